@@ -32,11 +32,22 @@
 #include "gnc-ui-util.h"
 
 
+/* The children of a node, kept sorted by key so they can be found by
+ * bisection.  Most nodes have no or a single child, so a small array
+ * is far cheaper than a hash table per node. */
+typedef struct
+{
+    guint key;           /* upper-cased character of the child */
+    QuickFill *qf;
+} QuickFillMatch;
+
 struct _QuickFill
 {
-    char *text;          /* the first matching text string     */
+    char *text;          /* the first matching text string, shared
+                          * through the string cache             */
     int len;             /* number of chars in text string     */
-    GHashTable *matches; /* array of children in the tree      */
+    guint n_matches;     /* number of children in the tree     */
+    QuickFillMatch *matches; /* children, sorted by key       */
 };
 
 
@@ -53,6 +64,81 @@ static QofLogModule log_module = GNC_MOD_REGISTER;
 /********************************************************************\
 \********************************************************************/
 
+/* Return the index of the child with the given key, or the index at
+ * which it would have to be inserted. */
+static guint
+quickfill_match_index (const QuickFill *qf, guint key)
+{
+    guint lo = 0, hi = qf->n_matches;
+
+    while (lo < hi)
+    {
+        guint mid = lo + (hi - lo) / 2;
+
+        if (qf->matches[mid].key < key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static QuickFill *
+quickfill_lookup_match (const QuickFill *qf, guint key)
+{
+    guint i = quickfill_match_index (qf, key);
+
+    if (i < qf->n_matches && qf->matches[i].key == key)
+        return qf->matches[i].qf;
+    return NULL;
+}
+
+static void
+quickfill_insert_match (QuickFill *qf, guint key, QuickFill *match_qf)
+{
+    guint i = quickfill_match_index (qf, key);
+
+    qf->matches = g_renew (QuickFillMatch, qf->matches, qf->n_matches + 1);
+    memmove (&qf->matches[i + 1], &qf->matches[i],
+             (qf->n_matches - i) * sizeof (QuickFillMatch));
+    qf->matches[i].key = key;
+    qf->matches[i].qf = match_qf;
+    qf->n_matches++;
+}
+
+static void
+quickfill_remove_match (QuickFill *qf, guint key)
+{
+    guint i = quickfill_match_index (qf, key);
+
+    if (i >= qf->n_matches || qf->matches[i].key != key)
+        return;
+
+    qf->n_matches--;
+    memmove (&qf->matches[i], &qf->matches[i + 1],
+             (qf->n_matches - i) * sizeof (QuickFillMatch));
+    if (qf->n_matches == 0)
+    {
+        g_free (qf->matches);
+        qf->matches = NULL;
+    }
+}
+
+static void
+quickfill_set_text (QuickFill *qf, const char *text, int len)
+{
+    char *old_text = qf->text;
+
+    /* Insert first, text may be the very string being replaced. */
+    qf->text = text ? CACHE_INSERT (text) : NULL;
+    qf->len = len;
+    if (old_text)
+        CACHE_REMOVE (old_text);
+}
+
+/********************************************************************\
+\********************************************************************/
+
 QuickFill *
 gnc_quickfill_new (void)
 {
@@ -69,7 +155,8 @@ gnc_quickfill_new (void)
     qf->text = NULL;
     qf->len = 0;
 
-    qf->matches = g_hash_table_new (g_direct_hash, g_direct_equal);
+    qf->n_matches = 0;
+    qf->matches = NULL;
 
     return qf;
 }
@@ -77,27 +164,13 @@ gnc_quickfill_new (void)
 /********************************************************************\
 \********************************************************************/
 
-static gboolean
-destroy_helper (gpointer key, gpointer value, gpointer data)
-{
-    gnc_quickfill_destroy (value);
-    return TRUE;
-}
-
 void
 gnc_quickfill_destroy (QuickFill *qf)
 {
     if (qf == NULL)
         return;
 
-    g_hash_table_foreach (qf->matches, (GHFunc)destroy_helper, NULL);
-    g_hash_table_destroy (qf->matches);
-    qf->matches = NULL;
-
-    if (qf->text)
-        g_free(qf->text);
-    qf->text = NULL;
-    qf->len = 0;
+    gnc_quickfill_purge (qf);
 
     g_free (qf);
 }
@@ -105,15 +178,18 @@ gnc_quickfill_destroy (QuickFill *qf)
 void
 gnc_quickfill_purge (QuickFill *qf)
 {
+    guint i;
+
     if (qf == NULL)
         return;
 
-    g_hash_table_foreach_remove (qf->matches, destroy_helper, NULL);
+    for (i = 0; i < qf->n_matches; i++)
+        gnc_quickfill_destroy (qf->matches[i].qf);
+    g_free (qf->matches);
+    qf->matches = NULL;
+    qf->n_matches = 0;
 
-    if (qf->text)
-        g_free (qf->text);
-    qf->text = NULL;
-    qf->len = 0;
+    quickfill_set_text (qf, NULL, 0);
 }
 
 /********************************************************************\
@@ -140,7 +216,7 @@ gnc_quickfill_get_char_match (QuickFill *qf, gunichar uc)
 
     DEBUG ("xaccGetQuickFill(): index = %u\n", key);
 
-    return g_hash_table_lookup (qf->matches, GUINT_TO_POINTER (key));
+    return quickfill_lookup_match (qf, key);
 }
 
 /********************************************************************\
@@ -187,14 +263,6 @@ gnc_quickfill_get_string_match (QuickFill *qf, const char *str)
 /********************************************************************\
 \********************************************************************/
 
-static void
-unique_len_helper (gpointer key, gpointer value, gpointer data)
-{
-    QuickFill **qf_p = data;
-
-    *qf_p = value;
-}
-
 QuickFill *
 gnc_quickfill_get_unique_len_match (QuickFill *qf, int *length)
 {
@@ -204,16 +272,9 @@ gnc_quickfill_get_unique_len_match (QuickFill *qf, int *length)
     if (qf == NULL)
         return NULL;
 
-    while (1)
+    while (qf->n_matches == 1)
     {
-        guint count;
-
-        count = g_hash_table_size (qf->matches);
-
-        if (count != 1)
-            break;
-
-        g_hash_table_foreach (qf->matches, unique_len_helper, &qf);
+        qf = qf->matches[0].qf;
 
         if (length != NULL)
             (*length)++;
@@ -263,11 +324,11 @@ quickfill_insert_recursive (QuickFill *qf, const char *text, int len,
     key_char_uc = g_utf8_get_char (next_char);
     key = g_unichar_toupper (key_char_uc);
 
-    match_qf = g_hash_table_lookup (qf->matches, GUINT_TO_POINTER (key));
+    match_qf = quickfill_lookup_match (qf, key);
     if (match_qf == NULL)
     {
         match_qf = gnc_quickfill_new ();
-        g_hash_table_insert (qf->matches, GUINT_TO_POINTER (key), match_qf);
+        quickfill_insert_match (qf, key, match_qf);
     }
 
     old_text = match_qf->text;
@@ -284,8 +345,7 @@ quickfill_insert_recursive (QuickFill *qf, const char *text, int len,
         /* If there's no string there already, just put the new one in. */
         if (old_text == NULL)
         {
-            match_qf->text = g_strdup(text);
-            match_qf->len = len;
+            quickfill_set_text (match_qf, text, len);
             break;
         }
 
@@ -294,9 +354,7 @@ quickfill_insert_recursive (QuickFill *qf, const char *text, int len,
                 (strncmp(text, old_text, strlen(old_text)) == 0))
             break;
 
-        g_free(old_text);
-        match_qf->text = g_strdup(text);
-        match_qf->len = len;
+        quickfill_set_text (match_qf, text, len);
         break;
     }
 
@@ -329,10 +387,8 @@ struct _BestText
 };
 
 static void
-best_text_helper (gpointer key, gpointer value, gpointer user_data)
+best_text_helper (QuickFill *qf, struct _BestText *best)
 {
-    QuickFill *qf = value;
-    struct _BestText *best = user_data;
 
     if (best->text == NULL)
     {
@@ -378,7 +434,7 @@ gnc_quickfill_remove_recursive (QuickFill *qf, const gchar *text, gint depth,
         key_char_uc = g_utf8_get_char (key_char);
         key = g_unichar_toupper (key_char_uc);
 
-        match_qf = g_hash_table_lookup (qf->matches, GUINT_TO_POINTER (key));
+        match_qf = quickfill_lookup_match (qf, key);
         if (match_qf)
         {
             /* remove text from child qf */
@@ -387,7 +443,7 @@ gnc_quickfill_remove_recursive (QuickFill *qf, const gchar *text, gint depth,
             if (match_qf->text == NULL)
             {
                 /* text was the only word with a prefix up to match_qf */
-                g_hash_table_remove (qf->matches, GUINT_TO_POINTER (key));
+                quickfill_remove_match (qf, key);
                 gnc_quickfill_destroy (match_qf);
 
             }
@@ -419,31 +475,24 @@ gnc_quickfill_remove_recursive (QuickFill *qf, const gchar *text, gint depth,
         }
         else
         {
-            if (g_hash_table_size (qf->matches) != 0)
+            if (qf->n_matches != 0)
             {
                 /* otherwise search for another good text */
                 struct _BestText bts;
+                guint i;
+
                 bts.text = NULL;
                 bts.sort = sort;
 
-                g_hash_table_foreach (qf->matches, (GHFunc) best_text_helper, &bts);
+                for (i = 0; i < qf->n_matches; i++)
+                    best_text_helper (qf->matches[i].qf, &bts);
                 best_text = bts.text;
                 best_len = (best_text == NULL) ? 0 : g_utf8_strlen (best_text, -1);
             }
         }
 
         /* now replace or clear text */
-        g_free(qf->text);
-        if (best_text != NULL)
-        {
-            qf->text = g_strdup(best_text);
-            qf->len = best_len;
-        }
-        else
-        {
-            qf->text = NULL;
-            qf->len = 0;
-        }
+        quickfill_set_text (qf, best_text, best_len);
     }
 }
 
@@ -24,12 +24,14 @@
 #include <config.h>
 #include <option-util.h>
 #include <gnc-euro.h>
+#include <gnc-exchange-totals.h>
 #include <gnc-exp-parser.h>
 #include <gnc-ui-util.h>
 #include <gnc-gettext-util.h>
 #include <gnc-prefs-utils.h>
 #include <gnc-helpers.h>
 #include <gnc-accounting-period.h>
+#include <gnc-amortize.h>
 #include <gnc-session.h>
 #include <gnc-component-manager.h>
 #include <guile-util.h>
@@ -173,4 +175,108 @@ time64 gnc_parse_time_to_time64(const gchar *s, const gchar *format);
 }
 GHashTable* gnc_sx_all_instantiate_cashflow_all(GDate range_start, GDate range_end);
 %clear GHashTable *;
+%inline %{
+/* The sums of gnc_exchange_totals() as a list of
+ * (commodity ((other-commodity amount group-amount) ...)). */
+static SCM
+gnc_exchange_totals_to_scm (gnc_commodity *report_commodity,
+                            Timespec end, gboolean cost)
+{
+    GList *groups = gnc_exchange_totals (gnc_get_current_book (),
+                                         report_commodity, end.tv_sec, cost);
+    GList *node, *pnode;
+    SCM result = SCM_EOL;
+
+    for (node = groups; node; node = node->next)
+    {
+        GncExchangeGroup *group = node->data;
+        SCM pairs = SCM_EOL;
+
+        for (pnode = group->pairs; pnode; pnode = pnode->next)
+        {
+            GncExchangePair *pair = pnode->data;
+            pairs = scm_cons (scm_list_3 (SWIG_NewPointerObj (pair->commodity,
+                                                              SWIGTYPE_p_gnc_commodity, 0),
+                                          gnc_numeric_to_scm (pair->amount),
+                                          gnc_numeric_to_scm (pair->group_amount)),
+                              pairs);
+        }
+        result = scm_cons (scm_list_2 (SWIG_NewPointerObj (group->commodity,
+                                                           SWIGTYPE_p_gnc_commodity, 0),
+                                       scm_reverse (pairs)),
+                           result);
+    }
+    gnc_exchange_totals_free (groups);
+    return scm_reverse (result);
+}
+
+/* gnc_exchange_totalavg_prices() as a list of (timepair price). */
+static SCM
+gnc_exchange_totalavg_prices_to_scm (SCM accounts, Timespec end,
+                                     gnc_commodity *price_commodity,
+                                     gnc_commodity *report_currency)
+{
+    GList *c_accounts = NULL, *prices, *node;
+    SCM result = SCM_EOL;
+
+    for (; !scm_is_null (accounts); accounts = SCM_CDR (accounts))
+        c_accounts = g_list_prepend (c_accounts,
+                                     SWIG_MustGetPtr (SCM_CAR (accounts),
+                                                      SWIGTYPE_p_Account, 1, 0));
+
+    prices = gnc_exchange_totalavg_prices (gnc_get_current_book (), c_accounts,
+                                           end.tv_sec, price_commodity,
+                                           report_currency);
+    for (node = prices; node; node = node->next)
+    {
+        GncExchangePrice *price = node->data;
+        result = scm_cons (scm_list_2 (gnc_timespec2timepair (price->date),
+                                       gnc_numeric_to_scm (price->price)),
+                           result);
+    }
+    gnc_exchange_prices_free (prices);
+    g_list_free (c_accounts);
+    return scm_reverse (result);
+}
+
+/* gnc_amortize_schedules() for a list of (rate n-periods principal
+ * denom): a list per loan of (payment interest principal balance). */
+static SCM
+gnc_amortize_schedules_to_scm (SCM loans)
+{
+    guint n_loans = scm_to_uint (scm_length (loans));
+    GncLoanTerms *terms = g_new0 (GncLoanTerms, n_loans);
+    GncAmortRow *rows, *row;
+    SCM result = SCM_EOL;
+    guint n;
+
+    for (n = 0; n < n_loans; n++, loans = SCM_CDR (loans))
+    {
+        SCM loan = SCM_CAR (loans);
+        terms[n].rate = gnc_scm_to_numeric (scm_list_ref (loan, scm_from_int (0)));
+        terms[n].n_periods = scm_to_int (scm_list_ref (loan, scm_from_int (1)));
+        terms[n].principal = gnc_scm_to_numeric (scm_list_ref (loan, scm_from_int (2)));
+        terms[n].denom = scm_to_int64 (scm_list_ref (loan, scm_from_int (3)));
+    }
+
+    rows = g_new (GncAmortRow, gnc_amortize_n_rows (terms, n_loans));
+    gnc_amortize_schedules (terms, n_loans, rows);
+    for (n = 0, row = rows; n < n_loans; n++)
+    {
+        SCM schedule = SCM_EOL;
+        gint period;
+
+        for (period = 0; period < terms[n].n_periods; period++, row++)
+            schedule = scm_cons (scm_list_4 (gnc_numeric_to_scm (row->payment),
+                                             gnc_numeric_to_scm (row->interest),
+                                             gnc_numeric_to_scm (row->principal),
+                                             gnc_numeric_to_scm (row->balance)),
+                                 schedule);
+        result = scm_cons (scm_reverse (schedule), result);
+    }
+    g_free (rows);
+    g_free (terms);
+    return scm_reverse (result);
+}
+%}
 #endif
@@ -427,6 +427,10 @@ typedef struct parser_env
     void *(*negate_numeric) (void *value);
     void (*free_numeric) (void *numeric_value);
     void *(*func_op)( const char *fname, int argc, void **argv );
+
+    void (*compile_op) (char op, const char *name, void *value, int argc,
+                        void *data);
+    void *compile_data;
 }
 parser_env;
 
@@ -446,6 +450,13 @@ parser_env;
 
 #define NAMED_INCR 5
 
+#define COMPILE_OP(pe, op, name, value, argc) \
+    do { \
+        if ((pe)->compile_op) \
+            (pe)->compile_op ((op), (name), (value), (argc), \
+                              (pe)->compile_data); \
+    } while (0)
+
 static char allowed_operators[] = "+-*/()=:";
 
 parser_env_ptr
@@ -522,6 +533,22 @@ exit_parser (parser_env_ptr pe)
     g_free (pe);
 }				/* exit_parser */
 
+/* Have each evaluation step reported to compile_op as the string is
+ * parsed, so that the caller can record the expression and evaluate
+ * it again without parsing. Pass NULL to stop reporting. */
+void
+parser_set_compile_op (parser_env_ptr pe,
+                       void compile_op (char op, const char *name,
+                               void *value, int argc, void *data),
+                       void *data)
+{
+    if (pe == NULL)
+        return;
+
+    pe->compile_op = compile_op;
+    pe->compile_data = data;
+}				/* parser_set_compile_op */
+
 /* return parser error code */
 ParseError get_parse_error (parser_env_ptr pe)
 {
@@ -614,6 +641,7 @@ parse_string (var_store_ptr value, const char *string, parser_env_ptr pe)
             val = pop (pe);
             pe->negate_numeric (val->value);
             push (val, pe);
+            COMPILE_OP (pe, CMP_NEGATE, NULL, NULL, 0);
         }
     }
 
@@ -942,6 +970,7 @@ assignment_op (parser_env_ptr pe)
             }				/* endif */
 
             push (vl, pe);
+            COMPILE_OP (pe, ASN_OP, vl->variable_name, NULL, ao);
         }
         else
         {
@@ -1009,6 +1038,7 @@ add_sub_op (parser_env_ptr pe)
         free_var (vr, pe);
 
         push (rslt, pe);
+        COMPILE_OP (pe, op, NULL, NULL, 0);
     }				/* endwhile */
 }				/* add_sub_op */
 
@@ -1069,6 +1099,7 @@ multiply_divide_op (parser_env_ptr pe)
         free_var (vr, pe);
 
         push (rslt, pe);
+        COMPILE_OP (pe, op, NULL, NULL, 0);
     }				/* endwhile */
 }				/* multiply_divide_op */
 
@@ -1158,7 +1189,10 @@ primary_exp (parser_env_ptr pe)
             return;
 
         if (LToken == SUB_OP)
+        {
             pe->negate_numeric (rslt->value);
+            COMPILE_OP (pe, CMP_NEGATE, NULL, NULL, 0);
+        }
 
         break;
 
@@ -1172,6 +1206,7 @@ primary_exp (parser_env_ptr pe)
 
         rslt->value = pe->numeric_value;
         pe->numeric_value = NULL;
+        COMPILE_OP (pe, CMP_NUMERIC, NULL, rslt->value, 0);
         break;
 
     case FN_TOKEN:
@@ -1223,14 +1258,16 @@ primary_exp (parser_env_ptr pe)
                 free_var( argv[i], pe );
             }
             g_free( argv );
-            g_free( ident );
 
             if ( rslt->value == NULL )
             {
+                g_free( ident );
                 pe->error_code = NOT_A_FUNC;
                 add_token( pe, EOS );
                 return;
             }
+            COMPILE_OP (pe, CMP_FUNCTION, ident, NULL, funcArgCount);
+            g_free( ident );
         }
 
         next_token(pe);
@@ -1245,6 +1282,7 @@ primary_exp (parser_env_ptr pe)
             return;
 
         rslt = get_named_var (pe);
+        COMPILE_OP (pe, CMP_VARIABLE, rslt->variable_name, NULL, 0);
         break;
     case STR_TOKEN:
         if (!(pe->Token == ')'
@@ -1258,6 +1296,7 @@ primary_exp (parser_env_ptr pe)
         rslt = get_unnamed_var( pe );
         rslt->type = VST_STRING;
         rslt->value = ident;
+        COMPILE_OP (pe, CMP_STRING, ident, NULL, 0);
         break;
     }				/* endswitch */
 
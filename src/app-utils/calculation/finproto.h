@@ -114,6 +114,12 @@ unsigned delete_var (char *var_name, parser_env_ptr pe);
 char *parse_string (var_store_ptr value,
                     const char *string, parser_env_ptr pe);
 
+void parser_set_compile_op (parser_env_ptr pe,
+                            void compile_op (char op, const char *name,
+                                    void *value, int argc,
+                                    void *data),
+                            void *data);
+
 
 /*==================================================*/
 /* amort_opt.c */
@@ -63,6 +63,15 @@ ParseError;
 #define MUL_OP  '*'
 #define ASN_OP  '='
 
+/* Steps reported to a parser's compile hook, in evaluation order.
+ * The arithmetic steps are reported with the operator symbols above;
+ * ASN_OP carries the compound assignment operator, or 0, in argc. */
+#define CMP_NUMERIC  'I'	/* push the numeric 'value'               */
+#define CMP_VARIABLE 'V'	/* push the variable 'name'               */
+#define CMP_STRING   '"'	/* push the string 'name'                 */
+#define CMP_FUNCTION 'F'	/* call function 'name' with argc args    */
+#define CMP_NEGATE   '~'	/* negate the top of the stack            */
+
 /* The following structure is used by the expression parser to store
  * named and temporary variables.  */
 
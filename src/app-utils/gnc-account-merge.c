@@ -46,17 +46,42 @@ determine_merge_disposition(Account *existing_root, Account *new_acct)
     return determine_account_merge_disposition(existing_acct, new_acct);
 }
 
-void
-account_trees_merge(Account *existing_root, Account *new_accts_root)
+/* Map the names of the children of parent to the children.  The names
+ * are borrowed from the accounts. */
+static GHashTable *
+children_by_name(Account *parent)
+{
+    GHashTable *names = g_hash_table_new(g_str_hash, g_str_equal);
+    GList *children, *node;
+
+    children = gnc_account_get_children(parent);
+    for (node = children; node; node = g_list_next(node))
+    {
+        const char *name = xaccAccountGetName((Account*)node->data);
+        if (name && !g_hash_table_lookup(names, name))
+            g_hash_table_insert(names, (gpointer)name, node->data);
+    }
+    g_list_free(children);
+    return names;
+}
+
+static void
+merge_children(Account *existing_parent, Account *new_parent, GList **edited)
 {
+    GHashTable *names;
     GList *accounts, *node;
-    g_return_if_fail(new_accts_root != NULL);
-    g_return_if_fail(existing_root != NULL);
+    gboolean editing = FALSE;
 
     /* since we're have a chance of mutating the list (via
      * gnc_account_add_child) while we're iterating over it, iterate
      * over a copy. */
-    accounts = gnc_account_get_children(new_accts_root);
+    accounts = gnc_account_get_children(new_parent);
+    if (!accounts)
+        return;
+
+    /* The existing children are looked up by name once per parent,
+     * rather than by searching the tree for each new account. */
+    names = children_by_name(existing_parent);
     for (node = accounts; node; node = g_list_next(node))
     {
         Account *existing_named, *new_acct;
@@ -64,18 +89,53 @@ account_trees_merge(Account *existing_root, Account *new_accts_root)
 
         new_acct = (Account*)node->data;
         name = xaccAccountGetName(new_acct);
-        existing_named = gnc_account_lookup_by_name(existing_root, name);
+        existing_named = name ? g_hash_table_lookup(names, name) : NULL;
         switch (determine_account_merge_disposition(existing_named, new_acct))
         {
         case GNC_ACCOUNT_MERGE_DISPOSITION_USE_EXISTING:
             /* recurse */
-            account_trees_merge(existing_named, new_acct);
+            merge_children(existing_named, new_acct, edited);
             break;
         case GNC_ACCOUNT_MERGE_DISPOSITION_CREATE_NEW:
             /* merge this one in. */
-            gnc_account_append_child(existing_root, new_acct);
+            if (edited && !editing)
+            {
+                /* Hold the parent open so it is committed only once */
+                xaccAccountBeginEdit(existing_parent);
+                *edited = g_list_prepend(*edited, existing_parent);
+                editing = TRUE;
+            }
+            gnc_account_append_child(existing_parent, new_acct);
+            if (name)
+                g_hash_table_insert(names, (gpointer)name, new_acct);
             break;
         }
     }
+    g_hash_table_destroy(names);
     g_list_free(accounts);
 }
+
+void
+account_trees_merge(Account *existing_root, Account *new_accts_root)
+{
+    g_return_if_fail(new_accts_root != NULL);
+    g_return_if_fail(existing_root != NULL);
+
+    merge_children(existing_root, new_accts_root, NULL);
+}
+
+void
+account_trees_merge_bulk(Account *existing_root, Account *new_accts_root)
+{
+    GList *edited = NULL, *node;
+
+    g_return_if_fail(new_accts_root != NULL);
+    g_return_if_fail(existing_root != NULL);
+
+    qof_event_begin_batch();
+    merge_children(existing_root, new_accts_root, &edited);
+    for (node = edited; node; node = g_list_next(node))
+        xaccAccountCommitEdit((Account*)node->data);
+    g_list_free(edited);
+    qof_event_end_batch();
+}
@@ -39,6 +39,16 @@ typedef struct _merge_error
 GncAccountMergeDisposition determine_account_merge_disposition(Account *existing_acct, Account *new_acct);
 GncAccountMergeDisposition determine_merge_disposition(Account *existing_root, Account *new_acct);
 
+/** Merge the accounts under new_accts_root into the tree under
+ *  existing_root.  An account whose parent's counterpart in the
+ *  existing tree has a child of the same name is merged into that
+ *  child; any other account is moved into the existing tree along with
+ *  its descendants. */
 void account_trees_merge(Account *existing_root, Account *new_accts_root);
 
+/** Like account_trees_merge(), for merging large trees: the existing
+ *  accounts which get new children are committed only once, at the end,
+ *  and the engine events are delivered as a single batch. */
+void account_trees_merge_bulk(Account *existing_root, Account *new_accts_root);
+
 #endif /* GNC_ACCOUNT_MERGE_H */
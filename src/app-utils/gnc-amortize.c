@@ -0,0 +1,292 @@
+/********************************************************************\
+ * gnc-amortize.c -- loan amortization schedules                    *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+\********************************************************************/
+
+#include "config.h"
+
+#include <glib.h>
+#include <math.h>
+#include <string.h>
+
+#include "gnc-amortize.h"
+#include "gnc-exp-parser.h"
+
+static QofLogModule log_module = GNC_MOD_GUI;
+
+#define AMORT_HOW (GNC_HOW_DENOM_EXACT | GNC_HOW_RND_ROUND_HALF_UP)
+
+static gboolean
+loan_terms_valid (const GncLoanTerms *loan)
+{
+    return (loan->n_periods > 0 && loan->denom > 0
+            && !gnc_numeric_check (loan->rate)
+            && !gnc_numeric_check (loan->principal)
+            && gnc_numeric_compare (loan->rate, gnc_numeric_zero ()) >= 0);
+}
+
+gnc_numeric
+gnc_amortize_payment (const GncLoanTerms *loan)
+{
+    double rate, payment;
+
+    g_return_val_if_fail (loan, gnc_numeric_error (GNC_ERROR_ARG));
+    if (!loan_terms_valid (loan))
+        return gnc_numeric_error (GNC_ERROR_ARG);
+
+    if (gnc_numeric_zero_p (loan->rate))
+        return gnc_numeric_div (loan->principal,
+                                gnc_numeric_create (loan->n_periods, 1),
+                                loan->denom, AMORT_HOW);
+
+    /* The payment itself can't be had exactly, (1 + rate)^n_periods
+     * overflows any denominator.  Rounded to the denom it is as exact
+     * as a lender's, and the schedule makes up the difference in the
+     * last payment. */
+    rate = gnc_numeric_to_double (loan->rate);
+    payment = gnc_numeric_to_double (loan->principal) * rate
+              / (1.0 - pow (1.0 + rate, -loan->n_periods));
+    return double_to_gnc_numeric (payment, loan->denom,
+                                  GNC_HOW_DENOM_EXACT | GNC_HOW_RND_ROUND_HALF_UP);
+}
+
+gsize
+gnc_amortize_n_rows (const GncLoanTerms *loans, guint n_loans)
+{
+    gsize n_rows = 0;
+    guint n;
+
+    g_return_val_if_fail (loans || n_loans == 0, 0);
+
+    for (n = 0; n < n_loans; n++)
+        if (loans[n].n_periods > 0)
+            n_rows += loans[n].n_periods;
+    return n_rows;
+}
+
+static void
+negate_rows (GncAmortRow *rows, gint n_rows)
+{
+    gint period;
+
+    for (period = 0; period < n_rows; period++)
+    {
+        rows[period].payment = gnc_numeric_neg (rows[period].payment);
+        rows[period].interest = gnc_numeric_neg (rows[period].interest);
+        rows[period].principal = gnc_numeric_neg (rows[period].principal);
+        rows[period].balance = gnc_numeric_neg (rows[period].balance);
+    }
+}
+
+/* Fills the loan's n_periods rows. */
+static gboolean
+amortize_loan (const GncLoanTerms *loan, GncAmortRow *rows)
+{
+    gnc_numeric payment, balance;
+    gint period;
+
+    /* A negative principal is the same schedule with all signs turned,
+     * which keeps the rounding and the last payment symmetric. */
+    if (gnc_numeric_negative_p (loan->principal))
+    {
+        GncLoanTerms positive = *loan;
+        gboolean valid;
+
+        positive.principal = gnc_numeric_neg (loan->principal);
+        valid = amortize_loan (&positive, rows);
+        if (valid)
+            negate_rows (rows, loan->n_periods);
+        return valid;
+    }
+
+    payment = gnc_amortize_payment (loan);
+    if (gnc_numeric_check (payment))
+    {
+        gnc_numeric error = gnc_numeric_error (GNC_ERROR_ARG);
+        for (period = 0; period < loan->n_periods; period++)
+        {
+            rows[period].payment = rows[period].interest = error;
+            rows[period].principal = rows[period].balance = error;
+        }
+        return FALSE;
+    }
+
+    balance = gnc_numeric_convert (loan->principal, loan->denom, AMORT_HOW);
+    for (period = 0; period < loan->n_periods; period++)
+    {
+        GncAmortRow *row = &rows[period];
+
+        row->interest = gnc_numeric_mul (balance, loan->rate, loan->denom,
+                                         AMORT_HOW);
+        row->principal = gnc_numeric_sub (payment, row->interest,
+                                          loan->denom, AMORT_HOW);
+        /* The last payment, or one which would overpay because of the
+         * rounding, repays all that is left. */
+        if (period == loan->n_periods - 1
+                || gnc_numeric_compare (row->principal, balance) > 0)
+            row->principal = balance;
+        row->payment = gnc_numeric_add (row->interest, row->principal,
+                                        loan->denom, AMORT_HOW);
+        balance = gnc_numeric_sub (balance, row->principal, loan->denom,
+                                   AMORT_HOW);
+        row->balance = balance;
+    }
+    return TRUE;
+}
+
+gboolean
+gnc_amortize_schedules (const GncLoanTerms *loans, guint n_loans,
+                        GncAmortRow *rows)
+{
+    gboolean all_valid = TRUE;
+    guint n;
+
+    g_return_val_if_fail (loans || n_loans == 0, FALSE);
+    g_return_val_if_fail (rows || n_loans == 0, FALSE);
+
+    for (n = 0; n < n_loans; n++)
+    {
+        if (loans[n].n_periods <= 0)
+        {
+            PWARN ("loan %u has no payments", n);
+            all_valid = FALSE;
+            continue;
+        }
+        if (!amortize_loan (&loans[n], rows))
+        {
+            PWARN ("loan %u has invalid terms", n);
+            all_valid = FALSE;
+        }
+        rows += loans[n].n_periods;
+    }
+    return all_valid;
+}
+
+gboolean
+gnc_amortize_totals (const GncLoanTerms *loan, const gint *payments,
+                     guint n_payments, gnc_numeric *interest,
+                     gnc_numeric *principal)
+{
+    GncAmortRow *rows;
+    gnc_numeric interest_sum, principal_sum;
+    guint n;
+
+    g_return_val_if_fail (loan && interest && principal, FALSE);
+    g_return_val_if_fail (payments || n_payments == 0, FALSE);
+
+    if (loan->n_periods <= 0)
+        return FALSE;
+    rows = g_new (GncAmortRow, loan->n_periods);
+    if (!amortize_loan (loan, rows))
+    {
+        g_free (rows);
+        return FALSE;
+    }
+
+    interest_sum = principal_sum = gnc_numeric_create (0, loan->denom);
+    for (n = 0; n < n_payments; n++)
+    {
+        gint period = payments[n];
+        if (period < 1 || period > loan->n_periods)
+            continue;
+        interest_sum = gnc_numeric_add (interest_sum, rows[period - 1].interest,
+                                        loan->denom, AMORT_HOW);
+        principal_sum = gnc_numeric_add (principal_sum,
+                                         rows[period - 1].principal,
+                                         loan->denom, AMORT_HOW);
+    }
+    g_free (rows);
+
+    *interest = interest_sum;
+    *principal = principal_sum;
+    return TRUE;
+}
+
+/* The value of an expression without variables. */
+static gboolean
+formula_constant (const char *formula_str, gnc_numeric *value)
+{
+    GHashTable *vars = g_hash_table_new (g_str_hash, g_str_equal);
+    GHashTableIter iter;
+    gpointer key, var_value;
+    gboolean constant;
+
+    constant = (gnc_exp_parser_parse_separate_vars (formula_str, value, NULL,
+                                                    vars)
+                && g_hash_table_size (vars) == 0
+                && gnc_numeric_check (*value) == GNC_ERROR_OK);
+
+    g_hash_table_iter_init (&iter, vars);
+    while (g_hash_table_iter_next (&iter, &key, &var_value))
+    {
+        g_free (key);
+        g_free (var_value);
+    }
+    g_hash_table_destroy (vars);
+    return constant;
+}
+
+gboolean
+gnc_amortize_formula_terms (const char *formula, GncLoanTerms *loan,
+                            gboolean *interest)
+{
+    gchar *args_str, **args = NULL;
+    gnc_numeric n_periods, fv, type;
+    gboolean is_loan = FALSE;
+    gsize len;
+
+    g_return_val_if_fail (formula && loan && interest, FALSE);
+
+    while (g_ascii_isspace (*formula))
+        formula++;
+    if (g_str_has_prefix (formula, "ipmt"))
+        *interest = TRUE;
+    else if (g_str_has_prefix (formula, "ppmt"))
+        *interest = FALSE;
+    else
+        return FALSE;
+
+    /* The arguments must not contain parentheses, so that they can be
+     * split at the colons. */
+    args_str = g_strstrip (g_strdup (formula + 4));
+    len = strlen (args_str);
+    if (len >= 2 && args_str[0] == '(' && args_str[len - 1] == ')'
+            && strpbrk (args_str + 1, "()") == args_str + len - 1)
+    {
+        args_str[len - 1] = '\0';
+        args = g_strsplit (args_str + 1, ":", -1);
+    }
+    if (args && g_strv_length (args) == 6
+            && strcmp (g_strstrip (args[1]), "i") == 0
+            && formula_constant (args[0], &loan->rate)
+            && formula_constant (args[2], &n_periods)
+            && formula_constant (args[3], &loan->principal)
+            && formula_constant (args[4], &fv)
+            && formula_constant (args[5], &type)
+            && gnc_numeric_zero_p (fv) && gnc_numeric_zero_p (type))
+    {
+        loan->n_periods = (gint) gnc_numeric_to_double (n_periods);
+        is_loan = (loan->n_periods > 0
+                   && gnc_numeric_equal (n_periods,
+                                         gnc_numeric_create (loan->n_periods, 1)));
+    }
+    g_strfreev (args);
+    g_free (args_str);
+    return is_loan;
+}
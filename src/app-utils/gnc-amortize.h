@@ -0,0 +1,103 @@
+/********************************************************************\
+ * gnc-amortize.h -- loan amortization schedules                    *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+\********************************************************************/
+
+/** @addtogroup GUI
+    @{ */
+/** @file gnc-amortize.h
+    @brief Payment schedules of level payment loans.
+
+    The pmt, ipmt and ppmt functions of fin.scm work out one payment
+    of one loan at a time, in floating point.  These functions instead
+    build the whole schedule of many loans in one pass each, the way a
+    lender books it: every period's interest is the balance times the
+    periodic rate rounded to the currency's smallest unit, the rest of
+    the payment repays principal, and the last payment takes whatever
+    balance the rounding left.
+*/
+
+#ifndef GNC_AMORTIZE_H
+#define GNC_AMORTIZE_H
+
+#include <glib.h>
+
+#include "qof.h"
+
+/** The terms of a loan paid back in equal payments at the end of each
+ *  period. */
+typedef struct
+{
+    gnc_numeric rate;       /**< Interest rate per period, e.g. 0.05/12 */
+    gint n_periods;         /**< Number of payments */
+    gnc_numeric principal;  /**< Amount borrowed */
+    gint64 denom;           /**< Smallest unit amounts are rounded to */
+} GncLoanTerms;
+
+/** One payment of a schedule, with the sign of the principal borrowed. */
+typedef struct
+{
+    gnc_numeric payment;    /**< interest plus principal */
+    gnc_numeric interest;
+    gnc_numeric principal;
+    gnc_numeric balance;    /**< What is owed after the payment */
+} GncAmortRow;
+
+/** The level payment of a loan, rounded to its denom.
+ *
+ *  @return The payment, or a gnc_numeric error if the terms are
+ *  invalid. */
+gnc_numeric gnc_amortize_payment (const GncLoanTerms *loan);
+
+/** The number of rows gnc_amortize_schedules() needs for the loans,
+ *  the sum of their n_periods. */
+gsize gnc_amortize_n_rows (const GncLoanTerms *loans, guint n_loans);
+
+/** Builds the schedules of n_loans loans into rows, which must hold
+ *  gnc_amortize_n_rows() rows.  The n_periods rows of each loan follow
+ *  those of the loan before it.
+ *
+ *  @return FALSE if the terms of a loan are invalid, in which case
+ *  its rows are filled with gnc_numeric errors. */
+gboolean gnc_amortize_schedules (const GncLoanTerms *loans, guint n_loans,
+                                 GncAmortRow *rows);
+
+/** Sums the interest and principal of the given payments of a loan,
+ *  numbered from 1 the way the "i" variable of scheduled transaction
+ *  formulas counts them.  Numbers past the last payment add nothing.
+ *
+ *  @return FALSE if the terms are invalid. */
+gboolean gnc_amortize_totals (const GncLoanTerms *loan, const gint *payments,
+                              guint n_payments, gnc_numeric *interest,
+                              gnc_numeric *principal);
+
+/** Reads the terms of a loan from a payment formula of the form the
+ *  loan assistant writes, "ipmt( rate : i : n_periods : principal : 0 :
+ *  0 )" or the same with ppmt, whose arguments other than "i" are
+ *  constants.  The denom of the terms is left alone.
+ *
+ *  @param interest Set to whether the formula is the interest part of
+ *  the payments rather than the principal part.
+ *
+ *  @return FALSE if the formula is not of that form. */
+gboolean gnc_amortize_formula_terms (const char *formula, GncLoanTerms *loan,
+                                     gboolean *interest);
+
+#endif
+/** @} */
@@ -40,8 +40,6 @@ typedef struct
 {
     GHashTable * event_masks;
     GHashTable * entity_events;
-
-    gboolean match;
 } ComponentEventInfo;
 
 typedef struct
@@ -64,8 +62,14 @@ static guint  suspend_counter = 0;
 static gint   next_component_id = 1;
 static GList *components = NULL;
 
-static ComponentEventInfo changes = { NULL, NULL, FALSE };
-static ComponentEventInfo changes_backup = { NULL, NULL, FALSE };
+static ComponentEventInfo changes = { NULL, NULL };
+static ComponentEventInfo changes_backup = { NULL, NULL };
+
+/* Reverse indexes of the component watches, so a refresh only has to
+ * look at the components watching something that changed.  Both map
+ * to a GPtrArray of the watching ComponentInfos. */
+static GHashTable *guid_watchers = NULL;   /* GncGUID --> watchers */
+static GHashTable *type_watchers = NULL;   /* QofIdType --> watchers */
 
 
 /* This static indicates the debugging module that this .o belongs to.  */
@@ -252,6 +256,116 @@ add_event_type (ComponentEventInfo *cei, QofIdTypeConst entity_type,
         *mask = event_mask;
 }
 
+static void
+free_watchers (gpointer value)
+{
+    g_ptr_array_free (value, TRUE);
+}
+
+static void
+create_watcher_indexes (void)
+{
+    if (guid_watchers)
+        return;
+
+    guid_watchers = g_hash_table_new_full (guid_hash_to_guint,
+                                           guid_g_hash_table_equal,
+                                           (GDestroyNotify) guid_free,
+                                           free_watchers);
+    type_watchers = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                           (GDestroyNotify) qof_string_cache_remove,
+                                           free_watchers);
+}
+
+static void
+destroy_watcher_indexes (void)
+{
+    if (!guid_watchers)
+        return;
+
+    g_hash_table_destroy (guid_watchers);
+    guid_watchers = NULL;
+
+    g_hash_table_destroy (type_watchers);
+    type_watchers = NULL;
+}
+
+static void
+index_guid_watch (ComponentInfo *ci, const GncGUID *entity)
+{
+    GPtrArray *watchers;
+
+    create_watcher_indexes ();
+
+    watchers = g_hash_table_lookup (guid_watchers, entity);
+    if (!watchers)
+    {
+        watchers = g_ptr_array_new ();
+        g_hash_table_insert (guid_watchers, guid_copy (entity), watchers);
+    }
+
+    g_ptr_array_add (watchers, ci);
+}
+
+static void
+unindex_guid_watch (ComponentInfo *ci, const GncGUID *entity)
+{
+    GPtrArray *watchers;
+
+    if (!guid_watchers)
+        return;
+
+    watchers = g_hash_table_lookup (guid_watchers, entity);
+    if (!watchers)
+        return;
+
+    g_ptr_array_remove_fast (watchers, ci);
+    if (watchers->len == 0)
+        g_hash_table_remove (guid_watchers, entity);
+}
+
+static void
+unindex_guid_watch_helper (gpointer key, gpointer value, gpointer user_data)
+{
+    unindex_guid_watch (user_data, key);
+}
+
+static void
+index_type_watch (ComponentInfo *ci, QofIdTypeConst entity_type)
+{
+    GPtrArray *watchers;
+
+    create_watcher_indexes ();
+
+    watchers = g_hash_table_lookup (type_watchers, entity_type);
+    if (!watchers)
+    {
+        watchers = g_ptr_array_new ();
+        g_hash_table_insert (type_watchers,
+                             qof_string_cache_insert (entity_type), watchers);
+    }
+
+    g_ptr_array_add (watchers, ci);
+}
+
+static void
+unindex_type_watch_helper (gpointer key, gpointer value, gpointer user_data)
+{
+    ComponentInfo *ci = user_data;
+    GPtrArray *watchers;
+
+    if (!type_watchers)
+        return;
+
+    watchers = g_hash_table_lookup (type_watchers, key);
+    if (!watchers)
+        return;
+
+    g_ptr_array_remove_fast (watchers, ci);
+    if (watchers->len == 0)
+        g_hash_table_remove (type_watchers, key);
+}
+
 static void
 gnc_cm_event_handler (QofInstance *entity,
                       QofEventId event_type,
@@ -324,6 +438,8 @@ gnc_component_manager_shutdown (void)
     destroy_event_hash (changes_backup.entity_events);
     changes_backup.entity_events = NULL;
 
+    destroy_watcher_indexes ();
+
     qof_event_unregister_handler (handler_id);
 }
 
@@ -454,6 +570,7 @@ gnc_gui_component_watch_entity (gint component_id,
                                 QofEventId event_mask)
 {
     ComponentInfo *ci;
+    gboolean watched;
 
     if (entity == NULL)
         return;
@@ -465,7 +582,14 @@ gnc_gui_component_watch_entity (gint component_id,
         return;
     }
 
+    watched = g_hash_table_lookup (ci->watch_info.entity_events, entity) != NULL;
+
     add_event (&ci->watch_info, entity, event_mask, FALSE);
+
+    if (event_mask == 0 && watched)
+        unindex_guid_watch (ci, entity);
+    else if (event_mask != 0 && !watched)
+        index_guid_watch (ci, entity);
 }
 
 void
@@ -482,6 +606,10 @@ gnc_gui_component_watch_entity_type (gint component_id,
         return;
     }
 
+    if (entity_type &&
+            !g_hash_table_lookup (ci->watch_info.event_masks, entity_type))
+        index_type_watch (ci, entity_type);
+
     add_event_type (&ci->watch_info, entity_type, event_mask, FALSE);
 }
 
@@ -506,6 +634,10 @@ gnc_gui_component_clear_watches (gint component_id)
         return;
     }
 
+    /* The type masks are only zeroed, so their index entries stay
+     * until the component is unregistered. */
+    g_hash_table_foreach (ci->watch_info.entity_events,
+                          unindex_guid_watch_helper, ci);
     clear_event_info (&ci->watch_info);
 }
 
@@ -531,6 +663,8 @@ gnc_unregister_gui_component (gint component_id)
 
     components = g_list_remove (components, ci);
 
+    g_hash_table_foreach (ci->watch_info.event_masks,
+                          unindex_type_watch_helper, ci);
     destroy_mask_hash (ci->watch_info.event_masks);
     ci->watch_info.event_masks = NULL;
 
@@ -599,67 +733,67 @@ gnc_resume_gui_refresh (void)
 static void
 match_type_helper (gpointer key, gpointer value, gpointer user_data)
 {
-    ComponentEventInfo *cei = user_data;
-    QofIdType id_type = key;
-    QofEventId * et = value;
-    QofEventId * et_2;
+    GHashTable *matches = user_data;
+    QofEventId *et = value;
+    GPtrArray *watchers;
+    guint i;
 
-    et_2 = g_hash_table_lookup (cei->event_masks, id_type);
-    if (!et_2)
+    if (*et == 0)
         return;
 
-    if (*et & *et_2)
-        cei->match = TRUE;
+    watchers = g_hash_table_lookup (type_watchers, key);
+    if (!watchers)
+        return;
+
+    for (i = 0; i < watchers->len; i++)
+    {
+        ComponentInfo *ci = g_ptr_array_index (watchers, i);
+        QofEventId *et_2;
+
+        et_2 = g_hash_table_lookup (ci->watch_info.event_masks, key);
+        if (et_2 && (*et & *et_2))
+            g_hash_table_insert (matches, GINT_TO_POINTER (ci->component_id), ci);
+    }
 }
 
 static void
 match_helper (gpointer key, gpointer value, gpointer user_data)
 {
-    GncGUID *guid = key;
+    GHashTable *matches = user_data;
     EventInfo *ei_1 = value;
-    EventInfo *ei_2;
-    ComponentEventInfo *cei = user_data;
+    GPtrArray *watchers;
+    guint i;
 
-    ei_2 = g_hash_table_lookup (cei->entity_events, guid);
-    if (!ei_2)
+    watchers = g_hash_table_lookup (guid_watchers, key);
+    if (!watchers)
         return;
 
-    if (ei_1->event_mask & ei_2->event_mask)
-        cei->match = TRUE;
+    for (i = 0; i < watchers->len; i++)
+    {
+        ComponentInfo *ci = g_ptr_array_index (watchers, i);
+        EventInfo *ei_2;
+
+        ei_2 = g_hash_table_lookup (ci->watch_info.entity_events, key);
+        if (ei_2 && (ei_1->event_mask & ei_2->event_mask))
+            g_hash_table_insert (matches, GINT_TO_POINTER (ci->component_id), ci);
+    }
 }
 
-static gboolean
-changes_match (ComponentEventInfo *cei, ComponentEventInfo *changes)
+/* Return the set of ids of the components whose watches intersect
+ * the changes, found through the watcher indexes rather than by
+ * comparing every component against the changes. */
+static GHashTable *
+find_matching_components (ComponentEventInfo *changes)
 {
-    ComponentEventInfo *big_cei;
-    GHashTable *smalltable;
-
-    if (cei == NULL)
-        return FALSE;
-
-    /* check types first, for efficiency */
-    cei->match = FALSE;
-    g_hash_table_foreach (changes->event_masks, match_type_helper, cei);
-    if (cei->match)
-        return TRUE;
-
-    if (g_hash_table_size (cei->entity_events) <=
-            g_hash_table_size (changes->entity_events))
-    {
-        smalltable = cei->entity_events;
-        big_cei = changes;
-    }
-    else
-    {
-        smalltable = changes->entity_events;
-        big_cei = cei;
-    }
+    GHashTable *matches = g_hash_table_new (g_direct_hash, g_direct_equal);
 
-    big_cei->match = FALSE;
+    if (!guid_watchers)
+        return matches;
 
-    g_hash_table_foreach (smalltable, match_helper, big_cei);
+    g_hash_table_foreach (changes->event_masks, match_type_helper, matches);
+    g_hash_table_foreach (changes->entity_events, match_helper, matches);
 
-    return big_cei->match;
+    return matches;
 }
 
 static void
@@ -667,10 +801,13 @@ gnc_gui_refresh_internal (gboolean force)
 {
     GList *list;
     GList *node;
+    GHashTable *matches = NULL;
+    gint64 trace;
 
     if (!got_events && !force)
         return;
 
+    trace = qof_log_trace_begin ();
     gnc_suspend_gui_refresh ();
 
     {
@@ -690,6 +827,8 @@ gnc_gui_refresh_internal (gboolean force)
 #endif
 
     list = find_component_ids_by_class (NULL);
+    if (!force)
+        matches = find_matching_components (&changes_backup);
 
     for (node = list; node; node = node->next)
     {
@@ -716,7 +855,7 @@ gnc_gui_refresh_internal (gboolean force)
                 ci->refresh_handler (NULL, ci->user_data);
             }
         }
-        else if (changes_match (&ci->watch_info, &changes_backup))
+        else if (g_hash_table_lookup (matches, GINT_TO_POINTER (ci->component_id)))
         {
             if (ci->refresh_handler)
             {
@@ -738,8 +877,11 @@ gnc_gui_refresh_internal (gboolean force)
     got_events = FALSE;
 
     g_list_free (list);
+    if (matches)
+        g_hash_table_destroy (matches);
 
     gnc_resume_gui_refresh ();
+    QOF_TRACE_END ("gui", "refresh", trace);
 }
 
 void
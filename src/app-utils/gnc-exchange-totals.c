@@ -0,0 +1,480 @@
+/********************************************************************\
+ * gnc-exchange-totals.c -- exchange rates from a book's            *
+ *                          transactions                            *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+\********************************************************************/
+
+#include "config.h"
+
+#include <glib.h>
+
+#include "gnc-exchange-totals.h"
+#include "gnc-euro.h"
+
+#include "Account.h"
+#include "Query.h"
+#include "Split.h"
+#include "Transaction.h"
+
+static QofLogModule log_module = GNC_MOD_GUI;
+
+#define SPLITS_CACHE_MAX 4
+#define TOTALS_CACHE_MAX 16
+
+/* The splits of a book posted up to end that exchange two commodities,
+ * in the order a split query returns them, i.e. by date posted. */
+typedef struct
+{
+    QofBook *book;
+    guint64 generation;
+    time64 end;
+    GList *splits;
+} ExchangeSplits;
+
+typedef struct
+{
+    QofBook *book;
+    guint64 generation;
+    time64 end;
+    gnc_commodity *report_commodity;
+    gboolean cost;
+    GList *groups;
+} ExchangeTotals;
+
+/* Both caches are most recently used first.  Reports run in several
+ * threads (see gnc:report-render-html-list), hence the lock. */
+static GMutex cache_lock;
+static GList *splits_cache = NULL;
+static GList *totals_cache = NULL;
+static gint cache_handler_id = 0;
+
+static void
+exchange_splits_free (ExchangeSplits *entry)
+{
+    g_list_free (entry->splits);
+    g_free (entry);
+}
+
+static void
+exchange_totals_entry_free (ExchangeTotals *entry)
+{
+    gnc_exchange_totals_free (entry->groups);
+    g_free (entry);
+}
+
+static void
+cache_event_handler (QofInstance *entity, QofEventId event_type,
+                     gpointer handler_data, gpointer event_data)
+{
+    GList *node, *next;
+
+    if (event_type != QOF_EVENT_DESTROY || !QOF_IS_BOOK (entity))
+        return;
+
+    g_mutex_lock (&cache_lock);
+    for (node = splits_cache; node; node = next)
+    {
+        ExchangeSplits *entry = node->data;
+        next = node->next;
+        if (entry->book != QOF_BOOK (entity))
+            continue;
+        exchange_splits_free (entry);
+        splits_cache = g_list_delete_link (splits_cache, node);
+    }
+    for (node = totals_cache; node; node = next)
+    {
+        ExchangeTotals *entry = node->data;
+        next = node->next;
+        if (entry->book != QOF_BOOK (entity))
+            continue;
+        exchange_totals_entry_free (entry);
+        totals_cache = g_list_delete_link (totals_cache, node);
+    }
+    g_mutex_unlock (&cache_lock);
+}
+
+/* Puts data at the front of cache and drops what falls off its end. */
+static GList *
+cache_insert (GList *cache, gpointer data, guint max, GDestroyNotify destroy)
+{
+    GList *last;
+
+    if (!cache_handler_id)
+        cache_handler_id = qof_event_register_handler (cache_event_handler,
+                                                       NULL);
+
+    cache = g_list_prepend (cache, data);
+    while (g_list_length (cache) > max)
+    {
+        last = g_list_last (cache);
+        destroy (last->data);
+        cache = g_list_delete_link (cache, last);
+    }
+    return cache;
+}
+
+/* Must be called with cache_lock held.  The list stays owned by the
+ * cache. */
+static GList *
+exchange_splits_lookup (QofBook *book, time64 end)
+{
+    guint64 generation = qof_book_get_generation (book);
+    ExchangeSplits *entry;
+    QofQuery *q;
+    GList *node, *splits = NULL;
+
+    for (node = splits_cache; node; node = node->next)
+    {
+        entry = node->data;
+        if (entry->book == book && entry->generation == generation &&
+                entry->end == end)
+        {
+            splits_cache = g_list_remove_link (splits_cache, node);
+            splits_cache = g_list_concat (node, splits_cache);
+            return entry->splits;
+        }
+    }
+
+    ENTER ("book %p, end %" G_GINT64_FORMAT, book, end);
+    q = qof_query_create_for (GNC_ID_SPLIT);
+    qof_query_set_book (q, book);
+    xaccQueryAddDateMatchTT (q, FALSE, 0, TRUE, end, QOF_QUERY_AND);
+
+    for (node = qof_query_run (q); node; node = node->next)
+    {
+        Split *split = node->data;
+        Transaction *trans = xaccSplitGetParent (split);
+
+        if (xaccSplitGetReconcile (split) == VREC)
+            continue;
+        if (gnc_commodity_equiv (xaccTransGetCurrency (trans),
+                                 xaccAccountGetCommodity
+                                 (xaccSplitGetAccount (split))))
+            continue;
+        splits = g_list_prepend (splits, split);
+    }
+    qof_query_destroy (q);
+
+    entry = g_new0 (ExchangeSplits, 1);
+    entry->book = book;
+    entry->generation = generation;
+    entry->end = end;
+    entry->splits = g_list_reverse (splits);
+    splits_cache = cache_insert (splits_cache, entry, SPLITS_CACHE_MAX,
+                                 (GDestroyNotify)exchange_splits_free);
+    LEAVE ("%d splits", g_list_length (entry->splits));
+    return entry->splits;
+}
+
+static GncExchangeGroup *
+find_group (GList *groups, const gnc_commodity *commodity)
+{
+    for (; groups; groups = groups->next)
+    {
+        GncExchangeGroup *group = groups->data;
+        if (group->commodity == commodity)
+            return group;
+    }
+    return NULL;
+}
+
+static GncExchangePair *
+find_pair (GList *pairs, const gnc_commodity *commodity)
+{
+    for (; pairs; pairs = pairs->next)
+    {
+        GncExchangePair *pair = pairs->data;
+        if (pair->commodity == commodity)
+            return pair;
+    }
+    return NULL;
+}
+
+static GncExchangePair *
+exchange_pair_new (gnc_commodity *commodity, gnc_numeric amount,
+                   gnc_numeric group_amount)
+{
+    GncExchangePair *pair = g_new (GncExchangePair, 1);
+    pair->commodity = commodity;
+    pair->amount = amount;
+    pair->group_amount = group_amount;
+    return pair;
+}
+
+/* This follows the Scheme it replaces split by split, including which
+ * group a split lands in and the order the groups and pairs end up in,
+ * since gnc:resolve-unknown-comm depends on both. */
+static GList *
+compute_totals (GList *splits, gnc_commodity *report_commodity,
+                gboolean cost)
+{
+    GncExchangeGroup *group = g_new0 (GncExchangeGroup, 1);
+    GList *groups, *node;
+
+    group->commodity = report_commodity;
+    groups = g_list_prepend (NULL, group);
+
+    for (node = splits; node; node = node->next)
+    {
+        Split *split = node->data;
+        Account *account = xaccSplitGetAccount (split);
+        gnc_commodity *trans_comm =
+            xaccTransGetCurrency (xaccSplitGetParent (split));
+        gnc_commodity *account_comm = xaccAccountGetCommodity (account);
+        gnc_numeric shares = xaccSplitGetAmount (split);
+        gnc_numeric value = xaccSplitGetValue (split);
+        gnc_commodity *other;
+        gnc_numeric amount, group_amount;
+        GncExchangePair *pair;
+
+        if (cost)
+        {
+            /* Trading splits counterbalance the actual values and
+             * shares back to zero. */
+            if (xaccAccountGetType (account) == ACCT_TYPE_TRADING)
+                continue;
+        }
+        else
+        {
+            shares = gnc_numeric_abs (shares);
+            value = gnc_numeric_abs (value);
+            /* Without shares this is not a buy or sell. */
+            if (gnc_numeric_zero_p (shares))
+                continue;
+        }
+
+        group = find_group (groups, trans_comm);
+        if (!group)
+            group = find_group (groups, account_comm);
+        if (!group)
+        {
+            group = g_new0 (GncExchangeGroup, 1);
+            group->commodity = account_comm;
+            group->pairs = g_list_prepend (NULL, exchange_pair_new
+                                           (trans_comm, value, shares));
+            groups = g_list_prepend (groups, group);
+            continue;
+        }
+
+        if (gnc_commodity_equiv (trans_comm, group->commodity))
+        {
+            other = account_comm;
+            amount = shares;
+            group_amount = value;
+        }
+        else
+        {
+            other = trans_comm;
+            amount = cost ? gnc_numeric_neg (value) : value;
+            group_amount = cost ? gnc_numeric_neg (shares) : shares;
+        }
+
+        pair = find_pair (group->pairs, other);
+        if (!pair)
+        {
+            pair = exchange_pair_new (other, gnc_numeric_zero (),
+                                      gnc_numeric_zero ());
+            group->pairs = g_list_prepend (group->pairs, pair);
+            groups = g_list_remove (groups, group);
+            groups = g_list_prepend (groups, group);
+        }
+        pair->amount = gnc_numeric_add (pair->amount, amount,
+                                        GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
+        pair->group_amount = gnc_numeric_add (pair->group_amount, group_amount,
+                                              GNC_DENOM_AUTO,
+                                              GNC_HOW_DENOM_LCD);
+    }
+    return groups;
+}
+
+static GList *
+copy_totals (GList *groups)
+{
+    GList *copy = NULL, *node, *pnode;
+
+    for (node = groups; node; node = node->next)
+    {
+        GncExchangeGroup *group = node->data;
+        GncExchangeGroup *group_copy = g_new0 (GncExchangeGroup, 1);
+
+        group_copy->commodity = group->commodity;
+        for (pnode = group->pairs; pnode; pnode = pnode->next)
+            group_copy->pairs = g_list_prepend (group_copy->pairs,
+                                                g_memdup (pnode->data,
+                                                          sizeof (GncExchangePair)));
+        group_copy->pairs = g_list_reverse (group_copy->pairs);
+        copy = g_list_prepend (copy, group_copy);
+    }
+    return g_list_reverse (copy);
+}
+
+GList *
+gnc_exchange_totals (QofBook *book, gnc_commodity *report_commodity,
+                     time64 end, gboolean cost)
+{
+    guint64 generation;
+    ExchangeTotals *entry = NULL;
+    GList *node, *result;
+
+    g_return_val_if_fail (book != NULL, NULL);
+    g_return_val_if_fail (report_commodity != NULL, NULL);
+
+    g_mutex_lock (&cache_lock);
+    generation = qof_book_get_generation (book);
+    for (node = totals_cache; node; node = node->next)
+    {
+        ExchangeTotals *e = node->data;
+        if (e->book == book && e->generation == generation &&
+                e->end == end && e->report_commodity == report_commodity &&
+                e->cost == cost)
+        {
+            totals_cache = g_list_remove_link (totals_cache, node);
+            totals_cache = g_list_concat (node, totals_cache);
+            entry = e;
+            break;
+        }
+    }
+
+    if (!entry)
+    {
+        entry = g_new0 (ExchangeTotals, 1);
+        entry->book = book;
+        entry->generation = generation;
+        entry->end = end;
+        entry->report_commodity = report_commodity;
+        entry->cost = cost;
+        entry->groups = compute_totals (exchange_splits_lookup (book, end),
+                                        report_commodity, cost);
+        totals_cache = cache_insert (totals_cache, entry, TOTALS_CACHE_MAX,
+                                     (GDestroyNotify)exchange_totals_entry_free);
+    }
+
+    result = copy_totals (entry->groups);
+    g_mutex_unlock (&cache_lock);
+    return result;
+}
+
+static void
+exchange_group_free (GncExchangeGroup *group)
+{
+    g_list_free_full (group->pairs, g_free);
+    g_free (group);
+}
+
+void
+gnc_exchange_totals_free (GList *groups)
+{
+    g_list_free_full (groups, (GDestroyNotify)exchange_group_free);
+}
+
+GList *
+gnc_exchange_totalavg_prices (QofBook *book, GList *accounts, time64 end,
+                              gnc_commodity *price_commodity,
+                              gnc_commodity *report_currency)
+{
+    gnc_numeric total_foreign = gnc_numeric_zero ();
+    gnc_numeric total_domestic = gnc_numeric_zero ();
+    GHashTable *account_set;
+    GList *prices = NULL, *node;
+
+    g_return_val_if_fail (book != NULL, NULL);
+    g_return_val_if_fail (price_commodity != NULL, NULL);
+    g_return_val_if_fail (report_currency != NULL, NULL);
+
+    account_set = g_hash_table_new (g_direct_hash, g_direct_equal);
+    for (node = accounts; node; node = node->next)
+        g_hash_table_insert (account_set, node->data, node->data);
+
+    g_mutex_lock (&cache_lock);
+    for (node = exchange_splits_lookup (book, end); node; node = node->next)
+    {
+        Split *split = node->data;
+        Transaction *trans = xaccSplitGetParent (split);
+        Account *account = xaccSplitGetAccount (split);
+        gnc_commodity *trans_comm = xaccTransGetCurrency (trans);
+        gnc_commodity *account_comm = xaccAccountGetCommodity (account);
+        gnc_numeric shares = gnc_numeric_abs (xaccSplitGetAmount (split));
+        gnc_numeric value = gnc_numeric_abs (xaccSplitGetValue (split));
+        gnc_commodity *other;
+        gnc_numeric amount, bought, price;
+
+        if (!g_hash_table_lookup (account_set, account))
+            continue;
+
+        if (gnc_commodity_equiv (trans_comm, price_commodity))
+        {
+            other = account_comm;
+            amount = shares;
+            bought = value;
+        }
+        else if (gnc_commodity_equiv (account_comm, price_commodity))
+        {
+            other = trans_comm;
+            amount = value;
+            bought = shares;
+        }
+        else
+            continue;
+
+        if (!gnc_commodity_equiv (other, report_currency) &&
+                gnc_is_euro_currency (report_currency) &&
+                gnc_is_euro_currency (other))
+        {
+            amount = gnc_convert_from_euro (report_currency,
+                                            gnc_convert_to_euro (other, amount));
+            other = report_currency;
+        }
+
+        if (!gnc_commodity_equiv (other, report_currency))
+        {
+            PWARN ("Sorry, currency exchange not yet implemented: %s %s "
+                   "(buying %s %s) =? %s",
+                   gnc_num_dbg_to_string (amount),
+                   gnc_commodity_get_mnemonic (other),
+                   gnc_num_dbg_to_string (bought),
+                   gnc_commodity_get_mnemonic (price_commodity),
+                   gnc_commodity_get_mnemonic (report_currency));
+            continue;
+        }
+
+        total_foreign = gnc_numeric_add (total_foreign, bought,
+                                         GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
+        total_domestic = gnc_numeric_add (total_domestic, amount,
+                                          GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
+        price = gnc_numeric_div (total_domestic, total_foreign, GNC_DENOM_AUTO,
+                                 GNC_HOW_DENOM_SIGFIGS (8) | GNC_HOW_RND_ROUND);
+        if (!gnc_numeric_zero_p (price))
+        {
+            GncExchangePrice *p = g_new (GncExchangePrice, 1);
+            p->date = xaccTransRetDatePostedTS (trans);
+            p->price = price;
+            prices = g_list_prepend (prices, p);
+        }
+    }
+    g_mutex_unlock (&cache_lock);
+
+    g_hash_table_destroy (account_set);
+    return g_list_reverse (prices);
+}
+
+void
+gnc_exchange_prices_free (GList *prices)
+{
+    g_list_free_full (prices, g_free);
+}
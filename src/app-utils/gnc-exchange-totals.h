@@ -0,0 +1,99 @@
+/********************************************************************\
+ * gnc-exchange-totals.h -- exchange rates from a book's            *
+ *                          transactions                            *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+\********************************************************************/
+
+/** @addtogroup GUI
+    @{ */
+/** @file gnc-exchange-totals.h
+    @brief Totals of what was paid for one commodity in another.
+
+    These are the sums behind the "average cost" and "weighted
+    average" price sources of the reports (see
+    commodity-utilities.scm).  They look at every split whose
+    account's commodity differs from its transaction's currency, so
+    the scan over the book is done once for each end date and shared
+    by all the totals computed from it until the book changes.
+*/
+
+#ifndef GNC_EXCHANGE_TOTALS_H
+#define GNC_EXCHANGE_TOTALS_H
+
+#include <glib.h>
+
+#include "qof.h"
+#include "gnc-commodity.h"
+
+/** What was exchanged between a group's commodity and one other. */
+typedef struct
+{
+    gnc_commodity *commodity;   /**< The other commodity */
+    gnc_numeric amount;         /**< The total in the other commodity */
+    gnc_numeric group_amount;   /**< The total in the group's commodity */
+} GncExchangePair;
+
+/** All exchanges of one commodity, one pair per other commodity. */
+typedef struct
+{
+    gnc_commodity *commodity;
+    GList *pairs;               /**< GncExchangePair, newest first */
+} GncExchangeGroup;
+
+/** A running average price and the date it became valid. */
+typedef struct
+{
+    Timespec date;
+    gnc_numeric price;
+} GncExchangePrice;
+
+/** Sums the exchanges of all splits posted up to end in the book.
+ *
+ *  The groups are keyed and ordered the way gnc:get-exchange-totals
+ *  has always built its sumlist, starting with a group for the
+ *  report_commodity.  With cost FALSE the amounts are absolute and
+ *  splits without shares are ignored; with cost TRUE they are signed
+ *  and splits in trading accounts are ignored instead.
+ *
+ *  The result is cached for the book's generation.
+ *
+ *  @return A list of GncExchangeGroup to be freed with
+ *  gnc_exchange_totals_free(). */
+GList *gnc_exchange_totals (QofBook *book, gnc_commodity *report_commodity,
+                            time64 end, gboolean cost);
+
+void gnc_exchange_totals_free (GList *groups);
+
+/** Computes the average price of price_commodity in report_currency
+ *  after each split posted up to end in one of the accounts that
+ *  exchanged them, oldest first.  Other EURO currencies are converted
+ *  to a EURO report_currency; amounts in other currencies are left
+ *  out with a warning.
+ *
+ *  @return A list of GncExchangePrice to be freed with
+ *  gnc_exchange_prices_free(). */
+GList *gnc_exchange_totalavg_prices (QofBook *book, GList *accounts,
+                                     time64 end,
+                                     gnc_commodity *price_commodity,
+                                     gnc_commodity *report_currency);
+
+void gnc_exchange_prices_free (GList *prices);
+
+#endif /* GNC_EXCHANGE_TOTALS_H */
+/** @} */
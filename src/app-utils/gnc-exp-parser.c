@@ -48,6 +48,23 @@ typedef struct ParserNum
     gnc_numeric value;
 } ParserNum;
 
+/* One step of a compiled expression; see the CMP_* codes in finvar.h. */
+typedef struct ExpStep
+{
+    char op;
+    gchar *name;        /* variable, string or function name */
+    gnc_numeric value;  /* CMP_NUMERIC literal */
+    gint argc;          /* function arguments, or compound assignment op */
+    gint slot;          /* CMP_VARIABLE index into var_names */
+} ExpStep;
+
+struct GNCExpression
+{
+    gchar *text;
+    GArray *steps;          /* ExpStep, in evaluation order */
+    GPtrArray *var_names;   /* the expression's variable binding table */
+};
+
 
 /** Static Globals *************************************************/
 static GHashTable   *variable_bindings = NULL;
@@ -373,6 +390,29 @@ trans_numeric(const char *digit_str,
     return pnum;
 }
 
+static gnc_numeric
+apply_numeric_op(char op_sym, gnc_numeric left, gnc_numeric right)
+{
+    switch (op_sym)
+    {
+    case ADD_OP:
+        return gnc_numeric_add (left, right,
+                                GNC_DENOM_AUTO, GNC_HOW_DENOM_EXACT);
+    case SUB_OP:
+        return gnc_numeric_sub (left, right,
+                                GNC_DENOM_AUTO, GNC_HOW_DENOM_EXACT);
+    case DIV_OP:
+        return gnc_numeric_div (left, right,
+                                GNC_DENOM_AUTO, GNC_HOW_DENOM_EXACT);
+    case MUL_OP:
+        return gnc_numeric_mul (left, right,
+                                GNC_DENOM_AUTO, GNC_HOW_DENOM_EXACT);
+    case ASN_OP:
+    default:
+        return right;
+    }
+}
+
 static void *
 numeric_ops(char op_sym,
             void *left_value,
@@ -386,29 +426,7 @@ numeric_ops(char op_sym,
         return NULL;
 
     result = (op_sym == ASN_OP) ? left : g_new0(ParserNum, 1);
-
-    switch (op_sym)
-    {
-    case ADD_OP:
-        result->value = gnc_numeric_add (left->value, right->value,
-                                         GNC_DENOM_AUTO, GNC_HOW_DENOM_EXACT);
-        break;
-    case SUB_OP:
-        result->value = gnc_numeric_sub (left->value, right->value,
-                                         GNC_DENOM_AUTO, GNC_HOW_DENOM_EXACT);
-        break;
-    case DIV_OP:
-        result->value = gnc_numeric_div (left->value, right->value,
-                                         GNC_DENOM_AUTO, GNC_HOW_DENOM_EXACT);
-        break;
-    case MUL_OP:
-        result->value = gnc_numeric_mul (left->value, right->value,
-                                         GNC_DENOM_AUTO, GNC_HOW_DENOM_EXACT);
-        break;
-    case ASN_OP:
-        result->value = right->value;
-        break;
-    }
+    result->value = apply_numeric_op (op_sym, left->value, right->value);
 
     return result;
 }
@@ -482,11 +500,37 @@ cleanup:
     return toRet;
 }
 
-gboolean
-gnc_exp_parser_parse_separate_vars (const char * expression,
-                                    gnc_numeric *value_p,
-                                    char **error_loc_p,
-                                    GHashTable *varHash )
+static void
+compile_step (char op, const char *name, void *value, int argc, void *data)
+{
+    GNCExpression *expr = data;
+    ExpStep step;
+
+    memset (&step, 0, sizeof (step));
+    step.op = op;
+    step.argc = argc;
+    step.name = g_strdup (name);
+    if (op == CMP_NUMERIC && value != NULL)
+        step.value = ((ParserNum *)value)->value;
+    if (op == CMP_VARIABLE)
+    {
+        guint i;
+        for (i = 0; i < expr->var_names->len; i++)
+            if (g_strcmp0 (g_ptr_array_index (expr->var_names, i), name) == 0)
+                break;
+        if (i == expr->var_names->len)
+            g_ptr_array_add (expr->var_names, g_strdup (name));
+        step.slot = i;
+    }
+    g_array_append_val (expr->steps, step);
+}
+
+static gboolean
+gnc_exp_parser_parse_internal (const char * expression,
+                               gnc_numeric *value_p,
+                               char **error_loc_p,
+                               GHashTable *varHash,
+                               GNCExpression *compiled)
 {
     parser_env_ptr pe;
     var_store_ptr vars;
@@ -517,6 +561,8 @@ gnc_exp_parser_parse_separate_vars (const char * expression,
     pe = init_parser (vars, lc->mon_decimal_point, lc->mon_thousands_sep,
                       trans_numeric, numeric_ops, negate_numeric, g_free,
                       func_op);
+    if (compiled != NULL)
+        parser_set_compile_op (pe, compile_step, compiled);
 
     error_loc = parse_string (&result, expression, pe);
 
@@ -594,6 +640,238 @@ gnc_exp_parser_parse_separate_vars (const char * expression,
     return last_error == PARSER_NO_ERROR;
 }
 
+gboolean
+gnc_exp_parser_parse_separate_vars (const char * expression,
+                                    gnc_numeric *value_p,
+                                    char **error_loc_p,
+                                    GHashTable *varHash )
+{
+    return gnc_exp_parser_parse_internal (expression, value_p, error_loc_p,
+                                          varHash, NULL);
+}
+
+GNCExpression *
+gnc_exp_parser_compile (const char *expression, char **error_loc_p)
+{
+    GNCExpression *expr;
+    GHashTable *tmpVarHash;
+
+    if (expression == NULL)
+        return NULL;
+
+    expr = g_new0 (GNCExpression, 1);
+    expr->text = g_strdup (expression);
+    expr->steps = g_array_new (FALSE, FALSE, sizeof (ExpStep));
+    expr->var_names = g_ptr_array_new_with_free_func (g_free);
+
+    /* The recording pass evaluates the expression once against a
+     * private table, so it has no effect on any variable. A numeric
+     * error only reflects the values used for that pass. */
+    tmpVarHash = g_hash_table_new (g_str_hash, g_str_equal);
+    gnc_exp_parser_parse_internal (expression, NULL, error_loc_p,
+                                   tmpVarHash, expr);
+    g_hash_table_foreach (tmpVarHash, gnc_ep_tmpvarhash_clean, NULL);
+    g_hash_table_destroy (tmpVarHash);
+
+    if (last_error != PARSER_NO_ERROR && last_error != NUMERIC_ERROR)
+    {
+        gnc_exp_parser_expression_free (expr);
+        return NULL;
+    }
+
+    if (error_loc_p != NULL)
+        *error_loc_p = NULL;
+    last_error = PARSER_NO_ERROR;
+    return expr;
+}
+
+void
+gnc_exp_parser_expression_free (GNCExpression *expr)
+{
+    guint i;
+
+    if (expr == NULL)
+        return;
+
+    for (i = 0; i < expr->steps->len; i++)
+        g_free (g_array_index (expr->steps, ExpStep, i).name);
+    g_array_free (expr->steps, TRUE);
+    g_ptr_array_free (expr->var_names, TRUE);
+    g_free (expr->text);
+    g_free (expr);
+}
+
+const char *
+gnc_exp_parser_expression_text (const GNCExpression *expr)
+{
+    g_return_val_if_fail (expr != NULL, NULL);
+    return expr->text;
+}
+
+/* Evaluates the recorded steps on a stack of var_stores. The variable
+ * cells come first and are resolved from varHash, then the predefined
+ * variables, exactly as gnc_exp_parser_parse_separate_vars() would;
+ * every step then owns one temporary cell. */
+gboolean
+gnc_exp_parser_eval (const GNCExpression *expr,
+                     gnc_numeric *value_p,
+                     char **error_loc_p,
+                     GHashTable *varHash)
+{
+    guint nvars, nsteps, i;
+    var_store *cells, **stack;
+    ParserNum *nums;
+    gboolean *predefined;
+    guint sp = 0;
+
+    g_return_val_if_fail (expr != NULL, FALSE);
+
+    if (!parser_inited)
+        gnc_exp_parser_real_init ( (varHash == NULL) );
+
+    nvars = expr->var_names->len;
+    nsteps = expr->steps->len;
+    cells = g_new0 (var_store, nvars + nsteps);
+    nums = g_new0 (ParserNum, nvars + nsteps);
+    stack = g_new0 (var_store *, nsteps + 1);
+    predefined = g_new0 (gboolean, nvars);
+
+    for (i = 0; i < nvars; i++)
+    {
+        const char *name = g_ptr_array_index (expr->var_names, i);
+        gpointer key, value;
+
+        cells[i].variable_name = (char *)name;
+        cells[i].type = VST_NUMERIC;
+        cells[i].value = &nums[i];
+
+        if (varHash != NULL
+                && g_hash_table_lookup_extended (varHash, name, &key, &value))
+        {
+            if (value != NULL)
+                nums[i].value = *(gnc_numeric *)value;
+            predefined[i] = TRUE;
+        }
+        else if ((value = g_hash_table_lookup (variable_bindings, name)))
+        {
+            nums[i].value = ((ParserNum *)value)->value;
+            predefined[i] = TRUE;
+        }
+        else
+            nums[i].value = gnc_numeric_zero ();
+    }
+
+    last_error = PARSER_NO_ERROR;
+    for (i = 0; i < nsteps && last_error == PARSER_NO_ERROR; i++)
+    {
+        const ExpStep *step = &g_array_index (expr->steps, ExpStep, i);
+        var_store *tmp = &cells[nvars + i];
+        var_store *left, *right;
+
+        tmp->type = VST_NUMERIC;
+        tmp->value = &nums[nvars + i];
+
+        switch (step->op)
+        {
+        case CMP_NUMERIC:
+            nums[nvars + i].value = step->value;
+            stack[sp++] = tmp;
+            break;
+        case CMP_VARIABLE:
+            stack[sp++] = &cells[step->slot];
+            break;
+        case CMP_STRING:
+            tmp->type = VST_STRING;
+            tmp->value = step->name;
+            stack[sp++] = tmp;
+            break;
+        case CMP_NEGATE:
+            left = stack[sp - 1];
+            ((ParserNum *)left->value)->value =
+                gnc_numeric_neg (((ParserNum *)left->value)->value);
+            break;
+        case CMP_FUNCTION:
+        {
+            gnc_numeric *result;
+
+            sp -= step->argc;
+            result = func_op (step->name, step->argc, (void **)&stack[sp]);
+            if (result == NULL)
+            {
+                last_error = NOT_A_FUNC;
+                break;
+            }
+            nums[nvars + i].value = *result;
+            g_free (result);
+            stack[sp++] = tmp;
+            break;
+        }
+        case ASN_OP:
+            right = stack[--sp];
+            left = stack[sp - 1];
+            ((ParserNum *)left->value)->value =
+                apply_numeric_op (step->argc ? step->argc : ASN_OP,
+                                  ((ParserNum *)left->value)->value,
+                                  ((ParserNum *)right->value)->value);
+            break;
+        default:
+            right = stack[--sp];
+            left = stack[--sp];
+            nums[nvars + i].value =
+                apply_numeric_op (step->op,
+                                  ((ParserNum *)left->value)->value,
+                                  ((ParserNum *)right->value)->value);
+            stack[sp++] = tmp;
+            break;
+        }
+    }
+
+    if (last_error == PARSER_NO_ERROR && sp == 0)
+        last_error = STACK_UNDERFLOW;
+    if (last_error == PARSER_NO_ERROR)
+    {
+        gnc_numeric result = ((ParserNum *)stack[sp - 1]->value)->value;
+
+        if (gnc_numeric_check (result))
+            last_error = NUMERIC_ERROR;
+        else if (value_p)
+            *value_p = gnc_numeric_reduce (result);
+    }
+    if (error_loc_p != NULL)
+        *error_loc_p = (last_error == PARSER_NO_ERROR) ? NULL : expr->text;
+
+    /* Hand the variables back the same way as the parser does. */
+    for (i = 0; i < nvars; i++)
+    {
+        if (varHash != NULL && !predefined[i])
+        {
+            gpointer maybeKey, maybeValue;
+            gnc_numeric *numericValue;
+
+            if (g_hash_table_lookup_extended (varHash, cells[i].variable_name,
+                                              &maybeKey, &maybeValue))
+            {
+                g_hash_table_remove (varHash, maybeKey);
+                g_free (maybeKey);
+                g_free (maybeValue);
+            }
+            numericValue = g_new0 (gnc_numeric, 1);
+            *numericValue = nums[i].value;
+            g_hash_table_insert (varHash, g_strdup (cells[i].variable_name),
+                                 numericValue);
+        }
+        else if (varHash == NULL && predefined[i])
+            gnc_exp_parser_set_value (cells[i].variable_name, nums[i].value);
+    }
+
+    g_free (predefined);
+    g_free (stack);
+    g_free (nums);
+    g_free (cells);
+
+    return last_error == PARSER_NO_ERROR;
+}
+
 const char *
 gnc_exp_parser_error_string (void)
 {
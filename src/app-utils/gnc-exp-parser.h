@@ -85,6 +85,38 @@ gboolean gnc_exp_parser_parse_separate_vars (const char * expression,
         char **error_loc_p,
         GHashTable *varHash );
 
+/**
+ * An expression parsed once, for repeated evaluation against changing
+ * variable values without parsing the text again.
+ **/
+typedef struct GNCExpression GNCExpression;
+
+/**
+ * Parses the expression into a GNCExpression. Returns NULL if the
+ * expression doesn't parse, setting *error_loc_p as
+ * gnc_exp_parser_parse does. Compiling evaluates the expression once,
+ * without changing any variable.
+ **/
+GNCExpression *gnc_exp_parser_compile (const char *expression,
+                                       char **error_loc_p);
+
+/**
+ * Evaluates a compiled expression exactly as
+ * gnc_exp_parser_parse_separate_vars would evaluate its text, with the
+ * same variable lookup and update through varHash, or through the
+ * predefined variables if varHash is NULL. On failure *error_loc_p
+ * points at the expression's text.
+ **/
+gboolean gnc_exp_parser_eval (const GNCExpression *expr,
+                              gnc_numeric *value_p,
+                              char **error_loc_p,
+                              GHashTable *varHash);
+
+/* The text the expression was compiled from. */
+const char *gnc_exp_parser_expression_text (const GNCExpression *expr);
+
+void gnc_exp_parser_expression_free (GNCExpression *expr);
+
 /* If the last parse returned FALSE, return an error string describing
  * the problem. Otherwise, return NULL. */
 const char * gnc_exp_parser_error_string (void);
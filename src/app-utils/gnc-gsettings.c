@@ -88,15 +88,124 @@ static gboolean gnc_gsettings_is_valid_key(GSettings *settings, const gchar *key
     return found;
 }
 
+/* Values read from each GSettings object are kept in a cache attached
+ * to it, so the preferences the register and the account trees look up
+ * for every cell cost a hash lookup instead of a trip through the
+ * GSettings backend.  Enums are kept apart because their GVariant is
+ * the nick, not the number the callers want. */
+#define CACHE_TAG "gnc-value-cache"
+
+typedef struct
+{
+    GHashTable *values;         /* key -> GVariant */
+    GHashTable *enums;          /* key -> GVariant holding an int32 */
+} GncGSettingsCache;
+
+static void
+gnc_gsettings_cache_free (gpointer data)
+{
+    GncGSettingsCache *cache = data;
+
+    g_hash_table_destroy (cache->values);
+    g_hash_table_destroy (cache->enums);
+    g_free (cache);
+}
+
+/* "change-event" is emitted before the "changed" signals the rest of
+ * GnuCash registers for, so their callbacks already read the new value. */
+static gboolean
+gnc_gsettings_cache_invalidate (GSettings *settings, GQuark *keys,
+                                gint n_keys, gpointer user_data)
+{
+    GncGSettingsCache *cache = user_data;
+    gint i;
+
+    if (n_keys == 0)
+    {
+        g_hash_table_remove_all (cache->values);
+        g_hash_table_remove_all (cache->enums);
+    }
+    for (i = 0; i < n_keys; i++)
+    {
+        const gchar *key = g_quark_to_string (keys[i]);
+
+        g_hash_table_remove (cache->values, key);
+        g_hash_table_remove (cache->enums, key);
+    }
+    return FALSE;
+}
+
+static void
+gnc_gsettings_cache_init (GSettings *settings)
+{
+    GncGSettingsCache *cache = g_new0 (GncGSettingsCache, 1);
+
+    cache->values = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                           (GDestroyNotify) g_variant_unref);
+    cache->enums = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                          (GDestroyNotify) g_variant_unref);
+    g_object_set_data_full (G_OBJECT (settings), CACHE_TAG, cache,
+                            gnc_gsettings_cache_free);
+    g_signal_connect (settings, "change-event",
+                      G_CALLBACK (gnc_gsettings_cache_invalidate), cache);
+}
+
+/* Returns the cached value of key, reading it first if need be, or NULL
+ * if the schema has no such key.  The value belongs to the cache. */
+static GVariant *
+gnc_gsettings_cached_value (GSettings *settings, const gchar *key)
+{
+    GncGSettingsCache *cache = g_object_get_data (G_OBJECT (settings), CACHE_TAG);
+    GVariant *value;
+
+    if (!key)
+        return NULL;
+    value = g_hash_table_lookup (cache->values, key);
+    if (!value && gnc_gsettings_is_valid_key (settings, key))
+    {
+        value = g_settings_get_value (settings, key);
+        g_hash_table_insert (cache->values, g_strdup (key), value);
+    }
+    return value;
+}
+
+static GVariant *
+gnc_gsettings_cached_enum (GSettings *settings, const gchar *key)
+{
+    GncGSettingsCache *cache = g_object_get_data (G_OBJECT (settings), CACHE_TAG);
+    GVariant *value;
+
+    if (!key)
+        return NULL;
+    value = g_hash_table_lookup (cache->enums, key);
+    if (!value && gnc_gsettings_is_valid_key (settings, key))
+    {
+        value = g_variant_ref_sink (g_variant_new_int32 (
+                                        g_settings_get_enum (settings, key)));
+        g_hash_table_insert (cache->enums, g_strdup (key), value);
+    }
+    return value;
+}
+
 static GSettings * gnc_gsettings_get_schema_ptr (const gchar *schema_str)
 {
     GSettings *gset = NULL;
-    gchar *full_name = gnc_gsettings_normalize_schema_name (schema_str);
+    gchar *full_name;
 
     ENTER("");
     if (!schema_hash)
         schema_hash = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
 
+    /* The schema is also kept under the name it was asked for, which
+     * spares building the full name on every preference read. */
+    gset = g_hash_table_lookup (schema_hash, schema_str ? schema_str : "");
+    if (gset)
+    {
+        LEAVE("");
+        return gset;
+    }
+
+    full_name = gnc_gsettings_normalize_schema_name (schema_str);
     gset = g_hash_table_lookup (schema_hash, full_name);
     DEBUG ("Looking for schema %s returned gsettings %p", full_name, gset);
     if (!gset)
@@ -104,7 +213,10 @@ static GSettings * gnc_gsettings_get_schema_ptr (const gchar *schema_str)
         gset = g_settings_new (full_name);
         DEBUG ("Created gsettings object %p for schema %s", gset, full_name);
         if (G_IS_SETTINGS(gset))
+        {
+            gnc_gsettings_cache_init (gset);
             g_hash_table_insert (schema_hash, full_name, gset);
+        }
         else
             PWARN ("Ignoring attempt to access unknown gsettings schema %s", full_name);
     }
@@ -112,6 +224,9 @@ static GSettings * gnc_gsettings_get_schema_ptr (const gchar *schema_str)
     {
         g_free(full_name);
     }
+    if (G_IS_SETTINGS(gset))
+        g_hash_table_insert (schema_hash, g_strdup (schema_str ? schema_str : ""),
+                             gset);
 
     LEAVE("");
     return gset;
@@ -280,10 +395,12 @@ gnc_gsettings_get_bool (const gchar *schema,
                         const gchar *key)
 {
     GSettings *schema_ptr = gnc_gsettings_get_schema_ptr (schema);
+    GVariant *value;
     g_return_val_if_fail (G_IS_SETTINGS (schema_ptr), FALSE);
 
-    if (gnc_gsettings_is_valid_key (schema_ptr, key))
-        return g_settings_get_boolean (schema_ptr, key);
+    value = gnc_gsettings_cached_value (schema_ptr, key);
+    if (value)
+        return g_variant_get_boolean (value);
     else
     {
         PERR ("Invalid key %s for schema %s", key, schema);
@@ -319,10 +436,12 @@ gnc_gsettings_get_int (const gchar *schema,
                        const gchar *key)
 {
     GSettings *schema_ptr = gnc_gsettings_get_schema_ptr (schema);
+    GVariant *value;
     g_return_val_if_fail (G_IS_SETTINGS (schema_ptr), 0);
 
-    if (gnc_gsettings_is_valid_key (schema_ptr, key))
-        return g_settings_get_int (schema_ptr, key);
+    value = gnc_gsettings_cached_value (schema_ptr, key);
+    if (value)
+        return g_variant_get_int32 (value);
     else
     {
         PERR ("Invalid key %s for schema %s", key, schema);
@@ -356,10 +475,12 @@ gnc_gsettings_get_float (const gchar *schema,
                          const gchar *key)
 {
     GSettings *schema_ptr = gnc_gsettings_get_schema_ptr (schema);
+    GVariant *value;
     g_return_val_if_fail (G_IS_SETTINGS (schema_ptr), 0);
 
-    if (gnc_gsettings_is_valid_key (schema_ptr, key))
-        return g_settings_get_double (schema_ptr, key);
+    value = gnc_gsettings_cached_value (schema_ptr, key);
+    if (value)
+        return g_variant_get_double (value);
     else
     {
         PERR ("Invalid key %s for schema %s", key, schema);
@@ -393,10 +514,12 @@ gnc_gsettings_get_string (const gchar *schema,
                           const gchar *key)
 {
     GSettings *schema_ptr = gnc_gsettings_get_schema_ptr (schema);
+    GVariant *value;
     g_return_val_if_fail (G_IS_SETTINGS (schema_ptr), NULL);
 
-    if (gnc_gsettings_is_valid_key (schema_ptr, key))
-        return g_settings_get_string (schema_ptr, key);
+    value = gnc_gsettings_cached_value (schema_ptr, key);
+    if (value)
+        return g_variant_dup_string (value, NULL);
     else
     {
         PERR ("Invalid key %s for schema %s", key, schema);
@@ -432,10 +555,12 @@ gnc_gsettings_get_enum (const gchar *schema,
                         const gchar *key)
 {
     GSettings *schema_ptr = gnc_gsettings_get_schema_ptr (schema);
+    GVariant *value;
     g_return_val_if_fail (G_IS_SETTINGS (schema_ptr), 0);
 
-    if (gnc_gsettings_is_valid_key (schema_ptr, key))
-        return g_settings_get_enum (schema_ptr, key);
+    value = gnc_gsettings_cached_enum (schema_ptr, key);
+    if (value)
+        return g_variant_get_int32 (value);
     else
     {
         PERR ("Invalid key %s for schema %s", key, schema);
@@ -469,10 +594,12 @@ gnc_gsettings_get_value (const gchar *schema,
                          const gchar *key)
 {
     GSettings *schema_ptr = gnc_gsettings_get_schema_ptr (schema);
+    GVariant *value;
     g_return_val_if_fail (G_IS_SETTINGS (schema_ptr), NULL);
 
-    if (gnc_gsettings_is_valid_key (schema_ptr, key))
-        return g_settings_get_value (schema_ptr, key);
+    value = gnc_gsettings_cached_value (schema_ptr, key);
+    if (value)
+        return g_variant_ref (value);
     else
     {
         PERR ("Invalid key %s for schema %s", key, schema);
@@ -34,6 +34,7 @@
 #include <glib.h>
 #include <glib-object.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "Account.h"
 #include "SX-book.h"
@@ -41,6 +42,7 @@
 #include "Scrub.h"
 #include "Split.h"
 #include "Transaction.h"
+#include "gnc-amortize.h"
 #include "gnc-commodity.h"
 #include "gnc-event.h"
 #include "gnc-exp-parser.h"
@@ -105,6 +107,43 @@ gnc_sx_instance_get_variables_for_parser(GHashTable *instance_var_hash)
     return parser_vars;
 }
 
+/* Compiled SX formulas, keyed by their text.  Every instance of an SX
+ * evaluates the same template split formulas, so each one is parsed
+ * only once; keying on the text keeps the cache right when a template
+ * split is edited.  Formulas that fail to compile map to NULL and are
+ * parsed each time so that the error gets reported. */
+static GHashTable *sx_compiled_formulas = NULL;
+
+static GNCExpression*
+_get_sx_compiled_formula(const char *formula_str)
+{
+    GNCExpression *expr;
+
+    if (sx_compiled_formulas == NULL)
+        sx_compiled_formulas = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+                               (GDestroyNotify)gnc_exp_parser_expression_free);
+    if (g_hash_table_lookup_extended(sx_compiled_formulas, formula_str,
+                                     NULL, (gpointer*)&expr))
+        return expr;
+
+    expr = gnc_exp_parser_compile(formula_str, NULL);
+    g_hash_table_insert(sx_compiled_formulas, g_strdup(formula_str), expr);
+    return expr;
+}
+
+/* gnc_exp_parser_parse_separate_vars(), through the compiled cache. */
+static gboolean
+_sx_eval_formula(const char *formula_str, gnc_numeric *value,
+                 char **error_loc, GHashTable *parser_vars)
+{
+    GNCExpression *expr = _get_sx_compiled_formula(formula_str);
+
+    if (expr == NULL)
+        return gnc_exp_parser_parse_separate_vars(formula_str, value,
+                                                  error_loc, parser_vars);
+    return gnc_exp_parser_eval(expr, value, error_loc, parser_vars);
+}
+
 int
 gnc_sx_parse_vars_from_formula(const char *formula,
                                GHashTable *var_hash,
@@ -119,7 +158,7 @@ gnc_sx_parse_vars_from_formula(const char *formula,
     parser_vars = gnc_sx_instance_get_variables_for_parser(var_hash);
 
     num = gnc_numeric_zero();
-    if (!gnc_exp_parser_parse_separate_vars(formula, &num, &errLoc, parser_vars))
+    if (!_sx_eval_formula(formula, &num, &errLoc, parser_vars))
     {
         toRet = -1;
     }
@@ -342,6 +381,113 @@ gnc_sx_instance_get_variables(GncSxInstance *inst)
     return vars;
 }
 
+/* Flattens everything about the SX that decides its instance dates and
+ * states, so that a change to anything else (its name, say) can be told
+ * apart from a change to the schedule. */
+static GArray*
+_gnc_sx_schedule_key(SchedXaction *sx)
+{
+    GArray *key = g_array_new(FALSE, FALSE, sizeof(gint32));
+    const GDate *date;
+    GList *iter;
+    gint32 val;
+
+#define KEY_ADD(v) (val = (gint32)(v), g_array_append_val(key, val))
+#define KEY_ADD_DATE(d) KEY_ADD((d) && g_date_valid(d) ? g_date_get_julian(d) : 0)
+    date = xaccSchedXactionGetStartDate(sx);
+    KEY_ADD_DATE(date);
+    date = xaccSchedXactionGetEndDate(sx);
+    KEY_ADD_DATE(date);
+    date = xaccSchedXactionGetLastOccurDate(sx);
+    KEY_ADD_DATE(date);
+    KEY_ADD(xaccSchedXactionGetNumOccur(sx));
+    KEY_ADD(xaccSchedXactionGetRemOccur(sx));
+    KEY_ADD(gnc_sx_get_instance_count(sx, NULL));
+    KEY_ADD(xaccSchedXactionGetAdvanceCreation(sx));
+    KEY_ADD(xaccSchedXactionGetAdvanceReminder(sx));
+    for (iter = gnc_sx_get_schedule(sx); iter != NULL; iter = iter->next)
+    {
+        Recurrence *r = (Recurrence*)iter->data;
+        GDate r_date = recurrenceGetDate(r);
+        KEY_ADD(recurrenceGetPeriodType(r));
+        KEY_ADD(recurrenceGetMultiplier(r));
+        KEY_ADD(recurrenceGetWeekendAdjust(r));
+        KEY_ADD_DATE(&r_date);
+    }
+    KEY_ADD(-1);
+    for (iter = gnc_sx_get_defer_instances(sx); iter != NULL; iter = iter->next)
+    {
+        SXTmpStateData *deferred = (SXTmpStateData*)iter->data;
+        KEY_ADD_DATE(&deferred->last_date);
+        KEY_ADD(deferred->num_occur_rem);
+        KEY_ADD(deferred->num_inst);
+    }
+#undef KEY_ADD_DATE
+#undef KEY_ADD
+
+    return key;
+}
+
+static gboolean
+_gnc_sx_schedule_key_equal(const GArray *a, const GArray *b)
+{
+    if (a == NULL || b == NULL || a->len != b->len)
+        return FALSE;
+    return memcmp(a->data, b->data, a->len * sizeof(gint32)) == 0;
+}
+
+static void
+_gnc_sx_range_ends(SchedXaction *sx, const GDate *range_end,
+                   GDate *creation_end, GDate *remind_end)
+{
+    *creation_end = *range_end;
+    g_date_add_days(creation_end, xaccSchedXactionGetAdvanceCreation(sx));
+    *remind_end = *creation_end;
+    g_date_add_days(remind_end, xaccSchedXactionGetAdvanceReminder(sx));
+}
+
+/* Appends the to-create and reminder instances that follow
+ * instances->horizon_state, up to the given ends, leaving
+ * horizon_state just past the last one. */
+static void
+_gnc_sx_gen_dated_instances(GncSxInstances *instances,
+                            const GDate *creation_end, const GDate *remind_end)
+{
+    SchedXaction *sx = instances->sx;
+    SXTmpStateData *temporal_state = instances->horizon_state;
+    GDate cur_date;
+
+    /* to-create */
+    g_date_clear(&cur_date, 1);
+    cur_date = xaccSchedXactionGetNextInstance(sx, temporal_state);
+    while (g_date_valid(&cur_date) && g_date_compare(&cur_date, creation_end) <= 0)
+    {
+        GncSxInstance *inst;
+        int seq_num;
+        seq_num = gnc_sx_get_instance_count(sx, temporal_state);
+        inst = gnc_sx_instance_new(instances, SX_INSTANCE_STATE_TO_CREATE,
+                                   &cur_date, temporal_state, seq_num);
+        instances->instance_list = g_list_append(instances->instance_list, inst);
+        gnc_sx_incr_temporal_state(sx, temporal_state);
+        cur_date = xaccSchedXactionGetNextInstance(sx, temporal_state);
+    }
+
+    /* reminders */
+    while (g_date_valid(&cur_date) &&
+           g_date_compare(&cur_date, remind_end) <= 0)
+    {
+        GncSxInstance *inst;
+        int seq_num;
+        seq_num = gnc_sx_get_instance_count(sx, temporal_state);
+        inst = gnc_sx_instance_new(instances, SX_INSTANCE_STATE_REMINDER,
+                                   &cur_date, temporal_state, seq_num);
+        instances->instance_list = g_list_append(instances->instance_list,
+                                                 inst);
+        gnc_sx_incr_temporal_state(sx, temporal_state);
+        cur_date = xaccSchedXactionGetNextInstance(sx, temporal_state);
+    }
+}
+
 static GncSxInstances*
 _gnc_sx_gen_instances(gpointer *data, gpointer user_data)
 {
@@ -349,15 +495,13 @@ _gnc_sx_gen_instances(gpointer *data, gpointer user_data)
     SchedXaction *sx = (SchedXaction*)data;
     const GDate *range_end = (const GDate*)user_data;
     GDate creation_end, remind_end;
-    GDate cur_date;
     SXTmpStateData *temporal_state = gnc_sx_create_temporal_state(sx);
 
     instances->sx = sx;
+    instances->schedule_key = _gnc_sx_schedule_key(sx);
+    instances->horizon = *range_end;
 
-    creation_end = *range_end;
-    g_date_add_days(&creation_end, xaccSchedXactionGetAdvanceCreation(sx));
-    remind_end = creation_end;
-    g_date_add_days(&remind_end, xaccSchedXactionGetAdvanceReminder(sx));
+    _gnc_sx_range_ends(sx, range_end, &creation_end, &remind_end);
 
     /* postponed */
     {
@@ -381,38 +525,88 @@ _gnc_sx_gen_instances(gpointer *data, gpointer user_data)
         }
     }
 
-    /* to-create */
-    g_date_clear(&cur_date, 1);
-    cur_date = xaccSchedXactionGetNextInstance(sx, temporal_state);
-    instances->next_instance_date = cur_date;
-    while (g_date_valid(&cur_date) && g_date_compare(&cur_date, &creation_end) <= 0)
+    g_date_clear(&instances->next_instance_date, 1);
+    instances->next_instance_date = xaccSchedXactionGetNextInstance(sx, temporal_state);
+    instances->horizon_state = temporal_state;
+    _gnc_sx_gen_dated_instances(instances, &creation_end, &remind_end);
+
+    return instances;
+}
+
+/* Moves the instances' horizon to range_end.  Returns TRUE if any
+ * instance was added, removed or changed state. */
+static gboolean
+_gnc_sx_instances_set_horizon(GncSxInstances *instances, const GDate *range_end)
+{
+    SchedXaction *sx = instances->sx;
+    GDate creation_end, remind_end;
+    gboolean changed = FALSE;
+    GList *iter, *next;
+
+    _gnc_sx_range_ends(sx, range_end, &creation_end, &remind_end);
+
+    for (iter = instances->instance_list; iter != NULL; iter = next)
     {
-        GncSxInstance *inst;
-        int seq_num;
-        seq_num = gnc_sx_get_instance_count(sx, temporal_state);
-        inst = gnc_sx_instance_new(instances, SX_INSTANCE_STATE_TO_CREATE,
-                                   &cur_date, temporal_state, seq_num);
-        instances->instance_list = g_list_append(instances->instance_list, inst);
-        gnc_sx_incr_temporal_state(sx, temporal_state);
-        cur_date = xaccSchedXactionGetNextInstance(sx, temporal_state);
+        GncSxInstance *inst = (GncSxInstance*)iter->data;
+        next = iter->next;
+
+        if (inst->orig_state == SX_INSTANCE_STATE_POSTPONED)
+            continue;
+
+        if (g_date_compare(&inst->date, &remind_end) > 0)
+        {
+            /* Past the new end; as the list is in date order, so is
+             * everything after it. */
+            gnc_g_list_cut(&instances->instance_list, iter);
+            g_list_foreach(iter, (GFunc)gnc_sx_instance_free, NULL);
+            g_list_free(iter);
+            changed = TRUE;
+            break;
+        }
+
+        if (inst->orig_state == SX_INSTANCE_STATE_REMINDER
+                && g_date_compare(&inst->date, &creation_end) <= 0)
+        {
+            inst->orig_state = SX_INSTANCE_STATE_TO_CREATE;
+            if (inst->state == SX_INSTANCE_STATE_REMINDER)
+                inst->state = SX_INSTANCE_STATE_TO_CREATE;
+            changed = TRUE;
+        }
+        else if (inst->orig_state == SX_INSTANCE_STATE_TO_CREATE
+                 && g_date_compare(&inst->date, &creation_end) > 0)
+        {
+            inst->orig_state = SX_INSTANCE_STATE_REMINDER;
+            if (inst->state == SX_INSTANCE_STATE_TO_CREATE)
+                inst->state = SX_INSTANCE_STATE_REMINDER;
+            changed = TRUE;
+        }
     }
 
-    /* reminders */
-    while (g_date_valid(&cur_date) &&
-           g_date_compare(&cur_date, &remind_end) <= 0)
+    if (g_date_compare(range_end, &instances->horizon) < 0)
     {
-        GncSxInstance *inst;
-        int seq_num;
-        seq_num = gnc_sx_get_instance_count(sx, temporal_state);
-        inst = gnc_sx_instance_new(instances, SX_INSTANCE_STATE_REMINDER,
-                                   &cur_date, temporal_state, seq_num);
-        instances->instance_list = g_list_append(instances->instance_list,
-                                                 inst);
-        gnc_sx_incr_temporal_state(sx, temporal_state);
-        cur_date = xaccSchedXactionGetNextInstance(sx, temporal_state);
+        /* Continue from just after whatever instance is now last. */
+        GList *last = g_list_last(instances->instance_list);
+        gnc_sx_destroy_temporal_state(instances->horizon_state);
+        if (last != NULL)
+        {
+            GncSxInstance *inst = (GncSxInstance*)last->data;
+            instances->horizon_state = gnc_sx_clone_temporal_state(inst->temporal_state);
+            gnc_sx_incr_temporal_state(sx, instances->horizon_state);
+        }
+        else
+        {
+            instances->horizon_state = gnc_sx_create_temporal_state(sx);
+        }
+    }
+    else
+    {
+        guint len = g_list_length(instances->instance_list);
+        _gnc_sx_gen_dated_instances(instances, &creation_end, &remind_end);
+        changed = changed || g_list_length(instances->instance_list) != len;
     }
 
-    return instances;
+    instances->horizon = *range_end;
+    return changed;
 }
 
 GncSxInstanceModel*
@@ -533,6 +727,12 @@ gnc_sx_instances_free(GncSxInstances *instances)
 
     instances->sx = NULL;
 
+    if (instances->schedule_key != NULL)
+        g_array_free(instances->schedule_key, TRUE);
+    instances->schedule_key = NULL;
+    gnc_sx_destroy_temporal_state(instances->horizon_state);
+    instances->horizon_state = NULL;
+
     for (instance_iter = instances->instance_list; instance_iter != NULL; instance_iter = instance_iter->next)
     {
         GncSxInstance *inst = (GncSxInstance*)instance_iter->data;
@@ -629,11 +829,48 @@ _gnc_sx_instance_find_by_sx(GncSxInstances *in_list_instances, SchedXaction *sx_
     return -1;
 }
 
+/* A template transaction changed: its SX's variables need parsing
+ * again, though its schedule is untouched. */
+static void
+_gnc_sx_instance_template_changed(GncSxInstanceModel *instances, Transaction *txn)
+{
+    Account *template_root;
+    GList *split_iter;
+
+    template_root = gnc_book_get_template_root(qof_instance_get_book(txn));
+    if (template_root == NULL)
+        return;
+
+    for (split_iter = xaccTransGetSplitList(txn); split_iter != NULL; split_iter = split_iter->next)
+    {
+        Account *acct = xaccSplitGetAccount((Split*)split_iter->data);
+        GList *iter;
+
+        if (acct == NULL || gnc_account_get_parent(acct) != template_root)
+            continue;
+
+        for (iter = instances->sx_instance_list; iter != NULL; iter = iter->next)
+        {
+            GncSxInstances *sx_instances = (GncSxInstances*)iter->data;
+            if (sx_instances->sx->template_acct != acct || sx_instances->template_changed)
+                continue;
+            sx_instances->template_changed = TRUE;
+            g_signal_emit_by_name(instances, "updated", (gpointer)sx_instances->sx);
+        }
+    }
+}
+
 static void
 _gnc_sx_instance_event_handler(QofInstance *ent, QofEventId event_type, gpointer user_data, gpointer evt_data)
 {
     GncSxInstanceModel *instances = GNC_SX_INSTANCE_MODEL(user_data);
 
+    if (GNC_IS_TRANSACTION(ent) && (event_type & (QOF_EVENT_MODIFY | QOF_EVENT_DESTROY)))
+    {
+        _gnc_sx_instance_template_changed(instances, GNC_TRANSACTION(ent));
+        return;
+    }
+
     /* selection rules {
     //   (gnc_collection_get_schedxaction_list(book), GNC_EVENT_ITEM_ADDED)
     //   (gnc_collection_get_schedxaction_list(book), GNC_EVENT_ITEM_REMOVED)
@@ -731,10 +968,81 @@ _find_unreferenced_vars(gchar *key,
     }
 }
 
+/* Takes over new_variable_names as the SX's variables, dropping the
+ * bindings of removed variables from each instance and adding the new
+ * ones. */
+static void
+_gnc_sx_instances_merge_variables(GncSxInstances *existing,
+                                  GHashTable *new_variable_names)
+{
+    GList *removed_var_names = NULL, *added_var_names = NULL;
+    GList *inst_iter = NULL;
+
+    if (existing->variable_names != NULL)
+    {
+        HashListPair removed_cb_data;
+        removed_cb_data.hash = new_variable_names;
+        removed_cb_data.list = NULL;
+        g_hash_table_foreach(existing->variable_names, (GHFunc)_find_unreferenced_vars, &removed_cb_data);
+        removed_var_names = removed_cb_data.list;
+    }
+    g_debug("%d removed variables", g_list_length(removed_var_names));
+
+    if (new_variable_names != NULL)
+    {
+        HashListPair added_cb_data;
+        added_cb_data.hash = existing->variable_names;
+        added_cb_data.list = NULL;
+        g_hash_table_foreach(new_variable_names, (GHFunc)_find_unreferenced_vars, &added_cb_data);
+        added_var_names = added_cb_data.list;
+    }
+    g_debug("%d added variables", g_list_length(added_var_names));
+
+    for (inst_iter = existing->instance_list; inst_iter != NULL; inst_iter = inst_iter->next)
+    {
+        GList *var_iter;
+        GncSxInstance *inst = (GncSxInstance*)inst_iter->data;
+
+        for (var_iter = removed_var_names; var_iter != NULL; var_iter = var_iter->next)
+        {
+            gchar *to_remove_key = (gchar*)var_iter->data;
+            g_hash_table_remove(inst->variable_bindings, to_remove_key);
+        }
+
+        for (var_iter = added_var_names; var_iter != NULL; var_iter = var_iter->next)
+        {
+            gchar *to_add_key = (gchar*)var_iter->data;
+            if (!g_hash_table_lookup_extended(
+                    inst->variable_bindings, to_add_key, NULL, NULL))
+            {
+                GncSxVariable *parent_var
+                    = g_hash_table_lookup(new_variable_names, to_add_key);
+                GncSxVariable *var_copy;
+
+                g_assert(parent_var != NULL);
+                var_copy = gnc_sx_variable_new_copy(parent_var);
+                g_hash_table_insert(inst->variable_bindings, g_strdup(to_add_key), var_copy);
+            }
+        }
+    }
+    g_list_free(removed_var_names);
+    g_list_free(added_var_names);
+
+    /* The removed names belong to the old table, so it goes last. */
+    if (existing->variable_names != NULL)
+    {
+        g_hash_table_destroy(existing->variable_names);
+    }
+    existing->variable_names = new_variable_names;
+    existing->variable_names_parsed = (new_variable_names != NULL);
+    existing->template_changed = FALSE;
+}
+
 void
 gnc_sx_instance_model_update_sx_instances(GncSxInstanceModel *model, SchedXaction *sx)
 {
     GncSxInstances *existing, *new_instances;
+    GArray *schedule_key;
     GList *link;
 
     link = g_list_find_custom(model->sx_instance_list, sx, (GCompareFunc)_gnc_sx_instance_find_by_sx);
@@ -744,11 +1052,39 @@ gnc_sx_instance_model_update_sx_instances(GncSxInstanceModel *model, SchedXactio
         return;
     }
 
-    // merge the new instance data into the existing structure, mutating as little as possible.
     existing = (GncSxInstances*)link->data;
+
+    /* Most modifications (the name, the auto-create flags) don't touch
+     * the schedule; then only the variables may need another look. */
+    schedule_key = _gnc_sx_schedule_key(sx);
+    if (_gnc_sx_schedule_key_equal(schedule_key, existing->schedule_key)
+            && g_date_compare(&existing->horizon, &model->range_end) == 0)
+    {
+        g_array_free(schedule_key, TRUE);
+        if (existing->template_changed)
+        {
+            GHashTable *variable_names
+                = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)gnc_sx_variable_free);
+            gnc_sx_get_variables(sx, variable_names);
+            g_hash_table_foreach(variable_names, (GHFunc)_wipe_parsed_sx_var, NULL);
+            _gnc_sx_instances_merge_variables(existing, variable_names);
+        }
+        return;
+    }
+    g_array_free(schedule_key, TRUE);
+
+    // merge the new instance data into the existing structure, mutating as little as possible.
     new_instances = _gnc_sx_gen_instances((gpointer)sx, &model->range_end);
     existing->sx = new_instances->sx;
     existing->next_instance_date = new_instances->next_instance_date;
+    existing->horizon = new_instances->horizon;
+    if (existing->schedule_key != NULL)
+        g_array_free(existing->schedule_key, TRUE);
+    existing->schedule_key = new_instances->schedule_key;
+    new_instances->schedule_key = NULL;
+    gnc_sx_destroy_temporal_state(existing->horizon_state);
+    existing->horizon_state = new_instances->horizon_state;
+    new_instances->horizon_state = NULL;
     {
         GList *existing_iter, *new_iter;
         gboolean existing_remain, new_remain;
@@ -797,66 +1133,29 @@ gnc_sx_instance_model_update_sx_instances(GncSxInstanceModel *model, SchedXactio
     }
 
     // handle variables
-    {
-        GList *removed_var_names = NULL, *added_var_names = NULL;
-        GList *inst_iter = NULL;
-
-        if (existing->variable_names != NULL)
-        {
-            HashListPair removed_cb_data;
-            removed_cb_data.hash = new_instances->variable_names;
-            removed_cb_data.list = NULL;
-            g_hash_table_foreach(existing->variable_names, (GHFunc)_find_unreferenced_vars, &removed_cb_data);
-            removed_var_names = removed_cb_data.list;
-        }
-        g_debug("%d removed variables", g_list_length(removed_var_names));
-
-        if (new_instances->variable_names != NULL)
-        {
-            HashListPair added_cb_data;
-            added_cb_data.hash = existing->variable_names;
-            added_cb_data.list = NULL;
-            g_hash_table_foreach(new_instances->variable_names, (GHFunc)_find_unreferenced_vars, &added_cb_data);
-            added_var_names = added_cb_data.list;
-        }
-        g_debug("%d added variables", g_list_length(added_var_names));
-
-        if (existing->variable_names != NULL)
-        {
-            g_hash_table_destroy(existing->variable_names);
-        }
-        existing->variable_names = new_instances->variable_names;
-        new_instances->variable_names = NULL;
+    _gnc_sx_instances_merge_variables(existing, new_instances->variable_names);
+    new_instances->variable_names = NULL;
+    gnc_sx_instances_free(new_instances);
+}
 
-        for (inst_iter = existing->instance_list; inst_iter != NULL; inst_iter = inst_iter->next)
-        {
-            GList *var_iter;
-            GncSxInstance *inst = (GncSxInstance*)inst_iter->data;
+void
+gnc_sx_instance_model_set_range_end(GncSxInstanceModel *model, const GDate *range_end)
+{
+    GList *iter;
 
-            for (var_iter = removed_var_names; var_iter != NULL; var_iter = var_iter->next)
-            {
-                gchar *to_remove_key = (gchar*)var_iter->data;
-                g_hash_table_remove(inst->variable_bindings, to_remove_key);
-            }
+    g_return_if_fail(GNC_IS_SX_INSTANCE_MODEL(model));
+    g_return_if_fail(range_end != NULL && g_date_valid(range_end));
 
-            for (var_iter = added_var_names; var_iter != NULL; var_iter = var_iter->next)
-            {
-                gchar *to_add_key = (gchar*)var_iter->data;
-                if (!g_hash_table_lookup_extended(
-                        inst->variable_bindings, to_add_key, NULL, NULL))
-                {
-                    GncSxVariable *parent_var
-                        = g_hash_table_lookup(existing->variable_names, to_add_key);
-                    GncSxVariable *var_copy;
+    if (g_date_compare(range_end, &model->range_end) == 0)
+        return;
+    model->range_end = *range_end;
 
-                    g_assert(parent_var != NULL);
-                    var_copy = gnc_sx_variable_new_copy(parent_var);
-                    g_hash_table_insert(inst->variable_bindings, g_strdup(to_add_key), var_copy);
-                }
-            }
-        }
+    for (iter = model->sx_instance_list; iter != NULL; iter = iter->next)
+    {
+        GncSxInstances *instances = (GncSxInstances*)iter->data;
+        if (_gnc_sx_instances_set_horizon(instances, range_end))
+            g_signal_emit_by_name(model, "updated", (gpointer)instances->sx);
     }
-    gnc_sx_instances_free(new_instances);
 }
 
 void
@@ -967,10 +1266,10 @@ _get_sx_formula_value(const SchedXaction* sx,
         {
             parser_vars = gnc_sx_instance_get_variables_for_parser(variable_bindings);
         }
-        if (!gnc_exp_parser_parse_separate_vars(formula_str,
-                                                numeric,
-                                                &parseErrorLoc,
-                                                parser_vars))
+        if (!_sx_eval_formula(formula_str,
+                              numeric,
+                              &parseErrorLoc,
+                              parser_vars))
         {
             gchar *err = g_strdup_printf ("Error parsing SX [%s] key [%s]=formula [%s] at [%s]: %s",
                             xaccSchedXactionGetName(sx),
@@ -1518,6 +1817,9 @@ typedef struct
     GList **creation_errors;
     const SchedXaction *sx;
     gnc_numeric count;
+    const GDate *range_start;
+    const GDate *range_end;
+    GArray *instance_nums; /* <gint>, filled in when first needed */
 } SxCashflowData;
 
 static void add_to_hash_amount(GHashTable* hash, const GncGUID* guid, const gnc_numeric* amount)
@@ -1579,6 +1881,146 @@ static void add_to_hash_amount(GHashTable* hash, const GncGUID* guid, const gnc_
             gnc_num_dbg_to_string(*elem));
 }
 
+/* TRUE if the split's formula under formula_key refers to the instance
+ * number "i" and to no other variable, so that it can be evaluated for
+ * each occurrence even though nobody fills in variables when
+ * forecasting. */
+static gboolean
+_sx_formula_uses_only_instance_num(const Split *template_split,
+                                   const char *formula_key)
+{
+    char *formula_str = NULL;
+    GHashTable *vars;
+    gboolean only_i;
+
+    qof_instance_get (QOF_INSTANCE (template_split),
+                      formula_key, &formula_str,
+                      NULL);
+    if (formula_str == NULL || *formula_str == '\0')
+    {
+        g_free (formula_str);
+        return FALSE;
+    }
+
+    vars = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)gnc_sx_variable_free);
+    gnc_sx_parse_vars_from_formula(formula_str, vars, NULL);
+    only_i = (g_hash_table_size(vars) == 1
+              && g_hash_table_lookup(vars, "i") != NULL);
+    g_hash_table_destroy(vars);
+    g_free (formula_str);
+    return only_i;
+}
+
+/* The instance numbers of the SX's occurrences in the forecast range. */
+static GArray*
+_sx_cashflow_instance_nums(SxCashflowData *creation_data)
+{
+    const SchedXaction *sx = creation_data->sx;
+    SXTmpStateData *tmp_state;
+    GDate next;
+
+    if (creation_data->instance_nums != NULL)
+        return creation_data->instance_nums;
+
+    creation_data->instance_nums = g_array_new(FALSE, FALSE, sizeof(gint));
+    tmp_state = gnc_sx_create_temporal_state(sx);
+    gnc_sx_skip_temporal_state(sx, tmp_state, creation_data->range_start);
+    next = xaccSchedXactionGetNextInstance(sx, tmp_state);
+    while (g_date_valid(&next) && g_date_compare(&next, creation_data->range_end) <= 0)
+    {
+        gint instance_num = gnc_sx_get_instance_count(sx, tmp_state);
+        g_array_append_val(creation_data->instance_nums, instance_num);
+        gnc_sx_incr_temporal_state(sx, tmp_state);
+        next = xaccSchedXactionGetNextInstance(sx, tmp_state);
+    }
+    gnc_sx_destroy_temporal_state(tmp_state);
+    return creation_data->instance_nums;
+}
+
+/* The sum of a loan payment formula over the occurrences in the range,
+ * from the loan's schedule instead of evaluating the formula for each
+ * of them.  An empty formula sums to zero.  FALSE if the formula is
+ * anything else. */
+static gboolean
+_sx_cashflow_loan_total(SxCashflowData *creation_data,
+                        const Split *template_split, const char *formula_key,
+                        gint64 denom, gnc_numeric *total)
+{
+    GArray *instance_nums;
+    char *formula_str = NULL;
+    GncLoanTerms loan;
+    gnc_numeric interest, principal;
+    gboolean is_interest, is_loan;
+
+    qof_instance_get (QOF_INSTANCE (template_split),
+                      formula_key, &formula_str,
+                      NULL);
+    if (formula_str == NULL || *formula_str == '\0')
+    {
+        g_free (formula_str);
+        *total = gnc_numeric_zero();
+        return TRUE;
+    }
+    is_loan = gnc_amortize_formula_terms(formula_str, &loan, &is_interest);
+    g_free (formula_str);
+    if (!is_loan)
+        return FALSE;
+
+    instance_nums = _sx_cashflow_instance_nums(creation_data);
+    loan.denom = denom;
+    if (!gnc_amortize_totals(&loan, (const gint*)instance_nums->data,
+                             instance_nums->len, &interest, &principal))
+        return FALSE;
+    *total = is_interest ? interest : principal;
+    return TRUE;
+}
+
+/* The split's debit minus credit summed over the occurrences in the
+ * range, evaluating the formulas for each occurrence's "i". */
+static gnc_numeric
+_sx_cashflow_per_instance(SxCashflowData *creation_data,
+                          const Split *template_split, gint64 denom)
+{
+    GArray *instance_nums = _sx_cashflow_instance_nums(creation_data);
+    GHashTable *bindings;
+    gnc_numeric total = gnc_numeric_zero();
+    gnc_numeric credit_total, debit_total;
+    guint n;
+
+    /* Loan payments come from the loan's schedule, rounded to the
+     * account's smallest unit as each payment would be. */
+    if (_sx_cashflow_loan_total(creation_data, template_split,
+                                "sx-credit-formula", denom, &credit_total)
+            && _sx_cashflow_loan_total(creation_data, template_split,
+                                       "sx-debit-formula", denom, &debit_total))
+        return gnc_numeric_sub(debit_total, credit_total, GNC_DENOM_AUTO,
+                               GNC_HOW_DENOM_REDUCE | GNC_HOW_RND_NEVER);
+
+    bindings = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)gnc_sx_variable_free);
+    for (n = 0; n < instance_nums->len; n++)
+    {
+        gnc_numeric credit_num = gnc_numeric_zero();
+        gnc_numeric debit_num = gnc_numeric_zero();
+        gnc_numeric i_num = gnc_numeric_create(g_array_index(instance_nums, gint, n), 1);
+
+        g_hash_table_insert(bindings, g_strdup("i"),
+                            gnc_sx_variable_new_full("i", i_num, FALSE));
+        _get_sx_formula_value(creation_data->sx, template_split,
+                              &credit_num, creation_data->creation_errors,
+                              "sx-credit-formula", "sx-credit-numeric",
+                              bindings);
+        _get_sx_formula_value(creation_data->sx, template_split,
+                              &debit_num, creation_data->creation_errors,
+                              "sx-debit-formula", "sx-debit-numeric",
+                              bindings);
+        total = gnc_numeric_add(total, gnc_numeric_sub_fixed(debit_num, credit_num),
+                                GNC_DENOM_AUTO,
+                                GNC_HOW_DENOM_REDUCE | GNC_HOW_RND_NEVER);
+    }
+    g_hash_table_destroy(bindings);
+    return total;
+}
+
 static gboolean
 create_cashflow_helper(Transaction *template_txn, void *user_data)
 {
@@ -1628,23 +2070,34 @@ create_cashflow_helper(Transaction *template_txn, void *user_data)
             gnc_numeric final_once, final;
             gint gncn_error;
 
-            /* Credit value */
-            _get_sx_formula_value(creation_data->sx, template_split,
-				  &credit_num, creation_data->creation_errors,
-				  "sx-credit-formula", "sx-credit-numeric",
-				  NULL);
-            /* Debit value */
-            _get_sx_formula_value(creation_data->sx, template_split,
-				  &debit_num, creation_data->creation_errors,
-				  "sx-debit-formula", "sx-debit-numeric", NULL);
-
-            /* The resulting cash flow number: debit minus credit,
-             * multiplied with the count factor. */
-            final_once = gnc_numeric_sub_fixed( debit_num, credit_num );
-            /* Multiply with the count factor. */
-            final = gnc_numeric_mul(final_once, creation_data->count,
-                                    gnc_numeric_denom(final_once),
-                                    GNC_HOW_RND_ROUND_HALF_UP);
+            if (_sx_formula_uses_only_instance_num(template_split, "sx-credit-formula")
+                    || _sx_formula_uses_only_instance_num(template_split, "sx-debit-formula"))
+            {
+                /* The amount depends on the occurrence, so the
+                 * formulas have to be evaluated for each of them. */
+                final = _sx_cashflow_per_instance(creation_data, template_split,
+                                                  xaccAccountGetCommoditySCU(split_acct));
+            }
+            else
+            {
+                /* Credit value */
+                _get_sx_formula_value(creation_data->sx, template_split,
+                                      &credit_num, creation_data->creation_errors,
+                                      "sx-credit-formula", "sx-credit-numeric",
+                                      NULL);
+                /* Debit value */
+                _get_sx_formula_value(creation_data->sx, template_split,
+                                      &debit_num, creation_data->creation_errors,
+                                      "sx-debit-formula", "sx-debit-numeric", NULL);
+
+                /* The resulting cash flow number: debit minus credit,
+                 * multiplied with the count factor. */
+                final_once = gnc_numeric_sub_fixed( debit_num, credit_num );
+                /* Multiply with the count factor. */
+                final = gnc_numeric_mul(final_once, creation_data->count,
+                                        gnc_numeric_denom(final_once),
+                                        GNC_HOW_RND_ROUND_HALF_UP);
+            }
 
             gncn_error = gnc_numeric_check(final);
             if (gncn_error != GNC_ERROR_OK)
@@ -1685,7 +2138,8 @@ create_cashflow_helper(Transaction *template_txn, void *user_data)
 static void
 instantiate_cashflow_internal(const SchedXaction* sx,
                               GHashTable* map,
-                              GList **creation_errors, gint count)
+                              GList **creation_errors, gint count,
+                              const GDate *range_start, const GDate *range_end)
 {
     SxCashflowData create_cashflow_data;
     Account* sx_template_account = gnc_sx_get_template_transaction_account(sx);
@@ -1707,12 +2161,18 @@ instantiate_cashflow_internal(const SchedXaction* sx,
     create_cashflow_data.creation_errors = creation_errors;
     create_cashflow_data.sx = sx;
     create_cashflow_data.count = gnc_numeric_create(count, 1);
+    create_cashflow_data.range_start = range_start;
+    create_cashflow_data.range_end = range_end;
+    create_cashflow_data.instance_nums = NULL;
 
     /* The cash flow numbers are in the transactions of the template
      * account, so run this foreach on the transactions. */
     xaccAccountForEachTransaction(sx_template_account,
                                   create_cashflow_helper,
                                   &create_cashflow_data);
+
+    if (create_cashflow_data.instance_nums != NULL)
+        g_array_free(create_cashflow_data.instance_nums, TRUE);
 }
 
 typedef struct
@@ -1743,7 +2203,9 @@ static void instantiate_cashflow_cb(gpointer data, gpointer _user_data)
         instantiate_cashflow_internal(sx,
                                       userdata->hash,
                                       userdata->creation_errors,
-                                      count);
+                                      count,
+                                      userdata->range_start,
+                                      userdata->range_end);
     }
 }
 
@@ -79,6 +79,13 @@ typedef struct _GncSxInstances
 
     /** GList<GncSxInstance*> **/
     GList *instance_list;
+
+    /* private: what the instances were generated from, so that updates
+     * only redo the work a change actually affects. */
+    GArray *schedule_key; /**< the SX's scheduling fields, flattened **/
+    gboolean template_changed; /**< template txns changed since parsing **/
+    GDate horizon; /**< the range end the instances were generated to **/
+    SXTmpStateData *horizon_state; /**< temporal state after the last instance **/
 } GncSxInstances;
 
 typedef enum
@@ -134,6 +141,14 @@ GncSxInstanceModel* gnc_sx_get_instances(const GDate *range_end, gboolean includ
  * finishing an iteration over an existing GncSxInstances*.
  **/
 void gnc_sx_instance_model_update_sx_instances(GncSxInstanceModel *model, SchedXaction *sx);
+/**
+ * Moves the end of the model's range.  When the range grows, each SX's
+ * existing instances are kept and only the instances between the old
+ * and new end are generated; when it shrinks, the instances past the
+ * new end are dropped.  Emits "updated" for each SX whose instances
+ * changed.
+ **/
+void gnc_sx_instance_model_set_range_end(GncSxInstanceModel *model, const GDate *range_end);
 void gnc_sx_instance_model_remove_sx_instances(GncSxInstanceModel *model, SchedXaction *sx);
 
 /** @return GList<GncSxVariable*>. Caller owns the list, but not the items. **/
@@ -0,0 +1,173 @@
+/********************************************************************\
+ * gnc-trans-quickfill.c -- Create transaction text quick-fills     *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+\********************************************************************/
+
+#include "config.h"
+#include "gnc-trans-quickfill.h"
+#include "engine/gnc-event.h"
+#include "engine/Transaction.h"
+
+/* This static indicates the debugging module that this .o belongs to. */
+static QofLogModule log_module = GNC_MOD_REGISTER;
+
+#define TRANS_QF_KEY "gnc-trans-quickfill"
+
+/* Number of transactions added to the quickfills per idle call. */
+#define TRANS_QF_CHUNK 500
+
+typedef struct
+{
+    QuickFill *desc_qf;
+    QuickFill *memo_qf;
+    QofBook *book;
+    gint  listener;
+    GList *pending;     /* transactions still to be added */
+    guint idle_id;
+} TransQF;
+
+static void
+add_trans_texts (TransQF *qfb, Transaction *trans)
+{
+    GList *node;
+    const char *text;
+
+    text = xaccTransGetDescription (trans);
+    if (text && *text)
+        gnc_quickfill_insert (qfb->desc_qf, text, QUICKFILL_LIFO);
+
+    for (node = xaccTransGetSplitList (trans); node; node = node->next)
+    {
+        text = xaccSplitGetMemo (node->data);
+        if (text && *text)
+            gnc_quickfill_insert (qfb->memo_qf, text, QUICKFILL_LIFO);
+    }
+}
+
+/* Transactions can be destroyed while still waiting to be added. */
+static void
+listen_for_trans_events (QofInstance *entity,  QofEventId event_type,
+                         gpointer user_data, gpointer event_data)
+{
+    TransQF *qfb = user_data;
+
+    if (!GNC_IS_TRANSACTION (entity))
+        return;
+    if (qof_instance_get_book (entity) != qfb->book)
+        return;
+
+    if (event_type & QOF_EVENT_DESTROY)
+    {
+        if (qfb->pending)
+            qfb->pending = g_list_remove (qfb->pending, entity);
+        return;
+    }
+
+    if (0 == (event_type & (QOF_EVENT_CREATE | QOF_EVENT_MODIFY)))
+        return;
+
+    add_trans_texts (qfb, GNC_TRANSACTION (entity));
+}
+
+static gboolean
+load_trans_chunk (gpointer user_data)
+{
+    TransQF *qfb = user_data;
+    gint n;
+
+    for (n = 0; qfb->pending && n < TRANS_QF_CHUNK; n++)
+    {
+        GList *node = qfb->pending;
+
+        add_trans_texts (qfb, node->data);
+        qfb->pending = g_list_delete_link (qfb->pending, node);
+    }
+
+    if (qfb->pending)
+        return TRUE;
+
+    DEBUG ("shared transaction quickfills of book %p complete", qfb->book);
+    qfb->idle_id = 0;
+    return FALSE;
+}
+
+static void
+collect_trans (QofInstance *inst, gpointer user_data)
+{
+    GList **list = user_data;
+    *list = g_list_prepend (*list, inst);
+}
+
+static void
+shared_quickfill_destroy (QofBook *book, gpointer key, gpointer user_data)
+{
+    TransQF *qfb = user_data;
+
+    if (qfb->idle_id)
+        g_source_remove (qfb->idle_id);
+    g_list_free (qfb->pending);
+    gnc_quickfill_destroy (qfb->desc_qf);
+    gnc_quickfill_destroy (qfb->memo_qf);
+    qof_event_unregister_handler (qfb->listener);
+    g_free (qfb);
+}
+
+static TransQF *
+get_shared_quickfills (QofBook *book)
+{
+    TransQF *qfb;
+
+    g_assert (book);
+
+    qfb = qof_book_get_data (book, TRANS_QF_KEY);
+    if (qfb)
+        return qfb;
+
+    qfb = g_new0 (TransQF, 1);
+    qfb->desc_qf = gnc_quickfill_new ();
+    qfb->memo_qf = gnc_quickfill_new ();
+    qfb->book = book;
+
+    /* Filling the quickfills from a big book takes a while, so only
+     * gather the transactions here and add them from the idle loop. */
+    qof_collection_foreach (qof_book_get_collection (book, GNC_ID_TRANS),
+                            collect_trans, &qfb->pending);
+    if (qfb->pending)
+        qfb->idle_id = g_idle_add (load_trans_chunk, qfb);
+
+    qfb->listener =
+        qof_event_register_handler (listen_for_trans_events, qfb);
+
+    qof_book_set_data_fin (book, TRANS_QF_KEY, qfb, shared_quickfill_destroy);
+
+    return qfb;
+}
+
+QuickFill *
+gnc_get_shared_trans_desc_quickfill (QofBook *book)
+{
+    return get_shared_quickfills (book)->desc_qf;
+}
+
+QuickFill *
+gnc_get_shared_split_memo_quickfill (QofBook *book)
+{
+    return get_shared_quickfills (book)->memo_qf;
+}
@@ -0,0 +1,63 @@
+/********************************************************************\
+ * gnc-trans-quickfill.h -- Create transaction text quick-fills     *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+\********************************************************************/
+/** @addtogroup QuickFill Auto-complete typed user input.
+   @{
+*/
+/** Similar to the @ref Account_QuickFill account name quickfill, we
+ * create cached quickfills with the descriptions of all transactions
+ * and the memos of all splits of a book, shared by all registers.
+*/
+
+#ifndef GNC_TRANS_QUICKFILL_H
+#define GNC_TRANS_QUICKFILL_H
+
+#include "qof.h"
+#include "app-utils/QuickFill.h"
+
+/** Fetch the quickfill of the transaction descriptions of a book.
+ *
+ *  The quickfill is created on the first call and then filled from
+ *  the book's transactions a chunk at a time from the main loop's
+ *  idle handler, so it may be incomplete for a moment after the
+ *  first call.  It listens to transaction events and adds the
+ *  descriptions of new and modified transactions.  Strings are never
+ *  removed, in the same way as a register's own quickfill.
+ *
+ * \param book The book
+ *
+ * \return The shared QuickFill object, owned by the book.
+ */
+QuickFill * gnc_get_shared_trans_desc_quickfill (QofBook *book);
+
+/** Fetch the quickfill of the split memos of a book.  It is built and
+ *  maintained together with the description quickfill, see
+ *  gnc_get_shared_trans_desc_quickfill().
+ *
+ * \param book The book
+ *
+ * \return The shared QuickFill object, owned by the book.
+ */
+QuickFill * gnc_get_shared_split_memo_quickfill (QofBook *book);
+
+#endif
+
+/** @} */
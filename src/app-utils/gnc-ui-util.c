@@ -1328,19 +1328,208 @@ gnc_integral_print_info (void)
     return info;
 }
 
+struct _GNCAmountFormatter
+{
+    GNCPrintAmountInfo info;
+
+    const char *currency_symbol;
+    /* Only the first character of each is used. */
+    char decimal_point[8];
+    char separator[8];
+    const char *grouping;
+
+    /* [0] for amounts that aren't negative, [1] for those that are. */
+    struct
+    {
+        char cs_precedes;
+        char sep_by_space;
+        char sign_posn;
+        const char *sign;
+    } style[2];
+};
+
+static void
+gnc_amount_formatter_init (GNCAmountFormatter *fmt,
+                           const GNCPrintAmountInfo *info)
+{
+    struct lconv *lc = gnc_localeconv();
+    int i;
+
+    fmt->info = *info;
+
+    g_utf8_strncpy (fmt->decimal_point,
+                    info->monetary ? lc->mon_decimal_point : lc->decimal_point,
+                    1);
+    g_utf8_strncpy (fmt->separator,
+                    info->monetary ? lc->mon_thousands_sep : lc->thousands_sep,
+                    1);
+    fmt->grouping = info->monetary ? lc->mon_grouping : lc->grouping;
+
+    fmt->style[0].cs_precedes  = lc->p_cs_precedes;
+    fmt->style[0].sep_by_space = lc->p_sep_by_space;
+    fmt->style[0].sign_posn    = lc->p_sign_posn;
+    fmt->style[0].sign         = lc->positive_sign;
+    fmt->style[1].cs_precedes  = lc->n_cs_precedes;
+    fmt->style[1].sep_by_space = lc->n_sep_by_space;
+    fmt->style[1].sign_posn    = lc->n_sign_posn;
+    fmt->style[1].sign         = lc->negative_sign;
+
+    if (!info->use_locale)
+        for (i = 0; i < 2; i++)
+        {
+            fmt->style[i].cs_precedes = TRUE;
+            fmt->style[i].sep_by_space = TRUE;
+        }
+
+    if (info->commodity && info->use_symbol)
+    {
+        fmt->currency_symbol = gnc_commodity_get_nice_symbol (info->commodity);
+        if (!gnc_commodity_is_iso (info->commodity))
+            for (i = 0; i < 2; i++)
+            {
+                fmt->style[i].cs_precedes = FALSE;
+                fmt->style[i].sep_by_space = TRUE;
+            }
+    }
+    else /* !info->use_symbol || !info->commodity */
+        fmt->currency_symbol = "";
+}
+
+GNCAmountFormatter *
+gnc_amount_formatter_new (GNCPrintAmountInfo info)
+{
+    GNCAmountFormatter *fmt = g_new (GNCAmountFormatter, 1);
+
+    gnc_amount_formatter_init (fmt, &info);
+    return fmt;
+}
+
+void
+gnc_amount_formatter_free (GNCAmountFormatter *fmt)
+{
+    g_free (fmt);
+}
+
+static const gint64 powers_of_ten[] =
+{
+    G_GINT64_CONSTANT(1), G_GINT64_CONSTANT(10), G_GINT64_CONSTANT(100),
+    G_GINT64_CONSTANT(1000), G_GINT64_CONSTANT(10000),
+    G_GINT64_CONSTANT(100000), G_GINT64_CONSTANT(1000000),
+    G_GINT64_CONSTANT(10000000), G_GINT64_CONSTANT(100000000),
+    G_GINT64_CONSTANT(1000000000), G_GINT64_CONSTANT(10000000000),
+    G_GINT64_CONSTANT(100000000000), G_GINT64_CONSTANT(1000000000000),
+    G_GINT64_CONSTANT(10000000000000), G_GINT64_CONSTANT(100000000000000),
+    G_GINT64_CONSTANT(1000000000000000), G_GINT64_CONSTANT(10000000000000000),
+    G_GINT64_CONSTANT(100000000000000000),
+    G_GINT64_CONSTANT(1000000000000000000)
+};
+
+/* Prints the absolute value of val straight from its digits when its
+ * denominator is a power of ten, which is the case for nearly every
+ * amount and price in a book.  Gives the same string as the general
+ * code below, and returns -1 for the values it leaves to it. */
+static int
+PrintDecimalAmount (char *buf, gnc_numeric val, const GNCAmountFormatter *fmt,
+                    int min_dp, int max_dp)
+{
+    char digits[64], *p, *out = buf;
+    const char *group = fmt->grouping;
+    gint64 num, whole, frac;
+    int dp, n_digits, group_count, num_decimal_places, i;
+
+    /* An empty separator or decimal point trips up the general code;
+     * leave those locales to it so both print the same. */
+    if (val.num == G_MININT64 || val.denom <= 0 ||
+        fmt->decimal_point[0] == '\0' ||
+        (fmt->info.use_separators && fmt->separator[0] == '\0'))
+        return -1;
+    for (dp = 0; dp < (int)G_N_ELEMENTS (powers_of_ten); dp++)
+        if (powers_of_ten[dp] == val.denom)
+            break;
+    if (dp == G_N_ELEMENTS (powers_of_ten))
+        return -1;
+
+    num = ABS (val.num);
+    if (fmt->info.round && fmt->info.force_fit && dp > max_dp)
+    {
+        gint64 rounding = 5 * powers_of_ten[dp - max_dp - 1];
+
+        if (num > G_MAXINT64 - rounding)
+            return -1;
+        num += rounding;
+    }
+    whole = num / val.denom;
+    frac = num % val.denom;
+
+    /* The whole part, backwards, with the separators. */
+    p = digits;
+    group_count = 0;
+    do
+    {
+        *p++ = '0' + whole % 10;
+        whole /= 10;
+        if (whole && fmt->info.use_separators && *group != CHAR_MAX &&
+            ++group_count == *group)
+        {
+            *p++ = '\0';        /* marks a separator */
+            group_count = 0;
+            if (group[1] != '\0')
+                group++;
+        }
+    }
+    while (whole);
+
+    while (p > digits)
+    {
+        if (*--p)
+            *out++ = *p;
+        else
+            out = g_stpcpy (out, fmt->separator);
+    }
+
+    /* The fraction, cut at max_dp and without trailing zeros beyond
+     * min_dp. */
+    n_digits = MIN (dp, max_dp);
+    frac /= powers_of_ten[dp - n_digits];
+    num_decimal_places = n_digits;
+    while (num_decimal_places > min_dp && frac % 10 == 0)
+    {
+        frac /= 10;
+        num_decimal_places--;
+    }
+    if (num_decimal_places < min_dp)
+        num_decimal_places = min_dp;
+
+    if (num_decimal_places > 0)
+    {
+        int frac_digits = MIN (num_decimal_places, n_digits);
+
+        out = g_stpcpy (out, fmt->decimal_point);
+        for (i = frac_digits - 1; i >= 0; i--)
+        {
+            out[i] = '0' + frac % 10;
+            frac /= 10;
+        }
+        out += frac_digits;
+        for (i = frac_digits; i < num_decimal_places; i++)
+            *out++ = '0';
+    }
+    *out = '\0';
+
+    return out - buf;
+}
+
 /* Utility function for printing non-negative amounts */
 static int
-PrintAmountInternal(char *buf, gnc_numeric val, const GNCPrintAmountInfo *info)
+PrintAmountInternal(char *buf, gnc_numeric val, const GNCAmountFormatter *fmt)
 {
-    struct lconv *lc = gnc_localeconv();
+    const GNCPrintAmountInfo *info = &fmt->info;
     int num_whole_digits;
     char temp_buf[128];
     gnc_numeric whole, rounding;
-    int min_dp, max_dp;
+    int min_dp, max_dp, len;
     gboolean value_is_negative, value_is_decimal;
 
-    g_return_val_if_fail (info != NULL, 0);
-
     if (gnc_numeric_check (val))
     {
         PWARN ("Bad numeric: %s.",
@@ -1349,13 +1538,6 @@ PrintAmountInternal(char *buf, gnc_numeric val, const GNCPrintAmountInfo *info)
         return 0;
     }
 
-    /* Print the absolute value, but remember sign */
-    value_is_negative = gnc_numeric_negative_p (val);
-    val = gnc_numeric_abs (val);
-
-    /* Try to print as decimal. */
-    value_is_decimal = gnc_numeric_to_decimal(&val, NULL);
-
     /* Force at least auto_decimal_places zeros */
     if (auto_decimal_enabled)
     {
@@ -1373,6 +1555,17 @@ PrintAmountInternal(char *buf, gnc_numeric val, const GNCPrintAmountInfo *info)
     if (!info->force_fit)
         max_dp = 99;
 
+    len = PrintDecimalAmount (buf, val, fmt, min_dp, max_dp);
+    if (len >= 0)
+        return len;
+
+    /* Print the absolute value, but remember sign */
+    value_is_negative = gnc_numeric_negative_p (val);
+    val = gnc_numeric_abs (val);
+
+    /* Try to print as decimal. */
+    value_is_decimal = gnc_numeric_to_decimal(&val, NULL);
+
     /* rounding? -- can only ROUND if force_fit is also true */
     if (value_is_decimal && info->round && info->force_fit)
     {
@@ -1409,23 +1602,12 @@ PrintAmountInternal(char *buf, gnc_numeric val, const GNCPrintAmountInfo *info)
     else
     {
         int group_count;
-        char *separator;
+        const char *separator = fmt->separator;
         char *temp_ptr;
         char *buf_ptr;
-        char *group;
+        const char *group = fmt->grouping;
         gchar *rev_buf;
 
-        if (info->monetary)
-        {
-            separator = lc->mon_thousands_sep;
-            group = lc->mon_grouping;
-        }
-        else
-        {
-            separator = lc->thousands_sep;
-            group = lc->grouping;
-        }
-
         buf_ptr = buf;
         temp_ptr = &temp_buf[num_whole_digits - 1];
         group_count = 0;
@@ -1495,14 +1677,10 @@ PrintAmountInternal(char *buf, gnc_numeric val, const GNCPrintAmountInfo *info)
     }
     else
     {
-        char *decimal_point;
         guint8 num_decimal_places = 0;
         char *temp_ptr = temp_buf;
 
-        decimal_point = info->monetary
-                        ? lc->mon_decimal_point
-                        : lc->decimal_point;
-        g_utf8_strncpy(temp_ptr, decimal_point, 1);
+        g_utf8_strncpy(temp_ptr, fmt->decimal_point, 1);
         temp_ptr = g_utf8_find_next_char(temp_ptr, NULL);
 
         while (!gnc_numeric_zero_p (val)
@@ -1550,14 +1728,10 @@ PrintAmountInternal(char *buf, gnc_numeric val, const GNCPrintAmountInfo *info)
     return strlen(buf);
 }
 
-/**
- * @param bufp Should be at least 64 chars.
- **/
 int
-xaccSPrintAmount (char * bufp, gnc_numeric val, GNCPrintAmountInfo info)
+gnc_amount_formatter_print (const GNCAmountFormatter *fmt, char *bufp,
+                            gnc_numeric val)
 {
-    struct lconv *lc;
-
     char *orig_bufp = bufp;
     const char *currency_symbol;
     const char *sign;
@@ -1567,52 +1741,18 @@ xaccSPrintAmount (char * bufp, gnc_numeric val, GNCPrintAmountInfo info)
     char sign_posn;
 
     gboolean print_sign = TRUE;
-    gboolean is_shares = FALSE;
     gboolean print_absolute = FALSE;
+    int style;
 
-    if (!bufp)
+    if (!bufp || !fmt)
         return 0;
 
-    lc = gnc_localeconv();
-    if (info.use_locale)
-        if (gnc_numeric_negative_p (val))
-        {
-            cs_precedes  = lc->n_cs_precedes;
-            sep_by_space = lc->n_sep_by_space;
-        }
-        else
-        {
-            cs_precedes  = lc->p_cs_precedes;
-            sep_by_space = lc->p_sep_by_space;
-        }
-    else
-    {
-        cs_precedes = TRUE;
-        sep_by_space = TRUE;
-    }
-
-    if (info.commodity && info.use_symbol)
-    {
-        currency_symbol = gnc_commodity_get_nice_symbol (info.commodity);
-        if (!gnc_commodity_is_iso (info.commodity))
-        {
-            cs_precedes  = FALSE;
-            sep_by_space = TRUE;
-        }
-    }
-    else /* !info.use_symbol || !info.commodity */
-        currency_symbol = "";
-
-    if (gnc_numeric_negative_p (val))
-    {
-        sign = lc->negative_sign;
-        sign_posn = lc->n_sign_posn;
-    }
-    else
-    {
-        sign = lc->positive_sign;
-        sign_posn = lc->p_sign_posn;
-    }
+    style = gnc_numeric_negative_p (val) ? 1 : 0;
+    cs_precedes  = fmt->style[style].cs_precedes;
+    sep_by_space = fmt->style[style].sep_by_space;
+    sign_posn    = fmt->style[style].sign_posn;
+    sign         = fmt->style[style].sign;
+    currency_symbol = fmt->currency_symbol;
 
     if (gnc_numeric_zero_p (val) || (sign == NULL) || (sign[0] == 0))
         print_sign = FALSE;
@@ -1628,7 +1768,7 @@ xaccSPrintAmount (char * bufp, gnc_numeric val, GNCPrintAmountInfo info)
         if (print_sign && (sign_posn == 3))
             bufp = g_stpcpy(bufp, sign);
 
-        if (info.use_symbol)
+        if (fmt->info.use_symbol)
         {
             bufp = g_stpcpy(bufp, currency_symbol);
             if (sep_by_space)
@@ -1650,7 +1790,7 @@ xaccSPrintAmount (char * bufp, gnc_numeric val, GNCPrintAmountInfo info)
     /* Now print the value */
     bufp += PrintAmountInternal(bufp,
                                 print_absolute ? gnc_numeric_abs(val) : val,
-                                &info);
+                                fmt);
 
     /* Now see if we print parentheses */
     if (print_sign && (sign_posn == 0))
@@ -1663,7 +1803,7 @@ xaccSPrintAmount (char * bufp, gnc_numeric val, GNCPrintAmountInfo info)
         if (print_sign && (sign_posn == 3))
             bufp = g_stpcpy(bufp, sign);
 
-        if (info.use_symbol)
+        if (fmt->info.use_symbol)
         {
             if (sep_by_space)
                 bufp = g_stpcpy(bufp, " ");
@@ -1683,6 +1823,59 @@ xaccSPrintAmount (char * bufp, gnc_numeric val, GNCPrintAmountInfo info)
     return (bufp - orig_bufp);
 }
 
+gchar **
+gnc_amount_formatter_print_all (const GNCAmountFormatter *fmt,
+                                const gnc_numeric *vals, guint n_vals)
+{
+    GString *text;
+    gsize *offsets;
+    gchar **strings;
+    gchar *block;
+    char buf[1024];
+    guint i;
+
+    g_return_val_if_fail (fmt != NULL, NULL);
+    g_return_val_if_fail (vals != NULL || n_vals == 0, NULL);
+
+    text = g_string_sized_new (n_vals * 16);
+    offsets = g_new (gsize, n_vals);
+    for (i = 0; i < n_vals; i++)
+    {
+        int len = gnc_amount_formatter_print (fmt, buf, vals[i]);
+
+        offsets[i] = text->len;
+        g_string_append_len (text, buf, len);
+        g_string_append_c (text, '\0');
+    }
+
+    /* The vector and the strings in one block, so one g_free does. */
+    strings = g_malloc ((n_vals + 1) * sizeof (gchar *) + text->len);
+    block = (gchar *)(strings + n_vals + 1);
+    memcpy (block, text->str, text->len);
+    for (i = 0; i < n_vals; i++)
+        strings[i] = block + offsets[i];
+    strings[n_vals] = NULL;
+
+    g_free (offsets);
+    g_string_free (text, TRUE);
+    return strings;
+}
+
+/**
+ * @param bufp Should be at least 64 chars.
+ **/
+int
+xaccSPrintAmount (char * bufp, gnc_numeric val, GNCPrintAmountInfo info)
+{
+    GNCAmountFormatter fmt;
+
+    if (!bufp)
+        return 0;
+
+    gnc_amount_formatter_init (&fmt, &info);
+    return gnc_amount_formatter_print (&fmt, bufp, val);
+}
+
 const char *
 xaccPrintAmount (gnc_numeric val, GNCPrintAmountInfo info)
 {
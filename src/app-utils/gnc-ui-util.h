@@ -292,6 +292,31 @@ GNCPrintAmountInfo gnc_integral_print_info (void);
 const char * xaccPrintAmount (gnc_numeric val, GNCPrintAmountInfo info);
 int xaccSPrintAmount (char *buf, gnc_numeric val, GNCPrintAmountInfo info);
 
+/* A GNCAmountFormatter holds what xaccSPrintAmount works out from the
+ *    locale, the commodity and the print info on every call.  Code that
+ *    prints many amounts the same way, such as a register column or a
+ *    report, can make one and print with it instead.  It is not
+ *    updated when the commodity's symbol changes, so make a new one for
+ *    each redraw rather than keeping it.
+ *
+ * gnc_amount_formatter_print() prints like xaccSPrintAmount() into buf,
+ *    which should be at least 64 chars, and returns the length.  It
+ *    doesn't allocate memory.
+ *
+ * gnc_amount_formatter_print_all() prints n_vals amounts and returns
+ *    them as a NULL terminated vector.  The vector and its strings are
+ *    a single block; free it with g_free(), not g_strfreev().
+ */
+typedef struct _GNCAmountFormatter GNCAmountFormatter;
+
+GNCAmountFormatter * gnc_amount_formatter_new (GNCPrintAmountInfo info);
+void gnc_amount_formatter_free (GNCAmountFormatter *fmt);
+int gnc_amount_formatter_print (const GNCAmountFormatter *fmt, char *buf,
+                                gnc_numeric val);
+gchar ** gnc_amount_formatter_print_all (const GNCAmountFormatter *fmt,
+                                         const gnc_numeric *vals,
+                                         guint n_vals);
+
 const gchar *printable_value(gdouble val, gint denom);
 gchar *number_to_words(gdouble val, gint64 denom);
 gchar *numeric_to_words(gnc_numeric val);
@@ -1166,18 +1166,27 @@
          section
          name
          default-value)
-  (let* ((value (if (list? default-value)
-                    default-value
-                    (gnc-query2scm default-value)))
+  ;; The value is a query handle, which owns its query, or '() for no
+  ;; query.  Saved reports store the handle's string; the list form
+  ;; older reports stored is still read.
+  (define (query->value query)
+    (cond ((null? query) query)
+          ((gnc-query-handle-p query) query)
+          ((string? query) (gnc-string2query-handle query))
+          ((list? query) (gnc-scm2query-handle query))
+          (else (gnc-query2handle query))))
+  (let* ((value (query->value default-value))
          (value->string (lambda ()
-                          (string-append "'" (gnc:value->string value)))))
+                          (if (gnc-query-handle-p value)
+                              (gnc:value->string
+                               (gnc-query-handle2string value))
+                              (string-append
+                               "'" (gnc:value->string value))))))
     (gnc:make-option
      section name "" 'query #f
      (lambda () value)
-     (lambda (x) (set! value (if (list? x) x (gnc-query2scm x))))
-     (lambda () (if (list? default-value)
-                    default-value
-                    (gnc-query2scm default-value)))
+     (lambda (x) (set! value (query->value x)))
+     (lambda () (query->value default-value))
      (gnc:restore-form-generator value->string)
      #f
      #f
@@ -0,0 +1,107 @@
+/********************************************************************
+ * print-amount-benchmark.c: speed of amount printing and parsing   *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+********************************************************************/
+#include "config.h"
+
+#include <glib.h>
+
+#include "qof.h"
+#include "gnc-ui-util.h"
+#include "benchmark-support.h"
+
+typedef struct
+{
+    gnc_numeric amount;
+    GNCPrintAmountInfo info;
+} PrintBench;
+
+static void
+bench_print (gpointer data, guint64 iterations)
+{
+    PrintBench *b = data;
+    guint64 i;
+
+    for (i = 0; i < iterations; i++)
+        gnc_benchmark_consume (xaccPrintAmount (b->amount, b->info)[0]);
+}
+
+static void
+bench_formatter (gpointer data, guint64 iterations)
+{
+    PrintBench *b = data;
+    GNCAmountFormatter *fmt = gnc_amount_formatter_new (b->info);
+    char buf[64];
+    guint64 i;
+
+    for (i = 0; i < iterations; i++)
+    {
+        gnc_amount_formatter_print (fmt, buf, b->amount);
+        gnc_benchmark_consume (buf[0]);
+    }
+    gnc_amount_formatter_free (fmt);
+}
+
+static void
+bench_parse (gpointer data, guint64 iterations)
+{
+    PrintBench *b = data;
+    gchar *str = g_strdup (xaccPrintAmount (b->amount, b->info));
+    gnc_numeric n;
+    guint64 i;
+
+    for (i = 0; i < iterations; i++)
+    {
+        xaccParseAmount (str, b->info.monetary, &n, NULL);
+        gnc_benchmark_consume (n.num);
+    }
+    g_free (str);
+}
+
+int
+main (int argc, char **argv)
+{
+    PrintBench b;
+
+    gnc_benchmark_init (&argc, &argv);
+    qof_init ();
+
+    b.amount = gnc_numeric_create (-123456789, 100);
+    b.info = gnc_default_print_info (FALSE);
+    gnc_benchmark_run ("print-amount/currency", bench_print, &b, 500000);
+    gnc_benchmark_run ("amount-formatter/currency", bench_formatter, &b,
+                       500000);
+    gnc_benchmark_run ("parse-amount/currency", bench_parse, &b, 500000);
+
+    b.info = gnc_default_print_info (TRUE);
+    gnc_benchmark_run ("print-amount/currency-symbol", bench_print, &b,
+                       500000);
+
+    b.amount = gnc_numeric_create (12345678, 10000);
+    b.info = gnc_share_print_info_places (4);
+    gnc_benchmark_run ("print-amount/shares", bench_print, &b, 500000);
+    gnc_benchmark_run ("parse-amount/shares", bench_parse, &b, 500000);
+
+    b.amount = gnc_numeric_create (1, 3);
+    b.info = gnc_default_print_info (FALSE);
+    gnc_benchmark_run ("print-amount/rounded", bench_print, &b, 500000);
+
+    qof_close ();
+    return gnc_benchmark_finish ();
+}
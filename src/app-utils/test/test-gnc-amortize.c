@@ -0,0 +1,113 @@
+/********************************************************************
+ * test-gnc-amortize.c: GLib g_test test suite for gnc-amortize.c.  *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, you can retrieve it from        *
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html            *
+ * or contact:                                                      *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ ********************************************************************/
+
+#include <config.h>
+#include <glib.h>
+#include <unittest-support.h>
+#include <qof.h>
+
+#include "../gnc-amortize.h"
+
+static const gchar *suitename = "/app-utils/gnc-amortize";
+void test_suite_gnc_amortize (void);
+
+/* 1000.00 at 1% a month over 12 months pays 88.85 a month. */
+static void
+test_amortize_payment (void)
+{
+    GncLoanTerms loan = { { 1, 100 }, 12, { 100000, 100 }, 100 };
+    gnc_numeric payment = gnc_amortize_payment (&loan);
+
+    g_assert (gnc_numeric_equal (payment, gnc_numeric_create (8885, 100)));
+
+    loan.rate = gnc_numeric_zero ();
+    payment = gnc_amortize_payment (&loan);
+    g_assert (gnc_numeric_equal (payment, gnc_numeric_create (8333, 100)));
+
+    loan.n_periods = 0;
+    payment = gnc_amortize_payment (&loan);
+    g_assert (gnc_numeric_check (payment) != GNC_ERROR_OK);
+}
+
+static void
+test_amortize_schedules (void)
+{
+    GncLoanTerms loans[] =
+    {
+        { { 1, 100 }, 12, { 100000, 100 }, 100 },
+        { { 5, 1200 }, 360, { 20000000, 100 }, 100 },
+    };
+    gsize n_rows = gnc_amortize_n_rows (loans, 2);
+    GncAmortRow *rows = g_new (GncAmortRow, n_rows);
+    guint loan, row = 0;
+
+    g_assert_cmpuint (n_rows, ==, 372);
+    g_assert (gnc_amortize_schedules (loans, 2, rows));
+
+    /* The first interest is the rate of the whole principal. */
+    g_assert (gnc_numeric_equal (rows[0].interest,
+                                 gnc_numeric_create (1000, 100)));
+    g_assert (gnc_numeric_equal (rows[0].principal,
+                                 gnc_numeric_create (7885, 100)));
+
+    /* Every loan is paid off exactly, with all payments but the last
+     * one equal. */
+    for (loan = 0; loan < 2; loan++)
+    {
+        gnc_numeric payment = gnc_amortize_payment (&loans[loan]);
+        gnc_numeric repaid = gnc_numeric_zero ();
+        gint period;
+
+        for (period = 0; period < loans[loan].n_periods; period++, row++)
+        {
+            if (period < loans[loan].n_periods - 1)
+                g_assert (gnc_numeric_equal (rows[row].payment, payment));
+            repaid = gnc_numeric_add (repaid, rows[row].principal,
+                                      GNC_DENOM_AUTO, GNC_HOW_DENOM_EXACT);
+        }
+        g_assert (gnc_numeric_zero_p (rows[row - 1].balance));
+        g_assert (gnc_numeric_equal (repaid, loans[loan].principal));
+    }
+    g_free (rows);
+}
+
+static void
+test_amortize_totals (void)
+{
+    GncLoanTerms loan = { { 1, 100 }, 12, { 100000, 100 }, 100 };
+    gint payments[] = { 1, 2, 13 };
+    gnc_numeric interest, principal;
+
+    g_assert (gnc_amortize_totals (&loan, payments, 3, &interest, &principal));
+    /* 10.00 + 9.21 of interest, 78.85 + 79.64 of principal */
+    g_assert (gnc_numeric_equal (interest, gnc_numeric_create (1921, 100)));
+    g_assert (gnc_numeric_equal (principal, gnc_numeric_create (15849, 100)));
+}
+
+void
+test_suite_gnc_amortize (void)
+{
+    GNC_TEST_ADD_FUNC (suitename, "payment", test_amortize_payment);
+    GNC_TEST_ADD_FUNC (suitename, "schedules", test_amortize_schedules);
+    GNC_TEST_ADD_FUNC (suitename, "totals", test_amortize_totals);
+}
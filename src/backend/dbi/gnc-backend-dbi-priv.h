@@ -113,6 +113,8 @@ typedef struct
     // be used to prevent infinite loops.
     gboolean retry;         // Signals the calling function that it should retry (the error handler detected
     // transient error and managed to resolve it, but it can't run the original query)
+    struct GncDbiWriteQueue* write_queue; // Writes waiting for the connection's thread, see gnc-backend-dbi.cpp
+    struct GncDbiPrefetch* prefetch; // Selects of the initial load fetched on other connections, see gnc-backend-dbi.cpp
 
 } GncDbiSqlConnection;
 /* external access required for tests */
@@ -87,6 +87,8 @@ extern "C"
 #include <gnc-backend-prov.hpp>
 #include "gnc-backend-dbi.h"
 #include "gnc-backend-dbi-priv.h"
+#include "gnc-balance-sql.h"
+#include "gnc-transaction-sql.h"
 
 #if PLATFORM(WINDOWS)
 #ifdef __STRICT_ANSI_UNSET__
@@ -224,6 +226,13 @@ static  gchar* add_columns_ddl (GncSqlConnection* conn,
 static GncSqlConnection* create_dbi_connection (provider_functions_t* provider,
                                                 QofBackend* qbe,  dbi_conn conn);
 static GncDbiTestResult conn_test_dbi_library (dbi_conn conn);
+static void gnc_dbi_write_queue_start (GncDbiSqlConnection* dbi_conn);
+static gboolean gnc_dbi_write_queue_flush (GncDbiSqlConnection* dbi_conn);
+static void gnc_dbi_write_queue_set_active (GncDbiSqlConnection* dbi_conn,
+                                            gboolean active);
+static void adjust_sql_options (dbi_conn connection);
+static dbi_result gnc_dbi_prefetch_take (GncDbiSqlConnection* dbi_conn,
+                                         const gchar* sql);
 #define GNC_DBI_PROVIDER_SQLITE (&provider_sqlite3)
 #define GNC_DBI_PROVIDER_MYSQL (&provider_mysql)
 #define GNC_DBI_PROVIDER_PGSQL (&provider_pgsql)
@@ -287,6 +296,445 @@ gnc_dbi_verify_conn (GncDbiSqlConnection* dbi_conn)
     return dbi_conn->conn_ok;
 }
 
+/* ================================================================= */
+/* Write-behind: with GNC_DBI_WRITE_BEHIND set, committing an object to
+ * a MySQL or PostgreSQL database doesn't wait for the server.  The SQL
+ * of the commit is still built at once, from the object as it is then,
+ * and is queued for a thread of the connection which sends it.
+ *
+ * Ordering: the statements are sent one at a time, in the order they
+ * were queued.  Anything else that uses the connection, a query above
+ * all, first waits for the queue to be empty, so it sees every commit
+ * made before it.  Saving, closing the book and quitting wait too.
+ *
+ * Errors: a statement which fails makes the rest of its database
+ * transaction be left out and the transaction be rolled back, so that a
+ * commit is written whole or not at all.  The failure is reported with
+ * ERR_BACKEND_SERVER_ERR by the next commit or wait for the queue; the
+ * object itself was marked clean when it was queued.
+ *
+ * Crash safety: the commits still queued when GnuCash stops without
+ * closing the book are lost, those already sent are in the database.
+ * The default, without the variable, is to wait for each commit. */
+struct GncDbiWriteQueue
+{
+    GncDbiSqlConnection* dbi_conn;
+    GThread* thread;
+    GAsyncQueue* queue;     /* gchar* SQL, or write_queue_stop */
+    GMutex conn_lock;       /* Held while the thread uses the connection */
+    GMutex lock;
+    GCond drained;
+    guint pending;          /* Statements queued and not yet sent */
+    gboolean failed;        /* A statement failed since the last report */
+    gboolean active;        /* Whether writes are queued, or sent at once */
+};
+
+static gchar write_queue_stop[] = "";
+
+static gboolean
+write_queue_send (GncDbiSqlConnection* dbi_conn, const gchar* sql)
+{
+    dbi_result result;
+
+    DEBUG ("SQL: %s\n", sql);
+    do
+    {
+        gnc_dbi_init_error (dbi_conn);
+        result = dbi_conn_query (dbi_conn->conn, sql);
+    }
+    while (dbi_conn->retry);
+    if (result == NULL)
+    {
+        PERR ("Error executing SQL %s\n", sql);
+        return FALSE;
+    }
+    if (dbi_result_free (result) < 0)
+        PERR ("Error in dbi_result_free() result\n");
+    return TRUE;
+}
+
+static gpointer
+write_queue_thread (gpointer data)
+{
+    auto wq = static_cast<GncDbiWriteQueue*> (data);
+    gboolean in_tx = FALSE;
+    gboolean tx_failed = FALSE;
+
+    for (;;)
+    {
+        auto sql = static_cast<gchar*> (g_async_queue_pop (wq->queue));
+        gboolean ends_tx;
+        gboolean is_ok = TRUE;
+
+        if (sql == write_queue_stop)
+            break;
+        ends_tx = strcmp (sql, "COMMIT") == 0 || strcmp (sql, "ROLLBACK") == 0;
+
+        g_mutex_lock (&wq->conn_lock);
+        if (strcmp (sql, "BEGIN") == 0)
+        {
+            in_tx = TRUE;
+            is_ok = gnc_dbi_verify_conn (wq->dbi_conn)
+                    && write_queue_send (wq->dbi_conn, sql);
+            tx_failed = !is_ok;
+        }
+        else if (in_tx && tx_failed)
+        {
+            /* What is left of a failed transaction isn't sent. */
+            if (ends_tx)
+                (void)write_queue_send (wq->dbi_conn, "ROLLBACK");
+        }
+        else
+        {
+            is_ok = write_queue_send (wq->dbi_conn, sql);
+            tx_failed = in_tx && !is_ok;
+        }
+        if (ends_tx)
+            in_tx = tx_failed = FALSE;
+        g_mutex_unlock (&wq->conn_lock);
+        g_free (sql);
+
+        g_mutex_lock (&wq->lock);
+        if (!is_ok)
+            wq->failed = TRUE;
+        if (--wq->pending == 0)
+            g_cond_broadcast (&wq->drained);
+        g_mutex_unlock (&wq->lock);
+    }
+    return NULL;
+}
+
+/* The queue to put a write in, or NULL if it is to be sent at once. */
+static GncDbiWriteQueue*
+write_queue_for (GncDbiSqlConnection* dbi_conn)
+{
+    auto wq = dbi_conn->write_queue;
+    return wq != NULL && wq->active ? wq : NULL;
+}
+
+static void
+write_queue_push (GncDbiWriteQueue* wq, const gchar* sql)
+{
+    g_mutex_lock (&wq->lock);
+    wq->pending++;
+    g_mutex_unlock (&wq->lock);
+    g_async_queue_push (wq->queue, g_strdup (sql));
+}
+
+/* Reports a failure of the queued writes since the last report, and
+ * returns FALSE if there was one. */
+static gboolean
+write_queue_report (GncDbiWriteQueue* wq)
+{
+    gboolean failed;
+
+    g_mutex_lock (&wq->lock);
+    failed = wq->failed;
+    wq->failed = FALSE;
+    g_mutex_unlock (&wq->lock);
+    if (failed)
+    {
+        qof_backend_set_error (wq->dbi_conn->qbe, ERR_BACKEND_SERVER_ERR);
+        gnc_sql_forget_rows ((GncSqlBackend*)wq->dbi_conn->qbe);
+    }
+    return !failed;
+}
+
+static void
+gnc_dbi_write_queue_start (GncDbiSqlConnection* dbi_conn)
+{
+    GncDbiWriteQueue* wq;
+
+    if (dbi_conn == NULL || dbi_conn->write_queue != NULL
+        || dbi_conn->provider == GNC_DBI_PROVIDER_SQLITE
+        || g_getenv ("GNC_DBI_WRITE_BEHIND") == NULL)
+        return;
+
+    wq = g_new0 (GncDbiWriteQueue, 1);
+    wq->dbi_conn = dbi_conn;
+    wq->queue = g_async_queue_new ();
+    g_mutex_init (&wq->conn_lock);
+    g_mutex_init (&wq->lock);
+    g_cond_init (&wq->drained);
+    wq->active = TRUE;
+    wq->thread = g_thread_new ("dbi-write-behind", write_queue_thread, wq);
+    dbi_conn->write_queue = wq;
+    ((GncSqlBackend*)dbi_conn->qbe)->writes_queued = TRUE;
+}
+
+/* Waits for the queued writes to be sent, and reports whether they all
+ * went right. */
+static gboolean
+gnc_dbi_write_queue_flush (GncDbiSqlConnection* dbi_conn)
+{
+    auto wq = dbi_conn != NULL ? dbi_conn->write_queue : NULL;
+
+    if (wq == NULL)
+        return TRUE;
+    g_mutex_lock (&wq->lock);
+    while (wq->pending > 0)
+        g_cond_wait (&wq->drained, &wq->lock);
+    g_mutex_unlock (&wq->lock);
+    return write_queue_report (wq);
+}
+
+/* Sends the writes of a save, whose errors are checked as it goes, at
+ * once. */
+static void
+gnc_dbi_write_queue_set_active (GncDbiSqlConnection* dbi_conn,
+                                gboolean active)
+{
+    (void)gnc_dbi_write_queue_flush (dbi_conn);
+    if (dbi_conn != NULL && dbi_conn->write_queue != NULL)
+    {
+        dbi_conn->write_queue->active = active;
+        ((GncSqlBackend*)dbi_conn->qbe)->writes_queued = active;
+    }
+}
+
+static void
+gnc_dbi_write_queue_stop (GncDbiSqlConnection* dbi_conn)
+{
+    auto wq = dbi_conn->write_queue;
+
+    if (wq == NULL)
+        return;
+    (void)gnc_dbi_write_queue_flush (dbi_conn);
+    g_async_queue_push (wq->queue, write_queue_stop);
+    g_thread_join (wq->thread);
+    g_async_queue_unref (wq->queue);
+    g_mutex_clear (&wq->conn_lock);
+    g_mutex_clear (&wq->lock);
+    g_cond_clear (&wq->drained);
+    g_free (wq);
+    dbi_conn->write_queue = NULL;
+    ((GncSqlBackend*)dbi_conn->qbe)->writes_queued = FALSE;
+}
+
+/* ================================================================= */
+/* Parallel fetch: the SELECTs of whole tables that the initial load of a
+ * MySQL or PostgreSQL database is going to run are sent together, over
+ * GNC_DBI_LOAD_CONNECTIONS connections of their own (4 by default, 0
+ * turns this off), each with a thread to wait for the server.  The load
+ * still runs its statements one at a time, in its own order, on the main
+ * thread; a statement that was fetched takes the result, waiting for it
+ * if need be, rather than asking the server.  So the objects are decoded
+ * and added to the book just as before, and only the round trips and the
+ * server's work overlap.  A select that failed on its own connection is
+ * run again on the main one, whose errors are handled as usual.
+ *
+ * The tables aren't read in one database transaction, so a change
+ * committed by another user during the load may be seen in one table
+ * and not in another, as it could be when they were read in turn. */
+typedef struct
+{
+    gchar* sql;
+    dbi_result result;
+    gboolean finished;
+} GncDbiPrefetchedSelect;
+
+struct GncDbiPrefetch
+{
+    GMutex lock;
+    GCond finished;
+    GPtrArray* selects;     /* GncDbiPrefetchedSelect*, in the given order */
+    guint next;             /* The next select for a thread to start */
+    GPtrArray* conns;       /* A dbi_conn for each thread */
+    GPtrArray* threads;
+};
+
+static const guint default_load_connections = 4;
+
+typedef struct
+{
+    struct GncDbiPrefetch* prefetch;
+    dbi_conn conn;
+    gboolean is_mysql;
+} GncDbiPrefetchWorker;
+
+static gpointer
+prefetch_thread (gpointer data)
+{
+    auto worker = static_cast<GncDbiPrefetchWorker*> (data);
+    auto prefetch = worker->prefetch;
+    gboolean connected = dbi_conn_connect (worker->conn) == 0;
+
+    if (connected && worker->is_mysql)
+        adjust_sql_options (worker->conn);
+    for (;;)
+    {
+        GncDbiPrefetchedSelect* select = NULL;
+
+        g_mutex_lock (&prefetch->lock);
+        if (prefetch->next < prefetch->selects->len)
+            select = static_cast<GncDbiPrefetchedSelect*> (
+                         g_ptr_array_index (prefetch->selects, prefetch->next++));
+        g_mutex_unlock (&prefetch->lock);
+        if (select == NULL)
+            break;
+
+        /* Not connected, the thread just marks its selects finished so
+         * that they're run on the main connection. */
+        auto result = connected ? dbi_conn_query (worker->conn, select->sql)
+                                : NULL;
+        g_mutex_lock (&prefetch->lock);
+        select->result = result;
+        select->finished = TRUE;
+        g_cond_broadcast (&prefetch->finished);
+        g_mutex_unlock (&prefetch->lock);
+    }
+    g_free (worker);
+    return NULL;
+}
+
+/* A connection to the same database with the same options, not yet
+ * connected. */
+static dbi_conn
+prefetch_new_conn (dbi_conn conn)
+{
+    const gchar* driver = dbi_driver_get_name (dbi_conn_get_driver (conn));
+    const gchar* option = NULL;
+    dbi_conn new_conn;
+
+#if HAVE_LIBDBI_R
+    if (dbi_instance == NULL)
+        return NULL;
+    new_conn = dbi_conn_new_r (driver, dbi_instance);
+#else
+    new_conn = dbi_conn_new (driver);
+#endif
+    if (new_conn == NULL)
+        return NULL;
+    while ((option = dbi_conn_get_option_list (conn, option)) != NULL)
+    {
+        const gchar* value = dbi_conn_get_option (conn, option);
+        if (value != NULL)
+            (void)dbi_conn_set_option (new_conn, option, value);
+        else
+            (void)dbi_conn_set_option_numeric (new_conn, option,
+                                               dbi_conn_get_option_numeric (conn, option));
+    }
+    return new_conn;
+}
+
+static void
+conn_begin_prefetch (GncSqlConnection* conn, const gchar** sql_list)
+{
+    GncDbiSqlConnection* dbi_conn = (GncDbiSqlConnection*)conn;
+    const gchar* connections = g_getenv ("GNC_DBI_LOAD_CONNECTIONS");
+    guint n_threads = connections ? static_cast<guint> (MAX (0, atoi (connections)))
+                                  : default_load_connections;
+    struct GncDbiPrefetch* prefetch;
+
+    g_return_if_fail (conn != NULL);
+    g_return_if_fail (sql_list != NULL);
+
+    if (dbi_conn->prefetch != NULL || n_threads == 0 ||
+        dbi_conn->provider == GNC_DBI_PROVIDER_SQLITE)
+        return;
+
+    prefetch = g_new0 (struct GncDbiPrefetch, 1);
+    g_mutex_init (&prefetch->lock);
+    g_cond_init (&prefetch->finished);
+    prefetch->selects = g_ptr_array_new ();
+    prefetch->conns = g_ptr_array_new ();
+    prefetch->threads = g_ptr_array_new ();
+    for (auto sql = sql_list; *sql != NULL; sql++)
+    {
+        auto select = g_new0 (GncDbiPrefetchedSelect, 1);
+        select->sql = g_strdup (*sql);
+        g_ptr_array_add (prefetch->selects, select);
+    }
+    n_threads = MIN (n_threads, prefetch->selects->len);
+
+    /* libdbi reads numbers in the current locale; the threads can't set
+     * their own, so the load's is set until the fetch ends. */
+    gnc_push_locale (LC_NUMERIC, "C");
+    for (guint i = 0; i < n_threads; i++)
+    {
+        auto new_conn = prefetch_new_conn (dbi_conn->conn);
+        if (new_conn == NULL)
+            break;
+
+        auto worker = g_new0 (GncDbiPrefetchWorker, 1);
+        worker->prefetch = prefetch;
+        worker->conn = new_conn;
+        worker->is_mysql = dbi_conn->provider == GNC_DBI_PROVIDER_MYSQL;
+        g_ptr_array_add (prefetch->conns, new_conn);
+        g_ptr_array_add (prefetch->threads,
+                         g_thread_new ("dbi-prefetch", prefetch_thread, worker));
+    }
+    dbi_conn->prefetch = prefetch;
+}
+
+/* The result fetched for sql, if it was and hasn't been taken yet. */
+static dbi_result
+gnc_dbi_prefetch_take (GncDbiSqlConnection* dbi_conn, const gchar* sql)
+{
+    auto prefetch = dbi_conn->prefetch;
+    dbi_result result = NULL;
+
+    if (prefetch == NULL)
+        return NULL;
+    for (guint i = 0; i < prefetch->selects->len; i++)
+    {
+        auto select = static_cast<GncDbiPrefetchedSelect*> (
+                          g_ptr_array_index (prefetch->selects, i));
+        if (strcmp (select->sql, sql) != 0)
+            continue;
+
+        g_mutex_lock (&prefetch->lock);
+        /* With no threads left to start it, it never will be. */
+        while (!select->finished && prefetch->threads->len > 0)
+            g_cond_wait (&prefetch->finished, &prefetch->lock);
+        result = select->result;
+        select->result = NULL;
+        g_mutex_unlock (&prefetch->lock);
+        break;
+    }
+    return result;
+}
+
+static void
+conn_end_prefetch (GncSqlConnection* conn)
+{
+    GncDbiSqlConnection* dbi_conn = (GncDbiSqlConnection*)conn;
+    auto prefetch = dbi_conn->prefetch;
+
+    g_return_if_fail (conn != NULL);
+
+    if (prefetch == NULL)
+        return;
+
+    /* Leave the selects that haven't been started to nobody. */
+    g_mutex_lock (&prefetch->lock);
+    prefetch->next = prefetch->selects->len;
+    g_mutex_unlock (&prefetch->lock);
+    for (guint i = 0; i < prefetch->threads->len; i++)
+        (void)g_thread_join (static_cast<GThread*> (
+                                 g_ptr_array_index (prefetch->threads, i)));
+    for (guint i = 0; i < prefetch->selects->len; i++)
+    {
+        auto select = static_cast<GncDbiPrefetchedSelect*> (
+                          g_ptr_array_index (prefetch->selects, i));
+        if (select->result != NULL)
+            (void)dbi_result_free (select->result);
+        g_free (select->sql);
+        g_free (select);
+    }
+    for (guint i = 0; i < prefetch->conns->len; i++)
+        dbi_conn_close (static_cast<dbi_conn> (
+                            g_ptr_array_index (prefetch->conns, i)));
+    gnc_pop_locale (LC_NUMERIC);
+    g_ptr_array_free (prefetch->selects, TRUE);
+    g_ptr_array_free (prefetch->conns, TRUE);
+    g_ptr_array_free (prefetch->threads, TRUE);
+    g_mutex_clear (&prefetch->lock);
+    g_cond_clear (&prefetch->finished);
+    g_free (prefetch);
+    dbi_conn->prefetch = NULL;
+}
+
 /* ================================================================= */
 
 static void
@@ -318,6 +766,59 @@ sqlite3_error_fn (dbi_conn conn, void* user_data)
     gnc_dbi_set_error(dbi_conn, ERR_BACKEND_MISC, 0, FALSE);
 }
 
+static void
+run_sqlite3_pragmas (dbi_conn conn, const char* const* pragmas)
+{
+    for (; *pragmas != NULL; pragmas++)
+    {
+        dbi_result result = dbi_conn_query (conn, *pragmas);
+        if (result)
+            dbi_result_free (result);
+        else
+            PWARN ("SQLite3 refused \"%s\"", *pragmas);
+    }
+}
+
+/* SQLite's own defaults keep a 2 MB page cache and wait for the disk
+ * twice at every commit.  With GNC_SQLITE_WAL set, the database gets a
+ * write-ahead log instead, waited for only at checkpoints.  It isn't the
+ * default because it needs the file on a local disk and leaves -wal and
+ * -shm files beside it while open. */
+static void
+set_sqlite3_pragmas (dbi_conn conn)
+{
+    static const char* const pragmas[] =
+    {
+        "PRAGMA cache_size = -32768", /* KiB */
+        NULL
+    };
+    static const char* const wal_pragmas[] =
+    {
+        "PRAGMA journal_mode = WAL",
+        "PRAGMA synchronous = NORMAL",
+        NULL
+    };
+
+    run_sqlite3_pragmas (conn, pragmas);
+    if (g_getenv ("GNC_SQLITE_WAL"))
+        run_sqlite3_pragmas (conn, wal_pragmas);
+}
+
+/* INSERT ... ON CONFLICT came with SQLite 3.24 and PostgreSQL 9.5.
+ * libdbi gives the server's version as, e.g., 32400 for 3.24.0. */
+static E_DB_UPSERT_STYLE
+on_conflict_upsert_style (dbi_conn conn, guint first_version)
+{
+    guint version = dbi_conn_get_engine_version (conn);
+
+    if (version < first_version)
+    {
+        PINFO ("Database version %u has no upsert", version);
+        return UPSERT_NONE;
+    }
+    return UPSERT_ON_CONFLICT;
+}
+
 static void
 gnc_dbi_sqlite3_session_begin (QofBackend* qbe, QofSession* session,
                                const gchar* book_id, gboolean ignore_lock,
@@ -451,6 +952,7 @@ gnc_dbi_sqlite3_session_begin (QofBackend* qbe, QofSession* session,
         msg = "Locked";
         goto exit;
     }
+    set_sqlite3_pragmas (be->conn);
 
     if (be->sql_be.conn != NULL)
     {
@@ -459,6 +961,7 @@ gnc_dbi_sqlite3_session_begin (QofBackend* qbe, QofSession* session,
     be->sql_be.conn = create_dbi_connection (GNC_DBI_PROVIDER_SQLITE, qbe,
                                              be->conn);
     be->sql_be.timespec_format = SQLITE3_TIMESPEC_STR_FORMAT;
+    be->sql_be.upsert_style = on_conflict_upsert_style (be->conn, 32400);
 
     /* We should now have a proper session set up.
      * Let's start logging */
@@ -1140,6 +1643,7 @@ gnc_dbi_mysql_session_begin (QofBackend* qbe, QofSession* session,
         }
         be->sql_be.conn = create_dbi_connection (GNC_DBI_PROVIDER_MYSQL, qbe,
                                                  be->conn);
+        be->sql_be.upsert_style = UPSERT_ON_DUPLICATE_KEY;
     }
     be->sql_be.timespec_format = MYSQL_TIMESPEC_STR_FORMAT;
 
@@ -1501,6 +2005,7 @@ gnc_dbi_postgres_session_begin (QofBackend* qbe, QofSession* session,
         }
         be->sql_be.conn = create_dbi_connection (GNC_DBI_PROVIDER_PGSQL, qbe,
                                                  be->conn);
+        be->sql_be.upsert_style = on_conflict_upsert_style (be->conn, 90500);
     }
     be->sql_be.timespec_format = PGSQL_TIMESPEC_STR_FORMAT;
 
@@ -1569,6 +2074,11 @@ gnc_dbi_session_end (QofBackend* be_start)
 
     ENTER (" ");
 
+    (void)gnc_dbi_write_queue_flush ((GncDbiSqlConnection*)be->sql_be.conn);
+    gnc_sql_balances_detach (&be->sql_be);
+    gnc_sql_split_pages_detach (&be->sql_be);
+    gnc_sql_transaction_cache_detach (&be->sql_be);
+    gnc_sql_forget_rows (&be->sql_be);
     if (be->conn != NULL)
     {
         gnc_dbi_unlock (be_start);
@@ -1619,6 +2129,7 @@ gnc_dbi_load (QofBackend* qbe,  QofBook* book, QofBackendLoadType loadType)
 
     ENTER ("be=%p, book=%p", be, book);
 
+    (void)gnc_dbi_write_queue_flush ((GncDbiSqlConnection*)be->sql_be.conn);
     if (loadType == LOAD_TYPE_INITIAL_LOAD)
     {
         g_assert (be->primary_book == NULL);
@@ -1629,6 +2140,7 @@ gnc_dbi_load (QofBackend* qbe,  QofBook* book, QofBackendLoadType loadType)
 
         // Call all object backends to create any required tables
         qof_object_foreach_backend (GNC_SQL_BACKEND, create_tables_cb, be);
+        (void)gnc_sql_update_indexes (&be->sql_be);
     }
 
     gnc_sql_load (&be->sql_be, book, loadType);
@@ -1651,6 +2163,8 @@ gnc_dbi_load (QofBackend* qbe,  QofBook* book, QofBackendLoadType loadType)
         qof_backend_set_error (qbe, ERR_SQL_DB_TOO_NEW);
     }
 
+    if (loadType == LOAD_TYPE_INITIAL_LOAD)
+        gnc_dbi_write_queue_start ((GncDbiSqlConnection*)be->sql_be.conn);
 
     LEAVE ("");
 }
@@ -1806,7 +2320,7 @@ conn_table_operation (GncSqlConnection* sql_conn, GSList* table_name_list,
  * @param book: QofBook to be saved in the database.
  */
 static void
-gnc_dbi_safe_sync_all (QofBackend* qbe, QofBook* book)
+safe_sync_all (QofBackend* qbe, QofBook* book)
 {
     GncDbiBackend* be = (GncDbiBackend*)qbe;
     GncDbiSqlConnection* conn = (GncDbiSqlConnection*) (((GncSqlBackend*)
@@ -1818,6 +2332,9 @@ gnc_dbi_safe_sync_all (QofBackend* qbe, QofBook* book)
     g_return_if_fail (book != NULL);
 
     ENTER ("book=%p, primary=%p", book, be->primary_book);
+    /* The tables are about to be replaced by what is in memory. */
+    if (book == be->primary_book && gnc_sql_load_transactions_as_needed ())
+        gnc_sql_load (&be->sql_be, book, LOAD_TYPE_LOAD_ALL);
     dbname = dbi_conn_get_option (be->conn, "dbname");
     table_list = conn->provider->get_table_list (conn->conn, dbname);
     if (!conn_table_operation ((GncSqlConnection*)conn, table_list,
@@ -1864,6 +2381,20 @@ gnc_dbi_safe_sync_all (QofBackend* qbe, QofBook* book)
     gnc_table_slist_free (table_list);
     LEAVE ("book=%p", book);
 }
+
+/* The save checks for errors as it goes, so its writes aren't queued. */
+static void
+gnc_dbi_safe_sync_all (QofBackend* qbe, QofBook* book)
+{
+    GncDbiSqlConnection* conn;
+
+    g_return_if_fail (qbe != NULL);
+
+    conn = (GncDbiSqlConnection*)((GncSqlBackend*)qbe)->conn;
+    gnc_dbi_write_queue_set_active (conn, FALSE);
+    safe_sync_all (qbe, book);
+    gnc_dbi_write_queue_set_active (conn, TRUE);
+}
 /* ================================================================= */
 static void
 gnc_dbi_begin_edit (QofBackend* qbe, QofInstance* inst)
@@ -2161,6 +2692,7 @@ typedef struct
     GncSqlRow base;
 
     dbi_result result;
+    GHashTable* field_idx;
     GList* gvalue_list;
 } GncDbiSqlRow;
 
@@ -2195,10 +2727,23 @@ row_get_value_at_col_name (GncSqlRow* row, const gchar* col_name)
     GncDbiSqlRow* dbi_row = (GncDbiSqlRow*)row;
     gushort type;
     guint attrs;
+    guint idx;
     GValue* value;
 
-    type = dbi_result_get_field_type (dbi_row->result, col_name);
-    attrs = dbi_result_get_field_attribs (dbi_row->result, col_name);
+    /* libdbi finds a field by name by comparing it with each of the
+     * result's fields, for each call.  The index is found once for all of
+     * the rows of the result, and the fields read by it. */
+    idx = GPOINTER_TO_UINT (g_hash_table_lookup (dbi_row->field_idx,
+                                                   col_name));
+    if (idx == 0)
+    {
+        idx = dbi_result_get_field_idx (dbi_row->result, col_name);
+        if (idx != 0)
+            g_hash_table_insert (dbi_row->field_idx, g_strdup (col_name),
+                                 GUINT_TO_POINTER (idx));
+    }
+    type = dbi_result_get_field_type_idx (dbi_row->result, idx);
+    attrs = dbi_result_get_field_attribs_idx (dbi_row->result, idx);
     value = g_new0 (GValue, 1);
     g_assert (value != NULL);
 
@@ -2206,19 +2751,19 @@ row_get_value_at_col_name (GncSqlRow* row, const gchar* col_name)
     {
     case DBI_TYPE_INTEGER:
         (void)g_value_init (value, G_TYPE_INT64);
-        g_value_set_int64 (value, dbi_result_get_longlong (dbi_row->result, col_name));
+        g_value_set_int64 (value, dbi_result_get_longlong_idx (dbi_row->result, idx));
         break;
     case DBI_TYPE_DECIMAL:
         gnc_push_locale (LC_NUMERIC, "C");
         if ((attrs & DBI_DECIMAL_SIZEMASK) == DBI_DECIMAL_SIZE4)
         {
             (void)g_value_init (value, G_TYPE_FLOAT);
-            g_value_set_float (value, dbi_result_get_float (dbi_row->result, col_name));
+            g_value_set_float (value, dbi_result_get_float_idx (dbi_row->result, idx));
         }
         else if ((attrs & DBI_DECIMAL_SIZEMASK) == DBI_DECIMAL_SIZE8)
         {
             (void)g_value_init (value, G_TYPE_DOUBLE);
-            g_value_set_double (value, dbi_result_get_double (dbi_row->result, col_name));
+            g_value_set_double (value, dbi_result_get_double_idx (dbi_row->result, idx));
         }
         else
         {
@@ -2228,12 +2773,14 @@ row_get_value_at_col_name (GncSqlRow* row, const gchar* col_name)
         break;
     case DBI_TYPE_STRING:
         (void)g_value_init (value, G_TYPE_STRING);
-        g_value_take_string (value, dbi_result_get_string_copy (dbi_row->result,
-                                                                col_name));
+        g_value_take_string (value,
+                             dbi_result_get_string_copy_idx (dbi_row->result,
+                                                             idx));
         break;
     case DBI_TYPE_DATETIME:
-        if (dbi_result_field_is_null (dbi_row->result, col_name))
+        if (dbi_result_field_is_null_idx (dbi_row->result, idx))
         {
+            g_free (value);
             return NULL;
         }
         else
@@ -2242,8 +2789,8 @@ row_get_value_at_col_name (GncSqlRow* row, const gchar* col_name)
 	    /* A less evil hack than the one equrie by libdbi-0.8, but
 	     * still necessary to work around the same bug.
 	     */
-	    time64 time = dbi_result_get_as_longlong(dbi_row->result,
-						     col_name);
+	    time64 time = dbi_result_get_as_longlong_idx(dbi_row->result,
+							 idx);
 #else
             /* A seriously evil hack to work around libdbi bug #15
              * https://sourceforge.net/p/libdbi/bugs/15/. When libdbi
@@ -2252,8 +2799,7 @@ row_get_value_at_col_name (GncSqlRow* row, const gchar* col_name)
              */
             dbi_result_t* result = (dbi_result_t*) (dbi_row->result);
             guint64 row = dbi_result_get_currow (result);
-            guint idx = dbi_result_get_field_idx (result, col_name) - 1;
-            time64 time = result->rows[row]->field_values[idx].d_datetime;
+            time64 time = result->rows[row]->field_values[idx - 1].d_datetime;
 #endif //HAVE_LIBDBI_TO_LONGLONG
             (void)g_value_init (value, G_TYPE_INT64);
             g_value_set_int64 (value, time);
@@ -2270,7 +2816,7 @@ row_get_value_at_col_name (GncSqlRow* row, const gchar* col_name)
 }
 
 static GncSqlRow*
-create_dbi_row (dbi_result result)
+create_dbi_row (dbi_result result, GHashTable* field_idx)
 {
     GncDbiSqlRow* row;
 
@@ -2280,6 +2826,7 @@ create_dbi_row (dbi_result result)
     row->base.getValueAtColName = row_get_value_at_col_name;
     row->base.dispose = row_dispose;
     row->result = result;
+    row->field_idx = field_idx;
 
     return (GncSqlRow*)row;
 }
@@ -2293,6 +2840,7 @@ typedef struct
     guint num_rows;
     guint cur_row;
     GncSqlRow* row;
+    GHashTable* field_idx;  /* Field name -> libdbi's index of it */
 } GncDbiSqlResult;
 
 static void
@@ -2315,6 +2863,7 @@ result_dispose (GncSqlResult* result)
             qof_backend_set_error (dbi_result->dbi_conn->qbe, ERR_BACKEND_SERVER_ERR);
         }
     }
+    g_hash_table_destroy (dbi_result->field_idx);
     g_free (result);
 }
 
@@ -2345,7 +2894,8 @@ result_get_first_row (GncSqlResult* result)
             qof_backend_set_error (dbi_result->dbi_conn->qbe, ERR_BACKEND_SERVER_ERR);
         }
         dbi_result->cur_row = 1;
-        dbi_result->row = create_dbi_row (dbi_result->result);
+        dbi_result->row = create_dbi_row (dbi_result->result,
+                                          dbi_result->field_idx);
         return dbi_result->row;
     }
     else
@@ -2373,7 +2923,8 @@ result_get_next_row (GncSqlResult* result)
             qof_backend_set_error (dbi_result->dbi_conn->qbe, ERR_BACKEND_SERVER_ERR);
         }
         dbi_result->cur_row++;
-        dbi_result->row = create_dbi_row (dbi_result->result);
+        dbi_result->row = create_dbi_row (dbi_result->result,
+                                          dbi_result->field_idx);
         return dbi_result->row;
     }
     else
@@ -2398,10 +2949,174 @@ create_dbi_result (GncDbiSqlConnection* dbi_conn,  dbi_result result)
     dbi_result->num_rows = (guint)dbi_result_get_numrows (result);
     dbi_result->cur_row = 0;
     dbi_result->dbi_conn = dbi_conn;
+    dbi_result->field_idx = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                   g_free, NULL);
 
     return (GncSqlResult*)dbi_result;
 }
 /* --------------------------------------------------------- */
+/* A result read from a server-side cursor, a batch of rows at a time.
+ * Each batch is a dbi_result of its own, holding only its rows. */
+typedef struct
+{
+    GncSqlResult base;
+
+    GncDbiSqlConnection* dbi_conn;
+    gchar* cursor;
+    guint batch_size;
+    dbi_result batch;
+    guint batch_rows;
+    guint cur_row;          /* Rows of the batch read */
+    guint total_rows;       /* Rows fetched so far */
+    gboolean at_end;        /* The last batch has been fetched */
+    GncSqlRow* row;
+    GHashTable* field_idx;  /* Field name -> libdbi's index of it */
+} GncDbiSqlCursorResult;
+
+static void
+cursor_free_batch (GncDbiSqlCursorResult* cursor_result)
+{
+    if (cursor_result->row != NULL)
+    {
+        gnc_sql_row_dispose (cursor_result->row);
+        cursor_result->row = NULL;
+    }
+    if (cursor_result->batch != NULL)
+    {
+        if (dbi_result_free (cursor_result->batch) < 0)
+        {
+            PERR ("Error in dbi_result_free() result\n");
+            qof_backend_set_error (cursor_result->dbi_conn->qbe,
+                                   ERR_BACKEND_SERVER_ERR);
+        }
+        cursor_result->batch = NULL;
+    }
+}
+
+static gboolean
+cursor_fetch (GncDbiSqlCursorResult* cursor_result)
+{
+    GncDbiSqlConnection* dbi_conn = cursor_result->dbi_conn;
+
+    cursor_free_batch (cursor_result);
+    cursor_result->batch_rows = 0;
+    cursor_result->cur_row = 0;
+    (void)gnc_dbi_write_queue_flush (dbi_conn);
+    gnc_push_locale (LC_NUMERIC, "C");
+    do
+    {
+        gnc_dbi_init_error (dbi_conn);
+        cursor_result->batch = dbi_conn_queryf (dbi_conn->conn,
+                                                "FETCH FORWARD %u FROM %s",
+                                                cursor_result->batch_size,
+                                                cursor_result->cursor);
+    }
+    while (dbi_conn->retry);
+    gnc_pop_locale (LC_NUMERIC);
+    if (cursor_result->batch == NULL)
+    {
+        PERR ("Error fetching from cursor %s\n", cursor_result->cursor);
+        qof_backend_set_error (dbi_conn->qbe, ERR_BACKEND_SERVER_ERR);
+        cursor_result->at_end = TRUE;
+        return FALSE;
+    }
+    cursor_result->batch_rows = (guint)dbi_result_get_numrows (cursor_result->batch);
+    cursor_result->total_rows += cursor_result->batch_rows;
+    if (cursor_result->batch_rows < cursor_result->batch_size)
+        cursor_result->at_end = TRUE;
+    return TRUE;
+}
+
+static void
+cursor_result_dispose (GncSqlResult* result)
+{
+    GncDbiSqlCursorResult* cursor_result = (GncDbiSqlCursorResult*)result;
+    dbi_result close_result;
+
+    cursor_free_batch (cursor_result);
+    (void)gnc_dbi_write_queue_flush (cursor_result->dbi_conn);
+    close_result = dbi_conn_queryf (cursor_result->dbi_conn->conn, "CLOSE %s",
+                                    cursor_result->cursor);
+    if (close_result == NULL || dbi_result_free (close_result) < 0)
+        PERR ("Error closing cursor %s\n", cursor_result->cursor);
+    g_hash_table_destroy (cursor_result->field_idx);
+    g_free (cursor_result->cursor);
+    g_free (result);
+}
+
+static guint
+cursor_result_get_num_rows (GncSqlResult* result)
+{
+    GncDbiSqlCursorResult* cursor_result = (GncDbiSqlCursorResult*)result;
+
+    return cursor_result->total_rows;
+}
+
+static  GncSqlRow*
+cursor_result_get_next_row (GncSqlResult* result)
+{
+    GncDbiSqlCursorResult* cursor_result = (GncDbiSqlCursorResult*)result;
+
+    if (cursor_result->row != NULL)
+    {
+        gnc_sql_row_dispose (cursor_result->row);
+        cursor_result->row = NULL;
+    }
+    if (cursor_result->cur_row == cursor_result->batch_rows)
+    {
+        if (cursor_result->at_end || !cursor_fetch (cursor_result)
+            || cursor_result->batch_rows == 0)
+            return NULL;
+    }
+    if (dbi_result_next_row (cursor_result->batch) == 0)
+    {
+        PERR ("Error in dbi_result_next_row()\n");
+        qof_backend_set_error (cursor_result->dbi_conn->qbe,
+                               ERR_BACKEND_SERVER_ERR);
+    }
+    cursor_result->cur_row++;
+    cursor_result->row = create_dbi_row (cursor_result->batch,
+                                         cursor_result->field_idx);
+    return cursor_result->row;
+}
+
+/* The cursor can only go forward, so this is only right before any row
+ * has been read. */
+static  GncSqlRow*
+cursor_result_get_first_row (GncSqlResult* result)
+{
+    GncDbiSqlCursorResult* cursor_result = (GncDbiSqlCursorResult*)result;
+
+    if (cursor_result->total_rows > 0)
+    {
+        PERR ("A cursor's rows can't be read over again\n");
+        return NULL;
+    }
+    return cursor_result_get_next_row (result);
+}
+
+static GncSqlResult*
+create_dbi_cursor_result (GncDbiSqlConnection* dbi_conn, gchar* cursor,
+                          guint batch_size)
+{
+    GncDbiSqlCursorResult* cursor_result;
+
+    cursor_result = g_new0 (GncDbiSqlCursorResult, 1);
+    g_assert (cursor_result != NULL);
+
+    cursor_result->base.dispose = cursor_result_dispose;
+    cursor_result->base.getNumRows = cursor_result_get_num_rows;
+    cursor_result->base.getFirstRow = cursor_result_get_first_row;
+    cursor_result->base.getNextRow = cursor_result_get_next_row;
+    cursor_result->dbi_conn = dbi_conn;
+    cursor_result->cursor = cursor;
+    cursor_result->batch_size = batch_size;
+    cursor_result->field_idx = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                      g_free, NULL);
+
+    return (GncSqlResult*)cursor_result;
+}
+/* --------------------------------------------------------- */
 typedef struct
 {
     GncSqlStatement base;
@@ -2466,8 +3181,10 @@ create_dbi_statement (GncSqlConnection* conn, const gchar* sql)
 static void
 conn_dispose (GncSqlConnection* conn)
 {
-    //GncDbiSqlConnection* dbi_conn = (GncDbiSqlConnection*)conn;
+    GncDbiSqlConnection* dbi_conn = (GncDbiSqlConnection*)conn;
 
+    conn_end_prefetch (conn);
+    gnc_dbi_write_queue_stop (dbi_conn);
     g_free (conn);
 }
 
@@ -2478,6 +3195,14 @@ conn_execute_select_statement (GncSqlConnection* conn, GncSqlStatement* stmt)
     GncDbiSqlStatement* dbi_stmt = (GncDbiSqlStatement*)stmt;
     dbi_result result;
 
+    qof_backend_stat_add (dbi_conn->qbe, "sql.selects", 1);
+    (void)gnc_dbi_write_queue_flush (dbi_conn);
+    result = gnc_dbi_prefetch_take (dbi_conn, dbi_stmt->sql->str);
+    if (result != NULL)
+    {
+        DEBUG ("SQL: %s (fetched)\n", dbi_stmt->sql->str);
+        return create_dbi_result (dbi_conn, result);
+    }
     DEBUG ("SQL: %s\n", dbi_stmt->sql->str);
     gnc_push_locale (LC_NUMERIC, "C");
     do
@@ -2495,6 +3220,50 @@ conn_execute_select_statement (GncSqlConnection* conn, GncSqlStatement* stmt)
     return create_dbi_result (dbi_conn, result);
 }
 
+/* PostgreSQL can hand a result out a batch of rows at a time through a
+ * cursor, declared WITH HOLD so that it doesn't need a transaction of
+ * its own.  libdbi's other drivers always read the whole result, so they
+ * get an ordinary one. */
+static GncSqlResult*
+conn_execute_select_statement_streamed (GncSqlConnection* conn,
+                                        GncSqlStatement* stmt,
+                                        guint batch_size)
+{
+    static guint cursor_count = 0;
+    GncDbiSqlConnection* dbi_conn = (GncDbiSqlConnection*)conn;
+    GncDbiSqlStatement* dbi_stmt = (GncDbiSqlStatement*)stmt;
+    dbi_result result;
+    gchar* cursor;
+
+    if (dbi_conn->provider != GNC_DBI_PROVIDER_PGSQL)
+        return conn_execute_select_statement (conn, stmt);
+
+    qof_backend_stat_add (dbi_conn->qbe, "sql.selects", 1);
+    (void)gnc_dbi_write_queue_flush (dbi_conn);
+    cursor = g_strdup_printf ("gnc_cursor_%u", ++cursor_count);
+    DEBUG ("SQL: %s (cursor %s)\n", dbi_stmt->sql->str, cursor);
+    do
+    {
+        gnc_dbi_init_error (dbi_conn);
+        result = dbi_conn_queryf (dbi_conn->conn,
+                                  "DECLARE %s NO SCROLL CURSOR WITH HOLD FOR %s",
+                                  cursor, dbi_stmt->sql->str);
+    }
+    while (dbi_conn->retry);
+    if (result == NULL)
+    {
+        PERR ("Error executing SQL %s\n", dbi_stmt->sql->str);
+        g_free (cursor);
+        return NULL;
+    }
+    if (dbi_result_free (result) < 0)
+    {
+        PERR ("Error in dbi_result_free() result\n");
+        qof_backend_set_error (dbi_conn->qbe, ERR_BACKEND_SERVER_ERR);
+    }
+    return create_dbi_cursor_result (dbi_conn, cursor, batch_size);
+}
+
 static gint
 conn_execute_nonselect_statement (GncSqlConnection* conn,
                                   GncSqlStatement* stmt)
@@ -2504,7 +3273,17 @@ conn_execute_nonselect_statement (GncSqlConnection* conn,
     dbi_result result;
     gint num_rows;
     gint status;
+    auto wq = write_queue_for (dbi_conn);
 
+    qof_backend_stat_add (dbi_conn->qbe, "sql.writes", 1);
+    if (wq != NULL)
+    {
+        /* The rows it changes aren't known yet. */
+        if (!write_queue_report (wq))
+            return -1;
+        write_queue_push (wq, dbi_stmt->sql->str);
+        return 0;
+    }
     DEBUG ("SQL: %s\n", dbi_stmt->sql->str);
     do
     {
@@ -2547,6 +3326,7 @@ conn_does_table_exist (GncSqlConnection* conn, const gchar* table_name)
     g_return_val_if_fail (conn != NULL, FALSE);
     g_return_val_if_fail (table_name != NULL, FALSE);
 
+    (void)gnc_dbi_write_queue_flush (dbi_conn);
     dbname = dbi_conn_get_option (dbi_conn->conn, "dbname");
     tables = dbi_conn_get_table_list (dbi_conn->conn, dbname, table_name);
     nTables = (gint)dbi_result_get_numrows (tables);
@@ -2567,6 +3347,37 @@ conn_does_table_exist (GncSqlConnection* conn, const gchar* table_name)
     }
 }
 
+static gboolean
+conn_does_index_exist (GncSqlConnection* conn, const gchar* index_name,
+                       const gchar* table_name)
+{
+    GncDbiSqlConnection* dbi_conn = (GncDbiSqlConnection*)conn;
+    GSList* index_list;
+    gchar* mysql_name;
+    gboolean found = FALSE;
+
+    g_return_val_if_fail (conn != NULL, FALSE);
+    g_return_val_if_fail (index_name != NULL, FALSE);
+    g_return_val_if_fail (table_name != NULL, FALSE);
+
+    (void)gnc_dbi_write_queue_flush (dbi_conn);
+    /* MySQL index names are only unique within a table, so its provider
+     * lists them as "index table". */
+    mysql_name = g_strjoin (" ", index_name, table_name, NULL);
+    index_list = dbi_conn->provider->get_index_list (dbi_conn->conn);
+    for (GSList* iter = index_list; iter != NULL && !found;
+         iter = g_slist_next (iter))
+    {
+        const gchar* name = static_cast<const gchar*> (iter->data);
+        found = g_strcmp0 (name, index_name) == 0
+                || g_strcmp0 (name, mysql_name) == 0;
+    }
+    gnc_table_slist_free (index_list);
+    g_free (mysql_name);
+
+    return found;
+}
+
 static gboolean
 conn_begin_transaction (GncSqlConnection* conn)
 {
@@ -2574,7 +3385,17 @@ conn_begin_transaction (GncSqlConnection* conn)
     dbi_result result;
     gint status;
     gboolean success = FALSE;
+    auto wq = write_queue_for (dbi_conn);
 
+    if (wq != NULL)
+    {
+        /* Don't start on a commit while an earlier one has failed
+         * unreported. */
+        if (!write_queue_report (wq))
+            return FALSE;
+        write_queue_push (wq, "BEGIN");
+        return TRUE;
+    }
     DEBUG ("BEGIN\n");
 
     if (!gnc_dbi_verify_conn (dbi_conn))
@@ -2614,7 +3435,13 @@ conn_rollback_transaction (GncSqlConnection* conn)
     dbi_result result;
     gint status;
     gboolean success = FALSE;
+    auto wq = write_queue_for (dbi_conn);
 
+    if (wq != NULL)
+    {
+        write_queue_push (wq, "ROLLBACK");
+        return TRUE;
+    }
     DEBUG ("ROLLBACK\n");
     result = dbi_conn_queryf (dbi_conn->conn, "ROLLBACK");
     success = (result != NULL);
@@ -2641,7 +3468,13 @@ conn_commit_transaction (GncSqlConnection* conn)
     dbi_result result;
     gint status;
     gboolean success = FALSE;
+    auto wq = write_queue_for (dbi_conn);
 
+    if (wq != NULL)
+    {
+        write_queue_push (wq, "COMMIT");
+        return TRUE;
+    }
     DEBUG ("COMMIT\n");
     result = dbi_conn_queryf (dbi_conn->conn, "COMMIT");
     success = (result != NULL);
@@ -3009,6 +3842,7 @@ conn_create_table (GncSqlConnection* conn, const gchar* table_name,
     {
         gint status;
 
+        (void)gnc_dbi_write_queue_flush (dbi_conn);
         DEBUG ("SQL: %s\n", ddl);
         result = dbi_conn_query (dbi_conn->conn, ddl);
         g_free (ddl);
@@ -3045,6 +3879,7 @@ conn_create_index (GncSqlConnection* conn,  const gchar* index_name,
     {
         gint status;
 
+        (void)gnc_dbi_write_queue_flush (dbi_conn);
         DEBUG ("SQL: %s\n", ddl);
         result = dbi_conn_query (dbi_conn->conn, ddl);
         g_free (ddl);
@@ -3080,6 +3915,7 @@ conn_add_columns_to_table (GncSqlConnection* conn,  const gchar* table_name,
     {
         gint status;
 
+        (void)gnc_dbi_write_queue_flush (dbi_conn);
         DEBUG ("SQL: %s\n", ddl);
         result = dbi_conn_query (dbi_conn->conn, ddl);
         g_free (ddl);
@@ -3105,8 +3941,13 @@ conn_quote_string (const GncSqlConnection* conn, gchar* unquoted_str)
     gchar* quoted_str;
     size_t size;
 
+    /* The connection's thread may be sending a write. */
+    if (dbi_conn->write_queue != NULL)
+        g_mutex_lock (&dbi_conn->write_queue->conn_lock);
     size = dbi_conn_quote_string_copy (dbi_conn->conn, unquoted_str,
                                        &quoted_str);
+    if (dbi_conn->write_queue != NULL)
+        g_mutex_unlock (&dbi_conn->write_queue->conn_lock);
     if (size != 0)
     {
         return quoted_str;
@@ -3298,9 +4139,12 @@ create_dbi_connection (provider_functions_t* provider,
 
     dbi_conn->base.dispose = conn_dispose;
     dbi_conn->base.executeSelectStatement = conn_execute_select_statement;
+    dbi_conn->base.executeSelectStatementStreamed =
+        conn_execute_select_statement_streamed;
     dbi_conn->base.executeNonSelectStatement = conn_execute_nonselect_statement;
     dbi_conn->base.createStatementFromSql = conn_create_statement_from_sql;
     dbi_conn->base.doesTableExist = conn_does_table_exist;
+    dbi_conn->base.doesIndexExist = conn_does_index_exist;
     dbi_conn->base.beginTransaction = conn_begin_transaction;
     dbi_conn->base.rollbackTransaction = conn_rollback_transaction;
     dbi_conn->base.commitTransaction = conn_commit_transaction;
@@ -3308,6 +4152,8 @@ create_dbi_connection (provider_functions_t* provider,
     dbi_conn->base.createIndex = conn_create_index;
     dbi_conn->base.addColumnsToTable = conn_add_columns_to_table;
     dbi_conn->base.quoteString = conn_quote_string;
+    dbi_conn->base.beginPrefetch = conn_begin_prefetch;
+    dbi_conn->base.endPrefetch = conn_end_prefetch;
     dbi_conn->qbe = qbe;
     dbi_conn->conn = conn;
     dbi_conn->provider = provider;
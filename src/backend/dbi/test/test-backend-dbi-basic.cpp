@@ -46,6 +46,8 @@ extern "C"
 #include <TransLog.h>
 #include "Transaction.h"
 #include "Split.h"
+#include "Query.h"
+#include "Scrub.h"
 #include "gnc-commodity.h"
 #include "gncAddress.h"
 #include "gncCustomer.h"
@@ -423,6 +425,245 @@ test_dbi_store_and_reload (Fixture* fixture, gconstpointer pData)
     qof_session_destroy (session_3);
 }
 
+static void
+compare_account_balances (Account* acct_1, gpointer data)
+{
+    auto book_2 = static_cast<QofBook*> (data);
+    auto acct_2 = xaccAccountLookup (qof_instance_get_guid (acct_1), book_2);
+
+    g_assert (acct_2 != NULL);
+    g_assert (gnc_numeric_equal (xaccAccountGetBalance (acct_1),
+                                 xaccAccountGetBalance (acct_2)));
+    g_assert (gnc_numeric_equal (xaccAccountGetClearedBalance (acct_1),
+                                 xaccAccountGetClearedBalance (acct_2)));
+    g_assert (gnc_numeric_equal (xaccAccountGetReconciledBalance (acct_1),
+                                 xaccAccountGetReconciledBalance (acct_2)));
+}
+
+/* Save a book, open it again loading its transactions as needed, and
+ * check that the accounts' balances are right before and after a query
+ * for the splits of one of them, and that the whole book is there once
+ * all of it is loaded. */
+static void
+test_dbi_load_as_needed (Fixture* fixture, gconstpointer pData)
+{
+    const gchar* url = (const gchar*)pData;
+    QofSession* session_2;
+    QofSession* session_3;
+
+    auto msg = "[gnc_dbi_unlock()] There was no lock entry in the Lock table";
+    auto log_domain = "gnc.backend.dbi";
+    auto loglevel = static_cast<GLogLevelFlags> (G_LOG_LEVEL_WARNING |
+                                                 G_LOG_FLAG_FATAL);
+    TestErrorStruct* check = test_error_struct_new (log_domain, loglevel, msg);
+    fixture->hdlrs = test_log_set_fatal_handler (fixture->hdlrs, check,
+                                                 (GLogFunc)test_checked_handler);
+    if (fixture->filename)
+        url = fixture->filename;
+
+    session_2 = qof_session_new ();
+    qof_session_begin (session_2, url, FALSE, TRUE, TRUE);
+    g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+    qof_session_swap_data (fixture->session, session_2);
+    qof_session_save (session_2, NULL);
+    g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+    auto book_2 = qof_session_get_book (session_2);
+    auto root_2 = gnc_book_get_root_account (book_2);
+
+    g_setenv ("GNC_SQL_LOAD_AS_NEEDED", "1", TRUE);
+    session_3 = qof_session_new ();
+    qof_session_begin (session_3, url, TRUE, FALSE, FALSE);
+    g_assert_cmpint (qof_session_get_error (session_3), == , ERR_BACKEND_NO_ERR);
+    qof_session_load (session_3, NULL);
+    g_assert_cmpint (qof_session_get_error (session_3), == , ERR_BACKEND_NO_ERR);
+    auto book_3 = qof_session_get_book (session_3);
+    gnc_account_foreach_descendant (root_2, (AccountCb)compare_account_balances,
+                                    book_3);
+
+    auto accounts = gnc_account_get_descendants (root_2);
+    for (auto node = accounts; node != NULL; node = node->next)
+    {
+        auto acct_2 = GNC_ACCOUNT (node->data);
+        if (xaccAccountGetSplitList (acct_2) == NULL)
+            continue;
+        auto acct_3 = xaccAccountLookup (qof_instance_get_guid (acct_2), book_3);
+        auto query = qof_query_create_for (GNC_ID_SPLIT);
+        qof_query_set_book (query, book_3);
+        xaccQueryAddSingleAccountMatch (query, acct_3, QOF_QUERY_AND);
+        qof_query_run (query);
+        qof_query_destroy (query);
+        g_assert_cmpint (g_list_length (xaccAccountGetSplitList (acct_3)), == ,
+                         g_list_length (xaccAccountGetSplitList (acct_2)));
+        break;
+    }
+    g_list_free (accounts);
+    gnc_account_foreach_descendant (root_2, (AccountCb)compare_account_balances,
+                                    book_3);
+
+    qof_session_ensure_all_data_loaded (session_3);
+    gnc_account_foreach_descendant (root_2, (AccountCb)compare_account_balances,
+                                    book_3);
+    compare_books (book_2, book_3);
+    g_unsetenv ("GNC_SQL_LOAD_AS_NEEDED");
+    qof_session_end (session_2);
+    qof_session_destroy (session_2);
+    qof_session_end (session_3);
+    qof_session_destroy (session_3);
+}
+
+static void
+compare_balances_as_of (Account* acct_1, gpointer data)
+{
+    auto book_2 = static_cast<QofBook*> (data);
+    auto acct_2 = xaccAccountLookup (qof_instance_get_guid (acct_1), book_2);
+
+    g_assert (acct_2 != NULL);
+    for (auto node = xaccAccountGetSplitList (acct_1); node != NULL;
+         node = node->next)
+    {
+        auto date = xaccTransGetDate (xaccSplitGetParent (GNC_SPLIT (node->data)));
+        g_assert (gnc_numeric_equal (xaccAccountGetBalanceAsOfDate (acct_1, date),
+                                     xaccAccountGetBalanceAsOfDate (acct_2, date)));
+        g_assert (gnc_numeric_equal (
+                      xaccAccountGetBalanceAsOfDate (acct_1, date + 1),
+                      xaccAccountGetBalanceAsOfDate (acct_2, date + 1)));
+    }
+}
+
+/* Save a book, open it again loading its transactions as needed, rebuild
+ * its balances table and check the accounts' balances as of the dates of
+ * their splits, and that changing a split keeps the table right. */
+static void
+test_dbi_balances_table (Fixture* fixture, gconstpointer pData)
+{
+    const gchar* url = (const gchar*)pData;
+    QofSession* session_2;
+    QofSession* session_3;
+
+    auto msg = "[gnc_dbi_unlock()] There was no lock entry in the Lock table";
+    auto log_domain = "gnc.backend.dbi";
+    auto loglevel = static_cast<GLogLevelFlags> (G_LOG_LEVEL_WARNING |
+                                                 G_LOG_FLAG_FATAL);
+    TestErrorStruct* check = test_error_struct_new (log_domain, loglevel, msg);
+    fixture->hdlrs = test_log_set_fatal_handler (fixture->hdlrs, check,
+                                                 (GLogFunc)test_checked_handler);
+    if (fixture->filename)
+        url = fixture->filename;
+
+    session_2 = qof_session_new ();
+    qof_session_begin (session_2, url, FALSE, TRUE, TRUE);
+    g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+    qof_session_swap_data (fixture->session, session_2);
+    qof_session_save (session_2, NULL);
+    g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+    auto book_2 = qof_session_get_book (session_2);
+    auto root_2 = gnc_book_get_root_account (book_2);
+
+    g_setenv ("GNC_SQL_LOAD_AS_NEEDED", "1", TRUE);
+    session_3 = qof_session_new ();
+    qof_session_begin (session_3, url, TRUE, FALSE, FALSE);
+    g_assert_cmpint (qof_session_get_error (session_3), == , ERR_BACKEND_NO_ERR);
+    qof_session_load (session_3, NULL);
+    g_assert_cmpint (qof_session_get_error (session_3), == , ERR_BACKEND_NO_ERR);
+    auto book_3 = qof_session_get_book (session_3);
+    xaccBookScrubBalances (book_3);
+    g_assert_cmpint (qof_session_get_error (session_3), == , ERR_BACKEND_NO_ERR);
+    gnc_account_foreach_descendant (root_2, (AccountCb)compare_balances_as_of,
+                                    book_3);
+
+    auto accounts = gnc_account_get_descendants (root_2);
+    for (auto node = accounts; node != NULL; node = node->next)
+    {
+        auto acct_2 = GNC_ACCOUNT (node->data);
+        if (xaccAccountGetSplitList (acct_2) == NULL)
+            continue;
+        auto acct_3 = xaccAccountLookup (qof_instance_get_guid (acct_2), book_3);
+        auto query = qof_query_create_for (GNC_ID_SPLIT);
+        qof_query_set_book (query, book_3);
+        xaccQueryAddSingleAccountMatch (query, acct_3, QOF_QUERY_AND);
+        qof_query_run (query);
+        qof_query_destroy (query);
+
+        auto split = GNC_SPLIT (xaccAccountGetSplitList (acct_3)->data);
+        auto trans = xaccSplitGetParent (split);
+        xaccTransBeginEdit (trans);
+        xaccSplitSetAmount (split, gnc_numeric_add (xaccSplitGetAmount (split),
+                                                    gnc_numeric_create (1, 1),
+                                                    GNC_DENOM_AUTO,
+                                                    GNC_HOW_DENOM_LCD));
+        xaccTransCommitEdit (trans);
+        g_assert_cmpint (qof_session_get_error (session_3), == ,
+                         ERR_BACKEND_NO_ERR);
+        g_assert (gnc_numeric_equal (
+                      xaccAccountGetBalanceAsOfDate (acct_3, G_MAXINT32),
+                      xaccAccountGetBalance (acct_3)));
+        break;
+    }
+    g_list_free (accounts);
+
+    g_unsetenv ("GNC_SQL_LOAD_AS_NEEDED");
+    qof_session_end (session_2);
+    qof_session_destroy (session_2);
+    qof_session_end (session_3);
+    qof_session_destroy (session_3);
+}
+
+/* Save a book, change, add and remove slots of one of its accounts,
+ * some of them in a frame, and check that reloading it gives the book
+ * back. */
+static void
+test_dbi_edit_slots (Fixture* fixture, gconstpointer pData)
+{
+    const gchar* url = (const gchar*)pData;
+    QofSession* session_2;
+    QofSession* session_3;
+
+    auto msg = "[gnc_dbi_unlock()] There was no lock entry in the Lock table";
+    auto log_domain = "gnc.backend.dbi";
+    auto loglevel = static_cast<GLogLevelFlags> (G_LOG_LEVEL_WARNING |
+                                                 G_LOG_FLAG_FATAL);
+    TestErrorStruct* check = test_error_struct_new (log_domain, loglevel, msg);
+    fixture->hdlrs = test_log_set_fatal_handler (fixture->hdlrs, check,
+                                                 (GLogFunc)test_checked_handler);
+    if (fixture->filename)
+        url = fixture->filename;
+
+    session_2 = qof_session_new ();
+    qof_session_begin (session_2, url, FALSE, TRUE, TRUE);
+    g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+    qof_session_swap_data (fixture->session, session_2);
+    auto root = gnc_book_get_root_account (qof_session_get_book (session_2));
+    auto acct = gnc_account_lookup_by_name (root, "Bank 1");
+    g_assert (acct != NULL);
+    auto frame = qof_instance_get_slots (QOF_INSTANCE (acct));
+    delete frame->set_path ({"frame", "kept"}, new KvpValue ("kept"));
+    delete frame->set_path ({"frame", "changed"}, new KvpValue (INT64_C (1)));
+    qof_session_save (session_2, NULL);
+    g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+
+    xaccAccountBeginEdit (acct);
+    delete frame->set ("int64-val", new KvpValue (INT64_C (200)));
+    delete frame->set ("double-val", nullptr);
+    delete frame->set ("new-val", new KvpValue ("new"));
+    delete frame->set_path ({"frame", "changed"}, new KvpValue (INT64_C (2)));
+    delete frame->set_path ({"frame", "added"}, new KvpValue (3.5));
+    qof_instance_set_dirty (QOF_INSTANCE (acct));
+    xaccAccountCommitEdit (acct);
+    g_assert_cmpint (qof_session_get_error (session_2), == , ERR_BACKEND_NO_ERR);
+
+    session_3 = qof_session_new ();
+    qof_session_begin (session_3, url, TRUE, FALSE, FALSE);
+    g_assert_cmpint (qof_session_get_error (session_3), == , ERR_BACKEND_NO_ERR);
+    qof_session_load (session_3, NULL);
+    g_assert_cmpint (qof_session_get_error (session_3), == , ERR_BACKEND_NO_ERR);
+    compare_books (qof_session_get_book (session_2),
+                   qof_session_get_book (session_3));
+    qof_session_end (session_2);
+    qof_session_destroy (session_2);
+    qof_session_end (session_3);
+    qof_session_destroy (session_3);
+}
+
 /** Test the safe_save mechanism.  Beware that this test used on its
  * own doesn't ensure that the resave is done safely, only that the
  * database is intact and unchanged after the save. To observe the
@@ -651,6 +892,12 @@ create_dbi_test_suite (const char* dbm_name, const char* url)
                   test_dbi_store_and_reload, teardown);
     GNC_TEST_ADD (subsuite, "safe_save", Fixture, url, setup_memory,
                   test_dbi_safe_save, teardown);
+    GNC_TEST_ADD (subsuite, "edit_slots", Fixture, url, setup_memory,
+                  test_dbi_edit_slots, teardown);
+    GNC_TEST_ADD (subsuite, "load_as_needed", Fixture, url, setup,
+                  test_dbi_load_as_needed, teardown);
+    GNC_TEST_ADD (subsuite, "balances_table", Fixture, url, setup,
+                  test_dbi_balances_table, teardown);
     GNC_TEST_ADD (subsuite, "version_control", Fixture, url, setup_memory,
                   test_dbi_version_control, teardown);
     GNC_TEST_ADD (subsuite, "business_store_and_reload", Fixture, url,
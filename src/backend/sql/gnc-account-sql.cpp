@@ -201,7 +201,7 @@ load_all_accounts (GncSqlBackend* be)
     GncSqlResult* result;
     QofBook* pBook;
     GList* l_accounts_needing_parents = NULL;
-    GSList* bal_slist;
+    GSList* bal_slist = NULL;
     GSList* bal;
 
     g_return_if_fail (be != NULL);
@@ -290,8 +290,10 @@ load_all_accounts (GncSqlBackend* be)
             }
         }
 
-        /* Load starting balances */
-        bal_slist = gnc_sql_get_account_balances_slist (be);
+        /* Until their transactions are loaded, the accounts start with the
+         * balances of their splits in the database. */
+        if (gnc_sql_load_transactions_as_needed ())
+            bal_slist = gnc_sql_get_account_balances_slist (be);
         for (bal = bal_slist; bal != NULL; bal = bal->next)
         {
             acct_balances_t* balances = (acct_balances_t*)bal->data;
@@ -305,10 +307,7 @@ load_all_accounts (GncSqlBackend* be)
 
             qof_instance_decrease_editlevel (balances->acct);
         }
-        if (bal_slist != NULL)
-        {
-            g_slist_free (bal_slist);
-        }
+        g_slist_free_full (bal_slist, g_free);
     }
 
     LEAVE ("");
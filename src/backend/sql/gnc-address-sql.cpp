@@ -104,15 +104,7 @@ load_address (const GncSqlBackend* be, GncSqlRow* row,
         }
         else
         {
-            if (subtable->qof_param_name != NULL)
-            {
-                setter = qof_class_get_parameter_setter (GNC_ID_ADDRESS,
-                                                         subtable->qof_param_name);
-            }
-            else
-            {
-                setter = subtable->setter;
-            }
+            setter = gnc_sql_get_setter (GNC_ID_ADDRESS, subtable);
             (*setter) (addr, (const gpointer)s);
         }
     }
@@ -58,6 +58,7 @@ extern "C"
 #include "gnc-backend-sql.h"
 
 #include "gnc-account-sql.h"
+#include "gnc-balance-sql.h"
 #include "gnc-book-sql.h"
 #include "gnc-budget-sql.h"
 #include "gnc-commodity-sql.h"
@@ -80,23 +81,38 @@ extern "C"
 #include "gnc-tax-table-sql.h"
 #include "gnc-vendor-sql.h"
 
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
 static void gnc_sql_init_object_handlers (void);
 static void update_progress (GncSqlBackend* be);
 static void finish_progress (GncSqlBackend* be);
 static void register_standard_col_type_handlers (void);
 static gboolean reset_version_info (GncSqlBackend* be);
+typedef std::vector<std::string> RowValues;
 static GncSqlStatement* build_insert_statement (GncSqlBackend* be,
                                                 const gchar* table_name,
-                                                QofIdTypeConst obj_name, gpointer pObject,
-                                                const GncSqlColumnTableEntry* table);
+                                                const GncSqlColumnTableEntry* table,
+                                                const RowValues& row);
 static GncSqlStatement* build_update_statement (GncSqlBackend* be,
                                                 const gchar* table_name,
-                                                QofIdTypeConst obj_name, gpointer pObject,
-                                                const GncSqlColumnTableEntry* table);
+                                                const GncSqlColumnTableEntry* table,
+                                                const RowValues& row,
+                                                const RowValues* stored);
+static GncSqlStatement* build_upsert_statement (GncSqlBackend* be,
+                                                const gchar* table_name,
+                                                const GncSqlColumnTableEntry* table,
+                                                const RowValues& row);
 static GncSqlStatement* build_delete_statement (GncSqlBackend* be,
                                                 const gchar* table_name,
                                                 QofIdTypeConst obj_name, gpointer pObject,
                                                 const GncSqlColumnTableEntry* table);
+static gboolean batch_insert (GncSqlBackend* be, const gchar* table_name,
+                              QofIdTypeConst obj_name, gpointer pObject,
+                              const GncSqlColumnTableEntry* table);
+static gboolean flush_insert_batches (GncSqlBackend* be);
 
 static GList* post_load_commodities = NULL;
 
@@ -166,12 +182,42 @@ static const gchar* fixed_load_order[] =
 /* Load order for objects from other modules */
 static const gchar** other_load_order = NULL;
 
+/* The tables the initial load reads whole, with the SQL that
+ * gnc_sql_create_select_statement() gives, so that the connection can
+ * fetch them together.  The slots and transactions are streamed
+ * instead, so as not to hold them in memory all at once. */
+static const gchar* prefetch_tables[] =
+{
+    "books", "commodities", "accounts", "lots", "prices", "budgets",
+    "schedxactions", "billterms", "customers", "employees", "entries",
+    "invoices", "jobs", "orders", "taxtables", "vendors", NULL
+};
+
 void
 gnc_sql_set_load_order (const gchar** load_order)
 {
     other_load_order = load_order;
 }
 
+/* Loads the objects of one type, timing them and counting the ones
+ * with a collection of their own. */
+static void
+load_object_type (GncSqlBackend* be, const gchar* type,
+                  GncSqlObjectBackend* pData)
+{
+    {
+        QofBackendPhase phase {&be->be, "sql", type};
+        (pData->initial_load) (be);
+    }
+    if (qof_object_lookup (type) != NULL)
+    {
+        QofCollection* col = qof_book_get_collection (be->book, type);
+        gchar* name = g_strconcat ("sql.", type, NULL);
+        qof_backend_stat_add (&be->be, name, qof_collection_count (col));
+        g_free (name);
+    }
+}
+
 static void
 initial_load_cb (const gchar* type, gpointer data_p, gpointer be_p)
 {
@@ -199,7 +245,7 @@ initial_load_cb (const gchar* type, gpointer data_p, gpointer be_p)
 
     if (pData->initial_load != NULL)
     {
-        (pData->initial_load) (be);
+        load_object_type (be, type, pData);
     }
 }
 
@@ -230,12 +276,23 @@ gnc_sql_load (GncSqlBackend* be,  QofBook* book, QofBackendLoadType loadType)
     ENTER ("be=%p, book=%p", be, book);
 
     be->loading = TRUE;
+    gnc_sql_slots_begin_bulk_load (be);
 
     if (loadType == LOAD_TYPE_INITIAL_LOAD)
     {
+        std::vector<std::string> selects;
+        std::vector<const gchar*> sql_list;
+
         g_assert (be->book == NULL);
         be->book = book;
 
+        for (i = 0; prefetch_tables[i] != NULL; i++)
+            selects.push_back (std::string {"SELECT * FROM "} + prefetch_tables[i]);
+        for (auto& sql : selects)
+            sql_list.push_back (sql.c_str ());
+        sql_list.push_back (NULL);
+        gnc_sql_connection_begin_prefetch (be->conn, sql_list.data ());
+
         /* Load any initial stuff. Some of this needs to happen in a certain order */
         for (i = 0; fixed_load_order[i] != NULL; i++)
         {
@@ -245,7 +302,7 @@ gnc_sql_load (GncSqlBackend* be,  QofBook* book, QofBackendLoadType loadType)
             if (pData->initial_load != NULL)
             {
                 update_progress (be);
-                (pData->initial_load) (be);
+                load_object_type (be, fixed_load_order[i], pData);
             }
         }
         if (other_load_order != NULL)
@@ -259,7 +316,7 @@ gnc_sql_load (GncSqlBackend* be,  QofBook* book, QofBackendLoadType loadType)
                 if (pData->initial_load != NULL)
                 {
                     update_progress (be);
-                    (pData->initial_load) (be);
+                    load_object_type (be, other_load_order[i], pData);
                 }
             }
         }
@@ -268,15 +325,29 @@ gnc_sql_load (GncSqlBackend* be,  QofBook* book, QofBackendLoadType loadType)
         gnc_account_foreach_descendant (root, (AccountCb)xaccAccountBeginEdit, NULL);
 
         qof_object_foreach_backend (GNC_SQL_BACKEND, initial_load_cb, be);
+        gnc_sql_connection_end_prefetch (be->conn);
 
+        QofBackendPhase phase {&be->be, "sql", "commit-accounts"};
         gnc_account_foreach_descendant (root, (AccountCb)xaccAccountCommitEdit, NULL);
+
+        if (gnc_sql_load_transactions_as_needed ())
+        {
+            gnc_sql_balances_attach (be);
+            gnc_sql_split_pages_attach (be);
+            gnc_sql_transaction_cache_attach (be);
+        }
     }
     else if (loadType == LOAD_TYPE_LOAD_ALL)
     {
         // Load all transactions
+        QofBackendPhase phase {&be->be, "sql", "load-all"};
         gnc_sql_transaction_load_all_tx (be);
+        gnc_sql_balances_detach (be);
+        gnc_sql_split_pages_detach (be);
+        gnc_sql_transaction_cache_detach (be);
     }
 
+    gnc_sql_slots_end_bulk_load (be);
     be->loading = FALSE;
     g_list_free_full (post_load_commodities, commit_commodity);
     post_load_commodities = NULL;
@@ -443,6 +514,37 @@ finish_progress (GncSqlBackend* be)
         (be->be.percentage) (NULL, -1.0);
 }
 
+/* While gnc_sql_sync_all writes a whole book into empty tables, the rows
+ * of each table are gathered into INSERTs of many rows; anything else
+ * sent to the database sends them first. GNC_SQL_INSERT_BATCH sets the
+ * rows in an INSERT, 1 sending each on its own. */
+struct InsertBatch
+{
+    std::string sql;
+    guint rows;
+};
+struct SyncBatches
+{
+    GncSqlBackend* be;
+    guint max_rows;
+    gboolean failed;
+    std::unordered_map<std::string, InsertBatch> tables;
+};
+static SyncBatches* sync_batches = NULL;
+
+static const guint default_insert_batch_rows = 500;
+/* SQLite takes statements of up to a million bytes. */
+static const gsize max_insert_batch_bytes = 512 * 1024;
+
+static guint
+insert_batch_rows (void)
+{
+    const char* rows = g_getenv ("GNC_SQL_INSERT_BATCH");
+    if (!rows)
+        return default_insert_batch_rows;
+    return static_cast<guint> (MAX (1, atoi (rows)));
+}
+
 void
 gnc_sql_sync_all (GncSqlBackend* be,  QofBook* book)
 {
@@ -454,10 +556,12 @@ gnc_sql_sync_all (GncSqlBackend* be,  QofBook* book)
     ENTER ("book=%p, be->book=%p", book, be->book);
     update_progress (be);
     (void)reset_version_info (be);
+    gnc_sql_forget_rows (be);
 
     /* Create new tables */
     be->is_pristine_db = TRUE;
     qof_object_foreach_backend (GNC_SQL_BACKEND, create_tables_cb, be);
+    (void)gnc_sql_update_indexes (be);
 
     /* Save all contents */
     be->book = book;
@@ -467,6 +571,10 @@ gnc_sql_sync_all (GncSqlBackend* be,  QofBook* book)
     be->obj_total += gnc_book_count_transactions (book);
     be->operations_done = 0;
 
+    SyncBatches batches {be, insert_batch_rows (), FALSE, {}};
+    if (batches.max_rows > 1)
+        sync_batches = &batches;
+
     is_ok = gnc_sql_connection_begin_transaction (be->conn);
 
     // FIXME: should write the set of commodities that are used
@@ -496,6 +604,11 @@ gnc_sql_sync_all (GncSqlBackend* be,  QofBook* book)
         qof_object_foreach_backend (GNC_SQL_BACKEND, write_cb, be);
     }
     if (is_ok)
+    {
+        is_ok = flush_insert_batches (be) && !batches.failed;
+    }
+    sync_batches = NULL;
+    if (is_ok)
     {
         is_ok = gnc_sql_connection_commit_transaction (be->conn);
     }
@@ -513,6 +626,7 @@ gnc_sql_sync_all (GncSqlBackend* be,  QofBook* book)
         if (!qof_backend_check_error ((QofBackend*)be))
             qof_backend_set_error ((QofBackend*)be, ERR_BACKEND_SERVER_ERR);
         is_ok = gnc_sql_connection_rollback_transaction (be->conn);
+        gnc_sql_forget_rows (be);
     }
     finish_progress (be);
     LEAVE ("book=%p", book);
@@ -524,10 +638,23 @@ gnc_sql_sync_all (GncSqlBackend* be,  QofBook* book)
 void
 gnc_sql_begin_edit (GncSqlBackend* be, QofInstance* inst)
 {
+    GncSqlObjectBackend* pData;
+
     g_return_if_fail (be != NULL);
     g_return_if_fail (inst != NULL);
 
     ENTER (" ");
+    /* An object that is new or already changed doesn't match its rows. */
+    if (be->loading || be->conn == NULL || qof_instance_get_infant (inst) ||
+        qof_instance_get_dirty_flag (inst))
+    {
+        LEAVE ("");
+        return;
+    }
+    pData = static_cast<decltype (pData)> (
+                qof_object_lookup_backend (inst->e_type, GNC_SQL_BACKEND));
+    if (pData != NULL && pData->begin_edit != NULL)
+        (pData->begin_edit) (be, inst);
     LEAVE ("");
 }
 
@@ -571,6 +698,7 @@ gnc_sql_commit_edit (GncSqlBackend* be, QofInstance* inst)
     gboolean is_dirty;
     gboolean is_destroying;
     gboolean is_infant;
+    gpointer handler;
 
     g_return_if_fail (be != NULL);
     g_return_if_fail (inst != NULL);
@@ -616,6 +744,7 @@ gnc_sql_commit_edit (GncSqlBackend* be, QofInstance* inst)
     if (!gnc_sql_connection_begin_transaction (be->conn))
     {
         PERR ("gnc_sql_commit_edit(): begin_transaction failed\n");
+        gnc_sql_forget_rows (be);
         LEAVE ("Rolled back - database transaction begin error");
         return;
     }
@@ -625,7 +754,13 @@ gnc_sql_commit_edit (GncSqlBackend* be, QofInstance* inst)
     be_data.inst = inst;
     be_data.is_ok = TRUE;
 
-    qof_object_foreach_backend (GNC_SQL_BACKEND, commit_cb, &be_data);
+    /* The handler for a type is nearly always registered under the type's
+     * name; only walk all of them when it isn't. */
+    handler = qof_object_lookup_backend (inst->e_type, GNC_SQL_BACKEND);
+    if (handler)
+        commit_cb (inst->e_type, handler, &be_data);
+    if (!be_data.is_known)
+        qof_object_foreach_backend (GNC_SQL_BACKEND, commit_cb, &be_data);
 
     if (!be_data.is_known)
     {
@@ -642,6 +777,7 @@ gnc_sql_commit_edit (GncSqlBackend* be, QofInstance* inst)
     {
         // Error - roll it back
         (void)gnc_sql_connection_rollback_transaction (be->conn);
+        gnc_sql_forget_rows (be);
 
         // This *should* leave things marked dirty
         LEAVE ("Rolled back - database error");
@@ -957,17 +1093,11 @@ gnc_sql_free_query (QofBackend* pBEnd, gpointer pQuery)
     // Try various objects first
     be_data.is_ok = FALSE;
     be_data.be = be;
-    be_data.pCompiledQuery = pQuery;
+    be_data.pCompiledQuery = pQueryInfo->pCompiledQuery;
     be_data.pQueryInfo = pQueryInfo;
 
     qof_object_foreach_backend (GNC_SQL_BACKEND, free_query_cb, &be_data);
-    if (be_data.is_ok)
-    {
-        LEAVE ("");
-        return;
-    }
-
-    if (pQueryInfo->pCompiledQuery != NULL)
+    if (!be_data.is_ok && pQueryInfo->pCompiledQuery != NULL)
     {
         DEBUG ("%s\n", (gchar*)pQueryInfo->pCompiledQuery);
         g_free (pQueryInfo->pCompiledQuery);
@@ -1137,6 +1267,33 @@ set_autoinc_id (void* object, void* item)
     // Nowhere to put the ID
 }
 
+/* The QOF parameter named by a column, looked up the first time the
+ * column is used so that loading and saving rows doesn't look it up by
+ * name for each of them. The column tables are static, so they can be
+ * keyed by address. */
+struct ColumnParam
+{
+    std::string obj_name;
+    const QofParam* param;
+};
+static std::unordered_map<const GncSqlColumnTableEntry*, ColumnParam>
+    column_params;
+
+static const QofParam*
+get_column_param (QofIdTypeConst obj_name,
+                  const GncSqlColumnTableEntry* table_row)
+{
+    auto& column = column_params[table_row];
+    /* A few tables are shared between object types. */
+    if (column.param == NULL || column.obj_name != obj_name)
+    {
+        column.obj_name = obj_name;
+        column.param = qof_class_get_parameter (obj_name,
+                                                table_row->qof_param_name);
+    }
+    return column.param;
+}
+
 QofAccessFunc
 gnc_sql_get_getter (QofIdTypeConst obj_name,
                     const GncSqlColumnTableEntry* table_row)
@@ -1152,8 +1309,8 @@ gnc_sql_get_getter (QofIdTypeConst obj_name,
     }
     else if (table_row->qof_param_name != NULL)
     {
-        getter = qof_class_get_parameter_getter (obj_name,
-                                                 table_row->qof_param_name);
+        auto param = get_column_param (obj_name, table_row);
+        getter = param ? param->param_getfcn : NULL;
     }
     else
     {
@@ -1163,6 +1320,32 @@ gnc_sql_get_getter (QofIdTypeConst obj_name,
     return getter;
 }
 
+QofSetterFunc
+gnc_sql_get_setter (QofIdTypeConst obj_name,
+                    const GncSqlColumnTableEntry* table_row)
+{
+    QofSetterFunc setter;
+
+    g_return_val_if_fail (obj_name != NULL, NULL);
+    g_return_val_if_fail (table_row != NULL, NULL);
+
+    if ((table_row->flags & COL_AUTOINC) != 0)
+    {
+        setter = set_autoinc_id;
+    }
+    else if (table_row->qof_param_name != NULL)
+    {
+        auto param = get_column_param (obj_name, table_row);
+        setter = param ? param->param_setfcn : NULL;
+    }
+    else
+    {
+        setter = table_row->setter;
+    }
+
+    return setter;
+}
+
 /* ----------------------------------------------------------------- */
 void
 gnc_sql_add_colname_to_list (const GncSqlColumnTableEntry* table_row,
@@ -2377,6 +2560,28 @@ static GncSqlColumnTypeHandler numeric_handler
 /* ================================================================= */
 
 static  GHashTable* g_columnTypeHash = NULL;
+/* The handler of each column, found in g_columnTypeHash when the column is
+ * first used. */
+static std::unordered_map<const GncSqlColumnTableEntry*,
+                          GncSqlColumnTypeHandler*> column_handlers;
+
+/* What loads each column of a table from a row: its handler and setter,
+ * worked out the first time the table is loaded so that loading a row
+ * is only a call for each column. Keyed by the address of the static
+ * column table, like column_params. */
+struct ColumnLoader
+{
+    const GncSqlColumnTableEntry* table_row;
+    GncSqlColumnTypeHandler* handler;
+    QofSetterFunc setter;
+};
+struct TableLoader
+{
+    std::string obj_name;
+    std::vector<ColumnLoader> columns;
+};
+static std::unordered_map<const GncSqlColumnTableEntry*, TableLoader>
+    table_loaders;
 
 void
 gnc_sql_register_col_type_handler (const gchar* colType,
@@ -2393,6 +2598,8 @@ gnc_sql_register_col_type_handler (const gchar* colType,
 
     DEBUG ("Col type %s registered\n", colType);
     g_hash_table_insert (g_columnTypeHash, (gpointer)colType, (gpointer)handler);
+    column_handlers.clear ();
+    table_loaders.clear ();
 }
 
 static GncSqlColumnTypeHandler*
@@ -2405,8 +2612,11 @@ get_handler (const GncSqlColumnTableEntry* table_row)
 
     if (g_columnTypeHash != NULL)
     {
-        pHandler = static_cast<decltype (pHandler)> (
-                       g_hash_table_lookup (g_columnTypeHash, table_row->col_type));
+        auto& handler = column_handlers[table_row];
+        if (handler == NULL)
+            handler = static_cast<decltype (pHandler)> (
+                g_hash_table_lookup (g_columnTypeHash, table_row->col_type));
+        pHandler = handler;
         g_assert (pHandler != NULL);
     }
     else
@@ -2485,22 +2695,21 @@ gnc_sql_load_tx_guid (const GncSqlBackend* be, GncSqlRow* row)
     return &guid;
 }
 
-void
-gnc_sql_load_object (const GncSqlBackend* be, GncSqlRow* row,
-                     QofIdTypeConst obj_name, gpointer pObject,
-                     const GncSqlColumnTableEntry* table)
+static const TableLoader&
+get_table_loader (QofIdTypeConst obj_name, const GncSqlColumnTableEntry* table)
 {
-    QofSetterFunc setter;
-    GncSqlColumnTypeHandler* pHandler;
-    const GncSqlColumnTableEntry* table_row;
-
-    g_return_if_fail (be != NULL);
-    g_return_if_fail (row != NULL);
-    g_return_if_fail (pObject != NULL);
-    g_return_if_fail (table != NULL);
+    auto& loader = table_loaders[table];
+    /* A few tables are shared between object types. */
+    if (!loader.columns.empty ()
+        && loader.obj_name == (obj_name != NULL ? obj_name : ""))
+        return loader;
 
-    for (table_row = table; table_row->col_name != NULL; table_row++)
+    loader.obj_name = obj_name != NULL ? obj_name : "";
+    loader.columns.clear ();
+    for (auto table_row = table; table_row->col_name != NULL; table_row++)
     {
+        QofSetterFunc setter;
+
         if ((table_row->flags & COL_AUTOINC) != 0)
         {
             setter = set_autoinc_id;
@@ -2508,17 +2717,32 @@ gnc_sql_load_object (const GncSqlBackend* be, GncSqlRow* row,
         else if (table_row->qof_param_name != NULL)
         {
             g_assert (obj_name != NULL);
-            setter = qof_class_get_parameter_setter (obj_name,
-                                                     table_row->qof_param_name);
+            setter = gnc_sql_get_setter (obj_name, table_row);
         }
         else
         {
             setter = table_row->setter;
         }
-        pHandler = get_handler (table_row);
+        auto pHandler = get_handler (table_row);
         g_assert (pHandler != NULL);
-        pHandler->load_fn (be, row, setter, pObject, table_row);
+        loader.columns.push_back (ColumnLoader {table_row, pHandler, setter});
     }
+    return loader;
+}
+
+void
+gnc_sql_load_object (const GncSqlBackend* be, GncSqlRow* row,
+                     QofIdTypeConst obj_name, gpointer pObject,
+                     const GncSqlColumnTableEntry* table)
+{
+    g_return_if_fail (be != NULL);
+    g_return_if_fail (row != NULL);
+    g_return_if_fail (pObject != NULL);
+    g_return_if_fail (table != NULL);
+
+    for (auto& column : get_table_loader (obj_name, table).columns)
+        column.handler->load_fn (be, row, column.setter, pObject,
+                                 column.table_row);
 }
 
 /* ================================================================= */
@@ -2565,6 +2789,7 @@ gnc_sql_execute_select_statement (GncSqlBackend* be, GncSqlStatement* stmt)
     g_return_val_if_fail (be != NULL, NULL);
     g_return_val_if_fail (stmt != NULL, NULL);
 
+    flush_insert_batches (be);
     result = gnc_sql_connection_execute_select_statement (be->conn, stmt);
     if (result == NULL)
     {
@@ -2575,6 +2800,33 @@ gnc_sql_execute_select_statement (GncSqlBackend* be, GncSqlStatement* stmt)
     return result;
 }
 
+static const guint default_fetch_size = 1000;
+
+GncSqlResult*
+gnc_sql_execute_select_statement_streamed (GncSqlBackend* be,
+                                           GncSqlStatement* stmt)
+{
+    GncSqlResult* result;
+    const char* rows = g_getenv ("GNC_SQL_FETCH_SIZE");
+    guint fetch_size = rows ? static_cast<guint> (MAX (1, atoi (rows)))
+                            : default_fetch_size;
+
+    g_return_val_if_fail (be != NULL, NULL);
+    g_return_val_if_fail (stmt != NULL, NULL);
+
+    flush_insert_batches (be);
+    result = gnc_sql_connection_execute_select_statement_streamed (be->conn,
+                                                                   stmt,
+                                                                   fetch_size);
+    if (result == NULL)
+    {
+        PERR ("SQL error: %s\n", gnc_sql_statement_to_sql (stmt));
+        qof_backend_set_error (&be->be, ERR_BACKEND_SERVER_ERR);
+    }
+
+    return result;
+}
+
 GncSqlStatement*
 gnc_sql_create_statement_from_sql (GncSqlBackend* be, const gchar* sql)
 {
@@ -2607,6 +2859,7 @@ gnc_sql_execute_select_sql (GncSqlBackend* be, const gchar* sql)
     {
         return NULL;
     }
+    flush_insert_batches (be);
     result = gnc_sql_connection_execute_select_statement (be->conn, stmt);
     gnc_sql_statement_dispose (stmt);
     if (result == NULL)
@@ -2632,6 +2885,7 @@ gnc_sql_execute_nonselect_sql (GncSqlBackend* be, const gchar* sql)
     {
         return -1;
     }
+    flush_insert_batches (be);
     result = gnc_sql_connection_execute_nonselect_statement (be->conn, stmt);
     gnc_sql_statement_dispose (stmt);
     return result;
@@ -2735,6 +2989,7 @@ gnc_sql_do_db_operation (GncSqlBackend* be,
 {
     GncSqlStatement* stmt = NULL;
     gboolean ok = FALSE;
+    RowValues row;
 
     g_return_val_if_fail (be != NULL, FALSE);
     g_return_val_if_fail (table_name != NULL, FALSE);
@@ -2742,16 +2997,63 @@ gnc_sql_do_db_operation (GncSqlBackend* be,
     g_return_val_if_fail (pObject != NULL, FALSE);
     g_return_val_if_fail (table != NULL, FALSE);
 
-    if (op == OP_DB_INSERT)
+    if (op == OP_DB_UPSERT)
+    {
+        row = get_row_values (be, obj_name, pObject, table);
+        auto stored = find_stored_row (be, table_name, row);
+        if (stored != NULL && *stored == row)
+        {
+            // Written already, as it is
+            return TRUE;
+        }
+        if (stored == NULL && be->is_pristine_db)
+        {
+            /* Nothing is in a new database but what this save wrote.
+             * Keep the row even so, for the next object referring to
+             * the same one. */
+            auto key = stored_row_key (table_name, row);
+            stored_rows[be][key] = row;
+            op = OP_DB_INSERT;
+        }
+        else if (stored == NULL && be->upsert_style == UPSERT_NONE)
+        {
+            op = gnc_sql_object_is_it_in_db (be, table_name, obj_name,
+                                             pObject, table) ?
+                 OP_DB_UPDATE : OP_DB_INSERT;
+        }
+        else if (stored != NULL)
+        {
+            op = OP_DB_UPDATE;
+        }
+    }
+    if (op == OP_DB_INSERT && sync_batches && sync_batches->be == be)
+    {
+        return batch_insert (be, table_name, obj_name, pObject, table);
+    }
+    flush_insert_batches (be);
+    if (op == OP_DB_UPSERT)
+    {
+        stmt = build_upsert_statement (be, table_name, table, row);
+    }
+    else if (op == OP_DB_INSERT)
     {
-        stmt = build_insert_statement (be, table_name, obj_name, pObject, table);
+        row = get_row_values (be, obj_name, pObject, table);
+        stmt = build_insert_statement (be, table_name, table, row);
     }
     else if (op == OP_DB_UPDATE)
     {
-        stmt = build_update_statement (be, table_name, obj_name, pObject, table);
+        row = get_row_values (be, obj_name, pObject, table);
+        auto stored = find_stored_row (be, table_name, row);
+        if (stored != NULL && *stored == row)
+        {
+            // Nothing in the row changed
+            return TRUE;
+        }
+        stmt = build_update_statement (be, table_name, table, row, stored);
     }
     else if (op == OP_DB_DELETE)
     {
+        row = get_row_values (be, obj_name, pObject, table);
         stmt = build_delete_statement (be, table_name, obj_name, pObject, table);
     }
     else
@@ -2767,10 +3069,16 @@ gnc_sql_do_db_operation (GncSqlBackend* be,
         {
             PERR ("SQL error: %s\n", gnc_sql_statement_to_sql (stmt));
             qof_backend_set_error (&be->be, ERR_BACKEND_SERVER_ERR);
+            gnc_sql_forget_rows (be);
         }
         else
         {
             ok = TRUE;
+            auto key = stored_row_key (table_name, row);
+            if (op == OP_DB_DELETE)
+                (void)stored_rows[be].erase (key);
+            else if (!be->is_pristine_db || op == OP_DB_UPSERT)
+                stored_rows[be][key] = std::move (row);
         }
         gnc_sql_statement_dispose (stmt);
     }
@@ -2812,12 +3120,9 @@ gnc_sql_get_sql_value (const GncSqlConnection* conn, const GValue* value)
         {
             if (g_value_get_string (value) != NULL)
             {
-                gchar* before_str;
-                gchar* after_str;
-                before_str = g_value_dup_string (value);
-                after_str = gnc_sql_connection_quote_string (conn, before_str);
-                g_free (before_str);
-                return after_str;
+                /* The driver copies the string as it quotes it. */
+                return gnc_sql_connection_quote_string (
+                           conn, const_cast<gchar*> (g_value_get_string (value)));
             }
             else
             {
@@ -2886,33 +3191,32 @@ free_gvalue_list (GSList* list)
     g_slist_free (list);
 }
 
-static GncSqlStatement*
-build_insert_statement (GncSqlBackend* be,
-                        const gchar* table_name,
-                        QofIdTypeConst obj_name, gpointer pObject,
-                        const GncSqlColumnTableEntry* table)
+/* The text of an INSERT or UPDATE that is the same for every object of
+ * a table, built the first time the table is written. libdbi can't bind
+ * parameters to a prepared statement, so only the values are left to
+ * format for each row. Keyed by the address of the static column table,
+ * like column_params. */
+struct TableStatements
 {
-    GncSqlStatement* stmt;
-    GString* sql;
-    GSList* values;
-    GSList* node;
-    gchar* sqlbuf;
-    GList* colnames = NULL;
-    GList* colname;
-    const GncSqlColumnTableEntry* table_row;
-
-    g_return_val_if_fail (be != NULL, NULL);
-    g_return_val_if_fail (table_name != NULL, NULL);
-    g_return_val_if_fail (obj_name != NULL, NULL);
-    g_return_val_if_fail (pObject != NULL, NULL);
-    g_return_val_if_fail (table != NULL, NULL);
+    std::string table_name;
+    std::string insert;             /* "INSERT INTO t(a,b,c) VALUES(" */
+    std::string update;             /* "UPDATE t SET " */
+    std::vector<std::string> sets;  /* "b=", "c=": every column but the first */
+};
+static std::unordered_map<const GncSqlColumnTableEntry*, TableStatements>
+    table_statements;
 
-    sqlbuf = g_strdup_printf ("INSERT INTO %s(", table_name);
-    sql = g_string_new (sqlbuf);
-    g_free (sqlbuf);
+static const TableStatements&
+get_table_statements (const gchar* table_name,
+                      const GncSqlColumnTableEntry* table)
+{
+    auto& stmts = table_statements[table];
+    /* A few column tables are shared between database tables. */
+    if (!stmts.insert.empty () && stmts.table_name == table_name)
+        return stmts;
 
-    // Get all col names and all values
-    for (table_row = table; table_row->col_name != NULL; table_row++)
+    GList* colnames = NULL;
+    for (auto table_row = table; table_row->col_name != NULL; table_row++)
     {
         if ((table_row->flags & COL_AUTOINC) == 0)
         {
@@ -2926,118 +3230,289 @@ build_insert_statement (GncSqlBackend* be,
     }
     g_assert (colnames != NULL);
 
-    for (colname = colnames; colname != NULL; colname = colname->next)
+    stmts.table_name = table_name;
+    stmts.insert = std::string {"INSERT INTO "} + table_name + "(";
+    stmts.update = std::string {"UPDATE "} + table_name + " SET ";
+    stmts.sets.clear ();
+    for (auto colname = colnames; colname != NULL; colname = colname->next)
     {
+        auto name = static_cast<gchar*> (colname->data);
         if (colname != colnames)
         {
-            g_string_append (sql, ",");
+            stmts.insert += ",";
+            stmts.sets.push_back (std::string {name} + "=");
         }
-        g_string_append (sql, (gchar*)colname->data);
-        g_free (colname->data);
+        stmts.insert += name;
+        g_free (name);
     }
     g_list_free (colnames);
+    stmts.insert += ") VALUES(";
+    return stmts;
+}
+
+/* The SQL text of each of the object's column values, in column order. */
+static RowValues
+get_row_values (GncSqlBackend* be, QofIdTypeConst obj_name, gpointer pObject,
+                const GncSqlColumnTableEntry* table)
+{
+    RowValues row;
+    GSList* values;
+    GSList* node;
 
-    g_string_append (sql, ") VALUES(");
     values = create_gslist_from_values (be, obj_name, pObject, table);
     for (node = values; node != NULL; node = node->next)
     {
-        GValue* value = (GValue*)node->data;
-        gchar* value_str;
-        if (node != values)
-        {
-            (void)g_string_append (sql, ",");
-        }
-        value_str = gnc_sql_get_sql_value (be->conn, value);
-        (void)g_string_append (sql, value_str);
+        gchar* value_str = gnc_sql_get_sql_value (be->conn,
+                                                  (GValue*)node->data);
+        row.emplace_back (value_str != NULL ? value_str : "");
         g_free (value_str);
-        (void)g_value_reset (value);
     }
     free_gvalue_list (values);
-    (void)g_string_append (sql, ")");
+    return row;
+}
 
-    stmt = gnc_sql_connection_create_statement_from_sql (be->conn, sql->str);
-    (void)g_string_free (sql, TRUE);
+/* Appends a row's values and the closing parenthesis of the row. */
+static void
+append_row_values (std::string& sql, const RowValues& row)
+{
+    for (auto value = row.begin (); value != row.end (); ++value)
+    {
+        if (value != row.begin ())
+        {
+            sql += ",";
+        }
+        sql += *value;
+    }
+    sql += ")";
+}
+
+/* The values of each row as the backend last wrote it, or as it was when
+ * an edit of its object began, so that an UPDATE only sets the columns
+ * which changed.  Keyed by the table's name and the value of the row's
+ * first column, its guid.  Rows written by a save of the whole book
+ * aren't kept, and all of a backend's are dropped when a write fails. */
+static std::unordered_map<const GncSqlBackend*,
+                          std::unordered_map<std::string, RowValues>>
+    stored_rows;
+
+static std::string
+stored_row_key (const gchar* table_name, const RowValues& row)
+{
+    return std::string {table_name} + ":" + row.front ();
+}
+
+static const RowValues*
+find_stored_row (GncSqlBackend* be, const gchar* table_name,
+                 const RowValues& row)
+{
+    auto rows = stored_rows.find (be);
+    if (rows == stored_rows.end ())
+        return NULL;
+    auto stored = rows->second.find (stored_row_key (table_name, row));
+    return stored != rows->second.end () ? &stored->second : NULL;
+}
+
+void
+gnc_sql_remember_row (GncSqlBackend* be, const gchar* table_name,
+                      QofIdTypeConst obj_name, gpointer pObject,
+                      const GncSqlColumnTableEntry* table)
+{
+    g_return_if_fail (be != NULL);
+    g_return_if_fail (table_name != NULL);
+    g_return_if_fail (pObject != NULL);
+    g_return_if_fail (table != NULL);
+
+    auto row = get_row_values (be, obj_name, pObject, table);
+    auto key = stored_row_key (table_name, row);
+    (void)stored_rows[be].emplace (key, std::move (row));
+}
+
+gboolean
+gnc_sql_row_is_stored (GncSqlBackend* be, const gchar* table_name,
+                       QofIdTypeConst obj_name, gpointer pObject,
+                       const GncSqlColumnTableEntry* table)
+{
+    g_return_val_if_fail (be != NULL, FALSE);
+    g_return_val_if_fail (table_name != NULL, FALSE);
+    g_return_val_if_fail (pObject != NULL, FALSE);
+    g_return_val_if_fail (table != NULL, FALSE);
+
+    auto row = get_row_values (be, obj_name, pObject, table);
+    auto stored = find_stored_row (be, table_name, row);
+    return stored != NULL && *stored == row;
+}
+
+void
+gnc_sql_forget_rows (GncSqlBackend* be)
+{
+    (void)stored_rows.erase (be);
+}
+
+static GncSqlStatement*
+build_insert_statement (GncSqlBackend* be,
+                        const gchar* table_name,
+                        const GncSqlColumnTableEntry* table,
+                        const RowValues& row)
+{
+    GncSqlStatement* stmt;
+
+    g_return_val_if_fail (be != NULL, NULL);
+    g_return_val_if_fail (table_name != NULL, NULL);
+    g_return_val_if_fail (table != NULL, NULL);
+
+    std::string sql {get_table_statements (table_name, table).insert};
+    append_row_values (sql, row);
+
+    stmt = gnc_sql_connection_create_statement_from_sql (be->conn, sql.c_str ());
 
     return stmt;
 }
 
+static gboolean
+flush_insert_batch (GncSqlBackend* be, InsertBatch& batch)
+{
+    GncSqlStatement* stmt;
+    gint result;
+
+    if (batch.rows == 0)
+        return TRUE;
+    stmt = gnc_sql_connection_create_statement_from_sql (be->conn,
+                                                         batch.sql.c_str ());
+    result = stmt ? gnc_sql_connection_execute_nonselect_statement (be->conn,
+                                                                    stmt) : -1;
+    if (stmt)
+        gnc_sql_statement_dispose (stmt);
+    batch.sql.clear ();
+    batch.rows = 0;
+    update_progress (be);
+    if (result == -1)
+    {
+        PERR ("SQL error in a batch of inserts\n");
+        qof_backend_set_error (&be->be, ERR_BACKEND_SERVER_ERR);
+        sync_batches->failed = TRUE;
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static gboolean
+flush_insert_batches (GncSqlBackend* be)
+{
+    gboolean ok = TRUE;
+
+    if (!sync_batches || sync_batches->be != be)
+        return TRUE;
+    for (auto& table : sync_batches->tables)
+        ok = flush_insert_batch (be, table.second) && ok;
+    return ok;
+}
+
+static gboolean
+batch_insert (GncSqlBackend* be, const gchar* table_name,
+              QofIdTypeConst obj_name, gpointer pObject,
+              const GncSqlColumnTableEntry* table)
+{
+    auto& batch = sync_batches->tables[table_name];
+
+    if (batch.rows == 0)
+        batch.sql = get_table_statements (table_name, table).insert;
+    else
+        batch.sql += ",(";
+    append_row_values (batch.sql, get_row_values (be, obj_name, pObject, table));
+    if (++batch.rows >= sync_batches->max_rows ||
+        batch.sql.size () >= max_insert_batch_bytes)
+        return flush_insert_batch (be, batch);
+    return TRUE;
+}
+
+/* Sets only the columns whose values differ from the stored row's, if
+ * there is one. */
 static GncSqlStatement*
 build_update_statement (GncSqlBackend* be,
                         const gchar* table_name,
-                        QofIdTypeConst obj_name, gpointer pObject,
-                        const GncSqlColumnTableEntry* table)
+                        const GncSqlColumnTableEntry* table,
+                        const RowValues& row,
+                        const RowValues* stored)
 {
     GncSqlStatement* stmt;
-    GString* sql;
-    GSList* values;
-    GList* colnames = NULL;
-    GSList* value;
-    GList* colname;
-    gboolean firstCol;
-    const GncSqlColumnTableEntry* table_row;
-    gchar* sqlbuf;
+    gboolean first = TRUE;
 
     g_return_val_if_fail (be != NULL, NULL);
     g_return_val_if_fail (table_name != NULL, NULL);
-    g_return_val_if_fail (obj_name != NULL, NULL);
-    g_return_val_if_fail (pObject != NULL, NULL);
     g_return_val_if_fail (table != NULL, NULL);
 
-    // Get all col names and all values
-    for (table_row = table; table_row->col_name != NULL; table_row++)
+    auto& stmts = get_table_statements (table_name, table);
+    if (row.size () != stmts.sets.size () + 1)
     {
-        if ((table_row->flags & COL_AUTOINC) == 0)
-        {
-            GncSqlColumnTypeHandler* pHandler;
-
-            // Add col names to the list
-            pHandler = get_handler (table_row);
-            g_assert (pHandler != NULL);
-            pHandler->add_colname_to_list_fn (table_row, &colnames);
-        }
+        PERR ("Mismatch in number of column names and values");
+        return NULL;
     }
-    g_assert (colnames != NULL);
-    values = create_gslist_from_values (be, obj_name, pObject, table);
+    if (stored != NULL && stored->size () != row.size ())
+        stored = NULL;
 
     // Create the SQL statement
-    sqlbuf = g_strdup_printf ("UPDATE %s SET ", table_name);
-    sql = g_string_new (sqlbuf);
-    g_free (sqlbuf);
-
-    firstCol = TRUE;
-    for (colname = colnames->next, value = values->next;
-         colname != NULL && value != NULL;
-         colname = colname->next, value = value->next)
+    std::string sql {stmts.update};
+    for (size_t i = 1; i < row.size (); i++)
     {
-        gchar* value_str;
-        if (!firstCol)
+        if (stored != NULL && (*stored)[i] == row[i])
+            continue;
+        if (!first)
         {
-            (void)g_string_append (sql, ",");
+            sql += ",";
         }
-        (void)g_string_append (sql, (gchar*)colname->data);
-        (void)g_string_append (sql, "=");
-        value_str = gnc_sql_get_sql_value (be->conn, (GValue*) (value->data));
-        (void)g_string_append (sql, value_str);
-        g_free (value_str);
-        firstCol = FALSE;
-    }
-    for (colname = colnames; colname != NULL; colname = colname->next)
-    {
-        g_free (colname->data);
+        sql += stmts.sets[i - 1];
+        sql += row[i];
+        first = FALSE;
     }
-    g_list_free (colnames);
-    if (value != NULL || colname != NULL)
+    sql += std::string {" WHERE "} + table[0].col_name + " = " + row[0];
+
+    stmt = gnc_sql_connection_create_statement_from_sql (be->conn, sql.c_str ());
+
+    return stmt;
+}
+
+/* The INSERT of the row, turned into an UPDATE of every other column by
+ * a row with the same first column, the primary key. */
+static GncSqlStatement*
+build_upsert_statement (GncSqlBackend* be,
+                        const gchar* table_name,
+                        const GncSqlColumnTableEntry* table,
+                        const RowValues& row)
+{
+    g_return_val_if_fail (be != NULL, NULL);
+    g_return_val_if_fail (table_name != NULL, NULL);
+    g_return_val_if_fail (table != NULL, NULL);
+    g_return_val_if_fail ((table[0].flags & COL_PKEY) != 0, NULL);
+
+    auto& stmts = get_table_statements (table_name, table);
+    if (row.size () != stmts.sets.size () + 1)
     {
         PERR ("Mismatch in number of column names and values");
+        return NULL;
     }
 
-    stmt = gnc_sql_connection_create_statement_from_sql (be->conn, sql->str);
-    gnc_sql_statement_add_where_cond (stmt, obj_name, pObject, &table[0],
-                                      (GValue*) (values->data));
-    free_gvalue_list (values);
-    (void)g_string_free (sql, TRUE);
+    std::string sql {stmts.insert};
+    append_row_values (sql, row);
+    if (be->upsert_style == UPSERT_ON_DUPLICATE_KEY)
+        sql += " ON DUPLICATE KEY UPDATE ";
+    else
+        sql += std::string {" ON CONFLICT("} + table[0].col_name +
+               ") DO UPDATE SET ";
+    for (auto set = stmts.sets.begin (); set != stmts.sets.end (); ++set)
+    {
+        // set is "col="
+        auto col = set->substr (0, set->size () - 1);
+        if (set != stmts.sets.begin ())
+        {
+            sql += ",";
+        }
+        if (be->upsert_style == UPSERT_ON_DUPLICATE_KEY)
+            sql += *set + "VALUES(" + col + ")";
+        else
+            sql += *set + "excluded." + col;
+    }
 
-    return stmt;
+    return gnc_sql_connection_create_statement_from_sql (be->conn, sql.c_str ());
 }
 
 static GncSqlStatement*
@@ -3190,6 +3665,137 @@ gnc_sql_create_index (const GncSqlBackend* be, const gchar* index_name,
     return ok;
 }
 
+/* ================================================================= */
+/* Indexes which the loaders and the split query compiler depend on.
+ * Tables are only given their indexes when they are created, so a database
+ * made by an older version, or one whose table was rebuilt by
+ * gnc_sql_upgrade_table(), can lack some of them.  To add an index, append
+ * it to index_table and raise INDEX_VERSION. */
+#define INDEX_VERSION_NAME "Gnucash-Indexes"
+#define INDEX_VERSION 1
+
+static const GncSqlColumnTableEntry post_date_index_cols[] =
+{
+    { "post_date", CT_TIMESPEC, 0, 0 },
+    { NULL }
+};
+static const GncSqlColumnTableEntry tx_guid_index_cols[] =
+{
+    { "tx_guid", CT_GUID, 0, 0 },
+    { NULL }
+};
+static const GncSqlColumnTableEntry account_guid_index_cols[] =
+{
+    { "account_guid", CT_GUID, 0, 0 },
+    { NULL }
+};
+static const GncSqlColumnTableEntry obj_guid_index_cols[] =
+{
+    { "obj_guid", CT_GUID, 0, 0 },
+    { NULL }
+};
+static const GncSqlColumnTableEntry obj_guid_name_index_cols[] =
+{
+    { "obj_guid", CT_GUID, 0, 0 },
+    { "name", CT_STRING, 0, 0 },
+    { NULL }
+};
+static const GncSqlColumnTableEntry commodity_date_index_cols[] =
+{
+    { "commodity_guid", CT_GUID, 0, 0 },
+    { "date", CT_TIMESPEC, 0, 0 },
+    { NULL }
+};
+
+typedef struct
+{
+    const gchar* index_name;
+    const gchar* table_name;
+    const GncSqlColumnTableEntry* col_table;
+} GncSqlIndexInfo;
+
+static const GncSqlIndexInfo index_table[] =
+{
+    { "tx_post_date_index", "transactions", post_date_index_cols },
+    { "splits_tx_guid_index", "splits", tx_guid_index_cols },
+    { "splits_account_guid_index", "splits", account_guid_index_cols },
+    { "slots_guid_index", "slots", obj_guid_index_cols },
+    { "slots_guid_name_index", "slots", obj_guid_name_index_cols },
+    { "prices_commodity_date_index", "prices", commodity_date_index_cols },
+    { NULL }
+};
+
+/* Backends on which gnc_sql_upgrade_table() has dropped a table, and with
+ * it the table's indexes, since the index version was last checked. */
+static std::unordered_set<const GncSqlBackend*> indexes_dropped;
+
+static gboolean
+index_is_missing (GncSqlBackend* be, const GncSqlIndexInfo* info)
+{
+    return gnc_sql_connection_does_table_exist (be->conn, info->table_name)
+           && !gnc_sql_connection_does_index_exist (be->conn, info->index_name,
+                                                    info->table_name);
+}
+
+GList*
+gnc_sql_missing_indexes (GncSqlBackend* be)
+{
+    GList* missing = NULL;
+
+    g_return_val_if_fail (be != NULL, NULL);
+    g_return_val_if_fail (be->conn != NULL, NULL);
+
+    for (const GncSqlIndexInfo* info = index_table; info->index_name != NULL;
+         ++info)
+    {
+        if (!index_is_missing (be, info)) continue;
+        PWARN ("Index %s on table %s is missing", info->index_name,
+               info->table_name);
+        missing = g_list_prepend (missing,
+                                  g_strdup_printf ("%s (%s)", info->index_name,
+                                                   info->table_name));
+    }
+    return g_list_reverse (missing);
+}
+
+gboolean
+gnc_sql_update_indexes (GncSqlBackend* be)
+{
+    gboolean ok = TRUE;
+
+    g_return_val_if_fail (be != NULL, FALSE);
+    g_return_val_if_fail (be->conn != NULL, FALSE);
+
+    if (gnc_sql_get_table_version (be, INDEX_VERSION_NAME) >= INDEX_VERSION
+        && indexes_dropped.find (be) == indexes_dropped.end ())
+        return TRUE;
+
+    ENTER ("be=%p", be);
+    for (const GncSqlIndexInfo* info = index_table; info->index_name != NULL;
+         ++info)
+    {
+        if (!index_is_missing (be, info)) continue;
+        PINFO ("Creating missing index %s on table %s", info->index_name,
+               info->table_name);
+        if (!gnc_sql_create_index (be, info->index_name, info->table_name,
+                                   info->col_table))
+        {
+            PERR ("Unable to create index %s on table %s", info->index_name,
+                  info->table_name);
+            ok = FALSE;
+        }
+    }
+
+    /* Leave the version alone on failure so the next session tries again. */
+    if (ok)
+    {
+        indexes_dropped.erase (be);
+        (void)gnc_sql_set_table_version (be, INDEX_VERSION_NAME, INDEX_VERSION);
+    }
+    LEAVE ("ok=%d", ok);
+    return ok;
+}
+
 gint
 gnc_sql_get_table_version (const GncSqlBackend* be, const gchar* table_name)
 {
@@ -3219,6 +3825,8 @@ gnc_sql_upgrade_table (GncSqlBackend* be, const gchar* table_name,
     g_return_if_fail (col_table != NULL);
 
     DEBUG ("Upgrading %s table\n", table_name);
+    /* Dropping the old table below drops its indexes too. */
+    indexes_dropped.insert (be);
 
     temp_table_name = g_strdup_printf ("%s_new", table_name);
     (void)gnc_sql_create_temp_table (be, temp_table_name, col_table);
@@ -3375,6 +3983,7 @@ gnc_sql_finalize_version_info (GncSqlBackend* be)
         g_hash_table_destroy (be->versions);
         be->versions = NULL;
     }
+    indexes_dropped.erase (be);
 }
 
 /**
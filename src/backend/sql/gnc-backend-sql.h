@@ -46,6 +46,18 @@ extern "C"
 }
 typedef struct GncSqlConnection GncSqlConnection;
 
+/**
+ * How the database writes a row whether or not one with its key is
+ * already there.
+ */
+typedef enum
+{
+    UPSERT_NONE,            /**< It can't; look for the row first */
+    UPSERT_ON_CONFLICT,     /**< INSERT ... ON CONFLICT DO UPDATE (SQLite
+                                 3.24, PostgreSQL 9.5) */
+    UPSERT_ON_DUPLICATE_KEY /**< INSERT ... ON DUPLICATE KEY UPDATE (MySQL) */
+} E_DB_UPSERT_STYLE;
+
 /**
  * @struct GncSqlBackend
  *
@@ -63,6 +75,11 @@ struct GncSqlBackend
     gint operations_done;    /**< Number of operations (save/load) done */
     GHashTable* versions;    /**< Version number for each table */
     const gchar* timespec_format;   /**< Format string for SQL for timespec values */
+    E_DB_UPSERT_STYLE upsert_style; /**< How the database does OP_DB_UPSERT */
+    gboolean writes_queued;  /**< Writes are sent after they return, so a
+                                 commit shouldn't query what it writes */
+    struct GncSqlTxCache* tx_cache; /**< Transactions loaded as needed, for
+                                        taking them out of memory again */
 };
 typedef struct GncSqlBackend GncSqlBackend;
 
@@ -162,11 +179,16 @@ struct GncSqlConnection
     void (*dispose) (GncSqlConnection*);
     GncSqlResult* (*executeSelectStatement) (GncSqlConnection*,
                                              GncSqlStatement*);  /**< Returns NULL if error */
+    GncSqlResult* (*executeSelectStatementStreamed) (GncSqlConnection*,
+                                                     GncSqlStatement*,
+                                                     guint);  /**< Returns NULL if error */
     gint (*executeNonSelectStatement) (GncSqlConnection*,
                                        GncSqlStatement*);  /**< Returns -1 if error */
     GncSqlStatement* (*createStatementFromSql) (GncSqlConnection*, const gchar*);
     gboolean (*doesTableExist) (GncSqlConnection*,
                                 const gchar*);   /**< Returns true if successful */
+    gboolean (*doesIndexExist) (GncSqlConnection*, const gchar*,
+                                const gchar*);   /**< Index name, table name; returns TRUE if the index exists */
     gboolean (*beginTransaction) (
         GncSqlConnection*);  /**< Returns TRUE if successful, FALSE if error */
     gboolean (*rollbackTransaction) (
@@ -180,16 +202,23 @@ struct GncSqlConnection
     gboolean (*addColumnsToTable) (GncSqlConnection*, const gchar* table,
                                    GList*);  /**< Returns TRUE if successful, FALSE if error */
     gchar* (*quoteString) (const GncSqlConnection*, gchar*);
+    void (*beginPrefetch) (GncSqlConnection*,
+                           const gchar**);  /**< Starts running SELECTs, NULL-terminated, that are about to be executed */
+    void (*endPrefetch) (GncSqlConnection*);  /**< Drops the results of a prefetch not yet executed */
 };
 #define gnc_sql_connection_dispose(CONN) (CONN)->dispose(CONN)
 #define gnc_sql_connection_execute_select_statement(CONN,STMT) \
         (CONN)->executeSelectStatement(CONN,STMT)
+#define gnc_sql_connection_execute_select_statement_streamed(CONN,STMT,BATCH) \
+        (CONN)->executeSelectStatementStreamed(CONN,STMT,BATCH)
 #define gnc_sql_connection_execute_nonselect_statement(CONN,STMT) \
         (CONN)->executeNonSelectStatement(CONN,STMT)
 #define gnc_sql_connection_create_statement_from_sql(CONN,SQL) \
         (CONN)->createStatementFromSql(CONN,SQL)
 #define gnc_sql_connection_does_table_exist(CONN,NAME) \
         (CONN)->doesTableExist(CONN,NAME)
+#define gnc_sql_connection_does_index_exist(CONN,INDEXNAME,TABLENAME) \
+        (CONN)->doesIndexExist(CONN,INDEXNAME,TABLENAME)
 #define gnc_sql_connection_begin_transaction(CONN) \
         (CONN)->beginTransaction(CONN)
 #define gnc_sql_connection_rollback_transaction(CONN) \
@@ -204,6 +233,10 @@ struct GncSqlConnection
         (CONN)->addColumnsToTable(CONN,TABLENAME,COLLIST)
 #define gnc_sql_connection_quote_string(CONN,STR) \
         (CONN)->quoteString(CONN,STR)
+#define gnc_sql_connection_begin_prefetch(CONN,SQLS) \
+        (CONN)->beginPrefetch(CONN,SQLS)
+#define gnc_sql_connection_end_prefetch(CONN) \
+        (CONN)->endPrefetch(CONN)
 
 /**
  * @struct GncSqlRow
@@ -256,6 +289,7 @@ struct GncSqlResult
  * run_query()      - run a compiled query
  * free_query()     - free a compiled query
  * write()          - write all objects
+ * begin_edit()     - note an object's rows before it is changed
  */
 typedef struct
 {
@@ -279,6 +313,10 @@ typedef struct
      * @return TRUE if successful, FALSE if error
      */
     gboolean (*write) (GncSqlBackend* be);
+    /** Note the rows of an object about to be edited, with
+     * gnc_sql_remember_row(), so that committing it only updates the
+     * columns which changed */
+    void (*begin_edit) (GncSqlBackend* be, QofInstance* inst);
 } GncSqlObjectBackend;
 #define GNC_SQL_BACKEND             "gnc:sql:1"
 #define GNC_SQL_BACKEND_VERSION 1
@@ -367,7 +405,8 @@ typedef enum
 {
     OP_DB_INSERT,
     OP_DB_UPDATE,
-    OP_DB_DELETE
+    OP_DB_DELETE,
+    OP_DB_UPSERT    /**< Insert the row, or update it if it is there */
 } E_DB_OPERATION;
 
 typedef void (*GNC_SQL_LOAD_FN) (const GncSqlBackend* be,
@@ -427,6 +466,16 @@ typedef struct
 QofAccessFunc gnc_sql_get_getter (QofIdTypeConst obj_name,
                                   const GncSqlColumnTableEntry* table_row);
 
+/**
+ * Returns the QOF setter function for a column.
+ *
+ * @param obj_name QOF object type name
+ * @param table_row DB table column
+ * @return Setter function
+ */
+QofSetterFunc gnc_sql_get_setter (QofIdTypeConst obj_name,
+                                  const GncSqlColumnTableEntry* table_row);
+
 /**
  * Adds a column name to a list.  If the column type spans multiple columns,
  * all of the column names for the pieces are added.
@@ -440,6 +489,11 @@ void gnc_sql_add_colname_to_list (const GncSqlColumnTableEntry* table_row,
 /**
  * Performs an operation on the database.
  *
+ * An OP_DB_UPSERT of a row the backend has already written, or is saving
+ * into a pristine database, needs no more than an UPDATE or INSERT;
+ * otherwise it is a single statement in the database's own dialect, and
+ * only a database without one gets asked whether the row is there.
+ *
  * @param be SQL backend struct
  * @param op Operation type
  * @param table_name SQL table name
@@ -455,6 +509,45 @@ gboolean gnc_sql_do_db_operation (GncSqlBackend* be,
                                   gpointer pObject,
                                   const GncSqlColumnTableEntry* table);
 
+/**
+ * Notes an object's row as it is in the database, unless the backend
+ * already has it.  An UPDATE of the row then only sets the columns whose
+ * values differ from the noted ones, and is skipped if none do.  The
+ * backend also notes each row it inserts or updates.
+ *
+ * @param be SQL backend struct
+ * @param table_name SQL table name
+ * @param obj_name QOF object type name
+ * @param pObject Gnucash object, unchanged since it was last saved
+ * @param table DB table description
+ */
+void gnc_sql_remember_row (GncSqlBackend* be, const gchar* table_name,
+                           QofIdTypeConst obj_name, gpointer pObject,
+                           const GncSqlColumnTableEntry* table);
+
+/**
+ * Checks, without asking the database, whether the backend has noted an
+ * object's row just as it is now.
+ *
+ * @param be SQL backend struct
+ * @param table_name SQL table name
+ * @param obj_name QOF object type name
+ * @param pObject Gnucash object
+ * @param table DB table description
+ * @return TRUE if the row was noted with the object's current values
+ */
+gboolean gnc_sql_row_is_stored (GncSqlBackend* be, const gchar* table_name,
+                                QofIdTypeConst obj_name, gpointer pObject,
+                                const GncSqlColumnTableEntry* table);
+
+/**
+ * Forgets the rows noted by gnc_sql_remember_row() and by writes, for
+ * when the database may no longer match them.
+ *
+ * @param be SQL backend struct
+ */
+void gnc_sql_forget_rows (GncSqlBackend* be);
+
 /**
  * Executes an SQL SELECT statement and returns the result rows.  If an error
  * occurs, an entry is added to the log, an error status is returned to qof and
@@ -467,6 +560,23 @@ gboolean gnc_sql_do_db_operation (GncSqlBackend* be,
 GncSqlResult* gnc_sql_execute_select_statement (GncSqlBackend* be,
                                                 GncSqlStatement* statement);
 
+/**
+ * Executes an SQL SELECT statement whose rows are to be read once, in
+ * order, and returns the result rows.  Where the database allows it, they
+ * are fetched from it a batch at a time as they are read, so that a large
+ * result isn't held in memory all at once; GNC_SQL_FETCH_SIZE sets the
+ * rows in a batch.  The result can't be read over again, and its number
+ * of rows is only those fetched so far.  If an error occurs, an entry is
+ * added to the log, an error status is returned to qof and NULL is
+ * returned.
+ *
+ * @param be SQL backend struct
+ * @param statement Statement
+ * @return Results, or NULL if an error has occured
+ */
+GncSqlResult* gnc_sql_execute_select_statement_streamed (GncSqlBackend* be,
+                                                         GncSqlStatement* statement);
+
 /**
  * Executes an SQL SELECT statement from an SQL char string and returns the
  * result rows.  If an error occurs, an entry is added to the log, an error
@@ -579,6 +689,29 @@ gboolean gnc_sql_create_index (const GncSqlBackend* be,
                                const gchar* index_name,
                                const gchar* table_name, const GncSqlColumnTableEntry* col_table);
 
+/**
+ * Brings the indexes that the loaders and the split query compiler rely on
+ * up to date.  Databases made by older versions may lack some of them; when
+ * the index version recorded in the versions table is out of date, each
+ * missing index is created and the version is then recorded.  Tables which
+ * do not exist yet are skipped.
+ *
+ * @param be SQL backend struct
+ * @return TRUE if all the indexes exist, FALSE if one couldn't be created
+ */
+gboolean gnc_sql_update_indexes (GncSqlBackend* be);
+
+/**
+ * Reports the indexes that the backend expects but which are missing from
+ * the database, regardless of the recorded index version.  Each one is
+ * logged with a warning.
+ *
+ * @param be SQL backend struct
+ * @return List of newly allocated "index (table)" strings, which the caller
+ * must free with g_list_free_full (list, g_free).  NULL if none are missing.
+ */
+GList* gnc_sql_missing_indexes (GncSqlBackend* be);
+
 /**
  * Loads the object guid from a database row.  The table must have a column
  * named "guid" with type CT_GUID.
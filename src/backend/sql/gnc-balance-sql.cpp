@@ -0,0 +1,608 @@
+/********************************************************************
+ * gnc-balance-sql.cpp: load and save data to SQL                   *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+\********************************************************************/
+/** @file gnc-balance-sql.cpp
+ *  @brief keep accounts' balances by month in SQL
+ *
+ * The balances are kept in cells, one for each account and month with
+ * splits.  Every change to them is found by reading the splits being
+ * written before and after the write, so that whatever the write does to
+ * a split, its amount, state, account or transaction's post date, the
+ * cells it leaves and the cells it enters are both right.
+ */
+#include <guid.hpp>
+extern "C"
+{
+#include "config.h"
+
+#include <glib.h>
+
+#include "qof.h"
+#include "AccountP.h"
+#include "gnc-engine.h"
+}
+
+#include "gnc-backend-sql.h"
+#include "gnc-balance-sql.h"
+#include "gnc-transaction-sql.h"
+
+#include <map>
+#include <string>
+#include <utility>
+
+static QofLogModule log_module = G_LOG_DOMAIN;
+
+#define TABLE_NAME "account_balances"
+#define TABLE_VERSION 1
+
+/* A month's cell of an account, keyed by the account's GUID and the
+ * month as yyyymm. */
+typedef std::pair<std::string, gint> CellKey;
+typedef std::map<CellKey, acct_balances_t> CellMap;
+
+struct GncSqlBalanceChange
+{
+    gchar* split_cond;
+    CellMap cells;
+};
+
+typedef struct
+{
+    GncGUID account_guid;
+    gint period;
+    gnc_numeric total;
+    gnc_numeric cleared;
+    gnc_numeric reconciled;
+} balance_cell_t;
+
+typedef struct
+{
+    GncGUID account_guid;
+    char reconcile_state;
+    gnc_numeric quantity;
+    Timespec post_date;
+} split_amount_t;
+
+static gpointer get_cell_account_guid (gpointer pObject);
+static void set_cell_account_guid (gpointer pObject, gpointer pValue);
+static gint get_cell_period (gpointer pObject);
+static void set_cell_period (gpointer pObject, gint value);
+static gnc_numeric get_cell_total (gpointer pObject);
+static void set_cell_total (gpointer pObject, gnc_numeric value);
+static gnc_numeric get_cell_cleared (gpointer pObject);
+static void set_cell_cleared (gpointer pObject, gnc_numeric value);
+static gnc_numeric get_cell_reconciled (gpointer pObject);
+static void set_cell_reconciled (gpointer pObject, gnc_numeric value);
+
+static const GncSqlColumnTableEntry col_table[] =
+{
+    /*# -fullinitblock */
+    {
+        "account_guid", CT_GUID,    0, COL_NNUL, NULL, NULL,
+        (QofAccessFunc)get_cell_account_guid,
+        (QofSetterFunc)set_cell_account_guid
+    },
+    {
+        "period_num",   CT_INT,     0, COL_NNUL, NULL, NULL,
+        (QofAccessFunc)get_cell_period, (QofSetterFunc)set_cell_period
+    },
+    {
+        "total",        CT_NUMERIC, 0, COL_NNUL, NULL, NULL,
+        (QofAccessFunc)get_cell_total, (QofSetterFunc)set_cell_total
+    },
+    {
+        "cleared",      CT_NUMERIC, 0, COL_NNUL, NULL, NULL,
+        (QofAccessFunc)get_cell_cleared, (QofSetterFunc)set_cell_cleared
+    },
+    {
+        "reconciled",   CT_NUMERIC, 0, COL_NNUL, NULL, NULL,
+        (QofAccessFunc)get_cell_reconciled,
+        (QofSetterFunc)set_cell_reconciled
+    },
+    { NULL }
+    /*# +fullinitblock */
+};
+
+static const GncSqlColumnTableEntry cell_index_col_table[] =
+{
+    /*# -fullinitblock */
+    { "account_guid", CT_GUID, 0, 0, NULL, NULL, NULL, NULL },
+    { "period_num",   CT_INT,  0, 0, NULL, NULL, NULL, NULL },
+    { NULL }
+    /*# +fullinitblock */
+};
+
+static void set_split_account_guid (gpointer pObject, gpointer pValue);
+static void set_split_reconcile_state (gpointer pObject, gpointer pValue);
+static void set_split_quantity (gpointer pObject, gnc_numeric value);
+static void set_split_post_date (gpointer pObject, Timespec value);
+
+static const GncSqlColumnTableEntry split_amount_col_table[] =
+{
+    /*# -fullinitblock */
+    {
+        "account_guid",    CT_GUID,     0, 0, NULL, NULL, NULL,
+        (QofSetterFunc)set_split_account_guid
+    },
+    {
+        "reconcile_state", CT_STRING,   1, 0, NULL, NULL, NULL,
+        (QofSetterFunc)set_split_reconcile_state
+    },
+    {
+        "quantity",        CT_NUMERIC,  0, 0, NULL, NULL, NULL,
+        (QofSetterFunc)set_split_quantity
+    },
+    {
+        "post_date",       CT_TIMESPEC, 0, 0, NULL, NULL, NULL,
+        (QofSetterFunc)set_split_post_date
+    },
+    { NULL }
+    /*# +fullinitblock */
+};
+
+/* ================================================================= */
+static gpointer
+get_cell_account_guid (gpointer pObject)
+{
+    balance_cell_t* cell = (balance_cell_t*)pObject;
+
+    g_return_val_if_fail (pObject != NULL, NULL);
+
+    return &cell->account_guid;
+}
+
+static void
+set_cell_account_guid (gpointer pObject, gpointer pValue)
+{
+    balance_cell_t* cell = (balance_cell_t*)pObject;
+
+    g_return_if_fail (pObject != NULL);
+    g_return_if_fail (pValue != NULL);
+
+    cell->account_guid = *(const GncGUID*)pValue;
+}
+
+static gint
+get_cell_period (gpointer pObject)
+{
+    g_return_val_if_fail (pObject != NULL, 0);
+
+    return ((balance_cell_t*)pObject)->period;
+}
+
+static void
+set_cell_period (gpointer pObject, gint value)
+{
+    g_return_if_fail (pObject != NULL);
+
+    ((balance_cell_t*)pObject)->period = value;
+}
+
+static gnc_numeric
+get_cell_total (gpointer pObject)
+{
+    g_return_val_if_fail (pObject != NULL, gnc_numeric_zero ());
+
+    return ((balance_cell_t*)pObject)->total;
+}
+
+static void
+set_cell_total (gpointer pObject, gnc_numeric value)
+{
+    g_return_if_fail (pObject != NULL);
+
+    ((balance_cell_t*)pObject)->total = value;
+}
+
+static gnc_numeric
+get_cell_cleared (gpointer pObject)
+{
+    g_return_val_if_fail (pObject != NULL, gnc_numeric_zero ());
+
+    return ((balance_cell_t*)pObject)->cleared;
+}
+
+static void
+set_cell_cleared (gpointer pObject, gnc_numeric value)
+{
+    g_return_if_fail (pObject != NULL);
+
+    ((balance_cell_t*)pObject)->cleared = value;
+}
+
+static gnc_numeric
+get_cell_reconciled (gpointer pObject)
+{
+    g_return_val_if_fail (pObject != NULL, gnc_numeric_zero ());
+
+    return ((balance_cell_t*)pObject)->reconciled;
+}
+
+static void
+set_cell_reconciled (gpointer pObject, gnc_numeric value)
+{
+    g_return_if_fail (pObject != NULL);
+
+    ((balance_cell_t*)pObject)->reconciled = value;
+}
+
+static void
+set_split_account_guid (gpointer pObject, gpointer pValue)
+{
+    g_return_if_fail (pObject != NULL);
+    g_return_if_fail (pValue != NULL);
+
+    ((split_amount_t*)pObject)->account_guid = *(const GncGUID*)pValue;
+}
+
+static void
+set_split_reconcile_state (gpointer pObject, gpointer pValue)
+{
+    const gchar* s = (const gchar*)pValue;
+
+    g_return_if_fail (pObject != NULL);
+    g_return_if_fail (pValue != NULL);
+
+    ((split_amount_t*)pObject)->reconcile_state = s[0];
+}
+
+static void
+set_split_quantity (gpointer pObject, gnc_numeric value)
+{
+    g_return_if_fail (pObject != NULL);
+
+    ((split_amount_t*)pObject)->quantity = value;
+}
+
+static void
+set_split_post_date (gpointer pObject, Timespec value)
+{
+    g_return_if_fail (pObject != NULL);
+
+    ((split_amount_t*)pObject)->post_date = value;
+}
+
+/* ================================================================= */
+static gboolean
+table_exists (const GncSqlBackend* be)
+{
+    return gnc_sql_get_table_version (be, TABLE_NAME) > 0;
+}
+
+/* The month, as yyyymm in local time, a split posted at t goes in. */
+static gint
+period_of (time64 t)
+{
+    struct tm tm;
+
+    if (gnc_localtime_r (&t, &tm) == NULL)
+        return 0;
+    return (tm.tm_year + 1900) * 100 + tm.tm_mon + 1;
+}
+
+static acct_balances_t*
+find_cell (CellMap& cells, const GncGUID* guid, gint period)
+{
+    gchar guid_buf[GUID_ENCODING_LENGTH + 1];
+
+    (void)guid_to_string_buff (guid, guid_buf);
+    auto iter = cells.emplace (CellKey (guid_buf, period),
+                               acct_balances_t {NULL, gnc_numeric_zero (),
+                                                gnc_numeric_zero (),
+                                                gnc_numeric_zero ()}).first;
+    return &iter->second;
+}
+
+/* Adds the splits matching split_cond to their cells, or takes them off
+ * if negate is TRUE. */
+static gboolean
+add_splits (GncSqlBackend* be, const gchar* split_cond, gboolean negate,
+            CellMap& cells)
+{
+    GncSqlResult* result;
+    gchar* sql;
+
+    sql = g_strdup_printf ("SELECT s.account_guid AS account_guid, "
+                           "s.reconcile_state AS reconcile_state, "
+                           "s.quantity_num AS quantity_num, "
+                           "s.quantity_denom AS quantity_denom, "
+                           "t.post_date AS post_date "
+                           "FROM splits AS s, transactions AS t "
+                           "WHERE s.tx_guid=t.guid AND (%s)", split_cond);
+    result = gnc_sql_execute_select_sql (be, sql);
+    g_free (sql);
+    if (result == NULL)
+        return FALSE;
+
+    for (auto row = gnc_sql_result_get_first_row (result); row != NULL;
+         row = gnc_sql_result_get_next_row (result))
+    {
+        split_amount_t split {*guid_null (), NREC, gnc_numeric_zero (),
+                              {0, 0}};
+
+        gnc_sql_load_object (be, row, NULL, &split, split_amount_col_table);
+        if (negate)
+            split.quantity = gnc_numeric_neg (split.quantity);
+        gnc_sql_add_split_to_balances (find_cell (cells, &split.account_guid,
+                                                  period_of (split.post_date.tv_sec)),
+                                       split.reconcile_state, split.quantity);
+    }
+    gnc_sql_result_dispose (result);
+
+    return TRUE;
+}
+
+static gchar*
+cell_cond (const CellKey& key)
+{
+    return g_strdup_printf ("account_guid='%s' AND period_num=%d",
+                            key.first.c_str (), key.second);
+}
+
+/* Writes a cell, which is left out if it has come to nothing. */
+static gboolean
+insert_cell (GncSqlBackend* be, const CellKey& key, const acct_balances_t& bal)
+{
+    balance_cell_t cell;
+
+    if (gnc_numeric_zero_p (bal.balance) && gnc_numeric_zero_p (bal.cleared_balance)
+        && gnc_numeric_zero_p (bal.reconciled_balance))
+        return TRUE;
+
+    (void)string_to_guid (key.first.c_str (), &cell.account_guid);
+    cell.period = key.second;
+    cell.total = bal.balance;
+    cell.cleared = bal.cleared_balance;
+    cell.reconciled = bal.reconciled_balance;
+    return gnc_sql_do_db_operation (be, OP_DB_INSERT, TABLE_NAME, "", &cell,
+                                    col_table);
+}
+
+/* Adds a change to the cell in the table. */
+static gboolean
+apply_to_cell (GncSqlBackend* be, const CellKey& key, acct_balances_t bal)
+{
+    GncSqlResult* result;
+    gchar* cond = cell_cond (key);
+    gchar* sql;
+    gboolean is_ok;
+
+    sql = g_strdup_printf ("SELECT * FROM %s WHERE %s", TABLE_NAME, cond);
+    result = gnc_sql_execute_select_sql (be, sql);
+    g_free (sql);
+    is_ok = result != NULL;
+    if (is_ok)
+    {
+        auto row = gnc_sql_result_get_first_row (result);
+        if (row != NULL)
+        {
+            balance_cell_t cell;
+
+            gnc_sql_load_object (be, row, NULL, &cell, col_table);
+            gnc_sql_add_split_to_balances (&bal, YREC, cell.reconciled);
+            gnc_sql_add_split_to_balances (&bal, CREC,
+                                           gnc_numeric_sub (cell.cleared,
+                                                            cell.reconciled,
+                                                            GNC_DENOM_AUTO,
+                                                            GNC_HOW_DENOM_LCD));
+            gnc_sql_add_split_to_balances (&bal, NREC,
+                                           gnc_numeric_sub (cell.total,
+                                                            cell.cleared,
+                                                            GNC_DENOM_AUTO,
+                                                            GNC_HOW_DENOM_LCD));
+        }
+        gnc_sql_result_dispose (result);
+
+        sql = g_strdup_printf ("DELETE FROM %s WHERE %s", TABLE_NAME, cond);
+        is_ok = gnc_sql_execute_nonselect_sql (be, sql) >= 0;
+        g_free (sql);
+    }
+    g_free (cond);
+
+    return is_ok && insert_cell (be, key, bal);
+}
+
+/* ================================================================= */
+GncSqlBalanceChange*
+gnc_sql_balances_change_begin (GncSqlBackend* be, const gchar* split_cond)
+{
+    GncSqlBalanceChange* change;
+
+    g_return_val_if_fail (be != NULL, NULL);
+    g_return_val_if_fail (split_cond != NULL, NULL);
+
+    if (!table_exists (be))
+        return NULL;
+
+    change = new GncSqlBalanceChange;
+    change->split_cond = g_strdup (split_cond);
+    (void)add_splits (be, split_cond, /* negate */TRUE, change->cells);
+    return change;
+}
+
+gboolean
+gnc_sql_balances_change_end (GncSqlBackend* be, GncSqlBalanceChange* change,
+                             gboolean write_ok)
+{
+    gboolean is_ok = TRUE;
+
+    g_return_val_if_fail (be != NULL, FALSE);
+
+    if (change == NULL)
+        return TRUE;
+
+    if (write_ok)
+        is_ok = add_splits (be, change->split_cond, /* negate */FALSE,
+                            change->cells);
+    for (auto& entry : change->cells)
+    {
+        const acct_balances_t& bal = entry.second;
+
+        if (!write_ok || !is_ok)
+            break;
+        if (gnc_numeric_zero_p (bal.balance)
+            && gnc_numeric_zero_p (bal.cleared_balance)
+            && gnc_numeric_zero_p (bal.reconciled_balance))
+            continue;
+        is_ok = apply_to_cell (be, entry.first, bal);
+    }
+    g_free (change->split_cond);
+    delete change;
+
+    return is_ok;
+}
+
+gboolean
+gnc_sql_balances_rebuild (GncSqlBackend* be)
+{
+    CellMap cells;
+    gboolean is_ok;
+
+    g_return_val_if_fail (be != NULL, FALSE);
+
+    ENTER ("be=%p", be);
+    is_ok = gnc_sql_connection_begin_transaction (be->conn);
+    if (is_ok)
+    {
+        gchar* sql = g_strdup_printf ("DELETE FROM %s", TABLE_NAME);
+
+        if (table_exists (be))
+            is_ok = gnc_sql_execute_nonselect_sql (be, sql) >= 0;
+        else
+            is_ok = gnc_sql_create_table (be, TABLE_NAME, TABLE_VERSION,
+                                          col_table)
+                    && gnc_sql_create_index (be, "account_balances_index",
+                                             TABLE_NAME, cell_index_col_table);
+        g_free (sql);
+    }
+    if (is_ok)
+        is_ok = add_splits (be, "1=1", /* negate */FALSE, cells);
+    for (auto& entry : cells)
+    {
+        if (!is_ok)
+            break;
+        is_ok = insert_cell (be, entry.first, entry.second);
+    }
+    if (is_ok)
+        is_ok = gnc_sql_connection_commit_transaction (be->conn);
+    if (!is_ok)
+    {
+        PERR ("Unable to rebuild the account balances");
+        if (!qof_backend_check_error ((QofBackend*)be))
+            qof_backend_set_error ((QofBackend*)be, ERR_BACKEND_SERVER_ERR);
+        (void)gnc_sql_connection_rollback_transaction (be->conn);
+    }
+    LEAVE ("");
+
+    return is_ok;
+}
+
+/* The balance before date is that of the months before date's and that
+ * of the splits of date's month posted before it. */
+static gboolean
+balance_as_of (const Account* acc, time64 date, gnc_numeric* balance,
+               gpointer user_data)
+{
+    GncSqlBackend* be = (GncSqlBackend*)user_data;
+    gchar guid_buf[GUID_ENCODING_LENGTH + 1];
+    struct tm tm;
+    gint period = period_of (date);
+    CellMap cells;
+    GncSqlResult* result;
+    gchar* sql;
+    gchar* start_buf;
+    gchar* date_buf;
+    gchar* cond;
+    Timespec ts;
+
+    if (be->loading || !table_exists (be)
+        || gnc_localtime_r (&date, &tm) == NULL)
+        return FALSE;
+
+    (void)guid_to_string_buff (qof_instance_get_guid (QOF_INSTANCE (acc)),
+                               guid_buf);
+    *balance = gnc_numeric_zero ();
+
+    sql = g_strdup_printf ("SELECT * FROM %s WHERE account_guid='%s' "
+                           "AND period_num<%d", TABLE_NAME, guid_buf, period);
+    result = gnc_sql_execute_select_sql (be, sql);
+    g_free (sql);
+    if (result == NULL)
+        return FALSE;
+    for (auto row = gnc_sql_result_get_first_row (result); row != NULL;
+         row = gnc_sql_result_get_next_row (result))
+    {
+        balance_cell_t cell;
+
+        gnc_sql_load_object (be, row, NULL, &cell, col_table);
+        *balance = gnc_numeric_add (*balance, cell.total, GNC_DENOM_AUTO,
+                                    GNC_HOW_DENOM_LCD);
+    }
+    gnc_sql_result_dispose (result);
+
+    start_buf = gnc_sql_convert_timespec_to_string (
+                    be, gnc_dmy2timespec (1, tm.tm_mon + 1, tm.tm_year + 1900));
+    timespecFromTime64 (&ts, date);
+    date_buf = gnc_sql_convert_timespec_to_string (be, ts);
+    cond = g_strdup_printf ("s.account_guid='%s' AND t.post_date>='%s' "
+                            "AND t.post_date<'%s'",
+                            guid_buf, start_buf, date_buf);
+    g_free (start_buf);
+    g_free (date_buf);
+    if (!add_splits (be, cond, /* negate */FALSE, cells))
+    {
+        g_free (cond);
+        return FALSE;
+    }
+    g_free (cond);
+    for (auto& entry : cells)
+        *balance = gnc_numeric_add (*balance, entry.second.balance,
+                                    GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
+
+    return TRUE;
+}
+
+static void
+rebuild (QofBook* book, gpointer user_data)
+{
+    (void)gnc_sql_balances_rebuild ((GncSqlBackend*)user_data);
+}
+
+static const GncBalanceSource balance_source = { balance_as_of, rebuild };
+
+void
+gnc_sql_balances_attach (GncSqlBackend* be)
+{
+    g_return_if_fail (be != NULL);
+    g_return_if_fail (be->book != NULL);
+
+    gnc_book_set_balance_source (be->book, &balance_source, be);
+}
+
+void
+gnc_sql_balances_detach (GncSqlBackend* be)
+{
+    g_return_if_fail (be != NULL);
+
+    if (be->book != NULL)
+        gnc_book_set_balance_source (be->book, NULL, NULL);
+}
+
+/* ========================== END OF FILE ===================== */
@@ -0,0 +1,95 @@
+/********************************************************************
+ * gnc-balance-sql.h: load and save data to SQL                     *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+\********************************************************************/
+/** @file gnc-balance-sql.h
+ *  @brief keep accounts' balances by month in SQL
+ *
+ * The account_balances table holds, for each account and month, the
+ * total, cleared and reconciled amounts of the account's splits posted
+ * in that month.  It is optional: it is made by rebuilding it, from the
+ * Check & Repair of the book's balances, and kept up to date from then
+ * on as transactions and splits are committed.  When transactions are
+ * loaded as needed, the engine takes an account's balance as of a date
+ * from it rather than from the splits in memory.
+ */
+
+#ifndef GNC_BALANCE_SQL_H
+#define GNC_BALANCE_SQL_H
+
+extern "C"
+{
+#include <glib.h>
+#include "qof.h"
+}
+#include "gnc-backend-sql.h"
+
+typedef struct GncSqlBalanceChange GncSqlBalanceChange;
+
+/**
+ * Starts following the change a write makes to the balances, by reading
+ * the splits it is going to write before it does.
+ *
+ * @param be SQL backend
+ * @param split_cond SQL condition on the splits, as "s", which are written
+ * @return The change, or NULL if the database has no balances table
+ */
+GncSqlBalanceChange* gnc_sql_balances_change_begin (GncSqlBackend* be,
+                                                    const gchar* split_cond);
+
+/**
+ * Reads the splits again after the write and, if it succeeded, applies
+ * the difference to the balances table.  Frees the change, which may be
+ * NULL.
+ *
+ * @param be SQL backend
+ * @param change Change from gnc_sql_balances_change_begin
+ * @param write_ok Whether the write succeeded
+ * @return TRUE if successful, FALSE if error
+ */
+gboolean gnc_sql_balances_change_end (GncSqlBackend* be,
+                                      GncSqlBalanceChange* change,
+                                      gboolean write_ok);
+
+/**
+ * Builds the balances table from the splits in the database, making it if
+ * it isn't there.
+ *
+ * @param be SQL backend
+ * @return TRUE if successful, FALSE if error
+ */
+gboolean gnc_sql_balances_rebuild (GncSqlBackend* be);
+
+/**
+ * Lets the engine use the balances table for the backend's book, and
+ * rebuild it.
+ *
+ * @param be SQL backend
+ */
+void gnc_sql_balances_attach (GncSqlBackend* be);
+
+/**
+ * Stops the engine using the balances table, once all of the book's
+ * transactions are in memory or the book is closed.
+ *
+ * @param be SQL backend
+ */
+void gnc_sql_balances_detach (GncSqlBackend* be);
+
+#endif /* GNC_BALANCE_SQL_H */
@@ -186,7 +186,7 @@ create_commodities_tables (GncSqlBackend* be)
 /* ================================================================= */
 static gboolean
 do_commit_commodity (GncSqlBackend* be, QofInstance* inst,
-                     gboolean force_insert)
+                     gboolean force_upsert)
 {
     const GncGUID* guid;
     gboolean is_infant;
@@ -198,7 +198,11 @@ do_commit_commodity (GncSqlBackend* be, QofInstance* inst,
     {
         op = OP_DB_DELETE;
     }
-    else if (be->is_pristine_db || is_infant || force_insert)
+    else if (force_upsert)
+    {
+        op = OP_DB_UPSERT;
+    }
+    else if (be->is_pristine_db || is_infant)
     {
         op = OP_DB_INSERT;
     }
@@ -236,30 +240,24 @@ commit_commodity (GncSqlBackend* be, QofInstance* inst)
     return do_commit_commodity (be, inst, FALSE);
 }
 
-static gboolean
-is_commodity_in_db (GncSqlBackend* be, gnc_commodity* pCommodity)
-{
-    g_return_val_if_fail (be != NULL, FALSE);
-    g_return_val_if_fail (pCommodity != NULL, FALSE);
-
-    return gnc_sql_object_is_it_in_db (be, COMMODITIES_TABLE, GNC_ID_COMMODITY,
-                                       pCommodity, col_table);
-}
-
 gboolean
 gnc_sql_save_commodity (GncSqlBackend* be, gnc_commodity* pCommodity)
 {
-    gboolean is_ok = TRUE;
+    QofInstance* inst = QOF_INSTANCE (pCommodity);
 
     g_return_val_if_fail (be != NULL, FALSE);
     g_return_val_if_fail (pCommodity != NULL, FALSE);
 
-    if (!is_commodity_in_db (be, pCommodity))
-    {
-        is_ok = do_commit_commodity (be, QOF_INSTANCE (pCommodity), TRUE);
-    }
+    /* A commodity committed since the database was loaded or written
+     * has its row.  One that never was, like a currency first used by
+     * this object, may still have been written for another object. */
+    if (!be->is_pristine_db && !qof_instance_get_infant (inst))
+        return TRUE;
+    if (gnc_sql_row_is_stored (be, COMMODITIES_TABLE, GNC_ID_COMMODITY,
+                               pCommodity, col_table))
+        return TRUE;
 
-    return is_ok;
+    return do_commit_commodity (be, inst, TRUE);
 }
 
 void
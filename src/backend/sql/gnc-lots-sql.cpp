@@ -36,6 +36,7 @@ extern "C"
 #include "qof.h"
 #include "Account.h"
 #include "gnc-lot.h"
+#include "gnc-lot-p.h"
 
 #if defined( S_SPLINT_S )
 #include "splint-defs.h"
@@ -105,7 +106,7 @@ load_single_lot (GncSqlBackend* be, GncSqlRow* row)
     g_return_val_if_fail (be != NULL, NULL);
     g_return_val_if_fail (row != NULL, NULL);
 
-    lot = gnc_lot_new (be->book);
+    lot = gnc_lot_new_for_load (be->book, gnc_sql_load_guid (be, row));
 
     gnc_lot_begin_edit (lot);
     gnc_sql_load_object (be, row, GNC_ID_LOT, lot, col_table);
@@ -34,6 +34,7 @@ extern "C"
 
 #include "qof.h"
 #include "gnc-pricedb.h"
+#include "gnc-pricedb-p.h"
 
 #if defined( S_SPLINT_S )
 #include "splint-defs.h"
@@ -76,7 +77,7 @@ load_single_price (GncSqlBackend* be, GncSqlRow* row)
     g_return_val_if_fail (be != NULL, NULL);
     g_return_val_if_fail (row != NULL, NULL);
 
-    pPrice = gnc_price_create (be->book);
+    pPrice = gnc_price_create_for_load (be->book, gnc_sql_load_guid (be, row));
 
     gnc_price_begin_edit (pPrice);
     gnc_sql_load_object (be, row, GNC_ID_PRICE, pPrice, col_table);
@@ -109,18 +110,20 @@ load_all_prices (GncSqlBackend* be)
             gchar* sql;
 
             gnc_pricedb_set_bulk_update (pPriceDB, TRUE);
+            gnc_pricedb_begin_batch (pPriceDB);
             while (row != NULL)
             {
                 pPrice = load_single_price (be, row);
 
                 if (pPrice != NULL)
                 {
-                    (void)gnc_pricedb_add_price (pPriceDB, pPrice);
+                    (void)gnc_pricedb_add_price_compact (pPriceDB, pPrice);
                     gnc_price_unref (pPrice);
                 }
                 row = gnc_sql_result_get_next_row (result);
             }
             gnc_sql_result_dispose (result);
+            gnc_pricedb_end_batch (pPriceDB);
             gnc_pricedb_set_bulk_update (pPriceDB, FALSE);
 
             sql = g_strdup_printf ("SELECT DISTINCT guid FROM %s", TABLE_NAME);
@@ -43,6 +43,11 @@ extern "C"
 #include "gnc-slots-sql.h"
 
 #include <kvp_frame.hpp>
+#include <gnc-guid-map.hpp>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
 
 static QofLogModule log_module = G_LOG_DOMAIN;
 
@@ -92,6 +97,7 @@ static GDate* get_gdate_val (gpointer pObject);
 static void set_gdate_val (gpointer pObject, GDate* value);
 static slot_info_t* slot_info_copy (slot_info_t* pInfo, GncGUID* guid);
 static void slots_load_info (slot_info_t* pInfo);
+static void load_slot (slot_info_t* pInfo, GncSqlRow* row);
 
 #define SLOT_MAX_PATHNAME_LEN 4096
 #define SLOT_MAX_STRINGVAL_LEN 4096
@@ -698,6 +704,184 @@ save_slot (const gchar* key, KvpValue* value, gpointer data)
     (void)g_string_truncate (pSlot_info->path, curlen);
 }
 
+/* ================================================================= */
+/* Saving an object which is already in the database only writes the
+ * slots which changed since it was last saved.  The object's rows are
+ * read back and compared with its slots: the rows of slots which are gone
+ * or changed are deleted, changed and new slots are inserted, and a frame
+ * which is still there keeps its row and its GUID, its own slots compared
+ * in turn.  A list which changed is written again as a whole. */
+struct StoredSlot
+{
+    gint64 id;
+    KvpValue::Type type;
+    GncGUID guid_val;           /* of a frame or a list */
+};
+typedef std::map<std::string, StoredSlot> StoredSlots;
+
+/* Reads the rows of the slots of guid into stored, by name, and the
+ * values of those which aren't frames into values, by key. */
+static gboolean
+read_stored_slots (GncSqlBackend* be, const GncGUID* guid,
+                   StoredSlots& stored, KvpFrame* values)
+{
+    gchar* buf;
+    GncSqlResult* result;
+    gchar guid_buf[GUID_ENCODING_LENGTH + 1];
+    GncSqlStatement* stmt;
+    slot_info_t info = { be, guid, TRUE, values, KvpValue::Type::INVALID, NULL, FRAME, NULL, g_string_new (NULL) };
+
+    (void)guid_to_string_buff (guid, guid_buf);
+    buf = g_strdup_printf ("SELECT * FROM %s WHERE obj_guid='%s'",
+                           TABLE_NAME, guid_buf);
+    stmt = gnc_sql_create_statement_from_sql (be, buf);
+    g_free (buf);
+    result = stmt ? gnc_sql_execute_select_statement (be, stmt) : NULL;
+    if (stmt != NULL)
+        gnc_sql_statement_dispose (stmt);
+    if (result == NULL)
+    {
+        (void)g_string_free (info.path, TRUE);
+        return FALSE;
+    }
+
+    for (GncSqlRow* row = gnc_sql_result_get_first_row (result); row != NULL;
+         row = gnc_sql_result_get_next_row (result))
+    {
+        const GValue* name = gnc_sql_row_get_value_at_col_name (row, "name");
+        const GValue* id = gnc_sql_row_get_value_at_col_name (row, "id");
+        const GValue* type = gnc_sql_row_get_value_at_col_name (row,
+                                                                "slot_type");
+        if (name == NULL || !G_VALUE_HOLDS_STRING (name) || id == NULL ||
+            type == NULL)
+            continue;
+
+        StoredSlot slot {gnc_sql_get_integer_value (id),
+                         static_cast<KvpValue::Type> (gnc_sql_get_integer_value (type)),
+                         *guid_null ()};
+        if (slot.type == KvpValue::Type::FRAME ||
+            slot.type == KvpValue::Type::GLIST)
+        {
+            const GValue* guid_val = gnc_sql_row_get_value_at_col_name (row,
+                                     "guid_val");
+            if (guid_val != NULL && G_VALUE_HOLDS_STRING (guid_val) &&
+                g_value_get_string (guid_val) != NULL)
+                (void)string_to_guid (g_value_get_string (guid_val),
+                                      &slot.guid_val);
+        }
+        if (slot.type != KvpValue::Type::FRAME)
+            load_slot (&info, row);
+        stored[g_value_get_string (name)] = slot;
+    }
+    gnc_sql_result_dispose (result);
+    (void)g_string_free (info.path, TRUE);
+    return TRUE;
+}
+
+static gboolean
+slot_value_unchanged (const KvpValue* stored, const KvpValue* value)
+{
+    if (stored == NULL || stored->get_type () != value->get_type ())
+        return FALSE;
+    /* compare () finds 1/2 and 50/100 equal, the database doesn't. */
+    if (value->get_type () == KvpValue::Type::NUMERIC)
+    {
+        auto one = stored->get<gnc_numeric> ();
+        auto two = value->get<gnc_numeric> ();
+        return one.num == two.num && one.denom == two.denom;
+    }
+    return compare (stored, value) == 0;
+}
+
+/* Writes the changes to the slots of frame, whose rows belong to
+ * pInfo->guid, and collects the ids of the rows to delete. */
+static void
+save_changed_slots (slot_info_t* pInfo, KvpFrame* frame,
+                    std::vector<gint64>& deleted)
+{
+    StoredSlots stored;
+    KvpFrame values;
+
+    if (!read_stored_slots (pInfo->be, pInfo->guid, stored, &values))
+    {
+        pInfo->is_ok = FALSE;
+        return;
+    }
+
+    for (const auto& key : frame->get_keys ())
+    {
+        if (!pInfo->is_ok)
+            return;
+
+        KvpValue* value = frame->get_slot (key.c_str ());
+        std::string name {pInfo->path->str};
+        if (!name.empty ())
+            name += "/";
+        name += key;
+
+        auto slot = stored.find (name);
+        if (slot != stored.end ())
+        {
+            if (slot->second.type == KvpValue::Type::FRAME &&
+                value->get_type () == KvpValue::Type::FRAME)
+            {
+                slot_info_t* pNewInfo = slot_info_copy (pInfo,
+                                                        &slot->second.guid_val);
+                (void)g_string_assign (pNewInfo->path, name.c_str ());
+                save_changed_slots (pNewInfo, value->get<KvpFrame*> (), deleted);
+                pInfo->is_ok = pNewInfo->is_ok;
+                g_string_free (pNewInfo->path, TRUE);
+                g_slice_free (slot_info_t, pNewInfo);
+                stored.erase (slot);
+                continue;
+            }
+            if (slot->second.type == value->get_type () &&
+                slot_value_unchanged (values.get_slot (key.c_str ()), value))
+            {
+                stored.erase (slot);
+                continue;
+            }
+            /* Changed: the old row is deleted below. */
+        }
+        save_slot (key.c_str (), value, pInfo);
+    }
+
+    /* What is left is gone or changed. */
+    for (const auto& slot : stored)
+    {
+        if (!pInfo->is_ok)
+            return;
+        deleted.push_back (slot.second.id);
+        if (slot.second.type == KvpValue::Type::FRAME ||
+            slot.second.type == KvpValue::Type::GLIST)
+            pInfo->is_ok = gnc_sql_slots_delete (pInfo->be,
+                                                 &slot.second.guid_val);
+    }
+}
+
+static gboolean
+delete_slot_rows (GncSqlBackend* be, const std::vector<gint64>& ids)
+{
+    std::string sql;
+
+    for (auto id : ids)
+    {
+        sql += sql.empty () ? std::string {"DELETE FROM "} + TABLE_NAME +
+               " WHERE id IN (" : std::string {","};
+        sql += std::to_string (id);
+    }
+    if (sql.empty ())
+        return TRUE;
+    sql += ")";
+    if (gnc_sql_execute_nonselect_sql (be, sql.c_str ()) == -1)
+    {
+        PERR ("SQL error: %s\n", sql.c_str ());
+        qof_backend_set_error (&be->be, ERR_BACKEND_SERVER_ERR);
+        return FALSE;
+    }
+    return TRUE;
+}
+
 gboolean
 gnc_sql_slots_save (GncSqlBackend* be, const GncGUID* guid, gboolean is_infant,
                     QofInstance* inst)
@@ -709,15 +893,22 @@ gnc_sql_slots_save (GncSqlBackend* be, const GncGUID* guid, gboolean is_infant,
     g_return_val_if_fail (guid != NULL, FALSE);
     g_return_val_if_fail (pFrame != NULL, FALSE);
 
-    // If this is not saving into a new db, clear out the old saved slots first
-    if (!be->is_pristine_db && !is_infant)
-    {
-        (void)gnc_sql_slots_delete (be, guid);
-    }
-
     slot_info.be = be;
     slot_info.guid = guid;
-    pFrame->for_each_slot (save_slot, &slot_info);
+    // If this is not saving into a new db, only write what changed.  That
+    // needs the stored slots read back, which would wait for queued writes.
+    if (!be->is_pristine_db && !is_infant && !be->writes_queued)
+    {
+        std::vector<gint64> deleted;
+
+        save_changed_slots (&slot_info, pFrame, deleted);
+        if (slot_info.is_ok)
+            slot_info.is_ok = delete_slot_rows (be, deleted);
+    }
+    else
+    {
+        pFrame->for_each_slot (save_slot, &slot_info);
+    }
     (void)g_string_free (slot_info.path, TRUE);
 
     return slot_info.is_ok;
@@ -775,6 +966,160 @@ gnc_sql_slots_delete (GncSqlBackend* be, const GncGUID* guid)
     return slot_info.is_ok;
 }
 
+/* ================================================================= */
+/* A bulk load keeps the rows of the slots table in memory, grouped by
+ * obj_guid in the order of their ids, the order they were saved in.
+ * Each row holds copies of the values of the columns below, the names
+ * the column type handlers read them by, and answers to them as a
+ * GncSqlRow would. */
+static const gchar* const cached_col_names[] =
+{
+    "obj_guid", "name", "slot_type", "int64_val", "string_val",
+    "double_val", "timespec_val", "guid_val", "numeric_val_num",
+    "numeric_val_denom", "gdate_val"
+};
+#define N_CACHED_COLS G_N_ELEMENTS (cached_col_names)
+
+struct CachedSlotRow
+{
+    GncSqlRow base;
+    GValue values[N_CACHED_COLS];
+};
+typedef std::vector<CachedSlotRow*> CachedSlotRows;
+
+struct SlotCache
+{
+    GncSqlBackend* be;
+    gboolean read;
+    GncGUIDMap rows;            /* obj_guid -> CachedSlotRows */
+};
+static SlotCache* slot_cache = NULL;
+
+static const GValue*
+cached_row_get_value (GncSqlRow* row, const gchar* col_name)
+{
+    CachedSlotRow* cached = (CachedSlotRow*)row;
+
+    for (guint i = 0; i < N_CACHED_COLS; i++)
+        if (strcmp (col_name, cached_col_names[i]) == 0)
+            return G_IS_VALUE (&cached->values[i]) ? &cached->values[i] : NULL;
+    return NULL;
+}
+
+static void
+cached_row_dispose (GncSqlRow*)
+{
+    /* The cache owns its rows. */
+}
+
+static CachedSlotRow*
+cache_row (GncSqlRow* row)
+{
+    CachedSlotRow* cached = g_new0 (CachedSlotRow, 1);
+
+    cached->base.getValueAtColName = cached_row_get_value;
+    cached->base.dispose = cached_row_dispose;
+    for (guint i = 0; i < N_CACHED_COLS; i++)
+    {
+        const GValue* value = gnc_sql_row_get_value_at_col_name (row,
+                                                                 cached_col_names[i]);
+        if (value != NULL && G_IS_VALUE (value))
+        {
+            g_value_init (&cached->values[i], G_VALUE_TYPE (value));
+            g_value_copy (value, &cached->values[i]);
+        }
+    }
+    return cached;
+}
+
+static void
+free_cached_rows (CachedSlotRows* rows)
+{
+    for (auto cached : *rows)
+    {
+        for (guint i = 0; i < N_CACHED_COLS; i++)
+            if (G_IS_VALUE (&cached->values[i]))
+                g_value_unset (&cached->values[i]);
+        g_free (cached);
+    }
+    delete rows;
+}
+
+static  const GncGUID* load_obj_guid (const GncSqlBackend* be, GncSqlRow* row);
+
+static void
+read_slot_cache (SlotCache* cache)
+{
+    gchar* buf;
+    GncSqlStatement* stmt;
+    GncSqlResult* result;
+
+    buf = g_strdup_printf ("SELECT * FROM %s ORDER BY %s", TABLE_NAME,
+                           col_table[0].col_name);
+    stmt = gnc_sql_create_statement_from_sql (cache->be, buf);
+    g_free (buf);
+    if (stmt == NULL)
+        return;
+    result = gnc_sql_execute_select_statement_streamed (cache->be, stmt);
+    gnc_sql_statement_dispose (stmt);
+    if (result == NULL)
+        return;
+
+    for (GncSqlRow* row = gnc_sql_result_get_first_row (result); row != NULL;
+         row = gnc_sql_result_get_next_row (result))
+    {
+        const GncGUID* guid = load_obj_guid (cache->be, row);
+        auto rows = static_cast<CachedSlotRows*> (cache->rows.lookup (*guid));
+        if (rows == NULL)
+        {
+            rows = new CachedSlotRows;
+            cache->rows.insert (*guid, rows);
+        }
+        rows->push_back (cache_row (row));
+    }
+    gnc_sql_result_dispose (result);
+    cache->read = TRUE;
+}
+
+/* The cached rows of the object, or NULL if its slots have to be queried
+ * for because there is no bulk load going on. */
+static const CachedSlotRows*
+get_cached_rows (GncSqlBackend* be, const GncGUID* guid)
+{
+    static const CachedSlotRows no_rows;
+
+    if (slot_cache == NULL || slot_cache->be != be)
+        return NULL;
+    if (!slot_cache->read)
+        read_slot_cache (slot_cache);
+    if (!slot_cache->read)
+        return NULL;
+    auto rows = static_cast<CachedSlotRows*> (slot_cache->rows.lookup (*guid));
+    return rows ? rows : &no_rows;
+}
+
+void
+gnc_sql_slots_begin_bulk_load (GncSqlBackend* be)
+{
+    g_return_if_fail (be != NULL);
+
+    gnc_sql_slots_end_bulk_load (be);
+    slot_cache = new SlotCache {be, FALSE, {}};
+}
+
+void
+gnc_sql_slots_end_bulk_load (GncSqlBackend* be)
+{
+    if (slot_cache == NULL)
+        return;
+    for (auto rows : slot_cache->rows.values ())
+        free_cached_rows (static_cast<CachedSlotRows*> (rows));
+    delete slot_cache;
+    slot_cache = NULL;
+}
+
+/* ================================================================= */
+
 static void
 load_slot (slot_info_t* pInfo, GncSqlRow* row)
 {
@@ -837,6 +1182,14 @@ slots_load_info (slot_info_t* pInfo)
     g_return_if_fail (pInfo->guid != NULL);
     g_return_if_fail (pInfo->pKvpFrame != NULL);
 
+    auto cached_rows = get_cached_rows (pInfo->be, pInfo->guid);
+    if (cached_rows != NULL)
+    {
+        for (auto cached : *cached_rows)
+            load_slot (pInfo, &cached->base);
+        return;
+    }
+
     (void)guid_to_string_buff (pInfo->guid, guid_buf);
 
     buf = g_strdup_printf ("SELECT * FROM %s WHERE obj_guid='%s'",
@@ -918,6 +1271,17 @@ gnc_sql_slots_load_for_list (GncSqlBackend* be, GList* list)
 
     coll = qof_instance_get_collection (QOF_INSTANCE (list->data));
 
+    if (get_cached_rows (be, qof_instance_get_guid (list->data)) != NULL)
+    {
+        for (GList* node = list; node != NULL; node = node->next)
+        {
+            auto guid = qof_instance_get_guid (node->data);
+            for (auto cached : *get_cached_rows (be, guid))
+                load_slot_for_list_item (be, &cached->base, coll);
+        }
+        return;
+    }
+
     // Create the query for all slots for all items on the list
     sql = g_string_sized_new (40 + (GUID_ENCODING_LENGTH + 3) * g_list_length (
                                   list));
@@ -89,6 +89,17 @@ void gnc_sql_slots_load_for_sql_subquery (GncSqlBackend* be,
                                           const gchar* subquery,
                                           BookLookupFn lookup_fn);
 
+/**
+ * Between these two calls the first load of slots reads the whole slots
+ * table with one query and keeps it in memory, and every load of slots
+ * after it, including those of nested frames and lists, is served from
+ * there.  gnc_sql_load uses them around loading the book.
+ *
+ * @param be SQL backend
+ */
+void gnc_sql_slots_begin_bulk_load (GncSqlBackend* be);
+void gnc_sql_slots_end_bulk_load (GncSqlBackend* be);
+
 void gnc_sql_init_slots_handler (void);
 
 #endif /* GNC_SLOTS_SQL_H */
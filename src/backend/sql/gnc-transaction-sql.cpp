@@ -37,7 +37,9 @@ extern "C"
 #include "qofquerycore-p.h"
 
 #include "Account.h"
+#include "AccountP.h"
 #include "Transaction.h"
+#include "TransactionP.h"
 #include <Scrub.h>
 #include "gnc-lot.h"
 #include "engine-helpers.h"
@@ -55,9 +57,10 @@ extern "C"
 #include "gnc-transaction-sql.h"
 #include "gnc-commodity-sql.h"
 #include "gnc-slots-sql.h"
+#include "gnc-balance-sql.h"
 
-#define SIMPLE_QUERY_COMPILATION 1
-#define LOAD_TRANSACTIONS_AS_NEEDED 0
+#include <cmath>
+#include <unordered_map>
 
 static QofLogModule log_module = G_LOG_DOMAIN;
 
@@ -205,7 +208,7 @@ load_single_split (GncSqlBackend* be, GncSqlRow* row)
 
     if (pSplit == NULL)
     {
-        pSplit = xaccMallocSplit (be->book);
+        pSplit = xaccMallocSplitForLoad (be->book, &split_guid);
     }
 
     /* If the split is dirty, don't overwrite it */
@@ -230,6 +233,7 @@ static void
 load_splits_for_tx_list (GncSqlBackend* be, GList* list)
 {
     GString* sql;
+    GncSqlStatement* stmt;
     GncSqlResult* result;
 
     g_return_if_fail (be != NULL);
@@ -244,7 +248,12 @@ load_splits_for_tx_list (GncSqlBackend* be, GList* list)
     (void)g_string_append (sql, ")");
 
     // Execute the query and load the splits
-    result = gnc_sql_execute_select_sql (be, sql->str);
+    stmt = gnc_sql_create_statement_from_sql (be, sql->str);
+    (void)g_string_free (sql, TRUE);
+    if (stmt == NULL)
+        return;
+    result = gnc_sql_execute_select_statement_streamed (be, stmt);
+    gnc_sql_statement_dispose (stmt);
     if (result != NULL)
     {
         GList* split_list = NULL;
@@ -270,7 +279,6 @@ load_splits_for_tx_list (GncSqlBackend* be, GList* list)
 
         gnc_sql_result_dispose (result);
     }
-    (void)g_string_free (sql, TRUE);
 }
 
 static  Transaction*
@@ -294,7 +302,7 @@ load_single_tx (GncSqlBackend* be, GncSqlRow* row)
         return NULL;
     }
 
-    pTx = xaccMallocTransaction (be->book);
+    pTx = xaccMallocTransactionForLoad (be->book, &tx_guid);
     xaccTransBeginEdit (pTx);
     gnc_sql_load_object (be, row, GNC_ID_TRANS, pTx, tx_col_table);
 
@@ -310,22 +318,334 @@ load_single_tx (GncSqlBackend* be, GncSqlRow* row)
     return pTx;
 }
 
+gboolean
+gnc_sql_load_transactions_as_needed (void)
+{
+    return g_getenv ("GNC_SQL_LOAD_AS_NEEDED") != NULL;
+}
+
+void
+gnc_sql_add_split_to_balances (acct_balances_t* bal, char reconcile_state,
+                               gnc_numeric amount)
+{
+    bal->balance = gnc_numeric_add (bal->balance, amount,
+                                    GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
+    if (reconcile_state != NREC)
+        bal->cleared_balance = gnc_numeric_add (bal->cleared_balance, amount,
+                                                GNC_DENOM_AUTO,
+                                                GNC_HOW_DENOM_LCD);
+    if (reconcile_state == YREC || reconcile_state == FREC)
+        bal->reconciled_balance = gnc_numeric_add (bal->reconciled_balance,
+                                                   amount, GNC_DENOM_AUTO,
+                                                   GNC_HOW_DENOM_LCD);
+}
+
 /**
- * Structure to hold start/end balances for each account.  The values are
- * saved before splits are loaded, and then used to adjust the start balances
- * so that the end balances (which are calculated and correct on initial load)
- * are unchanged.
+ * When transactions are loaded as needed, an account's starting balances
+ * are those of the splits still in the database: they start out as the
+ * balances of all of its splits, the splits of newly loaded transactions
+ * are taken off them and those of evicted ones put back, so that its
+ * ending balances don't change.
+ *
+ * @param tx_list Newly loaded, or about to be evicted, transactions
+ * @param take_off TRUE if loaded, FALSE if evicted
  */
-typedef struct
+static void
+move_splits_on_start_balances (GList* tx_list, gboolean take_off)
+{
+    std::unordered_map<Account*, acct_balances_t> loaded;
+
+    for (GList* node = tx_list; node != NULL; node = node->next)
+    {
+        for (GList* snode = xaccTransGetSplitList (GNC_TRANSACTION (node->data));
+             snode != NULL; snode = snode->next)
+        {
+            Split* split = GNC_SPLIT (snode->data);
+            Account* acc = xaccSplitGetAccount (split);
+            if (acc == NULL)
+                continue;
+
+            auto bal = loaded.find (acc);
+            if (bal == loaded.end ())
+                bal = loaded.emplace (acc, acct_balances_t {acc,
+                                      gnc_numeric_zero (), gnc_numeric_zero (),
+                                      gnc_numeric_zero ()}).first;
+            gnc_numeric amount = xaccSplitGetAmount (split);
+            gnc_sql_add_split_to_balances (&bal->second,
+                                           xaccSplitGetReconcile (split),
+                                           take_off ? gnc_numeric_neg (amount)
+                                           : amount);
+        }
+    }
+
+    for (auto& entry : loaded)
+    {
+        acct_balances_t* bal = &entry.second;
+        gnc_numeric* start_bal;
+        gnc_numeric* start_c_bal;
+        gnc_numeric* start_r_bal;
+
+        g_object_get (bal->acct,
+                      "start-balance", &start_bal,
+                      "start-cleared-balance", &start_c_bal,
+                      "start-reconciled-balance", &start_r_bal,
+                      NULL);
+        bal->balance = gnc_numeric_add (*start_bal, bal->balance,
+                                        GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
+        bal->cleared_balance = gnc_numeric_add (*start_c_bal,
+                                                bal->cleared_balance,
+                                                GNC_DENOM_AUTO,
+                                                GNC_HOW_DENOM_LCD);
+        bal->reconciled_balance = gnc_numeric_add (*start_r_bal,
+                                                   bal->reconciled_balance,
+                                                   GNC_DENOM_AUTO,
+                                                   GNC_HOW_DENOM_LCD);
+        g_free (start_bal);
+        g_free (start_c_bal);
+        g_free (start_r_bal);
+
+        qof_instance_increase_editlevel (bal->acct);
+        g_object_set (bal->acct,
+                      "start-balance", &bal->balance,
+                      "start-cleared-balance", &bal->cleared_balance,
+                      "start-reconciled-balance", &bal->reconciled_balance,
+                      NULL);
+        qof_instance_decrease_editlevel (bal->acct);
+        xaccAccountRecomputeBalance (bal->acct);
+    }
+}
+
+/* ----------------------------------------------------------------- */
+/* The transactions loaded as needed, most recently used first.  Those
+ * created in this session aren't in it and stay in memory, as do those
+ * with splits in lots, which the lots hold on to. */
+struct GncSqlTxCache
+{
+    GQueue lru;
+    GHashTable* links;  /* Transaction* -> its link in lru */
+    guint budget;       /* 0 for no limit */
+    gint loading;       /* query_transactions() is running */
+};
+
+static void
+cache_use (GncSqlTxCache* cache, Transaction* tx)
+{
+    GList* link = static_cast<GList*> (g_hash_table_lookup (cache->links, tx));
+
+    if (link == NULL)
+    {
+        g_queue_push_head (&cache->lru, tx);
+        g_hash_table_insert (cache->links, tx, cache->lru.head);
+    }
+    else if (link != cache->lru.head)
+    {
+        g_queue_unlink (&cache->lru, link);
+        g_queue_push_head_link (&cache->lru, link);
+    }
+}
+
+static void
+cache_forget (GncSqlTxCache* cache, Transaction* tx)
+{
+    GList* link = static_cast<GList*> (g_hash_table_lookup (cache->links, tx));
+
+    if (link == NULL)
+        return;
+    g_queue_delete_link (&cache->lru, link);
+    g_hash_table_remove (cache->links, tx);
+}
+
+static void
+cache_add (GncSqlBackend* be, GList* tx_list)
+{
+    if (be->tx_cache == NULL)
+        return;
+    for (GList* node = tx_list; node != NULL; node = node->next)
+        cache_use (be->tx_cache, GNC_TRANSACTION (node->data));
+}
+
+/* Clean, closed and held by nothing but the engine, as far as reference
+ * counts tell. */
+static gboolean
+tx_evictable (Transaction* tx)
+{
+    if (xaccTransIsOpen (tx) || qof_instance_is_dirty (QOF_INSTANCE (tx)) ||
+        G_OBJECT (tx)->ref_count > 1)
+        return FALSE;
+    for (GList* node = xaccTransGetSplitList (tx); node != NULL;
+         node = node->next)
+    {
+        Split* split = GNC_SPLIT (node->data);
+        if (xaccSplitGetLot (split) != NULL ||
+            qof_instance_get_dirty_flag (split) ||
+            G_OBJECT (split)->ref_count > 1)
+            return FALSE;
+    }
+    return TRUE;
+}
+
+static void query_transactions (GncSqlBackend* be, GncSqlStatement* stmt);
+
+/**
+ * Takes the least recently used transactions that can go out of memory
+ * until no more than the budget are left, putting their splits back on
+ * their accounts' starting balances first.  The engine's commits of the
+ * evictions are ignored like those of a load.
+ *
+ * @param be SQL backend
+ */
+static void
+cache_evict (GncSqlBackend* be)
+{
+    GncSqlTxCache* cache = be->tx_cache;
+    GList* victims = NULL;
+    guint n_left;
+    gboolean loading;
+
+    if (cache == NULL || cache->budget == 0 || cache->loading > 0 ||
+        cache->lru.length <= cache->budget)
+        return;
+
+    n_left = cache->lru.length;
+    for (GList* link = cache->lru.tail; link != NULL && n_left > cache->budget;
+         link = link->prev)
+    {
+        Transaction* tx = GNC_TRANSACTION (link->data);
+        if (!tx_evictable (tx))
+            continue;
+        victims = g_list_prepend (victims, tx);
+        n_left--;
+    }
+    if (victims == NULL)
+        return;
+
+    ENTER ("evicting %u of %u transactions", g_list_length (victims),
+           cache->lru.length);
+    move_splits_on_start_balances (victims, FALSE);
+    loading = be->loading;
+    be->loading = TRUE;
+    for (GList* node = victims; node != NULL; node = node->next)
+    {
+        Transaction* tx = GNC_TRANSACTION (node->data);
+        cache_forget (cache, tx);
+        xaccTransEvict (tx);
+    }
+    be->loading = loading;
+    g_list_free (victims);
+    LEAVE ("");
+}
+
+static Transaction*
+cache_load (GncSqlBackend* be, const gchar* sql, const GncGUID* guid,
+            QofIdTypeConst type)
+{
+    GncSqlStatement* stmt;
+    QofInstance* inst;
+
+    stmt = gnc_sql_create_statement_from_sql (be, sql);
+    if (stmt == NULL)
+        return NULL;
+    query_transactions (be, stmt);
+    gnc_sql_statement_dispose (stmt);
+
+    inst = qof_collection_lookup_entity (qof_book_get_collection (be->book,
+                                                                  type), guid);
+    if (inst == NULL)
+        return NULL;
+    if (GNC_IS_SPLIT (inst))
+        return xaccSplitGetParent (GNC_SPLIT (inst));
+    return GNC_TRANSACTION (inst);
+}
+
+/* Lookups by GUID while a load is running are the load's own, for
+ * objects it hasn't made yet. */
+static Transaction*
+source_load_trans (QofBook* book, const GncGUID* guid, gpointer user_data)
+{
+    GncSqlBackend* be = static_cast<GncSqlBackend*> (user_data);
+    gchar guid_buf[GUID_ENCODING_LENGTH + 1];
+    gchar* sql;
+    Transaction* tx;
+
+    if (be->loading || be->tx_cache == NULL || be->tx_cache->loading > 0)
+        return NULL;
+    (void)guid_to_string_buff (guid, guid_buf);
+    sql = g_strdup_printf ("SELECT * FROM %s WHERE guid='%s'",
+                           TRANSACTION_TABLE, guid_buf);
+    tx = cache_load (be, sql, guid, GNC_ID_TRANS);
+    g_free (sql);
+    return tx;
+}
+
+static Transaction*
+source_load_split (QofBook* book, const GncGUID* guid, gpointer user_data)
+{
+    GncSqlBackend* be = static_cast<GncSqlBackend*> (user_data);
+    gchar guid_buf[GUID_ENCODING_LENGTH + 1];
+    gchar* sql;
+    Transaction* tx;
+
+    if (be->loading || be->tx_cache == NULL || be->tx_cache->loading > 0)
+        return NULL;
+    (void)guid_to_string_buff (guid, guid_buf);
+    sql = g_strdup_printf ("SELECT t.* FROM %s AS t, %s AS s "
+                           "WHERE s.tx_guid=t.guid AND s.guid='%s'",
+                           TRANSACTION_TABLE, SPLIT_TABLE, guid_buf);
+    tx = cache_load (be, sql, guid, GNC_ID_SPLIT);
+    g_free (sql);
+    return tx;
+}
+
+static void
+source_used (Transaction* tx, gpointer user_data)
+{
+    GncSqlBackend* be = static_cast<GncSqlBackend*> (user_data);
+
+    if (be->tx_cache != NULL &&
+        g_hash_table_lookup (be->tx_cache->links, tx) != NULL)
+        cache_use (be->tx_cache, tx);
+}
+
+static const GncTransSource trans_source =
+{
+    source_load_trans,
+    source_load_split,
+    source_used
+};
+
+void
+gnc_sql_transaction_cache_attach (GncSqlBackend* be)
+{
+    const gchar* budget;
+
+    g_return_if_fail (be != NULL);
+    g_return_if_fail (be->book != NULL);
+
+    if (!gnc_sql_load_transactions_as_needed () || be->tx_cache != NULL)
+        return;
+    be->tx_cache = g_new0 (GncSqlTxCache, 1);
+    g_queue_init (&be->tx_cache->lru);
+    be->tx_cache->links = g_hash_table_new (g_direct_hash, g_direct_equal);
+    budget = g_getenv ("GNC_SQL_MAX_LOADED_TRANSACTIONS");
+    if (budget != NULL)
+        be->tx_cache->budget = (guint)g_ascii_strtoull (budget, NULL, 10);
+    gnc_book_set_trans_source (be->book, &trans_source, be);
+}
+
+void
+gnc_sql_transaction_cache_detach (GncSqlBackend* be)
 {
-    Account* acc;
-    gnc_numeric start_bal;
-    gnc_numeric end_bal;
-    gnc_numeric start_cleared_bal;
-    gnc_numeric end_cleared_bal;
-    gnc_numeric start_reconciled_bal;
-    gnc_numeric end_reconciled_bal;
-} full_acct_balances_t;
+    g_return_if_fail (be != NULL);
+
+    if (be->tx_cache == NULL)
+        return;
+    if (be->book != NULL)
+        gnc_book_set_trans_source (be->book, NULL, NULL);
+    g_queue_clear (&be->tx_cache->lru);
+    g_hash_table_destroy (be->tx_cache->links);
+    g_free (be->tx_cache);
+    be->tx_cache = NULL;
+}
 
 /**
  * Executes a transaction query statement and loads the transactions and all
@@ -342,27 +662,15 @@ query_transactions (GncSqlBackend* be, GncSqlStatement* stmt)
     g_return_if_fail (be != NULL);
     g_return_if_fail (stmt != NULL);
 
-    result = gnc_sql_execute_select_statement (be, stmt);
+    if (be->tx_cache != NULL)
+        be->tx_cache->loading++;
+    result = gnc_sql_execute_select_statement_streamed (be, stmt);
     if (result != NULL)
     {
         GList* tx_list = NULL;
         GList* node;
         GncSqlRow* row;
         Transaction* tx;
-#if LOAD_TRANSACTIONS_AS_NEEDED
-        GSList* bal_list = NULL;
-        GSList* nextbal;
-        Account* root = gnc_book_get_root_account (be->book);
-
-        qof_event_suspend ();
-        xaccAccountBeginEdit (root);
-
-        // Save the start/ending balances (balance, cleared and reconciled) for
-        // every account.
-        gnc_account_foreach_descendant (gnc_book_get_root_account (be->primary_book),
-                                        save_account_balances,
-                                        &bal_list);
-#endif
 
         // Load the transactions
         row = gnc_sql_result_get_first_row (result);
@@ -390,73 +698,16 @@ query_transactions (GncSqlBackend* be, GncSqlStatement* stmt)
         {
             Transaction* pTx = GNC_TRANSACTION (node->data);
             xaccTransCommitEdit (pTx);
+            xaccTransScrubForgetModified (pTx);
         }
+        if (gnc_sql_load_transactions_as_needed ())
+            move_splits_on_start_balances (tx_list, TRUE);
+        cache_add (be, tx_list);
         g_list_free (tx_list);
-
-#if LOAD_TRANSACTIONS_AS_NEEDED
-        // Update the account balances based on the loaded splits.  If the end
-        // balance has changed, update the start balance so that the end
-        // balance is the same as it was before the splits were loaded.
-        // Repeat for cleared and reconciled balances.
-        for (nextbal = bal_list; nextbal != NULL; nextbal = nextbal->next)
-        {
-            full_acct_balances_t* balns = (full_acct_balances_t*)nextbal->data;
-            gnc_numeric* pnew_end_bal;
-            gnc_numeric* pnew_end_c_bal;
-            gnc_numeric* pnew_end_r_bal;
-            gnc_numeric adj;
-
-            g_object_get (balns->acc,
-                          "end-balance", &pnew_end_bal,
-                          "end-cleared-balance", &pnew_end_c_bal,
-                          "end-reconciled-balance", &pnew_end_r_bal,
-                          NULL);
-
-            qof_instance_increase_editlevel (balns - acc);
-            if (!gnc_numeric_eq (*pnew_end_bal, balns->end_bal))
-            {
-                adj = gnc_numeric_sub (balns->end_bal, *pnew_end_bal,
-                                       GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
-                balns->start_bal = gnc_numeric_add (balns->start_bal, adj,
-                                                    GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
-                g_object_set (balns->acc, "start-balance", &balns->start_bal, NULL);
-                qof_instance_decrease_editlevel (balns - acc);
-            }
-            if (!gnc_numeric_eq (*pnew_end_c_bal, balns->end_cleared_bal))
-            {
-                adj = gnc_numeric_sub (balns->end_cleared_bal, *pnew_end_c_bal,
-                                       GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
-                balns->start_cleared_bal = gnc_numeric_add (balns->start_cleared_bal, adj,
-                                                            GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
-                g_object_set (balns->acc, "start-cleared-balance", &balns->start_cleared_bal,
-                              NULL);
-            }
-            if (!gnc_numeric_eq (*pnew_end_r_bal, balns->end_reconciled_bal))
-            {
-                adj = gnc_numeric_sub (balns->end_reconciled_bal, *pnew_end_r_bal,
-                                       GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
-                balns->start_reconciled_bal = gnc_numeric_add (balns->start_reconciled_bal,
-                                                               adj,
-                                                               GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
-                g_object_set (balns->acc, "start-reconciled-balance",
-                              &balns->start_reconciled_bal, NULL);
-            }
-            qof_instance_decrease_editlevel (balns - acc);
-            xaccAccountRecomputeBalance (balns->acc);
-            g_free (pnew_end_bal);
-            g_free (pnew_end_c_bal);
-            g_free (pnew_end_r_bal);
-            g_free (balns);
-        }
-        if (bal_list != NULL)
-        {
-            g_slist_free (bal_list);
-        }
-
-        xaccAccountCommitEdit (root);
-        qof_event_resume ();
-#endif
     }
+    if (be->tx_cache != NULL)
+        be->tx_cache->loading--;
+    cache_evict (be);
 }
 
 /* ================================================================= */
@@ -641,6 +892,27 @@ commit_split (GncSqlBackend* be, QofInstance* inst)
     return is_ok;
 }
 
+/* A split committed by the engine on its own; those written along with
+ * their transaction are followed by the transaction's commit. */
+static gboolean
+commit_split_balances (GncSqlBackend* be, QofInstance* inst)
+{
+    gchar guid_buf[GUID_ENCODING_LENGTH + 1];
+    gchar* cond;
+    GncSqlBalanceChange* change;
+    gboolean is_ok;
+
+    g_return_val_if_fail (inst != NULL, FALSE);
+    g_return_val_if_fail (be != NULL, FALSE);
+
+    (void)guid_to_string_buff (qof_instance_get_guid (inst), guid_buf);
+    cond = g_strdup_printf ("s.guid='%s'", guid_buf);
+    change = gnc_sql_balances_change_begin (be, cond);
+    g_free (cond);
+    is_ok = commit_split (be, inst);
+    return gnc_sql_balances_change_end (be, change, is_ok) && is_ok;
+}
+
 static void
 save_split_cb (gpointer data, gpointer user_data)
 {
@@ -795,14 +1067,91 @@ gnc_sql_save_transaction (GncSqlBackend* be, QofInstance* inst)
     return save_transaction (be, GNC_TRANS (inst), /* do_save_splits */TRUE);
 }
 
+static void
+save_dirty_split_cb (gpointer data, gpointer user_data)
+{
+    split_info_t* split_info = (split_info_t*)user_data;
+    QofInstance* inst = QOF_INSTANCE (data);
+
+    if (!split_info->is_ok || !qof_instance_get_dirty_flag (inst) ||
+        qof_instance_get_destroying (inst))
+        return;
+    split_info->is_ok = commit_split (split_info->be, inst);
+}
+
+static void
+mark_split_clean_cb (gpointer data, gpointer user_data)
+{
+    QofInstance* inst = QOF_INSTANCE (data);
+
+    if (!qof_instance_get_destroying (inst))
+        qof_instance_mark_clean (inst);
+}
+
+/* The engine commits a transaction's splits one by one after the
+ * transaction, each in a database transaction, and so in SQLite a sync
+ * to disk, of its own.  The changed splits are written here instead, in
+ * the transaction's, and marked clean so that their own commits have
+ * nothing left to do.  Splits being deleted are still left to those. */
 static gboolean
 commit_transaction (GncSqlBackend* be, QofInstance* inst)
 {
+    Transaction* pTx = GNC_TRANS (inst);
+    split_info_t split_info;
+    gchar guid_buf[GUID_ENCODING_LENGTH + 1];
+    gchar* cond;
+    GncSqlBalanceChange* change;
+
     g_return_val_if_fail (be != NULL, FALSE);
     g_return_val_if_fail (inst != NULL, FALSE);
     g_return_val_if_fail (GNC_IS_TRANS (inst), FALSE);
 
-    return save_transaction (be, GNC_TRANS (inst), /* do_save_splits */FALSE);
+    if (be->tx_cache != NULL && qof_instance_get_destroying (inst))
+        cache_forget (be->tx_cache, pTx);
+
+    (void)guid_to_string_buff (qof_instance_get_guid (inst), guid_buf);
+    cond = g_strdup_printf ("s.tx_guid='%s'", guid_buf);
+    change = gnc_sql_balances_change_begin (be, cond);
+    g_free (cond);
+
+    split_info.be = be;
+    split_info.guid = qof_instance_get_guid (inst);
+    split_info.is_ok = save_transaction (be, pTx, /* do_save_splits */FALSE);
+    if (split_info.is_ok && !qof_instance_get_destroying (inst))
+    {
+        g_list_foreach (xaccTransGetSplitList (pTx), save_dirty_split_cb,
+                        &split_info);
+        if (split_info.is_ok)
+            g_list_foreach (xaccTransGetSplitList (pTx), mark_split_clean_cb,
+                            NULL);
+    }
+    return gnc_sql_balances_change_end (be, change, split_info.is_ok)
+           && split_info.is_ok;
+}
+
+/* The engine changes a transaction's splits without editing them, so
+ * their rows are noted along with the transaction's. */
+static void
+begin_edit_transaction (GncSqlBackend* be, QofInstance* inst)
+{
+    GList* node;
+
+    g_return_if_fail (be != NULL);
+    g_return_if_fail (inst != NULL);
+    g_return_if_fail (GNC_IS_TRANS (inst));
+
+    gnc_sql_remember_row (be, TRANSACTION_TABLE, GNC_ID_TRANS, inst,
+                          tx_col_table);
+    for (node = xaccTransGetSplitList (GNC_TRANS (inst)); node != NULL;
+         node = node->next)
+    {
+        QofInstance* split = QOF_INSTANCE (node->data);
+
+        if (!qof_instance_get_infant (split) &&
+            !qof_instance_get_dirty_flag (split))
+            gnc_sql_remember_row (be, SPLIT_TABLE, GNC_ID_SPLIT, split,
+                                  split_col_table);
+    }
 }
 
 /* ================================================================= */
@@ -860,6 +1209,15 @@ void gnc_sql_transaction_load_all_tx (GncSqlBackend* be)
     }
 }
 
+/* Loads every transaction when the book is opened, unless they're to be
+ * loaded as needed. */
+static void
+load_transactions (GncSqlBackend* be)
+{
+    if (!gnc_sql_load_transactions_as_needed ())
+        gnc_sql_transaction_load_all_tx (be);
+}
+
 static void
 convert_query_comparison_to_sql (QofQueryPredData* pPredData,
                                  gboolean isInverted, GString* sql)
@@ -1044,6 +1402,7 @@ convert_query_term_to_sql (const GncSqlBackend* be, const gchar* fieldName,
 
             datebuf = gnc_sql_convert_timespec_to_string (be, date_data->date);
             g_string_append_printf (sql, "'%s'", datebuf);
+            g_free (datebuf);
 
         }
         else if (strcmp (pPredData->type_name, QOF_TYPE_INT32) == 0)
@@ -1089,179 +1448,344 @@ typedef struct
     gboolean has_been_run;
 } split_query_info_t;
 
-#define TX_GUID_CHECK 0
+/* Appends a GUID term, unless its list is empty, which SQL can't say. */
+static gboolean
+append_guid_term (const GncSqlBackend* be, const gchar* col_name,
+                  QofQueryTerm* term, GString* sql)
+{
+    query_guid_t guid_data = (query_guid_t)qof_query_term_get_pred_data (term);
 
-G_GNUC_UNUSED static  gpointer
-compile_split_query (GncSqlBackend* be, QofQuery* query)
+    if ((guid_data->options != QOF_GUID_MATCH_ANY &&
+         guid_data->options != QOF_GUID_MATCH_NONE) || guid_data->guids == NULL)
+        return FALSE;
+    convert_query_term_to_sql (be, col_name, term, sql);
+    return TRUE;
+}
+
+/* The engine compares the absolute value with the amount, equal meaning
+ * within 1/10000, and may also want only debits or credits.  The SQL
+ * compares in floating point, so it is widened by a little more than
+ * that can be out, and only ever loads too much. */
+static gboolean
+append_numeric_term (const gchar* col_prefix, QofQueryTerm* term,
+                     GString* sql)
 {
-    split_query_info_t* query_info = NULL;
-    gchar* query_sql;
+    QofQueryPredData* pPredData = qof_query_term_get_pred_data (term);
+    query_numeric_t numeric_data = (query_numeric_t)pPredData;
+    double amount = gnc_numeric_to_double (numeric_data->amount);
+    double slack = 1e-9 * (1.0 + fabs (amount));
+    gchar low[G_ASCII_DTOSTR_BUF_SIZE];
+    gchar high[G_ASCII_DTOSTR_BUF_SIZE];
+
+    /* An inverted term matches the other sign too. */
+    if (qof_query_term_is_inverted (term) ||
+        pPredData->how == QOF_COMPARE_NEQ)
+        return FALSE;
 
-    g_return_val_if_fail (be != NULL, NULL);
-    g_return_val_if_fail (query != NULL, NULL);
+    g_string_append (sql, "(");
+    if (numeric_data->options == QOF_NUMERIC_MATCH_CREDIT)
+        g_string_append_printf (sql, "%s_num<=0 AND ", col_prefix);
+    else if (numeric_data->options == QOF_NUMERIC_MATCH_DEBIT)
+        g_string_append_printf (sql, "%s_num>=0 AND ", col_prefix);
 
-    query_info = static_cast<decltype (query_info)> (
-                     g_malloc (sizeof (split_query_info_t)));
-    g_assert (query_info != NULL);
-    query_info->has_been_run = FALSE;
+    /* Multiplied out, as a denominator of zero can't be divided by. */
+    g_string_append_printf (sql, "(%s_denom<=0 OR ", col_prefix);
+    switch (pPredData->how)
+    {
+    case QOF_COMPARE_LT:
+    case QOF_COMPARE_LTE:
+        (void)g_ascii_dtostr (high, sizeof (high), amount + slack);
+        g_string_append_printf (sql, "ABS(%s_num)<=%s*%s_denom",
+                                col_prefix, high, col_prefix);
+        break;
+    case QOF_COMPARE_GT:
+    case QOF_COMPARE_GTE:
+        (void)g_ascii_dtostr (low, sizeof (low), amount - slack);
+        g_string_append_printf (sql, "ABS(%s_num)>=%s*%s_denom",
+                                col_prefix, low, col_prefix);
+        break;
+    default:
+        (void)g_ascii_dtostr (low, sizeof (low), fabs (amount) - 1e-4 - slack);
+        (void)g_ascii_dtostr (high, sizeof (high), fabs (amount) + 1e-4 + slack);
+        g_string_append_printf (sql, "ABS(%s_num) BETWEEN %s*%s_denom AND %s*%s_denom",
+                                col_prefix, low, col_prefix, high, col_prefix);
+        break;
+    }
+    g_string_append (sql, "))");
+    return TRUE;
+}
+
+/* Appends a string term as LIKE, which is as strict as the engine or,
+ * with a case-insensitive collation, less so.  Regular expressions differ
+ * between the databases and aren't translated, nor are case-insensitive
+ * matches other than of ASCII, nor those which an empty or missing
+ * string would satisfy. */
+static gboolean
+append_string_term (const GncSqlBackend* be, const gchar* col_name,
+                    QofQueryTerm* term, GString* sql)
+{
+    QofQueryPredData* pPredData = qof_query_term_get_pred_data (term);
+    query_string_t string_data = (query_string_t)pPredData;
+    gboolean nocase = string_data->options == QOF_STRING_MATCH_CASEINSENSITIVE;
+    const gchar* match = string_data->matchstring;
+    GString* pattern;
+    gchar* quoted;
+
+    if (string_data->is_regex || qof_query_term_is_inverted (term) ||
+        match == NULL || *match == '\0' ||
+        (pPredData->how != QOF_COMPARE_EQUAL &&
+         pPredData->how != QOF_COMPARE_CONTAINS) ||
+        (nocase && (pPredData->how != QOF_COMPARE_CONTAINS ||
+                    !g_str_is_ascii (match))))
+        return FALSE;
+
+    pattern = g_string_new (pPredData->how == QOF_COMPARE_CONTAINS ? "%" : "");
+    for (const gchar* c = match; *c != '\0'; c++)
+    {
+        if (*c == '!' || *c == '%' || *c == '_')
+            g_string_append_c (pattern, '!');
+        g_string_append_c (pattern, nocase ? g_ascii_tolower (*c) : *c);
+    }
+    if (pPredData->how == QOF_COMPARE_CONTAINS)
+        g_string_append_c (pattern, '%');
+
+    quoted = gnc_sql_connection_quote_string (be->conn, pattern->str);
+    g_string_free (pattern, TRUE);
+    if (quoted == NULL)
+        return FALSE;
+    if (nocase)
+        g_string_append_printf (sql, "(LOWER(%s) LIKE %s ESCAPE '!')",
+                                col_name, quoted);
+    else
+        g_string_append_printf (sql, "(%s LIKE %s ESCAPE '!')", col_name,
+                                quoted);
+    g_free (quoted);
+    return TRUE;
+}
+
+/* Appends the SQL for an AND term of a split query, if it has one, which
+ * restricts the transactions in the database that it can match, and
+ * returns whether it did.  exact is cleared unless the SQL matches just
+ * what the term does.  The engine runs the query itself on what is
+ * loaded, so the terms left out only load more than is needed. */
+static gboolean
+append_split_query_term (const GncSqlBackend* be, QofQueryTerm* term,
+                         GString* sql, gboolean* exact)
+{
+    GSList* paramPath = qof_query_term_get_param_path (term);
+    QofQueryPredData* pPredData = qof_query_term_get_pred_data (term);
+    GString* term_sql = g_string_new ("");
+    gboolean is_exact = TRUE;
+    gboolean is_ok = FALSE;
 
-    if (qof_query_has_terms (query))
+    if (paramPath == NULL)
     {
-        GList* orterms = qof_query_get_terms (query);
-        GList* orTerm;
-        GString* sql = g_string_new ("");
-        gboolean need_OR = FALSE;
+        g_string_free (term_sql, TRUE);
+        *exact = FALSE;
+        return FALSE;
+    }
+    auto path = static_cast<const char*> (paramPath->data);
+    auto next_path = paramPath->next == NULL ? NULL :
+                     static_cast<const char*> (paramPath->next->data);
+    auto type = pPredData->type_name;
 
-        for (orTerm = orterms; orTerm != NULL; orTerm = orTerm->next)
+    if (next_path == NULL)
+    {
+        if (strcmp (path, QOF_PARAM_GUID) == 0 &&
+            strcmp (type, QOF_TYPE_GUID) == 0)
         {
-            GList* andterms = (GList*)orTerm->data;
-            GList* andTerm;
-            gboolean need_AND = FALSE;
-#if TX_GUID_CHECK
-            gboolean has_tx_guid_check = FALSE;
-#endif
-            if (need_OR)
-            {
-                g_string_append (sql, " OR ");
-            }
-            g_string_append (sql, "(");
-            for (andTerm = andterms; andTerm != NULL; andTerm = andTerm->next)
-            {
-                QofQueryTerm* term;
-                GSList* paramPath;
-                gboolean unknownPath = FALSE;
-
-                term = (QofQueryTerm*)andTerm->data;
-                paramPath = qof_query_term_get_param_path (term);
-                const char* path = static_cast<decltype (path)> (paramPath->data);
-                const char* next_path =
-                    static_cast<decltype (next_path)> (paramPath->next->data);
-                if (strcmp (path, QOF_PARAM_BOOK) == 0) continue;
-
-#if SIMPLE_QUERY_COMPILATION
-                if (strcmp (path, SPLIT_ACCOUNT) != 0 ||
-                    strcmp (next_path, QOF_PARAM_GUID) != 0) continue;
-#endif
+            is_ok = append_guid_term (be, "s.guid", term, term_sql);
+        }
+        else if (strcmp (path, SPLIT_RECONCILE) == 0 &&
+                 strcmp (type, QOF_TYPE_CHAR) == 0)
+        {
+            convert_query_term_to_sql (be, "s.reconcile_state", term, term_sql);
+            is_ok = TRUE;
+        }
+        else if ((strcmp (path, SPLIT_VALUE) == 0 ||
+                  strcmp (path, SPLIT_AMOUNT) == 0) &&
+                 strcmp (type, QOF_TYPE_NUMERIC) == 0)
+        {
+            is_ok = append_numeric_term (strcmp (path, SPLIT_VALUE) == 0 ?
+                                         "s.value" : "s.quantity",
+                                         term, term_sql);
+            is_exact = FALSE;
+        }
+        else if ((strcmp (path, SPLIT_MEMO) == 0 ||
+                  strcmp (path, SPLIT_ACTION) == 0) &&
+                 strcmp (type, QOF_TYPE_STRING) == 0)
+        {
+            is_ok = append_string_term (be, strcmp (path, SPLIT_MEMO) == 0 ?
+                                        "s.memo" : "s.action",
+                                        term, term_sql);
+            is_exact = FALSE;
+        }
+    }
+    else if (strcmp (path, SPLIT_ACCOUNT) == 0 &&
+             strcmp (next_path, QOF_PARAM_GUID) == 0)
+    {
+        is_ok = append_guid_term (be, "s.account_guid", term, term_sql);
+    }
+    else if (strcmp (path, SPLIT_TRANS) == 0 &&
+             strcmp (next_path, QOF_PARAM_GUID) == 0)
+    {
+        is_ok = append_guid_term (be, "t.guid", term, term_sql);
+    }
+    else if (strcmp (path, SPLIT_TRANS) == 0 &&
+             strcmp (next_path, TRANS_DATE_POSTED) == 0)
+    {
+        /* A match by day rounds the dates, which SQL can't. */
+        query_date_t date_data = (query_date_t)pPredData;
+        if (date_data->options == QOF_DATE_MATCH_NORMAL &&
+            pPredData->how != QOF_COMPARE_EQUAL &&
+            pPredData->how != QOF_COMPARE_NEQ)
+        {
+            convert_query_term_to_sql (be, "t.post_date", term, term_sql);
+            is_ok = TRUE;
+        }
+    }
+    else if (strcmp (path, SPLIT_TRANS) == 0 &&
+             (strcmp (next_path, TRANS_DESCRIPTION) == 0 ||
+              strcmp (next_path, TRANS_NUM) == 0) &&
+             strcmp (type, QOF_TYPE_STRING) == 0)
+    {
+        is_ok = append_string_term (be,
+                                    strcmp (next_path, TRANS_DESCRIPTION) == 0 ?
+                                    "t.description" : "t.num",
+                                    term, term_sql);
+        is_exact = FALSE;
+    }
 
-                if (need_AND) g_string_append (sql, " AND ");
+    if (is_ok)
+        g_string_append_printf (sql, "%s%s", sql->len ? " AND " : "",
+                                term_sql->str);
+    if (!is_ok || !is_exact)
+        *exact = FALSE;
+    g_string_free (term_sql, TRUE);
+    return is_ok;
+}
 
-                if (strcmp (path, SPLIT_ACCOUNT) == 0 &&
-                    strcmp (next_path, QOF_PARAM_GUID) == 0)
-                {
-                    convert_query_term_to_sql (be, "s.account_guid", term, sql);
-#if SIMPLE_QUERY_COMPILATION
-                    goto done_compiling_query;
-#endif
+/* Whether the query sorts first by date posted, which the default sort
+ * of splits does too, and in which direction. */
+static gboolean
+query_sorts_by_date_posted (QofQuery* query, gboolean* increasing)
+{
+    QofQuerySort* primary;
+    QofQuerySort* secondary;
+    QofQuerySort* tertiary;
 
-                }
-                else if (strcmp (path, SPLIT_RECONCILE) == 0)
-                {
-                    convert_query_term_to_sql (be, "s.reconcile_state", term, sql);
+    qof_query_get_sorts (query, &primary, &secondary, &tertiary);
+    if (primary == NULL)
+        return FALSE;
+    GSList* path = qof_query_sort_get_param_path (primary);
+    if (path == NULL)
+        return FALSE;
+    if (strcmp (static_cast<const char*> (path->data), QUERY_DEFAULT_SORT) != 0 &&
+        (strcmp (static_cast<const char*> (path->data), SPLIT_TRANS) != 0 ||
+         path->next == NULL ||
+         strcmp (static_cast<const char*> (path->next->data), TRANS_DATE_POSTED) != 0))
+        return FALSE;
+    *increasing = qof_query_sort_get_increasing (primary);
+    return TRUE;
+}
 
-                }
-                else if (strcmp (path, SPLIT_TRANS) == 0)
-                {
-#if TX_GUID_CHECK
-                    if (!has_tx_guid_check)
-                    {
-                        g_string_append (sql, "(splits.tx_guid = transactions.guid) AND ");
-                        has_tx_guid_check = TRUE;
-                    }
-#endif
-                    if (strcmp (next_path, TRANS_DATE_POSTED) == 0)
-                    {
-                        convert_query_term_to_sql (be, "t.post_date", term, sql);
-                    }
-                    else if (strcmp (next_path, TRANS_DESCRIPTION) == 0)
-                    {
-                        convert_query_term_to_sql (be, "t.description", term, sql);
-                    }
-                    else
-                    {
-                        unknownPath = TRUE;
-                    }
+/* Compiles a query for splits into one for the transactions they could be
+ * in, from the terms SQL can say.  An OR term with none of those would
+ * need all of them.  When a query that keeps only its last few splits is
+ * said in full and sorted by date posted, only the transactions as late
+ * as the last few matching splits, or as early for a decreasing sort,
+ * are loaded. */
+static gpointer
+compile_split_query (GncSqlBackend* be, QofQuery* query)
+{
+    split_query_info_t* query_info = NULL;
+    gchar* query_sql;
+    GString* sql;
+    gboolean load_all;
+    gboolean exact;
+    gboolean increasing = TRUE;
+    guint n_or_terms = 0;
+    gint max_results;
 
-                }
-                else if (strcmp (path, SPLIT_VALUE) == 0)
-                {
-                    convert_query_term_to_sql (be, "s.value_num/s.value_denom", term, sql);
+    g_return_val_if_fail (be != NULL, NULL);
+    g_return_val_if_fail (query != NULL, NULL);
 
-                }
-                else
-                {
-                    unknownPath = TRUE;
-                }
+    if (!gnc_sql_load_transactions_as_needed ())
+        return NULL;
 
-                if (unknownPath)
-                {
-                    GString* name = g_string_new ((gchar*)paramPath->data);
-                    while (paramPath->next != NULL)
-                    {
-                        g_string_append (name, ".");
-                        g_string_append (name, next_path);
-                        paramPath = paramPath->next;
-                    }
-                    PERR ("Unknown SPLIT query field: %s\n", name->str);
-                    g_string_free (name, TRUE);
-                }
-                need_AND = TRUE;
-            }
+    query_info = static_cast<decltype (query_info)> (
+                     g_malloc (sizeof (split_query_info_t)));
+    g_assert (query_info != NULL);
+    query_info->has_been_run = FALSE;
 
-            /* If the last char in the string is a '(', then for some reason, there were
-               no terms added to the SQL.  If so, remove it and ignore the OR term. */
-            if (sql->str[sql->len - 1] == '(')
-            {
-                g_string_truncate (sql, sql->len - 1);
-                need_OR = FALSE;
-            }
-            else
-            {
-                g_string_append (sql, ")");
-                need_OR = TRUE;
-            }
-        }
+    sql = g_string_new ("");
+    load_all = !qof_query_has_terms (query);
+    exact = TRUE;
+    for (GList* orTerm = qof_query_get_terms (query);
+         orTerm != NULL && !load_all; orTerm = orTerm->next)
+    {
+        GString* and_sql = g_string_new ("");
+        gboolean has_sql = FALSE;
 
-#if SIMPLE_QUERY_COMPILATION
-done_compiling_query:
-#endif
-        if (sql->len != 0)
+        for (GList* andTerm = (GList*)orTerm->data; andTerm != NULL;
+             andTerm = andTerm->next)
         {
-#if SIMPLE_QUERY_COMPILATION
-            g_string_append (sql, ")");
-#endif
-            query_sql = g_strdup_printf (
-                            "SELECT DISTINCT t.* FROM %s AS t, %s AS s WHERE s.tx_guid=t.guid AND %s",
-                            TRANSACTION_TABLE, SPLIT_TABLE, sql->str);
+            if (append_split_query_term (be, (QofQueryTerm*)andTerm->data,
+                                         and_sql, &exact))
+                has_sql = TRUE;
         }
+        if (has_sql)
+            g_string_append_printf (sql, "%s(%s)", sql->len ? " OR " : "",
+                                    and_sql->str);
         else
-        {
-            query_sql = g_strdup_printf ("SELECT * FROM %s", TRANSACTION_TABLE);
-        }
-        query_info->stmt = gnc_sql_create_statement_from_sql (be, query_sql);
-
-        g_string_free (sql, TRUE);
-        g_free (query_sql);
+            load_all = TRUE;
+        g_string_free (and_sql, TRUE);
+        n_or_terms++;
+    }
 
+    max_results = qof_query_get_max_results (query);
+    if (load_all)
+    {
+        query_sql = g_strdup_printf ("SELECT * FROM %s", TRANSACTION_TABLE);
+    }
+    else if (max_results > 0 && exact && n_or_terms == 1 &&
+             query_sorts_by_date_posted (query, &increasing))
+    {
+        query_sql = g_strdup_printf (
+                        "SELECT DISTINCT t.* FROM %s AS t, %s AS s WHERE s.tx_guid=t.guid AND (%s)"
+                        " AND t.post_date%s(SELECT %s(d) FROM (SELECT t.post_date AS d FROM %s AS t, %s AS s"
+                        " WHERE s.tx_guid=t.guid AND (%s) ORDER BY t.post_date %s LIMIT %d) AS last_splits)",
+                        TRANSACTION_TABLE, SPLIT_TABLE, sql->str,
+                        increasing ? ">=" : "<=", increasing ? "MIN" : "MAX",
+                        TRANSACTION_TABLE, SPLIT_TABLE, sql->str,
+                        increasing ? "DESC" : "ASC", max_results);
     }
     else
     {
-        query_sql = g_strdup_printf ("SELECT * FROM %s", TRANSACTION_TABLE);
-        query_info->stmt = gnc_sql_create_statement_from_sql (be, query_sql);
-        g_free (query_sql);
+        query_sql = g_strdup_printf (
+                        "SELECT DISTINCT t.* FROM %s AS t, %s AS s WHERE s.tx_guid=t.guid AND (%s)",
+                        TRANSACTION_TABLE, SPLIT_TABLE, sql->str);
     }
+    DEBUG ("Compiled: %s\n", query_sql);
+    query_info->stmt = gnc_sql_create_statement_from_sql (be, query_sql);
+    g_string_free (sql, TRUE);
+    g_free (query_sql);
 
     return query_info;
 }
 
-G_GNUC_UNUSED static void
+static void
 run_split_query (GncSqlBackend* be, gpointer pQuery)
 {
     split_query_info_t* query_info = (split_query_info_t*)pQuery;
 
     g_return_if_fail (be != NULL);
-    g_return_if_fail (pQuery != NULL);
 
-    if (!query_info->has_been_run)
+    /* Nothing to load when all of the transactions were. */
+    if (query_info == NULL)
+        return;
+
+    if (!query_info->has_been_run && query_info->stmt != NULL)
     {
         query_transactions (be, query_info->stmt);
         query_info->has_been_run = TRUE;
@@ -1270,13 +1794,141 @@ run_split_query (GncSqlBackend* be, gpointer pQuery)
     }
 }
 
-G_GNUC_UNUSED static void
+static void
 free_split_query (GncSqlBackend* be, gpointer pQuery)
+{
+    split_query_info_t* query_info = (split_query_info_t*)pQuery;
+
+    g_return_if_fail (be != NULL);
+
+    if (query_info == NULL)
+        return;
+    if (query_info->stmt != NULL)
+        gnc_sql_statement_dispose (query_info->stmt);
+    g_free (query_info);
+}
+
+/* ----------------------------------------------------------------- */
+/* Pages through the accounts' transactions from the latest back, with
+ * keyset pagination on (post_date, enter_date, guid): each page starts
+ * right after the key of the last one, however many transactions share
+ * a date, and the database can walk the indexes to find it. */
+static gint
+load_split_page (QofBook* book, GList* accounts, const GncSplitPageKey* before,
+                 gint n, GncSplitPageKey* first, gpointer user_data)
+{
+    GncSqlBackend* be = (GncSqlBackend*)user_data;
+    GncSqlResult* result;
+    GncSqlStatement* stmt;
+    GString* sql;
+    GString* guid_sql;
+    GncGUID last_guid;
+    gint n_loaded = 0;
+
+    g_return_val_if_fail (be != NULL, -1);
+
+    sql = g_string_new ("");
+    g_string_append_printf (sql, "SELECT DISTINCT t.post_date, t.enter_date, t.guid "
+                            "FROM %s AS t, %s AS s WHERE s.tx_guid=t.guid "
+                            "AND s.account_guid IN (",
+                            TRANSACTION_TABLE, SPLIT_TABLE);
+    (void)gnc_sql_append_guid_list_to_sql (sql, accounts, G_MAXUINT);
+    g_string_append (sql, ")");
+    if (before != NULL)
+    {
+        Timespec ts;
+        gchar* post_date;
+        gchar* enter_date;
+        gchar guid_buf[GUID_ENCODING_LENGTH + 1];
+
+        timespecFromTime64 (&ts, before->date_posted);
+        post_date = gnc_sql_convert_timespec_to_string (be, ts);
+        timespecFromTime64 (&ts, before->date_entered);
+        enter_date = gnc_sql_convert_timespec_to_string (be, ts);
+        (void)guid_to_string_buff (&before->trans_guid, guid_buf);
+        g_string_append_printf (sql, " AND (t.post_date<'%s' OR (t.post_date='%s' "
+                                "AND (t.enter_date<'%s' OR (t.enter_date='%s' "
+                                "AND t.guid<'%s'))))",
+                                post_date, post_date, enter_date, enter_date,
+                                guid_buf);
+        g_free (post_date);
+        g_free (enter_date);
+    }
+    g_string_append_printf (sql, " ORDER BY t.post_date DESC, t.enter_date DESC, "
+                            "t.guid DESC LIMIT %d", n);
+
+    result = gnc_sql_execute_select_sql (be, sql->str);
+    g_string_free (sql, TRUE);
+    if (result == NULL)
+        return 0;
+
+    guid_sql = g_string_new ("");
+    for (GncSqlRow* row = gnc_sql_result_get_first_row (result); row != NULL;
+         row = gnc_sql_result_get_next_row (result))
+    {
+        const GValue* val = gnc_sql_row_get_value_at_col_name (row, "guid");
+        const gchar* guid_str;
+
+        if (val == NULL || !G_VALUE_HOLDS_STRING (val)) continue;
+        guid_str = g_value_get_string (val);
+        if (guid_str == NULL || !string_to_guid (guid_str, &last_guid))
+            continue;
+        g_string_append_printf (guid_sql, "%s'%s'", n_loaded ? "," : "",
+                                guid_str);
+        n_loaded++;
+    }
+    gnc_sql_result_dispose (result);
+
+    if (n_loaded > 0)
+    {
+        gchar* query_sql = g_strdup_printf ("SELECT * FROM %s WHERE guid IN (%s)",
+                                            TRANSACTION_TABLE, guid_sql->str);
+        Transaction* tx;
+
+        stmt = gnc_sql_create_statement_from_sql (be, query_sql);
+        g_free (query_sql);
+        if (stmt != NULL)
+        {
+            query_transactions (be, stmt);
+            gnc_sql_statement_dispose (stmt);
+        }
+
+        /* The rows came latest first, so the last is the new key. */
+        tx = xaccTransLookup (&last_guid, be->book);
+        if (tx != NULL)
+        {
+            first->date_posted = xaccTransGetDate (tx);
+            first->date_entered = xaccTransGetDateEntered (tx);
+            first->trans_guid = last_guid;
+        }
+        else
+        {
+            n_loaded = -1;
+        }
+    }
+    g_string_free (guid_sql, TRUE);
+
+    return n_loaded;
+}
+
+static const GncSplitPageSource split_page_source = { load_split_page };
+
+void
+gnc_sql_split_pages_attach (GncSqlBackend* be)
 {
     g_return_if_fail (be != NULL);
-    g_return_if_fail (pQuery != NULL);
+    g_return_if_fail (be->book != NULL);
 
-    g_free (pQuery);
+    gnc_book_set_split_page_source (be->book, &split_page_source, be);
+}
+
+void
+gnc_sql_split_pages_detach (GncSqlBackend* be)
+{
+    g_return_if_fail (be != NULL);
+
+    if (be->book != NULL)
+        gnc_book_set_split_page_source (be->book, NULL, NULL);
 }
 
 /* ----------------------------------------------------------------- */
@@ -1330,7 +1982,7 @@ static const GncSqlColumnTableEntry acct_balances_col_table[] =
     { NULL }
 };
 
-G_GNUC_UNUSED static  single_acct_balance_t*
+static  single_acct_balance_t*
 load_single_acct_balances (const GncSqlBackend* be, GncSqlRow* row)
 {
     single_acct_balance_t* bal = NULL;
@@ -1350,7 +2002,6 @@ load_single_acct_balances (const GncSqlBackend* be, GncSqlRow* row)
 GSList*
 gnc_sql_get_account_balances_slist (GncSqlBackend* be)
 {
-#if LOAD_TRANSACTIONS_AS_NEEDED
     GncSqlResult* result;
     GncSqlStatement* stmt;
     gchar* buf;
@@ -1361,8 +2012,9 @@ gnc_sql_get_account_balances_slist (GncSqlBackend* be)
     buf = g_strdup_printf ("SELECT account_guid, reconcile_state, sum(quantity_num) as quantity_num, quantity_denom FROM %s GROUP BY account_guid, reconcile_state, quantity_denom ORDER BY account_guid, reconcile_state",
                            SPLIT_TABLE);
     stmt = gnc_sql_create_statement_from_sql (be, buf);
-    g_assert (stmt != NULL);
     g_free (buf);
+    if (stmt == NULL)
+        return NULL;
     result = gnc_sql_execute_select_statement (be, stmt);
     gnc_sql_statement_dispose (stmt);
     if (result != NULL)
@@ -1377,21 +2029,17 @@ gnc_sql_get_account_balances_slist (GncSqlBackend* be)
 
             // Get the next reconcile state balance and merge with other balances
             single_bal = load_single_acct_balances (be, row);
-            if (single_bal != NULL)
+            if (single_bal != NULL && single_bal->acct != NULL)
             {
                 if (bal != NULL && bal->acct != single_bal->acct)
                 {
-                    bal->cleared_balance = gnc_numeric_add (bal->cleared_balance,
-                                                            bal->reconciled_balance,
-                                                            GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
-                    bal->balance = gnc_numeric_add (bal->balance, bal->cleared_balance,
-                                                    GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
-                    bal_slist = g_slist_append (bal_slist, bal);
+                    bal_slist = g_slist_prepend (bal_slist, bal);
                     bal = NULL;
                 }
                 if (bal == NULL)
                 {
-                    bal = g_malloc ((gsize)sizeof (acct_balances_t));
+                    bal = static_cast<decltype (bal)> (
+                              g_malloc (sizeof (acct_balances_t)));
                     g_assert (bal != NULL);
 
                     bal->acct = single_bal->acct;
@@ -1399,45 +2047,22 @@ gnc_sql_get_account_balances_slist (GncSqlBackend* be)
                     bal->cleared_balance = gnc_numeric_zero ();
                     bal->reconciled_balance = gnc_numeric_zero ();
                 }
-                if (single_bal->reconcile_state == 'n')
-                {
-                    bal->balance = gnc_numeric_add (bal->balance, single_bal->balance,
-                                                    GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
-                }
-                else if (single_bal->reconcile_state == 'c')
-                {
-                    bal->cleared_balance = gnc_numeric_add (bal->cleared_balance,
-                                                            single_bal->balance,
-                                                            GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
-                }
-                else if (single_bal->reconcile_state == 'y')
-                {
-                    bal->reconciled_balance = gnc_numeric_add (bal->reconciled_balance,
-                                                               single_bal->balance,
-                                                               GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
-                }
-                g_free (single_bal);
+                gnc_sql_add_split_to_balances (bal, single_bal->reconcile_state,
+                                               single_bal->balance);
             }
+            g_free (single_bal);
             row = gnc_sql_result_get_next_row (result);
         }
 
         // Add the final balance
         if (bal != NULL)
         {
-            bal->cleared_balance = gnc_numeric_add (bal->cleared_balance,
-                                                    bal->reconciled_balance,
-                                                    GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
-            bal->balance = gnc_numeric_add (bal->balance, bal->cleared_balance,
-                                            GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
-            bal_slist = g_slist_append (bal_slist, bal);
+            bal_slist = g_slist_prepend (bal_slist, bal);
         }
         gnc_sql_result_dispose (result);
     }
 
-    return bal_slist;
-#else
-    return NULL;
-#endif
+    return g_slist_reverse (bal_slist);
 }
 
 /* ----------------------------------------------------------------- */
@@ -1510,33 +2135,24 @@ gnc_sql_init_transaction_handler (void)
         GNC_SQL_BACKEND_VERSION,
         GNC_ID_TRANS,
         commit_transaction,          /* commit */
-#if LOAD_TRANSACTIONS_AS_NEEDED
-        NULL,                        /* initial load */
-#else
-        gnc_sql_transaction_load_all_tx,
-#endif
+        load_transactions,           /* initial load */
         create_transaction_tables,   /* create tables */
         NULL,                        /* compile_query */
         NULL,                        /* run_query */
         NULL,                        /* free_query */
-        NULL                         /* write */
+        NULL,                        /* write */
+        begin_edit_transaction       /* begin_edit */
     };
     static GncSqlObjectBackend be_data_split =
     {
         GNC_SQL_BACKEND_VERSION,
         GNC_ID_SPLIT,
-        commit_split,                /* commit */
+        commit_split_balances,       /* commit */
         NULL,                        /* initial_load */
         NULL,                        /* create tables */
-#if LOAD_TRANSACTIONS_AS_NEEDED
-        compile_split_query,
-        run_split_query,
-        free_split_query,
-#else
-        NULL,                        /* compile_query */
-        NULL,                        /* run_query */
-        NULL,                        /* free_query */
-#endif
+        compile_split_query,         /* compile_query */
+        run_split_query,             /* run_query */
+        free_split_query,            /* free_query */
         NULL                         /* write */
     };
 
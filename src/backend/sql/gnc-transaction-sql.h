@@ -71,6 +71,53 @@ void gnc_sql_transaction_load_tx_for_account (GncSqlBackend* be,
  */
 void gnc_sql_transaction_load_all_tx (GncSqlBackend* be);
 
+/**
+ * Whether opening a book leaves its transactions in the database, to be
+ * loaded when the queries for an account's splits ask for them, or when
+ * all of the data is asked for.  The accounts' balances come from the
+ * database meanwhile.  Turned on by setting GNC_SQL_LOAD_AS_NEEDED in the
+ * environment.
+ *
+ * @return TRUE if transactions are loaded as needed
+ */
+gboolean gnc_sql_load_transactions_as_needed (void);
+
+/**
+ * Lets registers load the backend's transactions a page at a time
+ * through the book, while transactions are loaded as needed.
+ *
+ * @param be SQL backend
+ */
+void gnc_sql_split_pages_attach (GncSqlBackend* be);
+
+/**
+ * Stops registers loading pages, once all of the book's transactions are
+ * in memory or the book is closed.
+ *
+ * @param be SQL backend
+ */
+void gnc_sql_split_pages_detach (GncSqlBackend* be);
+
+/**
+ * Keeps track of the transactions loaded as needed, most recently used
+ * first, so that once there are more than GNC_SQL_MAX_LOADED_TRANSACTIONS
+ * of them the least recently used can be taken out of memory again, and
+ * lets lookups by GUID load them back.  Does nothing unless transactions
+ * are loaded as needed.
+ *
+ * @param be SQL backend
+ */
+void gnc_sql_transaction_cache_attach (GncSqlBackend* be);
+
+/**
+ * Stops keeping track of loaded transactions, once all of the book's
+ * transactions are in memory or the book is closed.  The transactions
+ * stay in memory.
+ *
+ * @param be SQL backend
+ */
+void gnc_sql_transaction_cache_detach (GncSqlBackend* be);
+
 typedef struct
 {
     Account* acct;
@@ -79,9 +126,22 @@ typedef struct
     gnc_numeric reconciled_balance;
 } acct_balances_t;
 
+/**
+ * Adds a split's amount to balances the way the engine adds it to an
+ * account's: to the cleared balance unless the split is new, and to the
+ * reconciled balance if it is reconciled or frozen.
+ *
+ * @param bal Balances
+ * @param reconcile_state The split's reconcile state
+ * @param amount The split's amount
+ */
+void gnc_sql_add_split_to_balances (acct_balances_t* bal, char reconcile_state,
+                                    gnc_numeric amount);
+
 /**
  * Returns a list of acct_balances_t structures, one for each account which
- * has splits.
+ * has splits, with the balances of all of its splits in the database.  The
+ * structures and the list are to be freed by the caller.
  *
  * @param be SQL backend
  * @return GSList of acct_balances_t structures
@@ -59,6 +59,10 @@ extern "C"
 #ifdef HAVE_DIRENT_H
 # include <dirent.h>
 #endif
+#ifdef __linux__
+# include <sys/ioctl.h>
+# include <linux/fs.h>
+#endif
 #include <time.h>
 #ifdef G_OS_WIN32
 # include <io.h>
@@ -76,6 +80,8 @@ extern "C"
 #include "qof.h"
 #include "TransLog.h"
 #include "gnc-engine.h"
+#include "Split.h"
+#include "Transaction.h"
 
 #include "gnc-uri-utils.h"
 #include "io-gncxml-v2.h"
@@ -91,6 +97,7 @@ extern "C"
 #include <qofbackend-p.h>
 #include "gnc-xml-helper.h"
 #include "io-gncxml.h"
+#include "io-gncbin.h"
 
 #include "gnc-address-xml-v2.h"
 #include "gnc-bill-term-xml-v2.h"
@@ -107,6 +114,11 @@ extern "C"
 static QofLogModule log_module = GNC_MOD_BACKEND;
 
 static gboolean save_may_clobber_data (FileBackend *bend);
+static gboolean gnc_xml_be_write_to_file (FileBackend* fbe, QofBook* book,
+                                          const gchar* datafile,
+                                          gboolean make_backup);
+static void xml_end_journal (FileBackend* fbe);
+static void xml_background_finish (FileBackend* fbe);
 
 struct QofXmlBackendProvider : public QofBackendProvider
 {
@@ -119,6 +131,21 @@ struct QofXmlBackendProvider : public QofBackendProvider
     ~QofXmlBackendProvider () = default;
     QofBackend* create_backend(void);
     bool type_check(const char* type);
+};
+
+/* Books in the binary format of io-gncbin.h, which are otherwise handled
+ * like the XML ones. */
+struct QofBinBackendProvider : public QofBackendProvider
+{
+    QofBinBackendProvider (const char* name, const char* type) :
+        QofBackendProvider {name, type} {}
+    QofBinBackendProvider(QofBinBackendProvider&) = delete;
+    QofBinBackendProvider operator=(QofBinBackendProvider&) = delete;
+    QofBinBackendProvider(QofBinBackendProvider&&) = delete;
+    QofBinBackendProvider operator=(QofBinBackendProvider&&) = delete;
+    ~QofBinBackendProvider () = default;
+    QofBackend* create_backend(void);
+    bool type_check(const char* type);
 
 };
 
@@ -418,12 +445,16 @@ xml_session_end (QofBackend* be_start)
     FileBackend* be = (FileBackend*)be_start;
     ENTER (" ");
 
+    xml_background_finish (be);
+
     if (be->book && qof_book_is_readonly (be->book))
     {
         qof_backend_set_error ((QofBackend*)be, ERR_BACKEND_READONLY);
         return;
     }
 
+    xml_end_journal (be);
+
     if (be->linkfile)
         g_unlink (be->linkfile);
 
@@ -457,12 +488,26 @@ xml_session_end (QofBackend* be_start)
 
     g_free (be->linkfile);
     be->linkfile = NULL;
+
+    /* The next session may be another file's. */
+    if (be->old_files)
+        g_hash_table_destroy (be->old_files);
+    be->old_files = NULL;
     LEAVE (" ");
 }
 
 static void
 xml_destroy_backend (QofBackend* be)
 {
+    FileBackend* fbe = (FileBackend*) be;
+
+    xml_background_finish (fbe);
+    if (fbe->journal_pending)
+        g_hash_table_destroy (fbe->journal_pending);
+    g_free (fbe->journal_base);
+    if (fbe->old_files)
+        g_hash_table_destroy (fbe->old_files);
+
     /* Stop transaction logging */
     xaccLogSetBaseName (NULL);
 
@@ -482,7 +527,7 @@ xml_destroy_backend (QofBackend* be)
    current year/month/day/hour/minute/second. */
 
 /* The variable buf_size must be a compile-time constant */
-#define buf_size 1024
+#define buf_size (64 * 1024)
 
 static gboolean
 copy_file (const char* orig, const char* bkup)
@@ -510,6 +555,17 @@ copy_file (const char* orig, const char* bkup)
         return FALSE;
     }
 
+#ifdef FICLONE
+    /* Filesystems that can share the data between the files, like btrfs
+     * and xfs, make the copy without reading or writing any of it. */
+    if (ioctl (bkup_fd, FICLONE, orig_fd) == 0)
+    {
+        close (orig_fd);
+        close (bkup_fd);
+        return TRUE;
+    }
+#endif
+
     do
     {
         count_read = read (orig_fd, buf, buf_size);
@@ -541,6 +597,48 @@ copy_file (const char* orig, const char* bkup)
 
 /* ================================================================= */
 
+#ifdef HAVE_LINK
+/* Whether a link failed only because the filesystem has no hard links. */
+static gboolean
+link_unsupported (int err)
+{
+    return err == EPERM || err == ENOSYS
+#ifdef EOPNOTSUPP
+           || err == EOPNOTSUPP
+#endif
+#ifdef ENOTSUP
+           || err == ENOTSUP
+#endif
+           ;
+}
+#endif
+
+/* Makes bkup the file orig is now. Where there are no hard links, orig is
+ * moved to bkup, which is only right when orig is replaced next. */
+static gboolean
+gnc_int_link_or_move (FileBackend* be, const char* orig, const char* bkup)
+{
+#ifdef HAVE_LINK
+    if (link (orig, bkup) == 0)
+        return TRUE;
+    if (!link_unsupported (errno))
+    {
+        qof_backend_set_error ((QofBackend*)be, ERR_FILEIO_BACKUP_ERROR);
+        PWARN ("unable to link file %s to %s: %s", orig, bkup,
+               g_strerror (errno) ? g_strerror (errno) : "");
+        return FALSE;
+    }
+#endif
+    if (g_rename (orig, bkup) != 0)
+    {
+        qof_backend_set_error ((QofBackend*)be, ERR_FILEIO_BACKUP_ERROR);
+        PWARN ("unable to move file %s to %s: %s", orig, bkup,
+               g_strerror (errno) ? g_strerror (errno) : "");
+        return FALSE;
+    }
+    return TRUE;
+}
+
 static gboolean
 gnc_int_link_or_make_backup (FileBackend* be, const char* orig,
                              const char* bkup)
@@ -592,6 +690,8 @@ gnc_xml_be_determine_file_type (const char* path)
     gboolean with_encoding;
     QofBookFileType v2type;
 
+    if (gnc_is_bin_data_file (path))
+        return GNC_BOOK_BIN_FILE;
     v2type = gnc_is_xml_data_file_v2 (path, &with_encoding);
     if (v2type == GNC_BOOK_XML2_FILE)
     {
@@ -672,6 +772,31 @@ det_exit:
     return result;
 }
 
+bool
+QofBinBackendProvider::type_check (const char *uri)
+{
+    struct stat sbuf;
+    gchar* filename;
+    gboolean result;
+
+    if (!uri)
+    {
+        return FALSE;
+    }
+
+    filename = gnc_uri_get_path (uri);
+    if (0 == g_strcmp0 (filename, QOF_STDOUT))
+        result = FALSE;
+    else if (g_stat (filename, &sbuf) < 0)
+        result = (errno == ENOENT);
+    else
+        result = (sbuf.st_size == 0 || gnc_is_bin_data_file (filename));
+    if (!result)
+        PINFO (" %s is not a gnc binary file", filename);
+    g_free (filename);
+    return result;
+}
+
 static gboolean
 gnc_xml_be_backup_file (FileBackend* be)
 {
@@ -688,7 +813,8 @@ gnc_xml_be_backup_file (FileBackend* be)
     if (rc)
         return (errno == ENOENT);
 
-    if (gnc_xml_be_determine_file_type (datafile) == GNC_BOOK_BIN_FILE)
+    if (!be->binary &&
+        gnc_xml_be_determine_file_type (datafile) == GNC_BOOK_BIN_FILE)
     {
         /* make a more permanent safer backup */
         const char* back = "-binfmt.bkup";
@@ -707,64 +833,104 @@ gnc_xml_be_backup_file (FileBackend* be)
     backup = g_strconcat (datafile, ".", timestamp, GNC_DATAFILE_EXT, NULL);
     g_free (timestamp);
 
-    bkup_ret = gnc_int_link_or_make_backup (be, datafile, backup);
-    g_free (backup);
+    bkup_ret = gnc_int_link_or_move (be, datafile, backup);
+    /* The backup keeps the data file's time, which ages it out. */
+    if (bkup_ret && be->old_files)
+        g_hash_table_insert (be->old_files, backup,
+                             g_memdup (&statbuf.st_mtime,
+                                       sizeof (statbuf.st_mtime)));
+    else
+        g_free (backup);
 
     return bkup_ret;
 }
 
-/* ================================================================= */
-
+/* Puts the file written to tmp_name in place of datafile, which may have
+ * been moved to its backup already. */
 static gboolean
-gnc_xml_be_write_to_file (FileBackend* fbe,
-                          QofBook* book,
-                          const gchar* datafile,
-                          gboolean make_backup)
+gnc_xml_be_replace_file (FileBackend* fbe, const char* tmp_name,
+                         const char* datafile)
 {
     QofBackend* be = &fbe->be;
-    char* tmp_name;
-    struct stat statbuf;
-    int rc;
-    QofBackendError be_err;
 
-    ENTER (" book=%p file=%s", book, datafile);
+#ifdef G_OS_WIN32
+    /* Renaming doesn't replace a file there. */
+    g_unlink (datafile);
+#endif
+    if (g_rename (tmp_name, datafile) == 0)
+        return TRUE;
 
-    if (book && qof_book_is_readonly (book))
+    if (g_unlink (datafile) != 0 && errno != ENOENT)
     {
-        /* Are we read-only? Don't continue in this case. */
-        qof_backend_set_error ((QofBackend*)be, ERR_BACKEND_READONLY);
-        LEAVE ("");
+        qof_backend_set_error (be, ERR_BACKEND_READONLY);
+        PWARN ("unable to unlink filename %s: %s",
+               datafile ? datafile : "(null)",
+               g_strerror (errno) ? g_strerror (errno) : "");
         return FALSE;
     }
+    if (!gnc_int_link_or_make_backup (fbe, tmp_name, datafile))
+    {
+        qof_backend_set_error (be, ERR_FILEIO_BACKUP_ERROR);
+        qof_backend_set_message (be, "Failed to make backup file %s",
+                                 datafile ? datafile : "NULL");
+        return FALSE;
+    }
+    if (g_unlink (tmp_name) != 0)
+    {
+        qof_backend_set_error (be, ERR_BACKEND_PERM);
+        PWARN ("unable to unlink temp filename %s: %s",
+               tmp_name ? tmp_name : "(null)",
+               g_strerror (errno) ? g_strerror (errno) : "");
+        return FALSE;
+    }
+    return TRUE;
+}
 
-    /* If the book is 'clean', recently saved, then don't save again. */
-    /* XXX this is currently broken due to faulty 'Save As' logic. */
-    /* if (FALSE == qof_book_session_not_saved (book)) return FALSE; */
+/* ================================================================= */
+
+/* A name for the new file next to datafile, or NULL. */
+static char*
+gnc_xml_be_temp_name (FileBackend* fbe, const gchar* datafile)
+{
+    char* tmp_name = g_new (char, strlen (datafile) + 12);
 
-    tmp_name = g_new (char, strlen (datafile) + 12);
     strcpy (tmp_name, datafile);
     strcat (tmp_name, ".tmp-XXXXXX");
 
     if (!mktemp (tmp_name))
     {
-        qof_backend_set_error (be, ERR_BACKEND_MISC);
-        qof_backend_set_message (be, "Failed to make temp file");
-        LEAVE ("");
-        return FALSE;
+        qof_backend_set_error (&fbe->be, ERR_BACKEND_MISC);
+        qof_backend_set_message (&fbe->be, "Failed to make temp file");
+        g_free (tmp_name);
+        return NULL;
     }
+    return tmp_name;
+}
 
-    if (make_backup)
-    {
-        if (!gnc_xml_be_backup_file (fbe))
-        {
-            LEAVE ("");
-            return FALSE;
-        }
-    }
+static GncXmlCodec
+gnc_xml_be_codec (void)
+{
+    if (!gnc_prefs_get_file_save_compressed ())
+        return GNC_XML_CODEC_NONE;
+    return gnc_xml_codec_from_name (gnc_prefs_get_file_compression_codec ());
+}
 
-    if (gnc_book_write_to_xml_file_v2 (book, tmp_name,
-                                       gnc_prefs_get_file_save_compressed ()))
+/* Puts the new file at tmp_name, if it was written, in the place of
+ * datafile, or else gets rid of it. Frees tmp_name. */
+static gboolean
+gnc_xml_be_finish_write (FileBackend* fbe, char* tmp_name,
+                         const gchar* datafile, gboolean make_backup,
+                         gboolean written)
+{
+    QofBackend* be = &fbe->be;
+    struct stat statbuf;
+    int rc;
+    QofBackendError be_err;
+
+    if (written)
     {
+        if (g_stat (tmp_name, &statbuf) == 0)
+            qof_backend_stat_add (be, "file.bytes", statbuf.st_size);
         /* Record the file's permissions before g_unlinking it */
         rc = g_stat (datafile, &statbuf);
         if (rc == 0)
@@ -809,41 +975,22 @@ gnc_xml_be_write_to_file (FileBackend* fbe,
             }
 #endif
         }
-        if (g_unlink (datafile) != 0 && errno != ENOENT)
-        {
-            qof_backend_set_error (be, ERR_BACKEND_READONLY);
-            PWARN ("unable to unlink filename %s: %s",
-                   datafile ? datafile : "(null)",
-                   g_strerror (errno) ? g_strerror (errno) : "");
-            g_free (tmp_name);
-            LEAVE ("");
-            return FALSE;
-        }
-        if (!gnc_int_link_or_make_backup (fbe, tmp_name, datafile))
+        /* The backup is made once the new file is complete: it may move the
+         * data file out of the way, leaving only the new one to put in
+         * its place. */
+        QofBackendPhase phase {be, "file", "replace"};
+        if (make_backup && !gnc_xml_be_backup_file (fbe))
         {
-            qof_backend_set_error (be, ERR_FILEIO_BACKUP_ERROR);
-            qof_backend_set_message (be, "Failed to make backup file %s",
-                                     datafile ? datafile : "NULL");
+            g_unlink (tmp_name);
             g_free (tmp_name);
-            LEAVE ("");
             return FALSE;
         }
-        if (g_unlink (tmp_name) != 0)
+        if (!gnc_xml_be_replace_file (fbe, tmp_name, datafile))
         {
-            qof_backend_set_error (be, ERR_BACKEND_PERM);
-            PWARN ("unable to unlink temp filename %s: %s",
-                   tmp_name ? tmp_name : "(null)",
-                   g_strerror (errno) ? g_strerror (errno) : "");
             g_free (tmp_name);
-            LEAVE ("");
             return FALSE;
         }
         g_free (tmp_name);
-
-        /* Since we successfully saved the book,
-         * we should mark it clean. */
-        qof_book_mark_session_saved (book);
-        LEAVE (" successful save of book=%p to file=%s", book, datafile);
         return TRUE;
     }
     else
@@ -877,10 +1024,59 @@ gnc_xml_be_write_to_file (FileBackend* fbe,
                                      tmp_name ? tmp_name : "NULL");
         }
         g_free (tmp_name);
+        return FALSE;
+    }
+}
+
+static gboolean
+gnc_xml_be_write_to_file (FileBackend* fbe,
+                          QofBook* book,
+                          const gchar* datafile,
+                          gboolean make_backup)
+{
+    QofBackend* be = &fbe->be;
+    char* tmp_name;
+    GncXmlCodec codec;
+    gboolean written;
+
+    ENTER (" book=%p file=%s", book, datafile);
+
+    if (book && qof_book_is_readonly (book))
+    {
+        /* Are we read-only? Don't continue in this case. */
+        qof_backend_set_error ((QofBackend*)be, ERR_BACKEND_READONLY);
+        LEAVE ("");
+        return FALSE;
+    }
+
+    /* If the book is 'clean', recently saved, then don't save again. */
+    /* XXX this is currently broken due to faulty 'Save As' logic. */
+    /* if (FALSE == qof_book_session_not_saved (book)) return FALSE; */
+
+    tmp_name = gnc_xml_be_temp_name (fbe, datafile);
+    if (!tmp_name)
+    {
+        LEAVE ("");
+        return FALSE;
+    }
+
+    codec = gnc_xml_be_codec ();
+    {
+        QofBackendPhase phase {be, "file", "write"};
+        written = fbe->binary ? gnc_book_write_to_bin_file (book, tmp_name) :
+                  gnc_book_write_to_xml_file_v2_codec (book, tmp_name, codec);
+    }
+    if (!gnc_xml_be_finish_write (fbe, tmp_name, datafile, make_backup,
+                                  written))
+    {
         LEAVE ("");
         return FALSE;
     }
-    LEAVE ("");
+
+    /* Since we successfully saved the book,
+     * we should mark it clean. */
+    qof_book_mark_session_saved (book);
+    LEAVE (" successful save of book=%p to file=%s", book, datafile);
     return TRUE;
 }
 
@@ -891,22 +1087,60 @@ gnc_xml_be_write_to_file (FileBackend* fbe,
  * backup and log files.
  */
 
+/* How long the backups and logs found by a scan of the directory are
+ * trusted before it is scanned again, in seconds. Backups this backend
+ * makes are added to them as it goes. */
+static const time64 old_files_rescan = 3600;
+
+/* Whether name, which starts with the data file's path, is a dated backup
+ * or log of it. */
+static gboolean
+is_dated_file (FileBackend* be, regex_t* pattern, const gchar* name)
+{
+    /* At this point we're sure the file's name is in one of these forms:
+     * <fullpath/to/datafile><anything>.gnucash
+     * <fullpath/to/datafile><anything>.xac
+     * <fullpath/to/datafile><anything>.log
+     *
+     * To be a file generated by GnuCash, the <anything> part should consist
+     * of 1 dot followed by 14 digits (0 to 9).
+     */
+    const gchar* stamp_start = name + strlen (be->fullpath);
+    return regexec (pattern, stamp_start, 0, NULL, 0) == 0;
+}
+
+/* Removes stale lock files and lists the dated backups and logs of the
+ * data file with their times. */
 static void
-gnc_xml_be_remove_old_files (FileBackend* be)
+gnc_xml_be_scan_old_files (FileBackend* be, const struct stat* lockstatbuf)
 {
     const gchar* dent;
     GDir* dir;
-    struct stat lockstatbuf, statbuf;
-    time64 now;
-
-    if (g_stat (be->lockfile, &lockstatbuf) != 0)
-        return;
+    struct stat statbuf;
+    regex_t pattern;
+    gchar* expression;
 
     dir = g_dir_open (be->dirname, 0, NULL);
     if (!dir)
         return;
 
-    now = gnc_time (NULL);
+    expression = g_strdup_printf ("^\\.[[:digit:]]{14}(\\%s|\\%s|\\.xac)$",
+                                  GNC_DATAFILE_EXT, GNC_LOGFILE_EXT);
+    if (regcomp (&pattern, expression, REG_EXTENDED | REG_ICASE) != 0)
+    {
+        PWARN ("Cannot compile regex for date stamp");
+        g_free (expression);
+        g_dir_close (dir);
+        return;
+    }
+    g_free (expression);
+
+    if (be->old_files)
+        g_hash_table_remove_all (be->old_files);
+    else
+        be->old_files = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                               g_free, g_free);
+
     while ((dent = g_dir_read_name (dir)) != NULL)
     {
         gchar* name;
@@ -920,15 +1154,10 @@ gnc_xml_be_remove_old_files (FileBackend* be)
 
         name = g_build_filename (be->dirname, dent, (gchar*)NULL);
 
-        /* Only evaluate files associated with the current data file. */
-        if (!g_str_has_prefix (name, be->fullpath))
-        {
-            g_free (name);
-            continue;
-        }
-
-        /* Never remove the current data file itself */
-        if (g_strcmp0 (name, be->fullpath) == 0)
+        /* Only evaluate files associated with the current data file,
+         * and never the current data file itself. */
+        if (!g_str_has_prefix (name, be->fullpath) ||
+            g_strcmp0 (name, be->fullpath) == 0)
         {
             g_free (name);
             continue;
@@ -941,7 +1170,7 @@ gnc_xml_be_remove_old_files (FileBackend* be)
             if ((g_strcmp0 (name, be->linkfile) != 0) &&
                 /* Only delete lock files older than the active one */
                 (g_stat (name, &statbuf) == 0) &&
-                (statbuf.st_mtime < lockstatbuf.st_mtime))
+                (statbuf.st_mtime < lockstatbuf->st_mtime))
             {
                 PINFO ("remove stale lock file: %s", name);
                 g_unlink (name);
@@ -951,71 +1180,267 @@ gnc_xml_be_remove_old_files (FileBackend* be)
             continue;
         }
 
-        /* At this point we're sure the file's name is in one of these forms:
-         * <fullpath/to/datafile><anything>.gnucash
-         * <fullpath/to/datafile><anything>.xac
-         * <fullpath/to/datafile><anything>.log
-         *
-         * To be a file generated by GnuCash, the <anything> part should consist
-         * of 1 dot followed by 14 digits (0 to 9). Let's test this with a
-         * regular expression.
-         */
+        if (!is_dated_file (be, &pattern, name) || g_stat (name, &statbuf) != 0)
         {
-            /* Find the start of the date stamp. This takes some pointer
-             * juggling, but considering the above tests, this should always
-             * be safe */
-            regex_t pattern;
-            gchar* stamp_start = name + strlen (be->fullpath);
-            gchar* expression = g_strdup_printf ("^\\.[[:digit:]]{14}(\\%s|\\%s|\\.xac)$",
-                                                 GNC_DATAFILE_EXT, GNC_LOGFILE_EXT);
-            gboolean got_date_stamp = FALSE;
-
-            if (regcomp (&pattern, expression, REG_EXTENDED | REG_ICASE) != 0)
-                PWARN ("Cannot compile regex for date stamp");
-            else if (regexec (&pattern, stamp_start, 0, NULL, 0) == 0)
-                got_date_stamp = TRUE;
-
-            regfree (&pattern);
-            g_free (expression);
-
-            if (!got_date_stamp) /* Not a gnucash created file after all... */
-            {
-                g_free (name);
-                continue;
-            }
+            g_free (name);
+            continue;
         }
+        g_hash_table_insert (be->old_files, name,
+                             g_memdup (&statbuf.st_mtime,
+                                       sizeof (statbuf.st_mtime)));
+    }
+
+    regfree (&pattern);
+    g_dir_close (dir);
+}
+
+static void
+gnc_xml_be_remove_old_files (FileBackend* be)
+{
+    struct stat lockstatbuf;
+    GHashTableIter iter;
+    gpointer key, value;
+    time64 now;
+
+    if (g_stat (be->lockfile, &lockstatbuf) != 0)
+        return;
+
+    now = gnc_time (NULL);
+    if (!be->old_files || now - be->old_files_scanned >= old_files_rescan)
+    {
+        gnc_xml_be_scan_old_files (be, &lockstatbuf);
+        be->old_files_scanned = now;
+    }
+    if (!be->old_files)
+        return;
+
+    /* The file is a backup or log file. Check the user's retention preference
+     * to determine if we should keep it or not
+     */
+    g_hash_table_iter_init (&iter, be->old_files);
+    while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+        const gchar* name = static_cast<const gchar*> (key);
+        time_t mtime = *static_cast<time_t*> (value);
 
-        /* The file is a backup or log file. Check the user's retention preference
-         * to determine if we should keep it or not
-         */
         if (gnc_prefs_get_file_retention_policy () == XML_RETAIN_NONE)
         {
             PINFO ("remove stale file: %s  - reason: preference XML_RETAIN_NONE", name);
             g_unlink (name);
+            g_hash_table_iter_remove (&iter);
         }
         else if ((gnc_prefs_get_file_retention_policy () == XML_RETAIN_DAYS) &&
                  (gnc_prefs_get_file_retention_days () > 0))
         {
-            int days;
-
-            /* Is the backup file old enough to delete */
-            if (g_stat (name, &statbuf) != 0)
-            {
-                g_free (name);
-                continue;
-            }
-            days = (int) (difftime (now, statbuf.st_mtime) / 86400);
+            int days = (int) (difftime (now, mtime) / 86400);
 
             PINFO ("file retention = %d days", gnc_prefs_get_file_retention_days ());
             if (days >= gnc_prefs_get_file_retention_days ())
             {
                 PINFO ("remove stale file: %s  - reason: more than %d days old", name, days);
                 g_unlink (name);
+                g_hash_table_iter_remove (&iter);
             }
         }
-        g_free (name);
     }
-    g_dir_close (dir);
+}
+
+/* ================================================================= */
+/* Journaled saves
+ *
+ * With GNC_XML_JOURNAL set, a save after which only transactions have
+ * changed appends them to a journal next to the book file instead of
+ * writing the whole book, so that autosaving a big book is cheap. Loading
+ * the file applies the journal. The journal is folded into the file by
+ * the next full save: when anything else has changed, when a changed
+ * transaction is in a lot or read-only, when the journal has grown past
+ * journal_max_size, and when a session ends with nothing left unsaved.
+ */
+
+#define GNC_JOURNAL_EXT ".journal"
+
+/* A journal bigger than this is folded into the file on the next save. */
+static const gint64 journal_max_size = 4 << 20;
+
+static gboolean
+xml_journal_enabled (void)
+{
+    return g_getenv ("GNC_XML_JOURNAL") != NULL;
+}
+
+static gchar*
+journal_path (FileBackend* fbe)
+{
+    return g_strconcat (fbe->fullpath, GNC_JOURNAL_EXT, NULL);
+}
+
+/* Names the state of the file at path, so that a journal that doesn't go
+ * with the file any more isn't applied to it. */
+static gchar*
+journal_file_stamp (const char* path)
+{
+    struct stat statbuf;
+
+    if (g_stat (path, &statbuf) != 0)
+        return NULL;
+    return g_strdup_printf ("%" G_GINT64_FORMAT ":%" G_GINT64_FORMAT,
+                            (gint64) statbuf.st_size,
+                            (gint64) statbuf.st_mtime);
+}
+
+/* The journal replaces the transactions it holds, which is only safe when
+ * that can't touch others, as a lot's gains transactions. */
+static gboolean
+journal_can_hold (Transaction* trans)
+{
+    if (xaccTransGetReadOnly (trans))
+        return FALSE;
+    for (GList* node = xaccTransGetSplitList (trans); node; node = node->next)
+        if (xaccSplitGetLot (static_cast<Split*> (node->data)))
+            return FALSE;
+    return TRUE;
+}
+
+static void
+xml_commit_edit (QofBackend* be, QofInstance* inst)
+{
+    FileBackend* fbe = (FileBackend*) be;
+    Transaction* trans = NULL;
+
+    if (!fbe->journal_pending || fbe->journal_full)
+        return;
+
+    if (GNC_IS_TRANSACTION (inst))
+        trans = GNC_TRANSACTION (inst);
+    else if (GNC_IS_SPLIT (inst))
+        trans = xaccSplitGetParent (GNC_SPLIT (inst));
+    else if (qof_instance_get_dirty_flag (inst) ||
+             qof_instance_get_destroying (inst))
+        fbe->journal_full = TRUE;
+
+    if (trans)
+        g_hash_table_insert (fbe->journal_pending,
+                             guid_copy (qof_instance_get_guid (trans)), NULL);
+}
+
+/* Applies the journal to the book just loaded and starts journaling. */
+static void
+xml_load_journal (FileBackend* fbe, QofBook* book)
+{
+    gchar* path = journal_path (fbe);
+    gboolean stale = FALSE;
+
+    g_free (fbe->journal_base);
+    fbe->journal_base = journal_file_stamp (fbe->fullpath);
+    fbe->journal_full = FALSE;
+
+    if (g_file_test (path, G_FILE_TEST_EXISTS) &&
+        !gnc_xml_journal_replay (book, path, fbe->journal_base, &stale))
+    {
+        if (stale)
+        {
+            /* The next save writes the whole file and drops the journal. */
+            PWARN ("Ignoring journal %s, which doesn't go with the file", path);
+            fbe->journal_full = TRUE;
+        }
+        else
+        {
+            PERR ("Couldn't apply journal %s", path);
+            qof_backend_set_error (&fbe->be, ERR_FILEIO_PARSE_ERROR);
+        }
+    }
+    g_free (path);
+
+    if (xml_journal_enabled () && !qof_book_is_readonly (book) &&
+        !fbe->journal_pending)
+        fbe->journal_pending = g_hash_table_new_full (guid_hash_to_guint,
+                                                      guid_g_hash_table_equal,
+                                                      guid_free, NULL);
+}
+
+/* Appends the changes to the journal if it can hold them. */
+static gboolean
+xml_sync_journal (FileBackend* fbe, QofBook* book)
+{
+    struct stat statbuf;
+    gboolean success = TRUE;
+    GList* guids;
+    gchar* path;
+
+    if (!fbe->journal_pending || fbe->journal_full || !fbe->journal_base)
+        return FALSE;
+
+    path = journal_path (fbe);
+    if (g_stat (path, &statbuf) == 0 && statbuf.st_size > journal_max_size)
+    {
+        g_free (path);
+        return FALSE;
+    }
+
+    guids = g_hash_table_get_keys (fbe->journal_pending);
+    for (GList* node = guids; success && node; node = node->next)
+    {
+        Transaction* trans =
+            xaccTransLookup (static_cast<GncGUID*> (node->data), book);
+        if (trans && !journal_can_hold (trans))
+            success = FALSE;
+    }
+    if (success && !gnc_xml_journal_append (book, path, fbe->journal_base,
+                                            guids))
+    {
+        PWARN ("Couldn't append to journal %s", path);
+        success = FALSE;
+    }
+    g_list_free (guids);
+    g_free (path);
+
+    if (success)
+    {
+        g_hash_table_remove_all (fbe->journal_pending);
+        qof_book_mark_session_saved (book);
+    }
+    return success;
+}
+
+/* Drops the journal once the whole book has been written. */
+static void
+xml_reset_journal (FileBackend* fbe)
+{
+    gchar* path = journal_path (fbe);
+
+    if (g_unlink (path) != 0 && errno != ENOENT)
+        PWARN ("Unable to remove journal %s: %s", path,
+               g_strerror (errno) ? g_strerror (errno) : "");
+    g_free (path);
+
+    if (fbe->journal_pending)
+        g_hash_table_remove_all (fbe->journal_pending);
+    fbe->journal_full = FALSE;
+    g_free (fbe->journal_base);
+    fbe->journal_base = journal_file_stamp (fbe->fullpath);
+}
+
+/* Folds the journal into the file if everything has been saved. */
+static void
+xml_end_journal (FileBackend* fbe)
+{
+    if (fbe->journal_base && fbe->book && fbe->fullpath &&
+        !qof_book_session_not_saved (fbe->book))
+    {
+        gchar* path = journal_path (fbe);
+
+        if (g_file_test (path, G_FILE_TEST_EXISTS) &&
+            gnc_xml_be_write_to_file (fbe, fbe->book, fbe->fullpath, TRUE))
+            xml_reset_journal (fbe);
+        g_free (path);
+    }
+
+    if (fbe->journal_pending)
+        g_hash_table_destroy (fbe->journal_pending);
+    fbe->journal_pending = NULL;
+    fbe->journal_full = FALSE;
+    g_free (fbe->journal_base);
+    fbe->journal_base = NULL;
 }
 
 static void
@@ -1024,6 +1449,8 @@ xml_sync_all (QofBackend* be, QofBook* book)
     FileBackend* fbe = (FileBackend*) be;
     ENTER ("book=%p, fbe->book=%p", book, fbe->book);
 
+    xml_background_finish (fbe);
+
     /* We make an important assumption here, that we might want to change
      * in the future: when the user says 'save', we really save the one,
      * the only, the current open book, and nothing else. In any case the plans
@@ -1040,11 +1467,127 @@ xml_sync_all (QofBackend* be, QofBook* book)
         return;
     }
 
-    gnc_xml_be_write_to_file (fbe, book, fbe->fullpath, TRUE);
+    if (xml_sync_journal (fbe, book))
+    {
+        LEAVE ("book=%p, journaled", book);
+        return;
+    }
+
+    if (gnc_xml_be_write_to_file (fbe, book, fbe->fullpath, TRUE))
+        xml_reset_journal (fbe);
     gnc_xml_be_remove_old_files (fbe);
     LEAVE ("book=%p", book);
 }
 
+/* Saves in the background, so that autosaving a big book doesn't hold up
+ * work on it. The book is written uncompressed to a temporary file first,
+ * which doesn't take long; from that a thread compresses and writes the
+ * new data file, and when it is done that is put in place as xml_sync_all
+ * would. The book is marked saved as of the snapshot, so changes made
+ * meanwhile wait for the next save. Should the write fail, the book is
+ * marked unsaved again and the error left for the next save to report.
+ */
+static gpointer
+xml_background_thread (gpointer data)
+{
+    FileBackend* fbe = static_cast<FileBackend*> (data);
+    gboolean written;
+
+    written = gnc_xml_write_snapshot_v2 (fbe->bg_snapshot, fbe->bg_tmp_name,
+                                        static_cast<GncXmlCodec> (fbe->bg_codec));
+    g_atomic_int_set (&fbe->bg_done, 1);
+    return GINT_TO_POINTER (written);
+}
+
+/* Waits for the background write, if there is one, and finishes it. */
+static void
+xml_background_finish (FileBackend* fbe)
+{
+    gboolean written;
+
+    if (!fbe->bg_thread)
+        return;
+
+    ENTER ("file=%s", fbe->bg_tmp_name);
+    written = GPOINTER_TO_INT (g_thread_join (fbe->bg_thread));
+    fbe->bg_thread = NULL;
+    if (fbe->bg_source)
+        g_source_remove (fbe->bg_source);
+    fbe->bg_source = 0;
+    fclose (fbe->bg_snapshot);
+    fbe->bg_snapshot = NULL;
+
+    if (gnc_xml_be_finish_write (fbe, fbe->bg_tmp_name, fbe->fullpath, TRUE,
+                                 written))
+        xml_reset_journal (fbe);
+    else if (fbe->book)
+        qof_book_mark_session_dirty (fbe->book);
+    fbe->bg_tmp_name = NULL;
+    gnc_xml_be_remove_old_files (fbe);
+    LEAVE ("written=%d", written);
+}
+
+static gboolean
+xml_background_check (gpointer data)
+{
+    FileBackend* fbe = static_cast<FileBackend*> (data);
+
+    if (!g_atomic_int_get (&fbe->bg_done))
+        return TRUE;
+    fbe->bg_source = 0;
+    xml_background_finish (fbe);
+    return FALSE;
+}
+
+static void
+xml_background_sync (QofBackend* be, QofBook* book)
+{
+    FileBackend* fbe = (FileBackend*) be;
+    FILE* snapshot;
+    char* tmp_name;
+
+    ENTER ("book=%p, fbe->book=%p", book, fbe->book);
+
+    xml_background_finish (fbe);
+    /* With the journal on, most saves are short appends anyway. */
+    if (fbe->journal_pending || (fbe->book && book != fbe->book) ||
+        qof_book_is_readonly (book))
+    {
+        xml_sync_all (be, book);
+        LEAVE ("book=%p, in the foreground", book);
+        return;
+    }
+    if (NULL == fbe->book) fbe->book = book;
+
+    tmp_name = gnc_xml_be_temp_name (fbe, fbe->fullpath);
+    if (!tmp_name)
+    {
+        LEAVE ("");
+        return;
+    }
+    snapshot = tmpfile ();
+    if (!snapshot || !gnc_book_write_to_xml_snapshot_v2 (book, snapshot))
+    {
+        PWARN ("Couldn't take a snapshot of the book, saving in the foreground");
+        if (snapshot)
+            fclose (snapshot);
+        g_free (tmp_name);
+        xml_sync_all (be, book);
+        LEAVE ("book=%p, in the foreground", book);
+        return;
+    }
+
+    fbe->bg_snapshot = snapshot;
+    fbe->bg_tmp_name = tmp_name;
+    fbe->bg_codec = gnc_xml_be_codec ();
+    fbe->bg_done = 0;
+    qof_book_mark_session_saved (book);
+    fbe->bg_thread = g_thread_new ("xml-background-write",
+                                   xml_background_thread, fbe);
+    fbe->bg_source = g_timeout_add (250, xml_background_check, fbe);
+    LEAVE ("book=%p", book);
+}
+
 /* ================================================================= */
 /* Routines to deal with the creation of multiple books.
  * The core design assumption here is that the book
@@ -1148,6 +1691,19 @@ gnc_xml_be_load_from_file (QofBackend* bend, QofBook* book,
             PWARN ("Syntax error in Xml File %s", be->fullpath);
             error = ERR_FILEIO_PARSE_ERROR;
         }
+        else
+            xml_load_journal (be, book);
+        break;
+
+    case GNC_BOOK_BIN_FILE:
+        rc = qof_session_load_from_bin_file (be, book);
+        if (FALSE == rc)
+        {
+            PWARN ("Unreadable binary file %s", be->fullpath);
+            error = ERR_FILEIO_PARSE_ERROR;
+        }
+        else
+            be->binary = TRUE;
         break;
 
     case GNC_BOOK_XML2_FILE_NO_ENCODING:
@@ -1223,8 +1779,8 @@ gnc_xml_be_write_accounts_to_file (QofBackend* be, QofBook* book)
 
 /* ================================================================= */
 
-QofBackend*
-QofXmlBackendProvider::create_backend(void)
+static QofBackend*
+gnc_file_be_new (gboolean binary)
 {
     FileBackend* gnc_be;
     QofBackend* be;
@@ -1241,7 +1797,8 @@ QofXmlBackendProvider::create_backend(void)
 
     /* The file backend treats accounting periods transactionally. */
     be->begin = xml_begin_edit;
-    be->commit = NULL;
+    /* Only journaling needs to see commits, and binary files have none. */
+    be->commit = !binary && xml_journal_enabled () ? xml_commit_edit : NULL;
     be->rollback = xml_rollback_edit;
 
     /* The file backend always loads all data ... */
@@ -1254,6 +1811,8 @@ QofXmlBackendProvider::create_backend(void)
     be->process_events = NULL;
 
     be->sync = xml_sync_all;
+    /* A binary file is written in one go. */
+    be->background_sync = binary ? NULL : xml_background_sync;
 
     be->export_fn = gnc_xml_be_write_accounts_to_file;
 
@@ -1265,9 +1824,33 @@ QofXmlBackendProvider::create_backend(void)
 
     gnc_be->book = NULL;
 
+    gnc_be->journal_pending = NULL;
+    gnc_be->journal_full = FALSE;
+    gnc_be->journal_base = NULL;
+    gnc_be->binary = binary;
+    gnc_be->old_files = NULL;
+    gnc_be->old_files_scanned = 0;
+    gnc_be->bg_thread = NULL;
+    gnc_be->bg_snapshot = NULL;
+    gnc_be->bg_tmp_name = NULL;
+    gnc_be->bg_done = 0;
+    gnc_be->bg_source = 0;
+
     return be;
 }
 
+QofBackend*
+QofXmlBackendProvider::create_backend(void)
+{
+    return gnc_file_be_new (FALSE);
+}
+
+QofBackend*
+QofBinBackendProvider::create_backend(void)
+{
+    return gnc_file_be_new (TRUE);
+}
+
 static void
 business_core_xml_init (void)
 {
@@ -1303,6 +1886,14 @@ gnc_module_init_backend_xml (void)
     prov = QofBackendProvider_ptr(new QofXmlBackendProvider{name, "file"});
     qof_backend_register_provider(std::move(prov));
 
+    /* The XML provider turns down binary files, so a file: one of those
+     * gets to this one. */
+    const char* bin_name {"GnuCash Binary File Backend"};
+    prov = QofBackendProvider_ptr(new QofBinBackendProvider{bin_name, "gncbin"});
+    qof_backend_register_provider(std::move(prov));
+    prov = QofBackendProvider_ptr(new QofBinBackendProvider{bin_name, "file"});
+    qof_backend_register_provider(std::move(prov));
+
     /* And the business objects */
     business_core_xml_init ();
 }
@@ -67,6 +67,25 @@ struct FileBackend_struct
     int lockfd;
 
     QofBook* book;  /* The primary, main open book */
+    gboolean binary; /* Saved in the binary format, see io-gncbin.h */
+
+    /* Journaled saves, see xml_sync_all. */
+    GHashTable* journal_pending; /* Transactions changed since the last save */
+    gboolean journal_full;       /* Something the journal can't hold changed */
+    char* journal_base;          /* The state of the file the journal is for */
+
+    /* Dated backups and logs of the file, name -> time_t mtime, see
+     * gnc_xml_be_remove_old_files. */
+    GHashTable* old_files;
+    time64 old_files_scanned;    /* When the directory was last listed */
+
+    /* The write of xml_background_sync going on. */
+    GThread* bg_thread;          /* Writes bg_snapshot to bg_tmp_name */
+    FILE* bg_snapshot;
+    char* bg_tmp_name;
+    int bg_codec;                /* A GncXmlCodec */
+    gint bg_done;                /* Set by bg_thread as it ends */
+    guint bg_source;             /* Watches for bg_done */
 };
 
 typedef struct FileBackend_struct FileBackend;
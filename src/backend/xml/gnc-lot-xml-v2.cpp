@@ -164,8 +164,12 @@ dom_tree_to_lot (xmlNodePtr node, QofBook* book)
     struct lot_pdata pdata;
     GNCLot* lot;
     gboolean successful;
+    GncGUID guid;
 
-    lot = gnc_lot_new (book);
+    if (dom_tree_find_guid (node, lot_id_string, &guid))
+        lot = gnc_lot_new_for_load (book, &guid);
+    else
+        lot = gnc_lot_new (book);
     ENTER ("(lot=%p)", lot);
 
     pdata.lot = lot;
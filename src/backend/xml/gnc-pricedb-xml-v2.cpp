@@ -156,6 +156,7 @@ price_parse_xml_end_handler (gpointer data_for_children,
     xmlNodePtr price_xml = (xmlNodePtr) data_for_children;
     xmlNodePtr child;
     GNCPrice* p = NULL;
+    GncGUID guid;
     gxpf_data* gdata = static_cast<decltype (gdata)> (global_data);
     QofBook* book = static_cast<decltype (book)> (gdata->bookdata);
 
@@ -181,7 +182,10 @@ price_parse_xml_end_handler (gpointer data_for_children,
         goto cleanup_and_exit;
     }
 
-    p = gnc_price_create (book);
+    if (dom_tree_find_guid (price_xml, "price:id", &guid))
+        p = gnc_price_create_for_load (book, &guid);
+    else
+        p = gnc_price_create (book);
     if (!p)
     {
         ok = FALSE;
@@ -270,6 +274,7 @@ pricedb_start_handler (GSList* sibling_data,
     GNCPriceDB* db = gnc_pricedb_get_db (book);
     g_return_val_if_fail (db, FALSE);
     gnc_pricedb_set_bulk_update (db, TRUE);
+    gnc_pricedb_begin_batch (db);
     *result = db;
     return (TRUE);
 }
@@ -300,7 +305,8 @@ pricedb_after_child_handler (gpointer data_for_children,
         GNCPrice* p = (GNCPrice*) child_result->data;
 
         g_return_val_if_fail (p, FALSE);
-        gnc_pricedb_add_price (db, p);
+        /* The parser drops p once it's been copied. */
+        gnc_pricedb_add_price_compact (db, p);
         gd->counter.prices_loaded++;
         sixtp_run_callback (gd, "prices");
         return TRUE;
@@ -343,6 +349,7 @@ pricedb_v2_end_handler (
         return TRUE;
     }
 
+    gnc_pricedb_end_batch (db);
     gdata->cb (tag, gdata->parsedata, db);
     *result = NULL;
 
@@ -0,0 +1,108 @@
+/********************************************************************
+ * gnc-transaction-record.h -- transactions read apart from a book  *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+ ********************************************************************/
+
+#ifndef GNC_TRANSACTION_RECORD_H
+#define GNC_TRANSACTION_RECORD_H
+
+#include <guid.hpp>
+extern "C"
+{
+#include <glib.h>
+#include "qof.h"
+}
+
+#include <kvp_frame.hpp>
+#include <string>
+#include <vector>
+
+/* A transaction and its splits as read from a file, without touching
+ * the book, so that it can be read in any thread. Each has_ flag says
+ * whether the file had the field; gnc_transaction_record_commit, in
+ * gnc-xml.h, then makes the transaction out of the fields it had.
+ */
+
+struct SplitRecord
+{
+    GncGUID guid;
+    bool has_guid;
+    std::string memo;
+    bool has_memo;
+    std::string action;
+    bool has_action;
+    char reconciled;
+    bool has_reconciled;
+    Timespec reconcile_date;
+    bool has_reconcile_date;
+    gnc_numeric value;
+    bool has_value;
+    gnc_numeric quantity;
+    bool has_quantity;
+    GncGUID account;
+    bool has_account;
+    GncGUID lot;
+    bool has_lot;
+    /* Owned by the record until committed. */
+    KvpFrame* slots;
+
+    SplitRecord () :
+        has_guid {false}, has_memo {false}, has_action {false},
+        reconciled {'\0'}, has_reconciled {false}, reconcile_date {0, 0},
+        has_reconcile_date {false}, value (gnc_numeric_zero ()),
+        has_value {false}, quantity (gnc_numeric_zero ()),
+        has_quantity {false}, has_account {false}, has_lot {false},
+        slots {nullptr} {}
+};
+
+struct TransactionRecord
+{
+    GncGUID guid;
+    bool has_guid;
+    std::string currency_space;
+    std::string currency_id;
+    bool has_currency;
+    bool currency_ok;
+    std::string num;
+    bool has_num;
+    std::string description;
+    bool has_description;
+    Timespec date_posted;
+    bool has_date_posted;
+    Timespec date_entered;
+    bool has_date_entered;
+    KvpFrame* slots;
+    std::vector<SplitRecord> splits;
+
+    TransactionRecord () :
+        has_guid {false}, has_currency {false}, currency_ok {false},
+        has_num {false}, has_description {false}, date_posted {0, 0},
+        has_date_posted {false}, date_entered {0, 0},
+        has_date_entered {false}, slots {nullptr} {}
+
+    ~TransactionRecord ()
+    {
+        delete slots;
+        for (auto& split : splits)
+            delete split.slots;
+    }
+};
+
+#endif /* GNC_TRANSACTION_RECORD_H */
@@ -22,6 +22,8 @@
  *                                                                  *
  *******************************************************************/
 #include <guid.hpp>
+#include <string>
+#include <vector>
 extern "C"
 {
 #include "config.h"
@@ -44,10 +46,14 @@ extern "C"
 #include "sixtp-dom-generators.h"
 
 #include "gnc-xml.h"
+#include "gnc-transaction-record.h"
 
 #include "io-gncxml-gen.h"
 
 #include "sixtp-dom-parsers.h"
+#include <kvp_frame.hpp>
+
+static QofLogModule log_module = GNC_MOD_IO;
 
 const gchar* transaction_version_string = "2.0.0";
 
@@ -195,6 +201,92 @@ gnc_transaction_dom_tree_create (Transaction* trn)
     return ret;
 }
 
+static void
+stream_timespec (GncXmlStream& out, const gchar* tag, Timespec tms,
+                 gboolean always)
+{
+    if (always || ! ((tms.tv_sec == 0) && (tms.tv_nsec == 0)))
+        timespec_to_xml_stream (out, tag, &tms);
+}
+
+static void
+stream_gnc_num (GncXmlStream& out, const gchar* tag, gnc_numeric num)
+{
+    gnc_numeric_to_xml_stream (out, tag, &num);
+}
+
+/* Writes what split_to_dom_tree builds. */
+static void
+split_to_xml_stream (GncXmlStream& out, const gchar* tag, Split* spl)
+{
+    const char* str;
+    char tmp[2];
+
+    out.start_element (tag);
+    guid_to_xml_stream (out, "split:id", xaccSplitGetGUID (spl));
+
+    str = xaccSplitGetMemo (spl);
+    if (str && g_strcmp0 (str, "") != 0)
+        out.text_element ("split:memo", str);
+
+    str = xaccSplitGetAction (spl);
+    if (str && g_strcmp0 (str, "") != 0)
+        out.text_element ("split:action", str);
+
+    tmp[0] = xaccSplitGetReconcile (spl);
+    tmp[1] = '\0';
+    out.text_element ("split:reconciled-state", tmp);
+
+    stream_timespec (out, "split:reconcile-date",
+                     xaccSplitRetDateReconciledTS (spl), FALSE);
+    stream_gnc_num (out, "split:value", xaccSplitGetValue (spl));
+    stream_gnc_num (out, "split:quantity", xaccSplitGetAmount (spl));
+    guid_to_xml_stream (out, "split:account",
+                        xaccAccountGetGUID (xaccSplitGetAccount (spl)));
+    {
+        GNCLot* lot = xaccSplitGetLot (spl);
+
+        if (lot)
+            guid_to_xml_stream (out, "split:lot", gnc_lot_get_guid (lot));
+    }
+    qof_instance_slots_to_xml_stream (out, "split:slots", QOF_INSTANCE (spl));
+    out.end_element ();
+}
+
+void
+gnc_transaction_to_xml_stream (GncXmlStream& out, Transaction* trn)
+{
+    const char* str;
+
+    out.start_element ("gnc:transaction", "version",
+                       transaction_version_string);
+    guid_to_xml_stream (out, "trn:id", xaccTransGetGUID (trn));
+    commodity_ref_to_xml_stream (out, "trn:currency",
+                                 xaccTransGetCurrency (trn));
+
+    str = xaccTransGetNum (trn);
+    if (str && (g_strcmp0 (str, "") != 0))
+        out.text_element ("trn:num", str);
+
+    stream_timespec (out, "trn:date-posted", xaccTransRetDatePostedTS (trn),
+                     TRUE);
+    stream_timespec (out, "trn:date-entered", xaccTransRetDateEnteredTS (trn),
+                     TRUE);
+
+    str = xaccTransGetDescription (trn);
+    if (str)
+        out.text_element ("trn:description", str);
+
+    qof_instance_slots_to_xml_stream (out, "trn:slots", QOF_INSTANCE (trn));
+
+    out.start_element ("trn:splits");
+    for (GList* n = xaccTransGetSplitList (trn); n; n = n->next)
+        split_to_xml_stream (out, "trn:split", static_cast<Split*> (n->data));
+    out.end_element ();
+
+    out.end_element ();
+}
+
 /***********************************************************************/
 
 struct split_pdata
@@ -385,10 +477,14 @@ dom_tree_to_split (xmlNodePtr node, QofBook* book)
 {
     struct split_pdata pdata;
     Split* ret;
+    GncGUID guid;
 
     g_return_val_if_fail (book, NULL);
 
-    ret = xaccMallocSplit (book);
+    if (dom_tree_find_guid (node, "split:id", &guid))
+        ret = xaccMallocSplitForLoad (book, &guid);
+    else
+        ret = xaccMallocSplit (book);
     g_return_val_if_fail (ret, NULL);
 
     pdata.split = ret;
@@ -616,11 +712,15 @@ dom_tree_to_transaction (xmlNodePtr node, QofBook* book)
     Transaction* trn;
     gboolean successful;
     struct trans_pdata pdata;
+    GncGUID guid;
 
     g_return_val_if_fail (node, NULL);
     g_return_val_if_fail (book, NULL);
 
-    trn = xaccMallocTransaction (book);
+    if (dom_tree_find_guid (node, "trn:id", &guid))
+        trn = xaccMallocTransactionForLoad (book, &guid);
+    else
+        trn = xaccMallocTransaction (book);
     g_return_val_if_fail (trn, NULL);
     xaccTransBeginEdit (trn);
 
@@ -643,8 +743,916 @@ dom_tree_to_transaction (xmlNodePtr node, QofBook* book)
     return trn;
 }
 
+/***********************************************************************/
+/* Streaming parser
+ *
+ * Reads each transaction, its splits and their KVP straight from the
+ * SAX events instead of building a DOM tree of it and then walking the
+ * tree with the handlers above. It follows those handlers: the same
+ * elements are required, an unknown element fails the split or
+ * transaction it's in, a failed split is dropped along with the splits
+ * after it, and slots that can't be read are skipped.
+ *
+ * The elements are read into a TransactionRecord, see
+ * gnc-transaction-record.h, which doesn't touch
+ * the book; gnc_transaction_record_commit then makes the transaction.
+ * So the reading can be done in other threads, see
+ * io-gncxml-v2.cpp.
+ */
+
+enum class StreamElem
+{
+    TRANSACTION,
+    TRN_FIELD,          // A text field of the transaction
+    CURRENCY,
+    CMDTY_FIELD,        // cmdty:space or cmdty:id in the currency
+    TIMESPEC,           // trn:date-posted, trn:date-entered, split:reconcile-date
+    TS_FIELD,           // ts:date or ts:ns
+    SPLITS,
+    SPLIT,
+    SPLIT_FIELD,        // A text field of the split
+    FRAME,              // trn:slots or split:slots
+    SLOT,
+    SLOT_KEY,
+    SLOT_VALUE,
+    GDATE,              // The gdate of a gdate slot value
+    IGNORED,            // Skipped along with everything in it
+};
+
+struct StreamFrame
+{
+    StreamElem elem;
+    /* Whether a guid element's type attribute says it holds a GUID. */
+    bool guid_type;
+    /* A slot value's type, or the commodity of a currency. */
+    std::string type;
+    std::string space;
+    /* The frame that slots go into, for FRAME and frame SLOT_VALUEs. */
+    KvpFrame* frame;
+    /* The values of a list SLOT_VALUE. */
+    GList* list;
+    /* A SLOT's key and value. */
+    std::string key;
+    bool have_key;
+    KvpValue* value;
+    /* A TIMESPEC's or timespec SLOT_VALUE's time. */
+    Timespec ts;
+    bool seen_s;
+    bool seen_ns;
+    bool bad;
+    /* A gdate SLOT_VALUE's date. */
+    GDate date;
+    bool seen_date;
+
+    explicit StreamFrame (StreamElem e) :
+        elem {e}, guid_type {false}, frame {nullptr}, list {nullptr},
+        have_key {false}, value {nullptr}, ts {0, 0}, seen_s {false},
+        seen_ns {false}, bad {false}, seen_date {false}
+    {
+        g_date_clear (&date, 1);
+    }
+};
+
+enum
+{
+    TRN_GOT_ID = 1 << 0,
+    TRN_GOT_DATE_POSTED = 1 << 1,
+    TRN_GOT_DATE_ENTERED = 1 << 2,
+    TRN_GOT_SPLITS = 1 << 3,
+    TRN_REQUIRED = (1 << 4) - 1,
+
+    SPL_GOT_ID = 1 << 0,
+    SPL_GOT_RECONCILED = 1 << 1,
+    SPL_GOT_VALUE = 1 << 2,
+    SPL_GOT_QUANTITY = 1 << 3,
+    SPL_GOT_ACCOUNT = 1 << 4,
+    SPL_REQUIRED = (1 << 5) - 1,
+};
+
+struct TransactionStream
+{
+    TransactionRecord* record;
+    bool trn_ok;
+    unsigned int trn_got;
+    SplitRecord split;
+    bool split_ok;
+    unsigned int split_got;
+    bool splits_done;           // A split failed; skip the rest
+    std::vector<StreamFrame> stack;
+    std::string text;
+
+    TransactionStream () :
+        record {new TransactionRecord}, trn_ok {true}, trn_got {0},
+        split_ok {true}, split_got {0}, splits_done {false} {}
+
+    ~TransactionStream ();
+    void start (const gchar* tag, gchar** attrs);
+    void end (const gchar* tag);
+    TransactionRecord* finish ();
+
+private:
+    void unhandled (const gchar* tag, bool& ok);
+    StreamElem child_elem (const StreamFrame& parent, const gchar* tag);
+    void end_trn_field (const gchar* tag, const StreamFrame& elem);
+    void end_split_field (const gchar* tag, const StreamFrame& elem);
+    void end_timespec (const gchar* tag, StreamFrame& elem);
+    KvpValue* slot_value (StreamFrame& elem);
+    void free_frame (StreamFrame& elem);
+};
+
+static bool
+guid_type_attr (gchar** attrs)
+{
+    /* As in dom_tree_to_guid, the type must be the first attribute. */
+    if (!attrs || !attrs[0] || g_strcmp0 (attrs[0], "type") != 0)
+    {
+        PERR ("Unknown attribute for id tag: %s",
+              attrs && attrs[0] ? attrs[0] : "(null)");
+        return false;
+    }
+    if (g_strcmp0 (attrs[1], "guid") != 0 && g_strcmp0 (attrs[1], "new") != 0)
+    {
+        PERR ("Unknown type %s for attribute type for tag %s",
+              attrs[1] ? attrs[1] : "(null)", attrs[0]);
+        return false;
+    }
+    return true;
+}
+
+/* Reads the GUID of a guid element; false if the element isn't one. */
+static bool
+stream_text_to_guid (const StreamFrame& elem, const std::string& text,
+                     GncGUID* guid)
+{
+    if (!elem.guid_type)
+        return false;
+    if (!string_to_guid (text.c_str (), guid))
+        guid_replace (guid);
+    return true;
+}
+
+static const char*
+slot_value_type (gchar** attrs)
+{
+    for (; attrs && attrs[0]; attrs += 2)
+        if (g_strcmp0 (attrs[0], "type") == 0)
+            return attrs[1] ? attrs[1] : "";
+    return "";
+}
+
+TransactionStream::~TransactionStream ()
+{
+    for (auto& elem : stack)
+        free_frame (elem);
+    delete split.slots;
+    delete record;
+}
+
+void
+TransactionStream::free_frame (StreamFrame& elem)
+{
+    if (elem.elem == StreamElem::SLOT_VALUE && elem.type == "frame")
+        delete elem.frame;
+    elem.frame = nullptr;
+    g_list_free_full (elem.list, [](gpointer v)
+    {
+        delete static_cast<KvpValue*> (v);
+    });
+    elem.list = nullptr;
+    delete elem.value;
+    elem.value = nullptr;
+}
+
+void
+TransactionStream::unhandled (const gchar* tag, bool& ok)
+{
+    PERR ("Unhandled tag: %s", tag ? tag : "(null)");
+    ok = false;
+}
+
+StreamElem
+TransactionStream::child_elem (const StreamFrame& parent, const gchar* tag)
+{
+    switch (parent.elem)
+    {
+    case StreamElem::TRANSACTION:
+        if (g_strcmp0 (tag, "trn:id") == 0 ||
+            g_strcmp0 (tag, "trn:num") == 0 ||
+            g_strcmp0 (tag, "trn:description") == 0)
+            return StreamElem::TRN_FIELD;
+        if (g_strcmp0 (tag, "trn:currency") == 0)
+            return StreamElem::CURRENCY;
+        if (g_strcmp0 (tag, "trn:date-posted") == 0 ||
+            g_strcmp0 (tag, "trn:date-entered") == 0)
+            return StreamElem::TIMESPEC;
+        if (g_strcmp0 (tag, "trn:slots") == 0)
+            return StreamElem::FRAME;
+        if (g_strcmp0 (tag, "trn:splits") == 0)
+            return StreamElem::SPLITS;
+        unhandled (tag, trn_ok);
+        return StreamElem::IGNORED;
+
+    case StreamElem::CURRENCY:
+        if (g_strcmp0 (tag, "cmdty:space") == 0 ||
+            g_strcmp0 (tag, "cmdty:id") == 0)
+            return StreamElem::CMDTY_FIELD;
+        return StreamElem::IGNORED;
+
+    case StreamElem::TIMESPEC:
+        if (g_strcmp0 (tag, "ts:date") == 0 || g_strcmp0 (tag, "ts:ns") == 0)
+            return StreamElem::TS_FIELD;
+        return StreamElem::IGNORED;
+
+    case StreamElem::SPLITS:
+        if (!splits_done && g_strcmp0 (tag, "trn:split") == 0)
+            return StreamElem::SPLIT;
+        splits_done = true;
+        return StreamElem::IGNORED;
+
+    case StreamElem::SPLIT:
+        if (g_strcmp0 (tag, "split:id") == 0 ||
+            g_strcmp0 (tag, "split:memo") == 0 ||
+            g_strcmp0 (tag, "split:action") == 0 ||
+            g_strcmp0 (tag, "split:reconciled-state") == 0 ||
+            g_strcmp0 (tag, "split:value") == 0 ||
+            g_strcmp0 (tag, "split:quantity") == 0 ||
+            g_strcmp0 (tag, "split:account") == 0 ||
+            g_strcmp0 (tag, "split:lot") == 0)
+            return StreamElem::SPLIT_FIELD;
+        if (g_strcmp0 (tag, "split:reconcile-date") == 0)
+            return StreamElem::TIMESPEC;
+        if (g_strcmp0 (tag, "split:slots") == 0)
+            return StreamElem::FRAME;
+        unhandled (tag, split_ok);
+        return StreamElem::IGNORED;
+
+    case StreamElem::FRAME:
+        if (g_strcmp0 (tag, "slot") == 0)
+            return StreamElem::SLOT;
+        return StreamElem::IGNORED;
+
+    case StreamElem::SLOT:
+        if (g_strcmp0 (tag, "slot:key") == 0)
+            return StreamElem::SLOT_KEY;
+        if (g_strcmp0 (tag, "slot:value") == 0)
+            return StreamElem::SLOT_VALUE;
+        return StreamElem::IGNORED;
+
+    case StreamElem::SLOT_VALUE:
+        if (parent.type == "frame" && g_strcmp0 (tag, "slot") == 0)
+            return StreamElem::SLOT;
+        if (parent.type == "list")
+            return StreamElem::SLOT_VALUE;
+        if (parent.type == "timespec" &&
+            (g_strcmp0 (tag, "ts:date") == 0 || g_strcmp0 (tag, "ts:ns") == 0))
+            return StreamElem::TS_FIELD;
+        if (parent.type == "gdate" && g_strcmp0 (tag, "gdate") == 0)
+            return StreamElem::GDATE;
+        return StreamElem::IGNORED;
+
+    default:
+        return StreamElem::IGNORED;
+    }
+}
+
+void
+TransactionStream::start (const gchar* tag, gchar** attrs)
+{
+    text.clear ();
+    if (stack.empty ())
+    {
+        stack.emplace_back (StreamElem::TRANSACTION);
+        return;
+    }
+
+    StreamElem elem = child_elem (stack.back (), tag);
+    stack.emplace_back (elem);
+    auto& frame = stack.back ();
+    switch (elem)
+    {
+    case StreamElem::TRN_FIELD:
+    case StreamElem::SPLIT_FIELD:
+        if (g_strcmp0 (tag, "trn:id") == 0 ||
+            g_strcmp0 (tag, "split:id") == 0 ||
+            g_strcmp0 (tag, "split:account") == 0 ||
+            g_strcmp0 (tag, "split:lot") == 0)
+            frame.guid_type = guid_type_attr (attrs);
+        break;
+
+    case StreamElem::CURRENCY:
+        record->has_currency = true;
+        break;
+
+    case StreamElem::SPLITS:
+        trn_got |= TRN_GOT_SPLITS;
+        break;
+
+    case StreamElem::SPLIT:
+        split = SplitRecord ();
+        split_ok = true;
+        split_got = 0;
+        break;
+
+    case StreamElem::FRAME:
+    {
+        auto& slots = stack[stack.size () - 2].elem == StreamElem::SPLIT ?
+                      split.slots : record->slots;
+        if (!slots)
+            slots = new KvpFrame;
+        frame.frame = slots;
+        break;
+    }
+
+    case StreamElem::SLOT_VALUE:
+        frame.type = slot_value_type (attrs);
+        if (frame.type == "frame")
+            frame.frame = new KvpFrame;
+        else if (frame.type == "guid")
+            frame.guid_type = guid_type_attr (attrs);
+        break;
+
+    default:
+        break;
+    }
+}
+
+void
+TransactionStream::end_trn_field (const gchar* tag, const StreamFrame& elem)
+{
+    if (g_strcmp0 (tag, "trn:id") == 0)
+    {
+        if (stream_text_to_guid (elem, text, &record->guid))
+            record->has_guid = true;
+        trn_got |= TRN_GOT_ID;
+    }
+    else if (g_strcmp0 (tag, "trn:num") == 0)
+    {
+        record->num = text;
+        record->has_num = true;
+    }
+    else if (g_strcmp0 (tag, "trn:description") == 0)
+    {
+        record->description = text;
+        record->has_description = true;
+    }
+}
+
+void
+TransactionStream::end_split_field (const gchar* tag, const StreamFrame& elem)
+{
+    if (g_strcmp0 (tag, "split:id") == 0)
+    {
+        if (stream_text_to_guid (elem, text, &split.guid))
+            split.has_guid = true;
+        split_got |= SPL_GOT_ID;
+    }
+    else if (g_strcmp0 (tag, "split:memo") == 0)
+    {
+        split.memo = text;
+        split.has_memo = true;
+    }
+    else if (g_strcmp0 (tag, "split:action") == 0)
+    {
+        split.action = text;
+        split.has_action = true;
+    }
+    else if (g_strcmp0 (tag, "split:reconciled-state") == 0)
+    {
+        split.reconciled = text.empty () ? '\0' : text[0];
+        split.has_reconciled = true;
+        split_got |= SPL_GOT_RECONCILED;
+    }
+    else if (g_strcmp0 (tag, "split:value") == 0)
+    {
+        if (string_to_gnc_numeric (text.c_str (), &split.value))
+            split.has_value = true;
+        split_got |= SPL_GOT_VALUE;
+    }
+    else if (g_strcmp0 (tag, "split:quantity") == 0)
+    {
+        if (string_to_gnc_numeric (text.c_str (), &split.quantity))
+            split.has_quantity = true;
+        split_got |= SPL_GOT_QUANTITY;
+    }
+    else if (g_strcmp0 (tag, "split:account") == 0)
+    {
+        if (stream_text_to_guid (elem, text, &split.account))
+            split.has_account = true;
+        split_got |= SPL_GOT_ACCOUNT;
+    }
+    else if (g_strcmp0 (tag, "split:lot") == 0)
+    {
+        if (stream_text_to_guid (elem, text, &split.lot))
+            split.has_lot = true;
+    }
+}
+
+void
+TransactionStream::end_timespec (const gchar* tag, StreamFrame& elem)
+{
+    Timespec ts = elem.ts;
+    if (elem.bad || !elem.seen_s)
+    {
+        if (!elem.seen_s && !elem.bad)
+            PERR ("no ts:date node found.");
+        ts.tv_sec = ts.tv_nsec = 0;
+    }
+
+    bool valid = dom_tree_valid_timespec (&ts, BAD_CAST tag);
+    if (g_strcmp0 (tag, "trn:date-posted") == 0)
+    {
+        record->date_posted = ts;
+        record->has_date_posted = valid;
+        trn_got |= TRN_GOT_DATE_POSTED;
+    }
+    else if (g_strcmp0 (tag, "trn:date-entered") == 0)
+    {
+        record->date_entered = ts;
+        record->has_date_entered = valid;
+        trn_got |= TRN_GOT_DATE_ENTERED;
+    }
+    else if (valid)
+    {
+        split.reconcile_date = ts;
+        split.has_reconcile_date = true;
+    }
+}
+
+KvpValue*
+TransactionStream::slot_value (StreamFrame& elem)
+{
+    KvpValue* ret = nullptr;
+    const auto& type = elem.type;
+    if (type == "integer")
+    {
+        gint64 daint;
+        if (string_to_gint64 (text.c_str (), &daint))
+            ret = new KvpValue {daint};
+    }
+    else if (type == "double")
+    {
+        double dadoub;
+        if (string_to_double (text.c_str (), &dadoub))
+            ret = new KvpValue {dadoub};
+    }
+    else if (type == "numeric")
+    {
+        gnc_numeric danum;
+        if (string_to_gnc_numeric (text.c_str (), &danum))
+            ret = new KvpValue {danum};
+    }
+    else if (type == "string")
+        ret = new KvpValue {g_strdup (text.c_str ())};
+    else if (type == "guid")
+    {
+        auto gid = guid_malloc ();
+        if (stream_text_to_guid (elem, text, gid))
+            ret = new KvpValue {gid};
+        else
+            guid_free (gid);
+    }
+    else if (type == "timespec")
+    {
+        Timespec ts = elem.ts;
+        if (elem.bad || !elem.seen_s)
+        {
+            if (!elem.seen_s && !elem.bad)
+                PERR ("no ts:date node found.");
+            ts.tv_sec = ts.tv_nsec = 0;
+        }
+        ret = new KvpValue {ts};
+    }
+    else if (type == "gdate")
+    {
+        if (!elem.seen_date)
+            PWARN ("no gdate node found.");
+        else if (!elem.bad)
+            ret = new KvpValue {elem.date};
+    }
+    else if (type == "list")
+    {
+        ret = new KvpValue {elem.list};
+        elem.list = nullptr;
+    }
+    else if (type == "frame")
+    {
+        ret = new KvpValue {elem.frame};
+        elem.frame = nullptr;
+    }
+    return ret;
+}
+
+void
+TransactionStream::end (const gchar* tag)
+{
+    g_return_if_fail (!stack.empty ());
+    StreamFrame elem = std::move (stack.back ());
+    stack.pop_back ();
+    StreamFrame* parent = stack.empty () ? nullptr : &stack.back ();
+
+    switch (elem.elem)
+    {
+    case StreamElem::TRN_FIELD:
+        end_trn_field (tag, elem);
+        break;
+
+    case StreamElem::CURRENCY:
+        record->currency_ok = !elem.bad && !elem.space.empty () &&
+                              !elem.type.empty ();
+        record->currency_space = elem.space;
+        record->currency_id = elem.type;
+        break;
+
+    case StreamElem::CMDTY_FIELD:
+    {
+        auto& field = g_strcmp0 (tag, "cmdty:space") == 0 ?
+                      parent->space : parent->type;
+        if (!field.empty ())
+            parent->bad = true;
+        else
+        {
+            gchar* stripped = g_strstrip (g_strdup (text.c_str ()));
+            field = stripped;
+            g_free (stripped);
+        }
+        break;
+    }
+
+    case StreamElem::TIMESPEC:
+        end_timespec (tag, elem);
+        break;
+
+    case StreamElem::TS_FIELD:
+        if (g_strcmp0 (tag, "ts:date") == 0)
+        {
+            if (parent->seen_s ||
+                !string_to_timespec_secs (text.c_str (), &parent->ts))
+                parent->bad = true;
+            parent->seen_s = true;
+        }
+        else
+        {
+            if (parent->seen_ns ||
+                !string_to_timespec_nsecs (text.c_str (), &parent->ts))
+                parent->bad = true;
+            parent->seen_ns = true;
+        }
+        break;
+
+    case StreamElem::SPLIT_FIELD:
+        end_split_field (tag, elem);
+        break;
+
+    case StreamElem::SPLIT:
+        if ((split_got & SPL_REQUIRED) != SPL_REQUIRED)
+        {
+            PERR ("didn't find all of the expected tags in the input");
+            split_ok = false;
+        }
+        if (split_ok)
+            record->splits.push_back (std::move (split));
+        else
+        {
+            delete split.slots;
+            splits_done = true;
+        }
+        split.slots = nullptr;
+        break;
+
+    case StreamElem::SLOT_KEY:
+        parent->key = text;
+        parent->have_key = true;
+        break;
+
+    case StreamElem::GDATE:
+    {
+        gint year, month, day;
+        if (parent->seen_date ||
+            sscanf (text.c_str (), "%d-%d-%d", &year, &month, &day) != 3)
+            parent->bad = true;
+        else
+        {
+            g_date_set_dmy (&parent->date, day,
+                            static_cast<GDateMonth> (month), year);
+            if (!g_date_valid (&parent->date))
+            {
+                PWARN ("invalid date");
+                parent->bad = true;
+            }
+        }
+        parent->seen_date = true;
+        break;
+    }
+
+    case StreamElem::SLOT_VALUE:
+    {
+        auto val = slot_value (elem);
+        if (!val)
+            break;
+        if (parent->elem == StreamElem::SLOT)
+        {
+            delete parent->value;
+            parent->value = val;
+        }
+        else
+            parent->list = g_list_append (parent->list, val);
+        break;
+    }
+
+    case StreamElem::SLOT:
+        if (elem.have_key && elem.value)
+        {
+            delete parent->frame->set (elem.key.c_str (), elem.value);
+            elem.value = nullptr;
+        }
+        break;
+
+    case StreamElem::TRANSACTION:
+        if ((trn_got & TRN_REQUIRED) != TRN_REQUIRED)
+        {
+            PERR ("didn't find all of the expected tags in the input");
+            trn_ok = false;
+        }
+        break;
+
+    default:
+        break;
+    }
+    free_frame (elem);
+    text.clear ();
+}
+
+/* Hands over the record if the transaction was read successfully. */
+TransactionRecord*
+TransactionStream::finish ()
+{
+    TransactionRecord* ret = nullptr;
+    if (trn_ok)
+        ret = record;
+    else
+    {
+        PERR ("Failed to read transaction");
+        delete record;
+    }
+    record = nullptr;
+    return ret;
+}
+
+static void
+split_record_commit (SplitRecord& rec, Split* split, QofBook* book)
+{
+    if (rec.has_guid)
+        xaccSplitSetGUID (split, &rec.guid);
+    if (rec.has_memo)
+        xaccSplitSetMemo (split, rec.memo.c_str ());
+    if (rec.has_action)
+        xaccSplitSetAction (split, rec.action.c_str ());
+    if (rec.has_reconciled)
+        xaccSplitSetReconcile (split, rec.reconciled);
+    if (rec.has_reconcile_date)
+        xaccSplitSetDateReconciledTS (split, &rec.reconcile_date);
+    if (rec.has_value)
+        xaccSplitSetValue (split, rec.value);
+    if (rec.has_quantity)
+        xaccSplitSetAmount (split, rec.quantity);
+    if (rec.has_account)
+    {
+        auto account = xaccAccountLookup (&rec.account, book);
+        if (!account && gnc_transaction_xml_v2_testing &&
+            !guid_equal (&rec.account, guid_null ()))
+        {
+            account = xaccMallocAccount (book);
+            xaccAccountSetGUID (account, &rec.account);
+            xaccAccountSetCommoditySCU (account,
+                                        xaccSplitGetAmount (split).denom);
+        }
+        xaccAccountInsertSplit (account, split);
+    }
+    if (rec.has_lot)
+    {
+        auto lot = gnc_lot_lookup (&rec.lot, book);
+        if (!lot && gnc_transaction_xml_v2_testing &&
+            !guid_equal (&rec.lot, guid_null ()))
+        {
+            lot = gnc_lot_new (book);
+            gnc_lot_set_guid (lot, rec.lot);
+        }
+        gnc_lot_add_split (lot, split);
+    }
+    if (rec.slots)
+    {
+        qof_instance_set_slots (QOF_INSTANCE (split), rec.slots);
+        rec.slots = nullptr;
+    }
+}
+
+Transaction*
+gnc_transaction_record_commit (TransactionRecord* rec, QofBook* book)
+{
+    g_return_val_if_fail (rec, NULL);
+    g_return_val_if_fail (book, NULL);
+
+    auto trn = rec->has_guid ? xaccMallocTransactionForLoad (book, &rec->guid) :
+                               xaccMallocTransaction (book);
+    xaccTransBeginEdit (trn);
+
+    /* Only does anything if another transaction had the guid. */
+    if (rec->has_guid)
+        xaccTransSetGUID (trn, &rec->guid);
+    if (rec->has_currency)
+    {
+        gnc_commodity* ref = NULL;
+        if (rec->currency_ok)
+            ref = gnc_commodity_table_lookup (
+                gnc_commodity_table_get_table (book),
+                rec->currency_space.c_str (), rec->currency_id.c_str ());
+        if (!ref)
+            PERR ("Unknown currency for transaction");
+        xaccTransSetCurrency (trn, ref);
+    }
+    if (rec->has_num)
+        xaccTransSetNum (trn, rec->num.c_str ());
+    if (rec->has_date_posted)
+        xaccTransSetDatePostedTS (trn, &rec->date_posted);
+    if (rec->has_date_entered)
+        xaccTransSetDateEnteredTS (trn, &rec->date_entered);
+    if (rec->has_description)
+        xaccTransSetDescription (trn, rec->description.c_str ());
+    if (rec->slots)
+    {
+        qof_instance_set_slots (QOF_INSTANCE (trn), rec->slots);
+        rec->slots = nullptr;
+    }
+    for (auto& split_rec : rec->splits)
+    {
+        auto split = split_rec.has_guid ?
+                     xaccMallocSplitForLoad (book, &split_rec.guid) :
+                     xaccMallocSplit (book);
+        split_record_commit (split_rec, split, book);
+        xaccTransAppendSplit (trn, split);
+    }
+
+    xaccTransCommitEdit (trn);
+    delete rec;
+    return trn;
+}
+
+void
+gnc_transaction_record_free (TransactionRecord* rec)
+{
+    delete rec;
+}
+
+const GncGUID*
+gnc_transaction_record_get_guid (const TransactionRecord* rec)
+{
+    g_return_val_if_fail (rec, NULL);
+    return rec->has_guid ? &rec->guid : NULL;
+}
+
+static gboolean
+txn_stream_start_handler (GSList* sibling_data, gpointer parent_data,
+                          gpointer global_data, gpointer* data_for_children,
+                          gpointer* result, const gchar* tag, gchar** attrs)
+{
+    TransactionStream* stream = static_cast<TransactionStream*> (parent_data);
+
+    if (!stream)
+    {
+        stream = new TransactionStream;
+        /* Published only by the top element, for the fail handler. */
+        *result = stream;
+    }
+    *data_for_children = stream;
+    stream->start (tag, attrs);
+    return TRUE;
+}
+
+static gboolean
+txn_stream_chars_handler (GSList* sibling_data, gpointer parent_data,
+                          gpointer global_data, gpointer* result,
+                          const char* text, int length)
+{
+    TransactionStream* stream = static_cast<TransactionStream*> (parent_data);
+    if (stream && length > 0)
+        stream->text.append (text, length);
+    return TRUE;
+}
+
+/* Finishes the element. Returns TRUE once the transaction itself has
+ * ended, with its record in *rec, or NULL there if it failed. */
+static gboolean
+txn_stream_end (gpointer data_for_children, gpointer parent_data,
+                gpointer* result, const gchar* tag, TransactionRecord** rec)
+{
+    TransactionStream* stream =
+        static_cast<TransactionStream*> (data_for_children);
+
+    *rec = NULL;
+    /* See gnc_transaction_end_handler about the NULL tag. */
+    if (!tag || !stream)
+        return FALSE;
+
+    stream->end (tag);
+    if (parent_data)
+        return FALSE;
+
+    *rec = stream->finish ();
+    delete stream;
+    *result = NULL;
+    return TRUE;
+}
+
+static gboolean
+txn_stream_end_handler (gpointer data_for_children,
+                        GSList* data_from_children, GSList* sibling_data,
+                        gpointer parent_data, gpointer global_data,
+                        gpointer* result, const gchar* tag)
+{
+    gxpf_data* gdata = static_cast<gxpf_data*> (global_data);
+    TransactionRecord* rec;
+    Transaction* trn = NULL;
+
+    if (!txn_stream_end (data_for_children, parent_data, result, tag, &rec))
+        return TRUE;
+
+    if (rec)
+        trn = gnc_transaction_record_commit (
+                  rec, static_cast<QofBook*> (gdata->bookdata));
+    if (trn != NULL)
+        gdata->cb (tag, gdata->parsedata, trn);
+    return trn != NULL;
+}
+
+static gboolean
+txn_record_end_handler (gpointer data_for_children,
+                        GSList* data_from_children, GSList* sibling_data,
+                        gpointer parent_data, gpointer global_data,
+                        gpointer* result, const gchar* tag)
+{
+    gxpf_data* gdata = static_cast<gxpf_data*> (global_data);
+    TransactionRecord* rec;
+
+    if (!txn_stream_end (data_for_children, parent_data, result, tag, &rec))
+        return TRUE;
+
+    if (rec != NULL)
+        gdata->cb (tag, gdata->parsedata, rec);
+    return rec != NULL;
+}
+
+static void
+txn_stream_fail_handler (gpointer data_for_children,
+                         GSList* data_from_children, GSList* sibling_data,
+                         gpointer parent_data, gpointer global_data,
+                         gpointer* result, const gchar* tag)
+{
+    delete static_cast<TransactionStream*> (*result);
+    *result = NULL;
+}
+
+static sixtp*
+gnc_transaction_stream_parser_new (sixtp_end_handler ender)
+{
+    sixtp* top_level;
+
+    if (! (top_level =
+               sixtp_set_any (sixtp_new (), FALSE,
+                              SIXTP_START_HANDLER_ID, txn_stream_start_handler,
+                              SIXTP_CHARACTERS_HANDLER_ID, txn_stream_chars_handler,
+                              SIXTP_END_HANDLER_ID, ender,
+                              SIXTP_FAIL_HANDLER_ID, txn_stream_fail_handler,
+                              SIXTP_NO_MORE_HANDLERS)))
+    {
+        return NULL;
+    }
+
+    if (!sixtp_add_sub_parser (top_level, SIXTP_MAGIC_CATCHER, top_level))
+    {
+        sixtp_destroy (top_level);
+        return NULL;
+    }
+    return top_level;
+}
+
 sixtp*
-gnc_transaction_sixtp_parser_create (void)
+gnc_transaction_record_sixtp_parser_create (void)
+{
+    return gnc_transaction_stream_parser_new (txn_record_end_handler);
+}
+
+sixtp*
+gnc_transaction_dom_sixtp_parser_create (void)
 {
     return sixtp_dom_parser_new (gnc_transaction_end_handler, NULL, NULL);
 }
+
+/* The DOM parser stays available for files the streaming one can't
+ * read; set GNC_XML_DOM_PARSER in the environment to use it. */
+sixtp*
+gnc_transaction_sixtp_parser_create (void)
+{
+    if (g_getenv ("GNC_XML_DOM_PARSER"))
+        return gnc_transaction_dom_sixtp_parser_create ();
+    return gnc_transaction_stream_parser_new (txn_stream_end_handler);
+}
@@ -36,6 +36,8 @@ extern "C"
 #include "gnc-xml-helper.h"
 #include "sixtp.h"
 
+class GncXmlStream;
+
 xmlNodePtr gnc_account_dom_tree_create (Account* act, gboolean exporting,
                                         gboolean allow_incompat);
 sixtp* gnc_account_sixtp_parser_create (void);
@@ -63,7 +65,24 @@ xmlNodePtr gnc_budget_dom_tree_create (GncBudget* bgt);
 sixtp* gnc_budget_sixtp_parser_create (void);
 
 xmlNodePtr gnc_transaction_dom_tree_create (Transaction* txn);
+/** Writes what gnc_transaction_dom_tree_create builds without building it. */
+void gnc_transaction_to_xml_stream (GncXmlStream& out, Transaction* txn);
 sixtp* gnc_transaction_sixtp_parser_create (void);
+/** Builds each transaction from a DOM tree of it instead of streaming.
+ *  Used instead of the streaming parser when GNC_XML_DOM_PARSER is set. */
+sixtp* gnc_transaction_dom_sixtp_parser_create (void);
+
+/** A transaction read from the file but not yet made in a book. */
+struct TransactionRecord;
+/** Reads each transaction into a TransactionRecord and hands that to the
+ *  callback. It doesn't use the book, so it may run in any thread. */
+sixtp* gnc_transaction_record_sixtp_parser_create (void);
+/** Makes the transaction of @a rec in @a book and frees @a rec. */
+Transaction* gnc_transaction_record_commit (TransactionRecord* rec,
+                                            QofBook* book);
+void gnc_transaction_record_free (TransactionRecord* rec);
+/** The GUID the record was read with, or NULL if it had none. */
+const GncGUID* gnc_transaction_record_get_guid (const TransactionRecord* rec);
 
 sixtp* gnc_template_transaction_sixtp_parser_create (void);
 
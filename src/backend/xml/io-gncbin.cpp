@@ -0,0 +1,1172 @@
+/********************************************************************\
+ * io-gncbin.cpp -- read and write the binary GnuCash file format   *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+\********************************************************************/
+#include <guid.hpp>
+extern "C"
+{
+#include "config.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <string.h>
+#ifndef G_OS_WIN32
+# include <sys/mman.h>
+#endif
+
+#include "gnc-engine.h"
+#include "Account.h"
+#include "Split.h"
+#include "Transaction.h"
+#include "gnc-commodity.h"
+#include "gnc-lot.h"
+}
+
+#include <kvp_frame.hpp>
+#include <algorithm>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "gnc-xml.h"
+#include "gnc-transaction-record.h"
+#include "io-gncxml-v2.h"
+#include "io-gncbin.h"
+
+static QofLogModule log_module = GNC_MOD_IO;
+
+/* The file starts with a header: the magic, the format version, the
+ * number of sections and where the index of them is. The index has an
+ * entry per section: its type, a reserved word, its offset and its
+ * length. Everything is little-endian and each section starts on an
+ * 8 byte boundary, as does each column in it. */
+static const char bin_magic[8] = { 'G', 'N', 'C', 'B', 'I', 'N', '\r', '\n' };
+static const guint32 bin_version = 1;
+#define BIN_HEADER_LEN 24
+#define BIN_INDEX_ENTRY_LEN 24
+
+enum
+{
+    BIN_SECTION_STRINGS = 1,
+    BIN_SECTION_XML,
+    BIN_SECTION_TRANSACTIONS,
+    BIN_SECTION_SPLITS,
+    BIN_SECTION_SLOTS,
+    BIN_SECTION_LAST = BIN_SECTION_SLOTS
+};
+
+/* The columns of the transaction and split sections, each after the
+ * number of rows. Text is an index into the string table, 0 for none.
+ * Slots are an offset into the slot section plus one, 0 for none. */
+enum
+{
+    TRN_COL_GUID,
+    TRN_COL_CURRENCY_SPACE,
+    TRN_COL_CURRENCY_ID,
+    TRN_COL_NUM,
+    TRN_COL_DESCRIPTION,
+    TRN_COL_POSTED_SEC,
+    TRN_COL_POSTED_NSEC,
+    TRN_COL_ENTERED_SEC,
+    TRN_COL_ENTERED_NSEC,
+    TRN_COL_SLOTS,
+    TRN_COL_N_SPLITS,
+    TRN_N_COLS
+};
+static const gsize trn_col_width[TRN_N_COLS] =
+{ 16, 4, 4, 4, 4, 8, 8, 8, 8, 8, 4 };
+
+enum
+{
+    SPL_COL_GUID,
+    SPL_COL_MEMO,
+    SPL_COL_ACTION,
+    SPL_COL_RECONCILED,
+    SPL_COL_RECONCILE_SEC,
+    SPL_COL_RECONCILE_NSEC,
+    SPL_COL_VALUE_NUM,
+    SPL_COL_VALUE_DENOM,
+    SPL_COL_QUANTITY_NUM,
+    SPL_COL_QUANTITY_DENOM,
+    SPL_COL_ACCOUNT,
+    SPL_COL_LOT,
+    SPL_COL_SLOTS,
+    SPL_N_COLS
+};
+static const gsize spl_col_width[SPL_N_COLS] =
+{ 16, 4, 4, 1, 8, 8, 8, 8, 8, 8, 16, 16, 8 };
+
+/* Slot values are a type byte, the values of KvpValue::Type, then: */
+/* INT64: 8 bytes. DOUBLE: its 8 bytes. NUMERIC: num and denom of 8.
+ * STRING: a string index of 4. GUID: 16 bytes. TIMESPEC: seconds and
+ * nanoseconds of 8. GDATE: its Julian day in 4. GLIST: a count of 4
+ * and the values. FRAME: a count of 4 and that many string indexes of
+ * keys of 4, each followed by its value. */
+static const int max_slot_depth = 64;
+
+/* Transactions decoded in one thread at least. */
+static const gsize min_decode_chunk = 4096;
+
+static inline gsize
+pad8 (gsize len)
+{
+    return (len + 7) & ~static_cast<gsize> (7);
+}
+
+/* Where each column starts in a section of rows rows, and the length
+ * of the section. */
+static gsize
+column_layout (const gsize* widths, int n_cols, guint64 rows, gsize* offsets)
+{
+    gsize pos = 8;
+    for (int i = 0; i < n_cols; ++i)
+    {
+        offsets[i] = pos;
+        pos += pad8 (widths[i] * rows);
+    }
+    return pos;
+}
+
+/***********************************************************************/
+/* Writing */
+
+static void
+put_u8 (std::string& out, guint8 val)
+{
+    out.push_back (static_cast<char> (val));
+}
+
+static void
+put_u32 (std::string& out, guint32 val)
+{
+    val = GUINT32_TO_LE (val);
+    out.append (reinterpret_cast<const char*> (&val), 4);
+}
+
+static void
+put_u64 (std::string& out, guint64 val)
+{
+    val = GUINT64_TO_LE (val);
+    out.append (reinterpret_cast<const char*> (&val), 8);
+}
+
+static void
+put_i64 (std::string& out, gint64 val)
+{
+    put_u64 (out, static_cast<guint64> (val));
+}
+
+static void
+put_guid (std::string& out, const GncGUID* guid)
+{
+    if (guid)
+        out.append (reinterpret_cast<const char*> (guid->reserved),
+                    GUID_DATA_SIZE);
+    else
+        out.append (GUID_DATA_SIZE, '\0');
+}
+
+static void
+patch_u32 (std::string& out, gsize pos, guint32 val)
+{
+    val = GUINT32_TO_LE (val);
+    memcpy (&out[pos], &val, 4);
+}
+
+struct bin_string_table
+{
+    std::unordered_map<std::string, guint32> ids;
+    std::vector<guint64> offsets;
+    std::string blob;
+
+    bin_string_table () : offsets (1, 0) {}
+};
+
+/* The index of str in the table, adding it if it's new. */
+static guint32
+intern_string (bin_string_table& table, const char* str)
+{
+    if (!str)
+        return 0;
+    auto found = table.ids.find (str);
+    if (found != table.ids.end ())
+        return found->second;
+    guint32 id = table.offsets.size ();
+    table.offsets.push_back (table.blob.size ());
+    table.blob.append (str, strlen (str) + 1);
+    table.ids.emplace (str, id);
+    return id;
+}
+
+/* Only non-empty text is kept, as in the XML. */
+static guint32
+intern_text (bin_string_table& table, const char* str)
+{
+    return str && *str ? intern_string (table, str) : 0;
+}
+
+struct slot_writer
+{
+    std::string* out;
+    bin_string_table* strings;
+    guint32 count;
+    int depth;
+};
+
+static gboolean encode_value (slot_writer* writer, KvpValue* val);
+
+static void
+encode_slot (const char* key, KvpValue* value, void* data)
+{
+    slot_writer* writer = static_cast<slot_writer*> (data);
+    gsize mark = writer->out->size ();
+
+    put_u32 (*writer->out, intern_string (*writer->strings, key));
+    if (encode_value (writer, value))
+        writer->count++;
+    else
+        writer->out->resize (mark);
+}
+
+static void
+encode_frame (slot_writer* writer, KvpFrame* frame)
+{
+    slot_writer inner = { writer->out, writer->strings, 0, writer->depth + 1 };
+    gsize count_pos = writer->out->size ();
+
+    put_u32 (*writer->out, 0);
+    if (frame)
+        frame->for_each_slot (encode_slot, &inner);
+    patch_u32 (*writer->out, count_pos, inner.count);
+}
+
+/* Returns FALSE, having written something to be cut off again, for a
+ * value the XML would drop too. */
+static gboolean
+encode_value (slot_writer* writer, KvpValue* val)
+{
+    std::string& out = *writer->out;
+    auto type = val->get_type ();
+
+    if (writer->depth >= max_slot_depth)
+        return FALSE;
+    put_u8 (out, static_cast<guint8> (type));
+    switch (type)
+    {
+    case KvpValue::Type::INT64:
+        put_i64 (out, val->get<int64_t> ());
+        return TRUE;
+    case KvpValue::Type::DOUBLE:
+    {
+        double d = val->get<double> ();
+        guint64 bits;
+        memcpy (&bits, &d, 8);
+        put_u64 (out, bits);
+        return TRUE;
+    }
+    case KvpValue::Type::NUMERIC:
+    {
+        auto num = val->get<gnc_numeric> ();
+        put_i64 (out, num.num);
+        put_i64 (out, num.denom);
+        return TRUE;
+    }
+    case KvpValue::Type::STRING:
+    {
+        const char* str = val->get<const char*> ();
+        if (!str)
+            return FALSE;
+        put_u32 (out, intern_string (*writer->strings, str));
+        return TRUE;
+    }
+    case KvpValue::Type::GUID:
+        if (!val->get<GncGUID*> ())
+            return FALSE;
+        put_guid (out, val->get<GncGUID*> ());
+        return TRUE;
+    case KvpValue::Type::TIMESPEC:
+    {
+        auto ts = val->get<Timespec> ();
+        put_i64 (out, ts.tv_sec);
+        put_i64 (out, ts.tv_nsec);
+        return TRUE;
+    }
+    case KvpValue::Type::GDATE:
+    {
+        auto date = val->get<GDate> ();
+        if (!g_date_valid (&date))
+            return FALSE;
+        put_u32 (out, g_date_get_julian (&date));
+        return TRUE;
+    }
+    case KvpValue::Type::GLIST:
+    {
+        slot_writer inner = { writer->out, writer->strings, 0,
+                              writer->depth + 1
+                            };
+        gsize count_pos = out.size ();
+        put_u32 (out, 0);
+        for (auto cursor = val->get<GList*> (); cursor; cursor = cursor->next)
+        {
+            gsize mark = out.size ();
+            if (encode_value (&inner, static_cast<KvpValue*> (cursor->data)))
+                inner.count++;
+            else
+                out.resize (mark);
+        }
+        patch_u32 (out, count_pos, inner.count);
+        return TRUE;
+    }
+    case KvpValue::Type::FRAME:
+        encode_frame (writer, val->get<KvpFrame*> ());
+        return TRUE;
+    default:
+        return FALSE;
+    }
+}
+
+/* The slot column's entry for the instance. */
+static guint64
+encode_slots (std::string& slots, bin_string_table& strings,
+              QofInstance* inst)
+{
+    KvpFrame* frame = qof_instance_get_slots (inst);
+    slot_writer writer = { &slots, &strings, 0, 0 };
+
+    if (!frame)
+        return 0;
+    guint64 entry = slots.size () + 1;
+    encode_frame (&writer, frame);
+    return entry;
+}
+
+struct bin_book_writer
+{
+    bin_string_table strings;
+    std::string slots;
+    std::string trn_cols[TRN_N_COLS];
+    std::string spl_cols[SPL_N_COLS];
+    guint64 n_transactions;
+    guint64 n_splits;
+};
+
+static void
+encode_split (bin_book_writer* writer, Split* spl)
+{
+    std::string* cols = writer->spl_cols;
+    Timespec ts = xaccSplitRetDateReconciledTS (spl);
+    gnc_numeric value = xaccSplitGetValue (spl);
+    gnc_numeric quantity = xaccSplitGetAmount (spl);
+    Account* account = xaccSplitGetAccount (spl);
+    GNCLot* lot = xaccSplitGetLot (spl);
+
+    put_guid (cols[SPL_COL_GUID], xaccSplitGetGUID (spl));
+    put_u32 (cols[SPL_COL_MEMO],
+             intern_text (writer->strings, xaccSplitGetMemo (spl)));
+    put_u32 (cols[SPL_COL_ACTION],
+             intern_text (writer->strings, xaccSplitGetAction (spl)));
+    put_u8 (cols[SPL_COL_RECONCILED], xaccSplitGetReconcile (spl));
+    put_i64 (cols[SPL_COL_RECONCILE_SEC], ts.tv_sec);
+    put_i64 (cols[SPL_COL_RECONCILE_NSEC], ts.tv_nsec);
+    put_i64 (cols[SPL_COL_VALUE_NUM], value.num);
+    put_i64 (cols[SPL_COL_VALUE_DENOM], value.denom);
+    put_i64 (cols[SPL_COL_QUANTITY_NUM], quantity.num);
+    put_i64 (cols[SPL_COL_QUANTITY_DENOM], quantity.denom);
+    put_guid (cols[SPL_COL_ACCOUNT],
+              account ? xaccAccountGetGUID (account) : NULL);
+    put_guid (cols[SPL_COL_LOT], lot ? gnc_lot_get_guid (lot) : NULL);
+    put_u64 (cols[SPL_COL_SLOTS],
+             encode_slots (writer->slots, writer->strings, QOF_INSTANCE (spl)));
+    writer->n_splits++;
+}
+
+static int
+encode_transaction_cb (Transaction* trn, gpointer data)
+{
+    bin_book_writer* writer = static_cast<bin_book_writer*> (data);
+    std::string* cols = writer->trn_cols;
+    gnc_commodity* currency = xaccTransGetCurrency (trn);
+    guint32 space = 0, id = 0;
+    Timespec posted = xaccTransRetDatePostedTS (trn);
+    Timespec entered = xaccTransRetDateEnteredTS (trn);
+    GList* splits = xaccTransGetSplitList (trn);
+
+    if (currency && gnc_commodity_get_namespace (currency) &&
+        gnc_commodity_get_mnemonic (currency))
+    {
+        space = intern_string (writer->strings,
+                               gnc_commodity_get_namespace_compat (currency));
+        id = intern_string (writer->strings,
+                            gnc_commodity_get_mnemonic (currency));
+    }
+    put_guid (cols[TRN_COL_GUID], xaccTransGetGUID (trn));
+    put_u32 (cols[TRN_COL_CURRENCY_SPACE], space);
+    put_u32 (cols[TRN_COL_CURRENCY_ID], id);
+    put_u32 (cols[TRN_COL_NUM],
+             intern_text (writer->strings, xaccTransGetNum (trn)));
+    put_u32 (cols[TRN_COL_DESCRIPTION],
+             intern_string (writer->strings, xaccTransGetDescription (trn)));
+    put_i64 (cols[TRN_COL_POSTED_SEC], posted.tv_sec);
+    put_i64 (cols[TRN_COL_POSTED_NSEC], posted.tv_nsec);
+    put_i64 (cols[TRN_COL_ENTERED_SEC], entered.tv_sec);
+    put_i64 (cols[TRN_COL_ENTERED_NSEC], entered.tv_nsec);
+    put_u64 (cols[TRN_COL_SLOTS],
+             encode_slots (writer->slots, writer->strings, QOF_INSTANCE (trn)));
+    put_u32 (cols[TRN_COL_N_SPLITS], g_list_length (splits));
+    for (GList* n = splits; n; n = n->next)
+        encode_split (writer, static_cast<Split*> (n->data));
+    writer->n_transactions++;
+    return 0;
+}
+
+static std::string
+columns_section (std::string* cols, int n_cols, guint64 rows)
+{
+    std::string section;
+
+    put_u64 (section, rows);
+    for (int i = 0; i < n_cols; ++i)
+    {
+        section.append (cols[i]);
+        section.append (pad8 (cols[i].size ()) - cols[i].size (), '\0');
+        std::string ().swap (cols[i]);
+    }
+    return section;
+}
+
+static std::string
+strings_section (const bin_string_table& table)
+{
+    std::string section;
+
+    put_u64 (section, table.offsets.size ());
+    for (auto offset : table.offsets)
+        put_u64 (section, offset);
+    section.append (table.blob);
+    return section;
+}
+
+/* Writes the book's XML, without its transactions, into a section. */
+static gboolean
+xml_section (QofBook* book, std::string& section)
+{
+    FILE* tmp = tmpfile ();
+    long at = 0;
+    char block[64 * 1024];
+    size_t len;
+    gboolean ok;
+
+    if (!tmp)
+        return FALSE;
+    ok = gnc_book_write_without_transactions_v2 (book, tmp, &at) &&
+         fflush (tmp) == 0 && fseek (tmp, 0, SEEK_SET) == 0;
+    put_u64 (section, at);
+    while (ok && (len = fread (block, 1, sizeof (block), tmp)) > 0)
+        section.append (block, len);
+    ok = ok && !ferror (tmp);
+    fclose (tmp);
+    return ok;
+}
+
+static gboolean
+write_sections (FILE* out, std::vector<std::pair<guint32, std::string>>& sections)
+{
+    std::string header, index;
+    guint64 pos = BIN_HEADER_LEN;
+    static const char zeros[8] = { 0 };
+
+    for (auto& section : sections)
+    {
+        put_u32 (index, section.first);
+        put_u32 (index, 0);
+        put_u64 (index, pos);
+        put_u64 (index, section.second.size ());
+        pos += pad8 (section.second.size ());
+    }
+    header.append (bin_magic, sizeof (bin_magic));
+    put_u32 (header, bin_version);
+    put_u32 (header, sections.size ());
+    put_u64 (header, pos);
+
+    if (fwrite (header.data (), 1, header.size (), out) != header.size ())
+        return FALSE;
+    for (auto& section : sections)
+    {
+        const std::string& text = section.second;
+        gsize pad = pad8 (text.size ()) - text.size ();
+        if (fwrite (text.data (), 1, text.size (), out) != text.size () ||
+            fwrite (zeros, 1, pad, out) != pad)
+            return FALSE;
+        std::string ().swap (section.second);
+    }
+    return fwrite (index.data (), 1, index.size (), out) == index.size ();
+}
+
+gboolean
+gnc_book_write_to_bin_file (QofBook* book, const char* filename)
+{
+    bin_book_writer writer;
+    std::vector<std::pair<guint32, std::string>> sections;
+    std::string xml;
+    FILE* out;
+    gboolean success;
+
+    g_return_val_if_fail (book && filename, FALSE);
+
+    if (!xml_section (book, xml))
+    {
+        PWARN ("Could not write the book to a temporary file");
+        return FALSE;
+    }
+
+    {
+        QofBackendPhase phase {qof_book_get_backend (book), "bin", "encode"};
+        writer.n_transactions = writer.n_splits = 0;
+        xaccAccountTreeForEachTransaction (gnc_book_get_root_account (book),
+                                           encode_transaction_cb, &writer);
+        sections.emplace_back (BIN_SECTION_TRANSACTIONS,
+                               columns_section (writer.trn_cols, TRN_N_COLS,
+                                                writer.n_transactions));
+        sections.emplace_back (BIN_SECTION_SPLITS,
+                               columns_section (writer.spl_cols, SPL_N_COLS,
+                                                writer.n_splits));
+        sections.emplace_back (BIN_SECTION_SLOTS, std::move (writer.slots));
+        sections.emplace_back (BIN_SECTION_STRINGS,
+                               strings_section (writer.strings));
+        sections.emplace_back (BIN_SECTION_XML, std::move (xml));
+    }
+
+    out = g_fopen (filename, "wb");
+    if (!out)
+    {
+        PWARN ("Could not open %s for writing", filename);
+        return FALSE;
+    }
+    {
+        QofBackendPhase phase {qof_book_get_backend (book), "bin", "write"};
+        success = write_sections (out, sections);
+    }
+    if (fclose (out) != 0)
+        success = FALSE;
+    return success;
+}
+
+/***********************************************************************/
+/* Reading */
+
+/* A bounds-checked cursor over part of the mapped file. */
+struct bin_reader
+{
+    const char* data;
+    gsize size;
+    gsize pos;
+    gboolean ok;
+};
+
+static inline const char*
+take (bin_reader* reader, gsize len)
+{
+    if (!reader->ok || len > reader->size - reader->pos)
+    {
+        reader->ok = FALSE;
+        return NULL;
+    }
+    const char* at = reader->data + reader->pos;
+    reader->pos += len;
+    return at;
+}
+
+static inline guint32
+get_u32_at (const char* at)
+{
+    guint32 val;
+    memcpy (&val, at, 4);
+    return GUINT32_FROM_LE (val);
+}
+
+static inline guint64
+get_u64_at (const char* at)
+{
+    guint64 val;
+    memcpy (&val, at, 8);
+    return GUINT64_FROM_LE (val);
+}
+
+static inline gint64
+get_i64_at (const char* at)
+{
+    return static_cast<gint64> (get_u64_at (at));
+}
+
+static guint8
+read_u8 (bin_reader* reader)
+{
+    const char* at = take (reader, 1);
+    return at ? static_cast<guint8> (*at) : 0;
+}
+
+static guint32
+read_u32 (bin_reader* reader)
+{
+    const char* at = take (reader, 4);
+    return at ? get_u32_at (at) : 0;
+}
+
+static guint64
+read_u64 (bin_reader* reader)
+{
+    const char* at = take (reader, 8);
+    return at ? get_u64_at (at) : 0;
+}
+
+struct bin_strings
+{
+    const char* offsets;
+    guint64 count;
+    const char* blob;
+    gsize blob_size;
+};
+
+/* Checks the table once, so that every string in it is terminated. */
+static gboolean
+open_strings (const char* data, gsize size, bin_strings* strings)
+{
+    bin_reader reader = { data, size, 0, TRUE };
+
+    strings->count = read_u64 (&reader);
+    if (!reader.ok || strings->count == 0 ||
+        strings->count > (size - 8) / 8)
+        return FALSE;
+    strings->offsets = take (&reader, strings->count * 8);
+    strings->blob = data + reader.pos;
+    strings->blob_size = size - reader.pos;
+    if (strings->count > 1 &&
+        (strings->blob_size == 0 ||
+         strings->blob[strings->blob_size - 1] != '\0'))
+        return FALSE;
+    for (guint64 i = 1; i < strings->count; ++i)
+        if (get_u64_at (strings->offsets + i * 8) >= strings->blob_size)
+            return FALSE;
+    return TRUE;
+}
+
+/* The string with the index, NULL for none. A bad index clears ok. */
+static const char*
+get_string (const bin_strings* strings, guint32 id, gboolean* ok)
+{
+    if (id == 0)
+        return NULL;
+    if (id >= strings->count)
+    {
+        *ok = FALSE;
+        return NULL;
+    }
+    return strings->blob + get_u64_at (strings->offsets + id * 8);
+}
+
+static KvpFrame* decode_frame (bin_reader* reader, const bin_strings* strings,
+                               int depth);
+
+static KvpValue*
+decode_value (bin_reader* reader, const bin_strings* strings, int depth)
+{
+    auto type = static_cast<KvpValue::Type> (read_u8 (reader));
+
+    if (!reader->ok || depth >= max_slot_depth)
+    {
+        reader->ok = FALSE;
+        return nullptr;
+    }
+    switch (type)
+    {
+    case KvpValue::Type::INT64:
+    {
+        int64_t val = static_cast<gint64> (read_u64 (reader));
+        return new KvpValue {val};
+    }
+    case KvpValue::Type::DOUBLE:
+    {
+        guint64 bits = read_u64 (reader);
+        double val;
+        memcpy (&val, &bits, 8);
+        return new KvpValue {val};
+    }
+    case KvpValue::Type::NUMERIC:
+    {
+        gint64 num = static_cast<gint64> (read_u64 (reader));
+        gint64 denom = static_cast<gint64> (read_u64 (reader));
+        return new KvpValue {gnc_numeric_create (num, denom)};
+    }
+    case KvpValue::Type::STRING:
+    {
+        const char* str = get_string (strings, read_u32 (reader), &reader->ok);
+        if (!str)
+        {
+            reader->ok = FALSE;
+            return nullptr;
+        }
+        return new KvpValue {g_strdup (str)};
+    }
+    case KvpValue::Type::GUID:
+    {
+        const char* at = take (reader, GUID_DATA_SIZE);
+        if (!at)
+            return nullptr;
+        auto guid = guid_malloc ();
+        memcpy (guid->reserved, at, GUID_DATA_SIZE);
+        return new KvpValue {guid};
+    }
+    case KvpValue::Type::TIMESPEC:
+    {
+        Timespec ts;
+        ts.tv_sec = static_cast<gint64> (read_u64 (reader));
+        ts.tv_nsec = static_cast<gint64> (read_u64 (reader));
+        return new KvpValue {ts};
+    }
+    case KvpValue::Type::GDATE:
+    {
+        guint32 julian = read_u32 (reader);
+        if (!g_date_valid_julian (julian))
+        {
+            reader->ok = FALSE;
+            return nullptr;
+        }
+        GDate date;
+        g_date_clear (&date, 1);
+        g_date_set_julian (&date, julian);
+        return new KvpValue {date};
+    }
+    case KvpValue::Type::GLIST:
+    {
+        guint32 count = read_u32 (reader);
+        GList* list = nullptr;
+        for (guint32 i = 0; reader->ok && i < count; ++i)
+        {
+            KvpValue* item = decode_value (reader, strings, depth + 1);
+            if (item)
+                list = g_list_prepend (list, item);
+        }
+        list = g_list_reverse (list);
+        if (!reader->ok)
+        {
+            g_list_free_full (list, [] (gpointer v)
+            {
+                delete static_cast<KvpValue*> (v);
+            });
+            return nullptr;
+        }
+        return new KvpValue {list};
+    }
+    case KvpValue::Type::FRAME:
+    {
+        KvpFrame* frame = decode_frame (reader, strings, depth + 1);
+        return frame ? new KvpValue {frame} : nullptr;
+    }
+    default:
+        reader->ok = FALSE;
+        return nullptr;
+    }
+}
+
+static KvpFrame*
+decode_frame (bin_reader* reader, const bin_strings* strings, int depth)
+{
+    guint32 count = read_u32 (reader);
+    auto frame = new KvpFrame;
+
+    for (guint32 i = 0; reader->ok && i < count; ++i)
+    {
+        const char* key = get_string (strings, read_u32 (reader), &reader->ok);
+        KvpValue* value = decode_value (reader, strings, depth);
+        if (!key)
+            reader->ok = FALSE;
+        if (reader->ok && value)
+            delete frame->set (key, value);
+        else
+            delete value;
+    }
+    if (!reader->ok)
+    {
+        delete frame;
+        return nullptr;
+    }
+    return frame;
+}
+
+/* One of the book's sections of columns. */
+struct bin_columns
+{
+    guint64 rows;
+    const char* col[SPL_N_COLS];
+};
+
+static gboolean
+open_columns (const char* data, gsize size, const gsize* widths, int n_cols,
+              bin_columns* cols)
+{
+    gsize offsets[SPL_N_COLS];
+
+    if (size < 8)
+        return FALSE;
+    cols->rows = get_u64_at (data);
+    /* Every row takes a byte at least, so this bounds the layout. */
+    if (cols->rows > size)
+        return FALSE;
+    if (column_layout (widths, n_cols, cols->rows, offsets) > size)
+        return FALSE;
+    for (int i = 0; i < n_cols; ++i)
+        cols->col[i] = data + offsets[i];
+    return TRUE;
+}
+
+struct bin_book
+{
+    bin_strings strings;
+    bin_columns transactions;
+    bin_columns splits;
+    const char* slots;
+    gsize slots_size;
+    /* Each transaction's first split. */
+    std::vector<guint64> first_split;
+};
+
+static KvpFrame*
+decode_slots (const bin_book* book, guint64 entry, gboolean* ok)
+{
+    if (entry == 0)
+        return nullptr;
+    if (entry > book->slots_size)
+    {
+        *ok = FALSE;
+        return nullptr;
+    }
+    bin_reader reader = { book->slots, book->slots_size, entry - 1, TRUE };
+    KvpFrame* frame = decode_frame (&reader, &book->strings, 0);
+    if (!reader.ok)
+        *ok = FALSE;
+    return frame;
+}
+
+static void
+decode_split (const bin_book* book, guint64 row, SplitRecord& rec,
+              gboolean* ok)
+{
+    const char* const* col = book->splits.col;
+    const char* str;
+
+    memcpy (rec.guid.reserved, col[SPL_COL_GUID] + row * 16, GUID_DATA_SIZE);
+    rec.has_guid = true;
+    str = get_string (&book->strings,
+                      get_u32_at (col[SPL_COL_MEMO] + row * 4), ok);
+    if (str)
+    {
+        rec.memo = str;
+        rec.has_memo = true;
+    }
+    str = get_string (&book->strings,
+                      get_u32_at (col[SPL_COL_ACTION] + row * 4), ok);
+    if (str)
+    {
+        rec.action = str;
+        rec.has_action = true;
+    }
+    rec.reconciled = col[SPL_COL_RECONCILED][row];
+    rec.has_reconciled = true;
+    rec.reconcile_date.tv_sec = get_i64_at (col[SPL_COL_RECONCILE_SEC] + row * 8);
+    rec.reconcile_date.tv_nsec = get_i64_at (col[SPL_COL_RECONCILE_NSEC] +
+                                             row * 8);
+    rec.has_reconcile_date = rec.reconcile_date.tv_sec != 0 ||
+                             rec.reconcile_date.tv_nsec != 0;
+    rec.value = gnc_numeric_create (get_i64_at (col[SPL_COL_VALUE_NUM] + row * 8),
+                                    get_i64_at (col[SPL_COL_VALUE_DENOM] + row * 8));
+    rec.has_value = true;
+    rec.quantity = gnc_numeric_create (
+                       get_i64_at (col[SPL_COL_QUANTITY_NUM] + row * 8),
+                       get_i64_at (col[SPL_COL_QUANTITY_DENOM] + row * 8));
+    rec.has_quantity = true;
+    memcpy (rec.account.reserved, col[SPL_COL_ACCOUNT] + row * 16,
+            GUID_DATA_SIZE);
+    rec.has_account = true;
+    memcpy (rec.lot.reserved, col[SPL_COL_LOT] + row * 16, GUID_DATA_SIZE);
+    rec.has_lot = !guid_equal (&rec.lot, guid_null ());
+    rec.slots = decode_slots (book, get_u64_at (col[SPL_COL_SLOTS] + row * 8),
+                              ok);
+}
+
+static TransactionRecord*
+decode_transaction (const bin_book* book, guint64 row, gboolean* ok)
+{
+    const char* const* col = book->transactions.col;
+    auto rec = new TransactionRecord;
+    const char* str;
+
+    memcpy (rec->guid.reserved, col[TRN_COL_GUID] + row * 16, GUID_DATA_SIZE);
+    rec->has_guid = true;
+    const char* space = get_string (
+        &book->strings, get_u32_at (col[TRN_COL_CURRENCY_SPACE] + row * 4), ok);
+    const char* id = get_string (
+        &book->strings, get_u32_at (col[TRN_COL_CURRENCY_ID] + row * 4), ok);
+    if (space && id)
+    {
+        rec->currency_space = space;
+        rec->currency_id = id;
+        rec->has_currency = rec->currency_ok = true;
+    }
+    str = get_string (&book->strings,
+                      get_u32_at (col[TRN_COL_NUM] + row * 4), ok);
+    if (str)
+    {
+        rec->num = str;
+        rec->has_num = true;
+    }
+    str = get_string (&book->strings,
+                      get_u32_at (col[TRN_COL_DESCRIPTION] + row * 4), ok);
+    if (str)
+    {
+        rec->description = str;
+        rec->has_description = true;
+    }
+    rec->date_posted.tv_sec = get_i64_at (col[TRN_COL_POSTED_SEC] + row * 8);
+    rec->date_posted.tv_nsec = get_i64_at (col[TRN_COL_POSTED_NSEC] + row * 8);
+    rec->has_date_posted = true;
+    rec->date_entered.tv_sec = get_i64_at (col[TRN_COL_ENTERED_SEC] + row * 8);
+    rec->date_entered.tv_nsec = get_i64_at (col[TRN_COL_ENTERED_NSEC] + row * 8);
+    rec->has_date_entered = true;
+    rec->slots = decode_slots (book, get_u64_at (col[TRN_COL_SLOTS] + row * 8),
+                               ok);
+
+    guint64 first = book->first_split[row];
+    guint64 last = book->first_split[row + 1];
+    rec->splits.resize (last - first);
+    for (guint64 i = first; i < last; ++i)
+        decode_split (book, i, rec->splits[i - first], ok);
+    return rec;
+}
+
+struct decode_chunk
+{
+    guint64 begin;
+    guint64 end;
+    gboolean ok;
+};
+
+/* Runs in a worker thread: nothing but the records' slice is written. */
+static void
+decode_transactions (const bin_book* book, decode_chunk* chunk,
+                     std::vector<TransactionRecord*>* records)
+{
+    chunk->ok = TRUE;
+    for (guint64 row = chunk->begin; row < chunk->end; ++row)
+        (*records)[row] = decode_transaction (book, row, &chunk->ok);
+}
+
+static gboolean
+decode_book (const bin_book* book, std::vector<TransactionRecord*>& records)
+{
+    guint64 rows = book->transactions.rows;
+    guint threads = std::max (std::thread::hardware_concurrency (), 1u);
+    guint64 n_chunks = std::max<guint64> (
+        1, std::min<guint64> (threads, rows / min_decode_chunk));
+    std::vector<decode_chunk> chunks;
+    std::vector<std::thread> workers;
+    gboolean ok = TRUE;
+
+    records.assign (rows, nullptr);
+    for (guint64 i = 0; i < n_chunks; ++i)
+        chunks.push_back ({rows * i / n_chunks, rows * (i + 1) / n_chunks,
+                           FALSE});
+    for (auto& chunk : chunks)
+    {
+        if (&chunk == &chunks.back ())
+        {
+            decode_transactions (book, &chunk, &records);
+            break;
+        }
+        try
+        {
+            workers.emplace_back (decode_transactions, book, &chunk, &records);
+        }
+        catch (const std::system_error& err)
+        {
+            PWARN ("Can't start a decoding thread: %s", err.what ());
+            decode_transactions (book, &chunk, &records);
+        }
+    }
+    for (auto& worker : workers)
+        worker.join ();
+    for (auto& chunk : chunks)
+        ok &= chunk.ok;
+    return ok;
+}
+
+/* Finds the sections, each of which must be there once. */
+static gboolean
+open_sections (const char* data, gsize size, const char* sections[],
+               gsize lengths[])
+{
+    bin_reader reader = { data, size, 0, TRUE };
+
+    for (int i = 0; i <= BIN_SECTION_LAST; ++i)
+        sections[i] = NULL;
+    if (size < BIN_HEADER_LEN || memcmp (data, bin_magic, sizeof (bin_magic)))
+        return FALSE;
+    reader.pos = sizeof (bin_magic);
+    guint32 version = read_u32 (&reader);
+    guint32 count = read_u32 (&reader);
+    guint64 index = read_u64 (&reader);
+    if (version != bin_version)
+    {
+        PWARN ("Binary file version %u is not %u", version, bin_version);
+        return FALSE;
+    }
+    if (index > size || count > (size - index) / BIN_INDEX_ENTRY_LEN)
+        return FALSE;
+
+    reader.pos = index;
+    for (guint32 i = 0; i < count; ++i)
+    {
+        guint32 type = read_u32 (&reader);
+        read_u32 (&reader);
+        guint64 offset = read_u64 (&reader);
+        guint64 length = read_u64 (&reader);
+        if (offset > size || length > size - offset || offset % 8)
+            return FALSE;
+        /* Sections of later versions are skipped. */
+        if (type == 0 || type > BIN_SECTION_LAST)
+            continue;
+        if (sections[type])
+            return FALSE;
+        sections[type] = data + offset;
+        lengths[type] = length;
+    }
+    for (int i = 1; i <= BIN_SECTION_LAST; ++i)
+        if (!sections[i])
+            return FALSE;
+    return reader.ok;
+}
+
+static gboolean
+open_book (const char* sections[], gsize lengths[], bin_book* book)
+{
+    if (!open_strings (sections[BIN_SECTION_STRINGS],
+                       lengths[BIN_SECTION_STRINGS], &book->strings) ||
+        !open_columns (sections[BIN_SECTION_TRANSACTIONS],
+                       lengths[BIN_SECTION_TRANSACTIONS], trn_col_width,
+                       TRN_N_COLS, &book->transactions) ||
+        !open_columns (sections[BIN_SECTION_SPLITS],
+                       lengths[BIN_SECTION_SPLITS], spl_col_width,
+                       SPL_N_COLS, &book->splits))
+        return FALSE;
+    book->slots = sections[BIN_SECTION_SLOTS];
+    book->slots_size = lengths[BIN_SECTION_SLOTS];
+
+    /* The split counts must add up to the splits there are. */
+    guint64 rows = book->transactions.rows;
+    const char* counts = book->transactions.col[TRN_COL_N_SPLITS];
+    book->first_split.resize (rows + 1);
+    book->first_split[0] = 0;
+    for (guint64 row = 0; row < rows; ++row)
+        book->first_split[row + 1] = book->first_split[row] +
+                                     get_u32_at (counts + row * 4);
+    return book->first_split[rows] == book->splits.rows;
+}
+
+gboolean
+qof_session_load_from_bin_file (FileBackend* fbe, QofBook* book)
+{
+    GError* error = NULL;
+    GMappedFile* mapping;
+    const char* sections[BIN_SECTION_LAST + 1];
+    gsize lengths[BIN_SECTION_LAST + 1] = { 0 };
+    bin_book bin;
+    std::vector<TransactionRecord*> records;
+    gboolean retval = FALSE;
+
+    g_return_val_if_fail (fbe && book, FALSE);
+
+    mapping = g_mapped_file_new (fbe->fullpath, FALSE, &error);
+    if (!mapping)
+    {
+        PWARN ("Unable to map %s: %s", fbe->fullpath, error->message);
+        g_error_free (error);
+        return FALSE;
+    }
+    const char* data = g_mapped_file_get_contents (mapping);
+    gsize size = g_mapped_file_get_length (mapping);
+#ifndef G_OS_WIN32
+    if (data)
+        posix_madvise (const_cast<char*> (data), size, POSIX_MADV_WILLNEED);
+#endif
+
+    if (!data || !open_sections (data, size, sections, lengths) ||
+        !open_book (sections, lengths, &bin) ||
+        lengths[BIN_SECTION_XML] < 8)
+    {
+        PWARN ("%s is not a readable binary book", fbe->fullpath);
+        goto bail;
+    }
+
+    {
+        QofBackendPhase phase {&fbe->be, "bin", "decode"};
+        qof_backend_stat_add (&fbe->be, "bin.bytes", size);
+        if (!decode_book (&bin, records))
+        {
+            PWARN ("Bad transactions in %s", fbe->fullpath);
+            for (auto rec : records)
+                gnc_transaction_record_free (rec);
+            goto bail;
+        }
+    }
+
+    {
+        const char* xml = sections[BIN_SECTION_XML] + 8;
+        gsize xml_size = lengths[BIN_SECTION_XML] - 8;
+        guint64 at = get_u64_at (sections[BIN_SECTION_XML]);
+        if (at > xml_size)
+        {
+            for (auto rec : records)
+                gnc_transaction_record_free (rec);
+            goto bail;
+        }
+        retval = qof_session_load_from_xml_buffer_v2 (fbe, book, xml, xml_size,
+                                                      at, records);
+    }
+
+bail:
+    g_mapped_file_unref (mapping);
+    return retval;
+}
+
+gboolean
+gnc_is_bin_data_file (const gchar* name)
+{
+    char magic[sizeof (bin_magic)];
+    FILE* file = g_fopen (name, "rb");
+    gboolean result;
+
+    if (!file)
+        return FALSE;
+    result = fread (magic, 1, sizeof (magic), file) == sizeof (magic) &&
+             memcmp (magic, bin_magic, sizeof (magic)) == 0;
+    fclose (file);
+    return result;
+}
@@ -0,0 +1,61 @@
+/********************************************************************\
+ * io-gncbin.h -- api for the binary GnuCash file format            *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+\********************************************************************/
+
+/**
+ * @file io-gncbin.h
+ * @brief api for the binary GnuCash file format
+ *
+ * A binary book is a container of sections, listed in an index at the
+ * end of the file and each aligned for reading in place through mmap:
+ *
+ * - The transactions and the splits, each field a fixed-width column:
+ *   GUIDs, times and numerics as they are, text as an index into
+ *   the string table.
+ * - The string table, every distinct string of the columns and the
+ *   slots once.
+ * - The transactions' and splits' slots, in a compact encoding.
+ * - The rest of the book, which is small next to its transactions, as
+ *   the XML of the version 2 format with the transactions left out.
+ *
+ * Rows don't depend on each other, so the transactions are decoded in
+ * several threads. Reading a book and saving it in the other format
+ * loses nothing either way.
+ */
+
+#ifndef IO_GNCBIN_H
+#define IO_GNCBIN_H
+
+#include <glib.h>
+
+#include "gnc-engine.h"
+#include "gnc-backend-xml.h"
+
+/** Whether the file starts like a binary book. */
+gboolean gnc_is_bin_data_file (const gchar* name);
+
+/** Write the book to filename in the binary format. */
+gboolean gnc_book_write_to_bin_file (QofBook* book, const char* filename);
+
+/** Read the book in the backend's file, which is in the binary format. */
+gboolean qof_session_load_from_bin_file (FileBackend* fbe, QofBook* book);
+
+#endif /* IO_GNCBIN_H */
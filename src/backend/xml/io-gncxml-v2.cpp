@@ -45,7 +45,13 @@ extern "C"
 # include <unistd.h>
 #endif
 #include <zlib.h>
+#ifdef HAVE_ZSTD
+# include <zstd.h>
+#endif
 #include <errno.h>
+#ifndef G_OS_WIN32
+# include <sys/mman.h>
+#endif
 
 #include "gnc-engine.h"
 #include "gnc-pricedb-p.h"
@@ -67,12 +73,19 @@ extern "C"
 #endif
 }
 
+#include <algorithm>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
 #include "sixtp.h"
 #include "sixtp-parsers.h"
 #include "sixtp-utils.h"
 #include "gnc-xml.h"
 #include "io-utils.h"
 #include "sixtp-dom-parsers.h"
+#include "sixtp-dom-generators.h"
 #include "io-gncxml-v2.h"
 #include "io-gncxml-gen.h"
 
@@ -96,6 +109,7 @@ typedef struct
     gchar* filename;
     gchar* perms;
     gboolean compress;
+    GncXmlCodec codec;
 } gz_thread_params_t;
 
 /* Callback structure */
@@ -118,9 +132,9 @@ gnc_v2_book_version_string;        /* see gnc-book-xml-v2 */
 
 /* Forward declarations */
 static FILE* try_gz_open (const char* filename, const char* perms,
-                          gboolean use_gzip,
+                          GncXmlCodec codec,
                           gboolean compress);
-static gboolean is_gzipped_file (const gchar* name);
+static GncXmlCodec compressed_file_codec (const gchar* name);
 static gboolean wait_for_gzip (FILE* file);
 
 static void
@@ -413,6 +427,17 @@ gnc_counter_end_handler (gpointer data_for_children,
     else if (g_strcmp0 (type, "transaction") == 0)
     {
         sixdata->counter.transactions_total = val;
+        /* Size the indexes the transactions and their splits, two or
+         * more each, are about to be added to. */
+        if (val > 0 && val <= G_MAXINT32 / 2)
+        {
+            qof_collection_reserve (qof_book_get_collection (sixdata->book,
+                                                             GNC_ID_TRANS),
+                                    val);
+            qof_collection_reserve (qof_book_get_collection (sixdata->book,
+                                                             GNC_ID_SPLIT),
+                                    2 * val);
+        }
     }
     else if (g_strcmp0 (type, "account") == 0)
     {
@@ -437,6 +462,10 @@ gnc_counter_end_handler (gpointer data_for_children,
     else if (g_strcmp0 (type, "price") == 0)
     {
         sixdata->counter.prices_total = val;
+        if (val > 0 && val <= G_MAXINT32)
+            qof_collection_reserve (qof_book_get_collection (sixdata->book,
+                                                             GNC_ID_PRICE),
+                                    val);
     }
     else
     {
@@ -489,6 +518,19 @@ debug_print_counter_data (load_counter* data)
            data->budgets_total, data->budgets_loaded);
 }
 
+static void
+record_counter_stats (QofBackend* be, const load_counter* data)
+{
+    qof_backend_stat_add (be, "xml.transactions", data->transactions_loaded);
+    qof_backend_stat_add (be, "xml.accounts", data->accounts_loaded);
+    qof_backend_stat_add (be, "xml.books", data->books_loaded);
+    qof_backend_stat_add (be, "xml.commodities", data->commodities_loaded);
+    qof_backend_stat_add (be, "xml.prices", data->prices_loaded);
+    qof_backend_stat_add (be, "xml.schedxactions",
+                          data->schedXactions_loaded);
+    qof_backend_stat_add (be, "xml.budgets", data->budgets_loaded);
+}
+
 static void
 file_rw_feedback (sixtp_gdv2* gd, const char* type)
 {
@@ -700,6 +742,634 @@ gnc_sixtp_gdv2_new (
     return gd;
 }
 
+/***********************************************************************/
+/* Parallel loading
+ *
+ * Transactions are most of a book, and nothing in reading one depends
+ * on the rest of the file until it's made in the book. So the run of
+ * gnc:transaction elements in the file is cut into chunks and each
+ * chunk is read into TransactionRecords in a thread of its own, while
+ * the main parser reads what comes before the run: the commodities,
+ * prices and accounts. The records are then committed into the book in
+ * file order and the main parser reads the rest of the file, whose
+ * objects may refer to the transactions.
+ *
+ * A chunk that fails to read is fed to the main parser instead, so that
+ * a bad file fails, and is reported, just as it does when read serially.
+ */
+
+/* Runs shorter than this are read by the main parser. */
+static const gsize min_parallel_run = 1 << 20;
+/* The least a thread is given to read. */
+static const gsize min_parallel_chunk = 256 << 10;
+
+struct transaction_chunk
+{
+    gsize begin;
+    gsize end;
+    std::vector<TransactionRecord*> records;
+    gboolean ok;
+};
+
+struct parallel_load
+{
+    /* The file's contents: mapped, or else read into buffer. */
+    const char* data;
+    gsize size;
+    GMappedFile* mapping;
+    std::string buffer;
+    /* The root element's start tag, to wrap each chunk in. */
+    std::string root_tag;
+    gsize run_begin;
+    gsize run_end;
+    /* The price database, if it is held back until it's looked at. */
+    gsize prices_begin;
+    gsize prices_end;
+    std::vector<transaction_chunk> chunks;
+    std::vector<std::thread> workers;
+    gxpf_data* gdata;
+    gboolean ok;
+};
+
+/* The number of threads to read the transactions in, or 0 to size the
+ * chunks by min_parallel_chunk. GNC_XML_LOAD_THREADS overrides it, for
+ * testing and tuning. */
+static guint
+load_thread_count (gboolean* forced)
+{
+    const char* env = g_getenv ("GNC_XML_LOAD_THREADS");
+    *forced = FALSE;
+    if (env)
+    {
+        gint64 n = g_ascii_strtoll (env, NULL, 10);
+        if (n > 0)
+        {
+            *forced = TRUE;
+            return MIN (n, 256);
+        }
+    }
+    return std::max (std::thread::hardware_concurrency (), 1u);
+}
+
+static gboolean
+read_whole_file (FILE* file, std::string& buffer)
+{
+    char block[64 * 1024];
+    size_t len;
+
+    while ((len = fread (block, 1, sizeof (block), file)) > 0)
+        buffer.append (block, len);
+    return !ferror (file);
+}
+
+/* Maps an uncompressed file's contents in place of reading them, so
+ * that the planner and the threads work on the page cache directly. */
+static gboolean
+map_whole_file (const char* filename, parallel_load* load)
+{
+    GError* error = NULL;
+
+    load->mapping = g_mapped_file_new (filename, FALSE, &error);
+    if (!load->mapping)
+    {
+        PINFO ("Can't map %s, reading it instead: %s", filename,
+               error->message);
+        g_error_free (error);
+        return FALSE;
+    }
+    load->data = g_mapped_file_get_contents (load->mapping);
+    load->size = g_mapped_file_get_length (load->mapping);
+    if (!load->data)
+    {
+        g_mapped_file_unref (load->mapping);
+        load->mapping = NULL;
+        load->size = 0;
+        return FALSE;
+    }
+#ifndef G_OS_WIN32
+    /* The file is scanned once from the start and then parsed in order,
+     * if in several places at once. */
+    posix_madvise (const_cast<char*> (load->data), load->size,
+                   POSIX_MADV_SEQUENTIAL);
+#endif
+    return TRUE;
+}
+
+static gboolean
+load_whole_file (FILE* file, const char* mapped_name, parallel_load* load)
+{
+    QofLogTraceScope trace {"xml", "read"};
+
+    if (mapped_name && map_whole_file (mapped_name, load))
+        return TRUE;
+    if (!read_whole_file (file, load->buffer))
+        return FALSE;
+    load->data = load->buffer.data ();
+    load->size = load->buffer.size ();
+    return TRUE;
+}
+
+/* The position of text at or after from, or std::string::npos. */
+static gsize
+find_text (const parallel_load* load, gsize from, const char* text)
+{
+    gsize len = strlen (text);
+
+    while (from + len <= load->size)
+    {
+        const char* at = static_cast<const char*> (
+            memchr (load->data + from, text[0], load->size - from - len + 1));
+        if (!at)
+            break;
+        from = at - load->data;
+        if (memcmp (at, text, len) == 0)
+            return from;
+        ++from;
+    }
+    return std::string::npos;
+}
+
+/* Whether the element <tag ...> starts at pos. */
+static gboolean
+element_at (const parallel_load* load, gsize pos, const char* tag)
+{
+    gsize len = strlen (tag);
+
+    if (pos == std::string::npos || pos + 1 + len >= load->size ||
+        load->data[pos] != '<' || memcmp (load->data + pos + 1, tag, len) != 0)
+        return FALSE;
+    char next = load->data[pos + 1 + len];
+    return next == '>' || next == '/' || g_ascii_isspace (next);
+}
+
+static gsize
+find_element (const parallel_load* load, gsize from, const char* tag)
+{
+    std::string open = std::string ("<") + tag;
+
+    for (gsize pos = find_text (load, from, open.c_str ());
+         pos != std::string::npos;
+         pos = find_text (load, pos + 1, open.c_str ()))
+        if (element_at (load, pos, tag))
+            return pos;
+    return std::string::npos;
+}
+
+static gsize
+skip_space (const parallel_load* load, gsize from)
+{
+    while (from < load->size && g_ascii_isspace (load->data[from]))
+        ++from;
+    return from < load->size ? from : std::string::npos;
+}
+
+/* Finds the root element and keeps its start tag. Returns the end of
+ * the tag, or std::string::npos if parts of the file can't be read on
+ * their own. */
+static gsize
+find_root_tag (parallel_load* load)
+{
+    const char* data = load->data;
+
+    /* The parts are read without the XML declaration, so as UTF-8. */
+    if (load->size >= 5 && memcmp (data, "<?xml", 5) == 0)
+    {
+        gsize decl_end = find_text (load, 0, "?>");
+        if (decl_end == std::string::npos)
+            return std::string::npos;
+        gchar* decl = g_ascii_strdown (data, decl_end);
+        gboolean utf8 = !strstr (decl, "encoding") || strstr (decl, "utf-8");
+        g_free (decl);
+        if (!utf8)
+            return std::string::npos;
+    }
+
+    gsize root = find_element (load, 0, GNC_V2_STRING);
+    if (root == std::string::npos)
+        return std::string::npos;
+    gsize root_end = find_text (load, root, ">");
+    if (root_end == std::string::npos)
+        return std::string::npos;
+    load->root_tag.assign (data + root, root_end - root + 1);
+    return root_end;
+}
+
+/* Finds the book's price database, to be read when it's first looked
+ * at instead of now. GNC_XML_LAZY_PRICES asks for that. */
+static void
+plan_deferred_prices (parallel_load* load, gsize root_end)
+{
+    const std::string close = std::string ("</") + PRICEDB_TAG + ">";
+
+    load->prices_begin = load->prices_end = std::string::npos;
+    if (!g_getenv ("GNC_XML_LAZY_PRICES"))
+        return;
+
+    /* The prices come before the accounts and the transactions. */
+    gsize begin = find_element (load, root_end, PRICEDB_TAG);
+    gsize account = find_element (load, root_end, ACCOUNT_TAG);
+    if (begin == std::string::npos || account < begin)
+        return;
+    gsize end = find_text (load, begin, close.c_str ());
+    if (end == std::string::npos)
+        return;
+    load->prices_begin = begin;
+    load->prices_end = end + close.size ();
+}
+
+/* Finds the run of transactions and cuts it into chunks at transaction
+ * starts. Returns FALSE if the file is better read serially. */
+static gboolean
+plan_parallel_load (parallel_load* load, gsize root_end)
+{
+    const std::string close = std::string ("</") + TRANSACTION_TAG + ">";
+    std::vector<gsize> starts;
+    gboolean forced;
+    guint threads = load_thread_count (&forced);
+    gsize n_chunks;
+
+    if (threads < 2)
+        return FALSE;
+
+    /* Template transactions hold gnc:transactions of their own. */
+    gsize first = find_element (load, root_end, TRANSACTION_TAG);
+    gsize templates = find_element (load, root_end, TEMPLATE_TRANSACTION_TAG);
+    if (first == std::string::npos || templates < first)
+        return FALSE;
+
+    gsize pos = first;
+    while (element_at (load, pos, TRANSACTION_TAG))
+    {
+        starts.push_back (pos);
+        pos = find_text (load, pos, close.c_str ());
+        if (pos == std::string::npos)
+            return FALSE;
+        pos += close.size ();
+        gsize next = skip_space (load, pos);
+        if (!element_at (load, next, TRANSACTION_TAG))
+            break;
+        pos = next;
+    }
+    load->run_begin = first;
+    load->run_end = pos;
+
+    gsize run = load->run_end - load->run_begin;
+    if (forced)
+        n_chunks = MIN (threads, starts.size ());
+    else if (run < min_parallel_run)
+        return FALSE;
+    else
+        n_chunks = MIN (threads, run / min_parallel_chunk);
+    if (n_chunks < 2)
+        return FALSE;
+
+    gsize begin = load->run_begin;
+    for (gsize i = 1; i <= n_chunks; ++i)
+    {
+        gsize end = load->run_end;
+        if (i < n_chunks)
+        {
+            auto at = std::lower_bound (starts.begin (), starts.end (),
+                                        load->run_begin + run * i / n_chunks);
+            if (at == starts.end ())
+                break;
+            end = *at;
+        }
+        if (end <= begin)
+            continue;
+        load->chunks.push_back ({begin, end, {}, FALSE});
+        begin = end;
+    }
+    if (begin < load->run_end)
+        load->chunks.push_back ({begin, load->run_end, {}, FALSE});
+    return load->chunks.size () > 1;
+}
+
+static gboolean
+stage_transaction_cb (const char* tag, gpointer parsedata, gpointer data)
+{
+    transaction_chunk* chunk = static_cast<decltype (chunk)> (parsedata);
+
+    chunk->records.push_back (static_cast<TransactionRecord*> (data));
+    return TRUE;
+}
+
+static void
+free_chunk_records (transaction_chunk* chunk)
+{
+    for (auto rec : chunk->records)
+        gnc_transaction_record_free (rec);
+    chunk->records.clear ();
+}
+
+static gboolean
+push_buffer (xmlParserCtxtPtr xml_context, const char* data, gsize len,
+             gboolean terminate)
+{
+    /* libxml2 halts a push parser holding over 10MB of unparsed input. */
+    const gsize max_push = 1 << 20;
+    gboolean ok = TRUE;
+
+    do
+    {
+        gsize part = MIN (len, max_push);
+        if (xmlParseChunk (xml_context, data, part, terminate && part == len))
+            ok = FALSE;
+        data += part;
+        len -= part;
+    }
+    while (len > 0);
+    return ok;
+}
+
+struct chunk_push
+{
+    const parallel_load* load;
+    transaction_chunk* chunk;
+};
+
+/* Feeds the chunk to the parser as a document of its own. */
+static void
+chunk_push_handler (xmlParserCtxtPtr xml_context, chunk_push* push)
+{
+    const parallel_load* load = push->load;
+    transaction_chunk* chunk = push->chunk;
+    static const char root_end[] = "</" GNC_V2_STRING ">";
+
+    if (!push_buffer (xml_context, load->root_tag.data (),
+                      load->root_tag.size (), FALSE) ||
+        !push_buffer (xml_context, load->data + chunk->begin,
+                      chunk->end - chunk->begin, FALSE) ||
+        !push_buffer (xml_context, root_end, strlen (root_end), TRUE))
+        chunk->ok = FALSE;
+}
+
+/* Runs in a worker thread: reads the chunk's transactions into records.
+ * Only the file's contents are shared, and nothing writes to it. */
+static void
+read_transaction_chunk (const parallel_load* load, transaction_chunk* chunk)
+{
+    sixtp* top_parser = sixtp_new ();
+    sixtp* main_parser = sixtp_new ();
+    gpointer parse_result = NULL;
+    gxpf_data gpdata;
+    chunk_push push = { load, chunk };
+
+    chunk->ok = FALSE;
+    if (!sixtp_add_some_sub_parsers (
+            top_parser, TRUE,
+            GNC_V2_STRING, main_parser,
+            NULL, NULL))
+        return;
+    if (!sixtp_add_some_sub_parsers (
+            main_parser, TRUE,
+            TRANSACTION_TAG, gnc_transaction_record_sixtp_parser_create (),
+            NULL, NULL))
+        return;
+
+    gpdata.cb = stage_transaction_cb;
+    gpdata.parsedata = chunk;
+    gpdata.bookdata = NULL;
+    chunk->ok = TRUE;
+    if (!sixtp_parse_push (top_parser, (sixtp_push_handler) chunk_push_handler,
+                           &push, NULL, &gpdata, &parse_result))
+        chunk->ok = FALSE;
+    sixtp_destroy (top_parser);
+    if (!chunk->ok)
+        free_chunk_records (chunk);
+}
+
+static void
+start_parallel_load (parallel_load* load)
+{
+    /* libxml2 must be set up before it's used from several threads. */
+    xmlInitParser ();
+    for (auto& chunk : load->chunks)
+    {
+        try
+        {
+            load->workers.emplace_back (read_transaction_chunk, load, &chunk);
+        }
+        catch (const std::system_error& err)
+        {
+            PWARN ("Can't start a loading thread: %s", err.what ());
+            read_transaction_chunk (load, &chunk);
+        }
+    }
+}
+
+static void
+finish_parallel_load (parallel_load* load)
+{
+    for (auto& worker : load->workers)
+        if (worker.joinable ())
+            worker.join ();
+    for (auto& chunk : load->chunks)
+        free_chunk_records (&chunk);
+    if (load->mapping)
+        g_mapped_file_unref (load->mapping);
+    load->mapping = NULL;
+}
+
+static void
+commit_transaction_chunk (parallel_load* load, transaction_chunk* chunk)
+{
+    QofBook* book = static_cast<QofBook*> (load->gdata->bookdata);
+    QofBackendPhase phase {qof_book_get_backend (book), "xml", "commit"};
+
+    for (auto& rec : chunk->records)
+    {
+        Transaction* trn = gnc_transaction_record_commit (rec, book);
+        rec = NULL;
+        if (trn)
+            load->gdata->cb (TRANSACTION_TAG, load->gdata->parsedata, trn);
+        else
+            load->ok = FALSE;
+    }
+    chunk->records.clear ();
+}
+
+/* Feeds the file from begin to end to the main parser, leaving out the
+ * price database if it's held back. */
+static gboolean
+push_file_range (xmlParserCtxtPtr xml_context, const parallel_load* load,
+                 gsize begin, gsize end, gboolean terminate)
+{
+    if (load->prices_begin == std::string::npos ||
+        load->prices_begin < begin || load->prices_begin >= end)
+        return push_buffer (xml_context, load->data + begin, end - begin,
+                            terminate);
+    return push_buffer (xml_context, load->data + begin,
+                        load->prices_begin - begin, FALSE) &&
+           push_buffer (xml_context, load->data + load->prices_end,
+                        end - load->prices_end, terminate);
+}
+
+static void
+parallel_load_push_handler (xmlParserCtxtPtr xml_context,
+                            parallel_load* load)
+{
+    const char* data = load->data;
+
+    if (load->chunks.empty ())
+    {
+        load->ok &= push_file_range (xml_context, load, 0, load->size, TRUE);
+        return;
+    }
+
+    load->ok &= push_file_range (xml_context, load, 0, load->run_begin, FALSE);
+    for (auto& worker : load->workers)
+        worker.join ();
+    for (auto& chunk : load->chunks)
+    {
+        if (chunk.ok)
+            commit_transaction_chunk (load, &chunk);
+        else
+            load->ok &= push_buffer (xml_context, data + chunk.begin,
+                                     chunk.end - chunk.begin, FALSE);
+    }
+    load->ok &= push_file_range (xml_context, load, load->run_end,
+                                 load->size, TRUE);
+}
+
+/* A book's price database, held back from its load. */
+struct deferred_prices
+{
+    QofBook* book;
+    /* The price database as a document of its own. */
+    std::string text;
+};
+
+static void
+deferred_prices_push_handler (xmlParserCtxtPtr xml_context,
+                              deferred_prices* prices)
+{
+    push_buffer (xml_context, prices->text.data (), prices->text.size (),
+                 TRUE);
+}
+
+static void
+free_deferred_prices (gpointer data)
+{
+    delete static_cast<deferred_prices*> (data);
+}
+
+static void
+load_deferred_prices (GNCPriceDB* db, gpointer data)
+{
+    deferred_prices* prices = static_cast<decltype (prices)> (data);
+    QofBook* book = prices->book;
+    QofBackend* be = qof_book_get_backend (book);
+    gboolean saved = !qof_book_session_not_saved (book);
+    sixtp* top_parser = sixtp_new ();
+    sixtp* main_parser = sixtp_new ();
+    gpointer parse_result = NULL;
+    gxpf_data gpdata;
+    QofLogTraceScope trace {"xml", "prices"};
+
+    if (!sixtp_add_some_sub_parsers (
+            top_parser, TRUE,
+            GNC_V2_STRING, main_parser,
+            NULL, NULL))
+        return;
+    if (!sixtp_add_some_sub_parsers (
+            main_parser, TRUE,
+            PRICEDB_TAG, gnc_pricedb_sixtp_parser_create (),
+            NULL, NULL))
+        return;
+
+    sixtp_gdv2* gd = gnc_sixtp_gdv2_new (book, FALSE, NULL, NULL);
+    gpdata.cb = generic_callback;
+    gpdata.parsedata = gd;
+    gpdata.bookdata = book;
+
+    /* The prices are still part of the load: there's nothing new to save
+     * and nothing to tell the GUI about, price by price. */
+    decltype (be->commit) commit = be ? be->commit : NULL;
+    if (be)
+        be->commit = NULL;
+    qof_event_suspend ();
+    if (!sixtp_parse_push (top_parser,
+                           (sixtp_push_handler) deferred_prices_push_handler,
+                           prices, NULL, &gpdata, &parse_result))
+        PERR ("Error reading the price database of book %p", book);
+    qof_event_resume ();
+    if (be)
+        be->commit = commit;
+    if (saved)
+        qof_book_mark_session_saved (book);
+
+    sixtp_destroy (top_parser);
+    g_free (gd);
+}
+
+/* Hands the held back price database to the book's GNCPriceDB. */
+static void
+defer_prices (parallel_load* load, QofBook* book)
+{
+    static const char root_end[] = "</" GNC_V2_STRING ">";
+    deferred_prices* prices = new deferred_prices;
+
+    prices->book = book;
+    prices->text.reserve (load->root_tag.size () + strlen (root_end) +
+                          load->prices_end - load->prices_begin);
+    prices->text.append (load->root_tag);
+    prices->text.append (load->data + load->prices_begin,
+                         load->prices_end - load->prices_begin);
+    prices->text.append (root_end);
+    gnc_pricedb_set_deferred_load (gnc_pricedb_get_db (book),
+                                   load_deferred_prices, prices,
+                                   free_deferred_prices);
+}
+
+/* Reads the book in file, or in mapped_name if that isn't NULL and the
+ * file can be mapped into memory; it must then be uncompressed. */
+static gboolean
+parse_file_in_parallel (sixtp* top_parser, FILE* file,
+                        const char* mapped_name, sixtp_gdv2* gd,
+                        QofBook* book)
+{
+    parallel_load load;
+    gxpf_data gpdata;
+    gpointer parse_result = NULL;
+    gboolean retval;
+
+    load.data = NULL;
+    load.size = 0;
+    load.mapping = NULL;
+    if (!load_whole_file (file, mapped_name, &load))
+    {
+        PWARN ("Error reading the file");
+        return FALSE;
+    }
+    qof_backend_stat_add (qof_book_get_backend (book), "xml.bytes", load.size);
+
+    gpdata.cb = generic_callback;
+    gpdata.parsedata = gd;
+    gpdata.bookdata = book;
+    load.gdata = &gpdata;
+    load.ok = TRUE;
+    load.run_begin = load.run_end = 0;
+    load.prices_begin = load.prices_end = std::string::npos;
+
+    gsize root_end = find_root_tag (&load);
+    if (root_end != std::string::npos)
+        plan_deferred_prices (&load, root_end);
+    if (root_end != std::string::npos && plan_parallel_load (&load, root_end))
+        start_parallel_load (&load);
+    else
+        load.chunks.clear ();
+
+    retval = sixtp_parse_push (top_parser,
+                               (sixtp_push_handler) parallel_load_push_handler,
+                               &load, NULL, &gpdata, &parse_result);
+    retval = retval && load.ok;
+    if (retval && load.prices_begin != std::string::npos)
+        defer_prices (&load, book);
+    finish_parallel_load (&load);
+    return retval;
+}
+
 static gboolean
 qof_session_load_from_xml_file_v2_full (
     FileBackend* fbe, QofBook* book,
@@ -782,42 +1452,58 @@ qof_session_load_from_xml_file_v2_full (
     xaccLogDisable ();
     xaccDisableDataScrubbing ();
 
-    if (push_handler)
     {
-        gpointer parse_result = NULL;
-        gxpf_data gpdata;
+        QofBackendPhase phase {be, "xml", "parse"};
+        if (push_handler)
+        {
+            gpointer parse_result = NULL;
+            gxpf_data gpdata;
 
-        gpdata.cb = generic_callback;
-        gpdata.parsedata = gd;
-        gpdata.bookdata = book;
+            gpdata.cb = generic_callback;
+            gpdata.parsedata = gd;
+            gpdata.bookdata = book;
 
-        retval = sixtp_parse_push (top_parser, push_handler, push_user_data,
-                                   NULL, &gpdata, &parse_result);
-    }
-    else
-    {
-        /* Even though libxml2 knows how to decompress zipped files, we
-         * do it ourself since as of version 2.9.1 it has a bug that
-         * causes it to fail to decompress certain files. See
-         * https://bugzilla.gnome.org/show_bug.cgi?id=712528 for more
-         * info.
-         */
-        gchar* filename = fbe->fullpath;
-        FILE* file;
-        gboolean is_compressed = is_gzipped_file (filename);
-        file = try_gz_open (filename, "r", is_compressed, FALSE);
-        if (file == NULL)
-        {
-            PWARN ("Unable to open file %s", filename);
-            retval = FALSE;
+            retval = sixtp_parse_push (top_parser, push_handler,
+                                       push_user_data, NULL, &gpdata,
+                                       &parse_result);
         }
         else
         {
-            retval = gnc_xml_parse_fd (top_parser, file,
-                                       generic_callback, gd, book);
-            fclose (file);
-            if (is_compressed)
-                wait_for_gzip (file);
+            /* Even though libxml2 knows how to decompress zipped files, we
+             * do it ourself since as of version 2.9.1 it has a bug that
+             * causes it to fail to decompress certain files. See
+             * https://bugzilla.gnome.org/show_bug.cgi?id=712528 for more
+             * info.
+             */
+            gchar* filename = fbe->fullpath;
+            FILE* file;
+            GStatBuf st;
+            GncXmlCodec codec = compressed_file_codec (filename);
+            gboolean is_compressed = codec != GNC_XML_CODEC_NONE;
+            file = try_gz_open (filename, "r", codec, FALSE);
+            if (file == NULL)
+            {
+                PWARN ("Unable to open file %s", filename);
+                retval = FALSE;
+            }
+            else
+            {
+                if (g_stat (filename, &st) == 0)
+                    qof_backend_stat_add (be, "xml.file-bytes", st.st_size);
+                /* The transactions are read in several threads unless the
+                 * DOM parser was asked for. */
+                if (type == GNC_BOOK_XML2_FILE &&
+                    !g_getenv ("GNC_XML_DOM_PARSER"))
+                    retval = parse_file_in_parallel (
+                        top_parser, file, is_compressed ? NULL : filename,
+                        gd, book);
+                else
+                    retval = gnc_xml_parse_fd (top_parser, file,
+                                               generic_callback, gd, book);
+                fclose (file);
+                if (is_compressed)
+                    wait_for_gzip (file);
+            }
         }
     }
 
@@ -829,6 +1515,7 @@ qof_session_load_from_xml_file_v2_full (
         goto bail;
     }
     debug_print_counter_data (&gd->counter);
+    record_counter_stats (be, &gd->counter);
 
     /* destroy the parser */
     sixtp_destroy (top_parser);
@@ -840,26 +1527,32 @@ qof_session_load_from_xml_file_v2_full (
     qof_book_mark_session_saved (book);
 
     /* Call individual scrub functions */
-    memset (&be_data, 0, sizeof (be_data));
-    be_data.book = book;
-    qof_object_foreach_backend (GNC_FILE_BACKEND, scrub_cb, &be_data);
+    {
+        QofBackendPhase phase {be, "xml", "scrub"};
+        memset (&be_data, 0, sizeof (be_data));
+        be_data.book = book;
+        qof_object_foreach_backend (GNC_FILE_BACKEND, scrub_cb, &be_data);
 
-    /* fix price quote sources */
-    root = gnc_book_get_root_account (book);
-    xaccAccountTreeScrubQuoteSources (root, gnc_commodity_table_get_table (book));
+        /* fix price quote sources */
+        root = gnc_book_get_root_account (book);
+        xaccAccountTreeScrubQuoteSources (root, gnc_commodity_table_get_table (book));
 
-    /* Fix account and transaction commodities */
-    xaccAccountTreeScrubCommodities (root);
+        /* Fix account and transaction commodities */
+        xaccAccountTreeScrubCommodities (root);
 
-    /* Fix split amount/value */
-    xaccAccountTreeScrubSplits (root);
+        /* Fix split amount/value */
+        xaccAccountTreeScrubSplits (root);
+    }
 
     /* commit all groups, this completes the BeginEdit started when the
      * account_end_handler finished reading the account.
      */
-    gnc_account_foreach_descendant (root,
-                                    (AccountCb) xaccAccountCommitEdit,
-                                    NULL);
+    {
+        QofBackendPhase phase {be, "xml", "commit-accounts"};
+        gnc_account_foreach_descendant (root,
+                                        (AccountCb) xaccAccountCommitEdit,
+                                        NULL);
+    }
 
     /* start logging again */
     xaccLogEnable ();
@@ -878,10 +1571,65 @@ qof_session_load_from_xml_file_v2 (FileBackend* fbe, QofBook* book,
     return qof_session_load_from_xml_file_v2_full (fbe, book, NULL, NULL, type);
 }
 
-/***********************************************************************/
+struct buffer_load
+{
+    const char* data;
+    gsize size;
+    gsize transactions_at;
+    std::vector<TransactionRecord*>* records;
+    gboolean ok;
+};
 
-static gboolean
-write_counts (FILE* out, ...)
+/* Feeds the XML to the parser, committing the records where the
+ * transactions were left out. */
+static void
+buffer_load_push_handler (xmlParserCtxtPtr xml_context, buffer_load* load)
+{
+    auto sax = static_cast<sixtp_sax_data*> (xml_context->userData);
+    gxpf_data* gdata = static_cast<gxpf_data*> (sax->global_data);
+    QofBook* book = static_cast<QofBook*> (gdata->bookdata);
+
+    load->ok &= push_buffer (xml_context, load->data, load->transactions_at,
+                             FALSE);
+    {
+        QofBackendPhase phase {qof_book_get_backend (book), "xml", "commit"};
+        for (auto& rec : *load->records)
+        {
+            Transaction* trn = gnc_transaction_record_commit (rec, book);
+            rec = NULL;
+            if (trn)
+                gdata->cb (TRANSACTION_TAG, gdata->parsedata, trn);
+            else
+                load->ok = FALSE;
+        }
+    }
+    load->ok &= push_buffer (xml_context, load->data + load->transactions_at,
+                             load->size - load->transactions_at, TRUE);
+}
+
+gboolean
+qof_session_load_from_xml_buffer_v2 (FileBackend* fbe, QofBook* book,
+                                     const char* data, gsize size,
+                                     gsize transactions_at,
+                                     std::vector<TransactionRecord*>& records)
+{
+    buffer_load load = { data, size, transactions_at, &records, TRUE };
+    gboolean retval;
+
+    g_return_val_if_fail (transactions_at <= size, FALSE);
+    retval = qof_session_load_from_xml_file_v2_full (
+                 fbe, book, (sixtp_push_handler) buffer_load_push_handler,
+                 &load, GNC_BOOK_XML2_FILE);
+    for (auto rec : records)
+        gnc_transaction_record_free (rec);
+    records.clear ();
+    return retval && load.ok;
+}
+
+/***********************************************************************/
+
+static gboolean
+write_counts (FILE* out, ...)
 {
     va_list ap;
     char* type;
@@ -1184,53 +1932,169 @@ write_pricedb (FILE* out, QofBook* book, sixtp_gdv2* gd)
     return TRUE;
 }
 
+/* Parallel saving
+ *
+ * Transactions are rendered to text in several threads, each taking a
+ * chunk of them in turn, and the chunks are written out in order, so the
+ * file is the same whatever the number of threads. Rendering only reads
+ * the transactions. */
+
+/* Lists shorter than this are rendered by the writing thread alone. */
+static const gsize min_parallel_save = 2000;
+/* How many transactions a thread renders at a time. */
+static const gsize save_chunk_size = 500;
+
+struct rendered_chunk
+{
+    std::vector<Transaction*>::const_iterator begin;
+    std::vector<Transaction*>::const_iterator end;
+    std::string text;
+};
+
+/* The number of threads to render the transactions in. GNC_XML_SAVE_THREADS
+ * overrides it, and the size limit, for testing and tuning. */
+static guint
+save_thread_count (gsize n_transactions)
+{
+    const char* env = g_getenv ("GNC_XML_SAVE_THREADS");
+    if (env)
+    {
+        gint64 n = g_ascii_strtoll (env, NULL, 10);
+        if (n > 0)
+            return MIN (n, 256);
+    }
+    if (n_transactions < min_parallel_save)
+        return 1;
+    return std::max (std::thread::hardware_concurrency (), 1u);
+}
+
 static int
-xml_add_trn_data (Transaction* t, gpointer data)
+collect_transaction_cb (Transaction* t, gpointer data)
 {
-    struct file_backend* be_data = static_cast<decltype (be_data)> (data);
-    xmlNodePtr node;
+    static_cast<std::vector<Transaction*>*> (data)->push_back (t);
+    return 0;
+}
 
-    node = gnc_transaction_dom_tree_create (t);
+static void
+render_transaction_chunk (rendered_chunk* chunk)
+{
+    GncXmlStream stream;
 
-    xmlElemDump (be_data->out, NULL, node);
-    xmlFreeNode (node);
+    for (auto iter = chunk->begin; iter != chunk->end; ++iter)
+    {
+        gnc_transaction_to_xml_stream (stream, *iter);
+        stream.newline ();
+    }
+    chunk->text = stream.take ();
+}
 
-    if (ferror (be_data->out) || fprintf (be_data->out, "\n") < 0)
-        return -1;
+static gboolean
+write_rendered_chunks (FILE* out, std::vector<rendered_chunk>& chunks,
+                       sixtp_gdv2* gd)
+{
+    for (auto& chunk : chunks)
+    {
+        if (fwrite (chunk.text.data (), 1, chunk.text.size (), out) !=
+            chunk.text.size ())
+            return FALSE;
+        gd->counter.transactions_loaded += chunk.end - chunk.begin;
+        sixtp_run_callback (gd, "transaction");
+    }
+    return TRUE;
+}
 
-    be_data->gd->counter.transactions_loaded++;
-    sixtp_run_callback (be_data->gd, "transaction");
-    return 0;
+static gboolean
+write_transaction_list (FILE* out, const std::vector<Transaction*>& trans,
+                        sixtp_gdv2* gd)
+{
+    guint threads = save_thread_count (trans.size ());
+    std::vector<rendered_chunk> pending;
+    std::vector<std::thread> workers;
+    gboolean success = TRUE;
+    auto next = trans.cbegin ();
+
+    if (threads < 2)
+    {
+        for (auto t : trans)
+        {
+            GncXmlStream stream (out);
+
+            gnc_transaction_to_xml_stream (stream, t);
+            if (!stream.flush () || fprintf (out, "\n") < 0)
+                return FALSE;
+            gd->counter.transactions_loaded++;
+            sixtp_run_callback (gd, "transaction");
+        }
+        return TRUE;
+    }
+
+    /* Each batch of chunks is rendered while the one before is written. */
+    while (TRUE)
+    {
+        std::vector<rendered_chunk> batch;
+
+        while (success && next != trans.cend () && batch.size () < threads)
+        {
+            auto end = next + std::min<gsize> (save_chunk_size,
+                                               trans.cend () - next);
+            batch.push_back ({next, end, {}});
+            next = end;
+        }
+        for (auto& chunk : batch)
+        {
+            try
+            {
+                workers.emplace_back (render_transaction_chunk, &chunk);
+            }
+            catch (const std::system_error& err)
+            {
+                PWARN ("Can't start a saving thread: %s", err.what ());
+                render_transaction_chunk (&chunk);
+            }
+        }
+
+        if (success && !write_rendered_chunks (out, pending, gd))
+            success = FALSE;
+
+        for (auto& worker : workers)
+            worker.join ();
+        workers.clear ();
+        if (batch.empty ())
+            break;
+        pending = std::move (batch);
+    }
+    return success;
 }
 
 static gboolean
 write_transactions (FILE* out, QofBook* book, sixtp_gdv2* gd)
 {
-    struct file_backend be_data;
+    std::vector<Transaction*> trans;
 
-    be_data.out = out;
-    be_data.gd = gd;
-    return 0 ==
-           xaccAccountTreeForEachTransaction (gnc_book_get_root_account (book),
-                                              xml_add_trn_data,
-                                              (gpointer) &be_data);
+    if (gd->omit_transactions)
+    {
+        gd->transactions_at = ftell (out);
+        return gd->transactions_at >= 0;
+    }
+
+    xaccAccountTreeForEachTransaction (gnc_book_get_root_account (book),
+                                       collect_transaction_cb, &trans);
+    return write_transaction_list (out, trans, gd);
 }
 
 static gboolean
 write_template_transaction_data (FILE* out, QofBook* book, sixtp_gdv2* gd)
 {
     Account* ra;
-    struct file_backend be_data;
-
-    be_data.out = out;
-    be_data.gd = gd;
+    std::vector<Transaction*> trans;
 
     ra = gnc_book_get_template_root (book);
     if (gnc_account_n_descendants (ra) > 0)
     {
+        xaccAccountTreeForEachTransaction (ra, collect_transaction_cb, &trans);
         if (fprintf (out, "<%s>\n", TEMPLATE_TRANSACTION_TAG) < 0
             || !write_account_tree (out, ra, gd)
-            || xaccAccountTreeForEachTransaction (ra, xml_add_trn_data, (gpointer)&be_data)
+            || !write_transaction_list (out, trans, gd)
             || fprintf (out, "</%s>\n", TEMPLATE_TRANSACTION_TAG) < 0)
 
             return FALSE;
@@ -1342,8 +2206,8 @@ write_v2_header (FILE* out)
     return TRUE;
 }
 
-gboolean
-gnc_book_write_to_xml_filehandle_v2 (QofBook* book, FILE* out)
+static gboolean
+write_book_file (QofBook* book, FILE* out, long* transactions_at)
 {
     QofBackend* be;
     sixtp_gdv2* gd;
@@ -1368,15 +2232,35 @@ gnc_book_write_to_xml_filehandle_v2 (QofBook* book, FILE* out)
                                     qof_book_get_collection (book, GNC_ID_BUDGET));
     gd->counter.prices_total = gnc_pricedb_get_num_prices (gnc_pricedb_get_db (
                                                                book));
+    gd->omit_transactions = transactions_at != NULL;
 
-    if (!write_book (out, book, gd)
-        || fprintf (out, "</" GNC_V2_STRING ">\n\n") < 0)
-        success = FALSE;
+    {
+        QofBackendPhase phase {be, "xml", "write"};
+        if (!write_book (out, book, gd)
+            || fprintf (out, "</" GNC_V2_STRING ">\n\n") < 0)
+            success = FALSE;
+    }
 
+    if (transactions_at)
+        *transactions_at = gd->transactions_at;
     g_free (gd);
     return success;
 }
 
+gboolean
+gnc_book_write_to_xml_filehandle_v2 (QofBook* book, FILE* out)
+{
+    return write_book_file (book, out, NULL);
+}
+
+gboolean
+gnc_book_write_without_transactions_v2 (QofBook* book, FILE* out,
+                                        long* transactions_at)
+{
+    g_return_val_if_fail (transactions_at, FALSE);
+    return write_book_file (book, out, transactions_at);
+}
+
 /*
  * This function is called by the "export" code.
  */
@@ -1417,17 +2301,578 @@ gnc_book_write_accounts_to_xml_filehandle_v2 (QofBackend* be, QofBook* book,
 
 #define BUFLEN 4096
 
+/* Block-parallel gzip
+ *
+ * Compressed books are written as a series of gzip members, each holding
+ * up to gz_block_size bytes of the XML compressed on its own, so that the
+ * blocks can be compressed in several threads. gzip and zlib read the
+ * concatenated members as one stream. The header of each member has an
+ * extra field, GC, with the member's length, so that a reader can find
+ * the members without inflating them and inflate them in parallel too.
+ */
+static const gsize gz_block_size = 1 << 20;
+/* The gzip header up to the value of the GC field, which comes next. */
+static const guchar gz_block_header[] =
+{
+    0x1f, 0x8b, Z_DEFLATED, 0x04 /* FEXTRA */, 0, 0, 0, 0, 0, 0xff,
+    8, 0 /* XLEN */, 'G', 'C', 4, 0 /* LEN */
+};
+#define GZ_BLOCK_HEADER_LEN (sizeof (gz_block_header) + 4)
+#define GZ_BLOCK_TRAILER_LEN 8
+/* No block we write inflates to more than this. */
+#define GZ_BLOCK_MAX_ISIZE (64 << 20)
+
+struct gz_block
+{
+    std::string in;
+    std::string out;
+    gboolean ok;
+};
+
+static guint
+gz_thread_count (void)
+{
+    return std::max (std::thread::hardware_concurrency (), 1u);
+}
+
+static void
+put_le32 (std::string& buf, gsize pos, guint32 value)
+{
+    for (gint i = 0; i < 4; ++i, value >>= 8)
+        buf[pos + i] = static_cast<char> (value & 0xff);
+}
+
+static guint32
+get_le32 (const std::string& buf, gsize pos)
+{
+    guint32 value = 0;
+    for (gint i = 3; i >= 0; --i)
+        value = (value << 8) | static_cast<guchar> (buf[pos + i]);
+    return value;
+}
+
+/* Compresses block->in into a whole gzip member in block->out. */
+static void
+gz_block_compress (gz_block* block)
+{
+    z_stream zs;
+    uLong bound;
+    int ret;
+
+    block->ok = FALSE;
+    memset (&zs, 0, sizeof (zs));
+    if (deflateInit2 (&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8,
+                      Z_DEFAULT_STRATEGY) != Z_OK)
+        return;
+
+    bound = deflateBound (&zs, block->in.size ());
+    block->out.assign (reinterpret_cast<const char*> (gz_block_header),
+                       sizeof (gz_block_header));
+    block->out.resize (GZ_BLOCK_HEADER_LEN + bound + GZ_BLOCK_TRAILER_LEN);
+    zs.next_in = reinterpret_cast<Bytef*> (&block->in[0]);
+    zs.avail_in = block->in.size ();
+    zs.next_out = reinterpret_cast<Bytef*> (&block->out[GZ_BLOCK_HEADER_LEN]);
+    zs.avail_out = bound;
+    ret = deflate (&zs, Z_FINISH);
+    deflateEnd (&zs);
+    if (ret != Z_STREAM_END)
+        return;
+
+    gsize len = GZ_BLOCK_HEADER_LEN + zs.total_out + GZ_BLOCK_TRAILER_LEN;
+    block->out.resize (len);
+    put_le32 (block->out, sizeof (gz_block_header), len);
+    put_le32 (block->out, len - 8,
+              crc32 (crc32 (0L, Z_NULL, 0),
+                     reinterpret_cast<const Bytef*> (block->in.data ()),
+                     block->in.size ()));
+    put_le32 (block->out, len - 4, block->in.size ());
+    block->ok = TRUE;
+}
+
+/* Inflates the gzip member in block->in into block->out, checking its
+ * crc and size. */
+static void
+gz_block_inflate (gz_block* block)
+{
+    const std::string& in = block->in;
+    gsize len = in.size ();
+    guint32 isize = get_le32 (in, len - 4);
+    z_stream zs;
+    int ret;
+
+    block->ok = FALSE;
+    if (isize > GZ_BLOCK_MAX_ISIZE)
+        return;
+    memset (&zs, 0, sizeof (zs));
+    if (inflateInit2 (&zs, -MAX_WBITS) != Z_OK)
+        return;
+
+    zs.next_in = reinterpret_cast<Bytef*> (const_cast<char*> (in.data ()) +
+                                           GZ_BLOCK_HEADER_LEN);
+    zs.avail_in = len - GZ_BLOCK_HEADER_LEN - GZ_BLOCK_TRAILER_LEN;
+    /* One spare byte, to tell a member that holds more than it says. */
+    block->out.resize (isize + 1);
+    zs.next_out = reinterpret_cast<Bytef*> (&block->out[0]);
+    zs.avail_out = isize + 1;
+    ret = inflate (&zs, Z_FINISH);
+    inflateEnd (&zs);
+    if (ret != Z_STREAM_END || zs.total_out != isize)
+        return;
+    block->out.resize (isize);
+    if (crc32 (crc32 (0L, Z_NULL, 0),
+               reinterpret_cast<const Bytef*> (block->out.data ()), isize) !=
+        get_le32 (in, len - 8))
+        return;
+    block->ok = TRUE;
+}
+
+/* Runs func over the blocks, each in a thread of its own, and returns the
+ * threads to join. A block whose thread can't be started is done here. */
+static std::vector<std::thread>
+gz_start_blocks (std::vector<gz_block>& blocks, void (*func) (gz_block*))
+{
+    std::vector<std::thread> workers;
+
+    if (blocks.size () == 1)
+    {
+        func (&blocks[0]);
+        return workers;
+    }
+    for (auto& block : blocks)
+    {
+        try
+        {
+            workers.emplace_back (func, &block);
+        }
+        catch (const std::system_error& err)
+        {
+            PWARN ("Can't start a compression thread: %s", err.what ());
+            func (&block);
+        }
+    }
+    return workers;
+}
+
+static void
+gz_join_blocks (std::vector<std::thread>& workers)
+{
+    for (auto& worker : workers)
+        worker.join ();
+    workers.clear ();
+}
+
+/* Reads up to len bytes from fd into buf; returns how many, or -1. */
+static gssize
+read_fd_fully (gint fd, std::string& buf, gsize len)
+{
+    gsize got = 0;
+
+    buf.resize (len);
+    while (got < len)
+    {
+        gssize bytes = read (fd, &buf[got], len - got);
+        if (bytes < 0 && errno == EINTR)
+            continue;
+        if (bytes < 0)
+            return -1;
+        if (bytes == 0)
+            break;
+        got += bytes;
+    }
+    buf.resize (got);
+    return got;
+}
+
+static gboolean
+write_fd_fully (gint fd, const std::string& buf)
+{
+    gsize done = 0;
+
+    while (done < buf.size ())
+    {
+        gssize bytes =
+#if COMPILER(MSVC)
+            _write
+#else
+            write
+#endif
+            (fd, buf.data () + done, buf.size () - done);
+        if (bytes < 0 && errno == EINTR)
+            continue;
+        if (bytes < 0)
+            return FALSE;
+        done += bytes;
+    }
+    return TRUE;
+}
+
+/* Compresses what comes down the pipe fd into filename, a batch of blocks
+ * at a time; each batch is read while the one before is compressed. */
+static gboolean
+gz_write_blocks (gint fd, const gchar* filename)
+{
+    guint threads = gz_thread_count ();
+    std::vector<gz_block> pending;
+    std::vector<std::thread> workers;
+    gboolean success = TRUE;
+    gboolean eof = FALSE;
+    gsize n_blocks = 0;
+    FILE* out;
+
+    out = g_fopen (filename, "wb");
+    if (!out)
+    {
+        g_warning ("Could not open the compressed file '%s'. The error is '%s' (errno %d)",
+                   filename, g_strerror (errno) ? g_strerror (errno) : "", errno);
+        success = FALSE;
+    }
+
+    while (TRUE)
+    {
+        std::vector<gz_block> batch;
+
+        while (success && !eof && batch.size () < threads)
+        {
+            gz_block block;
+            gssize bytes = read_fd_fully (fd, block.in, gz_block_size);
+
+            if (bytes < 0)
+            {
+                g_warning ("Could not read from pipe. The error is '%s' (errno %d)",
+                           g_strerror (errno) ? g_strerror (errno) : "", errno);
+                success = FALSE;
+                break;
+            }
+            eof = (gsize) bytes < gz_block_size;
+            /* Even an empty file gets a member. */
+            if (bytes > 0 || n_blocks == 0)
+            {
+                batch.push_back (std::move (block));
+                n_blocks++;
+            }
+        }
+
+        gz_join_blocks (workers);
+        for (auto& block : pending)
+        {
+            if (!success)
+                break;
+            if (!block.ok ||
+                fwrite (block.out.data (), 1, block.out.size (), out) !=
+                block.out.size ())
+            {
+                g_warning ("Could not write the compressed file '%s'.",
+                           filename);
+                success = FALSE;
+            }
+        }
+        pending.clear ();
+
+        if (!success || batch.empty ())
+            break;
+        pending = std::move (batch);
+        workers = gz_start_blocks (pending, gz_block_compress);
+    }
+    gz_join_blocks (workers);
+
+    if (out && fclose (out) != 0)
+    {
+        g_warning ("Could not close the compressed file '%s'.", filename);
+        success = FALSE;
+    }
+    return success;
+}
+
+/* Finds the members of a file written by gz_write_blocks. Returns FALSE if
+ * the file wasn't, or isn't whole. */
+static gboolean
+gz_find_blocks (const std::string& data,
+                std::vector<std::pair<gsize, gsize>>& members)
+{
+    gsize pos = 0;
+
+    while (pos < data.size ())
+    {
+        if (data.size () - pos < GZ_BLOCK_HEADER_LEN + GZ_BLOCK_TRAILER_LEN ||
+            data.compare (pos, sizeof (gz_block_header),
+                          reinterpret_cast<const char*> (gz_block_header),
+                          sizeof (gz_block_header)) != 0)
+            return FALSE;
+        gsize len = get_le32 (data, pos + sizeof (gz_block_header));
+        if (len < GZ_BLOCK_HEADER_LEN + GZ_BLOCK_TRAILER_LEN ||
+            len > data.size () - pos)
+            return FALSE;
+        members.push_back (std::make_pair (pos, len));
+        pos += len;
+    }
+    return !members.empty ();
+}
+
+/* Inflates filename into the pipe fd if it was written by gz_write_blocks.
+ * Returns FALSE, having written nothing, if it wasn't. */
+static gboolean
+gz_read_blocks (gint fd, const gchar* filename, gint* success)
+{
+    guint threads = gz_thread_count ();
+    std::vector<std::pair<gsize, gsize>> members;
+    std::vector<gz_block> done;
+    std::vector<std::thread> workers;
+    std::string data;
+    char head[sizeof (gz_block_header)];
+    gsize next = 0;
+    FILE* in;
+
+    in = g_fopen (filename, "rb");
+    if (!in)
+        return FALSE;
+    /* Don't read others into memory. */
+    if (fread (head, 1, sizeof (head), in) != sizeof (head) ||
+        memcmp (head, gz_block_header, sizeof (head)) != 0)
+    {
+        fclose (in);
+        return FALSE;
+    }
+    data.assign (head, sizeof (head));
+    {
+        char buffer[BUFLEN];
+        size_t len;
+        while ((len = fread (buffer, 1, sizeof (buffer), in)) > 0)
+            data.append (buffer, len);
+    }
+    if (ferror (in) || !gz_find_blocks (data, members))
+    {
+        fclose (in);
+        return FALSE;
+    }
+    fclose (in);
+
+    *success = 1;
+    while (*success && (next < members.size () || !done.empty ()))
+    {
+        std::vector<gz_block> batch;
+
+        for (; next < members.size () && batch.size () < threads; ++next)
+            batch.push_back ({data.substr (members[next].first,
+                                           members[next].second), {}, FALSE});
+        workers = gz_start_blocks (batch, gz_block_inflate);
+
+        /* Write out the last batch while this one is inflated. */
+        for (auto& block : done)
+        {
+            if (!block.ok)
+            {
+                g_warning ("Could not read from compressed file '%s'.",
+                           filename);
+                *success = 0;
+                break;
+            }
+            if (!write_fd_fully (fd, block.out))
+            {
+                g_warning ("Could not write to pipe. The error is '%s' (%d)",
+                           g_strerror (errno) ? g_strerror (errno) : "", errno);
+                *success = 0;
+                break;
+            }
+        }
+        gz_join_blocks (workers);
+        done = std::move (batch);
+    }
+    return TRUE;
+}
+
+#ifdef HAVE_ZSTD
+/* zstd
+ *
+ * A book compressed with zstd is a single frame. libzstd compresses it in
+ * several threads itself where it was built with them. */
+static const guchar zstd_magic[] = { 0x28, 0xb5, 0x2f, 0xfd };
+
+/* Compresses what is written to the pipe fd into filename. */
+static gint
+zstd_write_file (gint fd, const gchar* filename)
+{
+    ZSTD_CCtx* cctx;
+    std::string in;
+    std::string out (ZSTD_CStreamOutSize (), '\0');
+    gsize in_len = ZSTD_CStreamInSize ();
+    gboolean eof = FALSE;
+    gint success = 1;
+    FILE* file;
+
+    file = g_fopen (filename, "wb");
+    if (!file)
+    {
+        g_warning ("Could not open the compressed file '%s'. The error is '%s' (errno %d)",
+                   filename, g_strerror (errno) ? g_strerror (errno) : "", errno);
+        return 0;
+    }
+    cctx = ZSTD_createCCtx ();
+    ZSTD_CCtx_setParameter (cctx, ZSTD_c_compressionLevel, ZSTD_CLEVEL_DEFAULT);
+    /* Fails, leaving it to this thread, where libzstd has no threads. */
+    if (gz_thread_count () > 1)
+        ZSTD_CCtx_setParameter (cctx, ZSTD_c_nbWorkers, gz_thread_count ());
+
+    while (success && !eof)
+    {
+        gssize bytes = read_fd_fully (fd, in, in_len);
+        if (bytes < 0)
+        {
+            g_warning ("Could not read from pipe. The error is '%s' (errno %d)",
+                       g_strerror (errno) ? g_strerror (errno) : "", errno);
+            success = 0;
+            break;
+        }
+        eof = (gsize) bytes < in_len;
+
+        ZSTD_inBuffer input = { in.data (), in.size (), 0 };
+        ZSTD_EndDirective mode = eof ? ZSTD_e_end : ZSTD_e_continue;
+        gsize left;
+        do
+        {
+            ZSTD_outBuffer output = { &out[0], out.size (), 0 };
+            left = ZSTD_compressStream2 (cctx, &output, &input, mode);
+            if (ZSTD_isError (left))
+            {
+                g_warning ("Could not compress to '%s': %s", filename,
+                           ZSTD_getErrorName (left));
+                success = 0;
+                break;
+            }
+            if (fwrite (out.data (), 1, output.pos, file) != output.pos)
+            {
+                g_warning ("Could not write the compressed file '%s'.",
+                           filename);
+                success = 0;
+                break;
+            }
+        }
+        /* Ending the frame flushes it all; otherwise take all the input. */
+        while (eof ? left != 0 : input.pos < input.size);
+    }
+    ZSTD_freeCCtx (cctx);
+    if (fclose (file) != 0)
+    {
+        g_warning ("Could not close the compressed file '%s'.", filename);
+        success = 0;
+    }
+    return success;
+}
+
+/* Decompresses filename into the pipe fd. */
+static gint
+zstd_read_file (gint fd, const gchar* filename)
+{
+    ZSTD_DCtx* dctx;
+    std::string in (ZSTD_DStreamInSize (), '\0');
+    std::string out;
+    gsize out_len = ZSTD_DStreamOutSize ();
+    gsize last = 0;
+    gint success = 1;
+    size_t len;
+    FILE* file;
+
+    file = g_fopen (filename, "rb");
+    if (!file)
+    {
+        g_warning ("Could not open the compressed file '%s'.", filename);
+        return 0;
+    }
+    dctx = ZSTD_createDCtx ();
+    while (success && (len = fread (&in[0], 1, in.size (), file)) > 0)
+    {
+        ZSTD_inBuffer input = { in.data (), len, 0 };
+        while (success && input.pos < input.size)
+        {
+            out.resize (out_len);
+            ZSTD_outBuffer output = { &out[0], out.size (), 0 };
+            last = ZSTD_decompressStream (dctx, &output, &input);
+            if (ZSTD_isError (last))
+            {
+                g_warning ("Could not read from compressed file '%s'. The error is: '%s'",
+                           filename, ZSTD_getErrorName (last));
+                success = 0;
+                break;
+            }
+            out.resize (output.pos);
+            if (!write_fd_fully (fd, out))
+            {
+                g_warning ("Could not write to pipe. The error is '%s' (%d)",
+                           g_strerror (errno) ? g_strerror (errno) : "", errno);
+                success = 0;
+            }
+        }
+    }
+    /* A frame cut short leaves the last call wanting more. */
+    if (success && (ferror (file) || last != 0))
+    {
+        g_warning ("Compressed file '%s' is truncated.", filename);
+        success = 0;
+    }
+    ZSTD_freeDCtx (dctx);
+    fclose (file);
+    return success;
+}
+
+/* Reads up to len bytes of the start of the book in filename. */
+static gssize
+zstd_read_head (const gchar* filename, char* buf, gsize len)
+{
+    ZSTD_DCtx* dctx;
+    std::string in (ZSTD_DStreamInSize (), '\0');
+    ZSTD_outBuffer output = { buf, len, 0 };
+    size_t read_len;
+    FILE* file = g_fopen (filename, "rb");
+
+    if (!file)
+        return -1;
+    dctx = ZSTD_createDCtx ();
+    while (output.pos < len &&
+           (read_len = fread (&in[0], 1, in.size (), file)) > 0)
+    {
+        ZSTD_inBuffer input = { in.data (), read_len, 0 };
+        while (output.pos < len && input.pos < input.size)
+            if (ZSTD_isError (ZSTD_decompressStream (dctx, &output, &input)))
+            {
+                output.pos = 0;
+                read_len = 0;
+                break;
+            }
+        if (read_len == 0)
+            break;
+    }
+    ZSTD_freeDCtx (dctx);
+    fclose (file);
+    return output.pos;
+}
+#endif /* HAVE_ZSTD */
+
 /* Compress or decompress function that is to be run in a separate thread.
  * Returns 1 on success or 0 otherwise, stuffed into a pointer type. */
 static gpointer
 gz_thread_func (gz_thread_params_t* params)
 {
     gchar buffer[BUFLEN];
-    gssize bytes;
     gint gzval;
     gzFile file;
     gint success = 1;
 
+#ifdef HAVE_ZSTD
+    if (params->codec == GNC_XML_CODEC_ZSTD)
+    {
+        success = params->compress ?
+                  zstd_write_file (params->fd, params->filename) :
+                  zstd_read_file (params->fd, params->filename);
+        goto cleanup_gz_thread_func;
+    }
+#endif
+    if (params->compress)
+    {
+        success = gz_write_blocks (params->fd, params->filename);
+        goto cleanup_gz_thread_func;
+    }
+    if (gz_read_blocks (params->fd, params->filename, &success))
+        goto cleanup_gz_thread_func;
+
 #ifdef G_OS_WIN32
     {
         gchar* conv_name = g_win32_locale_filename_from_utf8 (params->filename);
@@ -1461,67 +2906,36 @@ gz_thread_func (gz_thread_params_t* params)
         goto cleanup_gz_thread_func;
     }
 
-    if (params->compress)
-    {
-        while (success)
-        {
-            bytes = read (params->fd, buffer, BUFLEN);
-            if (bytes > 0)
-            {
-                if (gzwrite (file, buffer, bytes) <= 0)
-                {
-                    gint errnum;
-                    const gchar* error = gzerror (file, &errnum);
-                    g_warning ("Could not write the compressed file '%s'. The error is: '%s' (%d)",
-                               params->filename, error, errnum);
-                    success = 0;
-                }
-            }
-            else if (bytes == 0)
-            {
-                break;
-            }
-            else
-            {
-                g_warning ("Could not read from pipe. The error is '%s' (errno %d)",
-                           g_strerror (errno) ? g_strerror (errno) : "", errno);
-                success = 0;
-            }
-        }
-    }
-    else
+    while (success)
     {
-        while (success)
+        gzval = gzread (file, buffer, BUFLEN);
+        if (gzval > 0)
         {
-            gzval = gzread (file, buffer, BUFLEN);
-            if (gzval > 0)
-            {
-                if (
+            if (
 #if COMPILER(MSVC)
-                    _write
+                _write
 #else
-                    write
+                write
 #endif
-                    (params->fd, buffer, gzval) < 0)
-                {
-                    g_warning ("Could not write to pipe. The error is '%s' (%d)",
-                               g_strerror (errno) ? g_strerror (errno) : "", errno);
-                    success = 0;
-                }
-            }
-            else if (gzval == 0)
-            {
-                break;
-            }
-            else
+                (params->fd, buffer, gzval) < 0)
             {
-                gint errnum;
-                const gchar* error = gzerror (file, &errnum);
-                g_warning ("Could not read from compressed file '%s'. The error is: '%s' (%d)",
-                           params->filename, error, errnum);
+                g_warning ("Could not write to pipe. The error is '%s' (%d)",
+                           g_strerror (errno) ? g_strerror (errno) : "", errno);
                 success = 0;
             }
         }
+        else if (gzval == 0)
+        {
+            break;
+        }
+        else
+        {
+            gint errnum;
+            const gchar* error = gzerror (file, &errnum);
+            g_warning ("Could not read from compressed file '%s'. The error is: '%s' (%d)",
+                       params->filename, error, errnum);
+            success = 0;
+        }
     }
 
     if ((gzval = gzclose (file)) != Z_OK)
@@ -1541,13 +2955,13 @@ cleanup_gz_thread_func:
 }
 
 static FILE*
-try_gz_open (const char* filename, const char* perms, gboolean use_gzip,
+try_gz_open (const char* filename, const char* perms, GncXmlCodec codec,
              gboolean compress)
 {
     if (strstr (filename, ".gz.") != NULL) /* its got a temp extension */
-        use_gzip = TRUE;
+        codec = GNC_XML_CODEC_GZIP;
 
-    if (!use_gzip)
+    if (codec == GNC_XML_CODEC_NONE)
         return g_fopen (filename, perms);
 
     {
@@ -1573,6 +2987,7 @@ try_gz_open (const char* filename, const char* perms, gboolean use_gzip,
         params->filename = g_strdup (filename);
         params->perms = g_strdup (perms);
         params->compress = compress;
+        params->codec = codec;
 
 #ifndef HAVE_GLIB_2_32
         thread = g_thread_create ((GThreadFunc) gz_thread_func, params,
@@ -1632,16 +3047,41 @@ wait_for_gzip (FILE* file)
     return retval;
 }
 
+GncXmlCodec
+gnc_xml_codec_from_name (const char* name)
+{
+    if (g_strcmp0 (name, "zstd") == 0)
+    {
+#ifdef HAVE_ZSTD
+        return GNC_XML_CODEC_ZSTD;
+#else
+        PWARN ("Built without zstd, compressing with gzip instead");
+#endif
+    }
+    else if (name && *name && g_strcmp0 (name, "gzip") != 0)
+        PWARN ("Unknown compression '%s', using gzip", name);
+    return GNC_XML_CODEC_GZIP;
+}
+
 gboolean
 gnc_book_write_to_xml_file_v2 (
     QofBook* book,
     const char* filename,
     gboolean compress)
+{
+    return gnc_book_write_to_xml_file_v2_codec (
+               book, filename, compress ? GNC_XML_CODEC_GZIP : GNC_XML_CODEC_NONE);
+}
+
+gboolean
+gnc_book_write_to_xml_file_v2_codec (QofBook* book, const char* filename,
+                                     GncXmlCodec codec)
 {
     FILE* out;
     gboolean success = TRUE;
+    gboolean compress = codec != GNC_XML_CODEC_NONE;
 
-    out = try_gz_open (filename, "w", compress, TRUE);
+    out = try_gz_open (filename, "w", codec, TRUE);
 
     /* Try to write as much as possible */
     if (!out
@@ -1661,6 +3101,43 @@ gnc_book_write_to_xml_file_v2 (
     return success;
 }
 
+gboolean
+gnc_book_write_to_xml_snapshot_v2 (QofBook* book, FILE* snapshot)
+{
+    return gnc_book_write_to_xml_filehandle_v2 (book, snapshot) &&
+           write_emacs_trailer (snapshot) && fflush (snapshot) == 0;
+}
+
+gboolean
+gnc_xml_write_snapshot_v2 (FILE* snapshot, const char* filename,
+                           GncXmlCodec codec)
+{
+    FILE* out;
+    gchar buffer[BUFLEN];
+    size_t len;
+    gboolean success = TRUE;
+    gboolean compress = codec != GNC_XML_CODEC_NONE;
+
+    if (fseek (snapshot, 0, SEEK_SET) != 0)
+        return FALSE;
+    out = try_gz_open (filename, "w", codec, TRUE);
+    if (!out)
+        return FALSE;
+
+    while (success && (len = fread (buffer, 1, sizeof (buffer), snapshot)) > 0)
+        if (fwrite (buffer, 1, len, out) != len)
+            success = FALSE;
+    if (ferror (snapshot))
+        success = FALSE;
+
+    if (fclose (out))
+        success = FALSE;
+    if (compress && !wait_for_gzip (out))
+        success = FALSE;
+
+    return success;
+}
+
 /*
  * Have to pass in the backend as this routine needs the temporary
  * backend for file export, not the real backend which could be
@@ -1698,36 +3175,53 @@ gnc_book_write_accounts_to_xml_file_v2 (
 }
 
 /***********************************************************************/
-static gboolean
-is_gzipped_file (const gchar* name)
+static GncXmlCodec
+compressed_file_codec (const gchar* name)
 {
-    unsigned char buf[2];
+    unsigned char buf[4];
     int fd = g_open (name, O_RDONLY, 0);
+    gssize len;
 
     if (fd == -1)
     {
-        return FALSE;
+        return GNC_XML_CODEC_NONE;
     }
 
-    if (read (fd, buf, 2) != 2)
-    {
-        close (fd);
-        return FALSE;
-    }
+    len = read (fd, buf, sizeof (buf));
     close (fd);
 
-    if (buf[0] == 037 && buf[1] == 0213)
+    if (len >= 2 && buf[0] == 037 && buf[1] == 0213)
     {
-        return TRUE;
+        return GNC_XML_CODEC_GZIP;
+    }
+#ifdef HAVE_ZSTD
+    if (len == sizeof (zstd_magic) && memcmp (buf, zstd_magic, len) == 0)
+    {
+        return GNC_XML_CODEC_ZSTD;
     }
+#endif
 
-    return FALSE;
+    return GNC_XML_CODEC_NONE;
 }
 
 QofBookFileType
 gnc_is_xml_data_file_v2 (const gchar* name, gboolean* with_encoding)
 {
-    if (is_gzipped_file (name))
+    GncXmlCodec codec = compressed_file_codec (name);
+
+#ifdef HAVE_ZSTD
+    if (codec == GNC_XML_CODEC_ZSTD)
+    {
+        char first_chunk[256];
+        gssize num_read = zstd_read_head (name, first_chunk,
+                                          sizeof (first_chunk) - 1);
+        if (num_read < 1)
+            return GNC_BOOK_NOT_OURS;
+        first_chunk[num_read] = '\0';
+        return gnc_is_our_first_xml_chunk (first_chunk, with_encoding);
+    }
+#endif
+    if (codec == GNC_XML_CODEC_GZIP)
     {
         gzFile file = NULL;
         char first_chunk[256];
@@ -1853,11 +3347,13 @@ gnc_xml2_find_ambiguous (const gchar* filename, GList* encodings,
     GHashTable* processed = NULL;
     gint n_impossible = 0;
     GError* error = NULL;
+    GncXmlCodec codec;
     gboolean is_compressed;
     gboolean clean_return = FALSE;
 
-    is_compressed = is_gzipped_file (filename);
-    file = try_gz_open (filename, "r", is_compressed, FALSE);
+    codec = compressed_file_codec (filename);
+    is_compressed = codec != GNC_XML_CODEC_NONE;
+    file = try_gz_open (filename, "r", codec, FALSE);
     if (file == NULL)
     {
         PWARN ("Unable to open file %s", filename);
@@ -2061,11 +3557,13 @@ parse_with_subst_push_handler (xmlParserCtxtPtr xml_context,
     GIConv ascii = (GIConv) - 1;
     GString* output = NULL;
     GError* error = NULL;
+    GncXmlCodec codec;
     gboolean is_compressed;
 
     filename = push_data->filename;
-    is_compressed = is_gzipped_file (filename);
-    file = try_gz_open (filename, "r", is_compressed, FALSE);
+    codec = compressed_file_codec (filename);
+    is_compressed = codec != GNC_XML_CODEC_NONE;
+    file = try_gz_open (filename, "r", codec, FALSE);
     if (file == NULL)
     {
         PWARN ("Unable to open file %s", filename);
@@ -2203,3 +3701,201 @@ gnc_xml2_parse_with_subst (FileBackend* fbe, QofBook* book, GHashTable* subst)
 
     return success;
 }
+
+/* Journal
+ *
+ * The journal holds the transactions changed since the book file was last
+ * written in full. It is a document that is only ever appended to: each
+ * save adds the changed transactions, a delete for each one that is gone,
+ * and a synced mark, so that a save cut short is ignored when the journal
+ * is read back. It isn't closed; the reader closes it. The root's base
+ * attribute names the state of the book file the journal goes with.
+ */
+#define JOURNAL_ROOT_TAG "gnc-journal"
+#define JOURNAL_DELETE_TAG "journal:delete"
+#define JOURNAL_SYNCED_TAG "journal:synced"
+
+static std::string
+journal_header_start (const gchar* base)
+{
+    return std::string ("<?xml version=\"1.0\" encoding=\"utf-8\" ?>\n<"
+                        JOURNAL_ROOT_TAG " base=\"") + base + "\"";
+}
+
+static gboolean
+write_journal_header (FILE* out, const gchar* base)
+{
+    std::string start = journal_header_start (base);
+
+    return fwrite (start.data (), 1, start.size (), out) == start.size ()
+           && gnc_xml2_write_namespace_decl (out, "gnc")
+           && gnc_xml2_write_namespace_decl (out, "cmdty")
+           && gnc_xml2_write_namespace_decl (out, "slot")
+           && gnc_xml2_write_namespace_decl (out, "split")
+           && gnc_xml2_write_namespace_decl (out, "trn")
+           && gnc_xml2_write_namespace_decl (out, "ts")
+           && gnc_xml2_write_namespace_decl (out, "journal")
+           && fprintf (out, ">\n") >= 0;
+}
+
+gboolean
+gnc_xml_journal_append (QofBook* book, const gchar* filename,
+                        const gchar* base, GList* guids)
+{
+    FILE* out;
+    gboolean success;
+
+    g_return_val_if_fail (book && filename && base, FALSE);
+
+    out = g_fopen (filename, "ab");
+    if (!out)
+        return FALSE;
+
+    success = fseek (out, 0, SEEK_END) == 0;
+    if (success && ftell (out) == 0)
+        success = write_journal_header (out, base);
+
+    for (GList* node = guids; success && node; node = node->next)
+    {
+        const GncGUID* guid = static_cast<const GncGUID*> (node->data);
+        Transaction* trn = xaccTransLookup (guid, book);
+
+        if (trn)
+        {
+            GncXmlStream stream (out);
+
+            gnc_transaction_to_xml_stream (stream, trn);
+            success = stream.flush () && fprintf (out, "\n") >= 0;
+        }
+        else
+        {
+            char guid_str[GUID_ENCODING_LENGTH + 1];
+
+            guid_to_string_buff (guid, guid_str);
+            success = fprintf (out, "<" JOURNAL_DELETE_TAG " type=\"guid\">%s</"
+                               JOURNAL_DELETE_TAG ">\n", guid_str) >= 0;
+        }
+    }
+    if (success)
+        success = fprintf (out, "<" JOURNAL_SYNCED_TAG "/>\n") >= 0;
+
+    if (fclose (out) != 0)
+        success = FALSE;
+    return success;
+}
+
+/* Takes out the transaction about to be read back from the journal. */
+static void
+journal_drop_transaction (QofBook* book, const GncGUID* guid)
+{
+    Transaction* trn = xaccTransLookup (guid, book);
+
+    if (!trn)
+        return;
+    xaccTransBeginEdit (trn);
+    xaccTransClearReadOnly (trn);
+    xaccTransDestroy (trn);
+    xaccTransCommitEdit (trn);
+}
+
+static gboolean
+journal_transaction_cb (const char* tag, gpointer parsedata, gpointer data)
+{
+    QofBook* book = static_cast<decltype (book)> (parsedata);
+    TransactionRecord* rec = static_cast<decltype (rec)> (data);
+    const GncGUID* guid = gnc_transaction_record_get_guid (rec);
+
+    if (guid)
+        journal_drop_transaction (book, guid);
+    return gnc_transaction_record_commit (rec, book) != NULL;
+}
+
+static gboolean
+journal_delete_end_handler (gpointer data_for_children,
+                            GSList* data_from_children, GSList* sibling_data,
+                            gpointer parent_data, gpointer global_data,
+                            gpointer* result, const gchar* tag)
+{
+    gxpf_data* gdata = static_cast<decltype (gdata)> (global_data);
+    gchar* txt = concatenate_child_result_chars (data_from_children);
+    GncGUID guid;
+    gboolean ok;
+
+    g_return_val_if_fail (txt, FALSE);
+    ok = string_to_guid (txt, &guid);
+    g_free (txt);
+    if (!ok)
+    {
+        PERR ("couldn't parse GncGUID");
+        return FALSE;
+    }
+    journal_drop_transaction (static_cast<QofBook*> (gdata->bookdata), &guid);
+    return TRUE;
+}
+
+gboolean
+gnc_xml_journal_replay (QofBook* book, const gchar* filename,
+                        const gchar* base, gboolean* stale)
+{
+    static const char synced[] = "<" JOURNAL_SYNCED_TAG "/>\n";
+    std::string buffer;
+    gpointer parse_result = NULL;
+    gxpf_data gpdata;
+    sixtp* top_parser;
+    sixtp* journal_parser;
+    FILE* file;
+    gsize end;
+    gboolean retval;
+
+    g_return_val_if_fail (book && filename && stale, FALSE);
+
+    *stale = FALSE;
+    file = g_fopen (filename, "rb");
+    if (!file)
+        return FALSE;
+    retval = read_whole_file (file, buffer);
+    fclose (file);
+    if (!retval)
+        return FALSE;
+
+    std::string start = base ? journal_header_start (base) : "";
+    if (start.empty () || buffer.compare (0, start.size (), start) != 0)
+    {
+        *stale = TRUE;
+        return FALSE;
+    }
+    end = buffer.rfind (synced);
+    if (end == std::string::npos)
+        return TRUE;
+    buffer.resize (end + strlen (synced));
+    buffer += "</" JOURNAL_ROOT_TAG ">\n";
+
+    top_parser = sixtp_new ();
+    journal_parser = sixtp_new ();
+    if (!sixtp_add_some_sub_parsers (
+            top_parser, TRUE,
+            JOURNAL_ROOT_TAG, journal_parser,
+            NULL, NULL)
+        || !sixtp_add_some_sub_parsers (
+            journal_parser, TRUE,
+            TRANSACTION_TAG, gnc_transaction_record_sixtp_parser_create (),
+            JOURNAL_DELETE_TAG,
+            simple_chars_only_parser_new (journal_delete_end_handler),
+            JOURNAL_SYNCED_TAG, sixtp_new (),
+            NULL, NULL))
+    {
+        sixtp_destroy (top_parser);
+        return FALSE;
+    }
+
+    gpdata.cb = journal_transaction_cb;
+    gpdata.parsedata = book;
+    gpdata.bookdata = book;
+
+    xaccLogDisable ();
+    retval = sixtp_parse_buffer (top_parser, &buffer[0], buffer.size (), NULL,
+                                 &gpdata, &parse_result);
+    xaccLogEnable ();
+    sixtp_destroy (top_parser);
+    return retval;
+}
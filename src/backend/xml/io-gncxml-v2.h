@@ -89,6 +89,30 @@ gboolean gnc_book_write_to_xml_filehandle_v2 (QofBook* book, FILE* fh);
 gboolean gnc_book_write_to_xml_file_v2 (QofBook* book, const char* filename,
                                         gboolean compress);
 
+/** How a book file is compressed. Reading tells them apart by their
+ * magic bytes, so any of them can be opened whatever is saved with. */
+typedef enum
+{
+    GNC_XML_CODEC_NONE,
+    GNC_XML_CODEC_GZIP,
+    GNC_XML_CODEC_ZSTD          /**< Only where built with libzstd */
+} GncXmlCodec;
+
+/** The codec named "gzip" or "zstd". Others, and zstd if it wasn't built
+ * in, are gzip. */
+GncXmlCodec gnc_xml_codec_from_name (const char* name);
+gboolean gnc_book_write_to_xml_file_v2_codec (QofBook* book,
+                                              const char* filename,
+                                              GncXmlCodec codec);
+
+/** Write the book uncompressed to snapshot, a temporary file, for
+ * gnc_xml_write_snapshot_v2 to put into the book file later. */
+gboolean gnc_book_write_to_xml_snapshot_v2 (QofBook* book, FILE* snapshot);
+/** Write a snapshot to filename compressed with codec. This doesn't touch
+ * the book, so it can run in a thread while the book is worked on. */
+gboolean gnc_xml_write_snapshot_v2 (FILE* snapshot, const char* filename,
+                                    GncXmlCodec codec);
+
 /** write just the commodities and accounts to a file */
 gboolean gnc_book_write_accounts_to_xml_filehandle_v2 (QofBackend* be,
                                                        QofBook* book, FILE* fh);
@@ -145,7 +169,53 @@ gint gnc_xml2_find_ambiguous (
  */
 gboolean gnc_xml2_parse_with_subst (
     FileBackend* fbe, QofBook* book, GHashTable* subst);
+
+/** Append the transactions with the given GUIDs to the journal, or a
+ * deletion for each that is no longer in the book, starting the journal if
+ * need be.
+ *
+ * @param filename The journal.
+ *
+ * @param base Names the state of the book file the journal goes with.
+ *
+ * @param guids List of GncGUID* of transactions changed since the last save.
+ */
+gboolean gnc_xml_journal_append (QofBook* book, const gchar* filename,
+                                 const gchar* base, GList* guids);
+
+/** Apply the journal to the book just loaded from its file. Saves that
+ * were cut short are ignored.
+ *
+ * @param stale Set if the journal doesn't go with the state @a base of the
+ * book file, in which case nothing is applied.
+ *
+ * @return FALSE if the journal couldn't be applied.
+ */
+gboolean gnc_xml_journal_replay (QofBook* book, const gchar* filename,
+                                 const gchar* base, gboolean* stale);
+
+/** Write the book like gnc_book_write_to_xml_filehandle_v2, but leave
+ * its transactions out; they are kept apart by the binary file format,
+ * see io-gncbin.h.
+ *
+ * @param transactions_at Set to the offset in @a fh where the
+ * transactions belong.
+ */
+gboolean gnc_book_write_without_transactions_v2 (QofBook* book, FILE* fh,
+                                                 long* transactions_at);
 #ifdef __cplusplus
 }
+
+#include <vector>
+
+struct TransactionRecord;
+/** Read a book from XML written by gnc_book_write_without_transactions_v2,
+ * adding the records as its transactions at @a transactions_at. The
+ * records are used up either way.
+ */
+gboolean qof_session_load_from_xml_buffer_v2 (FileBackend* fbe, QofBook* book,
+                                              const char* data, gsize size,
+                                              gsize transactions_at,
+                                              std::vector<TransactionRecord*>& records);
 #endif
 #endif /* __IO_GNCXML_V2_H__ */
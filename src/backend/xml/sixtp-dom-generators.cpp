@@ -370,3 +370,343 @@ qof_instance_slots_to_dom_tree (const char* tag, const QofInstance* inst)
     frame->for_each_slot (add_kvp_slot, static_cast<void*> (ret));
     return ret;
 }
+
+/* Buffered output is written out once there's this much of it. */
+static const size_t xml_stream_flush_size = 64 * 1024;
+
+GncXmlStream::GncXmlStream (FILE* out) : m_out (out)
+{
+}
+
+GncXmlStream::~GncXmlStream ()
+{
+    flush ();
+}
+
+gboolean
+GncXmlStream::flush ()
+{
+    if (!m_out)
+        return TRUE;
+    if (!m_buf.empty ())
+    {
+        fwrite (m_buf.data (), 1, m_buf.size (), m_out);
+        m_buf.clear ();
+    }
+    return !ferror (m_out);
+}
+
+std::string
+GncXmlStream::take ()
+{
+    std::string out;
+    out.swap (m_buf);
+    return out;
+}
+
+void
+GncXmlStream::newline ()
+{
+    m_buf += '\n';
+}
+
+/* Escapes the text the way xmlElemDump does for a document with no
+ * encoding, after cleaning it up the way checked_char_cast does. */
+void
+GncXmlStream::escape (const char* text, gboolean attr)
+{
+    gchar* copy = nullptr;
+
+    if (!g_utf8_validate (text, -1, nullptr))
+        text = copy = reinterpret_cast<gchar*> (checked_char_cast (g_strdup (text)));
+
+    for (auto p = text; *p; ++p)
+    {
+        switch (*p)
+        {
+        case '<':
+            m_buf += "&lt;";
+            break;
+        case '>':
+            m_buf += "&gt;";
+            break;
+        case '&':
+            m_buf += "&amp;";
+            break;
+        case '\r':
+            m_buf += "&#13;";
+            break;
+        case '"':
+            m_buf += attr ? "&quot;" : "\"";
+            break;
+        case '\n':
+            m_buf += attr ? "&#10;" : "\n";
+            break;
+        case '\t':
+            m_buf += attr ? "&#9;" : "\t";
+            break;
+        default:
+            m_buf += (*p > 0 && *p < 0x20) ? '?' : *p;
+            break;
+        }
+    }
+    g_free (copy);
+}
+
+void
+GncXmlStream::open_child (const char* tag, const char* attr,
+                          const char* value)
+{
+    if (!m_open.empty () && !m_open.back ().second)
+    {
+        m_buf += ">\n";
+        m_open.back ().second = TRUE;
+    }
+    m_buf.append (2 * m_open.size (), ' ');
+    m_buf += '<';
+    m_buf += tag;
+    if (attr)
+    {
+        m_buf += ' ';
+        m_buf += attr;
+        m_buf += "=\"";
+        escape (value, TRUE);
+        m_buf += '"';
+    }
+}
+
+void
+GncXmlStream::close_child ()
+{
+    if (m_open.empty ())
+        return;
+    m_buf += '\n';
+    if (m_buf.size () >= xml_stream_flush_size)
+        flush ();
+}
+
+void
+GncXmlStream::start_element (const char* tag, const char* attr,
+                             const char* value)
+{
+    open_child (tag, attr, value);
+    m_open.emplace_back (tag, FALSE);
+}
+
+void
+GncXmlStream::end_element ()
+{
+    g_return_if_fail (!m_open.empty ());
+
+    auto elem = m_open.back ();
+    m_open.pop_back ();
+    if (!elem.second)
+    {
+        m_buf += "/>";
+    }
+    else
+    {
+        m_buf.append (2 * m_open.size (), ' ');
+        m_buf += "</";
+        m_buf += elem.first;
+        m_buf += '>';
+    }
+    close_child ();
+}
+
+void
+GncXmlStream::text_element (const char* tag, const char* text,
+                            const char* attr, const char* value)
+{
+    open_child (tag, attr, value);
+    if (!text)
+    {
+        m_buf += "/>";
+    }
+    else
+    {
+        m_buf += '>';
+        escape (text, FALSE);
+        m_buf += "</";
+        m_buf += tag;
+        m_buf += '>';
+    }
+    close_child ();
+}
+
+void
+guid_to_xml_stream (GncXmlStream& out, const char* tag, const GncGUID* gid)
+{
+    char guid_str[GUID_ENCODING_LENGTH + 1];
+
+    if (!guid_to_string_buff (gid, guid_str))
+    {
+        PERR ("guid_to_string_buff failed\n");
+        return;
+    }
+    out.text_element (tag, guid_str, "type", "guid");
+}
+
+void
+commodity_ref_to_xml_stream (GncXmlStream& out, const char* tag,
+                             const gnc_commodity* c)
+{
+    g_return_if_fail (c);
+
+    if (!gnc_commodity_get_namespace (c) || !gnc_commodity_get_mnemonic (c))
+        return;
+    out.start_element (tag);
+    out.text_element ("cmdty:space", gnc_commodity_get_namespace_compat (c));
+    out.text_element ("cmdty:id", gnc_commodity_get_mnemonic (c));
+    out.end_element ();
+}
+
+void
+timespec_to_xml_stream (GncXmlStream& out, const char* tag,
+                        const Timespec* spec, const char* type)
+{
+    gchar* date_str;
+
+    g_return_if_fail (spec);
+
+    date_str = timespec_sec_to_string (spec);
+    if (!date_str)
+        return;
+
+    out.start_element (tag, type ? "type" : nullptr, type);
+    out.text_element ("ts:date", date_str);
+    if (spec->tv_nsec > 0)
+    {
+        gchar* ns_str = timespec_nsec_to_string (spec);
+        if (ns_str)
+            out.text_element ("ts:ns", ns_str);
+        g_free (ns_str);
+    }
+    out.end_element ();
+    g_free (date_str);
+}
+
+void
+gdate_to_xml_stream (GncXmlStream& out, const char* tag, const GDate* date,
+                     const char* type)
+{
+    gchar date_str[512];
+
+    g_return_if_fail (date);
+
+    g_date_strftime (date_str, sizeof (date_str), "%Y-%m-%d", date);
+    out.start_element (tag, type ? "type" : nullptr, type);
+    out.text_element ("gdate", date_str);
+    out.end_element ();
+}
+
+void
+gnc_numeric_to_xml_stream (GncXmlStream& out, const char* tag,
+                           const gnc_numeric* num)
+{
+    gchar* numstr;
+
+    g_return_if_fail (num);
+
+    numstr = gnc_numeric_to_string (*num);
+    g_return_if_fail (numstr);
+    out.text_element (tag, numstr);
+    g_free (numstr);
+}
+
+static void stream_kvp_slot (const char* key, KvpValue* value, void* data);
+
+/* Writes what add_kvp_value_node builds. */
+static void
+stream_kvp_value (GncXmlStream& out, const gchar* tag, KvpValue* val)
+{
+    switch (val->get_type ())
+    {
+    case KvpValue::Type::INT64:
+    {
+        auto str = g_strdup_printf ("%" G_GINT64_FORMAT, val->get<int64_t> ());
+        out.text_element (tag, str, "type", "integer");
+        g_free (str);
+        break;
+    }
+    case KvpValue::Type::DOUBLE:
+    {
+        auto str = double_to_string (val->get<double> ());
+        out.text_element (tag, str, "type", "double");
+        g_free (str);
+        break;
+    }
+    case KvpValue::Type::NUMERIC:
+    {
+        auto str = gnc_numeric_to_string (val->get<gnc_numeric> ());
+        out.text_element (tag, str, "type", "numeric");
+        g_free (str);
+        break;
+    }
+    case KvpValue::Type::STRING:
+        out.text_element (tag, val->get<const char*> (), "type", "string");
+        break;
+    case KvpValue::Type::GUID:
+    {
+        gchar guidstr[GUID_ENCODING_LENGTH + 1];
+        guid_to_string_buff (val->get<GncGUID*> (), guidstr);
+        out.text_element (tag, guidstr, "type", "guid");
+        break;
+    }
+    case KvpValue::Type::TIMESPEC:
+    {
+        auto ts = val->get<Timespec> ();
+        timespec_to_xml_stream (out, tag, &ts, "timespec");
+        break;
+    }
+    case KvpValue::Type::GDATE:
+    {
+        auto d = val->get<GDate> ();
+        gdate_to_xml_stream (out, tag, &d, "gdate");
+        break;
+    }
+    case KvpValue::Type::GLIST:
+        out.start_element (tag, "type", "list");
+        for (auto cursor = val->get<GList*> (); cursor; cursor = cursor->next)
+            stream_kvp_value (out, "slot:value",
+                              static_cast<KvpValue*> (cursor->data));
+        out.end_element ();
+        break;
+    case KvpValue::Type::FRAME:
+    {
+        out.start_element (tag, "type", "frame");
+        auto frame = val->get<KvpFrame*> ();
+        if (frame)
+            frame->for_each_slot (stream_kvp_slot, static_cast<void*> (&out));
+        out.end_element ();
+        break;
+    }
+    default:
+        out.text_element (tag, nullptr);
+        break;
+    }
+}
+
+static void
+stream_kvp_slot (const char* key, KvpValue* value, void* data)
+{
+    auto out = static_cast<GncXmlStream*> (data);
+
+    out->start_element ("slot");
+    out->text_element ("slot:key", key);
+    stream_kvp_value (*out, "slot:value", value);
+    out->end_element ();
+}
+
+void
+qof_instance_slots_to_xml_stream (GncXmlStream& out, const char* tag,
+                                  const QofInstance* inst)
+{
+    KvpFrame* frame = qof_instance_get_slots (inst);
+    if (!frame)
+        return;
+
+    out.start_element (tag);
+    frame->for_each_slot (stream_kvp_slot, static_cast<void*> (&out));
+    out.end_element ();
+}
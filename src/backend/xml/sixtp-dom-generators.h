@@ -35,6 +35,11 @@ extern "C"
 
 #include "gnc-xml-helper.h"
 
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
 xmlNodePtr text_to_dom_tree (const char* tag, const char* str);
 xmlNodePtr int_to_dom_tree (const char* tag, gint64 val);
 xmlNodePtr boolean_to_dom_tree (const char* tag, gboolean val);
@@ -52,4 +57,51 @@ xmlNodePtr recurrence_to_dom_tree (const gchar* tag, const Recurrence* r);
 
 gchar* double_to_string (double value);
 
+/** Writes elements straight to a file, laid out byte for byte as
+ * xmlElemDump lays out the trees made by the functions above but without
+ * building them. Each element is either empty, holds text, or holds other
+ * elements. Tags must outlive the elements they start. */
+class GncXmlStream
+{
+public:
+    /** With no file, the output is kept for take (). */
+    GncXmlStream (FILE* out = nullptr);
+    ~GncXmlStream ();
+    /** Starts an element that holds other elements. */
+    void start_element (const char* tag, const char* attr = nullptr,
+                        const char* value = nullptr);
+    void end_element ();
+    /** Writes an element holding text, or an empty one if text is NULL. */
+    void text_element (const char* tag, const char* text,
+                       const char* attr = nullptr,
+                       const char* value = nullptr);
+    /** Ends the line after a top-level element. */
+    void newline ();
+    /** Writes out what has been buffered; returns FALSE on error. */
+    gboolean flush ();
+    /** Hands over what has been kept. */
+    std::string take ();
+private:
+    void open_child (const char* tag, const char* attr, const char* value);
+    void close_child ();
+    void escape (const char* text, gboolean attr);
+    FILE* m_out;
+    std::string m_buf;
+    /* The open elements, and whether each has any content yet. */
+    std::vector<std::pair<const char*, gboolean>> m_open;
+};
+
+void guid_to_xml_stream (GncXmlStream& out, const char* tag,
+                         const GncGUID* gid);
+void commodity_ref_to_xml_stream (GncXmlStream& out, const char* tag,
+                                  const gnc_commodity* c);
+void timespec_to_xml_stream (GncXmlStream& out, const char* tag,
+                             const Timespec* spec, const char* type = nullptr);
+void gdate_to_xml_stream (GncXmlStream& out, const char* tag,
+                          const GDate* date, const char* type = nullptr);
+void gnc_numeric_to_xml_stream (GncXmlStream& out, const char* tag,
+                                const gnc_numeric* num);
+void qof_instance_slots_to_xml_stream (GncXmlStream& out, const char* tag,
+                                       const QofInstance* inst);
+
 #endif /* _SIXTP_DOM_GENERATORS_H_ */
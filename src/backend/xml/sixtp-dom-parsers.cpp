@@ -62,11 +62,13 @@ dom_tree_to_guid (xmlNodePtr node)
         /* handle new and guid the same for the moment */
         if ((g_strcmp0 ("guid", type) == 0) || (g_strcmp0 ("new", type) == 0))
         {
-            auto gid = guid_new ();
+            auto gid = guid_malloc ();
             char* guid_str;
 
+            /* Don't pay for a random GUID that the string replaces. */
             guid_str = (char*)xmlNodeGetContent (node->xmlChildrenNode);
-            string_to_guid (guid_str, gid);
+            if (!string_to_guid (guid_str, gid))
+                guid_replace (gid);
             xmlFree (guid_str);
             xmlFree (type);
             return gid;
@@ -83,6 +85,27 @@ dom_tree_to_guid (xmlNodePtr node)
     }
 }
 
+gboolean
+dom_tree_find_guid (xmlNodePtr node, const char* tag, GncGUID* guid)
+{
+    xmlNodePtr child;
+
+    for (child = node->xmlChildrenNode; child; child = child->next)
+    {
+        if (child->type == XML_ELEMENT_NODE &&
+            g_strcmp0 (tag, (char*)child->name) == 0)
+        {
+            auto found = dom_tree_to_guid (child);
+            if (!found)
+                return FALSE;
+            *guid = *found;
+            guid_free (found);
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
 static KvpValue*
 dom_tree_to_integer_kvp_value (xmlNodePtr node)
 {
@@ -35,6 +35,9 @@ extern "C"
 #include "gnc-xml-helper.h"
 
 GncGUID* dom_tree_to_guid (xmlNodePtr node);
+/* The guid in the first child of node named tag, so that an object can be
+ * created with it before the other children are parsed. */
+gboolean dom_tree_find_guid (xmlNodePtr node, const char* tag, GncGUID* guid);
 
 gnc_commodity* dom_tree_to_commodity_ref (xmlNodePtr node, QofBook* book);
 gnc_commodity* dom_tree_to_commodity_ref_no_engine (xmlNodePtr node, QofBook*);
@@ -68,6 +68,10 @@ struct sixtp_gdv2
     countCallbackFn countCallback;
     QofBePercentageFunc gui_display_fn;
     gboolean exporting;
+    /* Set to write a book without its transactions, which go where
+     * transactions_at then says instead. See io-gncbin.h. */
+    gboolean omit_transactions;
+    long transactions_at;
 };
 typedef struct _sixtp_child_result sixtp_child_result;
 
@@ -42,7 +42,9 @@ extern "C"
 #include <cashobjects.h>
 #include <TransLog.h>
 #include <gnc-engine.h>
+#include <gnc-pricedb.h>
 #include <gnc-prefs.h>
+#include <gnc-uri-utils.h>
 
 #include <test-stuff.h>
 #include <unittest-support.h>
@@ -51,6 +53,7 @@ extern "C"
 
 #include "../gnc-backend-xml.h"
 #include "../io-gncxml-v2.h"
+#include "../io-gncbin.h"
 #include "test-file-stuff.h"
 
 #define GNC_LIB_NAME "gncmod-backend-xml"
@@ -78,6 +81,23 @@ remove_locks (const char* filename)
     remove_files_pattern (filename, ".LCK");
 }
 
+/* The load's statistics agree with each other and with the book. */
+static void
+test_load_stats (QofSession* session, QofBook* book)
+{
+    gint64 total = qof_session_get_stat (session, "session.load-usec");
+    QofCollection* trans = qof_book_get_collection (book, GNC_ID_TRANS);
+
+    do_test (total > 0, "load time recorded");
+    do_test (qof_session_get_stat (session, "xml.parse-usec") <= total,
+             "parse time within load time");
+    do_test (qof_session_get_stat (session, "xml.transactions") <=
+             (gint64) qof_collection_count (trans),
+             "transactions counted");
+    do_test (qof_session_get_stat (session, "xml.no-such-stat") == 0,
+             "unknown statistic");
+}
+
 static void
 test_load_file (const char* filename)
 {
@@ -111,11 +131,512 @@ test_load_file (const char* filename)
                   "session load xml2", __FILE__, __LINE__,
                   "qof error=%d for file [%s]",
                   qof_session_get_error (session), filename);
+    test_load_stats (session, book);
     /* Uncomment the line below to generate corrected files */
     /*    qof_session_save( session, NULL ); */
     qof_session_end (session);
 }
 
+struct compare_data
+{
+    QofBook* book;
+    int missing;
+    int different;
+};
+
+static void
+compare_transaction_cb (QofInstance* inst, gpointer user_data)
+{
+    compare_data* data = static_cast<decltype (data)> (user_data);
+    Transaction* trn = GNC_TRANSACTION (inst);
+    Transaction* other = xaccTransLookup (xaccTransGetGUID (trn), data->book);
+
+    if (!other)
+        data->missing++;
+    else if (!xaccTransEqual (trn, other, TRUE, TRUE, TRUE, FALSE))
+        data->different++;
+}
+
+/* Loads the file again with its transactions read in several threads
+ * and checks that the book has the same transactions as a serial load. */
+static void
+test_parallel_load_file (const char* filename)
+{
+    QofSession* serial, *parallel;
+    QofBook* serial_book, *parallel_book;
+    QofCollection* serial_col, *parallel_col;
+    compare_data data;
+
+    remove_locks (filename);
+    g_unsetenv ("GNC_XML_LOAD_THREADS");
+    serial = qof_session_new ();
+    qof_session_begin (serial, filename, TRUE, FALSE, TRUE);
+    qof_session_load (serial, NULL);
+
+    g_setenv ("GNC_XML_LOAD_THREADS", "4", TRUE);
+    parallel = qof_session_new ();
+    qof_session_begin (parallel, filename, TRUE, FALSE, TRUE);
+    qof_session_load (parallel, NULL);
+    g_unsetenv ("GNC_XML_LOAD_THREADS");
+
+    do_test_args (qof_session_get_error (parallel) == ERR_BACKEND_NO_ERR,
+                  "parallel session load xml2", __FILE__, __LINE__,
+                  "qof error=%d for file [%s]",
+                  qof_session_get_error (parallel), filename);
+
+    serial_book = qof_session_get_book (serial);
+    parallel_book = qof_session_get_book (parallel);
+    serial_col = qof_book_get_collection (serial_book, GNC_ID_TRANS);
+    parallel_col = qof_book_get_collection (parallel_book, GNC_ID_TRANS);
+    do_test_args (qof_collection_count (serial_col) ==
+                  qof_collection_count (parallel_col),
+                  "parallel load transaction count", __FILE__, __LINE__,
+                  "%u transactions, %u loaded in parallel from [%s]",
+                  qof_collection_count (serial_col),
+                  qof_collection_count (parallel_col), filename);
+
+    data.book = parallel_book;
+    data.missing = data.different = 0;
+    qof_collection_foreach (serial_col, compare_transaction_cb, &data);
+    do_test_args (data.missing == 0 && data.different == 0,
+                  "parallel load transactions", __FILE__, __LINE__,
+                  "%d missing and %d different transactions in [%s]",
+                  data.missing, data.different, filename);
+
+    qof_session_end (parallel);
+    qof_session_destroy (parallel);
+    qof_session_end (serial);
+    qof_session_destroy (serial);
+}
+
+/* Prices held back at load must all be there once they're looked at, and
+ * reading them mustn't leave the book needing a save. */
+static void
+test_lazy_prices_file (const char* filename)
+{
+    QofSession* eager, *lazy;
+    QofBook* eager_book, *lazy_book;
+    guint eager_count, lazy_count;
+
+    remove_locks (filename);
+    eager = qof_session_new ();
+    qof_session_begin (eager, filename, TRUE, FALSE, TRUE);
+    qof_session_load (eager, NULL);
+
+    g_setenv ("GNC_XML_LAZY_PRICES", "1", TRUE);
+    lazy = qof_session_new ();
+    qof_session_begin (lazy, filename, TRUE, FALSE, TRUE);
+    qof_session_load (lazy, NULL);
+    g_unsetenv ("GNC_XML_LAZY_PRICES");
+
+    do_test_args (qof_session_get_error (lazy) == ERR_BACKEND_NO_ERR,
+                  "lazy prices session load xml2", __FILE__, __LINE__,
+                  "qof error=%d for file [%s]",
+                  qof_session_get_error (lazy), filename);
+
+    eager_book = qof_session_get_book (eager);
+    lazy_book = qof_session_get_book (lazy);
+    eager_count = gnc_pricedb_get_num_prices (gnc_pricedb_get_db (eager_book));
+    lazy_count = gnc_pricedb_get_num_prices (gnc_pricedb_get_db (lazy_book));
+    do_test_args (eager_count == lazy_count,
+                  "lazy prices count", __FILE__, __LINE__,
+                  "%u prices, %u read on demand from [%s]",
+                  eager_count, lazy_count, filename);
+    do_test_args (!qof_book_session_not_saved (lazy_book),
+                  "lazy prices leave the book saved", __FILE__, __LINE__,
+                  "book from [%s] is dirty", filename);
+
+    qof_session_end (lazy);
+    qof_session_destroy (lazy);
+    qof_session_end (eager);
+    qof_session_destroy (eager);
+}
+
+/* Saving in several threads must write the same file as in one. */
+static void
+test_parallel_save_file (const char* filename)
+{
+    QofSession* session;
+    QofBook* book;
+    gchar* serial_name = g_strdup ("test_save_XXXXXX");
+    gchar* parallel_name = g_strdup ("test_save_XXXXXX");
+    gchar* serial_text = NULL, *parallel_text = NULL;
+    gsize serial_len = 0, parallel_len = 0;
+
+    close (g_mkstemp (serial_name));
+    close (g_mkstemp (parallel_name));
+    remove_locks (filename);
+    session = qof_session_new ();
+    qof_session_begin (session, filename, TRUE, FALSE, TRUE);
+    qof_session_load (session, NULL);
+    book = qof_session_get_book (session);
+
+    g_setenv ("GNC_XML_SAVE_THREADS", "1", TRUE);
+    do_test (gnc_book_write_to_xml_file_v2 (book, serial_name, FALSE),
+             "serial save xml2");
+    g_setenv ("GNC_XML_SAVE_THREADS", "4", TRUE);
+    do_test (gnc_book_write_to_xml_file_v2 (book, parallel_name, FALSE),
+             "parallel save xml2");
+    g_unsetenv ("GNC_XML_SAVE_THREADS");
+
+    g_file_get_contents (serial_name, &serial_text, &serial_len, NULL);
+    g_file_get_contents (parallel_name, &parallel_text, &parallel_len, NULL);
+    do_test_args (serial_text && parallel_text && serial_len == parallel_len &&
+                  memcmp (serial_text, parallel_text, serial_len) == 0,
+                  "parallel save output", __FILE__, __LINE__,
+                  "files saved from [%s] differ", filename);
+
+    g_free (serial_text);
+    g_free (parallel_text);
+    g_unlink (serial_name);
+    g_unlink (parallel_name);
+    g_free (serial_name);
+    g_free (parallel_name);
+    qof_session_end (session);
+    qof_session_destroy (session);
+}
+
+static void
+journal_candidate_cb (QofInstance* inst, gpointer user_data)
+{
+    GList** list = static_cast<decltype (list)> (user_data);
+    Transaction* trn = GNC_TRANSACTION (inst);
+
+    if (xaccTransGetReadOnly (trn))
+        return;
+    for (GList* node = xaccTransGetSplitList (trn); node; node = node->next)
+        if (xaccSplitGetLot (static_cast<Split*> (node->data)))
+            return;
+    *list = g_list_prepend (*list, trn);
+}
+
+/* Removes the file and the backups, logs and journal saving made of it. */
+static void
+remove_saved_files (const char* name)
+{
+    GDir* dir = g_dir_open (".", 0, NULL);
+    const gchar* entry;
+
+    if (!dir)
+        return;
+    while ((entry = g_dir_read_name (dir)) != NULL)
+        if (g_str_has_prefix (entry, name))
+            g_unlink (entry);
+    g_dir_close (dir);
+}
+
+/* With journaling, a save that changed only transactions goes to the
+ * journal, which the next load applies and a clean close folds into the
+ * file. */
+static void
+test_journal_file (const char* filename)
+{
+    QofSession* writer, *reader;
+    QofBook* book;
+    GList* candidates = NULL;
+    gchar* name = g_strdup ("test_journal_XXXXXX");
+    gchar* journal, *contents = NULL;
+    gsize len = 0;
+    GncGUID changed, gone;
+    Transaction* trn;
+
+    close (g_mkstemp (name));
+    journal = g_strconcat (name, ".journal", NULL);
+    if (!g_file_get_contents (filename, &contents, &len, NULL) ||
+        !g_file_set_contents (name, contents, len, NULL))
+    {
+        failure_args ("journal", __FILE__, __LINE__,
+                      "couldn't copy [%s]", filename);
+        goto cleanup;
+    }
+
+    g_setenv ("GNC_XML_JOURNAL", "1", TRUE);
+    writer = qof_session_new ();
+    qof_session_begin (writer, name, TRUE, FALSE, TRUE);
+    qof_session_load (writer, NULL);
+    book = qof_session_get_book (writer);
+    qof_collection_foreach (qof_book_get_collection (book, GNC_ID_TRANS),
+                            journal_candidate_cb, &candidates);
+    if (g_list_length (candidates) < 2)
+    {
+        qof_session_end (writer);
+        qof_session_destroy (writer);
+        goto cleanup;
+    }
+
+    trn = GNC_TRANSACTION (candidates->data);
+    changed = *xaccTransGetGUID (trn);
+    xaccTransBeginEdit (trn);
+    xaccTransSetDescription (trn, "journaled");
+    xaccTransCommitEdit (trn);
+    trn = GNC_TRANSACTION (candidates->next->data);
+    gone = *xaccTransGetGUID (trn);
+    xaccTransBeginEdit (trn);
+    xaccTransDestroy (trn);
+    xaccTransCommitEdit (trn);
+    qof_session_save (writer, NULL);
+    do_test_args (g_file_test (journal, G_FILE_TEST_EXISTS),
+                  "journaled save", __FILE__, __LINE__,
+                  "no journal saving [%s]", filename);
+
+    reader = qof_session_new ();
+    qof_session_begin (reader, name, TRUE, FALSE, TRUE);
+    qof_session_load (reader, NULL);
+    book = qof_session_get_book (reader);
+    trn = xaccTransLookup (&changed, book);
+    do_test_args (trn &&
+                  g_strcmp0 (xaccTransGetDescription (trn), "journaled") == 0 &&
+                  !xaccTransLookup (&gone, book),
+                  "journal replay", __FILE__, __LINE__,
+                  "journal of [%s] not applied", filename);
+    qof_session_end (reader);
+    qof_session_destroy (reader);
+    do_test_args (!g_file_test (journal, G_FILE_TEST_EXISTS),
+                  "journal compaction", __FILE__, __LINE__,
+                  "journal of [%s] left after closing", filename);
+
+    reader = qof_session_new ();
+    qof_session_begin (reader, name, TRUE, FALSE, TRUE);
+    qof_session_load (reader, NULL);
+    book = qof_session_get_book (reader);
+    trn = xaccTransLookup (&changed, book);
+    do_test_args (trn &&
+                  g_strcmp0 (xaccTransGetDescription (trn), "journaled") == 0 &&
+                  !xaccTransLookup (&gone, book),
+                  "journal compacted into file", __FILE__, __LINE__,
+                  "changes to [%s] lost compacting the journal", filename);
+    qof_session_end (reader);
+    qof_session_destroy (reader);
+
+    qof_session_end (writer);
+    qof_session_destroy (writer);
+
+cleanup:
+    g_unsetenv ("GNC_XML_JOURNAL");
+    g_list_free (candidates);
+    remove_saved_files (name);
+    g_free (contents);
+    g_free (journal);
+    g_free (name);
+}
+
+/* The number of dated backups of name in the current directory. */
+static int
+count_backups (const char* name)
+{
+    GDir* dir = g_dir_open (".", 0, NULL);
+    const gchar* entry;
+    int count = 0;
+
+    if (!dir)
+        return 0;
+    while ((entry = g_dir_read_name (dir)) != NULL)
+        if (g_str_has_prefix (entry, name) && strcmp (entry, name) != 0 &&
+            g_str_has_suffix (entry, GNC_DATAFILE_EXT))
+            count++;
+    g_dir_close (dir);
+    return count;
+}
+
+/* A save leaves the book in place and the old file as a dated backup,
+ * which the retention policy then removes. */
+static void
+test_backup_file (const char* filename)
+{
+    QofSession* session;
+    gchar* name = g_strdup ("test_backup_XXXXXX");
+    gchar* contents = NULL;
+    gsize len = 0;
+    gint policy = gnc_prefs_get_file_retention_policy ();
+
+    close (g_mkstemp (name));
+    if (!g_file_get_contents (filename, &contents, &len, NULL) ||
+        !g_file_set_contents (name, contents, len, NULL))
+    {
+        failure_args ("backup", __FILE__, __LINE__,
+                      "couldn't copy [%s]", filename);
+        goto cleanup;
+    }
+
+    gnc_prefs_set_file_retention_policy (XML_RETAIN_ALL);
+    session = qof_session_new ();
+    /* Old files are only cleaned up holding the lock. */
+    qof_session_begin (session, name, FALSE, FALSE, TRUE);
+    qof_session_load (session, NULL);
+    qof_book_mark_session_dirty (qof_session_get_book (session));
+    qof_session_save (session, NULL);
+    do_test_args (count_backups (name) == 1 &&
+                  gnc_is_xml_data_file_v2 (name, NULL) == GNC_BOOK_XML2_FILE,
+                  "save with backup", __FILE__, __LINE__,
+                  "%d backups saving [%s]", count_backups (name), filename);
+
+    /* Backups are named by the second. */
+    g_usleep (G_USEC_PER_SEC);
+    gnc_prefs_set_file_retention_policy (XML_RETAIN_NONE);
+    qof_book_mark_session_dirty (qof_session_get_book (session));
+    qof_session_save (session, NULL);
+    do_test_args (count_backups (name) == 0 &&
+                  gnc_is_xml_data_file_v2 (name, NULL) == GNC_BOOK_XML2_FILE,
+                  "backups removed", __FILE__, __LINE__,
+                  "%d backups kept saving [%s]", count_backups (name), filename);
+    qof_session_end (session);
+    qof_session_destroy (session);
+
+cleanup:
+    gnc_prefs_set_file_retention_policy (policy);
+    remove_saved_files (name);
+    g_free (contents);
+    g_free (name);
+}
+
+/* Whether the book read back has what the XML file had. */
+static void
+compare_books (QofBook* xml_book, QofBook* bin_book, const char* what,
+               const char* filename)
+{
+    QofCollection* xml_col = qof_book_get_collection (xml_book, GNC_ID_TRANS);
+    QofCollection* bin_col = qof_book_get_collection (bin_book, GNC_ID_TRANS);
+    compare_data data;
+
+    data.book = bin_book;
+    data.missing = data.different = 0;
+    qof_collection_foreach (xml_col, compare_transaction_cb, &data);
+    do_test_args (qof_collection_count (xml_col) ==
+                  qof_collection_count (bin_col) &&
+                  data.missing == 0 && data.different == 0,
+                  what, __FILE__, __LINE__,
+                  "%u transactions, %u read back with %d missing and %d "
+                  "different from [%s]",
+                  qof_collection_count (xml_col),
+                  qof_collection_count (bin_col),
+                  data.missing, data.different, filename);
+    do_test_args (gnc_pricedb_get_num_prices (gnc_pricedb_get_db (xml_book)) ==
+                  gnc_pricedb_get_num_prices (gnc_pricedb_get_db (bin_book)) &&
+                  qof_collection_count (
+                      qof_book_get_collection (xml_book, GNC_ID_ACCOUNT)) ==
+                  qof_collection_count (
+                      qof_book_get_collection (bin_book, GNC_ID_ACCOUNT)),
+                  what, __FILE__, __LINE__,
+                  "prices or accounts of [%s] not read back", filename);
+}
+
+/* A book written in the binary format reads back the same, by itself
+ * and after being saved again from a binary session. */
+static void
+test_binary_file (const char* filename)
+{
+    QofSession* xml, *bin;
+    QofBook* book;
+    gchar* name = g_strdup ("test_bin_XXXXXX");
+
+    close (g_mkstemp (name));
+    remove_locks (filename);
+    xml = qof_session_new ();
+    qof_session_begin (xml, filename, TRUE, FALSE, TRUE);
+    qof_session_load (xml, NULL);
+    book = qof_session_get_book (xml);
+    do_test_args (gnc_book_write_to_bin_file (book, name),
+                  "binary write", __FILE__, __LINE__,
+                  "couldn't write [%s] as binary", filename);
+    do_test (gnc_is_bin_data_file (name), "binary file type");
+
+    bin = qof_session_new ();
+    qof_session_begin (bin, name, TRUE, FALSE, TRUE);
+    qof_session_load (bin, NULL);
+    do_test_args (qof_session_get_error (bin) == ERR_BACKEND_NO_ERR,
+                  "binary session load", __FILE__, __LINE__,
+                  "qof error=%d for binary copy of [%s]",
+                  qof_session_get_error (bin), filename);
+    compare_books (book, qof_session_get_book (bin), "binary load",
+                   filename);
+    qof_book_mark_session_dirty (qof_session_get_book (bin));
+    qof_session_save (bin, NULL);
+    qof_session_end (bin);
+    qof_session_destroy (bin);
+    do_test (gnc_is_bin_data_file (name), "binary save keeps the format");
+
+    bin = qof_session_new ();
+    qof_session_begin (bin, name, TRUE, FALSE, TRUE);
+    qof_session_load (bin, NULL);
+    compare_books (book, qof_session_get_book (bin), "binary resave",
+                   filename);
+    qof_session_end (bin);
+    qof_session_destroy (bin);
+
+    qof_session_end (xml);
+    qof_session_destroy (xml);
+    remove_saved_files (name);
+    g_free (name);
+}
+
+/* Each codec's file reads back the same. With GNC_XML_BENCHMARK set,
+ * the time to save and load and the size are printed for each. */
+static void
+test_compressed_file (const char* filename)
+{
+    static const struct
+    {
+        const char* name;
+        GncXmlCodec codec;
+    } codecs[] =
+    {
+        { "none", GNC_XML_CODEC_NONE },
+        { "gzip", GNC_XML_CODEC_GZIP },
+#ifdef HAVE_ZSTD
+        { "zstd", GNC_XML_CODEC_ZSTD },
+#endif
+    };
+    gboolean benchmark = g_getenv ("GNC_XML_BENCHMARK") != NULL;
+    QofSession* xml, *copy;
+    QofBook* book;
+
+    remove_locks (filename);
+    xml = qof_session_new ();
+    qof_session_begin (xml, filename, TRUE, FALSE, TRUE);
+    qof_session_load (xml, NULL);
+    book = qof_session_get_book (xml);
+
+    for (auto& codec : codecs)
+    {
+        gchar* name = g_strdup ("test_codec_XXXXXX");
+        gint64 start, saved, loaded;
+        struct stat statbuf;
+
+        close (g_mkstemp (name));
+        start = g_get_monotonic_time ();
+        do_test_args (gnc_book_write_to_xml_file_v2_codec (book, name,
+                                                           codec.codec),
+                      "codec write", __FILE__, __LINE__,
+                      "couldn't write [%s] with %s", filename, codec.name);
+        saved = g_get_monotonic_time ();
+        do_test_args (gnc_is_xml_data_file_v2 (name, NULL) == GNC_BOOK_XML2_FILE,
+                      "codec file type", __FILE__, __LINE__,
+                      "[%s] with %s not recognized", filename, codec.name);
+
+        copy = qof_session_new ();
+        qof_session_begin (copy, name, TRUE, FALSE, TRUE);
+        qof_session_load (copy, NULL);
+        loaded = g_get_monotonic_time ();
+        do_test_args (qof_session_get_error (copy) == ERR_BACKEND_NO_ERR,
+                      "codec load", __FILE__, __LINE__,
+                      "qof error=%d for [%s] with %s",
+                      qof_session_get_error (copy), filename, codec.name);
+        compare_books (book, qof_session_get_book (copy), "codec round trip",
+                       filename);
+        if (benchmark && g_stat (name, &statbuf) == 0)
+            g_print ("%s %s: %ld bytes, saved in %.1f ms, loaded in %.1f ms\n",
+                     filename, codec.name, (long) statbuf.st_size,
+                     (saved - start) / 1000.0, (loaded - saved) / 1000.0);
+        qof_session_end (copy);
+        qof_session_destroy (copy);
+        remove_saved_files (name);
+        g_free (name);
+    }
+
+    qof_session_end (xml);
+    qof_session_destroy (xml);
+}
+
 int
 main (int argc, char** argv)
 {
@@ -151,6 +672,14 @@ main (int argc, char** argv)
                 if (!g_file_test (to_open, G_FILE_TEST_IS_DIR))
                 {
                     test_load_file (to_open);
+                    test_parallel_load_file (to_open);
+                    test_lazy_prices_file (to_open);
+                    test_parallel_save_file (to_open);
+                    test_journal_file (to_open);
+                    test_binary_file (to_open);
+                    test_compressed_file (to_open);
+                    if (files_tested == 0)
+                        test_backup_file (to_open);
                     files_tested++;
                 }
                 g_free (to_open);
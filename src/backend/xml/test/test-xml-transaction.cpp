@@ -53,10 +53,25 @@ extern "C"
 #include "../sixtp-parsers.h"
 #include "../sixtp-dom-parsers.h"
 #include "../io-gncxml-gen.h"
+#include "../sixtp-dom-generators.h"
 #include <test-file-stuff.h>
 
 static QofBook* book;
 
+static std::string
+file_contents (FILE* file)
+{
+    std::string contents;
+    char buf[4096];
+    size_t len;
+
+    fflush (file);
+    rewind (file);
+    while ((len = fread (buf, 1, sizeof (buf), file)) > 0)
+        contents.append (buf, len);
+    return contents;
+}
+
 extern gboolean gnc_transaction_xml_v2_testing;
 
 static xmlNodePtr
@@ -447,9 +462,24 @@ test_transaction (void)
 
         fd = g_mkstemp (filename1);
 
-        write_dom_node_to_file (test_node, fd);
-
-        close (fd);
+        {
+            /* Write the transaction with the streaming writer, which must
+             * write exactly what xmlElemDump does with the tree. */
+            FILE* out = fdopen (fd, "w+");
+            FILE* dom_out = tmpfile ();
+            {
+                GncXmlStream stream (out);
+                gnc_transaction_to_xml_stream (stream, ran_trn);
+            }
+            xmlElemDump (dom_out, NULL, test_node);
+            if (file_contents (out) != file_contents (dom_out))
+            {
+                failure_args ("transaction_xml", __FILE__, __LINE__,
+                              "streamed and DOM output differ: %d", i);
+            }
+            fclose (dom_out);
+            fclose (out);
+        }
 
         {
             GList* node = xaccTransGetSplitList (ran_trn);
@@ -483,16 +513,22 @@ test_transaction (void)
             data.trn = ran_trn;
             data.com = com;
             data.value = i;
-            parser = gnc_transaction_sixtp_parser_create ();
 
-            if (!gnc_xml_parse_file (parser, filename1, test_add_transaction,
-                                     (gpointer)&data, book))
+            /* Both parsers must read back the same transaction. */
+            for (auto create : {gnc_transaction_sixtp_parser_create,
+                                gnc_transaction_dom_sixtp_parser_create})
             {
-                failure_args ("gnc_xml_parse_file returned FALSE",
-                              __FILE__, __LINE__, "%d", i);
+                parser = create ();
+
+                if (!gnc_xml_parse_file (parser, filename1, test_add_transaction,
+                                         (gpointer)&data, book))
+                {
+                    failure_args ("gnc_xml_parse_file returned FALSE",
+                                  __FILE__, __LINE__, "%d", i);
+                }
+                else
+                    really_get_rid_of_transaction (data.new_trn);
             }
-            else
-                really_get_rid_of_transaction (data.new_trn);
         }
         /* no handling of circular data structures.  We'll do that later */
         /* sixtp_destroy(parser); */
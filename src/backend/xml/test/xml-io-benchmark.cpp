@@ -0,0 +1,325 @@
+/********************************************************************
+ * xml-io-benchmark.cpp: time opening and saving XML books          *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ ********************************************************************/
+
+/* Takes a book from --file, or makes one with get_realistic_book()'s
+ * generator, and times saving it as a new XML file, closing it, opening
+ * it again, saving it in full, committing single transactions and
+ * closing it.  Each phase is written out as JSON with its wall time,
+ * the peak resident size of the process so far and the size of the
+ * file.  Run it with "make xml-io-benchmark". */
+
+extern "C"
+{
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#ifndef G_OS_WIN32
+#include <sys/resource.h>
+#endif
+
+#include <qof.h>
+#include <cashobjects.h>
+#include <TransLog.h>
+#include "Transaction.h"
+#include "test-engine-stuff.h"
+}
+
+#define GNC_LIB_NAME "gncmod-backend-xml"
+
+static gchar* module_dir = NULL;
+static gchar* file = NULL;
+static gchar* out_dir = NULL;
+static gint seed = 42;
+static gint n_transactions = 50000;
+static gint n_accounts = 200;
+static gint n_years = 10;
+static gint n_commits = 20;
+static gchar* output = NULL;
+
+static GOptionEntry options[] =
+{
+    { "file", 'f', 0, G_OPTION_ARG_FILENAME, &file,
+      "Book to use instead of a generated one", "FILE" },
+    { "seed", 's', 0, G_OPTION_ARG_INT, &seed,
+      "Seed for the generated book", "N" },
+    { "transactions", 't', 0, G_OPTION_ARG_INT, &n_transactions,
+      "Transactions in the generated book", "N" },
+    { "accounts", 'a', 0, G_OPTION_ARG_INT, &n_accounts,
+      "Accounts in the generated book", "N" },
+    { "years", 'y', 0, G_OPTION_ARG_INT, &n_years,
+      "Years of transactions in the generated book", "N" },
+    { "commits", 'c', 0, G_OPTION_ARG_INT, &n_commits,
+      "Single transaction commits to time", "N" },
+    { "dir", 'd', 0, G_OPTION_ARG_FILENAME, &out_dir,
+      "Where to write the book, default the temporary directory", "DIR" },
+    { "module-dir", 'm', 0, G_OPTION_ARG_FILENAME, &module_dir,
+      "Where the XML backend module is, default ../.libs", "DIR" },
+    { "output", 'o', 0, G_OPTION_ARG_FILENAME, &output,
+      "JSON file to write, default stdout", "FILE" },
+    { NULL }
+};
+
+static FILE* out;
+static gint64 phase_start;
+
+static glong
+peak_rss_kb (void)
+{
+#ifndef G_OS_WIN32
+    struct rusage usage;
+
+    if (getrusage (RUSAGE_SELF, &usage) == 0)
+        return usage.ru_maxrss;
+#endif
+    return -1;
+}
+
+static gint64
+file_size (const char* path)
+{
+    GStatBuf st;
+
+    return g_stat (path, &st) == 0 ? st.st_size : -1;
+}
+
+static void
+phase_begin (void)
+{
+    phase_start = g_get_monotonic_time ();
+}
+
+static void
+phase_end (const char* name, const char* path)
+{
+    gint64 usec = g_get_monotonic_time () - phase_start;
+
+    fprintf (out, "    \"%s\": { \"seconds\": %.6f, \"peak_rss_kb\": %ld, "
+             "\"bytes\": %" G_GINT64_FORMAT " },\n", name, usec / 1e6,
+             peak_rss_kb (), path ? file_size (path) : (gint64)-1);
+    fflush (out);
+}
+
+static gboolean
+session_ok (QofSession* session, const char* what)
+{
+    QofBackendError err = qof_session_get_error (session);
+
+    if (err == ERR_BACKEND_NO_ERR)
+        return TRUE;
+    fprintf (stderr, "%s failed: %d %s\n", what, err,
+             qof_session_get_error_message (session));
+    return FALSE;
+}
+
+static void
+close_session (QofSession* session)
+{
+    qof_session_end (session);
+    qof_session_destroy (session);
+}
+
+static void
+collect (QofInstance* inst, gpointer data)
+{
+    GPtrArray* transactions = static_cast<GPtrArray*> (data);
+
+    if (transactions->len < static_cast<guint> (n_commits))
+        g_ptr_array_add (transactions, inst);
+}
+
+/* An edit to one transaction and the save that makes it stick, which
+ * is what the user waits for after each change in the register. */
+static void
+time_commits (QofSession* session)
+{
+    GPtrArray* transactions = g_ptr_array_new ();
+    gint64 total = 0, longest = 0;
+    guint i;
+
+    qof_collection_foreach (qof_book_get_collection (qof_session_get_book (session),
+                                                     GNC_ID_TRANS),
+                            collect, transactions);
+    for (i = 0; i < transactions->len; i++)
+    {
+        Transaction* trans = static_cast<Transaction*> (
+                                 g_ptr_array_index (transactions, i));
+        gint64 start = g_get_monotonic_time (), usec;
+
+        xaccTransBeginEdit (trans);
+        xaccTransSetDescription (trans, "io benchmark");
+        xaccTransCommitEdit (trans);
+        qof_session_save (session, NULL);
+        usec = g_get_monotonic_time () - start;
+        total += usec;
+        longest = MAX (longest, usec);
+    }
+    fprintf (out, "    \"commit\": { \"count\": %u, \"mean_seconds\": %.6f, "
+             "\"max_seconds\": %.6f, \"peak_rss_kb\": %ld },\n",
+             transactions->len,
+             transactions->len ? total / 1e6 / transactions->len : 0.0,
+             longest / 1e6, peak_rss_kb ());
+    g_ptr_array_free (transactions, TRUE);
+}
+
+static void
+remove_files (const char* dir, const char* prefix)
+{
+    GDir* d = g_dir_open (dir, 0, NULL);
+    const gchar* entry;
+
+    if (!d)
+        return;
+    while ((entry = g_dir_read_name (d)) != NULL)
+        if (g_str_has_prefix (entry, prefix))
+        {
+            gchar* path = g_build_filename (dir, entry, (gchar*)NULL);
+            g_unlink (path);
+            g_free (path);
+        }
+    g_dir_close (d);
+}
+
+static gboolean
+run (const char* path)
+{
+    QofSession* source = qof_session_new ();
+    QofSession* session;
+
+    fprintf (out, "{\n  \"version\": \"%s\",\n", PACKAGE_VERSION);
+    if (file)
+    {
+        fprintf (out, "  \"source\": \"%s\",\n  \"phases\": {\n", file);
+        phase_begin ();
+        qof_session_begin (source, file, TRUE, FALSE, TRUE);
+        qof_session_load (source, NULL);
+        if (!session_ok (source, "Opening the source book"))
+            return FALSE;
+        phase_end ("load_source", file);
+    }
+    else
+    {
+        RealisticBookParams params;
+
+        params.seed = seed;
+        params.n_accounts = n_accounts;
+        params.n_transactions = n_transactions;
+        params.n_years = n_years;
+        params.multi_split_percent = 20;
+        params.n_securities = 10;
+        fprintf (out, "  \"seed\": %d,\n  \"transactions\": %d,\n"
+                 "  \"phases\": {\n", seed, n_transactions);
+        phase_begin ();
+        add_realistic_data_to_book (qof_session_get_book (source), &params);
+        phase_end ("generate", NULL);
+    }
+
+    session = qof_session_new ();
+    phase_begin ();
+    qof_session_begin (session, path, FALSE, TRUE, TRUE);
+    qof_session_swap_data (source, session);
+    qof_session_save (session, NULL);
+    if (!session_ok (session, "Save as"))
+        return FALSE;
+    phase_end ("save_as", path);
+    close_session (source);
+
+    phase_begin ();
+    close_session (session);
+    phase_end ("close_new", NULL);
+
+    session = qof_session_new ();
+    phase_begin ();
+    qof_session_begin (session, path, FALSE, FALSE, TRUE);
+    qof_session_load (session, NULL);
+    if (!session_ok (session, "Opening"))
+        return FALSE;
+    phase_end ("open", path);
+
+    phase_begin ();
+    qof_book_mark_session_dirty (qof_session_get_book (session));
+    qof_session_save (session, NULL);
+    if (!session_ok (session, "Saving"))
+        return FALSE;
+    phase_end ("save", path);
+
+    time_commits (session);
+
+    phase_begin ();
+    close_session (session);
+    fprintf (out, "    \"close\": { \"seconds\": %.6f, \"peak_rss_kb\": %ld }\n",
+             (g_get_monotonic_time () - phase_start) / 1e6, peak_rss_kb ());
+    fprintf (out, "  }\n}\n");
+    return TRUE;
+}
+
+int
+main (int argc, char** argv)
+{
+    GOptionContext* context;
+    GError* error = NULL;
+    gchar *prefix, *path;
+    gboolean ok;
+
+    context = g_option_context_new ("- time XML book input and output");
+    g_option_context_add_main_entries (context, options, NULL);
+    if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+        fprintf (stderr, "%s\n", error->message);
+        g_error_free (error);
+        return 1;
+    }
+    g_option_context_free (context);
+
+    qof_init ();
+    cashobjects_register ();
+    if (!qof_load_backend_library (module_dir ? module_dir : "../.libs/",
+                                   GNC_LIB_NAME))
+    {
+        fprintf (stderr, "Could not load %s\n", GNC_LIB_NAME);
+        return 1;
+    }
+    xaccLogDisable ();
+
+    out = stdout;
+    if (output && !(out = fopen (output, "w")))
+    {
+        perror (output);
+        return 1;
+    }
+
+    prefix = g_strdup_printf ("gnc-io-benchmark-%d", getpid ());
+    path = g_strdup_printf ("%s/%s.gnucash",
+                            out_dir ? out_dir : g_get_tmp_dir (), prefix);
+    ok = run (path);
+    /* The book and its lock, backups and journal. */
+    remove_files (out_dir ? out_dir : g_get_tmp_dir (), prefix);
+    g_free (path);
+    g_free (prefix);
+
+    if (out != stdout)
+        fclose (out);
+    qof_close ();
+    return ok ? 0 : 1;
+}
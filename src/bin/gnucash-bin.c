@@ -82,6 +82,7 @@ static int          debugging        = 0;
 static int          extra            = 0;
 static gchar      **log_flags        = NULL;
 static gchar       *log_to_filename  = NULL;
+static const gchar *trace_filename   = NULL;
 static int          nofile           = 0;
 static const gchar *gsettings_prefix = NULL;
 static const char  *add_quotes_file  = NULL;
@@ -118,6 +119,14 @@ static GOptionEntry options[] =
         NULL
     },
 
+    {
+        "trace", '\0', 0, G_OPTION_ARG_STRING, &trace_filename,
+        N_("Write the time taken by file loads and saves, backend commits, queries, reports and refreshes to FILE, for viewing in chrome://tracing. The GNC_TRACE environment variable can name the file instead."),
+        /* Translators: Argument description for autohelp; see
+           http://developer.gnome.org/doc/API/2.0/glib/glib-Commandline-option-parser.html */
+        N_("FILE")
+    },
+
     {
         "nofile", '\0', 0, G_OPTION_ARG_NONE, &nofile,
         N_("Do not load the last file opened"), NULL
@@ -481,53 +490,83 @@ gnc_parse_command_line(int *argc, char ***argv)
         file_to_load = args_remaining[0];
 }
 
+/* Startup is timed in phases, logged at the info level of this file's
+ * log module, "gnc.gui", so that "--log gnc.gui=info" shows where the
+ * time before the main window goes. */
+static gint64 startup_begin = 0;
+static gint64 startup_mark = 0;
+
 static void
-load_gnucash_modules()
+startup_phase_done (const gchar *phase)
+{
+    gint64 now = g_get_monotonic_time ();
+
+    PINFO ("Startup: %s took %.3f s, %.3f s since start", phase,
+           (now - startup_mark) / 1e6, (now - startup_begin) / 1e6);
+    startup_mark = now;
+}
+
+/* The deferred modules only add menu items and assistants, which the
+ * main window picks up whenever their plugins are added, so they are
+ * loaded once it is showing instead of holding it up. */
+static struct
+{
+    gchar * name;
+    int version;
+    gboolean optional;
+    gboolean deferred;
+} modules[] =
+{
+    { "gnucash/app-utils", 0, FALSE, FALSE },
+    { "gnucash/engine", 0, FALSE, FALSE },
+    { "gnucash/register/ledger-core", 0, FALSE, FALSE },
+    { "gnucash/register/register-core", 0, FALSE, FALSE },
+    { "gnucash/register/register-gnome", 0, FALSE, FALSE },
+    { "gnucash/import-export/qif-import", 0, FALSE, TRUE },
+    { "gnucash/import-export/ofx", 0, TRUE, TRUE },
+    { "gnucash/import-export/csv-import", 0, TRUE, TRUE },
+    { "gnucash/import-export/csv-export", 0, TRUE, TRUE },
+    { "gnucash/import-export/log-replay", 0, TRUE, TRUE },
+    { "gnucash/import-export/aqbanking", 0, TRUE, FALSE },
+    { "gnucash/report/report-system", 0, FALSE, FALSE },
+    { "gnucash/report/stylesheets", 0, FALSE, FALSE },
+    { "gnucash/report/standard-reports", 0, FALSE, FALSE },
+    { "gnucash/report/utility-reports", 0, FALSE, FALSE },
+    { "gnucash/report/locale-specific/us", 0, FALSE, FALSE },
+    { "gnucash/report/report-gnome", 0, FALSE, FALSE },
+    { "gnucash/business-gnome", 0, TRUE, FALSE },
+    { "gnucash/gtkmm", 0, TRUE, FALSE },
+    { "gnucash/python", 0, TRUE, FALSE },
+    { "gnucash/plugins/bi_import", 0, TRUE, TRUE },
+    { "gnucash/plugins/customer_import", 0, TRUE, TRUE },
+};
+
+static void
+load_module_list (gboolean deferred)
 {
     int i, len;
-    struct
-    {
-        gchar * name;
-        int version;
-        gboolean optional;
-    } modules[] =
-    {
-        { "gnucash/app-utils", 0, FALSE },
-        { "gnucash/engine", 0, FALSE },
-        { "gnucash/register/ledger-core", 0, FALSE },
-        { "gnucash/register/register-core", 0, FALSE },
-        { "gnucash/register/register-gnome", 0, FALSE },
-        { "gnucash/import-export/qif-import", 0, FALSE },
-        { "gnucash/import-export/ofx", 0, TRUE },
-        { "gnucash/import-export/csv-import", 0, TRUE },
-        { "gnucash/import-export/csv-export", 0, TRUE },
-        { "gnucash/import-export/log-replay", 0, TRUE },
-        { "gnucash/import-export/aqbanking", 0, TRUE },
-        { "gnucash/report/report-system", 0, FALSE },
-        { "gnucash/report/stylesheets", 0, FALSE },
-        { "gnucash/report/standard-reports", 0, FALSE },
-        { "gnucash/report/utility-reports", 0, FALSE },
-        { "gnucash/report/locale-specific/us", 0, FALSE },
-        { "gnucash/report/report-gnome", 0, FALSE },
-        { "gnucash/business-gnome", 0, TRUE },
-        { "gnucash/gtkmm", 0, TRUE },
-        { "gnucash/python", 0, TRUE },
-        { "gnucash/plugins/bi_import", 0, TRUE},
-        { "gnucash/plugins/customer_import", 0, TRUE},
-    };
 
     /* module initializations go here */
     len = sizeof(modules) / sizeof(*modules);
     for (i = 0; i < len; i++)
     {
+        if (modules[i].deferred != deferred)
+            continue;
         DEBUG("Loading module %s started", modules[i].name);
-        gnc_update_splash_screen(modules[i].name, GNC_SPLASH_PERCENTAGE_UNKNOWN);
+        if (!deferred)
+            gnc_update_splash_screen(modules[i].name, GNC_SPLASH_PERCENTAGE_UNKNOWN);
         if (modules[i].optional)
             gnc_module_load_optional(modules[i].name, modules[i].version);
         else
             gnc_module_load(modules[i].name, modules[i].version);
-        DEBUG("Loading module %s finished", modules[i].name);
+        startup_phase_done (modules[i].name);
     }
+}
+
+static void
+load_gnucash_modules()
+{
+    load_module_list (FALSE);
     if (!gnc_engine_is_initialized())
     {
         /* On Windows this check used to fail anyway, see
@@ -539,6 +578,13 @@ load_gnucash_modules()
     }
 }
 
+static gboolean
+load_deferred_modules (gpointer user_data)
+{
+    load_module_list (TRUE);
+    return FALSE;
+}
+
 static void
 inner_main_add_price_quotes(void *closure, int argc, char **argv)
 {
@@ -554,6 +600,7 @@ inner_main_add_price_quotes(void *closure, int argc, char **argv)
        GUI is not initialized */
 #ifdef PRICE_QUOTES_NEED_MODULES
     load_gnucash_modules();
+    load_deferred_modules(NULL);
 #endif
     gnc_prefs_init ();
     qof_event_suspend();
@@ -623,6 +670,7 @@ inner_main (void *closure, int argc, char **argv)
     /* GnuCash switched to gsettings to store its preferences in version 2.5.6
      * Migrate the user's preferences from gconf if needed */
     gnc_gsettings_migrate_from_gconf();
+    startup_phase_done ("Guile and preferences");
 
     load_gnucash_modules();
 
@@ -631,15 +679,18 @@ inner_main (void *closure, int argc, char **argv)
      * menu is created. */
     load_system_config();
     load_user_config();
+    startup_phase_done ("config files");
 
     /* Setting-up the report menu must come after the module
        loading but before the gui initialization. */
     scm_c_use_module("gnucash report report-gnome");
     scm_c_eval_string("(gnc:report-menu-setup)");
+    startup_phase_done ("report menu");
 
     /* TODO: After some more guile-extraction, this should happen even
        before booting guile.  */
     gnc_main_gui_init();
+    startup_phase_done ("main window");
 
     gnc_hook_add_dangler(HOOK_UI_SHUTDOWN, (GFunc)gnc_file_quit, NULL);
 
@@ -649,12 +700,14 @@ inner_main (void *closure, int argc, char **argv)
     scm_c_eval_string("(gnc:price-quotes-install-sources)");
 
     gnc_hook_run(HOOK_STARTUP, NULL);
+    startup_phase_done ("price quote sources");
 
     if (!nofile && (fn = get_file_to_load()))
     {
         gnc_update_splash_screen(_("Loading data..."), GNC_SPLASH_PERCENTAGE_UNKNOWN);
         gnc_file_open_file(fn, /*open_readonly*/ FALSE);
         g_free(fn);
+        startup_phase_done ("opening the book");
     }
     else if (gnc_prefs_get_bool(GNC_PREFS_GROUP_NEW_USER, GNC_PREF_FIRST_STARTUP))
     {
@@ -668,6 +721,8 @@ inner_main (void *closure, int argc, char **argv)
     gnc_main_window_show_all_windows();
 
     gnc_hook_run(HOOK_UI_POST_STARTUP, NULL);
+    startup_phase_done ("showing the windows");
+    g_idle_add (load_deferred_modules, NULL);
     gnc_ui_start_event_loop();
     gnc_hook_remove_dangler(HOOK_UI_SHUTDOWN, (GFunc)gnc_file_quit);
 
@@ -733,6 +788,11 @@ gnc_log_init()
             g_strfreev(parts);
         }
     }
+
+    if (trace_filename == NULL)
+        trace_filename = g_getenv("GNC_TRACE");
+    if (trace_filename != NULL && *trace_filename != '\0')
+        qof_log_trace_init(trace_filename);
 }
 
 int
@@ -745,6 +805,7 @@ main(int argc, char ** argv)
 #ifndef HAVE_GLIB_2_32 /* Automatic after GLib 2-32 */
     g_thread_init(NULL);
 #endif
+    startup_begin = startup_mark = g_get_monotonic_time ();
 #ifdef ENABLE_BINRELOC
     {
         GError *binreloc_error = NULL;
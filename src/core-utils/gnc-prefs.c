@@ -32,6 +32,7 @@ static gchar *namespace_regexp    = NULL;
 static gboolean is_debugging      = FALSE;
 static gboolean extras_enabled    = FALSE;
 static gboolean use_compression   = TRUE; // This is also the default in the prefs backend
+static gchar *compression_codec   = NULL; // NULL is "gzip", the default in the prefs backend
 static gint file_retention_policy = 1;    // 1 = "days", the default in the prefs backend
 static gint file_retention_days   = 30;   // This is also the default in the prefs backend
 
@@ -92,6 +93,19 @@ gnc_prefs_set_file_save_compressed(gboolean compressed)
     use_compression = compressed;
 }
 
+const gchar *
+gnc_prefs_get_file_compression_codec(void)
+{
+    return compression_codec ? compression_codec : "gzip";
+}
+
+void
+gnc_prefs_set_file_compression_codec(const gchar *codec)
+{
+    g_free(compression_codec);
+    compression_codec = g_strdup(codec);
+}
+
 gint
 gnc_prefs_get_file_retention_policy(void)
 {
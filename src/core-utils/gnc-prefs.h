@@ -107,6 +107,9 @@ void gnc_prefs_set_extra(gboolean enabled);
 gboolean gnc_prefs_get_file_save_compressed(void);
 void gnc_prefs_set_file_save_compressed(gboolean compressed);
 
+const gchar *gnc_prefs_get_file_compression_codec(void);
+void gnc_prefs_set_file_compression_codec(const gchar *codec);
+
 gint gnc_prefs_get_file_retention_policy(void);
 void gnc_prefs_set_file_retention_policy(gint policy);
 
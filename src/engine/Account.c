@@ -47,6 +47,15 @@ static QofLogModule log_module = GNC_MOD_ACCOUNT;
 /* The Canonical Account Separator.  Pre-Initialized. */
 static gchar account_separator[8] = ".";
 static gunichar account_uc_separator = ':';
+/* Bumped whenever an account name, code or parent changes, an account is
+ * destroyed or the separator changes, which makes anything derived from
+ * the shape of the account tree stale. */
+static guint account_tree_generation = 1;
+/* Reading an account can fill in what is kept of it lazily: the sorted
+ * split list, running balances and date index, the full name, balance
+ * roll-ups and the unreconciled splits.  Threads holding the book's read
+ * lock may read at the same time, so that is done under this lock. */
+static GRecMutex account_cache_lock;
 /* Predefined KVP paths */
 static const char *KEY_ASSOC_INCOME_ACCOUNT = "ofx/associated-income-account";
 #define AB_KEY "hbci"
@@ -119,6 +128,14 @@ enum
 \********************************************************************/
 
 static void xaccAccountBringUpToDate (Account *acc);
+static void gnc_account_clear_date_index (AccountPrivate *priv);
+static void rollup_cache_invalidate (AccountPrivate *priv);
+static void open_lots_clear (AccountPrivate *priv);
+static void gnc_account_imap_clear_bayes_index (AccountPrivate *priv);
+static void open_lots_forget (AccountPrivate *priv, GNCLot *lot);
+static void unreconciled_clear (AccountPrivate *priv);
+static void text_index_clear (AccountPrivate *priv);
+static AccountLotChangedHook lot_changed_hook = NULL;
 
 
 /********************************************************************\
@@ -151,12 +168,20 @@ gnc_set_account_separator (const gchar *separator)
     {
         account_uc_separator = ':';
         strcpy(account_separator, ":");
+        ++account_tree_generation;
         return;
     }
 
     account_uc_separator = uc;
     count = g_unichar_to_utf8(uc, account_separator);
     account_separator[count] = '\0';
+    ++account_tree_generation;
+}
+
+guint
+gnc_account_tree_generation (void)
+{
+    return account_tree_generation;
 }
 
 gchar *gnc_account_name_violations_errmsg (const gchar *separator, GList* invalid_account_names)
@@ -261,6 +286,18 @@ gnc_account_init(Account* acc)
 
     priv->policy = xaccGetFIFOPolicy();
     priv->lots = NULL;
+    priv->open_lots[0] = NULL;
+    priv->open_lots[1] = NULL;
+    priv->open_lots_pending = NULL;
+    priv->unreconciled_splits = NULL;
+    priv->desc_index = NULL;
+    priv->memo_index = NULL;
+    priv->rollup_cache = NULL;
+    priv->full_name = NULL;
+    priv->full_name_generation = 0;
+    priv->full_name_index = NULL;
+    priv->code_index = NULL;
+    priv->lookup_index_generation = 0;
 
     priv->commodity = NULL;
     priv->commodity_scu = 0;
@@ -273,9 +310,16 @@ gnc_account_init(Account* acc)
     priv->starting_cleared_balance = gnc_numeric_zero();
     priv->starting_reconciled_balance = gnc_numeric_zero();
     priv->balance_dirty = FALSE;
+    priv->balance_dirty_from = G_MAXUINT;
 
     priv->splits = NULL;
     priv->sort_dirty = FALSE;
+    priv->sort_dirty_from = G_MAXUINT;
+    priv->split_array = g_ptr_array_new ();
+
+    priv->date_index_dates = NULL;
+    priv->date_index_len = 0;
+    priv->date_index_dirty = TRUE;
 }
 
 static void
@@ -1092,6 +1136,227 @@ gnc_book_set_root_account (QofBook *book, Account *root)
     gnc_coll_set_root_account (col, root);
 }
 
+/********************************************************************\
+ * Bulk ingestion.  Every transaction committed into an account that
+ * isn't being edited re-sorts the account's splits and recomputes its
+ * running balances.  During a bulk ingestion session every account in
+ * the book is held open for editing instead, so that work is done
+ * once per account when the session ends.
+\********************************************************************/
+
+#define BULK_INGEST_KEY "gnc-account-bulk-ingest"
+
+typedef struct
+{
+    guint depth;
+    GList *accounts;    /* accounts held open by the session */
+} BulkIngest;
+
+/* Destroying an account that the session holds open would otherwise
+ * leave it in the tree until the session ends, so the session lets go
+ * of it first; and a held account freed along with its parent must be
+ * forgotten. */
+static void
+bulk_ingest_release_account (Account *acc, gboolean commit)
+{
+    BulkIngest *bulk;
+    GList *node;
+
+    bulk = qof_book_get_data (qof_instance_get_book (acc), BULK_INGEST_KEY);
+    if (!bulk) return;
+
+    node = g_list_find (bulk->accounts, acc);
+    if (!node) return;
+
+    bulk->accounts = g_list_delete_link (bulk->accounts, node);
+    if (commit)
+        xaccAccountCommitEdit (acc);
+}
+
+static void
+bulk_ingest_begin_account (Account *acc, gpointer data)
+{
+    BulkIngest *bulk = data;
+
+    xaccAccountBeginEdit (acc);
+    bulk->accounts = g_list_prepend (bulk->accounts, acc);
+}
+
+void
+gnc_book_begin_bulk_ingest (QofBook *book)
+{
+    BulkIngest *bulk;
+    Account *root;
+
+    g_return_if_fail (QOF_IS_BOOK (book));
+
+    bulk = qof_book_get_data (book, BULK_INGEST_KEY);
+    if (bulk)
+    {
+        bulk->depth++;
+        return;
+    }
+
+    ENTER ("(book=%p)", book);
+    bulk = g_new0 (BulkIngest, 1);
+    bulk->depth = 1;
+    qof_book_set_data (book, BULK_INGEST_KEY, bulk);
+
+    root = gnc_book_get_root_account (book);
+    bulk_ingest_begin_account (root, bulk);
+    gnc_account_foreach_descendant (root, bulk_ingest_begin_account, bulk);
+    LEAVE ("%u accounts", g_list_length (bulk->accounts));
+}
+
+void
+gnc_book_end_bulk_ingest (QofBook *book)
+{
+    BulkIngest *bulk;
+    GList *node;
+
+    g_return_if_fail (QOF_IS_BOOK (book));
+
+    bulk = qof_book_get_data (book, BULK_INGEST_KEY);
+    if (!bulk)
+    {
+        PERR ("no bulk ingestion in progress");
+        return;
+    }
+    if (--bulk->depth > 0)
+        return;
+
+    ENTER ("(book=%p)", book);
+    qof_book_set_data (book, BULK_INGEST_KEY, NULL);
+
+    for (node = bulk->accounts; node; node = node->next)
+        xaccAccountCommitEdit (node->data);
+    g_list_free (bulk->accounts);
+    g_free (bulk);
+    LEAVE (" ");
+}
+
+gboolean
+gnc_book_in_bulk_ingest (QofBook *book)
+{
+    return book && qof_book_get_data (book, BULK_INGEST_KEY) != NULL;
+}
+
+#define BALANCE_SOURCE_KEY "gnc-account-balance-source"
+
+typedef struct
+{
+    const GncBalanceSource *source;
+    gpointer user_data;
+} BalanceSource;
+
+void
+gnc_book_set_balance_source (QofBook *book, const GncBalanceSource *source,
+                             gpointer user_data)
+{
+    BalanceSource *bs;
+
+    g_return_if_fail (QOF_IS_BOOK (book));
+
+    g_free (qof_book_get_data (book, BALANCE_SOURCE_KEY));
+    bs = NULL;
+    if (source)
+    {
+        bs = g_new (BalanceSource, 1);
+        bs->source = source;
+        bs->user_data = user_data;
+    }
+    qof_book_set_data (book, BALANCE_SOURCE_KEY, bs);
+}
+
+gboolean
+gnc_book_rebuild_balance_source (QofBook *book)
+{
+    BalanceSource *bs;
+
+    g_return_val_if_fail (QOF_IS_BOOK (book), FALSE);
+
+    bs = qof_book_get_data (book, BALANCE_SOURCE_KEY);
+    if (!bs || !bs->source->rebuild)
+        return FALSE;
+    bs->source->rebuild (book, bs->user_data);
+    return TRUE;
+}
+
+static gboolean
+balance_source_as_of (const Account *acc, time64 date, gnc_numeric *balance)
+{
+    BalanceSource *bs;
+
+    bs = qof_book_get_data (qof_instance_get_book (acc), BALANCE_SOURCE_KEY);
+    if (!bs || !bs->source->balance_as_of)
+        return FALSE;
+    return bs->source->balance_as_of (acc, date, balance, bs->user_data);
+}
+
+static gboolean
+balance_source_p (const Account *acc)
+{
+    BalanceSource *bs;
+
+    bs = qof_book_get_data (qof_instance_get_book (acc), BALANCE_SOURCE_KEY);
+    return bs && bs->source->balance_as_of;
+}
+
+#define SPLIT_PAGE_SOURCE_KEY "gnc-account-split-page-source"
+
+typedef struct
+{
+    const GncSplitPageSource *source;
+    gpointer user_data;
+} SplitPageSource;
+
+void
+gnc_book_set_split_page_source (QofBook *book,
+                                const GncSplitPageSource *source,
+                                gpointer user_data)
+{
+    SplitPageSource *ps;
+
+    g_return_if_fail (QOF_IS_BOOK (book));
+
+    g_free (qof_book_get_data (book, SPLIT_PAGE_SOURCE_KEY));
+    ps = NULL;
+    if (source)
+    {
+        ps = g_new (SplitPageSource, 1);
+        ps->source = source;
+        ps->user_data = user_data;
+    }
+    qof_book_set_data (book, SPLIT_PAGE_SOURCE_KEY, ps);
+}
+
+gboolean
+gnc_book_has_split_pages (const QofBook *book)
+{
+    g_return_val_if_fail (QOF_IS_BOOK (book), FALSE);
+
+    return qof_book_get_data (book, SPLIT_PAGE_SOURCE_KEY) != NULL;
+}
+
+gint
+gnc_book_load_split_page (QofBook *book, GList *accounts,
+                          const GncSplitPageKey *before, gint n,
+                          GncSplitPageKey *first)
+{
+    SplitPageSource *ps;
+
+    g_return_val_if_fail (QOF_IS_BOOK (book), -1);
+    g_return_val_if_fail (first != NULL, -1);
+
+    ps = qof_book_get_data (book, SPLIT_PAGE_SOURCE_KEY);
+    if (!ps || !ps->source->load_page)
+        return -1;
+    if (accounts == NULL || n <= 0)
+        return 0;
+    return ps->source->load_page (book, accounts, before, n, first,
+                                  ps->user_data);
+}
+
 /********************************************************************\
 \********************************************************************/
 
@@ -1212,6 +1477,7 @@ xaccFreeAccount (Account *acc)
 
     priv = GET_PRIVATE(acc);
     qof_event_gen (&acc->inst, QOF_EVENT_DESTROY, NULL);
+    bulk_ingest_release_account (acc, FALSE);
 
     if (priv->children)
     {
@@ -1282,6 +1548,22 @@ xaccFreeAccount (Account *acc)
 
     priv->balance_dirty = FALSE;
     priv->sort_dirty = FALSE;
+    gnc_account_clear_date_index (priv);
+    rollup_cache_invalidate (priv);
+    if (priv->full_name_index)
+        g_hash_table_destroy (priv->full_name_index);
+    if (priv->code_index)
+        g_hash_table_destroy (priv->code_index);
+    priv->full_name_index = priv->code_index = NULL;
+    g_free (priv->full_name);
+    priv->full_name = NULL;
+    ++account_tree_generation;
+    open_lots_clear (priv);
+    unreconciled_clear (priv);
+    text_index_clear (priv);
+    g_ptr_array_free (priv->split_array, TRUE);
+    priv->split_array = NULL;
+    gnc_account_imap_clear_bayes_index (priv);
 
     /* qof_instance_release (&acc->inst); */
     g_object_unref(acc);
@@ -1375,6 +1657,7 @@ xaccAccountCommitEdit (Account *acc)
         {
             g_list_free(priv->splits);
             priv->splits = NULL;
+            g_ptr_array_set_size (priv->split_array, 0);
         }
 
         /* It turns out there's a case where this assertion does not hold:
@@ -1399,6 +1682,9 @@ xaccAccountCommitEdit (Account *acc)
         }
         g_list_free(priv->lots);
         priv->lots = NULL;
+        open_lots_clear (priv);
+        unreconciled_clear (priv);
+        text_index_clear (priv);
 
         qof_instance_set_dirty(&acc->inst);
         qof_instance_decrease_editlevel(acc);
@@ -1416,6 +1702,7 @@ xaccAccountDestroy (Account *acc)
 {
     g_return_if_fail(GNC_IS_ACCOUNT(acc));
 
+    bulk_ingest_release_account (acc, TRUE);
     qof_instance_set_destroying(acc, TRUE);
 
     xaccAccountCommitEdit (acc);
@@ -1700,6 +1987,87 @@ xaccAccountEqual(const Account *aa, const Account *ab, gboolean check_guids)
 
 /********************************************************************\
 \********************************************************************/
+/* Array helpers keeping split_array in step with the split list. */
+
+/* Find the position of s in the array.  The search runs from the end
+ * since that is where most edits happen. */
+static gint
+split_array_find (GPtrArray *array, const Split *s)
+{
+    guint i;
+    for (i = array->len; i > 0; --i)
+        if (g_ptr_array_index (array, i - 1) == s)
+            return (gint) (i - 1);
+    return -1;
+}
+
+/* Flag the running balances as incorrect from split_array position pos
+ * onward; a pos of 0 invalidates all of them. */
+static void
+set_balance_dirty_from (AccountPrivate *priv, guint pos)
+{
+    priv->balance_dirty = TRUE;
+    if (pos < priv->balance_dirty_from)
+        priv->balance_dirty_from = pos;
+    rollup_cache_invalidate (priv);
+}
+
+static void
+gnc_account_clear_date_index (AccountPrivate *priv)
+{
+    g_free (priv->date_index_dates);
+    priv->date_index_dates = NULL;
+    priv->date_index_len = 0;
+    priv->date_index_dirty = TRUE;
+}
+
+/* Rebuild the date index from the split list.  The caller must make
+ * sure that the splits are sorted first. */
+static void
+gnc_account_build_date_index (AccountPrivate *priv)
+{
+    guint i, len;
+
+    g_rec_mutex_lock (&account_cache_lock);
+    if (!priv->date_index_dirty)
+    {
+        g_rec_mutex_unlock (&account_cache_lock);
+        return;
+    }
+
+    g_free (priv->date_index_dates);
+
+    len = priv->split_array->len;
+    priv->date_index_dates = g_new (time64, len);
+    for (i = 0; i < len; ++i)
+    {
+        Split *split = g_ptr_array_index (priv->split_array, i);
+        priv->date_index_dates[i] =
+            xaccTransGetDate (xaccSplitGetParent (split));
+    }
+    priv->date_index_len = len;
+    priv->date_index_dirty = FALSE;
+    g_rec_mutex_unlock (&account_cache_lock);
+}
+
+/* The position in the date index of the first split posted on or after
+ * the given date. */
+static guint
+gnc_account_date_index_search (const AccountPrivate *priv, time64 date)
+{
+    guint lo = 0, hi = priv->date_index_len;
+
+    while (lo < hi)
+    {
+        guint mid = lo + (hi - lo) / 2;
+        if (priv->date_index_dates[mid] < date)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
 void
 gnc_account_set_sort_dirty (Account *acc)
 {
@@ -1712,6 +2080,9 @@ gnc_account_set_sort_dirty (Account *acc)
 
     priv = GET_PRIVATE(acc);
     priv->sort_dirty = TRUE;
+    priv->sort_dirty_from = 0;
+    priv->date_index_dirty = TRUE;
+    text_index_clear (priv);
 }
 
 void
@@ -1725,35 +2096,146 @@ gnc_account_set_balance_dirty (Account *acc)
         return;
 
     priv = GET_PRIVATE(acc);
+    set_balance_dirty_from (priv, 0);
+    priv->date_index_dirty = TRUE;
+}
+
+void
+gnc_account_set_split_dirty (Account *acc, Split *split)
+{
+    AccountPrivate *priv;
+    gint pos;
+
+    g_return_if_fail(GNC_IS_ACCOUNT(acc));
+
+    if (qof_instance_get_destroying(acc))
+        return;
+
+    priv = GET_PRIVATE(acc);
+    priv->sort_dirty = TRUE;
+    priv->date_index_dirty = TRUE;
     priv->balance_dirty = TRUE;
+    rollup_cache_invalidate (priv);
+
+    /* A split that isn't in the account yet gets its position when it
+     * is inserted. */
+    pos = split_array_find (priv->split_array, split);
+    if (pos >= 0)
+    {
+        set_balance_dirty_from (priv, pos);
+        if ((guint) pos < priv->sort_dirty_from)
+            priv->sort_dirty_from = pos;
+    }
 }
 
 /********************************************************************\
 \********************************************************************/
 
+/* Insert s into the sorted split_array after all splits which don't
+ * sort after it, returning its position.  action_for_num is the book's
+ * use-split-action-for-num option, looked up once by the caller rather
+ * than at every comparison. */
+static guint
+split_array_insert_sorted (GPtrArray *array, Split *s,
+                           gboolean action_for_num)
+{
+    guint lo = 0, hi = array->len;
+
+    while (lo < hi)
+    {
+        guint mid = lo + (hi - lo) / 2;
+        if (xaccSplitOrderNumSource (g_ptr_array_index (array, mid), s,
+                                     action_for_num) <= 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    g_ptr_array_add (array, NULL);
+    memmove (array->pdata + lo + 1, array->pdata + lo,
+             (array->len - lo - 1) * sizeof (gpointer));
+    array->pdata[lo] = s;
+    return lo;
+}
+
+static gint
+split_array_order (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+    return xaccSplitOrderNumSource (*(Split* const*) a, *(Split* const*) b,
+                                    *(gboolean*) user_data);
+}
+
+/* Sort split_array given that its first n_sorted entries are already in
+ * order: sort the rest on its own and merge it in from the back, so new
+ * splits which belong at the end cost next to nothing.  Returns the
+ * position of the first entry which changed. */
+static guint
+split_array_sort_tail (GPtrArray *array, guint n_sorted,
+                       gboolean action_for_num)
+{
+    gpointer *pdata = array->pdata;
+    gpointer *tail;
+    guint n_tail;
+    gint i, j, w;
+
+    if (n_sorted >= array->len)
+        return array->len;
+
+    n_tail = array->len - n_sorted;
+    g_qsort_with_data (pdata + n_sorted, n_tail, sizeof (gpointer),
+                       split_array_order, &action_for_num);
+    if (n_sorted == 0)
+        return 0;
+
+    tail = g_memdup (pdata + n_sorted, n_tail * sizeof (gpointer));
+    i = (gint) n_sorted - 1;
+    j = (gint) n_tail - 1;
+    w = (gint) array->len - 1;
+    while (j >= 0)
+    {
+        if (i >= 0 &&
+                xaccSplitOrderNumSource (pdata[i], tail[j], action_for_num) > 0)
+            pdata[w--] = pdata[i--];
+        else
+            pdata[w--] = tail[j--];
+    }
+    g_free (tail);
+    /* Everything up to and including pdata[i] stayed where it was. */
+    return (guint) (i + 1);
+}
+
 gboolean
 gnc_account_insert_split (Account *acc, Split *s)
 {
     AccountPrivate *priv;
-    GList *node;
+    guint pos;
 
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), FALSE);
     g_return_val_if_fail(GNC_IS_SPLIT(s), FALSE);
 
     priv = GET_PRIVATE(acc);
-    node = g_list_find(priv->splits, s);
-    if (node)
+    if (split_array_find (priv->split_array, s) >= 0)
         return FALSE;
 
+    /* Outside of an edit the list and the array are always in the same
+     * order, so the split goes in at the same position in both. Inside
+     * one they only need to hold the same splits; the sort at commit
+     * time puts them back in step. */
     if (qof_instance_get_editlevel(acc) == 0)
     {
-        priv->splits = g_list_insert_sorted(priv->splits, s,
-                                            (GCompareFunc)xaccSplitOrder);
+        xaccAccountSortSplits (acc, FALSE);
+        pos = split_array_insert_sorted (priv->split_array, s,
+                                         qof_book_use_split_action_for_num_field
+                                         (gnc_account_get_book (acc)));
+        priv->splits = g_list_insert(priv->splits, s, pos);
     }
     else
     {
+        pos = priv->split_array->len;
+        g_ptr_array_add (priv->split_array, s);
         priv->splits = g_list_prepend(priv->splits, s);
         priv->sort_dirty = TRUE;
+        if (pos < priv->sort_dirty_from)
+            priv->sort_dirty_from = pos;
     }
 
     //FIXME: find better event
@@ -1761,7 +2243,9 @@ gnc_account_insert_split (Account *acc, Split *s)
     /* Also send an event based on the account */
     qof_event_gen(&acc->inst, GNC_EVENT_ITEM_ADDED, s);
 
-    priv->balance_dirty = TRUE;
+    set_balance_dirty_from (priv, pos);
+    priv->date_index_dirty = TRUE;
+    gnc_account_split_reconcile_changed (acc, s);
 //  DRH: Should the below be added? It is present in the delete path.
 //  xaccAccountRecomputeBalance(acc);
     return TRUE;
@@ -1771,40 +2255,73 @@ gboolean
 gnc_account_remove_split (Account *acc, Split *s)
 {
     AccountPrivate *priv;
-    GList *node;
+    gint pos;
 
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), FALSE);
     g_return_val_if_fail(GNC_IS_SPLIT(s), FALSE);
 
     priv = GET_PRIVATE(acc);
-    node = g_list_find(priv->splits, s);
-    if (NULL == node)
+    pos = split_array_find (priv->split_array, s);
+    if (pos < 0)
         return FALSE;
 
-    priv->splits = g_list_delete_link(priv->splits, node);
+    g_ptr_array_remove_index (priv->split_array, pos);
+    priv->splits = g_list_remove(priv->splits, s);
+    if (priv->unreconciled_splits)
+        g_hash_table_remove (priv->unreconciled_splits, s);
+    /* The indexes may hold it under texts it no longer has. */
+    text_index_clear (priv);
+    /* Removing a split leaves the sorted part sorted, just shorter. */
+    if ((guint) pos < priv->sort_dirty_from && priv->sort_dirty_from != G_MAXUINT)
+        --priv->sort_dirty_from;
     //FIXME: find better event type
     qof_event_gen(&acc->inst, QOF_EVENT_MODIFY, NULL);
     // And send the account-based event, too
     qof_event_gen(&acc->inst, GNC_EVENT_ITEM_REMOVED, s);
 
-    priv->balance_dirty = TRUE;
+    set_balance_dirty_from (priv, pos);
+    priv->date_index_dirty = TRUE;
     xaccAccountRecomputeBalance(acc);
     return TRUE;
 }
 
-void
-xaccAccountSortSplits (Account *acc, gboolean force)
+static void
+account_sort_splits (Account *acc, gboolean force)
 {
     AccountPrivate *priv;
-
-    g_return_if_fail(GNC_IS_ACCOUNT(acc));
+    GList *lp;
+    guint i, first_moved;
 
     priv = GET_PRIVATE(acc);
     if (!priv->sort_dirty || (!force && qof_instance_get_editlevel(acc) > 0))
         return;
-    priv->splits = g_list_sort(priv->splits, (GCompareFunc)xaccSplitOrder);
+    /* Only the splits from the first one that moved need new running
+     * balances.  A sort_dirty_from of 0, as set by
+     * gnc_account_set_sort_dirty when the sort order itself may have
+     * changed, makes this a full sort. */
+    first_moved = split_array_sort_tail (priv->split_array,
+                                         priv->sort_dirty_from,
+                                         qof_book_use_split_action_for_num_field
+                                         (gnc_account_get_book (acc)));
+    /* Write the new order back into the existing list nodes rather than
+     * sorting the list itself, so no nodes are reallocated. */
+    for (lp = priv->splits, i = 0; lp; lp = lp->next, ++i)
+        lp->data = g_ptr_array_index (priv->split_array, i);
     priv->sort_dirty = FALSE;
-    priv->balance_dirty = TRUE;
+    priv->sort_dirty_from = G_MAXUINT;
+    if (first_moved < priv->split_array->len)
+        set_balance_dirty_from (priv, first_moved);
+    priv->date_index_dirty = TRUE;
+}
+
+void
+xaccAccountSortSplits (Account *acc, gboolean force)
+{
+    g_return_if_fail(GNC_IS_ACCOUNT(acc));
+
+    g_rec_mutex_lock (&account_cache_lock);
+    account_sort_splits (acc, force);
+    g_rec_mutex_unlock (&account_cache_lock);
 }
 
 static void
@@ -1926,6 +2443,9 @@ xaccAccountRemoveLot (Account *acc, GNCLot *lot)
 
     ENTER ("(acc=%p, lot=%p)", acc, lot);
     priv->lots = g_list_remove(priv->lots, lot);
+    open_lots_forget (priv, lot);
+    if (lot_changed_hook)
+        lot_changed_hook (acc, lot, FALSE);
     qof_event_gen (QOF_INSTANCE(lot), QOF_EVENT_REMOVE, NULL);
     qof_event_gen (&acc->inst, QOF_EVENT_MODIFY, NULL);
     LEAVE ("(acc=%p, lot=%p)", acc, lot);
@@ -1955,11 +2475,13 @@ xaccAccountInsertLot (Account *acc, GNCLot *lot)
         old_acc = lot_account;
         opriv = GET_PRIVATE(old_acc);
         opriv->lots = g_list_remove(opriv->lots, lot);
+        open_lots_forget (opriv, lot);
     }
 
     priv = GET_PRIVATE(acc);
     priv->lots = g_list_prepend(priv->lots, lot);
     gnc_lot_set_account(lot, acc);
+    gnc_account_lot_changed (acc, lot);
 
     /* Don't move the splits to the new account.  The caller will do this
      * if appropriate, and doing it here will not work if we are being
@@ -1973,44 +2495,288 @@ xaccAccountInsertLot (Account *acc, GNCLot *lot)
 }
 
 /********************************************************************\
+ * The open-lot index.  Cap-gains lot selection asks for the earliest
+ * or latest open lot of some sign for every split it assigns, and a
+ * brokerage account can hold thousands of lots, nearly all of them
+ * closed.  So the account keeps the usable open lots sorted by
+ * opening date.  A lot that changes is taken out of the index and
+ * re-examined at the next lookup, when its balance and earliest split
+ * are final.
 \********************************************************************/
+
+static Split *
+open_lot_opening_split (GNCLot *lot, int *side)
+{
+    Split *s;
+    gboolean opening_is_positive;
+
+    if (gnc_lot_is_closed (lot)) return NULL;
+
+    s = gnc_lot_get_earliest_split (lot);
+    if (s == NULL || s->parent == NULL) return NULL;
+    if (gnc_numeric_zero_p (s->amount)) return NULL;
+
+    /* Overfull lots, whose balance has the opposite sign to the
+     * opening split, can't take any more splits. */
+    opening_is_positive = gnc_numeric_positive_p (s->amount);
+    if (opening_is_positive !=
+            gnc_numeric_positive_p (gnc_lot_get_balance (lot)))
+        return NULL;
+
+    *side = opening_is_positive ? 0 : 1;
+    return s;
+}
+
+static time64
+open_lot_date (GNCLot *lot)
+{
+    return xaccTransGetDate (gnc_lot_get_earliest_split (lot)->parent);
+}
+
+static gint
+open_lot_order (gconstpointer a, gconstpointer b)
+{
+    time64 ta = open_lot_date (*(GNCLot **)a);
+    time64 tb = open_lot_date (*(GNCLot **)b);
+    return ta < tb ? -1 : ta > tb ? 1 : 0;
+}
+
+/* Insert the lot after any lots opened at the same time. */
 static void
-xaccPreSplitMove (Split *split, gpointer dummy)
+open_lots_insert (GPtrArray *array, GNCLot *lot)
 {
-    xaccTransBeginEdit (xaccSplitGetParent (split));
+    time64 date = open_lot_date (lot);
+    guint lo = 0, hi = array->len;
+
+    while (lo < hi)
+    {
+        guint mid = lo + (hi - lo) / 2;
+        if (open_lot_date (g_ptr_array_index (array, mid)) <= date)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    g_ptr_array_add (array, NULL);
+    memmove (array->pdata + lo + 1, array->pdata + lo,
+             (array->len - 1 - lo) * sizeof (gpointer));
+    g_ptr_array_index (array, lo) = lot;
 }
 
 static void
-xaccPostSplitMove (Split *split, Account *accto)
+open_lots_clear (AccountPrivate *priv)
 {
-    Transaction *trans;
+    int i;
 
-    xaccSplitSetAccount(split, accto);
-    xaccSplitSetAmount(split, split->amount);
-    trans = xaccSplitGetParent (split);
-    xaccTransCommitEdit (trans);
+    for (i = 0; i < 2; i++)
+    {
+        if (priv->open_lots[i])
+            g_ptr_array_free (priv->open_lots[i], TRUE);
+        priv->open_lots[i] = NULL;
+    }
+    if (priv->open_lots_pending)
+        g_ptr_array_free (priv->open_lots_pending, TRUE);
+    priv->open_lots_pending = NULL;
+}
+
+static void
+open_lots_forget (AccountPrivate *priv, GNCLot *lot)
+{
+    int i;
+
+    if (!priv->open_lots_pending) return;
+
+    for (i = 0; i < 2; i++)
+        g_ptr_array_remove (priv->open_lots[i], lot);
+    g_ptr_array_remove (priv->open_lots_pending, lot);
 }
 
 void
-xaccAccountMoveAllSplits (Account *accfrom, Account *accto)
+gnc_account_set_lot_changed_hook (AccountLotChangedHook hook)
 {
-    AccountPrivate *from_priv;
+    lot_changed_hook = hook;
+}
 
-    /* errors */
-    g_return_if_fail(GNC_IS_ACCOUNT(accfrom));
-    g_return_if_fail(GNC_IS_ACCOUNT(accto));
+void
+gnc_account_lot_changed (Account *acc, GNCLot *lot)
+{
+    AccountPrivate *priv;
 
-    /* optimizations */
-    from_priv = GET_PRIVATE(accfrom);
-    if (!from_priv->splits || accfrom == accto)
-        return;
+    if (!acc || !lot) return;
 
-    /* check for book mix-up */
-    g_return_if_fail (qof_instance_books_equal(accfrom, accto));
-    ENTER ("(accfrom=%p, accto=%p)", accfrom, accto);
+    if (lot_changed_hook)
+        lot_changed_hook (acc, lot, TRUE);
 
-    xaccAccountBeginEdit(accfrom);
-    xaccAccountBeginEdit(accto);
+    priv = GET_PRIVATE(acc);
+    if (!priv->open_lots_pending) return;
+
+    open_lots_forget (priv, lot);
+    g_ptr_array_add (priv->open_lots_pending, lot);
+}
+
+static void
+open_lots_update (AccountPrivate *priv)
+{
+    GNCLot *lot;
+    GList *node;
+    guint i;
+    int side;
+
+    if (!priv->open_lots_pending)
+    {
+        priv->open_lots_pending = g_ptr_array_new ();
+        for (side = 0; side < 2; side++)
+            priv->open_lots[side] = g_ptr_array_new ();
+
+        for (node = priv->lots; node; node = node->next)
+        {
+            lot = node->data;
+            if (open_lot_opening_split (lot, &side))
+                g_ptr_array_add (priv->open_lots[side], lot);
+        }
+        for (side = 0; side < 2; side++)
+            g_ptr_array_sort (priv->open_lots[side], open_lot_order);
+        return;
+    }
+
+    for (i = 0; i < priv->open_lots_pending->len; i++)
+    {
+        lot = g_ptr_array_index (priv->open_lots_pending, i);
+        if (open_lot_opening_split (lot, &side))
+            open_lots_insert (priv->open_lots[side], lot);
+    }
+    g_ptr_array_set_size (priv->open_lots_pending, 0);
+}
+
+GNCLot *
+gnc_account_find_open_lot (Account *acc, gboolean opening_positive,
+                           gnc_commodity *currency, gboolean latest)
+{
+    AccountPrivate *priv;
+    GPtrArray *array;
+    guint i;
+
+    g_return_val_if_fail (GNC_IS_ACCOUNT(acc), NULL);
+
+    priv = GET_PRIVATE(acc);
+    open_lots_update (priv);
+    array = priv->open_lots[opening_positive ? 0 : 1];
+
+    for (i = 0; i < array->len; i++)
+    {
+        GNCLot *lot = g_ptr_array_index (array,
+                                         latest ? array->len - 1 - i : i);
+        Transaction *trans = gnc_lot_get_earliest_split (lot)->parent;
+
+        if (!currency ||
+                gnc_commodity_equiv (currency, trans->common_currency))
+            return lot;
+    }
+    return NULL;
+}
+
+/********************************************************************\********************************************************************/
+
+static gboolean
+split_is_unreconciled (const Split *split)
+{
+    return split->reconciled == NREC || split->reconciled == CREC;
+}
+
+static void
+unreconciled_clear (AccountPrivate *priv)
+{
+    if (priv->unreconciled_splits)
+        g_hash_table_destroy (priv->unreconciled_splits);
+    priv->unreconciled_splits = NULL;
+}
+
+void
+gnc_account_split_reconcile_changed (Account *acc, Split *split)
+{
+    AccountPrivate *priv;
+
+    g_return_if_fail (GNC_IS_ACCOUNT (acc));
+    g_return_if_fail (GNC_IS_SPLIT (split));
+
+    priv = GET_PRIVATE (acc);
+    if (!priv->unreconciled_splits || split->acc != acc)
+        return;
+
+    if (split_is_unreconciled (split))
+        g_hash_table_insert (priv->unreconciled_splits, split, split);
+    else
+        g_hash_table_remove (priv->unreconciled_splits, split);
+}
+
+SplitList *
+xaccAccountGetUnreconciledSplits (const Account *acc)
+{
+    AccountPrivate *priv;
+    GHashTableIter iter;
+    gpointer key;
+    GList *node, *result = NULL;
+
+    g_return_val_if_fail (GNC_IS_ACCOUNT (acc), NULL);
+
+    priv = GET_PRIVATE (acc);
+    g_rec_mutex_lock (&account_cache_lock);
+    if (!priv->unreconciled_splits)
+    {
+        priv->unreconciled_splits = g_hash_table_new (g_direct_hash,
+                                                      g_direct_equal);
+        for (node = priv->splits; node; node = node->next)
+            if (split_is_unreconciled (node->data))
+                g_hash_table_insert (priv->unreconciled_splits,
+                                     node->data, node->data);
+    }
+
+    g_hash_table_iter_init (&iter, priv->unreconciled_splits);
+    while (g_hash_table_iter_next (&iter, &key, NULL))
+        result = g_list_prepend (result, key);
+    g_rec_mutex_unlock (&account_cache_lock);
+    return result;
+}
+
+/********************************************************************\
+\********************************************************************/
+static void
+xaccPreSplitMove (Split *split, gpointer dummy)
+{
+    xaccTransBeginEdit (xaccSplitGetParent (split));
+}
+
+static void
+xaccPostSplitMove (Split *split, Account *accto)
+{
+    Transaction *trans;
+
+    xaccSplitSetAccount(split, accto);
+    xaccSplitSetAmount(split, split->amount);
+    trans = xaccSplitGetParent (split);
+    xaccTransCommitEdit (trans);
+}
+
+void
+xaccAccountMoveAllSplits (Account *accfrom, Account *accto)
+{
+    AccountPrivate *from_priv;
+
+    /* errors */
+    g_return_if_fail(GNC_IS_ACCOUNT(accfrom));
+    g_return_if_fail(GNC_IS_ACCOUNT(accto));
+
+    /* optimizations */
+    from_priv = GET_PRIVATE(accfrom);
+    if (!from_priv->splits || accfrom == accto)
+        return;
+
+    /* check for book mix-up */
+    g_return_if_fail (qof_instance_books_equal(accfrom, accto));
+    ENTER ("(accfrom=%p, accto=%p)", accfrom, accto);
+
+    xaccAccountBeginEdit(accfrom);
+    xaccAccountBeginEdit(accto);
     /* Begin editing both accounts and all transactions in accfrom. */
     g_list_foreach(from_priv->splits, (GFunc)xaccPreSplitMove, NULL);
 
@@ -2069,16 +2835,14 @@ xaccAccountMoveAllSplits (Account *accfrom, Account *accto)
  * Return: void                                                     *
 \********************************************************************/
 
-void
-xaccAccountRecomputeBalance (Account * acc)
+static void
+account_recompute_balance (Account * acc)
 {
     AccountPrivate *priv;
     gnc_numeric  balance;
     gnc_numeric  cleared_balance;
     gnc_numeric  reconciled_balance;
-    GList *lp;
-
-    if (NULL == acc) return;
+    guint i, start;
 
     priv = GET_PRIVATE(acc);
     if (qof_instance_get_editlevel(acc) > 0) return;
@@ -2086,15 +2850,29 @@ xaccAccountRecomputeBalance (Account * acc)
     if (qof_instance_get_destroying(acc)) return;
     if (qof_book_shutting_down(qof_instance_get_book(acc))) return;
 
-    balance            = priv->starting_balance;
-    cleared_balance    = priv->starting_cleared_balance;
-    reconciled_balance = priv->starting_reconciled_balance;
+    /* Pick up the running balances from the last split that is still
+     * known to be good. */
+    start = MIN (priv->balance_dirty_from, priv->split_array->len);
+    if (start == 0)
+    {
+        balance            = priv->starting_balance;
+        cleared_balance    = priv->starting_cleared_balance;
+        reconciled_balance = priv->starting_reconciled_balance;
+    }
+    else
+    {
+        Split *split = g_ptr_array_index (priv->split_array, start - 1);
+        balance            = split->balance;
+        cleared_balance    = split->cleared_balance;
+        reconciled_balance = split->reconciled_balance;
+    }
 
-    PINFO ("acct=%s starting baln=%" G_GINT64_FORMAT "/%" G_GINT64_FORMAT,
-           priv->accountName, balance.num, balance.denom);
-    for (lp = priv->splits; lp; lp = lp->next)
+    PINFO ("acct=%s starting baln=%" G_GINT64_FORMAT "/%" G_GINT64_FORMAT
+           " at split %u", priv->accountName, balance.num, balance.denom,
+           start);
+    for (i = start; i < priv->split_array->len; ++i)
     {
-        Split *split = (Split *) lp->data;
+        Split *split = g_ptr_array_index (priv->split_array, i);
         gnc_numeric amt = xaccSplitGetAmount (split);
 
         balance = gnc_numeric_add_fixed(balance, amt);
@@ -2121,6 +2899,17 @@ xaccAccountRecomputeBalance (Account * acc)
     priv->cleared_balance = cleared_balance;
     priv->reconciled_balance = reconciled_balance;
     priv->balance_dirty = FALSE;
+    priv->balance_dirty_from = G_MAXUINT;
+}
+
+void
+xaccAccountRecomputeBalance (Account * acc)
+{
+    if (NULL == acc) return;
+
+    g_rec_mutex_lock (&account_cache_lock);
+    account_recompute_balance (acc);
+    g_rec_mutex_unlock (&account_cache_lock);
 }
 
 /********************************************************************\
@@ -2235,7 +3024,7 @@ xaccAccountSetType (Account *acc, GNCAccountType tip)
 
     xaccAccountBeginEdit(acc);
     priv->type = tip;
-    priv->balance_dirty = TRUE; /* new type may affect balance computation */
+    set_balance_dirty_from (priv, 0); /* new type may affect balance computation */
     mark_account(acc);
     xaccAccountCommitEdit(acc);
 }
@@ -2256,6 +3045,7 @@ xaccAccountSetName (Account *acc, const char *str)
 
     xaccAccountBeginEdit(acc);
     CACHE_REPLACE(priv->accountName, str);
+    ++account_tree_generation;
     mark_account (acc);
     xaccAccountCommitEdit(acc);
 }
@@ -2275,6 +3065,7 @@ xaccAccountSetCode (Account *acc, const char *str)
 
     xaccAccountBeginEdit(acc);
     CACHE_REPLACE(priv->accountCode, str ? str : "");
+    ++account_tree_generation;
     mark_account (acc);
     xaccAccountCommitEdit(acc);
 }
@@ -2329,10 +3120,8 @@ set_kvp_string_tag (Account *acc, const char *tag, const char *value)
 static const char*
 get_kvp_string_tag (const Account *acc, const char *tag)
 {
-    GValue v = G_VALUE_INIT;
     if (acc == NULL || tag == NULL) return NULL;
-    qof_instance_get_kvp (QOF_INSTANCE (acc), tag, &v);
-    return G_VALUE_HOLDS_STRING (&v) ? g_value_get_string (&v) : NULL;
+    return qof_instance_get_kvp_string (QOF_INSTANCE (acc), 1, &tag);
 }
 
 void
@@ -2417,7 +3206,8 @@ xaccAccountSetCommodity (Account * acc, gnc_commodity * com)
     }
 
     priv->sort_dirty = TRUE;  /* Not needed. */
-    priv->balance_dirty = TRUE;
+    priv->sort_dirty_from = 0;
+    set_balance_dirty_from (priv, 0);
     mark_account (acc);
 
     xaccAccountCommitEdit(acc);
@@ -2570,6 +3360,8 @@ gnc_account_append_child (Account *new_parent, Account *child)
     }
     cpriv->parent = new_parent;
     ppriv->children = g_list_append(ppriv->children, child);
+    rollup_cache_invalidate (ppriv);
+    ++account_tree_generation;
     qof_instance_set_dirty(&new_parent->inst);
     qof_instance_set_dirty(&child->inst);
 
@@ -2610,6 +3402,8 @@ gnc_account_remove_child (Account *parent, Account *child)
     ed.idx = g_list_index(ppriv->children, child);
 
     ppriv->children = g_list_remove(ppriv->children, child);
+    rollup_cache_invalidate (ppriv);
+    ++account_tree_generation;
 
     /* Now send the event. */
     qof_event_gen(&child->inst, QOF_EVENT_REMOVE, &ed);
@@ -2658,6 +3452,13 @@ gnc_account_get_children (const Account *account)
     return g_list_copy(GET_PRIVATE(account)->children);
 }
 
+GList *
+gnc_account_peek_children (const Account *account)
+{
+    g_return_val_if_fail(GNC_IS_ACCOUNT(account), NULL);
+    return GET_PRIVATE(account)->children;
+}
+
 GList *
 gnc_account_get_children_sorted (const Account *account)
 {
@@ -2833,16 +3634,95 @@ gnc_account_lookup_by_name (const Account *parent, const char * name)
     return NULL;
 }
 
-Account *
-gnc_account_lookup_by_code (const Account *parent, const char * code)
+/********************************************************************\
+ * Name and code lookup indexes                                     *
+\********************************************************************/
+
+/* Stored in an index in place of an account when more than one account
+ * has the key.  Those lookups fall back to searching the tree, which
+ * decides between them the same way it always has. */
+static gchar lookup_index_ambiguous_marker;
+#define LOOKUP_INDEX_AMBIGUOUS ((gpointer)&lookup_index_ambiguous_marker)
+
+static void
+lookup_index_add (GHashTable *index, const gchar *key, Account *acc)
+{
+    if (g_hash_table_lookup (index, key))
+        g_hash_table_replace (index, g_strdup (key), LOOKUP_INDEX_AMBIGUOUS);
+    else
+        g_hash_table_insert (index, g_strdup (key), acc);
+}
+
+/* Index the descendants of parent.  prefix is parent's full name, or
+ * NULL for the root.  Accounts whose name contains the separator can't
+ * be reached by splitting a full name, so nothing at or below them
+ * goes into the full name index. */
+static void
+lookup_index_add_children (AccountPrivate *rpriv, const Account *parent,
+                           const gchar *prefix, gboolean name_reachable)
+{
+    GList *node;
+
+    for (node = GET_PRIVATE(parent)->children; node; node = node->next)
+    {
+        Account *child = node->data;
+        AccountPrivate *cpriv = GET_PRIVATE(child);
+        gboolean reachable = name_reachable &&
+                             !strstr (cpriv->accountName, account_separator);
+        gchar *full_name = prefix ?
+                           g_strconcat (prefix, account_separator,
+                                        cpriv->accountName, NULL) :
+                           g_strdup (cpriv->accountName);
+
+        if (reachable && *full_name)
+            lookup_index_add (rpriv->full_name_index, full_name, child);
+        if (cpriv->accountCode && *cpriv->accountCode)
+            lookup_index_add (rpriv->code_index, cpriv->accountCode, child);
+        lookup_index_add_children (rpriv, child, full_name, reachable);
+        g_free (full_name);
+    }
+}
+
+/* Return the private data of acc's root holding the indexes,
+ * (re)building them if the tree has changed since they were built. */
+static AccountPrivate *
+lookup_index_get (const Account *acc)
+{
+    AccountPrivate *rpriv = GET_PRIVATE(acc);
+
+    while (rpriv->parent)
+    {
+        acc = rpriv->parent;
+        rpriv = GET_PRIVATE(acc);
+    }
+
+    if (rpriv->full_name_index &&
+        rpriv->lookup_index_generation == account_tree_generation)
+        return rpriv;
+
+    if (rpriv->full_name_index)
+        g_hash_table_destroy (rpriv->full_name_index);
+    if (rpriv->code_index)
+        g_hash_table_destroy (rpriv->code_index);
+    rpriv->full_name_index = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                    g_free, NULL);
+    rpriv->code_index = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                               g_free, NULL);
+    lookup_index_add_children (rpriv, acc, NULL, TRUE);
+    rpriv->lookup_index_generation = account_tree_generation;
+    PINFO ("Indexed %u full names and %u codes",
+           g_hash_table_size (rpriv->full_name_index),
+           g_hash_table_size (rpriv->code_index));
+    return rpriv;
+}
+
+static Account *
+gnc_account_lookup_by_code_helper (const Account *parent, const char * code)
 {
     AccountPrivate *cpriv, *ppriv;
     Account *child, *result;
     GList *node;
 
-    g_return_val_if_fail(GNC_IS_ACCOUNT(parent), NULL);
-    g_return_val_if_fail(code, NULL);
-
     /* first, look for accounts hanging off the current node */
     ppriv = GET_PRIVATE(parent);
     for (node = ppriv->children; node; node = node->next)
@@ -2858,7 +3738,7 @@ gnc_account_lookup_by_code (const Account *parent, const char * code)
     for (node = ppriv->children; node; node = node->next)
     {
         child = node->data;
-        result = gnc_account_lookup_by_code (child, code);
+        result = gnc_account_lookup_by_code_helper (child, code);
         if (result)
             return result;
     }
@@ -2866,6 +3746,33 @@ gnc_account_lookup_by_code (const Account *parent, const char * code)
     return NULL;
 }
 
+Account *
+gnc_account_lookup_by_code (const Account *parent, const char * code)
+{
+    AccountPrivate *rpriv;
+    Account *found;
+    const Account *a;
+
+    g_return_val_if_fail(GNC_IS_ACCOUNT(parent), NULL);
+    g_return_val_if_fail(code, NULL);
+
+    if (!*code)
+        return gnc_account_lookup_by_code_helper (parent, code);
+
+    rpriv = lookup_index_get (parent);
+    found = g_hash_table_lookup (rpriv->code_index, code);
+    if (found == LOOKUP_INDEX_AMBIGUOUS)
+        return gnc_account_lookup_by_code_helper (parent, code);
+
+    /* The only account with this code only counts if it is below
+     * parent. */
+    for (a = found ? GET_PRIVATE(found)->parent : NULL; a;
+         a = GET_PRIVATE(a)->parent)
+        if (a == parent)
+            return found;
+    return NULL;
+}
+
 /********************************************************************\
  * Fetch an account, given its full name                            *
 \********************************************************************/
@@ -2924,6 +3831,11 @@ gnc_account_lookup_by_full_name (const Account *any_acc,
     g_return_val_if_fail(GNC_IS_ACCOUNT(any_acc), NULL);
     g_return_val_if_fail(name, NULL);
 
+    rpriv = lookup_index_get (any_acc);
+    found = g_hash_table_lookup (rpriv->full_name_index, name);
+    if (found != LOOKUP_INDEX_AMBIGUOUS)
+        return found;
+
     root = any_acc;
     rpriv = GET_PRIVATE(root);
     while (rpriv->parent)
@@ -3035,14 +3947,41 @@ xaccAccountGetName (const Account *acc)
     return GET_PRIVATE(acc)->accountName;
 }
 
+/* Return the account's memoized full name, building it from the
+ * parent's memoized full name if it is stale.  The root's full name is
+ * empty and its children's full names are just their names. */
+static const gchar *
+gnc_account_get_cached_full_name (const Account *account)
+{
+    AccountPrivate *priv = GET_PRIVATE(account);
+    const gchar *parent_name;
+
+    if (!priv->parent)
+        return "";
+
+    if (priv->full_name &&
+        priv->full_name_generation == account_tree_generation)
+        return priv->full_name;
+
+    g_free (priv->full_name);
+    if (!GET_PRIVATE(priv->parent)->parent)
+    {
+        priv->full_name = g_strdup (priv->accountName);
+    }
+    else
+    {
+        parent_name = gnc_account_get_cached_full_name (priv->parent);
+        priv->full_name = g_strconcat (parent_name, account_separator,
+                                       priv->accountName, NULL);
+    }
+    priv->full_name_generation = account_tree_generation;
+    return priv->full_name;
+}
+
 gchar *
 gnc_account_get_full_name(const Account *account)
 {
-    AccountPrivate *priv;
-    const Account *a;
-    char *fullname;
-    gchar **names;
-    int level;
+    gchar *full_name;
 
     /* So much for hardening the API. Too many callers to this function don't
      * bother to check if they have a non-NULL pointer before calling. */
@@ -3052,35 +3991,10 @@ gnc_account_get_full_name(const Account *account)
     /* errors */
     g_return_val_if_fail(GNC_IS_ACCOUNT(account), g_strdup(""));
 
-    /* optimizations */
-    priv = GET_PRIVATE(account);
-    if (!priv->parent)
-        return g_strdup("");
-
-    /* Figure out how much space is needed by counting the nodes up to
-     * the root. */
-    level = 0;
-    for (a = account; a; a = priv->parent)
-    {
-        priv = GET_PRIVATE(a);
-        level++;
-    }
-
-    /* Get all the pointers in the right order. The root node "entry"
-     * becomes the terminating NULL pointer for the array of strings. */
-    names = g_malloc(level * sizeof(gchar *));
-    names[--level] = NULL;
-    for (a = account; level > 0; a = priv->parent)
-    {
-        priv = GET_PRIVATE(a);
-        names[--level] = priv->accountName;
-    }
-
-    /* Build the full name */
-    fullname =  g_strjoinv(account_separator, names);
-    g_free(names);
-
-    return fullname;
+    g_rec_mutex_lock (&account_cache_lock);
+    full_name = g_strdup (gnc_account_get_cached_full_name (account));
+    g_rec_mutex_unlock (&account_cache_lock);
+    return full_name;
 }
 
 const char *
@@ -3203,7 +4117,7 @@ gnc_account_set_start_balance (Account *acc, const gnc_numeric start_baln)
 
     priv = GET_PRIVATE(acc);
     priv->starting_balance = start_baln;
-    priv->balance_dirty = TRUE;
+    set_balance_dirty_from (priv, 0);
 }
 
 void
@@ -3216,7 +4130,7 @@ gnc_account_set_start_cleared_balance (Account *acc,
 
     priv = GET_PRIVATE(acc);
     priv->starting_cleared_balance = start_baln;
-    priv->balance_dirty = TRUE;
+    set_balance_dirty_from (priv, 0);
 }
 
 void
@@ -3229,7 +4143,7 @@ gnc_account_set_start_reconciled_balance (Account *acc,
 
     priv = GET_PRIVATE(acc);
     priv->starting_reconciled_balance = start_baln;
-    priv->balance_dirty = TRUE;
+    set_balance_dirty_from (priv, 0);
 }
 
 gnc_numeric
@@ -3257,7 +4171,7 @@ gnc_numeric
 xaccAccountGetProjectedMinimumBalance (const Account *acc)
 {
     AccountPrivate *priv;
-    GList *node;
+    guint i;
     time64 today;
     gnc_numeric lowest = gnc_numeric_zero ();
     int seen_a_transaction = 0;
@@ -3266,9 +4180,9 @@ xaccAccountGetProjectedMinimumBalance (const Account *acc)
 
     priv = GET_PRIVATE(acc);
     today = gnc_time64_get_today_end();
-    for (node = g_list_last(priv->splits); node; node = node->prev)
+    for (i = priv->split_array->len; i > 0; --i)
     {
-        Split *split = node->data;
+        Split *split = g_ptr_array_index (priv->split_array, i - 1);
 
         if (!seen_a_transaction)
         {
@@ -3294,73 +4208,36 @@ xaccAccountGetProjectedMinimumBalance (const Account *acc)
 gnc_numeric
 xaccAccountGetBalanceAsOfDate (Account *acc, time64 date)
 {
-    /* Ideally this could use xaccAccountForEachSplit, but
-     * it doesn't exist yet and I'm uncertain of exactly how
-     * it would work at this time, since it differs from
-     * xaccAccountForEachTransaction by using gpointer return
-     * values rather than gints.
-     */
     AccountPrivate *priv;
-    GList   *lp;
-    Timespec ts, trans_ts;
-    gboolean found = FALSE;
     gnc_numeric balance;
+    guint lo;
 
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), gnc_numeric_zero());
 
+    /* Not all of the splits may be in memory. */
+    if (balance_source_as_of (acc, date, &balance))
+        return balance;
+
     xaccAccountSortSplits (acc, TRUE); /* just in case, normally a noop */
     xaccAccountRecomputeBalance (acc); /* just in case, normally a noop */
 
     priv = GET_PRIVATE(acc);
-    balance = priv->balance;
-
-    /* Since transaction post times are stored as a Timespec,
-     * convert date into a Timespec as well rather than converting
-     * each transaction's Timespec into a time64.
-     *
-     * FIXME: CAS: I think this comment is a bogus justification for
-     * using xaccTransGetDatePostedTS.  There's no benefit to using
-     * Timespec when the input argument is time64, and it's hard to
-     * imagine that casting long long to long and comparing two longs is
-     * worse than comparing two long longs every time.  IMO,
-     * xaccAccountGetPresentBalance gets this right, and its algorithm
-     * should be used here.
-     */
-    ts.tv_sec = date;
-    ts.tv_nsec = 0;
+    gnc_account_build_date_index (priv);
 
-    lp = priv->splits;
-    while ( lp && !found )
-    {
-        xaccTransGetDatePostedTS( xaccSplitGetParent( (Split *)lp->data ),
-                                  &trans_ts );
-        if ( timespec_cmp( &trans_ts, &ts ) >= 0 )
-            found = TRUE;
-        else
-            lp = lp->next;
-    }
+    lo = gnc_account_date_index_search (priv, date);
 
-    if ( lp )
-    {
-        if ( lp->prev )
-        {
-            /* Since lp is now pointing to a split which was past the reconcile
-             * date, get the running balance of the previous split.
-             */
-            balance = xaccSplitGetBalance( (Split *)lp->prev->data );
-        }
-        else
-        {
-            /* AsOf date must be before any entries, return zero. */
-            balance = gnc_numeric_zero();
-        }
-    }
+    /* No splits were posted after the given date, so the latest
+     * account balance is good enough. */
+    if (lo == priv->date_index_len)
+        return priv->balance;
 
-    /* Otherwise there were no splits posted after the given date,
-     * so the latest account balance should be good enough.
-     */
+    /* AsOf date must be before any entries, return zero. */
+    if (lo == 0)
+        return gnc_numeric_zero();
 
-    return( balance );
+    /* Otherwise the running balance of the split just before the
+     * cut-off is the balance we want. */
+    return xaccSplitGetBalance (g_ptr_array_index (priv->split_array, lo - 1));
 }
 
 /*
@@ -3375,16 +4252,16 @@ gnc_numeric
 xaccAccountGetPresentBalance (const Account *acc)
 {
     AccountPrivate *priv;
-    GList *node;
+    guint i;
     time64 today;
 
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), gnc_numeric_zero());
 
     priv = GET_PRIVATE(acc);
     today = gnc_time64_get_today_end();
-    for (node = g_list_last(priv->splits); node; node = node->prev)
+    for (i = priv->split_array->len; i > 0; --i)
     {
-        Split *split = node->data;
+        Split *split = g_ptr_array_index (priv->split_array, i - 1);
 
         if (xaccTransGetDate (xaccSplitGetParent (split)) <= today)
             return xaccSplitGetBalance (split);
@@ -3546,31 +4423,195 @@ xaccAccountBalanceAsOfDateHelper (Account *acc, gpointer data)
 
 
 
-/*
- * Common function that iterates recursively over all accounts below
- * the specified account.  It uses xaccAccountBalanceHelper to sum up
- * the balances of all its children, and uses the specified function
- * 'fn' for extracting the balance.  This function may extract the
- * current value, the reconciled value, etc.
- *
- * If 'report_commodity' is NULL, just use the account's commodity.
- * If 'include_children' is FALSE, this function doesn't recurse at all.
- */
-static gnc_numeric
-xaccAccountGetXxxBalanceInCurrencyRecursive (const Account *acc,
-        xaccGetBalanceFn fn,
-        const gnc_commodity *report_commodity,
-        gboolean include_children)
+/********************************************************************\
+ * Recursive balance roll-up cache                                  *
+\********************************************************************/
+
+typedef struct
 {
+    xaccGetBalanceFn fn;
+    xaccGetBalanceAsOfDateFn asOfDateFn;
+    const gnc_commodity *currency;
+    time64 date;
+    guint price_generation;
     gnc_numeric balance;
+} BalanceRollup;
 
-    if (!acc) return gnc_numeric_zero ();
-    if (!report_commodity)
-        report_commodity = xaccAccountGetCommodity (acc);
-    if (!report_commodity)
-        return gnc_numeric_zero();
+/* An account rarely gets asked for more than a few kinds of balance, so
+ * a short list is enough; the oldest entries fall off the end. */
+#define ROLLUP_CACHE_MAX_ENTRIES 8
 
-    balance = xaccAccountGetXxxBalanceInCurrency (acc, fn, report_commodity);
+static gboolean rollup_cache_enabled = FALSE;
+static gint rollup_cache_price_handler = 0;
+static guint rollup_cache_price_generation = 0;
+static guint64 rollup_cache_hits = 0;
+static guint64 rollup_cache_misses = 0;
+
+static void
+rollup_cache_free (AccountPrivate *priv)
+{
+    g_list_free_full (priv->rollup_cache, g_free);
+    priv->rollup_cache = NULL;
+}
+
+/* Drop the roll-ups of this account and all of its ancestors, which
+ * include this account's balance. */
+static void
+rollup_cache_invalidate (AccountPrivate *priv)
+{
+    while (priv)
+    {
+        if (priv->rollup_cache)
+            rollup_cache_free (priv);
+        priv = priv->parent ? GET_PRIVATE(priv->parent) : NULL;
+    }
+}
+
+/* Any price change may alter any converted balance, so rather than
+ * looking for the entries affected all of them are made stale by
+ * bumping the generation they were stored with. */
+static void
+rollup_cache_price_event (QofInstance *ent, QofEventId event_type,
+                          gpointer handler_data, gpointer event_data)
+{
+    if (!GNC_IS_PRICE(ent))
+        return;
+    if (event_type & (QOF_EVENT_CREATE | QOF_EVENT_MODIFY | QOF_EVENT_DESTROY |
+                      QOF_EVENT_ADD | QOF_EVENT_REMOVE))
+        ++rollup_cache_price_generation;
+}
+
+void
+gnc_account_set_balance_rollup_cache (gboolean enabled)
+{
+    if (enabled == rollup_cache_enabled)
+        return;
+
+    rollup_cache_enabled = enabled;
+    if (enabled)
+    {
+        rollup_cache_hits = rollup_cache_misses = 0;
+        rollup_cache_price_handler =
+            qof_event_register_handler (rollup_cache_price_event, NULL);
+        return;
+    }
+
+    qof_event_unregister_handler (rollup_cache_price_handler);
+    rollup_cache_price_handler = 0;
+    /* Make everything cached so far stale in case the cache is turned
+     * back on later. */
+    ++rollup_cache_price_generation;
+    PINFO ("balance roll-up cache: %" G_GUINT64_FORMAT " hits, %"
+           G_GUINT64_FORMAT " misses (%.1f%% hit rate)",
+           rollup_cache_hits, rollup_cache_misses,
+           rollup_cache_hits + rollup_cache_misses ?
+           100.0 * rollup_cache_hits / (rollup_cache_hits + rollup_cache_misses) :
+           0.0);
+}
+
+/* Only the balances which depend solely on the splits and the prices
+ * can be cached; the present and projected minimum balances also
+ * depend on the time of day. */
+static gboolean
+rollup_cache_usable (xaccGetBalanceFn fn)
+{
+    return rollup_cache_enabled &&
+           (fn == xaccAccountGetBalance ||
+            fn == xaccAccountGetClearedBalance ||
+            fn == xaccAccountGetReconciledBalance);
+}
+
+static gboolean
+rollup_cache_lookup (const Account *acc, xaccGetBalanceFn fn,
+                     xaccGetBalanceAsOfDateFn asOfDateFn,
+                     const gnc_commodity *currency, time64 date,
+                     gnc_numeric *balance)
+{
+    AccountPrivate *priv = GET_PRIVATE(acc);
+    GList *node;
+
+    g_rec_mutex_lock (&account_cache_lock);
+    for (node = priv->rollup_cache; node; node = node->next)
+    {
+        BalanceRollup *entry = node->data;
+        if (entry->fn == fn && entry->asOfDateFn == asOfDateFn &&
+            entry->currency == currency && entry->date == date &&
+            entry->price_generation == rollup_cache_price_generation)
+        {
+            *balance = entry->balance;
+            ++rollup_cache_hits;
+            g_rec_mutex_unlock (&account_cache_lock);
+            return TRUE;
+        }
+    }
+    ++rollup_cache_misses;
+    if ((rollup_cache_misses & 0xfff) == 0)
+        DEBUG ("balance roll-up cache: %" G_GUINT64_FORMAT " hits, %"
+               G_GUINT64_FORMAT " misses", rollup_cache_hits,
+               rollup_cache_misses);
+    g_rec_mutex_unlock (&account_cache_lock);
+    return FALSE;
+}
+
+static void
+rollup_cache_store (const Account *acc, xaccGetBalanceFn fn,
+                    xaccGetBalanceAsOfDateFn asOfDateFn,
+                    const gnc_commodity *currency, time64 date,
+                    gnc_numeric balance)
+{
+    AccountPrivate *priv = GET_PRIVATE(acc);
+    BalanceRollup *entry = g_new (BalanceRollup, 1);
+    GList *last;
+
+    entry->fn = fn;
+    entry->asOfDateFn = asOfDateFn;
+    entry->currency = currency;
+    entry->date = date;
+    entry->price_generation = rollup_cache_price_generation;
+    entry->balance = balance;
+
+    g_rec_mutex_lock (&account_cache_lock);
+    priv->rollup_cache = g_list_prepend (priv->rollup_cache, entry);
+
+    last = g_list_nth (priv->rollup_cache, ROLLUP_CACHE_MAX_ENTRIES);
+    if (last)
+    {
+        last->prev->next = NULL;
+        last->prev = NULL;
+        g_list_free_full (last, g_free);
+    }
+    g_rec_mutex_unlock (&account_cache_lock);
+}
+
+/*
+ * Common function that iterates recursively over all accounts below
+ * the specified account.  It uses xaccAccountBalanceHelper to sum up
+ * the balances of all its children, and uses the specified function
+ * 'fn' for extracting the balance.  This function may extract the
+ * current value, the reconciled value, etc.
+ *
+ * If 'report_commodity' is NULL, just use the account's commodity.
+ * If 'include_children' is FALSE, this function doesn't recurse at all.
+ */
+static gnc_numeric
+xaccAccountGetXxxBalanceInCurrencyRecursive (const Account *acc,
+        xaccGetBalanceFn fn,
+        const gnc_commodity *report_commodity,
+        gboolean include_children)
+{
+    gnc_numeric balance;
+
+    if (!acc) return gnc_numeric_zero ();
+    if (!report_commodity)
+        report_commodity = xaccAccountGetCommodity (acc);
+    if (!report_commodity)
+        return gnc_numeric_zero();
+
+    if (include_children && rollup_cache_usable (fn) &&
+        rollup_cache_lookup (acc, fn, NULL, report_commodity, 0, &balance))
+        return balance;
+
+    balance = xaccAccountGetXxxBalanceInCurrency (acc, fn, report_commodity);
 
     /* If needed, sum up the children converting to the *requested*
        commodity. */
@@ -3588,6 +4629,8 @@ xaccAccountGetXxxBalanceInCurrencyRecursive (const Account *acc,
 
         gnc_account_foreach_descendant (acc, xaccAccountBalanceHelper, &cb);
         balance = cb.balance;
+        if (rollup_cache_usable (fn))
+            rollup_cache_store (acc, fn, NULL, report_commodity, 0, balance);
     }
 
     return balance;
@@ -3598,111 +4641,621 @@ xaccAccountGetXxxBalanceAsOfDateInCurrencyRecursive (
     Account *acc, time64 date, xaccGetBalanceAsOfDateFn fn,
     gnc_commodity *report_commodity, gboolean include_children)
 {
-    gnc_numeric balance;
+    gnc_numeric balance;
+
+    g_return_val_if_fail(acc, gnc_numeric_zero());
+    if (!report_commodity)
+        report_commodity = xaccAccountGetCommodity (acc);
+    if (!report_commodity)
+        return gnc_numeric_zero();
+
+    if (include_children && rollup_cache_enabled &&
+        rollup_cache_lookup (acc, NULL, fn, report_commodity, date, &balance))
+        return balance;
+
+    balance = xaccAccountGetXxxBalanceAsOfDateInCurrency(
+                  acc, date, fn, report_commodity);
+
+    /* If needed, sum up the children converting to the *requested*
+       commodity. */
+    if (include_children)
+    {
+#ifdef _MSC_VER
+        /* MSVC compiler: Somehow, the struct initialization containing a
+           gnc_numeric doesn't work. As an exception, we hand-initialize
+           that member afterwards. */
+        CurrencyBalance cb = { report_commodity, 0, NULL, fn, date };
+        cb.balance = balance;
+#else
+        CurrencyBalance cb = { report_commodity, balance, NULL, fn, date };
+#endif
+
+        gnc_account_foreach_descendant (acc, xaccAccountBalanceAsOfDateHelper, &cb);
+        balance = cb.balance;
+        if (rollup_cache_enabled)
+            rollup_cache_store (acc, NULL, fn, report_commodity, date, balance);
+    }
+
+    return balance;
+}
+
+gnc_numeric
+xaccAccountGetBalanceInCurrency (const Account *acc,
+                                 const gnc_commodity *report_commodity,
+                                 gboolean include_children)
+{
+    gnc_numeric rc;
+    rc = xaccAccountGetXxxBalanceInCurrencyRecursive (
+             acc, xaccAccountGetBalance, report_commodity, include_children);
+    PINFO(" baln=%" G_GINT64_FORMAT "/%" G_GINT64_FORMAT, rc.num, rc.denom);
+    return rc;
+}
+
+
+gnc_numeric
+xaccAccountGetClearedBalanceInCurrency (const Account *acc,
+                                        const gnc_commodity *report_commodity,
+                                        gboolean include_children)
+{
+    return xaccAccountGetXxxBalanceInCurrencyRecursive (
+               acc, xaccAccountGetClearedBalance, report_commodity,
+               include_children);
+}
+
+gnc_numeric
+xaccAccountGetReconciledBalanceInCurrency (const Account *acc,
+        const gnc_commodity *report_commodity,
+        gboolean include_children)
+{
+    return xaccAccountGetXxxBalanceInCurrencyRecursive (
+               acc, xaccAccountGetReconciledBalance, report_commodity,
+               include_children);
+}
+
+gnc_numeric
+xaccAccountGetPresentBalanceInCurrency (const Account *acc,
+                                        const gnc_commodity *report_commodity,
+                                        gboolean include_children)
+{
+    return xaccAccountGetXxxBalanceInCurrencyRecursive (
+               acc, xaccAccountGetPresentBalance, report_commodity,
+               include_children);
+}
+
+gnc_numeric
+xaccAccountGetProjectedMinimumBalanceInCurrency (
+    const Account *acc,
+    const gnc_commodity *report_commodity,
+    gboolean include_children)
+{
+    return xaccAccountGetXxxBalanceInCurrencyRecursive (
+               acc, xaccAccountGetProjectedMinimumBalance, report_commodity,
+               include_children);
+}
+
+gnc_numeric
+xaccAccountGetBalanceAsOfDateInCurrency(
+    Account *acc, time64 date, gnc_commodity *report_commodity,
+    gboolean include_children)
+{
+    return xaccAccountGetXxxBalanceAsOfDateInCurrencyRecursive (
+               acc, date, xaccAccountGetBalanceAsOfDate, report_commodity,
+               include_children);
+}
+
+gnc_numeric
+xaccAccountGetBalanceChangeForPeriod (Account *acc, time64 t1, time64 t2,
+                                      gboolean recurse)
+{
+    gnc_numeric b1, b2;
+
+    b1 = xaccAccountGetBalanceAsOfDateInCurrency(acc, t1, NULL, recurse);
+    b2 = xaccAccountGetBalanceAsOfDateInCurrency(acc, t2, NULL, recurse);
+    return gnc_numeric_sub(b2, b1, GNC_DENOM_AUTO, GNC_HOW_DENOM_FIXED);
+}
+
+void
+xaccAccountGetBalancesAsOfDates (Account *acc, const time64 *dates,
+                                 guint n_dates, gnc_numeric *balances)
+{
+    AccountPrivate *priv;
+    guint i, lo = 0;
+
+    g_return_if_fail (GNC_IS_ACCOUNT(acc));
+    g_return_if_fail (n_dates == 0 || (dates && balances));
+
+    if (n_dates == 0)
+        return;
+
+    /* Not all of the splits may be in memory. */
+    if (balance_source_as_of (acc, dates[0], &balances[0]))
+    {
+        for (i = 1; i < n_dates; i++)
+            balances[i] = xaccAccountGetBalanceAsOfDate (acc, dates[i]);
+        return;
+    }
+
+    xaccAccountSortSplits (acc, TRUE); /* just in case, normally a noop */
+    xaccAccountRecomputeBalance (acc); /* just in case, normally a noop */
+
+    priv = GET_PRIVATE(acc);
+    gnc_account_build_date_index (priv);
+
+    for (i = 0; i < n_dates; i++)
+    {
+        while (lo < priv->date_index_len && priv->date_index_dates[lo] < dates[i])
+            lo++;
+
+        if (lo == priv->date_index_len)
+            balances[i] = priv->balance;
+        else if (lo == 0)
+            balances[i] = gnc_numeric_zero();
+        else
+            balances[i] = xaccSplitGetBalance (
+                              g_ptr_array_index (priv->split_array, lo - 1));
+    }
+}
+
+typedef struct
+{
+    const gnc_commodity *currency;
+    const time64 *dates;
+    guint n_dates;
+    gnc_numeric *scratch;
+    gnc_numeric *totals;
+} CurrencyBalancesAsOfDates;
+
+static void
+xaccAccountBalancesAsOfDatesHelper (Account *acc, gpointer data)
+{
+    CurrencyBalancesAsOfDates *cb = data;
+    AccountPrivate *priv = GET_PRIVATE(acc);
+    guint i;
+
+    xaccAccountGetBalancesAsOfDates (acc, cb->dates, cb->n_dates, cb->scratch);
+    for (i = 0; i < cb->n_dates; i++)
+    {
+        gnc_numeric balance = xaccAccountConvertBalanceToCurrency (
+                                  acc, cb->scratch[i], priv->commodity,
+                                  cb->currency);
+        cb->totals[i] = gnc_numeric_add (cb->totals[i], balance,
+                                         gnc_commodity_get_fraction (cb->currency),
+                                         GNC_HOW_RND_ROUND_HALF_UP);
+    }
+}
+
+void
+xaccAccountGetBalanceChangesForPeriods (Account *acc, const time64 *starts,
+                                        const time64 *ends, guint n_periods,
+                                        gboolean recurse, gnc_numeric *changes)
+{
+    CurrencyBalancesAsOfDates cb;
+    time64 *dates;
+    gnc_numeric *totals;
+    guint i;
+
+    g_return_if_fail (GNC_IS_ACCOUNT(acc));
+    g_return_if_fail (n_periods == 0 || (starts && ends && changes));
+
+    /* The single pass needs the period boundaries in order; anything
+     * else gets the boundaries looked up one at a time. */
+    for (i = 0; i < n_periods; i++)
+    {
+        if (starts[i] > ends[i] || (i > 0 && ends[i - 1] > starts[i]))
+        {
+            for (i = 0; i < n_periods; i++)
+                changes[i] = xaccAccountGetBalanceChangeForPeriod (
+                                 acc, starts[i], ends[i], recurse);
+            return;
+        }
+    }
+
+    dates = g_new (time64, 2 * n_periods);
+    totals = g_new (gnc_numeric, 2 * n_periods);
+    for (i = 0; i < n_periods; i++)
+    {
+        dates[2 * i] = starts[i];
+        dates[2 * i + 1] = ends[i];
+    }
+
+    xaccAccountGetBalancesAsOfDates (acc, dates, 2 * n_periods, totals);
+    if (recurse)
+    {
+        cb.currency = xaccAccountGetCommodity (acc);
+        cb.dates = dates;
+        cb.n_dates = 2 * n_periods;
+        cb.scratch = g_new (gnc_numeric, 2 * n_periods);
+        cb.totals = totals;
+        gnc_account_foreach_descendant (acc, xaccAccountBalancesAsOfDatesHelper,
+                                        &cb);
+        g_free (cb.scratch);
+    }
+
+    for (i = 0; i < n_periods; i++)
+        changes[i] = gnc_numeric_sub (totals[2 * i + 1], totals[2 * i],
+                                      GNC_DENOM_AUTO, GNC_HOW_DENOM_FIXED);
+    g_free (dates);
+    g_free (totals);
+}
+
+/********************************************************************\
+ * Whole-tree balance snapshots                                     *
+\********************************************************************/
+
+typedef struct
+{
+    Account *account;
+    gnc_numeric start;
+    gnc_numeric end;
+    gnc_numeric report_start;
+    gnc_numeric report_end;
+    gnc_numeric total_start;
+    gnc_numeric total_end;
+} AccountBalancesEntry;
+
+struct gnc_account_balances_s
+{
+    GArray *entries;            /* AccountBalancesEntry */
+    GHashTable *index;          /* Account -> entry index + 1 */
+    gnc_commodity *report_commodity;
+};
+
+static void
+gnc_account_balances_add (GncAccountBalances *snapshot, Account *acc,
+                          const time64 *dates, gboolean report)
+{
+    AccountPrivate *priv = GET_PRIVATE(acc);
+    AccountBalancesEntry entry;
+    gnc_numeric balances[2];
+    int fraction = 0;
+    guint pos;
+    GList *node;
+
+    if (dates[0] <= dates[1])
+        xaccAccountGetBalancesAsOfDates (acc, dates, 2, balances);
+    else
+    {
+        balances[0] = xaccAccountGetBalanceAsOfDate (acc, dates[0]);
+        balances[1] = xaccAccountGetBalanceAsOfDate (acc, dates[1]);
+    }
+    entry.account = acc;
+    entry.start = balances[0];
+    entry.end = balances[1];
+    entry.report_start = entry.report_end = gnc_numeric_zero();
+    if (report)
+    {
+        entry.report_start = xaccAccountConvertBalanceToCurrencyAsOfDate (
+                                 acc, entry.start, priv->commodity,
+                                 snapshot->report_commodity, dates[0]);
+        entry.report_end = xaccAccountConvertBalanceToCurrencyAsOfDate (
+                               acc, entry.end, priv->commodity,
+                               snapshot->report_commodity, dates[1]);
+        fraction = gnc_commodity_get_fraction (snapshot->report_commodity);
+    }
+    entry.total_start = entry.report_start;
+    entry.total_end = entry.report_end;
+
+    /* Append before descending so the entries come out in the order of
+     * gnc_account_get_descendants, parents first. */
+    pos = snapshot->entries->len;
+    g_array_append_val (snapshot->entries, entry);
+    g_hash_table_insert (snapshot->index, acc, GUINT_TO_POINTER(pos + 1));
+
+    for (node = priv->children; node; node = node->next)
+    {
+        AccountBalancesEntry *total, *child;
+        guint child_pos = snapshot->entries->len;
+
+        gnc_account_balances_add (snapshot, node->data, dates, report);
+        if (!report)
+            continue;
+
+        /* Only look the entries up now; the array may have moved. */
+        total = &g_array_index (snapshot->entries, AccountBalancesEntry, pos);
+        child = &g_array_index (snapshot->entries, AccountBalancesEntry,
+                                child_pos);
+        total->total_start = gnc_numeric_add (total->total_start,
+                                              child->total_start, fraction,
+                                              GNC_HOW_RND_ROUND_HALF_UP);
+        total->total_end = gnc_numeric_add (total->total_end,
+                                            child->total_end, fraction,
+                                            GNC_HOW_RND_ROUND_HALF_UP);
+    }
+}
+
+GncAccountBalances *
+gnc_account_balances_new (Account *root, time64 start, time64 end,
+                          gnc_commodity *report_commodity)
+{
+    GncAccountBalances *snapshot;
+    time64 dates[2];
+
+    g_return_val_if_fail (GNC_IS_ACCOUNT(root), NULL);
+
+    snapshot = g_new0 (GncAccountBalances, 1);
+    snapshot->entries = g_array_sized_new (FALSE, FALSE,
+                                           sizeof (AccountBalancesEntry),
+                                           gnc_account_n_descendants (root) + 1);
+    snapshot->index = g_hash_table_new (g_direct_hash, g_direct_equal);
+    snapshot->report_commodity = report_commodity;
+
+    dates[0] = start;
+    dates[1] = end;
+    gnc_account_balances_add (snapshot, root, dates,
+                              report_commodity != NULL);
+    return snapshot;
+}
+
+void
+gnc_account_balances_free (GncAccountBalances *snapshot)
+{
+    if (!snapshot)
+        return;
+    g_array_free (snapshot->entries, TRUE);
+    g_hash_table_destroy (snapshot->index);
+    g_free (snapshot);
+}
+
+static const AccountBalancesEntry *
+gnc_account_balances_lookup (const GncAccountBalances *snapshot,
+                             const Account *acc)
+{
+    guint pos;
+
+    g_return_val_if_fail (snapshot, NULL);
+    pos = GPOINTER_TO_UINT(g_hash_table_lookup (snapshot->index, acc));
+    if (!pos)
+    {
+        PWARN ("account %s is not in the snapshot",
+               acc ? xaccAccountGetName (acc) : "(null)");
+        return NULL;
+    }
+    return &g_array_index (snapshot->entries, AccountBalancesEntry, pos - 1);
+}
+
+guint
+gnc_account_balances_get_n_accounts (const GncAccountBalances *snapshot)
+{
+    g_return_val_if_fail (snapshot, 0);
+    return snapshot->entries->len;
+}
+
+Account *
+gnc_account_balances_get_nth_account (const GncAccountBalances *snapshot,
+                                      guint n)
+{
+    g_return_val_if_fail (snapshot, NULL);
+    g_return_val_if_fail (n < snapshot->entries->len, NULL);
+    return g_array_index (snapshot->entries, AccountBalancesEntry, n).account;
+}
+
+gnc_numeric
+gnc_account_balances_get_balance (const GncAccountBalances *snapshot,
+                                  const Account *acc, gboolean at_start)
+{
+    const AccountBalancesEntry *e = gnc_account_balances_lookup (snapshot, acc);
+
+    if (!e)
+        return gnc_numeric_zero();
+    return at_start ? e->start : e->end;
+}
+
+gnc_numeric
+gnc_account_balances_get_change (const GncAccountBalances *snapshot,
+                                 const Account *acc)
+{
+    const AccountBalancesEntry *e = gnc_account_balances_lookup (snapshot, acc);
+
+    if (!e)
+        return gnc_numeric_zero();
+    return gnc_numeric_sub (e->end, e->start, GNC_DENOM_AUTO,
+                            GNC_HOW_DENOM_FIXED);
+}
+
+gnc_numeric
+gnc_account_balances_get_report_balance (const GncAccountBalances *snapshot,
+                                         const Account *acc, gboolean at_start,
+                                         gboolean include_children)
+{
+    const AccountBalancesEntry *e = gnc_account_balances_lookup (snapshot, acc);
+
+    if (!e)
+        return gnc_numeric_zero();
+    if (include_children)
+        return at_start ? e->total_start : e->total_end;
+    return at_start ? e->report_start : e->report_end;
+}
+
+/********************************************************************\
+ * Tax report totals                                                *
+\********************************************************************/
+
+typedef struct
+{
+    guint lo;             /* first split in the period, in split_array */
+    guint hi;             /* one past the last */
+    gnc_numeric amount;
+} AccountTaxPeriod;
+
+struct gnc_account_tax_totals_s
+{
+    guint n_periods;
+    GPtrArray *accounts;
+    GArray *periods;      /* n_periods entries per account */
+    GHashTable *index;    /* account -> position in accounts + 1 */
+};
+
+typedef struct
+{
+    GncAccountTaxTotals *totals;
+    const time64 *starts;
+    const time64 *ends;
+} AccountTaxTotalsData;
 
-    g_return_val_if_fail(acc, gnc_numeric_zero());
-    if (!report_commodity)
-        report_commodity = xaccAccountGetCommodity (acc);
-    if (!report_commodity)
-        return gnc_numeric_zero();
+static void
+gnc_account_tax_totals_add (Account *acc, gpointer user_data)
+{
+    AccountTaxTotalsData *data = user_data;
+    GncAccountTaxTotals *totals = data->totals;
+    AccountPrivate *priv;
+    gboolean from_source;
+    gnc_numeric start_bal, end_bal;
+    guint i;
 
-    balance = xaccAccountGetXxxBalanceAsOfDateInCurrency(
-                  acc, date, fn, report_commodity);
+    if (!xaccAccountGetTaxRelated (acc))
+        return;
 
-    /* If needed, sum up the children converting to the *requested*
-       commodity. */
-    if (include_children)
+    /* Not all of the splits may be in memory, the totals are then
+     * taken from the balance source and the splits are those which
+     * are. */
+    from_source = balance_source_p (acc);
+    if (!from_source)
     {
-#ifdef _MSC_VER
-        /* MSVC compiler: Somehow, the struct initialization containing a
-           gnc_numeric doesn't work. As an exception, we hand-initialize
-           that member afterwards. */
-        CurrencyBalance cb = { report_commodity, 0, NULL, fn, date };
-        cb.balance = balance;
-#else
-        CurrencyBalance cb = { report_commodity, balance, NULL, fn, date };
-#endif
-
-        gnc_account_foreach_descendant (acc, xaccAccountBalanceAsOfDateHelper, &cb);
-        balance = cb.balance;
+        xaccAccountSortSplits (acc, TRUE); /* just in case, normally a noop */
+        xaccAccountRecomputeBalance (acc); /* just in case, normally a noop */
     }
+    priv = GET_PRIVATE(acc);
+    gnc_account_build_date_index (priv);
 
-    return balance;
+    g_ptr_array_add (totals->accounts, acc);
+    g_hash_table_insert (totals->index, acc,
+                         GUINT_TO_POINTER(totals->accounts->len));
+
+    for (i = 0; i < totals->n_periods; i++)
+    {
+        AccountTaxPeriod period;
+
+        /* The period includes its end. */
+        period.lo = gnc_account_date_index_search (priv, data->starts[i]);
+        period.hi = gnc_account_date_index_search (priv, data->ends[i] + 1);
+        if (period.hi < period.lo)
+            period.hi = period.lo;
+
+        if (from_source)
+        {
+            start_bal = xaccAccountGetBalanceAsOfDate (acc, data->starts[i]);
+            end_bal = xaccAccountGetBalanceAsOfDate (acc, data->ends[i] + 1);
+            period.amount = gnc_numeric_sub (end_bal, start_bal, GNC_DENOM_AUTO,
+                                             GNC_HOW_DENOM_FIXED);
+        }
+        else if (period.lo == period.hi)
+            period.amount = gnc_numeric_zero();
+        else
+        {
+            /* The running balances make the sum of the period's amounts
+             * the difference of two of them. */
+            end_bal = xaccSplitGetBalance (
+                          g_ptr_array_index (priv->split_array, period.hi - 1));
+            start_bal = period.lo == 0 ? gnc_numeric_zero() :
+                        xaccSplitGetBalance (
+                            g_ptr_array_index (priv->split_array, period.lo - 1));
+            period.amount = gnc_numeric_sub (end_bal, start_bal, GNC_DENOM_AUTO,
+                                             GNC_HOW_DENOM_FIXED);
+        }
+        g_array_append_val (totals->periods, period);
+    }
 }
 
-gnc_numeric
-xaccAccountGetBalanceInCurrency (const Account *acc,
-                                 const gnc_commodity *report_commodity,
-                                 gboolean include_children)
+GncAccountTaxTotals *
+gnc_account_tax_totals_new (Account *root, const time64 *starts,
+                            const time64 *ends, guint n_periods)
 {
-    gnc_numeric rc;
-    rc = xaccAccountGetXxxBalanceInCurrencyRecursive (
-             acc, xaccAccountGetBalance, report_commodity, include_children);
-    PINFO(" baln=%" G_GINT64_FORMAT "/%" G_GINT64_FORMAT, rc.num, rc.denom);
-    return rc;
+    GncAccountTaxTotals *totals;
+    AccountTaxTotalsData data;
+
+    g_return_val_if_fail (GNC_IS_ACCOUNT(root), NULL);
+    g_return_val_if_fail (n_periods == 0 || (starts && ends), NULL);
+
+    totals = g_new0 (GncAccountTaxTotals, 1);
+    totals->n_periods = n_periods;
+    totals->accounts = g_ptr_array_new ();
+    totals->periods = g_array_new (FALSE, FALSE, sizeof (AccountTaxPeriod));
+    totals->index = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+    data.totals = totals;
+    data.starts = starts;
+    data.ends = ends;
+    gnc_account_tax_totals_add (root, &data);
+    gnc_account_foreach_descendant (root, gnc_account_tax_totals_add, &data);
+    return totals;
 }
 
+void
+gnc_account_tax_totals_free (GncAccountTaxTotals *totals)
+{
+    if (!totals)
+        return;
+    g_ptr_array_free (totals->accounts, TRUE);
+    g_array_free (totals->periods, TRUE);
+    g_hash_table_destroy (totals->index);
+    g_free (totals);
+}
 
-gnc_numeric
-xaccAccountGetClearedBalanceInCurrency (const Account *acc,
-                                        const gnc_commodity *report_commodity,
-                                        gboolean include_children)
+guint
+gnc_account_tax_totals_get_n_accounts (const GncAccountTaxTotals *totals)
 {
-    return xaccAccountGetXxxBalanceInCurrencyRecursive (
-               acc, xaccAccountGetClearedBalance, report_commodity,
-               include_children);
+    g_return_val_if_fail (totals, 0);
+    return totals->accounts->len;
 }
 
-gnc_numeric
-xaccAccountGetReconciledBalanceInCurrency (const Account *acc,
-        const gnc_commodity *report_commodity,
-        gboolean include_children)
+Account *
+gnc_account_tax_totals_get_nth_account (const GncAccountTaxTotals *totals,
+                                        guint n)
 {
-    return xaccAccountGetXxxBalanceInCurrencyRecursive (
-               acc, xaccAccountGetReconciledBalance, report_commodity,
-               include_children);
+    g_return_val_if_fail (totals, NULL);
+    g_return_val_if_fail (n < totals->accounts->len, NULL);
+    return g_ptr_array_index (totals->accounts, n);
 }
 
-gnc_numeric
-xaccAccountGetPresentBalanceInCurrency (const Account *acc,
-                                        const gnc_commodity *report_commodity,
-                                        gboolean include_children)
+static const AccountTaxPeriod *
+gnc_account_tax_totals_lookup (const GncAccountTaxTotals *totals,
+                               const Account *acc, guint period)
 {
-    return xaccAccountGetXxxBalanceInCurrencyRecursive (
-               acc, xaccAccountGetPresentBalance, report_commodity,
-               include_children);
+    guint pos;
+
+    g_return_val_if_fail (totals, NULL);
+    g_return_val_if_fail (period < totals->n_periods, NULL);
+    pos = GPOINTER_TO_UINT(g_hash_table_lookup (totals->index, acc));
+    if (!pos)
+        return NULL;
+    return &g_array_index (totals->periods, AccountTaxPeriod,
+                           (pos - 1) * totals->n_periods + period);
 }
 
 gnc_numeric
-xaccAccountGetProjectedMinimumBalanceInCurrency (
-    const Account *acc,
-    const gnc_commodity *report_commodity,
-    gboolean include_children)
+gnc_account_tax_totals_get_amount (const GncAccountTaxTotals *totals,
+                                   const Account *acc, guint period)
 {
-    return xaccAccountGetXxxBalanceInCurrencyRecursive (
-               acc, xaccAccountGetProjectedMinimumBalance, report_commodity,
-               include_children);
+    const AccountTaxPeriod *p = gnc_account_tax_totals_lookup (totals, acc,
+                                                               period);
+    return p ? p->amount : gnc_numeric_zero();
 }
 
-gnc_numeric
-xaccAccountGetBalanceAsOfDateInCurrency(
-    Account *acc, time64 date, gnc_commodity *report_commodity,
-    gboolean include_children)
+guint
+gnc_account_tax_totals_get_n_splits (const GncAccountTaxTotals *totals,
+                                     const Account *acc, guint period)
 {
-    return xaccAccountGetXxxBalanceAsOfDateInCurrencyRecursive (
-               acc, date, xaccAccountGetBalanceAsOfDate, report_commodity,
-               include_children);
+    const AccountTaxPeriod *p = gnc_account_tax_totals_lookup (totals, acc,
+                                                               period);
+    return p ? p->hi - p->lo : 0;
 }
 
-gnc_numeric
-xaccAccountGetBalanceChangeForPeriod (Account *acc, time64 t1, time64 t2,
-                                      gboolean recurse)
+SplitList *
+gnc_account_tax_totals_get_splits (const GncAccountTaxTotals *totals,
+                                   const Account *acc, guint period)
 {
-    gnc_numeric b1, b2;
+    const AccountTaxPeriod *p = gnc_account_tax_totals_lookup (totals, acc,
+                                                               period);
+    GPtrArray *split_array;
+    GList *splits = NULL;
+    guint i;
 
-    b1 = xaccAccountGetBalanceAsOfDateInCurrency(acc, t1, NULL, recurse);
-    b2 = xaccAccountGetBalanceAsOfDateInCurrency(acc, t2, NULL, recurse);
-    return gnc_numeric_sub(b2, b1, GNC_DENOM_AUTO, GNC_HOW_DENOM_FIXED);
+    if (!p)
+        return NULL;
+    split_array = GET_PRIVATE(acc)->split_array;
+    for (i = MIN (p->hi, split_array->len); i > p->lo; i--)
+        splits = g_list_prepend (splits, g_ptr_array_index (split_array, i - 1));
+    return splits;
 }
 
 
@@ -3736,7 +5289,7 @@ xaccAccountCountSplits (const Account *acc, gboolean include_children)
     nr = 0;
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), 0);
 
-    nr = g_list_length(xaccAccountGetSplitList(acc));
+    nr = GET_PRIVATE(acc)->split_array->len;
     if (include_children && (gnc_account_n_children(acc) != 0))
     {
         for (i=0; i < gnc_account_n_children(acc); i++)
@@ -4478,10 +6031,10 @@ xaccAccountSetAutoInterestXfer (Account *acc, gboolean option)
 const char *
 xaccAccountGetLastNum (const Account *acc)
 {
-    GValue v = G_VALUE_INIT;
+    static const gchar *keys[] = {"last-num"};
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), FALSE);
-    qof_instance_get_kvp (QOF_INSTANCE(acc), "last-num", &v);
-    return G_VALUE_HOLDS_STRING (&v) ? g_value_get_string (&v) : NULL;
+    return qof_instance_get_kvp_string (QOF_INSTANCE (acc),
+                                        G_N_ELEMENTS (keys), keys);
 }
 
 /********************************************************************\
@@ -4696,53 +6249,171 @@ xaccAccountGetReconcileChildrenStatus(const Account *acc)
 /********************************************************************\
 \********************************************************************/
 
-/* The caller of this function can get back one or both of the
- * matching split and transaction pointers, depending on whether
- * a valid pointer to the location to store those pointers is
- * passed.
- */
+/* The value of an index entry that has to be looked up again. */
+static char text_index_stale_marker;
+#define TEXT_INDEX_STALE ((gpointer) &text_index_stale_marker)
+
+static void
+text_index_clear (AccountPrivate *priv)
+{
+    if (priv->desc_index)
+        g_hash_table_destroy (priv->desc_index);
+    if (priv->memo_index)
+        g_hash_table_destroy (priv->memo_index);
+    priv->desc_index = priv->memo_index = NULL;
+}
+
+static gboolean
+trans_has_desc (const Transaction *trans, const char *description)
+{
+    return g_strcmp0 (description, xaccTransGetDescription (trans)) == 0;
+}
+
+static gboolean
+trans_has_memo (const Transaction *trans, const char *memo)
+{
+    GList *node;
+
+    for (node = xaccTransGetSplitList (trans); node; node = node->next)
+        if (g_strcmp0 (memo, xaccSplitGetMemo (node->data)) == 0)
+            return TRUE;
+    return FALSE;
+}
+
+/* Point @a text at @a split if its transaction is more recent than the
+ * one the entry has.  A commit of the entry's own transaction may have
+ * moved it back in the account, so that makes the entry stale. */
+static void
+text_index_note (GHashTable *index, const char *text, Split *split,
+                 gboolean use_num)
+{
+    Split *old;
+
+    if (!text || !*text)
+        return;
+    old = g_hash_table_lookup (index, text);
+    if (!old)
+        g_hash_table_insert (index, g_strdup (text), split);
+    else if (old == TEXT_INDEX_STALE)
+        return;
+    else if (old->parent == split->parent)
+        g_hash_table_replace (index, g_strdup (text), TEXT_INDEX_STALE);
+    else if (xaccSplitOrderNumSource (old, split, use_num) < 0)
+        g_hash_table_replace (index, g_strdup (text), split);
+}
+
 static void
-finder_help_function(const Account *acc, const char *description,
-                     Split **split, Transaction **trans )
+text_index_build (Account *acc, AccountPrivate *priv)
+{
+    guint i;
+
+    priv->desc_index = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                              g_free, NULL);
+    priv->memo_index = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                              g_free, NULL);
+    /* In account order, so the most recent transaction wins. */
+    for (i = 0; i < priv->split_array->len; i++)
+    {
+        Split *split = g_ptr_array_index (priv->split_array, i);
+        const char *text = xaccTransGetDescription (split->parent);
+        GList *node;
+
+        if (text && *text)
+            g_hash_table_replace (priv->desc_index, g_strdup (text), split);
+        for (node = xaccTransGetSplitList (split->parent); node;
+                node = node->next)
+        {
+            text = xaccSplitGetMemo (node->data);
+            if (text && *text)
+                g_hash_table_replace (priv->memo_index, g_strdup (text),
+                                      split);
+        }
+    }
+}
+
+void
+gnc_account_trans_text_committed (Account *acc, Split *split)
 {
     AccountPrivate *priv;
-    GList *slp;
+    gboolean use_num;
+    GList *node;
 
-    /* First, make sure we set the data to NULL BEFORE we start */
-    if (split) *split = NULL;
-    if (trans) *trans = NULL;
+    g_return_if_fail (GNC_IS_ACCOUNT (acc));
+    g_return_if_fail (GNC_IS_SPLIT (split));
 
-    /* Then see if we have any work to do */
-    if (acc == NULL) return;
+    priv = GET_PRIVATE (acc);
+    if (!priv->desc_index || split->acc != acc || !split->parent)
+        return;
 
-    /* Why is this loop iterated backwards ?? Presumably because the split
-     * list is in date order, and the most recent matches should be
-     * returned!?  */
-    priv = GET_PRIVATE(acc);
-    for (slp = g_list_last(priv->splits); slp; slp = slp->prev)
+    g_rec_mutex_lock (&account_cache_lock);
+    use_num = qof_book_use_split_action_for_num_field (gnc_account_get_book (acc));
+    text_index_note (priv->desc_index,
+                     xaccTransGetDescription (split->parent), split, use_num);
+    for (node = xaccTransGetSplitList (split->parent); node; node = node->next)
+        text_index_note (priv->memo_index, xaccSplitGetMemo (node->data),
+                         split, use_num);
+    g_rec_mutex_unlock (&account_cache_lock);
+}
+
+/* Scan from the end of the account, as the lookups did before there
+ * were indexes, for the most recent transaction matching @a text. */
+static Split *
+text_index_scan (AccountPrivate *priv, const char *text,
+                 gboolean (*matches) (const Transaction *, const char *))
+{
+    GList *slp;
+
+    for (slp = g_list_last (priv->splits); slp; slp = slp->prev)
     {
         Split *lsplit = slp->data;
-        Transaction *ltrans = xaccSplitGetParent(lsplit);
 
-        if (g_strcmp0 (description, xaccTransGetDescription (ltrans)) == 0)
-        {
-            if (split) *split = lsplit;
-            if (trans) *trans = ltrans;
-            return;
-        }
+        if (matches (xaccSplitGetParent (lsplit), text))
+            return lsplit;
     }
+    return NULL;
 }
 
-Split *
-xaccAccountFindSplitByDesc(const Account *acc, const char *description)
+static Split *
+text_index_lookup (const Account *acc, gboolean memo, const char *text)
 {
+    AccountPrivate *priv;
+    gboolean (*matches) (const Transaction *, const char *);
+    GHashTable *index;
     Split *split;
 
-    /* Get the split which has a transaction matching the description. */
-    finder_help_function(acc, description, &split, NULL);
+    if (acc == NULL) return NULL;
+
+    priv = GET_PRIVATE(acc);
+    matches = memo ? trans_has_memo : trans_has_desc;
+    /* Empty texts aren't indexed. */
+    if (!text || !*text)
+        return text_index_scan (priv, text, matches);
+
+    g_rec_mutex_lock (&account_cache_lock);
+    if (!priv->desc_index)
+        text_index_build ((Account *) acc, priv);
+    index = memo ? priv->memo_index : priv->desc_index;
+    split = g_hash_table_lookup (index, text);
+    if (split == TEXT_INDEX_STALE ||
+            (split && !matches (split->parent, text)))
+    {
+        split = text_index_scan (priv, text, matches);
+        if (split)
+            g_hash_table_replace (index, g_strdup (text), split);
+        else
+            g_hash_table_remove (index, text);
+    }
+    g_rec_mutex_unlock (&account_cache_lock);
     return split;
 }
 
+Split *
+xaccAccountFindSplitByDesc(const Account *acc, const char *description)
+{
+    /* Get the split which has a transaction matching the description. */
+    return text_index_lookup (acc, FALSE, description);
+}
+
 /* This routine is for finding a matching transaction in an account by
  * matching on the description field. [CAS: The rest of this comment
  * seems to belong somewhere else.] This routine is used for
@@ -4751,11 +6422,14 @@ xaccAccountFindSplitByDesc(const Account *acc, const char *description)
 Transaction *
 xaccAccountFindTransByDesc(const Account *acc, const char *description)
 {
-    Transaction *trans;
-
     /* Get the translation matching the description. */
-    finder_help_function(acc, description, NULL, &trans);
-    return trans;
+    return xaccSplitGetParent (text_index_lookup (acc, FALSE, description));
+}
+
+Transaction *
+xaccAccountFindTransByMemo(const Account *acc, const char *memo)
+{
+    return xaccSplitGetParent (text_index_lookup (acc, TRUE, memo));
 }
 
 /* ================================================================ */
@@ -4907,7 +6581,7 @@ static void do_one_split (Split *s, gpointer data)
 static void do_one_account (Account *account, gpointer data)
 {
     AccountPrivate *priv = GET_PRIVATE(account);
-    g_list_foreach(priv->splits, (GFunc)do_one_split, NULL);
+    g_ptr_array_foreach(priv->split_array, (GFunc)do_one_split, NULL);
 }
 
 /* Replacement for xaccGroupBeginStagedTransactionTraversals */
@@ -5061,19 +6735,17 @@ gnc_account_imap_find_account (GncImportMatchMap *imap,
                                const char *category,
                                const char *key)
 {
-    GValue v = G_VALUE_INIT;
-    GncGUID * guid = NULL;
-    char *kvp_path;
+    const GncGUID *guid;
+    const gchar *keys[] = {IMAP_FRAME, category, key};
+    guint n_keys = G_N_ELEMENTS (keys);
 
     if (!imap || !key) return NULL;
     if (!category)
-        kvp_path = g_strdup_printf (IMAP_FRAME "/%s", key);
-    else
-        kvp_path = g_strdup_printf (IMAP_FRAME "/%s/%s", category, key);
-    qof_instance_get_kvp (QOF_INSTANCE (imap->acc), kvp_path, &v);
-    if (G_VALUE_HOLDS_BOXED (&v))
-        guid = (GncGUID*)g_value_get_boxed (&v);
-    g_free (kvp_path);
+    {
+        keys[1] = key;
+        n_keys = 2;
+    }
+    guid = qof_instance_get_kvp_guid (QOF_INSTANCE (imap->acc), n_keys, keys);
     return xaccAccountLookup (guid, imap->book);
 }
 
@@ -5085,19 +6757,21 @@ gnc_account_imap_add_account (GncImportMatchMap *imap,
                               Account *acc)
 {
     GValue v = G_VALUE_INIT;
-    char *kvp_path;
+    const gchar *keys[] = {IMAP_FRAME, category, key};
+    guint n_keys = G_N_ELEMENTS (keys);
 
     if (!imap || !key || !acc || (strlen (key) == 0)) return;
     if (!category)
-        kvp_path = g_strdup_printf (IMAP_FRAME "/%s", key);
-    else
-        kvp_path = g_strdup_printf (IMAP_FRAME "/%s/%s", category, key);
+    {
+        keys[1] = key;
+        n_keys = 2;
+    }
 
     g_value_init (&v, GNC_TYPE_GUID);
     g_value_set_boxed (&v, xaccAccountGetGUID (acc));
     xaccAccountBeginEdit (imap->acc);
-    qof_instance_set_kvp (QOF_INSTANCE (imap->acc), kvp_path, &v);
-    g_free (kvp_path);
+    qof_instance_set_kvp_keys (QOF_INSTANCE (imap->acc), &v, n_keys, keys);
+    g_value_unset (&v);
     qof_instance_set_dirty (QOF_INSTANCE (imap->acc));
     xaccAccountCommitEdit (imap->acc);
 }
@@ -5182,6 +6856,66 @@ buildTokenInfo(const char *key, const GValue *value, gpointer data)
     tokenInfo->accounts = g_list_prepend(tokenInfo->accounts, this_account);
 }
 
+static void
+token_info_free (struct token_accounts_info *tokenInfo)
+{
+    GList *node;
+
+    for (node = tokenInfo->accounts; node; node = node->next)
+    {
+        struct account_token_count *account_c = node->data;
+        g_free (account_c->account_guid);
+        g_free (account_c);
+    }
+    g_list_free (tokenInfo->accounts);
+    g_free (tokenInfo);
+}
+
+static void
+gnc_account_imap_clear_bayes_index (AccountPrivate *priv)
+{
+    if (priv->imap_bayes_index)
+        g_hash_table_destroy (priv->imap_bayes_index);
+    priv->imap_bayes_index = NULL;
+}
+
+/** The accounts and total count recorded for a token, read from the
+ * account's import-map-bayes slots the first time the token is looked
+ * up and kept in the account's index after that. */
+static const struct token_accounts_info *
+imap_bayes_token_info (Account *acc, const char *token)
+{
+    AccountPrivate *priv = GET_PRIVATE (acc);
+    struct token_accounts_info *tokenInfo;
+    GList *node;
+    char *path;
+
+    if (priv->imap_bayes_index == NULL)
+        priv->imap_bayes_index =
+            g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                   (GDestroyNotify)token_info_free);
+
+    tokenInfo = g_hash_table_lookup (priv->imap_bayes_index, token);
+    if (tokenInfo)
+        return tokenInfo;
+
+    tokenInfo = g_new0 (struct token_accounts_info, 1);
+    path = g_strdup_printf (IMAP_FRAME_BAYES "/%s", token);
+    qof_instance_foreach_slot (QOF_INSTANCE (acc), path,
+                               buildTokenInfo, tokenInfo);
+    g_free (path);
+
+    /* The guids point into the slots; the index keeps its own copies. */
+    for (node = tokenInfo->accounts; node; node = node->next)
+    {
+        struct account_token_count *account_c = node->data;
+        account_c->account_guid = g_strdup (account_c->account_guid);
+    }
+
+    g_hash_table_insert (priv->imap_bayes_index, g_strdup (token), tokenInfo);
+    return tokenInfo;
+}
+
 /** intermediate values used to calculate the bayes probability of a given account
   where p(AB) = (a*b)/[a*b + (1-a)(1-b)], product is (a*b),
   product_difference is (1-a) * (1-b)
@@ -5263,8 +6997,9 @@ highestProbability(gpointer key, gpointer value, gpointer data)
 Account*
 gnc_account_imap_find_account_bayes (GncImportMatchMap *imap, GList *tokens)
 {
-    struct token_accounts_info tokenInfo; /**< holds the accounts and total
-                                           * token count for a single token */
+    const struct token_accounts_info *tokenInfo; /**< holds the accounts and
+                                           * total token count for a single
+                                           * token */
     GList *current_token;                 /**< pointer to the current
                                            * token from the input GList
                                            * tokens */
@@ -5298,25 +7033,18 @@ gnc_account_imap_find_account_bayes (GncImportMatchMap *imap, GList *tokens)
     for (current_token = tokens; current_token;
          current_token = current_token->next)
     {
-        char* path = g_strdup_printf (IMAP_FRAME_BAYES "/%s",
-                                            (char*)current_token->data);
-        /* zero out the token_accounts_info structure */
-        memset(&tokenInfo, 0, sizeof(struct token_accounts_info));
-
         PINFO("token: '%s'", (char*)current_token->data);
 
-        /* process the accounts for this token, adding the account if it
-         * doesn't already exist or adding to the existing accounts token
-         * count if it does
+        /* get the accounts for this token and their token counts from
+         * the account's index
          */
-        qof_instance_foreach_slot(QOF_INSTANCE (imap->acc), path,
-                                  buildTokenInfo, &tokenInfo);
-        g_free (path);
+        tokenInfo = imap_bayes_token_info (imap->acc,
+                                           (char*)current_token->data);
         /* for each account we have just found, see if the account
          * already exists in the list of account probabilities, if not
          * add it
          */
-        for (current_account_token = tokenInfo.accounts; current_account_token;
+        for (current_account_token = tokenInfo->accounts; current_account_token;
                 current_account_token = current_account_token->next)
         {
             /* get the account name and corresponding token count */
@@ -5326,7 +7054,7 @@ gnc_account_imap_find_account_bayes (GncImportMatchMap *imap, GList *tokens)
                   "account_c->token_count('%" G_GINT64_FORMAT
                   "')/total_count('%" G_GINT64_FORMAT "')",
                   account_c->account_guid, account_c->token_count,
-                  tokenInfo.total_count);
+                  tokenInfo->total_count);
 
             account_p = g_hash_table_lookup(running_probabilities,
                                             account_c->account_guid);
@@ -5337,11 +7065,11 @@ gnc_account_imap_find_account_bayes (GncImportMatchMap *imap, GList *tokens)
             if (account_p)
             {
                 account_p->product = (((double)account_c->token_count /
-                                      (double)tokenInfo.total_count)
+                                      (double)tokenInfo->total_count)
                                       * account_p->product);
                 account_p->product_difference =
                     ((double)1 - ((double)account_c->token_count /
-                                  (double)tokenInfo.total_count))
+                                  (double)tokenInfo->total_count))
                     * account_p->product_difference;
                 PINFO("product == %f, product_difference == %f",
                       account_p->product, account_p->product_difference);
@@ -5355,10 +7083,10 @@ gnc_account_imap_find_account_bayes (GncImportMatchMap *imap, GList *tokens)
 
                 /* set the product and product difference values */
                 account_p->product = ((double)account_c->token_count /
-                                      (double)tokenInfo.total_count);
+                                      (double)tokenInfo->total_count);
                 account_p->product_difference =
                     (double)1 - ((double)account_c->token_count /
-                                 (double)tokenInfo.total_count);
+                                 (double)tokenInfo->total_count);
 
                 PINFO("product == %f, product_difference == %f",
                       account_p->product, account_p->product_difference);
@@ -5369,16 +7097,6 @@ gnc_account_imap_find_account_bayes (GncImportMatchMap *imap, GList *tokens)
                                     account_c->account_guid, account_p);
             }
         } /* for all accounts in tokenInfo */
-
-        /* free the data in tokenInfo */
-        for (current_account_token = tokenInfo.accounts; current_account_token;
-                current_account_token = current_account_token->next)
-        {
-            /* free up each struct account_token_count we allocated */
-            g_free((struct account_token_count*)current_account_token->data);
-        }
-
-        g_list_free(tokenInfo.accounts); /* free the accounts GList */
     }
 
     /* build a hash table of account names and their final probabilities
@@ -5520,6 +7238,11 @@ gnc_account_imap_add_account_bayes (GncImportMatchMap *imap,
         /* change the imap entry for the account */
         change_imap_entry (imap, kvp_path, token_count);
 
+        /* and have the index read the token's counts again */
+        if (GET_PRIVATE (imap->acc)->imap_bayes_index)
+            g_hash_table_remove (GET_PRIVATE (imap->acc)->imap_bayes_index,
+                                 current_token->data);
+
         g_free (kvp_path);
     }
 
@@ -5743,6 +7466,7 @@ gnc_account_delete_map_entry (Account *acc, char *full_category, gboolean empty)
             qof_instance_slot_delete_if_empty (QOF_INSTANCE(acc), kvp_path);
         else
             qof_instance_slot_delete (QOF_INSTANCE(acc), kvp_path);
+        gnc_account_imap_clear_bayes_index (GET_PRIVATE (acc));
 
         PINFO("Account is '%s', path is '%s'", xaccAccountGetName (acc), kvp_path);
 
@@ -5909,49 +7633,111 @@ convert_imap_account (Account *acc)
             g_free (imapInfo->count);
             g_free (imapInfo);
         }
+        gnc_account_imap_clear_bayes_index (GET_PRIVATE (acc));
     }
     g_free (acc_name);
     g_list_free (imap_list); // Free the List
 }
 
-void
-gnc_account_imap_convert_bayes (QofBook *book)
+#define IMAP_CONVERTED_BAYES "changed-bayesian-to-guid"
+
+struct GncImapBayesConversion
+{
+    QofBook *book;
+    GArray  *accounts;  /* GncGUID, looked up again when their turn comes */
+    guint    next;
+};
+
+GncImapBayesConversion *
+gnc_account_imap_convert_bayes_start (QofBook *book)
 {
-    Account      *root;
-    GList        *accts, *ptr;
-    gboolean      run_once = FALSE;
-    GValue        value_s = G_VALUE_INIT;
+    GncImapBayesConversion *conv;
+    GList   *accts, *ptr;
+    gboolean run_once = FALSE;
+    GValue   value_s = G_VALUE_INIT;
+
+    g_return_val_if_fail (book, NULL);
 
-    // get the run-once value
-    qof_instance_get_kvp (QOF_INSTANCE (book), "changed-bayesian-to-guid", &value_s);
+    // get the run-once value, which kvp keeps as the string "true"
+    qof_instance_get_kvp (QOF_INSTANCE (book), IMAP_CONVERTED_BAYES, &value_s);
 
-    if (G_VALUE_HOLDS_STRING (&value_s) && (strcmp(g_value_get_string (&value_s), "true") == 0))
+    if (G_VALUE_HOLDS_STRING (&value_s) && (g_strcmp0 (g_value_get_string (&value_s), "true") == 0))
         run_once = TRUE;
+    if (G_IS_VALUE (&value_s))
+        g_value_unset (&value_s);
 
-    if (run_once == FALSE)
-    {
-        GValue value_b = G_VALUE_INIT;
+    if (run_once)
+        return NULL;
 
-        /* Get list of Accounts */
-        root = gnc_book_get_root_account (book);
-        accts = gnc_account_get_descendants_sorted (root);
+    conv = g_new0 (GncImapBayesConversion, 1);
+    conv->book = book;
+    conv->accounts = g_array_new (FALSE, FALSE, sizeof (GncGUID));
 
-        /* Go through list of accounts */
-        for (ptr = accts; ptr; ptr = g_list_next (ptr))
-        {
-            Account *acc = ptr->data;
+    /* Get list of Accounts */
+    accts = gnc_account_get_descendants_sorted (gnc_book_get_root_account (book));
+    for (ptr = accts; ptr; ptr = g_list_next (ptr))
+        g_array_append_val (conv->accounts, *xaccAccountGetGUID (ptr->data));
+    g_list_free (accts);
 
-            convert_imap_account (acc);
-        }
-        g_list_free (accts);
+    return conv;
+}
 
-        g_value_init (&value_b, G_TYPE_BOOLEAN);
+gboolean
+gnc_account_imap_convert_bayes_step (GncImapBayesConversion *conv,
+                                     guint n_accounts)
+{
+    GValue value_b = G_VALUE_INIT;
+    QofBook *book;
 
-        g_value_set_boolean (&value_b, TRUE);
+    g_return_val_if_fail (conv, FALSE);
 
-        // set the run-once value
-        qof_instance_set_kvp (QOF_INSTANCE (book), "changed-bayesian-to-guid", &value_b);
+    /* Go through the next accounts, those deleted since the start aside */
+    for (; n_accounts > 0 && conv->next < conv->accounts->len; n_accounts--)
+    {
+        Account *acc = xaccAccountLookup (&g_array_index (conv->accounts,
+                                                          GncGUID,
+                                                          conv->next++),
+                                          conv->book);
+        if (acc)
+            convert_imap_account (acc);
     }
+    if (conv->next < conv->accounts->len)
+        return TRUE;
+
+    /* Set the run-once value.  It has to be committed like any other
+     * change to the book, or every open of the book would convert again. */
+    book = conv->book;
+    gnc_account_imap_convert_bayes_cancel (conv);
+
+    g_value_init (&value_b, G_TYPE_BOOLEAN);
+    g_value_set_boolean (&value_b, TRUE);
+
+    qof_book_begin_edit (book);
+    qof_instance_set_kvp (QOF_INSTANCE (book), IMAP_CONVERTED_BAYES, &value_b);
+    qof_instance_set_dirty (QOF_INSTANCE (book));
+    qof_book_commit_edit (book);
+    g_value_unset (&value_b);
+
+    return FALSE;
+}
+
+void
+gnc_account_imap_convert_bayes_cancel (GncImapBayesConversion *conv)
+{
+    if (!conv)
+        return;
+    g_array_free (conv->accounts, TRUE);
+    g_free (conv);
+}
+
+void
+gnc_account_imap_convert_bayes (QofBook *book)
+{
+    GncImapBayesConversion *conv;
+
+    conv = gnc_account_imap_convert_bayes_start (book);
+    if (conv)
+        (void)gnc_account_imap_convert_bayes_step (conv, G_MAXUINT);
 }
 
 
@@ -241,6 +241,59 @@ void gnc_set_account_separator (const gchar *separator);
 Account *gnc_book_get_root_account(QofBook *book);
 void gnc_book_set_root_account(QofBook *book, Account *root);
 
+/** Start a bulk ingestion session on the book, for importers that are
+ *  about to commit many transactions.  Until the matching
+ *  gnc_book_end_bulk_ingest() every account that exists in the book
+ *  when the session starts is held open for editing: splits committed
+ *  into it are neither sorted nor have their running balances
+ *  recomputed, so account balances read during the session may be
+ *  stale.  xaccAccountGetSplitList() still returns a sorted list.
+ *
+ *  Sessions nest; only the outermost pair has any effect.  Every call
+ *  must be matched by a call to gnc_book_end_bulk_ingest(), also when
+ *  the import fails part way: anything committed or rolled back by
+ *  then is consistent once the session ends.
+ */
+void gnc_book_begin_bulk_ingest (QofBook *book);
+
+/** End a bulk ingestion session started by gnc_book_begin_bulk_ingest().
+ *  Each account is sorted and has its balances recomputed once. */
+void gnc_book_end_bulk_ingest (QofBook *book);
+
+/** @return TRUE if a bulk ingestion session is in progress on the book. */
+gboolean gnc_book_in_bulk_ingest (QofBook *book);
+
+/** Where a transaction stands when an account's splits are loaded a page
+ *  at a time: pages are ordered by the date posted, then the date
+ *  entered, then the GUID of the transaction. */
+typedef struct
+{
+    time64 date_posted;
+    time64 date_entered;
+    GncGUID trans_guid;
+} GncSplitPageKey;
+
+/** @return TRUE if the book's backend leaves transactions out of memory
+ *  and can load them a page at a time with gnc_book_load_split_page(). */
+gboolean gnc_book_has_split_pages (const QofBook *book);
+
+/** Load the latest n transactions with splits in the accounts which come
+ *  before the key, or the latest n of all if before is NULL.
+ *
+ *  @param book The book
+ *  @param accounts The accounts whose splits are paged through
+ *  @param before The key of the earliest transaction of the last page,
+ *  or NULL for the first page
+ *  @param n The number of transactions to load
+ *  @param first Set to the key of the earliest transaction loaded, when
+ *  there was one
+ *  @return The number of transactions loaded, less than n once there are
+ *  no more, or -1 if the book can't load pages.
+ */
+gint gnc_book_load_split_page (QofBook *book, GList *accounts,
+                               const GncSplitPageKey *before, gint n,
+                               GncSplitPageKey *first);
+
 /** @deprecated */
 #define xaccAccountGetGUID(X)     qof_entity_get_guid(QOF_INSTANCE(X))
 #define xaccAccountReturnGUID(X) (X ? *(qof_entity_get_guid(QOF_INSTANCE(X))) : *(guid_null()))
@@ -554,6 +607,12 @@ gnc_numeric xaccAccountGetProjectedMinimumBalance (const Account *account);
 /** Get the balance of the account as of the date specified */
 gnc_numeric xaccAccountGetBalanceAsOfDate (Account *account,
         time64 date);
+/** Get the balance of the account as of each of the dates specified,
+ *  as xaccAccountGetBalanceAsOfDate would, but walking the account's
+ *  splits only once.  The dates must be in increasing order.
+ *  @param balances Receives n_dates values. */
+void xaccAccountGetBalancesAsOfDates (Account *account, const time64 *dates,
+                                      guint n_dates, gnc_numeric *balances);
 
 /* These two functions convert a given balance from one commodity to
    another.  The account argument is only used to get the Book, and
@@ -601,6 +660,110 @@ gnc_numeric xaccAccountGetBalanceAsOfDateInCurrency(
 gnc_numeric xaccAccountGetBalanceChangeForPeriod (
     Account *acc, time64 date1, time64 date2, gboolean recurse);
 
+/** Get the balance change of the account over each of a run of
+ *  periods, as xaccAccountGetBalanceChangeForPeriod would for
+ *  starts[i] and ends[i], but walking the splits of each account only
+ *  once.  The periods should be in order and not overlap; otherwise
+ *  each one is computed separately.
+ *  @param changes Receives n_periods values. */
+void xaccAccountGetBalanceChangesForPeriods (
+    Account *acc, const time64 *starts, const time64 *ends, guint n_periods,
+    gboolean recurse, gnc_numeric *changes);
+
+/** Turn the caching of recursive balances on or off.
+ *
+ *  When enabled, the result of xaccAccountGetBalanceInCurrency,
+ *  xaccAccountGetClearedBalanceInCurrency,
+ *  xaccAccountGetReconciledBalanceInCurrency and
+ *  xaccAccountGetBalanceAsOfDateInCurrency with include_children set
+ *  is remembered per account and report commodity.  The cached value
+ *  is dropped when the balance of the account or any of its
+ *  descendants changes, when the account tree below it changes, or
+ *  when any price is added, removed or modified.  The cache is off by
+ *  default.  Hit rates are logged at the INFO level of the
+ *  gnc.account log module when the cache is turned off.
+ *
+ *  @param enabled TRUE to turn the cache on, FALSE to turn it off and
+ *  discard what has been cached. */
+void gnc_account_set_balance_rollup_cache (gboolean enabled);
+
+/** A snapshot of the balances of every account in a tree at the start
+ *  and end of a period, for reports that show many accounts at once. */
+typedef struct gnc_account_balances_s GncAccountBalances;
+
+/** Computes the balances of root and all its descendants as of start
+ *  and of end, as xaccAccountGetBalanceAsOfDate would, in one pass
+ *  over the tree.  Pass the same date twice for a single date.
+ *
+ *  If report_commodity is not NULL each balance is also converted into
+ *  it with the price nearest to its date, and the converted balances
+ *  are summed up the tree.
+ *
+ *  @return The snapshot, to be freed with gnc_account_balances_free(). */
+GncAccountBalances *gnc_account_balances_new (Account *root, time64 start,
+                                              time64 end,
+                                              gnc_commodity *report_commodity);
+void gnc_account_balances_free (GncAccountBalances *snapshot);
+
+/** The accounts of the snapshot, root first, each parent before its
+ *  children. */
+guint gnc_account_balances_get_n_accounts (const GncAccountBalances *snapshot);
+Account *gnc_account_balances_get_nth_account (
+    const GncAccountBalances *snapshot, guint n);
+
+/** The account's own balance in its commodity, at the start or the end
+ *  of the period. */
+gnc_numeric gnc_account_balances_get_balance (
+    const GncAccountBalances *snapshot, const Account *account,
+    gboolean at_start);
+/** The change in the account's own balance over the period. */
+gnc_numeric gnc_account_balances_get_change (
+    const GncAccountBalances *snapshot, const Account *account);
+/** The account's balance in the report commodity, with or without the
+ *  balances of its descendants.  Zero without a report commodity. */
+gnc_numeric gnc_account_balances_get_report_balance (
+    const GncAccountBalances *snapshot, const Account *account,
+    gboolean at_start, gboolean include_children);
+
+/** The totals of the tax related accounts of a tree over a number of
+ *  periods, and the splits behind them, for the tax reports. */
+typedef struct gnc_account_tax_totals_s GncAccountTaxTotals;
+
+/** Finds the accounts among root and its descendants which are marked
+ *  tax related, and for each of them the splits posted in each period
+ *  from starts[i] to ends[i], both included.  Each account's splits
+ *  are only searched, not walked, and the totals are taken from their
+ *  running balances.  The periods may overlap.
+ *
+ *  The snapshot must not be used after the splits of its accounts
+ *  change.
+ *
+ *  @return The snapshot, to be freed with gnc_account_tax_totals_free(). */
+GncAccountTaxTotals *gnc_account_tax_totals_new (Account *root,
+                                                 const time64 *starts,
+                                                 const time64 *ends,
+                                                 guint n_periods);
+void gnc_account_tax_totals_free (GncAccountTaxTotals *totals);
+
+/** The tax related accounts, root first, each parent before its
+ *  children. */
+guint gnc_account_tax_totals_get_n_accounts (const GncAccountTaxTotals *totals);
+Account *gnc_account_tax_totals_get_nth_account (
+    const GncAccountTaxTotals *totals, guint n);
+
+/** The sum of the amounts of the account's splits in the period, in the
+ *  account's commodity.  Zero for an account which is not tax related. */
+gnc_numeric gnc_account_tax_totals_get_amount (
+    const GncAccountTaxTotals *totals, const Account *account, guint period);
+/** The number of the account's splits in the period. */
+guint gnc_account_tax_totals_get_n_splits (
+    const GncAccountTaxTotals *totals, const Account *account, guint period);
+/** The account's splits in the period, in the order of
+ *  xaccAccountGetSplitList().  The list must be freed with g_list_free(),
+ *  the splits belong to the account. */
+SplitList *gnc_account_tax_totals_get_splits (
+    const GncAccountTaxTotals *totals, const Account *account, guint period);
+
 /** @} */
 
 /** @name Account Children and Parents.
@@ -691,6 +854,16 @@ gboolean gnc_account_is_root (const Account *account);
  *  list with the g_list_free() function. */
 GList *gnc_account_get_children (const Account *account);
 
+/** This routine returns the account's own list of its children
+ *  accounts, without copying it.  The list must not be modified or
+ *  freed, and is only valid until a child is added to or removed from
+ *  the account.
+ *
+ *  @param account The account whose children should be returned.
+ *
+ *  @return The account's GList of children, or NULL if it has none. */
+GList *gnc_account_peek_children (const Account *account);
+
 /** This routine returns a GList of all children accounts of the specified
  *  account, ordered by xaccAccountOrder().  \sa gnc_account_get_children()
  */
@@ -994,6 +1167,15 @@ gboolean xaccAccountIsEquityType(GNCAccountType t);
  */
 SplitList* xaccAccountGetSplitList (const Account *account);
 
+/** The xaccAccountGetUnreconciledSplits() routine returns a newly
+ *    allocated GList of the splits in the account which are not yet
+ *    reconciled, that is whose reconcile flag is NREC or CREC, in no
+ *    particular order.  The account keeps an index of these splits,
+ *    so this doesn't look at the others.  Free the list with
+ *    g_list_free().
+ */
+SplitList* xaccAccountGetUnreconciledSplits (const Account *account);
+
 
 /** The xaccAccountCountSplits() routine returns the number of all
  *    the splits in the account.
@@ -1048,6 +1230,12 @@ Transaction * xaccAccountFindTransByDesc(const Account *account,
 Split * xaccAccountFindSplitByDesc(const Account *account,
                                    const char *description);
 
+/** Returns the most recent transaction of the account having a split
+ *  whose memo is @a memo, or NULL if there is none.  Like the two
+ *  lookups above it is kept indexed for auto-filling registers. */
+Transaction * xaccAccountFindTransByMemo(const Account *account,
+        const char *memo);
+
 /** @} */
 
 /* ------------------ */
@@ -1442,10 +1630,31 @@ gchar *gnc_account_get_map_entry (Account *acc, const char *full_category);
 void gnc_account_delete_map_entry (Account *acc, char *full_category, gboolean empty);
 
 /** Search for Bayesian entries with mappings based on full account name and change
- *  them to be based on the account guid
+ *  them to be based on the account guid.  The book records that this was done, and
+ *  later calls return without looking at the accounts.
  */
 void gnc_account_imap_convert_bayes (QofBook *book);
 
+/** A conversion of Bayesian entries done a few accounts at a time. */
+typedef struct GncImapBayesConversion GncImapBayesConversion;
+
+/** Starts a gnc_account_imap_convert_bayes() of the book's accounts that is
+ *  carried out by gnc_account_imap_convert_bayes_step().
+ *
+ *  @return The conversion, or NULL if the book was converted already */
+GncImapBayesConversion *gnc_account_imap_convert_bayes_start (QofBook *book);
+
+/** Converts the entries of the next n_accounts accounts of a conversion.  After
+ *  the last account, records the conversion in the book and frees conv.
+ *
+ *  @return TRUE if accounts are left for another step */
+gboolean gnc_account_imap_convert_bayes_step (GncImapBayesConversion *conv,
+                                              guint n_accounts);
+
+/** Frees a conversion without finishing it.  It starts from the first account
+ *  again the next time. */
+void gnc_account_imap_convert_bayes_cancel (GncImapBayesConversion *conv);
+
 /** @} */
 
 
@@ -109,13 +109,90 @@ typedef struct AccountPrivate
     gnc_numeric reconciled_balance;
 
     gboolean balance_dirty;     /* balances in splits incorrect */
+    /* Index into split_array of the first split whose running balances
+     * are incorrect.  The splits before it still hold good running
+     * balances, so recomputation can restart from there.  Only
+     * meaningful while balance_dirty is set. */
+    guint balance_dirty_from;
 
     GList *splits;              /* list of split pointers */
     gboolean sort_dirty;        /* sort order of splits is bad */
+    /* Index into split_array of the first split that may be out of
+     * order.  The splits before it are still sorted among themselves,
+     * so sorting only needs to sort the rest and merge it in.  Only
+     * meaningful while sort_dirty is set. */
+    guint sort_dirty_from;
+
+    /* The same splits as above, in the same order, held in a
+     * contiguous array.  The engine's own traversals and the sort
+     * work on this array; the GList is kept in step with it for
+     * xaccAccountGetSplitList and the many callers that walk it. */
+    GPtrArray *split_array;
+
+    /* Date index used by xaccAccountGetBalanceAsOfDate: the posted
+     * date of each split's transaction, parallel to split_array, so
+     * that a cut-off date can be found by binary search.  It is
+     * rebuilt on demand and discarded whenever the splits are added,
+     * removed, re-sorted or marked dirty. */
+    time64 *date_index_dates;
+    guint date_index_len;
+    gboolean date_index_dirty;  /* date index must be rebuilt */
+
+    /* The account's full name as returned by gnc_account_get_full_name,
+     * valid while full_name_generation matches the account tree
+     * generation, i.e. until any account is renamed or moved or the
+     * separator changes. */
+    gchar *full_name;
+    guint full_name_generation;
+
+    /* Indexes from full name and from account code to the accounts
+     * below this one, used by gnc_account_lookup_by_full_name and
+     * gnc_account_lookup_by_code.  Only kept on root accounts and
+     * rebuilt on demand after any account is renamed, recoded, moved or
+     * destroyed, or the account separator changes. */
+    GHashTable *full_name_index;
+    GHashTable *code_index;
+    guint lookup_index_generation;
+
+    /* Cached recursive balances (this account plus all of its
+     * descendants) in some report commodity, see
+     * gnc_account_set_balance_rollup_cache.  Emptied whenever this
+     * account or any descendant has its balance invalidated. */
+    GList *rollup_cache;
 
     LotList   *lots;		/* list of lot pointers */
+    /* Index of the open lots usable by cap-gains lot selection: those
+     * with a non-zero opening split and a balance of the same sign.
+     * open_lots[0] holds lots opened by a positive split, open_lots[1]
+     * those opened by a negative one, each sorted by opening date.
+     * Lots that have changed since they were indexed wait in
+     * open_lots_pending until the next lookup.  Built on first use;
+     * NULL until then. */
+    GPtrArray *open_lots[2];
+    GPtrArray *open_lots_pending;
+    /* The splits whose reconcile flag is NREC or CREC, as a set.
+     * Built on first use; NULL until then. */
+    GHashTable *unreconciled_splits;
+    /* Indexes for register auto-completion: from a transaction
+     * description, and from the memo of any split of the account's
+     * transactions, to this account's split in the most recent
+     * transaction having it.  Transaction commits keep them up to date;
+     * an entry that may have gone out of date is marked stale and looked
+     * up again when it is next asked for.  Built on first use and
+     * dropped whenever a split leaves the account; NULL until then. */
+    GHashTable *desc_index;
+    GHashTable *memo_index;
     GNCPolicy *policy;		/* Cached pointer to policy method */
 
+    /* Index of the Bayesian import map stored under this account's
+     * import-map-bayes slots: for each token looked up so far, the
+     * accounts it was seen with, their counts and the token's total.
+     * Filled one token at a time by gnc_account_imap_find_account_bayes;
+     * a token's entry is dropped when gnc_account_imap_add_account_bayes
+     * counts it again, and the whole index when map entries are deleted
+     * or converted.  NULL until first use. */
+    GHashTable *imap_bayes_index;
+
     /* The "mark" flag can be used by the user to mark this account
      * in any way desired.  Handy for specialty traversals of the
      * account tree. */
@@ -132,6 +209,86 @@ struct account_s
  * call this on an existing account! */
 void xaccAccountSetGUID (Account *account, const GncGUID *guid);
 
+/* Tell the account that the split has been changed in a way that may
+ * affect its position in the account or the running balances from it
+ * onward.  This sets both the sort-dirty and balance-dirty flags, but
+ * lets the balances of the splits before it be kept. */
+void gnc_account_set_split_dirty (Account *acc, Split *split);
+
+/* Tell the account that the lot's splits, balance, opening date or
+ * owner may have changed, so that its open-lot index re-examines the
+ * lot. */
+void gnc_account_lot_changed (Account *acc, GNCLot *lot);
+
+/* Lot indexes kept outside the account, like the owner lot index in
+ * gncOwner.c, are told about the same changes through this hook.  It
+ * is also called with present FALSE when the lot leaves the account. */
+typedef void (*AccountLotChangedHook) (Account *acc, GNCLot *lot,
+                                       gboolean present);
+void gnc_account_set_lot_changed_hook (AccountLotChangedHook hook);
+
+/* Return the open lot in the account that was opened earliest (or
+ * latest, if latest is TRUE) by a split of the given sign in a
+ * transaction of the given currency, or NULL if there is none.
+ * Lots that are overfull, i.e. whose balance has the sign opposite to
+ * their opening split, are not returned.  A NULL currency matches all
+ * transactions. */
+GNCLot *gnc_account_find_open_lot (Account *acc, gboolean opening_positive,
+                                   gnc_commodity *currency, gboolean latest);
+
+/* A backend which leaves splits out of memory can keep balances for
+ * them and give them to the engine through a balance source set on the
+ * book.  balance_as_of sets *balance to the balance of the account's
+ * splits posted before date and returns TRUE, or returns FALSE when the
+ * splits in memory are to be used.  rebuild builds the balances again
+ * from scratch. */
+typedef struct
+{
+    gboolean (*balance_as_of) (const Account *acc, time64 date,
+                               gnc_numeric *balance, gpointer user_data);
+    void (*rebuild) (QofBook *book, gpointer user_data);
+} GncBalanceSource;
+
+/* Set the book's balance source, or with a NULL source remove it.  The
+ * source isn't copied and has to outlive its use. */
+void gnc_book_set_balance_source (QofBook *book,
+                                  const GncBalanceSource *source,
+                                  gpointer user_data);
+
+/* Rebuild the balances of the book's balance source, if it has one.
+ * Returns whether it did. */
+gboolean gnc_book_rebuild_balance_source (QofBook *book);
+
+/* A backend which leaves transactions out of memory can let registers
+ * load them a page at a time through a split page source set on the
+ * book.  load_page does what gnc_book_load_split_page() describes. */
+typedef struct
+{
+    gint (*load_page) (QofBook *book, GList *accounts,
+                       const GncSplitPageKey *before, gint n,
+                       GncSplitPageKey *first, gpointer user_data);
+} GncSplitPageSource;
+
+/* Set the book's split page source, or with a NULL source remove it.
+ * The source isn't copied and has to outlive its use. */
+void gnc_book_set_split_page_source (QofBook *book,
+                                     const GncSplitPageSource *source,
+                                     gpointer user_data);
+
+/* Tell the account that the split's reconcile flag may have changed,
+ * so that its index of unreconciled splits stays up to date. */
+void gnc_account_split_reconcile_changed (Account *acc, Split *split);
+
+/* Tell the account that the transaction of one of its splits has been
+ * committed, so that its auto-completion indexes take in the
+ * transaction's description and memos. */
+void gnc_account_trans_text_committed (Account *acc, Split *split);
+
+/* A number that changes whenever an account name, code or parent
+ * changes or an account is destroyed, so that whatever was worked out
+ * from the shape of the account tree can tell it is stale. */
+guint gnc_account_tree_generation (void);
+
 /* Register Accounts with the engine */
 gboolean xaccAccountRegister (void);
 
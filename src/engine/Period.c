@@ -0,0 +1,490 @@
+/********************************************************************\
+ * Period.c -- Move the transactions of closed periods into an      *
+ *             archive book                                         *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+\********************************************************************/
+
+#include "config.h"
+
+#include <glib.h>
+
+#include "Account.h"
+#include "Period.h"
+#include "Split.h"
+#include "Transaction.h"
+#include "gnc-commodity.h"
+#include <qofinstance-p.h>
+
+#undef G_LOG_DOMAIN
+#define G_LOG_DOMAIN "gnc.engine.period"
+
+static QofLogModule log_module = G_LOG_DOMAIN;
+
+#define ARCHIVE_URI_KVP "archive/uri"
+#define ARCHIVE_DATE_KVP "archive/date"
+#define ARCHIVE_SESSION_KEY "gnc-archive-session"
+
+/* ================================================================ */
+
+/* The twin of an account in the archive has the account's GUID, so
+ * a second archive run into the same book finds the twins of the
+ * first one. */
+static Account *
+archive_twin (Account *acc, QofBook *archive, GHashTable *twins)
+{
+    Account *twin, *parent;
+
+    twin = g_hash_table_lookup (twins, acc);
+    if (twin)
+        return twin;
+
+    if (gnc_account_is_root (acc))
+    {
+        twin = gnc_book_get_root_account (archive);
+        g_hash_table_insert (twins, acc, twin);
+        return twin;
+    }
+
+    twin = xaccAccountLookup (qof_instance_get_guid (acc), archive);
+    if (!twin)
+    {
+        parent = archive_twin (gnc_account_get_parent (acc), archive, twins);
+        twin = xaccCloneAccount (acc, archive);
+        xaccAccountBeginEdit (twin);
+        qof_instance_set_guid (twin, qof_instance_get_guid (acc));
+        gnc_account_append_child (parent, twin);
+        xaccAccountCommitEdit (twin);
+        qof_event_gen (QOF_INSTANCE (twin), QOF_EVENT_CREATE, NULL);
+    }
+    g_hash_table_insert (twins, acc, twin);
+    return twin;
+}
+
+static void
+archive_copy_trans (Transaction *trans, QofBook *archive, GHashTable *twins)
+{
+    Transaction *copy;
+    GList *node;
+
+    copy = xaccMallocTransaction (archive);
+    xaccTransBeginEdit (copy);
+    qof_instance_set_guid (copy, qof_instance_get_guid (trans));
+    xaccTransSetCurrency (copy, gnc_commodity_obtain_twin
+                          (xaccTransGetCurrency (trans), archive));
+    xaccTransSetNum (copy, xaccTransGetNum (trans));
+    xaccTransSetDescription (copy, xaccTransGetDescription (trans));
+    xaccTransSetDatePostedSecs (copy, xaccTransGetDate (trans));
+    xaccTransSetDateEnteredSecs (copy, xaccTransGetDateEntered (trans));
+    qof_instance_copy_kvp (QOF_INSTANCE (copy), QOF_INSTANCE (trans));
+
+    for (node = xaccTransGetSplitList (trans); node; node = node->next)
+    {
+        Split *split = node->data;
+        Split *s = xaccMallocSplit (archive);
+        Account *twin = archive_twin (xaccSplitGetAccount (split), archive,
+                                      twins);
+
+        qof_instance_set_guid (s, qof_instance_get_guid (split));
+        xaccSplitSetParent (s, copy);
+        xaccAccountBeginEdit (twin);
+        xaccSplitSetAccount (s, twin);
+        xaccSplitSetMemo (s, xaccSplitGetMemo (split));
+        xaccSplitSetAction (s, xaccSplitGetAction (split));
+        xaccSplitSetAmount (s, xaccSplitGetAmount (split));
+        xaccSplitSetValue (s, xaccSplitGetValue (split));
+        xaccSplitSetReconcile (s, xaccSplitGetReconcile (split));
+        xaccSplitSetDateReconciledSecs (s, xaccSplitGetDateReconciled (split));
+        qof_instance_copy_kvp (QOF_INSTANCE (s), QOF_INSTANCE (split));
+        xaccAccountCommitEdit (twin);
+    }
+    xaccTransCommitEdit (copy);
+}
+
+/* Anything that refers to a transaction from elsewhere in the book
+ * keeps it out of the archive: lots point at their splits, and
+ * invoices and payments at their transactions. */
+static gboolean
+archivable (const Transaction *trans, time64 before)
+{
+    GList *node;
+    char type;
+
+    if (xaccTransGetDate (trans) >= before || xaccTransIsOpen (trans))
+        return FALSE;
+    type = xaccTransGetTxnType (trans);
+    if (type == TXN_TYPE_INVOICE || type == TXN_TYPE_PAYMENT)
+        return FALSE;
+    for (node = xaccTransGetSplitList (trans); node; node = node->next)
+    {
+        Split *split = node->data;
+        if (!xaccSplitGetAccount (split) || xaccSplitGetLot (split))
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/* ================================================================ */
+/* The opening balances are summed per transaction currency and, in
+ * it, per account; the amounts are those of the account's commodity. */
+
+typedef struct
+{
+    gnc_numeric amount;
+    gnc_numeric value;
+} OpeningSplit;
+
+typedef struct
+{
+    gnc_commodity *currency;
+    GHashTable *accounts;
+    gnc_numeric total;
+} OpeningTrans;
+
+static void
+opening_trans_free (gpointer data)
+{
+    OpeningTrans *ot = data;
+
+    g_hash_table_destroy (ot->accounts);
+    g_free (ot);
+}
+
+static void
+opening_add_trans (GHashTable *openings, Transaction *trans)
+{
+    gnc_commodity *currency = xaccTransGetCurrency (trans);
+    OpeningTrans *ot;
+    GList *node;
+
+    ot = g_hash_table_lookup (openings, currency);
+    if (!ot)
+    {
+        ot = g_new0 (OpeningTrans, 1);
+        ot->currency = currency;
+        ot->accounts = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                              NULL, g_free);
+        ot->total = gnc_numeric_zero ();
+        g_hash_table_insert (openings, currency, ot);
+    }
+
+    for (node = xaccTransGetSplitList (trans); node; node = node->next)
+    {
+        Split *split = node->data;
+        Account *acc = xaccSplitGetAccount (split);
+        OpeningSplit *os = g_hash_table_lookup (ot->accounts, acc);
+
+        if (!os)
+        {
+            os = g_new0 (OpeningSplit, 1);
+            os->amount = gnc_numeric_zero ();
+            os->value = gnc_numeric_zero ();
+            g_hash_table_insert (ot->accounts, acc, os);
+        }
+        os->amount = gnc_numeric_add (os->amount, xaccSplitGetAmount (split),
+                                      GNC_DENOM_AUTO, GNC_HOW_DENOM_EXACT);
+        os->value = gnc_numeric_add (os->value, xaccSplitGetValue (split),
+                                     GNC_DENOM_AUTO, GNC_HOW_DENOM_EXACT);
+    }
+}
+
+/* The equity account for a currency, as the close book dialog picks
+ * it: the given account if it is in that currency, otherwise a child
+ * of it named after the currency. */
+static Account *
+opening_equity (Account *equity, gnc_commodity *currency)
+{
+    Account *acc;
+
+    if (gnc_commodity_equal (currency, xaccAccountGetCommodity (equity)))
+        return equity;
+
+    acc = gnc_account_lookup_by_name (equity,
+                                      gnc_commodity_get_mnemonic (currency));
+    if (acc)
+        return acc;
+
+    acc = xaccMallocAccount (gnc_account_get_book (equity));
+    xaccAccountBeginEdit (acc);
+    xaccAccountSetType (acc, ACCT_TYPE_EQUITY);
+    xaccAccountSetName (acc, gnc_commodity_get_mnemonic (currency));
+    xaccAccountSetDescription (acc, gnc_commodity_get_mnemonic (currency));
+    xaccAccountSetCommodity (acc, currency);
+    gnc_account_append_child (equity, acc);
+    xaccAccountCommitEdit (acc);
+    return acc;
+}
+
+typedef struct
+{
+    QofBook *book;
+    Transaction *trans;
+    OpeningTrans *ot;
+} OpeningData;
+
+static void
+opening_add_split (Account *acc, gnc_numeric amount, gnc_numeric value,
+                   OpeningData *od)
+{
+    Split *split = xaccMallocSplit (od->book);
+
+    xaccSplitSetParent (split, od->trans);
+    xaccAccountBeginEdit (acc);
+    xaccSplitSetAccount (split, acc);
+    xaccSplitSetAmount (split, amount);
+    xaccSplitSetValue (split, value);
+    xaccAccountCommitEdit (acc);
+}
+
+static void
+opening_split_cb (gpointer key, gpointer value, gpointer data)
+{
+    Account *acc = key;
+    OpeningSplit *os = value;
+    OpeningData *od = data;
+
+    if (gnc_numeric_zero_p (os->amount) && gnc_numeric_zero_p (os->value))
+        return;
+    opening_add_split (acc, os->amount, os->value, od);
+    od->ot->total = gnc_numeric_add (od->ot->total, os->value,
+                                     GNC_DENOM_AUTO, GNC_HOW_DENOM_EXACT);
+}
+
+static void
+opening_make_trans (QofBook *book, OpeningTrans *ot, Account *equity,
+                    time64 date, const char *description)
+{
+    OpeningData od;
+
+    od.book = book;
+    od.ot = ot;
+    od.trans = xaccMallocTransaction (book);
+    xaccTransBeginEdit (od.trans);
+    xaccTransSetCurrency (od.trans, ot->currency);
+    xaccTransSetDatePostedSecs (od.trans, date);
+    xaccTransSetDateEnteredSecs (od.trans, gnc_time (NULL));
+    xaccTransSetDescription (od.trans, description ? description : "");
+
+    g_hash_table_foreach (ot->accounts, opening_split_cb, &od);
+    if (!gnc_numeric_zero_p (ot->total))
+    {
+        gnc_numeric total = gnc_numeric_neg (ot->total);
+        opening_add_split (opening_equity (equity, ot->currency), total,
+                           total, &od);
+    }
+
+    if (xaccTransCountSplits (od.trans) == 0)
+        xaccTransDestroy (od.trans);
+    xaccTransCommitEdit (od.trans);
+}
+
+/* ================================================================ */
+
+gint
+gnc_book_archive_period (QofBook *book, QofSession *session, time64 before,
+                         Account *equity, const char *description)
+{
+    QofBook *archive;
+    GHashTable *seen, *twins, *openings;
+    GPtrArray *moved;
+    GList *accounts, *node;
+    GHashTableIter iter;
+    gpointer value;
+    guint i;
+
+    g_return_val_if_fail (QOF_IS_BOOK (book), -1);
+    g_return_val_if_fail (session != NULL, -1);
+    archive = qof_session_get_book (session);
+    g_return_val_if_fail (book != archive, -1);
+    g_return_val_if_fail (GNC_IS_ACCOUNT (equity), -1);
+    g_return_val_if_fail (gnc_account_get_book (equity) == book, -1);
+
+    ENTER ("book %p archive %p before %" G_GINT64_FORMAT, book, archive,
+           before);
+
+    /* Collect first: destroying transactions changes the split lists
+     * being walked. */
+    seen = g_hash_table_new (g_direct_hash, g_direct_equal);
+    moved = g_ptr_array_new ();
+    accounts = gnc_account_get_descendants (gnc_book_get_root_account (book));
+    for (node = accounts; node; node = node->next)
+    {
+        GList *snode;
+
+        for (snode = xaccAccountGetSplitList (node->data); snode;
+                snode = snode->next)
+        {
+            Transaction *trans = xaccSplitGetParent (snode->data);
+
+            /* The splits are in date order. */
+            if (xaccTransGetDate (trans) >= before)
+                break;
+            if (g_hash_table_lookup (seen, trans))
+                continue;
+            g_hash_table_insert (seen, trans, trans);
+            if (archivable (trans, before))
+                g_ptr_array_add (moved, trans);
+        }
+    }
+    g_list_free (accounts);
+    g_hash_table_destroy (seen);
+
+    twins = g_hash_table_new (g_direct_hash, g_direct_equal);
+    openings = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+                                      opening_trans_free);
+    for (i = 0; i < moved->len; i++)
+    {
+        Transaction *trans = g_ptr_array_index (moved, i);
+
+        archive_copy_trans (trans, archive, twins);
+        opening_add_trans (openings, trans);
+    }
+    g_hash_table_destroy (twins);
+
+    /* Nothing leaves the book unless the archive has it safe. */
+    qof_session_save (session, NULL);
+    if (qof_session_get_error (session) != ERR_BACKEND_NO_ERR)
+    {
+        PERR ("cannot save the archive: %s",
+              qof_session_get_error_message (session));
+        g_hash_table_destroy (openings);
+        g_ptr_array_free (moved, TRUE);
+        LEAVE ("");
+        return -1;
+    }
+
+    for (i = 0; i < moved->len; i++)
+    {
+        Transaction *trans = g_ptr_array_index (moved, i);
+
+        xaccTransBeginEdit (trans);
+        xaccTransDestroy (trans);
+        xaccTransCommitEdit (trans);
+    }
+
+    g_hash_table_iter_init (&iter, openings);
+    while (g_hash_table_iter_next (&iter, NULL, &value))
+        opening_make_trans (book, value, equity, before - 1, description);
+    g_hash_table_destroy (openings);
+
+    i = moved->len;
+    g_ptr_array_free (moved, TRUE);
+    LEAVE ("moved %u transactions", i);
+    return i;
+}
+
+/* ================================================================ */
+
+void
+gnc_book_set_archive (QofBook *book, const char *uri, time64 before)
+{
+    GValue v = G_VALUE_INIT;
+
+    g_return_if_fail (QOF_IS_BOOK (book));
+
+    qof_book_begin_edit (book);
+    if (uri && *uri)
+    {
+        g_value_init (&v, G_TYPE_STRING);
+        g_value_set_string (&v, uri);
+        qof_instance_set_kvp (QOF_INSTANCE (book), ARCHIVE_URI_KVP, &v);
+        g_value_unset (&v);
+        g_value_init (&v, G_TYPE_INT64);
+        g_value_set_int64 (&v, before);
+        qof_instance_set_kvp (QOF_INSTANCE (book), ARCHIVE_DATE_KVP, &v);
+    }
+    else
+    {
+        qof_instance_set_kvp (QOF_INSTANCE (book), ARCHIVE_URI_KVP, NULL);
+        qof_instance_set_kvp (QOF_INSTANCE (book), ARCHIVE_DATE_KVP, NULL);
+    }
+    qof_instance_set_dirty (QOF_INSTANCE (book));
+    qof_book_commit_edit (book);
+}
+
+const char *
+gnc_book_get_archive_uri (const QofBook *book)
+{
+    GValue v = G_VALUE_INIT;
+
+    g_return_val_if_fail (QOF_IS_BOOK (book), NULL);
+
+    qof_instance_get_kvp (QOF_INSTANCE (book), ARCHIVE_URI_KVP, &v);
+    if (G_VALUE_HOLDS_STRING (&v))
+        return g_value_get_string (&v);
+    return NULL;
+}
+
+time64
+gnc_book_get_archive_date (const QofBook *book)
+{
+    GValue v = G_VALUE_INIT;
+
+    g_return_val_if_fail (QOF_IS_BOOK (book), 0);
+
+    qof_instance_get_kvp (QOF_INSTANCE (book), ARCHIVE_DATE_KVP, &v);
+    if (G_VALUE_HOLDS_INT64 (&v))
+        return g_value_get_int64 (&v);
+    return 0;
+}
+
+static void
+archive_session_free (QofBook *book, gpointer key, gpointer data)
+{
+    QofSession *session = data;
+
+    qof_session_end (session);
+    qof_session_destroy (session);
+}
+
+QofBook *
+gnc_book_get_archive_book (QofBook *book, time64 date)
+{
+    QofSession *session;
+    const char *uri;
+
+    g_return_val_if_fail (QOF_IS_BOOK (book), NULL);
+
+    if (date >= gnc_book_get_archive_date (book))
+        return NULL;
+    session = qof_book_get_data (book, ARCHIVE_SESSION_KEY);
+    if (session)
+        return qof_session_get_book (session);
+    uri = gnc_book_get_archive_uri (book);
+    if (!uri)
+        return NULL;
+
+    ENTER ("book %p uri %s", book, uri);
+    session = qof_session_new ();
+    qof_session_begin (session, uri, TRUE, FALSE, FALSE);
+    if (qof_session_get_error (session) == ERR_BACKEND_NO_ERR)
+        qof_session_load (session, NULL);
+    if (qof_session_get_error (session) != ERR_BACKEND_NO_ERR)
+    {
+        PERR ("cannot open the archive %s: %s", uri,
+              qof_session_get_error_message (session));
+        qof_session_destroy (session);
+        LEAVE ("");
+        return NULL;
+    }
+    qof_book_mark_readonly (qof_session_get_book (session));
+    qof_book_set_data_fin (book, ARCHIVE_SESSION_KEY, session,
+                           archive_session_free);
+    LEAVE ("archive %p", qof_session_get_book (session));
+    return qof_session_get_book (session);
+}
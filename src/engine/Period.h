@@ -0,0 +1,83 @@
+/********************************************************************\
+ * Period.h -- Move the transactions of closed periods into an      *
+ *             archive book                                         *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+\********************************************************************/
+
+/** @addtogroup Engine
+    @{ */
+/** @file Period.h
+ *  @brief Archive the transactions of closed periods
+ *
+ * A book that has been kept for many years carries all of its history
+ * in memory.  Once a period is closed, its transactions can be moved
+ * into a separate archive book and replaced in the working book by
+ * opening balance transactions, so that the working book only grows
+ * with the open periods.  The archive keeps the GUIDs of the accounts,
+ * transactions and splits it was given, and is only loaded again when
+ * something asks for dates it covers.
+ */
+
+#ifndef XACC_PERIOD_H
+#define XACC_PERIOD_H
+
+#include "gnc-engine.h"
+
+/** Move the transactions of @a book posted before @a before into the
+ *  book of the archive @a session, and replace them in @a book by one
+ *  opening balance transaction per currency, posted a second before
+ *  @a before, which carries the sum of the moved splits of each
+ *  account.  Should the moved transactions not balance, the rest goes
+ *  to @a equity or, for other currencies, to a child of it named after
+ *  the currency.  The account tree is copied into the archive as
+ *  needed, so an archive can take several periods one after the
+ *  other.  The archive is saved before anything is removed from
+ *  @a book, and if that fails @a book is left alone.
+ *
+ *  Transactions with a split in a lot, invoice and payment
+ *  transactions and transactions open for editing are left where they
+ *  are, since other objects in @a book refer to them.
+ *
+ *  @return The number of transactions moved, or -1 if the archive could
+ *  not be saved or the arguments are bad.
+ */
+gint gnc_book_archive_period (QofBook *book, QofSession *session, time64 before,
+                              Account *equity, const char *description);
+
+/** Record in @a book that the transactions before @a before are in the
+ *  book at @a uri.  Setting a NULL @a uri forgets the archive. */
+void gnc_book_set_archive (QofBook *book, const char *uri, time64 before);
+
+/** @return The URI of the archive of @a book, or NULL if it has none. */
+const char *gnc_book_get_archive_uri (const QofBook *book);
+
+/** @return The date before which the transactions of @a book are in its
+ *  archive, or 0 if it has none. */
+time64 gnc_book_get_archive_date (const QofBook *book);
+
+/** Get the archive book of @a book if @a date falls in the archived
+ *  periods.  The archive is opened read only the first time it is
+ *  asked for and stays open until @a book is destroyed.
+ *
+ *  @return The archive book, or NULL if @a date is not archived or the
+ *  archive could not be opened. */
+QofBook *gnc_book_get_archive_book (QofBook *book, time64 date);
+
+#endif /* XACC_PERIOD_H */
+/** @} */
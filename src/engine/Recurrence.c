@@ -363,20 +363,163 @@ recurrenceNextInstance(const Recurrence *r, const GDate *ref, GDate *next)
     }
 }
 
-/* Zero-based index */
+/* Zero-based index.  The instance is computed directly from the start
+   date instead of by stepping through the n earlier occurrences; it
+   agrees with repeated recurrenceNextInstance() calls.  An invalid
+   date results for n > 0 on a PERIOD_ONCE recurrence. */
 void
 recurrenceNthInstance(const Recurrence *r, guint n, GDate *date)
 {
-    GDate ref;
-    guint i;
+    const GDate *start;
+    guint mult, dim, n_months;
+
+    g_return_if_fail(r);
+    g_return_if_fail(date);
+    g_return_if_fail(g_date_valid(&r->start));
+
+    start = &r->start;
+    *date = *start;
+    if (n == 0)
+        return;
 
-    for (*date = ref = r->start, i = 0; i < n; i++)
+    mult = r->mult;
+    switch (r->ptype)
     {
-        recurrenceNextInstance(r, &ref, date);
-        ref = *date;
+    case PERIOD_ONCE:
+        g_date_clear(date, 1);
+        break;
+    case PERIOD_WEEK:
+        mult *= 7;
+        /* fall through */
+    case PERIOD_DAY:
+        g_date_add_days(date, n * mult);
+        break;
+    case PERIOD_YEAR:
+        mult *= 12;
+        /* fall through */
+    case PERIOD_MONTH:
+    case PERIOD_NTH_WEEKDAY:
+    case PERIOD_LAST_WEEKDAY:
+    case PERIOD_END_OF_MONTH:
+        n_months = n * mult;
+        g_date_set_day(date, 1);
+        g_date_add_months(date, n_months);
+        dim = g_date_get_days_in_month(g_date_get_month(date),
+                                       g_date_get_year(date));
+        if (r->ptype == PERIOD_NTH_WEEKDAY || r->ptype == PERIOD_LAST_WEEKDAY)
+            g_date_add_days(date, nth_weekday_compare(start, date, r->ptype));
+        else if (r->ptype == PERIOD_END_OF_MONTH || g_date_get_day(start) >= dim)
+            g_date_set_day(date, dim);
+        else
+            g_date_set_day(date, g_date_get_day(start));
+
+        /* Same weekend adjustment as recurrenceNextInstance(). */
+        if (r->ptype == PERIOD_NTH_WEEKDAY || r->ptype == PERIOD_LAST_WEEKDAY)
+            break;
+        if (g_date_get_weekday(date) == G_DATE_SATURDAY ||
+                g_date_get_weekday(date) == G_DATE_SUNDAY)
+        {
+            if (r->wadj == WEEKEND_ADJ_BACK)
+                g_date_subtract_days(date, g_date_get_weekday(date) ==
+                                     G_DATE_SATURDAY ? 1 : 2);
+            else if (r->wadj == WEEKEND_ADJ_FORWARD)
+                g_date_add_days(date, g_date_get_weekday(date) ==
+                                G_DATE_SATURDAY ? 2 : 1);
+        }
+        break;
+    default:
+        PERR("Invalid period type");
+        break;
     }
 }
 
+/* Estimate the index of the instance nearest ref from the elapsed days
+   or months, then correct the estimate by comparing against the actual
+   instance dates.  Weekend adjustment can move an instance by at most
+   two days, so the correction only takes a step or two. */
+guint
+recurrenceFirstInstanceAfter(const Recurrence *r, const GDate *ref,
+                             GDate *next)
+{
+    const GDate *start;
+    GDate tmp;
+    guint n, mult;
+    gint months;
+
+    g_return_val_if_fail(r, 0);
+    g_return_val_if_fail(ref && g_date_valid(ref), 0);
+    g_return_val_if_fail(g_date_valid(&r->start), 0);
+
+    start = &r->start;
+    if (g_date_compare(ref, start) < 0)
+    {
+        if (next)
+            *next = *start;
+        return 0;
+    }
+
+    mult = r->mult ? r->mult : 1;
+    switch (r->ptype)
+    {
+    case PERIOD_ONCE:
+        if (next)
+            g_date_clear(next, 1);
+        return 1;
+    case PERIOD_WEEK:
+        mult *= 7;
+        /* fall through */
+    case PERIOD_DAY:
+        n = g_date_days_between(start, ref) / mult + 1;
+        if (next)
+            recurrenceNthInstance(r, n, next);
+        return n;
+    case PERIOD_YEAR:
+        mult *= 12;
+        /* fall through */
+    default:
+        months = 12 * (g_date_get_year(ref) - g_date_get_year(start)) +
+                 (g_date_get_month(ref) - g_date_get_month(start));
+        n = months / mult;
+        break;
+    }
+
+    /* Walk back to an instance no later than ref, then forward to the
+       first one after it. */
+    recurrenceNthInstance(r, n, &tmp);
+    while (n > 0 && g_date_compare(&tmp, ref) > 0)
+        recurrenceNthInstance(r, --n, &tmp);
+    while (g_date_compare(&tmp, ref) <= 0)
+        recurrenceNthInstance(r, ++n, &tmp);
+
+    if (next)
+        *next = tmp;
+    return n;
+}
+
+guint
+recurrenceCountInstancesBetween(const Recurrence *r, const GDate *from,
+                                const GDate *to)
+{
+    GDate before;
+    guint first, last;
+
+    g_return_val_if_fail(r, 0);
+    g_return_val_if_fail(from && g_date_valid(from), 0);
+    g_return_val_if_fail(to && g_date_valid(to), 0);
+
+    if (g_date_compare(from, to) > 0)
+        return 0;
+
+    last = recurrenceFirstInstanceAfter(r, to, NULL);
+    if (g_date_compare(from, &r->start) <= 0)
+        return last;
+
+    before = *from;
+    g_date_subtract_days(&before, 1);
+    first = recurrenceFirstInstanceAfter(r, &before, NULL);
+    return last > first ? last - first : 0;
+}
+
 time64
 recurrenceGetPeriodTime(const Recurrence *r, guint period_num, gboolean end)
 {
@@ -405,6 +548,27 @@ recurrenceGetAccountPeriodValue(const Recurrence *r, Account *acc, guint n)
     return xaccAccountGetBalanceChangeForPeriod (acc, t1, t2, TRUE);
 }
 
+void
+recurrenceGetAccountPeriodValues(const Recurrence *r, Account *acc,
+                                 guint num_periods, gnc_numeric *values)
+{
+    time64 *starts, *ends;
+    guint n;
+
+    g_return_if_fail(r && acc && values);
+    starts = g_new(time64, num_periods);
+    ends = g_new(time64, num_periods);
+    for (n = 0; n < num_periods; n++)
+    {
+        starts[n] = recurrenceGetPeriodTime(r, n, FALSE);
+        ends[n] = recurrenceGetPeriodTime(r, n, TRUE);
+    }
+    xaccAccountGetBalanceChangesForPeriods (acc, starts, ends, num_periods,
+                                            TRUE, values);
+    g_free(starts);
+    g_free(ends);
+}
+
 void
 recurrenceListNextInstance(const GList *rlist, const GDate *ref, GDate *next)
 {
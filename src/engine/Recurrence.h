@@ -130,9 +130,24 @@ WeekendAdjust recurrenceGetWeekendAdjust(const Recurrence *r);
 void recurrenceNextInstance(const Recurrence *r, const GDate *refDate,
                             GDate *nextDate);
 
-/* Zero-based.  n == 1 gets the instance after the start date. */
+/* Zero-based.  n == 1 gets the instance after the start date.  The
+ * date is computed directly rather than by stepping through the
+ * earlier instances. */
 void recurrenceNthInstance(const Recurrence *r, guint n, GDate *date);
 
+/* Get the zero-based index of the first instance strictly later than
+ * 'refDate', and optionally (if 'nextDate' is non-NULL) the instance
+ * itself, as recurrenceNextInstance() would.  For a PERIOD_ONCE
+ * recurrence whose occurrence is not after 'refDate', the index is 1
+ * and 'nextDate' is invalid. */
+guint recurrenceFirstInstanceAfter(const Recurrence *r, const GDate *refDate,
+                                   GDate *nextDate);
+
+/* Count the instances falling between 'from' and 'to', inclusive,
+ * without enumerating them. */
+guint recurrenceCountInstancesBetween(const Recurrence *r, const GDate *from,
+                                      const GDate *to);
+
 /* Get a time coresponding to the beginning (or end if 'end' is true)
    of the nth instance of the recurrence. Also zero-based. */
 time64 recurrenceGetPeriodTime(const Recurrence *r, guint n, gboolean end);
@@ -144,6 +159,12 @@ time64 recurrenceGetPeriodTime(const Recurrence *r, guint n, gboolean end);
 gnc_numeric recurrenceGetAccountPeriodValue(const Recurrence *r,
         Account *acct, guint n);
 
+/** Fill values[0..num_periods-1] with recurrenceGetAccountPeriodValue()
+ *  for each of the first num_periods instances of the Recurrence,
+ *  walking the account's splits once. **/
+void recurrenceGetAccountPeriodValues(const Recurrence *r, Account *acct,
+                                      guint num_periods, gnc_numeric *values);
+
 /** @return the earliest of the next occurances -- a "composite" recurrence **/
 void recurrenceListNextInstance(const GList *r, const GDate *refDate,
                                 GDate *nextDate);
@@ -762,8 +762,9 @@ gint gnc_sx_get_num_occur_daterange(const SchedXaction *sx, const GDate* start_d
     /* Increase the tmpState until we are in our interval of
      * interest. Only calculate anything if the sx hasn't already
      * ended. */
-    while (g_date_compare(&tmpState->last_date, start_date) < 0)
+    if (g_date_compare(&tmpState->last_date, start_date) < 0)
     {
+        gnc_sx_skip_temporal_state (sx, tmpState, start_date);
         gnc_sx_incr_temporal_state (sx, tmpState);
         if (xaccSchedXactionHasOccurDef(sx) && tmpState->num_occur_rem < 0)
         {
@@ -775,19 +776,43 @@ gint gnc_sx_get_num_occur_daterange(const SchedXaction *sx, const GDate* start_d
     /* Now we are in our interval of interest. Increment the
      * occurrence date until we are beyond the end of our
      * interval. Make sure to check for invalid dates here: It means
-     * the SX has ended. */
-    while (g_date_valid(&tmpState->last_date)
-            && (g_date_compare(&tmpState->last_date, end_date) <= 0)
-            && (!xaccSchedXactionHasEndDate(sx)
-                || g_date_compare(&tmpState->last_date, xaccSchedXactionGetEndDate(sx)) <= 0)
-            && (!xaccSchedXactionHasOccurDef(sx)
-                /* The >=0 (i.e. the ==) is important here, otherwise
-                 * we miss the last valid occurrence of a SX which is
-                 * limited by num_occur */
-                || tmpState->num_occur_rem >= 0))
+     * the SX has ended. With a single recurrence the occurrences
+     * up to the end of the interval are counted directly. */
+    if (sx->schedule != NULL && sx->schedule->next == NULL)
     {
-        ++result;
-        gnc_sx_incr_temporal_state (sx, tmpState);
+        const GDate *last = &tmpState->last_date;
+        GDate limit = *end_date, after;
+
+        if (xaccSchedXactionHasEndDate(sx)
+                && g_date_compare(xaccSchedXactionGetEndDate(sx), &limit) < 0)
+            limit = *xaccSchedXactionGetEndDate(sx);
+        if (g_date_valid(last) && g_date_compare(last, &limit) <= 0
+                && (!xaccSchedXactionHasOccurDef(sx)
+                    || tmpState->num_occur_rem >= 0))
+        {
+            after = *last;
+            g_date_add_days(&after, 1);
+            result = 1 + recurrenceCountInstancesBetween(sx->schedule->data,
+                     &after, &limit);
+            if (xaccSchedXactionHasOccurDef(sx))
+                result = MIN(result, tmpState->num_occur_rem + 1);
+        }
+    }
+    else
+    {
+        while (g_date_valid(&tmpState->last_date)
+                && (g_date_compare(&tmpState->last_date, end_date) <= 0)
+                && (!xaccSchedXactionHasEndDate(sx)
+                    || g_date_compare(&tmpState->last_date, xaccSchedXactionGetEndDate(sx)) <= 0)
+                && (!xaccSchedXactionHasOccurDef(sx)
+                    /* The >=0 (i.e. the ==) is important here, otherwise
+                     * we miss the last valid occurrence of a SX which is
+                     * limited by num_occur */
+                    || tmpState->num_occur_rem >= 0))
+        {
+            ++result;
+            gnc_sx_incr_temporal_state (sx, tmpState);
+        }
     }
 
     /* If the first valid date shouldn't be counted, decrease the
@@ -1060,6 +1085,58 @@ gnc_sx_incr_temporal_state(const SchedXaction *sx, SXTmpStateData *tsd )
     ++tsd->num_inst;
 }
 
+void
+gnc_sx_skip_temporal_state(const SchedXaction *sx, SXTmpStateData *tsd,
+                           const GDate *date)
+{
+    const Recurrence *r;
+    GDate prev, before;
+    guint first, target;
+
+    g_return_if_fail(sx != NULL && tsd != NULL);
+    g_return_if_fail(date != NULL && g_date_valid(date));
+
+    prev = tsd->last_date;
+    if (!g_date_valid(&prev) && g_date_valid(&sx->start_date))
+    {
+        prev = sx->start_date;
+        g_date_subtract_days(&prev, 1);
+    }
+
+    /* A list of recurrences has no closed form; step through it. */
+    if (sx->schedule == NULL || sx->schedule->next != NULL
+            || !g_date_valid(&prev))
+    {
+        GDate next = xaccSchedXactionGetNextInstance(sx, tsd);
+        while (g_date_valid(&next) && g_date_compare(&next, date) < 0)
+        {
+            gnc_sx_incr_temporal_state(sx, tsd);
+            next = xaccSchedXactionGetNextInstance(sx, tsd);
+        }
+        return;
+    }
+
+    r = sx->schedule->data;
+    first = recurrenceFirstInstanceAfter(r, &prev, NULL);
+    before = *date;
+    g_date_subtract_days(&before, 1);
+    target = recurrenceFirstInstanceAfter(r, &before, NULL);
+
+    /* Same limits as xaccSchedXactionGetNextInstance(). */
+    if (xaccSchedXactionHasEndDate(sx))
+        target = MIN(target, recurrenceFirstInstanceAfter(
+                         r, xaccSchedXactionGetEndDate(sx), NULL));
+    else if (xaccSchedXactionHasOccurDef(sx))
+        target = MIN(target, first + MAX(tsd->num_occur_rem, 0));
+    if (target <= first)
+        return;
+
+    recurrenceNthInstance(r, target - 1, &tsd->last_date);
+    if (xaccSchedXactionHasOccurDef(sx))
+        tsd->num_occur_rem -= target - first;
+    tsd->num_inst += target - first;
+}
+
 void
 gnc_sx_destroy_temporal_state (SXTmpStateData *tsd)
 {
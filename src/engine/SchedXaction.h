@@ -246,6 +246,14 @@ SXTmpStateData *gnc_sx_create_temporal_state(const SchedXaction *sx );
  * occurence in the remporalStateDate. The SX is unchanged. */
 void gnc_sx_incr_temporal_state(const SchedXaction *sx, SXTmpStateData *stateData );
 
+/** Advances the given stateData over every instance earlier than
+ * 'date', as repeated gnc_sx_incr_temporal_state() calls would, but
+ * computes the skipped occurrences directly when the SX has a single
+ * recurrence.  The end date and remaining occurrence count are
+ * honored. */
+void gnc_sx_skip_temporal_state(const SchedXaction *sx, SXTmpStateData *stateData,
+                                const GDate *date);
+
 /** Frees the given stateDate object. */
 void gnc_sx_destroy_temporal_state( SXTmpStateData *stateData );
 
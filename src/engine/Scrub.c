@@ -47,6 +47,7 @@
 #include "AccountP.h"
 #include "Scrub.h"
 #include "ScrubP.h"
+#include "Scrub3.h"
 #include "Transaction.h"
 #include "TransactionP.h"
 #include "gnc-commodity.h"
@@ -58,15 +59,91 @@
 static QofLogModule log_module = G_LOG_DOMAIN;
 
 /* ================================================================ */
+/* The tree-wide scrubs work in two phases.  The first only reads:
+ * it walks the splits of every account in the tree and collects each
+ * transaction that needs attention exactly once, no matter how many
+ * of its splits live in the tree.  The second applies the fixes to
+ * the collected transactions one after the other.  A transaction
+ * with N splits in the tree used to be scrubbed N times.
+ */
+
+typedef gboolean (*TransScrubNeeded) (const Transaction *trans);
+
+typedef struct
+{
+    GHashTable *seen;
+    GPtrArray *found;
+    TransScrubNeeded needed;
+} ScrubCollect;
+
+static void
+scrub_collect_account (Account *acc, gpointer data)
+{
+    ScrubCollect *collect = data;
+    GList *node;
+
+    for (node = xaccAccountGetSplitList (acc); node; node = node->next)
+    {
+        Transaction *trans = xaccSplitGetParent (node->data);
+
+        if (!trans || g_hash_table_lookup (collect->seen, trans))
+            continue;
+        g_hash_table_insert (collect->seen, trans, trans);
+        if (!collect->needed || collect->needed (trans))
+            g_ptr_array_add (collect->found, trans);
+    }
+}
+
+/* Returns every transaction with a split in acc or one of its
+ * descendants for which needed returns TRUE (all of them if needed is
+ * NULL), each once, in account tree order.  Free with
+ * g_ptr_array_free. */
+static GPtrArray *
+scrub_collect_transactions (Account *acc, TransScrubNeeded needed)
+{
+    ScrubCollect collect;
+
+    collect.seen = g_hash_table_new (g_direct_hash, g_direct_equal);
+    collect.found = g_ptr_array_new ();
+    collect.needed = needed;
+
+    scrub_collect_account (acc, &collect);
+    gnc_account_foreach_descendant (acc, scrub_collect_account, &collect);
+
+    g_hash_table_destroy (collect.seen);
+    return collect.found;
+}
+
+static gboolean
+trans_has_orphans (const Transaction *trans)
+{
+    GList *node;
+
+    for (node = trans->splits; node; node = node->next)
+        if (!((Split *)node->data)->acc)
+            return TRUE;
+    return FALSE;
+}
+
+static void TransScrubOrphansFast (Transaction *trans, Account *root);
 
 void
 xaccAccountTreeScrubOrphans (Account *acc)
 {
+    GPtrArray *found;
+    Account *root;
+    guint i;
+
     if (!acc) return;
 
-    xaccAccountScrubOrphans (acc);
-    gnc_account_foreach_descendant(acc,
-                                   (AccountCb)xaccAccountScrubOrphans, NULL);
+    PINFO ("Looking for orphans in account tree %s \n",
+           xaccAccountGetName (acc) ? xaccAccountGetName (acc) : "(null)");
+
+    found = scrub_collect_transactions (acc, trans_has_orphans);
+    root = gnc_account_get_root (acc);
+    for (i = 0; i < found->len; i++)
+        TransScrubOrphansFast (g_ptr_array_index (found, i), root);
+    g_ptr_array_free (found, TRUE);
 }
 
 static void
@@ -276,9 +353,30 @@ xaccSplitScrub (Split *split)
 void
 xaccAccountTreeScrubImbalance (Account *acc)
 {
-    xaccAccountScrubImbalance (acc);
-    gnc_account_foreach_descendant(acc,
-                                   (AccountCb)xaccAccountScrubImbalance, NULL);
+    GPtrArray *found;
+    Account *root;
+    guint i;
+
+    if (!acc) return;
+
+    PINFO ("Looking for imbalance in account tree %s \n",
+           xaccAccountGetName (acc) ? xaccAccountGetName (acc) : "(null)");
+
+    /* Whether the currency and imbalance scrubs will change anything
+     * can't be told without doing them, so every transaction is
+     * collected; it is still visited only once. */
+    found = scrub_collect_transactions (acc, NULL);
+    root = gnc_account_get_root (acc);
+    for (i = 0; i < found->len; i++)
+    {
+        Transaction *trans = g_ptr_array_index (found, i);
+
+        PINFO("Start processing transaction %u of %u", i + 1, found->len);
+
+        xaccTransScrubCurrency (trans);
+        xaccTransScrubImbalance (trans, root, NULL);
+    }
+    g_ptr_array_free (found, TRUE);
 }
 
 void
@@ -362,6 +460,114 @@ get_balance_split (Transaction *trans, Account *root, Account *account,
     return balance_split;
 }
 
+/* Finding a transaction's trading accounts by name means searching the
+ * whole account tree, three times over, and in a trading-accounts book
+ * that is done for every transaction the imbalance scrub looks at.  So
+ * each book remembers what the searches found, misses included, until
+ * the shape of the account tree changes.  Creating a missing trading
+ * account changes it too, after which the cache fills again from one
+ * search per account. */
+
+#define SCRUB_TRADING "gnc-scrub-trading"
+
+typedef struct
+{
+    Account *account;           /* Trading:<namespace>, or NULL */
+    GHashTable *mnemonics;      /* mnemonic -> Account or NULL */
+} TradingNamespace;
+
+typedef struct
+{
+    guint generation;
+    Account *root;
+    Account *income;
+    Account *trading;
+    gboolean looked_up;
+    GHashTable *namespaces;     /* namespace -> TradingNamespace */
+} TradingCache;
+
+static void
+trading_namespace_free (gpointer data)
+{
+    TradingNamespace *ns = data;
+
+    g_hash_table_destroy (ns->mnemonics);
+    g_free (ns);
+}
+
+static void
+trading_cache_free (QofBook *book, gpointer key, gpointer data)
+{
+    TradingCache *cache = data;
+
+    g_hash_table_destroy (cache->namespaces);
+    g_free (cache);
+}
+
+static TradingCache *
+trading_cache_get (Account *root)
+{
+    QofBook *book = gnc_account_get_book (root);
+    TradingCache *cache = qof_book_get_data (book, SCRUB_TRADING);
+
+    if (!cache)
+    {
+        cache = g_new0 (TradingCache, 1);
+        cache->namespaces = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                   g_free,
+                                                   trading_namespace_free);
+        qof_book_set_data_fin (book, SCRUB_TRADING, cache, trading_cache_free);
+    }
+    if (cache->root != root ||
+        cache->generation != gnc_account_tree_generation ())
+    {
+        cache->root = root;
+        cache->generation = gnc_account_tree_generation ();
+        cache->looked_up = FALSE;
+        g_hash_table_remove_all (cache->namespaces);
+    }
+    if (!cache->looked_up)
+    {
+        cache->income = gnc_account_lookup_by_name (root, _("Income"));
+        cache->trading = gnc_account_lookup_by_name (root, _("Trading"));
+        cache->looked_up = TRUE;
+    }
+    return cache;
+}
+
+/* The Trading:<namespace>:<mnemonic> account of commodity, or NULL. */
+static Account *
+trading_cache_lookup (TradingCache *cache, const gnc_commodity *commodity)
+{
+    const char *name_space = gnc_commodity_get_namespace (commodity);
+    const char *mnemonic = gnc_commodity_get_mnemonic (commodity);
+    TradingNamespace *ns;
+    gpointer account;
+
+    if (!cache->trading || !name_space || !mnemonic)
+        return NULL;
+
+    ns = g_hash_table_lookup (cache->namespaces, name_space);
+    if (!ns)
+    {
+        ns = g_new0 (TradingNamespace, 1);
+        ns->account = gnc_account_lookup_by_name (cache->trading, name_space);
+        ns->mnemonics = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                               g_free, NULL);
+        g_hash_table_insert (cache->namespaces, g_strdup (name_space), ns);
+    }
+    if (!ns->account)
+        return NULL;
+
+    if (!g_hash_table_lookup_extended (ns->mnemonics, mnemonic,
+                                       NULL, &account))
+    {
+        account = gnc_account_lookup_by_name (ns->account, mnemonic);
+        g_hash_table_insert (ns->mnemonics, g_strdup (mnemonic), account);
+    }
+    return account;
+}
+
 /* Get the trading split for a given commodity, creating it (and the
    necessary accounts) if it doesn't exist. */
 static Split *
@@ -372,6 +578,7 @@ get_trading_split (Transaction *trans, Account *root,
     Account *trading_account;
     Account *ns_account;
     Account *account;
+    TradingCache *cache;
     gnc_commodity *default_currency = NULL;
 
     if (!root)
@@ -385,13 +592,17 @@ get_trading_split (Transaction *trans, Account *root,
         }
     }
 
+    cache = trading_cache_get (root);
+    account = trading_cache_lookup (cache, commodity);
+    if (account)
+        goto have_account;
+
     /* Get the default currency.  This is harder than it seems.  It's not
        possible to call gnc_default_currency() since it's a UI function.  One
        might think that the currency of the root account would do, but the root
        account has no currency.  Instead look for the Income placeholder account
        and use its currency.  */
-    default_currency = xaccAccountGetCommodity(gnc_account_lookup_by_name(root,
-                                                                          _("Income")));
+    default_currency = xaccAccountGetCommodity(cache->income);
     if (! default_currency)
     {
         default_currency = commodity;
@@ -426,7 +637,7 @@ get_trading_split (Transaction *trans, Account *root,
         return NULL;
     }
 
-
+have_account:
     balance_split = xaccTransFindSplitByAccount(trans, account);
 
     /* Put split into account before setting split value */
@@ -449,8 +660,6 @@ static Split *
 find_trading_split (Transaction *trans, Account *root,
                     gnc_commodity *commodity)
 {
-    Account *trading_account;
-    Account *ns_account;
     Account *account;
 
     if (!root)
@@ -464,21 +673,7 @@ find_trading_split (Transaction *trans, Account *root,
         }
     }
 
-    trading_account = gnc_account_lookup_by_name (root, _("Trading"));
-    if (!trading_account)
-    {
-        return NULL;
-    }
-
-    ns_account = gnc_account_lookup_by_name (trading_account,
-                                             gnc_commodity_get_namespace(commodity));
-    if (!ns_account)
-    {
-        return NULL;
-    }
-
-    account = gnc_account_lookup_by_name (ns_account,
-                                          gnc_commodity_get_mnemonic(commodity));
+    account = trading_cache_lookup (trading_cache_get (root), commodity);
     if (!account)
     {
         return NULL;
@@ -1387,4 +1582,155 @@ xaccTransScrubPostedDate (Transaction *trans)
     }
 }
 
+void
+xaccBookScrubBalances (QofBook *book)
+{
+    g_return_if_fail (book);
+
+    ENTER ("(book=%p)", book);
+    if (!gnc_book_rebuild_balance_source (book))
+        PINFO ("The book has no balances to rebuild.");
+    LEAVE (" ");
+}
+
+/* ================================================================ */
+/* The transactions committed since the book was last scrubbed, so
+ * that scrubbing after an import costs what the import added instead
+ * of what the book holds.  Loaders commit with scrubbing disabled, or
+ * forget what they commit, so a freshly opened book has none. */
+
+#define SCRUB_PENDING "gnc-scrub-pending"
+
+typedef struct
+{
+    GHashTable *transactions;
+    gboolean scrubbing;
+} ScrubPending;
+
+static void
+scrub_pending_free (QofBook *book, gpointer key, gpointer data)
+{
+    ScrubPending *pending = data;
+
+    g_hash_table_destroy (pending->transactions);
+    g_free (pending);
+}
+
+static ScrubPending *
+scrub_pending_get (QofBook *book, gboolean create)
+{
+    ScrubPending *pending = qof_book_get_data (book, SCRUB_PENDING);
+
+    if (!pending && create)
+    {
+        pending = g_new0 (ScrubPending, 1);
+        pending->transactions = g_hash_table_new (g_direct_hash,
+                                                  g_direct_equal);
+        qof_book_set_data_fin (book, SCRUB_PENDING, pending,
+                               scrub_pending_free);
+    }
+    return pending;
+}
+
+void
+xaccTransScrubNoteModified (Transaction *trans)
+{
+    QofBook *book;
+    ScrubPending *pending;
+
+    if (!trans) return;
+    book = xaccTransGetBook (trans);
+    if (!book || qof_book_shutting_down (book)) return;
+
+    pending = scrub_pending_get (book, TRUE);
+    /* The incremental scrub commits what it fixes. */
+    if (!pending->scrubbing)
+        g_hash_table_insert (pending->transactions, trans, trans);
+}
+
+void
+xaccTransScrubForgetModified (Transaction *trans)
+{
+    QofBook *book;
+    ScrubPending *pending;
+
+    if (!trans) return;
+    book = xaccTransGetBook (trans);
+    /* The book's data goes before its transactions do. */
+    if (!book || qof_book_shutting_down (book)) return;
+
+    pending = scrub_pending_get (book, FALSE);
+    if (pending)
+        g_hash_table_remove (pending->transactions, trans);
+}
+
+guint
+xaccBookScrubCountModified (QofBook *book)
+{
+    ScrubPending *pending;
+
+    g_return_val_if_fail (book, 0);
+
+    pending = scrub_pending_get (book, FALSE);
+    return pending ? g_hash_table_size (pending->transactions) : 0;
+}
+
+void
+xaccBookScrubModified (QofBook *book, gboolean scrub_lots)
+{
+    ScrubPending *pending;
+    GHashTable *accounts;
+    GHashTableIter iter;
+    gpointer key;
+    Account *root;
+    GList *transactions, *node;
+
+    g_return_if_fail (book);
+
+    pending = scrub_pending_get (book, FALSE);
+    if (!pending || g_hash_table_size (pending->transactions) == 0)
+        return;
+
+    ENTER ("(book=%p) %u transactions", book,
+           g_hash_table_size (pending->transactions));
+    transactions = g_hash_table_get_keys (pending->transactions);
+    g_hash_table_remove_all (pending->transactions);
+    pending->scrubbing = TRUE;
+
+    root = gnc_book_get_root_account (book);
+    accounts = g_hash_table_new (g_direct_hash, g_direct_equal);
+    for (node = transactions; node; node = node->next)
+    {
+        Transaction *trans = node->data;
+        GList *snode;
+
+        if (qof_instance_get_destroying (trans))
+            continue;
+
+        TransScrubOrphansFast (trans, root);
+        xaccTransScrubCurrency (trans);
+        xaccTransScrubImbalance (trans, root, NULL);
+
+        for (snode = trans->splits; snode; snode = snode->next)
+        {
+            Split *split = snode->data;
+
+            if (split->acc)
+                g_hash_table_insert (accounts, split->acc, split->acc);
+        }
+    }
+    g_list_free (transactions);
+
+    if (scrub_lots)
+    {
+        g_hash_table_iter_init (&iter, accounts);
+        while (g_hash_table_iter_next (&iter, &key, NULL))
+            xaccAccountScrubLots (key);
+    }
+    g_hash_table_destroy (accounts);
+
+    pending->scrubbing = FALSE;
+    LEAVE (" ");
+}
+
 /* ==================== END OF FILE ==================== */
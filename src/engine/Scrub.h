@@ -80,7 +80,8 @@ void xaccTransScrubOrphans (Transaction *trans);
 void xaccAccountScrubOrphans (Account *acc);
 
 /** The xaccAccountTreeScrubOrphans() method performs this scrub for the
- *    indicated account and its children.
+ *    indicated account and its children.  Each transaction is checked
+ *    only once, however many of its splits are in the tree.
  */
 void xaccAccountTreeScrubOrphans (Account *acc);
 
@@ -109,6 +110,10 @@ void xaccAccountTreeScrubSplits (Account *account);
 void xaccTransScrubImbalance (Transaction *trans, Account *root,
                               Account *parent);
 void xaccAccountScrubImbalance (Account *acc);
+/** The xaccAccountTreeScrubImbalance() method scrubs the currency and
+ *    imbalance of every transaction with a split in the indicated
+ *    account or its children, visiting each transaction once.
+ */
 void xaccAccountTreeScrubImbalance (Account *acc);
 
 /** The xaccTransScrubCurrency method fixes transactions without a
@@ -154,6 +159,27 @@ void xaccAccountScrubKvp (Account *account);
  */
 void xaccTransScrubPostedDate (Transaction *trans);
 
+/** Rebuilds the balances a backend keeps for the book's accounts when
+ *  it leaves their splits out of memory, from the splits it has.  Does
+ *  nothing with a backend which keeps none. */
+void xaccBookScrubBalances (QofBook *book);
+
+/** Scrubs the orphans, currency and imbalance of each transaction
+ *  committed in the book since it was last scrubbed this way, and if
+ *  scrub_lots is TRUE the lots of the accounts those transactions
+ *  touch.  The work is proportional to what changed, so importers can
+ *  run it after adding their transactions; the tree-wide scrubs above
+ *  still check everything. */
+void xaccBookScrubModified (QofBook *book, gboolean scrub_lots);
+
+/** The number of transactions xaccBookScrubModified() would scrub. */
+guint xaccBookScrubCountModified (QofBook *book);
+
+/** Drops trans from those xaccBookScrubModified() would scrub.
+ *  Backends that commit what they load with scrubbing enabled call
+ *  this, as what was read from the book needs no second look. */
+void xaccTransScrubForgetModified (Transaction *trans);
+
 #endif /* XACC_SCRUB_H */
 /** @} */
 /** @} */
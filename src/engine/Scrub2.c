@@ -52,12 +52,18 @@ static QofLogModule log_module = GNC_MOD_LOT;
 /** Loop over all splits, and make sure that every split
  * belongs to some lot.  If a split does not belong to
  * any lots, poke it into one.
+ *
+ * When xaccSplitAssign() busts a split across several lots, the new
+ * pieces are added to the account already in lots, and no split is
+ * taken out of it.  So the walk carries on from where it was instead
+ * of starting over, which made assigning the splits of a long
+ * brokerage history quadratic in their number.
  */
 
 void
 xaccAccountAssignLots (Account *acc)
 {
-    SplitList *splits, *node;
+    SplitList *node;
 
     if (!acc) return;
 
@@ -65,8 +71,7 @@ xaccAccountAssignLots (Account *acc)
     xaccAccountBeginEdit (acc);
 
 restart_loop:
-    splits = xaccAccountGetSplitList(acc);
-    for (node = splits; node; node = node->next)
+    for (node = xaccAccountGetSplitList(acc); node; node = node->next)
     {
         Split * split = node->data;
 
@@ -77,7 +82,9 @@ restart_loop:
         if (gnc_numeric_zero_p (split->amount) &&
                 xaccTransGetVoidStatus(split->parent)) continue;
 
-        if (xaccSplitAssign (split)) goto restart_loop;
+        /* Should the splits have been sorted after all, start over. */
+        if (xaccSplitAssign (split) && node->data != split)
+            goto restart_loop;
     }
     xaccAccountCommitEdit (acc);
     LEAVE ("acc=%s", xaccAccountGetName(acc));
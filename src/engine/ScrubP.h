@@ -38,4 +38,8 @@ Account * xaccScrubUtilityGetOrMakeAccount (Account *root,
         GNCAccountType acctype, gboolean placeholder);
 
 
+/* Adds trans to those xaccBookScrubModified() will scrub.  Called
+ * when a transaction is committed with data scrubbing enabled. */
+void xaccTransScrubNoteModified (Transaction *trans);
+
 #endif /* XACC_SCRUB_P_H */
@@ -56,10 +56,15 @@
 #include "gnc-lot.h"
 #include "gnc-event.h"
 #include "qofinstance-p.h"
+#include "qofquerycore-p.h"
 
 const char *void_former_amt_str = "void-former-amount";
 const char *void_former_val_str = "void-former-value";
 
+/* Paths for the typed KVP getters, which take the keys already split */
+static const gchar *gains_source_keys[] = {"gains-source"};
+static const gchar *split_type_keys[] = {"split-type"};
+
 #define PRICE_SIGFIGS 6
 
 /* This static indicates the debugging module that this .o belongs to.  */
@@ -112,6 +117,8 @@ gnc_split_init(Split* split)
     split->lot         = NULL;
 
     split->action      = CACHE_INSERT("");
+    split->sort_action_src = NULL;
+    split->sort_action = 0;
     split->memo        = CACHE_INSERT("");
     split->reconciled  = NREC;
     split->amount      = gnc_numeric_zero();
@@ -521,6 +528,7 @@ xaccSplitReinit(Split * split)
     split->lot         = NULL;
 
     CACHE_REPLACE(split->action, "");
+    split->sort_action_src = NULL;
     CACHE_REPLACE(split->memo, "");
     split->reconciled  = NREC;
     split->amount      = gnc_numeric_zero();
@@ -554,6 +562,19 @@ xaccMallocSplit(QofBook *book)
     return split;
 }
 
+Split *
+xaccMallocSplitForLoad (QofBook *book, const GncGUID *guid)
+{
+    Split *split;
+    g_return_val_if_fail (book, NULL);
+    g_return_val_if_fail (guid, NULL);
+
+    split = g_object_new (GNC_TYPE_SPLIT, NULL);
+    qof_instance_init_data_with_guid (&split->inst, GNC_ID_SPLIT, book, guid);
+
+    return split;
+}
+
 /********************************************************************\
 \********************************************************************/
 /* This routine is not exposed externally, since it does weird things,
@@ -738,9 +759,11 @@ xaccFreeSplit (Split *split)
 
 void mark_split (Split *s)
 {
+    xaccTransInvalidateImbalance (s->parent);
+
     if (s->acc)
     {
-        g_object_set(s->acc, "sort-dirty", TRUE, "balance-dirty", TRUE, NULL);
+        gnc_account_set_split_dirty (s->acc, s);
     }
 
     /* set dirty flag on lot too. */
@@ -944,6 +967,7 @@ xaccSplitSetAccount (Split *s, Account *acc)
         xaccTransBeginEdit(trans);
 
     s->acc = acc;
+    xaccTransInvalidateImbalance (trans);
     qof_instance_set_dirty(QOF_INSTANCE(s));
 
     if (trans)
@@ -962,12 +986,14 @@ xaccSplitCommitEdit(Split *s)
 {
     Account *acc = NULL;
     Account *orig_acc = NULL;
+    gboolean destroying;
 
     g_return_if_fail(s);
     if (!qof_instance_is_dirty(QOF_INSTANCE(s)))
         return;
 
     orig_acc = s->orig_acc;
+    destroying = qof_instance_get_destroying(s);
 
     if (GNC_IS_ACCOUNT(s->acc))
         acc = s->acc;
@@ -977,8 +1003,12 @@ xaccSplitCommitEdit(Split *s)
     if (s->lot && (gnc_lot_get_account(s->lot) != acc || qof_instance_get_destroying(s)))
         gnc_lot_remove_split (s->lot, s);
 
-    /* Possibly remove the split from the original account... */
-    if (orig_acc && (orig_acc != acc || qof_instance_get_destroying(s)))
+    /* Possibly remove the split from the original account.  While the
+     * book is shutting down every account is about to drop all of its
+     * splits at once, and taking them out one by one, in no particular
+     * order, would cost a search of the account's splits each. */
+    if (orig_acc && (orig_acc != acc || destroying) &&
+            !(destroying && qof_book_shutting_down(qof_instance_get_book(s))))
     {
         if (!gnc_account_remove_split(orig_acc, s))
         {
@@ -1025,9 +1055,12 @@ xaccSplitCommitEdit(Split *s)
                                (void (*) (QofInstance *)) xaccFreeSplit))
         return;
 
+    /* A destroyed split has been freed by now, and removing it has
+     * already dirtied the account's balances from where it was. */
     if (acc)
     {
-        g_object_set(acc, "sort-dirty", TRUE, "balance-dirty", TRUE, NULL);
+        if (!destroying)
+            gnc_account_set_split_dirty (acc, s);
         xaccAccountRecomputeBalance(acc);
     }
 }
@@ -1048,6 +1081,7 @@ xaccSplitRollbackEdit(Split *s)
     {
         GncEventData ed;
         qof_instance_set_destroying(s, FALSE);
+        xaccTransInvalidateImbalance (s->parent);
         ed.node = s;
         ed.idx = -1; /* unused */
         qof_event_gen(&s->parent->inst, GNC_EVENT_ITEM_ADDED, &ed);
@@ -1065,9 +1099,15 @@ Split *
 xaccSplitLookup (const GncGUID *guid, QofBook *book)
 {
     QofCollection *col;
+    Split *split;
+
     if (!guid || !book) return NULL;
     col = qof_book_get_collection (book, GNC_ID_SPLIT);
-    return (Split *) qof_collection_lookup_entity (col, guid);
+    split = (Split *) qof_collection_lookup_entity (col, guid);
+    /* The backend may have left its transaction out of memory. */
+    if (!split && gnc_book_load_split_trans (book, guid))
+        split = (Split *) qof_collection_lookup_entity (col, guid);
+    return split;
 }
 
 /********************************************************************\
@@ -1084,8 +1124,7 @@ void
 xaccSplitDetermineGainStatus (Split *split)
 {
     Split *other;
-    GValue v = G_VALUE_INIT;
-    GncGUID *guid = NULL;
+    const GncGUID *guid = NULL;
 
     if (GAINS_STATUS_UNKNOWN != split->gains) return;
 
@@ -1097,9 +1136,9 @@ xaccSplitDetermineGainStatus (Split *split)
         return;
     }
 
-    qof_instance_get_kvp (QOF_INSTANCE (split), "gains-source", &v);
-    if (G_VALUE_HOLDS_BOXED (&v))
-        guid = (GncGUID*)g_value_get_boxed (&v);
+    guid = qof_instance_get_kvp_guid (QOF_INSTANCE (split),
+                                      G_N_ELEMENTS (gains_source_keys),
+                                      gains_source_keys);
     if (!guid)
     {
         // CHECKME: We leave split->gains_split alone.  Is that correct?
@@ -1182,6 +1221,7 @@ qofSplitSetSharePrice (Split *split, gnc_numeric price)
     split->value = gnc_numeric_mul(xaccSplitGetAmount(split),
                                    price, get_currency_denom(split),
                                    GNC_HOW_RND_ROUND_HALF_UP);
+    xaccTransInvalidateImbalance (split->parent);
 }
 
 void
@@ -1215,6 +1255,7 @@ qofSplitSetAmount (Split *split, gnc_numeric amt)
     {
         split->amount = amt;
     }
+    xaccTransInvalidateImbalance (split->parent);
 }
 
 /* The amount of the split in the _account's_ commodity. */
@@ -1250,6 +1291,7 @@ qofSplitSetValue (Split *split, gnc_numeric amt)
     g_return_if_fail(split);
     split->value = gnc_numeric_convert(amt,
                                        get_currency_denom(split), GNC_HOW_RND_ROUND_HALF_UP);
+    xaccTransInvalidateImbalance (split->parent);
     g_assert(gnc_numeric_check (split->value) != GNC_ERROR_OK);
 }
 
@@ -1472,6 +1514,7 @@ xaccSplitDestroy (Split *split)
     ed.idx = xaccTransGetSplitIndex(trans, split);
     qof_instance_set_dirty(QOF_INSTANCE(split));
     qof_instance_set_destroying(split, TRUE);
+    xaccTransInvalidateImbalance (trans);
     qof_event_gen(&trans->inst, GNC_EVENT_ITEM_REMOVED, &ed);
     xaccTransCommitEdit(trans);
 
@@ -1481,13 +1524,39 @@ xaccSplitDestroy (Split *split)
 /********************************************************************\
 \********************************************************************/
 
+static inline gint
+split_sort_action (const Split *split)
+{
+    Split *s = (Split *) split;
+
+    if (s->sort_action_src != s->action || !s->sort_action_src)
+    {
+        s->sort_action = atoi (s->action);
+        s->sort_action_src = s->action;
+    }
+    return s->sort_action;
+}
+
 gint
 xaccSplitOrder (const Split *sa, const Split *sb)
+{
+    if (sa == sb) return 0;
+    /* nothing is always less than something */
+    if (!sa) return -1;
+    if (!sb) return +1;
+
+    return xaccSplitOrderNumSource (sa, sb,
+                                    qof_book_use_split_action_for_num_field
+                                    (xaccSplitGetBook (sa)));
+}
+
+gint
+xaccSplitOrderNumSource (const Split *sa, const Split *sb,
+                         gboolean action_for_num)
 {
     int retval;
     int comp;
     char *da, *db;
-    gboolean action_for_num;
 
     if (sa == sb) return 0;
     /* nothing is always less than something */
@@ -1495,14 +1564,17 @@ xaccSplitOrder (const Split *sa, const Split *sb)
     if (!sb) return +1;
 
     /* sort in transaction order, but use split action rather than trans num
-     * according to book option */
-    action_for_num = qof_book_use_split_action_for_num_field
-        (xaccSplitGetBook (sa));
-    if (action_for_num)
-        retval = xaccTransOrder_num_action (sa->parent, sa->action,
-                                            sb->parent, sb->action);
+     * according to book option.  The numbers are parsed once per string
+     * and cached, so this is integer comparisons until the dates and
+     * numbers tie. */
+    if (action_for_num && sa->action && sb->action)
+        retval = xaccTransOrderSortNums (sa->parent, split_sort_action (sa),
+                                         sb->parent, split_sort_action (sb));
     else
-        retval = xaccTransOrder (sa->parent, sb->parent);
+        retval = xaccTransOrderSortNums (sa->parent,
+                                         xaccTransGetSortNum (sa->parent),
+                                         sb->parent,
+                                         xaccTransGetSortNum (sb->parent));
     if (retval) return retval;
 
     /* otherwise, sort on memo strings */
@@ -1559,7 +1631,7 @@ xaccSplitOrderDateOnly (const Split *sa, const Split *sb)
     if ( !ta ) return +1;
 
     /* if dates differ, return */
-    DATE_CMP(ta, tb, date_posted);
+    TIME64_CMP(ta, tb, date_posted);
 
     /* If the dates are the same, do not change the order */
     return -1;
@@ -1729,6 +1801,7 @@ qofSplitSetAction (Split *split, const char *actn)
 {
     g_return_if_fail(split);
     CACHE_REPLACE(split->action, actn);
+    split->sort_action_src = NULL;
 }
 
 void
@@ -1738,6 +1811,7 @@ xaccSplitSetAction (Split *split, const char *actn)
     xaccTransBeginEdit (split->parent);
 
     CACHE_REPLACE(split->action, actn);
+    split->sort_action_src = NULL;
     qof_instance_set_dirty(QOF_INSTANCE(split));
     xaccTransCommitEdit(split->parent);
 
@@ -1756,6 +1830,8 @@ qofSplitSetReconcile (Split *split, char recn)
         case VREC:
             split->reconciled = recn;
             mark_split (split);
+            if (split->acc)
+                gnc_account_split_reconcile_changed (split->acc, split);
             xaccAccountRecomputeBalance (split->acc);
             break;
         default:
@@ -1779,6 +1855,8 @@ xaccSplitSetReconcile (Split *split, char recn)
         case VREC:
             split->reconciled = recn;
             mark_split (split);
+            if (split->acc)
+                gnc_account_split_reconcile_changed (split->acc, split);
             qof_instance_set_dirty(QOF_INSTANCE(split));
             xaccAccountRecomputeBalance (split->acc);
             break;
@@ -1871,6 +1949,8 @@ xaccSplitSetParent(Split *s, Transaction *t)
         qof_event_gen(&old_trans->inst, GNC_EVENT_ITEM_REMOVED, &ed);
     }
     s->parent = t;
+    xaccTransInvalidateImbalance (old_trans);
+    xaccTransInvalidateImbalance (t);
 
     xaccTransCommitEdit(old_trans);
     qof_instance_set_dirty(QOF_INSTANCE(s));
@@ -1989,13 +2069,12 @@ xaccSplitGetBook (const Split *split)
 const char *
 xaccSplitGetType(const Split *s)
 {
-    GValue v = G_VALUE_INIT;
     const char *split_type = NULL;
 
     if (!s) return NULL;
-    qof_instance_get_kvp (QOF_INSTANCE (s), "split-type", &v);
-    if (G_VALUE_HOLDS_STRING (&v))
-        split_type = g_value_get_string (&v);
+    split_type = qof_instance_get_kvp_string (QOF_INSTANCE (s),
+                                              G_N_ELEMENTS (split_type_keys),
+                                              split_type_keys);
     return split_type ? split_type : "normal";
 }
 
@@ -2144,25 +2223,21 @@ xaccSplitGetOtherSplit (const Split *split)
 gnc_numeric
 xaccSplitVoidFormerAmount(const Split *split)
 {
-    GValue v = G_VALUE_INIT;
-    gnc_numeric *num = NULL;
-    g_return_val_if_fail(split, gnc_numeric_zero());
-    qof_instance_get_kvp (QOF_INSTANCE (split), void_former_amt_str, &v);
-    if (G_VALUE_HOLDS_BOXED (&v))
-        num = (gnc_numeric*)g_value_get_boxed (&v);
-    return num ? *num : gnc_numeric_zero();
+    gnc_numeric num = gnc_numeric_zero();
+    g_return_val_if_fail(split, num);
+    qof_instance_get_kvp_numeric (QOF_INSTANCE (split), &num,
+                                  1, &void_former_amt_str);
+    return num;
 }
 
 gnc_numeric
 xaccSplitVoidFormerValue(const Split *split)
 {
-    GValue v = G_VALUE_INIT;
-    gnc_numeric *num = NULL;
-    g_return_val_if_fail(split, gnc_numeric_zero());
-    qof_instance_get_kvp (QOF_INSTANCE (split), void_former_val_str, &v);
-    if (G_VALUE_HOLDS_BOXED (&v))
-        num = (gnc_numeric*)g_value_get_boxed (&v);
-    return num ? *num : gnc_numeric_zero();
+    gnc_numeric num = gnc_numeric_zero();
+    g_return_val_if_fail(split, num);
+    qof_instance_get_kvp_numeric (QOF_INSTANCE (split), &num,
+                                  1, &void_former_val_str);
+    return num;
 }
 
 void
@@ -2266,6 +2341,153 @@ qofSplitSetAccount(Split *s, QofInstance *ent)
     xaccSplitSetAccount(s, acc);
 }
 
+/* Query indexes: an account knows its splits, and checking the date of
+ * a transaction once is cheaper than checking it from each of its splits,
+ * which is what a scan of the splits does. */
+static gboolean
+split_account_index_accepts (const QofQueryPredData *pdata)
+{
+    return !g_strcmp0 (pdata->type_name, QOF_TYPE_GUID) &&
+           ((const query_guid_def*)pdata)->options == QOF_GUID_MATCH_ANY;
+}
+
+static void
+split_account_index_foreach (QofBook *book, QofIdTypeConst search_for,
+                             const QofQueryPredData *pdata,
+                             QofInstanceForeachCB cb, gpointer user_data)
+{
+    const query_guid_def *pd = (const query_guid_def*)pdata;
+    GList *seen = NULL, *node, *snode;
+
+    for (node = pd->guids; node; node = node->next)
+    {
+        Account *acc = xaccAccountLookup (node->data, book);
+        if (!acc || g_list_find (seen, acc))
+            continue;
+        seen = g_list_prepend (seen, acc);
+        for (snode = xaccAccountGetSplitList (acc); snode; snode = snode->next)
+            cb (snode->data, user_data);
+    }
+    g_list_free (seen);
+}
+
+/* A query for the splits of an account which are neither reconciled
+ * nor frozen, as the reconcile window runs, only needs the account's
+ * unreconciled splits. */
+static gboolean
+split_unreconciled_filter_accepts (const QofQueryPredData *pdata)
+{
+    const query_char_def *pd = (const query_char_def*)pdata;
+    const gchar *c;
+
+    if (g_strcmp0 (pdata->type_name, QOF_TYPE_CHAR) ||
+            pd->options != QOF_CHAR_MATCH_ANY || !pd->char_list)
+        return FALSE;
+    for (c = pd->char_list; *c; c++)
+        if (*c != NREC && *c != CREC)
+            return FALSE;
+    return TRUE;
+}
+
+static void
+split_unreconciled_index_foreach (QofBook *book, QofIdTypeConst search_for,
+                                  const QofQueryPredData *pdata,
+                                  QofInstanceForeachCB cb, gpointer user_data)
+{
+    const query_guid_def *pd = (const query_guid_def*)pdata;
+    GList *seen = NULL, *node, *splits, *snode;
+
+    for (node = pd->guids; node; node = node->next)
+    {
+        Account *acc = xaccAccountLookup (node->data, book);
+        if (!acc || g_list_find (seen, acc))
+            continue;
+        seen = g_list_prepend (seen, acc);
+        splits = xaccAccountGetUnreconciledSplits (acc);
+        for (snode = splits; snode; snode = snode->next)
+            cb (snode->data, user_data);
+        g_list_free (splits);
+    }
+    g_list_free (seen);
+}
+
+typedef struct
+{
+    QofQueryPredicateFunc pred;
+    const QofParam *param;
+    QofQueryPredData *pdata;
+    QofInstanceForeachCB cb;
+    gpointer user_data;
+} SplitDateIndexData;
+
+static void
+split_date_index_trans_cb (QofInstance *inst, gpointer user_data)
+{
+    SplitDateIndexData *data = user_data;
+    Transaction *trans = GNC_TRANSACTION (inst);
+    GList *node;
+
+    if (!data->pred (trans, data->param, data->pdata))
+        return;
+    for (node = xaccTransGetSplitList (trans); node; node = node->next)
+        data->cb (node->data, data->user_data);
+}
+
+static void
+split_date_index_foreach (QofBook *book, QofIdTypeConst search_for,
+                          const QofQueryPredData *pdata,
+                          QofInstanceForeachCB cb, gpointer user_data)
+{
+    SplitDateIndexData data;
+
+    data.pred = qof_query_core_get_predicate (QOF_TYPE_DATE);
+    data.param = qof_class_get_parameter (GNC_ID_TRANS, TRANS_DATE_POSTED);
+    data.pdata = (QofQueryPredData*)pdata;
+    data.cb = cb;
+    data.user_data = user_data;
+    if (!data.pred || !data.param)
+    {
+        qof_object_foreach (search_for, book, cb, user_data);
+        return;
+    }
+    qof_collection_foreach (qof_book_get_collection (book, GNC_ID_TRANS),
+                            split_date_index_trans_cb, &data);
+}
+
+/* A split query's results can change with the split's transaction,
+ * account or lot. */
+static void
+split_list_dependents (GList *splits, QofInstanceForeachCB cb,
+                       gpointer user_data)
+{
+    for (; splits; splits = splits->next)
+        cb (splits->data, user_data);
+}
+
+static void
+trans_split_dependents (QofInstance *changed, QofInstanceForeachCB cb,
+                        gpointer user_data)
+{
+    split_list_dependents (xaccTransGetSplitList (GNC_TRANSACTION (changed)),
+                           cb, user_data);
+}
+
+static void
+account_split_dependents (QofInstance *changed, QofInstanceForeachCB cb,
+                          gpointer user_data)
+{
+    split_list_dependents (xaccAccountGetSplitList (GNC_ACCOUNT (changed)),
+                           cb, user_data);
+}
+
+static void
+lot_split_dependents (QofInstance *changed, QofInstanceForeachCB cb,
+                      gpointer user_data)
+{
+    split_list_dependents (gnc_lot_get_split_list (GNC_LOT (changed)),
+                           cb, user_data);
+}
+
 gboolean xaccSplitRegister (void)
 {
     static const QofParam params[] =
@@ -2366,6 +2588,33 @@ gboolean xaccSplitRegister (void)
     qof_class_register (SPLIT_CORR_ACCT_CODE,
                         (QofSortFunc)xaccSplitCompareOtherAccountCodes, NULL);
 
+    qof_query_register_index (GNC_ID_SPLIT, "account splits",
+                              qof_query_build_param_list (SPLIT_ACCOUNT,
+                                                          QOF_PARAM_GUID, NULL),
+                              10, split_account_index_accepts,
+                              split_account_index_foreach);
+    qof_query_register_filtered_index (GNC_ID_SPLIT,
+                                       "account unreconciled splits",
+                                       qof_query_build_param_list (SPLIT_ACCOUNT,
+                                                                   QOF_PARAM_GUID,
+                                                                   NULL),
+                                       5, split_account_index_accepts,
+                                       split_unreconciled_index_foreach,
+                                       qof_query_build_param_list (SPLIT_RECONCILE,
+                                                                   NULL),
+                                       split_unreconciled_filter_accepts);
+    qof_query_register_index (GNC_ID_SPLIT, "transactions by date posted",
+                              qof_query_build_param_list (SPLIT_TRANS,
+                                                          TRANS_DATE_POSTED,
+                                                          NULL),
+                              50, NULL, split_date_index_foreach);
+    qof_query_register_dependents (GNC_ID_SPLIT, GNC_ID_TRANS,
+                                   trans_split_dependents);
+    qof_query_register_dependents (GNC_ID_SPLIT, GNC_ID_ACCOUNT,
+                                   account_split_dependents);
+    qof_query_register_dependents (GNC_ID_SPLIT, GNC_ID_LOT,
+                                   lot_split_dependents);
+
     return qof_object_register (&split_object_def);
 }
 
@@ -72,12 +72,49 @@ struct split_s
 {
     QofInstance inst;
 
-    Account *acc;              /* back-pointer to debited/credited account  */
-    Account *orig_acc;
-    GNCLot *lot;               /* back-pointer to debited/credited lot */
+    /* The fields up to and including the running balances are the ones
+     * read and written by the balance, sort and register loops that
+     * visit every split of an account.  They are kept together right
+     * after the instance so that such a loop touches as few cache lines
+     * per split as possible; the fields after them are only looked at
+     * when a split is edited, displayed or compared field by field.
+     * Keep new fields out of this first group unless they are hot too. */
 
+    Account *acc;              /* back-pointer to debited/credited account  */
     Transaction *parent;       /* parent of split                           */
+
+    /* 'value' is the quantity of the transaction balancing commodity
+     * (i.e. currency) involved, 'amount' is the amount of the account's
+     * commodity involved. */
+    gnc_numeric  value;
+    gnc_numeric  amount;
+
+    /* -------------------------------------------------------------- */
+    /* Below follow some 'temporary' fields */
+
+    /* The various "balances" are the sum of all of the values of
+     * all the splits in the account, up to and including this split.
+     * These balances apply to a sorting order by date posted
+     * (not by date entered). */
+    gnc_numeric  balance;
+    gnc_numeric  cleared_balance;
+    gnc_numeric  reconciled_balance;
+
+    char    reconciled;        /* The reconciled field                      */
+
+    /* gains is a flag used to track the relationship between
+     * capital-gains splits. Depending on its value, this flag indicates
+     * if this split is the source of gains, if this split is a record
+     * of the gains, and if values are 'dirty' and need to be recomputed.
+     */
+    unsigned char  gains;
+
+    /* -------------------------------------------------------------- */
+    /* Cold fields */
+
+    Account *orig_acc;
     Transaction *orig_parent;
+    GNCLot *lot;               /* back-pointer to debited/credited lot */
 
     /* The memo field is an arbitrary user-assiged value.
      * It is intended to hold a short (zero to forty character) string
@@ -93,38 +130,19 @@ struct split_s
      */
     char  * action;            /* Buy, Sell, Div, etc.                      */
 
-    Timespec date_reconciled;  /* date split was reconciled                 */
-    char    reconciled;        /* The reconciled field                      */
+    /* The leading number of action, sorted on instead of the
+     * transaction's num when the book says so, and the action string
+     * it was parsed from; see sort_num in struct transaction_s. */
+    const char * sort_action_src;
+    gint sort_action;
 
-    /* gains is a flag used to track the relationship between
-     * capital-gains splits. Depending on its value, this flag indicates
-     * if this split is the source of gains, if this split is a record
-     * of the gains, and if values are 'dirty' and need to be recomputed.
-     */
-    unsigned char  gains;
+    Timespec date_reconciled;  /* date split was reconciled                 */
 
     /* 'gains_split' is a convenience pointer used to track down the
      * other end of a cap-gains transaction pair.  NULL if this split
      * doesn't involve cap gains.
      */
     Split *gains_split;
-
-    /* 'value' is the quantity of the transaction balancing commodity
-     * (i.e. currency) involved, 'amount' is the amount of the account's
-     * commodity involved. */
-    gnc_numeric  value;
-    gnc_numeric  amount;
-
-    /* -------------------------------------------------------------- */
-    /* Below follow some 'temporary' fields */
-
-    /* The various "balances" are the sum of all of the values of
-     * all the splits in the account, up to and including this split.
-     * These balances apply to a sorting order by date posted
-     * (not by date entered). */
-    gnc_numeric  balance;
-    gnc_numeric  cleared_balance;
-    gnc_numeric  reconciled_balance;
 };
 
 struct _SplitClass
@@ -138,6 +156,11 @@ struct _SplitClass
  * call this on an existing split! */
 #define xaccSplitSetGUID(s,g) qof_instance_set_guid(QOF_INSTANCE(s),g)
 
+/* Creates a split being read from a datafile with the GncGUID it was
+ * saved with, instead of making up one for xaccSplitSetGUID() to
+ * replace. */
+Split *xaccMallocSplitForLoad (QofBook *book, const GncGUID *guid);
+
 /* The xaccFreeSplit() method simply frees all memory associated
  * with the split.  It does not verify that the split isn't
  * referenced in some account.  If the split is referenced by an
@@ -157,6 +180,11 @@ void xaccSplitUnvoid(Split *split);
 void xaccSplitCommitEdit(Split *s);
 void xaccSplitRollbackEdit(Split *s);
 
+/* xaccSplitOrder() with the book's use-split-action-for-num option
+ * already looked up, for sorting many splits of the same book. */
+gint xaccSplitOrderNumSource (const Split *sa, const Split *sb,
+                              gboolean action_for_num);
+
 /* Compute the value of a list of splits in the given currency,
  * excluding the skip_me split. */
 gnc_numeric xaccSplitsComputeValue (GList *splits, const Split * skip_me,
@@ -224,6 +252,11 @@ void         DxaccSplitSetShareAmount (Split *split, double amount);
   }                                                     \
 }
 
+#define TIME64_CMP(aaa,bbb,field) {                     \
+  if ((aaa->field) < (bbb->field)) return -1;           \
+  if ((aaa->field) > (bbb->field)) return +1;           \
+}
+
 #define CHECK_GAINS_STATUS(s)  \
    if (GAINS_STATUS_UNKNOWN == s->gains) xaccSplitDetermineGainStatus(s);
 
@@ -87,6 +87,25 @@ static FILE * trans_log = NULL; /**< current log file handle */
 static char * trans_log_name = NULL; /**< current log file name */
 static char * log_base_name = NULL;
 
+/* The log is written by a background thread so that committing a
+ * transaction doesn't wait on the disk.  Each transaction is formatted
+ * into a block on the caller's thread and queued; the writer flushes
+ * the file whenever it has caught up with the queue, and at least
+ * every sync_interval microseconds while it is kept busy.  Callers
+ * that need the log on disk use xaccLogSync(). */
+#define TRANSLOG_QUEUE_MAX 1024
+
+typedef struct
+{
+    FILE        *fh;    /**< log file the block belongs to */
+    GString     *block; /**< formatted records, NULL for a sync request */
+    GAsyncQueue *done;  /**< if set, the item is pushed here once flushed */
+} TransLogItem;
+
+static GThreadPool * log_writer = NULL;
+static gint64 sync_interval = G_USEC_PER_SEC;
+static gint64 last_sync = 0;
+
 /********************************************************************\
 \********************************************************************/
 
@@ -153,6 +172,94 @@ xaccFileIsCurrentLog (const gchar *name)
 /********************************************************************\
 \********************************************************************/
 
+static void
+log_writer_func (gpointer data, gpointer user_data)
+{
+    TransLogItem *item = data;
+    gint64 now;
+
+    if (item->block)
+    {
+        if (fwrite (item->block->str, 1, item->block->len, item->fh)
+                != item->block->len)
+            PERR ("Error writing to the transaction log: %s",
+                  g_strerror (errno));
+        g_string_free (item->block, TRUE);
+    }
+
+    now = g_get_monotonic_time ();
+    if (item->done || g_thread_pool_unprocessed (log_writer) == 0 ||
+            now - last_sync >= sync_interval)
+    {
+        fflush (item->fh);
+        last_sync = now;
+    }
+
+    if (item->done)
+        g_async_queue_push (item->done, item);
+    else
+        g_slice_free (TransLogItem, item);
+}
+
+static void
+log_queue_block (GString *block)
+{
+    TransLogItem *item;
+
+    if (!log_writer)
+    {
+        /* No writer thread, write synchronously as we always did. */
+        fwrite (block->str, 1, block->len, trans_log);
+        fflush (trans_log);
+        g_string_free (block, TRUE);
+        return;
+    }
+
+    /* Don't let the queue grow without bound if the disk can't keep up. */
+    if (g_thread_pool_unprocessed (log_writer) >= TRANSLOG_QUEUE_MAX)
+        xaccLogSync ();
+
+    item = g_slice_new0 (TransLogItem);
+    item->fh = trans_log;
+    item->block = block;
+    g_thread_pool_push (log_writer, item, NULL);
+}
+
+void
+xaccLogSync (void)
+{
+    TransLogItem *item;
+    GAsyncQueue *done;
+
+    if (!trans_log) return;
+    if (!log_writer)
+    {
+        fflush (trans_log);
+        return;
+    }
+
+    done = g_async_queue_new ();
+    item = g_slice_new0 (TransLogItem);
+    item->fh = trans_log;
+    item->done = done;
+    g_thread_pool_push (log_writer, item, NULL);
+
+    /* The pool has a single thread, so once our request comes back
+     * everything queued before it has been written. */
+    g_async_queue_pop (done);
+    g_async_queue_unref (done);
+    g_slice_free (TransLogItem, item);
+}
+
+void
+xaccLogSetSyncInterval (guint seconds)
+{
+    sync_interval = (gint64)seconds * G_USEC_PER_SEC;
+}
+
+/********************************************************************\
+\********************************************************************/
+
 void
 xaccOpenLog (void)
 {
@@ -200,6 +307,21 @@ xaccOpenLog (void)
              "notes\tmemo\taction\treconciled\t"
              "amount\tvalue\tdate_reconciled\n");
     fprintf (trans_log, "-----------------\n");
+    fflush (trans_log);
+
+    if (!log_writer)
+    {
+        GError *error = NULL;
+
+        log_writer = g_thread_pool_new (log_writer_func, NULL, 1, FALSE,
+                                        &error);
+        if (!log_writer)
+        {
+            PWARN ("Cannot start the transaction log writer, "
+                   "writing synchronously: %s", error->message);
+            g_error_free (error);
+        }
+    }
 }
 
 /********************************************************************\
@@ -209,7 +331,7 @@ void
 xaccCloseLog (void)
 {
     if (!trans_log) return;
-    fflush (trans_log);
+    xaccLogSync ();
     fclose (trans_log);
     trans_log = NULL;
 }
@@ -217,10 +339,19 @@ xaccCloseLog (void)
 /********************************************************************\
 \********************************************************************/
 
+static inline void
+log_append_field (GString *block, const char *str)
+{
+    if (str)
+        g_string_append (block, str);
+    g_string_append_c (block, '\t');
+}
+
 void
 xaccTransWriteLog (Transaction *trans, char flag)
 {
     GList *node;
+    GString *block;
     char trans_guid_str[GUID_ENCODING_LENGTH + 1];
     char split_guid_str[GUID_ENCODING_LENGTH + 1];
     const char *trans_notes;
@@ -237,15 +368,17 @@ xaccTransWriteLog (Transaction *trans, char flag)
     timespecFromTime64(&ts, gnc_time (NULL));
     gnc_timespec_to_iso8601_buff (ts, dnow);
 
-    timespecFromTime64(&ts, trans->date_entered.tv_sec);
+    timespecFromTime64(&ts, trans->date_entered);
     gnc_timespec_to_iso8601_buff (ts, dent);
 
-    timespecFromTime64(&ts, trans->date_posted.tv_sec);
+    timespecFromTime64(&ts, trans->date_posted);
     gnc_timespec_to_iso8601_buff (ts, dpost);
 
     guid_to_string_buff (xaccTransGetGUID(trans), trans_guid_str);
     trans_notes = xaccTransGetNotes(trans);
-    fprintf (trans_log, "===== START\n");
+
+    block = g_string_sized_new (512);
+    g_string_append (block, "===== START\n");
 
     for (node = trans->splits; node; node = node->next)
     {
@@ -272,37 +405,37 @@ xaccTransWriteLog (Transaction *trans, char flag)
         amt = xaccSplitGetAmount (split);
         val = xaccSplitGetValue (split);
 
-        /* use tab-separated fields */
-        fprintf (trans_log,
-                 "%c\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t"
-                 "%s\t%s\t%s\t%s\t%c\t%" G_GINT64_FORMAT "/%" G_GINT64_FORMAT "\t%" G_GINT64_FORMAT "/%" G_GINT64_FORMAT "\t%s\n",
-                 flag,
-                 trans_guid_str, split_guid_str,  /* trans+split make up unique id */
-                 /* Note that the next three strings always exist,
-                 		* so we don't need to test them. */
-                 dnow,
-                 dent,
-                 dpost,
-                 acc_guid_str,
-                 accname ? accname : "",
-                 trans->num ? trans->num : "",
-                 trans->description ? trans->description : "",
-                 trans_notes ? trans_notes : "",
-                 split->memo ? split->memo : "",
-                 split->action ? split->action : "",
-                 split->reconciled,
-                 gnc_numeric_num(amt),
-                 gnc_numeric_denom(amt),
-                 gnc_numeric_num(val),
-                 gnc_numeric_denom(val),
-                 /* The next string always exists. No need to test it. */
-                 drecn);
+        /* use tab-separated fields; this must match
+         * src/import-export/log-replay/gnc-log-replay.c */
+        g_string_append_c (block, flag);
+        g_string_append_c (block, '\t');
+        log_append_field (block, trans_guid_str); /* trans+split make up unique id */
+        log_append_field (block, split_guid_str);
+        log_append_field (block, dnow);
+        log_append_field (block, dent);
+        log_append_field (block, dpost);
+        log_append_field (block, acc_guid_str);
+        log_append_field (block, accname);
+        log_append_field (block, trans->num);
+        log_append_field (block, trans->description);
+        log_append_field (block, trans_notes);
+        log_append_field (block, split->memo);
+        log_append_field (block, split->action);
+        g_string_append_printf (block,
+                                "%c\t%" G_GINT64_FORMAT "/%" G_GINT64_FORMAT
+                                "\t%" G_GINT64_FORMAT "/%" G_GINT64_FORMAT "\t%s\n",
+                                split->reconciled,
+                                gnc_numeric_num(amt),
+                                gnc_numeric_denom(amt),
+                                gnc_numeric_num(val),
+                                gnc_numeric_denom(val),
+                                drecn);
     }
 
-    fprintf (trans_log, "===== END\n");
+    g_string_append (block, "===== END\n");
 
-    /* get data out to the disk */
-    fflush (trans_log);
+    /* hand the data to the writer thread */
+    log_queue_block (block);
 }
 
 /************************ END OF ************************************\
@@ -65,6 +65,20 @@ void    xaccReopenLog (void);
  */
 void    xaccTransWriteLog (Transaction *trans, char flag);
 
+/** The xaccLogSync() method blocks until everything logged so far
+ *    has been handed to the operating system.  Log records are
+ *    written by a background thread, so call this wherever the log
+ *    must be complete, e.g. after saving the book.
+ */
+void    xaccLogSync (void);
+
+/** The xaccLogSetSyncInterval() method sets how often, in seconds,
+ *    the log file is flushed while the writer is kept busy by a
+ *    steady stream of commits.  It is always flushed as soon as the
+ *    writer has caught up.  The default is one second.
+ */
+void    xaccLogSetSyncInterval (guint seconds);
+
 /** document me */
 void    xaccLogEnable (void);
 
@@ -52,8 +52,10 @@ struct timeval
 #endif
 
 #include "AccountP.h"
+#include "gnc-text-index.h"
 #include "Scrub.h"
 #include "Scrub3.h"
+#include "ScrubP.h"
 #include "TransactionP.h"
 #include "SplitP.h"
 #include "TransLog.h"
@@ -192,6 +194,11 @@ const char *assoc_uri_str = "assoc_uri";
 #define TRANS_REVERSED_BY        "reversed-by"
 #define GNC_SX_FROM              "from-sched-xaction"
 
+/* Paths for the typed KVP getters, which take the keys already split */
+static const gchar *txn_type_keys[] = {TRANS_TXN_TYPE_KVP};
+static const gchar *read_only_keys[] = {TRANS_READ_ONLY_REASON};
+static const gchar *reversed_by_keys[] = {TRANS_REVERSED_BY};
+
 #define ISO_DATELENGTH 32 /* length of an iso 8601 date string. */
 
 /* This static indicates the debugging module that this .o belongs to.  */
@@ -272,16 +279,17 @@ gnc_transaction_init(Transaction* trans)
     ENTER ("trans=%p", trans);
     /* Fill in some sane defaults */
     trans->num         = CACHE_INSERT("");
+    trans->sort_num_src = NULL;
+    trans->sort_num = 0;
     trans->description = CACHE_INSERT("");
 
     trans->common_currency = NULL;
     trans->splits = NULL;
+    trans->imbal_value = gnc_numeric_zero ();
+    trans->imbal_valid = FALSE;
 
-    trans->date_entered.tv_sec  = 0;
-    trans->date_entered.tv_nsec = 0;
-
-    trans->date_posted.tv_sec  = 0;
-    trans->date_posted.tv_nsec = 0;
+    trans->date_entered = 0;
+    trans->date_posted = 0;
 
     trans->marker = 0;
     trans->orig = NULL;
@@ -315,6 +323,7 @@ gnc_transaction_get_property(GObject* object,
     Transaction* tx;
     gchar *key;
     GValue *temp;
+    Timespec ts;
 
     g_return_if_fail(GNC_IS_TRANSACTION(object));
 
@@ -331,10 +340,12 @@ gnc_transaction_get_property(GObject* object,
         g_value_take_object(value, tx->common_currency);
         break;
     case PROP_POST_DATE:
-        g_value_set_boxed(value, &tx->date_posted);
+        ts = xaccTransRetDatePostedTS (tx);
+        g_value_set_boxed(value, &ts);
         break;
     case PROP_ENTER_DATE:
-        g_value_set_boxed(value, &tx->date_entered);
+        ts = xaccTransRetDateEnteredTS (tx);
+        g_value_set_boxed(value, &ts);
         break;
     case PROP_INVOICE:
 	key = GNC_INVOICE_ID "/" GNC_INVOICE_GUID;
@@ -527,6 +538,21 @@ xaccMallocTransaction (QofBook *book)
     return trans;
 }
 
+Transaction *
+xaccMallocTransactionForLoad (QofBook *book, const GncGUID *guid)
+{
+    Transaction *trans;
+
+    g_return_val_if_fail (book, NULL);
+    g_return_val_if_fail (guid, NULL);
+
+    trans = g_object_new(GNC_TYPE_TRANSACTION, NULL);
+    qof_instance_init_data_with_guid (&trans->inst, GNC_ID_TRANS, book, guid);
+    qof_event_gen (&trans->inst, QOF_EVENT_CREATE, NULL);
+
+    return trans;
+}
+
 #ifdef DUMP_FUNCTIONS
 /* Please don't delete this function.  Although it is not called by
    any other code in GnuCash, it is useful when debugging.  For example
@@ -538,8 +564,10 @@ xaccTransDump (const Transaction *trans, const char *tag)
     GList *node;
 
     printf("%s Trans %p", tag, trans);
-    printf("    Entered:     %s\n", gnc_print_date(trans->date_entered));
-    printf("    Posted:      %s\n", gnc_print_date(trans->date_posted));
+    printf("    Entered:     %s\n",
+           gnc_print_date(xaccTransRetDateEnteredTS(trans)));
+    printf("    Posted:      %s\n",
+           gnc_print_date(xaccTransRetDatePostedTS(trans)));
     printf("    Num:         %s\n", trans->num ? trans->num : "(null)");
     printf("    Description: %s\n",
            trans->description ? trans->description : "(null)");
@@ -805,6 +833,8 @@ xaccFreeTransaction (Transaction *trans)
         return;
     }
 
+    xaccTransScrubForgetModified (trans);
+
     /* free up the destination splits */
     for (node = trans->splits; node; node = node->next)
         xaccFreeSplit (node->data);
@@ -819,10 +849,8 @@ xaccFreeTransaction (Transaction *trans)
     trans->num         = (char *) 1;
     trans->description = NULL;
 
-    trans->date_entered.tv_sec = 0;
-    trans->date_entered.tv_nsec = 0;
-    trans->date_posted.tv_sec = 0;
-    trans->date_posted.tv_nsec = 0;
+    trans->date_entered = 0;
+    trans->date_posted = 0;
 
     if (trans->orig)
     {
@@ -897,24 +925,24 @@ xaccTransEqual(const Transaction *ta, const Transaction *tb,
         return FALSE;
     }
 
-    if (timespec_cmp(&(ta->date_entered), &(tb->date_entered)))
+    if (ta->date_entered != tb->date_entered)
     {
         char buf1[100];
         char buf2[100];
 
-        (void)gnc_timespec_to_iso8601_buff(ta->date_entered, buf1);
-        (void)gnc_timespec_to_iso8601_buff(tb->date_entered, buf2);
+        (void)gnc_timespec_to_iso8601_buff(xaccTransRetDateEnteredTS(ta), buf1);
+        (void)gnc_timespec_to_iso8601_buff(xaccTransRetDateEnteredTS(tb), buf2);
         PINFO ("date entered differs: '%s' vs '%s'", buf1, buf2);
         return FALSE;
     }
 
-    if (timespec_cmp(&(ta->date_posted), &(tb->date_posted)))
+    if (ta->date_posted != tb->date_posted)
     {
         char buf1[100];
         char buf2[100];
 
-        (void)gnc_timespec_to_iso8601_buff(ta->date_posted, buf1);
-        (void)gnc_timespec_to_iso8601_buff(tb->date_posted, buf2);
+        (void)gnc_timespec_to_iso8601_buff(xaccTransRetDatePostedTS(ta), buf1);
+        (void)gnc_timespec_to_iso8601_buff(xaccTransRetDatePostedTS(tb), buf2);
         PINFO ("date posted differs: '%s' vs '%s'", buf1, buf2);
         return FALSE;
     }
@@ -1027,30 +1055,121 @@ gboolean xaccTransUseTradingAccounts(const Transaction *trans)
 /********************************************************************\
 \********************************************************************/
 
+#define TRANS_SOURCE_KEY "gnc-trans-source"
+
+typedef struct
+{
+    const GncTransSource *source;
+    gpointer user_data;
+} TransSource;
+
 Transaction *
 xaccTransLookup (const GncGUID *guid, QofBook *book)
 {
     QofCollection *col;
+    Transaction *trans;
+    TransSource *ts;
+
     if (!guid || !book) return NULL;
     col = qof_book_get_collection (book, GNC_ID_TRANS);
-    return (Transaction *) qof_collection_lookup_entity (col, guid);
+    trans = (Transaction *) qof_collection_lookup_entity (col, guid);
+
+    ts = qof_book_get_data (book, TRANS_SOURCE_KEY);
+    if (!ts)
+        return trans;
+    if (trans)
+    {
+        if (ts->source->used)
+            ts->source->used (trans, ts->user_data);
+        return trans;
+    }
+    if (!ts->source->load_trans)
+        return NULL;
+    return ts->source->load_trans (book, guid, ts->user_data);
+}
+
+Transaction *
+gnc_book_load_split_trans (QofBook *book, const GncGUID *guid)
+{
+    TransSource *ts;
+
+    if (!guid || !book) return NULL;
+    ts = qof_book_get_data (book, TRANS_SOURCE_KEY);
+    if (!ts || !ts->source->load_split)
+        return NULL;
+    return ts->source->load_split (book, guid, ts->user_data);
+}
+
+void
+gnc_book_set_trans_source (QofBook *book, const GncTransSource *source,
+                           gpointer user_data)
+{
+    TransSource *ts;
+
+    g_return_if_fail (QOF_IS_BOOK (book));
+
+    g_free (qof_book_get_data (book, TRANS_SOURCE_KEY));
+    ts = NULL;
+    if (source)
+    {
+        ts = g_new (TransSource, 1);
+        ts->source = source;
+        ts->user_data = user_data;
+    }
+    qof_book_set_data (book, TRANS_SOURCE_KEY, ts);
 }
 
 /********************************************************************\
 \********************************************************************/
 
+static guint64 imbal_cache_hits = 0;
+static guint64 imbal_cache_misses = 0;
+
+void
+xaccTransInvalidateImbalance (Transaction *trans)
+{
+    if (trans)
+        trans->imbal_valid = FALSE;
+}
+
+void
+xaccTransGetImbalanceCacheStats (guint64 *hits, guint64 *misses)
+{
+    if (hits) *hits = imbal_cache_hits;
+    if (misses) *misses = imbal_cache_misses;
+}
+
 gnc_numeric
 xaccTransGetImbalanceValue (const Transaction * trans)
 {
+    Transaction *t = (Transaction *) trans;
     gnc_numeric imbal = gnc_numeric_zero();
     if (!trans) return imbal;
 
+    if (trans->imbal_valid)
+    {
+        ++imbal_cache_hits;
+        return trans->imbal_value;
+    }
+
     ENTER("(trans=%p)", trans);
     /* Could use xaccSplitsComputeValue, except that we want to use
        GNC_HOW_DENOM_EXACT */
     FOR_EACH_SPLIT(trans, imbal =
                        gnc_numeric_add(imbal, xaccSplitGetValue(s),
                                        GNC_DENOM_AUTO, GNC_HOW_DENOM_EXACT));
+    /* The cache is only as good as the setters which drop it, so don't
+     * keep an overflowed sum around. */
+    if (gnc_numeric_check (imbal) == GNC_ERROR_OK)
+    {
+        t->imbal_value = imbal;
+        t->imbal_valid = TRUE;
+    }
+    ++imbal_cache_misses;
+    if ((imbal_cache_misses & 0xfff) == 0)
+        DEBUG ("imbalance cache: %" G_GUINT64_FORMAT " hits, %"
+               G_GUINT64_FORMAT " misses", imbal_cache_hits,
+               imbal_cache_misses);
     LEAVE("(trans=%p) imbal=%s", trans, gnc_num_dbg_to_string(imbal));
     return imbal;
 }
@@ -1072,6 +1191,19 @@ xaccTransGetImbalance (const Transaction * trans)
 
     trading_accts = xaccTransUseTradingAccounts (trans);
 
+    /* Without trading accounts the imbalance is just the sum of the
+     * values, in the transaction's currency. */
+    if (!trading_accts)
+    {
+        imbal_value = xaccTransGetImbalanceValue (trans);
+        if (!gnc_numeric_zero_p (imbal_value))
+            imbal_list = gnc_monetary_list_add_value (imbal_list,
+                                                      trans->common_currency,
+                                                      imbal_value);
+        LEAVE("(trans=%p), imbal=%p", trans, imbal_list);
+        return imbal_list;
+    }
+
     /* If using trading accounts and there is at least one split that is not
        in the transaction currency or a split that has a price or exchange
        rate other than 1, then compute the balance in each commodity in the
@@ -1446,6 +1578,7 @@ xaccTransBeginEdit (Transaction *trans)
     if (!qof_begin_edit(&trans->inst)) return;
 
     if (qof_book_shutting_down(qof_instance_get_book(trans))) return;
+    if (trans->evicting) return;
 
     if (!qof_book_is_readonly(qof_instance_get_book(trans)))
     {
@@ -1475,6 +1608,18 @@ xaccTransDestroy (Transaction *trans)
     }
 }
 
+void
+xaccTransEvict (Transaction *trans)
+{
+    g_return_if_fail (GNC_IS_TRANSACTION (trans));
+    g_return_if_fail (!xaccTransIsOpen (trans));
+
+    trans->evicting = TRUE;
+    xaccTransBeginEdit (trans);
+    qof_instance_set_destroying (trans, TRUE);
+    xaccTransCommitEdit (trans);
+}
+
 static void
 destroy_gains (Transaction *trans)
 {
@@ -1504,13 +1649,15 @@ do_destroy (Transaction *trans)
     /* If there are capital-gains transactions associated with this,
      * they need to be destroyed too unless we're shutting down in
      * which case all transactions will be destroyed. */
-    if (!shutting_down)
+    if (!shutting_down && !trans->evicting)
         destroy_gains (trans);
 
     /* Make a log in the journal before destruction.  */
-    if (!shutting_down && !qof_book_is_readonly(qof_instance_get_book(trans)))
+    if (!shutting_down && !trans->evicting &&
+            !qof_book_is_readonly(qof_instance_get_book(trans)))
         xaccTransWriteLog (trans, 'D');
 
+    gnc_text_index_trans_destroyed (trans);
     qof_event_gen (&trans->inst, QOF_EVENT_DESTROY, NULL);
 
     /* We only own the splits that still think they belong to us.   This is done
@@ -1617,6 +1764,15 @@ static void trans_cleanup_commit(Transaction *trans)
     }
     g_list_free(slist);
 
+    /* Let the accounts index the description and memos as committed. */
+    for (node = trans->splits; node; node = node->next)
+    {
+        Split *s = node->data;
+        if (s->acc)
+            gnc_account_trans_text_committed (s->acc, s);
+    }
+    gnc_text_index_trans_committed (trans);
+
     if (!qof_book_is_readonly(qof_instance_get_book(trans)))
         xaccTransWriteLog (trans, 'C');
 
@@ -1638,6 +1794,35 @@ static void trans_cleanup_commit(Transaction *trans)
     qof_event_gen (&trans->inst, QOF_EVENT_MODIFY, NULL);
 }
 
+/* Neither the transaction, its KVP nor any of its splits were touched
+ * since xaccTransBeginEdit(), so there's nothing to scrub, log or hand
+ * to the backend. */
+static gboolean
+trans_edit_is_clean (const Transaction *trans)
+{
+    GList *node;
+
+    if (!trans->orig ||
+        qof_instance_get_dirty_flag (trans) ||
+        qof_instance_get_destroying (trans) ||
+        qof_instance_get_infant (QOF_INSTANCE (trans)))
+        return FALSE;
+
+    if (g_list_length (trans->splits) != g_list_length (trans->orig->splits))
+        return FALSE;
+    for (node = trans->splits; node; node = node->next)
+    {
+        Split *s = node->data;
+        if (s->parent != trans ||
+            qof_instance_get_dirty_flag (s) ||
+            qof_instance_get_destroying (s))
+            return FALSE;
+    }
+
+    return qof_instance_compare_kvp (QOF_INSTANCE (trans),
+                                     QOF_INSTANCE (trans->orig)) == 0;
+}
+
 void
 xaccTransCommitEdit (Transaction *trans)
 {
@@ -1650,11 +1835,22 @@ xaccTransCommitEdit (Transaction *trans)
         return;
     }
 
+    if (trans_edit_is_clean (trans))
+    {
+        xaccFreeTransaction (trans->orig);
+        trans->orig = NULL;
+        LEAVE ("(trans=%p) unchanged", trans);
+        return;
+    }
+
     /* We increment this for the duration of the call
      * so other functions don't result in a recursive
      * call to xaccTransCommitEdit. */
     qof_instance_increase_editlevel(trans);
 
+    /* Don't let the scrubbers below trust a sum taken during the edit. */
+    xaccTransInvalidateImbalance (trans);
+
     if (was_trans_emptied(trans))
         qof_instance_set_destroying(trans, TRUE);
 
@@ -1685,12 +1881,15 @@ xaccTransCommitEdit (Transaction *trans)
 
         /* Allow scrubbing in transaction commit again */
         scrub_data = 1;
+
+        /* Orphans and lots are left to xaccBookScrubModified. */
+        xaccTransScrubNoteModified (trans);
     }
 
     /* Record the time of last modification */
-    if (0 == trans->date_entered.tv_sec)
+    if (0 == trans->date_entered)
     {
-	trans->date_entered.tv_sec = gnc_time(NULL);
+	trans->date_entered = gnc_time(NULL);
         qof_instance_set_dirty(QOF_INSTANCE(trans));
     }
 
@@ -1742,6 +1941,7 @@ xaccTransRollbackEdit (Transaction *trans)
 
     orig = trans->orig;
     SWAP(trans->num, orig->num);
+    trans->sort_num_src = NULL;
     SWAP(trans->description, orig->description);
     trans->date_entered = orig->date_entered;
     trans->date_posted = orig->date_posted;
@@ -1770,6 +1970,7 @@ xaccTransRollbackEdit (Transaction *trans)
 
             xaccSplitRollbackEdit(s);
             SWAP(s->action, so->action);
+            s->sort_action_src = NULL;
             SWAP(s->memo, so->memo);
 	    qof_instance_copy_kvp (QOF_INSTANCE (s), QOF_INSTANCE (so));
             s->reconciled = so->reconciled;
@@ -1779,6 +1980,8 @@ xaccTransRollbackEdit (Transaction *trans)
             s->gains_split = so->gains_split;
             //SET_GAINS_A_VDIRTY(s);
             s->date_reconciled = so->date_reconciled;
+            if (s->acc)
+                gnc_account_split_reconcile_changed (s->acc, s);
             qof_instance_mark_clean(QOF_INSTANCE(s));
             xaccFreeSplit(so);
         }
@@ -1809,6 +2012,8 @@ xaccTransRollbackEdit (Transaction *trans)
     g_list_free(slist);
     g_list_free(orig->splits);
     orig->splits = NULL;
+    /* The split values were copied back in behind the setters' backs. */
+    xaccTransInvalidateImbalance (trans);
 
     /* Now that the engine copy is back to its original version,
      * get the backend to fix it in the database */
@@ -1884,36 +2089,51 @@ xaccTransOrder (const Transaction *ta, const Transaction *tb)
     return xaccTransOrder_num_action (ta, NULL, tb, NULL);
 }
 
+gint
+xaccTransGetSortNum (const Transaction *trans)
+{
+    Transaction *t = (Transaction *) trans;
+
+    if (!t) return 0;
+    if (t->sort_num_src != t->num || !t->sort_num_src)
+    {
+        t->sort_num = t->num ? atoi (t->num) : 0;
+        t->sort_num_src = t->num;
+    }
+    return t->sort_num;
+}
+
 int
 xaccTransOrder_num_action (const Transaction *ta, const char *actna,
                             const Transaction *tb, const char *actnb)
+{
+    if (actna && actnb) /* split action string, if not NULL */
+        return xaccTransOrderSortNums (ta, atoi (actna), tb, atoi (actnb));
+    /* else transaction num string */
+    return xaccTransOrderSortNums (ta, xaccTransGetSortNum (ta),
+                                   tb, xaccTransGetSortNum (tb));
+}
+
+int
+xaccTransOrderSortNums (const Transaction *ta, gint na,
+                        const Transaction *tb, gint nb)
 {
     char *da, *db;
-    int na, nb, retval;
+    int retval;
 
     if ( ta && !tb ) return -1;
     if ( !ta && tb ) return +1;
     if ( !ta && !tb ) return 0;
 
     /* if dates differ, return */
-    DATE_CMP(ta, tb, date_posted);
+    TIME64_CMP(ta, tb, date_posted);
 
     /* otherwise, sort on number string */
-    if (actna && actnb) /* split action string, if not NULL */
-    {
-        na = atoi(actna);
-        nb = atoi(actnb);
-    }
-    else                /* else transaction num string */
-    {
-        na = atoi(ta->num);
-        nb = atoi(tb->num);
-    }
     if (na < nb) return -1;
     if (na > nb) return +1;
 
     /* if dates differ, return */
-    DATE_CMP(ta, tb, date_entered);
+    TIME64_CMP(ta, tb, date_entered);
 
     /* otherwise, sort on description string */
     da = ta->description ? ta->description : "";
@@ -1929,16 +2149,17 @@ xaccTransOrder_num_action (const Transaction *ta, const char *actna,
 /********************************************************************\
 \********************************************************************/
 
+/* The dates are kept in whole seconds; a Timespec's nanoseconds are
+ * dropped on the way in. */
 static inline void
-xaccTransSetDateInternal(Transaction *trans, Timespec *dadate, Timespec val)
+xaccTransSetDateInternal(Transaction *trans, time64 *dadate, time64 val)
 {
     xaccTransBeginEdit(trans);
 
     {
-        time64 secs = (time64) val.tv_sec;
-        gchar *tstr = gnc_ctime (&secs);
-        PINFO ("addr=%p set date to %" G_GUINT64_FORMAT ".%09ld %s\n",
-               trans, val.tv_sec, val.tv_nsec, tstr ? tstr : "(null)");
+        gchar *tstr = gnc_ctime (&val);
+        PINFO ("addr=%p set date to %" G_GINT64_FORMAT " %s\n",
+               trans, val, tstr ? tstr : "(null)");
         g_free(tstr);
     }
 
@@ -1965,9 +2186,8 @@ set_gains_date_dirty (Transaction *trans)
 void
 xaccTransSetDatePostedSecs (Transaction *trans, time64 secs)
 {
-    Timespec ts = {secs, 0};
     if (!trans) return;
-    xaccTransSetDateInternal(trans, &trans->date_posted, ts);
+    xaccTransSetDateInternal(trans, &trans->date_posted, secs);
     set_gains_date_dirty (trans);
 }
 
@@ -1993,16 +2213,15 @@ xaccTransSetDatePostedGDate (Transaction *trans, GDate date)
     qof_instance_set_kvp (QOF_INSTANCE(trans), TRANS_DATE_POSTED, &v);
     /* mark dirty and commit handled by SetDateInternal */
     xaccTransSetDateInternal(trans, &trans->date_posted,
-                             gdate_to_timespec(date));
+                             gdate_to_timespec(date).tv_sec);
     set_gains_date_dirty (trans);
 }
 
 void
 xaccTransSetDateEnteredSecs (Transaction *trans, time64 secs)
 {
-    Timespec ts = {secs, 0};
     if (!trans) return;
-    xaccTransSetDateInternal(trans, &trans->date_entered, ts);
+    xaccTransSetDateInternal(trans, &trans->date_entered, secs);
 }
 
 static void
@@ -2011,7 +2230,7 @@ qofTransSetDatePosted (Transaction *trans, Timespec ts)
     if (!trans) return;
     if ((ts.tv_nsec == 0) && (ts.tv_sec == 0)) return;
     if (!qof_begin_edit(&trans->inst)) return;
-    xaccTransSetDateInternal(trans, &trans->date_posted, ts);
+    xaccTransSetDateInternal(trans, &trans->date_posted, ts.tv_sec);
     set_gains_date_dirty(trans);
     qof_commit_edit(&trans->inst);
 }
@@ -2020,7 +2239,7 @@ void
 xaccTransSetDatePostedTS (Transaction *trans, const Timespec *ts)
 {
     if (!trans || !ts) return;
-    xaccTransSetDateInternal(trans, &trans->date_posted, *ts);
+    xaccTransSetDateInternal(trans, &trans->date_posted, ts->tv_sec);
     set_gains_date_dirty (trans);
 }
 
@@ -2030,7 +2249,7 @@ qofTransSetDateEntered (Transaction *trans, Timespec ts)
     if (!trans) return;
     if ((ts.tv_nsec == 0) && (ts.tv_sec == 0)) return;
     if (!qof_begin_edit(&trans->inst)) return;
-    xaccTransSetDateInternal(trans, &trans->date_entered, ts);
+    xaccTransSetDateInternal(trans, &trans->date_entered, ts.tv_sec);
     qof_commit_edit(&trans->inst);
 }
 
@@ -2038,7 +2257,7 @@ void
 xaccTransSetDateEnteredTS (Transaction *trans, const Timespec *ts)
 {
     if (!trans || !ts) return;
-    xaccTransSetDateInternal(trans, &trans->date_entered, *ts);
+    xaccTransSetDateInternal(trans, &trans->date_entered, ts->tv_sec);
 }
 
 void
@@ -2126,6 +2345,7 @@ xaccTransSetNum (Transaction *trans, const char *xnum)
     xaccTransBeginEdit(trans);
 
     CACHE_REPLACE(trans->num, xnum);
+    trans->sort_num_src = NULL;
     qof_instance_set_dirty(QOF_INSTANCE(trans));
     mark_trans(trans);  /* Dirty balance of every account in trans */
     xaccTransCommitEdit(trans);
@@ -2279,34 +2499,25 @@ xaccTransGetDescription (const Transaction *trans)
 const char *
 xaccTransGetAssociation (const Transaction *trans)
 {
-    GValue v = G_VALUE_INIT;
     if (!trans) return NULL;
-    qof_instance_get_kvp (QOF_INSTANCE (trans), assoc_uri_str, &v);
-    if (G_VALUE_HOLDS_STRING (&v))
-         return g_value_get_string (&v);
-    return NULL;
+    return qof_instance_get_kvp_string (QOF_INSTANCE (trans), 1, &assoc_uri_str);
 }
 
 const char *
 xaccTransGetNotes (const Transaction *trans)
 {
-    GValue v = G_VALUE_INIT;
     if (!trans) return NULL;
-    qof_instance_get_kvp (QOF_INSTANCE (trans), trans_notes_str, &v);
-    if (G_VALUE_HOLDS_STRING (&v))
-         return g_value_get_string (&v);
-    return NULL;
+    return qof_instance_get_kvp_string (QOF_INSTANCE (trans), 1, &trans_notes_str);
 }
 
 gboolean
 xaccTransGetIsClosingTxn (const Transaction *trans)
 {
-    GValue v = G_VALUE_INIT;
+    gint64 is_closing = 0;
     if (!trans) return FALSE;
-    qof_instance_get_kvp (QOF_INSTANCE (trans), trans_is_closing_str, &v);
-    if (G_VALUE_HOLDS_INT64 (&v))
-         return g_value_get_int64 (&v);
-    return FALSE;
+    qof_instance_get_kvp_int64 (QOF_INSTANCE (trans), &is_closing,
+                                1, &trans_is_closing_str);
+    return is_closing != 0;
 }
 
 /********************************************************************\
@@ -2315,14 +2526,14 @@ xaccTransGetIsClosingTxn (const Transaction *trans)
 time64
 xaccTransGetDate (const Transaction *trans)
 {
-    return trans ? trans->date_posted.tv_sec : 0;
+    return trans ? trans->date_posted : 0;
 }
 
 /*################## Added for Reg2 #################*/
 time64
 xaccTransGetDateEntered (const Transaction *trans)
 {
-    return trans ? trans->date_entered.tv_sec : 0;
+    return trans ? trans->date_entered : 0;
 }
 /*################## Added for Reg2 #################*/
 
@@ -2330,21 +2541,23 @@ void
 xaccTransGetDatePostedTS (const Transaction *trans, Timespec *ts)
 {
     if (trans && ts)
-        *ts = trans->date_posted;
+        timespecFromTime64 (ts, trans->date_posted);
 }
 
 void
 xaccTransGetDateEnteredTS (const Transaction *trans, Timespec *ts)
 {
     if (trans && ts)
-        *ts = trans->date_entered;
+        timespecFromTime64 (ts, trans->date_entered);
 }
 
 Timespec
 xaccTransRetDatePostedTS (const Transaction *trans)
 {
     Timespec ts = {0, 0};
-    return trans ? trans->date_posted : ts;
+    if (trans)
+        ts.tv_sec = trans->date_posted;
+    return ts;
 }
 
 GDate
@@ -2371,7 +2584,9 @@ Timespec
 xaccTransRetDateEnteredTS (const Transaction *trans)
 {
     Timespec ts = {0, 0};
-    return trans ? trans->date_entered : ts;
+    if (trans)
+        ts.tv_sec = trans->date_entered;
+    return ts;
 }
 
 void
@@ -2399,12 +2614,10 @@ char
 xaccTransGetTxnType (const Transaction *trans)
 {
     const char *s = NULL;
-    GValue v = G_VALUE_INIT;
 
     if (!trans) return TXN_TYPE_NONE;
-    qof_instance_get_kvp (QOF_INSTANCE (trans), TRANS_TXN_TYPE_KVP, &v);
-    if (G_VALUE_HOLDS_STRING (&v))
-         s = g_value_get_string (&v);
+    s = qof_instance_get_kvp_string (QOF_INSTANCE (trans),
+                                     G_N_ELEMENTS (txn_type_keys), txn_type_keys);
     if (s && strlen (s) == 1)
 	return *s;
 
@@ -2417,12 +2630,10 @@ xaccTransGetReadOnly (const Transaction *trans)
     /* XXX This flag should be cached in the transaction structure
      * for performance reasons, since its checked every trans commit.
      */
-    GValue v = G_VALUE_INIT;
     const char *s = NULL;
     if (trans == NULL) return NULL;
-    qof_instance_get_kvp (QOF_INSTANCE(trans), TRANS_READ_ONLY_REASON, &v);
-    if (G_VALUE_HOLDS_STRING (&v))
-         s = g_value_get_string (&v);
+    s = qof_instance_get_kvp_string (QOF_INSTANCE (trans),
+                                     G_N_ELEMENTS (read_only_keys), read_only_keys);
     if (s && strlen (s))
 	return s;
 
@@ -2500,7 +2711,7 @@ gboolean xaccTransInFutureByPostedDate (const Transaction *trans)
 
     present = gnc_time64_get_today_end ();
 
-    if (trans->date_posted.tv_sec > present)
+    if (trans->date_posted > present)
         result = TRUE;
     else
         result = FALSE;
@@ -2644,38 +2855,28 @@ gboolean
 xaccTransGetVoidStatus(const Transaction *trans)
 {
     const char *s = NULL;
-    GValue v = G_VALUE_INIT;
     g_return_val_if_fail(trans, FALSE);
 
-    qof_instance_get_kvp (QOF_INSTANCE (trans), void_reason_str, &v);
-    if (G_VALUE_HOLDS_STRING (&v))
-         s = g_value_get_string (&v);
+    s = qof_instance_get_kvp_string (QOF_INSTANCE (trans), 1, &void_reason_str);
     return s && strlen(s);
 }
 
 const char *
 xaccTransGetVoidReason(const Transaction *trans)
 {
-    GValue v = G_VALUE_INIT;
     g_return_val_if_fail(trans, FALSE);
 
-    qof_instance_get_kvp (QOF_INSTANCE (trans), void_reason_str, &v);
-    if (G_VALUE_HOLDS_STRING (&v))
-         return g_value_get_string (&v);
-    return NULL;
+    return qof_instance_get_kvp_string (QOF_INSTANCE (trans), 1, &void_reason_str);
 }
 
 Timespec
 xaccTransGetVoidTime(const Transaction *tr)
 {
-    GValue v = G_VALUE_INIT;
     const char *s = NULL;
-    Timespec void_time = {0, 0}, *ts;
+    Timespec void_time = {0, 0};
 
     g_return_val_if_fail(tr, void_time);
-    qof_instance_get_kvp (QOF_INSTANCE (tr), void_time_str, &v);
-    if (G_VALUE_HOLDS_STRING (&v))
-        s = g_value_get_string (&v);
+    s = qof_instance_get_kvp_string (QOF_INSTANCE (tr), 1, &void_time_str);
     if (s)
 	return gnc_iso8601_to_timespec_gmt (s);
     return void_time;
@@ -2742,12 +2943,13 @@ xaccTransReverse (Transaction *orig)
 Transaction *
 xaccTransGetReversedBy(const Transaction *trans)
 {
-    GValue v = G_VALUE_INIT;
+    const GncGUID *guid;
     g_return_val_if_fail(trans, NULL);
-    qof_instance_get_kvp (QOF_INSTANCE(trans), TRANS_REVERSED_BY, &v);
-    if (G_VALUE_HOLDS_BOXED (&v))
-        return xaccTransLookup((GncGUID*)g_value_get_boxed (&v),
-                               qof_instance_get_book(trans));
+    guid = qof_instance_get_kvp_guid (QOF_INSTANCE (trans),
+                                      G_N_ELEMENTS (reversed_by_keys),
+                                      reversed_by_keys);
+    if (guid)
+        return xaccTransLookup(guid, qof_instance_get_book(trans));
     return NULL;
 }
 
@@ -2800,7 +3002,7 @@ xaccTransScrubGainsDate (Transaction *trans)
              (s->gains & GAINS_STATUS_DATE_DIRTY)))
         {
             Transaction *source_trans = s->gains_split->parent;
-            ts = source_trans->date_posted;
+            ts = xaccTransRetDatePostedTS (source_trans);
             s->gains &= ~GAINS_STATUS_DATE_DIRTY;
             s->gains_split->gains &= ~GAINS_STATUS_DATE_DIRTY;
 
@@ -2919,6 +3121,16 @@ trans_is_balanced_p (const Transaction *trans)
     return trans ? xaccTransIsBalanced(trans) : FALSE;
 }
 
+/* A transaction query's results can change with any of its splits. */
+static void
+split_trans_dependents (QofInstance *changed, QofInstanceForeachCB cb,
+                        gpointer user_data)
+{
+    Transaction *trans = xaccSplitGetParent (GNC_SPLIT (changed));
+    if (trans)
+        cb (QOF_INSTANCE (trans), user_data);
+}
+
 gboolean xaccTransRegister (void)
 {
     static QofParam params[] =
@@ -3003,6 +3215,9 @@ gboolean xaccTransRegister (void)
         };
 
     qof_class_register (GNC_ID_TRANS, (QofSortFunc)xaccTransOrder, params);
+    qof_query_register_dependents (GNC_ID_TRANS, GNC_ID_SPLIT,
+                                   split_trans_dependents);
+    gnc_text_index_register ();
 
     return qof_object_register (&trans_object_def);
 }
@@ -75,8 +75,10 @@ struct transaction_s
 {
     QofInstance inst;     /* glbally unique id */
 
-    Timespec date_entered;     /* date register entry was made              */
-    Timespec date_posted;      /* date transaction was posted at bank       */
+    /* Whole seconds, as nearly everything that reads them wants; the
+     * Timespec accessors convert. */
+    time64 date_entered;       /* date register entry was made              */
+    time64 date_posted;        /* date transaction was posted at bank       */
 
     /* The num field is a arbitrary user-assigned field.
      * It is intended to store a short id number, typically the check number,
@@ -84,6 +86,13 @@ struct transaction_s
      */
     char * num;
 
+    /* The leading number of num, as xaccTransOrder() sorts on it, and
+     * the num string it was parsed from.  The number is reparsed
+     * whenever num is no longer that string; the setters reset
+     * sort_num_src so that a reused string address can't fool it. */
+    const char * sort_num_src;
+    gint sort_num;
+
     /* The description field is an arbitrary user-assigned value.
      * It is meant to be a short descriptive phrase.
      */
@@ -97,6 +106,12 @@ struct transaction_s
 
     GList * splits; /* list of splits */
 
+    /* The sum of the split values as xaccTransGetImbalanceValue()
+     * returns it, valid only while imbal_valid is set.  The split
+     * setters clear it through xaccTransInvalidateImbalance(). */
+    gnc_numeric imbal_value;
+    gboolean imbal_valid;
+
     /* marker is used to track the progress of transaction traversals.
      * 0 is never a legitimate marker value, so we can tell is we hit
      * a new transaction in the middle of a traversal. All each new
@@ -110,6 +125,9 @@ struct transaction_s
      * any changes made if/when the edit is abandoned.
      */
     Transaction *orig;
+
+    /* Set while xaccTransEvict() takes the transaction out of memory. */
+    gboolean evicting;
 };
 
 struct _TransactionClass
@@ -122,6 +140,12 @@ struct _TransactionClass
  * call this on an existing transaction! */
 #define xaccTransSetGUID(t,g) qof_instance_set_guid(QOF_INSTANCE(t),g)
 
+/* Creates a transaction being read from a datafile with the GncGUID it
+ * was saved with, instead of making up one for xaccTransSetGUID() to
+ * replace. */
+Transaction * xaccMallocTransactionForLoad (QofBook *book,
+                                            const GncGUID *guid);
+
 /* This routine makes a 'duplicate' of the indicated transaction.
  * This routine cannot be exposed publically since the duplicate
  * is wrong in many ways: it is not issued a unique guid, and thus
@@ -165,6 +189,55 @@ void xaccEnableDataScrubbing(void);
 void xaccDisableDataScrubbing(void);
 
 void xaccTransRemoveSplit (Transaction *trans, const Split *split);
+
+/* Forget the cached imbalance of the transaction.  Anything changing the
+ * value of one of its splits, or which splits it has, must call this. */
+void xaccTransInvalidateImbalance (Transaction *trans);
+
+/* How often xaccTransGetImbalanceValue() was answered from the cache
+ * and how often it had to add up the splits, since startup. */
+void xaccTransGetImbalanceCacheStats (guint64 *hits, guint64 *misses);
+
+/* The leading number of the transaction's num string, parsed once and
+ * cached; 0 for a NULL transaction. */
+gint xaccTransGetSortNum (const Transaction *trans);
+
+/* xaccTransOrder_num_action() for numbers already parsed from the
+ * transactions' num or their splits' action strings. */
+int xaccTransOrderSortNums (const Transaction *ta, gint na,
+                            const Transaction *tb, gint nb);
+
+/* A backend which leaves transactions out of memory, and takes them out
+ * again, can bring them back when they are looked up by GUID through a
+ * transaction source set on the book.  load_trans loads the transaction
+ * with the GUID and load_split the one holding the split with the GUID;
+ * both return it, or NULL.  used is told of each transaction that
+ * xaccTransLookup() finds in memory. */
+typedef struct
+{
+    Transaction * (*load_trans) (QofBook *book, const GncGUID *guid,
+                                 gpointer user_data);
+    Transaction * (*load_split) (QofBook *book, const GncGUID *guid,
+                                 gpointer user_data);
+    void (*used) (Transaction *trans, gpointer user_data);
+} GncTransSource;
+
+/* Set the book's transaction source, or with a NULL source remove it.
+ * The source isn't copied and has to outlive its use. */
+void gnc_book_set_trans_source (QofBook *book, const GncTransSource *source,
+                                gpointer user_data);
+
+/* Ask the book's transaction source for the transaction holding the
+ * split with the GUID.  Returns it, or NULL. */
+Transaction *gnc_book_load_split_trans (QofBook *book, const GncGUID *guid);
+
+/* Take a transaction and its splits out of memory as though it had been
+ * destroyed, for a backend which can load it again.  Nothing is logged
+ * and its capital gains are left alone.  The transaction must not be
+ * open, and the backend calling this has to ignore the commits it
+ * causes.  Accounts lose the transaction's splits from their balances,
+ * so a backend keeping starting balances must add them back first. */
+void xaccTransEvict (Transaction *trans);
 void check_open (const Transaction *trans);
 
 /* Structure for accessing static functions for testing */
@@ -111,6 +111,12 @@ GLIST_HELPER_INOUT(OwnerList, SWIGTYPE_p__gncOwner);
 #endif
 
 
+/* Declared with GList in the header, which can't see AccountValueList;
+ * the list belongs to the invoice. */
+AccountValueList * gncInvoiceGetTotalTaxValues (GncInvoice *invoice);
+%ignore gncInvoiceGetTotalTaxValues;
+%ignore gncEntryPeekTaxValues;
+
 /* Parse the header files to generate wrappers */
 %include <gncAddress.h>
 %include <gncBillTerm.h>
@@ -44,6 +44,7 @@ AccountList * gnc_account_get_descendants_sorted (const Account *account);
 %ignore gnc_account_get_children_sorted;
 %ignore gnc_account_get_descendants;
 %ignore gnc_account_get_descendants_sorted;
+%newobject gnc_account_tax_totals_get_splits;
 %include <Account.h>
 
 %include <Transaction.h>
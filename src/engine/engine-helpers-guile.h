@@ -50,6 +50,20 @@ GSList * gnc_query_scm2path (SCM path_scm);
 SCM gnc_query2scm (QofQuery * q);
 QofQuery * gnc_scm2query (SCM query_scm);
 
+/* Query handles wrap a query in a Scheme object which owns it and
+ * destroys it when it is garbage collected.  gnc_query2handle() copies
+ * the query, gnc_scm2query_handle() reads the list form above and
+ * gnc_string2query_handle() the string of qof_query_to_string(); each
+ * returns #f if there is no query.  gnc_handle2query() returns the
+ * handle's own query, which the caller must not destroy, or NULL if
+ * the object is not a query handle. */
+SCM gnc_query2handle (QofQuery *q);
+SCM gnc_scm2query_handle (SCM query_scm);
+SCM gnc_string2query_handle (const char *str);
+gboolean gnc_query_handle_p (SCM handle);
+QofQuery * gnc_handle2query (SCM handle);
+SCM gnc_query_handle2string (SCM handle);
+
 int gnc_gh_gint64_p(SCM num);
 
 SCM gnc_numeric_to_scm(gnc_numeric arg);
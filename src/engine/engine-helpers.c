@@ -34,7 +34,6 @@
 #include "glib-helpers.h"
 #include "gnc-date.h"
 #include "gnc-engine.h"
-#include "gnc-session.h"
 #include "guile-mappings.h"
 #include "gnc-guile-utils.h"
 #include <qof.h>
@@ -81,6 +80,20 @@ gnc_transaction_set_date(Transaction *t, Timespec ts)
     xaccTransSetDatePostedTS(t, &ts);
 }
 
+/* The book option of the objects' own book, which need not be the
+ * current session's when a process has several books open. */
+static gboolean
+book_uses_split_action_for_num (const Transaction *trans, const Split *split)
+{
+    QofBook *book = NULL;
+
+    if (trans)
+        book = xaccTransGetBook (trans);
+    else if (split)
+        book = xaccSplitGetBook (split);
+    return book && qof_book_use_split_action_for_num_field (book);
+}
+
 /** Gets the transaction Number or split Action based on book option:
   * if the book option is TRUE (split action is used for NUM) and a
   * split is provided, split-action is returned; if book option is FALSE
@@ -91,8 +104,7 @@ gnc_transaction_set_date(Transaction *t, Timespec ts)
 const char *
 gnc_get_num_action (const Transaction *trans, const Split *split)
 {
-    gboolean num_action = qof_book_use_split_action_for_num_field
-                           (qof_session_get_book(gnc_get_current_session ()));
+    gboolean num_action = book_uses_split_action_for_num (trans, split);
 
     if (trans && !split)
         return xaccTransGetNum(trans);
@@ -117,8 +129,7 @@ gnc_get_num_action (const Transaction *trans, const Split *split)
 const char *
 gnc_get_action_num (const Transaction *trans, const Split *split)
 {
-    gboolean num_action = qof_book_use_split_action_for_num_field
-                           (qof_session_get_book(gnc_get_current_session ()));
+    gboolean num_action = book_uses_split_action_for_num (trans, split);
 
     if (trans && !split)
         return xaccTransGetNum(trans);
@@ -149,8 +160,7 @@ void
 gnc_set_num_action (Transaction *trans, Split *split,
                     const char *num, const char *action)
 {
-    gboolean num_action = qof_book_use_split_action_for_num_field
-                           (qof_session_get_book(gnc_get_current_session ()));
+    gboolean num_action = book_uses_split_action_for_num (trans, split);
 
     if (trans && num && !split && !action)
     {
@@ -286,6 +296,173 @@ gnc_book_option_remove_cb (gchar *key, GncBOCb func, gpointer user_data)
     }
 }
 
+/* The index behind gnc_trans_dup_index_lookup: the splits of the old
+ * account tree, bucketed by their account's full name and value. */
+struct _GncTransDupIndex
+{
+    GHashTable *buckets;  /* TransDupKey* -> GPtrArray of Split* */
+    GList *names;         /* The account full names the keys point to */
+};
+
+typedef struct
+{
+    const gchar *name;
+    gnc_numeric value;    /* reduced, so that equal values hash alike */
+} TransDupKey;
+
+#define TRANS_DUP_WINDOW (7 * 24 * 60 * 60)
+
+static guint
+trans_dup_key_hash (gconstpointer key)
+{
+    const TransDupKey *k = key;
+    return g_str_hash (k->name) ^ g_int64_hash (&k->value.num)
+           ^ (g_int64_hash (&k->value.denom) << 1);
+}
+
+static gboolean
+trans_dup_key_equal (gconstpointer a, gconstpointer b)
+{
+    const TransDupKey *ka = a, *kb = b;
+    return gnc_numeric_equal (ka->value, kb->value) &&
+           g_strcmp0 (ka->name, kb->name) == 0;
+}
+
+static void
+trans_dup_bucket_free (gpointer bucket)
+{
+    g_ptr_array_free (bucket, TRUE);
+}
+
+GncTransDupIndex *
+gnc_trans_dup_index_new (Account *old_root)
+{
+    GncTransDupIndex *index;
+    GList *accounts, *node;
+
+    g_return_val_if_fail (old_root, NULL);
+
+    index = g_new0 (GncTransDupIndex, 1);
+    index->buckets = g_hash_table_new_full (trans_dup_key_hash, trans_dup_key_equal,
+                                            g_free, trans_dup_bucket_free);
+
+    accounts = gnc_account_get_descendants (old_root);
+    for (node = accounts; node; node = node->next)
+    {
+        Account *acc = node->data;
+        gchar *name;
+        GList *snode;
+
+        if (xaccAccountGetSplitList (acc) == NULL)
+            continue;
+
+        name = gnc_account_get_full_name (acc);
+        index->names = g_list_prepend (index->names, name);
+
+        for (snode = xaccAccountGetSplitList (acc); snode; snode = snode->next)
+        {
+            Split *split = snode->data;
+            TransDupKey key = { name, gnc_numeric_reduce (xaccSplitGetValue (split)) };
+            GPtrArray *bucket = g_hash_table_lookup (index->buckets, &key);
+
+            if (!bucket)
+            {
+                bucket = g_ptr_array_new ();
+                g_hash_table_insert (index->buckets, g_memdup (&key, sizeof key), bucket);
+            }
+            g_ptr_array_add (bucket, split);
+        }
+    }
+    g_list_free (accounts);
+
+    return index;
+}
+
+void
+gnc_trans_dup_index_destroy (GncTransDupIndex *index)
+{
+    if (!index) return;
+
+    g_hash_table_destroy (index->buckets);
+    g_list_free_full (index->names, g_free);
+    g_free (index);
+}
+
+TransList *
+gnc_trans_dup_index_lookup (GncTransDupIndex *index, Transaction *trans)
+{
+    GHashTable *matched_splits, *seen;
+    GList *node, *matches = NULL;
+    time64 date;
+    gint num_splits = 0;
+
+    g_return_val_if_fail (index, NULL);
+    g_return_val_if_fail (trans, NULL);
+
+    date = xaccTransGetDate (trans);
+    matched_splits = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+    /* Collect the old splits with the account name and value of one of
+     * the transaction's splits, posted within a week of it. */
+    for (node = xaccTransGetSplitList (trans); node; node = node->next)
+    {
+        Split *split = node->data;
+        TransDupKey key;
+        GPtrArray *bucket;
+        gchar *name;
+        guint i;
+
+        if (!xaccTransStillHasSplit (trans, split))
+            continue;
+        num_splits++;
+
+        name = gnc_account_get_full_name (xaccSplitGetAccount (split));
+        key.name = name;
+        key.value = gnc_numeric_reduce (xaccSplitGetValue (split));
+        bucket = g_hash_table_lookup (index->buckets, &key);
+        g_free (name);
+        if (!bucket)
+            continue;
+
+        for (i = 0; i < bucket->len; i++)
+        {
+            Split *old_split = g_ptr_array_index (bucket, i);
+            time64 old_date = xaccTransGetDate (xaccSplitGetParent (old_split));
+
+            if (old_date >= date - TRANS_DUP_WINDOW && old_date <= date + TRANS_DUP_WINDOW)
+                g_hash_table_insert (matched_splits, old_split, old_split);
+        }
+    }
+
+    /* A transaction with more than two splits is taken to be complete,
+     * so only old transactions all of whose splits matched are
+     * candidates.  Others may be incomplete and one matching split is
+     * enough (see bug 481528). */
+    seen = g_hash_table_new (g_direct_hash, g_direct_equal);
+    for (node = g_hash_table_get_keys (matched_splits); node; node = g_list_delete_link (node, node))
+    {
+        Transaction *old_trans = xaccSplitGetParent (node->data);
+        GList *snode;
+        gboolean all_matched = TRUE;
+
+        if (g_hash_table_lookup (seen, old_trans))
+            continue;
+        g_hash_table_insert (seen, old_trans, old_trans);
+
+        if (num_splits > 2)
+            for (snode = xaccTransGetSplitList (old_trans); snode && all_matched; snode = snode->next)
+                if (!g_hash_table_lookup (matched_splits, snode->data))
+                    all_matched = FALSE;
+
+        if (all_matched)
+            matches = g_list_prepend (matches, old_trans);
+    }
+    g_hash_table_destroy (seen);
+    g_hash_table_destroy (matched_splits);
+
+    return matches;
+}
+
 SCM
 gnc_timespec2timepair(Timespec t)
 {
@@ -1998,6 +2175,120 @@ gnc_scm2query (SCM query_scm)
     return q;
 }
 
+/* Query handles: a query object owned by the Guile garbage collector.
+ * Passing a handle around in Scheme costs nothing, and when the last
+ * reference to it is gone the collector destroys the query, so unlike
+ * the list form there is nothing to convert on every use and unlike a
+ * bare query pointer nothing to destroy by hand. */
+
+static scm_t_bits query_handle_tag = 0;
+
+static size_t
+query_handle_free (SCM handle)
+{
+    QofQuery *q = (QofQuery *) SCM_SMOB_DATA (handle);
+
+    SCM_SET_SMOB_DATA (handle, NULL);
+    if (q)
+        qof_query_destroy (q);
+    return 0;
+}
+
+static int
+query_handle_print (SCM handle, SCM port, scm_print_state *pstate)
+{
+    QofQuery *q = (QofQuery *) SCM_SMOB_DATA (handle);
+    const char *search_for = q ? qof_query_get_search_for (q) : NULL;
+
+    scm_puts ("#<gnc-query ", port);
+    scm_puts (search_for ? search_for : "-", port);
+    scm_puts (">", port);
+    return 1;
+}
+
+static SCM
+query_handle_equalp (SCM handle1, SCM handle2)
+{
+    return scm_from_bool (qof_query_equal
+                          ((QofQuery *) SCM_SMOB_DATA (handle1),
+                           (QofQuery *) SCM_SMOB_DATA (handle2)));
+}
+
+static void
+query_handle_init (void)
+{
+    if (query_handle_tag)
+        return;
+    query_handle_tag = scm_make_smob_type ("gnc-query", 0);
+    scm_set_smob_free (query_handle_tag, query_handle_free);
+    scm_set_smob_print (query_handle_tag, query_handle_print);
+    scm_set_smob_equalp (query_handle_tag, query_handle_equalp);
+}
+
+/* Takes over the query. */
+static SCM
+query_handle_new (QofQuery *q)
+{
+    if (!q)
+        return SCM_BOOL_F;
+    query_handle_init ();
+    SCM_RETURN_NEWSMOB (query_handle_tag, q);
+}
+
+SCM
+gnc_query2handle (QofQuery *q)
+{
+    if (!q)
+        return SCM_BOOL_F;
+    return query_handle_new (qof_query_copy (q));
+}
+
+SCM
+gnc_scm2query_handle (SCM query_scm)
+{
+    return query_handle_new (gnc_scm2query (query_scm));
+}
+
+gboolean
+gnc_query_handle_p (SCM handle)
+{
+    query_handle_init ();
+    return SCM_SMOB_PREDICATE (query_handle_tag, handle);
+}
+
+QofQuery *
+gnc_handle2query (SCM handle)
+{
+    if (!gnc_query_handle_p (handle))
+        return NULL;
+    return (QofQuery *) SCM_SMOB_DATA (handle);
+}
+
+SCM
+gnc_query_handle2string (SCM handle)
+{
+    QofQuery *q = gnc_handle2query (handle);
+    gchar *str;
+    SCM str_scm;
+
+    if (!q)
+        return SCM_BOOL_F;
+    str = qof_query_to_string (q);
+    if (!str)
+        return SCM_BOOL_F;
+    str_scm = scm_from_utf8_string (str);
+    g_free (str);
+    return str_scm;
+}
+
+SCM
+gnc_string2query_handle (const char *str)
+{
+    if (!str)
+        return SCM_BOOL_F;
+    return query_handle_new (qof_query_from_string (str));
+}
+
 int
 gnc_gh_gint64_p(SCM num)
 {
@@ -91,4 +91,25 @@ gnc_book_option_register_cb (gchar *key, GncBOCb func, gpointer user_data);
 void
 gnc_book_option_remove_cb (gchar *key, GncBOCb func, gpointer user_data);
 
+/** An index of the transactions in an account tree, for finding the
+  * ones an imported transaction may duplicate without running a query
+  * per imported transaction. */
+typedef struct _GncTransDupIndex GncTransDupIndex;
+
+/** Indexes the splits in the accounts below old_root by their account's
+  * full name and their value. The index must be destroyed before any of
+  * those splits is. */
+GncTransDupIndex *gnc_trans_dup_index_new (Account *old_root);
+
+void gnc_trans_dup_index_destroy (GncTransDupIndex *index);
+
+/** Returns the transactions in the indexed tree that may be duplicated
+  * by trans, which belongs to another account tree: those posted within
+  * a week of it with a split whose value equals that of one of the
+  * splits of trans and whose account has the same full name. If trans
+  * has more than two splits, all the splits of a candidate must match
+  * that way. The caller must free the returned list, but not the
+  * transactions. */
+TransList *gnc_trans_dup_index_lookup (GncTransDupIndex *index, Transaction *trans);
+
 #endif
@@ -104,6 +104,7 @@ functions. */
 %newobject xaccQueryGetSplitsUniqueTrans;
 %newobject xaccQueryGetTransactions;
 %newobject xaccQueryGetLots;
+%newobject gnc_trans_dup_index_lookup;
 
 %newobject xaccSplitGetCorrAccountFullName;
 %newobject gnc_numeric_to_string;
@@ -203,8 +204,72 @@ SplitList * qof_query_run_subquery (QofQuery *q, const QofQuery *q);
 
 Timespec timespecCanonicalDayTime(Timespec t);
 
+%ignore gnc_budget_get_account_period_values;
+%ignore gnc_budget_get_period_value_matrix;
+%ignore gnc_budget_get_account_period_actual_values;
+%ignore gnc_budget_get_period_actual_value_matrix;
 %include <gnc-budget.h>
 
+%inline %{
+/* The account's actual values for all the budget's periods, as a vector
+ * indexed by period.  Cheaper than asking for them one at a time. */
+static SCM gnc_budget_get_account_period_actual_vector (GncBudget *budget,
+                                                        Account *acc)
+{
+    guint i, num_periods = gnc_budget_get_num_periods (budget);
+    gnc_numeric *values = g_new (gnc_numeric, MAX (num_periods, 1));
+    SCM vec = scm_c_make_vector (num_periods, SCM_BOOL_F);
+
+    gnc_budget_get_account_period_actual_values (budget, acc, values);
+    for (i = 0; i < num_periods; i++)
+        scm_c_vector_set_x (vec, i, gnc_numeric_to_scm (values[i]));
+    g_free (values);
+    return vec;
+}
+
+/* The account's balance at each of a list of timepairs, in increasing
+ * order, as a list.  Splits posted at a date count towards its balance,
+ * as in gnc:account-get-comm-balance-at-date. */
+static SCM gnc_account_get_balances_at_dates (Account *acc, SCM dates)
+{
+    guint i, n_dates = scm_to_uint (scm_length (dates));
+    time64 *secs = g_new (time64, MAX (n_dates, 1));
+    gnc_numeric *balances = g_new (gnc_numeric, MAX (n_dates, 1));
+    SCM list = SCM_EOL;
+
+    for (i = 0; i < n_dates; i++, dates = SCM_CDR (dates))
+        secs[i] = gnc_timepair2timespec (SCM_CAR (dates)).tv_sec + 1;
+    xaccAccountGetBalancesAsOfDates (acc, secs, n_dates, balances);
+    for (i = n_dates; i > 0; i--)
+        list = scm_cons (gnc_numeric_to_scm (balances[i - 1]), list);
+    g_free (secs);
+    g_free (balances);
+    return list;
+}
+
+/* gnc_account_tax_totals_new for a list of periods, each a pair of
+ * timepairs (start . end). */
+static GncAccountTaxTotals *gnc_account_tax_totals_new_for_periods (
+    Account *root, SCM periods)
+{
+    guint i, n_periods = scm_to_uint (scm_length (periods));
+    time64 *starts = g_new (time64, MAX (n_periods, 1));
+    time64 *ends = g_new (time64, MAX (n_periods, 1));
+    GncAccountTaxTotals *totals;
+
+    for (i = 0; i < n_periods; i++, periods = SCM_CDR (periods))
+    {
+        SCM period = SCM_CAR (periods);
+        starts[i] = gnc_timepair2timespec (SCM_CAR (period)).tv_sec;
+        ends[i] = gnc_timepair2timespec (SCM_CDR (period)).tv_sec;
+    }
+    totals = gnc_account_tax_totals_new (root, starts, ends, n_periods);
+    g_free (starts);
+    g_free (ends);
+    return totals;
+}
+%}
+
 %typemap(in) GList * {
   SCM path_scm = $input;
   GList *path = NULL;
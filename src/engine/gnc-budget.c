@@ -72,6 +72,10 @@ typedef struct BudgetPrivate
 
     /* Number of periods */
     guint  num_periods;
+
+    /* Dense copy of the period values kept in the KVP, built per
+     * account on first use: GncGUID* -> gnc_numeric[num_periods]. */
+    GHashTable *period_values;
 } BudgetPrivate;
 
 #define GET_PRIVATE(o) \
@@ -99,6 +103,11 @@ gnc_budget_init(GncBudget* budget)
     gnc_gdate_set_today (&date);
     g_date_subtract_days(&date, g_date_get_day(&date) - 1);
     recurrenceSet(&priv->recurrence, 1, PERIOD_MONTH, &date, WEEKEND_ADJ_NONE);
+
+    priv->period_values = g_hash_table_new_full (guid_hash_to_guint,
+                                                 guid_g_hash_table_equal,
+                                                 (GDestroyNotify) guid_free,
+                                                 g_free);
 }
 
 static void
@@ -110,6 +119,7 @@ gnc_budget_dispose (GObject *budgetp)
 static void
 gnc_budget_finalize(GObject* budgetp)
 {
+    g_hash_table_destroy (GET_PRIVATE(budgetp)->period_values);
     G_OBJECT_CLASS(gnc_budget_parent_class)->finalize(budgetp);
 }
 
@@ -324,16 +334,18 @@ static void
 clone_budget_values_cb(Account* a, gpointer user_data)
 {
     CloneBudgetData_t* data = (CloneBudgetData_t*)user_data;
+    gnc_numeric *values = g_new (gnc_numeric, data->num_periods);
+    gboolean *is_set = g_new (gboolean, data->num_periods);
     guint i;
 
+    gnc_budget_get_account_period_values (data->old_b, a, values, is_set);
     for ( i = 0; i < data->num_periods; ++i )
     {
-        if ( gnc_budget_is_account_period_value_set(data->old_b, a, i) )
-        {
-            gnc_budget_set_account_period_value(data->new_b, a, i,
-                                                gnc_budget_get_account_period_value(data->old_b, a, i));
-        }
+        if ( is_set[i] )
+            gnc_budget_set_account_period_value(data->new_b, a, i, values[i]);
     }
+    g_free (values);
+    g_free (is_set);
 }
 
 GncBudget*
@@ -460,6 +472,7 @@ gnc_budget_set_num_periods(GncBudget* budget, guint num_periods)
 
     gnc_budget_begin_edit(budget);
     priv->num_periods = num_periods;
+    g_hash_table_remove_all (priv->period_values);
     qof_instance_set_dirty(&budget->inst);
     gnc_budget_commit_edit(budget);
 
@@ -473,17 +486,87 @@ gnc_budget_get_num_periods(const GncBudget* budget)
     return GET_PRIVATE(budget)->num_periods;
 }
 
-#define BUF_SIZE (10 + GUID_ENCODING_LENGTH + \
-   GNC_BUDGET_MAX_NUM_PERIODS_DIGITS)
+/* The period values live at <account guid>/<period number>; the two keys
+ * are handed to the KVP already split rather than joined with a '/'. */
+typedef struct
+{
+    gchar guid[GUID_ENCODING_LENGTH + 1];
+    gchar period[10 + GNC_BUDGET_MAX_NUM_PERIODS_DIGITS];
+    const gchar *keys[2];
+} PeriodPath;
 
 static inline void
-make_period_path (const Account *account, guint period_num, char *path)
+make_period_path (const Account *account, guint period_num, PeriodPath *path)
+{
+    guid_to_string_buff(xaccAccountGetGUID(account), path->guid);
+    g_snprintf(path->period, sizeof(path->period), "%d", period_num);
+    path->keys[0] = path->guid;
+    path->keys[1] = path->period;
+}
+
+/* An unset period is held as a numeric that fails gnc_numeric_check(),
+ * the same way the setter treats such a value as a request to unset. */
+#define PERIOD_VALUE_UNSET gnc_numeric_error (GNC_ERROR_ARG)
+
+typedef struct
+{
+    gnc_numeric *values;
+    guint num_periods;
+} PeriodValuesFill;
+
+static void
+fill_period_value (const char *key, const GValue *value, gpointer user_data)
 {
-    const GncGUID *guid;
-    gchar *bufend;
-    guid = xaccAccountGetGUID(account);
-    bufend = guid_to_string_buff(guid, path);
-    g_sprintf(bufend, "/%d", period_num);
+    PeriodValuesFill *fill = user_data;
+    gchar *end;
+    guint64 period_num = g_ascii_strtoull (key, &end, 10);
+
+    if (*end || end == key || period_num >= fill->num_periods)
+        return;
+    if (G_VALUE_HOLDS_BOXED (value) && g_value_get_boxed (value))
+        fill->values[period_num] = *(gnc_numeric*) g_value_get_boxed (value);
+}
+
+/* Returns the account's row of num_periods values, reading it from the
+ * KVP in one pass over the account's frame the first time. */
+static gnc_numeric *
+get_period_values (const GncBudget *budget, const Account *account)
+{
+    BudgetPrivate *priv = GET_PRIVATE(budget);
+    const GncGUID *guid = xaccAccountGetGUID (account);
+    gchar guid_str[GUID_ENCODING_LENGTH + 1];
+    PeriodValuesFill fill;
+    guint i;
+
+    fill.values = g_hash_table_lookup (priv->period_values, guid);
+    if (fill.values)
+        return fill.values;
+
+    fill.num_periods = priv->num_periods;
+    fill.values = g_new (gnc_numeric, MAX (fill.num_periods, 1));
+    for (i = 0; i < fill.num_periods; i++)
+        fill.values[i] = PERIOD_VALUE_UNSET;
+    guid_to_string_buff (guid, guid_str);
+    qof_instance_foreach_slot (QOF_INSTANCE (budget), guid_str,
+                               fill_period_value, &fill);
+
+    g_hash_table_insert (priv->period_values, guid_copy (guid), fill.values);
+    return fill.values;
+}
+
+/* Keeps an already built row in step with a change to the KVP. Rows
+ * not built yet are left alone; they are read from the KVP when
+ * first needed. */
+static void
+update_period_value (GncBudget *budget, const Account *account,
+                     guint period_num, gnc_numeric val)
+{
+    BudgetPrivate *priv = GET_PRIVATE(budget);
+    gnc_numeric *values = g_hash_table_lookup (priv->period_values,
+                                               xaccAccountGetGUID (account));
+
+    if (values && period_num < priv->num_periods)
+        values[period_num] = val;
 }
 /* period_num is zero-based */
 /* What happens when account is deleted, after we have an entry for it? */
@@ -491,14 +574,15 @@ void
 gnc_budget_unset_account_period_value(GncBudget *budget, const Account *account,
                                       guint period_num)
 {
-    gchar path[BUF_SIZE];
+    PeriodPath path;
 
     g_return_if_fail (budget != NULL);
     g_return_if_fail (account != NULL);
-    make_period_path (account, period_num, path);
+    make_period_path (account, period_num, &path);
 
     gnc_budget_begin_edit(budget);
-    qof_instance_set_kvp (QOF_INSTANCE (budget), path, NULL);
+    qof_instance_set_kvp_keys (QOF_INSTANCE (budget), NULL, G_N_ELEMENTS (path.keys), path.keys);
+    update_period_value (budget, account, period_num, PERIOD_VALUE_UNSET);
     qof_instance_set_dirty(&budget->inst);
     gnc_budget_commit_edit(budget);
 
@@ -512,7 +596,7 @@ void
 gnc_budget_set_account_period_value(GncBudget *budget, const Account *account,
                                     guint period_num, gnc_numeric val)
 {
-    gchar path[BUF_SIZE];
+    PeriodPath path;
 
     /* Watch out for an off-by-one error here:
      * period_num starts from 0 while num_periods starts from 1 */
@@ -525,18 +609,20 @@ gnc_budget_set_account_period_value(GncBudget *budget, const Account *account,
     g_return_if_fail (budget != NULL);
     g_return_if_fail (account != NULL);
 
-    make_period_path (account, period_num, path);
+    make_period_path (account, period_num, &path);
 
     gnc_budget_begin_edit(budget);
     if (gnc_numeric_check(val))
-        qof_instance_set_kvp (QOF_INSTANCE (budget), path, NULL);
+        qof_instance_set_kvp_keys (QOF_INSTANCE (budget), NULL, G_N_ELEMENTS (path.keys), path.keys);
     else
     {
         GValue v = G_VALUE_INIT;
         g_value_init (&v, GNC_TYPE_NUMERIC);
         g_value_set_boxed (&v, &val);
-        qof_instance_set_kvp (QOF_INSTANCE (budget), path, &v);
+        qof_instance_set_kvp_keys (QOF_INSTANCE (budget), &v, G_N_ELEMENTS (path.keys), path.keys);
     }
+    update_period_value (budget, account, period_num,
+                         gnc_numeric_check(val) ? PERIOD_VALUE_UNSET : val);
     qof_instance_set_dirty(&budget->inst);
     gnc_budget_commit_edit(budget);
 
@@ -552,18 +638,17 @@ gnc_budget_is_account_period_value_set(const GncBudget *budget,
                                        const Account *account,
                                        guint period_num)
 {
-    GValue v = G_VALUE_INIT;
-    gchar path[BUF_SIZE];
-    gconstpointer ptr = NULL;
+    PeriodPath path;
 
     g_return_val_if_fail(GNC_IS_BUDGET(budget), FALSE);
     g_return_val_if_fail(account, FALSE);
 
-    make_period_path (account, period_num, path);
-    qof_instance_get_kvp (QOF_INSTANCE (budget), path, &v);
-    if (G_VALUE_HOLDS_BOXED (&v))
-        ptr = g_value_get_boxed (&v);
-    return (ptr != NULL);
+    if (period_num < GET_PRIVATE(budget)->num_periods)
+        return !gnc_numeric_check (get_period_values (budget, account)[period_num]);
+
+    make_period_path (account, period_num, &path);
+    return qof_instance_get_kvp_numeric (QOF_INSTANCE (budget), NULL,
+                                         G_N_ELEMENTS (path.keys), path.keys);
 }
 
 gnc_numeric
@@ -571,23 +656,66 @@ gnc_budget_get_account_period_value(const GncBudget *budget,
                                     const Account *account,
                                     guint period_num)
 {
-    gnc_numeric *numeric = NULL;
-    gchar path[BUF_SIZE];
-    GValue v = G_VALUE_INIT;
+    gnc_numeric numeric;
+    PeriodPath path;
 
     g_return_val_if_fail(GNC_IS_BUDGET(budget), gnc_numeric_zero());
     g_return_val_if_fail(account, gnc_numeric_zero());
 
-    make_period_path (account, period_num, path);
-    qof_instance_get_kvp (QOF_INSTANCE (budget), path, &v);
-    if (G_VALUE_HOLDS_BOXED (&v))
-        numeric = (gnc_numeric*)g_value_get_boxed (&v);
+    if (period_num < GET_PRIVATE(budget)->num_periods)
+    {
+        gnc_numeric val = get_period_values (budget, account)[period_num];
+        return gnc_numeric_check (val) ? gnc_numeric_zero() : val;
+    }
 
-    if (numeric)
-        return *numeric;
+    make_period_path (account, period_num, &path);
+    if (qof_instance_get_kvp_numeric (QOF_INSTANCE (budget), &numeric,
+                                      G_N_ELEMENTS (path.keys), path.keys))
+        return numeric;
     return gnc_numeric_zero();
 }
 
+void
+gnc_budget_get_account_period_values(const GncBudget *budget,
+                                     const Account *account,
+                                     gnc_numeric *values,
+                                     gboolean *is_set)
+{
+    const gnc_numeric *row;
+    guint i, num_periods;
+
+    g_return_if_fail(GNC_IS_BUDGET(budget));
+    g_return_if_fail(account && values);
+
+    num_periods = GET_PRIVATE(budget)->num_periods;
+    row = get_period_values (budget, account);
+    for (i = 0; i < num_periods; i++)
+    {
+        gboolean set = !gnc_numeric_check (row[i]);
+        values[i] = set ? row[i] : gnc_numeric_zero();
+        if (is_set)
+            is_set[i] = set;
+    }
+}
+
+gnc_numeric *
+gnc_budget_get_period_value_matrix(const GncBudget *budget,
+                                   Account * const *accounts,
+                                   guint num_accounts)
+{
+    gnc_numeric *matrix;
+    guint i, num_periods;
+
+    g_return_val_if_fail(GNC_IS_BUDGET(budget), NULL);
+    g_return_val_if_fail(accounts || num_accounts == 0, NULL);
+
+    num_periods = GET_PRIVATE(budget)->num_periods;
+    matrix = g_new (gnc_numeric, MAX (num_accounts * num_periods, 1));
+    for (i = 0; i < num_accounts; i++)
+        gnc_budget_get_account_period_values (budget, accounts[i],
+                                              matrix + i * num_periods, NULL);
+    return matrix;
+}
 
 Timespec
 gnc_budget_get_period_start_date(const GncBudget *budget, guint period_num)
@@ -620,6 +748,37 @@ gnc_budget_get_account_period_actual_value(
                                            acc, period_num);
 }
 
+void
+gnc_budget_get_account_period_actual_values(const GncBudget *budget,
+                                            Account *acc, gnc_numeric *values)
+{
+    BudgetPrivate *priv;
+
+    g_return_if_fail(GNC_IS_BUDGET(budget) && acc && values);
+    priv = GET_PRIVATE(budget);
+    recurrenceGetAccountPeriodValues(&priv->recurrence, acc,
+                                     priv->num_periods, values);
+}
+
+gnc_numeric *
+gnc_budget_get_period_actual_value_matrix(const GncBudget *budget,
+                                          Account * const *accounts,
+                                          guint num_accounts)
+{
+    gnc_numeric *matrix;
+    guint i, num_periods;
+
+    g_return_val_if_fail(GNC_IS_BUDGET(budget), NULL);
+    g_return_val_if_fail(accounts || num_accounts == 0, NULL);
+
+    num_periods = GET_PRIVATE(budget)->num_periods;
+    matrix = g_new (gnc_numeric, MAX (num_accounts * num_periods, 1));
+    for (i = 0; i < num_accounts; i++)
+        gnc_budget_get_account_period_actual_values (budget, accounts[i],
+                                                     matrix + i * num_periods);
+    return matrix;
+}
+
 GncBudget*
 gnc_budget_lookup (const GncGUID *guid, const QofBook *book)
 {
@@ -147,9 +147,37 @@ gboolean gnc_budget_is_account_period_value_set(
 
 gnc_numeric gnc_budget_get_account_period_value(
     const GncBudget *budget, const Account *account, guint period_num);
+
+/** Get the account's budget values for all the periods at once.
+ *  @param values Receives gnc_budget_get_num_periods() values; unset
+ *  periods read as zero.
+ *  @param is_set If not NULL, receives gnc_budget_get_num_periods()
+ *  flags telling which periods are set. */
+void gnc_budget_get_account_period_values(
+    const GncBudget *budget, const Account *account,
+    gnc_numeric *values, gboolean *is_set);
+
+/** Get the budget values of several accounts for all the periods.
+ *  @return A newly allocated array of num_accounts rows of
+ *  gnc_budget_get_num_periods() values each, to be freed with g_free(). */
+gnc_numeric *gnc_budget_get_period_value_matrix(
+    const GncBudget *budget, Account * const *accounts, guint num_accounts);
+
 gnc_numeric gnc_budget_get_account_period_actual_value(
     const GncBudget *budget, Account *account, guint period_num);
 
+/** Get the account's actual values for all the periods at once, walking
+ *  its splits only once.
+ *  @param values Receives gnc_budget_get_num_periods() values. */
+void gnc_budget_get_account_period_actual_values(
+    const GncBudget *budget, Account *account, gnc_numeric *values);
+
+/** Get the actual values of several accounts for all the periods.
+ *  @return A newly allocated array of num_accounts rows of
+ *  gnc_budget_get_num_periods() values each, to be freed with g_free(). */
+gnc_numeric *gnc_budget_get_period_actual_value_matrix(
+    const GncBudget *budget, Account * const *accounts, guint num_accounts);
+
 /* Returns some budget in the book, or NULL. */
 GncBudget* gnc_budget_get_default(QofBook *book);
 
@@ -119,8 +119,19 @@ struct gnc_commodity_table_s
 {
     GHashTable * ns_table;
     GList      * ns_list;
+    GHashTable * cm_index;      /* (namespace, mnemonic) -> commodity */
 };
 
+/* Key of the flat commodity index.  The namespace is carried with an
+ * explicit length so that a unique name ("namespace::mnemonic") can be
+ * looked up in place, without copying it to split off the namespace. */
+typedef struct
+{
+    const char * name_space;
+    gsize        ns_len;
+    const char * mnemonic;
+} CommodityIndexKey;
+
 struct gnc_new_iso_code
 {
     const char *old_code;
@@ -1709,12 +1720,121 @@ gnc_commodity_table_map_namespace(const char * name_space)
  * make a new commodity table
  ********************************************************************/
 
+static guint
+commodity_index_hash(gconstpointer p)
+{
+    const CommodityIndexKey *key = p;
+    const char *s;
+    guint h = 5381;
+    gsize i;
+
+    for (i = 0; i < key->ns_len; i++)
+        h = (h << 5) + h + (guchar)key->name_space[i];
+    for (s = key->mnemonic; *s; s++)
+        h = (h << 5) + h + (guchar)*s;
+    return h;
+}
+
+static gboolean
+commodity_index_equal(gconstpointer a, gconstpointer b)
+{
+    const CommodityIndexKey *ka = a, *kb = b;
+
+    return (ka->ns_len == kb->ns_len &&
+            memcmp(ka->name_space, kb->name_space, ka->ns_len) == 0 &&
+            strcmp(ka->mnemonic, kb->mnemonic) == 0);
+}
+
+static void
+commodity_index_insert(gnc_commodity_table *table, const char *name_space,
+                       const char *mnemonic, gnc_commodity *comm)
+{
+    CommodityIndexKey *key;
+    gsize ns_len, mn_len;
+    char *buf;
+
+    if (!mnemonic) mnemonic = "";
+    ns_len = strlen(name_space);
+    mn_len = strlen(mnemonic);
+
+    /* The key and both strings share one allocation. */
+    key = g_malloc(sizeof(CommodityIndexKey) + ns_len + mn_len + 2);
+    buf = (char *)(key + 1);
+    memcpy(buf, name_space, ns_len + 1);
+    memcpy(buf + ns_len + 1, mnemonic, mn_len + 1);
+    key->name_space = buf;
+    key->ns_len = ns_len;
+    key->mnemonic = buf + ns_len + 1;
+
+    g_hash_table_replace(table->cm_index, key, comm);
+}
+
+static void
+commodity_index_remove(gnc_commodity_table *table, const char *name_space,
+                       const char *mnemonic)
+{
+    CommodityIndexKey key;
+
+    key.name_space = name_space;
+    key.ns_len = strlen(name_space);
+    key.mnemonic = mnemonic ? mnemonic : "";
+    g_hash_table_remove(table->cm_index, &key);
+}
+
+static gboolean
+commodity_ns_is(const char *name_space, gsize ns_len, const char *name)
+{
+    return (strlen(name) == ns_len &&
+            strncmp(name_space, name, ns_len) == 0);
+}
+
+/* Look up a commodity by a namespace of ns_len bytes (not necessarily
+ * nul-terminated) and a mnemonic. */
+static gnc_commodity *
+commodity_index_lookup(const gnc_commodity_table *table,
+                       const char *name_space, gsize ns_len,
+                       const char *mnemonic)
+{
+    CommodityIndexKey key;
+    unsigned int i;
+
+    if (commodity_ns_is(name_space, ns_len, GNC_COMMODITY_NS_ISO))
+    {
+        name_space = GNC_COMMODITY_NS_CURRENCY;
+        ns_len = strlen(GNC_COMMODITY_NS_CURRENCY);
+    }
+
+    /*
+     * Backward compatability support for currencies that have
+     * recently changed.
+     */
+    if (commodity_ns_is(name_space, ns_len, GNC_COMMODITY_NS_CURRENCY))
+    {
+        for (i = 0; i < GNC_NEW_ISO_CODES; i++)
+        {
+            if (strcmp(mnemonic, gnc_new_iso_codes[i].old_code) == 0)
+            {
+                mnemonic = gnc_new_iso_codes[i].new_code;
+                break;
+            }
+        }
+    }
+
+    key.name_space = name_space;
+    key.ns_len = ns_len;
+    key.mnemonic = mnemonic;
+    return g_hash_table_lookup(table->cm_index, &key);
+}
+
 gnc_commodity_table *
 gnc_commodity_table_new(void)
 {
     gnc_commodity_table * retval = g_new0(gnc_commodity_table, 1);
     retval->ns_table = g_hash_table_new(&g_str_hash, &g_str_equal);
     retval->ns_list = NULL;
+    retval->cm_index = g_hash_table_new_full(commodity_index_hash,
+                                             commodity_index_equal,
+                                             g_free, NULL);
     return retval;
 }
 
@@ -1793,36 +1913,10 @@ gnc_commodity *
 gnc_commodity_table_lookup(const gnc_commodity_table * table,
                            const char * name_space, const char * mnemonic)
 {
-    gnc_commodity_namespace * nsp = NULL;
-    unsigned int i;
-
     if (!table || !name_space || !mnemonic) return NULL;
 
-    nsp = gnc_commodity_table_find_namespace(table, name_space);
-
-    if (nsp)
-    {
-        /*
-         * Backward compatability support for currencies that have
-         * recently changed.
-         */
-        if (nsp->iso4217)
-        {
-            for (i = 0; i < GNC_NEW_ISO_CODES; i++)
-            {
-                if (strcmp(mnemonic, gnc_new_iso_codes[i].old_code) == 0)
-                {
-                    mnemonic = gnc_new_iso_codes[i].new_code;
-                    break;
-                }
-            }
-        }
-        return g_hash_table_lookup(nsp->cm_table, (gpointer)mnemonic);
-    }
-    else
-    {
-        return NULL;
-    }
+    return commodity_index_lookup(table, name_space, strlen(name_space),
+                                  mnemonic);
 }
 
 /********************************************************************
@@ -1834,28 +1928,15 @@ gnc_commodity *
 gnc_commodity_table_lookup_unique(const gnc_commodity_table *table,
                                   const char * unique_name)
 {
-    char *name_space;
-    char *mnemonic;
-    gnc_commodity *commodity;
+    const char *mnemonic;
 
     if (!table || !unique_name) return NULL;
 
-    name_space = g_strdup (unique_name);
-    mnemonic = strstr (name_space, "::");
-    if (!mnemonic)
-    {
-        g_free (name_space);
-        return NULL;
-    }
-
-    *mnemonic = '\0';
-    mnemonic += 2;
-
-    commodity = gnc_commodity_table_lookup (table, name_space, mnemonic);
+    mnemonic = strstr (unique_name, "::");
+    if (!mnemonic) return NULL;
 
-    g_free (name_space);
-
-    return commodity;
+    return commodity_index_lookup(table, unique_name, mnemonic - unique_name,
+                                  mnemonic + 2);
 }
 
 /********************************************************************
@@ -1968,6 +2049,7 @@ gnc_commodity_table_insert(gnc_commodity_table * table,
                         CACHE_INSERT(priv->mnemonic),
                         (gpointer)comm);
     nsp->cm_list = g_list_append(nsp->cm_list, comm);
+    commodity_index_insert(table, nsp->name, priv->mnemonic, comm);
 
     qof_event_gen (&comm->inst, QOF_EVENT_ADD, NULL);
     LEAVE ("(table=%p, comm=%p)", table, comm);
@@ -2004,6 +2086,7 @@ gnc_commodity_table_remove(gnc_commodity_table * table,
     nsp->cm_list = g_list_remove(nsp->cm_list, comm);
     g_hash_table_remove (nsp->cm_table, priv->mnemonic);
     /* XXX minor mem leak, should remove the key as well */
+    commodity_index_remove(table, nsp->name, priv->mnemonic);
 }
 
 /********************************************************************
@@ -2308,6 +2391,8 @@ gnc_commodity_table_delete_namespace(gnc_commodity_table * table,
                                      const char * name_space)
 {
     gnc_commodity_namespace * ns;
+    GHashTableIter iter;
+    gpointer key;
 
     if (!table) return;
 
@@ -2322,6 +2407,9 @@ gnc_commodity_table_delete_namespace(gnc_commodity_table * table,
     g_list_free(ns->cm_list);
     ns->cm_list = NULL;
 
+    g_hash_table_iter_init(&iter, ns->cm_table);
+    while (g_hash_table_iter_next(&iter, &key, NULL))
+        commodity_index_remove(table, ns->name, key);
     g_hash_table_foreach_remove(ns->cm_table, ns_helper, NULL);
     g_hash_table_destroy(ns->cm_table);
     CACHE_REMOVE(ns->name);
@@ -2406,6 +2494,8 @@ gnc_commodity_table_destroy(gnc_commodity_table * t)
     t->ns_list = NULL;
     g_hash_table_destroy(t->ns_table);
     t->ns_table = NULL;
+    g_hash_table_destroy(t->cm_index);
+    t->cm_index = NULL;
     g_free(t);
     LEAVE ("table=%p", t);
 }
@@ -2607,4 +2697,121 @@ gnc_monetary_list_free(MonetaryList *list)
     g_list_free(list);
 }
 
+/********************************************************************
+ * gnc_commodity_accumulator
+ ********************************************************************/
+
+struct gnc_commodity_accumulator_s
+{
+    GHashTable *index;    /* gnc_commodity * -> position in totals + 1 */
+    GArray     *totals;   /* of gnc_monetary, in the order first added */
+};
+
+gnc_commodity_accumulator *
+gnc_commodity_accumulator_new (void)
+{
+    gnc_commodity_accumulator *acc = g_new (gnc_commodity_accumulator, 1);
+
+    acc->index = g_hash_table_new (g_direct_hash, g_direct_equal);
+    acc->totals = g_array_new (FALSE, FALSE, sizeof (gnc_monetary));
+    return acc;
+}
+
+void
+gnc_commodity_accumulator_free (gnc_commodity_accumulator *acc)
+{
+    if (!acc) return;
+    g_hash_table_destroy (acc->index);
+    g_array_free (acc->totals, TRUE);
+    g_free (acc);
+}
+
+void
+gnc_commodity_accumulator_reset (gnc_commodity_accumulator *acc)
+{
+    g_return_if_fail (acc);
+    g_hash_table_remove_all (acc->index);
+    g_array_set_size (acc->totals, 0);
+}
+
+void
+gnc_commodity_accumulator_add (gnc_commodity_accumulator *acc,
+                               gnc_commodity *commodity, gnc_numeric amount)
+{
+    gnc_monetary *total;
+    guint pos;
+
+    g_return_if_fail (acc);
+
+    pos = GPOINTER_TO_UINT (g_hash_table_lookup (acc->index, commodity));
+    if (!pos)
+    {
+        gnc_monetary zero = gnc_monetary_create (commodity, gnc_numeric_zero ());
+        g_array_append_val (acc->totals, zero);
+        pos = acc->totals->len;
+        g_hash_table_insert (acc->index, commodity, GUINT_TO_POINTER (pos));
+    }
+
+    total = &g_array_index (acc->totals, gnc_monetary, pos - 1);
+    total->value = gnc_numeric_add (amount, total->value,
+                                    GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
+}
+
+void
+gnc_commodity_accumulator_merge (gnc_commodity_accumulator *acc,
+                                 const gnc_commodity_accumulator *other,
+                                 gboolean negate)
+{
+    guint i;
+
+    g_return_if_fail (acc && other);
+
+    /* Latest first, like the association lists of the Scheme collectors
+     * this replaces. */
+    for (i = other->totals->len; i > 0; i--)
+    {
+        gnc_monetary total = g_array_index (other->totals, gnc_monetary, i - 1);
+        gnc_commodity_accumulator_add (acc, total.commodity,
+                                       negate ? gnc_numeric_neg (total.value) :
+                                                total.value);
+    }
+}
+
+gnc_numeric
+gnc_commodity_accumulator_get (const gnc_commodity_accumulator *acc,
+                               const gnc_commodity *commodity)
+{
+    guint pos;
+
+    g_return_val_if_fail (acc, gnc_numeric_zero ());
+
+    pos = GPOINTER_TO_UINT (g_hash_table_lookup (acc->index, commodity));
+    if (!pos)
+        return gnc_numeric_zero ();
+    return g_array_index (acc->totals, gnc_monetary, pos - 1).value;
+}
+
+guint
+gnc_commodity_accumulator_count (const gnc_commodity_accumulator *acc)
+{
+    g_return_val_if_fail (acc, 0);
+    return acc->totals->len;
+}
+
+gnc_commodity *
+gnc_commodity_accumulator_nth_commodity (const gnc_commodity_accumulator *acc,
+                                         guint n)
+{
+    g_return_val_if_fail (acc && n < acc->totals->len, NULL);
+    return g_array_index (acc->totals, gnc_monetary, n).commodity;
+}
+
+gnc_numeric
+gnc_commodity_accumulator_nth_amount (const gnc_commodity_accumulator *acc,
+                                      guint n)
+{
+    g_return_val_if_fail (acc && n < acc->totals->len, gnc_numeric_zero ());
+    return g_array_index (acc->totals, gnc_monetary, n).value;
+}
+
 /* ========================= END OF FILE ============================== */
@@ -1049,6 +1049,42 @@ MonetaryList *gnc_monetary_list_delete_zeros(MonetaryList *list);
 void gnc_monetary_list_free(MonetaryList *list);
 /** @} */
 
+/** @name Commodity accumulators
+@{
+  An accumulator keeps a running total per commodity, like a
+  MonetaryList but with a hash table to find the commodities.  It backs
+  the commodity collectors of the reports.  The totals are kept in the
+  order their commodities were first added.
+*/
+typedef struct gnc_commodity_accumulator_s gnc_commodity_accumulator;
+
+gnc_commodity_accumulator *gnc_commodity_accumulator_new (void);
+void gnc_commodity_accumulator_free (gnc_commodity_accumulator *acc);
+
+/** Forget all totals, including which commodities were seen. */
+void gnc_commodity_accumulator_reset (gnc_commodity_accumulator *acc);
+
+/** Add amount to the total for commodity, starting one if needed. */
+void gnc_commodity_accumulator_add (gnc_commodity_accumulator *acc,
+                                    gnc_commodity *commodity,
+                                    gnc_numeric amount);
+
+/** Add each of the totals in other to acc, or subtract them if negate. */
+void gnc_commodity_accumulator_merge (gnc_commodity_accumulator *acc,
+                                      const gnc_commodity_accumulator *other,
+                                      gboolean negate);
+
+/** The total for commodity, zero if it hasn't been seen. */
+gnc_numeric gnc_commodity_accumulator_get (const gnc_commodity_accumulator *acc,
+                                           const gnc_commodity *commodity);
+
+guint gnc_commodity_accumulator_count (const gnc_commodity_accumulator *acc);
+gnc_commodity *gnc_commodity_accumulator_nth_commodity (
+    const gnc_commodity_accumulator *acc, guint n);
+gnc_numeric gnc_commodity_accumulator_nth_amount (
+    const gnc_commodity_accumulator *acc, guint n);
+/** @} */
+
 /** @} */
 
 #endif /* GNC_COMMODITY_H */
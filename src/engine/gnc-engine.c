@@ -25,6 +25,7 @@
 
 #include <glib.h>
 #include "gnc-engine.h"
+#include "TransLog.h"
 #include "qof.h"
 #include "cashobjects.h"
 #include "AccountP.h"
@@ -158,6 +159,7 @@ gnc_engine_init_static(int argc, char ** argv)
 void
 gnc_engine_shutdown (void)
 {
+    xaccCloseLog();
     qof_log_shutdown();
     qof_close();
     engine_is_initialized = 0;
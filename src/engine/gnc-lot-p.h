@@ -37,8 +37,14 @@
 #ifndef GNC_LOT_P_H
 #define GNC_LOT_P_H
 
+#include "gnc-lot.h"
+
 #define gnc_lot_set_guid(L,G)  qof_instance_set_guid(QOF_INSTANCE(L),&(G))
 
+/* Creates a lot being read from a datafile with the GncGUID it was saved
+ * with, instead of making up one for gnc_lot_set_guid() to replace. */
+GNCLot * gnc_lot_new_for_load (QofBook *book, const GncGUID *guid);
+
 /* Register with the Query engine */
 gboolean gnc_lot_register (void);
 
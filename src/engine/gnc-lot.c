@@ -285,6 +285,19 @@ gnc_lot_new (QofBook *book)
     return lot;
 }
 
+GNCLot *
+gnc_lot_new_for_load (QofBook *book, const GncGUID *guid)
+{
+    GNCLot *lot;
+    g_return_val_if_fail (book, NULL);
+    g_return_val_if_fail (guid, NULL);
+
+    lot = g_object_new (GNC_TYPE_LOT, NULL);
+    qof_instance_init_data_with_guid (QOF_INSTANCE(lot), GNC_ID_LOT, book, guid);
+    qof_event_gen (QOF_INSTANCE(lot), QOF_EVENT_CREATE, NULL);
+    return lot;
+}
+
 static void
 gnc_lot_free(GNCLot* lot)
 {
@@ -408,6 +421,7 @@ gnc_lot_set_closed_unknown(GNCLot* lot)
     {
         priv = GET_PRIVATE(lot);
         priv->is_closed = LOT_CLOSED_UNKNOWN;
+        gnc_account_lot_changed (priv->account, lot);
     }
 }
 
@@ -434,23 +448,19 @@ gint gnc_lot_count_splits (const GNCLot *lot)
 const char *
 gnc_lot_get_title (const GNCLot *lot)
 {
-    GValue v = G_VALUE_INIT;
+    static const gchar *keys[] = {"title"};
     if (!lot) return NULL;
-    qof_instance_get_kvp (QOF_INSTANCE (lot), "/title", &v);
-    if (G_VALUE_HOLDS_STRING (&v))
-        return g_value_get_string (&v);
-    return NULL;
+    return qof_instance_get_kvp_string (QOF_INSTANCE (lot),
+                                        G_N_ELEMENTS (keys), keys);
 }
 
 const char *
 gnc_lot_get_notes (const GNCLot *lot)
 {
-    GValue v = G_VALUE_INIT;
+    static const gchar *keys[] = {"notes"};
     if (!lot) return NULL;
-    qof_instance_get_kvp (QOF_INSTANCE (lot), "/notes", &v);
-    if (G_VALUE_HOLDS_STRING (&v))
-        return g_value_get_string (&v);
-    return NULL;
+    return qof_instance_get_kvp_string (QOF_INSTANCE (lot),
+                                        G_N_ELEMENTS (keys), keys);
 }
 
 void
@@ -619,6 +629,7 @@ gnc_lot_add_split (GNCLot *lot, Split *split)
 
     /* for recomputation of is-closed */
     priv->is_closed = LOT_CLOSED_UNKNOWN;
+    gnc_account_lot_changed (priv->account, lot);
     gnc_lot_commit_edit(lot);
 
     qof_event_gen (QOF_INSTANCE(lot), QOF_EVENT_MODIFY, NULL);
@@ -644,6 +655,8 @@ gnc_lot_remove_split (GNCLot *lot, Split *split)
         xaccAccountRemoveLot (priv->account, lot);
         priv->account = NULL;
     }
+    else
+        gnc_account_lot_changed (priv->account, lot);
     gnc_lot_commit_edit(lot);
     qof_event_gen (QOF_INSTANCE(lot), QOF_EVENT_MODIFY, NULL);
     LEAVE("removed from lot");
@@ -52,11 +52,30 @@ struct _GncPriceClass
     QofInstanceClass parent_class;
 };
 
+typedef void (*GNCPriceDBLoadFunc) (GNCPriceDB *db, gpointer user_data);
+
 struct gnc_price_db_s
 {
     QofInstance inst;              /* globally unique object identifier */
     GHashTable *commodity_hash;
     gboolean bulk_update;		 /* TRUE while reading XML file, etc. */
+    /* Loads the prices a backend held back, see
+     * gnc_pricedb_set_deferred_load. */
+    GNCPriceDBLoadFunc deferred_load;
+    gpointer deferred_data;
+    GDestroyNotify deferred_destroy;
+    /* The prices balance conversions settled on, by commodity pair and
+     * time; emptied whenever a price is added or removed. */
+    GHashTable *conversion_cache;
+    guint conversion_hits;
+    guint conversion_misses;
+    /* Which commodities have prices in which others, both ways round,
+     * and the shortest chains between them found so far. */
+    GHashTable *exchange_graph;
+    GHashTable *exchange_paths;
+    /* Prices added since gnc_pricedb_begin_batch, in order. */
+    GPtrArray *batch;
+    gint batch_level;
 };
 
 struct _GncPriceDBClass
@@ -86,10 +105,25 @@ typedef struct gnc_price_lookup_helper_s
 } GNCPriceLookupHelper;
 
 #define  gnc_price_set_guid(P,G)  qof_instance_set_guid(QOF_INSTANCE(P),(G))
+
+/** Creates a price being read from a datafile with the GncGUID it was
+ *  saved with, instead of making up one for gnc_price_set_guid() to
+ *  replace. */
+GNCPrice *gnc_price_create_for_load (QofBook *book, const GncGUID *guid);
 void     gnc_pricedb_substitute_commodity(GNCPriceDB *db,
         gnc_commodity *old_c,
         gnc_commodity *new_c);
 
+/** Lets a backend hold back the prices of a book it loads.  The first
+ *  time the database is looked at, load is called to add them, and
+ *  then destroy is called on user_data.  If the database is destroyed
+ *  first, only destroy is called.  Prices looked up by GUID in the
+ *  book's price collection, not through the database, aren't there
+ *  before that. */
+void gnc_pricedb_set_deferred_load (GNCPriceDB *db, GNCPriceDBLoadFunc load,
+                                    gpointer user_data,
+                                    GDestroyNotify destroy);
+
 /** register the pricedb object with the gncObject system */
 gboolean gnc_pricedb_register (void);
 
@@ -34,12 +34,20 @@ static QofLogModule log_module = GNC_MOD_PRICE;
 
 static gboolean add_price(GNCPriceDB *db, GNCPrice *p);
 static gboolean remove_price(GNCPriceDB *db, GNCPrice *p, gboolean cleanup);
+static void pricedb_run_deferred_load (GNCPriceDB *db);
+static void pricedb_conversion_cache_flush (GNCPriceDB *db);
+static void pricedb_exchange_link (GNCPriceDB *db, const gnc_commodity *a,
+                                   const gnc_commodity *b, gint delta);
+static GNCPrice *pricedb_lookup_history (GNCPriceDB *db, const GncGUID *guid);
+static GPtrArray *pricedb_get_series (GNCPriceDB *db,
+                                      const gnc_commodity *commodity,
+                                      const gnc_commodity *currency);
 static GNCPrice *lookup_nearest_in_time(GNCPriceDB *db, const gnc_commodity *c,
                                         const gnc_commodity *currency,
                                         Timespec t, gboolean sameday);
 static gboolean
 pricedb_pricelist_traversal(GNCPriceDB *db,
-                            gboolean (*f)(GList *p, gpointer user_data),
+                            gboolean (*f)(GPtrArray *series, gpointer user_data),
                             gpointer user_data);
 
 enum
@@ -306,6 +314,22 @@ gnc_price_create (QofBook *book)
     return p;
 }
 
+GNCPrice *
+gnc_price_create_for_load (QofBook *book, const GncGUID *guid)
+{
+    GNCPrice *p;
+
+    g_return_val_if_fail (book, NULL);
+    g_return_val_if_fail (guid, NULL);
+
+    p = g_object_new(GNC_TYPE_PRICE, NULL);
+
+    qof_instance_init_data_with_guid (&p->inst, GNC_ID_PRICE, book, guid);
+    qof_event_gen (&p->inst, QOF_EVENT_CREATE, NULL);
+
+    return p;
+}
+
 static void
 gnc_price_destroy (GNCPrice *p)
 {
@@ -576,10 +600,15 @@ GNCPrice *
 gnc_price_lookup (const GncGUID *guid, QofBook *book)
 {
     QofCollection *col;
+    GNCPrice *p;
 
     if (!guid || !book) return NULL;
+    pricedb_run_deferred_load (gnc_pricedb_get_db (book));
     col = qof_book_get_collection (book, GNC_ID_PRICE);
-    return (GNCPrice *) qof_collection_lookup_entity (col, guid);
+    p = (GNCPrice *) qof_collection_lookup_entity (col, guid);
+    if (!p)
+        p = pricedb_lookup_history (gnc_pricedb_get_db (book), guid);
+    return p;
 }
 
 gnc_commodity *
@@ -818,13 +847,458 @@ gnc_price_list_equal(PriceList *prices1, PriceList *prices2)
     return TRUE;
 }
 
+/* ==================================================================== */
+/* Price history
+
+   A GNCPrice with its instance, GUID and frame is a large object to keep
+   for every old quote.  Prices loaded through gnc_pricedb_add_price_compact
+   are instead kept in the columns below, shared by all price databases,
+   and stand in a series as a tagged row number.  A row becomes a GNCPrice
+   the first time anything asks for the price itself; its row is then
+   dead.  The columns are emptied when no live row is left.
+ */
+typedef struct
+{
+    GNCPriceDB *db;
+    gnc_commodity *commodity;
+    gnc_commodity *currency;
+} HistorySeries;
+
+#define HISTORY_DEAD 0xff
+
+static struct
+{
+    GArray *guids;              /* GncGUID */
+    GArray *times;              /* time64 */
+    GArray *values;             /* gnc_numeric */
+    GArray *series;             /* guint32, index into series_keys */
+    GArray *sources;            /* guint8 PriceSource, or HISTORY_DEAD */
+    GArray *types;              /* guint8, index into type_names */
+    GArray *series_keys;        /* HistorySeries */
+    GHashTable *series_index;   /* HistorySeries* -> index + 1 */
+    GPtrArray *type_names;      /* cached strings, NULL for none */
+    guint live;
+} price_history;
+
+/* A slot of a series holds a GNCPrice or, with the low bit set, a row. */
+#define PRICE_SLOT_IS_ROW(slot) ((GPOINTER_TO_SIZE (slot) & 1) != 0)
+#define PRICE_SLOT_ROW(slot) ((guint) (GPOINTER_TO_SIZE (slot) >> 1))
+#define PRICE_ROW_SLOT(row) GSIZE_TO_POINTER (((gsize) (row) << 1) | 1)
+
+static guint
+history_series_hash (gconstpointer key)
+{
+    const HistorySeries *k = key;
+    return g_direct_hash (k->db) ^ g_direct_hash (k->commodity) ^
+           (g_direct_hash (k->currency) * 31);
+}
+
+static gboolean
+history_series_equal (gconstpointer a, gconstpointer b)
+{
+    const HistorySeries *ka = a, *kb = b;
+    return ka->db == kb->db && ka->commodity == kb->commodity &&
+           ka->currency == kb->currency;
+}
+
+static void
+price_history_clear (void)
+{
+    guint i;
+
+    if (!price_history.guids) return;
+    g_array_free (price_history.guids, TRUE);
+    g_array_free (price_history.times, TRUE);
+    g_array_free (price_history.values, TRUE);
+    g_array_free (price_history.series, TRUE);
+    g_array_free (price_history.sources, TRUE);
+    g_array_free (price_history.types, TRUE);
+    g_hash_table_destroy (price_history.series_index);
+    g_array_free (price_history.series_keys, TRUE);
+    for (i = 0; i < price_history.type_names->len; i++)
+        if (price_history.type_names->pdata[i])
+            CACHE_REMOVE (price_history.type_names->pdata[i]);
+    g_ptr_array_free (price_history.type_names, TRUE);
+    memset (&price_history, 0, sizeof (price_history));
+}
+
+/* Mark row dead, and let the columns go with the last live row. */
+static void
+price_history_release (guint row)
+{
+    g_array_index (price_history.sources, guint8, row) = HISTORY_DEAD;
+    if (--price_history.live == 0)
+        price_history_clear ();
+}
+
+static guint
+price_history_add (GNCPriceDB *db, const GncGUID *guid,
+                   gnc_commodity *commodity, gnc_commodity *currency,
+                   time64 time, PriceSource source, const char *type,
+                   gnc_numeric value)
+{
+    HistorySeries key = {db, commodity, currency};
+    guint series, type_index;
+    guint8 source_code = source, type_code;
+
+    if (!price_history.guids)
+    {
+        price_history.guids = g_array_new (FALSE, FALSE, sizeof (GncGUID));
+        price_history.times = g_array_new (FALSE, FALSE, sizeof (time64));
+        price_history.values = g_array_new (FALSE, FALSE, sizeof (gnc_numeric));
+        price_history.series = g_array_new (FALSE, FALSE, sizeof (guint32));
+        price_history.sources = g_array_new (FALSE, FALSE, sizeof (guint8));
+        price_history.types = g_array_new (FALSE, FALSE, sizeof (guint8));
+        price_history.series_keys = g_array_new (FALSE, FALSE,
+                                                 sizeof (HistorySeries));
+        price_history.series_index = g_hash_table_new_full (history_series_hash,
+                                                            history_series_equal,
+                                                            g_free, NULL);
+        price_history.type_names = g_ptr_array_new ();
+    }
+
+    series = GPOINTER_TO_UINT (g_hash_table_lookup (price_history.series_index,
+                                                    &key));
+    if (series == 0)
+    {
+        g_array_append_val (price_history.series_keys, key);
+        series = price_history.series_keys->len;
+        g_hash_table_insert (price_history.series_index,
+                             g_memdup (&key, sizeof (key)),
+                             GUINT_TO_POINTER (series));
+    }
+    series--;
+
+    /* There are only a handful of types; the codes are the indexes of
+     * their cached strings. */
+    for (type_index = 0; type_index < price_history.type_names->len; type_index++)
+        if (g_strcmp0 (price_history.type_names->pdata[type_index], type) == 0)
+            break;
+    if (type_index == price_history.type_names->len)
+        g_ptr_array_add (price_history.type_names,
+                         type ? CACHE_INSERT (type) : NULL);
+    type_code = type_index;
+
+    g_array_append_val (price_history.guids, *guid);
+    g_array_append_val (price_history.times, time);
+    g_array_append_val (price_history.values, value);
+    g_array_append_val (price_history.series, series);
+    g_array_append_val (price_history.sources, source_code);
+    g_array_append_val (price_history.types, type_code);
+    price_history.live++;
+    return price_history.guids->len - 1;
+}
+
+/* Make row a GNCPrice, with the row's reference, and let the row go. */
+static GNCPrice *
+price_history_materialize (guint row)
+{
+    guint32 series = g_array_index (price_history.series, guint32, row);
+    HistorySeries *key = &g_array_index (price_history.series_keys,
+                                         HistorySeries, series);
+    const char *type = price_history.type_names->pdata[
+                           g_array_index (price_history.types, guint8, row)];
+    GNCPrice *p;
+
+    /* The price is already in the database and saved. */
+    qof_event_suspend ();
+    p = gnc_price_create (qof_instance_get_book (key->db));
+    qof_instance_set_guid (p, &g_array_index (price_history.guids, GncGUID, row));
+    p->commodity = key->commodity;
+    p->currency = key->currency;
+    p->tmspec.tv_sec = g_array_index (price_history.times, time64, row);
+    p->tmspec.tv_nsec = 0;
+    p->value = g_array_index (price_history.values, gnc_numeric, row);
+    p->source = g_array_index (price_history.sources, guint8, row);
+    p->type = type ? CACHE_INSERT (type) : NULL;
+    p->db = key->db;
+    qof_instance_set_infant (p, FALSE);
+    qof_instance_mark_clean (QOF_INSTANCE (p));
+    qof_event_resume ();
+
+    price_history_release (row);
+    return p;
+}
+
+static Timespec
+price_slot_time (gconstpointer slot)
+{
+    Timespec t;
+
+    if (!PRICE_SLOT_IS_ROW (slot))
+        return gnc_price_get_time ((GNCPrice *) slot);
+    t.tv_sec = g_array_index (price_history.times, time64, PRICE_SLOT_ROW (slot));
+    t.tv_nsec = 0;
+    return t;
+}
+
+static const GncGUID *
+price_slot_guid (gconstpointer slot)
+{
+    if (!PRICE_SLOT_IS_ROW (slot))
+        return gnc_price_get_guid ((GNCPrice *) slot);
+    return &g_array_index (price_history.guids, GncGUID, PRICE_SLOT_ROW (slot));
+}
+
+static gnc_numeric
+price_slot_value (gconstpointer slot)
+{
+    if (!PRICE_SLOT_IS_ROW (slot))
+        return gnc_price_get_value ((GNCPrice *) slot);
+    return g_array_index (price_history.values, gnc_numeric, PRICE_SLOT_ROW (slot));
+}
+
+static void
+price_slot_commodities (gconstpointer slot, gnc_commodity **commodity,
+                        gnc_commodity **currency)
+{
+    if (!PRICE_SLOT_IS_ROW (slot))
+    {
+        *commodity = gnc_price_get_commodity ((GNCPrice *) slot);
+        *currency = gnc_price_get_currency ((GNCPrice *) slot);
+    }
+    else
+    {
+        guint32 series = g_array_index (price_history.series, guint32,
+                                        PRICE_SLOT_ROW (slot));
+        HistorySeries *key = &g_array_index (price_history.series_keys,
+                                             HistorySeries, series);
+        *commodity = key->commodity;
+        *currency = key->currency;
+    }
+}
+
+/* compare_prices_by_date for slots. */
+static gint
+compare_slots_by_date (gconstpointer a, gconstpointer b)
+{
+    Timespec time_a = price_slot_time (a);
+    Timespec time_b = price_slot_time (b);
+    gint result = -timespec_cmp (&time_a, &time_b);
+
+    if (result) return result;
+    return guid_compare (price_slot_guid (a), price_slot_guid (b));
+}
+
+/* ==================================================================== */
+/* Price series
+
+   The prices of one commodity in one currency are kept in a GPtrArray
+   holding a reference to each, or a history row, oldest first, so that
+   new quotes are appended and the price for a time is found by binary
+   search.  Read from the end, a series is in the order of a PriceList;
+   the functions returning price lists hand out copies.
+ */
+
+/* The price in slot i of the series, made a GNCPrice if it is a row. */
+static GNCPrice *
+price_series_at (GPtrArray *series, guint i)
+{
+    gpointer slot = g_ptr_array_index (series, i);
+
+    if (PRICE_SLOT_IS_ROW (slot))
+    {
+        slot = price_history_materialize (PRICE_SLOT_ROW (slot));
+        series->pdata[i] = slot;
+    }
+    return slot;
+}
+
+/* The number of prices in the series before t, or up to and including
+ * t if include_t.  That is the index of the first price after them. */
+static guint
+price_series_index (const GPtrArray *series, Timespec t, gboolean include_t)
+{
+    guint lo = 0, hi = series->len;
+
+    while (lo < hi)
+    {
+        guint mid = lo + (hi - lo) / 2;
+        Timespec price_t = price_slot_time (g_ptr_array_index (series, mid));
+        gint cmp = timespec_cmp (&price_t, &t);
+
+        if (cmp < 0 || (include_t && cmp == 0))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/* The latest price in the series at or before t, or NULL. */
+static GNCPrice *
+price_series_latest_until (GPtrArray *series, Timespec t)
+{
+    guint n;
+
+    if (!series) return NULL;
+    n = price_series_index (series, t, TRUE);
+    return n ? price_series_at (series, n - 1) : NULL;
+}
+
+/* The earliest price in the series after t, or NULL. */
+static GNCPrice *
+price_series_earliest_after (GPtrArray *series, Timespec t)
+{
+    guint n;
+
+    if (!series) return NULL;
+    n = price_series_index (series, t, TRUE);
+    return n < series->len ? price_series_at (series, n) : NULL;
+}
+
+static GNCPrice *
+price_series_latest (GPtrArray *series)
+{
+    if (!series || !series->len) return NULL;
+    return price_series_at (series, series->len - 1);
+}
+
+/* Whichever of two prices comes first in a PriceList, skipping NULLs. */
+static GNCPrice *
+price_newer_of (GNCPrice *a, GNCPrice *b)
+{
+    if (!a) return b;
+    if (!b) return a;
+    return compare_prices_by_date (a, b) <= 0 ? a : b;
+}
+
+static GNCPrice *
+price_older_of (GNCPrice *a, GNCPrice *b)
+{
+    if (!a) return b;
+    if (!b) return a;
+    return compare_prices_by_date (a, b) <= 0 ? b : a;
+}
+
+/* A PriceList of the series' prices, without references of its own. */
+static PriceList *
+price_series_to_list (GPtrArray *series)
+{
+    PriceList *prices = NULL;
+    guint i;
+
+    for (i = 0; i < series->len; i++)
+        prices = g_list_prepend (prices, price_series_at (series, i));
+    return prices;
+}
+
+static void
+price_series_destroy (GPtrArray *series)
+{
+    guint i;
+
+    for (i = 0; i < series->len; i++)
+    {
+        gpointer slot = g_ptr_array_index (series, i);
+        if (PRICE_SLOT_IS_ROW (slot))
+            price_history_release (PRICE_SLOT_ROW (slot));
+        else
+            gnc_price_unref (slot);
+    }
+    g_ptr_array_free (series, TRUE);
+}
+
+/* Put slot, a price with a reference for the series or a row, in its
+ * place in the series. */
+static void
+price_series_insert_slot (GPtrArray *series, gpointer slot)
+{
+    guint lo = 0, hi = series->len;
+
+    /* Quotes mostly arrive in date order, so try the end first. */
+    if (hi == 0 ||
+        compare_slots_by_date (slot, g_ptr_array_index (series, hi - 1)) < 0)
+    {
+        g_ptr_array_add (series, slot);
+        return;
+    }
+    while (lo < hi)
+    {
+        guint mid = lo + (hi - lo) / 2;
+        if (compare_slots_by_date (g_ptr_array_index (series, mid), slot) < 0)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    g_ptr_array_add (series, NULL);
+    memmove (series->pdata + lo + 1, series->pdata + lo,
+             (series->len - lo - 1) * sizeof (gpointer));
+    series->pdata[lo] = slot;
+}
+
+/* Add a reference to p and put it in its place in the series.  If
+ * check_dupl, a price with the same value on the same day is taken for
+ * the same quote and p is left out. */
+static void
+price_series_insert (GPtrArray *series, GNCPrice *p, gboolean check_dupl)
+{
+    if (check_dupl)
+    {
+        Timespec day = timespecCanonicalDayTime (gnc_price_get_time (p));
+        Timespec t = gnc_price_get_time (p);
+        guint i = price_series_index (series, t, TRUE);
+        guint j;
+
+        /* The prices of a day are next to each other. */
+        for (j = i; j > 0; j--)
+        {
+            gpointer other = g_ptr_array_index (series, j - 1);
+            Timespec other_day = timespecCanonicalDayTime (price_slot_time (other));
+            if (!timespec_equal (&other_day, &day)) break;
+            if (gnc_numeric_equal (price_slot_value (other),
+                                   gnc_price_get_value (p)))
+                return;
+        }
+        for (j = i; j < series->len; j++)
+        {
+            gpointer other = g_ptr_array_index (series, j);
+            Timespec other_day = timespecCanonicalDayTime (price_slot_time (other));
+            if (!timespec_equal (&other_day, &day)) break;
+            if (gnc_numeric_equal (price_slot_value (other),
+                                   gnc_price_get_value (p)))
+                return;
+        }
+    }
+
+    gnc_price_ref (p);
+    price_series_insert_slot (series, p);
+}
+
+/* Take p out of the series and drop its reference, if it is there. */
+static void
+price_series_remove (GPtrArray *series, GNCPrice *p)
+{
+    Timespec t = gnc_price_get_time (p);
+    guint i = price_series_index (series, t, FALSE);
+
+    for (; i < series->len; i++)
+    {
+        gpointer other = g_ptr_array_index (series, i);
+        Timespec other_t = price_slot_time (other);
+        if (other == p) break;
+        if (timespec_cmp (&other_t, &t) > 0)
+        {
+            i = series->len;
+            break;
+        }
+    }
+    /* Failing that, look everywhere in case p's time was changed without
+     * moving it. */
+    if (i == series->len)
+        for (i = 0; i < series->len && g_ptr_array_index (series, i) != p; i++)
+            ;
+    if (i == series->len) return;
+    g_ptr_array_remove_index (series, i);
+    gnc_price_unref (p);
+}
+
 /* ==================================================================== */
 /* GNCPriceDB functions
 
    Structurally a GNCPriceDB contains a hash mapping price commodities
    (of type gnc_commodity*) to hashes mapping price currencies (of
-   type gnc_commodity*) to GNCPrice lists (see gnc-pricedb.h for a
-   description of GNCPrice lists).  The top-level key is the commodity
+   type gnc_commodity*) to price series (see above).  The top-level key is the commodity
    you want the prices for, and the second level key is the commodity
    that the value is expressed in terms of.
  */
@@ -885,18 +1359,18 @@ destroy_pricedb_currency_hash_data(gpointer key,
                                    gpointer data,
                                    gpointer user_data)
 {
-    GList *price_list = (GList *) data;
-    GList *node;
-    GNCPrice *p;
+    GPtrArray *series = (GPtrArray *) data;
+    guint i;
 
-    for (node = price_list; node; node = node->next)
+    for (i = 0; i < series->len; i++)
     {
-        p = node->data;
+        gpointer slot = g_ptr_array_index (series, i);
 
-        p->db = NULL;
+        if (!PRICE_SLOT_IS_ROW (slot))
+            ((GNCPrice *) slot)->db = NULL;
     }
 
-    gnc_price_list_destroy(price_list);
+    price_series_destroy (series);
 }
 
 static void
@@ -916,6 +1390,24 @@ void
 gnc_pricedb_destroy(GNCPriceDB *db)
 {
     if (!db) return;
+    if (db->deferred_destroy)
+        db->deferred_destroy (db->deferred_data);
+    db->deferred_load = NULL;
+    db->deferred_destroy = NULL;
+    if (db->batch)
+    {
+        guint i;
+        for (i = 0; i < db->batch->len; i++)
+        {
+            gpointer slot = g_ptr_array_index (db->batch, i);
+            if (PRICE_SLOT_IS_ROW (slot))
+                price_history_release (PRICE_SLOT_ROW (slot));
+            else
+                gnc_price_unref (slot);
+        }
+        g_ptr_array_free (db->batch, TRUE);
+        db->batch = NULL;
+    }
     if (db->commodity_hash)
     {
         g_hash_table_foreach (db->commodity_hash,
@@ -924,6 +1416,15 @@ gnc_pricedb_destroy(GNCPriceDB *db)
     }
     g_hash_table_destroy (db->commodity_hash);
     db->commodity_hash = NULL;
+    if (db->conversion_cache)
+        g_hash_table_destroy (db->conversion_cache);
+    db->conversion_cache = NULL;
+    if (db->exchange_paths)
+        g_hash_table_destroy (db->exchange_paths);
+    db->exchange_paths = NULL;
+    if (db->exchange_graph)
+        g_hash_table_destroy (db->exchange_graph);
+    db->exchange_graph = NULL;
     /* qof_instance_release (&db->inst); */
     g_object_unref(db);
 }
@@ -934,6 +1435,43 @@ gnc_pricedb_set_bulk_update(GNCPriceDB *db, gboolean bulk_update)
     db->bulk_update = bulk_update;
 }
 
+void
+gnc_pricedb_set_deferred_load (GNCPriceDB *db, GNCPriceDBLoadFunc load,
+                               gpointer user_data, GDestroyNotify destroy)
+{
+    g_return_if_fail (db);
+    if (db->deferred_destroy)
+        db->deferred_destroy (db->deferred_data);
+    db->deferred_load = load;
+    db->deferred_data = user_data;
+    db->deferred_destroy = destroy;
+}
+
+/* Adds the prices a backend held back, before anything looks at or
+ * changes the hash tables. */
+static void
+pricedb_run_deferred_load (GNCPriceDB *db)
+{
+    GNCPriceDBLoadFunc load;
+    gpointer data;
+    GDestroyNotify destroy;
+
+    if (!db || !db->deferred_load) return;
+    load = db->deferred_load;
+    data = db->deferred_data;
+    destroy = db->deferred_destroy;
+    /* The load adds prices, which must not start it again. */
+    db->deferred_load = NULL;
+    db->deferred_data = NULL;
+    db->deferred_destroy = NULL;
+
+    ENTER ("db=%p", db);
+    load (db, data);
+    if (destroy)
+        destroy (data);
+    LEAVE (" ");
+}
+
 /* ==================================================================== */
 /* This is kind of weird, the way its done.  Each collection of prices
  * for a given commodity should get its own guid, be its own entity, etc.
@@ -1006,7 +1544,7 @@ pricedb_equal_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)
 {
     GNCPriceDBEqualData *equal_data = user_data;
     gnc_commodity *currency = key;
-    GList *price_list1 = val;
+    GList *price_list1 = price_series_to_list (val);
     GList *price_list2;
 
     price_list2 = gnc_pricedb_get_prices (equal_data->db2,
@@ -1016,6 +1554,7 @@ pricedb_equal_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)
     if (!gnc_price_list_equal (price_list1, price_list2))
         equal_data->equal = FALSE;
 
+    g_list_free (price_list1);
     gnc_price_list_destroy (price_list2);
 }
 
@@ -1046,6 +1585,8 @@ gnc_pricedb_equal (GNCPriceDB *db1, GNCPriceDB *db2)
         return FALSE;
     }
 
+    pricedb_run_deferred_load (db1);
+    pricedb_run_deferred_load (db2);
     equal_data.equal = TRUE;
     equal_data.db2 = db2;
 
@@ -1060,18 +1601,43 @@ gnc_pricedb_equal (GNCPriceDB *db1, GNCPriceDB *db2)
 /* The add_price() function is a utility that only manages the
  * dual hash table instertion */
 
+/* The series of commodity's prices in currency, made if there is none. */
+static GPtrArray *
+pricedb_make_series (GNCPriceDB *db, gnc_commodity *commodity,
+                     gnc_commodity *currency)
+{
+    GHashTable *currency_hash;
+    GPtrArray *series;
+
+    currency_hash = g_hash_table_lookup(db->commodity_hash, commodity);
+    if (!currency_hash)
+    {
+        currency_hash = g_hash_table_new(NULL, NULL);
+        g_hash_table_insert(db->commodity_hash, commodity, currency_hash);
+    }
+
+    series = g_hash_table_lookup(currency_hash, currency);
+    if (!series)
+    {
+        series = g_ptr_array_new ();
+        g_hash_table_insert(currency_hash, currency, series);
+        pricedb_exchange_link (db, commodity, currency, 1);
+    }
+    return series;
+}
+
 static gboolean
 add_price(GNCPriceDB *db, GNCPrice *p)
 {
     /* This function will use p, adding a ref, so treat p as read-only
        if this function succeeds. */
-    GList *price_list;
+    GPtrArray *series;
     gnc_commodity *commodity;
     gnc_commodity *currency;
-    GHashTable *currency_hash;
     GNCPrice *old_price;
 
     if (!db || !p) return FALSE;
+    pricedb_run_deferred_load (db);
     ENTER ("db=%p, pr=%p dirty=%d destroying=%d",
            db, p, qof_instance_get_dirty_flag(p),
            qof_instance_get_destroying(p));
@@ -1102,6 +1668,13 @@ add_price(GNCPriceDB *db, GNCPrice *p)
         LEAVE ("no commodity hash found ");
         return FALSE;
     }
+    if (db->batch)
+    {
+        gnc_price_ref (p);
+        g_ptr_array_add (db->batch, p);
+        LEAVE ("batched");
+        return TRUE;
+    }
 /* Check for an existing price on the same day. If there is no existing price,
  * add this one. If this price is of equal or better precedence than the old
  * one, copy this one over the old one.
@@ -1110,77 +1683,390 @@ add_price(GNCPriceDB *db, GNCPrice *p)
                                         p->tmspec);
     if (!db->bulk_update && old_price != NULL)
     {
-        if (p->source > old_price->source)
+        if (p->source > old_price->source)
+        {
+            gnc_price_unref(p);
+            LEAVE ("Better price already in DB.");
+            return FALSE;
+        }
+        gnc_pricedb_remove_price(db, old_price);
+    }
+
+    series = pricedb_make_series (db, commodity, currency);
+    price_series_insert (series, p, !db->bulk_update);
+    p->db = db;
+    pricedb_conversion_cache_flush (db);
+
+    qof_event_gen (&p->inst, QOF_EVENT_ADD, NULL);
+
+    LEAVE ("db=%p, pr=%p dirty=%d dextroying=%d commodity=%s/%s currency_hash=%p",
+           db, p, qof_instance_get_dirty_flag(p),
+           qof_instance_get_destroying(p),
+           gnc_commodity_get_namespace(p->commodity),
+           gnc_commodity_get_mnemonic(p->commodity),
+           g_hash_table_lookup(db->commodity_hash, commodity));
+    return TRUE;
+}
+
+/* If gnc_pricedb_add_price() succeeds, it takes ownership of the
+   passed-in GNCPrice and inserts it into the pricedb. Writing to this
+   pointer afterwards will have interesting results, so don't.
+ */
+gboolean
+gnc_pricedb_add_price(GNCPriceDB *db, GNCPrice *p)
+{
+    if (!db || !p) return FALSE;
+
+    ENTER ("db=%p, pr=%p dirty=%d destroying=%d",
+           db, p, qof_instance_get_dirty_flag(p),
+           qof_instance_get_destroying(p));
+
+    if (FALSE == add_price(db, p))
+    {
+        LEAVE (" failed to add price");
+        return FALSE;
+    }
+    if (db->batch)
+    {
+        LEAVE ("batched");
+        return TRUE;
+    }
+
+    gnc_pricedb_begin_edit(db);
+    qof_instance_set_dirty(&db->inst);
+    gnc_pricedb_commit_edit(db);
+
+    LEAVE ("db=%p, pr=%p dirty=%d destroying=%d",
+           db, p, qof_instance_get_dirty_flag(p),
+           qof_instance_get_destroying(p));
+
+    return TRUE;
+}
+
+gboolean
+gnc_pricedb_add_price_compact (GNCPriceDB *db, GNCPrice *p)
+{
+    GPtrArray *series;
+    guint row;
+
+    if (!db || !p) return FALSE;
+    if (!p->commodity || !p->currency || !db->commodity_hash ||
+        !qof_instance_books_equal (db, p))
+        return FALSE;
+
+    /* The history keeps neither frames nor fractions of a second. */
+    if (p->tmspec.tv_nsec != 0 || qof_instance_has_kvp (QOF_INSTANCE (p)))
+    {
+        gboolean rc;
+        gnc_price_ref (p);
+        rc = add_price (db, p);
+        gnc_price_unref (p);
+        return rc;
+    }
+
+    pricedb_run_deferred_load (db);
+    row = price_history_add (db, gnc_price_get_guid (p), p->commodity,
+                             p->currency, p->tmspec.tv_sec, p->source,
+                             p->type, p->value);
+    if (db->batch)
+    {
+        g_ptr_array_add (db->batch, PRICE_ROW_SLOT (row));
+        return TRUE;
+    }
+    series = pricedb_make_series (db, p->commodity, p->currency);
+    price_series_insert_slot (series, PRICE_ROW_SLOT (row));
+    pricedb_conversion_cache_flush (db);
+    return TRUE;
+}
+
+/* Batches
+
+   A batch notes the prices added to it, in order, and settles them when
+   it ends.  For each price the prices on the same day, either way round,
+   are gathered from the series and the batch so far, and the one a
+   lookup_day would find is replaced or wins as add_price would have it;
+   then every series that gained prices has them sorted and merged in
+   once.
+ */
+typedef struct
+{
+    gconstpointer a;
+    gconstpointer b;
+    time64 day;
+} BatchDayKey;
+
+static guint
+batch_day_hash (gconstpointer key)
+{
+    const BatchDayKey *k = key;
+    return g_direct_hash (k->a) ^ (g_direct_hash (k->b) * 31) ^ (guint) k->day;
+}
+
+static gboolean
+batch_day_equal (gconstpointer a, gconstpointer b)
+{
+    const BatchDayKey *ka = a, *kb = b;
+    return ka->a == kb->a && ka->b == kb->b && ka->day == kb->day;
+}
+
+/* Add the prices of series on the canonical day of t to group. */
+static void
+batch_gather_day (GPtrArray *group, GPtrArray *series, Timespec t)
+{
+    Timespec day = timespecCanonicalDayTime (t);
+    guint i, j;
+
+    if (!series) return;
+    i = price_series_index (series, t, TRUE);
+    for (j = i; j > 0; j--)
+    {
+        Timespec other_day = timespecCanonicalDayTime (
+                                 price_slot_time (g_ptr_array_index (series, j - 1)));
+        if (!timespec_equal (&other_day, &day)) break;
+    }
+    for (; j < series->len; j++)
+    {
+        Timespec other_day = timespecCanonicalDayTime (
+                                 price_slot_time (g_ptr_array_index (series, j)));
+        if (j >= i && !timespec_equal (&other_day, &day)) break;
+        g_ptr_array_add (group, price_series_at (series, j));
+    }
+}
+
+/* Decide whether p goes in, as add_price would.  A price it replaces is
+ * put in dropped if it came in the batch and in *replaced otherwise. */
+static gboolean
+pricedb_batch_settle (GNCPriceDB *db, GNCPrice *p, GHashTable *days,
+                      GHashTable *dropped, GList **replaced)
+{
+    BatchDayKey key;
+    GPtrArray *group;
+    GNCPrice *old = NULL;
+    Timespec t = gnc_price_get_time (p), old_diff = {0, 0};
+    guint i;
+
+    key.a = MIN (p->commodity, p->currency);
+    key.b = MAX (p->commodity, p->currency);
+    key.day = timespecCanonicalDayTime (t).tv_sec;
+    group = g_hash_table_lookup (days, &key);
+    if (!group)
+    {
+        group = g_ptr_array_new ();
+        batch_gather_day (group, pricedb_get_series (db, p->commodity,
+                                                     p->currency), t);
+        batch_gather_day (group, pricedb_get_series (db, p->currency,
+                                                     p->commodity), t);
+        g_hash_table_insert (days, g_memdup (&key, sizeof (key)), group);
+    }
+
+    /* The nearest in time, the older of two as near. */
+    for (i = 0; i < group->len; i++)
+    {
+        GNCPrice *other = g_ptr_array_index (group, i);
+        Timespec other_t = gnc_price_get_time (other);
+        Timespec diff = timespec_diff (&other_t, &t);
+        diff = timespec_abs (&diff);
+        if (!old || timespec_cmp (&diff, &old_diff) < 0 ||
+            (timespec_equal (&diff, &old_diff) &&
+             compare_prices_by_date (other, old) > 0))
+        {
+            old = other;
+            old_diff = diff;
+        }
+    }
+    if (old)
+    {
+        if (p->source > old->source)
+            return FALSE;
+        g_ptr_array_remove (group, old);
+        if (old->db == db)
+        {
+            gnc_price_ref (old);
+            *replaced = g_list_prepend (*replaced, old);
+        }
+        else
+            g_hash_table_insert (dropped, old, old);
+    }
+
+    /* The same quote seen twice. */
+    for (i = 0; i < group->len; i++)
+    {
+        GNCPrice *other = g_ptr_array_index (group, i);
+        if (other->commodity == p->commodity &&
+            gnc_numeric_equal (gnc_price_get_value (other),
+                               gnc_price_get_value (p)))
+            return FALSE;
+    }
+    g_ptr_array_add (group, p);
+    return TRUE;
+}
+
+static gint
+compare_slots_oldest_first (gconstpointer a, gconstpointer b)
+{
+    return compare_slots_by_date (*(gconstpointer *) b, *(gconstpointer *) a);
+}
+
+/* Sort pending and merge it into series. */
+static void
+price_series_merge (GPtrArray *series, GPtrArray *pending)
+{
+    gint i = series->len - 1, j = pending->len - 1;
+    guint k;
+
+    g_ptr_array_sort (pending, compare_slots_oldest_first);
+    g_ptr_array_set_size (series, series->len + pending->len);
+    k = series->len;
+    while (j >= 0)
+    {
+        if (i >= 0 &&
+            compare_slots_by_date (g_ptr_array_index (series, i),
+                                   g_ptr_array_index (pending, j)) < 0)
+            series->pdata[--k] = series->pdata[i--];
+        else
+            series->pdata[--k] = pending->pdata[j--];
+    }
+}
+
+static void
+free_ptr_array (gpointer array)
+{
+    g_ptr_array_free (array, TRUE);
+}
+
+void
+gnc_pricedb_begin_batch (GNCPriceDB *db)
+{
+    g_return_if_fail (db);
+    if (db->batch_level++ == 0)
+        db->batch = g_ptr_array_new ();
+}
+
+void
+gnc_pricedb_end_batch (GNCPriceDB *db)
+{
+    GPtrArray *batch;
+    GHashTable *days, *dropped, *pending;
+    GHashTableIter iter;
+    gpointer key, value;
+    GList *replaced = NULL, *node;
+    gboolean added = FALSE;
+    guint i;
+
+    g_return_if_fail (db && db->batch_level > 0);
+    if (--db->batch_level > 0) return;
+    batch = db->batch;
+    db->batch = NULL;
+    ENTER ("db=%p, %u prices", db, batch->len);
+
+    /* Decide which of the prices stay, in the order they came. */
+    days = g_hash_table_new_full (batch_day_hash, batch_day_equal,
+                                  g_free, free_ptr_array);
+    dropped = g_hash_table_new (NULL, NULL);
+    for (i = 0; i < batch->len; i++)
+    {
+        gpointer slot = g_ptr_array_index (batch, i);
+        if (PRICE_SLOT_IS_ROW (slot) || db->bulk_update)
+            continue;
+        if (!pricedb_batch_settle (db, slot, days, dropped, &replaced))
+            g_hash_table_insert (dropped, slot, slot);
+    }
+    g_hash_table_destroy (days);
+
+    /* Sort the rest into their series. */
+    pending = g_hash_table_new_full (NULL, NULL, NULL, free_ptr_array);
+    for (i = 0; i < batch->len; i++)
+    {
+        gpointer slot = g_ptr_array_index (batch, i);
+        gnc_commodity *commodity, *currency;
+        GPtrArray *series, *series_pending;
+
+        if (g_hash_table_lookup (dropped, slot))
+            continue;
+        price_slot_commodities (slot, &commodity, &currency);
+        series = pricedb_make_series (db, commodity, currency);
+        series_pending = g_hash_table_lookup (pending, series);
+        if (!series_pending)
         {
-            gnc_price_unref(p);
-            LEAVE ("Better price already in DB.");
-            return FALSE;
+            series_pending = g_ptr_array_new ();
+            g_hash_table_insert (pending, series, series_pending);
         }
-        gnc_pricedb_remove_price(db, old_price);
+        g_ptr_array_add (series_pending, slot);
+        if (!PRICE_SLOT_IS_ROW (slot))
+            ((GNCPrice *) slot)->db = db;
     }
-
-    currency_hash = g_hash_table_lookup(db->commodity_hash, commodity);
-    if (!currency_hash)
+    g_hash_table_iter_init (&iter, pending);
+    while (g_hash_table_iter_next (&iter, &key, &value))
     {
-        currency_hash = g_hash_table_new(NULL, NULL);
-        g_hash_table_insert(db->commodity_hash, commodity, currency_hash);
+        price_series_merge (key, value);
+        added = TRUE;
     }
+    g_hash_table_destroy (pending);
+    pricedb_conversion_cache_flush (db);
 
-    price_list = g_hash_table_lookup(currency_hash, currency);
-    if (!gnc_price_list_insert(&price_list, p, !db->bulk_update))
+    /* The price editor's model adds its rows one price at a time. */
+    for (i = 0; i < batch->len; i++)
     {
-        LEAVE ("gnc_price_list_insert failed");
-        return FALSE;
+        gpointer slot = g_ptr_array_index (batch, i);
+        if (PRICE_SLOT_IS_ROW (slot)) continue;
+        if (g_hash_table_lookup (dropped, slot))
+            gnc_price_unref (slot);
+        else
+            qof_event_gen (&((GNCPrice *) slot)->inst, QOF_EVENT_ADD, NULL);
     }
+    g_hash_table_destroy (dropped);
+    g_ptr_array_free (batch, TRUE);
 
-    if (!price_list)
+    for (node = replaced; node; node = node->next)
     {
-        LEAVE (" no price list");
-        return FALSE;
+        gnc_pricedb_remove_price (db, node->data);
+        gnc_price_unref (node->data);
     }
+    g_list_free (replaced);
 
-    g_hash_table_insert(currency_hash, currency, price_list);
-    p->db = db;
-
-    qof_event_gen (&p->inst, QOF_EVENT_ADD, NULL);
-
-    LEAVE ("db=%p, pr=%p dirty=%d dextroying=%d commodity=%s/%s currency_hash=%p",
-           db, p, qof_instance_get_dirty_flag(p),
-           qof_instance_get_destroying(p),
-           gnc_commodity_get_namespace(p->commodity),
-           gnc_commodity_get_mnemonic(p->commodity),
-           currency_hash);
-    return TRUE;
+    if (added && !db->bulk_update)
+    {
+        gnc_pricedb_begin_edit (db);
+        qof_instance_set_dirty (&db->inst);
+        gnc_pricedb_commit_edit (db);
+    }
+    LEAVE ("db=%p", db);
 }
 
-/* If gnc_pricedb_add_price() succeeds, it takes ownership of the
-   passed-in GNCPrice and inserts it into the pricedb. Writing to this
-   pointer afterwards will have interesting results, so don't.
- */
-gboolean
-gnc_pricedb_add_price(GNCPriceDB *db, GNCPrice *p)
+/* The price with guid among db's history rows, made a GNCPrice. */
+static GNCPrice *
+pricedb_lookup_history (GNCPriceDB *db, const GncGUID *guid)
 {
-    if (!db || !p) return FALSE;
-
-    ENTER ("db=%p, pr=%p dirty=%d destroying=%d",
-           db, p, qof_instance_get_dirty_flag(p),
-           qof_instance_get_destroying(p));
+    GHashTable *currency_hash;
+    GPtrArray *series;
+    HistorySeries *key;
+    Timespec t;
+    guint row, i;
 
-    if (FALSE == add_price(db, p))
+    if (!db || !price_history.guids) return NULL;
+    for (row = 0; row < price_history.guids->len; row++)
     {
-        LEAVE (" failed to add price");
-        return FALSE;
+        if (g_array_index (price_history.sources, guint8, row) == HISTORY_DEAD)
+            continue;
+        if (guid_equal (&g_array_index (price_history.guids, GncGUID, row), guid))
+            break;
     }
-
-    gnc_pricedb_begin_edit(db);
-    qof_instance_set_dirty(&db->inst);
-    gnc_pricedb_commit_edit(db);
-
-    LEAVE ("db=%p, pr=%p dirty=%d destroying=%d",
-           db, p, qof_instance_get_dirty_flag(p),
-           qof_instance_get_destroying(p));
-
-    return TRUE;
+    if (row == price_history.guids->len) return NULL;
+
+    key = &g_array_index (price_history.series_keys, HistorySeries,
+                          g_array_index (price_history.series, guint32, row));
+    if (key->db != db) return NULL;
+    currency_hash = g_hash_table_lookup (db->commodity_hash, key->commodity);
+    series = currency_hash ?
+             g_hash_table_lookup (currency_hash, key->currency) : NULL;
+    if (!series) return NULL;
+
+    t.tv_sec = g_array_index (price_history.times, time64, row);
+    t.tv_nsec = 0;
+    for (i = price_series_index (series, t, FALSE); i < series->len; i++)
+        if (g_ptr_array_index (series, i) == PRICE_ROW_SLOT (row))
+            return price_series_at (series, i);
+    return NULL;
 }
 
 /* remove_price() is a utility; its only function is to remove the price
@@ -1190,12 +2076,13 @@ gnc_pricedb_add_price(GNCPriceDB *db, GNCPrice *p)
 static gboolean
 remove_price(GNCPriceDB *db, GNCPrice *p, gboolean cleanup)
 {
-    GList *price_list;
+    GPtrArray *series;
     gnc_commodity *commodity;
     gnc_commodity *currency;
     GHashTable *currency_hash;
 
     if (!db || !p) return FALSE;
+    pricedb_run_deferred_load (db);
     ENTER ("db=%p, pr=%p dirty=%d destroying=%d",
            db, p, qof_instance_get_dirty_flag(p),
            qof_instance_get_destroying(p));
@@ -1226,24 +2113,22 @@ remove_price(GNCPriceDB *db, GNCPrice *p, gboolean cleanup)
     }
 
     qof_event_gen (&p->inst, QOF_EVENT_REMOVE, NULL);
-    price_list = g_hash_table_lookup(currency_hash, currency);
+    series = g_hash_table_lookup(currency_hash, currency);
     gnc_price_ref(p);
-    if (!gnc_price_list_remove(&price_list, p))
-    {
-        gnc_price_unref(p);
-        LEAVE (" cannot remove price list");
-        return FALSE;
-    }
+    if (series)
+        price_series_remove (series, p);
+    pricedb_conversion_cache_flush (db);
 
-    /* if the price list is empty, then remove this currency from the
+    /* if the price series is empty, then remove this currency from the
        commodity hash */
-    if (price_list)
-    {
-        g_hash_table_insert(currency_hash, currency, price_list);
-    }
-    else
+    if (!series || series->len == 0)
     {
-        g_hash_table_remove(currency_hash, currency);
+        if (series)
+        {
+            g_hash_table_remove(currency_hash, currency);
+            price_series_destroy (series);
+            pricedb_exchange_link (db, commodity, currency, -1);
+        }
 
         if (cleanup)
         {
@@ -1338,18 +2223,21 @@ pricedb_remove_foreach_pricelist (gpointer key,
                                   gpointer val,
                                   gpointer user_data)
 {
-    GList *price_list = (GList *) val;
-    GList *node = price_list;
+    GPtrArray *series = (GPtrArray *) val;
     remove_info *data = (remove_info *) user_data;
+    guint n, i;
 
     ENTER("key %p, value %p, data %p", key, val, user_data);
 
-    /* The most recent price is the first in the list */
-    if (!data->delete_last)
-        node = g_list_next(node);
+    /* Only the prices up to the cutoff can go.  The most recent price is
+     * the last in the series. */
+    n = price_series_index (series, data->cutoff, TRUE);
+    if (!data->delete_last && n == series->len && n > 0)
+        n--;
 
-    /* now check each item in the list */
-    g_list_foreach(node, (GFunc)check_one_price_date, data);
+    /* now check each of them */
+    for (i = 0; i < n; i++)
+        check_one_price_date (price_series_at (series, i), data);
 
     LEAVE(" ");
 }
@@ -1377,6 +2265,7 @@ gnc_pricedb_remove_old_prices(GNCPriceDB *db,
     remove_info data;
     GSList *item;
 
+    pricedb_run_deferred_load (db);
     data.db = db;
     data.cutoff = cutoff;
     data.delete_user = delete_user;
@@ -1419,30 +2308,33 @@ static void
 hash_values_helper(gpointer key, gpointer value, gpointer data)
 {
     GList ** l = data;
+    GList *prices = price_series_to_list (value);
     if (*l)
     {
         GList *new_l;
-        new_l = pricedb_price_list_merge(*l, value);
+        new_l = pricedb_price_list_merge(*l, prices);
         g_list_free (*l);
+        g_list_free (prices);
         *l = new_l;
     }
     else
-        *l = g_list_copy (value);
+        *l = prices;
 }
 
 static PriceList *
 price_list_from_hashtable (GHashTable *hash, const gnc_commodity *currency)
 {
-    GList *price_list = NULL, *result = NULL ;
+    GPtrArray *series;
+    GList *result = NULL;
     if (currency)
     {
-        price_list = g_hash_table_lookup(hash, currency);
-        if (!price_list)
+        series = g_hash_table_lookup(hash, currency);
+        if (!series)
         {
             LEAVE (" no price list");
             return NULL;
         }
-        result = g_list_copy (price_list);
+        result = price_series_to_list (series);
     }
     else
     {
@@ -1485,6 +2377,19 @@ pricedb_price_list_merge (PriceList *a, PriceList *b)
     return g_list_reverse (merged_list);
 }
 
+/* The series of commodity's prices in currency, or NULL. */
+static GPtrArray *
+pricedb_get_series (GNCPriceDB *db, const gnc_commodity *commodity,
+                    const gnc_commodity *currency)
+{
+    GHashTable *currency_hash;
+
+    pricedb_run_deferred_load (db);
+    currency_hash = g_hash_table_lookup (db->commodity_hash, commodity);
+    if (!currency_hash) return NULL;
+    return g_hash_table_lookup (currency_hash, currency);
+}
+
 static PriceList*
 pricedb_get_prices_internal(GNCPriceDB *db, const gnc_commodity *commodity,
                             const gnc_commodity *currency, gboolean bidi)
@@ -1493,6 +2398,7 @@ pricedb_get_prices_internal(GNCPriceDB *db, const gnc_commodity *commodity,
     PriceList *forward_list = NULL, *reverse_list = NULL;
     g_return_val_if_fail (db != NULL, NULL);
     g_return_val_if_fail (commodity != NULL, NULL);
+    pricedb_run_deferred_load (db);
     forward_hash = g_hash_table_lookup(db->commodity_hash, commodity);
     if (currency && bidi)
         reverse_hash = g_hash_table_lookup(db->commodity_hash, currency);
@@ -1536,21 +2442,16 @@ gnc_pricedb_lookup_latest(GNCPriceDB *db,
                           const gnc_commodity *commodity,
                           const gnc_commodity *currency)
 {
-    GList *price_list;
     GNCPrice *result;
-    GHashTable *currency_hash;
 
     if (!db || !commodity || !currency) return NULL;
     ENTER ("db=%p commodity=%p currency=%p", db, commodity, currency);
 
-    price_list = pricedb_get_prices_internal(db, commodity, currency, TRUE);
-    if (!price_list) return NULL;
-    /* This works magically because prices are inserted in date-sorted
-     * order, and the latest date always comes first. So return the
-     * first in the list.  */
-    result = price_list->data;
+    /* The latest price is the last in each direction's series. */
+    result = price_newer_of (
+                 price_series_latest (pricedb_get_series (db, commodity, currency)),
+                 price_series_latest (pricedb_get_series (db, currency, commodity)));
     gnc_price_ref(result);
-    g_list_free (price_list);
     LEAVE(" ");
     return result;
 }
@@ -1560,13 +2461,13 @@ static void
 lookup_latest(gpointer key, gpointer val, gpointer user_data)
 {
     //gnc_commodity *currency = (gnc_commodity *)key;
-    GList *price_list = (GList *)val;
+    GPtrArray *series = (GPtrArray *)val;
     GList **return_list = (GList **)user_data;
 
-    if (!price_list) return;
+    if (!series || !series->len) return;
 
-    /* the latest price is the first in list */
-    gnc_price_list_insert(return_list, price_list->data, FALSE);
+    /* the latest price is the last in the series */
+    gnc_price_list_insert(return_list, price_series_latest (series), FALSE);
 }
 
 typedef struct
@@ -1587,54 +2488,42 @@ typedef struct
 */
 
 static gboolean
-price_list_scan_any_currency(GList *price_list, gpointer data)
+price_list_scan_any_currency(GPtrArray *series, gpointer data)
 {
     UsesCommodity *helper = (UsesCommodity*)data;
-    GList *node = price_list;
+    GNCPrice *price;
     gnc_commodity *com;
     gnc_commodity *cur;
+    guint n;
 
-    if (!price_list)
+    if (!series || !series->len)
         return TRUE;
 
-    com = gnc_price_get_commodity(node->data);
-    cur = gnc_price_get_currency(node->data);
+    price_slot_commodities(g_ptr_array_index(series, 0), &com, &cur);
 
-    /* if this price list isn't for the commodity we are interested in,
+    /* if this price series isn't for the commodity we are interested in,
        ignore it. */
     if (com != helper->com && cur != helper->com)
         return TRUE;
 
-    /* The price list is sorted in decreasing order of time.  Find the first
-       price on it that is older than the requested time and add it and the
-       previous price to the result list. */
-    while (node != NULL)
+    /* Find the latest price older than the requested time and add it and
+       the next newer price to the result list. */
+    n = price_series_index(series, helper->t, FALSE);
+    if (n > 0)
     {
-        GNCPrice *price = node->data;
-        Timespec price_t = gnc_price_get_time(price);
-        if (timespec_cmp(&price_t, &helper->t) < 0)
-        {
-            /* If there is a previous price add it to the results. */
-            if (node->prev)
-            {
-                GNCPrice *prev_price = node->prev->data;
-                gnc_price_ref(prev_price);
-                *helper->list = g_list_prepend(*helper->list, prev_price);
-            }
-            /* Add the first price before the desired time */
-            gnc_price_ref(price);
-            *helper->list = g_list_prepend(*helper->list, price);
-            /* No point in looking further, they will all be older */
-            break;
-        }
-        else if (node->next == NULL)
+        if (n < series->len)
         {
-            /* The last price is later than given time, add it */
-            gnc_price_ref(price);
-            *helper->list = g_list_prepend(*helper->list, price);
+            GNCPrice *next_price = price_series_at(series, n);
+            gnc_price_ref(next_price);
+            *helper->list = g_list_prepend(*helper->list, next_price);
         }
-        node = node->next;
+        price = price_series_at(series, n - 1);
     }
+    else
+        price = price_series_at(series, 0);
+    /* Failing one older, add the oldest, which is later than the time. */
+    gnc_price_ref(price);
+    *helper->list = g_list_prepend(*helper->list, price);
 
     return TRUE;
 }
@@ -1839,11 +2728,12 @@ gnc_pricedb_has_prices(GNCPriceDB *db,
                        const gnc_commodity *commodity,
                        const gnc_commodity *currency)
 {
-    GList *price_list;
+    GPtrArray *series;
     GHashTable *currency_hash;
     gint size;
 
     if (!db || !commodity) return FALSE;
+    pricedb_run_deferred_load (db);
     ENTER ("db=%p commodity=%p currency=%p", db, commodity, currency);
     currency_hash = g_hash_table_lookup(db->commodity_hash, commodity);
     if (!currency_hash)
@@ -1854,8 +2744,8 @@ gnc_pricedb_has_prices(GNCPriceDB *db,
 
     if (currency)
     {
-        price_list = g_hash_table_lookup(currency_hash, currency);
-        if (price_list)
+        series = g_hash_table_lookup(currency_hash, currency);
+        if (series)
         {
             LEAVE("yes");
             return TRUE;
@@ -1899,9 +2789,9 @@ static void
 price_count_helper(gpointer key, gpointer value, gpointer data)
 {
     int *result = data;
-    GList *price_list = value;
+    GPtrArray *series = value;
 
-    *result += g_list_length(price_list);
+    *result += series->len;
 }
 
 int
@@ -1912,6 +2802,7 @@ gnc_pricedb_num_prices(GNCPriceDB *db,
     GHashTable *currency_hash;
 
     if (!db || !c) return 0;
+    pricedb_run_deferred_load (db);
     ENTER ("db=%p commodity=%p", db, c);
 
     currency_hash = g_hash_table_lookup(db->commodity_hash, c);
@@ -1935,6 +2826,7 @@ gnc_pricedb_nth_price (GNCPriceDB *db,
     GHashTable *currency_hash;
 
     if (!db || !c || n < 0) return NULL;
+    pricedb_run_deferred_load (db);
     ENTER ("db=%p commodity=%p index=%d", db, c, n);
 
     currency_hash = g_hash_table_lookup(db->commodity_hash, c);
@@ -1950,60 +2842,65 @@ gnc_pricedb_nth_price (GNCPriceDB *db,
             g_hash_table_iter_init(&iter, currency_hash);
             if (g_hash_table_iter_next(&iter, &key, &value))
             {
-                PriceList *prices = value;
-                result = g_list_nth_data(prices, n);
+                GPtrArray *series = value;
+                if ((guint)n < series->len)
+                    result = price_series_at(series, series->len - 1 - n);
             }
         }
         else if (num_currencies > 1)
         {
             /* Prices for multiple currencies, must find the nth entry in the
                merged currency list. */
-            GList **price_array = (GList **)g_new(gpointer, num_currencies);
-            GList **next_list;
+            GPtrArray **series = g_new(GPtrArray *, num_currencies);
+            guint *left = g_new(guint, num_currencies);
             int i, j;
             GHashTableIter iter;
             gpointer key, value;
 
-            /* Build an array of all the currencies this commodity has prices for */
+            /* Build an array of all the currencies this commodity has prices
+               for, with the number of prices not yet passed in each */
             for (i = 0, g_hash_table_iter_init(&iter, currency_hash);
                  g_hash_table_iter_next(&iter, &key, &value) && i < num_currencies;
                  i++)
             {
-                price_array[i] = value;
+                series[i] = value;
+                left[i] = series[i]->len;
             }
 
             /* Iterate n times to get the nth price, each time finding the currency
                with the latest price */
             for (i = 0; i <= n; i++)
             {
-                next_list = NULL;
+                int next = -1;
                 for (j = 0; j < num_currencies; j++)
                 {
                     /* Save this entry if it's the first one or later than
                        the saved one. */
-                    if (price_array[j] != NULL &&
-                        (next_list == NULL || *next_list == NULL ||
-                        compare_prices_by_date((*next_list)->data, (price_array[j])->data) > 0))
+                    if (left[j] > 0 &&
+                        (next < 0 ||
+                         compare_slots_by_date(g_ptr_array_index(series[next], left[next] - 1),
+                                               g_ptr_array_index(series[j], left[j] - 1)) > 0))
                     {
-                        next_list = &price_array[j];
+                        next = j;
                     }
                 }
-                /* next_list points to the list with the latest price unless all
-                   the lists are empty */
-                if (next_list && *next_list)
+                /* next is the series with the latest price unless all of
+                   them have been passed */
+                if (next >= 0)
                 {
-                    result = (*next_list)->data;
-                    *next_list = (*next_list)->next;
+                    result = price_series_at(series[next], left[next] - 1);
+                    left[next]--;
                 }
                 else
                 {
-                    /* all the lists are empty, "n" is greater than the number
-                       of prices for this commodity. */
+                    /* all the series are passed, "n" is greater than the
+                       number of prices for this commodity. */
                     result = NULL;
                     break;
                 }
             }
-            g_free(price_array);
+            g_free(series);
+            g_free(left);
         }
     }
 
@@ -2026,29 +2923,29 @@ gnc_pricedb_lookup_at_time(GNCPriceDB *db,
                            const gnc_commodity *currency,
                            Timespec t)
 {
-    GList *price_list;
-    GList *item = NULL;
-    GHashTable *currency_hash;
+    GNCPrice *forward, *reverse, *result;
+    Timespec price_time;
 
     if (!db || !c || !currency) return NULL;
     ENTER ("db=%p commodity=%p currency=%p", db, c, currency);
-    price_list = pricedb_get_prices_internal (db, c, currency, TRUE);
-    item = price_list;
-    while (item)
+    forward = price_series_latest_until (pricedb_get_series (db, c, currency), t);
+    if (forward)
     {
-        GNCPrice *p = item->data;
-        Timespec price_time = gnc_price_get_time(p);
-        if (timespec_equal(&price_time, &t))
-        {
-            gnc_price_ref(p);
-            g_list_free (price_list);
-            return p;
-        }
-        item = item->next;
+        price_time = gnc_price_get_time(forward);
+        if (!timespec_equal(&price_time, &t))
+            forward = NULL;
+    }
+    reverse = price_series_latest_until (pricedb_get_series (db, currency, c), t);
+    if (reverse)
+    {
+        price_time = gnc_price_get_time(reverse);
+        if (!timespec_equal(&price_time, &t))
+            reverse = NULL;
     }
-    g_list_free (price_list);
+    result = price_newer_of (forward, reverse);
+    gnc_price_ref(result);
     LEAVE (" ");
-    return NULL;
+    return result;
 }
 
 static GNCPrice *
@@ -2058,36 +2955,26 @@ lookup_nearest_in_time(GNCPriceDB *db,
                        Timespec t,
                        gboolean sameday)
 {
-    GList *price_list;
+    GPtrArray *forward, *reverse;
     GNCPrice *current_price = NULL;
     GNCPrice *next_price = NULL;
     GNCPrice *result = NULL;
-    GList *item = NULL;
-    GHashTable *currency_hash;
 
     if (!db || !c || !currency) return NULL;
     ENTER ("db=%p commodity=%p currency=%p", db, c, currency);
-    price_list = pricedb_get_prices_internal (db, c, currency, TRUE);
-    if (!price_list) return NULL;
-    item = price_list;
-
-    /* default answer */
-    current_price = item->data;
-
-    /* find the first candidate past the one we want.  Remember that
-       prices are in most-recent-first order. */
-    while (!next_price && item)
-    {
-        GNCPrice *p = item->data;
-        Timespec price_time = gnc_price_get_time(p);
-        if (timespec_cmp(&price_time, &t) <= 0)
-        {
-            next_price = item->data;
-            break;
-        }
-        current_price = item->data;
-        item = item->next;
-    }
+    forward = pricedb_get_series (db, c, currency);
+    reverse = pricedb_get_series (db, currency, c);
+    if (!forward && !reverse) return NULL;
+
+    /* next_price is the latest price at or before the time we want, and
+       current_price the earliest one after it, or the latest of all when
+       there is none after. */
+    next_price = price_newer_of (price_series_latest_until (forward, t),
+                                 price_series_latest_until (reverse, t));
+    current_price = price_older_of (price_series_earliest_after (forward, t),
+                                    price_series_earliest_after (reverse, t));
+    if (!current_price)
+        current_price = next_price;
 
     if (current_price)      /* How can this be null??? */
     {
@@ -2159,7 +3046,6 @@ lookup_nearest_in_time(GNCPriceDB *db,
     }
 
     gnc_price_ref(result);
-    g_list_free (price_list);
     LEAVE (" ");
     return result;
 }
@@ -2179,50 +3065,40 @@ gnc_pricedb_lookup_latest_before (GNCPriceDB *db,
                                   gnc_commodity *currency,
                                   Timespec t)
 {
-    GList *price_list;
     GNCPrice *current_price = NULL;
-    /*  GNCPrice *next_price = NULL;
-        GNCPrice *result = NULL;*/
-    GList *item = NULL;
-    GHashTable *currency_hash;
-    Timespec price_time;
 
     if (!db || !c || !currency) return NULL;
     ENTER ("db=%p commodity=%p currency=%p", db, c, currency);
-    price_list = pricedb_get_prices_internal (db, c, currency, TRUE);
-    if (!price_list) return NULL;
-    item = price_list;
-    do
-    {
-        price_time = gnc_price_get_time (item->data);
-        if (timespec_cmp(&price_time, &t) <= 0)
-            current_price = item->data;
-        item = item->next;
-    }
-    while (timespec_cmp(&price_time, &t) > 0 && item);
+    current_price = price_newer_of (
+        price_series_latest_until (pricedb_get_series (db, c, currency), t),
+        price_series_latest_until (pricedb_get_series (db, currency, c), t));
     gnc_price_ref(current_price);
-    g_list_free (price_list);
     LEAVE (" ");
     return current_price;
 }
 
+/* The price between from and to to convert with, with a reference the
+ * caller must drop, or NULL. */
+static GNCPrice *
+direct_balance_price (GNCPriceDB *db, const gnc_commodity *from,
+                      const gnc_commodity *to, Timespec *t)
+{
+    if (from == NULL || to == NULL)
+        return NULL;
+    if (t != NULL)
+        return gnc_pricedb_lookup_nearest_in_time(db, from, to, *t);
+    return gnc_pricedb_lookup_latest(db, from, to);
+}
+
 static gnc_numeric
-direct_balance_conversion (GNCPriceDB *db, gnc_numeric bal,
-                           const gnc_commodity *from, const gnc_commodity *to,
-                           Timespec *t)
+direct_balance_conversion (GNCPrice *price, gnc_numeric bal,
+                           const gnc_commodity *from, const gnc_commodity *to)
 {
-    GNCPrice *price;
     gnc_numeric retval = gnc_numeric_zero();
-    if (from == NULL || to == NULL)
+    if (price == NULL)
         return retval;
     if (gnc_numeric_zero_p(bal))
         return retval;
-    if (t != NULL)
-        price = gnc_pricedb_lookup_nearest_in_time(db, from, to, *t);
-    else
-        price = gnc_pricedb_lookup_latest(db, from, to);
-    if (price == NULL)
-        return retval;
     if (gnc_price_get_commodity(price) == from)
         retval = gnc_numeric_mul (bal, gnc_price_get_value (price),
                                   gnc_commodity_get_fraction (to),
@@ -2231,7 +3107,6 @@ direct_balance_conversion (GNCPriceDB *db, gnc_numeric bal,
         retval = gnc_numeric_div (bal, gnc_price_get_value (price),
                                   gnc_commodity_get_fraction (to),
                                   GNC_HOW_RND_ROUND);
-    gnc_price_unref (price);
     return retval;
 
 }
@@ -2311,18 +3186,16 @@ convert_balance(gnc_numeric bal, const gnc_commodity *from,
                            fraction, GNC_HOW_RND_ROUND);
 
 }
-static gnc_numeric
-indirect_balance_conversion (GNCPriceDB *db, gnc_numeric bal,
-                             const gnc_commodity *from, const gnc_commodity *to,
-                             Timespec *t )
+/* The prices to convert with through a third commodity, with references
+ * the caller must drop, or a tuple of NULLs. */
+static PriceTuple
+indirect_balance_prices (GNCPriceDB *db, const gnc_commodity *from,
+                         const gnc_commodity *to, Timespec *t)
 {
     GList *from_prices = NULL, *to_prices = NULL;
-    PriceTuple tuple;
-    gnc_numeric zero = gnc_numeric_zero();
+    PriceTuple tuple = {NULL, NULL};
     if (from == NULL || to == NULL)
-        return zero;
-    if (gnc_numeric_zero_p(bal))
-        return zero;
+        return tuple;
     if (t == NULL)
     {
         from_prices = gnc_pricedb_lookup_latest_any_currency(db, from);
@@ -2340,34 +3213,325 @@ indirect_balance_conversion (GNCPriceDB *db, gnc_numeric bal,
                                                                     to, *t);
     }
     if (from_prices == NULL || to_prices == NULL)
-        return zero;
+    {
+        gnc_price_list_destroy(from_prices);
+        return tuple;
+    }
     tuple = extract_common_prices(from_prices, to_prices);
     gnc_price_list_destroy(from_prices);
     gnc_price_list_destroy(to_prices);
-    if (tuple.from)
-        return convert_balance(bal, from, to, tuple);
-    return zero;
+    return tuple;
 }
 
+/* Balance conversion cache
 
-/*
- * Convert a balance from one currency to another.
+   Reports convert many balances between the same commodities at the same
+   dates, so the prices a conversion settles on are kept by commodity
+   pair and time, to the second, until a price is added or removed.  The
+   prices, not the rates, are kept so that the results are the same as
+   without the cache.
  */
-gnc_numeric
-gnc_pricedb_convert_balance_latest_price(GNCPriceDB *pdb,
-        gnc_numeric balance,
-        const gnc_commodity *balance_currency,
-        const gnc_commodity *new_currency)
+typedef struct
+{
+    const gnc_commodity *from;
+    const gnc_commodity *to;
+    gboolean latest;
+    gint64 secs;
+} ConversionKey;
+
+typedef struct
+{
+    ConversionKey key;
+    GNCPrice *direct;           /* price between from and to, or NULL */
+    gboolean have_indirect;     /* tuple has been looked up */
+    PriceTuple tuple;           /* prices through a third commodity */
+    gboolean have_chain;        /* chain has been looked up */
+    GPtrArray *chain;           /* prices through several, or NULL */
+} ConversionEntry;
+
+static guint
+conversion_key_hash (gconstpointer key)
+{
+    const ConversionKey *k = key;
+    return g_direct_hash (k->from) ^ (g_direct_hash (k->to) * 31) ^
+           (guint) k->secs ^ (guint) (k->secs >> 32) ^ (guint) k->latest;
+}
+
+static gboolean
+conversion_key_equal (gconstpointer a, gconstpointer b)
+{
+    const ConversionKey *ka = a, *kb = b;
+    return ka->from == kb->from && ka->to == kb->to &&
+           ka->latest == kb->latest && ka->secs == kb->secs;
+}
+
+static void
+conversion_entry_free (gpointer data)
+{
+    ConversionEntry *entry = data;
+    gnc_price_unref (entry->direct);
+    gnc_price_unref (entry->tuple.from);
+    gnc_price_unref (entry->tuple.to);
+    if (entry->chain)
+        price_series_destroy (entry->chain);
+    g_free (entry);
+}
+
+static void
+pricedb_conversion_cache_flush (GNCPriceDB *db)
+{
+    if (db->conversion_cache)
+        g_hash_table_remove_all (db->conversion_cache);
+}
+
+/* The cache entry for converting from to to at t, or at the latest
+ * prices if t is NULL, with its direct price looked up. */
+static ConversionEntry *
+pricedb_conversion_entry (GNCPriceDB *db, const gnc_commodity *from,
+                          const gnc_commodity *to, Timespec *t)
+{
+    ConversionKey key;
+    ConversionEntry *entry;
+
+    /* Loading prices empties the cache, so do it first. */
+    pricedb_run_deferred_load (db);
+    if (!db->conversion_cache)
+        db->conversion_cache = g_hash_table_new_full (conversion_key_hash,
+                                                      conversion_key_equal,
+                                                      NULL,
+                                                      conversion_entry_free);
+    key.from = from;
+    key.to = to;
+    key.latest = (t == NULL);
+    key.secs = t ? t->tv_sec : 0;
+    entry = g_hash_table_lookup (db->conversion_cache, &key);
+    if (entry)
+    {
+        db->conversion_hits++;
+        return entry;
+    }
+
+    db->conversion_misses++;
+    entry = g_new0 (ConversionEntry, 1);
+    entry->key = key;
+    entry->direct = direct_balance_price (db, from, to, t);
+    g_hash_table_insert (db->conversion_cache, &entry->key, entry);
+    return entry;
+}
+
+/* Exchange graph
+
+   The commodities are the nodes of a graph with an edge between two of
+   them for each price series either way round.  It is kept up to date as
+   series come and go, and conversions no pair of prices covers follow
+   the shortest chain of edges, found breadth first and remembered until
+   an edge changes.
+ */
+typedef struct
+{
+    ConversionKey key;
+    GPtrArray *commodities;     /* from to to, empty if there is no chain */
+} ExchangePath;
+
+static void
+exchange_path_free (gpointer data)
+{
+    ExchangePath *path = data;
+    g_ptr_array_free (path->commodities, TRUE);
+    g_free (path);
+}
+
+static void
+exchange_graph_count (GNCPriceDB *db, const gnc_commodity *a,
+                      const gnc_commodity *b, gint delta)
+{
+    GHashTable *edges = g_hash_table_lookup (db->exchange_graph, a);
+    gint count;
+
+    if (!edges)
+    {
+        edges = g_hash_table_new (NULL, NULL);
+        g_hash_table_insert (db->exchange_graph, (gpointer) a, edges);
+    }
+    count = GPOINTER_TO_INT (g_hash_table_lookup (edges, b)) + delta;
+    if (count > 0)
+        g_hash_table_insert (edges, (gpointer) b, GINT_TO_POINTER (count));
+    else
+        g_hash_table_remove (edges, b);
+}
+
+/* Count a price series between a and b in or, for a negative delta, out
+ * of the graph. */
+static void
+pricedb_exchange_link (GNCPriceDB *db, const gnc_commodity *a,
+                       const gnc_commodity *b, gint delta)
+{
+    if (!db->exchange_graph)
+        db->exchange_graph =
+            g_hash_table_new_full (NULL, NULL, NULL,
+                                   (GDestroyNotify) g_hash_table_destroy);
+    exchange_graph_count (db, a, b, delta);
+    exchange_graph_count (db, b, a, delta);
+    if (db->exchange_paths)
+        g_hash_table_remove_all (db->exchange_paths);
+}
+
+static GPtrArray *
+exchange_graph_search (GNCPriceDB *db, const gnc_commodity *from,
+                       const gnc_commodity *to)
+{
+    GHashTable *came_from = g_hash_table_new (NULL, NULL);
+    GQueue queue = G_QUEUE_INIT;
+    GPtrArray *commodities = g_ptr_array_new ();
+    gpointer node;
+
+    g_hash_table_insert (came_from, (gpointer) from, (gpointer) from);
+    g_queue_push_tail (&queue, (gpointer) from);
+    while ((node = g_queue_pop_head (&queue)) != NULL && node != to)
+    {
+        GHashTable *edges = g_hash_table_lookup (db->exchange_graph, node);
+        GHashTableIter iter;
+        gpointer next;
+
+        if (!edges) continue;
+        g_hash_table_iter_init (&iter, edges);
+        while (g_hash_table_iter_next (&iter, &next, NULL))
+        {
+            if (g_hash_table_lookup (came_from, next)) continue;
+            g_hash_table_insert (came_from, next, node);
+            g_queue_push_tail (&queue, next);
+        }
+    }
+    g_queue_clear (&queue);
+
+    if (g_hash_table_lookup (came_from, to))
+    {
+        guint i;
+        for (node = (gpointer) to; node != from;
+             node = g_hash_table_lookup (came_from, node))
+            g_ptr_array_add (commodities, node);
+        g_ptr_array_add (commodities, (gpointer) from);
+        for (i = 0; i < commodities->len / 2; i++)
+        {
+            gpointer tmp = commodities->pdata[i];
+            commodities->pdata[i] = commodities->pdata[commodities->len - 1 - i];
+            commodities->pdata[commodities->len - 1 - i] = tmp;
+        }
+    }
+    g_hash_table_destroy (came_from);
+    return commodities;
+}
+
+/* The commodities on the shortest chain of prices from from to to, both
+ * included, or an empty array if there is none. */
+static GPtrArray *
+pricedb_exchange_path (GNCPriceDB *db, const gnc_commodity *from,
+                       const gnc_commodity *to)
+{
+    ConversionKey key = {from, to, FALSE, 0};
+    ExchangePath *path;
+
+    if (!db->exchange_paths)
+        db->exchange_paths = g_hash_table_new_full (conversion_key_hash,
+                                                    conversion_key_equal,
+                                                    NULL, exchange_path_free);
+    path = g_hash_table_lookup (db->exchange_paths, &key);
+    if (!path)
+    {
+        path = g_new0 (ExchangePath, 1);
+        path->key = key;
+        path->commodities = db->exchange_graph ?
+                            exchange_graph_search (db, from, to) :
+                            g_ptr_array_new ();
+        g_hash_table_insert (db->exchange_paths, &path->key, path);
+    }
+    return path->commodities;
+}
+
+/* The prices for each step of the shortest chain from from to to, with
+ * references, or NULL if there is no chain. */
+static GPtrArray *
+exchange_chain_prices (GNCPriceDB *db, const gnc_commodity *from,
+                       const gnc_commodity *to, Timespec *t)
+{
+    GPtrArray *commodities = pricedb_exchange_path (db, from, to);
+    GPtrArray *chain;
+    guint i;
+
+    if (commodities->len < 2)
+        return NULL;
+    chain = g_ptr_array_sized_new (commodities->len - 1);
+    for (i = 1; i < commodities->len; i++)
+    {
+        GNCPrice *price = direct_balance_price (db,
+                                                commodities->pdata[i - 1],
+                                                commodities->pdata[i], t);
+        if (!price)
+        {
+            price_series_destroy (chain);
+            return NULL;
+        }
+        g_ptr_array_add (chain, price);
+    }
+    return chain;
+}
+
+static gnc_numeric
+exchange_chain_conversion (GPtrArray *chain, gnc_numeric bal,
+                           const gnc_commodity *from, const gnc_commodity *to)
+{
+    const gnc_commodity *current = from;
+    int no_round = GNC_HOW_DENOM_EXACT | GNC_HOW_RND_NEVER;
+    guint i;
+
+    for (i = 0; i < chain->len; i++)
+    {
+        GNCPrice *price = g_ptr_array_index (chain, i);
+        gnc_numeric value = gnc_price_get_value (price);
+        gboolean last = (i == chain->len - 1);
+        gint64 denom = last ? gnc_commodity_get_fraction (to) : GNC_DENOM_AUTO;
+        gint how = last ? GNC_HOW_RND_ROUND : no_round;
+
+        if (gnc_price_get_commodity (price) == current)
+        {
+            bal = gnc_numeric_mul (bal, value, denom, how);
+            current = gnc_price_get_currency (price);
+        }
+        else
+        {
+            bal = gnc_numeric_div (bal, value, denom, how);
+            current = gnc_price_get_commodity (price);
+        }
+    }
+    if (gnc_numeric_check (bal))
+    {
+        PWARN ("Converting %s to %s in %u steps failed",
+               gnc_commodity_get_mnemonic (from),
+               gnc_commodity_get_mnemonic (to), chain->len);
+        return gnc_numeric_zero ();
+    }
+    return bal;
+}
+
+static gnc_numeric
+pricedb_convert_balance (GNCPriceDB *pdb, gnc_numeric balance,
+                         const gnc_commodity *balance_currency,
+                         const gnc_commodity *new_currency, Timespec *t)
 {
+    ConversionEntry *entry;
     gnc_numeric new_value;
 
     if (gnc_numeric_zero_p (balance) ||
-            gnc_commodity_equiv (balance_currency, new_currency))
+        gnc_commodity_equiv (balance_currency, new_currency))
         return balance;
+    if (!pdb || !balance_currency || !new_currency)
+        return gnc_numeric_zero ();
+
+    entry = pricedb_conversion_entry (pdb, balance_currency, new_currency, t);
 
     /* Look for a direct price. */
-    new_value = direct_balance_conversion(pdb, balance, balance_currency,
-                                          new_currency, NULL);
+    new_value = direct_balance_conversion (entry->direct, balance,
+                                           balance_currency, new_currency);
     if (!gnc_numeric_zero_p(new_value))
         return new_value;
 
@@ -2375,8 +3539,52 @@ gnc_pricedb_convert_balance_latest_price(GNCPriceDB *pdb,
      * no direct price found, try if we find a price in another currency
      * and convert in two stages
      */
-    return indirect_balance_conversion(pdb, balance, balance_currency,
-                                       new_currency, NULL);
+    if (!entry->have_indirect)
+    {
+        entry->tuple = indirect_balance_prices (pdb, balance_currency,
+                                                new_currency, t);
+        entry->have_indirect = TRUE;
+    }
+    if (entry->tuple.from)
+        return convert_balance (balance, balance_currency, new_currency,
+                                entry->tuple);
+
+    /* Nor that, so go the shortest way through the exchange graph. */
+    if (!entry->have_chain)
+    {
+        entry->chain = exchange_chain_prices (pdb, balance_currency,
+                                              new_currency, t);
+        entry->have_chain = TRUE;
+    }
+    if (entry->chain)
+        return exchange_chain_conversion (entry->chain, balance,
+                                          balance_currency, new_currency);
+    return gnc_numeric_zero ();
+}
+
+void
+gnc_pricedb_get_conversion_cache_stats (GNCPriceDB *pdb, guint *hits,
+                                        guint *misses, guint *entries)
+{
+    if (hits) *hits = pdb ? pdb->conversion_hits : 0;
+    if (misses) *misses = pdb ? pdb->conversion_misses : 0;
+    if (entries)
+        *entries = (pdb && pdb->conversion_cache) ?
+                   g_hash_table_size (pdb->conversion_cache) : 0;
+}
+
+
+/*
+ * Convert a balance from one currency to another.
+ */
+gnc_numeric
+gnc_pricedb_convert_balance_latest_price(GNCPriceDB *pdb,
+        gnc_numeric balance,
+        const gnc_commodity *balance_currency,
+        const gnc_commodity *new_currency)
+{
+    return pricedb_convert_balance (pdb, balance, balance_currency,
+                                    new_currency, NULL);
 }
 
 gnc_numeric
@@ -2386,24 +3594,8 @@ gnc_pricedb_convert_balance_nearest_price(GNCPriceDB *pdb,
         const gnc_commodity *new_currency,
         Timespec t)
 {
-    gnc_numeric new_value;
-
-    if (gnc_numeric_zero_p (balance) ||
-        gnc_commodity_equiv (balance_currency, new_currency))
-        return balance;
-
-    /* Look for a direct price. */
-    new_value = direct_balance_conversion(pdb, balance, balance_currency,
-                                          new_currency, &t);
-    if (!gnc_numeric_zero_p(new_value))
-        return new_value;
-
-    /*
-     * no direct price found, try if we find a price in another currency
-     * and convert in two stages
-     */
-    return indirect_balance_conversion(pdb, balance, balance_currency,
-                                       new_currency, &t);
+    return pricedb_convert_balance (pdb, balance, balance_currency,
+                                    new_currency, &t);
 }
 
 
@@ -2421,16 +3613,15 @@ typedef struct
 static void
 pricedb_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)
 {
-    GList *price_list = (GList *) val;
-    GList *node = price_list;
+    GPtrArray *series = (GPtrArray *) val;
+    guint i = series->len;
     GNCPriceDBForeachData *foreach_data = (GNCPriceDBForeachData *) user_data;
 
-    /* stop traversal when func returns FALSE */
-    while (foreach_data->ok && node)
+    /* newest first; stop traversal when func returns FALSE */
+    while (foreach_data->ok && i > 0)
     {
-        GNCPrice *p = (GNCPrice *) node->data;
+        GNCPrice *p = price_series_at (series, --i);
         foreach_data->ok = foreach_data->func(p, foreach_data->user_data);
-        node = node->next;
     }
 }
 
@@ -2449,6 +3640,8 @@ unstable_price_traversal(GNCPriceDB *db,
     GNCPriceDBForeachData foreach_data;
 
     if (!db || !f) return FALSE;
+    pricedb_run_deferred_load (db);
+    pricedb_run_deferred_load (db);
     foreach_data.ok = TRUE;
     foreach_data.func = f;
     foreach_data.user_data = user_data;
@@ -2467,18 +3660,18 @@ unstable_price_traversal(GNCPriceDB *db,
 typedef struct
 {
     gboolean ok;
-    gboolean (*func)(GList *p, gpointer user_data);
+    gboolean (*func)(GPtrArray *series, gpointer user_data);
     gpointer user_data;
 } GNCPriceListForeachData;
 
 static void
 pricedb_pricelist_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)
 {
-    GList *price_list = (GList *) val;
+    GPtrArray *series = (GPtrArray *) val;
     GNCPriceListForeachData *foreach_data = (GNCPriceListForeachData *) user_data;
     if (foreach_data->ok)
     {
-        foreach_data->ok = foreach_data->func(price_list, foreach_data->user_data);
+        foreach_data->ok = foreach_data->func(series, foreach_data->user_data);
     }
 }
 
@@ -2491,7 +3684,7 @@ pricedb_pricelist_foreach_currencies_hash(gpointer key, gpointer val, gpointer u
 
 static gboolean
 pricedb_pricelist_traversal(GNCPriceDB *db,
-                         gboolean (*f)(GList *p, gpointer user_data),
+                         gboolean (*f)(GPtrArray *series, gpointer user_data),
                          gpointer user_data)
 {
     GNCPriceListForeachData foreach_data;
@@ -2547,6 +3740,7 @@ stable_price_traversal(GNCPriceDB *db,
     GSList *i = NULL;
 
     if (!db || !f) return FALSE;
+    pricedb_run_deferred_load (db);
 
     currency_hashes = hash_table_to_list(db->commodity_hash);
     currency_hashes = g_slist_sort(currency_hashes,
@@ -2563,12 +3757,12 @@ stable_price_traversal(GNCPriceDB *db,
         for (j = price_lists; j; j = j->next)
         {
             HashEntry *pricelist_entry = (HashEntry *) j->data;
-            GList *price_list = (GList *) pricelist_entry->value;
-            GList *node;
+            GPtrArray *series = (GPtrArray *) pricelist_entry->value;
+            guint k;
 
-            for (node = (GList *) price_list; node; node = node->next)
+            for (k = series->len; k > 0; k--)
             {
-                GNCPrice *price = (GNCPrice *) node->data;
+                GNCPrice *price = price_series_at (series, k - 1);
 
                 /* stop traversal when f returns FALSE */
                 if (FALSE == ok) break;
@@ -2788,15 +3982,14 @@ VoidGNCPriceDBForeachData;
 static void
 void_pricedb_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)
 {
-    GList *price_list = (GList *) val;
-    GList *node = price_list;
+    GPtrArray *series = (GPtrArray *) val;
+    guint i = series->len;
     VoidGNCPriceDBForeachData *foreach_data = (VoidGNCPriceDBForeachData *) user_data;
 
-    while (node)
+    while (i > 0)
     {
-        GNCPrice *p = (GNCPrice *) node->data;
+        GNCPrice *p = price_series_at (series, --i);
         foreach_data->func(p, foreach_data->user_data);
-        node = node->next;
     }
 }
 
@@ -2815,6 +4008,7 @@ void_unstable_price_traversal(GNCPriceDB *db,
     VoidGNCPriceDBForeachData foreach_data;
 
     if (!db || !f) return;
+    pricedb_run_deferred_load (db);
     foreach_data.func = f;
     foreach_data.user_data = user_data;
 
@@ -364,6 +364,39 @@ void gnc_pricedb_set_bulk_update(GNCPriceDB *db, gboolean bulk_update);
  */
 gboolean     gnc_pricedb_add_price(GNCPriceDB *db, GNCPrice *p);
 
+/** @brief Add a saved price to the pricedb in compact form.
+ *
+ * For backends loading the price history: the pricedb copies p's GUID,
+ * commodity, currency, time, source, type and value into compact storage
+ * and keeps no reference to p, which the caller should drop.  A GNCPrice
+ * with the same GUID is made again when something asks for the price.
+ * There is no check for a duplicate on the same day.  A price with KVP
+ * data or a fraction of a second in its time is added as it is instead.
+ * @param db The pricedb
+ * @param p The price to copy.
+ * @return TRUE if the price was added, FALSE otherwise.
+ */
+gboolean     gnc_pricedb_add_price_compact(GNCPriceDB *db, GNCPrice *p);
+
+/** @brief Start adding many prices at once.
+ *
+ * Until the matching gnc_pricedb_end_batch, gnc_pricedb_add_price and
+ * gnc_pricedb_add_price_compact only take note of the prices; lookups
+ * don't see them yet.  Batches nest.
+ * @param db The pricedb
+ */
+void gnc_pricedb_begin_batch(GNCPriceDB *db);
+
+/** @brief Add the prices noted since gnc_pricedb_begin_batch.
+ *
+ * Each price series they go to is sorted and merged once, and a price
+ * replaces or gives way to one on the same day just as
+ * gnc_pricedb_add_price would have decided in the order they came.
+ * The pricedb is marked dirty once.
+ * @param db The pricedb
+ */
+void gnc_pricedb_end_batch(GNCPriceDB *db);
+
 /** @brief Remove a price from the pricedb and unref the price.
  * @param db The Pricedb
  * @param p The price to remove.
@@ -536,6 +569,10 @@ PriceList * gnc_pricedb_lookup_latest_before_any_currency(GNCPriceDB *db,
 
 /** @brief Convert a balance from one currency to another using the most recent
  * price between the two.
+ *
+ * Failing a price between the two, the balance is converted through a
+ * commodity both have prices in, or else along the shortest chain of
+ * prices between them; the same goes for the nearest price below.
  * @param pdb The pricedb
  * @param balance The balance to be converted
  * @param balance_currency The commodity in which the balance is currently
@@ -566,6 +603,19 @@ gnc_pricedb_convert_balance_nearest_price(GNCPriceDB *pdb,
                                           const gnc_commodity *new_currency,
                                           Timespec t);
 
+/** @brief Report how well the balance conversion cache is doing.
+ *
+ * The two convert_balance functions remember which prices they used for
+ * a pair of commodities at a time until a price is added or removed.
+ * @param pdb The pricedb
+ * @param hits The number of conversions answered from the cache
+ * @param misses The number of conversions that had to look up prices
+ * @param entries The number of pairs and times the cache holds now
+ * Any of the pointers may be NULL.
+ */
+void gnc_pricedb_get_conversion_cache_stats (GNCPriceDB *pdb, guint *hits,
+                                             guint *misses, guint *entries);
+
 typedef gboolean (*GncPriceForeachFunc)(GNCPrice *p, gpointer user_data);
 
 /** @brief Call a GncPriceForeachFunction once for each price in db, until the
@@ -0,0 +1,393 @@
+/********************************************************************\
+ * gnc-text-index.c -- Trigram index of transaction texts           *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+\********************************************************************/
+
+#include "config.h"
+
+#include <glib.h>
+#include <string.h>
+
+#include "qof.h"
+#include "qofquerycore-p.h"
+#include "Split.h"
+#include "Transaction.h"
+#include "gnc-engine.h"
+#include "gnc-text-index.h"
+
+static QofLogModule log_module = GNC_MOD_ENGINE;
+
+#define TEXT_INDEX_KEY "gnc-text-index"
+
+/* A trigram is kept as a hash of its three characters.  Two trigrams
+ * with the same hash only make the index find a few more candidates,
+ * which the query then checks and throws away. */
+typedef guint32 Trigram;
+
+typedef struct
+{
+    /* Trigram -> GPtrArray of the transactions having it. */
+    GHashTable *postings;
+    /* Transaction -> GArray of its trigrams, sorted, each once. */
+    GHashTable *trans_trigrams;
+} TextIndex;
+
+static inline Trigram
+trigram_of (gunichar a, gunichar b, gunichar c)
+{
+    return ((a * 1000003u) ^ b) * 1000003u ^ c;
+}
+
+static void
+add_trigrams (GArray *trigrams, const char *text)
+{
+    gunichar c0 = 0, c1 = 0, c2;
+    guint n = 0;
+
+    for (; *text; text = g_utf8_next_char (text))
+    {
+        c2 = g_utf8_get_char (text);
+        if (++n >= 3)
+        {
+            Trigram t = trigram_of (c0, c1, c2);
+            g_array_append_val (trigrams, t);
+        }
+        c0 = c1;
+        c1 = c2;
+    }
+}
+
+/* A case sensitive match of a string is a match of the case folded
+ * string in the case folded text, and a case insensitive one matches
+ * the normalized case folded string in the normalized case folded text,
+ * so the index holds the trigrams of both. */
+static void
+add_text (GArray *trigrams, const char *text)
+{
+    gchar *folded, *normalized;
+
+    if (!text || !*text)
+        return;
+    folded = g_utf8_casefold (text, -1);
+    add_trigrams (trigrams, folded);
+    normalized = g_utf8_normalize (folded, -1, G_NORMALIZE_ALL);
+    if (normalized && strcmp (normalized, folded) != 0)
+        add_trigrams (trigrams, normalized);
+    g_free (normalized);
+    g_free (folded);
+}
+
+static gint
+trigram_cmp (gconstpointer a, gconstpointer b)
+{
+    Trigram ta = *(const Trigram *)a, tb = *(const Trigram *)b;
+    return ta < tb ? -1 : ta > tb;
+}
+
+static void
+sort_unique (GArray *trigrams)
+{
+    guint i, n = 0;
+
+    g_array_sort (trigrams, trigram_cmp);
+    for (i = 0; i < trigrams->len; i++)
+        if (n == 0 || g_array_index (trigrams, Trigram, i) !=
+                g_array_index (trigrams, Trigram, n - 1))
+            g_array_index (trigrams, Trigram, n++) =
+                g_array_index (trigrams, Trigram, i);
+    g_array_set_size (trigrams, n);
+}
+
+static GArray *
+trans_trigrams (Transaction *trans)
+{
+    GArray *trigrams = g_array_new (FALSE, FALSE, sizeof (Trigram));
+    GList *node;
+
+    add_text (trigrams, xaccTransGetDescription (trans));
+    add_text (trigrams, xaccTransGetNotes (trans));
+    for (node = xaccTransGetSplitList (trans); node; node = node->next)
+        add_text (trigrams, xaccSplitGetMemo (node->data));
+    sort_unique (trigrams);
+    return trigrams;
+}
+
+static void
+index_add (TextIndex *index, Transaction *trans)
+{
+    GArray *trigrams = trans_trigrams (trans);
+    guint i;
+
+    for (i = 0; i < trigrams->len; i++)
+    {
+        Trigram t = g_array_index (trigrams, Trigram, i);
+        GPtrArray *posting = g_hash_table_lookup (index->postings,
+                                                  GUINT_TO_POINTER (t));
+        if (!posting)
+        {
+            posting = g_ptr_array_new ();
+            g_hash_table_insert (index->postings, GUINT_TO_POINTER (t),
+                                 posting);
+        }
+        g_ptr_array_add (posting, trans);
+    }
+    g_hash_table_insert (index->trans_trigrams, trans, trigrams);
+}
+
+static void
+index_remove (TextIndex *index, Transaction *trans)
+{
+    GArray *trigrams = g_hash_table_lookup (index->trans_trigrams, trans);
+    guint i;
+
+    if (!trigrams)
+        return;
+    for (i = 0; i < trigrams->len; i++)
+    {
+        gpointer key = GUINT_TO_POINTER (g_array_index (trigrams, Trigram, i));
+        GPtrArray *posting = g_hash_table_lookup (index->postings, key);
+
+        if (!posting)
+            continue;
+        g_ptr_array_remove_fast (posting, trans);
+        if (posting->len == 0)
+            g_hash_table_remove (index->postings, key);
+    }
+    g_hash_table_remove (index->trans_trigrams, trans);
+}
+
+static void
+index_add_cb (QofInstance *inst, gpointer user_data)
+{
+    index_add (user_data, GNC_TRANSACTION (inst));
+}
+
+static void
+text_index_free (QofBook *book, gpointer key, gpointer user_data)
+{
+    TextIndex *index = user_data;
+
+    if (!index)
+        return;
+    g_hash_table_destroy (index->postings);
+    g_hash_table_destroy (index->trans_trigrams);
+    g_free (index);
+}
+
+static TextIndex *
+text_index_get (QofBook *book)
+{
+    TextIndex *index = qof_book_get_data (book, TEXT_INDEX_KEY);
+
+    if (index)
+        return index;
+
+    ENTER ("book=%p", book);
+    index = g_new (TextIndex, 1);
+    index->postings = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                             NULL,
+                                             (GDestroyNotify) g_ptr_array_unref);
+    index->trans_trigrams = g_hash_table_new_full (g_direct_hash,
+                                                   g_direct_equal, NULL,
+                                                   (GDestroyNotify) g_array_unref);
+    qof_collection_foreach (qof_book_get_collection (book, GNC_ID_TRANS),
+                            index_add_cb, index);
+    qof_book_set_data_fin (book, TEXT_INDEX_KEY, index, text_index_free);
+    LEAVE ("%u trigrams", g_hash_table_size (index->postings));
+    return index;
+}
+
+/* The book's index, if it has one and isn't being torn down. */
+static TextIndex *
+trans_text_index (Transaction *trans)
+{
+    QofBook *book = qof_instance_get_book (QOF_INSTANCE (trans));
+
+    if (!book || qof_book_shutting_down (book))
+        return NULL;
+    return qof_book_get_data (book, TEXT_INDEX_KEY);
+}
+
+void
+gnc_text_index_trans_committed (Transaction *trans)
+{
+    TextIndex *index;
+
+    g_return_if_fail (GNC_IS_TRANSACTION (trans));
+
+    index = trans_text_index (trans);
+    if (!index)
+        return;
+    index_remove (index, trans);
+    index_add (index, trans);
+}
+
+void
+gnc_text_index_trans_destroyed (Transaction *trans)
+{
+    TextIndex *index;
+
+    g_return_if_fail (GNC_IS_TRANSACTION (trans));
+
+    index = trans_text_index (trans);
+    if (index)
+        index_remove (index, trans);
+}
+
+/* ================================================================ */
+/* Query index */
+
+static gchar *
+fold_match_string (const query_string_def *pd)
+{
+    gchar *folded = g_utf8_casefold (pd->matchstring, -1);
+    gchar *normalized;
+
+    if (pd->options != QOF_STRING_MATCH_CASEINSENSITIVE)
+        return folded;
+    normalized = g_utf8_normalize (folded, -1, G_NORMALIZE_ALL);
+    g_free (folded);
+    return normalized;
+}
+
+/* Substring matches, and case sensitive equality, of at least three
+ * characters.  A regular expression could be served from its literal
+ * runs, but isn't yet. */
+static gboolean
+text_index_accepts (const QofQueryPredData *pdata)
+{
+    const query_string_def *pd = (const query_string_def *) pdata;
+    gchar *folded;
+    gboolean ok;
+
+    if (g_strcmp0 (pdata->type_name, QOF_TYPE_STRING) != 0 ||
+            pd->is_regex || !pd->matchstring)
+        return FALSE;
+    if (pdata->how != QOF_COMPARE_CONTAINS &&
+            !(pdata->how == QOF_COMPARE_EQUAL &&
+              pd->options != QOF_STRING_MATCH_CASEINSENSITIVE))
+        return FALSE;
+
+    folded = fold_match_string (pd);
+    ok = folded && g_utf8_strlen (folded, -1) >= 3;
+    g_free (folded);
+    return ok;
+}
+
+static gboolean
+has_all_trigrams (const GArray *have, const GArray *want)
+{
+    guint i = 0, j = 0;
+
+    while (j < want->len)
+    {
+        Trigram w = g_array_index (want, Trigram, j);
+
+        while (i < have->len && g_array_index (have, Trigram, i) < w)
+            i++;
+        if (i == have->len || g_array_index (have, Trigram, i) != w)
+            return FALSE;
+        j++;
+    }
+    return TRUE;
+}
+
+static void
+text_index_foreach (QofBook *book, QofIdTypeConst search_for,
+                    const QofQueryPredData *pdata,
+                    QofInstanceForeachCB cb, gpointer user_data)
+{
+    TextIndex *index = text_index_get (book);
+    GArray *want = g_array_new (FALSE, FALSE, sizeof (Trigram));
+    GPtrArray *shortest = NULL;
+    gboolean splits = g_strcmp0 (search_for, GNC_ID_TRANS) != 0;
+    gchar *folded;
+    guint i;
+
+    folded = fold_match_string ((const query_string_def *) pdata);
+    if (folded)
+        add_trigrams (want, folded);
+    g_free (folded);
+    sort_unique (want);
+    if (want->len == 0)
+    {
+        g_array_free (want, TRUE);
+        qof_object_foreach (search_for, book, cb, user_data);
+        return;
+    }
+
+    /* Walk the rarest trigram's transactions, checking the others
+     * against each one's own trigrams. */
+    for (i = 0; i < want->len; i++)
+    {
+        GPtrArray *posting =
+            g_hash_table_lookup (index->postings,
+                                 GUINT_TO_POINTER (g_array_index (want,
+                                                   Trigram, i)));
+        if (!posting)
+        {
+            g_array_free (want, TRUE);
+            return;
+        }
+        if (!shortest || posting->len < shortest->len)
+            shortest = posting;
+    }
+
+    for (i = 0; i < shortest->len; i++)
+    {
+        Transaction *trans = g_ptr_array_index (shortest, i);
+        GList *node;
+
+        if (!has_all_trigrams (g_hash_table_lookup (index->trans_trigrams,
+                                                    trans), want))
+            continue;
+        if (!splits)
+        {
+            cb (QOF_INSTANCE (trans), user_data);
+            continue;
+        }
+        for (node = xaccTransGetSplitList (trans); node; node = node->next)
+            cb (node->data, user_data);
+    }
+    g_array_free (want, TRUE);
+}
+
+void
+gnc_text_index_register (void)
+{
+    qof_query_register_index (GNC_ID_SPLIT, "transaction text",
+                              qof_query_build_param_list (SPLIT_TRANS,
+                                                          TRANS_DESCRIPTION,
+                                                          NULL),
+                              20, text_index_accepts, text_index_foreach);
+    qof_query_register_index (GNC_ID_SPLIT, "transaction text",
+                              qof_query_build_param_list (SPLIT_TRANS,
+                                                          TRANS_NOTES, NULL),
+                              20, text_index_accepts, text_index_foreach);
+    qof_query_register_index (GNC_ID_SPLIT, "transaction text",
+                              qof_query_build_param_list (SPLIT_MEMO, NULL),
+                              20, text_index_accepts, text_index_foreach);
+    qof_query_register_index (GNC_ID_TRANS, "transaction text",
+                              qof_query_build_param_list (TRANS_DESCRIPTION,
+                                                          NULL),
+                              20, text_index_accepts, text_index_foreach);
+    qof_query_register_index (GNC_ID_TRANS, "transaction text",
+                              qof_query_build_param_list (TRANS_NOTES, NULL),
+                              20, text_index_accepts, text_index_foreach);
+}
@@ -0,0 +1,51 @@
+/********************************************************************\
+ * gnc-text-index.h -- Trigram index of transaction texts           *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+\********************************************************************/
+
+/** @file gnc-text-index.h
+ *  @brief Engine-private trigram index of transaction texts
+ *
+ * A book's transactions can be indexed by the trigrams, the runs of
+ * three characters, of their description, notes and split memos, case
+ * folded.  A query for the transactions or splits whose texts contain a
+ * string then only needs to check those having every trigram of the
+ * string.  The index is built the first time a query asks for it and
+ * then kept up to date by transaction commits.
+ */
+
+#ifndef GNC_TEXT_INDEX_H
+#define GNC_TEXT_INDEX_H
+
+#include "Transaction.h"
+
+/** Register the index with the query subsystem, for string matches on
+ *  the description, notes and memos of split and transaction
+ *  queries. */
+void gnc_text_index_register (void);
+
+/** Reindex the texts of a transaction which has been committed, if its
+ *  book has an index. */
+void gnc_text_index_trans_committed (Transaction *trans);
+
+/** Take a transaction which is being destroyed out of its book's
+ *  index. */
+void gnc_text_index_trans_destroyed (Transaction *trans);
+
+#endif /* GNC_TEXT_INDEX_H */
@@ -24,6 +24,7 @@
 #include "config.h"
 
 #include "gncBusGuile.h"
+#include "gncOwner.h"
 #include "engine-helpers.h"
 #include "engine-helpers-guile.h"
 #include "swig-runtime.h"
@@ -82,3 +83,58 @@ SCM gnc_account_value_ptr_to_scm (GncAccountValue *av)
     return scm_cons (SWIG_NewPointerObj(av->account, account_type, 0),
                      gnc_numeric_to_scm (val));
 }
+
+SCM gnc_owner_aging_to_scm (Account *account, SCM report_date,
+                            SCM interval_ends, gboolean reverse,
+                            gboolean show_zeros, gboolean use_due_date)
+{
+    static swig_type_info *owner_type = NULL, *commodity_type = NULL;
+    Timespec *ends;
+    guint i, num_intervals;
+    GList *aging, *node;
+    SCM result = SCM_EOL;
+
+    if (!account || !scm_is_vector (interval_ends))
+        return SCM_EOL;
+
+    if (!owner_type)
+        owner_type = SWIG_TypeQuery("_p__gncOwner");
+    if (!commodity_type)
+        commodity_type = SWIG_TypeQuery("_p_gnc_commodity");
+
+    num_intervals = scm_c_vector_length (interval_ends);
+    if (num_intervals == 0)
+        return SCM_EOL;
+    ends = g_new (Timespec, num_intervals);
+    for (i = 0; i < num_intervals; i++)
+        ends[i] = gnc_timepair2timespec (scm_c_vector_ref (interval_ends, i));
+
+    aging = gncOwnerGetAging (account, gnc_timepair2timespec (report_date),
+                              ends, num_intervals, reverse, show_zeros,
+                              use_due_date);
+    g_free (ends);
+
+    for (node = aging; node; node = node->next)
+    {
+        GncOwnerAging *entry = node->data;
+        GncOwner *owner = gncOwnerNew ();
+        SCM buckets = scm_c_make_vector (num_intervals, SCM_BOOL_F);
+        SCM item = scm_c_make_vector (5, SCM_BOOL_F);
+
+        gncOwnerCopy (&entry->owner, owner);
+        for (i = 0; i < num_intervals; i++)
+            scm_c_vector_set_x (buckets, i,
+                                gnc_numeric_to_scm (entry->buckets[i]));
+
+        scm_c_vector_set_x (item, 0, SWIG_NewPointerObj (owner, owner_type, 0));
+        scm_c_vector_set_x (item, 1, SWIG_NewPointerObj (entry->currency,
+                                                         commodity_type, 0));
+        scm_c_vector_set_x (item, 2, buckets);
+        scm_c_vector_set_x (item, 3, gnc_numeric_to_scm (entry->overpayment));
+        scm_c_vector_set_x (item, 4, scm_from_bool (entry->mixed_currency));
+        result = scm_cons (item, result);
+    }
+    gncOwnerAgingListFree (aging);
+
+    return scm_reverse (result);
+}
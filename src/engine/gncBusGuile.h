@@ -25,9 +25,19 @@
 #define GNC_BUSINESS_GUILE_H_
 
 #include <gncTaxTable.h>	/* for GncAccountValue */
+#include <Account.h>
 #include <libguile.h>
 
 GncAccountValue * gnc_scm_to_account_value_ptr (SCM valuearg);
 SCM gnc_account_value_ptr_to_scm (GncAccountValue *);
 
+/** Age the owner balances in an A/R or A/P account; see
+ *  gncOwnerGetAging().  interval_ends is a vector of timepairs.
+ *  Returns a list with one vector per owner: #(owner currency buckets
+ *  overpayment mixed-currency?), where owner is a new GncOwner that
+ *  the caller must free and buckets is a vector of gnc_numerics. */
+SCM gnc_owner_aging_to_scm (Account *account, SCM report_date,
+                            SCM interval_ends, gboolean reverse,
+                            gboolean show_zeros, gboolean use_due_date);
+
 #endif /* GNC_BUSINESS_GUILE_H_ */
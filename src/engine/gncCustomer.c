@@ -43,6 +43,7 @@
 
 #include "gncCustomer.h"
 #include "gncCustomerP.h"
+#include "gncIDSearch.h"
 #include "gncJobP.h"
 #include "gncTaxTableP.h"
 
@@ -354,6 +355,7 @@ static void gncCustomerFree (GncCustomer *cust)
 
     qof_event_gen (&cust->inst, QOF_EVENT_DESTROY, NULL);
 
+    gnc_search_id_changed (&cust->inst, cust->id, NULL);
     CACHE_REMOVE (cust->id);
     CACHE_REMOVE (cust->name);
     CACHE_REMOVE (cust->notes);
@@ -391,6 +393,7 @@ void gncCustomerSetID (GncCustomer *cust, const char *id)
 {
     if (!cust) return;
     if (!id) return;
+    gnc_search_id_changed (&cust->inst, cust->id, id);
     SET_STR(cust, cust->id, id);
     mark_customer (cust);
     gncCustomerCommitEdit (cust);
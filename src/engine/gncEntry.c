@@ -36,6 +36,7 @@
 #include "gncEntryP.h"
 #include "gnc-features.h"
 #include "gncInvoice.h"
+#include "gncInvoiceP.h"
 #include "gncOrder.h"
 
 struct _gncEntry
@@ -82,7 +83,7 @@ struct _gncEntry
     /* customer invoice */
     gnc_numeric	i_value;
     gnc_numeric	i_value_rounded;
-    GList *	i_tax_values;
+    GArray *	i_tax_values;	/* of GncAccountValue */
     gnc_numeric	i_tax_value;
     gnc_numeric	i_tax_value_rounded;
     gnc_numeric	i_disc_value;
@@ -92,7 +93,7 @@ struct _gncEntry
     /* vendor bill */
     gnc_numeric	b_value;
     gnc_numeric	b_value_rounded;
-    GList *	b_tax_values;
+    GArray *	b_tax_values;	/* of GncAccountValue */
     gnc_numeric	b_tax_value;
     gnc_numeric	b_tax_value_rounded;
     Timespec	b_taxtable_modtime;
@@ -205,6 +206,10 @@ void mark_entry (GncEntry *entry)
 {
     qof_instance_set_dirty(&entry->inst);
     qof_event_gen (&entry->inst, QOF_EVENT_MODIFY, NULL);
+    if (entry->invoice)
+        gncInvoiceEntryChanged (entry->invoice);
+    if (entry->bill)
+        gncInvoiceEntryChanged (entry->bill);
 }
 
 /* ================================================================ */
@@ -463,9 +468,9 @@ static void gncEntryFree (GncEntry *entry)
     CACHE_REMOVE (entry->action);
     CACHE_REMOVE (entry->notes);
     if (entry->i_tax_values)
-        gncAccountValueDestroy (entry->i_tax_values);
+        g_array_free (entry->i_tax_values, TRUE);
     if (entry->b_tax_values)
-        gncAccountValueDestroy (entry->b_tax_values);
+        g_array_free (entry->b_tax_values, TRUE);
     if (entry->i_tax_table)
         gncTaxTableDecRef (entry->i_tax_table);
     if (entry->b_tax_table)
@@ -1312,10 +1317,27 @@ get_entry_commodity_denom (const GncEntry *entry)
     return 100000;
 }
 
+/* Keep the tax values in a flat array instead of the list of separately
+ * allocated values gncEntryComputeValue returns, which is destroyed. */
+static void
+gncEntrySetTaxValues (GArray **array, GList *values)
+{
+    GList *node;
+
+    if (!*array)
+        *array = g_array_sized_new (FALSE, FALSE, sizeof (GncAccountValue),
+                                    g_list_length (values));
+    g_array_set_size (*array, 0);
+    for (node = values; node; node = node->next)
+        g_array_append_val (*array, *(GncAccountValue *) node->data);
+    gncAccountValueDestroy (values);
+}
+
 static void
 gncEntryRecomputeValues (GncEntry *entry)
 {
     int denom;
+    GList *i_tax_values = NULL, *b_tax_values = NULL;
 
     /* See if either tax table changed since we last computed values */
     if (entry->i_tax_table)
@@ -1340,18 +1362,6 @@ gncEntryRecomputeValues (GncEntry *entry)
     if (!entry->values_dirty)
         return;
 
-    /* Clear the last-computed tax values */
-    if (entry->i_tax_values)
-    {
-        gncAccountValueDestroy (entry->i_tax_values);
-        entry->i_tax_values = NULL;
-    }
-    if (entry->b_tax_values)
-    {
-        gncAccountValueDestroy (entry->b_tax_values);
-        entry->b_tax_values = NULL;
-    }
-
     /* Determine the commodity denominator */
     denom = get_entry_commodity_denom (entry);
 
@@ -1363,7 +1373,7 @@ gncEntryRecomputeValues (GncEntry *entry)
                           entry->i_disc_how,
                           denom,
                           &(entry->i_value), &(entry->i_disc_value),
-                          &(entry->i_tax_values));
+                          &i_tax_values);
 
     /* Compute the bill values */
     gncEntryComputeValue (entry->quantity, entry->b_price,
@@ -1371,19 +1381,21 @@ gncEntryRecomputeValues (GncEntry *entry)
                           entry->b_taxincluded,
                           gnc_numeric_zero(), GNC_AMT_TYPE_VALUE, GNC_DISC_PRETAX,
                           denom,
-                          &(entry->b_value), NULL, &(entry->b_tax_values));
+                          &(entry->b_value), NULL, &b_tax_values);
 
     entry->i_value_rounded = gnc_numeric_convert (entry->i_value, denom,
                              GNC_HOW_RND_ROUND_HALF_UP);
     entry->i_disc_value_rounded = gnc_numeric_convert (entry->i_disc_value, denom,
                                   GNC_HOW_RND_ROUND_HALF_UP);
-    entry->i_tax_value = gncAccountValueTotal (entry->i_tax_values);
+    entry->i_tax_value = gncAccountValueTotal (i_tax_values);
+    gncEntrySetTaxValues (&entry->i_tax_values, i_tax_values);
     entry->i_tax_value_rounded = gnc_numeric_convert (entry->i_tax_value, denom,
                                  GNC_HOW_RND_ROUND_HALF_UP);
 
     entry->b_value_rounded = gnc_numeric_convert (entry->b_value, denom,
                              GNC_HOW_RND_ROUND_HALF_UP);
-    entry->b_tax_value = gncAccountValueTotal (entry->b_tax_values);
+    entry->b_tax_value = gncAccountValueTotal (b_tax_values);
+    gncEntrySetTaxValues (&entry->b_tax_values, b_tax_values);
     entry->b_tax_value_rounded = gnc_numeric_convert (entry->b_tax_value, denom,
                                  GNC_HOW_RND_ROUND_HALF_UP);
     entry->values_dirty = FALSE;
@@ -1411,12 +1423,36 @@ static gnc_numeric gncEntryGetIntTaxValue (GncEntry *entry, gboolean round, gboo
         return (is_cust_doc ? entry->i_tax_value : entry->b_tax_value);
 }
 
-/* Careful: the returned list is managed by the entry, and will only be valid for a short time */
-static AccountValueList * gncEntryGetIntTaxValues (GncEntry *entry, gboolean is_cust_doc)
+const GncAccountValue * gncEntryPeekTaxValues (GncEntry *entry, gboolean is_cust_doc,
+                                               guint *n_values)
 {
+    GArray *values;
+
+    g_return_val_if_fail (n_values, NULL);
+    *n_values = 0;
     if (!entry) return NULL;
     gncEntryRecomputeValues (entry);
-    return (is_cust_doc ? entry->i_tax_values : entry->b_tax_values);
+    values = (is_cust_doc ? entry->i_tax_values : entry->b_tax_values);
+    if (!values || values->len == 0)
+        return NULL;
+    *n_values = values->len;
+    return &g_array_index (values, GncAccountValue, 0);
+}
+
+/* A list of the tax values, negated if asked to. */
+static AccountValueList * gncEntryCopyTaxValues (GncEntry *entry, gboolean is_cust_doc,
+                                                 gboolean negate)
+{
+    const GncAccountValue *int_values;
+    AccountValueList *values = NULL;
+    guint i, n_values;
+
+    int_values = gncEntryPeekTaxValues (entry, is_cust_doc, &n_values);
+    for (i = 0; i < n_values; i++)
+        values = gncAccountValueAdd (values, int_values[i].account,
+                                     (negate ? gnc_numeric_neg (int_values[i].value)
+                                      : int_values[i].value));
+    return values;
 }
 
 static gnc_numeric gncEntryGetIntDiscountValue (GncEntry *entry, gboolean round, gboolean is_cust_doc)
@@ -1444,19 +1480,7 @@ gnc_numeric gncEntryGetDocTaxValue (GncEntry *entry, gboolean round, gboolean is
 /* Careful: the returned list is NOT owned by the entry and should be freed by the caller */
 AccountValueList * gncEntryGetDocTaxValues (GncEntry *entry, gboolean is_cust_doc, gboolean is_cn)
 {
-    AccountValueList *int_values = gncEntryGetIntTaxValues (entry, is_cust_doc);
-    AccountValueList *values = NULL, *node;
-
-    /* Make a copy of the list with negated values if necessary. */
-    for (node = int_values; node; node = node->next)
-    {
-        GncAccountValue *acct_val = node->data;
-        values = gncAccountValueAdd (values, acct_val->account,
-                                     (is_cn ? gnc_numeric_neg (acct_val->value)
-                                      : acct_val->value));
-    }
-
-    return values;
+    return gncEntryCopyTaxValues (entry, is_cust_doc, is_cn);
 }
 
 gnc_numeric gncEntryGetDocDiscountValue (GncEntry *entry, gboolean round, gboolean is_cust_doc, gboolean is_cn)
@@ -1480,19 +1504,7 @@ gnc_numeric gncEntryGetBalTaxValue (GncEntry *entry, gboolean round, gboolean is
 /* Careful: the returned list is NOT owned by the entry and should be freed by the caller */
 AccountValueList * gncEntryGetBalTaxValues (GncEntry *entry, gboolean is_cust_doc)
 {
-    AccountValueList *int_values = gncEntryGetIntTaxValues (entry, is_cust_doc);
-    AccountValueList *values = NULL, *node;
-
-    /* Make a copy of the list with negated values if necessary. */
-    for (node = int_values; node; node = node->next)
-    {
-        GncAccountValue *acct_val = node->data;
-        values = gncAccountValueAdd (values, acct_val->account,
-                                     (is_cust_doc ? gnc_numeric_neg (acct_val->value)
-                                      : acct_val->value));
-    }
-
-    return values;
+    return gncEntryCopyTaxValues (entry, is_cust_doc, is_cust_doc);
 }
 
 gnc_numeric gncEntryGetBalDiscountValue (GncEntry *entry, gboolean round, gboolean is_cust_doc)
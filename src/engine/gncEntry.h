@@ -255,6 +255,14 @@ gnc_numeric gncEntryGetBalTaxValue (GncEntry *entry, gboolean round, gboolean is
 AccountValueList * gncEntryGetBalTaxValues (GncEntry *entry, gboolean is_cust_doc);
 gnc_numeric gncEntryGetBalDiscountValue (GncEntry *entry, gboolean round, gboolean is_cust_doc);
 
+/** The individual tax values of the entry without copying them: an
+ *  array of n_values values, unrounded, with the sign of the Doc
+ *  variant for a document which is not a credit note.  The array is
+ *  owned by the entry and is only valid until the entry or its tax
+ *  table changes. */
+const GncAccountValue * gncEntryPeekTaxValues (GncEntry *entry, gboolean is_cust_doc,
+                                               guint *n_values);
+
 /** Compute the Entry value, tax_value, and discount_value, based on
  * the quantity, price, discount, tax_-table, and types.  The value is
  * the amount the merchant gets, the taxes are what the gov't gets,
@@ -33,6 +33,127 @@ typedef enum
 
 static void * search(QofBook * book, const gchar *id, void * object, GncSearchType type);
 static QofLogModule log_module = G_LOG_DOMAIN;
+
+/***********************************************************************
+ * The ID index.  Importers look up a customer, vendor or invoice by
+ * ID for every row they read, so rather than querying the whole
+ * collection each time the book keeps, for each type that has been
+ * searched, a hash from ID to the objects with that ID.  It is built
+ * on the first search and then kept current by the ID setters.
+ **********************************************************************/
+#define ID_INDEX_KEY "gnc-id-search-index"
+
+static const gchar *
+instance_id (QofInstance *inst)
+{
+    if (GNC_IS_CUSTOMER (inst))
+        return gncCustomerGetID (GNC_CUSTOMER (inst));
+    if (GNC_IS_VENDOR (inst))
+        return gncVendorGetID (GNC_VENDOR (inst));
+    if (GNC_IS_INVOICE (inst))
+        return gncInvoiceGetID (GNC_INVOICE (inst));
+    return NULL;
+}
+
+static void
+id_table_add (GHashTable *table, const gchar *id, QofInstance *inst)
+{
+    GList *list;
+    gpointer key;
+
+    if (g_hash_table_lookup_extended (table, id, &key, (gpointer *)&list))
+        g_hash_table_steal (table, id);
+    else
+        key = g_strdup (id);
+    g_hash_table_insert (table, key, g_list_prepend (list, inst));
+}
+
+static void
+id_table_remove (GHashTable *table, const gchar *id, QofInstance *inst)
+{
+    GList *list;
+    gpointer key;
+
+    if (!g_hash_table_lookup_extended (table, id, &key, (gpointer *)&list))
+        return;
+    g_hash_table_steal (table, id);
+    list = g_list_remove (list, inst);
+    if (list)
+        g_hash_table_insert (table, key, list);
+    else
+        g_free (key);
+}
+
+static void
+id_table_add_instance (QofInstance *inst, gpointer table)
+{
+    const gchar *id = instance_id (inst);
+    if (id)
+        id_table_add (table, id, inst);
+}
+
+static void
+id_table_free (gpointer table)
+{
+    GHashTableIter iter;
+    gpointer list;
+
+    g_hash_table_iter_init (&iter, table);
+    while (g_hash_table_iter_next (&iter, NULL, &list))
+        g_list_free (list);
+    g_hash_table_destroy (table);
+}
+
+static void
+id_index_free (QofBook *book, gpointer key, gpointer index)
+{
+    g_hash_table_destroy (index);
+    /* The objects of the book are freed after this. */
+    qof_book_set_data (book, ID_INDEX_KEY, NULL);
+}
+
+static GHashTable *
+id_index_get (QofBook *book, QofIdTypeConst type, gboolean create)
+{
+    GHashTable *index, *table;
+
+    index = qof_book_get_data (book, ID_INDEX_KEY);
+    if (!index)
+    {
+        if (!create) return NULL;
+        index = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                       NULL, id_table_free);
+        qof_book_set_data_fin (book, ID_INDEX_KEY, index, id_index_free);
+    }
+
+    table = g_hash_table_lookup (index, type);
+    if (!table && create)
+    {
+        table = g_hash_table_new (g_str_hash, g_str_equal);
+        qof_collection_foreach (qof_book_get_collection (book, type),
+                                id_table_add_instance, table);
+        g_hash_table_insert (index, (gpointer)type, table);
+    }
+    return table;
+}
+
+void
+gnc_search_id_changed (QofInstance *inst, const gchar *old_id,
+                       const gchar *new_id)
+{
+    GHashTable *table;
+
+    if (!inst || !g_strcmp0 (old_id, new_id)) return;
+
+    table = id_index_get (qof_instance_get_book (inst), inst->e_type, FALSE);
+    if (!table) return;
+
+    if (old_id)
+        id_table_remove (table, old_id, inst);
+    if (new_id)
+        id_table_add (table, new_id, inst);
+}
+
 /***********************************************************************
  * Search the book for a Customer/Invoice/Bill with the same ID.
  * If it exists return a valid object, if not then returns NULL.
@@ -86,78 +207,33 @@ gnc_search_vendor_on_id (QofBook * book, const gchar *id)
  ****************************************************************/
 static void * search(QofBook * book, const gchar *id, void * object, GncSearchType type)
 {
-    void *c;
-    GList *result;
-    QofQuery *q;
-    gint len;
-    QofQueryPredData* string_pred_data;
-    
+    GHashTable *table;
+    GList *node;
+    QofIdTypeConst id_type;
+
     PINFO("Type = %d", type);
     g_return_val_if_fail (type, NULL);
     g_return_val_if_fail (id, NULL);
     g_return_val_if_fail (book, NULL);
 
-    // Build the query
-    q = qof_query_create ();
-    qof_query_set_book (q, book);
-    // Search only the id field
-    string_pred_data = qof_query_string_predicate (QOF_COMPARE_EQUAL, id, QOF_STRING_MATCH_NORMAL, FALSE);
     if (type == CUSTOMER)
-    {
-        qof_query_search_for(q,GNC_CUSTOMER_MODULE_NAME);
-        qof_query_add_term (q, qof_query_build_param_list("CUSTOMER_ID"), string_pred_data, QOF_QUERY_AND);
-    }
-    else if (type ==  INVOICE || type ==  BILL)
-    {
-        qof_query_search_for(q,GNC_INVOICE_MODULE_NAME);
-        qof_query_add_term (q, qof_query_build_param_list("INVOICE_ID"), string_pred_data, QOF_QUERY_AND);
-    }
-    else if (type == VENDOR)
-    {
-        qof_query_search_for(q,GNC_VENDOR_MODULE_NAME);
-        qof_query_add_term (q, qof_query_build_param_list("VENDOR_ID"), string_pred_data, QOF_QUERY_AND);
-    }
+        id_type = GNC_CUSTOMER_MODULE_NAME;
+    else if (type == INVOICE || type == BILL)
+        id_type = GNC_INVOICE_MODULE_NAME;
+    else
+        id_type = GNC_VENDOR_MODULE_NAME;
 
-
-    // Run the query
-    result = qof_query_run (q);
-
-    // now compare _exactly_
-    len = g_list_length (result);
-    if (result && (len > 0))
+    table = id_index_get (book, id_type, TRUE);
+    for (node = g_hash_table_lookup (table, id); node; node = node->next)
     {
-        result = g_list_first (result);
-
-        while (result)
-        {
-            c = result->data;
-            
-            if (type == CUSTOMER && strcmp(id, gncCustomerGetID(c)) == 0)
-            {
-                // correct id found
-                object = c;
-                break;
-            }
-            else if (type == INVOICE && strcmp(id, gncInvoiceGetID(c)) == 0 
-                        && gncInvoiceGetType(c) == GNC_INVOICE_CUST_INVOICE)
-            {
-                object = c;
-                break;
-            }
-            else if (type == BILL && strcmp(id, gncInvoiceGetID(c)) == 0 
-                        && gncInvoiceGetType(c) == GNC_INVOICE_VEND_INVOICE)
-            {
-                object = c;
-                break;
-            }
-            else if (type == VENDOR && strcmp(id, gncVendorGetID(c)) == 0)
-            {
-                object = c;
-                break;
-            }
-            result = g_list_next (result);
-        }
+        void *c = node->data;
+
+        if (type == INVOICE && gncInvoiceGetType(c) != GNC_INVOICE_CUST_INVOICE)
+            continue;
+        if (type == BILL && gncInvoiceGetType(c) != GNC_INVOICE_VEND_INVOICE)
+            continue;
+        object = c;
+        break;
     }
-    qof_query_destroy (q);
     return object;
 }
@@ -43,4 +43,10 @@ GncInvoice  * gnc_search_invoice_on_id   (QofBook *book, const gchar *id);
 GncInvoice  * gnc_search_bill_on_id   (QofBook *book, const gchar *id);
 GncVendor  * gnc_search_vendor_on_id   (QofBook *book, const gchar *id);
 
+/* Called by the ID setters of customers, vendors and invoices, and
+ * with new_id NULL when one is freed, to keep the ID index of the
+ * book up to date. */
+void gnc_search_id_changed (QofInstance *inst, const gchar *old_id,
+                            const gchar *new_id);
+
 #endif
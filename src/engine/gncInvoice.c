@@ -35,14 +35,17 @@
 
 #include "Transaction.h"
 #include "Account.h"
+#include "AccountP.h"
 #include "gncBillTermP.h"
 #include "gncEntry.h"
 #include "gncEntryP.h"
 #include "gnc-features.h"
 #include "gncJobP.h"
+#include "gncIDSearch.h"
 #include "gncInvoice.h"
 #include "gncInvoiceP.h"
 #include "gncOwnerP.h"
+#include "gncTaxTableP.h"
 #include "engine-helpers.h"
 
 struct _gncInvoice
@@ -71,6 +74,18 @@ struct _gncInvoice
     Account       *posted_acc;
     Transaction   *posted_txn;
     GNCLot        *posted_lot;
+
+    /* Totals of the entries, computed on first use.  Dropped whenever
+     * the invoice or one of its entries changes, and stale once any
+     * tax table changes after totals_taxtable_generation. */
+    gboolean      totals_valid;
+    guint         totals_taxtable_generation;
+    gnc_numeric   total;
+    gnc_numeric   total_subtotal;
+    gnc_numeric   total_tax;
+    gnc_numeric   total_cash;
+    gnc_numeric   total_card;
+    GList         *total_tax_values;
 };
 
 struct _gncInvoiceClass
@@ -82,6 +97,14 @@ static QofLogModule log_module = GNC_MOD_BUSINESS;
 
 #define _GNC_MOD_NAME     GNC_ID_INVOICE
 
+#define POST_BATCH_KEY "gnc-invoice-post-batch"
+
+typedef struct
+{
+    guint depth;
+    GList *autopay;     /* invoices posted with autopay, newest first */
+} InvoicePostBatch;
+
 #define GNC_INVOICE_IS_CN "credit-note"
 
 #define SET_STR(obj, member, str) { \
@@ -98,6 +121,7 @@ static void mark_invoice (GncInvoice *invoice);
 static void
 mark_invoice (GncInvoice *invoice)
 {
+    invoice->totals_valid = FALSE;
     qof_instance_set_dirty(&invoice->inst);
     qof_event_gen (&invoice->inst, QOF_EVENT_MODIFY, NULL);
 }
@@ -416,11 +440,13 @@ static void gncInvoiceFree (GncInvoice *invoice)
 
     qof_event_gen (&invoice->inst, QOF_EVENT_DESTROY, NULL);
 
+    gnc_search_id_changed (&invoice->inst, invoice->id, NULL);
     CACHE_REMOVE (invoice->id);
     CACHE_REMOVE (invoice->notes);
     CACHE_REMOVE (invoice->billing_id);
     g_list_free (invoice->entries);
     g_list_free (invoice->prices);
+    gncAccountValueDestroy (invoice->total_tax_values);
 
     if (invoice->printname) g_free (invoice->printname);
 
@@ -437,6 +463,7 @@ static void gncInvoiceFree (GncInvoice *invoice)
 void gncInvoiceSetID (GncInvoice *invoice, const char *id)
 {
     if (!invoice || !id) return;
+    gnc_search_id_changed (&invoice->inst, invoice->id, id);
     SET_STR (invoice, invoice->id, id);
     mark_invoice (invoice);
     gncInvoiceCommitEdit (invoice);
@@ -908,28 +935,142 @@ gncInvoiceGetTotalInternal (GncInvoice *invoice, gboolean use_value,
     return total;
 }
 
+/* Work out all the cached totals in one pass over the entries.  Each
+ * is summed in the same order gncInvoiceGetTotalInternal would use. */
+static void
+gncInvoiceComputeTotals (GncInvoice *invoice)
+{
+    GList *node;
+    gnc_numeric zero = gnc_numeric_zero();
+    gboolean is_cust_doc, is_cn;
+
+    invoice->total = invoice->total_subtotal = invoice->total_tax = zero;
+    invoice->total_cash = invoice->total_card = zero;
+    gncAccountValueDestroy (invoice->total_tax_values);
+    invoice->total_tax_values = NULL;
+
+    is_cust_doc = (gncInvoiceGetOwnerType (invoice) == GNC_OWNER_CUSTOMER);
+    is_cn = gncInvoiceGetIsCreditNote (invoice);
+
+    for (node = gncInvoiceGetEntries(invoice); node; node = node->next)
+    {
+        GncEntry *entry = node->data;
+        gnc_numeric *total_of;
+        gnc_numeric value, tax;
+        const GncAccountValue *tax_values;
+        guint i, n_tax_values;
+
+        switch (gncEntryGetBillPayment (entry))
+        {
+        case GNC_PAYMENT_CASH:
+            total_of = &invoice->total_cash;
+            break;
+        case GNC_PAYMENT_CARD:
+            total_of = &invoice->total_card;
+            break;
+        default:
+            total_of = NULL;
+            break;
+        }
+
+        value = gncEntryGetDocValue (entry, FALSE, is_cust_doc, is_cn);
+        if (gnc_numeric_check (value) == GNC_ERROR_OK)
+        {
+            invoice->total = gnc_numeric_add (invoice->total, value,
+                                              GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
+            invoice->total_subtotal = gnc_numeric_add (invoice->total_subtotal, value,
+                                                       GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
+            if (total_of)
+                *total_of = gnc_numeric_add (*total_of, value,
+                                             GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
+        }
+        else
+            g_warning ("bad value in our entry");
+
+        tax = gncEntryGetDocTaxValue (entry, FALSE, is_cust_doc, is_cn);
+        if (gnc_numeric_check (tax) == GNC_ERROR_OK)
+        {
+            invoice->total = gnc_numeric_add (invoice->total, tax,
+                                              GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
+            invoice->total_tax = gnc_numeric_add (invoice->total_tax, tax,
+                                                  GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
+            if (total_of)
+                *total_of = gnc_numeric_add (*total_of, tax,
+                                             GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
+        }
+        else
+            g_warning ("bad tax-value in our entry");
+
+        tax_values = gncEntryPeekTaxValues (entry, is_cust_doc, &n_tax_values);
+        for (i = 0; i < n_tax_values; i++)
+            invoice->total_tax_values =
+                gncAccountValueAdd (invoice->total_tax_values,
+                                    tax_values[i].account,
+                                    (is_cn ? gnc_numeric_neg (tax_values[i].value)
+                                     : tax_values[i].value));
+    }
+
+    invoice->totals_taxtable_generation = gncTaxTableGetGeneration ();
+    invoice->totals_valid = TRUE;
+}
+
+static void
+gncInvoiceUpdateTotals (GncInvoice *invoice)
+{
+    if (invoice->totals_valid &&
+            invoice->totals_taxtable_generation == gncTaxTableGetGeneration ())
+        return;
+    gncInvoiceComputeTotals (invoice);
+}
+
+void gncInvoiceEntryChanged (GncInvoice *invoice)
+{
+    if (!invoice) return;
+    invoice->totals_valid = FALSE;
+}
+
 gnc_numeric gncInvoiceGetTotal (GncInvoice *invoice)
 {
     if (!invoice) return gnc_numeric_zero();
-    return gncInvoiceGetTotalInternal(invoice, TRUE, TRUE, FALSE, 0);
+    gncInvoiceUpdateTotals (invoice);
+    return invoice->total;
 }
 
 gnc_numeric gncInvoiceGetTotalSubtotal (GncInvoice *invoice)
 {
     if (!invoice) return gnc_numeric_zero();
-    return gncInvoiceGetTotalInternal(invoice, TRUE, FALSE, FALSE, 0);
+    gncInvoiceUpdateTotals (invoice);
+    return invoice->total_subtotal;
 }
 
 gnc_numeric gncInvoiceGetTotalTax (GncInvoice *invoice)
 {
     if (!invoice) return gnc_numeric_zero();
-    return gncInvoiceGetTotalInternal(invoice, FALSE, TRUE, FALSE, 0);
+    gncInvoiceUpdateTotals (invoice);
+    return invoice->total_tax;
+}
+
+GList * gncInvoiceGetTotalTaxValues (GncInvoice *invoice)
+{
+    if (!invoice) return NULL;
+    gncInvoiceUpdateTotals (invoice);
+    return invoice->total_tax_values;
 }
 
 gnc_numeric gncInvoiceGetTotalOf (GncInvoice *invoice, GncEntryPaymentType type)
 {
     if (!invoice) return gnc_numeric_zero();
-    return gncInvoiceGetTotalInternal(invoice, TRUE, TRUE, TRUE, type);
+    switch (type)
+    {
+    case GNC_PAYMENT_CASH:
+        gncInvoiceUpdateTotals (invoice);
+        return invoice->total_cash;
+    case GNC_PAYMENT_CARD:
+        gncInvoiceUpdateTotals (invoice);
+        return invoice->total_card;
+    default:
+        return gncInvoiceGetTotalInternal(invoice, TRUE, TRUE, TRUE, type);
+    }
 }
 
 GList * gncInvoiceGetTypeListForOwnerType (GncOwnerType type)
@@ -1159,6 +1300,7 @@ gncInvoiceDetachFromLot (GNCLot *lot)
     gnc_lot_begin_edit (lot);
     qof_instance_set (QOF_INSTANCE (lot), "invoice", NULL, NULL);
     gnc_lot_commit_edit (lot);
+    gnc_account_lot_changed (gnc_lot_get_account (lot), lot);
 }
 
 static void
@@ -1174,6 +1316,7 @@ gncInvoiceAttachToLot (GncInvoice *invoice, GNCLot *lot)
     qof_instance_set (QOF_INSTANCE (lot), "invoice", guid, NULL);
     gnc_lot_commit_edit (lot);
     gncInvoiceSetPostedLot (invoice, lot);
+    gnc_account_lot_changed (gnc_lot_get_account (lot), lot);
 }
 
 GncInvoice * gncInvoiceGetInvoiceFromLot (GNCLot *lot)
@@ -1251,7 +1394,8 @@ GHashTable *gncInvoiceGetForeignCurrencies (const GncInvoice *invoice)
         GncEntry *entry = (GncEntry*)entries_iter->data;
         Account *this_acc;
         gnc_commodity *account_currency;
-        AccountValueList *tt_amts = NULL, *tt_iter;
+        const GncAccountValue *tt_amts;
+        guint tt_iter, n_tt_amts;
 
         /* Check entry's account currency */
         this_acc = (is_cust_doc ? gncEntryGetInvAccount (entry) :
@@ -1271,14 +1415,11 @@ GHashTable *gncInvoiceGetForeignCurrencies (const GncInvoice *invoice)
 
         /* Check currencies of each account in the tax table linked
          * to the current entry */
-        tt_amts = gncEntryGetDocTaxValues (entry, is_cust_doc, is_cn);
-
-        if (!tt_amts)
-            continue;
+        tt_amts = gncEntryPeekTaxValues (entry, is_cust_doc, &n_tt_amts);
 
-        for (tt_iter = tt_amts; tt_iter != NULL; tt_iter = g_list_next(tt_iter))
+        for (tt_iter = 0; tt_iter < n_tt_amts; tt_iter++)
         {
-            GncAccountValue *tt_amt_val = (GncAccountValue*)tt_iter->data;
+            const GncAccountValue *tt_amt_val = &tt_amts[tt_iter];
             Account *tt_acc = tt_amt_val->account;
             gnc_commodity *tt_acc_currency = xaccAccountGetCommodity (tt_acc);
 
@@ -1287,13 +1428,13 @@ GHashTable *gncInvoiceGetForeignCurrencies (const GncInvoice *invoice)
             {
                 gnc_numeric *curr_amt = (gnc_numeric*) g_hash_table_lookup (amt_hash, tt_acc_currency);
                 gnc_numeric *tt_acc_amt = (gnc_numeric*) g_new0 (gnc_numeric, 1);
-                *tt_acc_amt = tt_amt_val->value;
+                *tt_acc_amt = (is_cn ? gnc_numeric_neg (tt_amt_val->value)
+                               : tt_amt_val->value);
                 if (curr_amt)
                     *tt_acc_amt = gnc_numeric_add (*tt_acc_amt, *curr_amt, GNC_DENOM_AUTO, GNC_HOW_RND_ROUND_HALF_UP);
                 g_hash_table_insert (amt_hash, tt_acc_currency, tt_acc_amt);
             }
         }
-        gncAccountValueDestroy (tt_amts);
     }
     return amt_hash;
 }
@@ -1444,7 +1585,8 @@ Transaction * gncInvoicePostToAccount (GncInvoice *invoice, Account *acc,
     for (iter = gncInvoiceGetEntries(invoice); iter; iter = iter->next)
     {
         gnc_numeric value, tax;
-        GList *taxes;
+        const GncAccountValue *taxes;
+        guint i, n_taxes;
         GncEntry * entry = iter->data;
         Account *this_acc;
 
@@ -1467,7 +1609,7 @@ Transaction * gncInvoicePostToAccount (GncInvoice *invoice, Account *acc,
         /* Obtain the Entry's Value and TaxValues */
         value = gncEntryGetBalValue (entry, FALSE, is_cust_doc);
         tax   = gncEntryGetBalTaxValue (entry, FALSE, is_cust_doc);
-        taxes = gncEntryGetBalTaxValues (entry, is_cust_doc);
+        taxes = gncEntryPeekTaxValues (entry, is_cust_doc, &n_taxes);
 
         /* add the value for the account split */
         this_acc = (is_cust_doc ? gncEntryGetInvAccount (entry) :
@@ -1522,16 +1664,18 @@ Transaction * gncInvoicePostToAccount (GncInvoice *invoice, Account *acc,
                 g_warning ("bad value in our entry");
         }
 
-        /* now merge in the TaxValues */
-        splitinfo = gncAccountValueAddList (splitinfo, taxes);
+        /* now merge in the TaxValues, with the sign of
+         * gncEntryGetBalTaxValues */
+        for (i = 0; i < n_taxes; i++)
+            splitinfo = gncAccountValueAdd (splitinfo, taxes[i].account,
+                                            (is_cust_doc ? gnc_numeric_neg (taxes[i].value)
+                                             : taxes[i].value));
 
         /* ... and add the tax total */
         if (gnc_numeric_check (tax) == GNC_ERROR_OK)
             total = gnc_numeric_add (total, tax, GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
         else
             g_warning ("bad tax in our entry");
-
-        gncAccountValueDestroy (taxes);
     } /* for */
 
     /* Iterate through the splitinfo list and generate the splits */
@@ -1616,13 +1760,81 @@ Transaction * gncInvoicePostToAccount (GncInvoice *invoice, Account *acc,
 
     /* If requested, attempt to automatically apply open payments
      * and reverse documents to this lot to close it (or at least
-     * reduce its balance) */
+     * reduce its balance).  In a posting batch this waits until the
+     * batch ends. */
     if (autopay)
-        gncInvoiceAutoApplyPayments (invoice);
+    {
+        InvoicePostBatch *batch = qof_book_get_data (book, POST_BATCH_KEY);
+        if (batch)
+            batch->autopay = g_list_prepend (batch->autopay, invoice);
+        else
+            gncInvoiceAutoApplyPayments (invoice);
+    }
 
     return txn;
 }
 
+void
+gncInvoiceBeginPostBatch (QofBook *book)
+{
+    InvoicePostBatch *batch;
+
+    g_return_if_fail (QOF_IS_BOOK (book));
+
+    batch = qof_book_get_data (book, POST_BATCH_KEY);
+    if (batch)
+    {
+        batch->depth++;
+        return;
+    }
+
+    ENTER ("(book=%p)", book);
+    batch = g_new0 (InvoicePostBatch, 1);
+    batch->depth = 1;
+    qof_book_set_data (book, POST_BATCH_KEY, batch);
+
+    qof_event_begin_batch ();
+    gnc_book_begin_bulk_ingest (book);
+    LEAVE (" ");
+}
+
+void
+gncInvoiceEndPostBatch (QofBook *book)
+{
+    InvoicePostBatch *batch;
+    GList *node;
+
+    g_return_if_fail (QOF_IS_BOOK (book));
+
+    batch = qof_book_get_data (book, POST_BATCH_KEY);
+    if (!batch)
+    {
+        PERR ("no invoice posting batch in progress");
+        return;
+    }
+    if (--batch->depth > 0)
+        return;
+
+    ENTER ("(book=%p)", book);
+    qof_book_set_data (book, POST_BATCH_KEY, NULL);
+
+    /* Apply payments in posting order, once every document of the
+     * batch is there to be matched. */
+    batch->autopay = g_list_reverse (batch->autopay);
+    for (node = batch->autopay; node; node = node->next)
+    {
+        GncInvoice *invoice = node->data;
+        if (invoice->posted_lot)
+            gncInvoiceAutoApplyPayments (invoice);
+    }
+    g_list_free (batch->autopay);
+    g_free (batch);
+
+    gnc_book_end_bulk_ingest (book);
+    qof_event_end_batch ();
+    LEAVE (" ");
+}
+
 gboolean
 gncInvoiceUnpost (GncInvoice *invoice, gboolean reset_tax_tables)
 {
@@ -1756,46 +1968,13 @@ gncInvoiceUnpost (GncInvoice *invoice, gboolean reset_tax_tables)
     return TRUE;
 }
 
-struct lotmatch
-{
-    const GncOwner *owner;
-    gboolean positive_balance;
-};
-
-static gboolean
-gnc_lot_match_owner_balancing (GNCLot *lot, gpointer user_data)
-{
-    struct lotmatch *lm = user_data;
-    GncOwner owner_def;
-    const GncOwner *owner;
-    gnc_numeric balance = gnc_lot_get_balance (lot);
-
-    /* Could (part of) this lot serve to balance the lot
-     * for which this query was run ?*/
-    if (lm->positive_balance == gnc_numeric_positive_p (balance))
-        return FALSE;
-
-    /* Is it ours? Either the lot owner or the lot invoice owner should match */
-    if (!gncOwnerGetOwnerFromLot (lot, &owner_def))
-    {
-        const GncInvoice *invoice = gncInvoiceGetInvoiceFromLot (lot);
-        if (!invoice)
-            return FALSE;
-        owner = gncOwnerGetEndOwner (gncInvoiceGetOwner (invoice));
-    }
-    else
-        owner = gncOwnerGetEndOwner (&owner_def);
-
-    return gncOwnerEqual (owner, lm->owner);
-}
-
 void gncInvoiceAutoApplyPayments (GncInvoice *invoice)
 {
     GNCLot *inv_lot;
     Account *acct;
     const GncOwner *owner;
-    GList *lot_list;
-    struct lotmatch lm;
+    GList *lot_list = NULL, *owner_lots, *node;
+    gboolean positive_balance;
 
     /* General note: "paying" in this context means balancing
      * a lot, by linking opposite signed lots together. So below the term
@@ -1818,10 +1997,16 @@ void gncInvoiceAutoApplyPayments (GncInvoice *invoice)
      * and be for the same owner.
      * For example, for an invoice lot, payment lots and credit note lots
      * could be used. */
-    lm.positive_balance =  gnc_numeric_positive_p (gnc_lot_get_balance (inv_lot));
-    lm.owner = owner;
-    lot_list = xaccAccountFindOpenLots (acct, gnc_lot_match_owner_balancing,
-                                        &lm, NULL);
+    positive_balance = gnc_numeric_positive_p (gnc_lot_get_balance (inv_lot));
+    owner_lots = gncOwnerFindOpenLots (owner, acct);
+    for (node = owner_lots; node; node = node->next)
+    {
+        GNCLot *lot = node->data;
+        if (positive_balance != gnc_numeric_positive_p (gnc_lot_get_balance (lot)))
+            lot_list = g_list_prepend (lot_list, lot);
+    }
+    g_list_free (owner_lots);
+    lot_list = g_list_reverse (lot_list);
 
     lot_list = g_list_prepend (lot_list, inv_lot);
     gncOwnerAutoApplyPaymentsWithLots (owner, lot_list);
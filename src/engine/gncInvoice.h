@@ -164,6 +164,11 @@ gnc_numeric gncInvoiceGetTotal (GncInvoice *invoice);
 gnc_numeric gncInvoiceGetTotalOf (GncInvoice *invoice, GncEntryPaymentType type);
 gnc_numeric gncInvoiceGetTotalSubtotal (GncInvoice *invoice);
 gnc_numeric gncInvoiceGetTotalTax (GncInvoice *invoice);
+/** The taxes of all the entries summed per tax account, a list of
+ *  GncAccountValue with the signs of gncEntryGetDocTaxValues.  The list
+ *  is owned by the invoice, like its totals, and is only valid until
+ *  the invoice, one of its entries or a tax table changes. */
+GList * gncInvoiceGetTotalTaxValues (GncInvoice *invoice);
 
 typedef GList EntryList;
 EntryList * gncInvoiceGetEntries (GncInvoice *invoice);
@@ -213,6 +218,27 @@ gncInvoicePostToAccount (GncInvoice *invoice, Account *acc,
                          const char *memo, gboolean accumulatesplits,
                          gboolean autopay);
 
+/**
+ * Start a batch of invoice postings on the book, for billing runs that
+ * post many invoices at once.  Until the matching
+ * gncInvoiceEndPostBatch() the book is in a bulk ingestion session
+ * (see gnc_book_begin_bulk_ingest()), so posted transactions don't
+ * re-sort and rebalance their accounts one by one, and batch event
+ * handlers get their events when the batch ends.
+ *
+ * gncInvoicePostToAccount() with autopay TRUE doesn't apply payments
+ * at once during a batch.  The invoices are queued and paid, in the
+ * order they were posted, when the batch ends.  Documents posted later
+ * in the batch may therefore be matched with earlier ones.  Invoices
+ * must not be destroyed while they wait.
+ *
+ * Batches nest; only the outermost pair has any effect.
+ */
+void gncInvoiceBeginPostBatch (QofBook *book);
+
+/** End a posting batch started by gncInvoiceBeginPostBatch(). */
+void gncInvoiceEndPostBatch (QofBook *book);
+
 /**
  * Unpost this invoice.  This will destroy the posted transaction and
  * return the invoice to its unposted state.  It may leave empty lots
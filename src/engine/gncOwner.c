@@ -36,6 +36,7 @@
 #include <string.h>		/* for memcpy() */
 #include <qofinstance-p.h>
 
+#include "AccountP.h"
 #include "gncCustomerP.h"
 #include "gncEmployeeP.h"
 #include "gncJobP.h"
@@ -609,6 +610,7 @@ void gncOwnerAttachToLot (const GncOwner *owner, GNCLot *lot)
 		      GNC_OWNER_GUID, gncOwnerGetGUID (owner),
 		      NULL);
     gnc_lot_commit_edit (lot);
+    gnc_account_lot_changed (gnc_lot_get_account (lot), lot);
 }
 
 gboolean gncOwnerGetOwnerFromLot (GNCLot *lot, GncOwner *owner)
@@ -722,6 +724,218 @@ gncOwnerLotsSortFunc (GNCLot *lotA, GNCLot *lotB)
     return timespec_cmp (&da, &db);
 }
 
+/* ================================================================ */
+/* The owner lot index.  Paying an owner or totalling their balance
+ * needs the owner's open lots in an A/R or A/P account, and testing
+ * every lot in an account with thousands of customers makes that slow.
+ * So each account asked for them keeps its open lots filed by end
+ * owner, each owner's lots sorted by gncOwnerLotsSortFunc.  Lots that
+ * change wait in a pending set and are filed again at the next lookup,
+ * when their owner and balance are final. */
+
+typedef struct
+{
+    GHashTable *by_owner;       /* end owner GncGUID -> GPtrArray of lots */
+    GHashTable *lot_owner;      /* lot -> the GncGUID it is filed under */
+    GHashTable *pending;        /* lots to file again */
+} OwnerLotIndex;
+
+static GHashTable *owner_lot_indexes = NULL; /* Account -> OwnerLotIndex */
+
+static gboolean
+owner_lot_end_guid (GNCLot *lot, GncGUID *guid)
+{
+    GncOwner lot_owner;
+    const GncOwner *end_owner;
+    const GncGUID *end_guid;
+    GncInvoice *invoice = gncInvoiceGetInvoiceFromLot (lot);
+
+    /* Same owner resolution as gncOwnerLotMatchOwnerFunc */
+    if (invoice)
+        end_owner = gncOwnerGetEndOwner (gncInvoiceGetOwner (invoice));
+    else if (gncOwnerGetOwnerFromLot (lot, &lot_owner))
+        end_owner = gncOwnerGetEndOwner (&lot_owner);
+    else
+        return FALSE;
+
+    if (!end_owner || !end_owner->owner.undefined) return FALSE;
+    end_guid = gncOwnerGetGUID (end_owner);
+    if (!end_guid) return FALSE;
+    *guid = *end_guid;
+    return TRUE;
+}
+
+static gint
+owner_lot_order (gconstpointer a, gconstpointer b)
+{
+    return gncOwnerLotsSortFunc (*(GNCLot **)a, *(GNCLot **)b);
+}
+
+static void
+owner_lot_index_forget (OwnerLotIndex *idx, GNCLot *lot)
+{
+    GncGUID *key = g_hash_table_lookup (idx->lot_owner, lot);
+
+    if (key)
+    {
+        g_ptr_array_remove (g_hash_table_lookup (idx->by_owner, key), lot);
+        g_hash_table_remove (idx->lot_owner, lot);
+    }
+    g_hash_table_remove (idx->pending, lot);
+}
+
+/* File the lot under its owner, at the end of the owner's lots when
+ * sorted is FALSE, else after any lots with the same date. */
+static void
+owner_lot_index_file (OwnerLotIndex *idx, Account *acc, GNCLot *lot,
+                      gboolean sorted)
+{
+    GncGUID guid;
+    gpointer key;
+    GPtrArray *lots;
+    guint lo, hi;
+
+    if (gnc_lot_get_account (lot) != acc || gnc_lot_is_closed (lot))
+        return;
+    if (!owner_lot_end_guid (lot, &guid))
+        return;
+
+    if (!g_hash_table_lookup_extended (idx->by_owner, &guid,
+                                       &key, (gpointer *)&lots))
+    {
+        key = guid_copy (&guid);
+        lots = g_ptr_array_new ();
+        g_hash_table_insert (idx->by_owner, key, lots);
+    }
+    g_hash_table_insert (idx->lot_owner, lot, key);
+
+    lo = 0;
+    hi = lots->len;
+    if (!sorted)
+        lo = hi;
+    while (lo < hi)
+    {
+        guint mid = lo + (hi - lo) / 2;
+        if (gncOwnerLotsSortFunc (g_ptr_array_index (lots, mid), lot) <= 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    g_ptr_array_add (lots, NULL);
+    memmove (lots->pdata + lo + 1, lots->pdata + lo,
+             (lots->len - 1 - lo) * sizeof (gpointer));
+    g_ptr_array_index (lots, lo) = lot;
+}
+
+static void
+owner_lot_array_free (gpointer array)
+{
+    g_ptr_array_free (array, TRUE);
+}
+
+static void
+owner_lot_index_free (gpointer data)
+{
+    OwnerLotIndex *idx = data;
+
+    g_hash_table_destroy (idx->by_owner);
+    g_hash_table_destroy (idx->lot_owner);
+    g_hash_table_destroy (idx->pending);
+    g_free (idx);
+}
+
+static void
+owner_lot_index_account_gone (gpointer data, GObject *where_the_account_was)
+{
+    g_hash_table_remove (owner_lot_indexes, where_the_account_was);
+}
+
+static void
+owner_lot_index_changed (Account *acc, GNCLot *lot, gboolean present)
+{
+    OwnerLotIndex *idx = g_hash_table_lookup (owner_lot_indexes, acc);
+
+    if (!idx) return;
+
+    owner_lot_index_forget (idx, lot);
+    if (present)
+        g_hash_table_insert (idx->pending, lot, lot);
+}
+
+static OwnerLotIndex *
+owner_lot_index_get (Account *acc)
+{
+    OwnerLotIndex *idx;
+    GHashTableIter iter;
+    gpointer lot, lots;
+    GList *lot_list, *node;
+
+    if (!owner_lot_indexes)
+    {
+        owner_lot_indexes = g_hash_table_new_full (g_direct_hash,
+                                                   g_direct_equal,
+                                                   NULL, owner_lot_index_free);
+        gnc_account_set_lot_changed_hook (owner_lot_index_changed);
+    }
+
+    idx = g_hash_table_lookup (owner_lot_indexes, acc);
+    if (idx)
+    {
+        g_hash_table_iter_init (&iter, idx->pending);
+        while (g_hash_table_iter_next (&iter, &lot, NULL))
+            owner_lot_index_file (idx, acc, lot, TRUE);
+        g_hash_table_remove_all (idx->pending);
+        return idx;
+    }
+
+    idx = g_new0 (OwnerLotIndex, 1);
+    idx->by_owner = g_hash_table_new_full (guid_hash_to_guint,
+                                           guid_g_hash_table_equal,
+                                           (GDestroyNotify) guid_free,
+                                           owner_lot_array_free);
+    idx->lot_owner = g_hash_table_new (g_direct_hash, g_direct_equal);
+    idx->pending = g_hash_table_new (g_direct_hash, g_direct_equal);
+    g_hash_table_insert (owner_lot_indexes, acc, idx);
+    g_object_weak_ref (G_OBJECT (acc), owner_lot_index_account_gone, NULL);
+
+    lot_list = xaccAccountGetLotList (acc);
+    for (node = lot_list; node; node = node->next)
+        owner_lot_index_file (idx, acc, node->data, FALSE);
+    g_list_free (lot_list);
+
+    g_hash_table_iter_init (&iter, idx->by_owner);
+    while (g_hash_table_iter_next (&iter, NULL, &lots))
+        g_ptr_array_sort (lots, owner_lot_order);
+
+    return idx;
+}
+
+GList *
+gncOwnerFindOpenLots (const GncOwner *owner, Account *account)
+{
+    OwnerLotIndex *idx;
+    const GncGUID *guid;
+    GPtrArray *lots;
+    GList *retval = NULL;
+    guint i;
+
+    g_return_val_if_fail (owner, NULL);
+    g_return_val_if_fail (GNC_IS_ACCOUNT (account), NULL);
+
+    if (!owner->owner.undefined) return NULL;
+    guid = gncOwnerGetGUID (owner);
+    if (!guid) return NULL;
+
+    idx = owner_lot_index_get (account);
+    lots = g_hash_table_lookup (idx->by_owner, guid);
+    if (!lots) return NULL;
+
+    for (i = lots->len; i > 0; i--)
+        retval = g_list_prepend (retval, g_ptr_array_index (lots, i - 1));
+    return retval;
+}
+
 GNCLot *
 gncOwnerCreatePaymentLot (const GncOwner *owner, Transaction **preset_txn,
                           Account *posted_acc, Account *xfer_acc,
@@ -1402,8 +1616,7 @@ gncOwnerApplyPayment (const GncOwner *owner, Transaction **preset_txn, GList *lo
     if (lots)
         selected_lots = lots;
     else if (auto_pay)
-        selected_lots = xaccAccountFindOpenLots (posted_acc, gncOwnerLotMatchOwnerFunc,
-                        (gpointer)owner, NULL);
+        selected_lots = gncOwnerFindOpenLots (owner, posted_acc);
 
     /* And link the selected lots and the payment lot together as well as possible.
      * If the payment was bigger than the selected documents/overpayments, only
@@ -1482,8 +1695,7 @@ gncOwnerGetBalanceInCurrency (const GncOwner *owner,
             continue;
 
         /* Get a list of open lots for this owner and account */
-        lot_list = xaccAccountFindOpenLots (account, gncOwnerLotMatchOwnerFunc,
-                                            (gpointer)owner, NULL);
+        lot_list = gncOwnerFindOpenLots (owner, account);
         /* For each lot */
         for (lot_node = lot_list; lot_node; lot_node = lot_node->next)
         {
@@ -1494,6 +1706,7 @@ gncOwnerGetBalanceInCurrency (const GncOwner *owner,
                balance = gnc_numeric_add (balance, lot_balance,
                                           gnc_commodity_get_fraction (owner_currency), GNC_HOW_RND_ROUND_HALF_UP);
         }
+        g_list_free (lot_list);
     }
 
     pdb = gnc_pricedb_get_db (book);
@@ -1506,6 +1719,184 @@ gncOwnerGetBalanceInCurrency (const GncOwner *owner,
 }
 
 
+/*********************************************************************/
+/* Owner aging                                                       */
+
+/* The owner a split is booked against: the owner of the transaction's
+ * invoice, else that of the first lot in the transaction that has an
+ * invoice or an owner. */
+static gboolean
+aging_owner_from_split (Split *split, GncOwner *result)
+{
+    Transaction *txn = xaccSplitGetParent (split);
+    GncInvoice *invoice = gncInvoiceGetInvoiceFromTxn (txn);
+    GncOwner lot_owner;
+    const GncOwner *owner = NULL;
+    GList *node;
+
+    if (invoice)
+        owner = gncInvoiceGetOwner (invoice);
+    for (node = xaccTransGetSplitList (txn); !owner && node; node = node->next)
+    {
+        GNCLot *lot = xaccSplitGetLot (node->data);
+        if (!lot)
+            continue;
+        invoice = gncInvoiceGetInvoiceFromLot (lot);
+        if (invoice)
+            owner = gncInvoiceGetOwner (invoice);
+        else if (gncOwnerGetOwnerFromLot (lot, &lot_owner))
+            owner = &lot_owner;
+    }
+
+    owner = gncOwnerGetEndOwner (owner);
+    if (!owner || !owner->owner.undefined)
+        return FALSE;
+    gncOwnerCopy (owner, result);
+    return TRUE;
+}
+
+static void
+aging_add_document (GncOwnerAging *aging, gnc_numeric amount, guint bucket)
+{
+    if (gnc_numeric_compare (amount, aging->overpayment) >= 0)
+    {
+        amount = gnc_numeric_sub_fixed (amount, aging->overpayment);
+        aging->overpayment = gnc_numeric_zero ();
+    }
+    else
+    {
+        aging->overpayment = gnc_numeric_sub_fixed (aging->overpayment, amount);
+        amount = gnc_numeric_zero ();
+    }
+    aging->buckets[bucket] = gnc_numeric_add_fixed (aging->buckets[bucket],
+                                                    amount);
+}
+
+/* Payments go towards the oldest documents first. */
+static void
+aging_add_payment (GncOwnerAging *aging, gnc_numeric amount, guint num_buckets)
+{
+    guint i;
+
+    if (gnc_numeric_positive_p (aging->overpayment))
+    {
+        aging->overpayment = gnc_numeric_add_fixed (aging->overpayment, amount);
+        return;
+    }
+
+    for (i = 0; i < num_buckets; i++)
+    {
+        if (gnc_numeric_compare (aging->buckets[i], amount) >= 0)
+        {
+            aging->buckets[i] = gnc_numeric_sub_fixed (aging->buckets[i], amount);
+            amount = gnc_numeric_zero ();
+            break;
+        }
+        amount = gnc_numeric_sub_fixed (amount, aging->buckets[i]);
+        aging->buckets[i] = gnc_numeric_zero ();
+    }
+    aging->overpayment = amount;
+}
+
+static void
+aging_free (gpointer data)
+{
+    GncOwnerAging *aging = data;
+
+    g_free (aging->buckets);
+    g_free (aging);
+}
+
+GList *
+gncOwnerGetAging (Account *account, Timespec report_date,
+                  const Timespec *interval_ends, guint num_intervals,
+                  gboolean reverse, gboolean show_zeros,
+                  gboolean use_due_date)
+{
+    GHashTable *by_owner;
+    GList *result = NULL, *node;
+
+    g_return_val_if_fail (GNC_IS_ACCOUNT (account), NULL);
+    g_return_val_if_fail (interval_ends && num_intervals > 0, NULL);
+
+    by_owner = g_hash_table_new (guid_hash_to_guint, guid_g_hash_table_equal);
+
+    for (node = xaccAccountGetSplitList (account); node; node = node->next)
+    {
+        Split *split = node->data;
+        Transaction *txn = xaccSplitGetParent (split);
+        GNCLot *lot = xaccSplitGetLot (split);
+        GncOwnerAging *aging;
+        GncOwner owner;
+        gnc_numeric value;
+        Timespec date;
+        guint bucket;
+
+        date = xaccTransRetDatePostedTS (txn);
+        if (timespec_cmp (&date, &report_date) > 0)
+            break;
+        if (xaccTransGetVoidStatus (txn))
+            continue;
+        if (lot && gnc_lot_is_closed (lot) && !show_zeros)
+            continue;
+        if (!aging_owner_from_split (split, &owner))
+            continue;
+
+        aging = g_hash_table_lookup (by_owner, gncOwnerGetGUID (&owner));
+        if (!aging)
+        {
+            aging = g_new0 (GncOwnerAging, 1);
+            aging->owner = owner;
+            aging->currency = xaccTransGetCurrency (txn);
+            aging->buckets = g_new (gnc_numeric, num_intervals);
+            for (bucket = 0; bucket < num_intervals; bucket++)
+                aging->buckets[bucket] = gnc_numeric_zero ();
+            aging->overpayment = gnc_numeric_zero ();
+            g_hash_table_insert (by_owner,
+                                 (gpointer) gncOwnerGetGUID (&aging->owner),
+                                 aging);
+            result = g_list_prepend (result, aging);
+        }
+        else if (!gnc_commodity_equiv (xaccTransGetCurrency (txn),
+                                       aging->currency))
+        {
+            PWARN ("Ignoring transaction in %s for %s, whose other "
+                   "transactions are in %s",
+                   gnc_commodity_get_mnemonic (xaccTransGetCurrency (txn)),
+                   gncOwnerGetName (&owner),
+                   gnc_commodity_get_mnemonic (aging->currency));
+            aging->mixed_currency = TRUE;
+            continue;
+        }
+
+        value = xaccSplitGetValue (split);
+        if (reverse)
+            value = gnc_numeric_neg (value);
+
+        if (!gnc_numeric_negative_p (value))
+        {
+            aging_add_payment (aging, value, num_intervals);
+            continue;
+        }
+
+        if (use_due_date)
+            date = xaccTransRetDateDueTS (txn);
+        for (bucket = 0; bucket < num_intervals - 1; bucket++)
+            if (timespec_cmp (&date, &interval_ends[bucket]) < 0)
+                break;
+        aging_add_document (aging, gnc_numeric_neg (value), bucket);
+    }
+
+    g_hash_table_destroy (by_owner);
+    return g_list_reverse (result);
+}
+
+void
+gncOwnerAgingListFree (GList *aging)
+{
+    g_list_free_full (aging, aging_free);
+}
+
 /* XXX: Yea, this is broken, but it should work fine for Queries.
  * We're single-threaded, right?
  */
@@ -190,6 +190,16 @@ gboolean gncOwnerLotMatchOwnerFunc (GNCLot *lot, gpointer user_data);
  */
 gint gncOwnerLotsSortFunc (GNCLot *lotA, GNCLot *lotB);
 
+/** Find the open lots in the account that belong to the owner, sorted
+ * with gncOwnerLotsSortFunc.  This gives the same lots as
+ * xaccAccountFindOpenLots with gncOwnerLotMatchOwnerFunc, but uses an
+ * index the account keeps by owner once it has been asked, so it
+ * doesn't test every lot in the account.
+ *
+ * The caller must free the returned list, but not the lots in it.
+ */
+GList * gncOwnerFindOpenLots (const GncOwner *owner, Account *account);
+
 /** Get the owner from the lot.  If an owner is found in the lot,
  * fill in "owner" and return TRUE.  Otherwise return FALSE.
  */
@@ -314,6 +324,48 @@ gnc_numeric
 gncOwnerGetBalanceInCurrency (const GncOwner *owner,
                               const gnc_commodity *report_currency);
 
+#ifndef SWIG
+/** One owner's balance in an A/R or A/P account, split up by age.
+ *  See gncOwnerGetAging(). */
+typedef struct
+{
+    GncOwner       owner;           /**< The end owner */
+    gnc_commodity *currency;        /**< The currency of the owner's
+                                         transactions */
+    gnc_numeric   *buckets;         /**< The amount still due for the
+                                         documents in each interval */
+    gnc_numeric    overpayment;     /**< Payments beyond all documents */
+    gboolean       mixed_currency;  /**< TRUE if transactions in another
+                                         currency were left out */
+} GncOwnerAging;
+
+/** Age the balances of all the owners in an A/R or A/P account.
+ *
+ *  Every non-void split in the account posted up to report_date is
+ *  attributed to the owner of its invoice or lot.  A split that lowers
+ *  the account balance (raises it if reverse is TRUE) is a document:
+ *  its amount goes into the first interval whose end is after the
+ *  transaction's posted date, or due date if use_due_date is TRUE,
+ *  less any earlier overpayment.  Any other split is a payment and
+ *  pays off the oldest intervals first.  Splits in closed lots are
+ *  skipped unless show_zeros is TRUE.
+ *
+ *  @param interval_ends The exclusive end date of each interval, in
+ *  increasing order.  Dates after the last one count in the last
+ *  interval.
+ *
+ *  @return A list of GncOwnerAging, one per owner, each with
+ *  num_intervals buckets.  Free it with gncOwnerAgingListFree().
+ */
+GList * gncOwnerGetAging (Account *account, Timespec report_date,
+                          const Timespec *interval_ends, guint num_intervals,
+                          gboolean reverse, gboolean show_zeros,
+                          gboolean use_due_date);
+
+/** Free a list returned by gncOwnerGetAging(). */
+void gncOwnerAgingListFree (GList *aging);
+#endif /* SWIG */
+
 #define OWNER_TYPE        "type"
 #define OWNER_TYPE_STRING "type-string"  /**< Allows the type to be handled externally. */
 #define OWNER_CUSTOMER    "customer"
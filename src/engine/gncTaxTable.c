@@ -162,10 +162,14 @@ maybe_resort_list (GncTaxTable *table)
     bi->tables = g_list_sort (bi->tables, (GCompareFunc)gncTaxTableCompare);
 }
 
+/* Bumped by every change to any tax table, see gncTaxTableGetGeneration */
+static guint taxtable_generation = 0;
+
 static inline void
 mod_table (GncTaxTable *table)
 {
     timespecFromTime64 (&table->modtime, gnc_time (NULL));
+    taxtable_generation++;
 }
 
 static inline void addObj (GncTaxTable *table)
@@ -768,6 +772,11 @@ Timespec gncTaxTableLastModified (const GncTaxTable *table)
     return table->modtime;
 }
 
+guint gncTaxTableGetGeneration (void)
+{
+    return taxtable_generation;
+}
+
 gboolean gncTaxTableGetInvisible (const GncTaxTable *table)
 {
     if (!table) return FALSE;
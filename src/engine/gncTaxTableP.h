@@ -42,6 +42,11 @@ gboolean gncTaxTableGetInvisible (const GncTaxTable *table);
 
 GncTaxTable* gncTaxTableEntryGetTable( const GncTaxTableEntry* entry );
 
+/* A counter that changes whenever any tax table is modified, so that
+ * cached tax amounts can tell they are stale without asking every
+ * table they depend on. */
+guint gncTaxTableGetGeneration (void);
+
 #define gncTaxTableSetGUID(E,G) qof_instance_set_guid(QOF_INSTANCE(E),(G))
 
 #endif /* GNC_TAXTABLEP_H_ */
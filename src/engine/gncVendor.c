@@ -35,6 +35,7 @@
 #include "gnc-commodity.h"
 #include "gncAddressP.h"
 #include "gncBillTermP.h"
+#include "gncIDSearch.h"
 #include "gncInvoice.h"
 #include "gncJobP.h"
 #include "gncTaxTableP.h"
@@ -497,6 +498,7 @@ static void gncVendorFree (GncVendor *vendor)
 
     qof_event_gen (&vendor->inst, QOF_EVENT_DESTROY, NULL);
 
+    gnc_search_id_changed (&vendor->inst, vendor->id, NULL);
     CACHE_REMOVE (vendor->id);
     CACHE_REMOVE (vendor->name);
     CACHE_REMOVE (vendor->notes);
@@ -530,6 +532,7 @@ void gncVendorSetID (GncVendor *vendor, const char *id)
 {
     if (!vendor) return;
     if (!id) return;
+    gnc_search_id_changed (&vendor->inst, vendor->id, id);
     SET_STR(vendor, vendor->id, id);
     mark_vendor (vendor);
     gncVendorCommitEdit (vendor);
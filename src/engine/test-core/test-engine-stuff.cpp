@@ -53,6 +53,7 @@ extern "C"
 #include <inttypes.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 #include <sys/stat.h>
 #include <qof.h>
 #include <qofinstance-p.h>
@@ -66,6 +67,8 @@ extern "C"
 #include "Recurrence.h"
 #include "SchedXaction.h"
 #include "SX-book.h"
+#include "Scrub3.h"
+#include "gnc-pricedb.h"
 
 #include "test-engine-stuff.h"
 #include "test-stuff.h"
@@ -115,6 +118,12 @@ set_max_accounts_per_level (gint max_level_accounts_in)
     max_level_accounts = MAX (max_level_accounts_in, 1);
 }
 
+void
+set_max_total_accounts (gint max_total_accounts_in)
+{
+    max_total_accounts = MAX (max_total_accounts_in, 2);
+}
+
 void
 set_max_kvp_depth (gint max_kvp_depth)
 {
@@ -171,6 +180,16 @@ random_timespec_usec_resolution (gboolean usec_resolution_in)
     usec_resolution = usec_resolution_in;
 }
 
+static time64 timespec_earliest = 0;
+static time64 timespec_latest = 0;
+
+void
+random_timespec_range (time64 earliest, time64 latest)
+{
+    timespec_earliest = MIN (earliest, latest);
+    timespec_latest = MAX (earliest, latest);
+}
+
 /* ========================================================== */
 
 static inline gboolean
@@ -234,6 +253,15 @@ get_random_timespec(void)
 
     ret = g_new0(Timespec, 1);
 
+    if (timespec_latest > 0)
+    {
+        ret->tv_sec = timespec_earliest +
+            (time64)((timespec_latest - timespec_earliest) *
+                     (rand() / (RAND_MAX + 1.0)));
+        ret->tv_nsec = 0;
+        return ret;
+    }
+
     while (ret->tv_sec <= 0)
         ret->tv_sec = rand();
 
@@ -1944,6 +1972,390 @@ add_random_transactions_to_book (QofBook *book, gint num_transactions)
     g_list_free (accounts);
 }
 
+/* ========================================================== */
+/* Realistic books */
+
+typedef struct
+{
+    GRand *rand;
+    QofBook *book;
+    gnc_commodity *currency;
+    time64 start;
+    gint n_days;
+    GPtrArray *banks;           /* where money is paid from and into */
+    GPtrArray *credit;
+    GPtrArray *incomes;
+    GPtrArray *expenses;
+    GPtrArray *stocks;
+    gnc_numeric **prices;       /* per stock, one per week */
+    gint64 *holdings;           /* per stock, in 1/100 shares */
+} RealisticBook;
+
+static gnc_commodity *
+realistic_commodity (QofBook *book, const char *name_space,
+                     const char *mnemonic, const char *fullname, int fraction)
+{
+    gnc_commodity_table *table = gnc_commodity_table_get_table (book);
+    gnc_commodity *com;
+
+    com = gnc_commodity_table_lookup (table, name_space, mnemonic);
+    if (com)
+        return com;
+    com = gnc_commodity_new (book, fullname, name_space, mnemonic, NULL,
+                             fraction);
+    return gnc_commodity_table_insert (table, com);
+}
+
+static Account *
+realistic_account (RealisticBook *rb, Account *parent, const char *name,
+                   GNCAccountType type, gnc_commodity *commodity)
+{
+    Account *acc = xaccMallocAccount (rb->book);
+
+    xaccAccountBeginEdit (acc);
+    xaccAccountSetName (acc, name);
+    xaccAccountSetType (acc, type);
+    xaccAccountSetCommodity (acc, commodity);
+    xaccAccountCommitEdit (acc);
+    gnc_account_append_child (parent, acc);
+    return acc;
+}
+
+static Account *
+realistic_random_account (RealisticBook *rb, GPtrArray *accounts)
+{
+    return static_cast<Account*>(g_ptr_array_index (
+        accounts, g_rand_int_range (rb->rand, 0, accounts->len)));
+}
+
+/* Roughly half the accounts are expense categories, as in most
+ * personal books; every class gets at least one account. */
+static void
+realistic_account_tree (RealisticBook *rb, gint n_accounts, gint n_securities)
+{
+    Account *root = gnc_book_get_root_account (rb->book);
+    Account *assets, *liabilities, *income, *expenses, *equity, *invest;
+    GPtrArray *parents[4];
+    gint i, made;
+
+    assets = realistic_account (rb, root, "Assets", ACCT_TYPE_ASSET,
+                                rb->currency);
+    liabilities = realistic_account (rb, root, "Liabilities",
+                                     ACCT_TYPE_LIABILITY, rb->currency);
+    income = realistic_account (rb, root, "Income", ACCT_TYPE_INCOME,
+                                rb->currency);
+    expenses = realistic_account (rb, root, "Expenses", ACCT_TYPE_EXPENSE,
+                                  rb->currency);
+    equity = realistic_account (rb, root, "Equity", ACCT_TYPE_EQUITY,
+                                rb->currency);
+    realistic_account (rb, equity, "Opening Balances", ACCT_TYPE_EQUITY,
+                       rb->currency);
+    made = 6;
+
+    if (n_securities > 0)
+    {
+        invest = realistic_account (rb, assets, "Investments",
+                                    ACCT_TYPE_ASSET, rb->currency);
+        made++;
+        for (i = 0; i < n_securities; i++)
+        {
+            gchar *mnemonic = g_strdup_printf ("SEC%d", i);
+            gnc_commodity *sec = realistic_commodity (rb->book, "NASDAQ",
+                                                      mnemonic, mnemonic,
+                                                      100);
+            g_ptr_array_add (rb->stocks,
+                             realistic_account (rb, invest, mnemonic,
+                                                ACCT_TYPE_STOCK, sec));
+            g_free (mnemonic);
+            made++;
+        }
+    }
+
+    parents[0] = g_ptr_array_new ();
+    parents[1] = g_ptr_array_new ();
+    parents[2] = g_ptr_array_new ();
+    parents[3] = g_ptr_array_new ();
+    g_ptr_array_add (parents[0], assets);
+    g_ptr_array_add (parents[1], liabilities);
+    g_ptr_array_add (parents[2], income);
+    g_ptr_array_add (parents[3], expenses);
+
+    for (i = 0; made < n_accounts || i < 4; i++, made++)
+    {
+        gint which = i < 4 ? i : g_rand_int_range (rb->rand, 0, 20);
+        GNCAccountType type;
+        GPtrArray *leaves;
+        Account *parent, *acc;
+        gchar *name;
+
+        /* 0-3 assets, 4-5 liabilities, 6-8 income, the rest expenses. */
+        if (i >= 4)
+            which = which < 4 ? 0 : which < 6 ? 1 : which < 9 ? 2 : 3;
+        switch (which)
+        {
+        case 0:
+            type = g_rand_int_range (rb->rand, 0, 4) ? ACCT_TYPE_BANK
+                                                     : ACCT_TYPE_CASH;
+            leaves = rb->banks;
+            break;
+        case 1:
+            type = ACCT_TYPE_CREDIT;
+            leaves = rb->credit;
+            break;
+        case 2:
+            type = ACCT_TYPE_INCOME;
+            leaves = rb->incomes;
+            break;
+        default:
+            type = ACCT_TYPE_EXPENSE;
+            leaves = rb->expenses;
+            break;
+        }
+
+        /* Grow the hierarchy up to three levels below the top. */
+        parent = realistic_random_account (rb, parents[which]);
+        name = g_strdup_printf ("%s %d", xaccAccountGetName (parent), i);
+        acc = realistic_account (rb, parent, name, type, rb->currency);
+        g_free (name);
+        g_ptr_array_add (leaves, acc);
+        if (gnc_account_get_current_depth (acc) < 4)
+            g_ptr_array_add (parents[which], acc);
+    }
+
+    for (i = 0; i < 4; i++)
+        g_ptr_array_free (parents[i], TRUE);
+}
+
+/* A weekly random walk for each security. */
+static void
+realistic_prices (RealisticBook *rb)
+{
+    GNCPriceDB *db = gnc_pricedb_get_db (rb->book);
+    gint n_weeks = rb->n_days / 7 + 1;
+    guint i;
+    gint week;
+
+    rb->prices = g_new0 (gnc_numeric *, rb->stocks->len);
+    rb->holdings = g_new0 (gint64, rb->stocks->len);
+    for (i = 0; i < rb->stocks->len; i++)
+    {
+        gnc_commodity *sec = xaccAccountGetCommodity (
+            static_cast<Account*>(g_ptr_array_index (rb->stocks, i)));
+        double price = g_rand_double_range (rb->rand, 5, 500);
+
+        rb->prices[i] = g_new (gnc_numeric, n_weeks);
+        for (week = 0; week < n_weeks; week++)
+        {
+            GNCPrice *p = gnc_price_create (rb->book);
+            Timespec ts;
+
+            price *= 1 + g_rand_double_range (rb->rand, -0.04, 0.045);
+            price = MAX (price, 0.5);
+            rb->prices[i][week] = gnc_numeric_create ((gint64)(price * 100),
+                                                      100);
+            ts.tv_sec = rb->start + (time64)week * 7 * 24 * 3600;
+            ts.tv_nsec = 0;
+
+            gnc_price_begin_edit (p);
+            gnc_price_set_commodity (p, sec);
+            gnc_price_set_currency (p, rb->currency);
+            gnc_price_set_time (p, ts);
+            gnc_price_set_source (p, PRICE_SOURCE_FQ);
+            gnc_price_set_typestr (p, "last");
+            gnc_price_set_value (p, rb->prices[i][week]);
+            gnc_price_commit_edit (p);
+            gnc_pricedb_add_price (db, p);
+            gnc_price_unref (p);
+        }
+    }
+}
+
+/* Most transactions fall on weekdays; amounts spread from a dollar
+ * to a few thousand with the small ones most common. */
+static time64
+realistic_date (RealisticBook *rb)
+{
+    time64 date;
+    int wday;
+
+    do
+    {
+        struct tm tm;
+
+        date = rb->start + (time64)g_rand_int_range (rb->rand, 0, rb->n_days)
+               * 24 * 3600;
+        gnc_localtime_r (&date, &tm);
+        wday = tm.tm_wday;
+    }
+    while ((wday == 0 || wday == 6) && g_rand_int_range (rb->rand, 0, 3));
+
+    return date;
+}
+
+static gint64
+realistic_cents (RealisticBook *rb, double low, double high)
+{
+    return (gint64)exp (g_rand_double_range (rb->rand, log (low), log (high)));
+}
+
+static void
+realistic_split (Transaction *trans, Account *acc, gint64 amount,
+                 gint64 value)
+{
+    Split *split = xaccMallocSplit (xaccTransGetBook (trans));
+
+    xaccSplitSetParent (split, trans);
+    xaccSplitSetAccount (split, acc);
+    xaccSplitSetAmount (split, gnc_numeric_create (amount, 100));
+    xaccSplitSetValue (split, gnc_numeric_create (value, 100));
+}
+
+static void
+realistic_transaction (RealisticBook *rb, gint multi_split_percent)
+{
+    Transaction *trans = xaccMallocTransaction (rb->book);
+    time64 date = realistic_date (rb);
+    gint kind = g_rand_int_range (rb->rand, 0, 100);
+    Account *from;
+    gint64 cents;
+
+    xaccTransBeginEdit (trans);
+    xaccTransSetCurrency (trans, rb->currency);
+    xaccTransSetDatePostedSecsNormalized (trans, date);
+    xaccTransSetDateEnteredSecs (trans, date);
+    xaccTransSetDescription (trans, sane_descriptions[
+        g_rand_int_range (rb->rand, 0, G_N_ELEMENTS (sane_descriptions) - 1)]);
+
+    if (kind < 5 && rb->stocks->len)
+    {
+        /* A trade: buy, or sell part of what is held. */
+        guint i = g_rand_int_range (rb->rand, 0, rb->stocks->len);
+        gnc_numeric price = rb->prices[i][(date - rb->start) / (7 * 24 * 3600)];
+        gint64 shares = g_rand_int_range (rb->rand, 1, 100) * 100;
+
+        if (rb->holdings[i] > 0 && g_rand_int_range (rb->rand, 0, 3) == 0)
+            shares = -MIN (shares, rb->holdings[i]);
+        rb->holdings[i] += shares;
+        cents = shares * price.num / price.denom;
+        realistic_split (trans, static_cast<Account*>(
+                             g_ptr_array_index (rb->stocks, i)),
+                         shares, cents);
+        realistic_split (trans, realistic_random_account (rb, rb->banks),
+                         -cents, -cents);
+    }
+    else if (kind < 15)
+    {
+        /* Income into a bank account, often with deductions. */
+        Account *bank = realistic_random_account (rb, rb->banks);
+        gint n = 1;
+
+        if (g_rand_int_range (rb->rand, 0, 100) < multi_split_percent)
+            n = g_rand_int_range (rb->rand, 2, 5);
+        cents = realistic_cents (rb, 10000, 800000);
+        realistic_split (trans, realistic_random_account (rb, rb->incomes),
+                         -cents, -cents);
+        while (--n > 0)
+        {
+            gint64 part = cents / g_rand_int_range (rb->rand, 5, 20);
+
+            realistic_split (trans, realistic_random_account (rb, rb->expenses),
+                             part, part);
+            cents -= part;
+        }
+        realistic_split (trans, bank, cents, cents);
+    }
+    else if (kind < 22 && rb->credit->len)
+    {
+        /* Paying off a card. */
+        cents = realistic_cents (rb, 5000, 300000);
+        realistic_split (trans, realistic_random_account (rb, rb->credit),
+                         cents, cents);
+        realistic_split (trans, realistic_random_account (rb, rb->banks),
+                         -cents, -cents);
+    }
+    else
+    {
+        /* Spending, from a bank account or on a card, sometimes
+         * spread over several categories. */
+        gint n = 1;
+
+        from = rb->credit->len && g_rand_boolean (rb->rand)
+               ? realistic_random_account (rb, rb->credit)
+               : realistic_random_account (rb, rb->banks);
+        if (g_rand_int_range (rb->rand, 0, 100) < multi_split_percent)
+            n = g_rand_int_range (rb->rand, 2, 5);
+        cents = 0;
+        while (n-- > 0)
+        {
+            gint64 part = realistic_cents (rb, 100, 200000);
+
+            realistic_split (trans, realistic_random_account (rb, rb->expenses),
+                             part, part);
+            cents += part;
+        }
+        realistic_split (trans, from, -cents, -cents);
+    }
+
+    xaccTransCommitEdit (trans);
+}
+
+void
+add_realistic_data_to_book (QofBook *book, const RealisticBookParams *params)
+{
+    RealisticBook rb;
+    guint i;
+    gint n;
+
+    g_return_if_fail (book);
+    g_return_if_fail (params);
+
+    rb.rand = g_rand_new_with_seed (params->seed);
+    rb.book = book;
+    rb.currency = realistic_commodity (book, GNC_COMMODITY_NS_CURRENCY,
+                                       "USD", "US Dollar", 100);
+    rb.n_days = MAX (params->n_years, 1) * 365;
+    rb.start = gnc_dmy2timespec (1, 1, 2000).tv_sec;
+    rb.banks = g_ptr_array_new ();
+    rb.credit = g_ptr_array_new ();
+    rb.incomes = g_ptr_array_new ();
+    rb.expenses = g_ptr_array_new ();
+    rb.stocks = g_ptr_array_new ();
+
+    realistic_account_tree (&rb, params->n_accounts, params->n_securities);
+    realistic_prices (&rb);
+    for (n = 0; n < params->n_transactions; n++)
+        realistic_transaction (&rb, params->multi_split_percent);
+
+    /* Give the trades their lots, as the scrubber would on load. */
+    for (i = 0; i < rb.stocks->len; i++)
+    {
+        xaccAccountScrubLots (static_cast<Account*>(
+                                  g_ptr_array_index (rb.stocks, i)));
+        g_free (rb.prices[i]);
+    }
+
+    g_free (rb.prices);
+    g_free (rb.holdings);
+    g_ptr_array_free (rb.banks, TRUE);
+    g_ptr_array_free (rb.credit, TRUE);
+    g_ptr_array_free (rb.incomes, TRUE);
+    g_ptr_array_free (rb.expenses, TRUE);
+    g_ptr_array_free (rb.stocks, TRUE);
+    g_rand_free (rb.rand);
+}
+
+QofBook *
+get_realistic_book (const RealisticBookParams *params)
+{
+    QofBook *book;
+
+    g_return_val_if_fail (params, NULL);
+
+    book = qof_book_new ();
+    add_realistic_data_to_book (book, params);
+    return book;
+}
+
 void
 make_random_changes_to_book (QofBook *book)
 {
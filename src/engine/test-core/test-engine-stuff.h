@@ -48,6 +48,9 @@ typedef struct KvpFrameImpl KvpFrame;
 Timespec* get_random_timespec(void);
 void random_timespec_zero_nsec (gboolean zero_nsec);
 void random_timespec_usec_resolution (gboolean usec_resolution);
+/** Keep random dates between earliest and latest; latest 0 lifts the
+ *  limit. */
+void random_timespec_range (time64 earliest, time64 latest);
 
 KvpValue* get_random_kvp_value(int type);
 
@@ -68,6 +71,7 @@ void set_max_kvp_depth (gint max_kvp_depth);
 void set_max_kvp_frame_elements (gint max_kvp_frame_elements);
 void set_max_account_tree_depth (gint max_tree_depth);
 void set_max_accounts_per_level (gint max_accounts);
+void set_max_total_accounts (gint max_accounts);
 
 GNCPrice * get_random_price(QofBook *book);
 gboolean make_random_pricedb (QofBook *book, GNCPriceDB *pdb);
@@ -100,6 +104,28 @@ TestQueryTypes get_random_query_type (void);
 void trans_query_include_price (gboolean include_amounts);
 
 QofBook * get_random_book (void);
+
+/** What get_realistic_book() makes. */
+typedef struct
+{
+    guint32 seed;               /**< The same seed gives the same book */
+    gint n_accounts;
+    gint n_transactions;
+    gint n_years;               /**< Years of transactions from 2000 */
+    gint multi_split_percent;   /**< Share of transactions with 3-5 splits */
+    gint n_securities;          /**< Each with a stock account and prices */
+} RealisticBookParams;
+
+/** Makes a book that looks like a household's: an account hierarchy
+ *  weighted towards expense categories, spending, income, card
+ *  payments and trades on mostly weekdays, weekly prices for the
+ *  securities and lots for the trades.  Unlike the other generators it
+ *  does not use rand(), so it is reproducible from params->seed alone
+ *  and cheap enough for books of a million splits. */
+QofBook * get_realistic_book (const RealisticBookParams *params);
+/** The same, into a book that already exists, such as a session's. */
+void add_realistic_data_to_book (QofBook *book,
+                                 const RealisticBookParams *params);
 QofSession * get_random_session (void);
 
 void add_random_transactions_to_book (QofBook *book, gint num_transactions);
@@ -0,0 +1,405 @@
+/********************************************************************\
+ * engine-benchmark.c -- time core engine operations on large,      *
+ *                       realistic books                            *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+\********************************************************************/
+
+/* For each requested book size, makes a book with get_realistic_book()
+ * and times the operations that dominate loading, editing and
+ * reporting on it.  The results go out as JSON, one object per size,
+ * so they can be compared from one build to the next.  Run it with
+ * "make engine-benchmark". */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#include "qof.h"
+#include "Account.h"
+#include "Transaction.h"
+#include "Split.h"
+#include "SplitP.h"
+#include "TransactionP.h"
+#include "Query.h"
+#include "Scrub.h"
+#include "Scrub3.h"
+#include "cashobjects.h"
+#include "test-engine-stuff.h"
+
+static gint seed = 42;
+static gchar *sizes = NULL;
+static gint n_accounts = 200;
+static gint n_years = 10;
+static gint multi_split_percent = 20;
+static gint n_securities = 10;
+static gchar *output = NULL;
+
+static GOptionEntry options[] =
+{
+    { "seed", 's', 0, G_OPTION_ARG_INT, &seed,
+      "Seed for the books", "N" },
+    { "splits", 'n', 0, G_OPTION_ARG_STRING, &sizes,
+      "Comma separated book sizes in splits, default 10000,100000", "LIST" },
+    { "accounts", 'a', 0, G_OPTION_ARG_INT, &n_accounts,
+      "Accounts in each book", "N" },
+    { "years", 'y', 0, G_OPTION_ARG_INT, &n_years,
+      "Years of transactions", "N" },
+    { "multi-split", 'm', 0, G_OPTION_ARG_INT, &multi_split_percent,
+      "Percentage of transactions with more than two splits", "N" },
+    { "securities", 'S', 0, G_OPTION_ARG_INT, &n_securities,
+      "Securities traded", "N" },
+    { "output", 'o', 0, G_OPTION_ARG_FILENAME, &output,
+      "JSON file to write, default stdout", "FILE" },
+    { NULL }
+};
+
+typedef struct
+{
+    QofBook *book;
+    Account *root;
+    GPtrArray *accounts;
+    GPtrArray *transactions;
+    GPtrArray *splits;
+} Bench;
+
+static gint64 timer;
+
+static void
+timer_start (void)
+{
+    timer = g_get_monotonic_time ();
+}
+
+static void
+timer_report (FILE *out, const char *name, gboolean last)
+{
+    gint64 usec = g_get_monotonic_time () - timer;
+
+    fprintf (out, "        \"%s\": %.6f%s\n", name, usec / 1e6,
+             last ? "" : ",");
+    fflush (out);
+}
+
+static void
+collect (QofInstance *inst, gpointer data)
+{
+    g_ptr_array_add ((GPtrArray *)data, inst);
+}
+
+static void
+bench_commit (Bench *b)
+{
+    guint i;
+
+    /* An edit that changes nothing still goes through the whole commit
+     * path: scrubbing, sorting the splits into their accounts and
+     * sending the events. */
+    for (i = 0; i < b->transactions->len; i++)
+    {
+        Transaction *trans = g_ptr_array_index (b->transactions, i);
+
+        xaccTransBeginEdit (trans);
+        xaccTransSetDescription (trans, xaccTransGetDescription (trans));
+        xaccTransCommitEdit (trans);
+    }
+}
+
+static void
+bench_sort (Bench *b)
+{
+    guint i;
+
+    for (i = 0; i < b->accounts->len; i++)
+        xaccAccountSortSplits (g_ptr_array_index (b->accounts, i), TRUE);
+}
+
+static void
+bench_recompute (Bench *b)
+{
+    guint i;
+
+    for (i = 0; i < b->accounts->len; i++)
+    {
+        Account *acc = g_ptr_array_index (b->accounts, i);
+
+        gnc_account_set_balance_dirty (acc);
+        xaccAccountRecomputeBalance (acc);
+    }
+}
+
+static void
+bench_lookup (Bench *b)
+{
+    guint i;
+
+    for (i = 0; i < b->splits->len; i++)
+    {
+        Split *split = g_ptr_array_index (b->splits, i);
+
+        if (xaccSplitLookup (qof_instance_get_guid (split), b->book) != split)
+            g_warning ("split lookup failed");
+    }
+    for (i = 0; i < b->transactions->len; i++)
+    {
+        Transaction *trans = g_ptr_array_index (b->transactions, i);
+
+        if (xaccTransLookup (qof_instance_get_guid (trans), b->book) != trans)
+            g_warning ("transaction lookup failed");
+    }
+    for (i = 0; i < b->accounts->len; i++)
+    {
+        Account *acc = g_ptr_array_index (b->accounts, i);
+        gchar *name = gnc_account_get_full_name (acc);
+
+        gnc_account_lookup_by_full_name (b->root, name);
+        g_free (name);
+    }
+}
+
+/* What a register or a report asks for: one account's splits, and
+ * every split in a period. */
+static void
+bench_query (Bench *b)
+{
+    Timespec start = gnc_dmy2timespec (1, 1, 2001);
+    Timespec end = gnc_dmy2timespec_end (31, 12, 2001);
+    guint i;
+
+    for (i = 0; i < b->accounts->len; i++)
+    {
+        QofQuery *q = qof_query_create_for (GNC_ID_SPLIT);
+
+        qof_query_set_book (q, b->book);
+        xaccQueryAddSingleAccountMatch (q, g_ptr_array_index (b->accounts, i),
+                                        QOF_QUERY_AND);
+        qof_query_run (q);
+        qof_query_destroy (q);
+    }
+
+    for (i = 0; i < 10; i++)
+    {
+        QofQuery *q = qof_query_create_for (GNC_ID_SPLIT);
+
+        qof_query_set_book (q, b->book);
+        xaccQueryAddDateMatchTS (q, TRUE, start, TRUE, end, QOF_QUERY_AND);
+        qof_query_run (q);
+        qof_query_destroy (q);
+    }
+}
+
+static void
+bench_balance (Bench *b)
+{
+    time64 date = gnc_dmy2timespec (1, 7, 2002).tv_sec;
+    guint i;
+
+    for (i = 0; i < b->accounts->len; i++)
+        xaccAccountGetBalanceAsOfDate (g_ptr_array_index (b->accounts, i),
+                                       date);
+}
+
+static void
+bench_scrub (Bench *b)
+{
+    xaccAccountTreeScrubOrphans (b->root);
+    xaccAccountTreeScrubImbalance (b->root);
+    xaccAccountTreeScrubLots (b->root);
+}
+
+/* Creates the book's transactions and splits again in a scratch book,
+ * the way a loader does: either with a random guid that the one read
+ * from the file then replaces, or with the file's guid from the start
+ * and the collections sized for them beforehand. */
+static void
+bench_construct (FILE *out, Bench *b, gboolean for_load)
+{
+    QofBook *book = qof_book_new ();
+    GPtrArray *splits = g_ptr_array_sized_new (b->splits->len);
+    guint i;
+
+    timer_start ();
+    if (for_load)
+    {
+        qof_collection_reserve (qof_book_get_collection (book, GNC_ID_TRANS),
+                                b->transactions->len);
+        qof_collection_reserve (qof_book_get_collection (book, GNC_ID_SPLIT),
+                                b->splits->len);
+    }
+    for (i = 0; i < b->transactions->len; i++)
+    {
+        const GncGUID *guid =
+            qof_instance_get_guid (g_ptr_array_index (b->transactions, i));
+
+        if (for_load)
+        {
+            xaccMallocTransactionForLoad (book, guid);
+        }
+        else
+        {
+            Transaction *trans = xaccMallocTransaction (book);
+            xaccTransSetGUID (trans, guid);
+        }
+    }
+    for (i = 0; i < b->splits->len; i++)
+    {
+        const GncGUID *guid =
+            qof_instance_get_guid (g_ptr_array_index (b->splits, i));
+        Split *split;
+
+        if (for_load)
+        {
+            split = xaccMallocSplitForLoad (book, guid);
+        }
+        else
+        {
+            split = xaccMallocSplit (book);
+            xaccSplitSetGUID (split, guid);
+        }
+        g_ptr_array_add (splits, split);
+    }
+    timer_report (out, for_load ? "construct_for_load" : "construct_set_guid",
+                  FALSE);
+
+    for (i = 0; i < splits->len; i++)
+        xaccFreeSplit (g_ptr_array_index (splits, i));
+    g_ptr_array_free (splits, TRUE);
+    qof_book_destroy (book);
+}
+
+static void
+run_size (FILE *out, gint n_splits, gboolean last)
+{
+    RealisticBookParams params;
+    GList *accounts, *node;
+    Bench b;
+
+    params.seed = seed;
+    params.n_accounts = n_accounts;
+    params.n_years = n_years;
+    params.multi_split_percent = multi_split_percent;
+    params.n_securities = n_securities;
+    /* Two splits a transaction, and on average two more for the
+     * multi-split ones. */
+    params.n_transactions = n_splits / (2 + 2 * multi_split_percent / 100.0);
+
+    fprintf (out, "    {\n      \"requested_splits\": %d,\n", n_splits);
+    fprintf (out, "      \"timings\": {\n");
+
+    timer_start ();
+    b.book = get_realistic_book (&params);
+    timer_report (out, "generate", FALSE);
+
+    b.root = gnc_book_get_root_account (b.book);
+    b.accounts = g_ptr_array_new ();
+    accounts = gnc_account_get_descendants (b.root);
+    for (node = accounts; node; node = node->next)
+        g_ptr_array_add (b.accounts, node->data);
+    g_list_free (accounts);
+    b.transactions = g_ptr_array_new ();
+    qof_collection_foreach (qof_book_get_collection (b.book, GNC_ID_TRANS),
+                            collect, b.transactions);
+    b.splits = g_ptr_array_new ();
+    qof_collection_foreach (qof_book_get_collection (b.book, GNC_ID_SPLIT),
+                            collect, b.splits);
+
+    timer_start ();
+    bench_commit (&b);
+    timer_report (out, "commit", FALSE);
+    timer_start ();
+    bench_sort (&b);
+    timer_report (out, "sort", FALSE);
+    timer_start ();
+    bench_recompute (&b);
+    timer_report (out, "recompute_balance", FALSE);
+    timer_start ();
+    bench_balance (&b);
+    timer_report (out, "balance_as_of_date", FALSE);
+    timer_start ();
+    bench_lookup (&b);
+    timer_report (out, "lookup", FALSE);
+    bench_construct (out, &b, FALSE);
+    bench_construct (out, &b, TRUE);
+    timer_start ();
+    bench_query (&b);
+    timer_report (out, "query", FALSE);
+    timer_start ();
+    bench_scrub (&b);
+    timer_report (out, "scrub", FALSE);
+    timer_start ();
+    qof_book_destroy (b.book);
+    timer_report (out, "destroy", TRUE);
+
+    fprintf (out, "      },\n      \"accounts\": %u,\n"
+             "      \"transactions\": %u,\n      \"splits\": %u\n    }%s\n",
+             b.accounts->len, b.transactions->len, b.splits->len,
+             last ? "" : ",");
+    g_ptr_array_free (b.accounts, TRUE);
+    g_ptr_array_free (b.transactions, TRUE);
+    g_ptr_array_free (b.splits, TRUE);
+}
+
+int
+main (int argc, char **argv)
+{
+    GOptionContext *context;
+    GError *error = NULL;
+    gchar **size_list;
+    FILE *out = stdout;
+    gint i;
+
+    context = g_option_context_new ("- time core engine operations");
+    g_option_context_add_main_entries (context, options, NULL);
+    if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+        fprintf (stderr, "%s\n", error->message);
+        g_error_free (error);
+        return 1;
+    }
+    g_option_context_free (context);
+
+    qof_init ();
+    if (!cashobjects_register ())
+        return 1;
+
+    if (output && !(out = fopen (output, "w")))
+    {
+        perror (output);
+        return 1;
+    }
+
+    size_list = g_strsplit (sizes ? sizes : "10000,100000", ",", 0);
+    fprintf (out, "{\n  \"version\": \"%s\",\n  \"seed\": %d,\n"
+             "  \"accounts\": %d,\n  \"years\": %d,\n"
+             "  \"multi_split_percent\": %d,\n  \"securities\": %d,\n"
+             "  \"runs\": [\n", PACKAGE_VERSION, seed, n_accounts, n_years,
+             multi_split_percent, n_securities);
+    for (i = 0; size_list[i]; i++)
+        run_size (out, atoi (size_list[i]), size_list[i + 1] == NULL);
+    fprintf (out, "  ]\n}\n");
+    g_strfreev (size_list);
+
+    if (out != stdout)
+        fclose (out);
+    qof_close ();
+    return 0;
+}
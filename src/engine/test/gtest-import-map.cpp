@@ -384,6 +384,7 @@ TEST_F(ImapBayesTest, ConvertAccountBayes)
     // Check for run once flag
     auto vals = book->get_slot("changed-bayesian-to-guid");
     EXPECT_STREQ("true", vals->get<const char*>());
+    EXPECT_EQ(nullptr, gnc_account_imap_convert_bayes_start (t_imap->book));
 
     EXPECT_EQ(1, qof_instance_get_editlevel(QOF_INSTANCE(t_bank_account)));
     EXPECT_TRUE(qof_instance_get_dirty_flag(QOF_INSTANCE(t_bank_account)));
@@ -184,6 +184,46 @@ test_commodity(void)
 
 }
 
+static void
+test_commodity_accumulator(void)
+{
+    QofBook *book = qof_book_new ();
+    gnc_commodity *usd = gnc_commodity_new (book, "US Dollar", "CURRENCY",
+                                            "USD", NULL, 100);
+    gnc_commodity *eur = gnc_commodity_new (book, "Euro", "CURRENCY",
+                                            "EUR", NULL, 100);
+    gnc_commodity_accumulator *acc = gnc_commodity_accumulator_new ();
+    gnc_commodity_accumulator *other = gnc_commodity_accumulator_new ();
+
+    gnc_commodity_accumulator_add (acc, usd, gnc_numeric_create (150, 100));
+    gnc_commodity_accumulator_add (acc, eur, gnc_numeric_create (2, 1));
+    gnc_commodity_accumulator_add (acc, usd, gnc_numeric_create (1, 4));
+    do_test (gnc_commodity_accumulator_count (acc) == 2,
+             "accumulator has one total per commodity");
+    do_test (gnc_numeric_equal (gnc_commodity_accumulator_get (acc, usd),
+                                gnc_numeric_create (175, 100)),
+             "accumulator adds amounts");
+    do_test (gnc_commodity_accumulator_nth_commodity (acc, 0) == usd,
+             "accumulator keeps the order commodities were added in");
+
+    gnc_commodity_accumulator_add (other, eur, gnc_numeric_create (5, 1));
+    gnc_commodity_accumulator_merge (acc, other, TRUE);
+    do_test (gnc_numeric_equal (gnc_commodity_accumulator_get (acc, eur),
+                                gnc_numeric_create (-3, 1)),
+             "accumulator merges negated totals");
+
+    gnc_commodity_accumulator_reset (acc);
+    do_test (gnc_commodity_accumulator_count (acc) == 0 &&
+             gnc_numeric_zero_p (gnc_commodity_accumulator_get (acc, usd)),
+             "accumulator reset");
+
+    gnc_commodity_accumulator_free (other);
+    gnc_commodity_accumulator_free (acc);
+    gnc_commodity_destroy (eur);
+    gnc_commodity_destroy (usd);
+    qof_book_destroy (book);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -193,6 +233,7 @@ main (int argc, char **argv)
     gnc_commodity_table_register();
 
     test_commodity();
+    test_commodity_accumulator();
 
     print_test_results();
 
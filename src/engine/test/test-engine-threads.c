@@ -0,0 +1,190 @@
+/***************************************************************************
+ *            test-engine-threads.c
+ *
+ *  Copyright  2016  GnuCash team
+ ****************************************************************************/
+/*
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ *  02110-1301, USA.
+ */
+/**
+ * @file test-engine-threads.c
+ * @brief Readers in several threads share a book with its writer, the
+ * way qof_book_read_lock() describes.  Worth running under
+ * ThreadSanitizer.
+ */
+
+#include "config.h"
+#include <glib.h>
+#include <stdlib.h>
+#include "qof.h"
+#include "Account.h"
+#include "Query.h"
+#include "Split.h"
+#include "Transaction.h"
+#include "../cashobjects.h"
+#include "test-stuff.h"
+#include "test-engine-stuff.h"
+
+#define N_READERS 4
+#define N_CHANGES 200
+
+typedef struct
+{
+    QofBook *book;
+    GList *accounts;
+    gint *stop;
+    gint rounds;
+    gint lookups_failed;
+    gint balances_wrong;
+    gint queries_wrong;
+} ReaderData;
+
+static void
+read_account (ReaderData *data, Account *acc)
+{
+    gchar *name = gnc_account_get_full_name (acc);
+    QofQuery *q;
+    GList *splits, *results;
+
+    if (xaccAccountLookup (xaccAccountGetGUID (acc), data->book) != acc)
+        data->lookups_failed++;
+
+    if (!gnc_numeric_equal (xaccAccountGetBalanceAsOfDate (acc, G_MAXINT32),
+                            xaccAccountGetBalance (acc)))
+        data->balances_wrong++;
+
+    splits = xaccAccountGetSplitList (acc);
+    q = qof_query_create_for (GNC_ID_SPLIT);
+    qof_query_set_book (q, data->book);
+    xaccQueryAddSingleAccountMatch (q, acc, QOF_QUERY_AND);
+    results = qof_query_run (q);
+    if (g_list_length (results) != g_list_length (splits))
+        data->queries_wrong++;
+    qof_query_destroy (q);
+
+    g_free (name);
+}
+
+static gpointer
+reader_thread (gpointer user_data)
+{
+    ReaderData *data = user_data;
+    GList *node;
+
+    while (!g_atomic_int_get (data->stop))
+    {
+        qof_book_read_lock (data->book);
+        for (node = data->accounts; node; node = node->next)
+            read_account (data, node->data);
+        qof_book_read_unlock (data->book);
+        data->rounds++;
+    }
+    return NULL;
+}
+
+/* Moves a transaction by up to a month, which has its accounts sort
+ * their splits and redo their running balances and date indexes. */
+static void
+change_book (QofBook *book, GList *accounts)
+{
+    Account *acc = g_list_nth_data (accounts, rand () % g_list_length (accounts));
+    GList *splits = xaccAccountGetSplitList (acc);
+    Split *split;
+    Transaction *trans;
+
+    if (!splits)
+        return;
+    split = g_list_nth_data (splits, rand () % g_list_length (splits));
+    trans = xaccSplitGetParent (split);
+
+    qof_book_write_lock (book);
+    xaccTransBeginEdit (trans);
+    xaccTransSetDatePostedSecsNormalized (trans, xaccTransGetDate (trans) +
+                                          (rand () % 61 - 30) * 86400);
+    xaccTransCommitEdit (trans);
+    qof_book_write_unlock (book);
+}
+
+static void
+run_test (void)
+{
+    QofSession *session = get_random_session ();
+    QofBook *book = qof_session_get_book (session);
+    Account *root;
+    ReaderData data[N_READERS];
+    GThread *threads[N_READERS];
+    GList *accounts;
+    gint stop = 0;
+    gint i, failed = 0, wrong = 0, queries = 0;
+
+    add_random_transactions_to_book (book, 300);
+    root = gnc_book_get_root_account (book);
+    accounts = gnc_account_get_descendants (root);
+    if (!accounts)
+    {
+        success ("no accounts to share");
+        qof_session_end (session);
+        qof_session_destroy (session);
+        return;
+    }
+
+    for (i = 0; i < N_READERS; i++)
+    {
+        data[i].book = book;
+        data[i].accounts = accounts;
+        data[i].stop = &stop;
+        data[i].rounds = 0;
+        data[i].lookups_failed = 0;
+        data[i].balances_wrong = 0;
+        data[i].queries_wrong = 0;
+        threads[i] = g_thread_new ("reader", reader_thread, &data[i]);
+    }
+
+    for (i = 0; i < N_CHANGES; i++)
+        change_book (book, accounts);
+
+    g_atomic_int_set (&stop, 1);
+    for (i = 0; i < N_READERS; i++)
+    {
+        g_thread_join (threads[i]);
+        failed += data[i].lookups_failed;
+        wrong += data[i].balances_wrong;
+        queries += data[i].queries_wrong;
+    }
+
+    do_test (failed == 0, "lookups while the book changes");
+    do_test (wrong == 0, "balances while the book changes");
+    do_test (queries == 0, "queries while the book changes");
+
+    g_list_free (accounts);
+    qof_session_end (session);
+    qof_session_destroy (session);
+}
+
+int
+main (int argc, char **argv)
+{
+    qof_init ();
+    if (!cashobjects_register ())
+        exit (1);
+
+    srand (0);
+    run_test ();
+
+    print_test_results ();
+    qof_close ();
+    return get_rv ();
+}
@@ -25,6 +25,7 @@ extern "C"
 {
 #include "config.h"
 #include <glib.h>
+#include <string.h>
 #include "qof.h"
 #include "cashobjects.h"
 #include "Transaction.h"
@@ -68,6 +69,259 @@ test_trans_query (Transaction *trans, gpointer data)
     return 0;
 }
 
+/* The split list of an account is an index for account matches. */
+static void
+test_account_index (Account *acc, gpointer data)
+{
+    QofBook *book = QOF_BOOK(data);
+    QofQuery *q = qof_query_create_for (GNC_ID_SPLIT);
+    GList *splits = xaccAccountGetSplitList (acc);
+    GList *list;
+    gchar *plan;
+
+    qof_query_set_book (q, book);
+    xaccQueryAddSingleAccountMatch (q, acc, QOF_QUERY_AND);
+    plan = qof_query_explain (q);
+    if (!strstr (plan, "\"account splits\""))
+        failure_args ("query plan", __FILE__, __LINE__,
+                      "account match doesn't use the index: %s", plan);
+    g_free (plan);
+
+    list = qof_query_run (q);
+    if (g_list_length (list) != g_list_length (splits))
+        failure_args ("indexed account query", __FILE__, __LINE__,
+                      "%d splits found, account has %d",
+                      g_list_length (list), g_list_length (splits));
+    for (; list; list = list->next)
+        if (!g_list_find (splits, list->data))
+            failure ("indexed account query found a split of another account");
+    qof_query_destroy (q);
+}
+
+static gboolean
+same_splits (GList *found, GList *splits)
+{
+    if (g_list_length (found) != g_list_length (splits))
+        return FALSE;
+    for (; found; found = found->next)
+        if (!g_list_find (splits, found->data))
+            return FALSE;
+    return TRUE;
+}
+
+/* A rerun of a query follows the changes the events reported. */
+static void
+test_cached_results (QofBook *book, Account *root)
+{
+    GList *accounts = gnc_account_get_descendants (root);
+    Account *from = NULL, *to = NULL;
+    GList *node;
+    QofQuery *q;
+    Split *split;
+
+    for (node = accounts; node && !to; node = node->next)
+    {
+        Account *acc = static_cast<Account*>(node->data);
+        if (!from && xaccAccountGetSplitList (acc))
+            from = acc;
+        else if (from && gnc_commodity_equal (xaccAccountGetCommodity (acc),
+                                              xaccAccountGetCommodity (from)))
+            to = acc;
+    }
+    g_list_free (accounts);
+    if (!to)
+        return;
+
+    q = qof_query_create_for (GNC_ID_SPLIT);
+    qof_query_set_book (q, book);
+    xaccQueryAddSingleAccountMatch (q, from, QOF_QUERY_AND);
+    if (!same_splits (qof_query_run (q), xaccAccountGetSplitList (from)))
+        failure ("first run of the account query");
+
+    split = static_cast<Split*>(xaccAccountGetSplitList (from)->data);
+    xaccTransBeginEdit (xaccSplitGetParent (split));
+    xaccSplitSetAccount (split, to);
+    xaccTransCommitEdit (xaccSplitGetParent (split));
+    if (!same_splits (qof_query_run (q), xaccAccountGetSplitList (from)))
+        failure ("rerun after moving a split out of the account");
+
+    xaccTransBeginEdit (xaccSplitGetParent (split));
+    xaccSplitSetAccount (split, from);
+    xaccTransCommitEdit (xaccSplitGetParent (split));
+    if (!same_splits (qof_query_run (q), xaccAccountGetSplitList (from)))
+        failure ("rerun after moving the split back");
+    else
+        success ("cached query results follow the changes");
+    qof_query_destroy (q);
+}
+
+/* Sorting by account name and then date posted, the key of the first
+ * sort a string reached through the account, and of the second a date
+ * reached through the transaction. */
+static void
+test_sorted_results (QofBook *book)
+{
+    QofQuery *q = qof_query_create_for (GNC_ID_SPLIT);
+    GList *node;
+
+    qof_query_set_book (q, book);
+    qof_query_set_sort_order (q,
+                              qof_query_build_param_list (SPLIT_ACCOUNT,
+                                                          ACCOUNT_NAME_, NULL),
+                              qof_query_build_param_list (SPLIT_TRANS,
+                                                          TRANS_DATE_POSTED,
+                                                          NULL),
+                              NULL);
+    for (node = qof_query_run (q); node && node->next; node = node->next)
+    {
+        Split *s1 = static_cast<Split*>(node->data);
+        Split *s2 = static_cast<Split*>(node->next->data);
+        int cmp = g_strcmp0 (xaccAccountGetName (xaccSplitGetAccount (s1)),
+                             xaccAccountGetName (xaccSplitGetAccount (s2)));
+        if (!cmp)
+            cmp = (xaccTransGetDate (xaccSplitGetParent (s1)) >
+                   xaccTransGetDate (xaccSplitGetParent (s2)));
+        if (cmp > 0)
+        {
+            failure ("sorted query results out of order");
+            break;
+        }
+    }
+    qof_query_destroy (q);
+}
+
+/* Checking the splits in several threads finds the same splits, in the
+ * same order, as checking them in one. The book is grown until there are
+ * enough splits for four threads. */
+static void
+test_parallel_results (void)
+{
+    QofSession *session = get_random_session ();
+    QofBook *book = qof_session_get_book (session);
+    QofCollection *splits = qof_book_get_collection (book, GNC_ID_SPLIT);
+    QofQuery *q, *q2;
+    GList *serial, *parallel;
+    gchar *plan;
+
+    while (qof_collection_count (splits) < 4 * 1024)
+        add_random_transactions_to_book (book, 200);
+
+    q = qof_query_create_for (GNC_ID_SPLIT);
+    qof_query_set_book (q, book);
+    xaccQueryAddValueMatch (q, gnc_numeric_zero (), QOF_NUMERIC_MATCH_ANY,
+                            QOF_COMPARE_GTE, QOF_QUERY_AND);
+    xaccQueryAddMemoMatch (q, "[aeiou]", FALSE, TRUE, QOF_COMPARE_CONTAINS,
+                           QOF_QUERY_OR);
+    q2 = qof_query_copy (q);
+    qof_query_set_threads (q2, 4);
+
+    plan = qof_query_explain (q2);
+    if (!strstr (plan, "threads"))
+        failure_args ("query plan", __FILE__, __LINE__,
+                      "value and memo match isn't run in threads: %s", plan);
+    g_free (plan);
+
+    serial = qof_query_run (q);
+    parallel = qof_query_run (q2);
+    if (g_list_length (serial) != g_list_length (parallel))
+        failure_args ("parallel query", __FILE__, __LINE__,
+                      "%d splits found, %d by a serial run",
+                      g_list_length (parallel), g_list_length (serial));
+    for (; serial && parallel; serial = serial->next, parallel = parallel->next)
+        if (serial->data != parallel->data)
+            break;
+    if (serial || parallel)
+        failure ("parallel query results differ from the serial ones");
+    else
+        success ("parallel query results match");
+
+    qof_query_destroy (q2);
+    qof_query_destroy (q);
+    qof_session_end (session);
+}
+
+typedef struct
+{
+    const char *needle;
+    guint count;
+} DescMatchCount;
+
+static void
+count_desc_match (QofInstance *inst, gpointer data)
+{
+    DescMatchCount *dmc = static_cast<DescMatchCount*>(data);
+    const char *desc = xaccTransGetDescription (xaccSplitGetParent (GNC_SPLIT (inst)));
+
+    if (desc && qof_utf8_substr_nocase (desc, dmc->needle))
+        dmc->count++;
+}
+
+static void
+first_trans (QofInstance *inst, gpointer data)
+{
+    Transaction **trans = static_cast<Transaction**>(data);
+    if (!*trans)
+        *trans = GNC_TRANSACTION (inst);
+}
+
+/* A description match of three characters or more is served by the
+ * text index, which has to find every split the scan would, also after
+ * the description changes. */
+static void
+test_text_index (QofBook *book)
+{
+    Transaction *trans = NULL;
+    const char *desc;
+    DescMatchCount dmc;
+    GList *list;
+    gchar *needle, *plan;
+    QofQuery *q;
+
+    qof_collection_foreach (qof_book_get_collection (book, GNC_ID_TRANS),
+                            first_trans, &trans);
+    desc = trans ? xaccTransGetDescription (trans) : NULL;
+    if (!desc || g_utf8_strlen (desc, -1) < 4)
+        return;
+    desc = g_utf8_next_char (desc);
+    needle = g_strndup (desc, g_utf8_offset_to_pointer (desc, 3) - desc);
+
+    q = qof_query_create_for (GNC_ID_SPLIT);
+    qof_query_set_book (q, book);
+    xaccQueryAddDescriptionMatch (q, needle, FALSE, FALSE,
+                                  QOF_COMPARE_CONTAINS, QOF_QUERY_AND);
+    plan = qof_query_explain (q);
+    if (!strstr (plan, "\"transaction text\""))
+        failure_args ("query plan", __FILE__, __LINE__,
+                      "description match doesn't use the index: %s", plan);
+    g_free (plan);
+
+    dmc.needle = needle;
+    dmc.count = 0;
+    qof_collection_foreach (qof_book_get_collection (book, GNC_ID_SPLIT),
+                            count_desc_match, &dmc);
+    list = qof_query_run (q);
+    if (g_list_length (list) != dmc.count)
+        failure_args ("indexed description query", __FILE__, __LINE__,
+                      "%d splits found, %d match", g_list_length (list),
+                      dmc.count);
+    qof_query_destroy (q);
+
+    xaccTransBeginEdit (trans);
+    xaccTransSetDescription (trans, "Zebra crossing");
+    xaccTransCommitEdit (trans);
+    q = qof_query_create_for (GNC_ID_SPLIT);
+    qof_query_set_book (q, book);
+    xaccQueryAddDescriptionMatch (q, "BRA CROSS", FALSE, FALSE,
+                                  QOF_COMPARE_CONTAINS, QOF_QUERY_AND);
+    list = qof_query_run (q);
+    if (!g_list_find (list, xaccTransGetSplit (trans, 0)))
+        failure ("text index missed a changed description");
+    else
+        success ("text index follows commits");
+    qof_query_destroy (q);
+    g_free (needle);
+}
+
 static void
 run_test (void)
 {
@@ -82,6 +336,10 @@ run_test (void)
     add_random_transactions_to_book (book, 20);
 
     xaccAccountTreeForEachTransaction (root, test_trans_query, book);
+    gnc_account_foreach_descendant (root, test_account_index, book);
+    test_cached_results (book, root);
+    test_sorted_results (book);
+    test_text_index (book);
 
     qof_session_end (session);
 }
@@ -109,6 +367,7 @@ main (int argc, char **argv)
     {
         run_test ();
     }
+    test_parallel_results ();
     success("queries seem to work");
 
 cleanup:
@@ -62,6 +62,35 @@ test_query (QofQuery *q)
     qof_query_destroy (q2);
 }
 
+static void
+test_query_string (QofQuery *q)
+{
+    gchar *str;
+    QofQuery *q2;
+
+    str = qof_query_to_string (q);
+    if (!str)
+    {
+        failure ("query can't be written");
+        exit (1);
+    }
+
+    q2 = qof_query_from_string (str);
+    if (!qof_query_equal (q, q2))
+    {
+        failure ("query strings don't match");
+        fprintf (stderr, "%s\n", str);
+        exit (1);
+    }
+    else
+    {
+        success ("query strings match");
+    }
+
+    qof_query_destroy (q2);
+    g_free (str);
+}
+
 static void
 run_tests (void)
 {
@@ -72,12 +101,14 @@ run_tests (void)
 
     q = qof_query_create_for(GNC_ID_SPLIT);
     test_query (q);
+    test_query_string (q);
     qof_query_destroy (q);
 
     for (i = 0; i < 50; i++)
     {
         q = get_random_query ();
         test_query (q);
+        test_query_string (q);
         qof_query_destroy (q);
     }
 }
@@ -708,6 +708,52 @@ test_gnc_book_set_get_root_account (Fixture *fixture, gconstpointer pData)
     qof_book_destroy (book1);
 }
 
+/* gnc_book_begin_bulk_ingest
+void
+gnc_book_begin_bulk_ingest (QofBook *book)
+gnc_book_end_bulk_ingest
+void
+gnc_book_end_bulk_ingest (QofBook *book)*/
+static void
+test_gnc_book_bulk_ingest (Fixture *fixture, gconstpointer pData)
+{
+    auto book = gnc_account_get_book (fixture->acct);
+    auto root = gnc_account_get_root (fixture->acct);
+    auto priv = fixture->func->get_private (fixture->acct);
+    auto doomed = xaccMallocAccount (book);
+
+    xaccAccountSetName (doomed, "doomed");
+    gnc_account_append_child (root, doomed);
+
+    g_assert (!gnc_book_in_bulk_ingest (book));
+    gnc_book_begin_bulk_ingest (book);
+    g_assert (gnc_book_in_bulk_ingest (book));
+    g_assert_cmpint (qof_instance_get_editlevel (fixture->acct), ==, 1);
+    g_assert_cmpint (qof_instance_get_editlevel (root), ==, 1);
+
+    /* Balances are left alone until the session ends. */
+    gnc_account_set_balance_dirty (fixture->acct);
+    xaccAccountRecomputeBalance (fixture->acct);
+    g_assert (priv->balance_dirty);
+
+    /* Sessions nest. */
+    gnc_book_begin_bulk_ingest (book);
+    gnc_book_end_bulk_ingest (book);
+    g_assert (gnc_book_in_bulk_ingest (book));
+    g_assert_cmpint (qof_instance_get_editlevel (fixture->acct), ==, 1);
+
+    /* An account destroyed during the session goes at once. */
+    xaccAccountBeginEdit (doomed);
+    xaccAccountDestroy (doomed);
+    g_assert (gnc_account_lookup_by_name (root, "doomed") == NULL);
+
+    gnc_book_end_bulk_ingest (book);
+    g_assert (!gnc_book_in_bulk_ingest (book));
+    g_assert_cmpint (qof_instance_get_editlevel (fixture->acct), ==, 0);
+    g_assert_cmpint (qof_instance_get_editlevel (root), ==, 0);
+    g_assert (!priv->balance_dirty);
+}
+
 /* xaccMallocAccount
 Account *
 xaccMallocAccount (QofBook *book)// C: 24 in 17 SCM: 9 in 6*/
@@ -1169,6 +1215,7 @@ test_gnc_account_insert_remove_split (Fixture *fixture, gconstpointer pData)
     g_assert (gnc_account_insert_split (fixture->acct, split3));
     qof_instance_decrease_editlevel (fixture->acct);
     g_assert_cmpuint (g_list_length (priv->splits), == , 3);
+    g_assert_cmpuint (priv->split_array->len, == , 3);
     g_assert (priv->sort_dirty);
     g_assert (priv->balance_dirty);
     test_signal_assert_hits (sig1, 3);
@@ -1180,6 +1227,9 @@ test_gnc_account_insert_remove_split (Fixture *fixture, gconstpointer pData)
                             split3);
     g_assert (gnc_account_remove_split (fixture->acct, split3));
     g_assert_cmpuint (g_list_length (priv->splits), == , 2);
+    g_assert_cmpuint (priv->split_array->len, == , 2);
+    g_assert (g_ptr_array_index (priv->split_array, 0) == split1 ||
+              g_ptr_array_index (priv->split_array, 1) == split1);
     g_assert (priv->sort_dirty);
     g_assert (!priv->balance_dirty);
     test_signal_assert_hits (sig1, 4);
@@ -1192,6 +1242,21 @@ test_gnc_account_insert_remove_split (Fixture *fixture, gconstpointer pData)
     g_assert (!priv->balance_dirty);
     test_signal_assert_hits (sig1, 4);
     test_signal_assert_hits (sig3, 1);
+    /* Sorting leaves the list and the array in the same order. */
+    qof_instance_increase_editlevel (fixture->acct);
+    g_assert (gnc_account_insert_split (fixture->acct, split3));
+    qof_instance_decrease_editlevel (fixture->acct);
+    xaccAccountSortSplits (fixture->acct, FALSE);
+    g_assert (!priv->sort_dirty);
+    GList *node = priv->splits;
+    for (guint i = 0; i < priv->split_array->len; ++i, node = node->next)
+    {
+        g_assert (node->data == g_ptr_array_index (priv->split_array, i));
+        if (i > 0)
+            g_assert_cmpint (xaccSplitOrder (static_cast<Split*>(node->prev->data),
+                                             static_cast<Split*>(node->data)), <, 0);
+    }
+    g_assert (gnc_account_remove_split (fixture->acct, split3));
 
     /* Clean up the handlers */
     test_signal_free (sig3);
@@ -1349,6 +1414,18 @@ test_xaccAccountRecomputeBalance (Fixture *fixture, gconstpointer pData)
     g_assert (gnc_numeric_eq (priv->cleared_balance, clr_bal));
     g_assert (gnc_numeric_eq (priv->reconciled_balance, rec_bal));
     g_assert (!priv->balance_dirty);
+    /* Dirtying one split only invalidates the balances from it on. */
+    guint last = priv->split_array->len - 1;
+    Split *split = static_cast<Split*>(g_ptr_array_index (priv->split_array,
+                                                          last));
+    gnc_account_set_split_dirty (fixture->acct, split);
+    g_assert (priv->balance_dirty);
+    g_assert_cmpuint (priv->balance_dirty_from, ==, last);
+    xaccAccountRecomputeBalance (fixture->acct);
+    g_assert (gnc_numeric_eq (priv->balance, bal));
+    g_assert (gnc_numeric_eq (priv->cleared_balance, clr_bal));
+    g_assert (gnc_numeric_eq (priv->reconciled_balance, rec_bal));
+    g_assert (!priv->balance_dirty);
 }
 
 /* xaccAccountOrder
@@ -1709,6 +1786,12 @@ test_gnc_account_lookup_by_code (Fixture *fixture, gconstpointer pData)
     target = gnc_account_lookup_by_code (target, "2100");
     g_assert (target == NULL);
     g_free (name);
+    /* A code that exists elsewhere in the tree isn't found from an
+     * unrelated parent. */
+    target = gnc_account_lookup_by_code (root, "3000");
+    g_assert (target != NULL);
+    g_assert (gnc_account_lookup_by_code (target, "4160") == NULL);
+    g_assert (gnc_account_lookup_by_code (root, "4160") != NULL);
 }
 /* gnc_account_lookup_by_full_name_helper
 static Account *
@@ -1764,6 +1847,14 @@ test_gnc_account_lookup_by_full_name (Fixture *fixture, gconstpointer pData)
     target = gnc_account_lookup_by_full_name (root, names3);
     g_assert (target == NULL);
     g_free (code);
+    /* Renaming an ancestor must be reflected in the lookup. */
+    target = gnc_account_lookup_by_full_name (root, "income:taxable");
+    g_assert (target != NULL);
+    xaccAccountSetName (target, "taxed");
+    g_assert (gnc_account_lookup_by_full_name (root, names1) == NULL);
+    g_assert (gnc_account_lookup_by_full_name (root, "income:taxed:int") != NULL);
+    xaccAccountSetName (target, "taxable");
+    g_assert (gnc_account_lookup_by_full_name (root, names1) != NULL);
 }
 
 static void
@@ -1889,7 +1980,17 @@ test_gnc_account_get_full_name (Fixture *fixture, gconstpointer pData)
     g_assert (result != NULL);
     g_assert_cmpstr (result, == , "foo:baz:waldo");
     g_free (result);
-
+    /* The cached name follows renames of ancestors and separator
+     * changes. */
+    xaccAccountSetName (gnc_account_get_parent (fixture->acct), "bar");
+    result = gnc_account_get_full_name (fixture->acct);
+    g_assert_cmpstr (result, == , "foo:bar:waldo");
+    g_free (result);
+    gnc_set_account_separator ("-");
+    result = gnc_account_get_full_name (fixture->acct);
+    g_assert_cmpstr (result, == , "foo-bar-waldo");
+    g_free (result);
+    gnc_set_account_separator (":");
 }
 
 /* DxaccAccountGetCurrency
@@ -1953,6 +2054,47 @@ test_xaccAccountGetBalanceAsOfDate (Fixture *fixture, gconstpointer pData)
                                          (gnc_time (NULL) - offset));
     dval = gnc_numeric_to_double (val);
     g_assert_cmpfloat (dval, == , dbal);
+    /* Before the first split the balance is zero, after the last it's
+     * the account balance. */
+    val = xaccAccountGetBalanceAsOfDate (fixture->acct,
+                                         (gnc_time (NULL) - 100 * offset));
+    g_assert (gnc_numeric_zero_p (val));
+    val = xaccAccountGetBalanceAsOfDate (fixture->acct,
+                                         (gnc_time (NULL) + offset));
+    g_assert (gnc_numeric_eq (val, xaccAccountGetBalance (fixture->acct)));
+    /* A dirty account must rebuild its date index. */
+    gnc_account_set_sort_dirty (fixture->acct);
+    val = xaccAccountGetBalanceAsOfDate (fixture->acct,
+                                         (gnc_time (NULL) - offset));
+    dval = gnc_numeric_to_double (val);
+    g_assert_cmpfloat (dval, == , dbal);
+}
+/* gnc_account_set_balance_rollup_cache
+void
+gnc_account_set_balance_rollup_cache (gboolean enabled)*/
+static void
+test_gnc_account_balance_rollup_cache (Fixture *fixture, gconstpointer pData)
+{
+    auto book = gnc_account_get_book (fixture->acct);
+    auto usd = gnc_commodity_new (book, "US Dollar", "CURRENCY", "USD", "0", 100);
+    auto parent = gnc_account_get_parent (fixture->acct);
+    auto ppriv = fixture->func->get_private (parent);
+    gnc_numeric bal, cached;
+
+    xaccAccountSetCommodity (parent, usd);
+    xaccAccountSetCommodity (fixture->acct, usd);
+    xaccAccountRecomputeBalance (fixture->acct);
+    gnc_account_set_balance_rollup_cache (TRUE);
+    bal = xaccAccountGetBalanceInCurrency (parent, usd, TRUE);
+    g_assert (gnc_numeric_equal (bal, xaccAccountGetBalance (fixture->acct)));
+    g_assert (ppriv->rollup_cache != NULL);
+    cached = xaccAccountGetBalanceInCurrency (parent, usd, TRUE);
+    g_assert (gnc_numeric_eq (bal, cached));
+    /* A change in the child drops the parent's roll-ups. */
+    gnc_account_set_balance_dirty (fixture->acct);
+    g_assert (ppriv->rollup_cache == NULL);
+    gnc_account_set_balance_rollup_cache (FALSE);
+    g_assert (ppriv->rollup_cache == NULL);
 }
 /* xaccAccountGetPresentBalance
 gnc_numeric
@@ -2084,6 +2226,71 @@ test_xaccAccountForEachLot (Fixture *fixture, gconstpointer pData)
     xaccAccountForEachLot (acct, bogus_for_each_lot_func, &count_calls);
     g_assert_cmpint (count_calls, == , 5);
 }
+/* The lot gnc_account_find_open_lot should pick, found the slow way. */
+static GNCLot*
+find_open_lot_by_scan (Account *acct, gboolean opening_positive,
+                       gboolean latest)
+{
+    GNCLot *found = NULL;
+    Timespec found_ts = {0, 0};
+    auto lots = xaccAccountGetLotList (acct);
+    for (auto node = lots; node; node = node->next)
+    {
+        auto lot = GNC_LOT (node->data);
+        if (gnc_lot_is_closed (lot)) continue;
+        auto split = gnc_lot_get_earliest_split (lot);
+        if (!split || gnc_numeric_zero_p (xaccSplitGetAmount (split)))
+            continue;
+        auto positive = gnc_numeric_positive_p (xaccSplitGetAmount (split));
+        if (positive != opening_positive ||
+            positive != gnc_numeric_positive_p (gnc_lot_get_balance (lot)))
+            continue;
+        auto ts = xaccTransRetDatePostedTS (xaccSplitGetParent (split));
+        if (!found || (latest ? timespec_cmp (&ts, &found_ts) > 0 :
+                       timespec_cmp (&ts, &found_ts) < 0))
+        {
+            found = lot;
+            found_ts = ts;
+        }
+    }
+    g_list_free (lots);
+    return found;
+}
+static void
+check_open_lot_index (Account *acct)
+{
+    for (int positive = 0; positive < 2; positive++)
+        for (int latest = 0; latest < 2; latest++)
+            g_assert (gnc_account_find_open_lot (acct, positive, NULL, latest)
+                      == find_open_lot_by_scan (acct, positive, latest));
+}
+/* gnc_account_find_open_lot
+GNCLot *
+gnc_account_find_open_lot (Account *acc, gboolean opening_positive,
+                           gnc_commodity *currency, gboolean latest)*/
+static void
+test_gnc_account_find_open_lot (Fixture *fixture, gconstpointer pData)
+{
+    Account *root = gnc_account_get_root (fixture->acct);
+    Account *acct = gnc_account_lookup_by_name (root, "baz");
+    GNCLot *lot;
+    Split *opening;
+
+    g_assert (acct);
+    check_open_lot_index (acct);
+
+    /* Taking the opening split out of a lot must move the lot in the
+     * index: it is now opened by what was its second split, if any. */
+    lot = gnc_account_find_open_lot (acct, TRUE, NULL, FALSE);
+    g_assert (lot);
+    opening = gnc_lot_get_earliest_split (lot);
+    gnc_lot_remove_split (lot, opening);
+    check_open_lot_index (acct);
+
+    /* And putting it back must restore the lot. */
+    gnc_lot_add_split (lot, opening);
+    g_assert (gnc_account_find_open_lot (acct, TRUE, NULL, FALSE) == lot);
+}
 /* These getters and setters look in KVP, so I guess their delegators instead:
  * xaccAccountGetTaxRelated
  * xaccAccountSetTaxRelated
@@ -2354,6 +2561,36 @@ test_xaccAccountFindTransByDesc (Fixture *fixture, gconstpointer pData)
     g_assert_cmpstr (desc, == , "pepper");
     g_free (desc);
 }
+/* xaccAccountFindTransByMemo
+Transaction *
+xaccAccountFindTransByMemo (const Account *acc, const char *memo)
+*/
+static void
+test_xaccAccountFindTransByMemo (Fixture *fixture, gconstpointer pData)
+{
+    Account *root = gnc_account_get_root (fixture->acct);
+    Account *baz = gnc_account_lookup_by_name (root, "baz");
+    Transaction *pepper = xaccAccountFindTransByMemo (baz, "pepper_money");
+    Transaction *links = xaccAccountFindTransByDesc (baz, "links");
+
+    g_assert (pepper);
+    g_assert_cmpstr (xaccTransGetDescription (pepper), == , "pepper");
+    g_assert (links);
+    g_assert (xaccAccountFindTransByMemo (baz, "funding_money") == NULL);
+    /* The indexes follow commits: an older transaction taking a
+     * description doesn't win over a newer one, and one leaving it lets
+     * the next most recent be found. */
+    xaccTransBeginEdit (pepper);
+    xaccTransSetDescription (pepper, "links");
+    xaccTransCommitEdit (pepper);
+    g_assert (xaccAccountFindTransByDesc (baz, "pepper") == NULL);
+    g_assert (xaccAccountFindTransByDesc (baz, "links") == links);
+    xaccTransBeginEdit (links);
+    xaccTransSetDescription (links, "paprika");
+    xaccTransCommitEdit (links);
+    g_assert (xaccAccountFindTransByDesc (baz, "links") == pepper);
+    g_assert (xaccAccountFindTransByDesc (baz, "paprika") == links);
+}
 /* gnc_account_join_children
 void
 gnc_account_join_children (Account *to_parent, Account *from_parent)// C: 4 in 2 SCM: 3 in 3*/
@@ -2540,6 +2777,7 @@ test_suite_account (void)
     GNC_TEST_ADD (suitename, "gnc account list name violations", Fixture, &bad_data, setup, test_gnc_account_list_name_violations,  teardown);
     GNC_TEST_ADD_FUNC (suitename, "account create and destroy", test_gnc_account_create_and_destroy);
     GNC_TEST_ADD (suitename, "book set/get root account", Fixture, NULL, setup, test_gnc_book_set_get_root_account, teardown);
+    GNC_TEST_ADD (suitename, "book bulk ingest", Fixture, &some_data, setup, test_gnc_book_bulk_ingest, teardown);
     GNC_TEST_ADD_FUNC (suitename, "xaccMallocAccount", test_xaccMallocAccount);
 
     GNC_TEST_ADD_FUNC (suitename, "gnc account create root", test_gnc_account_create_root);
@@ -2573,14 +2811,17 @@ test_suite_account (void)
     GNC_TEST_ADD (suitename, "xaccAccountGetProjectedMinimumBalance", Fixture, &some_data, setup, test_xaccAccountGetProjectedMinimumBalance,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountGetBalanceAsOfDate", Fixture, &some_data, setup, test_xaccAccountGetBalanceAsOfDate,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountGetPresentBalance", Fixture, &some_data, setup, test_xaccAccountGetPresentBalance,  teardown );
+    GNC_TEST_ADD (suitename, "gnc account balance rollup cache", Fixture, &some_data, setup, test_gnc_account_balance_rollup_cache,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountFindOpenLots", Fixture, &complex_data, setup, test_xaccAccountFindOpenLots,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountForEachLot", Fixture, &complex_data, setup, test_xaccAccountForEachLot,  teardown );
+    GNC_TEST_ADD (suitename, "gnc account find open lot", Fixture, &complex_data, setup, test_gnc_account_find_open_lot,  teardown );
 
     GNC_TEST_ADD (suitename, "xaccAccountHasAncestor", Fixture, &complex, setup, test_xaccAccountHasAncestor,  teardown );
     GNC_TEST_ADD_FUNC (suitename, "AccountType Stuff", test_xaccAccountType_Stuff );
     GNC_TEST_ADD_FUNC (suitename, "AccountType Compatibility", test_xaccAccountType_Compatibility);
     GNC_TEST_ADD (suitename, "xaccAccountFindSplitByDesc", Fixture, &complex_data, setup, test_xaccAccountFindSplitByDesc,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountFindTransByDesc", Fixture, &complex_data, setup, test_xaccAccountFindTransByDesc,  teardown );
+    GNC_TEST_ADD (suitename, "xaccAccountFindTransByMemo", Fixture, &complex_data, setup, test_xaccAccountFindTransByMemo,  teardown );
     GNC_TEST_ADD (suitename, "gnc account join children", Fixture, &complex, setup, test_gnc_account_join_children,  teardown );
     GNC_TEST_ADD (suitename, "gnc account merge children", Fixture, &complex_data, setup, test_gnc_account_merge_children,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountForEachTransaction", Fixture, &complex_data, setup, test_xaccAccountForEachTransaction,  teardown );
@@ -108,6 +108,21 @@ mock_backend_rollback (QofBackend *be, QofInstance *foo)
     mbe->be.last_err = mbe->result_err;
 }
 
+static void
+mock_backend_begin (QofBackend *be, QofInstance *foo)
+{
+    MockBackend *mbe = (MockBackend *)be;
+    g_strlcpy (mbe->last_call, "begin", sizeof (mbe->last_call));
+}
+
+static void
+mock_backend_commit (QofBackend *be, QofInstance *foo)
+{
+    MockBackend *mbe = (MockBackend *)be;
+    g_strlcpy (mbe->last_call, "commit", sizeof (mbe->last_call));
+    mbe->be.last_err = mbe->result_err;
+}
+
 static MockBackend*
 mock_backend_new (void)
 {
@@ -138,10 +153,8 @@ setup (Fixture *fixture, gconstpointer pData)
     fixture->acc2 = xaccMallocAccount (book);
     xaccAccountSetCommodity (fixture->acc1, fixture->comm);
     xaccAccountSetCommodity (fixture->acc2, fixture->curr);
-    txn->date_posted.tv_sec = posted.tv_sec;
-    txn->date_posted.tv_nsec = posted.tv_nsec;
-    txn->date_entered.tv_sec = entered.tv_sec;
-    txn->date_entered.tv_nsec = entered.tv_nsec;
+    txn->date_posted = posted.tv_sec;
+    txn->date_entered = entered.tv_sec;
     split1->memo = static_cast<char*>(CACHE_INSERT ("foo"));
     split1->action = static_cast<char*>(CACHE_INSERT ("bar"));
     split1->amount = gnc_numeric_create (100000, 1000);
@@ -347,10 +360,8 @@ test_gnc_transaction_init ()
     g_assert_cmpstr (txn->description, ==, "");
     g_assert (txn->common_currency == NULL);
     g_assert (txn->splits == NULL);
-    g_assert_cmpint (txn->date_entered.tv_sec, ==, 0);
-    g_assert_cmpint (txn->date_entered.tv_nsec, ==, 0);
-    g_assert_cmpint (txn->date_posted.tv_sec, ==, 0);
-    g_assert_cmpint (txn->date_posted.tv_nsec, ==, 0);
+    g_assert_cmpint (txn->date_entered, ==, 0);
+    g_assert_cmpint (txn->date_posted, ==, 0);
     g_assert_cmpint (txn->marker, ==, 0);
     g_assert (txn->orig == NULL);
 
@@ -438,10 +449,8 @@ test_gnc_transaction_set_get_property (Fixture *fixture, gconstpointer pData)
     g_assert_cmpstr (txn->num, ==, "");
     g_assert_cmpstr (txn->description, ==, "");
     g_assert (txn->common_currency == NULL);
-    g_assert_cmpint (txn->date_entered.tv_sec, ==, 0);
-    g_assert_cmpint (txn->date_entered.tv_nsec, ==, 0);
-    g_assert_cmpint (txn->date_posted.tv_sec, ==, 0);
-    g_assert_cmpint (txn->date_posted.tv_nsec, ==, 0);
+    g_assert_cmpint (txn->date_entered, ==, 0);
+    g_assert_cmpint (txn->date_posted, ==, 0);
     /* Kick up the edit counter to keep from committing */
     xaccTransBeginEdit (txn);
     g_object_set (G_OBJECT (txn),
@@ -456,8 +465,8 @@ test_gnc_transaction_set_get_property (Fixture *fixture, gconstpointer pData)
     g_assert_cmpstr (txn->num, ==, num);
     g_assert_cmpstr (txn->description, ==, desc);
     g_assert (txn->common_currency == curr);
-    g_assert (timespec_equal (&(txn->date_entered), &now));
-    g_assert (timespec_equal (&(txn->date_posted), &now));
+    g_assert_cmpint (txn->date_entered, ==, now.tv_sec);
+    g_assert_cmpint (txn->date_posted, ==, now.tv_sec);
     g_assert_cmpint (check1->hits, ==, 1);
     g_assert_cmpint (check2->hits, ==, 2);
 
@@ -590,8 +599,8 @@ test_dupe_trans (Fixture *fixture, gconstpointer pData)
     QofBook *old_book = qof_instance_get_book (QOF_INSTANCE (oldtxn));
     GList *newnode, *oldnode = oldtxn->splits;
 
-    oldtxn->date_posted = posted;
-    oldtxn->date_entered = entered;
+    oldtxn->date_posted = posted.tv_sec;
+    oldtxn->date_entered = entered.tv_sec;
     oldtxn->inst.kvp_data->set("/foo/bar/baz",
                                new KvpValue("The Great Waldo Pepper"));
 
@@ -609,8 +618,8 @@ test_dupe_trans (Fixture *fixture, gconstpointer pData)
     }
     g_assert (newnode == NULL);
     g_assert (oldnode == NULL);
-    g_assert (timespec_equal (&(newtxn->date_posted), &posted));
-    g_assert (timespec_equal (&(newtxn->date_entered), &entered));
+    g_assert_cmpint (newtxn->date_posted, ==, posted.tv_sec);
+    g_assert_cmpint (newtxn->date_entered, ==, entered.tv_sec);
     g_assert (qof_instance_version_cmp (QOF_INSTANCE (newtxn),
                                         QOF_INSTANCE (oldtxn)) == 0);
     g_assert (newtxn->orig == NULL);
@@ -637,8 +646,8 @@ test_xaccTransClone (Fixture *fixture, gconstpointer pData)
     GList *newnode, *oldnode;
     int foo, bar;
 
-    oldtxn->date_posted = posted;
-    oldtxn->date_entered = entered;
+    oldtxn->date_posted = posted.tv_sec;
+    oldtxn->date_entered = entered.tv_sec;
     newtxn = xaccTransClone (oldtxn);
 
     g_assert_cmpstr (newtxn->num, ==, oldtxn->num);
@@ -661,8 +670,8 @@ test_xaccTransClone (Fixture *fixture, gconstpointer pData)
     }
     g_assert (newnode == NULL);
     g_assert (oldnode == NULL);
-    g_assert (timespec_equal (&(newtxn->date_posted), &posted));
-    g_assert (timespec_equal (&(newtxn->date_entered), &entered));
+    g_assert_cmpint (newtxn->date_posted, ==, posted.tv_sec);
+    g_assert_cmpint (newtxn->date_entered, ==, entered.tv_sec);
     g_assert (qof_instance_version_cmp (QOF_INSTANCE (newtxn),
                                         QOF_INSTANCE (oldtxn)) == 0);
     g_assert_cmpint (qof_instance_get_version_check (newtxn), ==,
@@ -703,8 +712,8 @@ test_xaccTransCopyFromClipBoard (Fixture *fixture, gconstpointer pData)
     xaccTransCopyFromClipBoard (txn, to_txn, fixture->acc1, acc1, FALSE);
     g_assert (gnc_commodity_equal (txn->common_currency,
                                    to_txn->common_currency));
-    g_assert (timespec_equal (&(to_txn->date_entered), &now));
-    g_assert (timespec_equal (&(to_txn->date_posted), &txn->date_posted));
+    g_assert_cmpint (to_txn->date_entered, ==, now.tv_sec);
+    g_assert_cmpint (to_txn->date_posted, ==, txn->date_posted);
     g_assert_cmpstr (txn->num, ==, to_txn->num);
     /* Notes also tests that KVP is copied */
     g_assert_cmpstr (xaccTransGetNotes (txn), ==, xaccTransGetNotes (to_txn));
@@ -729,8 +738,8 @@ test_xaccTransCopyFromClipBoard_no_start (Fixture *fixture, gconstpointer pData)
     xaccTransCopyFromClipBoard (txn, to_txn, fixture->acc1, acc1, TRUE);
     g_assert (gnc_commodity_equal (txn->common_currency,
                                    to_txn->common_currency));
-    g_assert (timespec_equal (&(to_txn->date_entered), &now));
-    g_assert (timespec_equal (&(to_txn->date_posted), &never));
+    g_assert_cmpint (to_txn->date_entered, ==, now.tv_sec);
+    g_assert_cmpint (to_txn->date_posted, ==, never.tv_sec);
     g_assert_cmpstr (to_txn->num, ==, txn->num);
     /* Notes also tests that KVP is copied */
     g_assert_cmpstr (xaccTransGetNotes (txn), ==, xaccTransGetNotes (to_txn));
@@ -766,10 +775,8 @@ test_xaccFreeTransaction (Fixture *fixture, gconstpointer pData)
     g_assert (txn->splits == NULL);
     g_assert_cmpint (GPOINTER_TO_INT(txn->num), ==, 1);
     g_assert (txn->description == NULL);
-    g_assert_cmpint (txn->date_entered.tv_sec, ==, 0);
-    g_assert_cmpint (txn->date_entered.tv_nsec, ==, 0);
-    g_assert_cmpint (txn->date_posted.tv_sec, ==, 0);
-    g_assert_cmpint (txn->date_posted.tv_nsec, ==, 0);
+    g_assert_cmpint (txn->date_entered, ==, 0);
+    g_assert_cmpint (txn->date_posted, ==, 0);
     g_assert_cmpint (GPOINTER_TO_INT(orig->num), ==, 1);
     g_assert (txn->orig == NULL);
     test_destroy (orig);
@@ -848,13 +855,13 @@ test_xaccTransEqual (Fixture *fixture, gconstpointer pData)
     g_assert (!xaccTransEqual (clone, txn0, TRUE, FALSE, TRUE, TRUE));
     g_assert_cmpint (check->hits, ==, 2);
 
-    gnc_timespec_to_iso8601_buff (clone->date_posted, posted);
-    gnc_timespec_to_iso8601_buff (clone->date_entered, entered);
+    gnc_timespec_to_iso8601_buff (xaccTransRetDatePostedTS (clone), posted);
+    gnc_timespec_to_iso8601_buff (xaccTransRetDateEnteredTS (clone), entered);
     xaccTransBeginEdit (clone);
     cleanup->msg = g_strdup_printf (cleanup_fmt, clone->orig);
     /* This puts the value of the first split back, but leaves the amount changed */
     xaccTransSetCurrency (clone, fixture->curr);
-    clone->date_posted.tv_sec = txn0->date_entered.tv_sec;
+    clone->date_posted = txn0->date_entered;
     xaccTransCommitEdit (clone);
     g_free (cleanup->msg);
     g_free (check->msg);
@@ -864,8 +871,8 @@ test_xaccTransEqual (Fixture *fixture, gconstpointer pData)
 
     xaccTransBeginEdit (clone);
     cleanup->msg = g_strdup_printf (cleanup_fmt, clone->orig);
-    clone->date_posted.tv_sec = txn0->date_posted.tv_sec;
-    clone->date_entered.tv_sec = txn0->date_posted.tv_sec;
+    clone->date_posted = txn0->date_posted;
+    clone->date_entered = txn0->date_posted;
     xaccTransCommitEdit (clone);
     g_free (cleanup->msg);
     g_free (check->msg);
@@ -875,7 +882,7 @@ test_xaccTransEqual (Fixture *fixture, gconstpointer pData)
 
     xaccTransBeginEdit (clone);
     cleanup->msg = g_strdup_printf (cleanup_fmt, clone->orig);
-    clone->date_entered.tv_sec = txn0->date_entered.tv_sec;
+    clone->date_entered = txn0->date_entered;
     clone->num = g_strdup("123");
     xaccTransCommitEdit (clone);
     g_free (cleanup->msg);
@@ -1113,6 +1120,42 @@ test_xaccTransGetImbalance_trading (Fixture *fixture,
 }
 
 
+/* xaccTransInvalidateImbalance
+void
+xaccTransInvalidateImbalance (Transaction *trans)
+*/
+static void
+test_xaccTransGetImbalanceValue_cache (Fixture *fixture, gconstpointer pData)
+{
+    auto txn = fixture->txn;
+    auto split = xaccTransGetSplit (txn, 0);
+    auto delta = gnc_numeric_create (200, 240);
+    auto value = xaccSplitGetValue (split);
+    guint64 hits, misses, hits0, misses0;
+
+    xaccTransInvalidateImbalance (txn);
+    xaccTransGetImbalanceCacheStats (&hits0, &misses0);
+    g_assert (gnc_numeric_zero_p (xaccTransGetImbalanceValue (txn)));
+    g_assert (xaccTransIsBalanced (txn));
+    xaccTransGetImbalanceCacheStats (&hits, &misses);
+    g_assert_cmpuint (hits, ==, hits0 + 1);
+    g_assert_cmpuint (misses, ==, misses0 + 1);
+
+    /* Changing a value through the setter drops the cached sum. */
+    xaccTransBeginEdit (txn);
+    xaccSplitSetValue (split, gnc_numeric_sub (value, delta, 240,
+                                               GNC_HOW_RND_NEVER));
+    g_assert (!xaccTransIsBalanced (txn));
+    g_assert (gnc_numeric_equal (xaccTransGetImbalanceValue (txn),
+                                 gnc_numeric_neg (delta)));
+    xaccTransGetImbalanceCacheStats (&hits, &misses);
+    g_assert_cmpuint (hits, ==, hits0 + 2);
+    g_assert_cmpuint (misses, ==, misses0 + 2);
+
+    xaccTransRollbackEdit (txn);
+    g_assert (gnc_numeric_equal (xaccSplitGetValue (split), value));
+    g_assert (xaccTransIsBalanced (txn));
+}
 /* xaccTransIsBalanced
 gboolean
 xaccTransIsBalanced (const Transaction *trans)// C: 4 in 4  Local: 1:0:0
@@ -1632,8 +1675,7 @@ test_xaccTransCommitEdit (void)
 
     xaccAccountSetCommodity (acc1, comm);
     xaccAccountSetCommodity (acc2, curr);
-    txn->date_posted.tv_sec = posted.tv_sec;
-    txn->date_posted.tv_nsec = posted.tv_nsec;
+    txn->date_posted = posted.tv_sec;
     split1->memo = static_cast<char*>(CACHE_INSERT ("foo"));
     split1->action = static_cast<char*>(CACHE_INSERT ("bar"));
     split1->amount = gnc_numeric_create (100000, 1000);
@@ -1656,7 +1698,7 @@ test_xaccTransCommitEdit (void)
     /* Setup's done, now test: */
     xaccTransCommitEdit (txn);
 
-    g_assert_cmpint (txn->date_entered.tv_sec, !=, 0);
+    g_assert_cmpint (txn->date_entered, !=, 0);
     /* Signals make sure that trans_cleanup_commit got called */
     g_assert_cmpint (test_signal_return_hits (sig_1_modify), ==, 1);
     g_assert_cmpint (test_signal_return_hits (sig_2_modify), ==, 1);
@@ -1679,6 +1721,41 @@ test_xaccTransCommitEdit (void)
     test_destroy (comm);
     qof_book_destroy (book);
 }
+/* trans_edit_is_clean
+static gboolean
+trans_edit_is_clean (const Transaction *trans)
+*/
+static void
+test_xaccTransCommitEdit_unchanged (Fixture *fixture, gconstpointer pData)
+{
+    auto txn = fixture->txn;
+    auto book = qof_instance_get_book (QOF_INSTANCE (txn));
+    auto mbe = (MockBackend*)qof_book_get_backend (book);
+    auto sig_modify = test_signal_new (QOF_INSTANCE (txn),
+                                       QOF_EVENT_MODIFY, NULL);
+
+    mbe->be.begin = mock_backend_begin;
+    mbe->be.commit = mock_backend_commit;
+
+    /* Nothing changed, so nothing goes to the backend. */
+    xaccTransBeginEdit (txn);
+    g_assert_cmpstr (mbe->last_call, ==, "begin");
+    xaccTransCommitEdit (txn);
+    g_assert_cmpstr (mbe->last_call, ==, "begin");
+    g_assert (txn->orig == NULL);
+    g_assert_cmpint (qof_instance_get_editlevel (txn), ==, 0);
+    g_assert_cmpint (test_signal_return_hits (sig_modify), ==, 0);
+
+    xaccTransBeginEdit (txn);
+    xaccSplitSetMemo (xaccTransGetSplit (txn, 0), "baz");
+    xaccTransCommitEdit (txn);
+    g_assert_cmpstr (mbe->last_call, ==, "commit");
+    g_assert_cmpint (test_signal_return_hits (sig_modify), >, 0);
+
+    mbe->be.begin = NULL;
+    mbe->be.commit = NULL;
+    test_signal_free (sig_modify);
+}
 /* xaccTransRollbackEdit
 void
 xaccTransRollbackEdit (Transaction *trans)// C: 2 in 2  Local: 1:0:0
@@ -1691,8 +1768,8 @@ test_xaccTransRollbackEdit (Fixture *fixture, gconstpointer pData)
     QofBook *book = qof_instance_get_book (txn);
     Timespec new_post = timespec_now ();
     Timespec new_entered = timespecCanonicalDayTime (timespec_now ());
-    Timespec orig_post = txn->date_posted;
-    Timespec orig_entered = txn->date_entered;
+    time64 orig_post = txn->date_posted;
+    time64 orig_entered = txn->date_entered;
     KvpFrame *base_frame = NULL;
     auto sig_account = test_signal_new (QOF_INSTANCE (fixture->acc1),
                               GNC_EVENT_ITEM_CHANGED, NULL);
@@ -1710,8 +1787,8 @@ test_xaccTransRollbackEdit (Fixture *fixture, gconstpointer pData)
     txn->description = static_cast<char*>(CACHE_INSERT("salt peanuts"));
     txn->common_currency = NULL;
     txn->inst.kvp_data = NULL;
-    txn->date_entered = new_entered;
-    txn->date_posted = new_post;
+    txn->date_entered = new_entered.tv_sec;
+    txn->date_posted = new_post.tv_sec;
     txn->splits->data = split_01;
     txn->splits->next->data = split_00;
     qof_instance_set_dirty (QOF_INSTANCE (split_01));
@@ -1735,8 +1812,8 @@ test_xaccTransRollbackEdit (Fixture *fixture, gconstpointer pData)
     g_assert_cmpstr (txn->description, ==, "Waldo Pepper");
     g_assert (txn->inst.kvp_data == base_frame);
     g_assert (txn->common_currency == fixture->curr);
-    g_assert (timespec_equal (&(txn->date_posted), &orig_post));
-    g_assert (timespec_equal (&(txn->date_entered), &orig_entered));
+    g_assert_cmpint (txn->date_posted, ==, orig_post);
+    g_assert_cmpint (txn->date_entered, ==, orig_entered);
     g_assert_cmpuint (test_signal_return_hits (sig_account), ==, 1);
     g_assert_cmpuint (g_list_length (txn->splits), ==, 2);
     g_assert_cmpint (GPOINTER_TO_INT(split_02->memo), ==, 1);
@@ -1801,18 +1878,42 @@ test_xaccTransOrder_num_action (Fixture *fixture, gconstpointer pData)
                      qof_instance_guid_compare (txnA, txnB));
     txnB->description = static_cast<char*>(CACHE_INSERT ("Salt Peanuts"));
     g_assert_cmpint (xaccTransOrder_num_action (txnA, NULL, txnB, NULL), >=, 1);
-    txnB->date_entered.tv_sec += 1;
+    txnB->date_entered += 1;
     g_assert_cmpint (xaccTransOrder_num_action (txnA, NULL, txnB, NULL), ==, -1);
     txnB->num = static_cast<char*>(CACHE_INSERT ("101"));
     g_assert_cmpint (xaccTransOrder_num_action (txnA, NULL, txnB, NULL), ==, 1);
     txnB->num = static_cast<char*>(CACHE_INSERT ("one-oh-one"));
     g_assert_cmpint (xaccTransOrder_num_action (txnA, NULL, txnB, NULL), ==, 1);
     g_assert_cmpint (xaccTransOrder_num_action (txnA, "24", txnB, "42"), ==, -1);
-    txnB->date_posted.tv_sec -= 1;
+    txnB->date_posted -= 1;
     g_assert_cmpint (xaccTransOrder_num_action (txnA, "24", txnB, "42"), ==, 1);
 
     fixture->func->xaccFreeTransaction (txnB);
 }
+/* xaccTransGetSortNum
+gint
+xaccTransGetSortNum (const Transaction *trans)
+*/
+static void
+test_xaccTransGetSortNum (Fixture *fixture, gconstpointer pData)
+{
+    auto txn = xaccMallocTransaction (qof_instance_get_book (fixture->txn));
+
+    g_assert_cmpint (xaccTransGetSortNum (NULL), ==, 0);
+    g_assert_cmpint (xaccTransGetSortNum (txn), ==, 0);
+    xaccTransSetNum (txn, "42");
+    g_assert_cmpint (xaccTransGetSortNum (txn), ==, 42);
+    xaccTransSetNum (txn, "17b");
+    g_assert_cmpint (xaccTransGetSortNum (txn), ==, 17);
+    /* The cached number follows num even when it's replaced directly. */
+    CACHE_REMOVE (txn->num);
+    txn->num = static_cast<char*>(CACHE_INSERT ("7"));
+    g_assert_cmpint (xaccTransGetSortNum (txn), ==, 7);
+
+    xaccTransBeginEdit (txn);
+    xaccTransDestroy (txn);
+    xaccTransCommitEdit (txn);
+}
 /* xaccTransSetDateInternal Local: 7:0:0
  * set_gains_date_dirty Local: 4:0:0
  * xaccTransSetDatePostedSecs C: 17 in 13  Local: 0:0:0
@@ -1984,8 +2085,8 @@ test_xaccTransScrubGainsDate_no_dirty (GainsFixture *fixture,
 
     fixture->base.func->xaccTransScrubGainsDate (fixture->base.txn);
 
-    g_assert (!timespec_equal (&(fixture->base.txn->date_posted),
-                               &(fixture->gains_txn->date_posted)));
+    g_assert_cmpint (fixture->base.txn->date_posted, !=,
+                     fixture->gains_txn->date_posted);
     g_assert_cmphex (base_split->gains & GAINS_STATUS_DATE_DIRTY, ==, 0);
     g_assert_cmphex (base_split->gains_split->gains & GAINS_STATUS_DATE_DIRTY,
                      ==, 0);
@@ -2003,8 +2104,8 @@ test_xaccTransScrubGainsDate_base_dirty (GainsFixture *fixture,
 
     fixture->base.func->xaccTransScrubGainsDate (fixture->base.txn);
 
-    g_assert (timespec_equal (&(fixture->base.txn->date_posted),
-                              &(fixture->gains_txn->date_posted)));
+    g_assert_cmpint (fixture->base.txn->date_posted, ==,
+                     fixture->gains_txn->date_posted);
     g_assert_cmphex (base_split->gains & GAINS_STATUS_DATE_DIRTY, ==, 0);
     g_assert_cmphex (base_split->gains_split->gains & GAINS_STATUS_DATE_DIRTY,
                      ==, 0);
@@ -2022,8 +2123,8 @@ test_xaccTransScrubGainsDate_gains_dirty (GainsFixture *fixture,
 
     fixture->base.func->xaccTransScrubGainsDate (fixture->base.txn);
 
-    g_assert (timespec_equal (&(fixture->base.txn->date_posted),
-                              &(fixture->gains_txn->date_posted)));
+    g_assert_cmpint (fixture->base.txn->date_posted, ==,
+                     fixture->gains_txn->date_posted);
     g_assert_cmphex (base_split->gains & GAINS_STATUS_DATE_DIRTY, ==, 0);
     g_assert_cmphex (base_split->gains_split->gains & GAINS_STATUS_DATE_DIRTY,
                      ==, 0);
@@ -2066,6 +2167,7 @@ test_suite_transaction (void)
     GNC_TEST_ADD (suitename, "xaccTransGetImbalanceValue", Fixture, NULL, setup, test_xaccTransGetImbalanceValue, teardown);
     GNC_TEST_ADD (suitename, "xaccTransGetImbalance", Fixture, NULL, setup, test_xaccTransGetImbalance, teardown);
     GNC_TEST_ADD (suitename, "xaccTransGetImbalance Trading Accounts", Fixture, NULL, setup, test_xaccTransGetImbalance_trading, teardown);
+    GNC_TEST_ADD (suitename, "xaccTransGetImbalanceValue cache", Fixture, NULL, setup, test_xaccTransGetImbalanceValue_cache, teardown);
     GNC_TEST_ADD (suitename, "xaccTransIsBalanced", Fixture, NULL, setup, test_xaccTransIsBalanced, teardown);
     GNC_TEST_ADD (suitename, "xaccTransIsBalanced Trading Accounts", Fixture, NULL, setup, test_xaccTransIsBalanced_trading, teardown);
     GNC_TEST_ADD (suitename, "xaccTransGetAccountValue", Fixture, NULL, setup, test_xaccTransGetAccountValue, teardown);
@@ -2083,9 +2185,11 @@ test_suite_transaction (void)
     GNC_TEST_ADD (suitename, "trans on error", Fixture, NULL, setup, test_trans_on_error, teardown);
     GNC_TEST_ADD (suitename, "trans cleanup commit", Fixture, NULL, setup, test_trans_cleanup_commit, teardown);
     GNC_TEST_ADD_FUNC (suitename, "xaccTransCommitEdit", test_xaccTransCommitEdit);
+    GNC_TEST_ADD (suitename, "xaccTransCommitEdit unchanged", Fixture, NULL, setup, test_xaccTransCommitEdit_unchanged, teardown);
     GNC_TEST_ADD (suitename, "xaccTransRollbackEdit", Fixture, NULL, setup, test_xaccTransRollbackEdit, teardown);
     GNC_TEST_ADD (suitename, "xaccTransRollbackEdit - Backend Errors", Fixture, NULL, setup, test_xaccTransRollbackEdit_BackendErrors, teardown);
     GNC_TEST_ADD (suitename, "xaccTransOrder_num_action", Fixture, NULL, setup, test_xaccTransOrder_num_action, teardown);
+    GNC_TEST_ADD (suitename, "xaccTransGetSortNum", Fixture, NULL, setup, test_xaccTransGetSortNum, teardown);
     GNC_TEST_ADD (suitename, "xaccTransGetTxnType", Fixture, NULL, setup, test_xaccTransGetTxnType, teardown);
     GNC_TEST_ADD (suitename, "xaccTransVoid", Fixture, NULL, setup, test_xaccTransVoid, teardown);
     GNC_TEST_ADD (suitename, "xaccTransReverse", Fixture, NULL, setup, test_xaccTransReverse, teardown);
@@ -54,6 +54,9 @@ static QofLogModule log_module = G_LOG_DOMAIN;
 #define GNC_PREF_NEW_SEARCH_LIMIT  "new-search-limit"
 #define GNC_PREF_ACTIVE_ONLY       "search-for-active-only"
 
+/* Results are shown this many at a time while the rest are added */
+#define SEARCH_RESULT_CHUNK_ROWS   200
+
 typedef enum
 {
     GNC_SEARCH_MATCH_ALL = 0,
@@ -295,7 +298,8 @@ gnc_search_dialog_init_result_view (GNCSearchWindow *sw)
 {
     GtkTreeSelection *selection;
 
-    sw->result_view = gnc_query_view_new(sw->display_list, sw->q);
+    sw->result_view = gnc_query_view_new_incremental (sw->display_list, sw->q,
+                                                      SEARCH_RESULT_CHUNK_ROWS);
 
     // We want the multi-selection mode of the tree view.
     selection = gtk_tree_view_get_selection(GTK_TREE_VIEW(sw->result_view));
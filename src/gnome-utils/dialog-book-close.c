@@ -28,12 +28,14 @@
 
 #include <gtk/gtk.h>
 #include <glib/gi18n.h>
+#include <string.h>
 
 #include "dialog-utils.h"
 #include "gnc-engine.h"
 #include "Transaction.h"
 #include "Split.h"
 #include "Account.h"
+#include "Period.h"
 #include "gnc-ui.h"
 #include "gnc-gui-query.h"
 #include "dialog-book-close.h"
@@ -41,6 +43,7 @@
 #include "gnc-component-manager.h"
 #include "gnc-date-edit.h"
 #include "gnc-session.h"
+#include "gnc-uri-utils.h"
 #include "app-utils/gnc-ui-util.h"
 
 #define DIALOG_BOOK_CLOSE_CM_CLASS "dialog-book-close"
@@ -61,6 +64,7 @@ struct CloseBookWindow
     GtkWidget* income_acct_widget;
     GtkWidget* expense_acct_widget;
     GtkWidget* desc_widget;
+    GtkWidget* archive_widget;
 
     /* The final settings */
     time64 close_date;
@@ -247,6 +251,85 @@ static void close_accounts_of_type(struct CloseBookWindow* cbw,
     g_hash_table_destroy(cacb.txns);
 }
 
+/* The archive goes next to the book, as BOOK-archive.gnucash, unless
+ * the book already has one. */
+static gchar* archive_uri(QofBook* book)
+{
+    const char* uri = gnc_book_get_archive_uri(book);
+    gchar *protocol, *path, *archive_path, *result;
+    QofSession* session = gnc_get_current_session();
+
+    if (uri)
+        return g_strdup(uri);
+
+    uri = qof_session_get_url(session);
+    if (!uri || !gnc_uri_is_file_uri(uri))
+        return NULL;
+
+    protocol = gnc_uri_get_protocol(uri);
+    path = gnc_uri_get_path(uri);
+    if (g_str_has_suffix(path, GNC_DATAFILE_EXT))
+        path[strlen(path) - strlen(GNC_DATAFILE_EXT)] = '\0';
+    archive_path = g_strconcat(path, "-archive", GNC_DATAFILE_EXT, NULL);
+    result = gnc_uri_create_uri(protocol, NULL, 0, NULL, NULL, archive_path);
+    g_free(archive_path);
+    g_free(path);
+    g_free(protocol);
+    return result;
+}
+
+static void archive_period(struct CloseBookWindow* cbw)
+{
+    QofSession* session;
+    Account* equity;
+    gchar* uri;
+    time64 before;
+    gboolean create;
+    gint moved;
+
+    uri = archive_uri(cbw->book);
+    if (!uri)
+    {
+        gnc_error_dialog(cbw->dialog, "%s",
+                         _("Only books saved in a file can be archived."));
+        return;
+    }
+
+    /* Everything up to the end of the closing day, which takes the
+     * closing transactions along. */
+    before = gnc_time64_get_day_end(cbw->close_date) + 1;
+    create = !gnc_book_get_archive_uri(cbw->book);
+
+    session = qof_session_new();
+    qof_session_begin(session, uri, FALSE, create, create);
+    if (!create && qof_session_get_error(session) == ERR_BACKEND_NO_ERR)
+        qof_session_load(session, NULL);
+    if (qof_session_get_error(session) != ERR_BACKEND_NO_ERR)
+    {
+        gnc_error_dialog(cbw->dialog, _("Could not open the archive %s: %s"),
+                         uri, qof_session_get_error_message(session));
+        qof_session_destroy(session);
+        g_free(uri);
+        return;
+    }
+
+    equity = gnc_find_or_create_equity_account(
+                 gnc_book_get_root_account(cbw->book), EQUITY_OPENING_BALANCE,
+                 gnc_default_currency());
+    moved = gnc_book_archive_period(cbw->book, session, before, equity,
+                                    _("Archived Balances"));
+    PINFO("moved %d transactions to %s", moved, uri);
+    if (moved >= 0)
+        gnc_book_set_archive(cbw->book, uri, MAX(before,
+                             gnc_book_get_archive_date(cbw->book)));
+    else
+        gnc_error_dialog(cbw->dialog, _("Could not save the archive %s: %s"),
+                         uri, qof_session_get_error_message(session));
+    qof_session_end(session);
+    qof_session_destroy(session);
+    g_free(uri);
+}
+
 static void close_handler(gpointer data)
 {
     GtkWidget *dialog = data;
@@ -312,6 +395,8 @@ gnc_book_close_response_cb(GtkDialog *dialog, gint response, GtkDialog *unused)
         gnc_suspend_gui_refresh();
         close_accounts_of_type(cbw, income_acct, ACCT_TYPE_INCOME);
         close_accounts_of_type(cbw, expense_acct, ACCT_TYPE_EXPENSE);
+        if (gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(cbw->archive_widget)))
+            archive_period(cbw);
         gnc_resume_gui_refresh();
 
         /* FALL THROUGH */
@@ -367,6 +452,9 @@ void gnc_ui_close_book (QofBook* book)
     /* desc */
     cbw->desc_widget = GTK_WIDGET(gtk_builder_get_object (builder, "desc_entry"));
 
+    /* archive */
+    cbw->archive_widget = GTK_WIDGET(gtk_builder_get_object (builder, "archive_check"));
+
     /* Autoconnect signals */
     gtk_builder_connect_signals_full (builder, gnc_builder_connect_full_func, cbw->dialog);
 
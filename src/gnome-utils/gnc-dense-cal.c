@@ -309,6 +309,7 @@ gnc_dense_cal_init(GncDenseCal *dcal)
     dcal->markData = NULL;
     dcal->numMarks = 0;
     dcal->marks = NULL;
+    dcal->marksFrozen = 0;
     dcal->lastMarkTag = 0;
 
     dcal->showPopup = FALSE;
@@ -1715,9 +1716,9 @@ static void
 gdc_add_tag_markings(GncDenseCal *cal, guint tag)
 {
     gchar *name, *info;
-    gint num_marks, idx;
+    gint num_marks, num_dates, idx;
     GDate **dates;
-    GDate *calDate;
+    GDate calDate, endDate;
 
     // copy the values into the old marking function.
     name = gnc_dense_cal_model_get_name(cal->model, tag);
@@ -1727,43 +1728,53 @@ gdc_add_tag_markings(GncDenseCal *cal, guint tag)
     if (num_marks == 0)
         goto cleanup;
 
-    dates = g_new0(GDate*, num_marks);
-    calDate = g_date_new_dmy(1, cal->month, cal->year);
+    g_date_clear(&calDate, 1);
+    g_date_set_dmy(&calDate, 1, cal->month, cal->year);
+    endDate = calDate;
+    g_date_add_months(&endDate, cal->numMonths);
 
+    /* The instances come in date order, so only fetch those up to the
+     * end of the visible months. */
+    dates = g_new0(GDate*, num_marks);
+    num_dates = 0;
     for (idx = 0; idx < num_marks; idx++)
     {
-        dates[idx] = g_date_new();
-        gnc_dense_cal_model_get_instance(cal->model, tag, idx, dates[idx]);
-
-    }
-    if (g_date_valid(dates[0]))
-    {
-        if (g_date_get_julian(dates[0]) < g_date_get_julian(calDate))
+        dates[num_dates] = g_date_new();
+        gnc_dense_cal_model_get_instance(cal->model, tag, idx, dates[num_dates]);
+        if (g_date_valid(dates[num_dates])
+                && g_date_compare(dates[num_dates], &endDate) >= 0)
         {
-            /* Oops, first marking is earlier than months displayed.
-             * Choose new first month and recalculate all markings for all
-             * tags. Their offsets are all wrong with the newly added month(s).
-             */
-            _gnc_dense_cal_set_month(cal, g_date_get_month(dates[0]), FALSE);
-            _gnc_dense_cal_set_year(cal, g_date_get_year(dates[0]), FALSE);
-
-            gdc_remove_markings (cal);
-            gdc_add_markings (cal);
+            g_date_free(dates[num_dates]);
+            break;
         }
-        else
-            gdc_mark_add(cal, tag, name, info, num_marks, dates);
+        num_dates++;
     }
-    else
+
+    if (num_dates > 0 && !g_date_valid(dates[0]))
     {
         g_warning("Bad date, skipped.");
     }
+    else if (num_dates > 0
+             && g_date_get_julian(dates[0]) < g_date_get_julian(&calDate))
+    {
+        /* Oops, first marking is earlier than months displayed.
+         * Choose new first month and recalculate all markings for all
+         * tags. Their offsets are all wrong with the newly added month(s).
+         */
+        _gnc_dense_cal_set_month(cal, g_date_get_month(dates[0]), FALSE);
+        _gnc_dense_cal_set_year(cal, g_date_get_year(dates[0]), FALSE);
 
-    for (idx = 0; idx < num_marks; idx++)
+        gdc_remove_markings (cal);
+        gdc_add_markings (cal);
+    }
+    else
+        gdc_mark_add(cal, tag, name, info, num_dates, dates);
+
+    for (idx = 0; idx < num_dates; idx++)
     {
         g_date_free(dates[idx]);
     }
     g_free(dates);
-    g_date_free(calDate);
 
 cleanup:
     g_free(info);
@@ -1772,14 +1783,24 @@ cleanup:
 static void
 gdc_add_markings(GncDenseCal *cal)
 {
-    GList *tags;
+    GList *tags, *node;
     tags = gnc_dense_cal_model_get_contained(cal->model);
-    for (; tags != NULL; tags = tags->next)
+
+    /* Redraw once for the whole model rather than once per tag. */
+    cal->marksFrozen++;
+    for (node = tags; node != NULL; node = node->next)
     {
-        guint tag = GPOINTER_TO_UINT(tags->data);
+        guint tag = GPOINTER_TO_UINT(node->data);
         gdc_add_tag_markings(cal, tag);
     }
+    cal->marksFrozen--;
     g_list_free(tags);
+
+    if (cal->marksFrozen == 0)
+    {
+        gnc_dense_cal_draw_to_buffer(cal);
+        gtk_widget_queue_draw(GTK_WIDGET(cal->cal_drawing_area));
+    }
 }
 
 static void
@@ -1855,12 +1876,6 @@ gdc_mark_add(GncDenseCal *dcal,
     gdc_mark_data *newMark;
     GDate *d;
 
-    if (size == 0)
-    {
-        g_error("0 size not allowed\n");
-        return;
-    }
-
     newMark = g_new0(gdc_mark_data, 1);
     newMark->name = NULL;
     if (name)
@@ -1885,10 +1900,14 @@ gdc_mark_add(GncDenseCal *dcal,
             break;
         }
         dcal->marks[doc] = g_list_append(dcal->marks[doc], newMark);
-        newMark->ourMarks = g_list_append(newMark->ourMarks,
-                                          GINT_TO_POINTER(doc));
+        newMark->ourMarks = g_list_prepend(newMark->ourMarks,
+                                           GINT_TO_POINTER(doc));
     }
-    dcal->markData = g_list_append(dcal->markData, (gpointer)newMark);
+    dcal->markData = g_list_prepend(dcal->markData, (gpointer)newMark);
+
+    if (dcal->marksFrozen > 0)
+        return;
+
     gnc_dense_cal_draw_to_buffer(dcal);
     gtk_widget_queue_draw(GTK_WIDGET(dcal->cal_drawing_area));
 }
@@ -103,6 +103,9 @@ struct _GncDenseCal
     int numMarks;
     /* array of GList*s of per-cell markings. */
     GList **marks;
+    /* > 0 while a batch of markings is added; the calendar is
+     * redrawn once at the end of the batch. */
+    gint marksFrozen;
 
     int disposed; /* private */
 };
@@ -622,6 +622,181 @@ gnc_file_query_save (gboolean can_cancel)
 }
 
 
+/* Loading or saving a big book takes a while, so the backend does it in
+ * a thread of its own while the main loop keeps running.  The session
+ * worked on is not the current one yet, or its book is held still by
+ * the insensitive main window, and events are suspended, so nothing
+ * else touches its data meanwhile.  As with the progress bar itself,
+ * there is only ever one such job. */
+typedef void (*GncFileSessionFunc) (QofSession *session,
+                                    QofPercentageFunc percentage_func);
+
+typedef struct
+{
+    QofSession *session;
+    GncFileSessionFunc func;
+    GMainLoop *loop;
+    GMutex lock;
+    gchar *message;     /* Set by the backend, protected by lock */
+    double percentage;  /* Set by the backend, protected by lock */
+    gboolean changed;   /* Protected by lock */
+} GncFileJob;
+
+static GncFileJob *file_job = NULL;
+
+/* Called from the job's thread. */
+static void
+gnc_file_job_progress (const char *message, double percentage)
+{
+    g_mutex_lock (&file_job->lock);
+    if (message)
+    {
+        g_free (file_job->message);
+        file_job->message = g_strdup (message);
+    }
+    file_job->percentage = percentage;
+    file_job->changed = TRUE;
+    g_mutex_unlock (&file_job->lock);
+}
+
+static gboolean
+gnc_file_job_show_progress (gpointer user_data)
+{
+    GncFileJob *job = user_data;
+    gchar *message;
+    double percentage;
+
+    g_mutex_lock (&job->lock);
+    if (!job->changed)
+    {
+        g_mutex_unlock (&job->lock);
+        return TRUE;
+    }
+    message = job->message;
+    job->message = NULL;
+    percentage = job->percentage;
+    job->changed = FALSE;
+    g_mutex_unlock (&job->lock);
+
+    /* A percentage below 0 would end the progress display. */
+    gnc_window_show_progress (message, MAX (percentage, 0.0));
+    g_free (message);
+    return TRUE;
+}
+
+static gboolean
+gnc_file_job_finished (gpointer user_data)
+{
+    GncFileJob *job = user_data;
+
+    g_main_loop_quit (job->loop);
+    return FALSE;
+}
+
+static gpointer
+gnc_file_job_thread (gpointer user_data)
+{
+    GncFileJob *job = user_data;
+
+    job->func (job->session, gnc_file_job_progress);
+    g_idle_add (gnc_file_job_finished, job);
+    return NULL;
+}
+
+/* Runs func on session in a thread, showing message and the progress of
+ * the backend until it is done. */
+static void
+gnc_file_run_session_job (QofSession *session, GncFileSessionFunc func,
+                          const char *message)
+{
+    GncFileJob job;
+    GThread *thread;
+    guint source;
+
+    g_return_if_fail (file_job == NULL);
+
+    /* Quitting waits until the job is done. */
+    save_in_progress++;
+    gnc_window_show_progress (message, 0.0);
+
+    memset (&job, 0, sizeof (job));
+    job.session = session;
+    job.func = func;
+    job.loop = g_main_loop_new (NULL, FALSE);
+    g_mutex_init (&job.lock);
+    file_job = &job;
+
+    source = g_timeout_add (100, gnc_file_job_show_progress, &job);
+    thread = g_thread_new ("gnc-file-job", gnc_file_job_thread, &job);
+    g_main_loop_run (job.loop);
+    g_thread_join (thread);
+    g_source_remove (source);
+
+    file_job = NULL;
+    g_mutex_clear (&job.lock);
+    g_main_loop_unref (job.loop);
+    g_free (job.message);
+
+    gnc_window_show_progress (NULL, -1.0);
+    save_in_progress--;
+}
+
+
+/* The conversion of import map entries from account full names to guids
+ * runs while the main loop is idle, so that opening a book with large
+ * Bayesian maps doesn't wait for it. */
+#define IMAP_CONVERSION_ACCOUNTS 25
+
+static GncImapBayesConversion *imap_conversion = NULL;
+static guint imap_conversion_source = 0;
+
+static gboolean
+gnc_file_imap_conversion_step (gpointer data)
+{
+    gboolean more;
+
+    qof_event_suspend();
+    more = gnc_account_imap_convert_bayes_step (imap_conversion,
+                                                IMAP_CONVERSION_ACCOUNTS);
+    qof_event_resume();
+    if (!more)
+    {
+        imap_conversion = NULL;
+        imap_conversion_source = 0;
+    }
+    return more;
+}
+
+static void
+gnc_file_imap_conversion_stop (gpointer session, gpointer user_data)
+{
+    if (imap_conversion_source)
+        g_source_remove (imap_conversion_source);
+    gnc_account_imap_convert_bayes_cancel (imap_conversion);
+    imap_conversion = NULL;
+    imap_conversion_source = 0;
+}
+
+static void
+gnc_file_imap_conversion_start (QofBook *book)
+{
+    static gboolean hooked = FALSE;
+
+    gnc_file_imap_conversion_stop (NULL, NULL);
+    imap_conversion = gnc_account_imap_convert_bayes_start (book);
+    if (!imap_conversion)
+        return;
+
+    if (!hooked)
+    {
+        gnc_hook_add_dangler (HOOK_BOOK_CLOSED,
+                              gnc_file_imap_conversion_stop, NULL);
+        hooked = TRUE;
+    }
+    imap_conversion_source = g_idle_add (gnc_file_imap_conversion_step, NULL);
+}
+
+
 /* private utilities for file open; done in two stages */
 
 #define RESPONSE_NEW  1
@@ -861,9 +1036,8 @@ RESTART:
                                        path, username, password );
 
         xaccLogDisable();
-        gnc_window_show_progress(_("Loading user data..."), 0.0);
-        qof_session_load (new_session, gnc_window_show_progress);
-        gnc_window_show_progress(NULL, -1.0);
+        gnc_file_run_session_job (new_session, qof_session_load,
+                                  _("Loading user data..."));
         xaccLogEnable();
 
         if (is_readonly)
@@ -881,9 +1055,8 @@ RESTART:
             if (gnc_xml_convert_single_file (newfile))
             {
                 /* try to load once again */
-                gnc_window_show_progress(_("Loading user data..."), 0.0);
-                qof_session_load (new_session, gnc_window_show_progress);
-                gnc_window_show_progress(NULL, -1.0);
+                gnc_file_run_session_job (new_session, qof_session_load,
+                                          _("Loading user data..."));
                 xaccLogEnable();
                 io_err = qof_session_get_error (new_session);
             }
@@ -897,8 +1070,8 @@ RESTART:
         /* Attempt to update the database if it's too old */
         if ( !uh_oh && io_err == ERR_SQL_DB_TOO_OLD )
         {
-            gnc_window_show_progress(_("Re-saving user data..."), 0.0);
-            qof_session_safe_save(new_session, gnc_window_show_progress);
+            gnc_file_run_session_job (new_session, qof_session_safe_save,
+                                      _("Re-saving user data..."));
             io_err = qof_session_get_error(new_session);
             uh_oh = show_session_error(io_err, newfile, GNC_FILE_DIALOG_SAVE);
         }
@@ -1001,9 +1174,7 @@ RESTART:
     }
 
     // Convert imap mappings from account full name to guid strings
-    qof_event_suspend();
-    gnc_account_imap_convert_bayes (gnc_get_current_book());
-    qof_event_resume();
+    gnc_file_imap_conversion_start (gnc_get_current_book());
 
     return TRUE;
 }
@@ -1258,8 +1429,8 @@ gnc_file_do_export(const char * filename)
 
 static gboolean been_here_before = FALSE;
 
-void
-gnc_file_save (void)
+static void
+gnc_file_save_session (gboolean in_background)
 {
     QofBackendError io_err;
     const char * newfile;
@@ -1294,7 +1465,11 @@ gnc_file_save (void)
     save_in_progress++;
     gnc_set_busy_cursor (NULL, TRUE);
     gnc_window_show_progress(_("Writing file..."), 0.0);
-    qof_session_save (session, gnc_window_show_progress);
+    if (in_background)
+        qof_session_save_in_background (session, gnc_window_show_progress);
+    else
+        qof_session_save (session, gnc_window_show_progress);
+    xaccLogSync ();
     gnc_window_show_progress(NULL, -1.0);
     gnc_unset_busy_cursor (NULL);
     save_in_progress--;
@@ -1320,6 +1495,18 @@ gnc_file_save (void)
     LEAVE (" ");
 }
 
+void
+gnc_file_save (void)
+{
+    gnc_file_save_session (FALSE);
+}
+
+void
+gnc_file_autosave (void)
+{
+    gnc_file_save_session (TRUE);
+}
+
 /* Note: this dialog will only be used when dbi is not enabled
  *       paths used in it always refer to files and are
  *       never db uris. See gnc_file_do_save_as for that.
@@ -1527,9 +1714,8 @@ gnc_file_do_save_as (const char* filename)
 
 
     gnc_set_busy_cursor (NULL, TRUE);
-    gnc_window_show_progress(_("Writing file..."), 0.0);
-    qof_session_save (new_session, gnc_window_show_progress);
-    gnc_window_show_progress(NULL, -1.0);
+    gnc_file_run_session_job (new_session, qof_session_save,
+                              _("Writing file..."));
     gnc_unset_busy_cursor (NULL);
 
     io_err = qof_session_get_error( new_session );
@@ -1606,6 +1792,7 @@ gnc_file_quit (void)
     gnc_hook_run(HOOK_BOOK_CLOSED, session);
     gnc_close_gui_component_by_session (session);
     gnc_state_save (session);
+    xaccLogSync ();
     gnc_clear_current_session();
 
     qof_event_resume ();
@@ -47,8 +47,31 @@ struct _GNCQueryViewPriv
 {
     const QofParam *get_guid;
     gint	    component_id;
+
+    /* The sort keys of the entries in the view, for the sort column */
+    GHashTable     *sort_keys;
+    const char     *key_type;
+
+    /* The entries still to be added when filling incrementally */
+    gint            chunk_rows;
+    guint           fill_id;
+    QofCollection  *fill_col;
+    GArray         *fill_guids;
+    guint           fill_next;
 };
 
+/* The sort key of an entry, computed once when the entry is added or
+ * the sort column changes, so that sorting the view neither runs the
+ * query again nor calls the parameter getters for every comparison. */
+typedef struct
+{
+    guint        position;  /* in the query results, ranks equal keys */
+    gchar       *text;      /* collation key of string-like columns */
+    gnc_numeric  number;    /* numeric and debit/credit columns */
+    gint64       integer;   /* date, integer, character and boolean */
+    gdouble      real;      /* double columns */
+} GNCQueryViewKey;
+
 #define GNC_QUERY_VIEW_GET_PRIVATE(o)  \
    (G_TYPE_INSTANCE_GET_PRIVATE ((o), GNC_TYPE_QUERY_VIEW, GNCQueryViewPriv))
 
@@ -70,6 +93,9 @@ static void gnc_query_view_double_click_cb (GtkTreeView *tree_view,
 
 static void gnc_query_view_destroy (GtkObject *object);
 static void gnc_query_view_fill (GNCQueryView *qview);
+static void gnc_query_view_stop_fill (GNCQueryView *qview);
+static void gnc_query_view_set_keys (GNCQueryView *qview);
+static void gnc_query_view_free_key (gpointer data);
 static void gnc_query_view_set_query_sort (GNCQueryView *qview, gboolean new_column);
 
 
@@ -133,10 +159,28 @@ gnc_query_view_construct (GNCQueryView *qview, GList *param_list, Query *query)
 
     /* Set initial sort order */
     gnc_query_view_set_query_sort (qview, TRUE);
+    gnc_query_view_refresh (qview);
 }
 
 GtkWidget *
 gnc_query_view_new (GList *param_list, Query *query)
+{
+    return gnc_query_view_new_incremental (param_list, query, 0);
+}
+
+/********************************************************************\
+ * gnc_query_view_new_incremental                                   *
+ *   creates a query view which adds its entries a chunk at a time  *
+ *                                                                  *
+ * Args: param_list - the list of params                            *
+ *       query      - the query to use to find entries              *
+ *       chunk_rows - the number of entries to add at a time, or 0  *
+ *                    to add them all at once                       *
+ * Returns: the query view widget, or NULL if there was a problem.  *
+\********************************************************************/
+GtkWidget *
+gnc_query_view_new_incremental (GList *param_list, Query *query,
+                                gint chunk_rows)
 {
     GNCQueryView  *qview;
     GtkListStore  *liststore;
@@ -180,6 +224,7 @@ gnc_query_view_new (GList *param_list, Query *query)
     /* Free array */
     g_slice_free1( array_size, types );
 
+    GNC_QUERY_VIEW_GET_PRIVATE (qview)->chunk_rows = MAX (chunk_rows, 0);
     gnc_query_view_construct (qview, param_list, query);
 
     return GTK_WIDGET (qview);
@@ -196,6 +241,7 @@ void gnc_query_view_reset_query (GNCQueryView *qview, Query *query)
     qview->query = qof_query_copy (query);
 
     gnc_query_view_set_query_sort (qview, TRUE);
+    gnc_query_view_refresh (qview);
 }
 
 
@@ -207,6 +253,7 @@ gnc_query_view_refresh_handler (GHashTable *changes, gpointer user_data)
     g_return_if_fail (GNC_IS_QUERY_VIEW (qview));
 
     gnc_query_view_set_query_sort (qview, TRUE);
+    gnc_query_view_refresh (qview);
 }
 
 
@@ -227,6 +274,8 @@ gnc_query_view_init (GNCQueryView *qview)
     qview->numeric_inv_sort = FALSE;
 
     priv = GNC_QUERY_VIEW_GET_PRIVATE (qview);
+    priv->sort_keys = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                             NULL, gnc_query_view_free_key);
     priv->component_id =
         gnc_register_gui_component ("gnc-query-view-cm-class",
                                     gnc_query_view_refresh_handler,
@@ -240,8 +289,45 @@ sort_iter_compare_func (GtkTreeModel *model,
                           GtkTreeIter  *b,
                           gpointer      userdata)
 {
-    /* This is really a dummy sort function, it leaves the list as is. */
-    return 0;
+    GNCQueryView     *qview = GNC_QUERY_VIEW (userdata);
+    GNCQueryViewPriv *priv = GNC_QUERY_VIEW_GET_PRIVATE (qview);
+    const GNCQueryViewKey *ka, *kb;
+    gpointer          entry_a = NULL, entry_b = NULL;
+    const char       *type = priv->key_type;
+    gint              result = 0;
+
+    if (!priv->sort_keys)
+        return 0;
+
+    gtk_tree_model_get (model, a, 0, &entry_a, -1);
+    gtk_tree_model_get (model, b, 0, &entry_b, -1);
+    ka = g_hash_table_lookup (priv->sort_keys, entry_a);
+    kb = g_hash_table_lookup (priv->sort_keys, entry_b);
+
+    /* A row being added has no entry yet */
+    if (!ka || !kb)
+        return 0;
+
+    if (!type)
+        result = 0;
+    else if (!g_strcmp0 (type, QOF_TYPE_NUMERIC) ||
+             !g_strcmp0 (type, QOF_TYPE_DEBCRED))
+    {
+        result = gnc_numeric_compare (ka->number, kb->number);
+        if (qview->numeric_inv_sort)
+            result = -result;
+    }
+    else if (!g_strcmp0 (type, QOF_TYPE_DOUBLE))
+        result = (ka->real > kb->real) - (ka->real < kb->real);
+    else if (ka->text || kb->text)
+        result = g_strcmp0 (ka->text, kb->text);
+    else
+        result = (ka->integer > kb->integer) - (ka->integer < kb->integer);
+
+    if (result == 0)
+        result = (ka->position > kb->position) - (ka->position < kb->position);
+
+    return result;
 }
 
 
@@ -302,7 +388,13 @@ gnc_query_sort_cb (GtkTreeSortable *sortable, gpointer user_data)
     /* Save the column */
     qview->sort_column = sortcol;
 
-    gnc_query_view_set_query_sort (qview, new_column);
+    /* The list store sorts itself when this returns, so only the keys
+     * of a new column need computing; the query is not run again. */
+    if (new_column)
+    {
+        gnc_query_view_set_query_sort (qview, TRUE);
+        gnc_query_view_set_keys (qview);
+    }
 }
 
 
@@ -362,7 +454,7 @@ gnc_query_view_init_view (GNCQueryView *qview)
             /* Add sortable columns */
             gtk_tree_view_column_set_sort_column_id (col, i+1);
             gtk_tree_sortable_set_sort_func (sortable, i+1, sort_iter_compare_func,
-                                    GINT_TO_POINTER (i+1), NULL);
+                                    view, NULL);
 	}
 
         type = gnc_search_param_get_param_type (((GNCSearchParam *) param));
@@ -577,11 +669,17 @@ gnc_query_view_destroy (GtkObject *object)
     GNCQueryViewPriv *priv;
 
     priv = GNC_QUERY_VIEW_GET_PRIVATE (qview);
+    gnc_query_view_stop_fill (qview);
     if (priv->component_id > 0)
     {
         gnc_unregister_gui_component (priv->component_id);
         priv->component_id = 0;
     }
+    if (priv->sort_keys)
+    {
+        g_hash_table_destroy (priv->sort_keys);
+        priv->sort_keys = NULL;
+    }
     /* Free the selected entry list */
     if (qview->selected_entry_list)
     {
@@ -688,9 +786,13 @@ gnc_query_view_refresh (GNCQueryView *qview)
     g_return_if_fail (qview != NULL);
     g_return_if_fail (GNC_IS_QUERY_VIEW (qview));
 
+    gnc_query_view_stop_fill (qview);
+
     old_entry = qview->selected_entry_list;
     model = gtk_tree_view_get_model (GTK_TREE_VIEW (qview));
     gtk_list_store_clear (GTK_LIST_STORE (model));
+    if (GNC_QUERY_VIEW_GET_PRIVATE (qview)->sort_keys)
+        g_hash_table_remove_all (GNC_QUERY_VIEW_GET_PRIVATE (qview)->sort_keys);
 
     qview->num_entries = 0;
     qview->selected_entry = NULL;
@@ -706,17 +808,20 @@ gnc_query_view_refresh (GNCQueryView *qview)
 
 /********************************************************************\
  * gnc_query_view_set_query_sort                                    *
- *   sets the sorting order of entries in the view                  *
+ *   sets the sorting order of the query on the sort column         *
+ *                                                                  *
+ * The view sorts its rows itself, by the keys of the sort column,  *
+ * and only uses the order of the query results to rank entries     *
+ * with equal keys.  So the query is always sorted increasing.      *
  *                                                                  *
  * Args: qview      - view to change the sort order for             *
  *	 new_column - is this a new column (so should we set the    *
- *                    query sort order or just set the 'increasing' *
+ *                    query sort order)                             *
  * Returns: nothing                                                 *
 \********************************************************************/
 static void
 gnc_query_view_set_query_sort (GNCQueryView *qview, gboolean new_column)
 {
-    gboolean        sort_order = qview->increasing;
     GList          *node;
     GNCSearchParamSimple *param;
 
@@ -725,17 +830,6 @@ gnc_query_view_set_query_sort (GNCQueryView *qview, gboolean new_column)
     param = node->data;
     g_assert (GNC_IS_SEARCH_PARAM_SIMPLE (param));
 
-    /* If we're asked to invert numerics, and if this is a numeric or
-     * debred column, then invert the sort order.
-     */
-    if (qview->numeric_inv_sort)
-    {
-        const char *type = gnc_search_param_get_param_type ((GNCSearchParam *) param);
-        if (!g_strcmp0(type, QOF_TYPE_NUMERIC) ||
-                !g_strcmp0(type, QOF_TYPE_DEBCRED))
-            sort_order = !sort_order;
-    }
-
     /* Set the sort order for the engine, if the key changed */
     if (new_column)
     {
@@ -746,110 +840,341 @@ gnc_query_view_set_query_sort (GNCQueryView *qview, gboolean new_column)
         qof_query_set_sort_order (qview->query, p1, p2, NULL);
     }
 
-    qof_query_set_sort_increasing (qview->query,
-                                   sort_order,
-                                   sort_order,
-                                   sort_order);
+    qof_query_set_sort_increasing (qview->query, TRUE, TRUE, TRUE);
+}
+
 
-    gnc_query_view_refresh (qview);
+static void
+gnc_query_view_free_key (gpointer data)
+{
+    GNCQueryViewKey *key = data;
+
+    g_free (key->text);
+    g_free (key);
 }
 
 
 /********************************************************************\
- * gnc_query_view_fill                                              *
- *   Add all items to the list store                                *
+ * gnc_query_view_compute_key                                       *
+ *   computes the sort key of an entry for a column                 *
  *                                                                  *
- * Args: qview - view to add item to                                *
+ * Args: param - the column parameter                               *
+ *       entry - the entry                                          *
+ *       key   - the key to fill in                                 *
  * Returns: nothing                                                 *
 \********************************************************************/
 static void
-gnc_query_view_fill (GNCQueryView *qview)
+gnc_query_view_compute_key (GNCSearchParamSimple *param, gpointer entry,
+                            GNCQueryViewKey *key)
 {
-    GNCQueryViewPriv *priv;
+    const char *type = gnc_search_param_get_param_type ((GNCSearchParam *) param);
+    GSList     *converters;
+    gpointer    res = entry;
+    QofParam   *qp = NULL;
+
+    g_free (key->text);
+    key->text = NULL;
+    key->number = gnc_numeric_zero ();
+    key->integer = 0;
+    key->real = 0.0;
+
+    if (g_strcmp0 (type, QOF_TYPE_BOOLEAN) == 0)
+    {
+        key->integer = GPOINTER_TO_INT (gnc_search_param_compute_value (param, entry));
+        return;
+    }
+
+    /* Do all the object conversions */
+    for (converters = gnc_search_param_get_converters (param); converters;
+            converters = converters->next)
+    {
+        qp = converters->data;
+        if (converters->next)
+            res = (qp->param_getfcn)(res, qp);
+    }
+    if (!qp || !res)
+        return;
+
+    if (!g_strcmp0 (type, QOF_TYPE_NUMERIC) || !g_strcmp0 (type, QOF_TYPE_DEBCRED))
+        key->number = ((gnc_numeric (*)(gpointer, QofParam *))(qp->param_getfcn))(res, qp);
+    else if (!g_strcmp0 (type, QOF_TYPE_DATE))
+        key->integer = ((Timespec (*)(gpointer, QofParam *))(qp->param_getfcn))(res, qp).tv_sec;
+    else if (!g_strcmp0 (type, QOF_TYPE_INT32))
+        key->integer = ((gint32 (*)(gpointer, QofParam *))(qp->param_getfcn))(res, qp);
+    else if (!g_strcmp0 (type, QOF_TYPE_INT64))
+        key->integer = ((gint64 (*)(gpointer, QofParam *))(qp->param_getfcn))(res, qp);
+    else if (!g_strcmp0 (type, QOF_TYPE_CHAR))
+        key->integer = ((char (*)(gpointer, QofParam *))(qp->param_getfcn))(res, qp);
+    else if (!g_strcmp0 (type, QOF_TYPE_DOUBLE))
+        key->real = ((double (*)(gpointer, QofParam *))(qp->param_getfcn))(res, qp);
+    else if (!g_strcmp0 (type, QOF_TYPE_STRING))
+    {
+        /* The filename collation puts "9" before "10", as the engine
+         * does for the number strings it compares as numbers. */
+        const char *str = ((const char * (*)(gpointer, QofParam *))(qp->param_getfcn))(res, qp);
+        key->text = g_utf8_collate_key_for_filename (str ? str : "", -1);
+    }
+    else
+    {
+        gchar *qofstring = qof_query_core_to_string (type, res, qp);
+        key->text = g_utf8_collate_key_for_filename (qofstring ? qofstring : "", -1);
+        g_free (qofstring);
+    }
+}
+
+
+/********************************************************************\
+ * gnc_query_view_set_keys                                          *
+ *   recomputes the sort keys of the entries for the sort column    *
+ *                                                                  *
+ * Args: qview - view whose sort column changed                     *
+ * Returns: nothing                                                 *
+\********************************************************************/
+static void
+gnc_query_view_set_keys (GNCQueryView *qview)
+{
+    GNCQueryViewPriv     *priv = GNC_QUERY_VIEW_GET_PRIVATE (qview);
+    GNCSearchParamSimple *param;
+    GHashTableIter        iter;
+    gpointer              entry, key;
+
+    param = g_list_nth_data (qview->column_params, qview->sort_column);
+    g_return_if_fail (GNC_IS_SEARCH_PARAM_SIMPLE (param));
+
+    priv->key_type = gnc_search_param_get_param_type ((GNCSearchParam *) param);
+
+    g_hash_table_iter_init (&iter, priv->sort_keys);
+    while (g_hash_table_iter_next (&iter, &entry, &key))
+        gnc_query_view_compute_key (param, entry, key);
+}
+
+
+/********************************************************************\
+ * gnc_query_view_add_row                                           *
+ *   Add an entry to the list store                                 *
+ *                                                                  *
+ * Args: qview    - view to add the entry to                        *
+ *       entry    - the entry                                       *
+ *       position - the position of the entry in the query results  *
+ * Returns: nothing                                                 *
+\********************************************************************/
+static void
+gnc_query_view_add_row (GNCQueryView *qview, gpointer entry, guint position)
+{
+    GNCQueryViewPriv *priv = GNC_QUERY_VIEW_GET_PRIVATE (qview);
     GtkTreeModel     *model;
     GtkTreeIter       iter;
-    GList            *entries, *item;
-    const             GncGUID *guid;
-    gint i;
+    GNCQueryViewKey  *key;
+    GList            *node;
+    gint              i;
+    QofParam         *qp = NULL;
 
-    /* Clear all watches */
-    priv = GNC_QUERY_VIEW_GET_PRIVATE (qview);
-    gnc_gui_component_clear_watches (priv->component_id);
+    model = gtk_tree_view_get_model (GTK_TREE_VIEW (qview));
 
-    entries = qof_query_run (qview->query);
+    /* Make the sort key before the row, which is sorted as it is set */
+    key = g_new0 (GNCQueryViewKey, 1);
+    key->position = position;
+    node = g_list_nth (qview->column_params, qview->sort_column);
+    if (node)
+    {
+        gnc_query_view_compute_key (node->data, entry, key);
+        priv->key_type = gnc_search_param_get_param_type (node->data);
+    }
+    if (priv->sort_keys)
+        g_hash_table_replace (priv->sort_keys, entry, key);
+    else
+        gnc_query_view_free_key (key);
 
-    model = gtk_tree_view_get_model (GTK_TREE_VIEW (qview));
+    /* Add a row to the list store */
+    gtk_list_store_append (GTK_LIST_STORE (model), &iter);
+    /* Add a pointer to the data in the first column of the list store */
+    gtk_list_store_set (GTK_LIST_STORE (model), &iter, 0, entry, -1);
 
-    for (item = entries; item; item = item->next)
+    for (i = 0, node = qview->column_params; node; node = node->next)
     {
-        GList *node;
-        gint row = 0;
-        const QofParam *gup;
-        QofParam *qp = NULL;
+        gboolean result;
+        GNCSearchParamSimple *param = node->data;
+        GSList *converters = NULL;
+        const char *type = gnc_search_param_get_param_type ((GNCSearchParam *) param);
+        gpointer res = entry;
+        gchar *qofstring;
 
-        /* Add a row to the list store */
-        gtk_list_store_append (GTK_LIST_STORE (model), &iter);
-        /* Add a pointer to the data in the first column of the list store */
-        gtk_list_store_set (GTK_LIST_STORE (model), &iter, 0, item->data, -1);
+        g_assert (GNC_IS_SEARCH_PARAM_SIMPLE (param));
+        converters = gnc_search_param_get_converters (param);
 
-        for (i = 0, node = qview->column_params; node; node = node->next)
+        /* Test for boolean type */
+        if (g_strcmp0 (type, QOF_TYPE_BOOLEAN) == 0)
         {
-            gboolean result;
-            GNCSearchParamSimple *param = node->data;
-            GSList *converters = NULL;
-            const char *type = gnc_search_param_get_param_type ((GNCSearchParam *) param);
-            gpointer res = item->data;
-            gchar *qofstring;
-
-            g_assert (GNC_IS_SEARCH_PARAM_SIMPLE (param));
-            converters = gnc_search_param_get_converters (param);
-
-            /* Test for boolean type */
-            if (g_strcmp0 (type, QOF_TYPE_BOOLEAN) == 0)
-            {
-                result = (gboolean) GPOINTER_TO_INT (gnc_search_param_compute_value (param, res));
-                gtk_list_store_set (GTK_LIST_STORE (model), &iter, i + 1, result, -1);
-                i++;
-                continue;
-            }
+            result = (gboolean) GPOINTER_TO_INT (gnc_search_param_compute_value (param, res));
+            gtk_list_store_set (GTK_LIST_STORE (model), &iter, i + 1, result, -1);
+            i++;
+            continue;
+        }
 
-            /* Do all the object conversions */
-            for (; converters; converters = converters->next)
-            {
-                qp = converters->data;
-                if (converters->next)
-                    res = (qp->param_getfcn)(res, qp);
-            }
+        /* Do all the object conversions */
+        for (; converters; converters = converters->next)
+        {
+            qp = converters->data;
+            if (converters->next)
+                res = (qp->param_getfcn)(res, qp);
+        }
 
-            /* Now convert this to a text value for the row */
-            if ( g_strcmp0(type, QOF_TYPE_DEBCRED) == 0 || g_strcmp0(type, QOF_TYPE_NUMERIC) == 0 )
-            {
+        /* Now convert this to a text value for the row */
+        if ( g_strcmp0(type, QOF_TYPE_DEBCRED) == 0 || g_strcmp0(type, QOF_TYPE_NUMERIC) == 0 )
+        {
 
-                gnc_numeric (*nfcn)(gpointer, QofParam *) =
-                    (gnc_numeric(*)(gpointer, QofParam *))(qp->param_getfcn);
-                gnc_numeric value = nfcn(res, qp);
+            gnc_numeric (*nfcn)(gpointer, QofParam *) =
+                (gnc_numeric(*)(gpointer, QofParam *))(qp->param_getfcn);
+            gnc_numeric value = nfcn(res, qp);
 
-                if (qview->numeric_abs)
-                    value = gnc_numeric_abs (value);
-                gtk_list_store_set (GTK_LIST_STORE (model), &iter, i + 1, xaccPrintAmount (value, gnc_default_print_info (FALSE)), -1);
-            }
-            else
-            {
-                qofstring = qof_query_core_to_string (type, res, qp);
-                gtk_list_store_set (GTK_LIST_STORE (model), &iter, i + 1, qofstring , -1);
-                g_free(qofstring);
-            }
-            i++;
+            if (qview->numeric_abs)
+                value = gnc_numeric_abs (value);
+            gtk_list_store_set (GTK_LIST_STORE (model), &iter, i + 1, xaccPrintAmount (value, gnc_default_print_info (FALSE)), -1);
         }
-        row++;
-        /* and set a watcher on this item */
-        gup = priv->get_guid;
+        else
+        {
+            qofstring = qof_query_core_to_string (type, res, qp);
+            gtk_list_store_set (GTK_LIST_STORE (model), &iter, i + 1, qofstring , -1);
+            g_free(qofstring);
+        }
+        i++;
+    }
+}
+
+
+/********************************************************************\
+ * gnc_query_view_fill_chunk                                        *
+ *   Add the next chunk of the entries still to be added            *
+ *                                                                  *
+ * The entries are looked up again by GUID, so that one destroyed   *
+ * since the query ran is left out rather than read after its free. *
+ *                                                                  *
+ * Args: qview - view to add the entries to                         *
+ * Returns: TRUE if there are entries left to add                   *
+\********************************************************************/
+static gboolean
+gnc_query_view_fill_chunk (GNCQueryView *qview)
+{
+    GNCQueryViewPriv *priv = GNC_QUERY_VIEW_GET_PRIVATE (qview);
+    guint             end;
+
+    if (!priv->fill_guids)
+        return FALSE;
+
+    end = MIN (priv->fill_next + priv->chunk_rows, priv->fill_guids->len);
+    for (; priv->fill_next < end; priv->fill_next++)
+    {
+        GncGUID *guid = &g_array_index (priv->fill_guids, GncGUID, priv->fill_next);
+        gpointer entry = qof_collection_lookup_entity (priv->fill_col, guid);
+
+        if (entry)
+            gnc_query_view_add_row (qview, entry, priv->fill_next);
+        else
+            qview->num_entries--;
+    }
+
+    if (priv->fill_next < priv->fill_guids->len)
+        return TRUE;
+
+    g_array_free (priv->fill_guids, TRUE);
+    priv->fill_guids = NULL;
+    priv->fill_col = NULL;
+    return FALSE;
+}
+
+
+static gboolean
+gnc_query_view_fill_idle (gpointer user_data)
+{
+    GNCQueryView *qview = GNC_QUERY_VIEW (user_data);
+
+    if (gnc_query_view_fill_chunk (qview))
+        return TRUE;
+
+    GNC_QUERY_VIEW_GET_PRIVATE (qview)->fill_id = 0;
+    return FALSE;
+}
+
+
+/********************************************************************\
+ * gnc_query_view_stop_fill                                         *
+ *   Drop the entries still to be added, if any                     *
+ *                                                                  *
+ * Args: qview - view being filled                                  *
+ * Returns: nothing                                                 *
+\********************************************************************/
+static void
+gnc_query_view_stop_fill (GNCQueryView *qview)
+{
+    GNCQueryViewPriv *priv = GNC_QUERY_VIEW_GET_PRIVATE (qview);
+
+    if (priv->fill_id)
+    {
+        g_source_remove (priv->fill_id);
+        priv->fill_id = 0;
+    }
+    if (priv->fill_guids)
+    {
+        g_array_free (priv->fill_guids, TRUE);
+        priv->fill_guids = NULL;
+    }
+    priv->fill_col = NULL;
+}
+
+
+/********************************************************************\
+ * gnc_query_view_fill                                              *
+ *   Add all items to the list store                                *
+ *                                                                  *
+ * An incremental view only adds the first chunk here and the rest  *
+ * from an idle handler, so that the window stays responsive.       *
+ * num_entries counts the entries still to be added as well.        *
+ *                                                                  *
+ * Args: qview - view to add item to                                *
+ * Returns: nothing                                                 *
+\********************************************************************/
+static void
+gnc_query_view_fill (GNCQueryView *qview)
+{
+    GNCQueryViewPriv *priv;
+    GList            *entries, *item, *books;
+    const             GncGUID *guid;
+    const QofParam   *gup;
+    guint             position = 0;
+
+    /* Clear all watches */
+    priv = GNC_QUERY_VIEW_GET_PRIVATE (qview);
+    gnc_gui_component_clear_watches (priv->component_id);
+
+    entries = qof_query_run (qview->query);
+
+    books = qof_query_get_books (qview->query);
+    if (priv->chunk_rows > 0 && entries && books)
+    {
+        priv->fill_col = qof_book_get_collection (books->data,
+                         qof_query_get_search_for (qview->query));
+        priv->fill_guids = g_array_sized_new (FALSE, FALSE, sizeof (GncGUID),
+                                              g_list_length (entries));
+        priv->fill_next = 0;
+    }
+
+    gup = priv->get_guid;
+    for (item = entries; item; item = item->next, position++)
+    {
+        /* Set a watcher on this item */
         guid = (const GncGUID*)((gup->param_getfcn)(item->data, gup));
         gnc_gui_component_watch_entity (priv->component_id, guid,
                                         QOF_EVENT_MODIFY | QOF_EVENT_DESTROY);
 
-        qview->num_entries++;
+        if (priv->fill_guids)
+            g_array_append_val (priv->fill_guids, *guid);
+        else
+            gnc_query_view_add_row (qview, item->data, position);
     }
+    qview->num_entries = position;
+
+    if (gnc_query_view_fill_chunk (qview))
+        priv->fill_id = g_idle_add (gnc_query_view_fill_idle, qview);
 }
 
 
@@ -98,6 +98,16 @@ extern "C" {
      */
     GtkWidget * gnc_query_view_new (GList *param_list, Query *query);
 
+    /* Like gnc_query_view_new, but the entries found by the query are
+     * added chunk_rows at a time, the first chunk at once and the rest
+     * whenever the main loop is idle, so a large result doesn't freeze
+     * the window.  Running the query again, by a reset or refresh, or
+     * destroying the view drops the entries not yet added.  The number
+     * of entries includes those still to be added.
+     */
+    GtkWidget * gnc_query_view_new_incremental (GList *param_list, Query *query,
+                                                gint chunk_rows);
+
     void gnc_query_view_construct (GNCQueryView *qview, GList *param_list, Query *query);
 
     void gnc_query_view_reset_query (GNCQueryView *view, Query *query);
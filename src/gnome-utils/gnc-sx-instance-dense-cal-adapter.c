@@ -46,6 +46,7 @@ static gchar* gsidca_get_name(GncDenseCalModel *model, guint tag);
 static gchar* gsidca_get_info(GncDenseCalModel *model, guint tag);
 static gint gsidca_get_instance_count(GncDenseCalModel *model, guint tag);
 static void gsidca_get_instance(GncDenseCalModel *model, guint tag, gint instance_index, GDate *date);
+static void gsidca_forget_last(GncSxInstanceDenseCalAdapter *adapter);
 
 static GObjectClass *parent_class = NULL;
 
@@ -59,6 +60,13 @@ struct _GncSxInstanceDenseCalAdapter
     GObject parent;
     gboolean disposed;
     GncSxInstanceModel *instances;
+
+    /* The instances last asked for, and the list node of the last
+     * instance returned, so walking the instances in order does not
+     * search the lists over again. */
+    GncSxInstances *last_insts;
+    GList *last_instance_node;
+    gint last_instance_index;
 };
 
 static void
@@ -75,8 +83,8 @@ gnc_sx_instance_dense_cal_adapter_class_init(GncSxInstanceDenseCalAdapterClass *
 static void
 gnc_sx_instance_dense_cal_adapter_init(GTypeInstance *instance, gpointer klass)
 {
-    /*GncSxInstanceDenseCalAdapter *adapter = GNC_SX_INSTANCE_DENSE_CAL_ADAPTER(instance);*/
-    ; /* nop */
+    GncSxInstanceDenseCalAdapter *adapter = GNC_SX_INSTANCE_DENSE_CAL_ADAPTER(instance);
+    gsidca_forget_last(adapter);
 }
 
 static void
@@ -95,6 +103,7 @@ gsidca_instances_added_cb(GncSxInstanceModel *model, SchedXaction *sx_added, gpo
 {
     GncSxInstanceDenseCalAdapter *adapter = GNC_SX_INSTANCE_DENSE_CAL_ADAPTER(user_data);
     g_debug("instance added\n");
+    gsidca_forget_last(adapter);
     if (xaccSchedXactionGetEnabled(sx_added))
     {
         g_signal_emit_by_name(adapter, "added", GPOINTER_TO_UINT(sx_added));
@@ -106,6 +115,7 @@ gsidca_instances_updated_cb(GncSxInstanceModel *model, SchedXaction *sx_updated,
 {
     GncSxInstanceDenseCalAdapter *adapter = GNC_SX_INSTANCE_DENSE_CAL_ADAPTER(user_data);
     gnc_sx_instance_model_update_sx_instances(model, sx_updated);
+    gsidca_forget_last(adapter);
     g_debug("instances updated\n");
     if (xaccSchedXactionGetEnabled(sx_updated))
     {
@@ -124,6 +134,7 @@ gsidca_instances_removing_cb(GncSxInstanceModel *model, SchedXaction *sx_to_be_r
     g_debug("removing instance...\n");
     g_signal_emit_by_name(adapter, "removing", GPOINTER_TO_UINT(sx_to_be_removed));
     gnc_sx_instance_model_remove_sx_instances(model, sx_to_be_removed);
+    gsidca_forget_last(adapter);
 }
 
 GncSxInstanceDenseCalAdapter*
@@ -182,6 +193,33 @@ gsidca_find_sx_with_tag(gconstpointer list_data,
     return (GUINT_TO_POINTER(GPOINTER_TO_UINT(sx_instances->sx)) == find_data ? 0 : 1);
 }
 
+static void
+gsidca_forget_last(GncSxInstanceDenseCalAdapter *adapter)
+{
+    adapter->last_insts = NULL;
+    adapter->last_instance_node = NULL;
+    adapter->last_instance_index = -1;
+}
+
+static GncSxInstances*
+gsidca_find_instances(GncSxInstanceDenseCalAdapter *adapter, guint tag)
+{
+    GList *node;
+
+    if (adapter->last_insts != NULL
+            && GPOINTER_TO_UINT(adapter->last_insts->sx) == tag)
+        return adapter->last_insts;
+
+    node = g_list_find_custom(adapter->instances->sx_instance_list, GUINT_TO_POINTER(tag), gsidca_find_sx_with_tag);
+    if (node == NULL)
+        return NULL;
+
+    adapter->last_insts = (GncSxInstances*)node->data;
+    adapter->last_instance_node = NULL;
+    adapter->last_instance_index = -1;
+    return adapter->last_insts;
+}
+
 static GList*
 gsidca_get_contained(GncDenseCalModel *model)
 {
@@ -203,8 +241,7 @@ static gchar*
 gsidca_get_name(GncDenseCalModel *model, guint tag)
 {
     GncSxInstanceDenseCalAdapter *adapter = GNC_SX_INSTANCE_DENSE_CAL_ADAPTER(model);
-    GncSxInstances *insts
-    = (GncSxInstances*)g_list_find_custom(adapter->instances->sx_instance_list, GUINT_TO_POINTER(tag), gsidca_find_sx_with_tag)->data;
+    GncSxInstances *insts = gsidca_find_instances(adapter, tag);
     if (insts == NULL)
         return NULL;
     return xaccSchedXactionGetName(insts->sx);
@@ -217,8 +254,7 @@ gsidca_get_info(GncDenseCalModel *model, guint tag)
     // g_list_find(instances->sxes, {sx_to_tag, tag}).get_freq_spec().get_freq_str();
     GList *schedule;
     gchar *schedule_str;
-    GncSxInstances *insts
-    = (GncSxInstances*)g_list_find_custom(adapter->instances->sx_instance_list, GUINT_TO_POINTER(tag), gsidca_find_sx_with_tag)->data;
+    GncSxInstances *insts = gsidca_find_instances(adapter, tag);
     if (insts == NULL)
         return NULL;
     schedule = gnc_sx_get_schedule(insts->sx);
@@ -231,8 +267,7 @@ gsidca_get_instance_count(GncDenseCalModel *model, guint tag)
 {
     GncSxInstanceDenseCalAdapter *adapter = GNC_SX_INSTANCE_DENSE_CAL_ADAPTER(model);
     // g_list_find(instances->sxes, {sx_to_tag, tag}).length();
-    GncSxInstances *insts
-    = (GncSxInstances*)g_list_find_custom(adapter->instances->sx_instance_list, GUINT_TO_POINTER(tag), gsidca_find_sx_with_tag)->data;
+    GncSxInstances *insts = gsidca_find_instances(adapter, tag);
     if (insts == NULL)
         return 0;
     return g_list_length(insts->instance_list);
@@ -243,11 +278,20 @@ gsidca_get_instance(GncDenseCalModel *model, guint tag, gint instance_index, GDa
 {
     GncSxInstanceDenseCalAdapter *adapter = GNC_SX_INSTANCE_DENSE_CAL_ADAPTER(model);
     GncSxInstance *inst;
-    GncSxInstances *insts
-    = (GncSxInstances*)g_list_find_custom(adapter->instances->sx_instance_list, GUINT_TO_POINTER(tag), gsidca_find_sx_with_tag)->data;
+    GList *node;
+    GncSxInstances *insts = gsidca_find_instances(adapter, tag);
     if (insts == NULL)
         return;
-    inst = (GncSxInstance*)g_list_nth_data(insts->instance_list, instance_index);
+    if (adapter->last_instance_node != NULL
+            && instance_index == adapter->last_instance_index + 1)
+        node = adapter->last_instance_node->next;
+    else
+        node = g_list_nth(insts->instance_list, instance_index);
+    adapter->last_instance_node = node;
+    adapter->last_instance_index = instance_index;
+    if (node == NULL)
+        return;
+    inst = (GncSxInstance*)node->data;
     g_date_valid(&inst->date);
     *date = inst->date;
     g_date_valid(date);
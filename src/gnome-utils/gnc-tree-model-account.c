@@ -38,6 +38,7 @@
 #include "gnc-engine.h"
 #include "gnc-event.h"
 #include "gnc-gobject-utils.h"
+#include "gnc-pricedb.h"
 #include "gnc-ui-balances.h"
 #include "gnc-ui-util.h"
 
@@ -97,8 +98,24 @@ typedef struct GncTreeModelAccountPrivate
     Account *root;
     gint event_handler_id;
     const gchar *negative_color;
+    GHashTable *balance_cache;  /* Account --> AccountBalances */
 } GncTreeModelAccountPrivate;
 
+/** One cached balance column value of an account. */
+typedef struct
+{
+    gchar *string;
+    gnc_numeric balance;
+    gboolean negative;
+} BalanceValue;
+
+/** The cached balance column values of an account, indexed by
+ *  column.  A NULL entry has not been computed yet. */
+typedef struct
+{
+    BalanceValue *values[GNC_TREE_MODEL_ACCOUNT_COL_LAST_VISIBLE + 1];
+} AccountBalances;
+
 #define GNC_TREE_MODEL_ACCOUNT_GET_PRIVATE(o)  \
    (G_TYPE_INSTANCE_GET_PRIVATE ((o), GNC_TYPE_TREE_MODEL_ACCOUNT, GncTreeModelAccountPrivate))
 
@@ -126,6 +143,53 @@ gnc_tree_model_account_update_color (gpointer gsettings, gchar *key, gpointer us
     use_red = gnc_prefs_get_bool (GNC_PREFS_GROUP_GENERAL, GNC_PREF_NEGATIVE_IN_RED);
     priv->negative_color = use_red ? "red" : NULL;
 }
+
+static void
+account_balances_free (gpointer data)
+{
+    AccountBalances *balances = data;
+    gint i;
+
+    for (i = 0; i <= GNC_TREE_MODEL_ACCOUNT_COL_LAST_VISIBLE; i++)
+    {
+        if (!balances->values[i])
+            continue;
+        g_free (balances->values[i]->string);
+        g_free (balances->values[i]);
+    }
+    g_free (balances);
+}
+
+/** Forget the cached balances of an account and all its ancestors,
+ *  whose totals include it.
+ *
+ *  @internal
+ */
+static void
+gnc_tree_model_account_invalidate_balances (GncTreeModelAccount *model,
+        Account *account)
+{
+    GncTreeModelAccountPrivate *priv;
+
+    priv = GNC_TREE_MODEL_ACCOUNT_GET_PRIVATE(model);
+    for ( ; account; account = gnc_account_get_parent (account))
+        g_hash_table_remove (priv->balance_cache, account);
+}
+
+/** Forget all cached balances, e.g. after a price or a preference
+ *  that affects every balance has changed.
+ *
+ *  @internal
+ */
+static void
+gnc_tree_model_account_clear_balances (gpointer gsettings, gchar *key, gpointer user_data)
+{
+    GncTreeModelAccountPrivate *priv;
+
+    g_return_if_fail(GNC_IS_TREE_MODEL_ACCOUNT(user_data));
+    priv = GNC_TREE_MODEL_ACCOUNT_GET_PRIVATE(user_data);
+    g_hash_table_remove_all (priv->balance_cache);
+}
 /************************************************************/
 /*               g_object required functions                */
 /************************************************************/
@@ -206,10 +270,20 @@ gnc_tree_model_account_init (GncTreeModelAccount *model)
     priv->book = NULL;
     priv->root = NULL;
     priv->negative_color = red ? "red" : NULL;
+    priv->balance_cache = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                          NULL, account_balances_free);
 
     gnc_prefs_register_cb(GNC_PREFS_GROUP_GENERAL, GNC_PREF_NEGATIVE_IN_RED,
                           gnc_tree_model_account_update_color,
                           model);
+    /* The report currency, reversed balance and accounting period
+     * preferences all change the balances shown. */
+    gnc_prefs_register_cb(GNC_PREFS_GROUP_GENERAL, NULL,
+                          gnc_tree_model_account_clear_balances,
+                          model);
+    gnc_prefs_register_cb(GNC_PREFS_GROUP_ACCT_SUMMARY, NULL,
+                          gnc_tree_model_account_clear_balances,
+                          model);
 
     LEAVE(" ");
 }
@@ -229,6 +303,8 @@ gnc_tree_model_account_finalize (GObject *object)
     priv = GNC_TREE_MODEL_ACCOUNT_GET_PRIVATE(model);
 
     priv->book = NULL;
+    g_hash_table_destroy (priv->balance_cache);
+    priv->balance_cache = NULL;
 
     if (G_OBJECT_CLASS (parent_class)->finalize)
         G_OBJECT_CLASS(parent_class)->finalize (object);
@@ -258,6 +334,12 @@ gnc_tree_model_account_dispose (GObject *object)
     gnc_prefs_remove_cb_by_func(GNC_PREFS_GROUP_GENERAL, GNC_PREF_NEGATIVE_IN_RED,
                                 gnc_tree_model_account_update_color,
                                 model);
+    gnc_prefs_remove_cb_by_func(GNC_PREFS_GROUP_GENERAL, NULL,
+                                gnc_tree_model_account_clear_balances,
+                                model);
+    gnc_prefs_remove_cb_by_func(GNC_PREFS_GROUP_ACCT_SUMMARY, NULL,
+                                gnc_tree_model_account_clear_balances,
+                                model);
 
     if (G_OBJECT_CLASS (parent_class)->dispose)
         G_OBJECT_CLASS (parent_class)->dispose (object);
@@ -569,7 +651,8 @@ static gchar *
 gnc_tree_model_account_compute_period_balance(GncTreeModelAccount *model,
         Account *acct,
         gboolean recurse,
-        gboolean *negative)
+        gboolean *negative,
+        gnc_numeric *balance)
 {
     GncTreeModelAccountPrivate *priv;
     time64 t1, t2;
@@ -577,6 +660,8 @@ gnc_tree_model_account_compute_period_balance(GncTreeModelAccount *model,
 
     if ( negative )
         *negative = FALSE;
+    if ( balance )
+        *balance = gnc_numeric_zero ();
 
     priv = GNC_TREE_MODEL_ACCOUNT_GET_PRIVATE(model);
     if (acct == priv->root)
@@ -594,10 +679,148 @@ gnc_tree_model_account_compute_period_balance(GncTreeModelAccount *model,
 
     if (negative)
         *negative = gnc_numeric_negative_p(b3);
+    if (balance)
+        *balance = b3;
 
     return g_strdup(xaccPrintAmount(b3, gnc_account_print_info(acct, TRUE)));
 }
 
+/** Get the value of a balance column for an account, computing it
+ *  and adding it to the cache if it isn't there yet.  The returned
+ *  value is owned by the cache.
+ *
+ *  @internal
+ */
+static const BalanceValue *
+gnc_tree_model_account_get_balance_value (GncTreeModelAccount *model,
+        Account *account,
+        gint column)
+{
+    GncTreeModelAccountPrivate *priv;
+    AccountBalances *balances;
+    BalanceValue *value;
+    xaccGetBalanceInCurrencyFn fn = NULL;
+    gboolean recurse = TRUE;
+    gboolean report = FALSE;
+    GNCPrintAmountInfo print_info;
+    gnc_commodity *commodity = NULL;
+
+    g_assert (column >= 0 && column <= GNC_TREE_MODEL_ACCOUNT_COL_LAST_VISIBLE);
+
+    priv = GNC_TREE_MODEL_ACCOUNT_GET_PRIVATE(model);
+    balances = g_hash_table_lookup (priv->balance_cache, account);
+    if (!balances)
+    {
+        balances = g_new0 (AccountBalances, 1);
+        g_hash_table_insert (priv->balance_cache, account, balances);
+    }
+    if (balances->values[column])
+        return balances->values[column];
+
+    value = g_new0 (BalanceValue, 1);
+    balances->values[column] = value;
+
+    switch (column)
+    {
+    case GNC_TREE_MODEL_ACCOUNT_COL_PRESENT_REPORT:
+        report = TRUE;
+        /* fall through */
+    case GNC_TREE_MODEL_ACCOUNT_COL_PRESENT:
+        fn = xaccAccountGetPresentBalanceInCurrency;
+        break;
+    case GNC_TREE_MODEL_ACCOUNT_COL_BALANCE_REPORT:
+        report = TRUE;
+        /* fall through */
+    case GNC_TREE_MODEL_ACCOUNT_COL_BALANCE:
+        fn = xaccAccountGetBalanceInCurrency;
+        recurse = FALSE;
+        break;
+    case GNC_TREE_MODEL_ACCOUNT_COL_CLEARED_REPORT:
+        report = TRUE;
+        /* fall through */
+    case GNC_TREE_MODEL_ACCOUNT_COL_CLEARED:
+        fn = xaccAccountGetClearedBalanceInCurrency;
+        break;
+    case GNC_TREE_MODEL_ACCOUNT_COL_RECONCILED_REPORT:
+        report = TRUE;
+        /* fall through */
+    case GNC_TREE_MODEL_ACCOUNT_COL_RECONCILED:
+        fn = xaccAccountGetReconciledBalanceInCurrency;
+        break;
+    case GNC_TREE_MODEL_ACCOUNT_COL_FUTURE_MIN_REPORT:
+        report = TRUE;
+        /* fall through */
+    case GNC_TREE_MODEL_ACCOUNT_COL_FUTURE_MIN:
+        fn = xaccAccountGetProjectedMinimumBalanceInCurrency;
+        break;
+    case GNC_TREE_MODEL_ACCOUNT_COL_TOTAL_REPORT:
+        report = TRUE;
+        /* fall through */
+    case GNC_TREE_MODEL_ACCOUNT_COL_TOTAL:
+        fn = xaccAccountGetBalanceInCurrency;
+        break;
+    case GNC_TREE_MODEL_ACCOUNT_COL_BALANCE_PERIOD:
+        recurse = FALSE;
+        /* fall through */
+    case GNC_TREE_MODEL_ACCOUNT_COL_TOTAL_PERIOD:
+        value->string = gnc_tree_model_account_compute_period_balance
+                        (model, account, recurse, &value->negative, &value->balance);
+        return value;
+    default:
+        PERR("column %d is not a balance column", column);
+        value->string = g_strdup ("");
+        value->balance = gnc_numeric_zero ();
+        return value;
+    }
+
+    if (report)
+    {
+        commodity = gnc_default_report_currency ();
+        print_info = gnc_commodity_print_info (commodity, TRUE);
+    }
+    else
+    {
+        print_info = gnc_account_print_info (account, TRUE);
+    }
+
+    value->balance = gnc_ui_account_get_balance_full (fn, account, recurse,
+                     &value->negative, commodity);
+    value->string = g_strdup (xaccPrintAmount (value->balance, print_info));
+    return value;
+}
+
+gnc_numeric
+gnc_tree_model_account_get_balance (GncTreeModelAccount *model,
+                                    Account *account,
+                                    GncTreeModelAccountColumn column)
+{
+    g_return_val_if_fail (GNC_IS_TREE_MODEL_ACCOUNT (model), gnc_numeric_zero ());
+    g_return_val_if_fail (account != NULL, gnc_numeric_zero ());
+
+    return gnc_tree_model_account_get_balance_value (model, account, column)->balance;
+}
+
+/** Fill in a balance column, or the color of one, from the cache.
+ *
+ *  @internal
+ */
+static void
+gnc_tree_model_account_set_balance (GncTreeModelAccount *model,
+                                    Account *account,
+                                    gint column,
+                                    gboolean color,
+                                    GValue *value)
+{
+    const BalanceValue *bv;
+
+    bv = gnc_tree_model_account_get_balance_value (model, account, column);
+    g_value_init (value, G_TYPE_STRING);
+    if (color)
+        gnc_tree_model_account_set_color (model, bv->negative, value);
+    else
+        g_value_set_string (value, bv->string);
+}
+
 static void
 gnc_tree_model_account_get_value (GtkTreeModel *tree_model,
                                   GtkTreeIter *iter,
@@ -607,8 +830,6 @@ gnc_tree_model_account_get_value (GtkTreeModel *tree_model,
     GncTreeModelAccount *model = GNC_TREE_MODEL_ACCOUNT (tree_model);
     GncTreeModelAccountPrivate *priv;
     Account *account;
-    gboolean negative; /* used to set "deficit style" also known as red numbers */
-    gchar *string;
     time64 last_date;
 
     g_return_if_fail (GNC_IS_TREE_MODEL_ACCOUNT (model));
@@ -651,153 +872,61 @@ gnc_tree_model_account_get_value (GtkTreeModel *tree_model,
         break;
 
     case GNC_TREE_MODEL_ACCOUNT_COL_PRESENT:
-        g_value_init (value, G_TYPE_STRING);
-        string = gnc_ui_account_get_print_balance(xaccAccountGetPresentBalanceInCurrency,
-                 account, TRUE, &negative);
-        g_value_take_string (value, string);
-        break;
     case GNC_TREE_MODEL_ACCOUNT_COL_PRESENT_REPORT:
-        g_value_init (value, G_TYPE_STRING);
-        string = gnc_ui_account_get_print_report_balance(xaccAccountGetPresentBalanceInCurrency,
-                 account, TRUE, &negative);
-        g_value_take_string (value, string);
-        break;
-    case GNC_TREE_MODEL_ACCOUNT_COL_COLOR_PRESENT:
-        g_value_init (value, G_TYPE_STRING);
-        string = gnc_ui_account_get_print_balance(xaccAccountGetPresentBalanceInCurrency,
-                 account, TRUE, &negative);
-        gnc_tree_model_account_set_color(model, negative, value);
-        g_free(string);
-        break;
-
     case GNC_TREE_MODEL_ACCOUNT_COL_BALANCE:
-        g_value_init (value, G_TYPE_STRING);
-        string = gnc_ui_account_get_print_balance(xaccAccountGetBalanceInCurrency,
-                 account, FALSE, &negative);
-        g_value_take_string (value, string);
-        break;
     case GNC_TREE_MODEL_ACCOUNT_COL_BALANCE_REPORT:
-        g_value_init (value, G_TYPE_STRING);
-        string = gnc_ui_account_get_print_report_balance(xaccAccountGetBalanceInCurrency,
-                 account, FALSE, &negative);
-        g_value_take_string (value, string);
-        break;
-    case GNC_TREE_MODEL_ACCOUNT_COL_COLOR_BALANCE:
-        g_value_init (value, G_TYPE_STRING);
-        string = gnc_ui_account_get_print_balance(xaccAccountGetBalanceInCurrency,
-                 account, FALSE, &negative);
-        gnc_tree_model_account_set_color(model, negative, value);
-        g_free(string);
-        break;
     case GNC_TREE_MODEL_ACCOUNT_COL_BALANCE_PERIOD:
-        g_value_init (value, G_TYPE_STRING);
-        string = gnc_tree_model_account_compute_period_balance(model, account, FALSE, &negative);
-        g_value_take_string (value, string);
-        break;
-    case GNC_TREE_MODEL_ACCOUNT_COL_COLOR_BALANCE_PERIOD:
-        g_value_init (value, G_TYPE_STRING);
-        string = gnc_tree_model_account_compute_period_balance(model, account, FALSE, &negative);
-        gnc_tree_model_account_set_color(model, negative, value);
-        g_free (string);
-        break;
-
     case GNC_TREE_MODEL_ACCOUNT_COL_CLEARED:
-        g_value_init (value, G_TYPE_STRING);
-        string = gnc_ui_account_get_print_balance(xaccAccountGetClearedBalanceInCurrency,
-                 account, TRUE, &negative);
-        g_value_take_string (value, string);
-        break;
     case GNC_TREE_MODEL_ACCOUNT_COL_CLEARED_REPORT:
-        g_value_init (value, G_TYPE_STRING);
-        string = gnc_ui_account_get_print_report_balance(xaccAccountGetClearedBalanceInCurrency,
-                 account, TRUE, &negative);
-        g_value_take_string (value, string);
-        break;
-    case GNC_TREE_MODEL_ACCOUNT_COL_COLOR_CLEARED:
-        g_value_init (value, G_TYPE_STRING);
-        string = gnc_ui_account_get_print_balance(xaccAccountGetClearedBalanceInCurrency,
-                 account, TRUE, &negative);
-        gnc_tree_model_account_set_color(model, negative, value);
-        g_free(string);
-        break;
-
     case GNC_TREE_MODEL_ACCOUNT_COL_RECONCILED:
-        g_value_init (value, G_TYPE_STRING);
-        string = gnc_ui_account_get_print_balance(xaccAccountGetReconciledBalanceInCurrency,
-                 account, TRUE, &negative);
-        g_value_take_string (value, string);
-        break;
     case GNC_TREE_MODEL_ACCOUNT_COL_RECONCILED_REPORT:
-        g_value_init (value, G_TYPE_STRING);
-        string = gnc_ui_account_get_print_report_balance(xaccAccountGetReconciledBalanceInCurrency,
-                 account, TRUE, &negative);
-        g_value_take_string (value, string);
-        break;
-    case GNC_TREE_MODEL_ACCOUNT_COL_RECONCILED_DATE:
-        g_value_init (value, G_TYPE_STRING);
-        if (xaccAccountGetReconcileLastDate(account, &last_date))
-        {
-            g_value_take_string(value, qof_print_date(last_date));
-        }
+    case GNC_TREE_MODEL_ACCOUNT_COL_FUTURE_MIN:
+    case GNC_TREE_MODEL_ACCOUNT_COL_FUTURE_MIN_REPORT:
+    case GNC_TREE_MODEL_ACCOUNT_COL_TOTAL:
+    case GNC_TREE_MODEL_ACCOUNT_COL_TOTAL_REPORT:
+    case GNC_TREE_MODEL_ACCOUNT_COL_TOTAL_PERIOD:
+        gnc_tree_model_account_set_balance (model, account, column, FALSE, value);
         break;
 
-    case GNC_TREE_MODEL_ACCOUNT_COL_COLOR_RECONCILED:
-        g_value_init (value, G_TYPE_STRING);
-        string = gnc_ui_account_get_print_balance(xaccAccountGetReconciledBalanceInCurrency,
-                 account, TRUE, &negative);
-        gnc_tree_model_account_set_color(model, negative, value);
-        g_free (string);
+    case GNC_TREE_MODEL_ACCOUNT_COL_COLOR_PRESENT:
+        gnc_tree_model_account_set_balance (model, account,
+                                            GNC_TREE_MODEL_ACCOUNT_COL_PRESENT, TRUE, value);
         break;
-
-    case GNC_TREE_MODEL_ACCOUNT_COL_FUTURE_MIN:
-        g_value_init (value, G_TYPE_STRING);
-        string = gnc_ui_account_get_print_balance(xaccAccountGetProjectedMinimumBalanceInCurrency,
-                 account, TRUE, &negative);
-        g_value_take_string (value, string);
+    case GNC_TREE_MODEL_ACCOUNT_COL_COLOR_BALANCE:
+        gnc_tree_model_account_set_balance (model, account,
+                                            GNC_TREE_MODEL_ACCOUNT_COL_BALANCE, TRUE, value);
         break;
-    case GNC_TREE_MODEL_ACCOUNT_COL_FUTURE_MIN_REPORT:
-        g_value_init (value, G_TYPE_STRING);
-        string = gnc_ui_account_get_print_report_balance(xaccAccountGetProjectedMinimumBalanceInCurrency,
-                 account, TRUE, &negative);
-        g_value_take_string (value, string);
+    case GNC_TREE_MODEL_ACCOUNT_COL_COLOR_BALANCE_PERIOD:
+        gnc_tree_model_account_set_balance (model, account,
+                                            GNC_TREE_MODEL_ACCOUNT_COL_BALANCE_PERIOD, TRUE, value);
         break;
-    case GNC_TREE_MODEL_ACCOUNT_COL_COLOR_FUTURE_MIN:
-        g_value_init (value, G_TYPE_STRING);
-        string = gnc_ui_account_get_print_balance(xaccAccountGetProjectedMinimumBalanceInCurrency,
-                 account, TRUE, &negative);
-        gnc_tree_model_account_set_color(model, negative, value);
-        g_free (string);
+    case GNC_TREE_MODEL_ACCOUNT_COL_COLOR_CLEARED:
+        gnc_tree_model_account_set_balance (model, account,
+                                            GNC_TREE_MODEL_ACCOUNT_COL_CLEARED, TRUE, value);
         break;
-
-    case GNC_TREE_MODEL_ACCOUNT_COL_TOTAL:
-        g_value_init (value, G_TYPE_STRING);
-        string = gnc_ui_account_get_print_balance(xaccAccountGetBalanceInCurrency,
-                 account, TRUE, &negative);
-        g_value_take_string (value, string);
+    case GNC_TREE_MODEL_ACCOUNT_COL_COLOR_RECONCILED:
+        gnc_tree_model_account_set_balance (model, account,
+                                            GNC_TREE_MODEL_ACCOUNT_COL_RECONCILED, TRUE, value);
         break;
-    case GNC_TREE_MODEL_ACCOUNT_COL_TOTAL_REPORT:
-        g_value_init (value, G_TYPE_STRING);
-        string = gnc_ui_account_get_print_report_balance(xaccAccountGetBalanceInCurrency,
-                 account, TRUE, &negative);
-        g_value_take_string (value, string);
+    case GNC_TREE_MODEL_ACCOUNT_COL_COLOR_FUTURE_MIN:
+        gnc_tree_model_account_set_balance (model, account,
+                                            GNC_TREE_MODEL_ACCOUNT_COL_FUTURE_MIN, TRUE, value);
         break;
     case GNC_TREE_MODEL_ACCOUNT_COL_COLOR_TOTAL:
-        g_value_init (value, G_TYPE_STRING);
-        string = gnc_ui_account_get_print_balance(xaccAccountGetBalanceInCurrency,
-                 account, TRUE, &negative);
-        gnc_tree_model_account_set_color(model, negative, value);
-        g_free (string);
-        break;
-    case GNC_TREE_MODEL_ACCOUNT_COL_TOTAL_PERIOD:
-        g_value_init (value, G_TYPE_STRING);
-        string = gnc_tree_model_account_compute_period_balance(model, account, TRUE, &negative);
-        g_value_take_string (value, string);
+        gnc_tree_model_account_set_balance (model, account,
+                                            GNC_TREE_MODEL_ACCOUNT_COL_TOTAL, TRUE, value);
         break;
     case GNC_TREE_MODEL_ACCOUNT_COL_COLOR_TOTAL_PERIOD:
+        gnc_tree_model_account_set_balance (model, account,
+                                            GNC_TREE_MODEL_ACCOUNT_COL_TOTAL_PERIOD, TRUE, value);
+        break;
+
+    case GNC_TREE_MODEL_ACCOUNT_COL_RECONCILED_DATE:
         g_value_init (value, G_TYPE_STRING);
-        string = gnc_tree_model_account_compute_period_balance(model, account, TRUE, &negative);
-        gnc_tree_model_account_set_color(model, negative, value);
-        g_free (string);
+        if (xaccAccountGetReconcileLastDate(account, &last_date))
+        {
+            g_value_take_string(value, qof_print_date(last_date));
+        }
         break;
 
     case GNC_TREE_MODEL_ACCOUNT_COL_COLOR_ACCOUNT:
@@ -1301,6 +1430,20 @@ gnc_tree_model_account_event_handler (QofInstance *entity,
     Account *account, *parent;
 
     g_return_if_fail(model);	/* Required */
+
+    /* Keep the balance cache in step with the engine.  Prices (and
+     * commodities) feed into the converted balances of any account. */
+    if (GNC_IS_SPLIT(entity))
+    {
+        gnc_tree_model_account_invalidate_balances
+        (model, xaccSplitGetAccount (GNC_SPLIT(entity)));
+        return;
+    }
+    if (GNC_IS_PRICE(entity) || GNC_IS_COMMODITY(entity))
+    {
+        gnc_tree_model_account_clear_balances (NULL, NULL, model);
+        return;
+    }
     if (!GNC_IS_ACCOUNT(entity))
         return;
 
@@ -1309,6 +1452,10 @@ gnc_tree_model_account_event_handler (QofInstance *entity,
     priv = GNC_TREE_MODEL_ACCOUNT_GET_PRIVATE(model);
 
     account = GNC_ACCOUNT(entity);
+    gnc_tree_model_account_invalidate_balances (model, account);
+    if (event_type == QOF_EVENT_REMOVE && ed && ed->node)
+        gnc_tree_model_account_invalidate_balances (model, GNC_ACCOUNT(ed->node));
+
     if (gnc_account_get_book(account) != priv->book)
     {
         LEAVE("not in this book");
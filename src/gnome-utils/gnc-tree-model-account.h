@@ -189,6 +189,27 @@ gboolean gnc_tree_model_account_get_iter_from_account (GncTreeModelAccount *mode
  */
 GtkTreePath *gnc_tree_model_account_get_path_from_account (GncTreeModelAccount *model,
         Account *account);
+
+
+/** Get the amount shown in one of the balance columns of the model
+ *  for an account.  The amount is taken from the model's cache of
+ *  balance values, so this is much cheaper than recomputing the
+ *  balance, e.g. when sorting a view by a balance column.
+ *
+ *  @param model The model that an account belongs to.
+ *
+ *  @param account The account whose balance is wanted.
+ *
+ *  @param column One of the balance, cleared, reconciled, present,
+ *  future minimum or total columns, or their period and report
+ *  variants.
+ *
+ *  @return The balance as shown in that column, with the sign
+ *  reversed where the user asked for that.
+ */
+gnc_numeric gnc_tree_model_account_get_balance (GncTreeModelAccount *model,
+        Account *account,
+        GncTreeModelAccountColumn column);
 /** @} */
 
 G_END_DECLS
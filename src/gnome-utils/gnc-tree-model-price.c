@@ -129,6 +129,7 @@ typedef struct GncTreeModelPricePrivate
     GNCPriceDB *price_db;
     gint event_handler_id;
     GNCPrintAmountInfo print_info;
+    GHashTable *price_index;    /* commodity --> GPtrArray of its prices */
 } GncTreeModelPricePrivate;
 
 #define GNC_TREE_MODEL_PRICE_GET_PRIVATE(o)  \
@@ -201,6 +202,8 @@ gnc_tree_model_price_init (GncTreeModelPrice *model)
 
     priv = GNC_TREE_MODEL_PRICE_GET_PRIVATE(model);
     priv->print_info = gnc_share_print_info_places(6);
+    priv->price_index = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                        NULL, (GDestroyNotify) g_ptr_array_unref);
 }
 
 static void
@@ -219,6 +222,8 @@ gnc_tree_model_price_finalize (GObject *object)
 
     priv->book = NULL;
     priv->price_db = NULL;
+    g_hash_table_destroy (priv->price_index);
+    priv->price_index = NULL;
 
     G_OBJECT_CLASS (parent_class)->finalize (object);
     LEAVE(" ");
@@ -452,6 +457,158 @@ iter_to_string (GncTreeModelPrice *model, GtkTreeIter *iter)
 }
 
 
+/************************************************************/
+/*              Price Tree Model - Price Index              */
+/************************************************************/
+
+/* The price rows of a commodity are kept in an array per commodity,
+ * in the order of gnc_pricedb_get_prices, so that the nth row can be
+ * found without walking or merging the commodity's price series.
+ * The arrays are built when first needed and then kept up to date
+ * from the price events. */
+
+static gint
+price_index_compare (GNCPrice *a, GNCPrice *b)
+{
+    Timespec time_a = gnc_price_get_time (a);
+    Timespec time_b = gnc_price_get_time (b);
+    gint result = -timespec_cmp (&time_a, &time_b);
+
+    if (result)
+        return result;
+    return guid_compare (gnc_price_get_guid (a), gnc_price_get_guid (b));
+}
+
+/* The position of the first price in the array not before price. */
+static guint
+price_index_bisect (GPtrArray *prices, GNCPrice *price)
+{
+    guint lo = 0, hi = prices->len;
+
+    while (lo < hi)
+    {
+        guint mid = lo + (hi - lo) / 2;
+
+        if (price_index_compare (g_ptr_array_index (prices, mid), price) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/* The row of a price in the array, or -1 if it isn't there. */
+static gint
+price_index_find (GPtrArray *prices, GNCPrice *price)
+{
+    guint i = price_index_bisect (prices, price);
+
+    if (i < prices->len && g_ptr_array_index (prices, i) == price)
+        return i;
+
+    /* The price may have been edited since it was placed. */
+    for (i = 0; i < prices->len; i++)
+        if (g_ptr_array_index (prices, i) == price)
+            return i;
+    return -1;
+}
+
+/** Get the price rows of a commodity, building them if they aren't
+ *  known yet or no longer match the number of prices in the price
+ *  db, e.g. because prices were added while events were suspended.
+ *
+ *  @internal
+ */
+static GPtrArray *
+gnc_tree_model_price_get_prices (GncTreeModelPrice *model,
+                                 gnc_commodity *commodity)
+{
+    GncTreeModelPricePrivate *priv;
+    GPtrArray *prices;
+    GList *list, *node;
+    gint n;
+
+    priv = GNC_TREE_MODEL_PRICE_GET_PRIVATE(model);
+    n = gnc_pricedb_num_prices (priv->price_db, commodity);
+    prices = g_hash_table_lookup (priv->price_index, commodity);
+    if (prices && prices->len == (guint)n)
+        return prices;
+
+    DEBUG("indexing %d prices of %s", n, gnc_commodity_get_mnemonic (commodity));
+    prices = g_ptr_array_sized_new (n);
+    list = gnc_pricedb_get_prices (priv->price_db, commodity, NULL);
+    for (node = list; node; node = node->next)
+        g_ptr_array_add (prices, node->data);
+    gnc_price_list_destroy (list);
+
+    g_hash_table_replace (priv->price_index, commodity, prices);
+    return prices;
+}
+
+static GNCPrice *
+gnc_tree_model_price_nth_price (GncTreeModelPrice *model,
+                                gnc_commodity *commodity,
+                                gint n)
+{
+    GPtrArray *prices = gnc_tree_model_price_get_prices (model, commodity);
+
+    if (n < 0 || (guint)n >= prices->len)
+        return NULL;
+    return g_ptr_array_index (prices, n);
+}
+
+/** Add a price that was just added to the price db to its
+ *  commodity's rows, if they have been built.
+ *
+ *  @internal
+ */
+static void
+gnc_tree_model_price_index_add (GncTreeModelPrice *model, GNCPrice *price)
+{
+    GncTreeModelPricePrivate *priv;
+    GPtrArray *prices;
+    guint i;
+
+    priv = GNC_TREE_MODEL_PRICE_GET_PRIVATE(model);
+    prices = g_hash_table_lookup (priv->price_index,
+                                  gnc_price_get_commodity (price));
+    if (!prices)
+        return;
+
+    i = price_index_bisect (prices, price);
+    if (i < prices->len && g_ptr_array_index (prices, i) == price)
+        return;
+
+    g_ptr_array_add (prices, NULL);
+    memmove (prices->pdata + i + 1, prices->pdata + i,
+             (prices->len - 1 - i) * sizeof (gpointer));
+    prices->pdata[i] = price;
+}
+
+/** Drop a price that is being removed from the price db from its
+ *  commodity's rows.
+ *
+ *  @internal
+ */
+static void
+gnc_tree_model_price_index_remove (GncTreeModelPrice *model, GNCPrice *price)
+{
+    GncTreeModelPricePrivate *priv;
+    GPtrArray *prices;
+    gint i;
+
+    priv = GNC_TREE_MODEL_PRICE_GET_PRIVATE(model);
+    prices = g_hash_table_lookup (priv->price_index,
+                                  gnc_price_get_commodity (price));
+    if (!prices)
+        return;
+
+    i = price_index_find (prices, price);
+    if (i >= 0)
+        g_ptr_array_remove_index (prices, i);
+}
+
+
 /************************************************************/
 /*       Gtk Tree Model Required Interface Functions        */
 /************************************************************/
@@ -595,7 +752,7 @@ gnc_tree_model_price_get_iter (GtkTreeModel *tree_model,
 
     /* Verify the third part of the path: the price. */
     i = gtk_tree_path_get_indices (path)[2];
-    price = gnc_pricedb_nth_price(priv->price_db, commodity, i);
+    price = gnc_tree_model_price_nth_price(model, commodity, i);
     /* There's a race condition here that I can't resolve.
      * Comment this check out for now, and we'll handle the
      * resulting problem elsewhere. */
@@ -858,7 +1015,7 @@ gnc_tree_model_price_iter_next (GtkTreeModel *tree_model,
     {
         commodity = gnc_price_get_commodity((GNCPrice*)iter->user_data2);
         n = GPOINTER_TO_INT(iter->user_data3) + 1;
-        iter->user_data2 = gnc_pricedb_nth_price(priv->price_db, commodity, n);
+        iter->user_data2 = gnc_tree_model_price_nth_price(model, commodity, n);
         if (iter->user_data2 == NULL)
         {
             LEAVE("no next iter");
@@ -934,7 +1091,7 @@ gnc_tree_model_price_iter_children (GtkTreeModel *tree_model,
     {
         GNCPrice *price;
         commodity = (gnc_commodity *)parent->user_data2;
-        price = gnc_pricedb_nth_price(priv->price_db, commodity, 0);
+        price = gnc_tree_model_price_nth_price(model, commodity, 0);
         if (price == NULL)
         {
             LEAVE("no prices");
@@ -1096,7 +1253,7 @@ gnc_tree_model_price_iter_nth_child (GtkTreeModel *tree_model,
 
         iter->stamp      = model->stamp;
         iter->user_data  = ITER_IS_PRICE;
-        iter->user_data2 = gnc_pricedb_nth_price(priv->price_db, commodity, n);
+        iter->user_data2 = gnc_tree_model_price_nth_price(model, commodity, n);
         iter->user_data3 = GINT_TO_POINTER(n);
         LEAVE("price iter %p (%s)", iter, iter_to_string(model, iter));
         return iter->user_data2 != NULL;
@@ -1174,9 +1331,8 @@ gnc_tree_model_price_get_iter_from_price (GncTreeModelPrice *model,
         GNCPrice *price,
         GtkTreeIter *iter)
 {
-    GncTreeModelPricePrivate *priv;
     gnc_commodity *commodity;
-    GList *list;
+    GPtrArray *prices;
     gint n;
 
     ENTER("model %p, price %p, iter %p", model, price, iter);
@@ -1184,7 +1340,6 @@ gnc_tree_model_price_get_iter_from_price (GncTreeModelPrice *model,
     g_return_val_if_fail ((price != NULL), FALSE);
     g_return_val_if_fail ((iter != NULL), FALSE);
 
-    priv = GNC_TREE_MODEL_PRICE_GET_PRIVATE(model);
     commodity = gnc_price_get_commodity(price);
     if (commodity == NULL)
     {
@@ -1192,17 +1347,16 @@ gnc_tree_model_price_get_iter_from_price (GncTreeModelPrice *model,
         return FALSE;
     }
 
-    list = gnc_pricedb_get_prices(priv->price_db, commodity, NULL);
-    if (list == NULL)
+    prices = gnc_tree_model_price_get_prices(model, commodity);
+    if (prices->len == 0)
     {
         LEAVE("empty list");
         return FALSE;
     }
 
-    n = g_list_index(list, price);
+    n = price_index_find(prices, price);
     if (n == -1)
     {
-        gnc_price_list_destroy(list);
         LEAVE("not in list");
         return FALSE;
     }
@@ -1211,7 +1365,6 @@ gnc_tree_model_price_get_iter_from_price (GncTreeModelPrice *model,
     iter->user_data  = ITER_IS_PRICE;
     iter->user_data2 = price;
     iter->user_data3 = GINT_TO_POINTER(n);
-    gnc_price_list_destroy(list);
     LEAVE("iter %s", iter_to_string(model, iter));
     return TRUE;
 }
@@ -1576,6 +1729,7 @@ gnc_tree_model_price_event_handler (QofInstance *entity,
                                     gpointer event_data)
 {
     GncTreeModelPrice *model;
+    GncTreeModelPricePrivate *priv;
     GtkTreePath *path;
     GtkTreeIter iter;
     remove_data *data;
@@ -1591,6 +1745,7 @@ gnc_tree_model_price_event_handler (QofInstance *entity,
 
     /* hard failures */
     g_return_if_fail(GNC_IS_TREE_MODEL_PRICE(model));
+    priv = GNC_TREE_MODEL_PRICE_GET_PRIVATE(model);
 
     /* get type specific data */
     if (GNC_IS_COMMODITY(entity))
@@ -1599,7 +1754,9 @@ gnc_tree_model_price_event_handler (QofInstance *entity,
 
         commodity = GNC_COMMODITY(entity);
         name = gnc_commodity_get_mnemonic(commodity);
-        if (event_type != QOF_EVENT_DESTROY)
+        if (event_type == QOF_EVENT_DESTROY)
+            g_hash_table_remove (priv->price_index, commodity);
+        else
         {
             if (!gnc_tree_model_price_get_iter_from_commodity (model, commodity, &iter))
             {
@@ -1629,6 +1786,12 @@ gnc_tree_model_price_event_handler (QofInstance *entity,
 
         price = GNC_PRICE(entity);
         name = "price";
+        if (event_type == QOF_EVENT_ADD)
+            gnc_tree_model_price_index_add (model, price);
+        else if (event_type == QOF_EVENT_MODIFY)
+            /* Its date may have changed, so place it afresh. */
+            g_hash_table_remove (priv->price_index,
+                                 gnc_price_get_commodity (price));
         if (event_type != QOF_EVENT_DESTROY)
         {
             if (!gnc_tree_model_price_get_iter_from_price (model, price, &iter))
@@ -1661,6 +1824,9 @@ gnc_tree_model_price_event_handler (QofInstance *entity,
             return;
         }
 
+        if (GNC_IS_PRICE(entity))
+            gnc_tree_model_price_index_remove (model, GNC_PRICE(entity));
+
         data = g_new0 (remove_data, 1);
         data->model = model;
         data->path = path;
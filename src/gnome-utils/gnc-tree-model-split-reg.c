@@ -89,7 +89,7 @@ static gboolean	gnc_tree_model_split_reg_iter_parent (GtkTreeModel *tree_model,
 static void gtm_sr_increment_stamp (GncTreeModelSplitReg *model);
 
 
-static void gtm_sr_insert_trans (GncTreeModelSplitReg *model, Transaction *trans, gboolean before);
+static void gtm_sr_insert_trans (GncTreeModelSplitReg *model, Transaction *trans, gint position);
 static void gtm_sr_delete_trans (GncTreeModelSplitReg *model, Transaction *trans);
 
 /** Component Manager Callback ******************************************/
@@ -101,9 +101,10 @@ struct GncTreeModelSplitRegPrivate
     QofBook *book;                   // GNC Book
     Account *anchor;                 // Account of register
 
-    GList *full_tlist;               // List of unique transactions derived from the query slist in same order
-    GList *tlist;                    // List of unique transactions derived from the full_tlist to display in same order
-    gint   tlist_start;              // The position of the first transaction in tlist in the full_tlist
+    GPtrArray *full_tarray;          // Array of unique transactions derived from the query slist in same order
+    GHashTable *full_tindex;         // Position + 1 of each transaction in full_tarray, built on demand
+    GList *tlist;                    // List of unique transactions derived from the full_tarray to display in same order
+    gint   tlist_start;              // The position of the first transaction in tlist in the full_tarray
 
     Transaction *btrans;             // The Blank transaction
 
@@ -430,9 +431,14 @@ gnc_tree_model_split_reg_dispose (GObject *object)
     g_list_free (priv->tlist);
     priv->tlist = NULL;
 
-    /* Free the full_tlist */
-    g_list_free (priv->full_tlist);
-    priv->full_tlist = NULL;
+    /* Free the full transaction array */
+    if (priv->full_tarray)
+        g_ptr_array_free (priv->full_tarray, TRUE);
+    priv->full_tarray = NULL;
+
+    if (priv->full_tindex)
+        g_hash_table_destroy (priv->full_tindex);
+    priv->full_tindex = NULL;
 
     /* Free the blank split */
     priv->bsplit = NULL;
@@ -552,62 +558,232 @@ gtm_sr_remove_all_rows (GncTreeModelSplitReg *model)
     g_list_free (rr_list);
 }
 
+/* Number of transactions in the full array */
+static gint
+gtm_sr_full_tlist_length (GncTreeModelSplitReg *model)
+{
+    GPtrArray *tarray = model->priv->full_tarray;
+
+    return tarray ? tarray->len : 0;
+}
+
+
+/* Return the transaction at position in the full array, or NULL. */
+static Transaction *
+gtm_sr_full_tlist_nth (GncTreeModelSplitReg *model, gint position)
+{
+    GPtrArray *tarray = model->priv->full_tarray;
+
+    if (!tarray || position < 0 || position >= tarray->len)
+        return NULL;
+
+    return g_ptr_array_index (tarray, position);
+}
+
+
+/* The positions changed, the index will be rebuilt when next needed. */
 static void
-gtm_sr_reg_load (GncTreeModelSplitReg *model, GncTreeModelSplitRegUpdate model_update, gint num_of_rows)
+gtm_sr_full_tlist_invalidate_index (GncTreeModelSplitReg *model)
 {
-    GncTreeModelSplitRegPrivate *priv;
-    GList *node;
-    gint rows = 0;
+    GncTreeModelSplitRegPrivate *priv = model->priv;
 
-    priv = model->priv;
+    if (priv->full_tindex)
+        g_hash_table_destroy (priv->full_tindex);
+    priv->full_tindex = NULL;
+}
 
-    if (model_update == VIEW_HOME)
-    {
-        priv->tlist_start = 0;
 
-        for (node = g_list_nth (priv->full_tlist, priv->tlist_start); node; node = node->next)
-        {
-            Transaction *trans = node->data;
+/* Return the position of trans in the full array, or -1. */
+static gint
+gtm_sr_full_tlist_position (GncTreeModelSplitReg *model, Transaction *trans)
+{
+    GncTreeModelSplitRegPrivate *priv = model->priv;
+    guint i;
 
-            priv->tlist = g_list_append (priv->tlist, trans);
-            rows++;
+    if (!priv->full_tarray)
+        return -1;
 
-            if (rows == num_of_rows)
-                break;
-        } 
-    }
-    
-    if (model_update == VIEW_END)
+    if (!priv->full_tindex)
     {
-        priv->tlist_start = g_list_length (priv->full_tlist) - num_of_rows;
+        priv->full_tindex = g_hash_table_new (g_direct_hash, g_direct_equal);
+        for (i = 0; i < priv->full_tarray->len; i++)
+            g_hash_table_insert (priv->full_tindex,
+                                 g_ptr_array_index (priv->full_tarray, i),
+                                 GINT_TO_POINTER (i + 1));
+    }
 
-        for (node = g_list_nth (priv->full_tlist, priv->tlist_start); node; node = node->next)
-        {
-            Transaction *trans = node->data;
+    return GPOINTER_TO_INT (g_hash_table_lookup (priv->full_tindex, trans)) - 1;
+}
+
+
+/* Return TRUE if the full array is in posted date order. */
+static gboolean
+gtm_sr_full_tlist_by_date (GncTreeModelSplitReg *model)
+{
+    switch (model->sort_col)
+    {
+    case GNC_TREE_MODEL_SPLIT_REG_COL_DATE:
+        return (model->sort_depth == 1);
 
-            priv->tlist = g_list_append (priv->tlist, trans);
-            rows++;
+    case GNC_TREE_MODEL_SPLIT_REG_COL_DESCNOTES:
+    case GNC_TREE_MODEL_SPLIT_REG_COL_NUMACT:
+    case GNC_TREE_MODEL_SPLIT_REG_COL_RECN:
+    case GNC_TREE_MODEL_SPLIT_REG_COL_DEBIT:
+    case GNC_TREE_MODEL_SPLIT_REG_COL_CREDIT:
+        return FALSE;
 
-            if (rows == num_of_rows)
-                break;
-        } 
+    default:
+        return TRUE;
     }
+}
 
-    if (model_update == VIEW_GOTO)
+
+/* Return the position in the full array where trans belongs, found by
+ * bisecting the array in posted date order.  The blank transaction at
+ * either end is skipped. */
+static gint
+gtm_sr_full_tlist_bisect (GncTreeModelSplitReg *model, Transaction *trans)
+{
+    GncTreeModelSplitRegPrivate *priv = model->priv;
+    gint lo, hi, mid, cmp;
+
+    lo = 0;
+    hi = gtm_sr_full_tlist_length (model);
+
+    if (hi > lo && gtm_sr_full_tlist_nth (model, hi - 1) == priv->btrans)
+        hi--;
+    if (hi > lo && gtm_sr_full_tlist_nth (model, lo) == priv->btrans)
+        lo++;
+
+    while (lo < hi)
     {
-        priv->tlist_start = num_of_rows - NUM_OF_TRANS*1.5;
+        mid = (lo + hi) / 2;
+        cmp = xaccTransOrder (gtm_sr_full_tlist_nth (model, mid), trans);
 
-        for (node = g_list_nth (priv->full_tlist, priv->tlist_start); node; node = node->next)
-        {
-            Transaction *trans = node->data;
+        if (model->sort_direction == GTK_SORT_DESCENDING)
+            cmp = -cmp;
+
+        if (cmp <= 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+
+/* Insert trans into the full array at position. */
+static void
+gtm_sr_full_tlist_insert (GncTreeModelSplitReg *model, Transaction *trans, gint position)
+{
+    GPtrArray *tarray = model->priv->full_tarray;
+    gint i;
+
+    if (!tarray)
+        tarray = model->priv->full_tarray = g_ptr_array_new ();
+
+    position = CLAMP (position, 0, (gint) tarray->len);
+
+    g_ptr_array_add (tarray, NULL);
+    for (i = tarray->len - 1; i > position; i--)
+        g_ptr_array_index (tarray, i) = g_ptr_array_index (tarray, i - 1);
+    g_ptr_array_index (tarray, position) = trans;
+
+    if (position < model->priv->tlist_start)
+        model->priv->tlist_start++;
 
-            priv->tlist = g_list_append (priv->tlist, trans);
-            rows++;
+    model->number_of_trans_in_full_tlist = tarray->len;
+    gtm_sr_full_tlist_invalidate_index (model);
+}
+
+
+/* Remove trans from the full array. */
+static void
+gtm_sr_full_tlist_remove (GncTreeModelSplitReg *model, Transaction *trans)
+{
+    gint position = gtm_sr_full_tlist_position (model, trans);
+
+    if (position < 0)
+        return;
+
+    g_ptr_array_remove_index (model->priv->full_tarray, position);
+
+    if (position < model->priv->tlist_start)
+        model->priv->tlist_start--;
+
+    model->number_of_trans_in_full_tlist = model->priv->full_tarray->len;
+    gtm_sr_full_tlist_invalidate_index (model);
+}
 
-            if (rows == (NUM_OF_TRANS*3))
-                break;
-        } 
+
+/* Insert a transaction that was added to the register account at its
+ * place in the full array, and into the view if that place lies in the
+ * displayed window.  Returns TRUE if it was added to the view. */
+static gboolean
+gtm_sr_insert_new_trans (GncTreeModelSplitReg *model, Transaction *trans)
+{
+    GncTreeModelSplitRegPrivate *priv = model->priv;
+    gint position, tpos, tlen, full_len;
+
+    if (!gtm_sr_full_tlist_by_date (model))
+    {
+        gtm_sr_full_tlist_insert (model, trans, priv->tlist_start);
+        gtm_sr_insert_trans (model, trans, 0);
+        return TRUE;
     }
+
+    full_len = gtm_sr_full_tlist_length (model);
+    tlen = g_list_length (priv->tlist);
+
+    position = gtm_sr_full_tlist_bisect (model, trans);
+    tpos = position - priv->tlist_start;
+
+    gtm_sr_full_tlist_insert (model, trans, position);
+
+    if (tpos < 0 || tpos > tlen)
+        return FALSE;
+
+    if (tpos == tlen && priv->tlist_start + tlen < full_len)
+        return FALSE;
+
+    gtm_sr_insert_trans (model, trans, tpos);
+    return TRUE;
+}
+
+
+/* Fill the tlist with count transactions from the full array starting at start */
+static void
+gtm_sr_reg_load_window (GncTreeModelSplitReg *model, gint start, gint count)
+{
+    GncTreeModelSplitRegPrivate *priv;
+    gint i;
+
+    priv = model->priv;
+
+    if (start < 0)
+        start = 0;
+
+    priv->tlist_start = start;
+
+    for (i = start; i < gtm_sr_full_tlist_length (model) && i < start + count; i++)
+        priv->tlist = g_list_prepend (priv->tlist, gtm_sr_full_tlist_nth (model, i));
+
+    priv->tlist = g_list_reverse (priv->tlist);
+}
+
+
+static void
+gtm_sr_reg_load (GncTreeModelSplitReg *model, GncTreeModelSplitRegUpdate model_update, gint num_of_rows)
+{
+    if (model_update == VIEW_HOME)
+        gtm_sr_reg_load_window (model, 0, num_of_rows);
+
+    if (model_update == VIEW_END)
+        gtm_sr_reg_load_window (model, gtm_sr_full_tlist_length (model) - num_of_rows,
+                                num_of_rows);
+
+    if (model_update == VIEW_GOTO)
+        gtm_sr_reg_load_window (model, num_of_rows - NUM_OF_TRANS*1.5, NUM_OF_TRANS*3);
 }
 
 
@@ -625,54 +801,73 @@ gnc_tree_model_split_reg_load (GncTreeModelSplitReg *model, GList *slist, Accoun
 
     /* Clear the treeview */
     gtm_sr_remove_all_rows (model);
-    priv->full_tlist = NULL;
+    g_list_free (priv->tlist);
     priv->tlist = NULL;
 
+    if (priv->full_tarray)
+        g_ptr_array_free (priv->full_tarray, TRUE);
+    gtm_sr_full_tlist_invalidate_index (model);
+
     if (model->current_trans == NULL)
         model->current_trans = priv->btrans;
 
-    if (model->sort_direction == GTK_SORT_ASCENDING)
+    /* Get an array of unique transactions from the slist, with the
+     * blank transaction at the end */
+    priv->full_tarray = g_ptr_array_new ();
+    priv->full_tindex = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+    for (node = slist; node; node = node->next)
     {
-        /* Get a list of Unique Transactions from an slist */
-        priv->full_tlist = xaccSplitListGetUniqueTransactions (slist);
+        Transaction *trans = xaccSplitGetParent (node->data);
+
+        if (g_hash_table_lookup (priv->full_tindex, trans))
+            continue;
 
-        /* Add the blank transaction to the full_tlist */
-        priv->full_tlist = g_list_append (priv->full_tlist, priv->btrans);
+        g_ptr_array_add (priv->full_tarray, trans);
+        g_hash_table_insert (priv->full_tindex, trans,
+                             GINT_TO_POINTER (priv->full_tarray->len));
     }
-    else
-    {
-        /* Get a list of Unique Transactions from an slist */
-        priv->full_tlist = xaccSplitListGetUniqueTransactions (slist);
+    g_ptr_array_add (priv->full_tarray, priv->btrans);
+    g_hash_table_insert (priv->full_tindex, priv->btrans,
+                         GINT_TO_POINTER (priv->full_tarray->len));
 
-        /* Add the blank transaction to the full_tlist */
-        priv->full_tlist = g_list_append (priv->full_tlist, priv->btrans);
+    if (model->sort_direction != GTK_SORT_ASCENDING)
+    {
+        guint i, len = priv->full_tarray->len;
 
-        /* Reverse the full_tlist */
-        priv->full_tlist = g_list_reverse (priv->full_tlist);
+        /* Reverse the full array */
+        for (i = 0; i < len / 2; i++)
+        {
+            gpointer tmp = g_ptr_array_index (priv->full_tarray, i);
+            g_ptr_array_index (priv->full_tarray, i) =
+                g_ptr_array_index (priv->full_tarray, len - 1 - i);
+            g_ptr_array_index (priv->full_tarray, len - 1 - i) = tmp;
+        }
+        gtm_sr_full_tlist_invalidate_index (model);
     }
 
     // Update the scrollbar
     gnc_tree_model_split_reg_sync_scrollbar (model);
 
-    model->number_of_trans_in_full_tlist = g_list_length (priv->full_tlist);
+    model->number_of_trans_in_full_tlist = gtm_sr_full_tlist_length (model);
 
-    if (g_list_length (priv->full_tlist) < NUM_OF_TRANS*3)
+    if (gtm_sr_full_tlist_length (model) < NUM_OF_TRANS*3)
     {
-        // Copy the full_tlist to tlist
-        priv->tlist = g_list_copy (priv->full_tlist);
+        // Copy the full array to tlist
+        gtm_sr_reg_load_window (model, 0, gtm_sr_full_tlist_length (model));
     }
     else
     {
         if (model->position_of_trans_in_full_tlist < (NUM_OF_TRANS*3))
             gtm_sr_reg_load (model, VIEW_HOME, NUM_OF_TRANS*3);
-        else if (model->position_of_trans_in_full_tlist > g_list_length (priv->full_tlist) - (NUM_OF_TRANS*3))
+        else if (model->position_of_trans_in_full_tlist > gtm_sr_full_tlist_length (model) - (NUM_OF_TRANS*3))
             gtm_sr_reg_load (model, VIEW_END, NUM_OF_TRANS*3);
         else
             gtm_sr_reg_load (model, VIEW_GOTO, model->position_of_trans_in_full_tlist);
     }
 
     PINFO("#### Register for Account '%s' has %d transactions and %d splits and tlist is %d ####",
-          default_account ? xaccAccountGetName (default_account) : "NULL", g_list_length (priv->full_tlist), g_list_length (slist), g_list_length (priv->tlist));
+          default_account ? xaccAccountGetName (default_account) : "NULL", gtm_sr_full_tlist_length (model), g_list_length (slist), g_list_length (priv->tlist));
 
     /* Update the completion model liststores */
     g_idle_add ((GSourceFunc) gnc_tree_model_split_reg_update_completion, model);
@@ -688,15 +883,17 @@ void
 gnc_tree_model_split_reg_move (GncTreeModelSplitReg *model, GncTreeModelSplitRegUpdate model_update)
 {
     GncTreeModelSplitRegPrivate *priv;
-    GList *inode, *dnode;
-    gint rows = 0;
+    gint full_len;
     gint icount = 0;
     gint dcount = 0;
+    gint i;
 
     priv = model->priv;
 
+    full_len = gtm_sr_full_tlist_length (model);
+
     // if list is not long enougth, return
-    if (g_list_length (priv->full_tlist) < NUM_OF_TRANS*3)
+    if (full_len < NUM_OF_TRANS*3)
         return;
 
     if ((model_update == VIEW_UP) && (model->current_row < NUM_OF_TRANS) && (priv->tlist_start > 0))
@@ -717,34 +914,19 @@ gnc_tree_model_split_reg_move (GncTreeModelSplitReg *model, GncTreeModelSplitReg
         priv->tlist_start = iblock_start;
 
         // Insert at the front end
-        for (inode = g_list_nth (priv->full_tlist, iblock_end); inode; inode = inode->prev)
-        {
-            Transaction *trans = inode->data;
-
-            gtm_sr_insert_trans (model, trans, TRUE);
+        for (i = iblock_end; i >= iblock_start; i--)
+            gtm_sr_insert_trans (model, gtm_sr_full_tlist_nth (model, i), 0);
 
-            rows++;
-
-            if (rows == icount)
-                break;
-        }
-        rows = 0;
         // Delete at the back end
-        for (dnode = g_list_nth (priv->full_tlist, dblock_end); dnode; dnode = dnode->prev)
+        if (dblock_end < full_len)
         {
-            Transaction *trans = dnode->data;
-
-            gtm_sr_delete_trans (model, trans);
-
-            rows++;
-
-            if (rows == dcount)
-                break;
+            for (i = dblock_end; i >= 0 && i > dblock_end - dcount; i--)
+                gtm_sr_delete_trans (model, gtm_sr_full_tlist_nth (model, i));
         }
         g_signal_emit_by_name (model, "refresh_view");
     }
 
-    if ((model_update == VIEW_DOWN) && (model->current_row > NUM_OF_TRANS*2) && (priv->tlist_start < (g_list_length (priv->full_tlist) - NUM_OF_TRANS*3 )))
+    if ((model_update == VIEW_DOWN) && (model->current_row > NUM_OF_TRANS*2) && (priv->tlist_start < (full_len - NUM_OF_TRANS*3 )))
     {
         gint dblock_end = 0;
         gint iblock_start = priv->tlist_start + NUM_OF_TRANS*3;
@@ -754,8 +936,8 @@ gnc_tree_model_split_reg_move (GncTreeModelSplitReg *model, GncTreeModelSplitReg
         if (iblock_start < 0)
             iblock_start = 0;
 
-        if (iblock_end > g_list_length (priv->full_tlist))
-            iblock_end = g_list_length (priv->full_tlist) - 1;
+        if (iblock_end > full_len)
+            iblock_end = full_len - 1;
 
         icount = iblock_end - iblock_start + 1;
 
@@ -765,30 +947,13 @@ gnc_tree_model_split_reg_move (GncTreeModelSplitReg *model, GncTreeModelSplitReg
         priv->tlist_start = dblock_end;
 
         // Insert at the back end
-        for (inode = g_list_nth (priv->full_tlist, iblock_start); inode; inode = inode->next)
-        {
-            Transaction *trans = inode->data;
+        for (i = iblock_start; i < full_len && i < iblock_start + icount; i++)
+            gtm_sr_insert_trans (model, gtm_sr_full_tlist_nth (model, i), -1);
 
-            gtm_sr_insert_trans (model, trans, FALSE);
-
-            rows++;
-
-            if (rows == icount)
-                break;
-        }
-        rows = 0;
         // Delete at the front end
-        for (dnode = g_list_nth (priv->full_tlist, dblock_start); dnode; dnode = dnode->next)
-        {
-            Transaction *trans = dnode->data;
-
-            gtm_sr_delete_trans (model, trans);
+        for (i = dblock_start; i < full_len && i < dblock_start + dcount; i++)
+            gtm_sr_delete_trans (model, gtm_sr_full_tlist_nth (model, i));
 
-            rows++;
-
-            if (rows == dcount)
-                break;
-        }
         g_signal_emit_by_name (model, "refresh_view");
     }
 }
@@ -799,20 +964,15 @@ Transaction *
 gnc_tree_model_split_reg_get_first_trans (GncTreeModelSplitReg *model)
 {
     GncTreeModelSplitRegPrivate *priv;
-    GList *node;
     Transaction *trans;
 
     priv = model->priv;
 
-    node = g_list_first (priv->full_tlist);
-
-    trans = node->data;
+    trans = gtm_sr_full_tlist_nth (model, 0);
 
     if (trans == priv->btrans)
-    {
-        node = g_list_last (priv->full_tlist);
-        trans = node->data;
-    }
+        trans = gtm_sr_full_tlist_nth (model, gtm_sr_full_tlist_length (model) - 1);
+
     return trans;
 }
 
@@ -841,16 +1001,14 @@ gnc_tree_model_split_reg_get_tooltip (GncTreeModelSplitReg *model, gint position
     const gchar *date_text;
     const gchar *desc_text;
     Timespec ts = {0,0};
-    GList *node;
 
     priv = model->priv;
 
-    node = g_list_nth (priv->full_tlist, position);
-    if (node == NULL)
+    if (position < 0 || position >= gtm_sr_full_tlist_length (model))
        return g_strconcat ("Error", NULL);
     else
     {
-        trans = node->data;
+        trans = gtm_sr_full_tlist_nth (model, position);
         if (trans == NULL)
            return g_strconcat ("Error", NULL);
         else if (trans == priv->btrans)
@@ -871,16 +1029,13 @@ gnc_tree_model_split_reg_get_tooltip (GncTreeModelSplitReg *model, gint position
 void
 gnc_tree_model_split_reg_set_current_trans_by_position (GncTreeModelSplitReg *model, gint position)
 {
-    GncTreeModelSplitRegPrivate *priv;
-    GList *node;
-
-    priv = model->priv;
+    Transaction *trans;
 
-    node = g_list_nth (priv->full_tlist, position);
-    if (node == NULL)
-        node = g_list_last (priv->full_tlist);
+    trans = gtm_sr_full_tlist_nth (model, position);
+    if (trans == NULL)
+        trans = gtm_sr_full_tlist_nth (model, gtm_sr_full_tlist_length (model) - 1);
 
-    model->current_trans = node->data;
+    model->current_trans = trans;
 }
 
 
@@ -888,11 +1043,7 @@ gnc_tree_model_split_reg_set_current_trans_by_position (GncTreeModelSplitReg *mo
 void
 gnc_tree_model_split_reg_sync_scrollbar (GncTreeModelSplitReg *model)
 {
-    GncTreeModelSplitRegPrivate *priv;
-
-    priv = model->priv;
-
-    model->position_of_trans_in_full_tlist = g_list_index (priv->full_tlist, model->current_trans);
+    model->position_of_trans_in_full_tlist = gtm_sr_full_tlist_position (model, model->current_trans);
 
     g_signal_emit_by_name (model, "scroll_sync");
 }
@@ -2424,20 +2575,20 @@ gtm_sr_changed_row_at (GncTreeModelSplitReg *model, GtkTreeIter *iter)
 }
 
 
-/* Insert transaction into model */
+/* Insert transaction into model at position in the tlist, -1 appends */
 static void
-gtm_sr_insert_trans (GncTreeModelSplitReg *model, Transaction *trans, gboolean before)
+gtm_sr_insert_trans (GncTreeModelSplitReg *model, Transaction *trans, gint position)
 {
     GtkTreeIter iter;
     GtkTreePath *path;
     GList *tnode = NULL, *snode = NULL;
 
-    ENTER("insert transaction %p into model %p", trans, model);
-    if (before == TRUE)
-        model->priv->tlist = g_list_prepend (model->priv->tlist, trans);
+    ENTER("insert transaction %p into model %p at %d", trans, model, position);
+    model->priv->tlist = g_list_insert (model->priv->tlist, trans, position);
+    if (position < 0)
+        tnode = g_list_last (model->priv->tlist);
     else
-        model->priv->tlist = g_list_append (model->priv->tlist, trans);
-    tnode = g_list_find (model->priv->tlist, trans);
+        tnode = g_list_nth (model->priv->tlist, position);
 
     iter = gtm_sr_make_iter (model, TROW1, tnode, NULL);
     gtm_sr_insert_row_at (model, &iter);
@@ -3236,6 +3387,8 @@ gnc_tree_model_split_reg_event_handler (QofInstance *entity,
             if (priv->btrans == trans)
             {
                 priv->btrans = xaccMallocTransaction (priv->book);
+                gtm_sr_full_tlist_insert (model, priv->btrans,
+                                          priv->tlist_start + g_list_length (priv->tlist));
                 priv->tlist = g_list_append (priv->tlist, priv->btrans);
 
                 tnode = g_list_find (priv->tlist, priv->btrans);
@@ -3258,20 +3411,32 @@ gnc_tree_model_split_reg_event_handler (QofInstance *entity,
         case QOF_EVENT_DESTROY:
             if (priv->btrans == trans)
             {
+                gint position = gtm_sr_full_tlist_position (model, trans);
+
                 tnode = g_list_find (priv->tlist, priv->btrans);
                 priv->btrans = xaccMallocTransaction (priv->book);
                 tnode->data = priv->btrans;
+                if (position >= 0)
+                {
+                    g_ptr_array_index (priv->full_tarray, position) = priv->btrans;
+                    gtm_sr_full_tlist_invalidate_index (model);
+                }
                 iter1 = gtm_sr_make_iter (model, TROW1 | BLANK, tnode, NULL);
                 gtm_sr_changed_row_at (model, &iter1);
                 iter2 = gtm_sr_make_iter (model, TROW2 | BLANK, tnode, NULL);
                 gtm_sr_changed_row_at (model, &iter2);
             }
-            else if (get_iter (model, trans, NULL, &iter1, &iter2))
+            else
             {
-                DEBUG("destroy trans %p (%s)", trans, name);
-                g_signal_emit_by_name (model, "selection_move_delete", trans);
-                gtm_sr_delete_trans (model, trans);
-                g_signal_emit_by_name (model, "refresh_trans", trans);
+                gtm_sr_full_tlist_remove (model, trans);
+
+                if (get_iter (model, trans, NULL, &iter1, &iter2))
+                {
+                    DEBUG("destroy trans %p (%s)", trans, name);
+                    g_signal_emit_by_name (model, "selection_move_delete", trans);
+                    gtm_sr_delete_trans (model, trans);
+                    g_signal_emit_by_name (model, "refresh_trans", trans);
+                }
             }
             break;
         default:
@@ -3295,15 +3460,15 @@ gnc_tree_model_split_reg_event_handler (QofInstance *entity,
                 if (g_strcmp0 (gnc_commodity_get_namespace (split_com), "template") != 0)
                 {
                     DEBUG("Insert trans %p for gl (%s)", trans, name);
-                    gtm_sr_insert_trans (model, trans, TRUE);
-                    g_signal_emit_by_name (model, "refresh_trans", trans);
+                    if (gtm_sr_insert_new_trans (model, trans))
+                        g_signal_emit_by_name (model, "refresh_trans", trans);
                 }
             }
             else if (!g_list_find (priv->tlist, trans) && ((xaccAccountHasAncestor (acc, priv->anchor) && priv->display_subacc) || acc == priv->anchor ))
             {
                 DEBUG("Insert trans %p (%s)", trans, name);
-                gtm_sr_insert_trans (model, trans, TRUE);
-                g_signal_emit_by_name (model, "refresh_trans", trans);
+                if (gtm_sr_insert_new_trans (model, trans))
+                    g_signal_emit_by_name (model, "refresh_trans", trans);
             }
             break;
         default:
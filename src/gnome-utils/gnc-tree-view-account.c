@@ -339,24 +339,30 @@ sort_by_code (GtkTreeModel *f_model,
     return xaccAccountOrder(account_a, account_b);
 }
 
+/* The balances come from the account tree model's cache, so sorting
+ * doesn't recompute every balance for every comparison. */
 static gint
-sort_by_xxx_value (xaccGetBalanceInCurrencyFn fn,
-                   gboolean recurse,
+sort_by_xxx_value (GncTreeModelAccountColumn column,
                    GtkTreeModel *f_model,
                    GtkTreeIter *f_iter_a,
                    GtkTreeIter *f_iter_b,
                    gpointer user_data)
 {
+    GtkTreeModel *model;
+    GtkTreeIter iter_a, iter_b;
     const Account *account_a, *account_b;
     gnc_numeric balance_a, balance_b;
     gint result;
 
     /* Find the accounts */
-    sort_cb_setup (f_model, f_iter_a, f_iter_b, &account_a, &account_b);
+    model = sort_cb_setup_w_iters (f_model, f_iter_a, f_iter_b,
+                                   &iter_a, &iter_b, &account_a, &account_b);
 
     /* Get balances */
-    balance_a = gnc_ui_account_get_balance_full(fn, account_a, recurse, NULL, NULL);
-    balance_b = gnc_ui_account_get_balance_full(fn, account_b, recurse, NULL, NULL);
+    balance_a = gnc_tree_model_account_get_balance (GNC_TREE_MODEL_ACCOUNT(model),
+                (Account *)account_a, column);
+    balance_b = gnc_tree_model_account_get_balance (GNC_TREE_MODEL_ACCOUNT(model),
+                (Account *)account_b, column);
 
     result = gnc_numeric_compare(balance_a, balance_b);
     if (result != 0)
@@ -370,7 +376,7 @@ sort_by_present_value (GtkTreeModel *f_model,
                        GtkTreeIter *f_iter_b,
                        gpointer user_data)
 {
-    return sort_by_xxx_value (xaccAccountGetPresentBalanceInCurrency, TRUE,
+    return sort_by_xxx_value (GNC_TREE_MODEL_ACCOUNT_COL_PRESENT,
                               f_model, f_iter_a, f_iter_b, user_data);
 }
 
@@ -380,7 +386,7 @@ sort_by_balance_value (GtkTreeModel *f_model,
                        GtkTreeIter *f_iter_b,
                        gpointer user_data)
 {
-    return sort_by_xxx_value (xaccAccountGetBalanceInCurrency, TRUE,
+    return sort_by_xxx_value (GNC_TREE_MODEL_ACCOUNT_COL_TOTAL,
                               f_model, f_iter_a, f_iter_b, user_data);
 }
 
@@ -390,7 +396,7 @@ sort_by_cleared_value (GtkTreeModel *f_model,
                        GtkTreeIter *f_iter_b,
                        gpointer user_data)
 {
-    return sort_by_xxx_value (xaccAccountGetClearedBalanceInCurrency, TRUE,
+    return sort_by_xxx_value (GNC_TREE_MODEL_ACCOUNT_COL_CLEARED,
                               f_model, f_iter_a, f_iter_b, user_data);
 }
 
@@ -400,7 +406,7 @@ sort_by_reconciled_value (GtkTreeModel *f_model,
                           GtkTreeIter *f_iter_b,
                           gpointer user_data)
 {
-    return sort_by_xxx_value (xaccAccountGetReconciledBalanceInCurrency, TRUE,
+    return sort_by_xxx_value (GNC_TREE_MODEL_ACCOUNT_COL_RECONCILED,
                               f_model, f_iter_a, f_iter_b, user_data);
 }
 
@@ -410,7 +416,7 @@ sort_by_future_min_value (GtkTreeModel *f_model,
                           GtkTreeIter *f_iter_b,
                           gpointer user_data)
 {
-    return sort_by_xxx_value (xaccAccountGetProjectedMinimumBalanceInCurrency, TRUE,
+    return sort_by_xxx_value (GNC_TREE_MODEL_ACCOUNT_COL_FUTURE_MIN,
                               f_model, f_iter_a, f_iter_b, user_data);
 }
 
@@ -420,7 +426,7 @@ sort_by_total_value (GtkTreeModel *f_model,
                      GtkTreeIter *f_iter_b,
                      gpointer user_data)
 {
-    return sort_by_xxx_value (xaccAccountGetBalanceInCurrency, TRUE,
+    return sort_by_xxx_value (GNC_TREE_MODEL_ACCOUNT_COL_TOTAL,
                               f_model, f_iter_a, f_iter_b, user_data);
 }
 
@@ -447,39 +453,14 @@ sort_by_placeholder (GtkTreeModel *f_model,
     return xaccAccountOrder(account_a, account_b);
 }
 
-static gint
-sort_by_xxx_period_value (GtkTreeModel *f_model,
-                          GtkTreeIter *f_iter_a,
-                          GtkTreeIter *f_iter_b,
-                          gboolean recurse)
-{
-    Account *acct1, *acct2;
-    time64 t1, t2;
-    gnc_numeric b1, b2;
-    gint result;
-
-    sort_cb_setup (f_model, f_iter_a, f_iter_b,
-                   (const Account **)&acct1, (const Account **)&acct2);
-
-    t1 = gnc_accounting_period_fiscal_start();
-    t2 = gnc_accounting_period_fiscal_end();
-
-    b1 = xaccAccountGetBalanceChangeForPeriod(acct1, t1, t2, recurse);
-    b2 = xaccAccountGetBalanceChangeForPeriod(acct2, t1, t2, recurse);
-
-    result = gnc_numeric_compare(b1, b2);
-    if (result != 0)
-        return result;
-    return xaccAccountOrder(acct1, acct2);
-}
-
 static gint
 sort_by_balance_period_value (GtkTreeModel *f_model,
                               GtkTreeIter *f_iter_a,
                               GtkTreeIter *f_iter_b,
                               gpointer user_data)
 {
-    return sort_by_xxx_period_value (f_model, f_iter_a, f_iter_b, FALSE);
+    return sort_by_xxx_value (GNC_TREE_MODEL_ACCOUNT_COL_BALANCE_PERIOD,
+                              f_model, f_iter_a, f_iter_b, user_data);
 }
 
 static gint
@@ -488,7 +469,8 @@ sort_by_total_period_value (GtkTreeModel *f_model,
                             GtkTreeIter *f_iter_b,
                             gpointer user_data)
 {
-    return sort_by_xxx_period_value (f_model, f_iter_a, f_iter_b, TRUE);
+    return sort_by_xxx_value (GNC_TREE_MODEL_ACCOUNT_COL_TOTAL_PERIOD,
+                              f_model, f_iter_a, f_iter_b, user_data);
 }
 
 /************************************************************/
@@ -1092,7 +1092,7 @@ on_finish (GtkAssistant  *gtkassistant,
     if (data->new_book)
         gtk_dialog_response(GTK_DIALOG(gnc_options_dialog_widget (data->optionwin)), GTK_RESPONSE_CANCEL);
 
-    account_trees_merge(gnc_get_current_root_account(), data->our_account_tree);
+    account_trees_merge_bulk(gnc_get_current_root_account(), data->our_account_tree);
 
     delete_our_account_tree (data);
 
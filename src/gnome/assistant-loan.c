@@ -37,6 +37,7 @@
 #include "gnc-account-sel.h"
 #include "gnc-date.h"
 #include "gnc-exp-parser.h"
+#include "gnc-amortize.h"
 #include "gnc-component-manager.h"
 #include "dialog-utils.h"
 #include "Account.h"
@@ -2028,6 +2029,9 @@ loan_rev_recalc_schedule( LoanAssistantData *ldd )
         GString *pmtFormula, *ppmtFormula, *ipmtFormula;
         int i;
         GHashTable *ivar;
+        GncLoanTerms loan;
+        GncAmortRow *amortRows = NULL;
+        gboolean isInterest;
 
         pmtFormula = g_string_sized_new( 64 );
         loan_get_pmt_formula( ldd, pmtFormula );
@@ -2036,6 +2040,20 @@ loan_rev_recalc_schedule( LoanAssistantData *ldd )
         ipmtFormula = g_string_sized_new( 64 );
         loan_get_ipmt_formula( ldd, ipmtFormula );
 
+        /* Work out the whole schedule at once rather than evaluating
+         * the formulas for each payment; the formulas are only
+         * evaluated past its end. */
+        loan.denom = 100;
+        if ( gnc_amortize_formula_terms( ipmtFormula->str, &loan, &isInterest ) )
+        {
+            amortRows = g_new( GncAmortRow, loan.n_periods );
+            if ( !gnc_amortize_schedules( &loan, 1, amortRows ) )
+            {
+                g_free( amortRows );
+                amortRows = NULL;
+            }
+        }
+
         ivar = g_hash_table_new( g_str_hash, g_str_equal );
         g_date_clear( &curDate, 1 );
         curDate = start;
@@ -2073,6 +2091,14 @@ loan_rev_recalc_schedule( LoanAssistantData *ldd )
                                      (gpointer)rowNumData );
             }
 
+            if ( amortRows != NULL && i <= loan.n_periods )
+            {
+                rowNumData[0] = amortRows[i - 1].payment;
+                rowNumData[1] = amortRows[i - 1].principal;
+                rowNumData[2] = amortRows[i - 1].interest;
+                continue;
+            }
+
             /* evaluate the expressions given the correct
              * sequence number i */
             ival = gnc_numeric_create( i, 1 );
@@ -2106,6 +2132,7 @@ loan_rev_recalc_schedule( LoanAssistantData *ldd )
             rowNumData[2] = val;
         }
 
+        g_free( amortRows );
         g_string_free( ipmtFormula, TRUE );
         g_string_free( ppmtFormula, TRUE );
         g_string_free( pmtFormula, TRUE );
@@ -93,6 +93,7 @@ static void gnc_main_window_cmd_tools_price_editor (GtkAction *action, GncMainWi
 static void gnc_main_window_cmd_tools_imap_editor (GtkAction *action, GncMainWindowActionData *data);
 static void gnc_main_window_cmd_tools_trans_assoc (GtkAction *action, GncMainWindowActionData *data);
 static void gnc_main_window_cmd_tools_commodity_editor (GtkAction *action, GncMainWindowActionData *data);
+static void gnc_main_window_cmd_extensions_memory_stats (GtkAction *action, GncMainWindowActionData *data);
 static void gnc_main_window_cmd_help_totd (GtkAction *action, GncMainWindowActionData *data);
 
 
@@ -216,6 +217,13 @@ static GtkActionEntry gnc_plugin_actions [] =
         G_CALLBACK (gnc_main_window_cmd_tools_trans_assoc)
     },
 
+    /* Extensions menu */
+    {
+        "ExtensionsMemoryStatsAction", NULL, N_("_Memory Statistics"), NULL,
+        N_("Show the number and memory use of the objects in the book"),
+        G_CALLBACK (gnc_main_window_cmd_extensions_memory_stats)
+    },
+
     /* Help menu */
 
     {
@@ -673,6 +681,20 @@ gnc_main_window_cmd_tools_find_transactions (GtkAction *action, GncMainWindowAct
 #endif
 }
 
+static void
+gnc_main_window_cmd_extensions_memory_stats (GtkAction *action, GncMainWindowActionData *data)
+{
+    gchar *stats;
+
+    g_return_if_fail (data != NULL);
+
+    stats = qof_book_type_stats_to_string (gnc_get_current_book ());
+    /* The log keeps the table's columns lined up. */
+    g_message ("Memory statistics:\n%s", stats);
+    gnc_info_dialog (GTK_WIDGET (data->window), "%s", stats);
+    g_free (stats);
+}
+
 static void
 gnc_main_window_cmd_help_totd (GtkAction *action, GncMainWindowActionData *data)
 {
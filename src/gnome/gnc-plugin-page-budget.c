@@ -855,7 +855,7 @@ estimate_budget_helper(GtkTreeModel *model, GtkTreePath *path,
 {
     Account *acct;
     guint num_periods, i;
-    gnc_numeric num;
+    gnc_numeric num, *values;
     GncPluginPageBudgetPrivate *priv;
     GncPluginPageBudget *page = data;
 
@@ -865,10 +865,12 @@ estimate_budget_helper(GtkTreeModel *model, GtkTreePath *path,
     acct = gnc_budget_view_get_account_from_path(priv->budget_view, path);
 
     num_periods = gnc_budget_get_num_periods(priv->budget);
+    values = g_new(gnc_numeric, MAX(num_periods, 1));
+    recurrenceGetAccountPeriodValues(&priv->r, acct, num_periods, values);
 
     for (i = 0; i < num_periods; i++)
     {
-        num = recurrenceGetAccountPeriodValue(&priv->r, acct, i);
+        num = values[i];
         if (!gnc_numeric_check(num))
         {
             if (gnc_reverse_balance (acct))
@@ -881,6 +883,7 @@ estimate_budget_helper(GtkTreeModel *model, GtkTreePath *path,
                 priv->budget, acct, i, num);
         }
     }
+    g_free(values);
 }
 
 
@@ -85,6 +85,8 @@ static void gsr_update_summary_label( GtkWidget *label,
                                       gboolean euroFlag );
 
 static void gsr_redraw_all_cb (GnucashRegister *g_reg, gpointer data);
+static void gsr_vadjustment_value_changed_cb (GtkAdjustment *adj,
+        GNCSplitReg *gsr);
 
 static void gnc_split_reg_ld_destroy( GNCLedgerDisplay *ledger );
 
@@ -414,6 +416,11 @@ gsr_create_table( GNCSplitReg *gsr )
                       G_CALLBACK(gsr_redraw_all_cb), gsr);
     g_signal_connect (gsr->reg, "redraw_help",
                       G_CALLBACK(gsr_emit_help_changed), gsr);
+    g_signal_connect_object (gtk_layout_get_vadjustment (
+                                 GTK_LAYOUT(gnucash_register_get_sheet (gsr->reg))),
+                             "value_changed",
+                             G_CALLBACK(gsr_vadjustment_value_changed_cb),
+                             gsr, 0);
 
     LEAVE(" ");
 }
@@ -494,6 +501,17 @@ gsr_update_summary_label( GtkWidget *label,
     gtk_label_set_text( GTK_LABEL(label), string );
 }
 
+/* A register whose transactions are loaded a page at a time loads the
+ * page before once it is scrolled to the top. */
+static void
+gsr_vadjustment_value_changed_cb (GtkAdjustment *adj, GNCSplitReg *gsr)
+{
+    if (gtk_adjustment_get_value (adj) > gtk_adjustment_get_lower (adj))
+        return;
+
+    gnc_ledger_display_load_more (gsr->ledger);
+}
+
 static
 void
 gsr_redraw_all_cb (GnucashRegister *g_reg, gpointer data)
@@ -2198,6 +2216,7 @@ static
 void
 gsr_emit_include_date_signal( GNCSplitReg *gsr, time64 date )
 {
+    gnc_ledger_display_include_date( gsr->ledger, date );
     g_signal_emit_by_name( gsr, "include-date", date, NULL );
 }
 
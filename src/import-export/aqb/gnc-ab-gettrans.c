@@ -44,45 +44,61 @@
 /* This static indicates the debugging module that this .o belongs to.  */
 G_GNUC_UNUSED static QofLogModule log_module = G_LOG_DOMAIN;
 
-static gboolean gettrans_dates(GtkWidget *parent, Account *gnc_acc, GWEN_TIME **from_date, GWEN_TIME **to_date);
+/* The GetTransactions job of one account of a run */
+typedef struct
+{
+    Account *gnc_acc;
+    AB_JOB *job;
+} GettransJob;
+
+static gboolean gettrans_dates(GtkWidget *parent, GList *accounts,
+                               gboolean *use_last_date, GWEN_TIME **from_date,
+                               GWEN_TIME **to_date);
 
 static gboolean
-gettrans_dates(GtkWidget *parent, Account *gnc_acc,
+gettrans_dates(GtkWidget *parent, GList *accounts, gboolean *use_last_date,
                GWEN_TIME **from_date, GWEN_TIME **to_date)
 {
     Timespec last_timespec, until_timespec;
     time64 now = gnc_time (NULL);
-    gboolean use_last_date = TRUE;
     gboolean use_earliest_date = TRUE;
     gboolean use_until_now = TRUE;
+    GList *node;
 
-    g_return_val_if_fail(from_date && to_date, FALSE);
+    g_return_val_if_fail(use_last_date && from_date && to_date, FALSE);
 
-    /* Get time of last retrieval */
-    last_timespec = gnc_ab_get_account_trans_retrieval(gnc_acc);
-    if (last_timespec.tv_sec == 0)
+    /* Get time of the earliest last retrieval.  Only offer to start from
+     * the last retrieval if every account has one. */
+    *use_last_date = TRUE;
+    timespecFromTime64 (&last_timespec, now);
+    for (node = accounts; node; node = node->next)
     {
-        use_last_date = FALSE;
-        timespecFromTime64 (&last_timespec, now);
+        Timespec acc_timespec = gnc_ab_get_account_trans_retrieval(node->data);
+        if (acc_timespec.tv_sec == 0)
+            *use_last_date = FALSE;
+        else if (timespec_cmp(&acc_timespec, &last_timespec) < 0)
+            last_timespec = acc_timespec;
     }
+    if (!*use_last_date)
+        timespecFromTime64 (&last_timespec, now);
     timespecFromTime64 (&until_timespec, now);
 
     /* Let the user choose the date range of retrieval */
     if (!gnc_ab_enter_daterange(parent, NULL,
                                 &last_timespec,
-                                &use_last_date, &use_earliest_date,
+                                use_last_date, &use_earliest_date,
                                 &until_timespec, &use_until_now))
         return FALSE;
 
-    /* Now calculate from date */
+    /* Now calculate from date.  For the last retrieval it depends on the
+     * account, see gettrans_from_date(). */
     if (use_earliest_date)
     {
+        *use_last_date = FALSE;
         *from_date = NULL;
     }
     else
     {
-        if (use_last_date)
-            last_timespec = gnc_ab_get_account_trans_retrieval(gnc_acc);
         *from_date = GWEN_Time_fromSeconds(timespecToTime64(last_timespec));
     }
 
@@ -94,22 +110,50 @@ gettrans_dates(GtkWidget *parent, Account *gnc_acc,
     return TRUE;
 }
 
+static GWEN_TIME *
+gettrans_from_date(Account *gnc_acc, gboolean use_last_date,
+                   const GWEN_TIME *from_date)
+{
+    if (!from_date)
+        return NULL;
+    if (use_last_date)
+    {
+        Timespec last_timespec = gnc_ab_get_account_trans_retrieval(gnc_acc);
+        return GWEN_Time_fromSeconds(timespecToTime64(last_timespec));
+    }
+    return GWEN_Time_dup(from_date);
+}
+
 void
 gnc_ab_gettrans(GtkWidget *parent, Account *gnc_acc)
+{
+    GList *accounts;
+
+    g_return_if_fail(parent && gnc_acc);
+
+    accounts = g_list_prepend(NULL, gnc_acc);
+    gnc_ab_gettrans_accounts(parent, accounts);
+    g_list_free(accounts);
+}
+
+void
+gnc_ab_gettrans_accounts(GtkWidget *parent, GList *accounts)
 {
     AB_BANKING *api;
     gboolean online = FALSE;
-    AB_ACCOUNT *ab_acc;
+    gboolean single = accounts && !accounts->next;
+    gboolean use_last_date = FALSE;
     GWEN_TIME *from_date = NULL, *to_date = NULL;
     Timespec until_timespec;
-    AB_JOB *job = NULL;
+    GList *jobs = NULL, *node;
     AB_JOB_LIST2 *job_list = NULL;
     GncGWENGui *gui = NULL;
     AB_IMEXPORTER_CONTEXT *context = NULL;
     GncABImExContextImport *ieci = NULL;
-    AB_JOB_STATUS job_status;
+    GString *failed = NULL;
+    gboolean finished = FALSE;
 
-    g_return_if_fail(parent && gnc_acc);
+    g_return_if_fail(parent && accounts);
 
     /* Get the API */
     api = gnc_AB_BANKING_new();
@@ -129,17 +173,9 @@ gnc_ab_gettrans(GtkWidget *parent, Account *gnc_acc)
     }
     online = TRUE;
 
-    /* Get the AqBanking Account */
-    ab_acc = gnc_ab_get_ab_account(api, gnc_acc);
-    if (!ab_acc)
-    {
-        g_warning("gnc_ab_gettrans: No AqBanking account found");
-        gnc_error_dialog(parent, _("No valid online banking account assigned."));
-        goto cleanup;
-    }
-
-    /* Get the start and end dates for the GetTransactions job.  */
-    if (!gettrans_dates(parent, gnc_acc, &from_date, &to_date))
+    /* Get the start and end dates for the GetTransactions jobs.  */
+    if (!gettrans_dates(parent, accounts, &use_last_date, &from_date,
+                        &to_date))
     {
         g_debug("gnc_ab_gettrans: gettrans_dates aborted");
         goto cleanup;
@@ -147,23 +183,75 @@ gnc_ab_gettrans(GtkWidget *parent, Account *gnc_acc)
     /* Use this as a local storage for the until_time below. */
     timespecFromTime64(&until_timespec, GWEN_Time_toTime_t(to_date));
 
-    /* Get a GetTransactions job and enqueue it */
-    job = AB_JobGetTransactions_new(ab_acc);
-    if (!job || AB_Job_CheckAvailability(job
+    /* Get a GetTransactions job for every account and enqueue them all,
+     * so that they are sent to the banks in a single run */
+    job_list = AB_Job_List2_new();
+    failed = g_string_new(NULL);
+    for (node = accounts; node; node = node->next)
+    {
+        Account *gnc_acc = node->data;
+        AB_ACCOUNT *ab_acc;
+        AB_JOB *job;
+        GWEN_TIME *acc_from_date;
+        GettransJob *gettrans_job;
+
+        /* Get the AqBanking Account */
+        ab_acc = gnc_ab_get_ab_account(api, gnc_acc);
+        if (!ab_acc)
+        {
+            g_warning("gnc_ab_gettrans: No AqBanking account found for %s",
+                      xaccAccountGetName(gnc_acc));
+            if (single)
+            {
+                gnc_error_dialog(parent, _("No valid online banking account assigned."));
+                goto cleanup;
+            }
+            g_string_append_printf(failed, "\n%s", xaccAccountGetName(gnc_acc));
+            continue;
+        }
+
+        job = AB_JobGetTransactions_new(ab_acc);
+        if (!job || AB_Job_CheckAvailability(job
 #ifndef AQBANKING_VERSION_5_PLUS
-                                         , 0
+                                             , 0
 #endif
-                                        ))
+                                            ))
+        {
+            g_warning("gnc_ab_gettrans: JobGetTransactions not available for "
+                      "%s", xaccAccountGetName(gnc_acc));
+            if (job)
+                AB_Job_free(job);
+            if (single)
+            {
+                gnc_error_dialog(parent, _("Online action \"Get Transactions\" not available for this account."));
+                goto cleanup;
+            }
+            g_string_append_printf(failed, "\n%s", xaccAccountGetName(gnc_acc));
+            continue;
+        }
+        acc_from_date = gettrans_from_date(gnc_acc, use_last_date, from_date);
+        AB_JobGetTransactions_SetFromTime(job, acc_from_date);
+        AB_JobGetTransactions_SetToTime(job, to_date);
+        if (acc_from_date)
+            GWEN_Time_free(acc_from_date);
+        AB_Job_List2_PushBack(job_list, job);
+
+        gettrans_job = g_new(GettransJob, 1);
+        gettrans_job->gnc_acc = gnc_acc;
+        gettrans_job->job = job;
+        jobs = g_list_prepend(jobs, gettrans_job);
+    }
+    jobs = g_list_reverse(jobs);
+
+    if (failed->len > 0)
     {
-        g_warning("gnc_ab_gettrans: JobGetTransactions not available for this "
-                  "account");
-        gnc_error_dialog(parent, _("Online action \"Get Transactions\" not available for this account."));
-        goto cleanup;
+        gnc_error_dialog(parent, "%s%s",
+                         _("Online action \"Get Transactions\" is not available "
+                           "for these accounts, which will be skipped:"),
+                         failed->str);
     }
-    AB_JobGetTransactions_SetFromTime(job, from_date);
-    AB_JobGetTransactions_SetToTime(job, to_date);
-    job_list = AB_Job_List2_new();
-    AB_Job_List2_PushBack(job_list, job);
+    if (!jobs)
+        goto cleanup;
 
     /* Get a GUI object */
     gui = gnc_GWEN_Gui_get(parent);
@@ -173,10 +261,10 @@ gnc_ab_gettrans(GtkWidget *parent, Account *gnc_acc)
         goto cleanup;
     }
 
-    /* Create a context to store the results */
+    /* Create a context to store the results of all jobs */
     context = AB_ImExporterContext_new();
 
-    /* Execute the job */
+    /* Execute the jobs */
     AB_Banking_ExecuteJobs(api, job_list, context
 #ifndef AQBANKING_VERSION_5_PLUS
                            , 0
@@ -187,18 +275,42 @@ gnc_ab_gettrans(GtkWidget *parent, Account *gnc_acc)
      * transferred to and accepted by the bank.  See also
      * http://lists.gnucash.org/pipermail/gnucash-de/2008-September/006389.html
      */
-    job_status = AB_Job_GetStatus(job);
-    if (job_status != AB_Job_StatusFinished
-            && job_status != AB_Job_StatusPending)
+    g_string_truncate(failed, 0);
+    for (node = jobs; node; node = node->next)
     {
-        g_warning("gnc_ab_gettrans: Error on executing job");
-        gnc_error_dialog(parent, _("Error on executing job.\n\nStatus: %s - %s")
-                         , AB_Job_Status2Char(job_status)
-                         , AB_Job_GetResultText(job));
-        goto cleanup;
+        GettransJob *gettrans_job = node->data;
+        AB_JOB_STATUS job_status = AB_Job_GetStatus(gettrans_job->job);
+
+        if (job_status != AB_Job_StatusFinished
+                && job_status != AB_Job_StatusPending)
+        {
+            g_warning("gnc_ab_gettrans: Error on executing job for %s",
+                      xaccAccountGetName(gettrans_job->gnc_acc));
+            if (single)
+                gnc_error_dialog(parent, _("Error on executing job.\n\nStatus: %s - %s")
+                                 , AB_Job_Status2Char(job_status)
+                                 , AB_Job_GetResultText(gettrans_job->job));
+            else
+                g_string_append_printf(failed, "\n%s: %s - %s",
+                                       xaccAccountGetName(gettrans_job->gnc_acc),
+                                       AB_Job_Status2Char(job_status),
+                                       AB_Job_GetResultText(gettrans_job->job));
+            /* Do not store a retrieval date for this account */
+            gettrans_job->gnc_acc = NULL;
+            continue;
+        }
+        finished = TRUE;
+    }
+    if (failed->len > 0)
+    {
+        gnc_error_dialog(parent, "%s%s",
+                         _("Error on executing the jobs of these accounts:"),
+                         failed->str);
     }
+    if (!finished)
+        goto cleanup;
 
-    /* Import the results */
+    /* Import the results of all accounts into one matcher */
     ieci = gnc_ab_import_context(context, AWAIT_TRANSACTIONS, FALSE, NULL,
                                  parent);
     if (!(gnc_ab_ieci_get_found(ieci) & FOUND_TRANSACTIONS))
@@ -217,7 +329,13 @@ gnc_ab_gettrans(GtkWidget *parent, Account *gnc_acc)
     }
 
     /* Store the date of this retrieval */
-    gnc_ab_set_account_trans_retrieval(gnc_acc, until_timespec);
+    for (node = jobs; node; node = node->next)
+    {
+        GettransJob *gettrans_job = node->data;
+        if (gettrans_job->gnc_acc)
+            gnc_ab_set_account_trans_retrieval(gettrans_job->gnc_acc,
+                                               until_timespec);
+    }
 
 cleanup:
     if (ieci)
@@ -228,8 +346,15 @@ cleanup:
         gnc_GWEN_Gui_release(gui);
     if (job_list)
         AB_Job_List2_free(job_list);
-    if (job)
-        AB_Job_free(job);
+    for (node = jobs; node; node = node->next)
+    {
+        GettransJob *gettrans_job = node->data;
+        AB_Job_free(gettrans_job->job);
+        g_free(gettrans_job);
+    }
+    g_list_free(jobs);
+    if (failed)
+        g_string_free(failed, TRUE);
     if (to_date)
         GWEN_Time_free(to_date);
     if (from_date)
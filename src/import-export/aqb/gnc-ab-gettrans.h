@@ -45,6 +45,17 @@ G_BEGIN_DECLS
  */
 void gnc_ab_gettrans(GtkWidget *parent, Account *gnc_acc);
 
+/**
+ * Execute GetTransactions jobs for several accounts in a single AqBanking
+ * run.  The date range is asked for once, and the transactions of all
+ * accounts are imported through one matcher.  Accounts without an
+ * online banking account or without the job are skipped.
+ *
+ * @param parent Widget to use as parent, may be NULL
+ * @param accounts GList of the GnuCash accounts to fetch transactions for
+ */
+void gnc_ab_gettrans_accounts(GtkWidget *parent, GList *accounts);
+
 G_END_DECLS
 
 #endif /* GNC_AB_GETTRANS_H */
@@ -49,6 +49,7 @@
 #include "gnc-plugin-page-register2.h"
 #include "gnc-main-window.h"
 #include "gnc-prefs.h"
+#include "gnc-ui.h"
 #include "gnc-ui-util.h" // for gnc_get_current_book
 
 /* This static indicates the debugging module that this .o belongs to.  */
@@ -71,6 +72,7 @@ static Account *main_window_to_account(GncMainWindow *window);
 static void gnc_plugin_ab_cmd_setup(GtkAction *action, GncMainWindowActionData *data);
 static void gnc_plugin_ab_cmd_get_balance(GtkAction *action, GncMainWindowActionData *data);
 static void gnc_plugin_ab_cmd_get_transactions(GtkAction *action, GncMainWindowActionData *data);
+static void gnc_plugin_ab_cmd_get_all_transactions(GtkAction *action, GncMainWindowActionData *data);
 static void gnc_plugin_ab_cmd_issue_transaction(GtkAction *action, GncMainWindowActionData *data);
 static void gnc_plugin_ab_cmd_issue_sepatransaction(GtkAction *action, GncMainWindowActionData *data);
 static void gnc_plugin_ab_cmd_issue_inttransaction(GtkAction *action, GncMainWindowActionData *data);
@@ -109,6 +111,11 @@ static GtkActionEntry gnc_plugin_actions [] =
         N_("Get the transactions online through Online Banking"),
         G_CALLBACK(gnc_plugin_ab_cmd_get_transactions)
     },
+    {
+        "ABGetAllTransAction", NULL, N_("Get Transactions for _All Accounts..."), NULL,
+        N_("Get the transactions of all online banking accounts at once through Online Banking"),
+        G_CALLBACK(gnc_plugin_ab_cmd_get_all_transactions)
+    },
     {
         "ABIssueTransAction", NULL, N_("_Issue Transaction..."), NULL,
         N_("Issue a new transaction online through Online Banking"),
@@ -534,6 +541,41 @@ gnc_plugin_ab_cmd_get_transactions(GtkAction *action,
     LEAVE(" ");
 }
 
+static void
+gnc_plugin_ab_cmd_get_all_transactions(GtkAction *action,
+                                       GncMainWindowActionData *data)
+{
+    GList *descendants, *node, *accounts = NULL;
+
+    ENTER("action %p, main window data %p", action, data);
+    descendants = gnc_account_get_descendants(gnc_get_current_root_account());
+    for (node = descendants; node; node = node->next)
+    {
+        Account *account = node->data;
+        const gchar *accountid = gnc_ab_get_account_accountid(account);
+
+        if (gnc_ab_get_account_uid(account) > 0 || (accountid && *accountid))
+            accounts = g_list_prepend(accounts, account);
+    }
+    g_list_free(descendants);
+
+    if (accounts == NULL)
+    {
+        g_message("No AqBanking account assigned");
+        gnc_error_dialog(GTK_WIDGET(data->window), "%s",
+                         _("No account has been assigned an online banking account."));
+        LEAVE("no accounts");
+        return;
+    }
+
+    gnc_main_window = data->window;
+    accounts = g_list_reverse(accounts);
+    gnc_ab_gettrans_accounts(GTK_WIDGET(data->window), accounts);
+    g_list_free(accounts);
+
+    LEAVE(" ");
+}
+
 static void
 gnc_plugin_ab_cmd_issue_transaction(GtkAction *action,
                                     GncMainWindowActionData *data)
@@ -32,6 +32,7 @@
 
 #include "gnc-commodity.h"
 #include "gnc-ui-util.h"
+#include "gnc-window.h"
 #include "Query.h"
 #include "Transaction.h"
 #include "engine-helpers.h"
@@ -51,6 +52,15 @@ static QofLogModule log_module = GNC_MOD_ASSISTANT;
 #endif
 
 
+/* Lines are collected in a buffer and only written out once this
+ * much has accumulated, so that even the general journal is written
+ * with a modest number of large writes. */
+#define CSV_EXPORT_BUFFER_SIZE (256 * 1024)
+
+/* Number of transactions between two updates of the progress bar
+ * when the total number is not known in advance. */
+#define CSV_EXPORT_PROGRESS_STEP 500
+
 enum GncCsvLineType {TRANS_SIMPLE,
                      TRANS_COMPLEX,
                      SPLIT_LINE};
@@ -58,85 +68,86 @@ enum GncCsvLineType {TRANS_SIMPLE,
 /*******************************************************************/
 
 /*******************************************************
- * write_line_to_file
+ * flush_lines_to_file
  *
- * write a text string to a file pointer, return TRUE if
- * successfull.
+ * write the lines collected so far to a file pointer and
+ * empty the buffer, return TRUE if successfull.
  *******************************************************/
 static
-gboolean write_line_to_file (FILE *fh, char * line)
+gboolean flush_lines_to_file (FILE *fh, GString *lines)
 {
-    int len, written;
-    DEBUG("Account String: %s", line);
+    gsize written;
 
-    /* Write account line */
-    len = strlen (line);
-    written = fwrite (line, 1, len, fh);
+    if (lines->len == 0)
+        return TRUE;
 
-    if (written != len)
+    written = fwrite (lines->str, 1, lines->len, fh);
+    if (written != lines->len)
         return FALSE;
-    else
-        return TRUE;
+
+    g_string_truncate (lines, 0);
+    return TRUE;
 }
 
 
 /*******************************************************
- * csv_txn_test_field_string
+ * csv_txn_append_field
  *
- * Test the field string for ," and new lines
+ * Append a field to the line followed by the separator,
+ * doubling any " and quoting the field if it contains
+ * a separator, a new line or a " and the separators do
+ * not already quote it.
  *******************************************************/
-static
-gchar *csv_txn_test_field_string (CsvExportInfo *info, const gchar *string_in)
+static void
+csv_txn_append_field (GString *line, CsvExportInfo *info, const gchar *string_in,
+                      const gchar *sep)
 {
-    gboolean need_quote = FALSE;
-    gchar **parts;
-    gchar *string_parts;
-    gchar *string_out;
-
-    /* Check for " and then "" them */
-    parts = g_strsplit (string_in, "\"", -1);
-    string_parts = g_strjoinv ("\"\"", parts);
-    g_strfreev (parts);
-
-    /* Check for separator string and \n and " in field,
-       if so quote field if not allready quoted */
-    if (g_strrstr (string_parts, info->separator_str) != NULL)
-        need_quote = TRUE;
-    if (g_strrstr (string_parts, "\n") != NULL)
-        need_quote = TRUE;
-    if (g_strrstr (string_parts, "\"") != NULL)
-        need_quote = TRUE;
-
-    if (!info->use_quotes && need_quote)
-        string_out = g_strconcat ("\"", string_parts, "\"", NULL);
-    else
-        string_out = g_strdup (string_parts);
+    const gchar *p;
+    gboolean need_quote;
+
+    if (string_in == NULL)
+        string_in = "";
+
+    need_quote = !info->use_quotes &&
+                 ((strchr (string_in, '"') != NULL) ||
+                  (strchr (string_in, '\n') != NULL) ||
+                  (strstr (string_in, info->separator_str) != NULL));
 
-    g_free (string_parts);
-    return string_out;
+    if (need_quote)
+        g_string_append_c (line, '"');
+
+    for (p = strchr (string_in, '"'); p != NULL; p = strchr (string_in, '"'))
+    {
+        g_string_append_len (line, string_in, p - string_in + 1);
+        g_string_append_c (line, '"');
+        string_in = p + 1;
+    }
+    g_string_append (line, string_in);
+
+    if (need_quote)
+        g_string_append_c (line, '"');
+
+    g_string_append (line, sep);
 }
 
 /******************** Helper functions *********************/
 
 // Transaction line starts with Date
-static gchar*
-begin_trans_string (Transaction *trans, CsvExportInfo *info)
+static void
+begin_trans_string (GString *line, Transaction *trans, CsvExportInfo *info)
 {
     gchar *date = qof_print_date (xaccTransGetDate (trans));
-    gchar *result = g_strconcat (info->end_sep, date, info->mid_sep, NULL);
+    g_string_append (line, info->end_sep);
+    g_string_append (line, date);
+    g_string_append (line, info->mid_sep);
     g_free (date);
-    return result;
 }
 
-
 // Split line start
-static gchar*
-begin_split_string (Transaction *trans, Split *split, gboolean t_void, CsvExportInfo *info)
+static void
+begin_split_string (GString *line, Transaction *trans, Split *split, gboolean t_void, CsvExportInfo *info)
 {
     const gchar *str_rec_date;
-    const gchar *start;
-    gchar       *conv;
-    gchar       *result;
     Timespec     ts = {0,0};
 
     if (xaccSplitGetReconcile (split) == YREC)
@@ -147,337 +158,223 @@ begin_split_string (Transaction *trans, Split *split, gboolean t_void, CsvExport
     else
         str_rec_date = "";
 
+    g_string_append (line, info->end_sep);
+    g_string_append (line, info->mid_sep);
+    g_string_append (line, info->mid_sep);
+    g_string_append (line, str_rec_date);
+    g_string_append (line, info->mid_sep);
+    g_string_append (line, info->mid_sep);
+    g_string_append (line, info->mid_sep);
+    g_string_append (line, info->mid_sep);
+
     if (t_void)
-    {
-        start = xaccTransGetVoidReason (trans) ? xaccTransGetVoidReason (trans) : "" ;
-        conv = csv_txn_test_field_string (info, start);
-        result = g_strconcat (info->end_sep, info->mid_sep, info->mid_sep, str_rec_date,
-                              info->mid_sep, info->mid_sep, info->mid_sep, info->mid_sep, conv, info->mid_sep, NULL);
-        g_free (conv);
-    }
+        csv_txn_append_field (line, info, xaccTransGetVoidReason (trans), info->mid_sep);
     else
-         result = g_strconcat (info->end_sep, info->mid_sep, info->mid_sep, str_rec_date,
-                               info->mid_sep, info->mid_sep, info->mid_sep, info->mid_sep, info->mid_sep, NULL);
-
-    return result;
+        g_string_append (line, info->mid_sep);
 }
 
 
 // Transaction Type
-static gchar*
-add_type (gchar *so_far, Transaction *trans, CsvExportInfo *info)
+static void
+add_type (GString *line, Transaction *trans, CsvExportInfo *info)
 {
-    gchar       *result;
-    char         type;
-    static char  ss[2];
-
-    type = xaccTransGetTxnType (trans);
+    char type = xaccTransGetTxnType (trans);
 
     if (type == TXN_TYPE_NONE)
         type = ' ';
-    ss[0] = type;
-    ss[1] = '\0';
-    result = g_strconcat (so_far, ss, info->mid_sep, NULL);
-    g_free (so_far);
-    return result;
+    g_string_append_c (line, type);
+    g_string_append (line, info->mid_sep);
 }
 
 // Second Date
-static gchar*
-add_second_date (gchar *so_far, Transaction *trans, CsvExportInfo *info)
+static void
+add_second_date (GString *line, Transaction *trans, CsvExportInfo *info)
 {
-    gchar       *result;
-    const gchar *second_date;
-    char         type;
-    Timespec     ts = {0,0};
+    Timespec ts = {0,0};
 
-    type = xaccTransGetTxnType (trans);
-
-    if (type == TXN_TYPE_INVOICE)
+    if (xaccTransGetTxnType (trans) == TXN_TYPE_INVOICE)
     {
         xaccTransGetDateDueTS (trans, &ts);
-        second_date = gnc_print_date (ts);
-        result = g_strconcat (so_far, second_date, info->mid_sep, NULL);
+        g_string_append (line, gnc_print_date (ts));
     }
-    else
-        result = g_strconcat (so_far, info->mid_sep, NULL);
-
-    g_free (so_far);
-    return result;
+    g_string_append (line, info->mid_sep);
 }
 
 // Account Name short or Long
-static gchar*
-add_account_name (gchar *so_far, Account *acc, Split *split, gboolean full, CsvExportInfo *info)
+static void
+add_account_name (GString *line, Account *acc, Split *split, gboolean full, CsvExportInfo *info)
 {
-    gchar       *name = NULL;
-    gchar       *conv;
-    gchar       *result;
-    Account     *account = NULL;
+    Account *account = NULL;
 
     if (split == NULL)
     {
         if (acc == NULL)
-            name = g_strdup (" ");
-        else
-            account = acc;
+        {
+            csv_txn_append_field (line, info, " ", info->mid_sep);
+            return;
+        }
+        account = acc;
     }
     else
         account = xaccSplitGetAccount (split);
 
-    if (account != NULL)
+    if (account == NULL)
+        csv_txn_append_field (line, info, NULL, info->mid_sep);
+    else if (full)
     {
-        if (full)
-            name = gnc_account_get_full_name (account);
-        else
-            name = g_strdup (xaccAccountGetName (account));
+        gchar *name = gnc_account_get_full_name (account);
+        csv_txn_append_field (line, info, name, info->mid_sep);
+        g_free (name);
     }
-    conv = csv_txn_test_field_string (info, name);
-    result = g_strconcat (so_far, conv, info->mid_sep, NULL);
-    g_free (name);
-    g_free (conv);
-    g_free (so_far);
-    return result;
+    else
+        csv_txn_append_field (line, info, xaccAccountGetName (account), info->mid_sep);
 }
 
 // Number
-static gchar*
-add_number (gchar *so_far, Transaction *trans, CsvExportInfo *info)
+static void
+add_number (GString *line, Transaction *trans, CsvExportInfo *info)
 {
-    const gchar *num;
-    gchar       *conv;
-    gchar       *result;
-
-    num = xaccTransGetNum (trans) ? xaccTransGetNum (trans) : "" ;
-    conv = csv_txn_test_field_string (info, num);
-    result = g_strconcat (so_far, conv, info->mid_sep, NULL);
-    g_free (conv);
-    g_free (so_far);
-    return result;
+    csv_txn_append_field (line, info, xaccTransGetNum (trans), info->mid_sep);
 }
 
 // Description
-static gchar*
-add_description (gchar *so_far, Transaction *trans, CsvExportInfo *info)
+static void
+add_description (GString *line, Transaction *trans, CsvExportInfo *info)
 {
-    const gchar *desc;
-    gchar       *conv;
-    gchar       *result;
-
-    desc = xaccTransGetDescription (trans) ? xaccTransGetDescription (trans) : "" ;
-    conv = csv_txn_test_field_string (info, desc);
-    result = g_strconcat (so_far, conv, info->mid_sep, NULL);
-    g_free (conv);
-    g_free (so_far);
-    return result;
+    csv_txn_append_field (line, info, xaccTransGetDescription (trans), info->mid_sep);
 }
 
 // Notes
-static gchar*
-add_notes (gchar *so_far, Transaction *trans, CsvExportInfo *info)
+static void
+add_notes (GString *line, Transaction *trans, CsvExportInfo *info)
 {
-    const gchar *notes;
-    gchar       *conv;
-    gchar       *result;
-
-    notes = xaccTransGetNotes (trans) ? xaccTransGetNotes (trans) : "" ;
-    conv = csv_txn_test_field_string (info, notes);
-    result = g_strconcat (so_far, conv, info->mid_sep, NULL);
-    g_free (conv);
-    g_free (so_far);
-    return result;
+    csv_txn_append_field (line, info, xaccTransGetNotes (trans), info->mid_sep);
 }
 
 // Memo
-static gchar*
-add_memo (gchar *so_far, Split *split, CsvExportInfo *info)
+static void
+add_memo (GString *line, Split *split, CsvExportInfo *info)
 {
-    const gchar *memo;
-    gchar       *conv;
-    gchar       *result;
-
-    memo = xaccSplitGetMemo (split) ? xaccSplitGetMemo (split) : "" ;
-    conv = csv_txn_test_field_string (info, memo);
-    result = g_strconcat (so_far, conv, info->mid_sep, NULL);
-    g_free (conv);
-    g_free (so_far);
-    return result;
+    csv_txn_append_field (line, info, xaccSplitGetMemo (split), info->mid_sep);
 }
 
 // Full Category Path or Not
-static gchar*
-add_category (gchar *so_far, Split *split, gboolean full, CsvExportInfo *info)
+static void
+add_category (GString *line, Split *split, gboolean full, CsvExportInfo *info)
 {
-    gchar       *cat;
-    gchar       *conv;
-    gchar       *result;
-
     if (full)
-        cat = xaccSplitGetCorrAccountFullName (split);
+    {
+        gchar *cat = xaccSplitGetCorrAccountFullName (split);
+        csv_txn_append_field (line, info, cat, info->mid_sep);
+        g_free (cat);
+    }
     else
-        cat = g_strdup(xaccSplitGetCorrAccountName (split));
-
-    conv = csv_txn_test_field_string (info, cat);
-    result = g_strconcat (so_far, conv, info->mid_sep, NULL);
-    g_free (cat);
-    g_free (conv);
-    g_free (so_far);
-    return result;
+        csv_txn_append_field (line, info, xaccSplitGetCorrAccountName (split), info->mid_sep);
 }
 
 // Line Type
-static gchar*
-add_line_type (gchar *so_far, gint line_type, CsvExportInfo *info)
+static void
+add_line_type (GString *line, gint line_type, CsvExportInfo *info)
 {
-    gchar *result;
-
-    if (line_type == SPLIT_LINE)
-        result = g_strconcat (so_far, "S", info->mid_sep, NULL);
-    else
-        result = g_strconcat (so_far, "T", info->mid_sep, NULL);
-
-    g_free (so_far);
-    return result;
+    g_string_append_c (line, (line_type == SPLIT_LINE) ? 'S' : 'T');
+    g_string_append (line, info->mid_sep);
 }
 
 // Action
-static gchar*
-add_action (gchar *so_far, Split *split, gint line_type, CsvExportInfo *info)
+static void
+add_action (GString *line, Split *split, gint line_type, CsvExportInfo *info)
 {
-    const gchar *action;
-    gchar       *conv;
-    gchar       *result;
-
     if ((line_type == TRANS_COMPLEX)||(line_type == TRANS_SIMPLE))
-        result = g_strconcat (so_far, "", info->mid_sep, NULL);
+        g_string_append (line, info->mid_sep);
     else
-    {
-        action = xaccSplitGetAction (split);
-        conv = csv_txn_test_field_string (info, action);
-        result = g_strconcat (so_far, conv, info->mid_sep, NULL);
-        g_free (conv);
-    }
-    g_free (so_far);
-    return result;
+        csv_txn_append_field (line, info, xaccSplitGetAction (split), info->mid_sep);
 }
 
 // Reconcile
-static gchar*
-add_reconcile (gchar *so_far, Split *split, CsvExportInfo *info)
+static void
+add_reconcile (GString *line, Split *split, CsvExportInfo *info)
 {
-    const gchar *recon;
-    gchar       *conv;
-    gchar       *result;
-
-    recon = gnc_get_reconcile_str (xaccSplitGetReconcile (split));
-    conv = csv_txn_test_field_string (info, recon);
-    result = g_strconcat (so_far, conv, info->mid_sep, NULL);
-    g_free (conv);
-    g_free (so_far);
-    return result;
+    const gchar *recon = gnc_get_reconcile_str (xaccSplitGetReconcile (split));
+    csv_txn_append_field (line, info, recon, info->mid_sep);
 }
 
 // Commodity Mnemonic
-static gchar*
-add_comm_mnemonic (gchar *so_far, Transaction *trans, Split *split, CsvExportInfo *info)
+static void
+add_comm_mnemonic (GString *line, Transaction *trans, Split *split, CsvExportInfo *info)
 {
     const gchar *comm_m;
-    gchar       *conv;
-    gchar       *result;
 
     if (split == NULL)
         comm_m = gnc_commodity_get_mnemonic (xaccTransGetCurrency (trans));
     else
         comm_m = gnc_commodity_get_mnemonic (xaccAccountGetCommodity (xaccSplitGetAccount(split)));
 
-    conv = csv_txn_test_field_string (info, comm_m);
-    result = g_strconcat (so_far, conv, info->mid_sep, NULL);
-    g_free (conv);
-    g_free (so_far);
-    return result;
+    csv_txn_append_field (line, info, comm_m, info->mid_sep);
 }
 
 // Commodity Namespace
-static gchar*
-add_comm_namespace (gchar *so_far, Transaction *trans, Split *split, CsvExportInfo *info)
+static void
+add_comm_namespace (GString *line, Transaction *trans, Split *split, CsvExportInfo *info)
 {
     const gchar *comm_n;
-    gchar       *conv;
-    gchar       *result;
 
     if (split == NULL)
         comm_n = gnc_commodity_get_namespace (xaccTransGetCurrency (trans));
     else
         comm_n = gnc_commodity_get_namespace (xaccAccountGetCommodity (xaccSplitGetAccount(split)));
 
-    conv = csv_txn_test_field_string (info, comm_n);
-    result = g_strconcat (so_far, conv, info->mid_sep, NULL);
-    g_free (conv);
-    g_free (so_far);
-    return result;
+    csv_txn_append_field (line, info, comm_n, info->mid_sep);
 }
 
 // Amount with Symbol or not
-static gchar*
-add_amount (gchar *so_far, Split *split, gboolean t_void, gboolean symbol, gint line_type, CsvExportInfo *info)
+static void
+add_amount (GString *line, Split *split, gboolean t_void, gboolean symbol, gint line_type, CsvExportInfo *info)
 {
     const gchar *amt;
-    gchar       *conv;
-    gchar       *result;
 
     if (line_type == TRANS_COMPLEX)
-        result = g_strconcat (so_far, "", info->mid_sep, NULL);
+    {
+        g_string_append (line, info->mid_sep);
+        return;
+    }
+
+    if (symbol)
+    {
+        if (t_void)
+            amt = xaccPrintAmount (gnc_numeric_zero(), gnc_split_amount_print_info (split, TRUE));
+        else
+            amt = xaccPrintAmount (xaccSplitGetAmount (split), gnc_split_amount_print_info (split, TRUE));
+    }
     else
     {
-        if (symbol)
-        {
-            if (t_void)
-                amt = xaccPrintAmount (gnc_numeric_zero(), gnc_split_amount_print_info (split, TRUE));
-            else
-                amt = xaccPrintAmount (xaccSplitGetAmount (split), gnc_split_amount_print_info (split, TRUE));
-        }
+        if (t_void)
+            amt = xaccPrintAmount (xaccSplitVoidFormerAmount (split), gnc_split_amount_print_info (split, FALSE));
         else
-        {
-            if (t_void)
-                amt = xaccPrintAmount (xaccSplitVoidFormerAmount (split), gnc_split_amount_print_info (split, FALSE));
-            else
-                amt = xaccPrintAmount (xaccSplitGetAmount (split), gnc_split_amount_print_info (split, FALSE));
-        }
-        conv = csv_txn_test_field_string (info, amt);
-        result = g_strconcat (so_far, conv, info->mid_sep, NULL);
-        g_free (conv);
+            amt = xaccPrintAmount (xaccSplitGetAmount (split), gnc_split_amount_print_info (split, FALSE));
     }
-    g_free (so_far);
-    return result;
+    csv_txn_append_field (line, info, amt, info->mid_sep);
 }
 
 // Share Price / Conversion factor
-static gchar*
-add_rate (gchar *so_far, Split *split, gboolean t_void, CsvExportInfo *info)
+static void
+add_rate (GString *line, Split *split, gboolean t_void, CsvExportInfo *info)
 {
     const gchar *amt;
-    gchar       *conv;
-    gchar       *result;
 
     if (t_void)
         amt = xaccPrintAmount (gnc_numeric_zero(), gnc_split_amount_print_info (split, FALSE));
     else
         amt = xaccPrintAmount (xaccSplitGetSharePrice (split), gnc_split_amount_print_info (split, FALSE));
 
-    conv = csv_txn_test_field_string (info, amt);
-    result = g_strconcat (so_far, conv, info->end_sep, EOLSTR, NULL);
-    g_free (conv);
-    g_free (so_far);
-    return result;
+    csv_txn_append_field (line, info, amt, info->end_sep);
+    g_string_append (line, EOLSTR);
 }
 
 // Share Price / Conversion factor
-static gchar*
-add_price (gchar *so_far, Split *split, gboolean t_void, CsvExportInfo *info)
+static void
+add_price (GString *line, Split *split, gboolean t_void, CsvExportInfo *info)
 {
     const gchar *string_amount;
-    gchar       *conv;
-    gchar       *result;
 
     if (t_void)
     {
@@ -488,84 +385,78 @@ add_price (gchar *so_far, Split *split, gboolean t_void, CsvExportInfo *info)
     else
         string_amount = xaccPrintAmount (xaccSplitGetSharePrice (split), gnc_split_amount_print_info (split, FALSE));
 
-    conv = csv_txn_test_field_string (info, string_amount);
-    result = g_strconcat (so_far, conv, info->end_sep, EOLSTR, NULL);
-    g_free (conv);
-    return result;
+    csv_txn_append_field (line, info, string_amount, info->end_sep);
+    g_string_append (line, EOLSTR);
 }
 
 // Transaction End of Line
-static gchar*
-add_trans_eol (gchar *so_far, CsvExportInfo *info)
+static void
+add_trans_eol (GString *line, CsvExportInfo *info)
 {
-    gchar *result = g_strconcat (so_far, "", info->mid_sep, "", info->end_sep, EOLSTR, NULL);
-
-    g_free (so_far);
-    return result;
+    g_string_append (line, info->mid_sep);
+    g_string_append (line, info->end_sep);
+    g_string_append (line, EOLSTR);
 }
 
 /******************************************************************************/
 
-static gchar*
-make_simple_trans_line (Account *acc, Transaction *trans, Split *split, CsvExportInfo *info)
+static void
+make_simple_trans_line (GString *line, Account *acc, Transaction *trans, Split *split, CsvExportInfo *info)
 {
     gboolean t_void = xaccTransGetVoidStatus (trans);
 
-    gchar *result = begin_trans_string (trans, info);
-    result = add_account_name (result, acc, NULL, TRUE, info);
-    result = add_number (result, trans, info);
-    result = add_description (result, trans, info);
-    result = add_category (result, split, TRUE, info);
-    result = add_reconcile (result, split, info);
-    result = add_amount (result, split, t_void, TRUE, TRANS_SIMPLE, info);
-    result = add_amount (result, split, t_void, FALSE, TRANS_SIMPLE, info);
-    result = add_rate (result, split, t_void, info);
-    return result;
+    begin_trans_string (line, trans, info);
+    add_account_name (line, acc, NULL, TRUE, info);
+    add_number (line, trans, info);
+    add_description (line, trans, info);
+    add_category (line, split, TRUE, info);
+    add_reconcile (line, split, info);
+    add_amount (line, split, t_void, TRUE, TRANS_SIMPLE, info);
+    add_amount (line, split, t_void, FALSE, TRANS_SIMPLE, info);
+    add_rate (line, split, t_void, info);
 }
 
-static gchar*
-make_complex_trans_line (Account *acc, Transaction *trans, Split *split, CsvExportInfo *info)
+static void
+make_complex_trans_line (GString *line, Account *acc, Transaction *trans, Split *split, CsvExportInfo *info)
 {
     gboolean t_void = xaccTransGetVoidStatus (trans);
 
-    gchar *result = begin_trans_string (trans, info);
-    result = add_type (result, trans, info);
-    result = add_second_date (result, trans, info);
-    result = add_account_name (result, acc, NULL, FALSE, info);
-    result = add_number (result, trans, info);
-    result = add_description (result, trans, info);
-    result = add_notes (result, trans, info);
-    result = add_memo (result, split, info);
-    result = add_category (result, split, TRUE, info);
-    result = add_category (result, split, FALSE, info);
-    result = add_line_type (result, TRANS_COMPLEX, info);
-    result = add_action (result,split, TRANS_COMPLEX, info);
-    result = add_reconcile (result, split, info);
-    result = add_amount (result, split, t_void, TRUE, TRANS_COMPLEX, info);
-    result = add_comm_mnemonic (result, trans, NULL, info);
-    result = add_comm_namespace (result, trans, NULL, info);
-    result = add_trans_eol (result, info);
-    return result;
+    begin_trans_string (line, trans, info);
+    add_type (line, trans, info);
+    add_second_date (line, trans, info);
+    add_account_name (line, acc, NULL, FALSE, info);
+    add_number (line, trans, info);
+    add_description (line, trans, info);
+    add_notes (line, trans, info);
+    add_memo (line, split, info);
+    add_category (line, split, TRUE, info);
+    add_category (line, split, FALSE, info);
+    add_line_type (line, TRANS_COMPLEX, info);
+    add_action (line, split, TRANS_COMPLEX, info);
+    add_reconcile (line, split, info);
+    add_amount (line, split, t_void, TRUE, TRANS_COMPLEX, info);
+    add_comm_mnemonic (line, trans, NULL, info);
+    add_comm_namespace (line, trans, NULL, info);
+    add_trans_eol (line, info);
 }
 
-static gchar*
-make_complex_split_line (Transaction *trans, Split *split, CsvExportInfo *info)
+static void
+make_complex_split_line (GString *line, Transaction *trans, Split *split, CsvExportInfo *info)
 {
     gboolean t_void = xaccTransGetVoidStatus (trans);
 
-    gchar *result = begin_split_string (trans, split, t_void, info);
-    result = add_memo (result, split, info);
-    result = add_account_name (result, NULL, split, TRUE, info);
-    result = add_account_name (result, NULL, split, FALSE, info);
-    result = add_line_type (result, SPLIT_LINE, info);
-    result = add_action (result,split, SPLIT_LINE, info);
-    result = add_reconcile (result, split, info);
-    result = add_amount (result, split, t_void, TRUE, SPLIT_LINE, info);
-    result = add_comm_mnemonic (result, trans, split, info);
-    result = add_comm_namespace (result, trans, split, info);
-    result = add_amount (result, split, t_void, FALSE, SPLIT_LINE, info);
-    result = add_price (result, split, t_void, info);
-    return result;
+    begin_split_string (line, trans, split, t_void, info);
+    add_memo (line, split, info);
+    add_account_name (line, NULL, split, TRUE, info);
+    add_account_name (line, NULL, split, FALSE, info);
+    add_line_type (line, SPLIT_LINE, info);
+    add_action (line, split, SPLIT_LINE, info);
+    add_reconcile (line, split, info);
+    add_amount (line, split, t_void, TRUE, SPLIT_LINE, info);
+    add_comm_mnemonic (line, trans, split, info);
+    add_comm_namespace (line, trans, split, info);
+    add_amount (line, split, t_void, FALSE, SPLIT_LINE, info);
+    add_price (line, split, t_void, info);
 }
 
 
@@ -573,14 +464,16 @@ make_complex_split_line (Transaction *trans, Split *split, CsvExportInfo *info)
  * account_splits
  *
  * gather the splits / transactions for an account and
- * send them to a file
+ * add them to the lines buffer, writing the buffer to
+ * the file whenever it fills up
  *******************************************************/
 static
-void account_splits (CsvExportInfo *info, Account *acc, FILE *fh )
+void account_splits (CsvExportInfo *info, Account *acc, FILE *fh, GString *lines)
 {
     GSList  *p1, *p2;
-    GList   *splits;
+    GList   *splits, *node;
     QofBook *book;
+    guint    count = 0;
 
     // Setup the query for normal transaction export
     if (info->export_type == XML_EXPORT_TRANS)
@@ -600,21 +493,15 @@ void account_splits (CsvExportInfo *info, Account *acc, FILE *fh )
     }
 
     /* Run the query */
-    for (splits = qof_query_run (info->query); splits; splits = splits->next)
+    splits = qof_query_run (info->query);
+    for (node = splits; node && !info->failed; node = node->next)
     {
         Split       *split;
         Transaction *trans;
         SplitList   *s_list;
-        GList       *node;
-        Split       *t_split;
-        int          nSplits;
-        int          cnt;
-        gchar       *line;
 
-        split = splits->data;
+        split = node->data;
         trans = xaccSplitGetParent (split);
-        nSplits = xaccTransCountSplits (trans);
-        s_list = xaccTransGetSplitList (trans);
 
         // Look for trans already exported in trans_list
         if (g_list_find (info->trans_list, trans) != NULL)
@@ -626,49 +513,25 @@ void account_splits (CsvExportInfo *info, Account *acc, FILE *fh )
 
         // This will be a simple layout equivalent to a single line register view.
         if (info->simple_layout)
+            make_simple_trans_line (lines, acc, trans, split, info);
+        else
         {
-            line = make_simple_trans_line (acc, trans, split, info);
+            // Complex Transaction Line.
+            make_complex_trans_line (lines, acc, trans, split, info);
 
-            /* Write to file */
-            if (!write_line_to_file (fh, line))
-            {
-                info->failed = TRUE;
-                break;
-            }
-            g_free (line);
-            continue;
-        }
+            /* Loop through the list of splits for the Transaction */
+            for (s_list = xaccTransGetSplitList (trans); s_list; s_list = s_list->next)
+                make_complex_split_line (lines, trans, s_list->data, info);
 
-        // Complex Transaction Line.
-        line = make_complex_trans_line (acc, trans, split, info);
+            info->trans_list = g_list_prepend (info->trans_list, trans); // add trans to trans_list
+        }
 
         /* Write to file */
-        if (!write_line_to_file (fh, line))
-        {
+        if (lines->len >= CSV_EXPORT_BUFFER_SIZE && !flush_lines_to_file (fh, lines))
             info->failed = TRUE;
-            break;
-        }
-        g_free (line);
-
-        /* Loop through the list of splits for the Transaction */
-        node = s_list;
-        cnt = 0;
-        while ((cnt < nSplits) && (info->failed == FALSE))
-        {
-            t_split = node->data;
-
-            // Complex Split Line.
-            line = make_complex_split_line (trans, t_split, info);
 
-            if (!write_line_to_file (fh, line))
-                info->failed = TRUE;
-
-            g_free (line);
-
-            cnt++;
-            node = node->next;
-        }
-        info->trans_list = g_list_prepend (info->trans_list, trans); // add trans to trans_list
+        if (info->export_type != XML_EXPORT_TRANS && (++count % CSV_EXPORT_PROGRESS_STEP) == 0)
+            gnc_window_show_progress (_("Exporting transactions..."), 101.0);
     }
     if (info->export_type == XML_EXPORT_TRANS)
         qof_query_destroy (info->query);
@@ -709,6 +572,7 @@ void csv_transactions_export (CsvExportInfo *info)
     fh = g_fopen (info->file_name, "w" );
     if (fh != NULL)
     {
+        GString *lines = g_string_sized_new (CSV_EXPORT_BUFFER_SIZE + 4096);
         gchar *header;
         int i;
 
@@ -735,35 +599,41 @@ void csv_transactions_export (CsvExportInfo *info)
                                   info->end_sep, EOLSTR, NULL);
         }
         DEBUG("Header String: %s", header);
-
-        /* Write header line */
-        if (!write_line_to_file (fh, header))
-        {
-            info->failed = TRUE;
-            g_free (header);
-            return;
-        }
+        g_string_append (lines, header);
         g_free (header);
 
+        gnc_window_show_progress (_("Exporting transactions..."), 0.0);
+
         if (info->export_type == XML_EXPORT_TRANS)
         {
+            gint num_accounts = g_list_length (info->csva.account_list);
+
             /* Go through list of accounts */
-            for (ptr = info->csva.account_list, i = 0; ptr; ptr = g_list_next(ptr), i++)
+            for (ptr = info->csva.account_list, i = 0; ptr && !info->failed; ptr = g_list_next(ptr), i++)
             {
                 acc = ptr->data;
                 DEBUG("Account being processed is : %s", xaccAccountGetName (acc));
-                account_splits (info, acc, fh);
+                account_splits (info, acc, fh, lines);
+                gnc_window_show_progress (_("Exporting transactions..."),
+                                          (100.0 * (i + 1)) / num_accounts);
             }
         }
         else
-            account_splits (info, info->account, fh);
+            account_splits (info, info->account, fh, lines);
+
+        /* Write whatever is left in the buffer */
+        if (!info->failed && !flush_lines_to_file (fh, lines))
+            info->failed = TRUE;
 
+        gnc_window_show_progress (NULL, -1.0);
+        g_string_free (lines, TRUE);
         g_list_free (info->trans_list); // free trans_list
+        info->trans_list = NULL;
     }
     else
         info->failed = TRUE;
-    if (fh)
-        fclose (fh);
+    if (fh && fclose (fh) != 0)
+        info->failed = TRUE;
     LEAVE("");
 }
 
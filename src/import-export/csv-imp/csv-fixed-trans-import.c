@@ -435,6 +435,7 @@ csv_fixed_trans_import (CsvFTImportInfo *info)
     progress = GTK_PROGRESS_BAR(info->progressbar);
 
     gnc_suspend_gui_refresh ();
+    gnc_book_begin_bulk_ingest (book);
 
     while (valid)
     {
@@ -689,6 +690,7 @@ csv_fixed_trans_import (CsvFTImportInfo *info)
     }
     g_free (void_reason);
 
+    gnc_book_end_bulk_ingest (book);
     gnc_resume_gui_refresh ();
 
     LEAVE("");
@@ -58,6 +58,19 @@ gnc_csv_imp_error_quark (void)
 
 G_GNUC_UNUSED static QofLogModule log_module = GNC_MOD_IMPORT;
 
+/* Files larger than this are not converted and parsed as a whole;
+ * only the first GNC_CSV_PREVIEW_SIZE bytes are, for the preview, and
+ * gnc_csv_parse_to_trans reads the rest GNC_CSV_BATCH_SIZE bytes at a
+ * time. */
+#define GNC_CSV_STREAM_THRESHOLD (32 * 1024 * 1024)
+#define GNC_CSV_PREVIEW_SIZE (1024 * 1024)
+#define GNC_CSV_BATCH_SIZE (4 * 1024 * 1024)
+
+/* The cells of rows are parsed into transaction properties in chunks
+ * of this many rows, on up to GNC_CSV_PARSE_THREADS threads. */
+#define GNC_CSV_PARSE_CHUNK_ROWS 512
+#define GNC_CSV_PARSE_THREADS 4
+
 const int num_date_formats = 5;
 const gchar* date_format_user[] = {N_("y-m-d"),
                                    N_("d-m-y"),
@@ -98,253 +111,6 @@ static StfParseOptions_t* default_parse_options (void)
     return options;
 }
 
-/** Parses a string into a date, given a format. The format must
- * include the year. This function should only be called by
- * parse_date.
- * @param date_str The string containing a date being parsed
- * @param format An index specifying a format in date_format_user
- * @return The parsed value of date_str on success or -1 on failure
- */
-static time64 parse_date_with_year (const char* date_str, int format)
-{
-    time64 rawtime; /* The integer time */
-    struct tm retvalue, test_retvalue; /* The time in a broken-down structure */
-
-    int i, j, mem_length, orig_year = -1, orig_month = -1, orig_day = -1;
-
-    /* Buffer for containing individual parts (e.g. year, month, day) of a date */
-    char date_segment[5];
-
-    /* The compiled regular expression */
-    regex_t preg = {0};
-
-    /* An array containing indices specifying the matched substrings in date_str */
-    regmatch_t pmatch[4] = { {0}, {0}, {0}, {0} };
-
-    /* The regular expression for parsing dates */
-    const char* regex = "^ *([0-9]+) *[-/.'] *([0-9]+) *[-/.'] *([0-9]+).*$|^ *([0-9][0-9][0-9][0-9][0-9][0-9][0-9][0-9]).*$";
-
-    /* We get our matches using the regular expression. */
-    regcomp (&preg, regex, REG_EXTENDED);
-    regexec (&preg, date_str, 4, pmatch, 0);
-    regfree (&preg);
-
-    /* If there wasn't a match, there was an error. */
-    if (pmatch[0].rm_eo == 0)
-        return -1;
-
-    /* If this is a string without separators ... */
-    if (pmatch[1].rm_so == -1)
-    {
-        /* ... we will fill in the indices based on the user's selection. */
-        int k = 0; /* k traverses date_str by keeping track of where separators "should" be. */
-        j = 1; /* j traverses pmatch. */
-        for (i = 0; date_format_user[format][i]; i++)
-        {
-            char segment_type = date_format_user[format][i];
-            /* Only do something if this is a meaningful character */
-            if (segment_type == 'y' || segment_type == 'm' || segment_type == 'd')
-            {
-                pmatch[j].rm_so = k;
-                switch (segment_type)
-                {
-                case 'm':
-                case 'd':
-                    k += 2;
-                    break;
-
-                case 'y':
-                    k += 4;
-                    break;
-                }
-
-                pmatch[j].rm_eo = k;
-                j++;
-            }
-        }
-    }
-
-    /* Put some sane values in retvalue by using a fixed time for
-     * the non-year-month-day parts of the date. */
-    gnc_time (&rawtime);
-    gnc_localtime_r (&rawtime, &retvalue);
-    retvalue.tm_hour = 11;
-    retvalue.tm_min = 0;
-    retvalue.tm_sec = 0;
-    retvalue.tm_isdst = -1;
-
-    /* j traverses pmatch (index 0 contains the entire string, so we
-     * start at index 1 for the first meaningful match). */
-    j = 1;
-    /* Go through the date format and interpret the matches in order of
-     * the sections in the date format. */
-    for (i = 0; date_format_user[format][i]; i++)
-    {
-        char segment_type = date_format_user[format][i];
-        /* Only do something if this is a meaningful character */
-        if (segment_type == 'y' || segment_type == 'm' || segment_type == 'd')
-        {
-            /* Copy the matching substring into date_segment so that we can
-             * convert it into an integer. */
-            mem_length = pmatch[j].rm_eo - pmatch[j].rm_so;
-            memcpy (date_segment, date_str + pmatch[j].rm_so, mem_length);
-            date_segment[mem_length] = '\0';
-
-            /* Set the appropriate member of retvalue. Save the original
-             * values so that we can check if they change when we use gnc_mktime
-             * below. */
-            switch (segment_type)
-            {
-            case 'y':
-                retvalue.tm_year = atoi (date_segment);
-
-                /* Handle two-digit years. */
-                if (retvalue.tm_year < 100)
-                {
-                    /* We allow two-digit years in the range 1969 - 2068. */
-                    if (retvalue.tm_year < 69)
-                        retvalue.tm_year += 100;
-                }
-                else
-                    retvalue.tm_year -= 1900;
-                orig_year = retvalue.tm_year;
-                break;
-
-            case 'm':
-                orig_month = retvalue.tm_mon = atoi (date_segment) - 1;
-                break;
-
-            case 'd':
-                orig_day = retvalue.tm_mday = atoi (date_segment);
-                break;
-            }
-            j++;
-        }
-    }
-    /* Convert back to an integer. If gnc_mktime leaves retvalue unchanged,
-     * everything is okay; otherwise, an error has occurred. */
-    /* We have to use a "test" date value to account for changes in
-     * daylight savings time, which can cause a date change with gnc_mktime
-     * near midnight, causing the code to incorrectly think a date is
-     * incorrect. */
-    test_retvalue = retvalue;
-    gnc_mktime (&test_retvalue);
-    retvalue.tm_isdst = test_retvalue.tm_isdst;
-    rawtime = gnc_mktime (&retvalue);
-    if (retvalue.tm_mday == orig_day &&
-            retvalue.tm_mon == orig_month &&
-            retvalue.tm_year == orig_year)
-    {
-        return rawtime;
-    }
-    else
-    {
-        return -1;
-    }
-}
-
-/** Parses a string into a date, given a format. The format cannot
- * include the year. This function should only be called by
- * parse_date.
- * @param date_str The string containing a date being parsed
- * @param format An index specifying a format in date_format_user
- * @return The parsed value of date_str on success or -1 on failure
- */
-static time64 parse_date_without_year (const char* date_str, int format)
-{
-    time64 rawtime; /* The integer time */
-    struct tm retvalue, test_retvalue; /* The time in a broken-down structure */
-
-    int i, j, mem_length, orig_year = -1, orig_month = -1, orig_day = -1;
-
-    /* Buffer for containing individual parts (e.g. year, month, day) of a date */
-    gchar* date_segment;
-
-    /* The compiled regular expression */
-    regex_t preg = {0};
-
-    /* An array containing indices specifying the matched substrings in date_str */
-    regmatch_t pmatch[3] = { {0}, {0}, {0} };
-
-    /* The regular expression for parsing dates */
-    const char* regex = "^ *([0-9]+) *[-/.'] *([0-9]+).*$";
-
-    /* We get our matches using the regular expression. */
-    regcomp (&preg, regex, REG_EXTENDED);
-    regexec (&preg, date_str, 3, pmatch, 0);
-    regfree (&preg);
-
-    /* If there wasn't a match, there was an error. */
-    if (pmatch[0].rm_eo == 0)
-        return -1;
-
-    /* Put some sane values in retvalue by using a fixed time for
-     * the non-year-month-day parts of the date. */
-    gnc_time (&rawtime);
-    gnc_localtime_r (&rawtime, &retvalue);
-    retvalue.tm_hour = 11;
-    retvalue.tm_min = 0;
-    retvalue.tm_sec = 0;
-    retvalue.tm_isdst = -1;
-    orig_year = retvalue.tm_year;
-
-    /* j traverses pmatch (index 0 contains the entire string, so we
-     * start at index 1 for the first meaningful match). */
-    j = 1;
-    /* Go through the date format and interpret the matches in order of
-     * the sections in the date format. */
-    for (i = 0; date_format_user[format][i]; i++)
-    {
-        char segment_type = date_format_user[format][i];
-        /* Only do something if this is a meaningful character */
-        if (segment_type == 'm' || segment_type == 'd')
-        {
-            /* Copy the matching substring into date_segment so that we can
-             * convert it into an integer. */
-            mem_length = pmatch[j].rm_eo - pmatch[j].rm_so;
-            date_segment = g_new (gchar, mem_length);
-            memcpy(date_segment, date_str + pmatch[j].rm_so, mem_length);
-            date_segment[mem_length] = '\0';
-
-            /* Set the appropriate member of retvalue. Save the original
-             * values so that we can check if they change when we use gnc_mktime
-             * below. */
-            switch (segment_type)
-            {
-            case 'm':
-                orig_month = retvalue.tm_mon = atoi (date_segment) - 1;
-                break;
-
-            case 'd':
-                orig_day = retvalue.tm_mday = atoi (date_segment);
-                break;
-            }
-            g_free (date_segment);
-            j++;
-        }
-    }
-    /* Convert back to an integer. If gnc_mktime leaves retvalue unchanged,
-     * everything is okay; otherwise, an error has occurred. */
-    /* We have to use a "test" date value to account for changes in
-     * daylight savings time, which can cause a date change with gnc_mktime
-     * near midnight, causing the code to incorrectly think a date is
-     * incorrect. */
-    test_retvalue = retvalue;
-    gnc_mktime (&test_retvalue);
-    retvalue.tm_isdst = test_retvalue.tm_isdst;
-    rawtime = gnc_mktime (&retvalue);
-    if (retvalue.tm_mday == orig_day &&
-            retvalue.tm_mon == orig_month &&
-            retvalue.tm_year == orig_year)
-    {
-        return rawtime;
-    }
-    else
-    {
-        return -1;
-    }
-}
-
 /** Parses a string into a date, given a format. This function
  * requires only knowing the order in which the year, month and day
  * appear. For example, 01-02-2003 will be parsed the same way as
@@ -355,10 +121,8 @@ static time64 parse_date_without_year (const char* date_str, int format)
  */
 time64 parse_date (const char* date_str, int format)
 {
-    if (strchr (date_format_user[format], 'y'))
-        return parse_date_with_year (date_str, format);
-    else
-        return parse_date_without_year (date_str, format);
+    /* date_format_user is in the order of GncDateOrder. */
+    return gnc_parse_date (date_str, (GncDateOrder) format);
 }
 
 /** Constructor for GncCsvParseData.
@@ -385,6 +149,8 @@ GncCsvParseData* gnc_csv_new_parse_data (void)
     parse_data->start_row = 0;
     parse_data->end_row = 1000;
     parse_data->skip_rows = FALSE;
+    parse_data->streaming = FALSE;
+    parse_data->stream_offset = 0;
     return parse_data;
 }
 
@@ -436,9 +202,42 @@ void gnc_csv_parse_data_free (GncCsvParseData* parse_data)
     g_free (parse_data);
 }
 
+/** Finds the end of the first record in raw file data that ends at or
+ * after want. Newlines inside quoted CSV fields don't end a record, so
+ * the data is scanned from begin, which must be the start of a record.
+ * This works on the raw data, which is fine for the ASCII compatible
+ * encodings in which a newline byte is always a newline.
+ * @param parse_data Data that is being parsed
+ * @param begin Start of a record in parse_data->raw_str
+ * @param want Position at which the record may end at the earliest
+ * @return Pointer just past the newline ending the record, or the end of raw_str
+ */
+static const gchar* raw_record_end (GncCsvParseData* parse_data, const gchar* begin,
+                                    const gchar* want)
+{
+    const gchar* end = parse_data->raw_str.end;
+    gunichar quote = parse_data->options->stringindicator;
+    gboolean use_quotes = (parse_data->options->parsetype == PARSE_TYPE_CSV && quote < 0x80);
+    gboolean quoted = FALSE;
+    const gchar* p;
+
+    if (want >= end)
+        return end;
+
+    for (p = begin; p < end; p++)
+    {
+        if (use_quotes && *p == (gchar)quote)
+            quoted = !quoted;
+        else if (*p == '\n' && !quoted && p >= want)
+            return p + 1;
+    }
+    return end;
+}
+
 /** Converts raw file data using a new encoding. This function must be
  * called after gnc_csv_load_file only if gnc_csv_load_file guessed
- * the wrong encoding.
+ * the wrong encoding. For large files only the rows needed for the
+ * preview are converted (see parse_data->streaming).
  * @param parse_data Data that is being parsed
  * @param encoding Encoding that data should be translated using
  * @param error Will point to an error on failure
@@ -448,6 +247,7 @@ int gnc_csv_convert_encoding (GncCsvParseData* parse_data, const char* encoding,
                              GError** error)
 {
     gsize bytes_read, bytes_written;
+    const gchar* raw_end = parse_data->raw_str.end;
 
     /* If parse_data->file_str has already been initialized it must be
      * freed first. (This should always be the case, since
@@ -456,9 +256,18 @@ int gnc_csv_convert_encoding (GncCsvParseData* parse_data, const char* encoding,
     if (parse_data->file_str.begin != NULL)
         g_free(parse_data->file_str.begin);
 
+    /* Only convert the start of a large file; the rest is converted a
+     * batch at a time when transactions are created. */
+    if (parse_data->streaming)
+    {
+        raw_end = raw_record_end (parse_data, parse_data->raw_str.begin,
+                                  parse_data->raw_str.begin + GNC_CSV_PREVIEW_SIZE);
+        parse_data->stream_offset = raw_end - parse_data->raw_str.begin;
+    }
+
     /* Do the actual translation to UTF-8. */
     parse_data->file_str.begin = g_convert (parse_data->raw_str.begin,
-                                           parse_data->raw_str.end - parse_data->raw_str.begin,
+                                           raw_end - parse_data->raw_str.begin,
                                            "UTF-8", encoding, &bytes_read, &bytes_written,
                                            error);
     /* Handle errors that occur. */
@@ -488,6 +297,7 @@ int gnc_csv_load_file (GncCsvParseData* parse_data, const char* filename,
                       GError** error)
 {
     const char* guess_enc = NULL;
+    gsize length;
 
     /* Get the raw data first and handle an error if one occurs. */
     parse_data->raw_mapping = g_mapped_file_new (filename, FALSE, NULL);
@@ -502,13 +312,22 @@ int gnc_csv_load_file (GncCsvParseData* parse_data, const char* filename,
 
     /* Copy the mapping's contents into parse-data->raw_str. */
     parse_data->raw_str.begin = g_mapped_file_get_contents (parse_data->raw_mapping);
-    parse_data->raw_str.end = parse_data->raw_str.begin + g_mapped_file_get_length (parse_data->raw_mapping);
-
-    /* Make a guess at the encoding of the data. */
-    if (g_mapped_file_get_length (parse_data->raw_mapping) != 0)
+    length = g_mapped_file_get_length (parse_data->raw_mapping);
+    parse_data->raw_str.end = parse_data->raw_str.begin + length;
+
+    /* Large files are only read as a whole when transactions are created. */
+    parse_data->streaming = (length > GNC_CSV_STREAM_THRESHOLD);
+
+    /* Make a guess at the encoding of the data, looking only at the
+     * start of large files (cut at a newline so that no multibyte
+     * character is split). */
+    if (parse_data->streaming)
+        length = raw_record_end (parse_data, parse_data->raw_str.begin,
+                                 parse_data->raw_str.begin + GNC_CSV_PREVIEW_SIZE)
+                 - parse_data->raw_str.begin;
+    if (length != 0)
         guess_enc = go_guess_encoding ((const char*)(parse_data->raw_str.begin),
-                                      (size_t)(parse_data->raw_str.end - parse_data->raw_str.begin),
-                                      "UTF-8", NULL);
+                                      (size_t)length, "UTF-8", NULL);
     if (guess_enc == NULL)
     {
         g_set_error (error, GNC_CSV_IMP_ERROR, GNC_CSV_IMP_ERROR_ENCODING, "%s", _("Unknown encoding."));
@@ -574,7 +393,7 @@ int gnc_csv_parse (GncCsvParseData* parse_data, gboolean guessColTypes, GError**
     for (i = 0; i < parse_data->orig_lines->len; i++)
     {
         int length = ((GPtrArray*)parse_data->orig_lines->pdata[i])->len;
-        parse_data->orig_row_lengths->data[i] = length;
+        g_array_index (parse_data->orig_row_lengths, int, i) = length;
         if (length > parse_data->orig_max_row)
             parse_data->orig_max_row = length;
     }
@@ -717,6 +536,7 @@ static gboolean trans_property_set (TransProperty* prop, char* str)
         /* If a cell is empty or just spaces make its value = "0" */
         reti = regcomp(&regex, "[0-9]", 0);
         reti = regexec(&regex, str_dupe, 0, NULL, 0);
+        regfree(&regex);
         if (reti == REG_NOMATCH)
         {
             g_free (str_dupe);
@@ -952,12 +772,12 @@ static gboolean trans_property_list_verify_essentials (TransPropertyList* list,
     }
 }
 
-/** Create a Transaction from a TransPropertyList.
+/** Create a Transaction from a TransPropertyList. The list must have
+ * passed trans_property_list_verify_essentials.
  * @param list The list of properties
- * @param error Contains an error on failure
- * @return On success, a GncCsvTransLine; on failure, the trans pointer is NULL
+ * @return A GncCsvTransLine
  */
-static GncCsvTransLine* trans_property_list_to_trans (TransPropertyList* list, gchar** error)
+static GncCsvTransLine* trans_property_list_to_trans (TransPropertyList* list)
 {
     GncCsvTransLine* trans_line = g_new (GncCsvTransLine, 1);
     GList* properties_begin = list->properties;
@@ -983,13 +803,6 @@ static GncCsvTransLine* trans_property_list_to_trans (TransPropertyList* list, g
      * important. */
     trans_line->line_no = -1;
 
-    /* Make sure this is a transaction with all the columns we need. */
-    if (!trans_property_list_verify_essentials (list, error))
-    {
-        g_free(trans_line);
-        return NULL;
-    }
-
     trans_line->trans = xaccMallocTransaction (book);
     xaccTransBeginEdit (trans_line->trans);
     xaccTransSetCurrency (trans_line->trans, currency);
@@ -1091,11 +904,365 @@ static GncCsvTransLine* trans_property_list_to_trans (TransPropertyList* list, g
     return trans_line;
 }
 
+/** The properties of one row, parsed before its transaction is
+ * created. Parsing the cells doesn't touch the engine, so it is done
+ * for many rows at once by parse_lines_properties. */
+typedef struct
+{
+    int line_no;             /**< The row's number */
+    GPtrArray* line;         /**< The row's cells */
+    TransPropertyList* list; /**< The row's properties, or NULL if they have errors */
+    gchar* error_message;    /**< Why the properties couldn't be parsed, or NULL */
+} ParsedLine;
+
+/** A range of ParsedLines handed to a parsing thread. */
+typedef struct
+{
+    ParsedLine* lines;
+    guint count;
+} ParsedLineChunk;
+
+/** Parses the cells of one row into a TransPropertyList and checks
+ * that it has the essential properties. Columns that name accounts
+ * are left for parsed_line_to_trans, since looking accounts up isn't
+ * safe outside the main thread: the property of an "Other Account"
+ * column holds the cell text until then.
+ * @param parse_data Data that is being parsed
+ * @param parsed The row, whose list or error_message is set
+ */
+static void parse_line_properties (GncCsvParseData* parse_data, ParsedLine* parsed)
+{
+    GArray* column_types = parse_data->column_types;
+    GPtrArray* line = parsed->line;
+    TransPropertyList* list;
+    int j;
+
+    list = trans_property_list_new (NULL, parse_data->date_format, parse_data->currency_format);
+
+    for (j = 0; j < line->len; j++)
+    {
+        TransProperty* property;
+
+        /* We do nothing in "None" or "Account" columns. */
+        if ((column_types->data[j] == GNC_CSV_NONE) || (column_types->data[j] == GNC_CSV_ACCOUNT))
+            continue;
+
+        /* Affect the transaction appropriately. */
+        property = trans_property_new (column_types->data[j], list);
+        if (property->type == GNC_CSV_OACCOUNT)
+        {
+            property->value = line->pdata[j];
+            trans_property_list_add (property);
+        }
+        /* TODO Maybe move error handling to within TransPropertyList functions? */
+        else if (trans_property_set (property, line->pdata[j]))
+            trans_property_list_add (property);
+        else
+        {
+            parsed->error_message = g_strdup_printf (_("%s column could not be understood."),
+                                                    _(gnc_csv_column_type_strs[property->type]));
+            trans_property_free (property);
+            trans_property_list_free (list);
+            return;
+        }
+    }
+
+    /* Make sure this is a transaction with all the columns we need. */
+    if (!trans_property_list_verify_essentials (list, &parsed->error_message))
+    {
+        trans_property_list_free (list);
+        return;
+    }
+    parsed->list = list;
+}
+
+/** GThreadPool function parsing the properties of a chunk of rows.
+ * @param data The ParsedLineChunk to parse
+ * @param user_data The GncCsvParseData that is being parsed
+ */
+static void parse_line_chunk_properties (gpointer data, gpointer user_data)
+{
+    ParsedLineChunk* chunk = data;
+    guint k;
+
+    for (k = 0; k < chunk->count; k++)
+        parse_line_properties ((GncCsvParseData*)user_data, &chunk->lines[k]);
+}
+
+/** Parses the properties of rows in chunks of GNC_CSV_PARSE_CHUNK_ROWS
+ * rows, on up to GNC_CSV_PARSE_THREADS threads. The first chunk is
+ * parsed before the threads start so that the lazily initialized
+ * locale and date settings the parsers use are set up by one thread.
+ * @param parse_data Data that is being parsed
+ * @param lines The rows to parse
+ * @param count The number of rows in lines
+ */
+static void parse_lines_properties (GncCsvParseData* parse_data, ParsedLine* lines, guint count)
+{
+    guint num_chunks = (count + GNC_CSV_PARSE_CHUNK_ROWS - 1) / GNC_CSV_PARSE_CHUNK_ROWS;
+    ParsedLineChunk* chunks;
+    GThreadPool* pool = NULL;
+    guint c;
+
+    if (count == 0)
+        return;
+
+    chunks = g_new (ParsedLineChunk, num_chunks);
+    for (c = 0; c < num_chunks; c++)
+    {
+        chunks[c].lines = lines + c * GNC_CSV_PARSE_CHUNK_ROWS;
+        chunks[c].count = MIN (GNC_CSV_PARSE_CHUNK_ROWS, count - c * GNC_CSV_PARSE_CHUNK_ROWS);
+    }
+
+    parse_line_chunk_properties (&chunks[0], parse_data);
+    if (num_chunks > 1)
+        pool = g_thread_pool_new (parse_line_chunk_properties, parse_data,
+                                  GNC_CSV_PARSE_THREADS, FALSE, NULL);
+    for (c = 1; c < num_chunks; c++)
+    {
+        /* Without a pool (which shouldn't happen) parse the chunk here. */
+        if (pool != NULL)
+            g_thread_pool_push (pool, &chunks[c], NULL);
+        else
+            parse_line_chunk_properties (&chunks[c], parse_data);
+    }
+    /* Wait for all the chunks to be parsed. */
+    if (pool != NULL)
+        g_thread_pool_free (pool, FALSE, TRUE);
+    g_free (chunks);
+}
+
+/** Creates the transaction for a row whose properties have been
+ * parsed and inserts it into parse_data->transactions, which is kept
+ * sorted by date. This is the part of the conversion that uses the
+ * engine, so rows go through it one at a time, in order.
+ * @param parse_data Data that is being parsed
+ * @param parsed The row, whose list is consumed
+ * @param account Account with which transactions are created, or NULL to use the row's Account column
+ * @param home_account Will point to the account that was used
+ * @param last_transaction Points to the last element in parse_data->transactions
+ * @return NULL on success, or a newly allocated error message if the row could not be converted
+ */
+static gchar* parsed_line_to_trans (GncCsvParseData* parse_data, ParsedLine* parsed,
+                                    Account* account, Account** home_account,
+                                    GList** last_transaction)
+{
+    GArray* column_types = parse_data->column_types;
+    GPtrArray* line = parsed->line;
+    TransPropertyList* list = parsed->list;
+    GncCsvTransLine* trans_line;
+    GList* properties;
+    int j;
+
+    parsed->list = NULL;
+    *home_account = account;
+
+    // If account = NULL, we should have an Account column
+    if (*home_account == NULL)
+    {
+        for (j = 0; j < line->len; j++)
+        {
+            /* Look for "Account" columns. */
+            if (column_types->data[j] == GNC_CSV_ACCOUNT)
+            {
+                *home_account = gnc_csv_account_map_search (line->pdata[j]);
+            }
+        }
+    }
+
+    if (*home_account == NULL)
+    {
+        if (list != NULL)
+            trans_property_list_free (list);
+        g_free (parsed->error_message);
+        return g_strdup_printf (_("Account column could not be understood."));
+    }
+
+    if (list == NULL)
+        return parsed->error_message;
+
+    /* Now look up the accounts of the "Other Account" columns. */
+    list->account = *home_account;
+    for (properties = list->properties; properties != NULL; properties = g_list_next (properties))
+    {
+        TransProperty* prop = properties->data;
+        if (prop->type == GNC_CSV_OACCOUNT)
+            trans_property_set (prop, prop->value);
+    }
+
+    trans_line = trans_property_list_to_trans (list);
+    trans_property_list_free (list);
+
+    /* If all went well, add this transaction to the list. */
+    trans_line->line_no = parsed->line_no;
+
+    /* We keep the transactions sorted by date. We start at the end
+     * of the list and go backward, simply because the file itself
+     * is probably also sorted by date (but we need to handle the
+     * exception anyway). */
+
+    /* If we can just put it at the end, do so and increment last_transaction. */
+    if (*last_transaction == NULL ||
+            xaccTransGetDate (((GncCsvTransLine*)((*last_transaction)->data))->trans) <= xaccTransGetDate (trans_line->trans))
+    {
+        /* If this is the first transaction, we need to get last_transaction on track. */
+        if (*last_transaction == NULL)
+        {
+            parse_data->transactions = g_list_append (parse_data->transactions, trans_line);
+            *last_transaction = parse_data->transactions;
+        }
+        else /* Otherwise, we can append right after it and continue. */
+        {
+            g_list_append (*last_transaction, trans_line);
+            *last_transaction = g_list_next (*last_transaction);
+        }
+    }
+    /* Otherwise, search backward for the correct spot. */
+    else
+    {
+        GList* insertion_spot = *last_transaction;
+        while (insertion_spot != NULL &&
+                xaccTransGetDate (((GncCsvTransLine*)(insertion_spot->data))->trans) > xaccTransGetDate (trans_line->trans))
+        {
+            insertion_spot = g_list_previous (insertion_spot);
+        }
+        /* Move insertion_spot one location forward since we have to
+         * use the g_list_insert_before function. */
+        if (insertion_spot == NULL) /* We need to handle the case of inserting at the beginning of the list. */
+            insertion_spot = parse_data->transactions;
+        else
+            insertion_spot = g_list_next (insertion_spot);
+
+        parse_data->transactions = g_list_insert_before (parse_data->transactions, insertion_spot, trans_line);
+    }
+    return NULL;
+}
+
+/** Adds a row that was read by parse_stream_to_trans and could not be
+ * converted to parse_data->orig_lines and parse_data->error_lines, so
+ * that the user can correct it like the rows of the preview.
+ * @param parse_data Data that is being parsed
+ * @param line The row's cells, which are copied
+ * @param error_message The row's error message, which is taken over
+ */
+static void stream_add_error_line (GncCsvParseData* parse_data, GPtrArray* line,
+                                   gchar* error_message)
+{
+    GPtrArray* copy = g_ptr_array_sized_new (line->len + 1);
+    int length = line->len;
+    int j;
+
+    for (j = 0; j < line->len; j++)
+        g_ptr_array_add (copy, g_string_chunk_insert (parse_data->chunk, line->pdata[j]));
+    g_ptr_array_add (copy, error_message);
+
+    parse_data->error_lines = g_list_append (parse_data->error_lines,
+                                            GINT_TO_POINTER(parse_data->orig_lines->len));
+    g_ptr_array_add (parse_data->orig_lines, copy);
+    g_array_append_val (parse_data->orig_row_lengths, length);
+    if (length > parse_data->orig_max_row)
+        parse_data->orig_max_row = length;
+}
+
+/** Creates transactions from the rows of a large file that follow the
+ * ones in parse_data->orig_lines (see parse_data->streaming). The rest
+ * of the file is converted and parsed a batch at a time, so only one
+ * batch is held in memory at once; rows with errors are kept in
+ * parse_data->orig_lines, the others are dropped once their
+ * transaction has been created.
+ * @param parse_data Data that is being parsed
+ * @param account Account with which transactions are created
+ * @param next_row Number of the first row to use, counting the rows in parse_data->orig_lines
+ * @param home_account Will point to the account that was used
+ * @param last_transaction Points to the last element in parse_data->transactions
+ */
+static void parse_stream_to_trans (GncCsvParseData* parse_data, Account* account,
+                                   int next_row, Account** home_account,
+                                   GList** last_transaction)
+{
+    const gchar* pos = parse_data->raw_str.begin + parse_data->stream_offset;
+    int row = parse_data->orig_lines->len;
+
+    while (pos < parse_data->raw_str.end)
+    {
+        const gchar* batch_end = raw_record_end (parse_data, pos, pos + GNC_CSV_BATCH_SIZE);
+        GStringChunk* chunk;
+        GPtrArray* lines;
+        GArray* rows;
+        gsize bytes_written;
+        gchar* utf8;
+        int k, j;
+
+        utf8 = g_convert (pos, batch_end - pos, "UTF-8", parse_data->encoding,
+                          NULL, &bytes_written, NULL);
+        pos = batch_end;
+        if (utf8 == NULL)
+        {
+            /* Don't drop the rows silently; let the user see that part of the file is missing. */
+            GPtrArray* line = g_ptr_array_new ();
+            PWARN ("Could not convert rows after row %d from %s", row, parse_data->encoding);
+            stream_add_error_line (parse_data, line,
+                                   g_strdup_printf (_("The rows following this one could not be converted from %s."),
+                                                    parse_data->encoding));
+            g_ptr_array_free (line, TRUE);
+            break;
+        }
+
+        chunk = g_string_chunk_new (100 * 1024);
+        lines = stf_parse_general (parse_data->options, chunk, utf8, utf8 + bytes_written);
+        if (lines == NULL)
+            lines = g_ptr_array_new ();
+
+        /* Pick the rows to use and parse their properties. */
+        rows = g_array_new (FALSE, TRUE, sizeof (ParsedLine));
+        for (k = 0; k < lines->len; k++, row++)
+        {
+            if (row == next_row)
+            {
+                ParsedLine parsed = {row, lines->pdata[k], NULL, NULL};
+                g_array_append_val (rows, parsed);
+                next_row += parse_data->skip_rows ? 2 : 1;
+            }
+        }
+        parse_lines_properties (parse_data, (ParsedLine*)rows->data, rows->len);
+
+        for (k = 0; k < rows->len; k++)
+        {
+            ParsedLine* parsed = &g_array_index (rows, ParsedLine, k);
+            gchar* error_message = parsed_line_to_trans (parse_data, parsed, account,
+                                                         home_account, last_transaction);
+            if (error_message != NULL)
+                stream_add_error_line (parse_data, parsed->line, error_message);
+        }
+        g_array_free (rows, TRUE);
+
+        /* CSV cells are allocated one by one; fixed width ones live in chunk. */
+        if (parse_data->options->parsetype == PARSE_TYPE_CSV)
+        {
+            for (k = 0; k < lines->len; k++)
+            {
+                GPtrArray* line = lines->pdata[k];
+                for (j = 0; j < line->len; j++)
+                    g_free (line->pdata[j]);
+            }
+        }
+        stf_parse_general_free (lines);
+        g_string_chunk_free (chunk);
+        g_free (utf8);
+    }
+
+    /* Rows with errors were added to orig_lines; redoing the errors must reach them. */
+    parse_data->end_row = parse_data->orig_lines->len;
+}
+
 /** Creates a list of transactions from parsed data. Transactions that
  * could be created from rows are placed in parse_data->transactions;
  * rows that fail are placed in parse_data->error_lines. (Note: there
  * is no way for this function to "fail," i.e. it only returns 0, so
- * it may be changed to a void function in the future.)
+ * it may be changed to a void function in the future.) For large
+ * files, the rows following those in parse_data->orig_lines are read
+ * from the file in batches here; the ones with errors are added to
+ * parse_data->orig_lines.
  * @param parse_data Data that is being parsed
  * @param account Account with which transactions are created
  * @param redo_errors TRUE to convert only error data, FALSE for all data
@@ -1104,9 +1271,10 @@ static GncCsvTransLine* trans_property_list_to_trans (TransPropertyList* list, g
 int gnc_csv_parse_to_trans (GncCsvParseData* parse_data, Account* account,
                            gboolean redo_errors)
 {
-    gboolean hasBalanceColumn;
-    int i, j, max_cols = 0;
-    GArray* column_types = parse_data->column_types;
+    gboolean hasBalanceColumn, read_stream;
+    int i, max_cols = 0;
+    guint k;
+    GArray* rows;
     GList *error_lines = NULL, *begin_error_lines = NULL;
     Account *home_account = NULL;
 
@@ -1155,82 +1323,59 @@ int gnc_csv_parse_to_trans (GncCsvParseData* parse_data, Account* account,
         last_transaction = NULL;
     }
 
+    /* The rows of a large file that aren't in orig_lines are only read
+     * when the user hasn't chosen to stop before the end of orig_lines. */
+    read_stream = (!redo_errors && parse_data->streaming &&
+                   parse_data->end_row >= parse_data->orig_lines->len);
+
     /* set parse_data->end_row to number of lines */
     if (parse_data->end_row > parse_data->orig_lines->len)
         parse_data->end_row = parse_data->orig_lines->len;
 
+    /* Pick the rows to convert ... */
+    rows = g_array_new (FALSE, TRUE, sizeof (ParsedLine));
     while (i < parse_data->end_row)
     {
-        GPtrArray* line = parse_data->orig_lines->pdata[i];
-        /* This flag is TRUE if there are any errors in this row. */
-        gboolean errors = FALSE;
-        gchar* error_message = NULL;
-        TransPropertyList* list;
-        GncCsvTransLine* trans_line = NULL;
-
-        home_account = account;
+        ParsedLine parsed = {i, parse_data->orig_lines->pdata[i], NULL, NULL};
+        g_array_append_val (rows, parsed);
 
-        // If account = NULL, we should have an Account column
-        if (home_account == NULL)
-        {
-            for (j = 0; j < line->len; j++)
-            {
-                /* Look for "Account" columns. */
-                if (column_types->data[j] == GNC_CSV_ACCOUNT)
-                {
-                    home_account = gnc_csv_account_map_search (line->pdata[j]);
-                }
-            }
-        }
-
-        if (home_account == NULL)
+        /* Increment to the next row. */
+        if (redo_errors)
         {
-            error_message = g_strdup_printf (_("Account column could not be understood."));
-            errors = TRUE;
+            /* Move to the next error line in the list. */
+            error_lines = g_list_next (error_lines);
+            if (error_lines == NULL)
+                i = parse_data->orig_lines->len; /* Don't continue the for loop. */
+            else
+                i = GPOINTER_TO_INT(error_lines->data);
         }
         else
         {
-            list = trans_property_list_new (home_account, parse_data->date_format, parse_data->currency_format);
+            if (parse_data->skip_rows == FALSE)
+                i++;
+            else
+                i = i + 2;
+        }
+    }
 
-            for (j = 0; j < line->len; j++)
-            {
-                /* We do nothing in "None" or "Account" columns. */
-                if ((column_types->data[j] != GNC_CSV_NONE) && (column_types->data[j] != GNC_CSV_ACCOUNT))
-                {
-                    /* Affect the transaction appropriately. */
-                    TransProperty* property = trans_property_new (column_types->data[j], list);
-                    gboolean succeeded = trans_property_set (property, line->pdata[j]);
-
-                    /* TODO Maybe move error handling to within TransPropertyList functions? */
-                    if (succeeded)
-                        trans_property_list_add (property);
-                    else
-                    {
-                        errors = TRUE;
-                        error_message = g_strdup_printf (_("%s column could not be understood."),
-                                                        _(gnc_csv_column_type_strs[property->type]));
-                        trans_property_free (property);
-                        break;
-                    }
-                }
-            }
+    /* ... parse their cells ... */
+    parse_lines_properties (parse_data, (ParsedLine*)rows->data, rows->len);
 
-            /* If we had success, add the transaction to parse_data->transaction. */
-            if (!errors)
-            {
-                trans_line = trans_property_list_to_trans (list, &error_message);
-                errors = trans_line == NULL;
-            }
-            trans_property_list_free (list);
-        }
+    /* ... and create their transactions in order. */
+    for (k = 0; k < rows->len; k++)
+    {
+        ParsedLine* parsed = &g_array_index (rows, ParsedLine, k);
+        GPtrArray* line = parsed->line;
+        gchar* error_message = parsed_line_to_trans (parse_data, parsed, account,
+                                                     &home_account, &last_transaction);
 
         /* If there were errors, add this line to parse_data->error_lines. */
-        if (errors)
+        if (error_message != NULL)
         {
             parse_data->error_lines = g_list_append (parse_data->error_lines,
-                                                    GINT_TO_POINTER(i));
+                                                    GINT_TO_POINTER(parsed->line_no));
             /* If there's already an error message, we need to replace it. */
-            if (line->len > (int)(parse_data->orig_row_lengths->data[i]))
+            if (line->len > g_array_index (parse_data->orig_row_lengths, int, parsed->line_no))
             {
                 g_free(line->pdata[line->len - 1]);
                 line->pdata[line->len - 1] = error_message;
@@ -1241,65 +1386,11 @@ int gnc_csv_parse_to_trans (GncCsvParseData* parse_data, Account* account,
                 g_ptr_array_add (line, error_message);
             }
         }
-        else
-        {
-            /* If all went well, add this transaction to the list. */
-            trans_line->line_no = i;
-
-            /* We keep the transactions sorted by date. We start at the end
-             * of the list and go backward, simply because the file itself
-             * is probably also sorted by date (but we need to handle the
-             * exception anyway). */
-
-            /* If we can just put it at the end, do so and increment last_transaction. */
-            if (last_transaction == NULL ||
-                    xaccTransGetDate (((GncCsvTransLine*)(last_transaction->data))->trans) <= xaccTransGetDate (trans_line->trans))
-            {
-                parse_data->transactions = g_list_append (parse_data->transactions, trans_line);
-                /* If this is the first transaction, we need to get last_transaction on track. */
-                if (last_transaction == NULL)
-                    last_transaction = parse_data->transactions;
-                else /* Otherwise, we can just continue. */
-                    last_transaction = g_list_next (last_transaction);
-            }
-            /* Otherwise, search backward for the correct spot. */
-            else
-            {
-                GList* insertion_spot = last_transaction;
-                while (insertion_spot != NULL &&
-                        xaccTransGetDate (((GncCsvTransLine*)(insertion_spot->data))->trans) > xaccTransGetDate (trans_line->trans))
-                {
-                    insertion_spot = g_list_previous (insertion_spot);
-                }
-                /* Move insertion_spot one location forward since we have to
-                 * use the g_list_insert_before function. */
-                if (insertion_spot == NULL) /* We need to handle the case of inserting at the beginning of the list. */
-                    insertion_spot = parse_data->transactions;
-                else
-                    insertion_spot = g_list_next (insertion_spot);
-
-                parse_data->transactions = g_list_insert_before (parse_data->transactions, insertion_spot, trans_line);
-            }
-        }
-
-        /* Increment to the next row. */
-        if (redo_errors)
-        {
-            /* Move to the next error line in the list. */
-            error_lines = g_list_next (error_lines);
-            if (error_lines == NULL)
-                i = parse_data->orig_lines->len; /* Don't continue the for loop. */
-            else
-                i = GPOINTER_TO_INT(error_lines->data);
-        }
-        else
-        {
-            if (parse_data->skip_rows == FALSE)
-                i++;
-            else
-                i = i + 2;
-        }
     }
+    g_array_free (rows, TRUE);
+
+    if (read_stream)
+        parse_stream_to_trans (parse_data, account, i, &home_account, &last_transaction);
 
     /* If we have a balance column, set the appropriate amounts on the transactions. */
     hasBalanceColumn = FALSE;
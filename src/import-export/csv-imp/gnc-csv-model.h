@@ -127,6 +127,11 @@ typedef struct
     int end_row;                /**< The end row to generate transactions from. */
     gboolean skip_rows;         /**< Skip Alternate Rows from start row. */
     int currency_format;        /**< The currency format, 0 for locale, 1 for comma dec and 2 for period */
+    gboolean streaming;         /**< TRUE if the file is too large to be held in memory as
+                                      a whole; orig_lines then holds only the rows at the start
+                                      of the file and the rest is read in batches by
+                                      gnc_csv_parse_to_trans */
+    gsize stream_offset;        /**< Offset in raw_str of the first row after those in file_str */
 } GncCsvParseData;
 
 GncCsvParseData* gnc_csv_new_parse_data (void);
@@ -117,15 +117,6 @@ teardown( Fixture *fixture, gconstpointer pData )
 static const gchar *suitename = "/import-export/csv-imp/gnc-csv-model";
 void test_suite_gnc_csv_model ( void );
 
-/* parse_date_with_year
-time64 parse_date_with_year (const char* date_str, int format)// Local: 1:0:0
-*/
-// Internal helper only - no tests.
-/* parse_date_without_year
-static time64 parse_date_without_year (const char* date_str, int format)// Local: 1:0:0
-*/
-// Internal helper only - no tests.
-
 /* parse_date
 time64 parse_date (const char* date_str, int format)// C: 14 in 7 SCM: 9 in 2 Local: 1:0:0
 */
@@ -441,8 +432,6 @@ void
 test_suite_gnc_csv_model (void)
 {
 
-// GNC_TEST_ADD (suitename, "parse date with year", Fixture, NULL, setup, test_parse_date_with_year, teardown);
-// GNC_TEST_ADD (suitename, "parse date without year", Fixture, NULL, setup, test_parse_date_without_year, teardown);
 GNC_TEST_ADD_FUNC (suitename, "parse date", test_parse_date);
 GNC_TEST_ADD_FUNC (suitename, "gnc csv new parse data", test_gnc_csv_new_parse_data);
 // GNC_TEST_ADD (suitename, "gnc csv parse data free", Fixture, NULL, setup, test_gnc_csv_parse_data_free, teardown);
@@ -732,7 +732,9 @@ static void split_find_match (GNCImportTransInfo * trans_info,
             const char *memo = xaccSplitGetMemo(new_trans_fsplit);
             if (memo && strlen(memo) != 0)
             {
-                if (safe_strcasecmp(memo, xaccSplitGetMemo(split)) == 0)
+                /* Equal memos share one cached string. */
+                if (memo == xaccSplitGetMemo(split) ||
+                        safe_strcasecmp(memo, xaccSplitGetMemo(split)) == 0)
                 {
                     /* An exact match of memo gives a +2 */
                     prob = prob + 2;
@@ -757,8 +759,9 @@ static void split_find_match (GNCImportTransInfo * trans_info,
             const char *descr = xaccTransGetDescription(new_trans);
             if (descr && strlen(descr) != 0)
             {
-                if (safe_strcasecmp(descr,
-                                    xaccTransGetDescription(xaccSplitGetParent(split)))
+                if (descr == xaccTransGetDescription(xaccSplitGetParent(split)) ||
+                        safe_strcasecmp(descr,
+                                        xaccTransGetDescription(xaccSplitGetParent(split)))
                         == 0)
                 {
                     /*An exact match of Description gives a +2 */
@@ -864,6 +867,122 @@ void gnc_import_find_split_matches(GNCImportTransInfo *trans_info,
     qof_query_destroy (query);
 }
 
+/** The splits of each account matched against in an import session,
+ * with their transactions' posted dates, sorted by date. */
+struct _matchindex
+{
+    GHashTable *accounts; /* Account* -> GArray of MatchIndexEntry */
+};
+
+typedef struct
+{
+    time64 date;
+    Split *split;
+} MatchIndexEntry;
+
+static gint
+match_index_entry_compare (gconstpointer a, gconstpointer b)
+{
+    time64 da = ((const MatchIndexEntry *)a)->date;
+    time64 db = ((const MatchIndexEntry *)b)->date;
+    return (da > db) - (da < db);
+}
+
+static void
+match_index_array_free (gpointer array)
+{
+    g_array_free (array, TRUE);
+}
+
+GNCImportMatchIndex *
+gnc_import_match_index_new (void)
+{
+    GNCImportMatchIndex *index = g_new0 (GNCImportMatchIndex, 1);
+    index->accounts = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                      NULL, match_index_array_free);
+    return index;
+}
+
+void
+gnc_import_match_index_destroy (GNCImportMatchIndex *index)
+{
+    if (!index)
+        return;
+    g_hash_table_destroy (index->accounts);
+    g_free (index);
+}
+
+static GArray *
+match_index_get_account (GNCImportMatchIndex *index, Account *account)
+{
+    GArray *entries = g_hash_table_lookup (index->accounts, account);
+    GList *node;
+
+    if (entries)
+        return entries;
+
+    entries = g_array_new (FALSE, FALSE, sizeof (MatchIndexEntry));
+    for (node = xaccAccountGetSplitList (account); node; node = node->next)
+    {
+        MatchIndexEntry entry;
+        entry.split = node->data;
+        entry.date = xaccTransGetDate (xaccSplitGetParent (entry.split));
+        g_array_append_val (entries, entry);
+    }
+    /* The split list is normally in date order already; make sure. */
+    g_array_sort (entries, match_index_entry_compare);
+    g_hash_table_insert (index->accounts, account, entries);
+    return entries;
+}
+
+/** As gnc_import_find_split_matches(), scanning the date range of the
+ * index instead of running a query. */
+static void
+gnc_import_find_split_matches_indexed (GNCImportTransInfo *trans_info,
+                                       GNCImportMatchIndex *index,
+                                       gint process_threshold,
+                                       double fuzzy_amount_difference,
+                                       gint match_date_hardlimit)
+{
+    Account *importaccount;
+    time64 download_time, first, last;
+    GArray *entries;
+    guint lo, hi;
+
+    g_assert (trans_info);
+
+    importaccount =
+        xaccSplitGetAccount (gnc_import_TransInfo_get_fsplit (trans_info));
+    if (!importaccount)
+        return;
+
+    download_time = xaccTransGetDate (gnc_import_TransInfo_get_trans (trans_info));
+    first = download_time - match_date_hardlimit * 86400;
+    last = download_time + match_date_hardlimit * 86400;
+    entries = match_index_get_account (index, importaccount);
+
+    /* Binary search for the first split on or after the window start. */
+    lo = 0;
+    hi = entries->len;
+    while (lo < hi)
+    {
+        guint mid = lo + (hi - lo) / 2;
+        if (g_array_index (entries, MatchIndexEntry, mid).date < first)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    for (; lo < entries->len; lo++)
+    {
+        MatchIndexEntry *entry = &g_array_index (entries, MatchIndexEntry, lo);
+        if (entry->date > last)
+            break;
+        split_find_match (trans_info, entry->split,
+                          process_threshold, fuzzy_amount_difference);
+    }
+}
+
 
 /***********************************************************************
  */
@@ -1198,16 +1317,30 @@ static gint compare_probability (gconstpointer a,
 void
 gnc_import_TransInfo_init_matches (GNCImportTransInfo *trans_info,
                                    GNCImportSettings *settings)
+{
+    gnc_import_TransInfo_init_matches_indexed (trans_info, settings, NULL);
+}
+
+void
+gnc_import_TransInfo_init_matches_indexed (GNCImportTransInfo *trans_info,
+                                           GNCImportSettings *settings,
+                                           GNCImportMatchIndex *index)
 {
     GNCImportMatchInfo * best_match = NULL;
     g_assert (trans_info);
 
 
     /* Find all split matches in originating account. */
-    gnc_import_find_split_matches(trans_info,
-                                  gnc_import_Settings_get_display_threshold (settings),
-                                  gnc_import_Settings_get_fuzzy_amount (settings),
-                                  gnc_import_Settings_get_match_date_hardlimit (settings));
+    if (index)
+        gnc_import_find_split_matches_indexed (trans_info, index,
+                                               gnc_import_Settings_get_display_threshold (settings),
+                                               gnc_import_Settings_get_fuzzy_amount (settings),
+                                               gnc_import_Settings_get_match_date_hardlimit (settings));
+    else
+        gnc_import_find_split_matches(trans_info,
+                                      gnc_import_Settings_get_display_threshold (settings),
+                                      gnc_import_Settings_get_fuzzy_amount (settings),
+                                      gnc_import_Settings_get_match_date_hardlimit (settings));
 
     if (trans_info->match_list != NULL)
     {
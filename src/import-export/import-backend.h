@@ -33,6 +33,7 @@
 
 typedef struct _transactioninfo GNCImportTransInfo;
 typedef struct _matchinfo GNCImportMatchInfo;
+typedef struct _matchindex GNCImportMatchIndex;
 
 typedef enum _action
 {
@@ -100,6 +101,25 @@ void
 gnc_import_TransInfo_init_matches (GNCImportTransInfo *trans_info,
                                    GNCImportSettings *settings);
 
+/** Creates an index for finding match candidates during one import
+ * session.  The first time an account is matched against, its splits
+ * are sorted by date once.  The candidates for each imported
+ * transaction are then found by binary search on that array, where
+ * gnc_import_find_split_matches() runs a query per transaction.
+ *
+ * The index assumes that the accounts' existing transactions don't
+ * change while it is in use; destroy it when the session ends. */
+GNCImportMatchIndex *gnc_import_match_index_new (void);
+
+void gnc_import_match_index_destroy (GNCImportMatchIndex *index);
+
+/** As gnc_import_TransInfo_init_matches(), finding the candidate
+ * splits through the given index. */
+void
+gnc_import_TransInfo_init_matches_indexed (GNCImportTransInfo *trans_info,
+                                           GNCImportSettings *settings,
+                                           GNCImportMatchIndex *index);
+
 /** This function is intended to be called when the importer dialog is
  * finished. It should be called once for each imported transaction
  * and processes each ImportTransInfo according to its selected action:
@@ -43,6 +43,7 @@
 #include "gnc-ui.h"
 #include "gnc-ui-util.h"
 #include "gnc-engine.h"
+#include "Scrub.h"
 #include "import-settings.h"
 #include "import-match-picker.h"
 #include "import-backend.h"
@@ -63,6 +64,9 @@ struct _main_matcher_info
     int selected_row;
     GNCTransactionProcessedCB transaction_processed_cb;
     gpointer user_data;
+    /* Candidate splits of the import accounts, built on the first
+     * transaction added and kept until the matcher is deleted. */
+    GNCImportMatchIndex *match_index;
 };
 
 enum downloaded_cols
@@ -129,6 +133,9 @@ void gnc_gen_trans_list_delete (GNCImportMainMatcher *info)
     }
 
 
+    gnc_import_match_index_destroy (info->match_index);
+    info->match_index = NULL;
+
     if (!(info->dialog == NULL))
     {
         gnc_save_window_size(GNC_PREFS_GROUP, GTK_WINDOW(info->dialog));
@@ -159,6 +166,7 @@ on_matcher_ok_clicked (GtkButton *button,
     /* Don't run any queries and/or split sorts while processing the matcher
     results. */
     gnc_suspend_gui_refresh();
+    gnc_book_begin_bulk_ingest (gnc_get_current_book ());
 
     do
     {
@@ -179,6 +187,10 @@ on_matcher_ok_clicked (GtkButton *button,
     while (gtk_tree_model_iter_next (model, &iter));
 
     /* Allow GUI refresh again. */
+    gnc_book_end_bulk_ingest (gnc_get_current_book ());
+    /* Check just what the import committed. */
+    xaccBookScrubModified (gnc_get_current_book (),
+                           g_getenv ("GNC_AUTO_SCRUB_LOTS") != NULL);
     gnc_resume_gui_refresh();
 
     gnc_gen_trans_list_delete (info);
@@ -891,8 +903,11 @@ void gnc_gen_trans_list_add_trans_with_ref_id(GNCImportMainMatcher *gui, Transac
         transaction_info = gnc_import_TransInfo_new(trans, NULL);
         gnc_import_TransInfo_set_ref_id(transaction_info, ref_id);
 
-        gnc_import_TransInfo_init_matches(transaction_info,
-                                          gui->user_settings);
+        if (gui->match_index == NULL)
+            gui->match_index = gnc_import_match_index_new ();
+        gnc_import_TransInfo_init_matches_indexed(transaction_info,
+                gui->user_settings,
+                gui->match_index);
 
         model = gtk_tree_view_get_model(gui->view);
         gtk_list_store_append(GTK_LIST_STORE(model), &iter);
@@ -33,18 +33,24 @@
 #include "qof.h"
 #include "Account.h"
 #include "Transaction.h"
+#include "qofinstance-p.h"
 
 
 /********************************************************************\
  * Setter and getter functions for the online_id kvp frame in
  * Account, Transaction and Split
+ *
+ * The getters borrow the string from the kvp slot, since the matcher
+ * asks for the id of every transaction it looks at.
 \********************************************************************/
 
+static const gchar *online_id_keys[] = {"online_id"};
+
 const gchar * gnc_import_get_acc_online_id (Account * account)
 {
-    gchar *id = NULL;
-    qof_instance_get (QOF_INSTANCE (account), "online-id", &id, NULL);
-    return id;
+    return qof_instance_get_kvp_string (QOF_INSTANCE (account),
+                                        G_N_ELEMENTS (online_id_keys),
+                                        online_id_keys);
 }
 
 /* Used in the midst of editing a transaction; make it save the
@@ -59,9 +65,9 @@ void gnc_import_set_acc_online_id (Account *account, const gchar *id)
 
 const gchar * gnc_import_get_trans_online_id (Transaction * transaction)
 {
-    gchar *id = NULL;
-    qof_instance_get (QOF_INSTANCE (transaction), "online-id", &id, NULL);
-    return id;
+    return qof_instance_get_kvp_string (QOF_INSTANCE (transaction),
+                                        G_N_ELEMENTS (online_id_keys),
+                                        online_id_keys);
 }
 /* Not actually used */
 void gnc_import_set_trans_online_id (Transaction *transaction,
@@ -82,9 +88,9 @@ gboolean gnc_import_trans_has_online_id(Transaction * transaction)
 
 const gchar * gnc_import_get_split_online_id (Split * split)
 {
-    gchar *id = NULL;
-    qof_instance_get (QOF_INSTANCE (split), "online-id", &id, NULL);
-    return id;
+    return qof_instance_get_kvp_string (QOF_INSTANCE (split),
+                                        G_N_ELEMENTS (online_id_keys),
+                                        online_id_keys);
 }
 /* Used several places in a transaction edit where many other
  * parameters are also being set, so individual commits wouldn't be
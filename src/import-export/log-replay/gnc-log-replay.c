@@ -27,10 +27,8 @@
 
 #include <gtk/gtk.h>
 #include <glib/gi18n.h>
-#include <glib/gstdio.h>
 #include <string.h>
 #include <sys/time.h>
-#include <errno.h>
 
 #include "Account.h"
 #include "Transaction.h"
@@ -62,7 +60,6 @@ static QofLogModule log_module = GNC_MOD_TEST;
    "%c\t%s/%s\t%s\t%s\t%s\t%s\t%s\t%s\t"
    "%s\t%s\t%s\t%c\t%lld/%lld\t%lld/%lld\t%s\n",
 */
-#define STRING_FIELD_SIZE 256
 typedef struct _split_record
 {
     enum _enum_action {LOG_BEGIN_EDIT, LOG_ROLLBACK, LOG_COMMIT, LOG_DELETE} log_action;
@@ -79,17 +76,17 @@ typedef struct _split_record
     int date_posted_present;
     GncGUID acc_guid;
     int acc_guid_present;
-    char acc_name[STRING_FIELD_SIZE];
+    const char *acc_name;
     int acc_name_present;
-    char trans_num[STRING_FIELD_SIZE];
+    const char *trans_num;
     int trans_num_present;
-    char trans_descr[STRING_FIELD_SIZE];
+    const char *trans_descr;
     int trans_descr_present;
-    char trans_notes[STRING_FIELD_SIZE];
+    const char *trans_notes;
     int trans_notes_present;
-    char split_memo[STRING_FIELD_SIZE];
+    const char *split_memo;
     int split_memo_present;
-    char split_action[STRING_FIELD_SIZE];
+    const char *split_action;
     int split_action_present;
     char split_reconcile;
     int split_reconcile_present;
@@ -105,52 +102,36 @@ typedef struct _split_record
  * Entry point
 \********************************************************************/
 
-static char *olds;
-/* This version of strtok will only match SINGLE occurence of delim,
-   returning a 0 length valid string between two consecutive ocurence of delim.
-   It will also return a 0 length string instead of NULL when it reaches the end of s
-*/
-static char * my_strtok (s, delim)
-char *s;
-const char *delim;
+/* Return the field of a log line that starts at *pos and move *pos
+ * to the next one.  Fields are separated by single tabs, so two
+ * consecutive tabs delimit an empty field; at the end of the line an
+ * empty string is returned.  The line is terminated in place.
+ */
+static char * next_field (char **pos)
 {
-    char *token;
-    /*DEBUG("strtok(): Start...");*/
-    if (s == NULL)
-        s = olds;
-
-    /* Scan leading delimiters.  */
-    /*s += strspn (s, delim);*/ /*Don't do it, or we will loose count.*/
-    if (*s == '\0')
-    {
-        olds = s;
-        return s;
-    }
+    char *field = *pos;
+    char *end = strchr (field, '\t');
 
-    /* Find the end of the token.  */
-    token = s;
-    s = strpbrk (token, delim);
-    if (s == NULL)
+    if (end == NULL)
     {
-        /* This token finishes the string.  */
-        olds = strchr (token, '\0');
+        *pos = field + strlen (field);
     }
     else
     {
-        /* Terminate the token and make OLDS point past it.  */
-        *s = '\0';
-        olds = s + 1;
+        *end = '\0';
+        *pos = end + 1;
     }
-    return token;
+    return field;
 }
 
 static split_record interpret_split_record( char *record_line)
 {
     char * tok_ptr;
+    char * pos = record_line;
     split_record record;
     memset(&record, 0, sizeof(record));
     DEBUG("interpret_split_record(): Start...");
-    if (strlen(tok_ptr = my_strtok(record_line, "\t")) != 0)
+    if (strlen(tok_ptr = next_field(&pos)) != 0)
     {
         switch (tok_ptr[0])
         {
@@ -169,88 +150,88 @@ static split_record interpret_split_record( char *record_line)
         }
         record.log_action_present = TRUE;
     }
-    if (strlen(tok_ptr = my_strtok(NULL, "\t")) != 0)
+    if (strlen(tok_ptr = next_field(&pos)) != 0)
     {
         string_to_guid(tok_ptr, &(record.trans_guid));
         record.trans_guid_present = TRUE;
     }
-    if (strlen(tok_ptr = my_strtok(NULL, "\t")) != 0)
+    if (strlen(tok_ptr = next_field(&pos)) != 0)
     {
         string_to_guid(tok_ptr, &(record.split_guid));
         record.split_guid_present = TRUE;
     }
-    if (strlen(tok_ptr = my_strtok(NULL, "\t")) != 0)
+    if (strlen(tok_ptr = next_field(&pos)) != 0)
     {
         record.log_date = gnc_iso8601_to_timespec_gmt(tok_ptr);
         record.log_date_present = TRUE;
     }
-    if (strlen(tok_ptr = my_strtok(NULL, "\t")) != 0)
+    if (strlen(tok_ptr = next_field(&pos)) != 0)
     {
         record.date_entered = gnc_iso8601_to_timespec_gmt(tok_ptr);
         record.date_entered_present = TRUE;
     }
-    if (strlen(tok_ptr = my_strtok(NULL, "\t")) != 0)
+    if (strlen(tok_ptr = next_field(&pos)) != 0)
     {
         record.date_posted = gnc_iso8601_to_timespec_gmt(tok_ptr);
         record.date_posted_present = TRUE;
     }
-    if (strlen(tok_ptr = my_strtok(NULL, "\t")) != 0)
+    if (strlen(tok_ptr = next_field(&pos)) != 0)
     {
         string_to_guid(tok_ptr, &(record.acc_guid));
         record.acc_guid_present = TRUE;
     }
-    if (strlen(tok_ptr = my_strtok(NULL, "\t")) != 0)
+    if (strlen(tok_ptr = next_field(&pos)) != 0)
     {
-        strncpy(record.acc_name, tok_ptr, STRING_FIELD_SIZE - 1);
+        record.acc_name = tok_ptr;
         record.acc_name_present = TRUE;
     }
-    if (strlen(tok_ptr = my_strtok(NULL, "\t")) != 0)
+    if (strlen(tok_ptr = next_field(&pos)) != 0)
     {
-        strncpy(record.trans_num, tok_ptr, STRING_FIELD_SIZE - 1);
+        record.trans_num = tok_ptr;
         record.trans_num_present = TRUE;
     }
-    if (strlen(tok_ptr = my_strtok(NULL, "\t")) != 0)
+    if (strlen(tok_ptr = next_field(&pos)) != 0)
     {
-        strncpy(record.trans_descr, tok_ptr, STRING_FIELD_SIZE - 1);
+        record.trans_descr = tok_ptr;
         record.trans_descr_present = TRUE;
     }
-    if (strlen(tok_ptr = my_strtok(NULL, "\t")) != 0)
+    if (strlen(tok_ptr = next_field(&pos)) != 0)
     {
-        strncpy(record.trans_notes, tok_ptr, STRING_FIELD_SIZE - 1);
+        record.trans_notes = tok_ptr;
         record.trans_notes_present = TRUE;
     }
-    if (strlen(tok_ptr = my_strtok(NULL, "\t")) != 0)
+    if (strlen(tok_ptr = next_field(&pos)) != 0)
     {
-        strncpy(record.split_memo, tok_ptr, STRING_FIELD_SIZE - 1);
+        record.split_memo = tok_ptr;
         record.split_memo_present = TRUE;
     }
-    if (strlen(tok_ptr = my_strtok(NULL, "\t")) != 0)
+    if (strlen(tok_ptr = next_field(&pos)) != 0)
     {
-        strncpy(record.split_action, tok_ptr, STRING_FIELD_SIZE - 1);
+        record.split_action = tok_ptr;
         record.split_action_present = TRUE;
     }
-    if (strlen(tok_ptr = my_strtok(NULL, "\t")) != 0)
+    if (strlen(tok_ptr = next_field(&pos)) != 0)
     {
         record.split_reconcile = tok_ptr[0];
         record.split_reconcile_present = TRUE;
     }
-    if (strlen(tok_ptr = my_strtok(NULL, "\t")) != 0)
+    if (strlen(tok_ptr = next_field(&pos)) != 0)
     {
         string_to_gnc_numeric(tok_ptr, &(record.amount));
         record.amount_present = TRUE;
     }
-    if (strlen(tok_ptr = my_strtok(NULL, "\t")) != 0)
+    if (strlen(tok_ptr = next_field(&pos)) != 0)
     {
         string_to_gnc_numeric(tok_ptr, &(record.value));
         record.value_present = TRUE;
     }
-    if (strlen(tok_ptr = my_strtok(NULL, "\t")) != 0)
+    if (strlen(tok_ptr = next_field(&pos)) != 0)
     {
         record.date_reconciled = gnc_iso8601_to_timespec_gmt(tok_ptr);
         record.date_reconciled_present = TRUE;
     }
 
-    if (strlen(tok_ptr = my_strtok(NULL, "\t")) != 0)
+    if (strlen(tok_ptr = next_field(&pos)) != 0)
     {
         PERR("interpret_split_record():  Expected number of fields exceeded!");
     }
@@ -359,16 +340,14 @@ static void dump_split_record(split_record record)
     }
 }
 
-/* File pointer must already be at the begining of a record */
-static void  process_trans_record(  FILE *log_file)
+/* Replay one logged transaction; lines are the lines between its
+ * ===== START and ===== END markers. */
+static void  process_trans_record(char **lines, guint n_lines)
 {
-    char read_buf[2048];
-    char *read_retval;
     char * trans_ro = NULL;
-    const char * record_end_str = "===== END";
     int first_record = TRUE;
-    int record_ended = FALSE;
     int split_num = 0;
+    guint i;
     split_record record;
     Transaction * trans = NULL;
     Split * split = NULL;
@@ -377,182 +356,283 @@ static void  process_trans_record(  FILE *log_file)
 
     DEBUG("process_trans_record(): Begin...\n");
 
-    while ( record_ended == FALSE)
+    for (i = 0; i < n_lines; i++)
     {
-        read_retval = fgets(read_buf, sizeof(read_buf), log_file);
-        if (read_retval != NULL && strncmp(record_end_str, read_buf, strlen(record_end_str)) != 0) /* If we are not at the end of the record */
-        {
-            split_num++;
-            /*DEBUG("process_trans_record(): Line read: %s%s",read_buf ,"\n");*/
-            record = interpret_split_record( read_buf);
+        char *read_buf = lines[i];
+        split_num++;
+        /*DEBUG("process_trans_record(): Line read: %s%s",read_buf ,"\n");*/
+        record = interpret_split_record( read_buf);
+        if (qof_log_check (log_module, QOF_LOG_DEBUG))
             dump_split_record( record);
-            if (record.log_action_present)
+        if (record.log_action_present)
+        {
+            switch (record.log_action)
             {
-                switch (record.log_action)
+            case LOG_BEGIN_EDIT:
+                DEBUG("process_trans_record():Ignoring log action: LOG_BEGIN_EDIT"); /*Do nothing, there is no point*/
+                break;
+            case LOG_ROLLBACK:
+                DEBUG("process_trans_record():Ignoring log action: LOG_ROLLBACK");/*Do nothing, since we didn't do the begin_edit either*/
+                break;
+            case LOG_DELETE:
+                DEBUG("process_trans_record(): Playing back LOG_DELETE");
+                if ((trans = xaccTransLookup (&(record.trans_guid), book)) != NULL
+                        && first_record == TRUE)
+                {
+                    first_record = FALSE;
+                    if (xaccTransGetReadOnly(trans))
+                    {
+                        PWARN("Destroying a read only transaction.");
+                        xaccTransClearReadOnly(trans);
+                    }
+                    xaccTransBeginEdit(trans);
+                    xaccTransDestroy(trans);
+                }
+                else if (first_record == TRUE)
+                {
+                    PERR("The transaction to delete was not found!");
+                }
+                else
+                    xaccTransDestroy(trans);
+                break;
+            case LOG_COMMIT:
+                DEBUG("process_trans_record(): Playing back LOG_COMMIT");
+                if (record.trans_guid_present == TRUE
+                        && first_record == TRUE)
                 {
-                case LOG_BEGIN_EDIT:
-                    DEBUG("process_trans_record():Ignoring log action: LOG_BEGIN_EDIT"); /*Do nothing, there is no point*/
-                    break;
-                case LOG_ROLLBACK:
-                    DEBUG("process_trans_record():Ignoring log action: LOG_ROLLBACK");/*Do nothing, since we didn't do the begin_edit either*/
-                    break;
-                case LOG_DELETE:
-                    DEBUG("process_trans_record(): Playing back LOG_DELETE");
-                    if ((trans = xaccTransLookup (&(record.trans_guid), book)) != NULL
-                            && first_record == TRUE)
+                    trans = xaccTransLookupDirect (record.trans_guid, book);
+                    if (trans != NULL)
                     {
-                        first_record = FALSE;
-                        if (xaccTransGetReadOnly(trans))
+                        DEBUG("process_trans_record(): Transaction to be edited was found");
+                        xaccTransBeginEdit(trans);
+                        trans_ro = g_strdup(xaccTransGetReadOnly(trans));
+                        if (trans_ro)
                         {
-                            PWARN("Destroying a read only transaction.");
+                            PWARN("Replaying a read only transaction.");
                             xaccTransClearReadOnly(trans);
                         }
-                        xaccTransBeginEdit(trans);
-                        xaccTransDestroy(trans);
-                    }
-                    else if (first_record == TRUE)
-                    {
-                        PERR("The transaction to delete was not found!");
                     }
                     else
-                        xaccTransDestroy(trans);
-                    break;
-                case LOG_COMMIT:
-                    DEBUG("process_trans_record(): Playing back LOG_COMMIT");
-                    if (record.trans_guid_present == TRUE
-                            && first_record == TRUE)
                     {
-                        trans = xaccTransLookupDirect (record.trans_guid, book);
-                        if (trans != NULL)
-                        {
-                            DEBUG("process_trans_record(): Transaction to be edited was found");
-                            xaccTransBeginEdit(trans);
-                            trans_ro = g_strdup(xaccTransGetReadOnly(trans));
-                            if (trans_ro)
-                            {
-                                PWARN("Replaying a read only transaction.");
-                                xaccTransClearReadOnly(trans);
-                            }
-                        }
-                        else
-                        {
-                            DEBUG("process_trans_record(): Creating a new transaction");
-                            trans = xaccMallocTransaction (book);
-                            xaccTransBeginEdit(trans);
-                        }
+                        DEBUG("process_trans_record(): Creating a new transaction");
+                        trans = xaccMallocTransaction (book);
+                        xaccTransBeginEdit(trans);
+                    }
 
-                        qof_instance_set_guid (QOF_INSTANCE (trans),
+                    qof_instance_set_guid (QOF_INSTANCE (trans),
 					       &(record.trans_guid));
-                        /*Fill the transaction info*/
-                        if (record.date_entered_present)
-                        {
-                            xaccTransSetDateEnteredTS(trans, &(record.date_entered));
-                        }
-                        if (record.date_posted_present)
-                        {
-                            xaccTransSetDatePostedTS(trans, &(record.date_posted));
-                        }
-                        if (record.trans_num_present)
-                        {
-                            xaccTransSetNum(trans, record.trans_num);
-                        }
-                        if (record.trans_descr_present)
-                        {
-                            xaccTransSetDescription(trans, record.trans_descr);
-                        }
-                        if (record.trans_notes_present)
-                        {
-                            xaccTransSetNotes(trans, record.trans_notes);
-                        }
+                    /*Fill the transaction info*/
+                    if (record.date_entered_present)
+                    {
+                        xaccTransSetDateEnteredTS(trans, &(record.date_entered));
                     }
-                    if (record.split_guid_present == TRUE) /*Fill the split info*/
+                    if (record.date_posted_present)
                     {
-                        gboolean is_new_split;
+                        xaccTransSetDatePostedTS(trans, &(record.date_posted));
+                    }
+                    if (record.trans_num_present)
+                    {
+                        xaccTransSetNum(trans, record.trans_num);
+                    }
+                    if (record.trans_descr_present)
+                    {
+                        xaccTransSetDescription(trans, record.trans_descr);
+                    }
+                    if (record.trans_notes_present)
+                    {
+                        xaccTransSetNotes(trans, record.trans_notes);
+                    }
+                }
+                if (record.split_guid_present == TRUE) /*Fill the split info*/
+                {
+                    gboolean is_new_split;
 
-                        split = xaccSplitLookupDirect (record.split_guid, book);
-                        if (split != NULL)
-                        {
-                            DEBUG("process_trans_record(): Split to be edited was found");
-                            is_new_split = FALSE;
-                        }
-                        else
-                        {
-                            DEBUG("process_trans_record(): Creating a new split");
-                            split = xaccMallocSplit(book);
-                            is_new_split = TRUE;
-                        }
-                        xaccSplitSetGUID (split, &(record.split_guid));
-                        if (record.acc_guid_present)
-                        {
-                            acct = xaccAccountLookupDirect(record.acc_guid, book);
-                            xaccAccountInsertSplit(acct, split);
+                    split = xaccSplitLookupDirect (record.split_guid, book);
+                    if (split != NULL)
+                    {
+                        DEBUG("process_trans_record(): Split to be edited was found");
+                        is_new_split = FALSE;
+                    }
+                    else
+                    {
+                        DEBUG("process_trans_record(): Creating a new split");
+                        split = xaccMallocSplit(book);
+                        is_new_split = TRUE;
+                    }
+                    xaccSplitSetGUID (split, &(record.split_guid));
+                    if (record.acc_guid_present)
+                    {
+                        acct = xaccAccountLookupDirect(record.acc_guid, book);
+                        xaccAccountInsertSplit(acct, split);
 
-                            // No currency in the txn yet? Set one now.
-                            if (!xaccTransGetCurrency(trans))
-                                xaccTransSetCurrency(trans, gnc_account_or_default_currency(acct, NULL));
-                        }
-                        if (is_new_split)
-                            xaccTransAppendSplit(trans, split);
+                        // No currency in the txn yet? Set one now.
+                        if (!xaccTransGetCurrency(trans))
+                            xaccTransSetCurrency(trans, gnc_account_or_default_currency(acct, NULL));
+                    }
+                    if (is_new_split)
+                        xaccTransAppendSplit(trans, split);
 
-                        if (record.split_memo_present)
-                        {
-                            xaccSplitSetMemo(split, record.split_memo);
-                        }
-                        if (record.split_action_present)
-                        {
-                            xaccSplitSetAction(split, record.split_action);
-                        }
-                        if (record.date_reconciled_present)
-                        {
-                            xaccSplitSetDateReconciledTS (split, &(record.date_reconciled));
-                        }
-                        if (record.split_reconcile_present)
-                        {
-                            xaccSplitSetReconcile(split, record.split_reconcile);
-                        }
+                    if (record.split_memo_present)
+                    {
+                        xaccSplitSetMemo(split, record.split_memo);
+                    }
+                    if (record.split_action_present)
+                    {
+                        xaccSplitSetAction(split, record.split_action);
+                    }
+                    if (record.date_reconciled_present)
+                    {
+                        xaccSplitSetDateReconciledTS (split, &(record.date_reconciled));
+                    }
+                    if (record.split_reconcile_present)
+                    {
+                        xaccSplitSetReconcile(split, record.split_reconcile);
+                    }
 
-                        if (record.amount_present)
-                        {
-                            xaccSplitSetAmount(split, record.amount);
-                        }
-                        if (record.value_present)
-                        {
-                            xaccSplitSetValue(split, record.value);
-                        }
+                    if (record.amount_present)
+                    {
+                        xaccSplitSetAmount(split, record.amount);
+                    }
+                    if (record.value_present)
+                    {
+                        xaccSplitSetValue(split, record.value);
                     }
-                    first_record = FALSE;
-                    break;
                 }
-            }
-            else
-            {
-                PERR("Corrupted record");
+                first_record = FALSE;
+                break;
             }
         }
-        else /* The record ended */
+        else
         {
-            record_ended = TRUE;
-            DEBUG("process_trans_record(): Record ended\n");
-            if (trans != NULL) /*If we played with a transaction, commit it here*/
+            PERR("Corrupted record");
+        }
+    }
+
+    DEBUG("process_trans_record(): Record ended\n");
+    if (trans != NULL) /*If we played with a transaction, commit it here*/
+    {
+        xaccTransScrubCurrency(trans);
+        xaccTransSetReadOnly(trans, trans_ro);
+        xaccTransCommitEdit(trans);
+        g_free(trans_ro);
+    }
+}
+
+/* One ===== START / ===== END block of the log. */
+typedef struct
+{
+    guint first;    /* Index of the block's first line */
+    guint count;    /* Number of lines in the block; 0 once it is superseded */
+} log_block;
+
+/* Return the transaction GncGUID of a block if it records a commit or a
+ * deletion, which leave the transaction in a final state.  Blocks for
+ * begin edit and rollback are ignored by the replay anyway. */
+static gboolean block_trans_guid (const char *first_line, GncGUID *guid)
+{
+    char guid_str[GUID_ENCODING_LENGTH + 1];
+    const char *field;
+
+    if (first_line[0] != 'C' && first_line[0] != 'D')
+        return FALSE;
+    field = strchr (first_line, '\t');
+    if (field == NULL)
+        return FALSE;
+    field++;
+    if (strlen (field) < GUID_ENCODING_LENGTH)
+        return FALSE;
+    memcpy (guid_str, field, GUID_ENCODING_LENGTH);
+    guid_str[GUID_ENCODING_LENGTH] = '\0';
+    return string_to_guid (guid_str, guid);
+}
+
+/* Replay the records of a log file read into contents, which is
+ * modified.  The file is split into lines and blocks in a single pass.
+ * Every commit or deletion block holds the complete state of its
+ * transaction, so only the last such block of each transaction is
+ * replayed, in the order of those last blocks. */
+static void replay_log (char *contents)
+{
+    const char * record_start_str = "===== START";
+    const char * record_end_str = "===== END";
+    GPtrArray *lines = g_ptr_array_new ();
+    GArray *blocks = g_array_new (FALSE, FALSE, sizeof (log_block));
+    GHashTable *last_block = g_hash_table_new_full (guid_hash_to_guint,
+                             guid_g_hash_table_equal,
+                             g_free, NULL);
+    gboolean in_block = FALSE;
+    log_block block = { 0, 0 };
+    char *pos = contents;
+    guint i;
+
+    /* Skip the header line, which has already been checked. */
+    pos = strchr (pos, '\n');
+    while (pos != NULL && *(++pos) != '\0')
+    {
+        char *line = pos;
+
+        pos = strchr (line, '\n');
+        if (pos != NULL)
+        {
+            *pos = '\0';
+            if (pos > line && pos[-1] == '\r')
+                pos[-1] = '\0';
+        }
+
+        if (strncmp (record_start_str, line, strlen (record_start_str)) == 0)
+        {
+            in_block = TRUE;
+            block.first = lines->len;
+            block.count = 0;
+        }
+        else if (in_block && strncmp (record_end_str, line, strlen (record_end_str)) == 0)
+        {
+            GncGUID guid;
+
+            in_block = FALSE;
+            if (block.count > 0 &&
+                    block_trans_guid (g_ptr_array_index (lines, block.first), &guid))
             {
-                xaccTransScrubCurrency(trans);
-                xaccTransSetReadOnly(trans, trans_ro);
-                xaccTransCommitEdit(trans);
-                g_free(trans_ro);
+                gpointer prev = g_hash_table_lookup (last_block, &guid);
+                if (prev)
+                    g_array_index (blocks, log_block, GPOINTER_TO_UINT (prev) - 1).count = 0;
+                g_array_append_val (blocks, block);
+                g_hash_table_replace (last_block, g_memdup (&guid, sizeof (guid)),
+                                      GUINT_TO_POINTER (blocks->len));
             }
         }
+        else if (in_block)
+        {
+            g_ptr_array_add (lines, line);
+            block.count++;
+        }
     }
+
+    DEBUG("%u blocks for %u transactions", blocks->len, g_hash_table_size (last_block));
+
+    /* Nothing but the replay changes the book here; no need for the
+     * gui to hear about each change. */
+    qof_event_suspend ();
+    for (i = 0; i < blocks->len; i++)
+    {
+        log_block *b = &g_array_index (blocks, log_block, i);
+        if (b->count > 0)
+            process_trans_record ((char **)lines->pdata + b->first, b->count);
+    }
+    qof_event_resume ();
+
+    g_hash_table_destroy (last_block);
+    g_array_free (blocks, TRUE);
+    g_ptr_array_free (lines, TRUE);
 }
 
 void gnc_file_log_replay (void)
 {
     char *selected_filename;
     char *default_dir;
-    char read_buf[256];
-    char *read_retval;
+    char *contents = NULL;
+    GError *error = NULL;
     GtkFileFilter *filter;
-    FILE *log_file;
-    char * record_start_str = "===== START";
     /* NOTE: This string must match src/engine/TransLog.c (sans newline) */
     char * expected_header_orig = "mod\ttrans_guid\tsplit_guid\ttime_now\t"
                                   "date_entered\tdate_posted\tacc_guid\tacc_name\tnum\tdescription\t"
@@ -600,11 +680,9 @@ void gnc_file_log_replay (void)
         else
         {
             DEBUG("Opening selected file");
-            log_file = g_fopen(selected_filename, "r");
-            if (!log_file || ferror(log_file) != 0)
+            if (!g_file_get_contents(selected_filename, &contents, NULL, &error))
             {
-                int err = errno;
-                perror("File open failed");
+                PERR("File open failed: %s", error->message);
                 gnc_error_dialog(NULL,
                                  /* Translation note:
                                   * First argument is the filename,
@@ -612,11 +690,12 @@ void gnc_file_log_replay (void)
                                   */
                                  _("Failed to open log file: %s: %s"),
                                  selected_filename,
-                                 strerror(err));
+                                 error->message);
+                g_error_free(error);
             }
             else
             {
-                if ((read_retval = fgets(read_buf, sizeof(read_buf), log_file)) == NULL)
+                if (*contents == '\0')
                 {
                     DEBUG("Read error or EOF");
                     gnc_info_dialog(NULL, "%s",
@@ -624,9 +703,10 @@ void gnc_file_log_replay (void)
                 }
                 else
                 {
-                    if (strncmp(expected_header, read_buf, strlen(expected_header)) != 0)
+                    if (strncmp(expected_header, contents, strlen(expected_header)) != 0)
                     {
-                        PERR("File header not recognised:\n%s", read_buf);
+                        PERR("File header not recognised:\n%.*s",
+                             (int)strcspn(contents, "\n"), contents);
                         PERR("Expected:\n%s", expected_header);
                         gnc_error_dialog(NULL, "%s",
                                          _("The log file you selected cannot be read. "
@@ -634,19 +714,10 @@ void gnc_file_log_replay (void)
                     }
                     else
                     {
-                        do
-                        {
-                            read_retval = fgets(read_buf, sizeof(read_buf), log_file);
-                            /*DEBUG("Chunk read: %s",read_retval);*/
-                            if (strncmp(record_start_str, read_buf, strlen(record_start_str)) == 0) /* If a record started */
-                            {
-                                process_trans_record(log_file);
-                            }
-                        }
-                        while (feof(log_file) == 0);
+                        replay_log(contents);
                     }
                 }
-                fclose(log_file);
+                g_free(contents);
             }
         }
         g_free(selected_filename);
@@ -30,6 +30,7 @@
 #include "gnc-plugin-log-replay.h"
 #include "gnc-plugin-manager.h"
 #include "gnc-component-manager.h"
+#include "gnc-ui-util.h"
 
 static void gnc_plugin_log_replay_class_init (GncPluginLogreplayClass *klass);
 static void gnc_plugin_log_replay_init (GncPluginLogreplay *plugin);
@@ -143,9 +144,15 @@ static void
 gnc_plugin_log_replay_cmd_new_log_replay (GtkAction *action,
         GncMainWindowActionData *data)
 {
+    QofBook *book = gnc_get_current_book ();
+
     gnc_suspend_gui_refresh();
+    gnc_book_begin_bulk_ingest (book);
     gnc_file_log_replay ();
+    gnc_book_end_bulk_ingest (book);
     gnc_resume_gui_refresh();
+    /* The replay runs with engine events suspended. */
+    gnc_gui_refresh_all();
 }
 
 /************************************************************
@@ -47,7 +47,9 @@
 #include "gnc-ui-util.h"
 #include "gnc-glib-utils.h"
 #include "gnc-prefs.h"
+#include "gnc-component-manager.h"
 #include "gnome-utils/gnc-ui.h"
+#include "gnome-utils/gnc-window.h"
 #include "gnome-utils/dialog-account.h"
 #include "dialog-utils.h"
 
@@ -71,6 +73,37 @@ static Account *ofx_parent_account = NULL;
 
 GList *ofx_created_commodites = NULL;
 
+/* Transactions read from the file are handed to the importer gui in
+ * batches of this many. */
+#define OFX_TRANS_BATCH_SIZE 250
+
+/* The transactions read since the last batch, most recent first. */
+static GList *ofx_pending_trans = NULL;
+static guint ofx_pending_count = 0;
+
+/** Hand the transactions read since the last batch to the importer
+ *  gui and show that the import is making progress. */
+static void
+gnc_ofx_flush_pending_trans (void)
+{
+    GList *node;
+
+    if (ofx_pending_trans == NULL)
+        return;
+
+    DEBUG("Sending %u transactions to the importer gui", ofx_pending_count);
+    ofx_pending_trans = g_list_reverse (ofx_pending_trans);
+    for (node = ofx_pending_trans; node; node = node->next)
+        gnc_gen_trans_list_add_trans (gnc_ofx_importer_gui, node->data);
+    g_list_free (ofx_pending_trans);
+    ofx_pending_trans = NULL;
+    ofx_pending_count = 0;
+
+    /* We don't know how many transactions are still to come, so just
+     * pulse the progress bar. */
+    gnc_window_show_progress (_("Importing transactions..."), 101.0);
+}
+
 /*
 int ofx_proc_status_cb(struct OfxStatusData data)
 {
@@ -825,8 +858,10 @@ int ofx_proc_transaction_cb(struct OfxTransactionData data, void * transaction_u
         /* Send transaction to importer GUI. */
         if (xaccTransCountSplits(transaction) > 0)
         {
-            DEBUG("%d splits sent to the importer gui", xaccTransCountSplits(transaction));
-            gnc_gen_trans_list_add_trans (gnc_ofx_importer_gui, transaction);
+            DEBUG("%d splits queued for the importer gui", xaccTransCountSplits(transaction));
+            ofx_pending_trans = g_list_prepend (ofx_pending_trans, transaction);
+            if (++ofx_pending_count >= OFX_TRANS_BATCH_SIZE)
+                gnc_ofx_flush_pending_trans ();
         }
         else
         {
@@ -1033,8 +1068,19 @@ void gnc_file_ofx_import (void)
         selected_filename = conv_name;
 #endif
 
+        /* Reading the file creates many transactions; hold off on gui
+         * refreshes and account resorting until all of them are in. */
         DEBUG("Opening selected file");
+        gnc_suspend_gui_refresh ();
+        gnc_book_begin_bulk_ingest (gnc_get_current_book ());
+        gnc_window_show_progress (_("Importing transactions..."), 0.0);
+
         libofx_proc_file(libofx_context, selected_filename, AUTODETECT);
+        gnc_ofx_flush_pending_trans ();
+
+        gnc_window_show_progress (NULL, -1.0);
+        gnc_book_end_bulk_ingest (gnc_get_current_book ());
+        gnc_resume_gui_refresh ();
         g_free(selected_filename);
     }
 
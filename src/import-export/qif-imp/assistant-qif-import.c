@@ -39,6 +39,7 @@
 
 #include "Account.h"
 #include "Transaction.h"
+#include "Scrub.h"
 #include "dialog-account-picker.h"
 #include "dialog-commodity.h"
 #include "dialog-progress.h"
@@ -3184,6 +3185,7 @@ gnc_ui_qif_import_finish_cb (GtkAssistant *gtkassistant,
     gboolean acct_tree_found = FALSE;
 
     gnc_suspend_gui_refresh();
+    gnc_book_begin_bulk_ingest (gnc_get_current_book ());
 
     /* Prune any imported transactions that were determined to be duplicates. */
     if (wind->match_transactions != SCM_BOOL_F)
@@ -3195,6 +3197,10 @@ gnc_ui_qif_import_finish_cb (GtkAssistant *gtkassistant,
                    scm_c_eval_string("(gnc-get-current-root-account)"),
                    wind->imported_account_tree);
 
+    gnc_book_end_bulk_ingest (gnc_get_current_book ());
+    /* Check just what the import committed. */
+    xaccBookScrubModified (gnc_get_current_book (),
+                           g_getenv ("GNC_AUTO_SCRUB_LOTS") != NULL);
     gnc_resume_gui_refresh();
 
     /* Save the user's mapping preferences. */
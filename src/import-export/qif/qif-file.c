@@ -32,6 +32,7 @@
 #include <string.h>
 
 #include "gnc-engine.h"
+#include "gnc-glib-utils.h"
 
 #include "qif-import-p.h"
 #include "qif-objects-p.h"
@@ -69,16 +70,64 @@ qif_record_destroy(GList *record)
     g_list_free(record);
 }
 
+/* Return the next line of the mapped file, stripped of leading and
+ * trailing whitespace, or NULL at the end of the file.  Lines end at
+ * a newline or a carriage return, so DOS, Unix and old Mac files all
+ * work, and are of any length.  The line is copied into buf and is
+ * only valid until the next call.  Lines that aren't valid UTF-8 are
+ * converted from the locale's character set, or stripped of the
+ * invalid characters if that doesn't work either.
+ */
+static char *
+qif_next_line(QifContext ctx, GString *buf)
+{
+    const char *start, *eol;
+
+    if (ctx->read_pos >= ctx->read_end)
+        return NULL;
+
+    start = ctx->read_pos;
+    for (eol = start; eol < ctx->read_end && *eol != '\n' && *eol != '\r'; eol++)
+        ;
+    ctx->read_pos = (eol < ctx->read_end) ? eol + 1 : eol;
+
+    /* increment the line number */
+    ctx->lineno++;
+
+    g_string_truncate(buf, 0);
+    g_string_append_len(buf, start, eol - start);
+
+    if (!g_utf8_validate(buf->str, buf->len, NULL))
+    {
+        gchar *converted = g_locale_to_utf8(buf->str, buf->len, NULL, NULL, NULL);
+        if (converted && g_utf8_validate(converted, -1, NULL))
+        {
+            g_string_assign(buf, converted);
+        }
+        else
+        {
+            PWARN("Invalid characters removed from line %d", ctx->lineno);
+            gnc_utf8_strip_invalid(buf->str);
+            g_string_set_size(buf, strlen(buf->str));
+        }
+        g_free(converted);
+    }
+
+    /* strip start/end whitespace */
+    return g_strstrip(buf->str);
+}
+
 /* This returns a record, which is a bunch of QifLines, ending
  * with a line with just a '^'.  If it finds a line that begins
  * with a !, then destroy the current record state, set the "found_bangtype",
- * and return NULL.
+ * and return NULL.  The bang line is left in buf.
  */
 static GList *
-qif_make_record(QifContext ctx, char *buf, size_t bufsiz, gboolean *found_bangtype)
+qif_make_record(QifContext ctx, GString *buf, gboolean *found_bangtype)
 {
     GList *record = NULL;
     QifLine line;
+    char *text;
 
     g_return_val_if_fail(ctx, NULL);
     g_return_val_if_fail(buf, NULL);
@@ -86,28 +135,21 @@ qif_make_record(QifContext ctx, char *buf, size_t bufsiz, gboolean *found_bangty
 
     *found_bangtype = FALSE;
 
-    while (fgets(buf, bufsiz, ctx->fp) != NULL)
+    while ((text = qif_next_line(ctx, buf)) != NULL)
     {
-
-        /* increment the line number */
-        ctx->lineno++;
-
-        /* strip start/end whitespace */
-        g_strstrip(buf);
-
         /* if there is nothing left in the string, ignore it */
-        if (strlen(buf) == 0)
+        if (*text == '\0')
             continue;
 
         /* If this is a bangline, then set the flag, clear our state, and return NULL */
-        if (*buf == '!')
+        if (*text == '!')
         {
             *found_bangtype = TRUE;
             break;
         }
 
         /* See if this is an End of Record marker */
-        if (*buf == '^')
+        if (*text == '^')
         {
             /* Yep.  If we've got a record then break and return ... */
             if (record)
@@ -118,7 +160,7 @@ qif_make_record(QifContext ctx, char *buf, size_t bufsiz, gboolean *found_bangty
         }
 
         /* otherwise, add the line to the list */
-        line = qif_make_line(buf, ctx->lineno);
+        line = qif_make_line(text, ctx->lineno);
         if (line)
             record = g_list_prepend(record, line);
 
@@ -138,27 +180,31 @@ qif_make_record(QifContext ctx, char *buf, size_t bufsiz, gboolean *found_bangty
     return g_list_reverse(record);
 }
 
-/* read a qif file and parse it, line by line
+/* read a qif file and parse it, record by record, straight out of the
+ * file mapping.  Only the record being parsed is copied.
  * return QIF_E_OK on success or some other QIF Error.
  */
 static QifError
-qif_read_file(QifContext ctx, FILE *f)
+qif_read_file(QifContext ctx, GMappedFile *mapping)
 {
-    char buf[BUFSIZ];
+    GString *buf;
     GList *record;
     gboolean found_bang;
     QifError err = QIF_E_OK;
 
     g_return_val_if_fail(ctx, QIF_E_BADARGS);
-    g_return_val_if_fail(f, QIF_E_BADARGS);
+    g_return_val_if_fail(mapping, QIF_E_BADARGS);
+
+    ctx->read_pos = g_mapped_file_get_contents(mapping);
+    ctx->read_end = ctx->read_pos + g_mapped_file_get_length(mapping);
+    ctx->lineno = 0;
 
-    ctx->fp = f;
-    ctx->lineno = -1;
+    buf = g_string_sized_new(256);
 
     do
     {
         found_bang = FALSE;
-        record = qif_make_record(ctx, buf, sizeof(buf), &found_bang);
+        record = qif_make_record(ctx, buf, &found_bang);
 
         /* If we got a record, process it */
         if (record)
@@ -179,7 +225,8 @@ qif_read_file(QifContext ctx, FILE *f)
         /* if we found a bangtype, process that */
         if (found_bang)
         {
-            g_assert(*buf == '!');
+            char *bangtype = buf->str;
+            g_assert(*bangtype == '!');
 
             /* First, process the end of the last handler.  This could possibly
              * merge items into the context or perform some other operation
@@ -192,12 +239,15 @@ qif_read_file(QifContext ctx, FILE *f)
             }
 
             /* Now process the bangtype (stored in buf) to set the new handler */
-            qif_parse_bangtype(ctx, buf);
+            qif_parse_bangtype(ctx, bangtype);
         }
 
     }
     while ((record || found_bang) && err == QIF_E_OK);
 
+    g_string_free(buf, TRUE);
+    ctx->read_pos = ctx->read_end = NULL;
+
     /* Make sure to run any end processor */
     if (err == QIF_E_OK && ctx->handler && ctx->handler->end)
         err = ctx->handler->end(ctx);
@@ -212,24 +262,24 @@ static QifError
 qif_import_file(QifContext ctx, const char *filename)
 {
     QifError err;
-    FILE *fp;
+    GMappedFile *mapping;
 
     g_return_val_if_fail(ctx, QIF_E_BADARGS);
     g_return_val_if_fail(filename, QIF_E_BADARGS);
     g_return_val_if_fail(*filename, QIF_E_BADARGS);
 
-    /* Open the file */
-    fp = g_fopen(filename, "r");
-    if (fp == NULL)
+    /* Map the file */
+    mapping = g_mapped_file_new(filename, FALSE, NULL);
+    if (mapping == NULL)
         return QIF_E_NOFILE;
 
     ctx->filename = g_strdup(filename);
 
     /* read the file */
-    err = qif_read_file(ctx, fp);
+    err = qif_read_file(ctx, mapping);
 
-    /* close the file */
-    fclose(fp);
+    /* unmap the file */
+    g_mapped_file_unref(mapping);
 
     return err;
 }
@@ -43,9 +43,11 @@ struct _QifContext
     /* The parent context */
     QifContext	parent;
 
-    /* file information */
+    /* file information; read_pos and read_end delimit the unread part
+     * of the file's mapping while it is being read */
     char *	filename;
-    FILE *	fp;
+    const char *	read_pos;
+    const char *	read_end;
     gint		lineno;
 
     /* This describes what we are parsing right now */
@@ -53,6 +53,10 @@ extern "C"
 #include "gnc-timezone.hpp"
 #define BOOST_ERROR_CODE_HEADER_ONLY
 #include <boost/date_time/local_time/local_time.hpp>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
 
 #define N_(string) string //So that xgettext will find it
 
@@ -115,7 +119,7 @@ gnc_localtime_r (const time64 *secs, struct tm* time)
 {
     try
     {
-	*time = static_cast<struct tm>(GncDateTime(*secs));
+	*time = GncDateTime::local_tm(*secs);
 	return time;
     }
     catch(std::invalid_argument)
@@ -951,6 +955,144 @@ qof_scan_date (const char *buff, int *day, int *month, int *year)
     return qof_scan_date_internal(buff, day, month, year, dateFormat);
 }
 
+/* Larger than any field of a valid date; numbers are capped there. */
+static const int date_field_max = 100000;
+
+static const char*
+scan_date_field (const char *str, int *value)
+{
+    int n = 0;
+    if (!isdigit (*str))
+        return nullptr;
+    while (isdigit (*str))
+    {
+        if (n < date_field_max)
+            n = n * 10 + (*str - '0');
+        ++str;
+    }
+    *value = n < date_field_max ? n : date_field_max;
+    return str;
+}
+
+static const char*
+scan_date_separator (const char *str)
+{
+    while (*str == ' ') ++str;
+    if (!*str || !strchr ("-/.'", *str))
+        return nullptr;
+    ++str;
+    while (*str == ' ') ++str;
+    return str;
+}
+
+/* The fields in the order they appear, and how many digits each takes
+ * in the form without separators. */
+static const char* date_order_fields[] = { "ymd", "dmy", "mdy", "dm", "md" };
+
+/* The dates looked up last, by a hash of the date. */
+struct DateParseMemo
+{
+    int64_t key;
+    time64 time;
+};
+static const size_t date_parse_memo_size = 64;
+static DateParseMemo date_parse_memo[date_parse_memo_size];
+static std::mutex date_parse_memo_lock;
+
+static time64
+date_parse_time (int year, int month, int day)
+{
+    /* tm_year as the regex-based CSV importer used to work it out. */
+    if (year < 100)
+        year += year < 69 ? 2000 : 1900;
+    int64_t key = (static_cast<int64_t>(year) * date_field_max + month) *
+        date_field_max + day;
+    auto& memo = date_parse_memo[(key * UINT64_C(0x9e3779b97f4a7c15)) >> 58];
+    {
+        std::lock_guard<std::mutex> guard (date_parse_memo_lock);
+        if (memo.key == key)
+            return memo.time;
+    }
+
+    /* gnc_mktime normalizes the struct tm; the date is valid if that
+     * didn't change it. */
+    struct tm tm;
+    memset (&tm, 0, sizeof (tm));
+    tm.tm_year = year - 1900;
+    tm.tm_mon = month - 1;
+    tm.tm_mday = day;
+    tm.tm_hour = 11;
+    tm.tm_isdst = -1;
+    time64 time = gnc_mktime (&tm);
+    if (tm.tm_year != year - 1900 || tm.tm_mon != month - 1 ||
+        tm.tm_mday != day)
+        time = -1;
+
+    std::lock_guard<std::mutex> guard (date_parse_memo_lock);
+    memo.key = key;
+    memo.time = time;
+    return time;
+}
+
+time64
+gnc_parse_date (const char *str, GncDateOrder order)
+{
+    int fields[3] = { 0, 0, 0 }, year = 0, month = 0, day = 0;
+    const char *fmt, *pos;
+    size_t n_fields, i;
+
+    if (!str || static_cast<unsigned int>(order) > GNC_DATE_ORDER_MD)
+        return -1;
+    fmt = date_order_fields[order];
+    n_fields = strlen (fmt);
+
+    while (*str == ' ') ++str;
+    pos = str;
+    for (i = 0; pos && i < n_fields; ++i)
+    {
+        if (i)
+            pos = scan_date_separator (pos);
+        if (pos)
+            pos = scan_date_field (pos, &fields[i]);
+    }
+    if (!pos)
+    {
+        /* With a year, 8 digits without separators will also do. */
+        if (n_fields < 3)
+            return -1;
+        for (i = 0; i < 8; ++i)
+            if (!isdigit (str[i]))
+                return -1;
+        for (i = 0, pos = str; i < n_fields; ++i)
+        {
+            size_t len = fmt[i] == 'y' ? 4 : 2;
+            fields[i] = 0;
+            for (; len; --len, ++pos)
+                fields[i] = fields[i] * 10 + (*pos - '0');
+        }
+    }
+
+    for (i = 0; i < n_fields; ++i)
+        switch (fmt[i])
+        {
+        case 'y':
+            year = fields[i];
+            break;
+        case 'm':
+            month = fields[i];
+            break;
+        case 'd':
+            day = fields[i];
+            break;
+        }
+    if (n_fields < 3)
+        year = GncDateTime::local_ymd (gnc_time (nullptr)).year;
+    if (month < 1 || month > 12 || day < 1 || day > 31 ||
+        (year >= 100 && year < 1400) || year > 9999)
+        return -1;
+    return date_parse_time (year, month, day);
+}
+
 /* Return the field separator for the current date format
 return date character
 */
@@ -1180,13 +1322,18 @@ gnc_timespec_to_iso8601_buff (Timespec ts, char * buff)
 void
 gnc_timespec2dmy (Timespec t, int *day, int *month, int *year)
 {
-    struct tm result;
     time64 t_secs = t.tv_sec + (t.tv_nsec / NANOS_PER_SECOND);
-    gnc_localtime_r(&t_secs, &result);
-
-    if (day) *day = result.tm_mday;
-    if (month) *month = result.tm_mon + 1;
-    if (year) *year = result.tm_year + 1900;
+    try
+    {
+        auto date = GncDateTime::local_ymd(t_secs);
+        if (day) *day = date.day;
+        if (month) *month = date.month;
+        if (year) *year = date.year;
+    }
+    catch(std::invalid_argument)
+    {
+        return;
+    }
 }
 
 #define THIRTY_TWO_YEARS 0x3c30fc00LL
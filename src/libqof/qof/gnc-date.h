@@ -553,6 +553,35 @@ size_t qof_print_date_time_buff (char * buff, size_t len, time64 secs);
  */
 gboolean qof_scan_date (const char *buff, int *day, int *month, int *year);
 
+/** The order of the fields of a date for gnc_parse_date(). The last
+ *  two have no year; the current year is used. */
+typedef enum
+{
+    GNC_DATE_ORDER_YMD,
+    GNC_DATE_ORDER_DMY,
+    GNC_DATE_ORDER_MDY,
+    GNC_DATE_ORDER_DM,
+    GNC_DATE_ORDER_MD,
+} GncDateOrder;
+
+/** gnc_parse_date
+ *    Convert a string of numbers in the given order, separated by one
+ *    of "-/.'" and optional spaces, into a time. Anything after the
+ *    last number is ignored. Orders with a year also take 8 digits
+ *    without separators, e.g. 20130801 for GNC_DATE_ORDER_YMD. Years
+ *    under 100 are taken to be in 1969 - 2068.
+ *
+ *    Nothing is allocated, and the last few dozen dates are
+ *    remembered, which makes it suitable for importers parsing the
+ *    same handful of dates over and over.
+ *
+ * Args:   str - the date string
+ *         order - the order of the fields
+ *
+ * Return: 11:00 local time on the date, or -1 if str isn't a valid date.
+ */
+time64 gnc_parse_date (const char *str, GncDateOrder order);
+
 // @}
 /** \name Date Start/End Adjustment routines
  * Given a time value, adjust it to be the beginning or end of that day.
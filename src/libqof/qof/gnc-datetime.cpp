@@ -29,6 +29,7 @@ extern "C"
 }
 #include <boost/date_time/gregorian/gregorian.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
+#include <cstring>
 #include <memory>
 #include <iostream>
 #include <sstream>
@@ -58,6 +59,65 @@ static constexpr auto ticks_per_second = INT64_C(1000000);
 static constexpr auto ticks_per_second = INT64_C(1000000000);
 #endif
 
+static constexpr auto secs_per_day = INT64_C(86400);
+
+/* Conversions between days from the POSIX epoch and the proleptic
+ * Gregorian calendar, after Howard Hinnant's days_from_civil and
+ * civil_from_days. */
+static int64_t
+days_from_ymd(const ymd date) noexcept
+{
+    int64_t year = date.year - (date.month <= 2);
+    int64_t era = (year >= 0 ? year : year - 399) / 400;
+    int64_t yoe = year - era * 400;
+    int64_t doy = (153 * (date.month + (date.month > 2 ? -3 : 9)) + 2) / 5 +
+        date.day - 1;
+    int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+static ymd
+ymd_from_days(int64_t days) noexcept
+{
+    days += 719468;
+    int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    int64_t doe = days - era * 146097;
+    int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int64_t mp = (5 * doy + 2) / 153;
+    int month = mp < 10 ? mp + 3 : mp - 9;
+    return {static_cast<int>(yoe + era * 400 + (month <= 2)), month,
+            static_cast<int>(doy - (153 * mp + 2) / 5 + 1)};
+}
+
+static int64_t
+floor_days(const int64_t secs) noexcept
+{
+    return secs / secs_per_day - (secs % secs_per_day < 0);
+}
+
+static void
+check_year_range(const int64_t days)
+{
+    static const auto first_day =
+        days_from_ymd({static_cast<int>(TimeZoneProvider::min_year), 1, 1});
+    static const auto last_day =
+        days_from_ymd({static_cast<int>(TimeZoneProvider::max_year), 12, 31});
+    if (days < first_day || days > last_day)
+        throw(std::invalid_argument("Time value is outside the supported year range."));
+}
+
+/* The local time in seconds from the epoch. */
+static int64_t
+local_secs(const time64 time, long* offset, bool* is_dst)
+{
+    check_year_range(floor_days(time));
+    *offset = tzp.offset(time, is_dst);
+    auto secs = time + *offset;
+    check_year_range(floor_days(secs));
+    return secs;
+}
+
 /** Private implementation of GncDate. See the documentation for that class.
  */
 class GncDateImpl
@@ -337,3 +397,38 @@ GncDateTime::format(const char* format) const
 {
     return m_impl->format(format);
 }
+
+struct tm
+GncDateTime::local_tm(const time64 time)
+{
+    long offset;
+    bool is_dst;
+    auto secs = local_secs(time, &offset, &is_dst);
+    auto days = floor_days(secs);
+    auto secs_of_day = secs - days * secs_per_day;
+    auto date = ymd_from_days(days);
+
+    struct tm tm;
+    memset(&tm, 0, sizeof(tm));
+    tm.tm_sec = secs_of_day % 60;
+    tm.tm_min = secs_of_day / 60 % 60;
+    tm.tm_hour = secs_of_day / 3600;
+    tm.tm_mday = date.day;
+    tm.tm_mon = date.month - 1;
+    tm.tm_year = date.year - 1900;
+    tm.tm_wday = (days % 7 + 11) % 7; // 1970-01-01 was a Thursday
+    tm.tm_yday = days - days_from_ymd({date.year, 1, 1});
+    tm.tm_isdst = is_dst ? 1 : 0;
+#if HAVE_STRUCT_TM_GMTOFF
+    tm.tm_gmtoff = offset;
+#endif
+    return tm;
+}
+
+ymd
+GncDateTime::local_ymd(const time64 time)
+{
+    long offset;
+    bool is_dst;
+    return ymd_from_days(floor_days(local_secs(time, &offset, &is_dst)));
+}
@@ -159,6 +159,21 @@ public:
  *  according to the format.
  */
     std::string format(const char* format) const;
+/** Break a time down into local time in the current timezone, as
+ * casting GncDateTime(time) to a struct tm does, but with arithmetic
+ * and the cached timezone transitions instead of boost objects.
+ * @param time: Seconds from the POSIX epoch.
+ * @return struct tm
+ * @exception std::invalid_argument if the year is outside the constraints.
+ */
+    static struct tm local_tm(const time64 time);
+/** The date of a time in the current timezone, worked out like
+ *  local_tm().
+ * @param time: Seconds from the POSIX epoch.
+ * @return ymd struct
+ * @exception std::invalid_argument if the year is outside the constraints.
+ */
+    static ymd local_ymd(const time64 time);
 
 private:
     std::unique_ptr<GncDateTimeImpl> m_impl;
@@ -0,0 +1,173 @@
+/********************************************************************
+ * gnc-guid-map.cpp -- open-addressing map keyed by GncGUID         *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+ *******************************************************************/
+
+#include "gnc-guid-map.hpp"
+
+#include <cstring>
+#include <utility>
+
+namespace {
+    /* Small enough that a collection of a handful of commodities or
+     * budgets doesn't cost much, and a power of two. */
+    static const std::size_t min_capacity = 16;
+    static const unsigned int min_shift = 60; // 64 - log2 (min_capacity)
+
+    /* Fold the two halves of the GUID together and spread them with a
+     * Fibonacci multiply; the top bits of the product pick the slot.
+     * Random GUIDs would do without the multiply, but GUIDs read from
+     * files or made up by tests aren't always random. */
+    inline std::uint64_t
+    guid_bits (const GncGUID& guid) noexcept
+    {
+        std::uint64_t hi, lo;
+        std::memcpy (&hi, guid.data, sizeof hi);
+        std::memcpy (&lo, guid.data + sizeof hi, sizeof lo);
+        return (hi ^ lo) * UINT64_C(0x9e3779b97f4a7c15);
+    }
+}
+
+GncGUIDMap::GncGUIDMap() noexcept : m_slots {}, m_count {0}, m_shift {64} {}
+
+std::size_t
+GncGUIDMap::home (const GncGUID& guid) const noexcept
+{
+    return static_cast<std::size_t>(guid_bits (guid) >> m_shift);
+}
+
+/* The slot holding guid, or the empty slot where it would go. */
+std::size_t
+GncGUIDMap::find (const GncGUID& guid) const noexcept
+{
+    std::size_t mask = m_slots.size() - 1;
+    for (std::size_t i = home (guid); ; i = (i + 1) & mask)
+    {
+        const Slot& slot = m_slots[i];
+        if (!slot.value || slot.key == guid)
+            return i;
+    }
+}
+
+void*
+GncGUIDMap::lookup (const GncGUID& guid) const noexcept
+{
+    if (!m_count)
+        return nullptr;
+    return m_slots[find (guid)].value;
+}
+
+void
+GncGUIDMap::resize (std::size_t capacity)
+{
+    std::vector<Slot> old (capacity, Slot {GncGUID {}, nullptr});
+    m_slots.swap (old);
+    m_shift = min_shift;
+    for (std::size_t cap = min_capacity; cap < capacity; cap <<= 1)
+        --m_shift;
+    for (auto& slot : old)
+        if (slot.value)
+            m_slots[find (slot.key)] = slot;
+}
+
+void
+GncGUIDMap::insert (const GncGUID& guid, void* value)
+{
+    if (!value)
+        return;
+    /* Keep the load under 3/4 so that probe runs stay short. */
+    if ((m_count + 1) * 4 > m_slots.size() * 3)
+        resize (m_slots.empty() ? min_capacity : m_slots.size() * 2);
+
+    Slot& slot = m_slots[find (guid)];
+    if (!slot.value)
+    {
+        slot.key = guid;
+        ++m_count;
+    }
+    slot.value = value;
+}
+
+void
+GncGUIDMap::reserve (std::size_t count)
+{
+    std::size_t capacity = m_slots.empty() ? min_capacity : m_slots.size();
+    while (count * 4 > capacity * 3)
+        capacity <<= 1;
+    if (capacity > m_slots.size())
+        resize (capacity);
+}
+
+bool
+GncGUIDMap::remove (const GncGUID& guid) noexcept
+{
+    if (!m_count)
+        return false;
+
+    std::size_t mask = m_slots.size() - 1;
+    std::size_t hole = find (guid);
+    if (!m_slots[hole].value)
+        return false;
+
+    /* Move back every following entry of the run that the hole would
+     * otherwise cut off from its home slot. */
+    for (std::size_t i = (hole + 1) & mask; m_slots[i].value;
+         i = (i + 1) & mask)
+    {
+        std::size_t want = home (m_slots[i].key);
+        if (((i - want) & mask) >= ((i - hole) & mask))
+        {
+            m_slots[hole] = m_slots[i];
+            hole = i;
+        }
+    }
+    m_slots[hole].value = nullptr;
+    --m_count;
+    return true;
+}
+
+std::vector<void*>
+GncGUIDMap::values () const
+{
+    std::vector<void*> result;
+    result.reserve (m_count);
+    for (const auto& slot : m_slots)
+        if (slot.value)
+            result.push_back (slot.value);
+    return result;
+}
+
+void*
+GncGUIDMap::next (std::size_t& slot) const noexcept
+{
+    while (slot < m_slots.size())
+    {
+        auto value = m_slots[slot++].value;
+        if (value)
+            return value;
+    }
+    return nullptr;
+}
+
+std::size_t
+GncGUIDMap::memory_used () const noexcept
+{
+    return m_slots.capacity() * sizeof (Slot);
+}
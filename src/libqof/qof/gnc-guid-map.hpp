@@ -0,0 +1,90 @@
+/********************************************************************
+ * gnc-guid-map.hpp -- open-addressing map keyed by GncGUID         *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+ *******************************************************************/
+
+#ifndef GNC_GUID_MAP_HPP
+#define GNC_GUID_MAP_HPP
+
+#include <guid.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/** @addtogroup GncGUIDMap
+ * @ingroup QOF
+ * @{
+ * @brief A flat hash map from GncGUID to a non-NULL pointer.
+ *
+ * The GUIDs are stored in the slots themselves, so a lookup touches a
+ * single contiguous array instead of following a key pointer into the
+ * entity as a GHashTable keyed by GncGUID* does. Collisions are
+ * resolved by linear probing, and removal shifts the following entries
+ * back so that no tombstones accumulate.
+ *
+ * NULL values can't be stored: a NULL value marks an empty slot.
+ */
+class GncGUIDMap
+{
+public:
+    GncGUIDMap() noexcept;
+
+    /** @return The value stored for guid, or nullptr. */
+    void* lookup (const GncGUID& guid) const noexcept;
+    /** Store value for guid, replacing any value already there. value
+     * must not be nullptr. */
+    void insert (const GncGUID& guid, void* value);
+    /** @return true if there was a value for guid. */
+    bool remove (const GncGUID& guid) noexcept;
+    /** Make room for count values, so that inserting up to that many
+     * doesn't rehash the map again and again. */
+    void reserve (std::size_t count);
+    std::size_t size () const noexcept { return m_count; }
+    /** A snapshot of the values, in no particular order, which stays
+     * valid if the map is changed while it's being walked. */
+    std::vector<void*> values () const;
+    /** Walk the values without copying them: start with slot 0 and call
+     * again with the slot it leaves until it returns nullptr. The walk
+     * is only good while the map isn't changed, since an insert may
+     * rehash it.
+     * @return The first value at or after slot, which is moved past it,
+     * or nullptr when there are no more. */
+    void* next (std::size_t& slot) const noexcept;
+    /** The bytes held by the slot array. */
+    std::size_t memory_used () const noexcept;
+
+private:
+    struct Slot
+    {
+        GncGUID key;
+        void* value;
+    };
+
+    std::size_t home (const GncGUID& guid) const noexcept;
+    std::size_t find (const GncGUID& guid) const noexcept;
+    void resize (std::size_t capacity);
+
+    std::vector<Slot> m_slots;
+    std::size_t m_count;
+    unsigned int m_shift;
+};
+
+/** @} */
+#endif //GNC_GUID_MAP_HPP
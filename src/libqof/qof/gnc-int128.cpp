@@ -38,10 +38,41 @@ extern "C"
  * Addison-Wesley, 1998.
  */
 
+/* GCC and Clang provide a 128-bit integer type on 64-bit targets. Where
+ * it's available the magnitudes are multiplied, divided and reduced with
+ * it, which the compiler turns into a couple of instructions or a call to
+ * its runtime library; elsewhere, or if GNC_INT128_PORTABLE is defined,
+ * the algorithms below work on 32-bit sublegs. Either way the magnitude
+ * and the flags are kept as before, so the results are the same. */
+#if defined(__SIZEOF_INT128__) && !defined(GNC_INT128_PORTABLE)
+#define GNC_INT128_NATIVE 1
+#endif
+
 namespace {
     static const unsigned int sublegs = GncInt128::numlegs * 2;
     static const unsigned int sublegbits = GncInt128::legbits / 2;
     static const uint64_t sublegmask = (UINT64_C(1) << sublegbits) - 1;
+
+#ifdef GNC_INT128_NATIVE
+    typedef unsigned __int128 uint128_t;
+
+    inline uint128_t
+    join_legs (uint64_t hi, uint64_t lo) noexcept
+    {
+        return (static_cast<uint128_t>(hi) << GncInt128::legbits) | lo;
+    }
+
+    /* v must not be 0. */
+    inline unsigned int
+    trailing_zeros (uint128_t v) noexcept
+    {
+        uint64_t lo {static_cast<uint64_t>(v)};
+        if (lo)
+            return __builtin_ctzll (lo);
+        return GncInt128::legbits +
+            __builtin_ctzll (static_cast<uint64_t>(v >> GncInt128::legbits));
+    }
+#endif
 }
 
 GncInt128::GncInt128 () : m_flags {}, m_hi {0}, m_lo {0}{}
@@ -135,6 +166,24 @@ GncInt128::gcd(GncInt128 b) const noexcept
     if (isOverflow() || isNan())
         return *this;
 
+#ifdef GNC_INT128_NATIVE
+    /* The same algorithm on the magnitudes, with the factors of two taken
+     * out a word at a time. */
+    uint128_t u {join_legs (m_hi, m_lo)}, v {join_legs (b.m_hi, b.m_lo)};
+    unsigned int shift {trailing_zeros (u | v)};
+    u >>= trailing_zeros (u);
+    do
+    {
+        v >>= trailing_zeros (v);
+        if (u > v)
+            std::swap (u, v);
+        v -= u;
+    }
+    while (v);
+    u <<= shift;
+    return GncInt128 (static_cast<uint64_t>(u >> legbits),
+                      static_cast<uint64_t>(u));
+#else
     GncInt128 a (isNeg() ? -(*this) : *this);
     if (b.isNeg()) b = -b;
 
@@ -157,6 +206,7 @@ GncInt128::gcd(GncInt128 b) const noexcept
         t = a - b;  //B6
     }
     return a << k;
+#endif
 }
 
 /* Since u * v = gcd(u, v) * lcm(u, v), we find lcm by u / gcd * v. */
@@ -417,6 +467,14 @@ GncInt128::operator*= (const GncInt128& b) noexcept
         return *this;
     }
 
+#ifdef GNC_INT128_NATIVE
+    /* abits + bbits <= maxbits, so the product fits. */
+    uint128_t product {join_legs (m_hi, m_lo) * join_legs (b.m_hi, b.m_lo)};
+    m_hi = static_cast<uint64_t>(product >> legbits);
+    m_lo = static_cast<uint64_t>(product);
+    return *this;
+#else
+
 /* This is Knuth's "classical" multi-precision multiplication algorithm
  * truncated to a GncInt128 result with the loop unrolled for clarity and with
  * overflow and zero checks beforehand to save time. See Donald Knuth, "The Art
@@ -474,8 +532,10 @@ GncInt128::operator*= (const GncInt128& b) noexcept
         return *this;
     }
     return *this;
+#endif
 }
 
+#ifndef GNC_INT128_NATIVE
 namespace {
 /* Algorithm from Knuth (full citation at operator*=) p272ff.  Again, there
  * are faster algorithms out there, but they require much larger numbers to
@@ -603,6 +663,7 @@ div_single_leg (uint64_t* u, size_t m, uint64_t v, GncInt128& q, GncInt128& r) n
 }
 
 }// namespace
+#endif
 
  void
 GncInt128::div (const GncInt128& b, GncInt128& q, GncInt128& r) noexcept
@@ -651,6 +712,16 @@ GncInt128::div (const GncInt128& b, GncInt128& q, GncInt128& r) noexcept
         return;
     }
 
+#ifdef GNC_INT128_NATIVE
+    uint128_t dividend {join_legs (m_hi, m_lo)};
+    uint128_t divisor {join_legs (b.m_hi, b.m_lo)};
+    uint128_t quotient {dividend / divisor};
+    uint128_t remainder {dividend % divisor};
+    q.m_hi = static_cast<uint64_t>(quotient >> legbits);
+    q.m_lo = static_cast<uint64_t>(quotient);
+    r.m_hi = static_cast<uint64_t>(remainder >> legbits);
+    r.m_lo = static_cast<uint64_t>(remainder);
+#else
     uint64_t u[sublegs + 2] {(m_lo & sublegmask), (m_lo >> sublegbits),
             (m_hi & sublegmask), (m_hi >> sublegbits), 0, 0};
     uint64_t v[sublegs] {(b.m_lo & sublegmask), (b.m_lo >> sublegbits),
@@ -663,6 +734,7 @@ GncInt128::div (const GncInt128& b, GncInt128& q, GncInt128& r) noexcept
         return div_single_leg (u, m, v[0], q, r);
 
     return div_multi_leg (u, m, v, n, q, r);
+#endif
 }
 
 GncInt128&
@@ -244,6 +244,59 @@ gnc_numeric_same(gnc_numeric a, gnc_numeric b, gint64 denom,
 }
 
 
+/* *******************************************************************
+ *  64-bit fast paths
+ *
+ *  Most arithmetic is on amounts in one commodity, which share a
+ *  denominator, and its result fits in 64 bits without rounding. Then
+ *  the result GncRational would come to is worked out directly, and
+ *  only the other cases go through GncRational and GncDenom. INT64_MIN
+ *  is left to them: its magnitude doesn't fit in an int64.
+ ********************************************************************/
+
+static inline bool
+fast_add (gint64 a, gint64 b, gint64 *result)
+{
+    if (a == INT64_MIN || b == INT64_MIN)
+        return false;
+    if (b > 0 ? a > INT64_MAX - b : a < -INT64_MAX - b)
+        return false;
+    *result = a + b;
+    return true;
+}
+
+static inline bool
+fast_mul (gint64 a, gint64 b, gint64 *result)
+{
+    if (a == INT64_MIN || b == INT64_MIN)
+        return false;
+    if (a && b && ABS(a) > INT64_MAX / ABS(b))
+        return false;
+    *result = a * b;
+    return true;
+}
+
+/* The denominator GncDenom would give the result for operands with the
+ * same positive denominator, or 0 if it would have to be worked out. */
+static inline gint64
+fast_denom (gint64 common, gint64 denom, gint how)
+{
+    if (denom > 0)
+        return denom;
+    if (denom != GNC_DENOM_AUTO)
+        return 0;
+    switch (how & GNC_NUMERIC_DENOM_MASK)
+    {
+    case 0:
+    case GNC_HOW_DENOM_EXACT:
+    case GNC_HOW_DENOM_LCD:
+    case GNC_HOW_DENOM_FIXED:
+        return common;
+    default:
+        return 0;
+    }
+}
+
 /* *******************************************************************
  *  gnc_numeric_add
  ********************************************************************/
@@ -257,6 +310,12 @@ gnc_numeric_add(gnc_numeric a, gnc_numeric b,
         return gnc_numeric_error(GNC_ERROR_ARG);
     }
 
+    gint64 num;
+    if (a.denom == b.denom && a.denom > 0 &&
+        fast_denom (a.denom, denom, how) == a.denom &&
+        fast_add (a.num, b.num, &num))
+        return gnc_numeric_create (num, a.denom);
+
     GncNumeric an (a), bn (b);
     GncDenom new_denom (an, bn, denom, how);
     if (new_denom.m_error)
@@ -298,6 +357,26 @@ gnc_numeric_mul(gnc_numeric a, gnc_numeric b,
         return gnc_numeric_error(GNC_ERROR_ARG);
     }
 
+    /* The product of the numerators over the product of the
+     * denominators, if it can be brought exactly to the result's. */
+    gint64 num, den, target;
+    if (a.denom > 0 && b.denom > 0 &&
+        fast_mul (a.num, b.num, &num) && fast_mul (a.denom, b.denom, &den))
+    {
+        if (denom > 0)
+            target = denom;
+        else if (denom == GNC_DENOM_AUTO &&
+                 ((how & GNC_NUMERIC_DENOM_MASK) == 0 ||
+                  (how & GNC_NUMERIC_DENOM_MASK) == GNC_HOW_DENOM_EXACT))
+            target = den;
+        else if (a.denom == b.denom)
+            target = fast_denom (a.denom, denom, how);
+        else
+            target = 0;
+        if (target && den % target == 0 && num % (den / target) == 0)
+            return gnc_numeric_create (num / (den / target), target);
+    }
+
     GncNumeric an (a), bn (b);
     GncDenom new_denom (an, bn, denom, how);
     if (new_denom.m_error)
@@ -307,6 +386,107 @@ gnc_numeric_mul(gnc_numeric a, gnc_numeric b,
 }
 
 
+/* *******************************************************************
+ *  gnc_numeric_sum
+ ********************************************************************/
+
+static inline const gnc_numeric&
+numeric_at (const gnc_numeric *values, gsize stride, gsize i)
+{
+    return *reinterpret_cast<const gnc_numeric*>(
+        reinterpret_cast<const char*>(values) + i * stride);
+}
+
+/* Each numerator is split into its signed upper and unsigned lower 32
+ * bits, which are added up apart: neither sum can overflow for up to
+ * 2^31 values, so the loop needs no checks, nor any branch but the one
+ * closing it. */
+static const gsize sum_chunk = G_GUINT64_CONSTANT(1) << 31;
+
+gnc_numeric
+gnc_numeric_sum (const gnc_numeric *values, gsize n_values, gsize stride,
+                 gint64 denom, gint how)
+{
+    gnc_numeric sum = gnc_numeric_zero ();
+
+    if (!n_values)
+        return sum;
+    g_return_val_if_fail (values, gnc_numeric_error (GNC_ERROR_ARG));
+    if (!stride)
+        stride = sizeof (gnc_numeric);
+
+    gint64 common = values[0].denom;
+    if (common > 0 && fast_denom (common, denom, how) == common)
+    {
+        GncInt128 total {};
+        gint64 denom_diff {};
+
+        for (gsize start = 0; start < n_values; start += sum_chunk)
+        {
+            gsize end = MIN (n_values, start + sum_chunk);
+            uint64_t lo_sum {};
+            int64_t hi_sum {};
+
+            for (gsize i = start; i < end; ++i)
+            {
+                const gnc_numeric& value = numeric_at (values, stride, i);
+                lo_sum += static_cast<uint64_t>(value.num) & UINT64_C(0xffffffff);
+                hi_sum += value.num >> 32;
+                denom_diff |= value.denom ^ common;
+            }
+            total += GncInt128 (hi_sum) * GncInt128 (UINT64_C(1) << 32) +
+                GncInt128 (lo_sum);
+        }
+
+        if (!denom_diff)
+        {
+            if (total.isBig ())
+                return gnc_numeric_error (GNC_ERROR_OVERFLOW);
+            return gnc_numeric_create (static_cast<int64_t>(total), common);
+        }
+    }
+
+    for (gsize i = 0; i < n_values; ++i)
+        sum = gnc_numeric_add (sum, numeric_at (values, stride, i), denom, how);
+    return sum;
+}
+
+void
+gnc_numeric_running_sum (const gnc_numeric *values, gsize n_values,
+                         gsize stride, gnc_numeric start,
+                         gint64 denom, gint how, gnc_numeric *sums)
+{
+    gnc_numeric sum = start;
+    gsize i = 0;
+
+    if (!n_values)
+        return;
+    g_return_if_fail (values && sums);
+    if (!stride)
+        stride = sizeof (gnc_numeric);
+
+    /* As long as the values have the sum's denominator and the sum stays
+     * within 64 bits, each step is a plain add. */
+    if (sum.denom > 0 && fast_denom (sum.denom, denom, how) == sum.denom)
+    {
+        for (; i < n_values; ++i)
+        {
+            const gnc_numeric& value = numeric_at (values, stride, i);
+            gint64 num;
+            if (value.denom != sum.denom || !fast_add (sum.num, value.num, &num))
+                break;
+            sum.num = num;
+            sums[i] = sum;
+        }
+    }
+
+    for (; i < n_values; ++i)
+    {
+        sum = gnc_numeric_add (sum, numeric_at (values, stride, i), denom, how);
+        sums[i] = sum;
+    }
+}
+
 /* *******************************************************************
  *  gnc_numeric_div
  ********************************************************************/
@@ -363,9 +543,85 @@ gnc_numeric_abs(gnc_numeric a)
  *  gnc_numeric_convert
  ********************************************************************/
 
+/* Conversions between denominators of which one divides the other, as
+ * between commodity SCUs of 100, 1000 and 1000000, come down to a
+ * multiply or to a divide and a rounding; this does them in 64 bits the
+ * way GncRational::round would. Returns false if the slow path has to
+ * be taken. */
+static bool
+fast_convert (gnc_numeric in, gint64 denom, gint how, gnc_numeric *out)
+{
+    if (in.denom <= 0 || denom <= 0 || in.num == INT64_MIN)
+        return false;
+    if (in.denom == denom || in.num == 0)
+    {
+        *out = gnc_numeric_create (in.num, denom);
+        return true;
+    }
+    if (denom % in.denom == 0)
+    {
+        gint64 num;
+        if (!fast_mul (in.num, denom / in.denom, &num))
+            return false;
+        *out = gnc_numeric_create (num, denom);
+        return true;
+    }
+    if (in.denom % denom)
+        return false;
+
+    gint64 ratio = in.denom / denom;
+    gint64 num = in.num / ratio, rem = ABS(in.num % ratio);
+    if (rem == 0)
+    {
+        *out = gnc_numeric_create (num, denom);
+        return true;
+    }
+    /* GncRational rounds these with a signed remainder. */
+    if (num == 0)
+        return false;
+
+    gint64 away = num < 0 ? -1 : 1;
+    switch (how & GNC_NUMERIC_RND_MASK)
+    {
+    case GNC_HOW_RND_NEVER:
+        *out = gnc_numeric_error (GNC_ERROR_REMAINDER);
+        return true;
+    case GNC_HOW_RND_FLOOR:
+        if (num < 0) ++num;
+        break;
+    case GNC_HOW_RND_CEIL:
+        if (num > 0) ++num;
+        break;
+    case GNC_HOW_RND_TRUNC:
+        break;
+    case GNC_HOW_RND_PROMOTE:
+        num += away;
+        break;
+    case GNC_HOW_RND_ROUND_HALF_DOWN:
+        if (rem * 2 > ratio)
+            num += away;
+        break;
+    case GNC_HOW_RND_ROUND_HALF_UP:
+        if (rem * 2 >= ratio)
+            num += away;
+        break;
+    case GNC_HOW_RND_ROUND:
+        if (rem * 2 > ratio || (rem * 2 == ratio && num % 2))
+            num += away;
+        break;
+    default:
+        return false;
+    }
+    *out = gnc_numeric_create (num, denom);
+    return true;
+}
+
 gnc_numeric
 gnc_numeric_convert(gnc_numeric in, int64_t denom, int how)
 {
+    gnc_numeric result;
+    if (fast_convert (in, denom, how, &result))
+        return result;
     GncNumeric a (in), b (gnc_numeric_zero());
     GncDenom d (a, b, denom, how);
     a.round (d);
@@ -448,6 +448,34 @@ gnc_numeric gnc_numeric_sub_fixed(gnc_numeric a, gnc_numeric b)
     return gnc_numeric_sub(a, b, GNC_DENOM_AUTO,
                            GNC_HOW_DENOM_FIXED | GNC_HOW_RND_NEVER);
 }
+
+/** Return the sum of n_values values, as gnc_numeric_add(), with the
+ *  same denom and how, would if applied in turn starting from zero.
+ *
+ *  When the values all have the denominator the result is to have, the
+ *  numerators are added up in a loop which the compiler can vectorize,
+ *  in 128 bits, so that only the result can overflow, not a partial
+ *  sum on the way to it.
+ *
+ *  @param values The first of the values.
+ *  @param n_values The number of values.
+ *  @param stride The distance in bytes from one value to the next, to sum
+ *  a gnc_numeric member of an array of structures; 0 for an array of
+ *  gnc_numeric.
+ */
+gnc_numeric gnc_numeric_sum(const gnc_numeric *values, gsize n_values,
+                            gsize stride, gint64 denom, gint how);
+
+/** Fill sums with the running totals of the values, starting from start:
+ *  sums[i] is start plus values 0 to i, each added with
+ *  gnc_numeric_add() and denom and how. It's meant for the balance
+ *  column of a register or a report.
+ *
+ *  @param sums An array of n_values gnc_numerics to put the totals in.
+ */
+void gnc_numeric_running_sum(const gnc_numeric *values, gsize n_values,
+                             gsize stride, gnc_numeric start,
+                             gint64 denom, gint how, gnc_numeric *sums);
 /** @} */
 
 /** @name Arithmetic Functions with Exact Error Returns
@@ -715,3 +715,57 @@ TimeZoneProvider::get(int year) const noexcept
     }
     return iter->second;
 }
+
+TZ_Transitions
+TimeZoneProvider::transitions (int year) const
+{
+    std::lock_guard<std::mutex> guard (m_transitions_lock);
+    auto iter = m_transitions.find (year);
+    if (iter != m_transitions.end())
+        return iter->second;
+
+    auto zone = get (year);
+    auto std_offset = zone->base_utc_offset().total_seconds();
+    TZ_Transitions trans {0, 0, std_offset, std_offset};
+    if (zone->has_dst())
+    {
+        static const boost::posix_time::ptime epoch (
+            boost::gregorian::date (1970, 1, 1));
+        trans.dst_offset += zone->dst_offset().total_seconds();
+        /* The start is in standard time, the end in DST. */
+        trans.dst_start = (zone->dst_local_start_time (year) -
+                           epoch).total_seconds() - trans.std_offset;
+        trans.dst_end = (zone->dst_local_end_time (year) -
+                         epoch).total_seconds() - trans.dst_offset;
+    }
+    m_transitions.emplace (year, trans);
+    return trans;
+}
+
+long
+TimeZoneProvider::offset (int64_t time, bool* is_dst) const
+{
+    static const int64_t secs_per_day = 86400;
+    /* Days from 1970-01-01 to the 1st January of year, for the
+     * proleptic Gregorian calendar. */
+    auto days_to_year = [](int64_t year) {
+        --year;
+        return year * 365 + year / 4 - year / 100 + year / 400 - 719162;
+    };
+    int64_t days = time / secs_per_day - (time % secs_per_day < 0);
+    int64_t year = 1970 + days * 400 / 146097;
+    while (days_to_year (year + 1) <= days)
+        ++year;
+    while (days_to_year (year) > days)
+        --year;
+
+    auto trans = transitions (static_cast<int>(year));
+    bool dst;
+    if (trans.dst_start <= trans.dst_end)
+        dst = time >= trans.dst_start && time < trans.dst_end;
+    else
+        dst = time >= trans.dst_start || time < trans.dst_end;
+    if (is_dst)
+        *is_dst = dst;
+    return dst ? trans.dst_offset : trans.std_offset;
+}
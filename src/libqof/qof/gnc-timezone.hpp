@@ -32,6 +32,9 @@ extern "C"
 
 #define BOOST_ERROR_CODE_HEADER_ONLY
 #include <boost/date_time/local_time/local_time.hpp>
+#include <cstdint>
+#include <map>
+#include <mutex>
 
 namespace gnc
 {
@@ -44,6 +47,19 @@ using TZ_Entry = std::pair<int, TZ_Ptr>;
 using TZ_Vector = std::vector<TZ_Entry>;
 using time_zone_names = boost::local_time::time_zone_names;
 
+/** The UTC offsets of one year and the instants, in seconds from the
+ * POSIX epoch, at which DST begins and ends. dst_start == dst_end for
+ * a year without DST. dst_start > dst_end in the southern hemisphere,
+ * where DST runs over the new year.
+ */
+struct TZ_Transitions
+{
+    int64_t dst_start;
+    int64_t dst_end;
+    long std_offset; // seconds east of UTC
+    long dst_offset;
+};
+
 class TimeZoneProvider
 {
 public:
@@ -55,11 +71,21 @@ public:
     TimeZoneProvider operator=(const TimeZoneProvider&) = delete;
     TimeZoneProvider operator=(const TimeZoneProvider&&) = delete;
     TZ_Ptr get (int year) const noexcept;
+/** The offset from UTC in seconds, east positive, in force at time.
+ * The transitions of each year are worked out from the boost time zone
+ * once and cached, so this is arithmetic and one lookup.
+ * @param time: Seconds from the POSIX epoch.
+ * @param is_dst: If not null, set to whether DST is in force.
+ */
+    long offset (int64_t time, bool* is_dst = nullptr) const;
     static const unsigned int min_year; //1400
     static const unsigned int max_year; //9999
 private:
     void parse_file(const std::string& tzname);
+    TZ_Transitions transitions (int year) const;
     TZ_Vector zone_vector;
+    mutable std::map<int, TZ_Transitions> m_transitions;
+    mutable std::mutex m_transitions_lock;
 #if PLATFORM(WINDOWS)
     void load_windows_dynamic_tz(HKEY, time_zone_names);
     void load_windows_classic_tz(HKEY, time_zone_names);
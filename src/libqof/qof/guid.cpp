@@ -53,15 +53,135 @@ extern "C"
 #include "qof.h"
 
 }
+#include <algorithm>
+#include <boost/random/mersenne_twister.hpp>
 #include <boost/uuid/uuid.hpp>
 #include <boost/uuid/uuid_generators.hpp>
 #include <boost/uuid/uuid_io.hpp>
 #include <sstream>
 #include <string>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 /* This static indicates the debugging module that this .o belongs to.  */
 static QofLogModule log_module = QOF_MOD_ENGINE;
 
+/* Hex encoding and decoding of the 16 bytes of a GUID, 16 bytes at a time
+ * with SSE2 and a nibble at a time without. */
+namespace
+{
+#ifdef __SSE2__
+    inline void
+    guid_encode (const uint8_t* data, char* str) noexcept
+    {
+        const __m128i mask = _mm_set1_epi8 (0x0f);
+        __m128i bytes = _mm_loadu_si128 (reinterpret_cast<const __m128i*>(data));
+        __m128i hi = _mm_and_si128 (_mm_srli_epi16 (bytes, 4), mask);
+        __m128i lo = _mm_and_si128 (bytes, mask);
+        auto to_hex = [] (__m128i nibbles) {
+            __m128i letters = _mm_and_si128 (
+                _mm_cmpgt_epi8 (nibbles, _mm_set1_epi8 (9)),
+                _mm_set1_epi8 ('a' - '0' - 10));
+            return _mm_add_epi8 (_mm_add_epi8 (nibbles, _mm_set1_epi8 ('0')),
+                                 letters);
+        };
+        __m128i first = to_hex (_mm_unpacklo_epi8 (hi, lo));
+        __m128i second = to_hex (_mm_unpackhi_epi8 (hi, lo));
+        _mm_storeu_si128 (reinterpret_cast<__m128i*>(str), first);
+        _mm_storeu_si128 (reinterpret_cast<__m128i*>(str + 16), second);
+    }
+
+    /* The nibble values of 16 hex digits, or false if one isn't a digit. */
+    inline bool
+    hex_nibbles (const char* str, __m128i* nibbles) noexcept
+    {
+        __m128i chars = _mm_loadu_si128 (reinterpret_cast<const __m128i*>(str));
+        __m128i digits = _mm_sub_epi8 (chars, _mm_set1_epi8 ('0'));
+        __m128i is_digit = _mm_and_si128 (
+            _mm_cmpgt_epi8 (chars, _mm_set1_epi8 ('0' - 1)),
+            _mm_cmplt_epi8 (chars, _mm_set1_epi8 ('9' + 1)));
+        __m128i lower = _mm_or_si128 (chars, _mm_set1_epi8 (0x20));
+        __m128i letters = _mm_sub_epi8 (lower, _mm_set1_epi8 ('a' - 10));
+        __m128i is_letter = _mm_and_si128 (
+            _mm_cmpgt_epi8 (lower, _mm_set1_epi8 ('a' - 1)),
+            _mm_cmplt_epi8 (lower, _mm_set1_epi8 ('f' + 1)));
+        if (_mm_movemask_epi8 (_mm_or_si128 (is_digit, is_letter)) != 0xffff)
+            return false;
+        *nibbles = _mm_or_si128 (_mm_and_si128 (is_digit, digits),
+                                 _mm_andnot_si128 (is_digit, letters));
+        return true;
+    }
+
+    /* str must have 32 readable chars; the caller checks the length. */
+    inline bool
+    guid_decode (const char* str, uint8_t* data) noexcept
+    {
+        __m128i first, second;
+        if (!hex_nibbles (str, &first) || !hex_nibbles (str + 16, &second))
+            return false;
+        /* Each 16-bit lane holds a high nibble in its low byte and the
+         * low nibble in its high byte. */
+        auto combine = [] (__m128i pairs) {
+            return _mm_or_si128 (
+                _mm_slli_epi16 (_mm_and_si128 (pairs, _mm_set1_epi16 (0x0f)), 4),
+                _mm_srli_epi16 (pairs, 8));
+        };
+        _mm_storeu_si128 (reinterpret_cast<__m128i*>(data),
+                          _mm_packus_epi16 (combine (first), combine (second)));
+        return true;
+    }
+#else
+    inline void
+    guid_encode (const uint8_t* data, char* str) noexcept
+    {
+        static const char digits[] = "0123456789abcdef";
+        for (int i = 0; i < 16; ++i)
+        {
+            *str++ = digits[data[i] >> 4];
+            *str++ = digits[data[i] & 0x0f];
+        }
+    }
+
+    inline int
+    hex_value (char c) noexcept
+    {
+        if (c >= '0' && c <= '9')
+            return c - '0';
+        c |= 0x20;
+        if (c >= 'a' && c <= 'f')
+            return c - 'a' + 10;
+        return -1;
+    }
+
+    inline bool
+    guid_decode (const char* str, uint8_t* data) noexcept
+    {
+        uint8_t bytes[16];
+        for (int i = 0; i < 16; ++i)
+        {
+            int hi = hex_value (str[2 * i]), lo = hex_value (str[2 * i + 1]);
+            if (hi < 0 || lo < 0)
+                return false;
+            bytes[i] = static_cast<uint8_t>(hi << 4 | lo);
+        }
+        std::copy (bytes, bytes + 16, data);
+        return true;
+    }
+#endif
+
+    /* True if str is GUID_ENCODING_LENGTH chars long, without reading
+     * past its terminator. */
+    inline bool
+    guid_encoding_length (const char* str) noexcept
+    {
+        for (int i = 0; i < GUID_ENCODING_LENGTH; ++i)
+            if (!str[i])
+                return false;
+        return !str[GUID_ENCODING_LENGTH];
+    }
+}
+
 /**
  * gnc_value_get_guid
  *
@@ -150,10 +270,17 @@ guid_to_string_buff (const GncGUID * guid, gchar *str)
 {
     if (!str || !guid) return NULL;
 
-    auto val = guid->to_string ();
-    /*We need to be sure to copy the terminating null character.*/
-    std::copy (val.c_str (), val.c_str() + val.size () + 1, str);
-    return str + val.size();
+    guid_encode (guid->data, str);
+    str[GUID_ENCODING_LENGTH] = '\0';
+    return str + GUID_ENCODING_LENGTH;
+}
+
+void
+guid_array_to_string_buff (const GncGUID * guids, gsize n_guids, gchar *str)
+{
+    if (!str || !guids) return;
+    for (gsize i = 0; i < n_guids; ++i)
+        str = guid_to_string_buff (&guids[i], str) + 1;
 }
 
 gboolean
@@ -161,6 +288,9 @@ string_to_guid (const char * str, GncGUID * guid)
 {
     if (!guid || !str) return false;
 
+    /* The encoding we write; other spellings are left to boost. */
+    if (guid_encoding_length (str) && guid_decode (str, guid->data))
+        return true;
     try
     {
         auto other = GncGUID::from_string (str);
@@ -173,6 +303,18 @@ string_to_guid (const char * str, GncGUID * guid)
     return true;
 }
 
+gboolean
+string_array_to_guid (const gchar * const * strs, gsize n_strs,
+                      GncGUID * guids)
+{
+    gboolean all = TRUE;
+    if (!strs || !guids) return FALSE;
+    for (gsize i = 0; i < n_strs; ++i)
+        if (!string_to_guid (strs[i], &guids[i]))
+            all = FALSE;
+    return all;
+}
+
 gboolean
 guid_equal (const GncGUID *guid_1, const GncGUID *guid_2)
 {
@@ -278,10 +420,16 @@ gnc_guid_get_type (void)
     return type;
 }
 
+/* Each thread has a generator of its own, seeded once from the system's
+ * entropy source, so that threads creating GUIDs neither share state nor
+ * wait for each other. boost::uuids::random_generator isn't safe to share
+ * in older boost and reads the entropy source for every GUID in newer. */
 GncGUID
 GncGUID::create_random () noexcept
 {
-    static boost::uuids::random_generator gen;
+    using Generator =
+        boost::uuids::basic_random_generator<boost::random::mt19937>;
+    static thread_local Generator gen;
     return {gen ()};
 }
 
@@ -299,12 +447,9 @@ GncGUID::null_guid () noexcept
 std::string
 GncGUID::to_string () const noexcept
 {
-    auto const & val = boost::uuids::to_string (*this);
-    std::string ret;
-    std::for_each (val.begin (), val.end (), [&ret] (char a) {
-        if (a != '-') ret.push_back (a);
-    });
-    return ret;
+    char str[GUID_ENCODING_LENGTH];
+    guid_encode (data, str);
+    return std::string (str, GUID_ENCODING_LENGTH);
 }
 
 GncGUID
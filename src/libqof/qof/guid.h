@@ -149,6 +149,13 @@ gchar * guid_to_string (const GncGUID * guid);
  */
 gchar * guid_to_string_buff (const GncGUID * guid, /*@ out @*/ gchar *buff);
 
+/** Print n_guids guids into buff as guid_to_string_buff() would, one
+ *  after the other, each followed by its null terminator. The buffer
+ *  must be at least n_guids * (GUID_ENCODING_LENGTH+1) characters long.
+ */
+void guid_array_to_string_buff (const GncGUID * guids, gsize n_guids,
+                                /*@ out @*/ gchar *buff);
+
 
 /** Given a string, replace the given guid with the parsed one unless
  * the given value is null.
@@ -161,6 +168,13 @@ gchar * guid_to_string_buff (const GncGUID * guid, /*@ out @*/ gchar *buff);
  */
 gboolean string_to_guid(const gchar * string, /*@ out @*/ GncGUID * guid);
 
+/** Parse n_strs strings into the guids as string_to_guid() would.
+ *  @return TRUE if every string was parsed; the guids of those that
+ *  weren't are left alone.
+ */
+gboolean string_array_to_guid (const gchar * const * strs, gsize n_strs,
+                               /*@ out @*/ GncGUID * guids);
+
 
 /** Given two GUIDs, return TRUE if they are non-NULL and equal.
  * Return FALSE, otherwise. */
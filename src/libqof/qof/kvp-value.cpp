@@ -30,6 +30,18 @@
 #include <iomanip>
 #include <stdexcept>
 
+void*
+KvpValueImpl::operator new(std::size_t size)
+{
+    return g_slice_alloc (size);
+}
+
+void
+KvpValueImpl::operator delete(void* ptr, std::size_t size) noexcept
+{
+    g_slice_free1 (size, ptr);
+}
+
 KvpValueImpl::KvpValueImpl(KvpValueImpl const & other) noexcept
 {
     duplicate(other);
@@ -208,6 +220,46 @@ struct to_string_visitor : boost::static_visitor<void>
     }
 };
 
+struct memory_visitor : boost::static_visitor<std::size_t>
+{
+    template <typename T> std::size_t
+    operator()(const T&) const noexcept { return 0; }
+
+    std::size_t operator()(const char* val) const noexcept
+    {
+        return val ? strlen(val) + 1 : 0;
+    }
+
+    std::size_t operator()(GncGUID* val) const noexcept
+    {
+        return val ? sizeof(GncGUID) : 0;
+    }
+
+    std::size_t operator()(GList* val) const noexcept
+    {
+        std::size_t bytes = 0;
+        for (auto node = val; node; node = node->next)
+        {
+            bytes += sizeof(GList);
+            if (node->data)
+                bytes += static_cast<KvpValue*>(node->data)->memory_used();
+        }
+        return bytes;
+    }
+
+    std::size_t operator()(KvpFrame* val) const noexcept
+    {
+        return val ? val->memory_used() : 0;
+    }
+};
+
+std::size_t
+KvpValueImpl::memory_used() const noexcept
+{
+    memory_visitor visitor;
+    return sizeof(*this) + boost::apply_visitor(visitor, datastore);
+}
+
 char *
 KvpValueImpl::to_string() const noexcept
 {
@@ -106,6 +106,17 @@ struct KvpValueImpl
      */
     ~KvpValueImpl() noexcept;
 
+    /**
+     * KvpValues are small and a book has hundreds of thousands of them, most
+     * holding a single number, GUID or date. They're carved out of GLib's
+     * slice allocator rather than each being a separate malloc() block, which
+     * keeps them packed together and makes creating and deleting them cheap
+     * when the backends load or write the slots. Strings, lists and frames
+     * hanging off a value are still allocated on their own.
+     */
+    static void* operator new(std::size_t size);
+    static void operator delete(void* ptr, std::size_t size) noexcept;
+
     /**
      * Replaces the frame within this KvpValueImpl.
      *
@@ -137,6 +148,12 @@ struct KvpValueImpl
 
     KvpValueImpl::Type get_type() const noexcept;
 
+    /**
+     * Approximate bytes used by the value, including the strings, GUIDs,
+     * lists and frames it owns.
+     */
+    std::size_t memory_used() const noexcept;
+
     char * to_string() const noexcept;
 
     template <typename T>
@@ -47,25 +47,91 @@ static const char delim = '/';
 
 KvpFrameImpl::KvpFrameImpl(const KvpFrameImpl & rhs) noexcept
 {
-    std::for_each(rhs.m_valuemap.begin(), rhs.m_valuemap.end(),
-        [this](const map_type::value_type & a)
+    if (!rhs.m_valuemap)
+        m_slots.reserve(rhs.m_slots.size());
+    rhs.each_slot(
+        [this](const char* first, KvpValue* second)
         {
-            auto key = static_cast<char *>(qof_string_cache_insert(a.first));
-            auto val = new KvpValueImpl(*a.second);
-            this->m_valuemap.insert({key,val});
+            auto key = static_cast<char *>(qof_string_cache_insert(first));
+            auto val = new KvpValueImpl(*second);
+            this->insert_slot(key, val);
         }
     );
 }
 
 KvpFrameImpl::~KvpFrameImpl() noexcept
 {
-    std::for_each(m_valuemap.begin(), m_valuemap.end(),
-		 [](const map_type::value_type &a){
-		      qof_string_cache_remove(a.first);
-		      delete a.second;
-		  }
-	);
-    m_valuemap.clear();
+    each_slot(
+        [](const char* first, KvpValue* second){
+            qof_string_cache_remove(first);
+            delete second;
+        }
+    );
+    m_slots.clear();
+    m_valuemap.reset();
+}
+
+static inline bool
+slot_before_key(const KvpFrameImpl::slot_type& slot, const char* key)
+{
+    return std::strcmp(slot.first, key) < 0;
+}
+
+KvpValue*
+KvpFrameImpl::find_slot(const char* key) const noexcept
+{
+    if (m_valuemap)
+    {
+        auto spot = m_valuemap->find(key);
+        return spot == m_valuemap->end() ? nullptr : spot->second;
+    }
+    auto spot = std::lower_bound(m_slots.begin(), m_slots.end(), key,
+                                 slot_before_key);
+    if (spot == m_slots.end() || std::strcmp(spot->first, key) != 0)
+        return nullptr;
+    return spot->second;
+}
+
+KvpValue*
+KvpFrameImpl::remove_slot(const char* key) noexcept
+{
+    KvpValue* ret {nullptr};
+    if (m_valuemap)
+    {
+        auto spot = m_valuemap->find(key);
+        if (spot == m_valuemap->end())
+            return nullptr;
+        qof_string_cache_remove(spot->first);
+        ret = spot->second;
+        m_valuemap->erase(spot);
+        return ret;
+    }
+    auto spot = std::lower_bound(m_slots.begin(), m_slots.end(), key,
+                                 slot_before_key);
+    if (spot == m_slots.end() || std::strcmp(spot->first, key) != 0)
+        return nullptr;
+    qof_string_cache_remove(spot->first);
+    ret = spot->second;
+    m_slots.erase(spot);
+    return ret;
+}
+
+void
+KvpFrameImpl::insert_slot(const char* key, KvpValue* value) noexcept
+{
+    if (!m_valuemap && m_slots.size() >= max_vector_slots)
+    {
+        m_valuemap.reset(new map_type(m_slots.begin(), m_slots.end()));
+        std::vector<slot_type>().swap(m_slots);
+    }
+    if (m_valuemap)
+    {
+        m_valuemap->insert({key, value});
+        return;
+    }
+    auto spot = std::lower_bound(m_slots.begin(), m_slots.end(), key,
+                                 slot_before_key);
+    m_slots.insert(spot, {key, value});
 }
 
 static inline Path
@@ -90,20 +156,13 @@ KvpFrameImpl::set(const char* key, KvpValue* value) noexcept
     if (!key) return nullptr;
     if (strchr(key, delim))
         return set(make_vector(key), value);
-    KvpValue* ret {nullptr};
-    auto spot = m_valuemap.find(key);
-    if (spot != m_valuemap.end())
-    {
-        qof_string_cache_remove(spot->first);
-        ret = spot->second;
-        m_valuemap.erase(spot);
-    }
+    KvpValue* ret = remove_slot(key);
 
     if (value)
     {
         auto cachedkey =
             static_cast<const char *>(qof_string_cache_insert(key));
-        m_valuemap.insert({cachedkey,value});
+        insert_slot(cachedkey, value);
     }
 
     return ret;
@@ -179,21 +238,42 @@ KvpFrameImpl::set_path(Path path, KvpValue* value) noexcept
     return cur_frame->set(last_key.c_str(), value);
 }
 
+KvpValue*
+KvpFrameImpl::set_path(const char * const * keys, std::size_t n_keys,
+                       KvpValue* value) noexcept
+{
+    if (!keys || !n_keys) return nullptr;
+    auto cur_frame = this;
+    for (std::size_t i = 0; i + 1 < n_keys; ++i)
+    {
+        auto slot = cur_frame->find_slot(keys[i]);
+        if (slot == nullptr || slot->get_type() != KvpValue::Type::FRAME)
+        {
+            auto new_frame = new KvpFrame;
+            delete cur_frame->set(keys[i], new KvpValue{new_frame});
+            cur_frame = new_frame;
+            continue;
+        }
+        cur_frame = slot->get<KvpFrame*>();
+    }
+    return cur_frame->set(keys[n_keys - 1], value);
+}
+
 std::string
 KvpFrameImpl::to_string() const noexcept
 {
     std::ostringstream ret;
     ret << "{\n";
 
-    std::for_each(m_valuemap.begin(), m_valuemap.end(),
-        [this,&ret](const map_type::value_type &a)
+    each_slot(
+        [&ret](const char* first, KvpValue* second)
         {
             ret << "    ";
-            if (a.first)
-                ret << a.first;
+            if (first)
+                ret << first;
             ret << " => ";
-            if (a.second)
-                ret << a.second->to_string();
+            if (second)
+                ret << second->to_string();
             ret << ",\n";
         }
     );
@@ -202,14 +282,34 @@ KvpFrameImpl::to_string() const noexcept
     return ret.str();
 }
 
+std::size_t
+KvpFrameImpl::memory_used() const noexcept
+{
+    std::size_t bytes = sizeof(*this) + m_slots.capacity() * sizeof(slot_type);
+    /* A red-black tree node holds three pointers and a colour besides
+     * the slot. */
+    if (m_valuemap)
+        bytes += sizeof(map_type) + m_valuemap->size() *
+            (sizeof(map_type::value_type) + 4 * sizeof(void*));
+    each_slot(
+        [&bytes](const char*, KvpValue* value)
+        {
+            if (value)
+                bytes += value->memory_used();
+        }
+    );
+    return bytes;
+}
+
 std::vector<std::string>
 KvpFrameImpl::get_keys() const noexcept
 {
     std::vector<std::string> ret;
-    std::for_each(m_valuemap.begin(), m_valuemap.end(),
-        [&ret](const KvpFrameImpl::map_type::value_type &a)
+    ret.reserve(size());
+    each_slot(
+        [&ret](const char* first, KvpValue*)
         {
-            ret.push_back(a.first);
+            ret.push_back(first);
         }
     );
     return ret;
@@ -221,10 +321,10 @@ KvpFrameImpl::for_each_slot(void (*proc)(const char *key, KvpValue *value,
                             void *data) const noexcept
 {
     if (!proc) return;
-    std::for_each (m_valuemap.begin(), m_valuemap.end(),
-        [proc,data](const KvpFrameImpl::map_type::value_type & a)
+    each_slot(
+        [proc,data](const char* first, KvpValue* second)
         {
-            proc (a.first, a.second, data);
+            proc (first, second, data);
         }
     );
 }
@@ -235,10 +335,7 @@ KvpFrameImpl::get_slot(const char * key) const noexcept
     if (!key) return nullptr;
     if (strchr(key, delim))
         return get_slot(make_vector(key));
-    auto spot = m_valuemap.find(key);
-    if (spot == m_valuemap.end())
-        return nullptr;
-    return spot->second;
+    return find_slot(key);
 }
 
 KvpValueImpl *
@@ -255,6 +352,22 @@ KvpFrameImpl::get_slot(Path path) const noexcept
 
 }
 
+KvpValueImpl *
+KvpFrameImpl::get_slot(const char * const * keys,
+                       std::size_t n_keys) const noexcept
+{
+    if (!keys || !n_keys) return nullptr;
+    auto cur_frame = this;
+    for (std::size_t i = 0; i + 1 < n_keys; ++i)
+    {
+        auto slot = cur_frame->find_slot(keys[i]);
+        if (slot == nullptr || slot->get_type() != KvpValue::Type::FRAME)
+            return nullptr;
+        cur_frame = slot->get<KvpFrame*>();
+    }
+    return cur_frame->find_slot(keys[n_keys - 1]);
+}
+
 int compare(const KvpFrameImpl * one, const KvpFrameImpl * two) noexcept
 {
     if (one && !two) return 1;
@@ -272,20 +385,23 @@ int compare(const KvpFrameImpl * one, const KvpFrameImpl * two) noexcept
  */
 int compare(const KvpFrameImpl & one, const KvpFrameImpl & two) noexcept
 {
-    for (const auto & a : one.m_valuemap)
-    {
-        auto otherspot = two.m_valuemap.find(a.first);
-        if (otherspot == two.m_valuemap.end())
+    int comparison = 0;
+    one.each_slot(
+        [&two, &comparison](const char* first, KvpValue* second)
         {
-            return 1;
+            if (comparison != 0)
+                return;
+            auto otherspot = two.find_slot(first);
+            if (otherspot == nullptr)
+                comparison = 1;
+            else
+                comparison = compare(second, otherspot);
         }
-        auto comparison = compare(a.second,otherspot->second);
-
-        if (comparison != 0)
-            return comparison;
-    }
+    );
+    if (comparison != 0)
+        return comparison;
 
-    if (one.m_valuemap.size() < two.m_valuemap.size())
+    if (one.size() < two.size())
         return -1;
     return 0;
 }
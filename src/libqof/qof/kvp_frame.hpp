@@ -90,6 +90,7 @@
 
 #include "kvp-value.hpp"
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 #include <cstring>
@@ -120,6 +121,7 @@ struct KvpFrameImpl
 	    }
     };
     using map_type = std::map<const char *, KvpValue*, cstring_comparer>;
+    using slot_type = std::pair<const char *, KvpValue*>;
 
     public:
     KvpFrameImpl() noexcept {};
@@ -182,6 +184,20 @@ struct KvpFrameImpl
      * @return The old value if there was one or nullptr.
      */
     KvpValue* set_path(Path path, KvpValue* newvalue) noexcept;
+    /**
+     * Set the value at the end of a path of keys which the caller has already
+     * split, replacing and returning the old value if it exists or nullptr
+     * if it doesn't. Creates any missing intermediate frames. Takes
+     * ownership of new value and releases ownership of the returned old
+     * value. Values must be allocated on the free store with operator new.
+     * @param keys: The keys of the subframes, then of the slot. They may not
+     * contain '/'.
+     * @param n_keys: The number of keys.
+     * @param newvalue: The value to set at the last key.
+     * @return The old value if there was one or nullptr.
+     */
+    KvpValue* set_path(const char * const * keys, std::size_t n_keys,
+                       KvpValue* newvalue) noexcept;
     /**
      * Make a string representation of the frame. Mostly useful for debugging.
      * @return A std::string representing the frame and all its children.
@@ -204,6 +220,16 @@ struct KvpFrameImpl
      * @return The value at the key or nullptr.
      */
     KvpValue* get_slot(Path keys) const noexcept;
+    /** Get the value at the end of a path of keys which the caller has
+     * already split, or nullptr if it doesn't exist. Unlike the other
+     * get_slot()s this allocates nothing.
+     * @param keys: The keys of the subframes, then of the slot. They may not
+     * contain '/'.
+     * @param n_keys: The number of keys.
+     * @return The value at the last key or nullptr.
+     */
+    KvpValue* get_slot(const char * const * keys,
+                       std::size_t n_keys) const noexcept;
     /** Convenience wrapper for std::for_each, which should be preferred.
      */
     void for_each_slot(void (*proc)(const char *key, KvpValue *value,
@@ -213,11 +239,49 @@ struct KvpFrameImpl
     /** Test for emptiness
      * @return true if the frame contains nothing.
      */
-    bool empty() const noexcept { return m_valuemap.empty(); }
+    bool empty() const noexcept
+    {
+        return m_valuemap ? m_valuemap->empty() : m_slots.empty();
+    }
+
+    /** Approximate bytes used by the frame and everything in it. The keys
+     * live in the string cache and aren't counted.
+     */
+    std::size_t memory_used() const noexcept;
     friend int compare(const KvpFrameImpl&, const KvpFrameImpl&) noexcept;
 
     private:
-    map_type m_valuemap;
+    /* Most frames hold only a few slots, so they're kept in a vector
+     * sorted like map_type until there are more than this many, when
+     * they move to a map_type for good. */
+    static const std::size_t max_vector_slots = 16;
+
+    std::size_t size() const noexcept
+    {
+        return m_valuemap ? m_valuemap->size() : m_slots.size();
+    }
+    KvpValue* find_slot(const char* key) const noexcept;
+    /* Removes the slot for key and returns its value, releasing the
+     * cached key; nullptr if there's no such slot. */
+    KvpValue* remove_slot(const char* key) noexcept;
+    /* Takes a key already in the string cache. */
+    void insert_slot(const char* key, KvpValue* value) noexcept;
+    /* Calls func(key, value) for each slot in key order. */
+    template <typename Func> void each_slot(Func func) const noexcept
+    {
+        if (m_valuemap)
+        {
+            for (const auto& a : *m_valuemap)
+                func(a.first, a.second);
+            return;
+        }
+        /* Indexed so that a slot added by func can't invalidate the walk. */
+        for (std::size_t i = 0; i < m_slots.size(); ++i)
+            func(m_slots[i].first, m_slots[i].second);
+    }
+
+    std::vector<slot_type> m_slots;
+    std::unique_ptr<map_type> m_valuemap;
 };
 
 int compare (const KvpFrameImpl &, const KvpFrameImpl &) noexcept;
@@ -38,46 +38,80 @@ extern "C"
 #include "qof.h"
 }
 
+#include <mutex>
+
 /* Uncomment if you need to log anything.
 static QofLogModule log_module = QOF_MOD_UTIL;
 */
 /* =================================================================== */
 /* The QOF string cache                                                */
 /*                                                                     */
-/* The cache is a GHashTable where a copy of the string is the key,    */
-/* and a ref count is the value                                        */
+/* The cache is split into shards by the hash of the string, so that   */
+/* threads building objects at the same time mostly take different     */
+/* locks. Each shard is a GHashTable where a copy of the string is the */
+/* key and its refcount, stored in the pointer itself, is the value.   */
+/* The shards don't own their keys: g_hash_table_insert would free the */
+/* key we pass when bumping the refcount, which is the cached string.  */
 /* =================================================================== */
 
-static GHashTable* qof_string_cache = NULL;
+#define QOF_STRING_CACHE_SHARD_BITS 5
+
+struct StringCacheShard
+{
+    std::mutex lock;
+    GHashTable* table;
+};
+
+static StringCacheShard qof_string_cache[1 << QOF_STRING_CACHE_SHARD_BITS];
+
+/* g_str_hash's low bits pick the GHashTable's bucket, so spread the hash
+ * and take the top bits for the shard. */
+static StringCacheShard&
+qof_get_string_cache_shard(gconstpointer key)
+{
+    guint32 spread = g_str_hash(key) * 0x9e3779b1u;
+    return qof_string_cache[spread >> (32 - QOF_STRING_CACHE_SHARD_BITS)];
+}
 
+/* Must be called with the shard's lock held. */
 static GHashTable*
-qof_get_string_cache(void)
+qof_get_string_cache(StringCacheShard& shard)
 {
-    if (!qof_string_cache)
-    {
-        qof_string_cache = g_hash_table_new_full(
-                               g_str_hash,               /* hash_func          */
-                               g_str_equal,              /* key_equal_func     */
-                               g_free,                   /* key_destroy_func   */
-                               g_free);                  /* value_destroy_func */
-    }
-    return qof_string_cache;
+    if (!shard.table)
+        shard.table = g_hash_table_new(g_str_hash, g_str_equal);
+    return shard.table;
+}
+
+static void
+qof_string_cache_free_key(gpointer key, gpointer value, gpointer user_data)
+{
+    g_free(key);
 }
 
 void
 qof_string_cache_init(void)
 {
-    (void)qof_get_string_cache();
+    for (auto& shard : qof_string_cache)
+    {
+        std::lock_guard<std::mutex> guard(shard.lock);
+        (void)qof_get_string_cache(shard);
+    }
 }
 
 void
 qof_string_cache_destroy (void)
 {
-    if (qof_string_cache)
+    for (auto& shard : qof_string_cache)
     {
-        g_hash_table_destroy(qof_string_cache);
+        std::lock_guard<std::mutex> guard(shard.lock);
+        if (shard.table)
+        {
+            g_hash_table_foreach(shard.table, qof_string_cache_free_key,
+                                 NULL);
+            g_hash_table_destroy(shard.table);
+        }
+        shard.table = NULL;
     }
-    qof_string_cache = NULL;
 }
 
 /* If the key exists in the cache, check the refcount.  If 1, just
@@ -87,19 +121,23 @@ qof_string_cache_remove(gconstpointer key)
 {
     if (key)
     {
-        GHashTable* cache = qof_get_string_cache();
+        StringCacheShard& shard = qof_get_string_cache_shard(key);
+        std::lock_guard<std::mutex> guard(shard.lock);
+        GHashTable* cache = qof_get_string_cache(shard);
         gpointer value;
         gpointer cache_key;
         if (g_hash_table_lookup_extended(cache, key, &cache_key, &value))
         {
-            guint* refcount = (guint*)value;
-            if (*refcount == 1)
+            guint refcount = GPOINTER_TO_UINT(value);
+            if (refcount == 1)
             {
                 g_hash_table_remove(cache, key);
+                g_free(cache_key);
             }
             else
             {
-                --(*refcount);
+                g_hash_table_insert(cache, cache_key,
+                                    GUINT_TO_POINTER(refcount - 1));
             }
         }
     }
@@ -112,25 +150,59 @@ qof_string_cache_insert(gconstpointer key)
 {
     if (key)
     {
-        GHashTable* cache = qof_get_string_cache();
+        StringCacheShard& shard = qof_get_string_cache_shard(key);
+        std::lock_guard<std::mutex> guard(shard.lock);
+        GHashTable* cache = qof_get_string_cache(shard);
         gpointer value;
         gpointer cache_key;
         if (g_hash_table_lookup_extended(cache, key, &cache_key, &value))
         {
-            guint* refcount = (guint*)value;
-            ++(*refcount);
+            guint refcount = GPOINTER_TO_UINT(value);
+            g_hash_table_insert(cache, cache_key,
+                                GUINT_TO_POINTER(refcount + 1));
             return cache_key;
         }
         else
         {
             gpointer new_key = g_strdup(static_cast<const char*>(key));
-            guint* refcount = static_cast<unsigned int*>(g_malloc(sizeof(guint)));
-            *refcount = 1;
-            g_hash_table_insert(cache, new_key, refcount);
+            g_hash_table_insert(cache, new_key, GUINT_TO_POINTER(1));
             return new_key;
         }
     }
     return NULL;
 }
 
+void
+qof_string_cache_get_stats(guint *n_strings, guint64 *n_refs, gsize *bytes)
+{
+    guint strings = 0;
+    guint64 refs = 0;
+    gsize size = 0;
+    for (auto& shard : qof_string_cache)
+    {
+        std::lock_guard<std::mutex> guard(shard.lock);
+        if (!shard.table)
+            continue;
+        GHashTableIter iter;
+        gpointer key, value;
+        g_hash_table_iter_init(&iter, shard.table);
+        while (g_hash_table_iter_next(&iter, &key, &value))
+        {
+            ++strings;
+            refs += GPOINTER_TO_UINT(value);
+            size += strlen(static_cast<const char*>(key)) + 1;
+        }
+        /* A GHashTable keeps a key, a value and a hash per entry, in
+         * tables kept under 3/4 full. */
+        size += g_hash_table_size(shard.table) * 4 / 3 *
+            (2 * sizeof(gpointer) + sizeof(guint));
+    }
+    if (n_strings)
+        *n_strings = strings;
+    if (n_refs)
+        *n_refs = refs;
+    if (bytes)
+        *bytes = size;
+}
+
 /* ************************ END OF FILE ***************************** */
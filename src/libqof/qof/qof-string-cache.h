@@ -66,7 +66,9 @@ extern "C"
  * Note that all the work is done when inserting or removing.  Once
  * cached the strings are just plain C strings.
  *
- * The string cache is demand-created on first use.
+ * The string cache is demand-created on first use. Inserting and removing
+ * strings is safe from several threads at once; qof_string_cache_init()
+ * and qof_string_cache_destroy() are not meant to race with anything.
  *
  **/
 
@@ -86,6 +88,12 @@ void qof_string_cache_remove(gconstpointer key);
 */
 gpointer qof_string_cache_insert(gconstpointer key);
 
+/** Report how many distinct strings the cache holds, how many references
+ * there are to them and roughly how many bytes the strings and the
+ * cache's tables take.  Any of the pointers may be NULL. */
+void qof_string_cache_get_stats(guint *n_strings, guint64 *n_refs,
+                                gsize *bytes);
+
 #define CACHE_INSERT(str) qof_string_cache_insert((gconstpointer)(str))
 #define CACHE_REMOVE(str) qof_string_cache_remove((str))
 
@@ -94,12 +102,19 @@ gpointer qof_string_cache_insert(gconstpointer key);
  *     void foo_set_name(Foo *f, const char *str) {
  *        CACHE_REPLACE(f->name, str);
  *     }
- * It avoids unnecessary ejection by doing INSERT before REMOVE.
+ * It avoids unnecessary ejection by doing INSERT before REMOVE.  Since
+ * equal strings share one cached copy, setting an object's string to
+ * one it already holds, or to another object's, is often a no-op
+ * that needn't touch the cache at all.
 */
-#define CACHE_REPLACE(dst, src) do {          \
-        gpointer tmp = CACHE_INSERT((src));   \
-        CACHE_REMOVE((dst));                  \
-        (dst) = tmp;                          \
+#define CACHE_REPLACE(dst, src) do {              \
+        gconstpointer src_ = (src);               \
+        if (src_ != (gconstpointer)(dst))         \
+        {                                         \
+            gpointer tmp = CACHE_INSERT(src_);    \
+            CACHE_REMOVE((dst));                  \
+            (dst) = tmp;                          \
+        }                                         \
     } while (0)
 
 #define QOF_CACHE_NEW(void) qof_string_cache_insert("")
@@ -156,6 +156,13 @@
  *    data. Database backends should implement a more intelligent
  *    solution.
  *
+ * The background_sync() routine does what sync() does, but may leave
+ *    writing the data out to a thread of its own and return before it is
+ *    done. The book counts as saved as it was when background_sync()
+ *    returned. A failed write marks it unsaved again and is reported by
+ *    the next sync(), which, like ending the session, first waits for the
+ *    write to be done. It is optional; sync() is used in its absence.
+ *
  * The events_pending() routines should return true if there are
  *    external events which need to be processed to bring the
  *    engine up to date with the backend.
@@ -265,6 +272,7 @@ struct QofBackend_s
 
     void (*sync) (QofBackend *, /*@ dependent @*/ QofBook *);
     void (*safe_sync) (QofBackend *, /*@ dependent @*/ QofBook *);
+    void (*background_sync) (QofBackend *, /*@ dependent @*/ QofBook *);
 
     gboolean (*events_pending) (QofBackend *);
     gboolean (*process_events) (QofBackend *);
@@ -297,6 +305,9 @@ struct QofBackend_s
      */
     void (*export_fn) (QofBackend *, QofBook *);
 
+    /** Counters and times of the last load or save, name to gint64;
+     * see qof_backend_stat_add(). */
+    GHashTable *stats;
 };
 
 #ifdef __cplusplus
@@ -316,6 +327,34 @@ char * qof_backend_get_message(QofBackend *be);
 void qof_backend_init(QofBackend *be);
 void qof_backend_destroy(QofBackend *be);
 
+/** @name Statistics
+ * What a backend counted and timed while loading or saving a book, for
+ * the trace log, the log and qof_session_get_stat().  The session
+ * clears them before each load and save.  Times are in microseconds
+ * and their names end in "-usec"; other names count objects or bytes.
+ * Only the thread running the load or save may use them.
+ @{ */
+typedef void (*QofBackendStatFunc) (const char *name, gint64 value,
+                                    gpointer user_data);
+
+/** Add @a value to the statistic @a name, which starts at 0. */
+void qof_backend_stat_add (QofBackend *be, const char *name, gint64 value);
+
+/** Add the microseconds since @a start, a g_get_monotonic_time(), to
+ * the statistic @a name. */
+void qof_backend_stat_add_time (QofBackend *be, const char *name,
+                                gint64 start);
+
+/** The statistic @a name, or 0 if nothing was added to it. */
+gint64 qof_backend_stat_get (const QofBackend *be, const char *name);
+
+/** Call @a func on every statistic, in no particular order. */
+void qof_backend_foreach_stat (const QofBackend *be, QofBackendStatFunc func,
+                               gpointer user_data);
+
+void qof_backend_stats_clear (QofBackend *be);
+/** @} */
+
 /** Allow backends to see if the book is open
 
 @return 'y' if book is open, otherwise 'n'.
@@ -338,6 +377,26 @@ void qof_book_set_version (QofBook *book, gint32 version);
 /* @} */
 #ifdef __cplusplus
 }
+
+/** A phase of a load or save lasting for the enclosing scope: a span of
+ * the trace log, and its time added to the statistic
+ * "<category>.<name>-usec". */
+class QofBackendPhase
+{
+public:
+    QofBackendPhase (QofBackend* be, const char* category,
+                     const char* name) noexcept :
+        m_be {be}, m_category {category}, m_name {name},
+        m_start {g_get_monotonic_time ()} {}
+    ~QofBackendPhase ();
+    QofBackendPhase (const QofBackendPhase&) = delete;
+    QofBackendPhase& operator= (const QofBackendPhase&) = delete;
+private:
+    QofBackend* m_be;
+    const char* m_category;
+    const char* m_name;
+    gint64 m_start;
+};
 #endif
 
 #endif /* QOF_BACKEND_P_H */
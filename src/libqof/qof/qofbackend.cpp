@@ -157,6 +157,7 @@ qof_backend_init(QofBackend *be)
 
     be->sync = NULL;
     be->safe_sync = NULL;
+    be->background_sync = NULL;
 
     be->events_pending = NULL;
     be->process_events = NULL;
@@ -169,6 +170,8 @@ qof_backend_init(QofBackend *be)
     /* to be removed */
     be->price_lookup = NULL;
     be->export_fn = NULL;
+
+    be->stats = NULL;
 }
 
 void
@@ -176,6 +179,80 @@ qof_backend_destroy(QofBackend *be)
 {
     g_free(be->error_msg);
     be->error_msg = NULL;
+    if (be->stats)
+        g_hash_table_destroy (be->stats);
+    be->stats = NULL;
+}
+
+/***********************************************************************/
+/* Statistics */
+
+void
+qof_backend_stat_add (QofBackend *be, const char *name, gint64 value)
+{
+    g_return_if_fail (be && name);
+    if (!be->stats)
+        be->stats = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                           g_free, g_free);
+    auto stat = static_cast<gint64*>(g_hash_table_lookup (be->stats, name));
+    if (!stat)
+    {
+        stat = g_new0 (gint64, 1);
+        g_hash_table_insert (be->stats, g_strdup (name), stat);
+    }
+    *stat += value;
+    if (G_UNLIKELY (g_atomic_int_get (&qof_log_trace_enabled)))
+        qof_log_trace_counter ("stats", name, *stat);
+}
+
+void
+qof_backend_stat_add_time (QofBackend *be, const char *name, gint64 start)
+{
+    qof_backend_stat_add (be, name, g_get_monotonic_time () - start);
+}
+
+gint64
+qof_backend_stat_get (const QofBackend *be, const char *name)
+{
+    g_return_val_if_fail (be && name, 0);
+    if (!be->stats)
+        return 0;
+    auto stat = static_cast<gint64*>(g_hash_table_lookup (be->stats, name));
+    return stat ? *stat : 0;
+}
+
+void
+qof_backend_foreach_stat (const QofBackend *be, QofBackendStatFunc func,
+                          gpointer user_data)
+{
+    g_return_if_fail (be && func);
+    if (!be->stats)
+        return;
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init (&iter, be->stats);
+    while (g_hash_table_iter_next (&iter, &key, &value))
+        func (static_cast<const char*>(key), *static_cast<gint64*>(value),
+              user_data);
+}
+
+void
+qof_backend_stats_clear (QofBackend *be)
+{
+    g_return_if_fail (be);
+    if (be->stats)
+        g_hash_table_remove_all (be->stats);
+}
+
+QofBackendPhase::~QofBackendPhase ()
+{
+    QOF_TRACE_END (m_category, m_name,
+                   g_atomic_int_get (&qof_log_trace_enabled) ? m_start : 0);
+    if (!m_be)
+        return;
+    auto name = g_strconcat (m_category, ".", m_name, "-usec", NULL);
+    qof_backend_stat_add_time (m_be, name, m_start);
+    g_free (name);
 }
 
 void
@@ -216,6 +293,7 @@ qof_backend_run_commit(QofBackend *be, QofInstance *inst)
     {
         return;
     }
+    QofLogTraceScope trace {"backend", "commit"};
     (be->commit) (be, inst);
 }
 
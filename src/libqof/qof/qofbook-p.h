@@ -81,6 +81,11 @@ gchar *qof_book_normalize_counter_format_internal(const gchar *p,
  */
 void qof_book_print_dirty (const QofBook *book);
 
+/** Called as a change to inst is committed: moves the book on to its
+ *    next generation, which is returned, and records inst as changed in
+ *    the book's open snapshots. */
+guint64 qof_book_note_change (QofBook *book, QofInstance *inst);
+
 /* @} */
 /* @} */
 /* @} */
@@ -60,6 +60,10 @@ extern "C"
 #include "qofbookslots.h"
 #include "kvp_frame.hpp"
 
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
 static QofLogModule log_module = QOF_MOD_ENGINE;
 #define AB_KEY "hbci"
 #define AB_TEMPLATES "template-list"
@@ -93,6 +97,25 @@ enum
     N_PROPERTIES		/* Just a counter */
 };
 
+/* A counter as handed out by qof_book_increment_and_format_counter. The
+ * value is written back to the book's KVP when the book is committed,
+ * so that a caller numbering many invoices inside one edit doesn't go
+ * through the KVP and the backend for each of them. */
+struct QofBookCounter
+{
+    int64_t value;
+    bool dirty;                 // Newer than the value in the KVP
+    std::string user_format;    // The format as found in the KVP ...
+    std::string format;         // ... and after normalizing it
+};
+
+struct QofBookCounters
+{
+    /* Recursive because committing the book flushes the counters. */
+    std::recursive_mutex mutex;
+    std::unordered_map<std::string, QofBookCounter> counters;
+};
+
 QOF_GOBJECT_GET_TYPE(QofBook, qof_book, QOF_TYPE_INSTANCE, {});
 QOF_GOBJECT_DISPOSE(qof_book);
 QOF_GOBJECT_FINALIZE(qof_book);
@@ -122,11 +145,15 @@ qof_book_init (QofBook *book)
 
     book->data_tables = g_hash_table_new (g_str_hash, g_str_equal);
     book->data_table_finalizers = g_hash_table_new (g_str_hash, g_str_equal);
+    book->counters = new QofBookCounters;
 
     book->book_open = 'y';
     book->read_only = FALSE;
     book->session_dirty = FALSE;
     book->version = 0;
+    book->generation = 0;
+    book->snapshots = NULL;
+    g_rw_lock_init (&book->rw_lock);
 }
 
 static void
@@ -417,8 +444,12 @@ qof_book_dispose_real (G_GNUC_UNUSED GObject *bookp)
 }
 
 static void
-qof_book_finalize_real (G_GNUC_UNUSED GObject *bookp)
+qof_book_finalize_real (GObject *bookp)
 {
+    auto book = QOF_BOOK (bookp);
+    delete book->counters;
+    book->counters = nullptr;
+    g_rw_lock_clear (&book->rw_lock);
 }
 
 void
@@ -432,6 +463,12 @@ qof_book_destroy (QofBook *book)
     book->shutting_down = TRUE;
     qof_event_force (&book->inst, QOF_EVENT_DESTROY, NULL);
 
+    /* Outstanding snapshots outlive the book, but are no longer current. */
+    for (GList *node = book->snapshots; node; node = node->next)
+        static_cast<QofBookSnapshot*> (node->data)->book = nullptr;
+    g_list_free (book->snapshots);
+    book->snapshots = NULL;
+
     /* Call the list of finalizers, let them do their thing.
      * Do this before tearing into the rest of the book.
      */
@@ -522,6 +559,123 @@ qof_book_set_dirty_cb(QofBook *book, QofBookDirtyCB cb, gpointer user_data)
     book->dirty_cb = cb;
 }
 
+/* ====================================================================== */
+
+struct QofBookSnapshot
+{
+    QofBook *book;
+    guint64 generation;
+    GHashTable *changed;  /* GncGUID -> NULL, owning the GUIDs */
+};
+
+void
+qof_book_read_lock (QofBook *book)
+{
+    g_return_if_fail (QOF_IS_BOOK (book));
+    g_rw_lock_reader_lock (&book->rw_lock);
+}
+
+void
+qof_book_read_unlock (QofBook *book)
+{
+    g_return_if_fail (QOF_IS_BOOK (book));
+    g_rw_lock_reader_unlock (&book->rw_lock);
+}
+
+void
+qof_book_write_lock (QofBook *book)
+{
+    g_return_if_fail (QOF_IS_BOOK (book));
+    g_rw_lock_writer_lock (&book->rw_lock);
+}
+
+void
+qof_book_write_unlock (QofBook *book)
+{
+    g_return_if_fail (QOF_IS_BOOK (book));
+    g_rw_lock_writer_unlock (&book->rw_lock);
+}
+
+guint64
+qof_book_get_generation (const QofBook *book)
+{
+    g_return_val_if_fail (QOF_IS_BOOK (book), 0);
+    return book->generation;
+}
+
+guint64
+qof_book_note_change (QofBook *book, QofInstance *inst)
+{
+    if (!book) return 0;
+
+    for (GList *node = book->snapshots; node; node = node->next)
+    {
+        auto snapshot = static_cast<QofBookSnapshot*> (node->data);
+        auto guid = qof_instance_get_guid (inst);
+        if (!g_hash_table_lookup_extended (snapshot->changed, guid,
+                                           nullptr, nullptr))
+            g_hash_table_insert (snapshot->changed, guid_copy (guid), NULL);
+    }
+    return ++book->generation;
+}
+
+QofBookSnapshot *
+qof_book_snapshot_new (QofBook *book)
+{
+    g_return_val_if_fail (QOF_IS_BOOK (book), NULL);
+
+    auto snapshot = g_new0 (QofBookSnapshot, 1);
+    snapshot->book = book;
+    snapshot->generation = book->generation;
+    snapshot->changed = g_hash_table_new_full (guid_hash_to_guint,
+                                               guid_g_hash_table_equal,
+                                               guid_free, NULL);
+    book->snapshots = g_list_prepend (book->snapshots, snapshot);
+    return snapshot;
+}
+
+void
+qof_book_snapshot_free (QofBookSnapshot *snapshot)
+{
+    if (!snapshot) return;
+    if (snapshot->book)
+        snapshot->book->snapshots = g_list_remove (snapshot->book->snapshots,
+                                                   snapshot);
+    g_hash_table_destroy (snapshot->changed);
+    g_free (snapshot);
+}
+
+guint64
+qof_book_snapshot_get_generation (const QofBookSnapshot *snapshot)
+{
+    g_return_val_if_fail (snapshot, 0);
+    return snapshot->generation;
+}
+
+gboolean
+qof_book_snapshot_is_current (const QofBookSnapshot *snapshot)
+{
+    g_return_val_if_fail (snapshot, FALSE);
+    return snapshot->book &&
+           snapshot->book->generation == snapshot->generation;
+}
+
+gboolean
+qof_book_snapshot_changed (const QofBookSnapshot *snapshot,
+                           const GncGUID *guid)
+{
+    g_return_val_if_fail (snapshot && guid, TRUE);
+    return g_hash_table_lookup_extended (snapshot->changed, guid,
+                                         NULL, NULL);
+}
+
+GList *
+qof_book_snapshot_get_changed (const QofBookSnapshot *snapshot)
+{
+    g_return_val_if_fail (snapshot, NULL);
+    return g_hash_table_get_keys (snapshot->changed);
+}
+
 /* ====================================================================== */
 /* getters */
 
@@ -646,6 +800,119 @@ qof_book_foreach_collection (const QofBook *book,
 
 /* ====================================================================== */
 
+struct TypeStatsData
+{
+    QofBookTypeStats *stats;
+    GType type;
+    gsize size;
+};
+
+/* The instance struct and, where the type has one, the private struct
+ * of each class in its hierarchy. */
+static gsize
+instance_size (QofInstance *inst)
+{
+    GTypeQuery query;
+    g_type_query (G_OBJECT_TYPE (inst), &query);
+    gsize size = query.instance_size;
+#if GLIB_CHECK_VERSION(2,38,0)
+    size -= g_type_class_get_instance_private_offset (G_OBJECT_GET_CLASS (inst));
+#endif
+    return size;
+}
+
+static void
+type_stats_instance_cb (QofInstance *inst, gpointer user_data)
+{
+    auto data = static_cast<TypeStatsData*>(user_data);
+    /* A collection nearly always holds a single GType. */
+    if (G_OBJECT_TYPE (inst) != data->type)
+    {
+        data->type = G_OBJECT_TYPE (inst);
+        data->size = instance_size (inst);
+    }
+    data->stats->instance_bytes += data->size;
+    if (inst->kvp_data)
+        data->stats->kvp_bytes += inst->kvp_data->memory_used ();
+}
+
+static void
+type_stats_collection_cb (QofCollection *col, gpointer user_data)
+{
+    auto list = static_cast<GList**>(user_data);
+    auto stats = g_new0 (QofBookTypeStats, 1);
+    TypeStatsData data {stats, 0, 0};
+
+    stats->e_type = qof_collection_get_type (col);
+    stats->count = qof_collection_count (col);
+    qof_collection_get_churn (col, &stats->inserted, &stats->removed);
+    stats->index_bytes = qof_collection_index_bytes (col);
+    qof_collection_foreach (col, type_stats_instance_cb, &data);
+    *list = g_list_prepend (*list, stats);
+}
+
+static gint
+type_stats_compare (gconstpointer a, gconstpointer b)
+{
+    return g_strcmp0 (static_cast<const QofBookTypeStats*>(a)->e_type,
+                      static_cast<const QofBookTypeStats*>(b)->e_type);
+}
+
+GList *
+qof_book_get_type_stats (const QofBook *book)
+{
+    GList *list = NULL;
+    g_return_val_if_fail (book, NULL);
+    qof_book_foreach_collection (book, type_stats_collection_cb, &list);
+    return g_list_sort (list, type_stats_compare);
+}
+
+gchar *
+qof_book_type_stats_to_string (const QofBook *book)
+{
+    QofBookTypeStats total {};
+    guint n_strings;
+    guint64 n_refs;
+    gsize string_bytes;
+    GList *list = qof_book_get_type_stats (book);
+    GString *str = g_string_new (NULL);
+
+    auto append_row = [str](const char *type, const QofBookTypeStats *stats)
+    {
+        g_string_append_printf (str, "%-24s %10u %10" G_GUINT64_FORMAT
+                                " %10" G_GUINT64_FORMAT " %12" G_GSIZE_FORMAT
+                                " %12" G_GSIZE_FORMAT " %12" G_GSIZE_FORMAT
+                                "\n", type, stats->count, stats->inserted,
+                                stats->removed, stats->instance_bytes,
+                                stats->kvp_bytes, stats->index_bytes);
+    };
+
+    g_string_append_printf (str, "%-24s %10s %10s %10s %12s %12s %12s\n",
+                            "Type", "Count", "Inserted", "Removed",
+                            "Instances", "KVP", "Index");
+    for (GList *node = list; node; node = node->next)
+    {
+        auto stats = static_cast<QofBookTypeStats*>(node->data);
+        append_row (stats->e_type, stats);
+        total.count += stats->count;
+        total.inserted += stats->inserted;
+        total.removed += stats->removed;
+        total.instance_bytes += stats->instance_bytes;
+        total.kvp_bytes += stats->kvp_bytes;
+        total.index_bytes += stats->index_bytes;
+    }
+    append_row ("Total", &total);
+    g_list_free_full (list, g_free);
+
+    qof_string_cache_get_stats (&n_strings, &n_refs, &string_bytes);
+    g_string_append_printf (str, "String cache: %u strings, %"
+                            G_GUINT64_FORMAT " references, %" G_GSIZE_FORMAT
+                            " bytes\n", n_strings, n_refs, string_bytes);
+    return g_string_free (str, FALSE);
+}
+
+/* ====================================================================== */
+
 void qof_book_mark_closed (QofBook *book)
 {
     if (!book)
@@ -655,11 +922,89 @@ void qof_book_mark_closed (QofBook *book)
     book->book_open = 'n';
 }
 
+/* Returns the named counter, picking up its value from the KVP unless
+ * there's a newer one waiting to be written there; the value can be
+ * changed behind our back by the book options dialog. The caller must
+ * hold the counters' mutex. */
+static QofBookCounter&
+book_counter (QofBook *book, KvpFrame *kvp, const char *counter_name)
+{
+    auto& counter = book->counters->counters[counter_name];
+    if (!counter.dirty)
+    {
+        auto value = kvp->get_slot({"counters", counter_name});
+        counter.value = value ? value->get<int64_t>() : 0;
+    }
+    return counter;
+}
+
+/* Returns the normalized format for the counter, normalizing it again
+ * only when the one in the KVP has changed. The caller must hold the
+ * counters' mutex. */
+static const std::string&
+counter_format (KvpFrame *kvp, const char *counter_name,
+                QofBookCounter& counter)
+{
+    auto value = kvp->get_slot({"counter_formats", counter_name});
+    const char *user_format = value ? value->get<const char*>() : nullptr;
+    if (!user_format)
+        user_format = "";
+    if (!counter.format.empty() && counter.user_format == user_format)
+        return counter.format;
+
+    counter.user_format = user_format;
+    counter.format.clear();
+    if (*user_format)
+    {
+        gchar *error = NULL;
+        gchar *norm_format = qof_book_normalize_counter_format(user_format,
+                                                               &error);
+        if (norm_format)
+        {
+            counter.format = norm_format;
+            g_free(norm_format);
+        }
+        else
+        {
+            PWARN("Invalid counter format string. Format string: '%s' Counter: '%s' Error: '%s')", user_format, counter_name, error);
+            g_free(error);
+        }
+    }
+
+    /* If no (valid) format string was found, use the default format
+     * string */
+    if (counter.format.empty())
+        counter.format = "%.6" PRIi64;
+    return counter.format;
+}
+
+/* Writes the counters changed since the last commit to the KVP. */
+static void
+qof_book_flush_counters (QofBook *book)
+{
+    std::lock_guard<std::recursive_mutex> lock {book->counters->mutex};
+    KvpFrame *kvp = qof_instance_get_slots (QOF_INSTANCE (book));
+    if (!kvp)
+        return;
+    for (auto& item : book->counters->counters)
+    {
+        auto& counter = item.second;
+        if (!counter.dirty)
+            continue;
+        Path path {"counters", item.first};
+        auto value = kvp->get_slot(path);
+        if (value)
+            value->set(counter.value);
+        else
+            delete kvp->set_path(path, new KvpValue(counter.value));
+        counter.dirty = false;
+    }
+}
+
 gint64
 qof_book_get_counter (QofBook *book, const char *counter_name)
 {
     KvpFrame *kvp;
-    KvpValue *value;
 
     if (!book)
     {
@@ -682,27 +1027,14 @@ qof_book_get_counter (QofBook *book, const char *counter_name)
         return -1;
     }
 
-    value = kvp->get_slot({"counters", counter_name});
-    if (value)
-    {
-        /* found it */
-        return value->get<int64_t>();
-    }
-    else
-    {
-        /* New counter */
-        return 0;
-    }
+    std::lock_guard<std::recursive_mutex> lock {book->counters->mutex};
+    return book_counter (book, kvp, counter_name).value;
 }
 
 gchar *
 qof_book_increment_and_format_counter (QofBook *book, const char *counter_name)
 {
     KvpFrame *kvp;
-    KvpValue *value;
-    gint64 counter;
-    gchar* format;
-    gchar* result;
 
     if (!book)
     {
@@ -716,16 +1048,6 @@ qof_book_increment_and_format_counter (QofBook *book, const char *counter_name)
         return NULL;
     }
 
-    /* Get the current counter value from the KVP in the book. */
-    counter = qof_book_get_counter(book, counter_name);
-
-    /* Check if an error occurred */
-    if (counter < 0)
-        return NULL;
-
-    /* Increment the counter */
-    counter++;
-
     /* Get the KVP from the current book */
     kvp = qof_instance_get_slots (QOF_INSTANCE (book));
 
@@ -735,35 +1057,31 @@ qof_book_increment_and_format_counter (QofBook *book, const char *counter_name)
         return NULL;
     }
 
-    /* Save off the new counter */
+    /* Held across the edit so that each caller gets its own number and
+     * the book's edit level isn't changed by two threads at once. */
+    std::lock_guard<std::recursive_mutex> lock {book->counters->mutex};
+    auto& counter = book_counter (book, kvp, counter_name);
+    if (counter.value < 0)
+        return NULL;
+
+    counter.value++;
+    counter.dirty = true;
+
+    /* The new value reaches the KVP when the outermost edit of the book is
+     * committed. */
     qof_book_begin_edit(book);
-    value = new KvpValue(counter);
-    delete kvp->set_path({"counters", counter_name}, value);
     qof_instance_set_dirty (QOF_INSTANCE (book));
     qof_book_commit_edit(book);
 
-    format = qof_book_get_counter_format(book, counter_name);
-
-    if (!format)
-    {
-        PWARN("Cannot get format for counter");
-        return NULL;
-    }
-
     /* Generate a string version of the counter */
-    result = g_strdup_printf(format, counter);
-    g_free (format);
-    return result;
+    return g_strdup_printf(counter_format (kvp, counter_name, counter).c_str(),
+                           counter.value);
 }
 
 char *
 qof_book_get_counter_format(const QofBook *book, const char *counter_name)
 {
     KvpFrame *kvp;
-    const char *user_format = NULL;
-    gchar *norm_format = NULL;
-    KvpValue *value;
-    gchar *error = NULL;
 
     if (!book)
     {
@@ -786,29 +1104,9 @@ qof_book_get_counter_format(const QofBook *book, const char *counter_name)
         return NULL;
     }
 
-    /* Get the format string */
-    value = kvp->get_slot({"counter_formats", counter_name});
-    if (value)
-    {
-        user_format = value->get<const char*>();
-        norm_format = qof_book_normalize_counter_format(user_format, &error);
-        if (!norm_format)
-        {
-            PWARN("Invalid counter format string. Format string: '%s' Counter: '%s' Error: '%s')", user_format, counter_name, error);
-            /* Invalid format string */
-            user_format = NULL;
-            g_free(error);
-        }
-    }
-
-    /* If no (valid) format string was found, use the default format
-     * string */
-    if (!norm_format)
-    {
-        /* Use the default format */
-        norm_format = g_strdup ("%.6" PRIi64);
-    }
-    return norm_format;
+    std::lock_guard<std::recursive_mutex> lock {book->counters->mutex};
+    auto& counter = book->counters->counters[counter_name];
+    return g_strdup (counter_format (kvp, counter_name, counter).c_str());
 }
 
 gchar *
@@ -1175,6 +1473,8 @@ static void noop (QofInstance *inst) {}
 void
 qof_book_commit_edit(QofBook *book)
 {
+    if (qof_instance_get_editlevel (book) <= 1)
+        qof_book_flush_counters (book);
     if (!qof_commit_edit (QOF_INSTANCE(book))) return;
     qof_commit_edit_part2 (&book->inst, commit_err, noop, noop/*lot_free*/);
 }
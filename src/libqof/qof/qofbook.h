@@ -147,6 +147,22 @@ struct _QofBook
      * except that it provides a nice convenience, avoiding a lookup
      * from the session.  Better solutions welcome ... */
     QofBackend *backend;
+
+    /* The counters handed out by qof_book_increment_and_format_counter()
+     * that haven't been written to the KVP yet. */
+    struct QofBookCounters *counters;
+
+    /* Counts the changes committed to objects in the book, see
+     * qof_book_get_generation(). */
+    guint64 generation;
+
+    /* The QofBookSnapshots taken of the book and not yet freed. */
+    GList *snapshots;
+
+    /* Held for reading by other threads while they read the book, and
+     * for writing by its own thread while it changes it, see
+     * qof_book_read_lock(). */
+    GRWLock rw_lock;
 };
 
 struct _QofBookClass
@@ -296,6 +312,33 @@ gboolean qof_book_use_split_action_for_num_field (const QofBook *book);
 /** Is the book shutting down? */
 gboolean qof_book_shutting_down (const QofBook *book);
 
+/** Memory use and churn of the objects of one type in a book.  The
+ * byte counts are estimates: allocator overhead isn't included, and
+ * neither are strings in the shared string cache, which
+ * qof_string_cache_get_stats() reports for the whole process. */
+typedef struct
+{
+    QofIdTypeConst e_type;
+    guint count;            /**< Objects of the type now in the book */
+    guint64 inserted;       /**< Objects added since the book was made */
+    guint64 removed;        /**< Objects removed since the book was made */
+    gsize instance_bytes;   /**< The objects' instance and private structs */
+    gsize kvp_bytes;        /**< Their KVP frames, values and strings */
+    gsize index_bytes;      /**< The collection's GUID index */
+} QofBookTypeStats;
+
+/** Gathers a QofBookTypeStats for every collection in @a book, sorted by
+ * type.  It walks every object, so it's meant for debugging and
+ * capacity planning, not for hot paths.
+ * @return A GList of QofBookTypeStats; free it with
+ * g_list_free_full (list, g_free). */
+GList *qof_book_get_type_stats (const QofBook *book);
+
+/** Formats qof_book_get_type_stats() as a table, with the totals and
+ * the string cache's figures at the bottom.
+ * @return A newly allocated string; g_free() it. */
+gchar *qof_book_type_stats_to_string (const QofBook *book);
+
 /** qof_book_not_saved() returns the value of the session_dirty flag,
  * set when changes to any object in the book are committed
  * (qof_backend->commit_edit has been called) and the backend hasn't
@@ -329,6 +372,60 @@ time64 qof_book_get_session_dirty_time(const QofBook *book);
  */
 void qof_book_set_dirty_cb(QofBook *book, QofBookDirtyCB cb, gpointer user_data);
 
+/** The book's generation goes up by one with every change committed to
+ *    an object in it. An object remembers the generation of its last
+ *    change, see qof_instance_get_generation().
+ */
+guint64 qof_book_get_generation (const QofBook *book);
+
+/** @name Sharing a book between threads
+
+A book belongs to the thread which loaded it, normally the GUI thread,
+which alone changes it. Other threads may read it at the same time as
+each other: looking objects up by GUID, reading accounts, transactions,
+splits and prices and their balances, and running queries, each thread
+with queries of its own. They do so holding the book's read lock.
+
+While it lets such readers run, the book's own thread holds the write
+lock around each change it makes, from the begin edit to the commit of
+all objects involved. It needs no lock to read.
+
+What reading fills in lazily, as an account's sorted splits, running
+balances and full name, is guarded by the engine so readers can share it.
+@{ */
+void qof_book_read_lock (QofBook *book);
+void qof_book_read_unlock (QofBook *book);
+void qof_book_write_lock (QofBook *book);
+void qof_book_write_unlock (QofBook *book);
+/** @} */
+
+/** A snapshot marks the state of a book at some point and gathers the
+ *    objects changed since. Work which reads the book a piece at a time,
+ *    so that editing goes on in between, can tell from it whether what
+ *    it read still holds, and redo just the changed objects if not.
+ */
+typedef struct QofBookSnapshot QofBookSnapshot;
+
+/** Take a snapshot of book. Free it with qof_book_snapshot_free(). */
+QofBookSnapshot *qof_book_snapshot_new (QofBook *book);
+void qof_book_snapshot_free (QofBookSnapshot *snapshot);
+
+/** The generation of the book the snapshot was taken at. */
+guint64 qof_book_snapshot_get_generation (const QofBookSnapshot *snapshot);
+
+/** TRUE if nothing in the book has changed since the snapshot was taken.
+ *    Once the book is destroyed no snapshot of it is current. */
+gboolean qof_book_snapshot_is_current (const QofBookSnapshot *snapshot);
+
+/** TRUE if the object with guid was changed, or destroyed, since the
+ *    snapshot was taken. */
+gboolean qof_book_snapshot_changed (const QofBookSnapshot *snapshot,
+                                    const GncGUID *guid);
+
+/** The GncGUIDs of the objects changed since the snapshot was taken.
+ *    Free the list, but not the GUIDs, which belong to the snapshot. */
+GList *qof_book_snapshot_get_changed (const QofBookSnapshot *snapshot);
+
 /** This will get the named counter for this book. The return value is
  *    -1 on error or the current value of the counter.
  */
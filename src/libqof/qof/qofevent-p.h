@@ -31,7 +31,12 @@
 typedef struct
 {
     QofEventHandler handler;
+    QofEventBatchHandler batch_handler;
     gpointer user_data;
+    /* The events and entity types the handler wants; types is NULL when
+     * it wants all of them. */
+    QofEventId event_mask;
+    gchar **types;
 
     gint handler_id;
 } HandlerInfo;
@@ -39,4 +44,8 @@ typedef struct
 /* generates an event even when events are suspended! */
 void qof_event_force (QofInstance *entity, QofEventId event_id, gpointer event_data);
 
+/* The number of events qof_event_gen dropped because events were
+ * suspended, for caches which must know whether they missed any. */
+guint64 qof_event_get_dropped_count (void);
+
 #endif
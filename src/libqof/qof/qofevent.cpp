@@ -32,12 +32,30 @@ extern "C"
 #include "qof.h"
 #include "qofevent-p.h"
 
+#include <mutex>
+
 /* Static Variables ************************************************/
+/* Sessions on several threads share the handlers, so everything below
+ * is used with event_lock held.  It is recursive because handlers
+ * generate events and register and unregister handlers themselves. */
+static std::recursive_mutex event_lock;
 static guint   suspend_counter   = 0;
+static guint64 dropped_events    = 0;
 static gint    next_handler_id   = 1;
 static guint   handler_run_level = 0;
 static guint   pending_deletes   = 0;
 static GList   *handlers  =   NULL;
+/* The handlers registered for particular entity types, by type. They're
+ * also in handlers, which owns them. */
+static GHashTable *typed_handlers = NULL;
+static guint   plain_handlers    = 0;
+static guint64 handlers_called   = 0;
+static guint64 handlers_skipped  = 0;
+static guint   batch_handlers    = 0;
+static guint   batch_level       = 0;
+/* The entries of the open batch, and the index of each entity's entry. */
+static GArray     *batch_events  = NULL;
+static GHashTable *batch_index   = NULL;
 
 /* This static indicates the debugging module that this .o belongs to.  */
 static QofLogModule log_module = QOF_MOD_ENGINE;
@@ -76,10 +94,20 @@ find_next_handler_id(void)
 gint
 qof_event_register_handler (QofEventHandler handler, gpointer user_data)
 {
+    return qof_event_register_filtered_handler (handler, user_data, NULL, 0);
+}
+
+gint
+qof_event_register_filtered_handler (QofEventHandler handler,
+                                     gpointer user_data,
+                                     const QofIdType *types,
+                                     QofEventId event_mask)
+{
+    std::lock_guard<std::recursive_mutex> guard (event_lock);
     HandlerInfo *hi;
     gint handler_id;
 
-    ENTER ("(handler=%p, data=%p)", handler, user_data);
+    ENTER ("(handler=%p, data=%p, mask=%x)", handler, user_data, event_mask);
 
     /* sanity check */
     if (!handler)
@@ -97,8 +125,81 @@ qof_event_register_handler (QofEventHandler handler, gpointer user_data)
     hi->handler = handler;
     hi->user_data = user_data;
     hi->handler_id = handler_id;
+    hi->event_mask = event_mask ? event_mask : ~0;
+
+    if (types && *types)
+    {
+        hi->types = g_strdupv (const_cast<gchar**>(types));
+        if (!typed_handlers)
+            typed_handlers = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                    g_free, NULL);
+        for (auto type = hi->types; *type; ++type)
+        {
+            auto list = static_cast<GList*>(g_hash_table_lookup (typed_handlers,
+                                                                 *type));
+            g_hash_table_insert (typed_handlers, g_strdup (*type),
+                                 g_list_prepend (list, hi));
+        }
+    }
 
     handlers = g_list_prepend (handlers, hi);
+    plain_handlers++;
+    LEAVE ("(handler=%p, data=%p) handler_id=%d", handler, user_data, handler_id);
+    return handler_id;
+}
+
+/* Unlink a handler from the lists and free it. */
+static void
+qof_event_free_handler (GList *node)
+{
+    HandlerInfo *hi = static_cast<HandlerInfo*>(node->data);
+
+    if (hi->types)
+    {
+        for (auto type = hi->types; *type; ++type)
+        {
+            auto list = static_cast<GList*>(g_hash_table_lookup (typed_handlers,
+                                                                 *type));
+            list = g_list_remove (list, hi);
+            if (list)
+                g_hash_table_insert (typed_handlers, g_strdup (*type), list);
+            else
+                g_hash_table_remove (typed_handlers, *type);
+        }
+        g_strfreev (hi->types);
+    }
+    handlers = g_list_remove_link (handlers, node);
+    g_list_free_1 (node);
+    g_free (hi);
+}
+
+gint
+qof_event_register_batch_handler (QofEventBatchHandler handler,
+                                  gpointer user_data)
+{
+    std::lock_guard<std::recursive_mutex> guard (event_lock);
+    HandlerInfo *hi;
+    gint handler_id;
+
+    ENTER ("(handler=%p, data=%p)", handler, user_data);
+
+    /* sanity check */
+    if (!handler)
+    {
+        PERR ("no handler specified");
+        return 0;
+    }
+
+    handler_id = find_next_handler_id();
+
+    hi = g_new0 (HandlerInfo, 1);
+
+    hi->batch_handler = handler;
+    hi->user_data = user_data;
+    hi->handler_id = handler_id;
+
+    handlers = g_list_prepend (handlers, hi);
+    batch_handlers++;
     LEAVE ("(handler=%p, data=%p) handler_id=%d", handler, user_data, handler_id);
     return handler_id;
 }
@@ -106,6 +207,7 @@ qof_event_register_handler (QofEventHandler handler, gpointer user_data)
 void
 qof_event_unregister_handler (gint handler_id)
 {
+    std::lock_guard<std::recursive_mutex> guard (event_lock);
     GList *node;
 
     ENTER ("(handler_id=%d)", handler_id);
@@ -124,15 +226,22 @@ qof_event_unregister_handler (gint handler_id)
         if (hi->handler)
             LEAVE ("(handler_id=%d) handler=%p data=%p", handler_id,
                    hi->handler, hi->user_data);
+        else if (hi->batch_handler)
+            LEAVE ("(handler_id=%d) batch handler=%p data=%p", handler_id,
+                   hi->batch_handler, hi->user_data);
+
+        if (hi->batch_handler)
+            batch_handlers--;
+        else if (hi->handler)
+            plain_handlers--;
 
         /* safety -- clear the handler in case we're running events now */
         hi->handler = NULL;
+        hi->batch_handler = NULL;
 
         if (handler_run_level == 0)
         {
-            handlers = g_list_remove_link (handlers, node);
-            g_list_free_1 (node);
-            g_free (hi);
+            qof_event_free_handler (node);
         }
         else
         {
@@ -148,6 +257,7 @@ qof_event_unregister_handler (gint handler_id)
 void
 qof_event_suspend (void)
 {
+    std::lock_guard<std::recursive_mutex> guard (event_lock);
     suspend_counter++;
 
     if (suspend_counter == 0)
@@ -159,6 +269,7 @@ qof_event_suspend (void)
 void
 qof_event_resume (void)
 {
+    std::lock_guard<std::recursive_mutex> guard (event_lock);
     if (suspend_counter == 0)
     {
         PERR ("suspend counter underflow");
@@ -168,12 +279,134 @@ qof_event_resume (void)
     suspend_counter--;
 }
 
+/* If we're the outermost event runner and we have pending deletes
+ * then go delete the handlers now.
+ */
+static void
+qof_event_delete_pending_handlers (void)
+{
+    GList *node;
+    GList *next_node = NULL;
+
+    if (handler_run_level != 0 || !pending_deletes)
+        return;
+
+    for (node = handlers; node; node = next_node)
+    {
+        HandlerInfo *hi = static_cast<HandlerInfo*>(node->data);
+        next_node = node->next;
+        if (hi->handler == NULL && hi->batch_handler == NULL)
+        {
+            /* remove this node from the lists, then free this node */
+            qof_event_free_handler (node);
+        }
+    }
+    pending_deletes = 0;
+}
+
+static void
+qof_event_deliver_batch (const QofEventBatchEntry *events, guint n_events)
+{
+    GList *node;
+    GList *next_node = NULL;
+
+    if (!n_events)
+        return;
+
+    handler_run_level++;
+    for (node = handlers; node; node = next_node)
+    {
+        HandlerInfo *hi = static_cast<HandlerInfo*>(node->data);
+
+        next_node = node->next;
+        if (hi->batch_handler)
+        {
+            PINFO("id=%d hi=%p han=%p events=%u", hi->handler_id, hi,
+                  hi->batch_handler, n_events);
+            hi->batch_handler (events, n_events, hi->user_data);
+        }
+    }
+    handler_run_level--;
+
+    qof_event_delete_pending_handlers ();
+}
+
+/* Hand the open batch to the batch handlers. Events the handlers generate
+ * go into a new batch; they'd be lost if they went into this one. */
+static void
+qof_event_flush_batch (void)
+{
+    GArray *events = batch_events;
+
+    if (!events || !events->len)
+        return;
+
+    batch_events = NULL;
+    g_hash_table_remove_all (batch_index);
+    qof_event_deliver_batch (&g_array_index (events, QofEventBatchEntry, 0),
+                             events->len);
+    g_array_free (events, TRUE);
+}
+
+static void
+qof_event_queue (QofInstance *entity, QofEventId event_id)
+{
+    gpointer index;
+
+    if (!batch_events)
+        batch_events = g_array_new (FALSE, FALSE, sizeof (QofEventBatchEntry));
+    if (!batch_index)
+        batch_index = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+    /* The index is stored plus one so that it can't be mistaken for a
+     * missing entry. */
+    index = g_hash_table_lookup (batch_index, entity);
+    if (index)
+    {
+        g_array_index (batch_events, QofEventBatchEntry,
+                       GPOINTER_TO_UINT (index) - 1).event_type |= event_id;
+    }
+    else
+    {
+        QofEventBatchEntry entry = { entity, event_id };
+        g_array_append_val (batch_events, entry);
+        g_hash_table_insert (batch_index, entity,
+                             GUINT_TO_POINTER (batch_events->len));
+    }
+
+    if (event_id & QOF_EVENT_DESTROY)
+        qof_event_flush_batch ();
+}
+
+void
+qof_event_begin_batch (void)
+{
+    std::lock_guard<std::recursive_mutex> guard (event_lock);
+    batch_level++;
+}
+
+void
+qof_event_end_batch (void)
+{
+    std::lock_guard<std::recursive_mutex> guard (event_lock);
+    if (batch_level == 0)
+    {
+        PERR ("batch level underflow");
+        return;
+    }
+
+    if (--batch_level == 0)
+        qof_event_flush_batch ();
+}
+
 static void
 qof_event_generate_internal (QofInstance *entity, QofEventId event_id,
                              gpointer event_data)
 {
+    static guint64 events_generated = 0;
     GList *node;
     GList *next_node = NULL;
+    guint called;
 
     g_return_if_fail(entity);
 
@@ -187,44 +420,71 @@ qof_event_generate_internal (QofInstance *entity, QofEventId event_id,
     }
 
     handler_run_level++;
+    called = 0;
+    /* First the handlers for this type of entity, then the ones for all
+     * types. */
+    if (typed_handlers && entity->e_type)
+        node = static_cast<GList*>(g_hash_table_lookup (typed_handlers,
+                                                        entity->e_type));
+    else
+        node = NULL;
+    for (; node; node = next_node)
+    {
+        HandlerInfo *hi = static_cast<HandlerInfo*>(node->data);
+
+        next_node = node->next;
+        if (hi->handler && (hi->event_mask & event_id))
+        {
+            PINFO("id=%d hi=%p han=%p data=%p", hi->handler_id, hi,
+                  hi->handler, event_data);
+            hi->handler (entity, event_id, hi->user_data, event_data);
+            called++;
+        }
+    }
     for (node = handlers; node; node = next_node)
     {
         HandlerInfo *hi = static_cast<HandlerInfo*>(node->data);
 
         next_node = node->next;
-        if (hi->handler)
+        if (hi->handler && !hi->types && (hi->event_mask & event_id))
         {
             PINFO("id=%d hi=%p han=%p data=%p", hi->handler_id, hi,
                   hi->handler, event_data);
             hi->handler (entity, event_id, hi->user_data, event_data);
+            called++;
         }
     }
     handler_run_level--;
 
-    /* If we're the outermost event runner and we have pending deletes
-     * then go delete the handlers now.
-     */
-    if (handler_run_level == 0 && pending_deletes)
+    /* Handlers registering or unregistering others can make these a bit
+     * off, which is fine for a statistic. */
+    handlers_called += called;
+    handlers_skipped += plain_handlers > called ? plain_handlers - called : 0;
+    if ((++events_generated & 0xfff) == 0)
+        DEBUG ("event handlers: %" G_GUINT64_FORMAT " called, %"
+               G_GUINT64_FORMAT " skipped by their filters", handlers_called,
+               handlers_skipped);
+
+    qof_event_delete_pending_handlers ();
+
+    if (!batch_handlers)
+        return;
+
+    if (batch_level)
     {
-        for (node = handlers; node; node = next_node)
-        {
-            HandlerInfo *hi = static_cast<HandlerInfo*>(node->data);
-            next_node = node->next;
-            if (hi->handler == NULL)
-            {
-                /* remove this node from the list, then free this node */
-                handlers = g_list_remove_link (handlers, node);
-                g_list_free_1 (node);
-                g_free (hi);
-            }
-        }
-        pending_deletes = 0;
+        qof_event_queue (entity, event_id);
+    }
+    else
+    {
+        QofEventBatchEntry entry = { entity, event_id };
+        qof_event_deliver_batch (&entry, 1);
     }
 }
 
 void
 qof_event_force (QofInstance *entity, QofEventId event_id, gpointer event_data)
 {
+    std::lock_guard<std::recursive_mutex> guard (event_lock);
     if (!entity)
         return;
 
@@ -234,13 +494,24 @@ qof_event_force (QofInstance *entity, QofEventId event_id, gpointer event_data)
 void
 qof_event_gen (QofInstance *entity, QofEventId event_id, gpointer event_data)
 {
+    std::lock_guard<std::recursive_mutex> guard (event_lock);
     if (!entity)
         return;
 
     if (suspend_counter)
+    {
+        dropped_events++;
         return;
+    }
 
     qof_event_generate_internal (entity, event_id, event_data);
 }
 
+guint64
+qof_event_get_dropped_count (void)
+{
+    std::lock_guard<std::recursive_mutex> guard (event_lock);
+    return dropped_events;
+}
+
 /* =========================== END OF FILE ======================= */
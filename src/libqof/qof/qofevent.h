@@ -89,6 +89,50 @@ for future libqof1 or libqof2 usage.
 typedef void (*QofEventHandler) (QofInstance *ent,  QofEventId event_type,
                                  gpointer handler_data, gpointer event_data);
 
+/** \brief Register a handler for only some events of some entity types.
+ *
+ * The handler is called exactly as one registered with
+ * qof_event_register_handler() would be, but only for the events it asked
+ * for. Events of other types never reach it, so there's no need for it to
+ * check and return early.
+ *
+ * @param handler:   handler to register
+ * @param handler_data: data provided when handler is invoked
+ * @param types:     NULL-terminated array of the entity types, e.g.
+ * GNC_ID_SPLIT, the handler is interested in, or NULL for all types.
+ * @param event_mask: The events the handler is interested in, or 0 for all.
+ *
+ * @return id identifying handler, to be passed to
+ * qof_event_unregister_handler()
+ */
+gint qof_event_register_filtered_handler (QofEventHandler handler,
+                                          gpointer handler_data,
+                                          const QofIdType *types,
+                                          QofEventId event_mask);
+
+/** \brief One entity's events in a batch.
+ *
+ * event_type is the bitwise OR of all the distinct events the entity
+ * raised while the batch was open.
+ */
+typedef struct
+{
+    QofInstance *entity;
+    QofEventId event_type;
+} QofEventBatchEntry;
+
+/** \brief Handler invoked with a batch of events.
+ *
+ * Each entity appears at most once, in the order in which it first raised
+ * an event. The per-event event_data isn't delivered.
+ *
+ * @param events:       The entries of the batch.
+ * @param n_events:     The number of entries.
+ * @param handler_data: data supplied when handler was registered.
+ */
+typedef void (*QofEventBatchHandler) (const QofEventBatchEntry *events,
+                                      guint n_events, gpointer handler_data);
+
 /** \brief Register a handler for events.
  *
  * @param handler:   handler to register
@@ -98,6 +142,27 @@ typedef void (*QofEventHandler) (QofInstance *ent,  QofEventId event_type,
  */
 gint qof_event_register_handler (QofEventHandler handler, gpointer handler_data);
 
+/** \brief Register a handler for batches of events.
+ *
+ * Outside of qof_event_begin_batch() and qof_event_end_batch() the handler
+ * is called with a batch of one entry for every generated event, right
+ * after the ordinary handlers. Inside them, the events are collected and
+ * delivered only once the outermost batch ends, one entry per entity,
+ * so that a handler which only has to refresh what changed does it once
+ * per entity instead of once per event.
+ *
+ * An entity being destroyed can't be kept around for later, so a
+ * QOF_EVENT_DESTROY event delivers the batch collected so far at once.
+ *
+ * @param handler:   handler to register
+ * @param handler_data: data provided when handler is invoked
+ *
+ * @return id identifying handler, to be passed to
+ * qof_event_unregister_handler()
+ */
+gint qof_event_register_batch_handler (QofEventBatchHandler handler,
+                                       gpointer handler_data);
+
 /** \brief Unregister an event handler.
  *
  * @param handler_id: the id of the handler to unregister
@@ -139,6 +204,18 @@ void qof_event_suspend (void);
 /** Resume engine event generation. */
 void qof_event_resume (void);
 
+/** \brief Start collecting events for the batch handlers.
+ *
+ * Unlike qof_event_suspend() this doesn't lose any events, and ordinary
+ * handlers keep getting them as they happen. Batches nest: an equal number
+ * of calls to qof_event_end_batch() must be made.
+ */
+void qof_event_begin_batch (void);
+
+/** \brief End a batch, delivering the collected events to the batch
+ * handlers if it was the outermost one. */
+void qof_event_end_batch (void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -33,6 +33,7 @@ extern "C"
 #include "qof.h"
 #include "qofid-p.h"
 #include "qofinstance-p.h"
+#include "gnc-guid-map.hpp"
 
 static QofLogModule log_module = QOF_MOD_ENGINE;
 
@@ -41,8 +42,11 @@ struct QofCollection_s
     QofIdType    e_type;
     gboolean     is_dirty;
 
-    GHashTable * hash_of_entities;
+    GncGUIDMap * map_of_entities;
     gpointer     data;       /* place where object class can hang arbitrary data */
+
+    guint64      n_inserted;
+    guint64      n_removed;
 };
 
 /* =============================================================== */
@@ -53,7 +57,7 @@ qof_collection_new (QofIdType type)
     QofCollection *col;
     col = g_new0(QofCollection, 1);
     col->e_type = static_cast<QofIdType>(CACHE_INSERT (type));
-    col->hash_of_entities = guid_hash_table_new();
+    col->map_of_entities = new GncGUIDMap;
     col->data = NULL;
     return col;
 }
@@ -62,9 +66,9 @@ void
 qof_collection_destroy (QofCollection *col)
 {
     CACHE_REMOVE (col->e_type);
-    g_hash_table_destroy(col->hash_of_entities);
+    delete col->map_of_entities;
     col->e_type = NULL;
-    col->hash_of_entities = NULL;
+    col->map_of_entities = NULL;
     col->data = NULL;   /** XXX there should be a destroy notifier for this */
     g_free (col);
 }
@@ -78,6 +82,32 @@ qof_collection_get_type (const QofCollection *col)
     return col->e_type;
 }
 
+void
+qof_collection_get_churn (const QofCollection *col, guint64 *inserted,
+                          guint64 *removed)
+{
+    g_return_if_fail (col);
+    if (inserted)
+        *inserted = col->n_inserted;
+    if (removed)
+        *removed = col->n_removed;
+}
+
+gsize
+qof_collection_index_bytes (const QofCollection *col)
+{
+    g_return_val_if_fail (col, 0);
+    return sizeof (*col) + sizeof (GncGUIDMap) +
+        col->map_of_entities->memory_used ();
+}
+
+void
+qof_collection_reserve (QofCollection *col, guint count)
+{
+    g_return_if_fail (col);
+    col->map_of_entities->reserve (count);
+}
+
 /* =============================================================== */
 
 void
@@ -90,7 +120,8 @@ qof_collection_remove_entity (QofInstance *ent)
     col = qof_instance_get_collection(ent);
     if (!col) return;
     guid = qof_instance_get_guid(ent);
-    g_hash_table_remove (col->hash_of_entities, guid);
+    if (col->map_of_entities->remove (*guid))
+        ++col->n_removed;
     qof_instance_set_collection(ent, NULL);
 }
 
@@ -104,7 +135,8 @@ qof_collection_insert_entity (QofCollection *col, QofInstance *ent)
     if (guid_equal(guid, guid_null())) return;
     g_return_if_fail (col->e_type == ent->e_type);
     qof_collection_remove_entity (ent);
-    g_hash_table_insert (col->hash_of_entities, (gpointer)guid, ent);
+    col->map_of_entities->insert (*guid, ent);
+    ++col->n_inserted;
     qof_instance_set_collection(ent, col);
 }
 
@@ -130,7 +162,8 @@ qof_collection_add_entity (QofCollection *coll, QofInstance *ent)
     {
         return FALSE;
     }
-    g_hash_table_insert (coll->hash_of_entities, (gpointer)guid, ent);
+    coll->map_of_entities->insert (*guid, ent);
+    ++coll->n_inserted;
     return TRUE;
 }
 
@@ -217,8 +250,7 @@ qof_collection_lookup_entity (const QofCollection *col, const GncGUID * guid)
     QofInstance *ent;
     g_return_val_if_fail (col, NULL);
     if (guid == NULL) return NULL;
-    ent = static_cast<QofInstance*>(g_hash_table_lookup (col->hash_of_entities,
-							 guid));
+    ent = static_cast<QofInstance*>(col->map_of_entities->lookup (*guid));
     return ent;
 }
 
@@ -246,7 +278,7 @@ qof_collection_count (const QofCollection *col)
 {
     guint c;
 
-    c = g_hash_table_size(col->hash_of_entities);
+    c = col->map_of_entities->size();
     return c;
 }
 
@@ -303,40 +335,33 @@ qof_collection_set_data (QofCollection *col, gpointer user_data)
 
 /* =============================================================== */
 
-struct _iterate
-{
-    QofInstanceForeachCB      fcn;
-    gpointer                data;
-};
-
-static void
-foreach_cb (gpointer item, gpointer arg)
-{
-    struct _iterate *iter = static_cast<_iterate*>(arg);
-    QofInstance *ent = static_cast<QofInstance*>(item);
-
-    iter->fcn (ent, iter->data);
-}
-
 void
 qof_collection_foreach (const QofCollection *col, QofInstanceForeachCB cb_func,
                         gpointer user_data)
 {
-    struct _iterate iter;
-    GList *entries;
-
     g_return_if_fail (col);
     g_return_if_fail (cb_func);
 
-    iter.fcn = cb_func;
-    iter.data = user_data;
+    PINFO("Hash Table size of %s before is %" G_GSIZE_FORMAT, col->e_type,
+          col->map_of_entities->size());
 
-    PINFO("Hash Table size of %s before is %d", col->e_type, g_hash_table_size(col->hash_of_entities));
+    /* Walk a snapshot, so that the callback may add or remove entities. */
+    for (auto entry : col->map_of_entities->values())
+        cb_func (static_cast<QofInstance*>(entry), user_data);
 
-    entries = g_hash_table_get_values (col->hash_of_entities);
-    g_list_foreach (entries, foreach_cb, &iter);
-    g_list_free (entries);
+    PINFO("Hash Table size of %s after is %" G_GSIZE_FORMAT, col->e_type,
+          col->map_of_entities->size());
+}
 
-    PINFO("Hash Table size of %s after is %d", col->e_type, g_hash_table_size(col->hash_of_entities));
+QofInstance *
+qof_collection_next_entity (const QofCollection *col, gsize *cursor)
+{
+    g_return_val_if_fail (col, NULL);
+    g_return_val_if_fail (cursor, NULL);
+
+    std::size_t slot = *cursor;
+    auto ent = static_cast<QofInstance*>(col->map_of_entities->next (slot));
+    *cursor = slot;
+    return ent;
 }
 /* =============================================================== */
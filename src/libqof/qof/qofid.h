@@ -160,6 +160,19 @@ void qof_collection_destroy (QofCollection *col);
 /** return the type that the collection stores */
 QofIdType qof_collection_get_type (const QofCollection *);
 
+/** How many entities have been added to and removed from the collection
+ * since it was created. */
+void qof_collection_get_churn (const QofCollection *col, guint64 *inserted,
+                               guint64 *removed);
+
+/** Approximate bytes used by the collection's index of its entities,
+ * not counting the entities themselves. */
+gsize qof_collection_index_bytes (const QofCollection *col);
+
+/** Make room in the collection's index for count entities, for a loader
+ * which knows how many are coming. */
+void qof_collection_reserve (QofCollection *col, guint count);
+
 /** Find the entity going only from its guid */
 /*@ dependent @*/
 QofInstance * qof_collection_lookup_entity (const QofCollection *, const GncGUID *);
@@ -171,6 +184,14 @@ typedef void (*QofInstanceForeachCB) (QofInstance *, gpointer user_data);
 void qof_collection_foreach (const QofCollection *, QofInstanceForeachCB,
                              gpointer user_data);
 
+/** Walk the entities of a collection without copying them, unlike
+ * qof_collection_foreach(). Start with *cursor set to 0 and call again
+ * until it returns NULL. The collection must not gain or lose entities
+ * during the walk.
+ * @return The next entity, or NULL when there are no more. */
+QofInstance * qof_collection_next_entity (const QofCollection *col,
+                                          gsize *cursor);
+
 /** Store and retreive arbitrary object-defined data
  *
  * XXX We need to add a callback for when the collection is being
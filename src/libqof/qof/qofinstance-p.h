@@ -31,6 +31,7 @@
 #define QOF_INSTANCE_P_H
 
 #include "qofinstance.h"
+#include "gnc-numeric.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -87,6 +88,10 @@ void qof_instance_set_dirty(QofInstance* inst);
 
 /* reset the dirty flag */
 void qof_instance_mark_clean (QofInstance *);
+
+/** Clear or set the flag saying the instance has never been committed,
+ *  for instances recreated from data that is already saved. */
+void qof_instance_set_infant (gpointer inst, gboolean infant);
 /** Get the version number on this instance.  The version number is
  *  used to manage multi-user updates. */
 gint32 qof_instance_get_version (gconstpointer inst);
@@ -130,6 +135,55 @@ void qof_instance_set_kvp (QofInstance *inst, const gchar *key, const GValue *va
  */
 void qof_instance_get_kvp (const QofInstance *inst, const gchar *key, GValue
 *value);
+/** Like qof_instance_set_kvp(), but for a path which the caller has
+ * already split into its keys, so that it needn't be parsed each time.
+ * @param inst: The QofInstance on which to set the value.
+ * @param value: A GValue containing an item of a type which KvpValue knows
+ * how to store, or NULL to remove the slot.
+ * @param n_keys: The number of keys.
+ * @param keys: The keys of the frames leading to the slot, then of the slot
+ * itself. None may contain '/'.
+ */
+void qof_instance_set_kvp_keys (QofInstance *inst, const GValue *value,
+                                guint n_keys, const gchar * const *keys);
+/** Like qof_instance_get_kvp(), but for a path which the caller has
+ * already split into its keys. Walks the frames without allocating.
+ * @param inst: The QofInstance
+ * @param value: A GValue into which to store the value of the slot. It will be
+ *               set to the correct type.
+ * @param n_keys: The number of keys.
+ * @param keys: The keys of the frames leading to the slot, then of the slot
+ * itself. None may contain '/'.
+ */
+void qof_instance_get_kvp_keys (const QofInstance *inst, GValue *value,
+                                guint n_keys, const gchar * const *keys);
+/** Typed getters for the value at a path which the caller has already
+ * split into its keys, as for qof_instance_get_kvp_keys(). Unlike the
+ * GValue getters they neither copy nor allocate: strings and GUIDs are
+ * borrowed from the slot and are only valid until it is changed or the
+ * instance destroyed. A slot which is missing or holds another type is
+ * reported as not found.
+ * @param inst: The QofInstance
+ * @param n_keys: The number of keys.
+ * @param keys: The keys of the frames leading to the slot, then of the slot
+ * itself. None may contain '/'.
+ * @{
+ */
+/** @param value: Set to the numeric in the slot, if there is one.
+ * @return TRUE if the slot holds a numeric. */
+gboolean qof_instance_get_kvp_numeric (const QofInstance *inst, gnc_numeric *value,
+                                       guint n_keys, const gchar * const *keys);
+/** @param value: Set to the integer in the slot, if there is one.
+ * @return TRUE if the slot holds an integer. */
+gboolean qof_instance_get_kvp_int64 (const QofInstance *inst, gint64 *value,
+                                     guint n_keys, const gchar * const *keys);
+/** @return The string in the slot, or NULL. */
+const char *qof_instance_get_kvp_string (const QofInstance *inst,
+                                         guint n_keys, const gchar * const *keys);
+/** @return The GUID in the slot, or NULL. */
+const GncGUID *qof_instance_get_kvp_guid (const QofInstance *inst,
+                                          guint n_keys, const gchar * const *keys);
+/** @} */
 /** @} Close out the DOxygen ingroup */
 /* Functions to isolate the KVP mechanism inside QOF for cases where
 GValue * operations won't work.
@@ -104,6 +104,9 @@ typedef struct QofInstancePrivate
     gint32 version;
     guint32 version_check;  /* data aging timestamp */
 
+    /* The book's generation as of the last committed change */
+    guint64 generation;
+
     /* -------------------------------------------------------------- */
     /* Backend private expansion data */
     guint32  idata;   /* used by the sql backend for kvp management */
@@ -313,6 +316,40 @@ qof_instance_init_data (QofInstance *inst, QofIdType type, QofBook *book)
     qof_collection_insert_entity (col, inst);
 }
 
+void
+qof_instance_init_data_with_guid (QofInstance *inst, QofIdType type,
+                                  QofBook *book, const GncGUID *guid)
+{
+    QofInstancePrivate *priv;
+    QofCollection *col;
+
+    g_return_if_fail(QOF_IS_INSTANCE(inst));
+    g_return_if_fail(guid);
+    priv = GET_PRIVATE(inst);
+    g_return_if_fail(!priv->book);
+
+    col = qof_book_get_collection (book, type);
+    g_return_if_fail(col != NULL);
+
+    if (guid_equal (guid, guid_null ()) ||
+        qof_collection_lookup_entity (col, guid) != NULL)
+    {
+        qof_instance_init_data (inst, type, book);
+        return;
+    }
+    if (g_strcmp0(qof_collection_get_type(col), type))
+    {
+        PERR ("attempt to insert \"%s\" into \"%s\"", type,
+              qof_collection_get_type(col));
+        return;
+    }
+
+    priv->book = book;
+    inst->e_type = static_cast<QofIdType>(CACHE_INSERT (type));
+    priv->guid = *guid;
+    qof_collection_insert_entity (col, inst);
+}
+
 static void
 qof_instance_dispose (GObject *instp)
 {
@@ -719,6 +756,13 @@ qof_instance_set_dirty(QofInstance* inst)
     priv->dirty = TRUE;
 }
 
+guint64
+qof_instance_get_generation (gconstpointer inst)
+{
+    g_return_val_if_fail(QOF_IS_INSTANCE(inst), 0);
+    return GET_PRIVATE(inst)->generation;
+}
+
 gboolean
 qof_instance_get_infant(const QofInstance *inst)
 {
@@ -726,6 +770,13 @@ qof_instance_get_infant(const QofInstance *inst)
     return GET_PRIVATE(inst)->infant;
 }
 
+void
+qof_instance_set_infant (gpointer inst, gboolean infant)
+{
+    g_return_if_fail(QOF_IS_INSTANCE(inst));
+    GET_PRIVATE(inst)->infant = infant;
+}
+
 gint32
 qof_instance_get_version (gconstpointer inst)
 {
@@ -1009,6 +1060,7 @@ qof_commit_edit_part2(QofInstance *inst,
         !(priv->infant && priv->do_free)) {
       qof_collection_mark_dirty(priv->collection);
       qof_book_mark_session_dirty(priv->book);
+      priv->generation = qof_book_note_change (priv->book, inst);
     }
 
     /* See if there's a backend.  If there is, invoke it. */
@@ -1066,10 +1118,10 @@ qof_instance_set_kvp (QofInstance *inst, const gchar *key, const GValue *value)
     delete inst->kvp_data->set_path(key, kvp_value_from_gvalue(value));
 }
 
-void
-qof_instance_get_kvp (const QofInstance *inst, const gchar *key, GValue *value)
+static void
+kvp_value_to_gvalue (KvpValue *kval, GValue *value)
 {
-    auto temp = gvalue_from_kvp_value (inst->kvp_data->get_slot(key));
+    auto temp = gvalue_from_kvp_value (kval);
     if (G_IS_VALUE (temp))
     {
         if (G_IS_VALUE (value))
@@ -1080,6 +1132,73 @@ qof_instance_get_kvp (const QofInstance *inst, const gchar *key, GValue *value)
     }
 }
 
+void
+qof_instance_get_kvp (const QofInstance *inst, const gchar *key, GValue *value)
+{
+    kvp_value_to_gvalue (inst->kvp_data->get_slot(key), value);
+}
+
+void
+qof_instance_set_kvp_keys (QofInstance *inst, const GValue *value,
+                           guint n_keys, const gchar * const *keys)
+{
+    delete inst->kvp_data->set_path(keys, n_keys, kvp_value_from_gvalue(value));
+}
+
+void
+qof_instance_get_kvp_keys (const QofInstance *inst, GValue *value,
+                           guint n_keys, const gchar * const *keys)
+{
+    kvp_value_to_gvalue (inst->kvp_data->get_slot(keys, n_keys), value);
+}
+
+static KvpValue *
+kvp_slot_of_type (const QofInstance *inst, guint n_keys,
+                  const gchar * const *keys, KvpValue::Type type)
+{
+    g_return_val_if_fail (inst != nullptr && inst->kvp_data != nullptr, nullptr);
+    auto slot = inst->kvp_data->get_slot(keys, n_keys);
+    if (slot == nullptr || slot->get_type() != type)
+        return nullptr;
+    return slot;
+}
+
+gboolean
+qof_instance_get_kvp_numeric (const QofInstance *inst, gnc_numeric *value,
+                              guint n_keys, const gchar * const *keys)
+{
+    auto slot = kvp_slot_of_type (inst, n_keys, keys, KvpValue::Type::NUMERIC);
+    if (slot == nullptr) return FALSE;
+    if (value) *value = slot->get<gnc_numeric>();
+    return TRUE;
+}
+
+gboolean
+qof_instance_get_kvp_int64 (const QofInstance *inst, gint64 *value,
+                            guint n_keys, const gchar * const *keys)
+{
+    auto slot = kvp_slot_of_type (inst, n_keys, keys, KvpValue::Type::INT64);
+    if (slot == nullptr) return FALSE;
+    if (value) *value = slot->get<int64_t>();
+    return TRUE;
+}
+
+const char *
+qof_instance_get_kvp_string (const QofInstance *inst,
+                             guint n_keys, const gchar * const *keys)
+{
+    auto slot = kvp_slot_of_type (inst, n_keys, keys, KvpValue::Type::STRING);
+    return slot ? slot->get<const char*>() : nullptr;
+}
+
+const GncGUID *
+qof_instance_get_kvp_guid (const QofInstance *inst,
+                           guint n_keys, const gchar * const *keys)
+{
+    auto slot = kvp_slot_of_type (inst, n_keys, keys, KvpValue::Type::GUID);
+    return slot ? slot->get<GncGUID*>() : nullptr;
+}
+
 void
 qof_instance_copy_kvp (QofInstance *to, const QofInstance *from)
 {
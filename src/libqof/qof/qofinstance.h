@@ -92,6 +92,14 @@ GType qof_instance_get_type(void);
 /** Initialise the settings associated with an instance */
 void qof_instance_init_data (QofInstance *, QofIdType, QofBook *);
 
+/** Initialise the settings associated with an instance that is read from
+ *  a file or database, with the guid it was saved with.  This spares a
+ *  loader generating a random guid only to replace it, and moving the
+ *  instance in its collection.  A null guid, or one another instance of
+ *  the type has, gets a random one as from qof_instance_init_data(). */
+void qof_instance_init_data_with_guid (QofInstance *, QofIdType, QofBook *,
+                                       const GncGUID *guid);
+
 /** Return the book pointer */
 /*@ dependent @*/
 QofBook *qof_instance_get_book (gconstpointer);
@@ -133,6 +141,10 @@ gint qof_instance_get_editlevel (gconstpointer ptr);
  */
 int qof_instance_version_cmp (const QofInstance *left, const QofInstance *right);
 
+/** The generation of its book when a change to this instance was last
+ *  committed, or 0 if none has been. See qof_book_get_generation(). */
+guint64 qof_instance_get_generation (gconstpointer ptr);
+
 /** Retrieve the flag that indicates whether or not this object is
  *  about to be destroyed.
  *
@@ -56,6 +56,9 @@ extern "C"
 #include "qof.h"
 #include "qoflog.h"
 
+#include <atomic>
+#include <mutex>
+
 #define QOF_LOG_MAX_CHARS 50
 #define QOF_LOG_MAX_CHARS_WITH_ALLOWANCE 100
 #define QOF_LOG_INDENT_WIDTH 4
@@ -67,6 +70,17 @@ static gint qof_log_num_spaces = 0;
 static GHashTable *log_table = NULL;
 static GLogFunc previous_handler = NULL;
 
+/* Never 0, so that a zeroed call site cache is always stale; it has to
+ * fit in the 24 bits that qof_log_check_cached() keeps of it. */
+gint qof_log_generation = 1;
+
+static void
+qof_log_invalidate_caches(void)
+{
+    gint next = (qof_log_generation + 1) & 0xffffff;
+    g_atomic_int_set(&qof_log_generation, next ? next : 1);
+}
+
 void
 qof_log_indent(void)
 {
@@ -220,6 +234,7 @@ qof_log_shutdown (void)
     {
         g_hash_table_destroy(log_table);
         log_table = NULL;
+        qof_log_invalidate_caches();
     }
 
     if (previous_handler != NULL)
@@ -227,6 +242,8 @@ qof_log_shutdown (void)
         g_log_set_default_handler(previous_handler, NULL);
         previous_handler = NULL;
     }
+
+    qof_log_trace_shutdown();
 }
 
 void
@@ -241,6 +258,7 @@ qof_log_set_level(QofLogModule log_module, QofLogLevel level)
         log_table = g_hash_table_new(g_str_hash, g_str_equal);
     }
     g_hash_table_insert(log_table, g_strdup((gchar*)log_module), GINT_TO_POINTER((gint)level));
+    qof_log_invalidate_caches();
 }
 
 const char *
@@ -368,8 +386,8 @@ qof_log_parse_log_config(const char *filename)
     g_key_file_free(conf);
 }
 
-gboolean
-qof_log_check(QofLogModule log_domain, QofLogLevel log_level)
+static QofLogLevel
+qof_log_threshold(QofLogModule log_domain)
 {
 //#define _QLC_DBG(x) x
 #define _QLC_DBG(x)
@@ -414,7 +432,24 @@ _QLC_DBG( { printf("trying [%s] (%d):", log_domain, log_levels != NULL ? g_hash_
     _QLC_DBG( { printf(" found [%d]\n", longest_match_level); });
     g_free(domain_copy);
 
-    return log_level <= longest_match_level;
+    return longest_match_level;
+}
+
+gboolean
+qof_log_check(QofLogModule log_domain, QofLogLevel log_level)
+{
+    return log_level <= qof_log_threshold(log_domain);
+}
+
+guint
+qof_log_update_cache(QofLogModule log_domain, guint *cache)
+{
+    /* Read the generation first: if a level changes while we look, the
+     * cache is stored stale and looked up again on the next call. */
+    guint generation = (guint)g_atomic_int_get(&qof_log_generation);
+    guint cached = generation << 8 | ((guint)qof_log_threshold(log_domain) & 0xff);
+    g_atomic_int_set((gint*)cache, (gint)cached);
+    return cached;
 }
 
 void
@@ -466,3 +501,117 @@ qof_log_level_from_string(const gchar *str)
     if (g_ascii_strncasecmp("debug", str, 5) == 0) return QOF_LOG_DEBUG;
     return QOF_LOG_DEBUG;
 }
+
+/* Tracing ------------------------------------------------------------*/
+
+gint qof_log_trace_enabled = 0;
+static FILE *trace_out = NULL;
+static gint64 trace_epoch = 0;
+static gboolean trace_empty = TRUE;
+static std::mutex trace_lock;
+
+static void
+trace_write_string(const gchar *str)
+{
+    fputc('"', trace_out);
+    for (; str && *str; ++str)
+    {
+        unsigned char c = *str;
+        if (c == '"' || c == '\\')
+            fprintf(trace_out, "\\%c", c);
+        else if (c < 0x20)
+            fprintf(trace_out, "\\u%04x", c);
+        else
+            fputc(c, trace_out);
+    }
+    fputc('"', trace_out);
+}
+
+/* The trace viewer wants small numbers for thread ids. */
+static int
+trace_thread_id(void)
+{
+    static std::atomic<int> next_id {1};
+    static thread_local int id = next_id++;
+    return id;
+}
+
+/* Called with trace_lock held.  The viewer would cope without the
+ * closing bracket, but other JSON readers wouldn't. */
+static void
+trace_close(void)
+{
+    g_atomic_int_set(&qof_log_trace_enabled, 0);
+    if (!trace_out)
+        return;
+    fputs("\n]\n", trace_out);
+    fclose(trace_out);
+    trace_out = NULL;
+}
+
+void
+qof_log_trace_init(const gchar *filename)
+{
+    std::lock_guard<std::mutex> lock(trace_lock);
+    trace_close();
+    if (!filename)
+        return;
+
+    trace_out = g_fopen(filename, "w");
+    if (!trace_out)
+    {
+        g_warning("Cannot open trace file \"%s\".", filename);
+        return;
+    }
+    fputc('[', trace_out);
+    trace_empty = TRUE;
+    trace_epoch = g_get_monotonic_time();
+    g_atomic_int_set(&qof_log_trace_enabled, 1);
+}
+
+void
+qof_log_trace_shutdown(void)
+{
+    std::lock_guard<std::mutex> lock(trace_lock);
+    trace_close();
+}
+
+void
+qof_log_trace_span(const gchar *category, const gchar *name, gint64 start)
+{
+    gint64 end = g_get_monotonic_time();
+    int tid = trace_thread_id();
+    std::lock_guard<std::mutex> lock(trace_lock);
+    /* Drop spans begun before the trace was (re)started. */
+    if (!trace_out || start < trace_epoch)
+        return;
+
+    fputs(trace_empty ? "\n" : ",\n", trace_out);
+    trace_empty = FALSE;
+    fputs("{\"name\":", trace_out);
+    trace_write_string(name);
+    fputs(",\"cat\":", trace_out);
+    trace_write_string(category);
+    fprintf(trace_out, ",\"ph\":\"X\",\"ts\":%" G_GINT64_FORMAT
+            ",\"dur\":%" G_GINT64_FORMAT ",\"pid\":1,\"tid\":%d}",
+            start - trace_epoch, end - start, tid);
+}
+
+void
+qof_log_trace_counter(const gchar *category, const gchar *name, gint64 value)
+{
+    gint64 now = g_get_monotonic_time();
+    std::lock_guard<std::mutex> lock(trace_lock);
+    if (!trace_out)
+        return;
+
+    fputs(trace_empty ? "\n" : ",\n", trace_out);
+    trace_empty = FALSE;
+    fputs("{\"name\":", trace_out);
+    trace_write_string(name);
+    fputs(",\"cat\":", trace_out);
+    trace_write_string(category);
+    fprintf(trace_out, ",\"ph\":\"C\",\"ts\":%" G_GINT64_FORMAT
+            ",\"pid\":1,\"args\":{\"value\":%" G_GINT64_FORMAT "}}",
+            now - trace_epoch, value);
+}
@@ -173,6 +173,51 @@ void qof_log_set_default(QofLogLevel log_level);
 
 #define PRETTY_FUNC_NAME qof_log_prettify(G_STRFUNC)
 
+/** The most verbose level compiled in.  PINFO, DEBUG, ENTER and LEAVE
+ * above it expand to nothing and their arguments aren't evaluated.
+ * configure --with-log-level sets it; the default keeps every level so
+ * that a build can still be traced in the field. */
+#ifndef QOF_LOG_MAX_LEVEL
+#define QOF_LOG_MAX_LEVEL G_LOG_LEVEL_DEBUG
+#endif
+
+/** Bumped whenever a log level changes, invalidating the caches of
+ * qof_log_check_cached().  Don't use it directly. */
+extern gint qof_log_generation;
+
+/** Looks up the threshold of @a log_module and stores it in @a cache
+ * together with the current qof_log_generation.  Returns the new cache
+ * value; used by qof_log_check_cached(). */
+guint qof_log_update_cache(QofLogModule log_module, guint *cache);
+
+/** Like qof_log_check(), but remembers the threshold in @a cache, which
+ * must always be used with the same @a log_module.  As long as no level
+ * changes this is one load, one compare and one branch. */
+static inline gboolean
+qof_log_check_cached(QofLogModule log_module, QofLogLevel log_level,
+                     guint *cache)
+{
+    guint cached = (guint)g_atomic_int_get((gint*)cache);
+    if (G_UNLIKELY(cached >> 8 != (guint)g_atomic_int_get(&qof_log_generation)))
+        cached = qof_log_update_cache(log_module, cache);
+    return (guint)log_level <= (cached & 0xff);
+}
+
+/** Opens the body of a logging macro: the statement that follows runs
+ * only if @a level is compiled in and enabled for the current
+ * @c log_module.  Each call site caches the module's threshold. */
+#define QOF_LOG_IF_ENABLED(level) \
+    static guint qof_log_site_cache = 0; \
+    if ((level) <= QOF_LOG_MAX_LEVEL && \
+        qof_log_check_cached(log_module, (QofLogLevel)(level), \
+                             &qof_log_site_cache))
+
+/** Opens the body of a logging macro that only compile-time filtering
+ * applies to.  PINFO and DEBUG still reach g_log() at any runtime level,
+ * as handlers set with g_log_set_handler() expect to see them. */
+#define QOF_LOG_IF_COMPILED(level) \
+    if ((level) <= QOF_LOG_MAX_LEVEL)
+
 #ifdef _MSC_VER
 /* Microsoft Visual Studio: MSVC compiler has a different syntax for
  * macros with variadic argument list. */
@@ -197,19 +242,21 @@ void qof_log_set_default(QofLogLevel log_level);
 
 /** Print an informational note */
 #define PINFO(format, ...) do { \
-    g_log (log_module, G_LOG_LEVEL_INFO, \
-      "[%s] " format, PRETTY_FUNC_NAME , __VA_ARGS__); \
+    QOF_LOG_IF_COMPILED(G_LOG_LEVEL_INFO) \
+      g_log (log_module, G_LOG_LEVEL_INFO, \
+        "[%s] " format, PRETTY_FUNC_NAME , __VA_ARGS__); \
 } while (0)
 
 /** Print a debugging message */
 #define DEBUG(format, ...) do { \
-    g_log (log_module, G_LOG_LEVEL_DEBUG, \
-      "[%s] " format, PRETTY_FUNC_NAME , __VA_ARGS__); \
+    QOF_LOG_IF_COMPILED(G_LOG_LEVEL_DEBUG) \
+      g_log (log_module, G_LOG_LEVEL_DEBUG, \
+        "[%s] " format, PRETTY_FUNC_NAME , __VA_ARGS__); \
 } while (0)
 
 /** Print a function entry debugging message */
 #define ENTER(format, ...) do { \
-    if (qof_log_check(log_module, (QofLogLevel)G_LOG_LEVEL_DEBUG)) { \
+    QOF_LOG_IF_ENABLED(G_LOG_LEVEL_DEBUG) { \
       g_log (log_module, G_LOG_LEVEL_DEBUG, \
         "[enter %s:%s()] " format, __FILE__, \
         PRETTY_FUNC_NAME , __VA_ARGS__); \
@@ -219,7 +266,7 @@ void qof_log_set_default(QofLogLevel log_level);
 
 /** Print a function exit debugging message. **/
 #define LEAVE(format, ...) do { \
-    if (qof_log_check(log_module, (QofLogLevel)G_LOG_LEVEL_DEBUG)) { \
+    QOF_LOG_IF_ENABLED(G_LOG_LEVEL_DEBUG) { \
       qof_log_dedent(); \
       g_log (log_module, G_LOG_LEVEL_DEBUG, \
         "[leave %s()] " format, \
@@ -249,19 +296,21 @@ void qof_log_set_default(QofLogLevel log_level);
 
 /** Print an informational note */
 #define PINFO(format, args...) do { \
-    g_log (log_module, G_LOG_LEVEL_INFO, \
-      "[%s] " format, PRETTY_FUNC_NAME , ## args); \
+    QOF_LOG_IF_COMPILED(G_LOG_LEVEL_INFO) \
+      g_log (log_module, G_LOG_LEVEL_INFO, \
+        "[%s] " format, PRETTY_FUNC_NAME , ## args); \
 } while (0)
 
 /** Print a debugging message */
 #define DEBUG(format, args...) do { \
-    g_log (log_module, G_LOG_LEVEL_DEBUG, \
-      "[%s] " format, PRETTY_FUNC_NAME , ## args); \
+    QOF_LOG_IF_COMPILED(G_LOG_LEVEL_DEBUG) \
+      g_log (log_module, G_LOG_LEVEL_DEBUG, \
+        "[%s] " format, PRETTY_FUNC_NAME , ## args); \
 } while (0)
 
 /** Print a function entry debugging message */
 #define ENTER(format, args...) do { \
-    if (qof_log_check(log_module, (QofLogLevel)G_LOG_LEVEL_DEBUG)) { \
+    QOF_LOG_IF_ENABLED(G_LOG_LEVEL_DEBUG) { \
       g_log (log_module, G_LOG_LEVEL_DEBUG, \
         "[enter %s:%s()] " format, __FILE__, \
         PRETTY_FUNC_NAME , ## args); \
@@ -271,7 +320,7 @@ void qof_log_set_default(QofLogLevel log_level);
 
 /** Print a function exit debugging message. **/
 #define LEAVE(format, args...) do { \
-    if (qof_log_check(log_module, (QofLogLevel)G_LOG_LEVEL_DEBUG)) { \
+    QOF_LOG_IF_ENABLED(G_LOG_LEVEL_DEBUG) { \
       qof_log_dedent(); \
       g_log (log_module, G_LOG_LEVEL_DEBUG, \
         "[leave %s()] " format, \
@@ -281,6 +330,51 @@ void qof_log_set_default(QofLogLevel log_level);
 
 #endif /* _MSC_VER */
 
+/** @name Tracing
+ * Timed spans around the expensive operations, written in the JSON
+ * format of Chrome's trace viewer so that chrome://tracing or
+ * ui.perfetto.dev can display them.  While tracing is off a span costs
+ * one test of qof_log_trace_enabled at either end.
+ @{ */
+
+/** Non-zero while spans are being written.  Don't set it directly. */
+extern gint qof_log_trace_enabled;
+
+/** Start writing spans to @a filename, replacing its contents.  Stops
+ * any trace already being written. */
+void qof_log_trace_init (const gchar *filename);
+
+/** Finish the trace file and stop tracing; qof_log_shutdown() calls it. */
+void qof_log_trace_shutdown (void);
+
+/** Record a span of @a category called @a name that began at @a start,
+ * as returned by qof_log_trace_begin().  Use QOF_TRACE_END instead. */
+void qof_log_trace_span (const gchar *category, const gchar *name,
+                         gint64 start);
+
+/** Record that the counter @a name of @a category is now @a value.  The
+ * viewer draws each counter as a graph over the spans. */
+void qof_log_trace_counter (const gchar *category, const gchar *name,
+                            gint64 value);
+
+/** The start of a span, or 0 if tracing is off. */
+static inline gint64
+qof_log_trace_begin (void)
+{
+    if (G_LIKELY (!g_atomic_int_get (&qof_log_trace_enabled)))
+        return 0;
+    return g_get_monotonic_time ();
+}
+
+/** Close a span opened with qof_log_trace_begin().  The strings must
+ * stay valid until this returns; they're copied into the trace. */
+#define QOF_TRACE_END(category, name, start) do { \
+    if (G_UNLIKELY (start)) \
+        qof_log_trace_span (category, name, start); \
+} while (0)
+
+/** @} */
+
 /** Replacement for @c g_return_val_if_fail, but calls LEAVE if the test fails. **/
 #define gnc_leave_return_val_if_fail(test, val) do { \
   if (! (test)) { LEAVE(""); } \
@@ -296,6 +390,25 @@ void qof_log_set_default(QofLogLevel log_level);
 
 #ifdef __cplusplus
 }
+
+/** A span lasting for the enclosing scope. */
+class QofLogTraceScope
+{
+public:
+    QofLogTraceScope (const char* category, const char* name) noexcept :
+        m_category {category}, m_name {name},
+        m_start {qof_log_trace_begin ()} {}
+    ~QofLogTraceScope ()
+    {
+        QOF_TRACE_END (m_category, m_name, m_start);
+    }
+    QofLogTraceScope (const QofLogTraceScope&) = delete;
+    QofLogTraceScope& operator= (const QofLogTraceScope&) = delete;
+private:
+    const char* m_category;
+    const char* m_name;
+    gint64 m_start;
+};
 #endif
 
 #endif /* _QOF_LOG_H */
@@ -33,11 +33,18 @@ extern "C"
 #include "qof.h"
 #include "qofobject-p.h"
 
+#include <mutex>
+
 static QofLogModule log_module = QOF_MOD_OBJECT;
 
 static gboolean object_is_initialized = FALSE;
 static GList *object_modules = NULL;
+/* The registered objects by type name, for qof_object_lookup. */
+static GHashTable *object_table = NULL;
+/* The books in being, which sessions on several threads may create and
+ * destroy at once.  The object modules are registered once at startup. */
 static GList *book_list = NULL;
+static std::mutex book_list_lock;
 static GHashTable *backend_data = NULL;
 
 /*
@@ -115,6 +122,7 @@ void qof_object_book_begin (QofBook *book)
     }
 
     /* Remember this book for later */
+    std::lock_guard<std::mutex> guard (book_list_lock);
     book_list = g_list_prepend (book_list, book);
     LEAVE (" ");
 }
@@ -133,6 +141,7 @@ void qof_object_book_end (QofBook *book)
     }
 
     /* Remove it from the list */
+    std::lock_guard<std::mutex> guard (book_list_lock);
     book_list = g_list_remove (book_list, book);
     LEAVE (" ");
 }
@@ -308,6 +317,7 @@ void qof_object_initialize (void)
 {
     if (object_is_initialized) return;
     backend_data = g_hash_table_new (g_str_hash, g_str_equal);
+    object_table = g_hash_table_new (g_str_hash, g_str_equal);
     object_is_initialized = TRUE;
 }
 
@@ -319,6 +329,8 @@ void qof_object_shutdown (void)
     g_hash_table_destroy (backend_data);
     backend_data = NULL;
 
+    g_hash_table_destroy (object_table);
+    object_table = NULL;
     g_list_free (object_modules);
     object_modules = NULL;
     g_list_free (book_list);
@@ -342,13 +354,23 @@ gboolean qof_object_register (const QofObject *object)
         object_modules = g_list_prepend (object_modules, (gpointer)object);
     else
         return FALSE;
+    /* The most recently registered object of a type wins, as it did when
+     * lookups searched object_modules. */
+    if (object->e_type)
+        g_hash_table_insert (object_table, (gpointer)object->e_type,
+                             (gpointer)object);
 
     /* Now initialize all the known books */
-    if (object->book_begin && book_list)
+    if (object->book_begin)
     {
-        GList *node;
-        for (node = book_list; node; node = node->next)
+        GList *books, *node;
+        {
+            std::lock_guard<std::mutex> guard (book_list_lock);
+            books = g_list_copy (book_list);
+        }
+        for (node = books; node; node = node->next)
             object->book_begin (static_cast<QofBook*>(node->data));
+        g_list_free (books);
     }
 
     return TRUE;
@@ -356,20 +378,12 @@ gboolean qof_object_register (const QofObject *object)
 
 const QofObject * qof_object_lookup (QofIdTypeConst name)
 {
-    GList *iter;
-    const QofObject *obj;
-
     g_return_val_if_fail (object_is_initialized, NULL);
 
     if (!name) return NULL;
 
-    for (iter = object_modules; iter; iter = iter->next)
-    {
-        obj = static_cast<QofObject*>(iter->data);
-        if (!g_strcmp0 (obj->e_type, name))
-            return obj;
-    }
-    return NULL;
+    return static_cast<const QofObject*>(g_hash_table_lookup (object_table,
+                                                              name));
 }
 
 gboolean qof_object_register_backend (QofIdTypeConst type_name,
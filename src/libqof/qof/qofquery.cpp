@@ -37,9 +37,15 @@ extern "C"
 #include "qofbackend-p.h"
 #include "qofbook-p.h"
 #include "qofclass-p.h"
+#include "qofevent-p.h"
 #include "qofquery-p.h"
 #include "qofquerycore-p.h"
 
+#include <algorithm>
+#include <system_error>
+#include <thread>
+#include <vector>
+
 static QofLogModule log_module = QOF_MOD_QUERY;
 
 struct _QofQueryTerm
@@ -105,8 +111,65 @@ struct _QofQuery
     gint              changed;
 
     GList *           results;
+
+    /* The execution plan, chosen when the terms are compiled: if the
+     * query has a single AND-list, one of its terms may be served by an
+     * index, which then supplies the candidates instead of a scan of the
+     * whole collection. */
+    const QofQueryIndex * plan_index;
+    const QofQueryTerm *  plan_term;
+
+    /* While cache_valid, results are kept up to date from the events:
+     * cache_touched maps the objects whose events arrived since the last
+     * run to a copy of their GUIDs, so that they can be found again, or
+     * found to be gone, without dereferencing them. cache_changed maps
+     * the GUIDs of objects of other types which raised events to their
+     * QofQueryDependents; their dependents are only looked for at the
+     * next run, so that a burst of events costs one walk. cache_dropped
+     * is the count of suspended events at the last run. */
+    gboolean          cache_valid;
+    GHashTable *      cache_touched;
+    GHashTable *      cache_changed;
+    guint64           cache_dropped;
+
+    /* The number of threads asked for by qof_query_set_threads(), and
+     * whether all of the terms' predicates allow them; the latter is
+     * found when the terms are compiled. */
+    gint              threads;
+    gboolean          parallel_safe;
 };
 
+typedef struct
+{
+    QofIdType                   search_for;
+    QofIdType                   changed_type;
+    QofQueryDependentsForeach   foreach;
+} QofQueryDependents;
+
+/* The queries whose results are being kept up to date.  Threads reading
+ * a book may each run queries, so the list is kept under a lock. */
+static GList *cached_queries = NULL;
+static GRecMutex cached_queries_lock;
+static GList *query_dependents = NULL;
+static gint   query_cache_handler_id = 0;
+
+struct _QofQueryIndex
+{
+    QofIdType               search_for;     /* NULL for any type */
+    QofQueryParamList *     param_list;
+    gchar *                 name;
+    gint                    cost;
+    QofQueryIndexAccepts    accepts;
+    QofQueryIndexForeach    foreach;
+    /* For a filtered index, the term which must accompany the indexed
+     * one; NULL otherwise. */
+    QofQueryParamList *     filter_param_list;
+    QofQueryIndexAccepts    filter_accepts;
+};
+
+/* The registered indexes, cheapest first. */
+static GList *query_indexes = NULL;
+
 typedef struct _QofQueryCB
 {
     QofQuery *        query;
@@ -114,6 +177,10 @@ typedef struct _QofQueryCB
     gint              count;
 } QofQueryCB;
 
+/* Below this many candidates for each thread, starting the threads costs
+ * more than they save. */
+static const std::size_t query_min_per_thread = 1024;
+
 /* initial_term will be owned by the new Query */
 static void query_init (QofQuery *q, QofQueryTerm *initial_term)
 {
@@ -242,12 +309,16 @@ static void free_sort (QofQuerySort *s)
     s->param_fcns = NULL;
 }
 
+static void query_cache_invalidate (QofQuery *q);
+
 static void free_members (QofQuery *q)
 {
     GList * cur_or;
 
     if (q == NULL) return;
 
+    query_cache_invalidate (q);
+
     for (cur_or = q->terms; cur_or; cur_or = cur_or->next)
     {
         GList * cur_and;
@@ -277,84 +348,193 @@ static void free_members (QofQuery *q)
     q->results = NULL;
 }
 
-static int cmp_func (const QofQuerySort *sort, QofSortFunc default_sort,
-                     const gconstpointer a, const gconstpointer b)
-{
-    QofParam *param = NULL;
-    GSList *node;
-    gpointer conva, convb;
+/* ==================================================================== */
+/* Sorting works out the keys of each object once, instead of walking the
+ * parameter getters for both sides of every comparison. A sort on a core
+ * type compared by the type's own compare function keeps the value the
+ * final getter returned; the compare function is then handed the kept
+ * value, with a getter which reads it back. Other sorts keep the object
+ * at the end of the parameter chain, or, for the default sort, the
+ * object itself. */
+
+typedef union
+{
+    const char *    str;
+    Timespec        date;
+    gnc_numeric     numeric;
+    gint32          i32;
+    gint64          i64;
+    double          dbl;
+    gboolean        boolean;
+    char            chr;
+} QofSortValue;
+
+typedef struct
+{
+    gpointer        object;     /* The end of the parameter chain */
+    QofSortValue    value;      /* What the final getter returned for it */
+} QofSortKey;
+
+typedef void (*QofSortFetch) (gpointer object, QofParam *param,
+                              QofSortValue *value);
+
+typedef enum
+{
+    SORT_KEY_NONE,              /* All objects compare equal */
+    SORT_KEY_DEFAULT,           /* The object type's default sort */
+    SORT_KEY_OBJECT,            /* Compare the ends of the chain */
+    SORT_KEY_VALUE              /* Compare the kept values */
+} QofSortKeyKind;
+
+typedef struct
+{
+    const QofQuerySort *sort;
+    QofSortKeyKind      kind;
+    QofSortFunc         default_sort;
+    QofParam *          final;  /* The last parameter of the chain */
+    QofSortFetch        fetch;
+    QofParam            reader; /* final, with a getter reading the key */
+} QofSortLevel;
+
+template <typename T, T QofSortValue::*member> static void
+sort_key_fetch (gpointer object, QofParam *param, QofSortValue *value)
+{
+    typedef T (*Getter) (gpointer, QofParam *);
+    value->*member = reinterpret_cast<Getter>(param->param_getfcn) (object,
+                                                                    param);
+}
+
+template <typename T, T QofSortValue::*member> static T
+sort_key_read (gpointer key, QofParam *param)
+{
+    (void)param;
+    return static_cast<QofSortKey*>(key)->value.*member;
+}
+
+#define SORT_KEY_TYPE(type, ctype, member) \
+    { type, sort_key_fetch<ctype, &QofSortValue::member>, \
+      reinterpret_cast<QofAccessFunc>(sort_key_read<ctype, &QofSortValue::member>) }
+
+static const struct
+{
+    const char *    type;
+    QofSortFetch    fetch;
+    QofAccessFunc   read;
+} sort_key_types[] =
+{
+    SORT_KEY_TYPE (QOF_TYPE_STRING, const char *, str),
+    SORT_KEY_TYPE (QOF_TYPE_DATE, Timespec, date),
+    SORT_KEY_TYPE (QOF_TYPE_NUMERIC, gnc_numeric, numeric),
+    SORT_KEY_TYPE (QOF_TYPE_DEBCRED, gnc_numeric, numeric),
+    SORT_KEY_TYPE (QOF_TYPE_INT32, gint32, i32),
+    SORT_KEY_TYPE (QOF_TYPE_INT64, gint64, i64),
+    SORT_KEY_TYPE (QOF_TYPE_DOUBLE, double, dbl),
+    SORT_KEY_TYPE (QOF_TYPE_BOOLEAN, gboolean, boolean),
+    SORT_KEY_TYPE (QOF_TYPE_CHAR, char, chr),
+};
 
-    g_return_val_if_fail (sort, 0);
+#undef SORT_KEY_TYPE
+
+static void
+sort_level_init (QofSortLevel *level, const QofQuerySort *sort,
+                 QofSortFunc default_sort)
+{
+    level->sort = sort;
+    level->kind = SORT_KEY_NONE;
+    level->default_sort = default_sort;
+    level->final = NULL;
+    level->fetch = NULL;
 
-    /* See if this is a default sort */
     if (sort->use_default)
     {
-        if (default_sort) return default_sort (a, b);
-        return 0;
+        if (default_sort)
+            level->kind = SORT_KEY_DEFAULT;
+        return;
     }
 
-    /* If no parameters, consider them equal */
-    if (!sort->param_fcns) return 0;
+    /* With no parameters or no compare function, the objects are equal */
+    if (!sort->param_fcns || (!sort->comp_fcn && !sort->obj_cmp))
+        return;
+
+    level->kind = SORT_KEY_OBJECT;
+    level->final = static_cast<QofParam*>(g_slist_last (sort->param_fcns)->data);
+    if (sort->obj_cmp ||
+        sort->comp_fcn != qof_query_core_get_compare (level->final->param_type))
+        return;
+
+    for (const auto& key_type : sort_key_types)
+        if (!g_strcmp0 (key_type.type, level->final->param_type))
+        {
+            level->kind = SORT_KEY_VALUE;
+            level->fetch = key_type.fetch;
+            level->reader = *level->final;
+            level->reader.param_getfcn = key_type.read;
+            break;
+        }
+}
+
+static void
+sort_key_init (const QofSortLevel *level, gpointer object, QofSortKey *key)
+{
+    GSList *node;
 
-    /* no compare function, consider the two objects equal */
-    if (!sort->comp_fcn && !sort->obj_cmp) return 0;
+    key->object = object;
+    if (level->kind == SORT_KEY_NONE || level->kind == SORT_KEY_DEFAULT)
+        return;
 
-    /* Do the list of conversions */
-    conva = (gpointer)a;
-    convb = (gpointer)b;
-    for (node = static_cast<GSList*>(sort->param_fcns); node;
-	 node = static_cast<GSList*>(node->next))
+    for (node = level->sort->param_fcns; node; node = node->next)
     {
-        param = static_cast<QofParam*>(node->data);
+        QofParam *param = static_cast<QofParam*>(node->data);
 
         /* The last term is really the "parameter getter",
          * unless we're comparing objects ;) */
-        if (!node->next && !sort->obj_cmp)
+        if (!node->next && !level->sort->obj_cmp)
             break;
 
-        /* Do the converstions */
-        conva = (param->param_getfcn) (conva, param);
-        convb = (param->param_getfcn) (convb, param);
+        key->object = (param->param_getfcn) (key->object, param);
     }
 
-    /* And now return the (appropriate) compare */
-    if (sort->comp_fcn)
-    {
-        int rc = sort->comp_fcn (conva, convb, sort->options, param);
-        return rc;
-    }
-
-    return sort->obj_cmp (conva, convb);
+    if (level->kind == SORT_KEY_VALUE && key->object)
+        level->fetch (key->object, level->final, &key->value);
 }
 
 static int
-sort_func (const gconstpointer a, const gconstpointer b, const gpointer q)
+sort_key_cmp (const QofSortLevel *level, QofSortKey *a, QofSortKey *b)
 {
-    int retval;
-    const QofQuery *sortQuery = static_cast<const QofQuery*>(q);
-
-    g_return_val_if_fail (sortQuery, 0);
+    const QofQuerySort *sort = level->sort;
 
-    retval = cmp_func (&(sortQuery->primary_sort), sortQuery->defaultSort, a, b);
-    if (retval == 0)
+    switch (level->kind)
     {
-        retval = cmp_func (&(sortQuery->secondary_sort), sortQuery->defaultSort,
-                           a, b);
-        if (retval == 0)
-        {
-            retval = cmp_func (&(sortQuery->tertiary_sort), sortQuery->defaultSort,
-                               a, b);
-            return sortQuery->tertiary_sort.increasing ? retval : -retval;
-        }
-        else
-        {
-            return sortQuery->secondary_sort.increasing ? retval : -retval;
-        }
+    case SORT_KEY_DEFAULT:
+        return level->default_sort (a->object, b->object);
+    case SORT_KEY_OBJECT:
+        if (sort->obj_cmp)
+            return sort->obj_cmp (a->object, b->object);
+        return sort->comp_fcn (a->object, b->object, sort->options,
+                               level->final);
+    case SORT_KEY_VALUE:
+        /* A missing object is passed on, for the compare function to
+         * deal with as it would have without the key. */
+        return sort->comp_fcn (a->object ? a : NULL, b->object ? b : NULL,
+                               sort->options,
+                               const_cast<QofParam*>(&level->reader));
+    default:
+        return 0;
     }
-    else
+}
+
+/* a and b are the keys of two objects, one for each sort level. */
+static int
+sort_keys_cmp (const QofSortLevel *levels, guint n_levels,
+               QofSortKey *a, QofSortKey *b)
+{
+    for (guint i = 0; i < n_levels; ++i)
     {
-        return sortQuery->primary_sort.increasing ? retval : -retval;
+        int retval = sort_key_cmp (&levels[i], &a[i], &b[i]);
+        if (retval)
+            return levels[i].sort->increasing ? retval : -retval;
     }
+    return 0;
 }
 
 /* ==================================================================== */
@@ -514,6 +694,7 @@ static void compile_terms (QofQuery *q)
     GList *or_ptr, *and_ptr, *node;
 
     ENTER (" query=%p", q);
+    q->parallel_safe = TRUE;
     /* Find the specific functions for this Query.  Note that the
      * Query's search_for should now be set to the new type.
      */
@@ -540,6 +721,10 @@ static void compile_terms (QofQuery *q)
                 qt->pred_fcn = qof_query_core_get_predicate (resObj->param_type);
             else
                 qt->pred_fcn = NULL;
+
+            if (qt->pred_fcn &&
+                !qof_query_core_predicate_is_thread_safe (resObj->param_type))
+                q->parallel_safe = FALSE;
         }
     }
 
@@ -550,6 +735,8 @@ static void compile_terms (QofQuery *q)
 
     q->defaultSort = qof_class_get_default_sort (q->search_for);
 
+    compile_plan (q);
+
     /* Now compile the backend instances */
     for (node = q->books; node; node = node->next)
     {
@@ -566,6 +753,67 @@ static void compile_terms (QofQuery *q)
     LEAVE (" query=%p", q);
 }
 
+/* Whether the AND-list has a term, other than the indexed one, which
+ * the index's filter accepts. */
+static gboolean
+plan_has_filter_term (GList *and_list, const QofQueryIndex *index,
+                      const QofQueryTerm *indexed)
+{
+    for (GList *node = and_list; node; node = node->next)
+    {
+        const QofQueryTerm *qt = static_cast<QofQueryTerm*>(node->data);
+
+        if (qt == indexed || qt->invert || !qt->pred_fcn ||
+            param_list_cmp (qt->param_list, index->filter_param_list))
+            continue;
+        if (!index->filter_accepts || index->filter_accepts (qt->pdata))
+            return TRUE;
+    }
+    return FALSE;
+}
+
+/* Pick the cheapest index which can serve one of the terms.  Only a
+ * query with a single OR-term can use one: with several, the candidates
+ * of the OR-terms would have to be merged. Inverted terms would make an
+ * index return the complement of what it was asked for. */
+static void
+compile_plan (QofQuery *q)
+{
+    GList *and_ptr, *node;
+
+    q->plan_index = NULL;
+    q->plan_term = NULL;
+    if (!q->terms || q->terms->next)
+        return;
+
+    for (node = query_indexes; node && !q->plan_index; node = node->next)
+    {
+        const QofQueryIndex *index = static_cast<QofQueryIndex*>(node->data);
+
+        if (index->search_for && g_strcmp0 (index->search_for, q->search_for))
+            continue;
+
+        for (and_ptr = static_cast<GList*>(q->terms->data); and_ptr;
+             and_ptr = and_ptr->next)
+        {
+            const QofQueryTerm *qt = static_cast<QofQueryTerm*>(and_ptr->data);
+
+            if (qt->invert || !qt->pred_fcn ||
+                param_list_cmp (qt->param_list, index->param_list) ||
+                (index->accepts && !index->accepts (qt->pdata)))
+                continue;
+            if (index->filter_param_list &&
+                !plan_has_filter_term (static_cast<GList*>(q->terms->data),
+                                       index, qt))
+                continue;
+
+            q->plan_index = index;
+            q->plan_term = qt;
+            break;
+        }
+    }
+}
+
 static void check_item_cb (gpointer object, gpointer user_data)
 {
     QofQueryCB* ql = static_cast<QofQueryCB*>(user_data);
@@ -580,6 +828,77 @@ static void check_item_cb (gpointer object, gpointer user_data)
     return;
 }
 
+static void gather_item_cb (gpointer object, gpointer user_data)
+{
+    auto candidates = static_cast<std::vector<gpointer>*>(user_data);
+
+    if (object)
+        candidates->push_back (object);
+}
+
+/* The number of threads the query may be checked in. */
+static guint
+query_thread_count (const QofQuery *q)
+{
+    if (!q->parallel_safe || q->threads == 0 || q->threads == 1)
+        return 1;
+    if (q->threads > 0)
+        return q->threads;
+    return std::max (std::thread::hardware_concurrency (), 1u);
+}
+
+/* Check the candidates in slices, one for each thread. A thread only
+ * writes the flags of its own slice, and the matches are collected in
+ * the candidates' order afterwards, so that the results are those of
+ * check_item_cb() run over the candidates in turn. */
+static void
+check_items_parallel (QofQueryCB *qcb, const std::vector<gpointer>& candidates,
+                      guint n_threads)
+{
+    const QofQuery *q = qcb->query;
+    std::vector<char> matches (candidates.size ());
+    std::vector<std::thread> workers;
+    std::size_t n_slices, slice;
+
+    n_slices = std::min<std::size_t> (n_threads,
+                                      candidates.size () / query_min_per_thread);
+    n_slices = std::max<std::size_t> (n_slices, 1);
+    slice = (candidates.size () + n_slices - 1) / n_slices;
+
+    auto check_slice = [&] (std::size_t begin)
+    {
+        std::size_t end = std::min (begin + slice, candidates.size ());
+        for (std::size_t i = begin; i < end; ++i)
+            matches[i] = check_object (q, candidates[i]);
+    };
+
+    /* The calling thread checks the first slice, and any slice whose
+     * thread couldn't be started. */
+    for (std::size_t begin = slice; begin < candidates.size (); begin += slice)
+    {
+        try
+        {
+            workers.emplace_back (check_slice, begin);
+        }
+        catch (const std::system_error& err)
+        {
+            PWARN ("Can't start a query thread: %s", err.what ());
+            check_slice (begin);
+        }
+    }
+    if (!candidates.empty ())
+        check_slice (0);
+    for (auto& worker : workers)
+        worker.join ();
+
+    for (std::size_t i = 0; i < candidates.size (); ++i)
+        if (matches[i])
+        {
+            qcb->list = g_list_prepend (qcb->list, candidates[i]);
+            qcb->count++;
+        }
+}
+
 static int param_list_cmp (const QofQueryParamList *l1, const QofQueryParamList *l2)
 {
     int ret;
@@ -704,6 +1023,8 @@ void qof_query_purge_terms (QofQuery *q, QofQueryParamList *param_list)
                     q->terms = g_list_remove_link (static_cast<GList*>(q->terms), _or_);
                     g_list_free_1 (_or_);
                     _or_ = q->terms;
+                    q->changed = 1;
+                    free_query_term (qt);
                     break;
                 }
                 else
@@ -721,6 +1042,222 @@ void qof_query_purge_terms (QofQuery *q, QofQueryParamList *param_list)
     }
 }
 
+static gchar *qof_query_describe_plan (const QofQuery *q);
+
+/* Decorate the objects with their sort keys, sort the keys and put the
+ * objects back into the list in the keys' order. The sort is stable, as
+ * g_list_sort() is. */
+static GList *
+query_sort_results (QofQuery *q, GList *objects)
+{
+    const guint n_levels = 3;
+    QofSortLevel levels[n_levels];
+    GList *node;
+    guint n, i;
+
+    if (!(q->primary_sort.comp_fcn || q->primary_sort.obj_cmp ||
+            (q->primary_sort.use_default && q->defaultSort)))
+        return objects;
+
+    sort_level_init (&levels[0], &q->primary_sort, q->defaultSort);
+    sort_level_init (&levels[1], &q->secondary_sort, q->defaultSort);
+    sort_level_init (&levels[2], &q->tertiary_sort, q->defaultSort);
+
+    n = g_list_length (objects);
+    std::vector<gpointer> originals (n);
+    std::vector<QofSortKey> keys (n * n_levels);
+    std::vector<guint> order (n);
+
+    for (node = objects, i = 0; node; node = node->next, ++i)
+    {
+        originals[i] = node->data;
+        order[i] = i;
+        for (guint l = 0; l < n_levels; ++l)
+            sort_key_init (&levels[l], node->data, &keys[i * n_levels + l]);
+    }
+
+    std::stable_sort (order.begin (), order.end (),
+                      [&] (guint a, guint b)
+                      {
+                          return sort_keys_cmp (levels, n_levels,
+                                                &keys[a * n_levels],
+                                                &keys[b * n_levels]) < 0;
+                      });
+
+    for (node = objects, i = 0; node; node = node->next, ++i)
+        node->data = originals[order[i]];
+    return objects;
+}
+
+/* ==================================================================== */
+/* The result cache.  A query run with qof_query_run keeps its results
+ * and follows the events: objects of the searched type which raised one
+ * are checked again at the next run, and so are the objects depending on
+ * an object of another type, if a QofQueryDependentsForeach was
+ * registered for that type. Any other event starts over with a full run,
+ * and so does any event lost to qof_event_suspend. */
+
+static void
+query_cache_invalidate (QofQuery *q)
+{
+    if (!q->cache_valid)
+        return;
+    q->cache_valid = FALSE;
+    g_rec_mutex_lock (&cached_queries_lock);
+    cached_queries = g_list_remove (cached_queries, q);
+    g_rec_mutex_unlock (&cached_queries_lock);
+    g_hash_table_destroy (q->cache_touched);
+    g_hash_table_destroy (q->cache_changed);
+    q->cache_touched = NULL;
+    q->cache_changed = NULL;
+}
+
+static void
+query_cache_touch (QofInstance *inst, gpointer user_data)
+{
+    QofQuery *q = static_cast<QofQuery*>(user_data);
+    g_hash_table_insert (q->cache_touched, inst,
+                         guid_copy (qof_instance_get_guid (inst)));
+}
+
+static const QofQueryDependents *
+query_find_dependents (QofIdTypeConst search_for, QofIdTypeConst changed_type)
+{
+    for (GList *node = query_dependents; node; node = node->next)
+    {
+        auto deps = static_cast<const QofQueryDependents*>(node->data);
+        if (!g_strcmp0 (deps->search_for, search_for) &&
+            !g_strcmp0 (deps->changed_type, changed_type))
+            return deps;
+    }
+    return NULL;
+}
+
+static void
+query_cache_event_handler (QofInstance *ent, QofEventId event_type,
+                           gpointer handler_data, gpointer event_data)
+{
+    GList *node, *next;
+
+    if (!ent->e_type)
+        return;
+
+    g_rec_mutex_lock (&cached_queries_lock);
+    for (node = cached_queries; node; node = next)
+    {
+        QofQuery *q = static_cast<QofQuery*>(node->data);
+        const QofQueryDependents *deps;
+
+        next = node->next;
+        if (!g_strcmp0 (ent->e_type, q->search_for))
+            query_cache_touch (ent, q);
+        else if ((deps = query_find_dependents (q->search_for, ent->e_type)))
+            g_hash_table_insert (q->cache_changed,
+                                 guid_copy (qof_instance_get_guid (ent)),
+                                 const_cast<QofQueryDependents*>(deps));
+        else
+            query_cache_invalidate (q);
+    }
+    g_rec_mutex_unlock (&cached_queries_lock);
+}
+
+static void
+query_cache_start (QofQuery *q)
+{
+    if (q->max_results >= 0)
+        return;     /* Cropping would need what was cropped. */
+
+    if (!q->cache_valid)
+    {
+        q->cache_touched = g_hash_table_new_full (g_direct_hash,
+                                                  g_direct_equal, NULL,
+                                                  (GDestroyNotify)guid_free);
+        q->cache_changed = g_hash_table_new_full (guid_hash_to_guint,
+                                                  guid_g_hash_table_equal,
+                                                  (GDestroyNotify)guid_free,
+                                                  NULL);
+        g_rec_mutex_lock (&cached_queries_lock);
+        cached_queries = g_list_prepend (cached_queries, q);
+        g_rec_mutex_unlock (&cached_queries_lock);
+        q->cache_valid = TRUE;
+    }
+    else
+    {
+        g_hash_table_remove_all (q->cache_touched);
+        g_hash_table_remove_all (q->cache_changed);
+    }
+    q->cache_dropped = qof_event_get_dropped_count ();
+}
+
+/* Bring the cached results up to date. Returns FALSE if there's nothing
+ * to go on and the query must be run in full. */
+static gboolean
+query_cache_refresh (QofQuery *q)
+{
+    GHashTableIter iter;
+    gpointer key, value;
+    GList *objects = NULL;
+
+    if (!q->cache_valid || q->changed ||
+        q->cache_dropped != qof_event_get_dropped_count ())
+        return FALSE;
+    if (!g_hash_table_size (q->cache_touched) &&
+        !g_hash_table_size (q->cache_changed))
+        return TRUE;
+
+    ENTER (" q=%p touched=%u changed=%u", q,
+           g_hash_table_size (q->cache_touched),
+           g_hash_table_size (q->cache_changed));
+
+    /* A changed object which is gone has no dependents left to check;
+     * the ones it had raised their own events. */
+    g_hash_table_iter_init (&iter, q->cache_changed);
+    while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+        auto deps = static_cast<const QofQueryDependents*>(value);
+        for (GList *node = q->books; node; node = node->next)
+        {
+            QofBook *book = static_cast<QofBook*>(node->data);
+            auto coll = qof_book_get_collection (book, deps->changed_type);
+            auto inst = qof_collection_lookup_entity (coll,
+                                                      static_cast<GncGUID*>(key));
+            if (!inst)
+                continue;
+            deps->foreach (inst, query_cache_touch, q);
+            break;
+        }
+    }
+    g_hash_table_remove_all (q->cache_changed);
+
+    for (GList *node = q->results; node; node = node->next)
+        if (!g_hash_table_lookup (q->cache_touched, node->data))
+            objects = g_list_prepend (objects, node->data);
+
+    g_hash_table_iter_init (&iter, q->cache_touched);
+    while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+        for (GList *node = q->books; node; node = node->next)
+        {
+            QofBook *book = static_cast<QofBook*>(node->data);
+            auto coll = qof_book_get_collection (book, q->search_for);
+            auto inst = qof_collection_lookup_entity (coll,
+                                                      static_cast<GncGUID*>(value));
+            if (!inst)
+                continue;
+            if (check_object (q, inst))
+                objects = g_list_prepend (objects, inst);
+            break;
+        }
+    }
+    g_hash_table_remove_all (q->cache_touched);
+
+    objects = query_sort_results (q, g_list_reverse (objects));
+    g_list_free (q->results);
+    q->results = objects;
+    LEAVE (" q=%p", q);
+    return TRUE;
+}
+
 static GList * qof_query_run_internal (QofQuery *q,
                                        void(*run_cb)(QofQueryCB*, gpointer),
                                        gpointer cb_arg)
@@ -733,6 +1270,7 @@ static GList * qof_query_run_internal (QofQuery *q,
     g_return_val_if_fail (q->books, NULL);
     g_return_val_if_fail (run_cb, NULL);
     ENTER (" q=%p", q);
+    QofLogTraceScope trace {"query", q->search_for};
 
     /* XXX: Prioritize the query terms? */
 
@@ -745,7 +1283,12 @@ static GList * qof_query_run_internal (QofQuery *q,
 
     /* Maybe log this sucker */
     if (qof_log_check (log_module, QOF_LOG_DEBUG))
+    {
+        gchar *plan = qof_query_describe_plan (q);
         qof_query_print (q);
+        DEBUG ("%s", plan);
+        g_free (plan);
+    }
 
     /* Now run the query over all the objects and save the results */
     {
@@ -771,11 +1314,7 @@ static GList * qof_query_run_internal (QofQuery *q,
     matching_objects = g_list_reverse(matching_objects);
 
     /* Now sort the matching objects based on the search criteria */
-    if (q->primary_sort.comp_fcn || q->primary_sort.obj_cmp ||
-            (q->primary_sort.use_default && q->defaultSort))
-    {
-        matching_objects = g_list_sort_with_data(matching_objects, sort_func, q);
-    }
+    matching_objects = query_sort_results (q, matching_objects);
 
     /* Crop the list to limit the number of splits. */
     if ((object_count > q->max_results) && (q->max_results > -1))
@@ -816,10 +1355,12 @@ static GList * qof_query_run_internal (QofQuery *q,
 static void qof_query_run_cb(QofQueryCB* qcb, gpointer cb_arg)
 {
     GList *node;
+    guint n_threads;
 
     (void)cb_arg; /* unused */
     g_return_if_fail(qcb);
 
+    n_threads = query_thread_count (qcb->query);
     for (node = qcb->query->books; node; node = node->next)
     {
         QofBook* book = static_cast<QofBook*>(node->data);
@@ -837,16 +1378,42 @@ static void qof_query_run_cb(QofQueryCB* qcb, gpointer cb_arg)
             }
         }
 
-        /* And then iterate over all the objects */
-        qof_object_foreach (qcb->query->search_for, book,
-                            (QofInstanceForeachCB) check_item_cb, qcb);
+        /* And then iterate over all the objects, or just the ones the
+         * index says are worth checking.  The candidates still go
+         * through all of the terms; to share them out among threads,
+         * they're gathered first. */
+        std::vector<gpointer> candidates;
+        auto cb = (QofInstanceForeachCB) check_item_cb;
+        gpointer cb_data = qcb;
+
+        if (n_threads > 1)
+        {
+            cb = (QofInstanceForeachCB) gather_item_cb;
+            cb_data = &candidates;
+        }
+        if (qcb->query->plan_index)
+            qcb->query->plan_index->foreach (book, qcb->query->search_for,
+                                             qcb->query->plan_term->pdata,
+                                             cb, cb_data);
+        else
+            qof_object_foreach (qcb->query->search_for, book, cb, cb_data);
+        if (n_threads > 1)
+            check_items_parallel (qcb, candidates, n_threads);
     }
 }
 
 GList * qof_query_run (QofQuery *q)
 {
-    /* Just a wrapper */
-    return qof_query_run_internal(q, qof_query_run_cb, NULL);
+    GList *results;
+
+    if (!q) return NULL;
+    if (query_cache_refresh (q))
+        return q->results;
+
+    results = qof_query_run_internal(q, qof_query_run_cb, NULL);
+    if (!q->changed)
+        query_cache_start (q);
+    return results;
 }
 
 static void qof_query_run_subq_cb(QofQueryCB* qcb, gpointer cb_arg)
@@ -869,7 +1436,9 @@ qof_query_run_subquery (QofQuery *subq, const QofQuery* primaryq)
     g_return_val_if_fail(!g_strcmp0(subq->search_for, primaryq->search_for),
                          NULL);
 
-    /* Perform the subquery */
+    /* Perform the subquery; its results follow the primary query's, not
+     * the events. */
+    query_cache_invalidate (subq);
     return qof_query_run_internal(subq, qof_query_run_subq_cb,
                                   (gpointer)primaryq);
 }
@@ -1009,6 +1578,9 @@ QofQuery * qof_query_copy (QofQuery *q)
     memcpy (copy, q, sizeof (QofQuery));
 
     copy->be_compiled = ht;
+    copy->cache_valid = FALSE;
+    copy->cache_touched = NULL;
+    copy->cache_changed = NULL;
     copy->terms = copy_or_terms (q->terms);
     copy->books = g_list_copy (q->books);
     copy->results = g_list_copy (q->results);
@@ -1252,6 +1824,7 @@ void qof_query_set_sort_options (QofQuery *q, gint prim_op, gint sec_op,
                                  gint tert_op)
 {
     if (!q) return;
+    query_cache_invalidate (q);
     q->primary_sort.options = prim_op;
     q->secondary_sort.options = sec_op;
     q->tertiary_sort.options = tert_op;
@@ -1261,6 +1834,7 @@ void qof_query_set_sort_increasing (QofQuery *q, gboolean prim_inc,
                                     gboolean sec_inc, gboolean tert_inc)
 {
     if (!q) return;
+    query_cache_invalidate (q);
     q->primary_sort.increasing = prim_inc;
     q->secondary_sort.increasing = sec_inc;
     q->tertiary_sort.increasing = tert_inc;
@@ -1269,9 +1843,16 @@ void qof_query_set_sort_increasing (QofQuery *q, gboolean prim_inc,
 void qof_query_set_max_results (QofQuery *q, int n)
 {
     if (!q) return;
+    query_cache_invalidate (q);
     q->max_results = n;
 }
 
+void qof_query_set_threads (QofQuery *q, gint n_threads)
+{
+    if (!q) return;
+    q->threads = n_threads;
+}
+
 void qof_query_add_guid_list_match (QofQuery *q, QofQueryParamList *param_list,
                                     GList *guid_list, QofGuidMatch options,
                                     QofQueryOp op)
@@ -1342,15 +1923,168 @@ void qof_query_init (void)
     ENTER (" ");
     qof_query_core_init ();
     qof_class_init ();
+    if (!query_cache_handler_id)
+        query_cache_handler_id =
+            qof_event_register_handler (query_cache_event_handler, NULL);
+    qof_query_register_index (NULL, "guid lookup",
+                              qof_query_build_param_list (QOF_PARAM_GUID,
+                                                          NULL),
+                              1, guid_index_accepts, guid_index_foreach);
     LEAVE ("Completed initialization of QofQuery");
 }
 
 void qof_query_shutdown (void)
 {
+    for (GList *node = query_indexes; node; node = node->next)
+    {
+        QofQueryIndex *index = static_cast<QofQueryIndex*>(node->data);
+        CACHE_REMOVE (index->search_for);
+        g_slist_free (index->param_list);
+        g_slist_free (index->filter_param_list);
+        g_free (index->name);
+        g_free (index);
+    }
+    g_list_free (query_indexes);
+    query_indexes = NULL;
+
+    for (GList *node = query_dependents; node; node = node->next)
+    {
+        QofQueryDependents *deps = static_cast<QofQueryDependents*>(node->data);
+        CACHE_REMOVE (deps->search_for);
+        CACHE_REMOVE (deps->changed_type);
+        g_free (deps);
+    }
+    g_list_free (query_dependents);
+    query_dependents = NULL;
+
+    while (cached_queries)
+        query_cache_invalidate (static_cast<QofQuery*>(cached_queries->data));
+    if (query_cache_handler_id)
+        qof_event_unregister_handler (query_cache_handler_id);
+    query_cache_handler_id = 0;
+
     qof_class_shutdown ();
     qof_query_core_shutdown ();
 }
 
+static gint
+index_cost_cmp (gconstpointer a, gconstpointer b)
+{
+    return static_cast<const QofQueryIndex*>(a)->cost -
+           static_cast<const QofQueryIndex*>(b)->cost;
+}
+
+void
+qof_query_register_index (QofIdTypeConst search_for, const char *name,
+                          QofQueryParamList *param_list, gint cost,
+                          QofQueryIndexAccepts accepts,
+                          QofQueryIndexForeach foreach)
+{
+    qof_query_register_filtered_index (search_for, name, param_list, cost,
+                                       accepts, foreach, NULL, NULL);
+}
+
+void
+qof_query_register_filtered_index (QofIdTypeConst search_for,
+                                   const char *name,
+                                   QofQueryParamList *param_list, gint cost,
+                                   QofQueryIndexAccepts accepts,
+                                   QofQueryIndexForeach foreach,
+                                   QofQueryParamList *filter_param_list,
+                                   QofQueryIndexAccepts filter_accepts)
+{
+    QofQueryIndex *index;
+
+    g_return_if_fail (name && param_list && foreach);
+
+    /* Registering the same index again replaces it. */
+    for (GList *node = query_indexes; node; node = node->next)
+    {
+        index = static_cast<QofQueryIndex*>(node->data);
+        if (!g_strcmp0 (index->search_for, search_for) &&
+            !param_list_cmp (index->param_list, param_list) &&
+            !param_list_cmp (index->filter_param_list, filter_param_list))
+        {
+            query_indexes = g_list_delete_link (query_indexes, node);
+            CACHE_REMOVE (index->search_for);
+            g_slist_free (index->param_list);
+            g_slist_free (index->filter_param_list);
+            g_free (index->name);
+            g_free (index);
+            break;
+        }
+    }
+
+    index = g_new0 (QofQueryIndex, 1);
+    index->search_for = static_cast<QofIdType>(CACHE_INSERT (search_for));
+    index->param_list = param_list;
+    index->name = g_strdup (name);
+    index->cost = cost;
+    index->accepts = accepts;
+    index->foreach = foreach;
+    index->filter_param_list = filter_param_list;
+    index->filter_accepts = filter_accepts;
+    query_indexes = g_list_insert_sorted (query_indexes, index,
+                                          index_cost_cmp);
+}
+
+void
+qof_query_register_dependents (QofIdTypeConst search_for,
+                               QofIdTypeConst changed_type,
+                               QofQueryDependentsForeach foreach)
+{
+    QofQueryDependents *deps;
+
+    g_return_if_fail (search_for && changed_type && foreach);
+
+    for (GList *node = query_dependents; node; node = node->next)
+    {
+        deps = static_cast<QofQueryDependents*>(node->data);
+        if (!g_strcmp0 (deps->search_for, search_for) &&
+            !g_strcmp0 (deps->changed_type, changed_type))
+        {
+            deps->foreach = foreach;
+            return;
+        }
+    }
+
+    deps = g_new0 (QofQueryDependents, 1);
+    deps->search_for = static_cast<QofIdType>(CACHE_INSERT (search_for));
+    deps->changed_type = static_cast<QofIdType>(CACHE_INSERT (changed_type));
+    deps->foreach = foreach;
+    query_dependents = g_list_prepend (query_dependents, deps);
+}
+
+/* The GUID of an object is an index into its collection. */
+static gboolean
+guid_index_accepts (const QofQueryPredData *pdata)
+{
+    return !g_strcmp0 (pdata->type_name, QOF_TYPE_GUID) &&
+           reinterpret_cast<const query_guid_def*>(pdata)->options ==
+           QOF_GUID_MATCH_ANY;
+}
+
+static void
+guid_index_foreach (QofBook *book, QofIdTypeConst search_for,
+                    const QofQueryPredData *pdata, QofInstanceForeachCB cb,
+                    gpointer user_data)
+{
+    auto pd = reinterpret_cast<const query_guid_def*>(pdata);
+    auto coll = qof_book_get_collection (book, search_for);
+    GList *seen = NULL;
+
+    for (GList *node = pd->guids; node; node = node->next)
+    {
+        auto inst = qof_collection_lookup_entity (coll,
+                                                  static_cast<GncGUID*>(node->data));
+        if (!inst || g_list_find (seen, inst))
+            continue;
+        seen = g_list_prepend (seen, inst);
+        cb (inst, user_data);
+    }
+    g_list_free (seen);
+}
+
 int qof_query_get_max_results (const QofQuery *q)
 {
     if (!q) return 0;
@@ -1552,6 +2286,49 @@ qof_query_print (QofQuery * query)
     LEAVE (" ");
 }
 
+static gchar *
+qof_query_describe_plan (const QofQuery *q)
+{
+    GString *str;
+    guint n_terms = 0;
+
+    for (GList *or_ptr = q->terms; or_ptr; or_ptr = or_ptr->next)
+        n_terms += g_list_length (static_cast<GList*>(or_ptr->data));
+
+    str = g_string_new ("Plan: ");
+    if (q->plan_index)
+    {
+        g_string_append_printf (str, "%s candidates from index \"%s\" on ",
+                                q->search_for, q->plan_index->name);
+        for (GSList *node = q->plan_term->param_list; node; node = node->next)
+            g_string_append_printf (str, "%s%s",
+                                    static_cast<gchar*>(node->data),
+                                    node->next ? "->" : "");
+    }
+    else
+        g_string_append_printf (str, "scan all %s", q->search_for);
+    g_string_append_printf (str, ", then check %u term%s in %u OR-term%s",
+                            n_terms, n_terms == 1 ? "" : "s",
+                            g_list_length (q->terms),
+                            g_list_length (q->terms) == 1 ? "" : "s");
+    if (query_thread_count (q) > 1)
+        g_string_append_printf (str, " in up to %u threads",
+                                query_thread_count (q));
+    return g_string_free (str, FALSE);
+}
+
+gchar *
+qof_query_explain (QofQuery *q)
+{
+    if (!q) return NULL;
+    if (q->changed)
+    {
+        query_clear_compiles (q);
+        compile_terms (q);
+    }
+    return qof_query_describe_plan (q);
+}
+
 static void
 qof_query_printOutput (GList * output)
 {
@@ -1941,4 +2718,504 @@ qof_query_printCharMatch (QofCharMatch c)
     return "UNKNOWN MATCH TYPE";
 }         /* qof_query_printGuidMatch */
 
+/* ======================== SERIALIZATION ================== */
+
+/* The text form of qof_query_to_string(), one record per line:
+ *
+ *   Q <search-for> <max-results>
+ *   S <options> <increasing> <path>     the three sorts, "S -" if unset
+ *   O                                   starts an AND-list of the OR-terms
+ *   T <invert> <type> <how> <path> ...  a term of the last AND-list,
+ *                                       followed by its predicate data
+ *
+ * A path is its length followed by its elements, a GUID list likewise.
+ * Strings are URI-escaped behind a '=', so that they hold no blanks, and
+ * a NULL string is '-'. */
+
+static void
+serialize_string (GString *str, const char *s)
+{
+    gchar *escaped;
+
+    if (!s)
+    {
+        g_string_append (str, " -");
+        return;
+    }
+    escaped = g_uri_escape_string (s, NULL, TRUE);
+    g_string_append_printf (str, " =%s", escaped);
+    g_free (escaped);
+}
+
+static void
+serialize_path (GString *str, const QofQueryParamList *path)
+{
+    g_string_append_printf (str, " %u", g_slist_length ((GSList*) path));
+    for (; path; path = path->next)
+        serialize_string (str, static_cast<const char*>(path->data));
+}
+
+static void
+serialize_guids (GString *str, const GList *guids)
+{
+    gchar buff[GUID_ENCODING_LENGTH + 1];
+
+    g_string_append_printf (str, " %u", g_list_length ((GList*) guids));
+    for (; guids; guids = guids->next)
+    {
+        guid_to_string_buff (static_cast<const GncGUID*>(guids->data), buff);
+        g_string_append_printf (str, " %s", buff);
+    }
+}
+
+static gboolean
+serialize_term (GString *str, const QofQueryTerm *qt)
+{
+    const QofQueryPredData *pd = qt->pdata;
+    const char *type = pd->type_name;
+
+    g_string_append_printf (str, "T %d", qt->invert ? 1 : 0);
+    serialize_string (str, type);
+    g_string_append_printf (str, " %d", pd->how);
+    serialize_path (str, qt->param_list);
+
+    if (!g_strcmp0 (type, QOF_TYPE_STRING))
+    {
+        auto pdata = (const query_string_def*) pd;
+        g_string_append_printf (str, " %d %d", pdata->options,
+                                pdata->is_regex ? 1 : 0);
+        serialize_string (str, pdata->matchstring);
+    }
+    else if (!g_strcmp0 (type, QOF_TYPE_DATE))
+    {
+        auto pdata = (const query_date_def*) pd;
+        g_string_append_printf (str, " %d %" G_GINT64_FORMAT " %ld",
+                                pdata->options, pdata->date.tv_sec,
+                                (long) pdata->date.tv_nsec);
+    }
+    else if (!g_strcmp0 (type, QOF_TYPE_NUMERIC)
+             || !g_strcmp0 (type, QOF_TYPE_DEBCRED))
+    {
+        auto pdata = (const query_numeric_def*) pd;
+        g_string_append_printf (str, " %d %" G_GINT64_FORMAT " %" G_GINT64_FORMAT,
+                                pdata->options, pdata->amount.num,
+                                pdata->amount.denom);
+    }
+    else if (!g_strcmp0 (type, QOF_TYPE_GUID))
+    {
+        auto pdata = (const query_guid_def*) pd;
+        g_string_append_printf (str, " %d", pdata->options);
+        serialize_guids (str, pdata->guids);
+    }
+    else if (!g_strcmp0 (type, QOF_TYPE_INT32))
+    {
+        auto pdata = (const query_int32_def*) pd;
+        g_string_append_printf (str, " %d", pdata->val);
+    }
+    else if (!g_strcmp0 (type, QOF_TYPE_INT64))
+    {
+        auto pdata = (const query_int64_def*) pd;
+        g_string_append_printf (str, " %" G_GINT64_FORMAT, pdata->val);
+    }
+    else if (!g_strcmp0 (type, QOF_TYPE_DOUBLE))
+    {
+        auto pdata = (const query_double_def*) pd;
+        gchar buff[G_ASCII_DTOSTR_BUF_SIZE];
+        g_string_append_printf (str, " %s",
+                                g_ascii_dtostr (buff, sizeof (buff), pdata->val));
+    }
+    else if (!g_strcmp0 (type, QOF_TYPE_BOOLEAN))
+    {
+        auto pdata = (const query_boolean_def*) pd;
+        g_string_append_printf (str, " %d", pdata->val ? 1 : 0);
+    }
+    else if (!g_strcmp0 (type, QOF_TYPE_CHAR))
+    {
+        auto pdata = (const query_char_def*) pd;
+        g_string_append_printf (str, " %d", pdata->options);
+        serialize_string (str, pdata->char_list);
+    }
+    else
+    {
+        PWARN ("query core type %s can't be serialized", type);
+        return FALSE;
+    }
+    g_string_append_c (str, '\n');
+    return TRUE;
+}
+
+static void
+serialize_sort (GString *str, const QofQuerySort *qs)
+{
+    if (!qs->param_list)
+    {
+        g_string_append (str, "S -\n");
+        return;
+    }
+    g_string_append_printf (str, "S %d %d", qs->options, qs->increasing ? 1 : 0);
+    serialize_path (str, qs->param_list);
+    g_string_append_c (str, '\n');
+}
+
+gchar *
+qof_query_to_string (const QofQuery *q)
+{
+    GString *str;
+    const GList *or_node, *and_node;
+
+    g_return_val_if_fail (q, NULL);
+
+    str = g_string_new ("Q");
+    serialize_string (str, q->search_for);
+    g_string_append_printf (str, " %d\n", q->max_results);
+    serialize_sort (str, &q->primary_sort);
+    serialize_sort (str, &q->secondary_sort);
+    serialize_sort (str, &q->tertiary_sort);
+
+    for (or_node = q->terms; or_node; or_node = or_node->next)
+    {
+        g_string_append (str, "O\n");
+        for (and_node = static_cast<GList*>(or_node->data); and_node;
+             and_node = and_node->next)
+        {
+            if (!serialize_term (str, static_cast<QofQueryTerm*>(and_node->data)))
+            {
+                g_string_free (str, TRUE);
+                return NULL;
+            }
+        }
+    }
+    return g_string_free (str, FALSE);
+}
+
+/* The blank separated fields of a record, read from the left. */
+typedef struct
+{
+    gchar **fields;
+    guint next;
+} QueryRecord;
+
+static const gchar *
+record_field (QueryRecord *rec)
+{
+    const gchar *field = rec->fields[rec->next];
+    if (field)
+        rec->next++;
+    return field;
+}
+
+static gboolean
+record_int64 (QueryRecord *rec, gint64 *val)
+{
+    const gchar *field = record_field (rec);
+    gchar *end;
+
+    if (!field || !*field)
+        return FALSE;
+    *val = g_ascii_strtoll (field, &end, 10);
+    return *end == '\0';
+}
+
+static gboolean
+record_int (QueryRecord *rec, gint *val)
+{
+    gint64 val64;
+
+    if (!record_int64 (rec, &val64) || val64 < G_MININT || val64 > G_MAXINT)
+        return FALSE;
+    *val = (gint) val64;
+    return TRUE;
+}
+
+/* A newly allocated string, or NULL for '-'. */
+static gboolean
+record_string (QueryRecord *rec, gchar **s)
+{
+    const gchar *field = record_field (rec);
+
+    if (!field)
+        return FALSE;
+    if (!strcmp (field, "-"))
+    {
+        *s = NULL;
+        return TRUE;
+    }
+    if (field[0] != '=')
+        return FALSE;
+    *s = g_uri_unescape_string (field + 1, NULL);
+    return *s != NULL;
+}
+
+/* The path's elements are cached strings, as the parameter names of a
+ * query are expected to outlive it. */
+static gboolean
+record_path (QueryRecord *rec, QofQueryParamList **path)
+{
+    gint n;
+
+    *path = NULL;
+    if (!record_int (rec, &n) || n < 0)
+        return FALSE;
+    while (n-- > 0)
+    {
+        gchar *elem;
+        if (!record_string (rec, &elem) || !elem)
+        {
+            g_slist_free (*path);
+            return FALSE;
+        }
+        *path = g_slist_prepend (*path, CACHE_INSERT (elem));
+        g_free (elem);
+    }
+    *path = g_slist_reverse (*path);
+    return TRUE;
+}
+
+static QofQueryPredData *
+deserialize_pred_data (QueryRecord *rec, const gchar *type, QofQueryCompare how)
+{
+    QofQueryPredData *pd = NULL;
+    gint options, flag;
+    gint64 val1, val2;
+    gchar *s;
+
+    if (!g_strcmp0 (type, QOF_TYPE_STRING))
+    {
+        if (record_int (rec, &options) && record_int (rec, &flag)
+                && record_string (rec, &s))
+        {
+            pd = qof_query_string_predicate (how, s ? s : "",
+                                             (QofStringMatch) options, flag);
+            g_free (s);
+        }
+    }
+    else if (!g_strcmp0 (type, QOF_TYPE_DATE))
+    {
+        if (record_int (rec, &options) && record_int64 (rec, &val1)
+                && record_int64 (rec, &val2))
+        {
+            Timespec date = { val1, (glong) val2 };
+            pd = qof_query_date_predicate (how, (QofDateMatch) options, date);
+        }
+    }
+    else if (!g_strcmp0 (type, QOF_TYPE_NUMERIC)
+             || !g_strcmp0 (type, QOF_TYPE_DEBCRED))
+    {
+        if (record_int (rec, &options) && record_int64 (rec, &val1)
+                && record_int64 (rec, &val2))
+        {
+            pd = qof_query_numeric_predicate (how, (QofNumericMatch) options,
+                                              gnc_numeric_create (val1, val2));
+            if (pd && !g_strcmp0 (type, QOF_TYPE_DEBCRED))
+                pd->type_name = QOF_TYPE_DEBCRED;
+        }
+    }
+    else if (!g_strcmp0 (type, QOF_TYPE_GUID))
+    {
+        gint n;
+        if (record_int (rec, &options) && record_int (rec, &n) && n >= 0)
+        {
+            GncGUID *guids = g_new (GncGUID, n);
+            GList *list = NULL;
+            gint i;
+
+            for (i = 0; i < n; i++)
+            {
+                const gchar *field = record_field (rec);
+                if (!field || !string_to_guid (field, &guids[i]))
+                    break;
+                list = g_list_prepend (list, &guids[i]);
+            }
+            /* The predicate copies the GUIDs. */
+            list = g_list_reverse (list);
+            if (i == n)
+                pd = qof_query_guid_predicate ((QofGuidMatch) options, list);
+            g_list_free (list);
+            g_free (guids);
+        }
+    }
+    else if (!g_strcmp0 (type, QOF_TYPE_INT32))
+    {
+        if (record_int (rec, &flag))
+            pd = qof_query_int32_predicate (how, flag);
+    }
+    else if (!g_strcmp0 (type, QOF_TYPE_INT64))
+    {
+        if (record_int64 (rec, &val1))
+            pd = qof_query_int64_predicate (how, val1);
+    }
+    else if (!g_strcmp0 (type, QOF_TYPE_DOUBLE))
+    {
+        const gchar *field = record_field (rec);
+        gchar *end;
+
+        if (field && *field)
+        {
+            double val = g_ascii_strtod (field, &end);
+            if (*end == '\0')
+                pd = qof_query_double_predicate (how, val);
+        }
+    }
+    else if (!g_strcmp0 (type, QOF_TYPE_BOOLEAN))
+    {
+        if (record_int (rec, &flag))
+            pd = qof_query_boolean_predicate (how, flag);
+    }
+    else if (!g_strcmp0 (type, QOF_TYPE_CHAR))
+    {
+        if (record_int (rec, &options) && record_string (rec, &s))
+        {
+            pd = qof_query_char_predicate ((QofCharMatch) options, s ? s : "");
+            g_free (s);
+        }
+    }
+    return pd;
+}
+
+static QofQueryTerm *
+deserialize_term (QueryRecord *rec)
+{
+    QofQueryTerm *qt;
+    QofQueryParamList *path;
+    QofQueryPredData *pd;
+    gint invert, how;
+    gchar *type;
+
+    if (!record_int (rec, &invert) || !record_string (rec, &type) || !type)
+        return NULL;
+    if (!record_int (rec, &how) || !record_path (rec, &path))
+    {
+        g_free (type);
+        return NULL;
+    }
+    pd = deserialize_pred_data (rec, type, (QofQueryCompare) how);
+    g_free (type);
+    if (!pd || record_field (rec))
+    {
+        if (pd)
+            qof_query_core_predicate_free (pd);
+        g_slist_free (path);
+        return NULL;
+    }
+
+    qt = g_new0 (QofQueryTerm, 1);
+    qt->param_list = path;
+    qt->pdata = pd;
+    qt->invert = invert != 0;
+    return qt;
+}
+
+static gboolean
+deserialize_sort (QueryRecord *rec, QofQuerySort *qs)
+{
+    gint options, increasing;
+    QofQueryParamList *path;
+
+    if (!g_strcmp0 (rec->fields[rec->next], "-"))
+    {
+        rec->next++;
+        path = NULL;
+        options = 0;
+        increasing = TRUE;
+    }
+    else if (!record_int (rec, &options) || !record_int (rec, &increasing)
+             || !record_path (rec, &path))
+        return FALSE;
+
+    g_slist_free (qs->param_list);
+    qs->param_list = path;
+    qs->options = options;
+    qs->increasing = increasing != 0;
+    return TRUE;
+}
+
+QofQuery *
+qof_query_from_string (const gchar *str)
+{
+    QofQuery *q;
+    gchar **lines;
+    GList *or_terms = NULL, *and_terms = NULL;
+    QofQuerySort *sorts[3];
+    guint line, n_sorts = 0;
+    gboolean have_header = FALSE, in_and = FALSE, ok = TRUE;
+
+    g_return_val_if_fail (str, NULL);
+
+    q = qof_query_create ();
+    sorts[0] = &q->primary_sort;
+    sorts[1] = &q->secondary_sort;
+    sorts[2] = &q->tertiary_sort;
+
+    lines = g_strsplit (str, "\n", -1);
+    for (line = 0; ok && lines[line]; line++)
+    {
+        QueryRecord rec;
+        const gchar *tag;
+
+        if (!*lines[line])
+            continue;
+        rec.fields = g_strsplit (lines[line], " ", -1);
+        rec.next = 0;
+        tag = record_field (&rec);
+
+        if (!have_header)
+        {
+            gchar *search_for;
+            gint max_results;
+
+            have_header = TRUE;
+            ok = (!g_strcmp0 (tag, "Q") && record_string (&rec, &search_for));
+            if (ok)
+            {
+                /* Type names are expected to outlive the query. */
+                if (search_for)
+                    qof_query_search_for (q, CACHE_INSERT (search_for));
+                g_free (search_for);
+                ok = record_int (&rec, &max_results);
+                if (ok)
+                    qof_query_set_max_results (q, max_results);
+            }
+        }
+        else if (!g_strcmp0 (tag, "S") && n_sorts < 3)
+        {
+            ok = deserialize_sort (&rec, sorts[n_sorts++]);
+        }
+        else if (!g_strcmp0 (tag, "O"))
+        {
+            if (and_terms)
+                or_terms = g_list_prepend (or_terms, g_list_reverse (and_terms));
+            and_terms = NULL;
+            in_and = TRUE;
+        }
+        else if (!g_strcmp0 (tag, "T") && in_and)
+        {
+            QofQueryTerm *qt = deserialize_term (&rec);
+            if (qt)
+                and_terms = g_list_prepend (and_terms, qt);
+            else
+                ok = FALSE;
+        }
+        else
+        {
+            ok = FALSE;
+        }
+        g_strfreev (rec.fields);
+    }
+    g_strfreev (lines);
+    ok = ok && have_header;
+
+    if (and_terms)
+        or_terms = g_list_prepend (or_terms, g_list_reverse (and_terms));
+    q->terms = g_list_reverse (or_terms);
+    q->changed = 1;
+
+    if (!ok)
+    {
+        PWARN ("invalid query string");
+        qof_query_destroy (q);
+        return NULL;
+    }
+    return q;
+}
+
 /* ======================== END OF FILE =================== */
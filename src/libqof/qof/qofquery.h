@@ -127,6 +127,90 @@ void qof_query_init (void);
 void qof_query_shutdown (void);
 // @}
 
+/* --------------------------------------------------------- */
+/** \name Query Indexes
+ *
+ * Without help a query checks every object in the collection of the type
+ * it searches for. An object implementation which has a faster way to
+ * find the objects satisfying some kind of term, such as an account's own
+ * list of splits, can register it as an index. When the query has a
+ * single OR-term the cheapest index which applies to one of its terms
+ * supplies the candidates, which are then checked against all of the
+ * terms.
+ */
+// @{
+typedef struct _QofQueryIndex QofQueryIndex;
+
+/** Whether the index can serve a term with this predicate. */
+typedef gboolean (*QofQueryIndexAccepts) (const QofQueryPredData *pdata);
+
+/** Call cb once for each object of type search_for in book which might
+ * satisfy the predicate pdata on the index's parameter. It may call it for
+ * objects which don't, but it must not miss any which do, and it mustn't
+ * call it twice for the same object. */
+typedef void (*QofQueryIndexForeach) (QofBook *book,
+                                      QofIdTypeConst search_for,
+                                      const QofQueryPredData *pdata,
+                                      QofInstanceForeachCB cb,
+                                      gpointer user_data);
+
+/** Register an index for terms on param_list in queries for search_for,
+ * or for every type if search_for is NULL. The query subsystem takes
+ * ownership of param_list. Registering an index for the same type and
+ * parameter list again replaces it.
+ *
+ * @param search_for: The type of object searched for, or NULL.
+ * @param name: A name for qof_query_explain().
+ * @param param_list: The parameter path of the terms the index serves.
+ * @param cost: The lowest cost index is preferred when several apply.
+ * @param accepts: Checks a term's predicate, or NULL to accept any.
+ * @param foreach: Walks the candidates.
+ */
+void qof_query_register_index (QofIdTypeConst search_for, const char *name,
+                               QofQueryParamList *param_list, gint cost,
+                               QofQueryIndexAccepts accepts,
+                               QofQueryIndexForeach foreach);
+
+/** Register an index which only serves a query that also has a term on
+ * filter_param_list accepted by filter_accepts. Its foreach may then
+ * leave out the objects which can't satisfy such a term, the way an
+ * account's list of unreconciled splits serves a query for the
+ * unreconciled splits of the account. The query subsystem takes
+ * ownership of both parameter lists.
+ *
+ * @param filter_param_list: The parameter path of the companion term.
+ * @param filter_accepts: Checks its predicate, or NULL to accept any.
+ */
+void qof_query_register_filtered_index (QofIdTypeConst search_for,
+                                        const char *name,
+                                        QofQueryParamList *param_list,
+                                        gint cost,
+                                        QofQueryIndexAccepts accepts,
+                                        QofQueryIndexForeach foreach,
+                                        QofQueryParamList *filter_param_list,
+                                        QofQueryIndexAccepts filter_accepts);
+
+/** Call cb for each object of the type being searched for whose match
+ * could depend on changed, an object of another type. */
+typedef void (*QofQueryDependentsForeach) (QofInstance *changed,
+                                           QofInstanceForeachCB cb,
+                                           gpointer user_data);
+
+/** qof_query_run() keeps its results and updates them from the events
+ * of the objects searched for, checking only those which changed since
+ * the last run. An event of an object of another type makes the next run
+ * a full one, unless a function to find which objects searched for depend
+ * on it has been registered for that type with this.
+ *
+ * @param search_for: The type of object searched for.
+ * @param changed_type: The type of object raising the events.
+ * @param foreach: Walks the dependents of an object of changed_type.
+ */
+void qof_query_register_dependents (QofIdTypeConst search_for,
+                                    QofIdTypeConst changed_type,
+                                    QofQueryDependentsForeach foreach);
+// @}
+
 /* --------------------------------------------------------- */
 /** \name Low-Level API Functions */
 // @{
@@ -360,6 +444,22 @@ void qof_query_set_sort_increasing (QofQuery *q, gboolean prim_inc,
  */
 void qof_query_set_max_results (QofQuery *q, int n);
 
+/**
+ * Check the objects in up to n_threads threads at once when the query is
+ * run; -1 uses a thread for each processor, and 0 or 1, the default,
+ * checks them all in the calling thread. The results, and their order,
+ * are the same either way.
+ *
+ * Only the core types' predicates which merely read their arguments are
+ * run in other threads; a query with a term on a QOF_TYPE_COLLECT or
+ * QOF_TYPE_CHOICE parameter is checked in the calling thread. The
+ * parameter getters the terms reach are run in the other threads too, so
+ * the caller must make sure that they don't change the objects, or any
+ * cache of theirs, and that nothing else changes the book while the
+ * query runs. Sorting is always done in the calling thread.
+ */
+void qof_query_set_threads (QofQuery *q, gint n_threads);
+
 /** Compare two queries for equality.
  * Query terms are compared each to each.
  * This is a simplistic
@@ -368,6 +468,27 @@ void qof_query_set_max_results (QofQuery *q, int n);
  */
 gboolean qof_query_equal (const QofQuery *q1, const QofQuery *q2);
 
+/** Write the query's object type, terms, sort order and maximum number
+ * of results as text, which qof_query_from_string() reads back into an
+ * equal query.  The text is a few short lines, and is much cheaper to
+ * write and read than the Scheme list form of gnc_query2scm().
+ *
+ * Only terms on the core types string, date, numeric, debcred, guid,
+ * int32, int64, double, boolean and char can be written.
+ *
+ * @return A newly allocated string, which the caller must g_free(), or
+ * NULL if a term can't be written.
+ */
+gchar * qof_query_to_string (const QofQuery *q);
+
+/** Read back a query written by qof_query_to_string().  The query has no
+ * book set.
+ *
+ * @return A new query, which the caller must destroy, or NULL if the
+ * string is not a valid query.
+ */
+QofQuery * qof_query_from_string (const gchar *str);
+
 /** Log the Query
  *
  * \deprecated Do not call directly, use the standard log
@@ -376,6 +497,14 @@ gboolean qof_query_equal (const QofQuery *q1, const QofQuery *q2);
  */
 void qof_query_print (QofQuery *query);
 
+/** Describe how the query will be run: which index, if any, supplies the
+ * candidates, and how many terms they are checked against. The plan is
+ * also logged, with the query, at debug level when it runs.
+ *
+ * @return A newly allocated string, to be freed with g_free().
+ */
+gchar * qof_query_explain (QofQuery *query);
+
 /** Return the type of data we're querying for */
 /*@ dependent @*/
 QofIdType qof_query_get_search_for (const QofQuery *q);
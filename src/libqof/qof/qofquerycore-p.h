@@ -48,6 +48,8 @@ typedef gint (*QofQueryPredicateFunc) (gpointer object,
 /* Lookup functions */
 QofQueryPredicateFunc qof_query_core_get_predicate (gchar const *type);
 QofCompareFunc qof_query_core_get_compare (gchar const *type);
+/* Whether the predicate for type may be run from several threads at once */
+gboolean qof_query_core_predicate_is_thread_safe (gchar const *type);
 
 /* Compare two predicates */
 gboolean qof_query_core_predicate_equal (const QofQueryPredData *p1, const QofQueryPredData *p2);
@@ -92,6 +92,7 @@ static const char * query_choice_type = QOF_TYPE_CHOICE;
 static gboolean initialized = FALSE;
 static GHashTable *predTable = NULL;
 static GHashTable *cmpTable = NULL;
+static GHashTable *threadSafeTable = NULL;
 static GHashTable *copyTable = NULL;
 static GHashTable *freeTable = NULL;
 static GHashTable *toStringTable = NULL;
@@ -1572,7 +1573,10 @@ qof_query_choice_predicate (QofGuidMatch options, GList *guid_list)
  * An example:
  * qof_query_register_core_object (QOF_TYPE_STRING, string_match_predicate,
  *                               string_compare_fcn, string_free_pdata,
- *                               string_print_fcn, pred_equal_fcn);
+ *                               string_print_fcn, pred_equal_fcn, TRUE);
+ *
+ * thread_safe says that the predicate only reads the object and the
+ * predicate data, so that several threads may run it at once.
  */
 
 
@@ -1583,7 +1587,8 @@ qof_query_register_core_object (QofType core_name,
                                 QueryPredicateCopyFunc copy,
                                 QueryPredDataFree pd_free,
                                 QueryToString toString,
-                                QueryPredicateEqual pred_equal)
+                                QueryPredicateEqual pred_equal,
+                                gboolean thread_safe)
 {
     g_return_if_fail (core_name);
     g_return_if_fail (*core_name != '\0');
@@ -1611,6 +1616,10 @@ qof_query_register_core_object (QofType core_name,
     if (pred_equal)
         g_hash_table_insert (predEqualTable, (char *)core_name,
 			     reinterpret_cast<void*>(pred_equal));
+
+    if (thread_safe)
+        g_hash_table_insert (threadSafeTable, (char *)core_name,
+                             GINT_TO_POINTER (1));
 }
 
 static void init_tables (void)
@@ -1625,66 +1634,70 @@ static void init_tables (void)
         QueryPredDataFree      pd_free;
         QueryToString          toString;
         QueryPredicateEqual    pred_equal;
+        gboolean               thread_safe;
     } knownTypes[] =
     {
+        /* The collection and choice predicates walk other objects'
+         * collections, so they're left out of parallel evaluation. */
         {
             QOF_TYPE_STRING, string_match_predicate, string_compare_func,
             string_copy_predicate, string_free_pdata, string_to_string,
-            string_predicate_equal
+            string_predicate_equal, TRUE
         },
         {
             QOF_TYPE_DATE, date_match_predicate, date_compare_func,
             date_copy_predicate, date_free_pdata, date_to_string,
-            date_predicate_equal
+            date_predicate_equal, TRUE
         },
         {
             QOF_TYPE_DEBCRED, numeric_match_predicate, numeric_compare_func,
             numeric_copy_predicate, numeric_free_pdata, debcred_to_string,
-            numeric_predicate_equal
+            numeric_predicate_equal, TRUE
         },
         {
             QOF_TYPE_NUMERIC, numeric_match_predicate, numeric_compare_func,
             numeric_copy_predicate, numeric_free_pdata, numeric_to_string,
-            numeric_predicate_equal
+            numeric_predicate_equal, TRUE
         },
         {
             QOF_TYPE_GUID, guid_match_predicate, NULL,
             guid_copy_predicate, guid_free_pdata, NULL,
-            guid_predicate_equal
+            guid_predicate_equal, TRUE
         },
         {
             QOF_TYPE_INT32, int32_match_predicate, int32_compare_func,
             int32_copy_predicate, int32_free_pdata, int32_to_string,
-            int32_predicate_equal
+            int32_predicate_equal, TRUE
         },
         {
             QOF_TYPE_INT64, int64_match_predicate, int64_compare_func,
             int64_copy_predicate, int64_free_pdata, int64_to_string,
-            int64_predicate_equal
+            int64_predicate_equal, TRUE
         },
         {
             QOF_TYPE_DOUBLE, double_match_predicate, double_compare_func,
             double_copy_predicate, double_free_pdata, double_to_string,
-            double_predicate_equal
+            double_predicate_equal, TRUE
         },
         {
             QOF_TYPE_BOOLEAN, boolean_match_predicate, boolean_compare_func,
             boolean_copy_predicate, boolean_free_pdata, boolean_to_string,
-            boolean_predicate_equal
+            boolean_predicate_equal, TRUE
         },
         {
             QOF_TYPE_CHAR, char_match_predicate, char_compare_func,
             char_copy_predicate, char_free_pdata, char_to_string,
-            char_predicate_equal
+            char_predicate_equal, TRUE
         },
         {
             QOF_TYPE_COLLECT, collect_match_predicate, collect_compare_func,
             collect_copy_predicate, collect_free_pdata, NULL,
-            collect_predicate_equal
+            collect_predicate_equal, FALSE
         },
         {
             QOF_TYPE_CHOICE, choice_match_predicate, NULL,
-            choice_copy_predicate, choice_free_pdata, NULL, choice_predicate_equal
+            choice_copy_predicate, choice_free_pdata, NULL, choice_predicate_equal,
+            FALSE
         },
     };
 
@@ -1697,7 +1710,8 @@ static void init_tables (void)
                                         knownTypes[i].copy,
                                         knownTypes[i].pd_free,
                                         knownTypes[i].toString,
-                                        knownTypes[i].pred_equal);
+                                        knownTypes[i].pred_equal,
+                                        knownTypes[i].thread_safe);
     }
 }
 
@@ -1733,6 +1747,7 @@ void qof_query_core_init (void)
     freeTable = g_hash_table_new (g_str_hash, g_str_equal);
     toStringTable = g_hash_table_new (g_str_hash, g_str_equal);
     predEqualTable = g_hash_table_new (g_str_hash, g_str_equal);
+    threadSafeTable = g_hash_table_new (g_str_hash, g_str_equal);
 
     init_tables ();
 }
@@ -1748,6 +1763,7 @@ void qof_query_core_shutdown (void)
     g_hash_table_destroy (freeTable);
     g_hash_table_destroy (toStringTable);
     g_hash_table_destroy (predEqualTable);
+    g_hash_table_destroy (threadSafeTable);
 }
 
 QofQueryPredicateFunc
@@ -1757,6 +1773,13 @@ qof_query_core_get_predicate (QofType type)
     return reinterpret_cast<QofQueryPredicateFunc>(g_hash_table_lookup (predTable, type));
 }
 
+gboolean
+qof_query_core_predicate_is_thread_safe (QofType type)
+{
+    g_return_val_if_fail (type, FALSE);
+    return g_hash_table_lookup (threadSafeTable, type) != NULL;
+}
+
 QofCompareFunc
 qof_query_core_get_compare (QofType type)
 {
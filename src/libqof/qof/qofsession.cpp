@@ -197,6 +197,12 @@ QofSessionImpl::load_backend (std::string access_method) noexcept
     LEAVE (" ");
 }
 
+static void
+log_stat (const char* name, gint64 value, gpointer)
+{
+    PINFO ("%s: %" G_GINT64_FORMAT, name, value);
+}
+
 void
 QofSessionImpl::load (QofPercentageFunc percentage_func) noexcept
 {
@@ -231,8 +237,13 @@ QofSessionImpl::load (QofPercentageFunc percentage_func) noexcept
         be->percentage = percentage_func;
         if (be->load)
         {
-            be->load (be, newbook, LOAD_TYPE_INITIAL_LOAD);
+            qof_backend_stats_clear (be);
+            {
+                QofBackendPhase phase {be, "session", "load"};
+                be->load (be, newbook, LOAD_TYPE_INITIAL_LOAD);
+            }
             push_error (qof_backend_get_error(be), {});
+            qof_backend_foreach_stat (be, log_stat, nullptr);
         }
     }
 
@@ -451,7 +462,8 @@ QofSessionImpl::is_saving () const noexcept
 /* Manipulators (save, load, etc.) -------------------------*/
 
 void
-QofSessionImpl::save (QofPercentageFunc percentage_func) noexcept
+QofSessionImpl::save (QofPercentageFunc percentage_func,
+                      bool in_background) noexcept
 {
     m_saving = true;
     ENTER ("sess=%p book_id=%s", this, m_book_id.c_str ());
@@ -471,9 +483,17 @@ QofSessionImpl::save (QofPercentageFunc percentage_func) noexcept
         /* if invoked as SaveAs(), then backend not yet set */
         qof_book_set_backend (m_book, backend);
         backend->percentage = percentage_func;
-        if (backend->sync)
+        auto sync = backend->sync;
+        if (in_background && backend->background_sync)
+            sync = backend->background_sync;
+        if (sync)
         {
-            (backend->sync)(backend, m_book);
+            qof_backend_stats_clear (backend);
+            {
+                QofBackendPhase phase {backend, "session", "save"};
+                (sync)(backend, m_book);
+            }
+            qof_backend_foreach_stat (backend, log_stat, nullptr);
             QofBackendError err {qof_backend_get_error (backend)};
             if (ERR_BACKEND_NO_ERR != err)
             {
@@ -501,8 +521,13 @@ QofSessionImpl::safe_save (QofPercentageFunc percentage_func) noexcept
     auto backend = qof_book_get_backend (m_book);
     if (!backend) return;
     if (!backend->safe_sync) return;
+    qof_backend_stats_clear (backend);
     backend->percentage = percentage_func;
-    (backend->safe_sync) (backend, get_book ());
+    {
+        QofBackendPhase phase {backend, "session", "safe-save"};
+        (backend->safe_sync) (backend, get_book ());
+    }
+    qof_backend_foreach_stat (backend, log_stat, nullptr);
     auto err = qof_backend_get_error (qof_book_get_backend (m_book));
     auto msg = qof_backend_get_message (qof_book_get_backend (m_book));
     if (err != ERR_BACKEND_NO_ERR)
@@ -519,7 +544,10 @@ QofSessionImpl::ensure_all_data_loaded () noexcept
     auto backend = qof_book_get_backend (m_book);
     if (!backend) return;
     if (!backend->load) return;
-    backend->load(backend, get_book (), LOAD_TYPE_LOAD_ALL);
+    {
+        QofBackendPhase phase {backend, "session", "load-all"};
+        backend->load(backend, get_book (), LOAD_TYPE_LOAD_ALL);
+    }
     push_error (qof_backend_get_error (backend), {});
 }
 
@@ -633,6 +661,23 @@ qof_session_get_backend (const QofSession *session)
     return session->get_backend ();
 }
 
+gint64
+qof_session_get_stat (const QofSession *session, const char *name)
+{
+    auto be = qof_session_get_backend (session);
+    if (!be) return 0;
+    return qof_backend_stat_get (be, name);
+}
+
+void
+qof_session_foreach_stat (const QofSession *session, QofSessionStatFunc func,
+                          gpointer user_data)
+{
+    auto be = qof_session_get_backend (session);
+    if (!be) return;
+    qof_backend_foreach_stat (be, func, user_data);
+}
+
 void
 qof_session_begin (QofSession *session, const char * book_id,
                    gboolean ignore_lock, gboolean create, gboolean force)
@@ -657,6 +702,14 @@ qof_session_save (QofSession *session,
     session->save (percentage_func);
 }
 
+void
+qof_session_save_in_background (QofSession *session,
+                                QofPercentageFunc percentage_func)
+{
+    if (!session) return;
+    session->save (percentage_func, true);
+}
+
 void
 qof_session_safe_save(QofSession *session, QofPercentageFunc percentage_func)
 {
@@ -227,6 +227,23 @@ gboolean qof_session_save_in_progress(const QofSession *session);
  */
 QofBackend * qof_session_get_backend(const QofSession *session);
 
+typedef void (*QofSessionStatFunc) (const char *name, gint64 value,
+                                    gpointer user_data);
+
+/**
+ * The qof_session_get_stat() routine returns one of the counters and
+ *    times the backend kept about the last load or save of the book,
+ *    or 0 if it has none by that name.  Names are a phase or an
+ *    object type under the backend's prefix, "xml.parse-usec" or
+ *    "sql.Trans" say; times are in microseconds.  The whole load or
+ *    save is "session.load-usec" or "session.save-usec".
+ */
+gint64 qof_session_get_stat (const QofSession *session, const char *name);
+
+/** Call func on every statistic of the last load or save. */
+void qof_session_foreach_stat (const QofSession *session,
+                               QofSessionStatFunc func, gpointer user_data);
+
 /** The qof_session_save() method will commit all changes that have been
  *    made to the session. For the file backend, this is nothing
  *    more than a write to the file of the current Accounts & etc.
@@ -236,6 +253,14 @@ QofBackend * qof_session_get_backend(const QofSession *session);
 void     qof_session_save (QofSession *session,
                            QofPercentageFunc percentage_func);
 
+/** Like qof_session_save(), but lets a backend which can do so finish
+ *    writing the data out in the background while the book is worked on. The book
+ *    counts as saved as it was when this returns; an error of the write
+ *    is reported by the next save.
+ */
+void     qof_session_save_in_background (QofSession *session,
+                                         QofPercentageFunc percentage_func);
+
 /**
  * A special version of save used in the sql backend which moves the
  * existing tables aside, then saves everything to new tables, then
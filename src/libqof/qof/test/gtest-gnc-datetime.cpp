@@ -24,6 +24,10 @@
 
 #include "../gnc-datetime.hpp"
 #include <gtest/gtest.h>
+#include <chrono>
+#include <ctime>
+#include <iostream>
+#include <stdexcept>
 
 TEST(gnc_date_constructors, test_default_constructor)
 {
@@ -87,3 +91,71 @@ TEST(gnc_datetime_functions, test_date)
     EXPECT_EQ(ymd.month, 11);
     EXPECT_EQ(ymd.day, 13);
 }
+
+static void
+expect_same_tm(const struct tm& tm, const struct tm& expected)
+{
+    EXPECT_EQ(tm.tm_year, expected.tm_year);
+    EXPECT_EQ(tm.tm_mon, expected.tm_mon);
+    EXPECT_EQ(tm.tm_mday, expected.tm_mday);
+    EXPECT_EQ(tm.tm_hour, expected.tm_hour);
+    EXPECT_EQ(tm.tm_min, expected.tm_min);
+    EXPECT_EQ(tm.tm_sec, expected.tm_sec);
+    EXPECT_EQ(tm.tm_wday, expected.tm_wday);
+    EXPECT_EQ(tm.tm_yday, expected.tm_yday);
+    EXPECT_EQ(tm.tm_isdst, expected.tm_isdst);
+}
+
+//Every 7 minutes across a year, so that the DST changes are crossed.
+TEST(gnc_datetime_functions, test_local_tm)
+{
+    const time64 start = 2366755200; //2045-01-01 00:00:00 Z
+    for (time64 time = start; time < start + 366 * 86400; time += 7 * 60)
+    {
+        auto expected = static_cast<struct tm>(GncDateTime(time));
+        auto tm = GncDateTime::local_tm(time);
+        expect_same_tm(tm, expected);
+        auto ymd = GncDateTime::local_ymd(time);
+        EXPECT_EQ(ymd.year, tm.tm_year + 1900);
+        EXPECT_EQ(ymd.month, tm.tm_mon + 1);
+        EXPECT_EQ(ymd.day, tm.tm_mday);
+    }
+    expect_same_tm(GncDateTime::local_tm(-4102444800), //1840-01-01 00:00:00 Z
+                   static_cast<struct tm>(GncDateTime(-4102444800)));
+    EXPECT_THROW(GncDateTime::local_tm(-20000000000), std::invalid_argument);
+    EXPECT_THROW(GncDateTime::local_ymd(260000000000), std::invalid_argument);
+}
+
+//Run with --gtest_also_run_disabled_tests.
+TEST(gnc_datetime_functions, DISABLED_benchmark)
+{
+    const time64 start = 1262304000; //2010-01-01 00:00:00 Z
+    const int count = 200000;
+    auto seconds = [](std::chrono::steady_clock::time_point begin) {
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - begin;
+        return elapsed.count();
+    };
+    int days = 0;
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; ++i)
+        days += static_cast<struct tm>(GncDateTime(start + i * 3001)).tm_mday;
+    double boost_secs = seconds(begin);
+
+    begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; ++i)
+        days -= GncDateTime::local_tm(start + i * 3001).tm_mday;
+    double tm_secs = seconds(begin);
+
+    begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; ++i)
+        days += GncDateTime::local_ymd(start + i * 3001).day;
+    double ymd_secs = seconds(begin);
+    EXPECT_NE(days, 0);
+
+    std::cout << "GncDateTime to struct tm: " << count / boost_secs
+              << " conversions/s\nlocal_tm: " << count / tm_secs
+              << " conversions/s\nlocal_ymd: " << count / ymd_secs
+              << " conversions/s" << std::endl;
+}
@@ -0,0 +1,223 @@
+/********************************************************************
+ * gtest-gnc-guid-map.cpp -- unit tests for the GncGUIDMap class    *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+ *******************************************************************/
+
+extern "C"
+{
+#include <glib.h>
+}
+#include <gtest/gtest.h>
+#include "../gnc-guid-map.hpp"
+#include "../guid.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <map>
+
+static std::vector<GncGUID>
+make_guids (std::size_t count)
+{
+    std::vector<GncGUID> guids;
+    guids.reserve (count);
+    for (std::size_t i = 0; i < count; ++i)
+        guids.push_back (GncGUID::create_random ());
+    return guids;
+}
+
+/* GUIDs differing only in their last bytes, like hand-made ones. */
+static std::vector<GncGUID>
+make_sequential_guids (std::size_t count)
+{
+    std::vector<GncGUID> guids (count, GncGUID::null_guid ());
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        guids[i].data[15] = static_cast<uint8_t>(i);
+        guids[i].data[14] = static_cast<uint8_t>(i >> 8);
+    }
+    return guids;
+}
+
+static void*
+value_for (std::size_t i)
+{
+    return reinterpret_cast<void*>(static_cast<uintptr_t>(i + 1));
+}
+
+TEST(GncGUIDMap, empty)
+{
+    GncGUIDMap map;
+    EXPECT_EQ (0u, map.size ());
+    EXPECT_EQ (nullptr, map.lookup (GncGUID::create_random ()));
+    EXPECT_FALSE (map.remove (GncGUID::create_random ()));
+    EXPECT_TRUE (map.values ().empty ());
+}
+
+TEST(GncGUIDMap, insert_lookup_replace)
+{
+    GncGUIDMap map;
+    auto guids = make_guids (1000);
+    for (std::size_t i = 0; i < guids.size (); ++i)
+        map.insert (guids[i], value_for (i));
+    EXPECT_EQ (guids.size (), map.size ());
+    for (std::size_t i = 0; i < guids.size (); ++i)
+        EXPECT_EQ (value_for (i), map.lookup (guids[i]));
+    EXPECT_EQ (nullptr, map.lookup (GncGUID::create_random ()));
+
+    map.insert (guids[7], value_for (5000));
+    EXPECT_EQ (guids.size (), map.size ());
+    EXPECT_EQ (value_for (5000), map.lookup (guids[7]));
+
+    map.insert (GncGUID::create_random (), nullptr);
+    EXPECT_EQ (guids.size (), map.size ());
+}
+
+/* Removing from the middle of probe runs mustn't lose the entries after
+ * the removed one; sequential GUIDs make for long runs. */
+static void
+check_removal (const std::vector<GncGUID>& guids)
+{
+    GncGUIDMap map;
+    std::map<std::size_t, bool> present;
+    for (std::size_t i = 0; i < guids.size (); ++i)
+    {
+        map.insert (guids[i], value_for (i));
+        present[i] = true;
+    }
+    for (std::size_t i = 0; i < guids.size (); i += 3)
+    {
+        EXPECT_TRUE (map.remove (guids[i]));
+        EXPECT_FALSE (map.remove (guids[i]));
+        present[i] = false;
+    }
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < guids.size (); ++i)
+    {
+        EXPECT_EQ (present[i] ? value_for (i) : nullptr,
+                   map.lookup (guids[i]));
+        count += present[i];
+    }
+    EXPECT_EQ (count, map.size ());
+    EXPECT_EQ (count, map.values ().size ());
+}
+
+TEST(GncGUIDMap, remove_random)
+{
+    check_removal (make_guids (5000));
+}
+
+TEST(GncGUIDMap, remove_sequential)
+{
+    check_removal (make_sequential_guids (5000));
+}
+
+TEST(GncGUIDMap, values)
+{
+    GncGUIDMap map;
+    auto guids = make_guids (100);
+    for (std::size_t i = 0; i < guids.size (); ++i)
+        map.insert (guids[i], value_for (i));
+
+    auto values = map.values ();
+    ASSERT_EQ (guids.size (), values.size ());
+    std::sort (values.begin (), values.end ());
+    for (std::size_t i = 0; i < guids.size (); ++i)
+        EXPECT_EQ (value_for (i), values[i]);
+
+    /* The snapshot doesn't change under the caller. */
+    for (auto& guid : guids)
+        map.remove (guid);
+    EXPECT_EQ (guids.size (), values.size ());
+    EXPECT_EQ (0u, map.size ());
+}
+
+TEST(GncGUIDMap, next)
+{
+    GncGUIDMap map;
+    auto guids = make_guids (100);
+    for (std::size_t i = 0; i < guids.size (); ++i)
+        map.insert (guids[i], value_for (i));
+
+    std::vector<void*> walked;
+    std::size_t slot = 0;
+    while (auto value = map.next (slot))
+        walked.push_back (value);
+    EXPECT_EQ (nullptr, map.next (slot));
+
+    auto values = map.values ();
+    EXPECT_EQ (values, walked);
+}
+
+/* Compares the map with the GHashTable that QofCollection used before.
+ * Run it with --gtest_also_run_disabled_tests. The GHashTable's memory
+ * isn't reported by GLib; the figure is worked out from its layout of a
+ * key, a value and a hash per bucket, with the bucket count being the
+ * next power of two at least 4/3 of the entries. */
+TEST(GncGUIDMap, DISABLED_benchmark)
+{
+    const std::size_t count = 200000;
+    const int rounds = 10;
+    auto guids = make_guids (count);
+    auto probes = guids;
+    std::random_shuffle (probes.begin (), probes.end ());
+
+    auto seconds = [](std::chrono::steady_clock::time_point start) {
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now () - start;
+        return elapsed.count ();
+    };
+
+    GncGUIDMap map;
+    for (std::size_t i = 0; i < count; ++i)
+        map.insert (guids[i], value_for (i));
+    std::size_t found = 0;
+    auto start = std::chrono::steady_clock::now ();
+    for (int r = 0; r < rounds; ++r)
+        for (const auto& guid : probes)
+            found += map.lookup (guid) != nullptr;
+    double map_secs = seconds (start);
+    EXPECT_EQ (count * rounds, found);
+
+    GHashTable *hash = guid_hash_table_new ();
+    for (std::size_t i = 0; i < count; ++i)
+        g_hash_table_insert (hash, &guids[i], value_for (i));
+    found = 0;
+    start = std::chrono::steady_clock::now ();
+    for (int r = 0; r < rounds; ++r)
+        for (const auto& guid : probes)
+            found += g_hash_table_lookup (hash, &guid) != nullptr;
+    double hash_secs = seconds (start);
+    EXPECT_EQ (count * rounds, found);
+    g_hash_table_destroy (hash);
+
+    std::size_t buckets = 8;
+    while (buckets * 3 < count * 4)
+        buckets <<= 1;
+    double hash_bytes = buckets * (2 * sizeof (gpointer) + sizeof (guint));
+
+    std::cout << "GncGUIDMap: "
+              << count * rounds / map_secs << " lookups/s, "
+              << static_cast<double>(map.memory_used ()) / count
+              << " bytes/entity" << std::endl;
+    std::cout << "GHashTable: "
+              << count * rounds / hash_secs << " lookups/s, "
+              << hash_bytes / count << " bytes/entity" << std::endl;
+}
@@ -24,6 +24,11 @@
 #include <gtest/gtest.h>
 #include "../gnc-int128.hpp"
 
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
 TEST(qofint128_constructors, test_default_constructor)
 {
     GncInt128 value {};
@@ -465,3 +470,133 @@ TEST(qofint128_functions, pow)
     auto over = minus.pow(9);
     EXPECT_TRUE(over.isOverflow());
 }
+
+/* Random magnitudes of random lengths, so that the single-leg, two-leg and
+ * overflowing cases all come up, with random signs. */
+static std::vector<GncInt128>
+random_values (std::size_t count, unsigned int max_bits = GncInt128::maxbits)
+{
+    std::mt19937_64 gen (20161027);
+    std::vector<GncInt128> values;
+    values.reserve (count);
+    while (values.size () < count)
+    {
+        unsigned int bits = gen () % max_bits + 1;
+        uint64_t hi = bits > 64 ? gen () >> (128 - bits) : 0;
+        uint64_t lo = bits >= 64 ? gen () : gen () >> (64 - bits);
+        if (!hi && !lo)
+            continue;
+        values.emplace_back (hi, lo, gen () & 1 ? GncInt128::neg
+                                                : GncInt128::pos);
+    }
+    return values;
+}
+
+#ifdef __SIZEOF_INT128__
+/* Checks the results against the compiler's 128-bit integers whichever
+ * implementation GncInt128 was built with. */
+typedef unsigned __int128 uint128;
+
+/* Read back from the decimal string, so as not to depend on any other
+ * GncInt128 operator. */
+static uint128
+magnitude (const GncInt128& value)
+{
+    char buf[41] {};
+    uint128 result = 0;
+    for (const char* c = value.asCharBufR (buf); *c; ++c)
+        if (*c != '-')
+            result = result * 10 + (*c - '0');
+    return result;
+}
+
+static GncInt128
+from_magnitude (uint128 mag, bool neg)
+{
+    return GncInt128 (static_cast<uint64_t>(mag >> 64),
+                      static_cast<uint64_t>(mag),
+                      neg ? GncInt128::neg : GncInt128::pos);
+}
+
+TEST(qofint128_functions, cross_check)
+{
+    auto values = random_values (2000);
+    for (std::size_t i = 0; i + 1 < values.size (); i += 2)
+    {
+        GncInt128 a = values[i], b = values[i + 1];
+        uint128 ua = magnitude (a), ub = magnitude (b);
+        bool neg = a.isNeg () != b.isNeg ();
+
+        auto product = a * b;
+        if (a.bits () + b.bits () > GncInt128::maxbits)
+            EXPECT_TRUE (product.isOverflow ()) << a << " * " << b;
+        else
+            EXPECT_EQ (from_magnitude (ua * ub, neg), product)
+                << a << " * " << b;
+
+        GncInt128 q {}, r {};
+        a.div (b, q, r);
+        if (ua < ub)
+        {
+            EXPECT_TRUE (q.isZero ()) << a << " / " << b;
+            EXPECT_EQ (a, r) << a << " % " << b;
+        }
+        else
+        {
+            EXPECT_EQ (from_magnitude (ua / ub, neg), q) << a << " / " << b;
+            EXPECT_EQ (from_magnitude (ua % ub, false), r) << a << " % " << b;
+        }
+
+        uint128 x = ua, y = ub;
+        while (y)
+        {
+            uint128 t = x % y;
+            x = y;
+            y = t;
+        }
+        EXPECT_EQ (from_magnitude (x, false), a.gcd (b))
+            << "gcd (" << a << ", " << b << ")";
+    }
+}
+#endif
+
+/* Times the multiplication, division and GCD of random values. Run it
+ * with --gtest_also_run_disabled_tests; build gnc-int128.cpp with
+ * GNC_INT128_PORTABLE defined to compare with the portable code. */
+TEST(qofint128_functions, DISABLED_benchmark)
+{
+    const int rounds = 200;
+    auto values = random_values (10000);
+    auto small = random_values (values.size (), GncInt128::legbits);
+
+    auto seconds = [](std::chrono::steady_clock::time_point start) {
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now () - start;
+        return elapsed.count ();
+    };
+    unsigned int checksum = 0;
+
+    auto start = std::chrono::steady_clock::now ();
+    for (int n = 0; n < rounds; ++n)
+        for (std::size_t i = 0; i + 1 < small.size (); ++i)
+            checksum += (small[i] * small[i + 1]).bits ();
+    double mul_secs = seconds (start);
+
+    start = std::chrono::steady_clock::now ();
+    for (int n = 0; n < rounds; ++n)
+        for (std::size_t i = 0; i + 1 < values.size (); ++i)
+            checksum += (values[i] / small[i + 1]).bits ();
+    double div_secs = seconds (start);
+
+    start = std::chrono::steady_clock::now ();
+    for (int n = 0; n < rounds / 10; ++n)
+        for (std::size_t i = 0; i + 1 < values.size (); ++i)
+            checksum += values[i].gcd (values[i + 1]).bits ();
+    double gcd_secs = seconds (start);
+
+    auto ops = static_cast<double>(values.size () - 1) * rounds;
+    std::cout << "multiply: " << ops / mul_secs << " ops/s" << std::endl;
+    std::cout << "divide: " << ops / div_secs << " ops/s" << std::endl;
+    std::cout << "gcd: " << ops / 10 / gcd_secs << " ops/s" << std::endl;
+    EXPECT_NE (0u, checksum);
+}
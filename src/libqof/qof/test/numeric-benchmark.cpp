@@ -0,0 +1,260 @@
+/********************************************************************
+ * numeric-benchmark.cpp: speed of gnc_numeric, GncInt128 and       *
+ *                        GncRational                               *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+********************************************************************/
+
+/* The operand patterns are the ones the engine sees most: amounts
+ * with the same currency denominator, a price denominator against a
+ * currency one, and values big enough to need the 128 bit paths. */
+
+extern "C"
+{
+#include "config.h"
+#include <glib.h>
+#include "gnc-numeric.h"
+#include "benchmark-support.h"
+}
+#include "../gnc-int128.hpp"
+#include "../gnc-rational.hpp"
+
+struct Operands
+{
+    const char *name;
+    gnc_numeric a;
+    gnc_numeric b;
+};
+
+static const Operands patterns[] =
+{
+    /* Two amounts in cents. */
+    { "same-denom", { 123456, 100 }, { 98765, 100 } },
+    /* A currency amount and a share count or price. */
+    { "mixed-denom", { 123456, 100 }, { 3333333, 10000 } },
+    /* Operands whose products overflow 64 bits. */
+    { "large", { INT64_C(123456789012345), 100 },
+      { INT64_C(987654321098), 1000000 } },
+};
+
+typedef gnc_numeric (*NumericOp) (gnc_numeric, gnc_numeric, gint64, gint);
+
+struct NumericBench
+{
+    NumericOp op;
+    const Operands *operands;
+    gint64 denom;
+    gint how;
+};
+
+static void
+bench_numeric (gpointer data, guint64 iterations)
+{
+    auto b = static_cast<NumericBench*>(data);
+    gnc_numeric a = b->operands->a;
+
+    for (guint64 i = 0; i < iterations; i++)
+    {
+        gnc_numeric r = b->op (a, b->operands->b, b->denom, b->how);
+        gnc_benchmark_consume (r.num);
+    }
+}
+
+static void
+bench_convert (gpointer data, guint64 iterations)
+{
+    auto operands = static_cast<const Operands*>(data);
+
+    for (guint64 i = 0; i < iterations; i++)
+    {
+        gnc_numeric r = gnc_numeric_convert (operands->b, 100,
+                                             GNC_HOW_RND_ROUND_HALF_UP);
+        gnc_benchmark_consume (r.num);
+    }
+}
+
+static void
+bench_reduce (gpointer data, guint64 iterations)
+{
+    auto operands = static_cast<const Operands*>(data);
+    gnc_numeric n = gnc_numeric_create (operands->a.num * 6,
+                                        operands->a.denom * 6);
+
+    for (guint64 i = 0; i < iterations; i++)
+    {
+        gnc_numeric r = gnc_numeric_reduce (n);
+        gnc_benchmark_consume (r.num);
+    }
+}
+
+static void
+bench_rational_reduce (gpointer data, guint64 iterations)
+{
+    auto operands = static_cast<const Operands*>(data);
+    GncRational n (GncInt128 (operands->a.num) * 6,
+                   GncInt128 (operands->a.denom) * 6);
+
+    for (guint64 i = 0; i < iterations; i++)
+    {
+        GncRational r (n);
+        GncDenom d (r, r, GNC_DENOM_AUTO, GNC_HOW_DENOM_REDUCE);
+        r.round (d);
+        gnc_benchmark_consume (static_cast<int64_t>(r.m_den));
+    }
+}
+
+static void
+bench_rational_mul (gpointer data, guint64 iterations)
+{
+    auto operands = static_cast<const Operands*>(data);
+    GncRational a (operands->a), b (operands->b);
+
+    for (guint64 i = 0; i < iterations; i++)
+    {
+        GncRational r (a);
+        GncDenom d (r, b, 100, GNC_HOW_RND_ROUND_HALF_UP);
+        r.mul (b, d);
+        gnc_benchmark_consume (static_cast<int64_t>(r.m_num));
+    }
+}
+
+static void
+bench_int128_mul (gpointer data, guint64 iterations)
+{
+    auto operands = static_cast<const Operands*>(data);
+    GncInt128 a (operands->a.num), b (operands->b.num);
+
+    for (guint64 i = 0; i < iterations; i++)
+    {
+        GncInt128 r = a * b;
+        gnc_benchmark_consume (r.isBig () ? 1 : static_cast<int64_t>(r));
+    }
+}
+
+static void
+bench_int128_div (gpointer data, guint64 iterations)
+{
+    auto operands = static_cast<const Operands*>(data);
+    GncInt128 a = GncInt128 (operands->a.num) * GncInt128 (operands->b.num);
+    GncInt128 b (operands->b.denom);
+
+    for (guint64 i = 0; i < iterations; i++)
+    {
+        GncInt128 r = a / b;
+        gnc_benchmark_consume (r.isBig () ? 1 : static_cast<int64_t>(r));
+    }
+}
+
+static void
+bench_int128_gcd (gpointer data, guint64 iterations)
+{
+    auto operands = static_cast<const Operands*>(data);
+    GncInt128 a (operands->a.num), b (operands->b.num);
+
+    for (guint64 i = 0; i < iterations; i++)
+        gnc_benchmark_consume (static_cast<int64_t>(a.gcd (b)));
+}
+
+static void
+bench_to_string (gpointer data, guint64 iterations)
+{
+    auto operands = static_cast<const Operands*>(data);
+
+    for (guint64 i = 0; i < iterations; i++)
+    {
+        gchar *str = gnc_numeric_to_string (operands->a);
+        gnc_benchmark_consume (str[0]);
+        g_free (str);
+    }
+}
+
+static void
+bench_from_string (gpointer data, guint64 iterations)
+{
+    auto operands = static_cast<const Operands*>(data);
+    gchar *str = gnc_numeric_to_string (operands->a);
+    gnc_numeric n;
+
+    for (guint64 i = 0; i < iterations; i++)
+    {
+        string_to_gnc_numeric (str, &n);
+        gnc_benchmark_consume (n.num);
+    }
+    g_free (str);
+}
+
+int
+main (int argc, char **argv)
+{
+    static const struct
+    {
+        const char *name;
+        NumericOp op;
+    } ops[] =
+    {
+        { "add", gnc_numeric_add },
+        { "sub", gnc_numeric_sub },
+        { "mul", gnc_numeric_mul },
+        { "div", gnc_numeric_div },
+    };
+    const guint64 n = 1000000;
+
+    gnc_benchmark_init (&argc, &argv);
+
+    for (auto& pattern : patterns)
+    {
+        gpointer data = const_cast<Operands*>(&pattern);
+        gchar *name;
+
+        for (auto& op : ops)
+        {
+            NumericBench exact = { op.op, &pattern, GNC_DENOM_AUTO,
+                                   GNC_HOW_DENOM_EXACT };
+            NumericBench fixed = { op.op, &pattern, 100,
+                                   GNC_HOW_DENOM_FIXED |
+                                   GNC_HOW_RND_ROUND_HALF_UP };
+
+            name = g_strdup_printf ("numeric-%s-exact/%s", op.name,
+                                    pattern.name);
+            gnc_benchmark_run (name, bench_numeric, &exact, n);
+            g_free (name);
+            name = g_strdup_printf ("numeric-%s-fixed/%s", op.name,
+                                    pattern.name);
+            gnc_benchmark_run (name, bench_numeric, &fixed, n);
+            g_free (name);
+        }
+
+#define RUN(label, fn, count)                                           \
+        name = g_strdup_printf ("%s/%s", label, pattern.name);          \
+        gnc_benchmark_run (name, fn, data, count);                      \
+        g_free (name)
+
+        RUN ("numeric-convert", bench_convert, n);
+        RUN ("numeric-reduce", bench_reduce, n);
+        RUN ("rational-reduce", bench_rational_reduce, n);
+        RUN ("rational-mul", bench_rational_mul, n);
+        RUN ("int128-mul", bench_int128_mul, 10 * n);
+        RUN ("int128-div", bench_int128_div, n);
+        RUN ("int128-gcd", bench_int128_gcd, n);
+        RUN ("numeric-to-string", bench_to_string, n / 4);
+        RUN ("string-to-numeric", bench_from_string, n / 4);
+#undef RUN
+    }
+
+    return gnc_benchmark_finish ();
+}
@@ -1540,6 +1540,66 @@ test_qof_scan_date (void)
     setlocale (LC_TIME, locale);
     g_free (locale);
 }
+/* gnc_parse_date
+time64
+gnc_parse_date (const char *str, GncDateOrder order)
+*/
+static void
+test_gnc_parse_date (void)
+{
+    time64 now = gnc_time (NULL);
+    struct tm tm;
+    gint year;
+    guint i;
+    struct
+    {
+        const gchar *str;
+        GncDateOrder order;
+        gint year, month, day;
+    } dates[] =
+    {
+        { "2013-08-01", GNC_DATE_ORDER_YMD, 2013, 8, 1 },
+        { " 2013 / 8 . 1 and more", GNC_DATE_ORDER_YMD, 2013, 8, 1 },
+        { "20130801", GNC_DATE_ORDER_YMD, 2013, 8, 1 },
+        { "3'6'8", GNC_DATE_ORDER_YMD, 2003, 6, 8 },
+        { "70-6-8", GNC_DATE_ORDER_YMD, 1970, 6, 8 },
+        { "01-08-2013", GNC_DATE_ORDER_DMY, 2013, 8, 1 },
+        { "01082013", GNC_DATE_ORDER_DMY, 2013, 8, 1 },
+        { "2/29/2016", GNC_DATE_ORDER_MDY, 2016, 2, 29 },
+        { "1-8", GNC_DATE_ORDER_DM, 0, 8, 1 },
+        { "8/1", GNC_DATE_ORDER_MD, 0, 8, 1 },
+        { "2/29/2015", GNC_DATE_ORDER_MDY, -1, 0, 0 },
+        { "2013-13-01", GNC_DATE_ORDER_YMD, -1, 0, 0 },
+        { "2013-08-00", GNC_DATE_ORDER_YMD, -1, 0, 0 },
+        { "0999-08-01", GNC_DATE_ORDER_YMD, -1, 0, 0 },
+        { "130801", GNC_DATE_ORDER_YMD, -1, 0, 0 },
+        { "0801", GNC_DATE_ORDER_MD, -1, 0, 0 },
+        { "08-01", GNC_DATE_ORDER_YMD, -1, 0, 0 },
+        { "2013-08-01", GNC_DATE_ORDER_MD, -1, 0, 0 },
+        { "", GNC_DATE_ORDER_YMD, -1, 0, 0 },
+    };
+
+    gnc_localtime_r (&now, &tm);
+    year = tm.tm_year + 1900;
+    g_assert_cmpint (gnc_parse_date (NULL, GNC_DATE_ORDER_YMD), ==, -1);
+    /* Twice, the second time from the memo. */
+    for (i = 0; i < 2 * G_N_ELEMENTS (dates); ++i)
+    {
+        time64 time = gnc_parse_date (dates[i / 2].str, dates[i / 2].order);
+        if (dates[i / 2].year < 0)
+        {
+            g_assert_cmpint (time, ==, -1);
+            continue;
+        }
+        gnc_localtime_r (&time, &tm);
+        g_assert_cmpint (tm.tm_year + 1900, ==,
+                         dates[i / 2].year ? dates[i / 2].year : year);
+        g_assert_cmpint (tm.tm_mon + 1, ==, dates[i / 2].month);
+        g_assert_cmpint (tm.tm_mday, ==, dates[i / 2].day);
+        g_assert_cmpint (tm.tm_hour, ==, 11);
+        g_assert_cmpint (tm.tm_min, ==, 0);
+    }
+}
 /* dateSeparator
 return date character
 char dateSeparator (void)// C: 1  Local: 0:0:0
@@ -2162,6 +2222,7 @@ test_suite_gnc_date (void)
 // GNC_TEST_ADD_FUNC (suitename, "floordiv", test_floordiv);
 // GNC_TEST_ADD_FUNC (suitename, "qof scan date internal", test_qof_scan_date_internal);
     GNC_TEST_ADD_FUNC (suitename, "qof scan date", test_qof_scan_date);
+    GNC_TEST_ADD_FUNC (suitename, "gnc parse date", test_gnc_parse_date);
 // GNC_TEST_ADD_FUNC (suitename, "dateSeparator", test_dateSeparator);
 // GNC_TEST_ADD_FUNC (suitename, "qof time format from utf8", test_qof_time_format_from_utf8);
 // GNC_TEST_ADD_FUNC (suitename, "qof formatted time to utf8", test_qof_formatted_time_to_utf8);
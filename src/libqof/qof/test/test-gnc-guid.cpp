@@ -23,12 +23,17 @@
  ********************************************************************/
 
 #include "../guid.hpp"
+#include "../guid.h"
 
+#include <algorithm>
+#include <chrono>
 #include <random>
 #include <sstream>
 #include <iomanip>
 #include <string>
 #include <iostream>
+#include <thread>
+#include <vector>
 #include <gtest/gtest.h>
 
 TEST (GncGUID, creation)
@@ -94,3 +99,119 @@ TEST (GncGUID, round_trip)
     EXPECT_EQ (guid1, guid2);
 }
 
+
+TEST (GncGUID, string_to_guid)
+{
+    GncGUID guid;
+    char buff[GUID_ENCODING_LENGTH + 1];
+    EXPECT_TRUE (string_to_guid ("0123456789abcdefFEDCBA9876543210", &guid));
+    EXPECT_EQ (guid_to_string_buff (&guid, buff), buff + GUID_ENCODING_LENGTH);
+    EXPECT_STREQ ("0123456789abcdeffedcba9876543210", buff);
+    EXPECT_EQ ("0123456789abcdeffedcba9876543210", guid.to_string ());
+    EXPECT_EQ (0x01, guid.data[0]);
+    EXPECT_EQ (0x10, guid.data[15]);
+
+    auto saved = guid;
+    /* Other spellings are still handed to boost. */
+    EXPECT_TRUE (string_to_guid ("01234567-89ab-cdef-fedc-ba9876543210", &guid));
+    EXPECT_EQ (saved, guid);
+}
+
+TEST (GncGUID, string_array)
+{
+    std::vector<GncGUID> guids, parsed (100);
+    for (int i = 0; i < 100; ++i)
+        guids.push_back (GncGUID::create_random ());
+    std::vector<char> buff (guids.size () * (GUID_ENCODING_LENGTH + 1));
+    guid_array_to_string_buff (guids.data (), guids.size (), buff.data ());
+
+    std::vector<const char*> strs;
+    for (std::size_t i = 0; i < guids.size (); ++i)
+    {
+        strs.push_back (&buff[i * (GUID_ENCODING_LENGTH + 1)]);
+        EXPECT_EQ (guids[i].to_string (), strs.back ());
+    }
+    EXPECT_TRUE (string_array_to_guid (strs.data (), strs.size (),
+                                       parsed.data ()));
+    EXPECT_EQ (guids, parsed);
+
+    strs[0] = nullptr;
+    parsed[0] = GncGUID::null_guid ();
+    EXPECT_FALSE (string_array_to_guid (strs.data (), strs.size (),
+                                        parsed.data ()));
+    EXPECT_EQ (GncGUID::null_guid (), parsed[0]);
+    EXPECT_EQ (guids[1], parsed[1]);
+}
+
+/* Run with --gtest_also_run_disabled_tests. */
+TEST (GncGUID, DISABLED_string_benchmark)
+{
+    const std::size_t count = 1000000;
+    std::vector<GncGUID> guids;
+    for (std::size_t i = 0; i < count; ++i)
+        guids.push_back (GncGUID::create_random ());
+    std::vector<char> buff (count * (GUID_ENCODING_LENGTH + 1));
+    std::vector<const char*> strs;
+    for (std::size_t i = 0; i < count; ++i)
+        strs.push_back (&buff[i * (GUID_ENCODING_LENGTH + 1)]);
+
+    auto start = std::chrono::steady_clock::now ();
+    guid_array_to_string_buff (guids.data (), count, buff.data ());
+    std::chrono::duration<double> encode =
+        std::chrono::steady_clock::now () - start;
+
+    start = std::chrono::steady_clock::now ();
+    EXPECT_TRUE (string_array_to_guid (strs.data (), count, guids.data ()));
+    std::chrono::duration<double> decode =
+        std::chrono::steady_clock::now () - start;
+
+    start = std::chrono::steady_clock::now ();
+    for (std::size_t i = 0; i < count; ++i)
+        guids[i] = GncGUID::from_string (strs[i]);
+    std::chrono::duration<double> boost_decode =
+        std::chrono::steady_clock::now () - start;
+
+    std::cout << "encode: " << count / encode.count () << " GUIDs/s\n"
+              << "decode: " << count / decode.count () << " GUIDs/s\n"
+              << "boost decode: " << count / boost_decode.count ()
+              << " GUIDs/s" << std::endl;
+}
+
+static std::vector<GncGUID>
+create_in_threads (unsigned int n_threads, std::size_t per_thread)
+{
+    std::vector<GncGUID> guids (n_threads * per_thread);
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < n_threads; ++t)
+        threads.emplace_back ([&guids, t, per_thread] {
+                for (std::size_t i = 0; i < per_thread; ++i)
+                    guids[t * per_thread + i] = GncGUID::create_random ();
+            });
+    for (auto& thread : threads)
+        thread.join ();
+    return guids;
+}
+
+TEST (GncGUID, threads)
+{
+    auto guids = create_in_threads (8, 10000);
+    std::sort (guids.begin (), guids.end ());
+    EXPECT_EQ (guids.end (), std::adjacent_find (guids.begin (), guids.end ()));
+    EXPECT_NE (guids.front (), GncGUID::null_guid ());
+}
+
+/* Run with --gtest_also_run_disabled_tests. */
+TEST (GncGUID, DISABLED_benchmark)
+{
+    const std::size_t count = 1000000;
+    unsigned int n_threads = std::max (std::thread::hardware_concurrency (), 1u);
+    for (unsigned int threads = 1; threads <= n_threads; threads *= 2)
+    {
+        auto start = std::chrono::steady_clock::now ();
+        create_in_threads (threads, count / threads);
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now () - start;
+        std::cout << threads << " threads: " << count / elapsed.count ()
+                  << " GUIDs/s" << std::endl;
+    }
+}
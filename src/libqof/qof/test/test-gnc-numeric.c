@@ -40,8 +40,208 @@ test_gnc_numeric_add (void)
     g_assert (gnc_numeric_equal (result, goal_ab));
 }
 
+#define assert_numeric(result, n, d) \
+    G_STMT_START { \
+        g_assert_cmpint ((result).num, ==, (n)); \
+        g_assert_cmpint ((result).denom, ==, (d)); \
+    } G_STMT_END
+
+/* Amounts with the same denominator are added without GncRational unless
+ * the sum overflows, which must still be reported. */
+static void
+test_gnc_numeric_add_same_denom (void)
+{
+    gnc_numeric a = { 12345, 100 };
+    gnc_numeric b = { -345, 100 };
+    gnc_numeric big = { INT64_MAX / 100 * 100, 100 };
+    gnc_numeric result;
+
+    result = gnc_numeric_add (a, b, GNC_DENOM_AUTO, GNC_HOW_DENOM_FIXED);
+    assert_numeric (result, 12000, 100);
+    result = gnc_numeric_add (a, b, GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
+    assert_numeric (result, 12000, 100);
+    result = gnc_numeric_add (a, b, 100, GNC_HOW_RND_NEVER);
+    assert_numeric (result, 12000, 100);
+    result = gnc_numeric_sub (a, b, GNC_DENOM_AUTO, GNC_HOW_DENOM_EXACT);
+    assert_numeric (result, 12690, 100);
+    /* Reducing and other denominators still go the long way. */
+    result = gnc_numeric_add (a, b, GNC_DENOM_AUTO, GNC_HOW_DENOM_REDUCE);
+    assert_numeric (result, 120, 1);
+    result = gnc_numeric_add (a, b, 10, GNC_HOW_RND_ROUND_HALF_UP);
+    assert_numeric (result, 1200, 10);
+
+    result = gnc_numeric_add (big, big, GNC_DENOM_AUTO, GNC_HOW_DENOM_FIXED);
+    g_assert_cmpint (gnc_numeric_check (result), ==, GNC_ERROR_OVERFLOW);
+}
+
+/* A product is only made without GncRational if it needs no rounding. */
+static void
+test_gnc_numeric_mul_exact (void)
+{
+    gnc_numeric amount = { 150, 100 };
+    gnc_numeric count = { 3, 1 };
+    gnc_numeric a = { 15, 10 };
+    gnc_numeric b = { 25, 10 };
+    gnc_numeric result;
+
+    result = gnc_numeric_mul (amount, count, 100, GNC_HOW_RND_ROUND_HALF_UP);
+    assert_numeric (result, 450, 100);
+    result = gnc_numeric_mul (a, b, GNC_DENOM_AUTO, GNC_HOW_DENOM_EXACT);
+    assert_numeric (result, 375, 100);
+    result = gnc_numeric_mul (a, b, GNC_DENOM_AUTO, GNC_HOW_DENOM_FIXED |
+                              GNC_HOW_RND_ROUND_HALF_UP);
+    assert_numeric (result, 38, 10);
+    result = gnc_numeric_mul (a, b, 10, GNC_HOW_RND_NEVER);
+    g_assert_cmpint (gnc_numeric_check (result), ==, GNC_ERROR_REMAINDER);
+}
+
+/* Conversions between denominators that divide each other don't go
+ * through GncRational; they must still round the same way. */
+static void
+test_gnc_numeric_convert_decimal (void)
+{
+    gnc_numeric a = gnc_numeric_create (123456789, 1000000);
+    gnc_numeric b = gnc_numeric_create (-123455, 1000);
+    gnc_numeric c = gnc_numeric_create (125, 100);
+
+    assert_numeric (gnc_numeric_convert (c, 100000, GNC_HOW_RND_NEVER),
+                    125000, 100000);
+    assert_numeric (gnc_numeric_convert (c, 1, GNC_HOW_RND_ROUND), 1, 1);
+    assert_numeric (gnc_numeric_convert (a, 100, GNC_HOW_RND_ROUND),
+                    12346, 100);
+    assert_numeric (gnc_numeric_convert (a, 100, GNC_HOW_RND_TRUNC),
+                    12345, 100);
+    assert_numeric (gnc_numeric_convert (b, 100, GNC_HOW_RND_ROUND_HALF_UP),
+                    -12346, 100);
+    assert_numeric (gnc_numeric_convert (b, 100, GNC_HOW_RND_ROUND_HALF_DOWN),
+                    -12345, 100);
+    assert_numeric (gnc_numeric_convert (b, 100, GNC_HOW_RND_ROUND),
+                    -12346, 100);
+    assert_numeric (gnc_numeric_convert (b, 100, GNC_HOW_RND_PROMOTE),
+                    -12346, 100);
+    g_assert_cmpint (gnc_numeric_check (gnc_numeric_convert (b, 100,
+                                                             GNC_HOW_RND_NEVER)),
+                     ==, GNC_ERROR_REMAINDER);
+    g_assert_cmpint (gnc_numeric_check (gnc_numeric_convert (
+                         gnc_numeric_create (INT64_MAX / 10, 100), 10000,
+                         GNC_HOW_RND_NEVER)), ==, GNC_ERROR_OVERFLOW);
+    /* Denominators that don't divide take the GncRational path. */
+    assert_numeric (gnc_numeric_convert (c, 3, GNC_HOW_RND_ROUND), 4, 3);
+}
+
+typedef struct
+{
+    gint id;
+    gnc_numeric amount;
+} Entry;
+
+static void
+test_gnc_numeric_sum (void)
+{
+    gnc_numeric values[] = { { 150, 100 }, { -25, 100 }, { 1000, 100 } };
+    gnc_numeric mixed[] = { { 150, 100 }, { 5, 10 } };
+    gnc_numeric big[] = { { INT64_MAX, 100 }, { INT64_MAX, 100 },
+                          { -INT64_MAX, 100 } };
+    Entry entries[] = { { 1, { 150, 100 } }, { 2, { -25, 100 } },
+                        { 3, { 1000, 100 } } };
+    gint how = GNC_HOW_DENOM_FIXED | GNC_HOW_RND_NEVER;
+    gnc_numeric result;
+
+    result = gnc_numeric_sum (values, 3, 0, GNC_DENOM_AUTO, how);
+    assert_numeric (result, 1125, 100);
+    result = gnc_numeric_sum (&entries[0].amount, 3, sizeof (Entry),
+                              GNC_DENOM_AUTO, how);
+    assert_numeric (result, 1125, 100);
+    result = gnc_numeric_sum (values, 0, 0, GNC_DENOM_AUTO, how);
+    g_assert (gnc_numeric_zero_p (result));
+
+    /* Other denominators take the gnc_numeric_add() rules. */
+    result = gnc_numeric_sum (mixed, 2, 0, GNC_DENOM_AUTO,
+                              GNC_HOW_DENOM_LCD);
+    assert_numeric (result, 200, 100);
+    result = gnc_numeric_sum (mixed, 2, 0, GNC_DENOM_AUTO, how);
+    g_assert_cmpint (gnc_numeric_check (result), !=, GNC_ERROR_OK);
+
+    /* The partial sums may overflow, the result mayn't. */
+    result = gnc_numeric_sum (big, 3, 0, GNC_DENOM_AUTO, how);
+    assert_numeric (result, INT64_MAX, 100);
+    result = gnc_numeric_sum (big, 2, 0, GNC_DENOM_AUTO, how);
+    g_assert_cmpint (gnc_numeric_check (result), ==, GNC_ERROR_OVERFLOW);
+}
+
+static void
+test_gnc_numeric_running_sum (void)
+{
+    gnc_numeric values[] = { { 150, 100 }, { -25, 100 }, { 5, 10 },
+                             { 1000, 100 } };
+    gnc_numeric start = { 100, 100 };
+    gnc_numeric sums[4];
+
+    gnc_numeric_running_sum (values, 4, 0, start, GNC_DENOM_AUTO,
+                             GNC_HOW_DENOM_LCD, sums);
+    assert_numeric (sums[0], 250, 100);
+    assert_numeric (sums[1], 225, 100);
+    assert_numeric (sums[2], 275, 100);
+    assert_numeric (sums[3], 1275, 100);
+}
+
+#define N_BENCH_VALUES 1000000
+
+/* Run with -m perf. */
+static void
+test_gnc_numeric_sum_benchmark (void)
+{
+    gnc_numeric *values = g_new (gnc_numeric, N_BENCH_VALUES);
+    gnc_numeric *sums = g_new (gnc_numeric, N_BENCH_VALUES);
+    gnc_numeric scalar = gnc_numeric_zero (), batched;
+    gint how = GNC_HOW_DENOM_FIXED | GNC_HOW_RND_NEVER;
+    gdouble elapsed;
+    guint i;
+
+    for (i = 0; i < N_BENCH_VALUES; ++i)
+        values[i] = gnc_numeric_create (g_random_int_range (-50000, 50000),
+                                        100);
+
+    g_test_timer_start ();
+    for (i = 0; i < N_BENCH_VALUES; ++i)
+        scalar = gnc_numeric_add_fixed (scalar, values[i]);
+    elapsed = g_test_timer_elapsed ();
+    g_test_minimized_result (elapsed, "gnc_numeric_add_fixed loop: %.4f s",
+                             elapsed);
+
+    g_test_timer_start ();
+    batched = gnc_numeric_sum (values, N_BENCH_VALUES, 0, GNC_DENOM_AUTO,
+                               how);
+    elapsed = g_test_timer_elapsed ();
+    g_test_minimized_result (elapsed, "gnc_numeric_sum: %.4f s", elapsed);
+    g_assert (gnc_numeric_equal (scalar, batched));
+
+    g_test_timer_start ();
+    gnc_numeric_running_sum (values, N_BENCH_VALUES, 0, gnc_numeric_zero (),
+                             GNC_DENOM_AUTO, how, sums);
+    elapsed = g_test_timer_elapsed ();
+    g_test_minimized_result (elapsed, "gnc_numeric_running_sum: %.4f s",
+                             elapsed);
+    g_assert (gnc_numeric_equal (scalar, sums[N_BENCH_VALUES - 1]));
+
+    g_free (sums);
+    g_free (values);
+}
+
 void
 test_suite_gnc_numeric ( void )
 {
     GNC_TEST_ADD_FUNC( suitename, "gnc-numeric add", test_gnc_numeric_add );
+    GNC_TEST_ADD_FUNC( suitename, "gnc-numeric add same denominator",
+                       test_gnc_numeric_add_same_denom );
+    GNC_TEST_ADD_FUNC( suitename, "gnc-numeric mul exact",
+                       test_gnc_numeric_mul_exact );
+    GNC_TEST_ADD_FUNC( suitename, "gnc-numeric convert decimal",
+                       test_gnc_numeric_convert_decimal );
+    GNC_TEST_ADD_FUNC( suitename, "gnc-numeric sum", test_gnc_numeric_sum );
+    GNC_TEST_ADD_FUNC( suitename, "gnc-numeric running sum",
+                       test_gnc_numeric_running_sum );
+    if (g_test_perf ())
+        GNC_TEST_ADD_FUNC( suitename, "gnc-numeric sum benchmark",
+                           test_gnc_numeric_sum_benchmark );
 }
@@ -144,6 +144,25 @@ TEST_F (KvpFrameTest, SetPathWithCreateSlash)
     EXPECT_EQ (v1, t_root.get_slot(path2));
 }
 
+TEST_F (KvpFrameTest, SetPathKeys)
+{
+    const char *keys[] {"top", "second", "twenty-first"};
+    Path path {"top", "second", "twenty-first"};
+    auto v1 = new KvpValueImpl {15.0};
+    auto v2 = new KvpValueImpl { (int64_t)52};
+
+    EXPECT_EQ (nullptr, t_root.get_slot(keys, 3));
+    EXPECT_EQ (nullptr, t_root.set_path(keys, 3, v1));
+    EXPECT_EQ (v1, t_root.get_slot(path));
+    EXPECT_EQ (v1, t_root.get_slot(keys, 3));
+    EXPECT_EQ (v1, t_root.set_path(keys, 3, v2));
+    EXPECT_EQ (v2, t_root.get_slot(keys, 3));
+    EXPECT_EQ (nullptr, t_root.get_slot(keys, 2)->get<KvpFrame*>()->get_slot("nothing"));
+    keys[1] = "nothing";
+    EXPECT_EQ (nullptr, t_root.get_slot(keys, 3));
+    delete v1;
+}
+
 TEST_F (KvpFrameTest, GetKeys)
 {
     auto k1 = "top";
@@ -202,3 +221,60 @@ TEST_F (KvpFrameTest, Empty)
     EXPECT_TRUE(f1.empty());
     EXPECT_FALSE(f2.empty());
 }
+
+static void
+collect_key (const char* key, KvpValue*, void* data)
+{
+    static_cast<std::vector<std::string>*>(data)->push_back(key);
+}
+
+TEST (KvpFrameImplTest, ManySlots)
+{
+    /* Enough slots that the frame outgrows its vector, added out of
+     * order. */
+    KvpFrameImpl frame;
+    std::vector<std::string> keys;
+    for (int i = 0; i < 40; ++i)
+        keys.push_back("key" + std::to_string((i * 17) % 40 + 100));
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        EXPECT_EQ (nullptr, frame.set(keys[i].c_str(),
+                                      new KvpValue {static_cast<int64_t>(i)}));
+        KvpFrameImpl copy {frame};
+        EXPECT_EQ (0, compare(frame, copy));
+    }
+    for (size_t i = 0; i < keys.size(); ++i)
+        EXPECT_EQ (static_cast<int64_t>(i),
+                   frame.get_slot(keys[i].c_str())->get<int64_t>());
+    EXPECT_EQ (nullptr, frame.get_slot("key99"));
+
+    std::vector<std::string> walked;
+    frame.for_each_slot(collect_key, &walked);
+    auto sorted = keys;
+    std::sort(sorted.begin(), sorted.end());
+    EXPECT_EQ (sorted, walked);
+    EXPECT_EQ (sorted, frame.get_keys());
+
+    for (size_t i = 0; i < keys.size(); i += 2)
+        delete frame.set(keys[i].c_str(), nullptr);
+    for (size_t i = 0; i < keys.size(); ++i)
+        EXPECT_EQ (i % 2 == 0, frame.get_slot(keys[i].c_str()) == nullptr);
+}
+
+TEST_F (KvpFrameTest, MemoryUsed)
+{
+    KvpFrameImpl frame;
+    auto empty = frame.memory_used();
+    EXPECT_GE (empty, sizeof (KvpFrameImpl));
+
+    std::string text (200, 'x');
+    frame.set("notes", new KvpValue {g_strdup (text.c_str())});
+    EXPECT_GE (frame.memory_used(),
+               empty + sizeof (KvpValueImpl) + text.size() + 1);
+
+    /* A nested frame counts toward its parent. */
+    auto before = t_root.memory_used();
+    auto child = t_root.get_slot("top")->get<KvpFrame*>();
+    child->set("fourth", new KvpValue {g_strdup (text.c_str())});
+    EXPECT_GE (t_root.memory_used(), before + text.size() + 1);
+}
@@ -77,8 +77,152 @@ test_qof_string_cache( void )
     g_assert(str1_1 != str1_4);
 }
 
+#ifdef HAVE_GLIB_2_32
+#define N_THREADS 8
+#define N_STRINGS 1000
+
+typedef struct
+{
+    gchar **cached;
+    guint rounds;
+    gboolean ok;
+} ThreadData;
+
+static gchar**
+make_strings (guint count, const gchar *prefix)
+{
+    gchar **strings = g_new0 (gchar*, count + 1);
+    guint i;
+    for (i = 0; i < count; ++i)
+        strings[i] = g_strdup_printf ("%s%u", prefix, i);
+    return strings;
+}
+
+/* Inserting a string that's already cached must hand back the cached copy
+ * no matter how many other threads are inserting and removing it. */
+static gpointer
+insert_remove_thread (gpointer user_data)
+{
+    ThreadData *data = user_data;
+    guint round, i;
+    for (round = 0; round < data->rounds; ++round)
+    {
+        for (i = 0; i < N_STRINGS; ++i)
+        {
+            gchar *copy = g_strdup (data->cached[i]);
+            if (qof_string_cache_insert (copy) != data->cached[i])
+                data->ok = FALSE;
+            g_free (copy);
+        }
+        for (i = 0; i < N_STRINGS; ++i)
+            qof_string_cache_remove (data->cached[i]);
+    }
+    return NULL;
+}
+
+static void
+test_qof_string_cache_threads (void)
+{
+    gchar **strings = make_strings (N_STRINGS, "thread-str");
+    gchar **cached = g_new0 (gchar*, N_STRINGS + 1);
+    ThreadData data[N_THREADS];
+    GThread *threads[N_THREADS];
+    guint i;
+
+    for (i = 0; i < N_STRINGS; ++i)
+        cached[i] = qof_string_cache_insert (strings[i]);
+    for (i = 0; i < N_THREADS; ++i)
+    {
+        data[i].cached = cached;
+        data[i].rounds = 20;
+        data[i].ok = TRUE;
+        threads[i] = g_thread_new ("string-cache", insert_remove_thread,
+                                   &data[i]);
+    }
+    for (i = 0; i < N_THREADS; ++i)
+    {
+        g_thread_join (threads[i]);
+        g_assert (data[i].ok);
+    }
+    /* The threads gave back all their references, ours are still there. */
+    for (i = 0; i < N_STRINGS; ++i)
+    {
+        g_assert (qof_string_cache_insert (strings[i]) == cached[i]);
+        qof_string_cache_remove (cached[i]);
+        qof_string_cache_remove (cached[i]);
+    }
+    g_free (cached);
+    g_strfreev (strings);
+}
+
+static gpointer
+benchmark_thread (gpointer user_data)
+{
+    gchar **strings = user_data;
+    guint round, i;
+    for (round = 0; round < 100; ++round)
+    {
+        gpointer cached[N_STRINGS];
+        for (i = 0; i < N_STRINGS; ++i)
+            cached[i] = qof_string_cache_insert (strings[i]);
+        for (i = 0; i < N_STRINGS; ++i)
+            qof_string_cache_remove (cached[i]);
+    }
+    return NULL;
+}
+
+/* Run with -m perf. Half the strings each thread uses are shared with
+ * all the others, the other half are its own. */
+static void
+test_qof_string_cache_benchmark (void)
+{
+    guint n_threads;
+    for (n_threads = 1; n_threads <= N_THREADS; n_threads *= 2)
+    {
+        gchar **shared = make_strings (N_STRINGS / 2, "shared");
+        gchar **strings[N_THREADS];
+        GThread *threads[N_THREADS];
+        gdouble elapsed;
+        guint i, j;
+
+        for (i = 0; i < n_threads; ++i)
+        {
+            gchar *prefix = g_strdup_printf ("thread%u-", i);
+            strings[i] = make_strings (N_STRINGS, prefix);
+            for (j = 0; j < N_STRINGS / 2; ++j)
+            {
+                g_free (strings[i][j]);
+                strings[i][j] = g_strdup (shared[j]);
+            }
+            g_free (prefix);
+        }
+        g_test_timer_start ();
+        for (i = 0; i < n_threads; ++i)
+            threads[i] = g_thread_new ("string-cache", benchmark_thread,
+                                       strings[i]);
+        for (i = 0; i < n_threads; ++i)
+            g_thread_join (threads[i]);
+        elapsed = g_test_timer_elapsed ();
+        g_test_maximized_result (n_threads * 100.0 * N_STRINGS / elapsed,
+                                 "%u threads: %.0f insert/remove pairs per second",
+                                 n_threads,
+                                 n_threads * 100.0 * N_STRINGS / elapsed);
+        for (i = 0; i < n_threads; ++i)
+            g_strfreev (strings[i]);
+        g_strfreev (shared);
+    }
+}
+#endif
+
 void
 test_suite_qof_string_cache ( void )
 {
     GNC_TEST_ADD_FUNC( suitename, "string-cache", test_qof_string_cache);
+#ifdef HAVE_GLIB_2_32
+    GNC_TEST_ADD_FUNC( suitename, "string-cache threads",
+                       test_qof_string_cache_threads);
+    if (g_test_perf ())
+        GNC_TEST_ADD_FUNC( suitename, "string-cache benchmark",
+                           test_qof_string_cache_benchmark);
+#endif
 }
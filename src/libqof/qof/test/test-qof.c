@@ -30,6 +30,8 @@ extern void test_suite_qofinstance();
 extern void test_suite_qofobject();
 extern void test_suite_gnc_date();
 extern void test_suite_qof_string_cache();
+extern void test_suite_qofevent();
+extern void test_suite_qoflog();
 
 int
 main (int   argc,
@@ -46,6 +48,8 @@ main (int   argc,
     test_suite_qofobject();
     test_suite_gnc_date();
     test_suite_qof_string_cache();
+    test_suite_qofevent();
+    test_suite_qoflog();
 
     return g_test_run( );
 }
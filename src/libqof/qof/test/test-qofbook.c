@@ -36,6 +36,7 @@ extern "C"
 #include "../qof.h"
 #include "../qofbook-p.h"
 #include "../qofbookslots.h"
+#include "../qofinstance-p.h"
 
 #ifdef HAVE_GLIB_2_38
 #define _Q "'"
@@ -344,6 +345,64 @@ test_book_get_counter( Fixture *fixture, gconstpointer pData )
     g_assert_cmpint( counter, == , 1 );
 }
 
+static gint64
+counter_in_kvp( QofBook *book, const char *counter_name )
+{
+    const gchar *keys[] = { "counters", counter_name };
+    GValue value = G_VALUE_INIT;
+    gint64 counter = -1;
+    qof_instance_get_kvp_keys( QOF_INSTANCE (book), &value, 2, keys );
+    if (G_VALUE_HOLDS_INT64 (&value))
+        counter = g_value_get_int64( &value );
+    if (G_IS_VALUE (&value))
+        g_value_unset( &value );
+    return counter;
+}
+
+static void
+test_book_counter_flush ( Fixture *fixture, gconstpointer pData )
+{
+    const char *counter_name = "gncInvoice";
+    const gchar *format_keys[] = { "counter_formats", counter_name };
+    const gchar *counter_keys[] = { "counters", counter_name };
+    GValue value = G_VALUE_INIT;
+    gchar *r;
+    int i;
+
+    g_test_message( "Testing that a lone increment reaches the KVP" );
+    r = qof_book_increment_and_format_counter( fixture->book, counter_name );
+    g_assert_cmpstr( r, == , "000001" );
+    g_free( r );
+    g_assert_cmpint( counter_in_kvp( fixture->book, counter_name ), == , 1 );
+
+    g_test_message( "Testing increments inside an edit of the book" );
+    qof_book_begin_edit( fixture->book );
+    for (i = 0; i < 100; ++i)
+        g_free( qof_book_increment_and_format_counter( fixture->book,
+                                                       counter_name ) );
+    g_assert_cmpint( qof_book_get_counter( fixture->book, counter_name ), == , 101 );
+    g_assert_cmpint( counter_in_kvp( fixture->book, counter_name ), == , 1 );
+    qof_book_commit_edit( fixture->book );
+    g_assert_cmpint( counter_in_kvp( fixture->book, counter_name ), == , 101 );
+
+    g_test_message( "Testing a counter changed through the KVP" );
+    g_value_init( &value, G_TYPE_INT64 );
+    g_value_set_int64( &value, 500 );
+    qof_instance_set_kvp_keys( QOF_INSTANCE (fixture->book), &value, 2, counter_keys );
+    g_value_unset( &value );
+    g_assert_cmpint( qof_book_get_counter( fixture->book, counter_name ), == , 500 );
+
+    g_test_message( "Testing a format changed through the KVP" );
+    g_value_init( &value, G_TYPE_STRING );
+    g_value_set_string( &value, "INV-%li" );
+    qof_instance_set_kvp_keys( QOF_INSTANCE (fixture->book), &value, 2, format_keys );
+    g_value_unset( &value );
+    r = qof_book_increment_and_format_counter( fixture->book, counter_name );
+    g_assert_cmpstr( r, == , "INV-501" );
+    g_free( r );
+    g_assert_cmpint( counter_in_kvp( fixture->book, counter_name ), == , 501 );
+}
+
 static void
 test_book_get_counter_format ( Fixture *fixture, gconstpointer pData )
 {
@@ -827,6 +886,84 @@ test_book_foreach_collection( Fixture *fixture, gconstpointer pData )
     g_assert( col_struct.col2_called );
 }
 
+static QofBookTypeStats *
+find_type_stats( GList *list, QofIdTypeConst type )
+{
+    for (; list; list = list->next)
+    {
+        QofBookTypeStats *stats = (QofBookTypeStats*) list->data;
+        if (g_strcmp0( stats->e_type, type ) == 0)
+            return stats;
+    }
+    return NULL;
+}
+
+static void
+test_book_type_stats( Fixture *fixture, gconstpointer pData )
+{
+    QofIdType my_type = "my_type";
+    QofInstance *inst1, *inst2, *inst3;
+    QofBookTypeStats *stats;
+    GList *list;
+    GValue value = G_VALUE_INIT;
+    gchar *str;
+
+    inst1 = g_object_new( QOF_TYPE_INSTANCE, NULL );
+    inst2 = g_object_new( QOF_TYPE_INSTANCE, NULL );
+    inst3 = g_object_new( QOF_TYPE_INSTANCE, NULL );
+    qof_instance_init_data( inst1, my_type, fixture->book );
+    qof_instance_init_data( inst2, my_type, fixture->book );
+    qof_instance_init_data( inst3, my_type, fixture->book );
+
+    g_test_message( "Testing the counts with three instances" );
+    list = qof_book_get_type_stats( fixture->book );
+    stats = find_type_stats( list, my_type );
+    g_assert( stats );
+    g_assert_cmpuint( stats->count, == , 3 );
+    g_assert_cmpuint( stats->inserted, == , 3 );
+    g_assert_cmpuint( stats->removed, == , 0 );
+    g_assert_cmpuint( stats->instance_bytes, >= , 3 * sizeof (QofInstance) );
+    g_assert_cmpuint( stats->kvp_bytes, >, 0 );
+    g_assert_cmpuint( stats->index_bytes, >, 0 );
+    g_list_free_full( list, g_free );
+
+    g_test_message( "Testing that KVP data is counted" );
+    list = qof_book_get_type_stats( fixture->book );
+    stats = find_type_stats( list, my_type );
+    {
+        gsize kvp_bytes = stats->kvp_bytes;
+        g_list_free_full( list, g_free );
+        g_value_init( &value, G_TYPE_STRING );
+        g_value_set_string( &value, "a string long enough to notice" );
+        qof_instance_set_kvp( inst1, "notes", &value );
+        g_value_unset( &value );
+        list = qof_book_get_type_stats( fixture->book );
+        stats = find_type_stats( list, my_type );
+        g_assert_cmpuint( stats->kvp_bytes, >= ,
+                          kvp_bytes + strlen( "a string long enough to notice" ) );
+        g_list_free_full( list, g_free );
+    }
+
+    g_test_message( "Testing the churn after removing an instance" );
+    g_object_unref( inst2 );
+    list = qof_book_get_type_stats( fixture->book );
+    stats = find_type_stats( list, my_type );
+    g_assert_cmpuint( stats->count, == , 2 );
+    g_assert_cmpuint( stats->inserted, == , 3 );
+    g_assert_cmpuint( stats->removed, == , 1 );
+    g_list_free_full( list, g_free );
+
+    g_test_message( "Testing the formatted table" );
+    str = qof_book_type_stats_to_string( fixture->book );
+    g_assert( strstr( str, my_type ) );
+    g_assert( strstr( str, "Total" ) );
+    g_assert( strstr( str, "String cache" ) );
+    g_free( str );
+
+    g_object_unref( inst1 );
+    g_object_unref( inst3 );
+}
+
 static void
 test_book_set_data_fin( void )
 {
@@ -931,6 +1068,7 @@ test_suite_qofbook ( void )
     GNC_TEST_ADD( suitename, "get counter", Fixture, NULL, setup, test_book_get_counter, teardown );
     GNC_TEST_ADD( suitename, "get counter format", Fixture, NULL, setup, test_book_get_counter_format, teardown );
     GNC_TEST_ADD( suitename, "increment and format counter", Fixture, NULL, setup, test_book_increment_and_format_counter, teardown );
+    GNC_TEST_ADD( suitename, "counter flush", Fixture, NULL, setup, test_book_counter_flush, teardown );
     GNC_TEST_ADD( suitename, "use trading accounts", Fixture, NULL, setup, test_book_use_trading_accounts, teardown );
     GNC_TEST_ADD( suitename, "use book-currency", Fixture, NULL, setup, test_book_use_book_currency, teardown );
     GNC_TEST_ADD( suitename, "get autofreeze days", Fixture, NULL, setup, test_book_get_num_days_autofreeze, teardown );
@@ -942,6 +1080,7 @@ test_suite_qofbook ( void )
     GNC_TEST_ADD( suitename, "set get data", Fixture, NULL, setup, test_book_set_get_data, teardown );
     GNC_TEST_ADD( suitename, "get collection", Fixture, NULL, setup, test_book_get_collection, teardown );
     GNC_TEST_ADD( suitename, "foreach collection", Fixture, NULL, setup, test_book_foreach_collection, teardown );
+    GNC_TEST_ADD( suitename, "type stats", Fixture, NULL, setup, test_book_type_stats, teardown );
     GNC_TEST_ADD_FUNC( suitename, "set data finalizers", test_book_set_data_fin );
     GNC_TEST_ADD( suitename, "mark closed", Fixture, NULL, setup, test_book_mark_closed, teardown );
     GNC_TEST_ADD_FUNC( suitename, "book new and destroy", test_book_new_destroy );
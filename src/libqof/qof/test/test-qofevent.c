@@ -0,0 +1,219 @@
+/********************************************************************
+ * test-qofevent.c: GLib g_test test suite for qofevent.cpp.        *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+********************************************************************/
+
+#include "config.h"
+#include <glib.h>
+#include <unittest-support.h>
+#include "qof.h"
+
+static const gchar *suitename = "/qof/qofevent";
+void test_suite_qofevent ( void );
+
+typedef struct
+{
+    QofInstance *inst1;
+    QofInstance *inst2;
+    /* Every event the ordinary handler saw */
+    guint n_plain;
+    /* Every batch the batch handler saw, and their entries */
+    guint n_batches;
+    GArray *entries;
+    gint plain_id;
+    gint batch_id;
+} Fixture;
+
+static void
+plain_handler (QofInstance *ent, QofEventId event_type,
+               gpointer handler_data, gpointer event_data)
+{
+    Fixture *fixture = handler_data;
+    fixture->n_plain++;
+}
+
+static void
+batch_handler (const QofEventBatchEntry *events, guint n_events,
+               gpointer handler_data)
+{
+    Fixture *fixture = handler_data;
+    fixture->n_batches++;
+    g_array_append_vals (fixture->entries, events, n_events);
+}
+
+static void
+setup( Fixture *fixture, gconstpointer pData )
+{
+    fixture->inst1 = g_object_new (QOF_TYPE_INSTANCE, NULL);
+    fixture->inst2 = g_object_new (QOF_TYPE_INSTANCE, NULL);
+    fixture->n_plain = 0;
+    fixture->n_batches = 0;
+    fixture->entries = g_array_new (FALSE, FALSE, sizeof (QofEventBatchEntry));
+    fixture->plain_id = qof_event_register_handler (plain_handler, fixture);
+    fixture->batch_id = qof_event_register_batch_handler (batch_handler,
+                                                          fixture);
+}
+
+static void
+teardown( Fixture *fixture, gconstpointer pData )
+{
+    qof_event_unregister_handler (fixture->plain_id);
+    qof_event_unregister_handler (fixture->batch_id);
+    g_array_free (fixture->entries, TRUE);
+    g_object_unref (fixture->inst1);
+    g_object_unref (fixture->inst2);
+}
+
+static QofEventBatchEntry*
+entry (Fixture *fixture, guint index)
+{
+    g_assert_cmpuint (index, <, fixture->entries->len);
+    return &g_array_index (fixture->entries, QofEventBatchEntry, index);
+}
+
+static void
+test_qof_event_batch_unbatched (Fixture *fixture, gconstpointer pData)
+{
+    qof_event_gen (fixture->inst1, QOF_EVENT_MODIFY, NULL);
+    qof_event_gen (fixture->inst1, QOF_EVENT_MODIFY, NULL);
+    g_assert_cmpuint (fixture->n_plain, ==, 2);
+    g_assert_cmpuint (fixture->n_batches, ==, 2);
+    g_assert_cmpuint (fixture->entries->len, ==, 2);
+    g_assert (entry (fixture, 1)->entity == fixture->inst1);
+    g_assert_cmpint (entry (fixture, 1)->event_type, ==, QOF_EVENT_MODIFY);
+}
+
+static void
+test_qof_event_batch_coalesce (Fixture *fixture, gconstpointer pData)
+{
+    qof_event_begin_batch ();
+    qof_event_gen (fixture->inst2, QOF_EVENT_ADD, NULL);
+    qof_event_gen (fixture->inst1, QOF_EVENT_MODIFY, NULL);
+    qof_event_gen (fixture->inst2, QOF_EVENT_MODIFY, NULL);
+    qof_event_gen (fixture->inst1, QOF_EVENT_MODIFY, NULL);
+    qof_event_begin_batch ();
+    qof_event_gen (fixture->inst2, QOF_EVENT_MODIFY, NULL);
+    qof_event_end_batch ();
+    /* Ordinary handlers still see every event as it happens. */
+    g_assert_cmpuint (fixture->n_plain, ==, 5);
+    g_assert_cmpuint (fixture->n_batches, ==, 0);
+    qof_event_end_batch ();
+
+    g_assert_cmpuint (fixture->n_batches, ==, 1);
+    g_assert_cmpuint (fixture->entries->len, ==, 2);
+    g_assert (entry (fixture, 0)->entity == fixture->inst2);
+    g_assert_cmpint (entry (fixture, 0)->event_type, ==,
+                     QOF_EVENT_ADD | QOF_EVENT_MODIFY);
+    g_assert (entry (fixture, 1)->entity == fixture->inst1);
+    g_assert_cmpint (entry (fixture, 1)->event_type, ==, QOF_EVENT_MODIFY);
+
+    /* The next batch starts out empty. */
+    qof_event_begin_batch ();
+    qof_event_end_batch ();
+    g_assert_cmpuint (fixture->n_batches, ==, 1);
+}
+
+static void
+test_qof_event_batch_destroy (Fixture *fixture, gconstpointer pData)
+{
+    qof_event_begin_batch ();
+    qof_event_gen (fixture->inst1, QOF_EVENT_MODIFY, NULL);
+    qof_event_gen (fixture->inst2, QOF_EVENT_DESTROY, NULL);
+    g_assert_cmpuint (fixture->n_batches, ==, 1);
+    g_assert_cmpuint (fixture->entries->len, ==, 2);
+    g_assert (entry (fixture, 1)->entity == fixture->inst2);
+    g_assert_cmpint (entry (fixture, 1)->event_type, ==, QOF_EVENT_DESTROY);
+
+    qof_event_gen (fixture->inst1, QOF_EVENT_MODIFY, NULL);
+    qof_event_end_batch ();
+    g_assert_cmpuint (fixture->n_batches, ==, 2);
+    g_assert_cmpuint (fixture->entries->len, ==, 3);
+}
+
+static void
+test_qof_event_batch_suspend_unregister (Fixture *fixture,
+                                         gconstpointer pData)
+{
+    qof_event_suspend ();
+    qof_event_begin_batch ();
+    qof_event_gen (fixture->inst1, QOF_EVENT_MODIFY, NULL);
+    qof_event_end_batch ();
+    qof_event_resume ();
+    g_assert_cmpuint (fixture->n_plain, ==, 0);
+    g_assert_cmpuint (fixture->n_batches, ==, 0);
+
+    qof_event_begin_batch ();
+    qof_event_gen (fixture->inst1, QOF_EVENT_MODIFY, NULL);
+    qof_event_unregister_handler (fixture->batch_id);
+    qof_event_end_batch ();
+    g_assert_cmpuint (fixture->n_plain, ==, 1);
+    g_assert_cmpuint (fixture->n_batches, ==, 0);
+    fixture->batch_id = qof_event_register_batch_handler (batch_handler,
+                                                          fixture);
+}
+
+static void
+test_qof_event_filtered (Fixture *fixture, gconstpointer pData)
+{
+    const QofIdType types[] = { "FilterType", NULL };
+    Fixture filtered;
+    QofBook *book = qof_book_new ();
+    QofInstance *other = g_object_new (QOF_TYPE_INSTANCE, NULL);
+    QofInstance *inst = g_object_new (QOF_TYPE_INSTANCE, NULL);
+    gint id;
+
+    qof_instance_init_data (inst, "FilterType", book);
+    qof_instance_init_data (other, "OtherType", book);
+    filtered.n_plain = 0;
+    fixture->n_plain = 0;
+    id = qof_event_register_filtered_handler (plain_handler, &filtered, types,
+                                              QOF_EVENT_MODIFY);
+
+    qof_event_gen (inst, QOF_EVENT_MODIFY, NULL);
+    qof_event_gen (inst, QOF_EVENT_ADD, NULL);
+    qof_event_gen (other, QOF_EVENT_MODIFY, NULL);
+    qof_event_gen (fixture->inst1, QOF_EVENT_MODIFY, NULL);
+    g_assert_cmpuint (filtered.n_plain, ==, 1);
+    /* Unfiltered handlers see everything, including application events. */
+    qof_event_gen (inst, QOF_MAKE_EVENT (QOF_EVENT_BASE + 1), NULL);
+    g_assert_cmpuint (fixture->n_plain, ==, 5);
+
+    qof_event_unregister_handler (id);
+    qof_event_gen (inst, QOF_EVENT_MODIFY, NULL);
+    g_assert_cmpuint (filtered.n_plain, ==, 1);
+
+    g_object_unref (inst);
+    g_object_unref (other);
+    qof_book_destroy (book);
+}
+
+void
+test_suite_qofevent ( void )
+{
+    GNC_TEST_ADD( suitename, "batch unbatched", Fixture, NULL, setup,
+                  test_qof_event_batch_unbatched, teardown );
+    GNC_TEST_ADD( suitename, "batch coalesce", Fixture, NULL, setup,
+                  test_qof_event_batch_coalesce, teardown );
+    GNC_TEST_ADD( suitename, "batch destroy", Fixture, NULL, setup,
+                  test_qof_event_batch_destroy, teardown );
+    GNC_TEST_ADD( suitename, "batch suspend and unregister", Fixture, NULL,
+                  setup, test_qof_event_batch_suspend_unregister, teardown );
+    GNC_TEST_ADD( suitename, "filtered handler", Fixture, NULL, setup,
+                  test_qof_event_filtered, teardown );
+}
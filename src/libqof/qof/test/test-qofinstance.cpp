@@ -236,6 +236,41 @@ test_instance_init_data( void )
     qof_book_destroy( book );
 }
 
+static void
+test_instance_init_data_with_guid( void )
+{
+    QofInstance *inst, *inst2;
+    QofIdType test_type = "test type";
+    QofBook *book;
+    QofCollection *col;
+    GncGUID guid = guid_new_return();
+
+    /* set up */
+    inst = static_cast<QofInstance*>(g_object_new( QOF_TYPE_INSTANCE, NULL ));
+    inst2 = static_cast<QofInstance*>(g_object_new( QOF_TYPE_INSTANCE, NULL ));
+    book = qof_book_new();
+    col = qof_book_get_collection( book, test_type );
+
+    g_test_message( "Running test with a guid read from a file" );
+    qof_instance_init_data_with_guid( inst, test_type, book, &guid );
+    g_assert( qof_instance_get_book( inst ) == book );
+    g_assert( guid_equal( qof_instance_get_guid( inst ), &guid ) );
+    g_assert( qof_instance_get_collection( inst ) == col );
+    g_assert_cmpstr( inst->e_type, == , test_type );
+    g_assert( qof_collection_lookup_entity( col, &guid ) == inst );
+
+    g_test_message( "Running test with a guid that is taken" );
+    qof_instance_init_data_with_guid( inst2, test_type, book, &guid );
+    g_assert( !guid_equal( qof_instance_get_guid( inst2 ), &guid ) );
+    g_assert( qof_collection_lookup_entity( col, &guid ) == inst );
+    g_assert( qof_collection_lookup_entity( col, qof_instance_get_guid( inst2 ) ) == inst2 );
+
+    /* clean up */
+    g_object_unref( inst );
+    g_object_unref( inst2 );
+    qof_book_destroy( book );
+}
+
 static void
 test_instance_get_set_slots( Fixture *fixture, gconstpointer pData )
 {
@@ -265,6 +300,46 @@ test_instance_get_set_slots( Fixture *fixture, gconstpointer pData )
 
 }
 
+static void
+test_instance_get_kvp_typed( Fixture *fixture, gconstpointer pData )
+{
+    KvpFrame *frame = qof_instance_get_slots( fixture->inst );
+    const gchar *num_keys[] = {"budget", "num"};
+    const gchar *int_keys[] = {"budget", "count"};
+    const gchar *str_keys[] = {"notes"};
+    const gchar *guid_keys[] = {"link"};
+    const gchar *missing_keys[] = {"budget", "nothing"};
+    GncGUID *guid = guid_new();
+    gnc_numeric num = gnc_numeric_zero();
+    gint64 count = 0;
+    const char *str;
+
+    delete frame->set_path( "budget/num", new KvpValue( gnc_numeric_create( 3, 4 ) ) );
+    delete frame->set_path( "budget/count", new KvpValue( INT64_C(42) ) );
+    delete frame->set( "notes", new KvpValue( static_cast<const char*>( g_strdup( "text" ) ) ) );
+    delete frame->set( "link", new KvpValue( guid_copy( guid ) ) );
+
+    g_assert( qof_instance_get_kvp_numeric( fixture->inst, &num, 2, num_keys ) );
+    g_assert( gnc_numeric_equal( num, gnc_numeric_create( 3, 4 ) ) );
+    g_assert( qof_instance_get_kvp_int64( fixture->inst, &count, 2, int_keys ) );
+    g_assert_cmpint( count, ==, 42 );
+    str = qof_instance_get_kvp_string( fixture->inst, 1, str_keys );
+    g_assert_cmpstr( str, ==, "text" );
+    /* The string is borrowed from the slot, not copied */
+    g_assert( str == qof_instance_get_kvp_string( fixture->inst, 1, str_keys ) );
+    g_assert( guid_equal( guid, qof_instance_get_kvp_guid( fixture->inst, 1, guid_keys ) ) );
+
+    g_test_message( "Test missing slots and slots of another type" );
+    g_assert( !qof_instance_get_kvp_numeric( fixture->inst, NULL, 2, missing_keys ) );
+    g_assert( !qof_instance_get_kvp_numeric( fixture->inst, NULL, 2, int_keys ) );
+    g_assert( !qof_instance_get_kvp_int64( fixture->inst, NULL, 2, num_keys ) );
+    g_assert( qof_instance_get_kvp_string( fixture->inst, 1, guid_keys ) == NULL );
+    g_assert( qof_instance_get_kvp_guid( fixture->inst, 1, str_keys ) == NULL );
+    g_assert( qof_instance_get_kvp_string( fixture->inst, 2, missing_keys ) == NULL );
+
+    guid_free( guid );
+}
+
 static void
 test_instance_version_cmp( void )
 {
@@ -1045,7 +1120,9 @@ test_suite_qofinstance ( void )
     GNC_TEST_ADD( suitename, "set get guid", Fixture, NULL, setup, test_instance_set_get_guid, teardown );
     GNC_TEST_ADD_FUNC( suitename, "instance new and destroy", test_instance_new_destroy );
     GNC_TEST_ADD_FUNC( suitename, "init data", test_instance_init_data );
+    GNC_TEST_ADD_FUNC( suitename, "init data with guid", test_instance_init_data_with_guid );
     GNC_TEST_ADD( suitename, "get set slots", Fixture, NULL, setup, test_instance_get_set_slots, teardown );
+    GNC_TEST_ADD( suitename, "get kvp typed", Fixture, NULL, setup, test_instance_get_kvp_typed, teardown );
     GNC_TEST_ADD_FUNC( suitename, "version compare", test_instance_version_cmp );
     GNC_TEST_ADD( suitename, "get set dirty", Fixture, NULL, setup, test_instance_get_set_dirty, teardown );
     GNC_TEST_ADD( suitename, "display name", Fixture, NULL, setup, test_instance_display_name, teardown );
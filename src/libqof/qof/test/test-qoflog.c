@@ -0,0 +1,163 @@
+/********************************************************************
+ * test-qoflog.c: GLib g_test test suite for qoflog.cpp.            *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+********************************************************************/
+
+#include "config.h"
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <string.h>
+#include <unittest-support.h>
+#include "qof.h"
+
+static const gchar *suitename = "/qof/qoflog";
+static QofLogModule log_module = "qof.test.log";
+void test_suite_qoflog ( void );
+
+typedef struct
+{
+    guint hits;
+    guint evaluated;
+    guint handler;
+} Fixture;
+
+static void
+count_handler (const gchar *log_domain, GLogLevelFlags log_level,
+               const gchar *msg, gpointer user_data)
+{
+    Fixture *fixture = user_data;
+    fixture->hits++;
+}
+
+static void
+setup (Fixture *fixture, gconstpointer pData)
+{
+    fixture->hits = 0;
+    fixture->evaluated = 0;
+    fixture->handler = g_log_set_handler (log_module, G_LOG_LEVEL_MASK,
+                                          count_handler, fixture);
+    qof_log_set_level (log_module, QOF_LOG_WARNING);
+}
+
+static void
+teardown (Fixture *fixture, gconstpointer pData)
+{
+    g_log_remove_handler (log_module, fixture->handler);
+    qof_log_set_level (log_module, QOF_LOG_WARNING);
+}
+
+static gint
+evaluate (Fixture *fixture)
+{
+    return ++fixture->evaluated;
+}
+
+static void
+enter_and_leave (Fixture *fixture)
+{
+    ENTER ("%d", evaluate (fixture));
+    LEAVE ("%d", evaluate (fixture));
+}
+
+static void
+test_qof_log_check_cached (Fixture *fixture, gconstpointer pData)
+{
+    guint cache = 0;
+    g_assert (!qof_log_check_cached (log_module, QOF_LOG_DEBUG, &cache));
+    g_assert (qof_log_check_cached (log_module, QOF_LOG_WARNING, &cache));
+    /* The cache follows level changes, of the module and of its parents. */
+    qof_log_set_level (log_module, QOF_LOG_DEBUG);
+    g_assert (qof_log_check_cached (log_module, QOF_LOG_DEBUG, &cache));
+    qof_log_set_level (log_module, QOF_LOG_ERROR);
+    g_assert (!qof_log_check_cached (log_module, QOF_LOG_WARNING, &cache));
+    g_assert (qof_log_check_cached (log_module, QOF_LOG_ERROR, &cache));
+    qof_log_set_level ("qof.test", QOF_LOG_INFO);
+    qof_log_set_level (log_module, QOF_LOG_INFO);
+    g_assert (qof_log_check_cached (log_module, QOF_LOG_INFO, &cache));
+    g_assert (!qof_log_check_cached (log_module, QOF_LOG_DEBUG, &cache));
+    qof_log_set_level ("qof.test", QOF_LOG_WARNING);
+}
+
+static void
+test_qof_log_enter_leave (Fixture *fixture, gconstpointer pData)
+{
+    guint expected;
+    /* Disabled, the arguments aren't evaluated. */
+    enter_and_leave (fixture);
+    g_assert_cmpuint (fixture->hits, ==, 0);
+    g_assert_cmpuint (fixture->evaluated, ==, 0);
+
+    qof_log_set_level (log_module, QOF_LOG_DEBUG);
+    enter_and_leave (fixture);
+    expected = QOF_LOG_MAX_LEVEL >= G_LOG_LEVEL_DEBUG ? 2 : 0;
+    g_assert_cmpuint (fixture->hits, ==, expected);
+    g_assert_cmpuint (fixture->evaluated, ==, expected);
+
+    fixture->hits = fixture->evaluated = 0;
+    qof_log_set_level (log_module, QOF_LOG_WARNING);
+    enter_and_leave (fixture);
+    g_assert_cmpuint (fixture->hits, ==, 0);
+    g_assert_cmpuint (fixture->evaluated, ==, 0);
+}
+
+static void
+test_qof_log_trace (Fixture *fixture, gconstpointer pData)
+{
+    gchar *filename = g_build_filename (g_get_tmp_dir (), "test-qoflog.json",
+                                        NULL);
+    gchar *contents = NULL;
+    gint64 start;
+
+    /* Spans outside a trace go nowhere. */
+    start = qof_log_trace_begin ();
+    g_assert_cmpint (start, ==, 0);
+    QOF_TRACE_END ("test", "before", start);
+
+    qof_log_trace_init (filename);
+    start = qof_log_trace_begin ();
+    g_assert_cmpint (start, !=, 0);
+    QOF_TRACE_END ("test", "first", start);
+    start = qof_log_trace_begin ();
+    QOF_TRACE_END ("test", "with \"quotes\"", start);
+    qof_log_trace_shutdown ();
+
+    start = qof_log_trace_begin ();
+    g_assert_cmpint (start, ==, 0);
+
+    g_assert (g_file_get_contents (filename, &contents, NULL, NULL));
+    g_assert (g_str_has_prefix (contents, "[\n{\"name\":\"first\",\"cat\":\"test\",\"ph\":\"X\","));
+    g_assert (strstr (contents, "},\n{\"name\":\"with \\\"quotes\\\"\",") != NULL);
+    g_assert (strstr (contents, "before") == NULL);
+    g_assert (g_str_has_suffix (contents, "}\n]\n"));
+
+    g_free (contents);
+    g_unlink (filename);
+    g_free (filename);
+}
+
+void
+test_suite_qoflog ( void )
+{
+    GNC_TEST_ADD( suitename, "check cached", Fixture, NULL, setup,
+                  test_qof_log_check_cached, teardown );
+    GNC_TEST_ADD( suitename, "enter and leave", Fixture, NULL, setup,
+                  test_qof_log_enter_leave, teardown );
+    GNC_TEST_ADD( suitename, "trace", Fixture, NULL, setup,
+                  test_qof_log_trace, teardown );
+}
@@ -227,6 +227,21 @@ test_qof_object_lookup( Fixture *fixture, gconstpointer pData )
 
     g_test_message( "Test non existing object lookup" );
     g_assert( qof_object_lookup( "anytype" ) == NULL );
+
+    g_test_message( "Test lookup by a copy of the type name" );
+    {
+        gchar *name = g_strdup( "my type object" );
+        g_assert( qof_object_lookup( name ) == fixture->qofobject );
+        g_free( name );
+    }
+
+    g_test_message( "Test the last object registered for a type is found" );
+    {
+        QofObject *other = new_object( "my type object", "other desc", EMPTY );
+        g_assert( qof_object_register( other ) == TRUE );
+        g_assert( qof_object_lookup( "my type object" ) == other );
+        g_free( other );
+    }
 }
 
 static struct
@@ -85,6 +85,7 @@ QofBackend * test_backend_factory ()
     ret->percentage = nullptr;
     ret->config_count = 0;
     ret->price_lookup = nullptr;
+    ret->stats = nullptr;
     return ret;
 }
 
@@ -35,6 +35,7 @@ extern "C"
 
 #include "Numeric.hpp"
 #include "GncInstance.hpp"
+#include "Range.hpp"
 
 namespace gnc
 {
@@ -126,6 +127,11 @@ public:
     {
         return xaccAccountGetSplitList(gobj());
     }
+    /// The splits of this account, borrowed without copying the list.
+    SplitRange splits() const
+    {
+        return SplitRange(xaccAccountGetSplitList(gobj()));
+    }
 
     /** @name Account tree traversal */
     //@{
@@ -148,6 +154,16 @@ public:
     {
         return gnc_account_get_descendants (gobj());
     }
+    /// The children of this account, borrowed without copying the list.
+    AccountRange children() const
+    {
+        return AccountRange(gnc_account_peek_children(gobj()));
+    }
+    /// All descendants of this account, walked without building a list.
+    DescendantRange descendants() const
+    {
+        return DescendantRange(gobj());
+    }
     Glib::RefPtr<Account> get_nth_child (gint num) const;
 
 
@@ -33,6 +33,7 @@ extern "C"
 
 #include <glibmm/object.h>
 #include "GncInstance.hpp"
+#include "Range.hpp"
 
 namespace gnc
 {
@@ -98,6 +99,11 @@ public:
 
 
     Glib::RefPtr<Account> get_root_account();
+    /// All transactions of this book, walked without building a list.
+    TransactionRange transactions() const
+    {
+        return TransactionRange(qof_book_get_collection(gobj(), GNC_ID_TRANS));
+    }
     bool is_readonly() const
     {
         return qof_book_is_readonly(gobj());
@@ -0,0 +1,225 @@
+/*
+ * Range.hpp
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, contact:
+ *
+ * Free Software Foundation           Voice:  +1-617-542-5942
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org
+ */
+
+#ifndef GNC_RANGE_HPP
+#define GNC_RANGE_HPP
+
+// gnucash includes
+extern "C"
+{
+#include "qof.h"
+#include "engine/Account.h"
+}
+
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+namespace gnc
+{
+
+/** Ranges over the engine's own lists, for use in range-based for
+ * loops.  Nothing is copied and nothing is allocated per element: the
+ * iterators yield the plain C pointers, which are only borrowed.  A
+ * range is only valid as long as the list it walks is not changed, so
+ * adding or removing elements during a walk is not allowed.
+ */
+
+/** A range over a GList whose data are pointers to T. */
+template <typename T>
+class GListRange
+{
+public:
+    class iterator : public std::iterator<std::forward_iterator_tag, T*>
+    {
+    public:
+        explicit iterator (GList *node = nullptr) : m_node(node) {}
+        T* operator* () const
+        {
+            return static_cast<T*>(m_node->data);
+        }
+        iterator& operator++ ()
+        {
+            m_node = m_node->next;
+            return *this;
+        }
+        iterator operator++ (int)
+        {
+            iterator old = *this;
+            m_node = m_node->next;
+            return old;
+        }
+        bool operator== (const iterator& other) const
+        {
+            return m_node == other.m_node;
+        }
+        bool operator!= (const iterator& other) const
+        {
+            return m_node != other.m_node;
+        }
+    private:
+        GList *m_node;
+    };
+
+    explicit GListRange (GList *list) : m_list(list) {}
+    iterator begin () const
+    {
+        return iterator(m_list);
+    }
+    iterator end () const
+    {
+        return iterator();
+    }
+    bool empty () const
+    {
+        return m_list == nullptr;
+    }
+
+private:
+    GList *m_list;
+};
+
+typedef GListRange< ::Split> SplitRange;
+typedef GListRange< ::Account> AccountRange;
+
+/** A range over all the descendants of an account, in the same order
+ * as gnc_account_get_descendants(): each account comes before its own
+ * children.  The iterator keeps one list position per level of the
+ * tree, so it allocates only when it goes deeper than before.
+ */
+class DescendantRange
+{
+public:
+    class iterator : public std::iterator<std::forward_iterator_tag, ::Account*>
+    {
+    public:
+        iterator () {}
+        explicit iterator (GList *children)
+        {
+            if (children)
+                m_stack.push_back(children);
+        }
+        ::Account* operator* () const
+        {
+            return static_cast< ::Account*>(m_stack.back()->data);
+        }
+        iterator& operator++ ()
+        {
+            GList *children = gnc_account_peek_children(**this);
+            if (children)
+            {
+                m_stack.push_back(children);
+                return *this;
+            }
+            while (!m_stack.empty())
+            {
+                m_stack.back() = m_stack.back()->next;
+                if (m_stack.back())
+                    break;
+                m_stack.pop_back();
+            }
+            return *this;
+        }
+        bool operator== (const iterator& other) const
+        {
+            if (m_stack.empty() || other.m_stack.empty())
+                return m_stack.empty() == other.m_stack.empty();
+            return m_stack.back() == other.m_stack.back();
+        }
+        bool operator!= (const iterator& other) const
+        {
+            return !(*this == other);
+        }
+    private:
+        std::vector<GList*> m_stack;
+    };
+
+    explicit DescendantRange (const ::Account *account) : m_account(account) {}
+    iterator begin () const
+    {
+        return iterator(gnc_account_peek_children(m_account));
+    }
+    iterator end () const
+    {
+        return iterator();
+    }
+
+private:
+    const ::Account *m_account;
+};
+
+/** A range over the entities of a collection, cast to T. */
+template <typename T>
+class CollectionRange
+{
+public:
+    class iterator : public std::iterator<std::forward_iterator_tag, T*>
+    {
+    public:
+        iterator () : m_col(nullptr), m_cursor(0), m_entity(nullptr) {}
+        explicit iterator (const QofCollection *col)
+            : m_col(col), m_cursor(0), m_entity(nullptr)
+        {
+            if (m_col)
+                m_entity = qof_collection_next_entity(m_col, &m_cursor);
+        }
+        T* operator* () const
+        {
+            return reinterpret_cast<T*>(m_entity);
+        }
+        iterator& operator++ ()
+        {
+            m_entity = qof_collection_next_entity(m_col, &m_cursor);
+            return *this;
+        }
+        bool operator== (const iterator& other) const
+        {
+            return m_entity == other.m_entity;
+        }
+        bool operator!= (const iterator& other) const
+        {
+            return m_entity != other.m_entity;
+        }
+    private:
+        const QofCollection *m_col;
+        gsize m_cursor;
+        QofInstance *m_entity;
+    };
+
+    explicit CollectionRange (const QofCollection *col) : m_col(col) {}
+    iterator begin () const
+    {
+        return iterator(m_col);
+    }
+    iterator end () const
+    {
+        return iterator();
+    }
+
+private:
+    const QofCollection *m_col;
+};
+
+typedef CollectionRange< ::Transaction> TransactionRange;
+
+} // END namespace gnc
+
+#endif
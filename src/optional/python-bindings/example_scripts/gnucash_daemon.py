@@ -0,0 +1,189 @@
+#!/usr/bin/env python
+
+# gnucash_daemon.py -- Keep a book open and answer requests on a socket
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License as
+# published by the Free Software Foundation; either version 2 of
+# the License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, contact:
+# Free Software Foundation           Voice:  +1-617-542-5942
+# 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652
+# Boston, MA  02110-1301,  USA       gnu@gnu.org
+
+##  @file
+#   @brief Keep a book open and answer requests on a local socket
+#   @ingroup python_bindings_examples
+#
+# Scripts that each open a book pay for loading it every time.  This one
+# opens it once and then serves requests on a Unix socket, so those
+# scripts can send their work here instead:
+#
+#   python gnucash_daemon.py [--socket PATH] [--readonly] BOOK_URI
+#
+# Each request is one line of JSON, and so is each answer.  An answer is
+# {"ok": true, "result": ...} or {"ok": false, "error": "..."}.  Amounts
+# go both ways as [num, denom].  The requests are:
+#
+#   {"op": "accounts"}
+#       the full names of all accounts
+#   {"op": "balance", "account": "Assets:Checking", "date": SECONDS}
+#       the balance of the account, as of date if given
+#   {"op": "add_transactions", "currency": "USD", "transactions":
+#    [[post_date, num, description,
+#      [["Assets:Checking", value_num, value_denom], ...]], ...]}
+#       makes the transactions with Book.AddTransactions
+#   {"op": "add_prices", "namespace": "NASDAQ", "commodity": "GOOG",
+#    "currency": "USD", "prices": [[time, num, denom], ...]}
+#       adds the prices with GncPriceDB.AddPrices
+#   {"op": "save"}
+#       saves the book; requests that change it save it too
+#   {"op": "shutdown"}
+#       saves and closes the book and stops the daemon
+#
+# The engine is not thread safe, so requests are served one at a time;
+# connections may stay open for many requests.  The standard reports
+# are written in Scheme and can't be run from here.
+
+import json
+import os
+import sys
+import threading
+from optparse import OptionParser
+
+try:
+    import SocketServer as socketserver
+except ImportError:
+    import socketserver
+
+from gnucash import Session, GncNumeric
+
+class BookServer(socketserver.ThreadingMixIn,
+                 socketserver.UnixStreamServer):
+    daemon_threads = True
+
+    def __init__(self, path, session, readonly):
+        socketserver.UnixStreamServer.__init__(self, path, RequestHandler)
+        self.session = session
+        self.book = session.book
+        self.readonly = readonly
+        self.lock = threading.Lock()
+
+    def account(self, name):
+        account = self.book.get_root_account().lookup_by_full_name(name)
+        if account is None:
+            raise ValueError("No account %s" % name)
+        return account
+
+    def commodity(self, namespace, mnemonic):
+        commodity = self.book.get_table().lookup(namespace, mnemonic)
+        if commodity is None:
+            raise ValueError("No commodity %s:%s" % (namespace, mnemonic))
+        return commodity
+
+    def do_accounts(self, request):
+        return [account.get_full_name() for account in
+                self.book.get_root_account().get_descendants()]
+
+    def do_balance(self, request):
+        account = self.account(request["account"])
+        if "date" in request:
+            balance = account.GetBalanceAsOfDate(request["date"])
+        else:
+            balance = account.GetBalance()
+        return [balance.num(), balance.denom()]
+
+    def do_add_transactions(self, request):
+        currency = self.commodity("CURRENCY", request["currency"])
+        rows = []
+        for post_date, num, description, splits in request["transactions"]:
+            rows.append((post_date, num, description,
+                         [(self.account(split[0]),) + tuple(split[1:])
+                          for split in splits]))
+        count = self.book.AddTransactions(currency, rows)
+        self.session.save()
+        return count
+
+    def do_add_prices(self, request):
+        commodity = self.commodity(request["namespace"],
+                                   request["commodity"])
+        currency = self.commodity("CURRENCY", request["currency"])
+        count = self.book.get_price_db().AddPrices(
+            commodity, currency, request.get("source"),
+            [tuple(price) for price in request["prices"]])
+        self.session.save()
+        return count
+
+    def do_save(self, request):
+        self.session.save()
+
+    def do_shutdown(self, request):
+        if not self.readonly:
+            self.session.save()
+        threading.Thread(target=self.shutdown).start()
+
+    writes = ("add_transactions", "add_prices", "save")
+
+    def handle_request_line(self, line):
+        try:
+            request = json.loads(line)
+            op = request.get("op")
+            handler = getattr(self, "do_" + str(op), None)
+            if handler is None:
+                raise ValueError("Unknown op %s" % op)
+            if self.readonly and op in self.writes:
+                raise ValueError("The book is open read only")
+            with self.lock:
+                result = handler(request)
+            return {"ok": True, "result": result}
+        except Exception as error:
+            return {"ok": False, "error": str(error)}
+
+class RequestHandler(socketserver.StreamRequestHandler):
+    def handle(self):
+        for line in self.rfile:
+            if not line.strip():
+                continue
+            answer = self.server.handle_request_line(line)
+            self.wfile.write((json.dumps(answer) + "\n").encode("utf-8"))
+            self.wfile.flush()
+
+def main():
+    parser = OptionParser(usage="%prog [options] BOOK_URI")
+    parser.add_option("--socket", default=os.path.expanduser(
+                          "~/.gnucash/gnucash-daemon.sock"),
+                      help="Unix socket to listen on")
+    parser.add_option("--readonly", action="store_true", default=False,
+                      help="open the book read only and refuse changes")
+    parser.add_option("--ignore-lock", action="store_true", default=False,
+                      help="open the book even if it is locked")
+    options, args = parser.parse_args()
+    if len(args) != 1:
+        parser.error("give the book to serve")
+
+    session = Session(args[0], ignore_lock=options.ignore_lock or
+                      options.readonly)
+    if os.path.exists(options.socket):
+        os.unlink(options.socket)
+    server = BookServer(options.socket, session, options.readonly)
+    os.chmod(options.socket, 0o600)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        if not options.readonly:
+            session.save()
+    finally:
+        server.server_close()
+        os.unlink(options.socket)
+        session.end()
+        session.destroy()
+
+if __name__ == "__main__":
+    main()
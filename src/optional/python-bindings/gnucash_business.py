@@ -328,6 +328,9 @@ methods_return_instance_lists(
 
 Invoice.add_method('gncInvoiceRemoveEntry', 'RemoveEntry')
 
+Book.add_method('gncInvoiceBeginPostBatch', 'begin_invoice_post_batch')
+Book.add_method('gncInvoiceEndPostBatch', 'end_invoice_post_batch')
+
 # Bill
 Bill.add_methods_with_prefix('gncBill')
 
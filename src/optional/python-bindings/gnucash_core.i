@@ -81,6 +81,7 @@
 #include "gncIDSearch.h"
 #include "engine/gnc-pricedb.h"
 #include "app-utils/gnc-prefs-utils.h"
+#include "app-utils/gnc-amortize.h"
 #include "cap-gains.h"
 #include "Scrub3.h"
 %}
@@ -93,11 +94,57 @@
 
 %include <qofbackend.h>
 
+/* Let other Python threads run while these work on the book.  The
+ * engine itself isn't thread safe, so the other threads must leave
+ * GnuCash objects alone meanwhile; none of these calls back into Python
+ * unless given a Python percentage function, which the bindings don't
+ * allow. */
+%define GNC_PY_ALLOW_THREADS(function)
+%exception function {
+    Py_BEGIN_ALLOW_THREADS
+    $action
+    Py_END_ALLOW_THREADS
+}
+%enddef
+
+GNC_PY_ALLOW_THREADS(qof_session_begin)
+GNC_PY_ALLOW_THREADS(qof_session_load)
+GNC_PY_ALLOW_THREADS(qof_session_save)
+GNC_PY_ALLOW_THREADS(qof_session_safe_save)
+GNC_PY_ALLOW_THREADS(qof_session_end)
+GNC_PY_ALLOW_THREADS(qof_session_destroy)
+GNC_PY_ALLOW_THREADS(qof_query_run)
+GNC_PY_ALLOW_THREADS(qof_query_run_subquery)
+GNC_PY_ALLOW_THREADS(gnc_pricedb_end_batch)
+
 // this function is defined in qofsession.h, but isnt found in the libraries,
 // ignored because SWIG attempts to link against (to create language bindings)
 %ignore qof_session_not_saved;
 %include <qofsession.h>
 
+/* A list of dicts, one per object type, keyed like QofBookTypeStats. */
+%typemap(out) GList *qof_book_get_type_stats {
+    GList *node;
+    PyObject *list = PyList_New(0);
+    for (node = $1; node; node = node->next)
+    {
+        QofBookTypeStats *stats = node->data;
+        PyObject *dict = Py_BuildValue("{s:s,s:I,s:K,s:K,s:n,s:n,s:n}",
+            "type", stats->e_type,
+            "count", stats->count,
+            "inserted", (unsigned PY_LONG_LONG) stats->inserted,
+            "removed", (unsigned PY_LONG_LONG) stats->removed,
+            "instance_bytes", (Py_ssize_t) stats->instance_bytes,
+            "kvp_bytes", (Py_ssize_t) stats->kvp_bytes,
+            "index_bytes", (Py_ssize_t) stats->index_bytes);
+        PyList_Append(list, dict);
+        Py_DECREF(dict);
+    }
+    g_list_free_full($1, g_free);
+    $result = list;
+}
+%newobject qof_book_type_stats_to_string;
+
 %include <qofbook.h>
 
 %include <qofid.h>
@@ -216,6 +263,494 @@ static const GncGUID * gncEntryGetGUID(GncEntry *x);
 %include <cap-gains.h>
 %include <Scrub3.h>
 
+/* Bulk export of splits and transactions as columns.  Each column is a
+ * bytes object of native endian fixed size values, so a script can hand
+ * it to numpy.frombuffer or array.array instead of wrapping and calling
+ * into every split.  See Account.ExportSplits in gnucash_core.py for the
+ * column names and types. */
+%{
+static PyObject *
+gnc_py_column (GArray *column)
+{
+    PyObject *bytes = PyBytes_FromStringAndSize (column->data,
+        column->len * g_array_get_element_size (column));
+    g_array_free (column, TRUE);
+    return bytes;
+}
+
+static void
+gnc_py_dict_take (PyObject *dict, const char *key, PyObject *value)
+{
+    PyDict_SetItemString (dict, key, value);
+    Py_DECREF (value);
+}
+
+static PyObject *
+gnc_py_export_split_list (GList *splits)
+{
+    GArray *post_date = g_array_new (FALSE, FALSE, sizeof (gint64));
+    GArray *amount_num = g_array_new (FALSE, FALSE, sizeof (gint64));
+    GArray *amount_denom = g_array_new (FALSE, FALSE, sizeof (gint64));
+    GArray *value_num = g_array_new (FALSE, FALSE, sizeof (gint64));
+    GArray *value_denom = g_array_new (FALSE, FALSE, sizeof (gint64));
+    GArray *account_index = g_array_new (FALSE, FALSE, sizeof (gint32));
+    GArray *trans_index = g_array_new (FALSE, FALSE, sizeof (gint32));
+    GArray *reconcile = g_array_new (FALSE, FALSE, sizeof (gchar));
+    GArray *guid = g_array_new (FALSE, FALSE, GUID_DATA_SIZE);
+    GArray *trans_guid = g_array_new (FALSE, FALSE, GUID_DATA_SIZE);
+    GArray *account_guid = g_array_new (FALSE, FALSE, GUID_DATA_SIZE);
+    GHashTable *accounts = g_hash_table_new (g_direct_hash, g_direct_equal);
+    GHashTable *transactions = g_hash_table_new (g_direct_hash, g_direct_equal);
+    PyObject *dict = PyDict_New ();
+    GList *node;
+
+    for (node = splits; node; node = node->next)
+    {
+        Split *split = node->data;
+        Transaction *trans = xaccSplitGetParent (split);
+        Account *acc = xaccSplitGetAccount (split);
+        gnc_numeric amount = xaccSplitGetAmount (split);
+        gnc_numeric value = xaccSplitGetValue (split);
+        gint64 date = trans ? xaccTransGetDate (trans) : 0;
+        gchar flag = xaccSplitGetReconcile (split);
+        gpointer index;
+        gint32 i;
+
+        if (!g_hash_table_lookup_extended (accounts, acc, NULL, &index))
+        {
+            index = GINT_TO_POINTER (account_guid->len);
+            g_hash_table_insert (accounts, acc, index);
+            g_array_append_vals (account_guid,
+                                 acc ? xaccAccountGetGUID (acc) : guid_null (), 1);
+        }
+        i = GPOINTER_TO_INT (index);
+        g_array_append_val (account_index, i);
+
+        if (!g_hash_table_lookup_extended (transactions, trans, NULL, &index))
+        {
+            index = GINT_TO_POINTER (trans_guid->len);
+            g_hash_table_insert (transactions, trans, index);
+            g_array_append_vals (trans_guid,
+                                 trans ? xaccTransGetGUID (trans) : guid_null (), 1);
+        }
+        i = GPOINTER_TO_INT (index);
+        g_array_append_val (trans_index, i);
+
+        g_array_append_val (post_date, date);
+        g_array_append_val (amount_num, amount.num);
+        g_array_append_val (amount_denom, amount.denom);
+        g_array_append_val (value_num, value.num);
+        g_array_append_val (value_denom, value.denom);
+        g_array_append_val (reconcile, flag);
+        g_array_append_vals (guid, xaccSplitGetGUID (split), 1);
+    }
+    g_hash_table_destroy (accounts);
+    g_hash_table_destroy (transactions);
+
+    gnc_py_dict_take (dict, "count", PyInt_FromLong (guid->len));
+    gnc_py_dict_take (dict, "post_date", gnc_py_column (post_date));
+    gnc_py_dict_take (dict, "amount_num", gnc_py_column (amount_num));
+    gnc_py_dict_take (dict, "amount_denom", gnc_py_column (amount_denom));
+    gnc_py_dict_take (dict, "value_num", gnc_py_column (value_num));
+    gnc_py_dict_take (dict, "value_denom", gnc_py_column (value_denom));
+    gnc_py_dict_take (dict, "account_index", gnc_py_column (account_index));
+    gnc_py_dict_take (dict, "trans_index", gnc_py_column (trans_index));
+    gnc_py_dict_take (dict, "reconcile", gnc_py_column (reconcile));
+    gnc_py_dict_take (dict, "guid", gnc_py_column (guid));
+    gnc_py_dict_take (dict, "trans_guid", gnc_py_column (trans_guid));
+    gnc_py_dict_take (dict, "account_guid", gnc_py_column (account_guid));
+    return dict;
+}
+
+static PyObject *
+gnc_py_export_trans_list (GList *transactions)
+{
+    GArray *post_date = g_array_new (FALSE, FALSE, sizeof (gint64));
+    GArray *enter_date = g_array_new (FALSE, FALSE, sizeof (gint64));
+    GArray *split_count = g_array_new (FALSE, FALSE, sizeof (gint32));
+    GArray *guid = g_array_new (FALSE, FALSE, GUID_DATA_SIZE);
+    GArray *currency_index = g_array_new (FALSE, FALSE, sizeof (gint32));
+    GHashTable *currencies = g_hash_table_new (g_direct_hash, g_direct_equal);
+    PyObject *currency_names = PyList_New (0);
+    PyObject *dict = PyDict_New ();
+    GList *node;
+
+    for (node = transactions; node; node = node->next)
+    {
+        Transaction *trans = node->data;
+        gnc_commodity *currency = xaccTransGetCurrency (trans);
+        gint64 posted = xaccTransGetDate (trans);
+        gint64 entered = xaccTransGetDateEntered (trans);
+        gint32 n_splits = xaccTransCountSplits (trans);
+        gpointer index;
+        gint32 i;
+
+        if (!g_hash_table_lookup_extended (currencies, currency, NULL, &index))
+        {
+            PyObject *name = PyString_FromString (
+                currency ? gnc_commodity_get_unique_name (currency) : "");
+
+            index = GINT_TO_POINTER (PyList_Size (currency_names));
+            g_hash_table_insert (currencies, currency, index);
+            PyList_Append (currency_names, name);
+            Py_DECREF (name);
+        }
+        i = GPOINTER_TO_INT (index);
+
+        g_array_append_val (post_date, posted);
+        g_array_append_val (enter_date, entered);
+        g_array_append_val (split_count, n_splits);
+        g_array_append_val (currency_index, i);
+        g_array_append_vals (guid, xaccTransGetGUID (trans), 1);
+    }
+    g_hash_table_destroy (currencies);
+
+    gnc_py_dict_take (dict, "count", PyInt_FromLong (guid->len));
+    gnc_py_dict_take (dict, "post_date", gnc_py_column (post_date));
+    gnc_py_dict_take (dict, "enter_date", gnc_py_column (enter_date));
+    gnc_py_dict_take (dict, "split_count", gnc_py_column (split_count));
+    gnc_py_dict_take (dict, "currency_index", gnc_py_column (currency_index));
+    gnc_py_dict_take (dict, "guid", gnc_py_column (guid));
+    gnc_py_dict_take (dict, "currencies", currency_names);
+    return dict;
+}
+
+/* The transactions of a list of splits, each once, in the order their
+ * first split comes. */
+static GList *
+gnc_py_split_list_transactions (GList *splits)
+{
+    GHashTable *seen = g_hash_table_new (g_direct_hash, g_direct_equal);
+    GList *transactions = NULL, *node;
+
+    for (node = splits; node; node = node->next)
+    {
+        Transaction *trans = xaccSplitGetParent (node->data);
+
+        if (trans && !g_hash_table_lookup (seen, trans))
+        {
+            g_hash_table_insert (seen, trans, trans);
+            transactions = g_list_prepend (transactions, trans);
+        }
+    }
+    g_hash_table_destroy (seen);
+    return g_list_reverse (transactions);
+}
+
+static GList *
+gnc_py_account_splits (Account *acc, gboolean include_children)
+{
+    GList *splits = g_list_copy (xaccAccountGetSplitList (acc));
+
+    if (include_children)
+    {
+        GList *descendants = gnc_account_get_descendants (acc), *node;
+
+        for (node = descendants; node; node = node->next)
+            splits = g_list_concat (splits,
+                        g_list_copy (xaccAccountGetSplitList (node->data)));
+        g_list_free (descendants);
+    }
+    return splits;
+}
+
+static gboolean
+gnc_py_query_searches_for (QofQuery *q, QofIdTypeConst type)
+{
+    return q && g_strcmp0 (qof_query_get_search_for (q), type) == 0;
+}
+
+/* Accepts the gnucash_core wrapper of an object as well as the SWIG
+ * pointer itself. */
+static void *
+gnc_py_object_pointer (PyObject *obj, const char *type)
+{
+    void *ptr = NULL;
+    PyObject *instance = NULL;
+
+    if (PyObject_HasAttrString (obj, "instance"))
+        obj = instance = PyObject_GetAttrString (obj, "instance");
+    if (SWIG_ConvertPtr (obj, &ptr, SWIG_TypeQuery (type), 0) != 0)
+        ptr = NULL;
+    Py_XDECREF (instance);
+    return ptr;
+}
+
+/* Builds one transaction from (post_date, num, description, splits),
+ * where each split is (account, value_num, value_denom) or that
+ * followed by amount_num and amount_denom. */
+static gboolean
+gnc_py_add_transaction (QofBook *book, gnc_commodity *currency, PyObject *row)
+{
+    PyObject *splits, *seq;
+    Transaction *trans;
+    long long post_date;
+    const char *num, *description;
+    Py_ssize_t i;
+
+    if (!PyArg_ParseTuple (row, "LzzO", &post_date, &num, &description,
+                           &splits))
+        return FALSE;
+    seq = PySequence_Fast (splits, "The splits must be a sequence");
+    if (!seq)
+        return FALSE;
+
+    trans = xaccMallocTransaction (book);
+    xaccTransBeginEdit (trans);
+    xaccTransSetCurrency (trans, currency);
+    xaccTransSetDatePostedSecsNormalized (trans, post_date);
+    xaccTransSetDateEnteredSecs (trans, gnc_time (NULL));
+    if (num)
+        xaccTransSetNum (trans, num);
+    if (description)
+        xaccTransSetDescription (trans, description);
+
+    for (i = 0; i < PySequence_Fast_GET_SIZE (seq); i++)
+    {
+        PyObject *account_obj;
+        long long value_num, value_denom, amount_num = 0, amount_denom = 0;
+        Account *acc;
+        Split *split;
+
+        if (!PyArg_ParseTuple (PySequence_Fast_GET_ITEM (seq, i), "OLL|LL",
+                               &account_obj, &value_num, &value_denom,
+                               &amount_num, &amount_denom))
+            break;
+        acc = gnc_py_object_pointer (account_obj, "Account *");
+        if (!acc)
+        {
+            PyErr_SetString (PyExc_TypeError, "A split needs an Account");
+            break;
+        }
+        split = xaccMallocSplit (book);
+        xaccSplitSetParent (split, trans);
+        xaccSplitSetAccount (split, acc);
+        xaccSplitSetValue (split, gnc_numeric_create (value_num, value_denom));
+        if (amount_denom)
+            xaccSplitSetAmount (split,
+                                gnc_numeric_create (amount_num, amount_denom));
+        else
+            xaccSplitSetAmount (split,
+                                gnc_numeric_create (value_num, value_denom));
+    }
+    Py_DECREF (seq);
+
+    if (PyErr_Occurred ())
+    {
+        xaccTransDestroy (trans);
+        xaccTransCommitEdit (trans);
+        return FALSE;
+    }
+    xaccTransCommitEdit (trans);
+    return TRUE;
+}
+%}
+
+%inline %{
+/* Creates a transaction in currency for each row of transactions, in
+ * one bulk ingestion session; see gnc_py_add_transaction for a row.
+ * Returns how many were made.  A bad row raises an exception; the rows
+ * before it are kept. */
+PyObject *
+gnc_py_book_add_transactions (QofBook *book, gnc_commodity *currency,
+                              PyObject *transactions)
+{
+    PyObject *seq = PySequence_Fast (transactions,
+                                     "The transactions must be a sequence");
+    Py_ssize_t i, n = 0;
+
+    if (!seq)
+        return NULL;
+    gnc_book_begin_bulk_ingest (book);
+    for (i = 0; i < PySequence_Fast_GET_SIZE (seq); i++, n++)
+        if (!gnc_py_add_transaction (book, currency,
+                                     PySequence_Fast_GET_ITEM (seq, i)))
+            break;
+    Py_DECREF (seq);
+
+    Py_BEGIN_ALLOW_THREADS
+    gnc_book_end_bulk_ingest (book);
+    Py_END_ALLOW_THREADS
+
+    if (PyErr_Occurred ())
+        return NULL;
+    return PyInt_FromSsize_t (n);
+}
+
+/* Adds a price of commodity in currency for each (time, num, denom) of
+ * prices, in one pricedb batch.  Returns how many were added. */
+PyObject *
+gnc_py_pricedb_add_prices (GNCPriceDB *db, gnc_commodity *commodity,
+                           gnc_commodity *currency, const char *source,
+                           PyObject *prices)
+{
+    PyObject *seq = PySequence_Fast (prices, "The prices must be a sequence");
+    QofBook *book = qof_instance_get_book (QOF_INSTANCE (db));
+    Py_ssize_t i, n = 0;
+
+    if (!seq)
+        return NULL;
+    gnc_pricedb_begin_batch (db);
+    for (i = 0; i < PySequence_Fast_GET_SIZE (seq); i++)
+    {
+        long long time, num, denom;
+        Timespec ts = { 0, 0 };
+        GNCPrice *price;
+
+        if (!PyArg_ParseTuple (PySequence_Fast_GET_ITEM (seq, i), "LLL",
+                               &time, &num, &denom))
+            break;
+        ts.tv_sec = time;
+        price = gnc_price_create (book);
+        gnc_price_begin_edit (price);
+        gnc_price_set_commodity (price, commodity);
+        gnc_price_set_currency (price, currency);
+        gnc_price_set_time (price, ts);
+        gnc_price_set_source_string (price, source ? source : "user:price");
+        gnc_price_set_typestr (price, "last");
+        gnc_price_set_value (price, gnc_numeric_create (num, denom));
+        gnc_price_commit_edit (price);
+        if (gnc_pricedb_add_price (db, price))
+            n++;
+        gnc_price_unref (price);
+    }
+    Py_DECREF (seq);
+
+    Py_BEGIN_ALLOW_THREADS
+    gnc_pricedb_end_batch (db);
+    Py_END_ALLOW_THREADS
+
+    if (PyErr_Occurred ())
+        return NULL;
+    return PyInt_FromSsize_t (n);
+}
+
+/* The schedules of gnc_amortize_schedules() for a sequence of (rate num,
+ * rate denom, n_periods, principal num, principal denom, denom) tuples:
+ * a list per loan of (payment, interest, principal, balance) tuples,
+ * numerators over the loan's denom. */
+PyObject *
+gnc_py_amortize_schedules (PyObject *loans)
+{
+    PyObject *seq = PySequence_Fast (loans, "The loans must be a sequence");
+    Py_ssize_t i, n_loans;
+    GncLoanTerms *terms;
+    GncAmortRow *rows, *row;
+    gboolean valid;
+    PyObject *result;
+
+    if (!seq)
+        return NULL;
+    n_loans = PySequence_Fast_GET_SIZE (seq);
+    terms = g_new0 (GncLoanTerms, n_loans);
+    for (i = 0; i < n_loans; i++)
+    {
+        long long rate_num, rate_denom, principal_num, principal_denom, denom;
+        int n_periods;
+
+        if (!PyArg_ParseTuple (PySequence_Fast_GET_ITEM (seq, i), "LLiLLL",
+                               &rate_num, &rate_denom, &n_periods,
+                               &principal_num, &principal_denom, &denom))
+        {
+            Py_DECREF (seq);
+            g_free (terms);
+            return NULL;
+        }
+        terms[i].rate = gnc_numeric_create (rate_num, rate_denom);
+        terms[i].n_periods = n_periods;
+        terms[i].principal = gnc_numeric_create (principal_num, principal_denom);
+        terms[i].denom = denom;
+    }
+    Py_DECREF (seq);
+
+    rows = g_new (GncAmortRow, gnc_amortize_n_rows (terms, n_loans));
+    Py_BEGIN_ALLOW_THREADS
+    valid = gnc_amortize_schedules (terms, n_loans, rows);
+    Py_END_ALLOW_THREADS
+    if (!valid)
+    {
+        PyErr_SetString (PyExc_ValueError, "Invalid loan terms");
+        g_free (rows);
+        g_free (terms);
+        return NULL;
+    }
+
+    result = PyList_New (n_loans);
+    for (i = 0, row = rows; i < n_loans; i++)
+    {
+        PyObject *schedule = PyList_New (terms[i].n_periods);
+        gint period;
+
+        for (period = 0; period < terms[i].n_periods; period++, row++)
+            PyList_SET_ITEM (schedule, period,
+                             Py_BuildValue ("(LLLL)",
+                                            (long long) row->payment.num,
+                                            (long long) row->interest.num,
+                                            (long long) row->principal.num,
+                                            (long long) row->balance.num));
+        PyList_SET_ITEM (result, i, schedule);
+    }
+    g_free (rows);
+    g_free (terms);
+    return result;
+}
+
+PyObject *
+gnc_py_export_account_splits (Account *acc, gboolean include_children)
+{
+    GList *splits = gnc_py_account_splits (acc, include_children);
+    PyObject *result = gnc_py_export_split_list (splits);
+
+    g_list_free (splits);
+    return result;
+}
+
+PyObject *
+gnc_py_export_account_transactions (Account *acc, gboolean include_children)
+{
+    GList *splits = gnc_py_account_splits (acc, include_children);
+    GList *transactions = gnc_py_split_list_transactions (splits);
+    PyObject *result = gnc_py_export_trans_list (transactions);
+
+    g_list_free (transactions);
+    g_list_free (splits);
+    return result;
+}
+
+PyObject *
+gnc_py_export_query_splits (QofQuery *q)
+{
+    if (!gnc_py_query_searches_for (q, GNC_ID_SPLIT))
+    {
+        PyErr_SetString (PyExc_ValueError, "The query must search for splits");
+        return NULL;
+    }
+    return gnc_py_export_split_list (qof_query_run (q));
+}
+
+/* Takes a query for transactions, or one for splits, whose transactions
+ * are then exported each once. */
+PyObject *
+gnc_py_export_query_transactions (QofQuery *q)
+{
+    GList *transactions;
+    PyObject *result;
+
+    if (gnc_py_query_searches_for (q, GNC_ID_TRANS))
+        return gnc_py_export_trans_list (qof_query_run (q));
+    if (!gnc_py_query_searches_for (q, GNC_ID_SPLIT))
+    {
+        PyErr_SetString (PyExc_ValueError,
+                         "The query must search for transactions or splits");
+        return NULL;
+    }
+    transactions = gnc_py_split_list_transactions (qof_query_run (q));
+    result = gnc_py_export_trans_list (transactions);
+    g_list_free (transactions);
+    return result;
+}
+%}
+
 %init %{
 gnc_environment_setup();
 qof_log_init();
@@ -170,6 +170,8 @@ class Book(GnuCashCoreClass):
     Methods of interest
     get_root_account -- Returns the root level Account
     get_table -- Returns a commodity lookup table, of type GncCommodityTable
+    get_type_stats -- Returns a list of dicts with the count, churn and
+                      approximate memory use of each type of object
     """
     def InvoiceLookup(self, guid):
         from gnucash_business import Invoice
@@ -296,6 +298,25 @@ class GncNumeric(GnuCashCoreClass):
         """returns a human readable numeric value string as bytes."""
         return unicode(self).encode('utf-8')
 
+def amortize_schedules(loans):
+    """Returns the payment schedules of level payment loans, all worked
+    out in one call (see gnc-amortize.h).
+
+    loans is a sequence of (rate, n_periods, principal, denom) with the
+    rate per period and the principal as GncNumeric, and denom the
+    smallest unit to round to, e.g. 100.  The result has a list per loan
+    of (payment, interest, principal, balance) GncNumeric tuples, one
+    per period.
+    """
+    loans = list(loans)
+    schedules = gnucash_core_c.gnc_py_amortize_schedules(
+        [(rate.num(), rate.denom(), n_periods,
+          principal.num(), principal.denom(), denom)
+         for rate, n_periods, principal, denom in loans])
+    return [[tuple(GncNumeric(num, loan[3]) for num in row)
+             for row in schedule]
+            for schedule, loan in zip(schedules, loans)]
+
 class GncPrice(GnuCashCoreClass):
     '''
     Each priceEach price in the database represents an "instantaneous"
@@ -341,6 +362,9 @@ class GncPriceDB(GnuCashCoreClass):
     '''
 
 GncPriceDB.add_methods_with_prefix('gnc_pricedb_')
+# AddPrices(commodity, currency, source, prices) adds a price for each
+# (time, num, denom) of prices in one batch; source may be None.
+GncPriceDB.add_method('gnc_py_pricedb_add_prices', 'AddPrices')
 PriceDB_dict =  {
                 'lookup_latest' : GncPrice,
                 'lookup_nearest_in_time' : GncPrice,
@@ -499,6 +523,11 @@ Book.add_method('gnc_book_set_root_account', 'set_root_account')
 Book.add_method('gnc_commodity_table_get_table', 'get_table')
 Book.add_method('gnc_pricedb_get_db', 'get_price_db')
 Book.add_method('qof_book_increment_and_format_counter', 'increment_and_format_counter')
+# AddTransactions(currency, rows) makes a transaction for each row of
+# (post_date, num, description, splits), post_date in seconds, each split
+# (account, value_num, value_denom[, amount_num, amount_denom]).  They
+# are committed in one bulk ingestion session; returns how many.
+Book.add_method('gnc_py_book_add_transactions', 'AddTransactions')
 
 #Functions that return Account
 Book.get_root_account = method_function_returns_instance(
@@ -680,6 +709,49 @@ methods_return_instance_lists(
                        })
 Account.name = property( Account.GetName, Account.SetName )
 
+# Bulk export, for scripts that go over many splits.  Each returns a dict
+# of columns; most are bytes of native endian values to read with
+# numpy.frombuffer or array.array, one value per row:
+#
+# ExportSplits: 'post_date' int64 seconds of the transaction's posting,
+#   'amount_num', 'amount_denom', 'value_num', 'value_denom' int64,
+#   'reconcile' one char, 'guid' 16 bytes, 'account_index' and
+#   'trans_index' int32 rows of 'account_guid' and 'trans_guid', which
+#   hold 16 bytes for each distinct account and transaction.
+# ExportTransactions: 'post_date', 'enter_date' int64, 'split_count'
+#   int32, 'guid' 16 bytes, 'currency_index' int32 into 'currencies',
+#   a list of the currencies' unique names.
+#
+# Both also have 'count', the number of rows.  The account methods take
+# whether to include the descendants' splits, default False.
+Account.add_method('gnc_py_export_account_splits', 'ExportSplits')
+Account.add_method('gnc_py_export_account_transactions', 'ExportTransactions')
+def include_children_default_false(function):
+    return default_arguments_decorator(function, None, False)
+Account.decorate_functions(include_children_default_false,
+                           'ExportSplits', 'ExportTransactions')
+
+class GncAccountBalances(GnuCashCoreClass):
+    '''
+    A snapshot of the balances of an account and all its descendants at
+    the start and end of a period, taken in one pass over the tree.
+
+    GncAccountBalances(root, start, end, report_commodity)
+
+    Definition in file Account.h.
+    '''
+
+GncAccountBalances.add_constructor_and_methods_with_prefix(
+    'gnc_account_balances_', 'new')
+GncAccountBalances.add_method('gnc_account_balances_free', 'free')
+account_balances_dict = {
+                    'get_nth_account' : Account,
+                    'get_balance' : GncNumeric,
+                    'get_change' : GncNumeric,
+                    'get_report_balance' : GncNumeric
+                }
+methods_return_instance(GncAccountBalances, account_balances_dict)
+
 #GUID
 GUID.add_methods_with_prefix('guid_')
 GUID.add_method('xaccAccountLookup', 'AccountLookup')
@@ -734,6 +806,10 @@ class Query(GnuCashCoreClass):
     pass
 
 Query.add_constructor_and_methods_with_prefix('qof_query_', 'create')
+# See Account.ExportSplits for the columns.  ExportSplits needs a query
+# for splits; ExportTransactions takes one for splits or transactions.
+Query.add_method('gnc_py_export_query_splits', 'ExportSplits')
+Query.add_method('gnc_py_export_query_transactions', 'ExportTransactions')
 
 Query.add_method('qof_query_set_book', 'set_book')
 Query.add_method('qof_query_search_for', 'search_for')
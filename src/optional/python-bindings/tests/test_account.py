@@ -1,4 +1,5 @@
 from unittest import main
+from array import array
 from datetime import datetime
 from gnucash import Book, Account, Split, GncCommodity, GncNumeric, \
     Transaction
@@ -66,5 +67,32 @@ class TestAccount( AccountSession ):
         self.account.ScrubLots()
         self.assertEqual(len(self.account.GetLotList()),1)
 
+    def test_export_splits(self):
+        self.account.SetCommodity(self.currency)
+        other = Account(self.book)
+        other.SetCommodity(self.currency)
+
+        tx = Transaction(self.book)
+        tx.BeginEdit()
+        tx.SetCurrency(self.currency)
+        tx.SetDatePostedTS(datetime.now())
+        for account, amount in ((self.account, 1234), (other, -1234)):
+            split = Split(self.book)
+            split.SetParent(tx)
+            split.SetAccount(account)
+            split.SetAmount(GncNumeric(amount, 100))
+            split.SetValue(GncNumeric(amount, 100))
+        tx.CommitEdit()
+
+        columns = self.account.ExportSplits()
+        self.assertEqual(columns['count'], 1)
+        self.assertEqual(array('q', columns['amount_num']).tolist(), [1234])
+        self.assertEqual(array('q', columns['amount_denom']).tolist(), [100])
+        self.assertEqual(len(columns['trans_guid']), 16)
+
+        columns = self.account.ExportTransactions()
+        self.assertEqual(columns['count'], 1)
+        self.assertEqual(array('i', columns['split_count']).tolist(), [2])
+
 if __name__ == '__main__':
     main()
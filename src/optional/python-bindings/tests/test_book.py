@@ -13,5 +13,15 @@ class TestBook( BookSession ):
     def test_markclosed(self):
         self.ses.end()
 
+    def test_type_stats(self):
+        stats = dict((s['type'], s) for s in self.book.get_type_stats())
+        self.assertTrue('Commodity' in stats)
+        commodities = stats['Commodity']
+        self.assertTrue(commodities['count'] > 0)
+        self.assertEqual(commodities['count'],
+            commodities['inserted'] - commodities['removed'])
+        self.assertTrue(commodities['instance_bytes'] > 0)
+        self.assertTrue('Total' in self.book.type_stats_to_string())
+
 if __name__ == '__main__':
     main()
@@ -23,6 +23,7 @@
 
 #include "config.h"
 
+#include <string.h>
 #include <time.h>
 
 #include "Account.h"
@@ -72,12 +73,38 @@ struct gnc_ledger_display
     gpointer user_data;
 
     gint component_id;
+
+    /* When the book's backend loads transactions as they are needed, an
+     * account register loads them a page at a time, latest first, and
+     * shows those posted since the earliest page loaded. */
+    gboolean paged;
+    gint pages_loaded;
+    gboolean all_pages_loaded;
+    GncSplitPageKey page_first;
+    Query *page_query;
+
+    /* The rows of the last load, to tell whether a refresh changes them. */
+    GArray *loaded_rows;
+    Split *loaded_blank_split;
 };
 
+/* What decides the rows a split gets in the register: its position in
+ * the list, the number of splits in its transaction and, for the
+ * dividers, its date. */
+typedef struct
+{
+    Split *split;
+    gint n_splits;
+    time64 date_posted;
+} LedgerRowKey;
+
 
 /** GLOBALS *********************************************************/
 static QofLogModule log_module = GNC_MOD_LEDGER;
 
+/* A page is a screenful of transactions and plenty to scroll through. */
+#define LEDGER_PAGE_SIZE 200
+
 
 /** Declarations ****************************************************/
 static GNCLedgerDisplay *
@@ -89,6 +116,8 @@ gnc_ledger_display_internal (Account *lead_account, Query *q,
                              gboolean is_template);
 static void gnc_ledger_display_refresh_internal (GNCLedgerDisplay *ld,
         GList *splits);
+static GList *gnc_ledger_display_run_query (GNCLedgerDisplay *ld);
+static GArray *gnc_ledger_display_row_keys (GList *splits);
 
 
 /** Implementations *************************************************/
@@ -577,7 +606,29 @@ refresh_handler (GHashTable *changes, gpointer user_data)
      * changed, requiring a full new query.  Similar considerations
      * needed for multi-user mode.
      */
-    splits = qof_query_run (ld->query);
+    splits = gnc_ledger_display_run_query (ld);
+
+    /* Most events just modify transactions already shown.  If the rows
+     * of the register stay the same, only the values shown need to be
+     * reloaded, not the whole table.  A refresh without changes is a
+     * forced one and always reloads. */
+    if (changes && ld->loaded_rows &&
+            gnc_split_register_full_refresh_ok (ld->reg) &&
+            ld->loaded_blank_split == gnc_split_register_get_blank_split (ld->reg))
+    {
+        GArray *rows = gnc_ledger_display_row_keys (splits);
+        gboolean same = (rows->len == ld->loaded_rows->len &&
+                         memcmp (rows->data, ld->loaded_rows->data,
+                                 rows->len * sizeof (LedgerRowKey)) == 0);
+
+        g_array_free (rows, TRUE);
+        if (same)
+        {
+            gnc_split_register_refresh_rows (ld->reg);
+            LEAVE("rows unchanged");
+            return;
+        }
+    }
 
     gnc_ledger_display_set_watches (ld, splits);
 
@@ -603,10 +654,103 @@ close_handler (gpointer user_data)
 
     qof_query_destroy (ld->query);
     ld->query = NULL;
+    qof_query_destroy (ld->page_query);
+    ld->page_query = NULL;
+
+    if (ld->loaded_rows)
+        g_array_free (ld->loaded_rows, TRUE);
 
     g_free (ld);
 }
 
+static GList *
+gnc_ledger_display_page_accounts (GNCLedgerDisplay *ld)
+{
+    Account *leader = gnc_ledger_display_leader (ld);
+    GList *accounts = NULL;
+
+    if (ld->ld_type == LD_SUBACCOUNT)
+        accounts = gnc_account_get_descendants (leader);
+    return g_list_prepend (accounts, leader);
+}
+
+/* Load the page of transactions before the ones loaded so far. */
+static gboolean
+gnc_ledger_display_load_page (GNCLedgerDisplay *ld)
+{
+    GList *accounts;
+    gint n;
+
+    if (!ld->paged || ld->all_pages_loaded)
+        return FALSE;
+
+    accounts = gnc_ledger_display_page_accounts (ld);
+    n = gnc_book_load_split_page (gnc_get_current_book (), accounts,
+                                  ld->pages_loaded ? &ld->page_first : NULL,
+                                  LEDGER_PAGE_SIZE, &ld->page_first);
+    g_list_free (accounts);
+
+    if (n > 0)
+        ld->pages_loaded++;
+    if (n < LEDGER_PAGE_SIZE)
+        ld->all_pages_loaded = TRUE;
+    return n > 0;
+}
+
+/* Run the register's query.  A paged register only shows the splits
+ * posted since the earliest page loaded, so that the backend isn't asked
+ * for all of them, but first loads back as far as a date filter on the
+ * query reaches. */
+static GList *
+gnc_ledger_display_run_query (GNCLedgerDisplay *ld)
+{
+    time64 start, end;
+
+    if (!ld->paged)
+        return qof_query_run (ld->query);
+
+    xaccQueryGetDateMatchTT (ld->query, &start, &end);
+    if (start != 0)
+        while (!ld->all_pages_loaded && ld->page_first.date_posted > start &&
+               gnc_ledger_display_load_page (ld))
+            ;
+
+    qof_query_destroy (ld->page_query);
+    ld->page_query = qof_query_copy (ld->query);
+    if (ld->pages_loaded && !ld->all_pages_loaded)
+        xaccQueryAddDateMatchTT (ld->page_query, TRUE,
+                                 ld->page_first.date_posted,
+                                 FALSE, 0, QOF_QUERY_AND);
+    return qof_query_run (ld->page_query);
+}
+
+gboolean
+gnc_ledger_display_load_more (GNCLedgerDisplay *ld)
+{
+    if (!ld || ld->loading || !gnc_ledger_display_load_page (ld))
+        return FALSE;
+
+    gnc_ledger_display_refresh (ld);
+    return TRUE;
+}
+
+void
+gnc_ledger_display_include_date (GNCLedgerDisplay *ld, time64 date)
+{
+    gboolean loaded = FALSE;
+
+    if (!ld || ld->loading)
+        return;
+
+    while (ld->paged && !ld->all_pages_loaded &&
+           ld->page_first.date_posted > date &&
+           gnc_ledger_display_load_page (ld))
+        loaded = TRUE;
+
+    if (loaded)
+        gnc_ledger_display_refresh (ld);
+}
+
 static void
 gnc_ledger_display_make_query (GNCLedgerDisplay *ld,
                                gint limit,
@@ -657,6 +801,14 @@ gnc_ledger_display_make_query (GNCLedgerDisplay *ld,
                               QOF_GUID_MATCH_ANY, QOF_QUERY_AND);
 
     g_list_free (accounts);
+
+    /* A limited register already has the backend load just its last
+     * splits, and a search ledger shows all it finds. */
+    ld->paged = (limit == 0 && type != SEARCH_LEDGER &&
+                 gnc_book_has_split_pages (gnc_get_current_book ()));
+    ld->pages_loaded = 0;
+    ld->all_pages_loaded = FALSE;
+    (void)gnc_ledger_display_load_page (ld);
 }
 
 /* Opens up a ledger window for an arbitrary query. */
@@ -762,6 +914,10 @@ gnc_ledger_display_internal (Account *lead_account, Query *q,
     ld->destroy = NULL;
     ld->get_parent = NULL;
     ld->user_data = NULL;
+    ld->paged = FALSE;
+    ld->pages_loaded = 0;
+    ld->all_pages_loaded = FALSE;
+    ld->page_query = NULL;
 
     limit = gnc_prefs_get_float(GNC_PREFS_GROUP_GENERAL_REGISTER, GNC_PREF_MAX_TRANS);
 
@@ -785,7 +941,7 @@ gnc_ledger_display_internal (Account *lead_account, Query *q,
 
     gnc_split_register_set_data (ld->reg, ld, gnc_ledger_display_parent);
 
-    splits = qof_query_run (ld->query);
+    splits = gnc_ledger_display_run_query (ld);
 
     gnc_ledger_display_set_watches (ld, splits);
 
@@ -833,9 +989,35 @@ gnc_ledger_display_refresh_internal (GNCLedgerDisplay *ld, GList *splits)
     gnc_split_register_load (ld->reg, splits,
                              gnc_ledger_display_leader (ld));
 
+    if (ld->loaded_rows)
+        g_array_free (ld->loaded_rows, TRUE);
+    ld->loaded_rows = gnc_ledger_display_row_keys (splits);
+    ld->loaded_blank_split = gnc_split_register_get_blank_split (ld->reg);
+
     ld->loading = FALSE;
 }
 
+static GArray *
+gnc_ledger_display_row_keys (GList *splits)
+{
+    GArray *rows = g_array_new (FALSE, TRUE, sizeof (LedgerRowKey));
+    GList *node;
+
+    for (node = splits; node; node = node->next)
+    {
+        LedgerRowKey key;
+        Transaction *trans = xaccSplitGetParent (node->data);
+
+        /* Clear the padding so that keys can be compared with memcmp. */
+        memset (&key, 0, sizeof (key));
+        key.split = node->data;
+        key.n_splits = xaccTransCountSplits (trans);
+        key.date_posted = xaccTransGetDate (trans);
+        g_array_append_val (rows, key);
+    }
+    return rows;
+}
+
 void
 gnc_ledger_display_refresh (GNCLedgerDisplay *ld)
 {
@@ -853,7 +1035,7 @@ gnc_ledger_display_refresh (GNCLedgerDisplay *ld)
         return;
     }
 
-    gnc_ledger_display_refresh_internal (ld, qof_query_run (ld->query));
+    gnc_ledger_display_refresh_internal (ld, gnc_ledger_display_run_query (ld));
     LEAVE(" ");
 }
 
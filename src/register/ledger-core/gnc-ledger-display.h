@@ -120,6 +120,16 @@ GNCLedgerDisplay * gnc_ledger_display_find_by_query (Query *q);
 void gnc_ledger_display_refresh (GNCLedgerDisplay * ledger_display);
 void gnc_ledger_display_refresh_by_split_register (SplitRegister *reg);
 
+/** When the book's backend loads transactions as they are needed, an
+ * account register loads them a page at a time, latest first.  Load the
+ * page before the earliest one shown and redisplay.  Returns FALSE if
+ * there was nothing more to load. */
+gboolean gnc_ledger_display_load_more (GNCLedgerDisplay *ld);
+
+/** Load pages of a paged register until it shows the splits posted on
+ * the date, redisplaying it if any were loaded. */
+void gnc_ledger_display_include_date (GNCLedgerDisplay *ld, time64 date);
+
 /** close the window */
 void gnc_ledger_display_close (GNCLedgerDisplay * ledger_display);
 
@@ -658,17 +658,25 @@ static Split *
 gnc_find_split_in_account_by_memo (Account *account, const char *memo,
                                    gboolean unit_price)
 {
+    Transaction *trans;
+    Split *split;
     GList *slp;
 
     if (account == NULL) return NULL;
 
+    /* The most recent transaction with the memo is the answer unless
+     * its split with the memo doesn't have a unit price. */
+    trans = xaccAccountFindTransByMemo (account, memo);
+    if (trans == NULL)
+        return NULL;
+    split = gnc_find_split_in_trans_by_memo (trans, memo, unit_price);
+    if (split) return split;
+
     for (slp = g_list_last (xaccAccountGetSplitList (account));
             slp;
             slp = slp->prev)
     {
-        Split *split = slp->data;
-        Transaction *trans = xaccSplitGetParent (split);
-
+        trans = xaccSplitGetParent (slp->data);
         split = gnc_find_split_in_trans_by_memo (trans, memo, unit_price);
 
         if (split) return split;
@@ -677,6 +685,59 @@ gnc_find_split_in_account_by_memo (Account *account, const char *memo,
     return NULL;
 }
 
+/* Index the descriptions and memos of the transactions in the
+ * register, from the bottom up so the lowest transaction having one is
+ * the one found. */
+static void
+gnc_split_register_build_text_index (SplitRegister *reg, SRInfo *info)
+{
+    int virt_row, virt_col;
+    Transaction *last_trans = NULL;
+
+    info->desc_trans = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                              g_free, NULL);
+    info->memo_trans = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                              g_free, NULL);
+
+    for (virt_row = reg->table->num_virt_rows - 1; virt_row >= 0; virt_row--)
+        for (virt_col = reg->table->num_virt_cols - 1; virt_col >= 0; virt_col--)
+        {
+            VirtualCellLocation vcell_loc = { virt_row, virt_col };
+            Transaction *trans;
+            const char *text;
+            GList *node;
+
+            trans = xaccSplitGetParent (gnc_split_register_get_split (reg,
+                                        vcell_loc));
+            if (trans == NULL || trans == last_trans)
+                continue;
+            last_trans = trans;
+
+            text = xaccTransGetDescription (trans);
+            if (text && !g_hash_table_lookup (info->desc_trans, text))
+                g_hash_table_insert (info->desc_trans, g_strdup (text), trans);
+            for (node = xaccTransGetSplitList (trans); node; node = node->next)
+            {
+                text = xaccSplitGetMemo (node->data);
+                if (text && !g_hash_table_lookup (info->memo_trans, text))
+                    g_hash_table_insert (info->memo_trans, g_strdup (text),
+                                         trans);
+            }
+        }
+}
+
+static Transaction *
+gnc_split_register_lookup_text (SplitRegister *reg, gboolean memo,
+                                const char *text)
+{
+    SRInfo *info = gnc_split_register_get_info (reg);
+
+    if (!info->desc_trans)
+        gnc_split_register_build_text_index (reg, info);
+    return g_hash_table_lookup (memo ? info->memo_trans : info->desc_trans,
+                                text);
+}
+
 static Split *
 gnc_find_split_in_reg_by_memo (SplitRegister *reg, const char *memo,
                                gboolean unit_price)
@@ -684,9 +745,19 @@ gnc_find_split_in_reg_by_memo (SplitRegister *reg, const char *memo,
     int virt_row, virt_col;
     int num_rows, num_cols;
     Transaction *last_trans;
+    Split *split;
+
+    if (!reg || !reg->table || !memo)
+        return NULL;
 
-    if (!reg || !reg->table)
+    /* As for an account, the lowest transaction with the memo is the
+     * answer unless the split with it doesn't have a unit price. */
+    last_trans = gnc_split_register_lookup_text (reg, TRUE, memo);
+    if (last_trans == NULL)
         return NULL;
+    split = gnc_find_split_in_trans_by_memo (last_trans, memo, unit_price);
+    if (split)
+        return split;
 
     num_rows = reg->table->num_virt_rows;
     num_cols = reg->table->num_virt_cols;
@@ -696,7 +767,6 @@ gnc_find_split_in_reg_by_memo (SplitRegister *reg, const char *memo,
     for (virt_row = num_rows - 1; virt_row >= 0; virt_row--)
         for (virt_col = num_cols - 1; virt_col >= 0; virt_col--)
         {
-            Split *split;
             Transaction *trans;
             VirtualCellLocation vcell_loc = { virt_row, virt_col };
 
@@ -719,38 +789,10 @@ gnc_find_split_in_reg_by_memo (SplitRegister *reg, const char *memo,
 static Transaction *
 gnc_find_trans_in_reg_by_desc (SplitRegister *reg, const char *description)
 {
-    int virt_row, virt_col;
-    int num_rows, num_cols;
-    Transaction *last_trans;
-
-    if (!reg || !reg->table)
+    if (!reg || !reg->table || !description)
         return NULL;
 
-    num_rows = reg->table->num_virt_rows;
-    num_cols = reg->table->num_virt_cols;
-
-    last_trans = NULL;
-
-    for (virt_row = num_rows - 1; virt_row >= 0; virt_row--)
-        for (virt_col = num_cols - 1; virt_col >= 0; virt_col--)
-        {
-            Split *split;
-            Transaction *trans;
-            VirtualCellLocation vcell_loc = { virt_row, virt_col };
-
-            split = gnc_split_register_get_split (reg, vcell_loc);
-            trans = xaccSplitGetParent(split);
-
-            if (trans == last_trans)
-                continue;
-
-            if (g_strcmp0 (description, xaccTransGetDescription (trans)) == 0)
-                return trans;
-
-            last_trans = trans;
-        }
-
-    return NULL;
+    return gnc_split_register_lookup_text (reg, FALSE, description);
 }
 
 /* This function determines if auto-completion is appropriate and,
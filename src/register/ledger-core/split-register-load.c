@@ -30,6 +30,7 @@
 #include "combocell.h"
 #include "gnc-component-manager.h"
 #include "qof.h"
+#include "gnc-trans-quickfill.h"
 #include "gnc-ui-util.h"
 #include "gnc-gui-query.h"
 #include "numcell.h"
@@ -48,6 +49,7 @@ static QofLogModule log_module = GNC_MOD_LEDGER;
 
 static void gnc_split_register_load_xfer_cells (SplitRegister *reg,
         Account *base_account);
+static void gnc_split_register_load_desc_cells (SplitRegister *reg);
 
 static void
 gnc_split_register_load_recn_cells (SplitRegister *reg)
@@ -191,6 +193,7 @@ gnc_split_register_add_transaction (SplitRegister *reg,
     /* Set the "leading" virtual cell. */
     gnc_table_set_vcell (reg->table, lead_cursor, xaccSplitGetGUID (split),
                          TRUE, start_primary_color, *vcell_loc);
+    gnc_split_register_index_row (reg, split, vcell_loc->virt_row);
     vcell_loc->virt_row++;
 
     /* Continue setting up virtual cells in a column, using a row for each
@@ -206,6 +209,7 @@ gnc_split_register_add_transaction (SplitRegister *reg,
         gnc_table_set_vcell (reg->table, split_cursor,
                              xaccSplitGetGUID (secondary),
                              visible_splits, TRUE, *vcell_loc);
+        gnc_split_register_index_row (reg, secondary, vcell_loc->virt_row);
         vcell_loc->virt_row++;
     }
 
@@ -234,13 +238,6 @@ _find_split_with_parent_txn(gconstpointer a, gconstpointer b)
 static void add_quickfill_completions(TableLayout *layout, Transaction *trans,
                                       Split *split, gboolean has_last_num)
 {
-    Split *s;
-    int i = 0;
-
-    gnc_quickfill_cell_add_completion(
-        (QuickFillCell *) gnc_table_layout_get_cell(layout, DESC_CELL),
-        xaccTransGetDescription(trans));
-
     gnc_quickfill_cell_add_completion(
         (QuickFillCell *) gnc_table_layout_get_cell(layout, NOTES_CELL),
         xaccTransGetNotes(trans));
@@ -249,14 +246,6 @@ static void add_quickfill_completions(TableLayout *layout, Transaction *trans,
         gnc_num_cell_set_last_num(
             (NumCell *) gnc_table_layout_get_cell(layout, NUM_CELL),
             gnc_get_num_action(trans, split));
-
-    while ((s = xaccTransGetSplit(trans, i)) != NULL)
-    {
-        gnc_quickfill_cell_add_completion(
-            (QuickFillCell *) gnc_table_layout_get_cell(layout, MEMO_CELL),
-            xaccSplitGetMemo(s));
-        i++;
-    }
 }
 
 static Split*
@@ -474,6 +463,19 @@ gnc_split_register_load (SplitRegister *reg, GList * slist,
         gnc_table_move_cursor_gui (table, virt_loc);
     }
 
+    /* start a new row index */
+    if (info->split_rows)
+    {
+        g_hash_table_remove_all (info->split_rows);
+        g_array_set_size (info->split_row_links, 0);
+    }
+    else
+    {
+        info->split_rows = g_hash_table_new (g_direct_hash, g_direct_equal);
+        info->split_row_links = g_array_new (FALSE, TRUE, sizeof (int));
+    }
+    gnc_split_register_clear_text_index (reg);
+
     /* make sure that the header is loaded */
     vcell_loc.virt_row = 0;
     vcell_loc.virt_col = 0;
@@ -509,6 +511,7 @@ gnc_split_register_load (SplitRegister *reg, GList * slist,
 
         /* load up account names into the transfer combobox menus */
         gnc_split_register_load_xfer_cells (reg, default_account);
+        gnc_split_register_load_desc_cells (reg);
         gnc_split_register_load_associate_cells (reg);
         gnc_split_register_load_recn_cells (reg);
         gnc_split_register_load_type_cells (reg);
@@ -790,6 +793,36 @@ gnc_split_register_load (SplitRegister *reg, GList * slist,
     LEAVE(" ");
 }
 
+void
+gnc_split_register_refresh_rows (SplitRegister *reg)
+{
+    Table *table;
+    VirtualLocation virt_loc;
+
+    g_return_if_fail(reg);
+    table = reg->table;
+    g_return_if_fail(table);
+
+    ENTER("reg=%p", reg);
+
+    /* Reload the cursor cells from the (possibly changed) split, with
+     * the move callback disabled as in a full load. */
+    gnc_table_control_allow_move (table->control, FALSE);
+
+    virt_loc = table->current_cursor_loc;
+    if (gnc_table_virtual_loc_valid (table, virt_loc, TRUE))
+        gnc_table_move_cursor_gui (table, virt_loc);
+
+    gnc_split_register_set_cell_fractions(
+        reg, gnc_split_register_get_current_split (reg));
+
+    gnc_table_refresh_gui (table, FALSE);
+
+    gnc_table_control_allow_move (table->control, TRUE);
+
+    LEAVE(" ");
+}
+
 /* ===================================================================== */
 
 #define QKEY  "split_reg_shared_quickfill"
@@ -833,4 +866,24 @@ gnc_split_register_load_xfer_cells (SplitRegister *reg, Account *base_account)
     gnc_combo_cell_use_list_store_cache (cell, store);
 }
 
+/* The description and memo completions come from the whole book, not
+ * just the splits shown in this register, and are shared by all open
+ * registers. */
+static void
+gnc_split_register_load_desc_cells (SplitRegister *reg)
+{
+    QofBook *book = gnc_get_current_book ();
+    QuickFillCell *cell;
+
+    cell = (QuickFillCell *)
+           gnc_table_layout_get_cell (reg->table->layout, DESC_CELL);
+    gnc_quickfill_cell_use_quickfill_cache (cell,
+            gnc_get_shared_trans_desc_quickfill (book));
+
+    cell = (QuickFillCell *)
+           gnc_table_layout_get_cell (reg->table->layout, MEMO_CELL);
+    gnc_quickfill_cell_use_quickfill_cache (cell,
+            gnc_get_shared_split_memo_quickfill (book));
+}
+
 /* ====================== END OF FILE ================================== */
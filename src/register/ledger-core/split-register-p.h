@@ -100,6 +100,19 @@ struct sr_info
     /** true if we are loading the register for the first time */
     gboolean first_pass;
 
+    /** Index of the rows of the loaded table: maps each Split to the
+     * last virtual row showing it.  split_row_links holds, for each
+     * row, the previous row showing the same split, or 0. */
+    GHashTable *split_rows;
+    GArray *split_row_links;
+
+    /** Indexes from transaction description, and from split memo, to
+     * the transaction lowest in the table having it, for auto-completion
+     * in registers without a default account.  Built on first use after
+     * each load; NULL until then. */
+    GHashTable *desc_trans;
+    GHashTable *memo_trans;
+
     /** true if the user has already confirmed changes of a reconciled
      * split */
     gboolean change_confirmed;
@@ -143,6 +156,15 @@ GtkWidget *gnc_split_register_get_parent (SplitRegister *reg);
 Split * gnc_split_register_get_split (SplitRegister *reg,
                                       VirtualCellLocation vcell_loc);
 
+/** Record in the register's row index that split is shown in the
+ *  virtual row v_row. */
+void gnc_split_register_index_row (SplitRegister *reg, Split *split,
+                                   int v_row);
+
+/** Forget the register's auto-completion indexes, as when it is
+ *  reloaded. */
+void gnc_split_register_clear_text_index (SplitRegister *reg);
+
 Account * gnc_split_register_get_default_account (SplitRegister *reg);
 
 Transaction * gnc_split_register_get_trans (SplitRegister *reg,
@@ -103,6 +103,41 @@ gnc_split_register_get_split (SplitRegister *reg,
     return xaccSplitLookup (guid, gnc_get_current_book ());
 }
 
+void
+gnc_split_register_index_row (SplitRegister *reg, Split *split, int v_row)
+{
+    SRInfo *info = gnc_split_register_get_info (reg);
+    GArray *links;
+
+    if (!info || !info->split_rows || !split)
+        return;
+
+    links = info->split_row_links;
+    if (links->len <= v_row)
+        g_array_set_size (links, v_row + 1);
+
+    /* Chain this row to the row that was last recorded for the split.
+     * Rows are recorded top to bottom while loading, so the chain
+     * runs upwards from the last row showing the split. */
+    g_array_index (links, int, v_row) =
+        GPOINTER_TO_INT (g_hash_table_lookup (info->split_rows, split));
+    g_hash_table_insert (info->split_rows, split, GINT_TO_POINTER (v_row));
+}
+
+void
+gnc_split_register_clear_text_index (SplitRegister *reg)
+{
+    SRInfo *info = gnc_split_register_get_info (reg);
+
+    if (!info)
+        return;
+    if (info->desc_trans)
+        g_hash_table_destroy (info->desc_trans);
+    if (info->memo_trans)
+        g_hash_table_destroy (info->memo_trans);
+    info->desc_trans = info->memo_trans = NULL;
+}
+
 Account *
 gnc_split_register_get_default_account (SplitRegister *reg)
 {
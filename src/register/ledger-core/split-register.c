@@ -322,6 +322,38 @@ gnc_split_register_get_split_virt_loc (SplitRegister *reg, Split *split,
 
     table = reg->table;
 
+    /* Use the row index built when the register was loaded, if any.
+     * Its chains run from the last row showing the split upwards, so
+     * this finds the same row as the search below. */
+    if (reg->sr_info && reg->sr_info->split_rows)
+    {
+        SRInfo *info = reg->sr_info;
+
+        for (v_row = GPOINTER_TO_INT (g_hash_table_lookup (info->split_rows, split));
+                v_row > 0 && v_row < info->split_row_links->len;
+                v_row = g_array_index (info->split_row_links, int, v_row))
+        {
+            VirtualCellLocation vc_loc = { v_row, 0 };
+            VirtualCell *vcell;
+
+            if (v_row >= table->num_virt_rows)
+                continue;
+
+            vcell = gnc_table_get_virtual_cell (table, vc_loc);
+            if (!vcell || !vcell->visible)
+                continue;
+
+            if (xaccSplitLookup (vcell->vcell_data, gnc_get_current_book ()) == split)
+            {
+                if (vcell_loc)
+                    *vcell_loc = vc_loc;
+
+                return TRUE;
+            }
+        }
+        return FALSE;
+    }
+
     /* go backwards because typically you search for splits at the end
      * and because we find split rows before transaction rows. */
 
@@ -1753,6 +1785,8 @@ gnc_split_register_save (SplitRegister *reg, gboolean do_commit)
         gnc_table_set_virt_cell_data (reg->table,
                                       reg->table->current_cursor_loc.vcell_loc,
                                       xaccSplitGetGUID (split));
+        gnc_split_register_index_row (reg, split,
+                                      reg->table->current_cursor_loc.vcell_loc.virt_row);
         DEBUG("assigned cell to new split=%p", split);
 
         trans_split = gnc_split_register_get_current_trans_split (reg, NULL);
@@ -2867,6 +2901,12 @@ gnc_split_register_destroy_info (SplitRegister *reg)
     info->credit_str = NULL;
     info->tcredit_str = NULL;
 
+    if (info->split_rows)
+        g_hash_table_destroy (info->split_rows);
+    if (info->split_row_links)
+        g_array_free (info->split_row_links, TRUE);
+    gnc_split_register_clear_text_index (reg);
+
     g_free (reg->sr_info);
 
     reg->sr_info = NULL;
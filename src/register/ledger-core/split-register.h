@@ -497,6 +497,15 @@ void gnc_split_register_cancel_cursor_trans_changes (SplitRegister *reg);
 void gnc_split_register_load (SplitRegister *reg, GList * slist,
                               Account *default_account);
 
+/** Reload the cursor and redraw the register without rebuilding its
+ *  rows.  This is only correct if the register would be loaded with
+ *  exactly the same rows again, e.g. when the transactions shown
+ *  were modified without adding, removing or reordering any splits.
+ *
+ *  @param reg a ::SplitRegister
+ */
+void gnc_split_register_refresh_rows (SplitRegister *reg);
+
 /** Copy the contents of the current cursor to a split. The split and
  *    transaction that are updated are the ones associated with the
  *    current cursor (register entry) position. If the do_commit flag
@@ -176,27 +176,17 @@ gnucash_grid_find_block_by_pixel (GnucashGrid *grid,
     g_return_val_if_fail(y >= 0, NULL);
     g_return_val_if_fail(x >= 0, NULL);
 
-    do
-    {
-        block = gnucash_sheet_get_block (grid->sheet, vc_loc);
-        if (!block)
-            return NULL;
-
-        if (block->visible &&
-                y >= block->origin_y &&
-                y < block->origin_y + block->style->dimensions->height)
-        {
-            if (vcell_loc)
-                vcell_loc->virt_row = vc_loc.virt_row;
-            break;
-        }
-        vc_loc.virt_row++;
-    }
-    while (vc_loc.virt_row < grid->sheet->num_virt_rows);
+    vc_loc.virt_row = gnucash_sheet_y_pixel_to_block (grid->sheet, y);
+    if (vc_loc.virt_row >= grid->sheet->num_virt_rows)
+        return NULL;
 
-    if (vc_loc.virt_row == grid->sheet->num_virt_rows)
+    block = gnucash_sheet_get_block (grid->sheet, vc_loc);
+    if (!block || y < block->origin_y)
         return NULL;
 
+    if (vcell_loc)
+        vcell_loc->virt_row = vc_loc.virt_row;
+
     do
     {
         block = gnucash_sheet_get_block (grid->sheet, vc_loc);
@@ -450,6 +440,65 @@ static guint32 dec_intensity_10percent(guint32 argb)
     return result;
 }
 
+/* Fill in the cached rendering of a cell from the table. */
+static void
+fill_cell_cache (GnucashGrid *grid, SheetBlock *block,
+                 VirtualLocation virt_loc, SheetCellCache *cache)
+{
+    Table *table = grid->sheet->table;
+    PangoRectangle logical_rect;
+    const char *text;
+    gboolean read_only_row;
+    guint32 argb;
+
+    read_only_row = ((virt_loc.phys_row_offset == (block->style->nrows - 1))
+                     && (table->model->dividing_row_upper >= 0)
+                     && (virt_loc.vcell_loc.virt_row <
+                         table->model->dividing_row_upper));
+
+    if (grid->sheet->use_theme_colors)
+    {
+        cache->bg_color = gnc_table_get_gtkrc_bg_color (table, virt_loc,
+                          &cache->hatching);
+        cache->fg_color = gnc_table_get_gtkrc_fg_color (table, virt_loc);
+    }
+    else
+    {
+        argb = gnc_table_get_bg_color (table, virt_loc, &cache->hatching);
+        // Are we in a read-only row? Then make the background color somewhat more gray.
+        if (read_only_row)
+            argb = dec_intensity_10percent(argb);
+        cache->bg_color = argb;
+
+        argb = gnc_table_get_fg_color (table, virt_loc);
+#ifdef READONLY_LINES_WITH_CHANGED_FG_COLOR
+        // Are we in a read-only row? Then make the foreground color somewhat less black
+        if (read_only_row)
+            argb = inc_intensity_10percent(argb);
+#endif
+        cache->fg_color = argb;
+    }
+
+    text = gnc_table_get_entry (table, virt_loc);
+    if (text && *text)
+    {
+        cache->layout = gtk_widget_create_pango_layout (GTK_WIDGET (grid->sheet),
+                        text);
+        // We don't need word wrap or line wrap
+        pango_layout_set_width (cache->layout, -1);
+        pango_layout_get_pixel_extents (cache->layout, NULL, &logical_rect);
+        cache->text_width = logical_rect.width;
+    }
+    else
+    {
+        cache->layout = NULL;
+        cache->text_width = 0;
+    }
+
+    cache->align = gnc_table_get_align (table, virt_loc);
+    cache->valid = TRUE;
+}
+
 static void
 draw_cell (GnucashGrid *grid,
            SheetBlock *block,
@@ -459,38 +508,36 @@ draw_cell (GnucashGrid *grid,
 {
     Table *table = grid->sheet->table;
     PhysicalCellBorders borders;
+    SheetCellCache *cache;
     const char *text;
     PangoLayout *layout;
-    PangoContext *context;
     PangoFontDescription *font;
-    PangoRectangle logical_rect;
     GdkColor *bg_color;
     GdkColor *fg_color;
     /*        gint x_offset, y_offset;*/
     GdkRectangle rect;
-    gboolean hatching;
-    guint32 argb, color_type;
+    int text_width;
     int x_offset;
 
+    cache = gnucash_sheet_block_get_cell_cache (block,
+            virt_loc.phys_row_offset,
+            virt_loc.phys_col_offset);
+    g_return_if_fail (cache != NULL);
+
+    if (!cache->valid)
+        fill_cell_cache (grid, block, virt_loc, cache);
+
     gdk_gc_set_background (grid->gc, &gn_white);
 
     if (grid->sheet->use_theme_colors)
     {
-        color_type = gnc_table_get_gtkrc_bg_color (table, virt_loc,
-                     &hatching);
-        bg_color = get_gtkrc_color(grid->sheet, color_type);
+        bg_color = get_gtkrc_color (grid->sheet, cache->bg_color);
+        fg_color = get_gtkrc_color (grid->sheet, cache->fg_color);
     }
     else
     {
-        argb = gnc_table_get_bg_color (table, virt_loc, &hatching);
-        // Are we in a read-only row? Then make the background color somewhat more gray.
-        if ((virt_loc.phys_row_offset == (block->style->nrows - 1))
-                && (table->model->dividing_row_upper >= 0)
-                && (virt_loc.vcell_loc.virt_row < table->model->dividing_row_upper))
-        {
-            argb = dec_intensity_10percent(argb);
-        }
-        bg_color = gnucash_color_argb_to_gdk (argb);
+        bg_color = gnucash_color_argb_to_gdk (cache->bg_color);
+        fg_color = gnucash_color_argb_to_gdk (cache->fg_color);
     }
 
     gdk_gc_set_foreground (grid->gc, bg_color);
@@ -535,7 +582,7 @@ draw_cell (GnucashGrid *grid,
                      y + height : y + height - 1),
                     borders.right);
 
-    if (hatching)
+    if (cache->hatching)
         gnucash_draw_hatching (drawable, grid->gc,
                                x, y, width, height);
 
@@ -626,64 +673,42 @@ draw_cell (GnucashGrid *grid,
         }
     }
 
-    text = gnc_table_get_entry (table, virt_loc);
-
-    layout = gtk_widget_create_pango_layout (GTK_WIDGET (grid->sheet), text);
-    // We don't need word wrap or line wrap
-    pango_layout_set_width (layout, -1);
-    context = pango_layout_get_context (layout);
-    font = pango_font_description_copy (pango_context_get_font_description (context));
-
-    if (grid->sheet->use_theme_colors)
-    {
-        color_type = gnc_table_get_gtkrc_fg_color (table, virt_loc);
-        fg_color = get_gtkrc_color(grid->sheet, color_type);
-    }
-    else
-    {
-        argb = gnc_table_get_fg_color (table, virt_loc);
-#ifdef READONLY_LINES_WITH_CHANGED_FG_COLOR
-        // Are we in a read-only row? Then make the foreground color somewhat less black
-        if ((virt_loc.phys_row_offset == (block->style->nrows - 1))
-                && (table->model->dividing_row_upper >= 0)
-                && (virt_loc.vcell_loc.virt_row < table->model->dividing_row_upper))
-        {
-            argb = inc_intensity_10percent(argb);
-        }
-#endif
-        fg_color = gnucash_color_argb_to_gdk (argb);
-    }
+    layout = cache->layout;
+    text_width = cache->text_width;
+    font = NULL;
 
     gdk_gc_set_foreground (grid->gc, fg_color);
 
     /* If this is the currently open transaction and
        there is no text in this cell */
     if ((table->current_cursor_loc.vcell_loc.virt_row ==
-            virt_loc.vcell_loc.virt_row) &&
-            (!text || strlen(text) == 0))
+            virt_loc.vcell_loc.virt_row) && (layout == NULL))
     {
+        PangoRectangle logical_rect;
+
         text = gnc_table_get_label (table, virt_loc);
         if ((text == NULL) || (*text == '\0'))
-            goto exit;
+            return;
         gdk_gc_set_foreground (grid->gc, &gn_light_gray);
-        pango_layout_set_text (layout, text, strlen (text));
+
+        layout = gtk_widget_create_pango_layout (GTK_WIDGET (grid->sheet), text);
+        pango_layout_set_width (layout, -1);
+        font = pango_font_description_copy
+               (pango_context_get_font_description
+                (pango_layout_get_context (layout)));
         pango_font_description_set_style (font, PANGO_STYLE_ITALIC);
-        pango_context_set_font_description (context, font);
+        pango_layout_set_font_description (layout, font);
+        pango_layout_get_pixel_extents (layout, NULL, &logical_rect);
+        text_width = logical_rect.width;
     }
 
-    if ((text == NULL) || (*text == '\0'))
-    {
-        goto exit;
-    }
+    if (layout == NULL)
+        return;
 
     /*y_offset = ((height / 2) +
                 (((font->ascent + font->descent) / 2) - font->descent));
     y_offset++;*/
 
-    pango_layout_get_pixel_extents(layout,
-                                   NULL,
-                                   &logical_rect);
-
     rect.x      = x + CELL_HPADDING;
     rect.y      = y + CELL_VPADDING;
     rect.width  = MAX (0, width - (2 * CELL_HPADDING));
@@ -692,7 +717,7 @@ draw_cell (GnucashGrid *grid,
     gdk_gc_set_clip_rectangle (grid->gc, &rect);
 
 
-    switch (gnc_table_get_align (table, virt_loc))
+    switch (cache->align)
     {
     default:
     case CELL_ALIGN_LEFT:
@@ -700,15 +725,15 @@ draw_cell (GnucashGrid *grid,
         break;
 
     case CELL_ALIGN_RIGHT:
-        x_offset = width - 2 * CELL_HPADDING - logical_rect.width;
+        x_offset = width - 2 * CELL_HPADDING - text_width;
         break;
 
     case CELL_ALIGN_CENTER:
-        if (logical_rect.width > width - 2 * CELL_HPADDING)
+        if (text_width > width - 2 * CELL_HPADDING)
             x_offset = 0;
         else
             x_offset = (width - 2 * CELL_HPADDING -
-                        logical_rect.width) / 2;
+                        text_width) / 2;
         break;
     }
 
@@ -722,11 +747,11 @@ draw_cell (GnucashGrid *grid,
 
     gdk_gc_set_clip_rectangle (grid->gc, NULL);
 
-exit:
-    pango_font_description_set_style (font, PANGO_STYLE_NORMAL);
-    pango_context_set_font_description (context, font);
-    pango_font_description_free (font);
-    g_object_unref (layout);
+    if (font)
+    {
+        pango_font_description_free (font);
+        g_object_unref (layout);
+    }
 }
 
 static void
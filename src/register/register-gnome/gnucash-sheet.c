@@ -362,22 +362,48 @@ gnucash_sheet_cursor_move (GnucashSheet *sheet, VirtualLocation virt_loc)
 }
 
 
-static gint
+gint
 gnucash_sheet_y_pixel_to_block (GnucashSheet *sheet, int y)
 {
     VirtualCellLocation vcell_loc = { 1, 0 };
+    SheetBlock *block;
+    gint lo = 1, hi = sheet->num_virt_rows;
 
-    for (;
-            vcell_loc.virt_row < sheet->num_virt_rows;
-            vcell_loc.virt_row++)
+    /* Block origins never decrease down the sheet, hidden blocks sharing
+     * the origin of the next shown one, so bisect for the first block
+     * that starts below y.  The last shown block before it is the one
+     * under y. */
+    while (lo < hi)
     {
-        SheetBlock *block;
+        vcell_loc.virt_row = lo + (hi - lo) / 2;
+        block = gnucash_sheet_get_block (sheet, vcell_loc);
 
+        if (block->origin_y <= y)
+            lo = vcell_loc.virt_row + 1;
+        else
+            hi = vcell_loc.virt_row;
+    }
+
+    for (vcell_loc.virt_row = lo - 1;
+            vcell_loc.virt_row >= 1;
+            vcell_loc.virt_row--)
+    {
         block = gnucash_sheet_get_block (sheet, vcell_loc);
-        if (!block || !block->visible)
+        if (!block->visible)
             continue;
 
         if (block->origin_y + block->style->dimensions->height > y)
+            return vcell_loc.virt_row;
+        break;
+    }
+
+    /* Nothing shown above y, take the first shown block after it. */
+    for (vcell_loc.virt_row = lo;
+            vcell_loc.virt_row < sheet->num_virt_rows;
+            vcell_loc.virt_row++)
+    {
+        block = gnucash_sheet_get_block (sheet, vcell_loc);
+        if (block && block->visible)
             break;
     }
 
@@ -638,12 +664,68 @@ gnucash_sheet_hadjustment_changed (GtkAdjustment *adj,
 }
 
 
+SheetCellCache *
+gnucash_sheet_block_get_cell_cache (SheetBlock *block, int row, int col)
+{
+    gint size;
+
+    g_return_val_if_fail (block != NULL, NULL);
+    g_return_val_if_fail (block->style != NULL, NULL);
+
+    size = block->style->nrows * block->style->ncols;
+    if (row < 0 || row >= block->style->nrows ||
+            col < 0 || col >= block->style->ncols)
+        return NULL;
+
+    if (block->cell_cache_size != size)
+    {
+        gnucash_sheet_block_clear_cache (block);
+        block->cell_cache = g_new0 (SheetCellCache, size);
+        block->cell_cache_size = size;
+    }
+
+    return &block->cell_cache[row * block->style->ncols + col];
+}
+
+void
+gnucash_sheet_block_clear_cache (SheetBlock *block)
+{
+    gint i;
+
+    if (block == NULL || block->cell_cache == NULL)
+        return;
+
+    for (i = 0; i < block->cell_cache_size; i++)
+        if (block->cell_cache[i].layout)
+            g_object_unref (block->cell_cache[i].layout);
+
+    g_free (block->cell_cache);
+    block->cell_cache = NULL;
+    block->cell_cache_size = 0;
+}
+
+static void
+gnucash_sheet_clear_cache (GnucashSheet *sheet)
+{
+    gint i, j;
+
+    if (sheet->blocks == NULL)
+        return;
+
+    for (i = 0; i < g_table_rows (sheet->blocks); i++)
+        for (j = 0; j < g_table_cols (sheet->blocks); j++)
+            gnucash_sheet_block_clear_cache
+            (g_table_index (sheet->blocks, i, j));
+}
+
 void
 gnucash_sheet_redraw_all (GnucashSheet *sheet)
 {
     g_return_if_fail (sheet != NULL);
     g_return_if_fail (GNUCASH_IS_SHEET(sheet));
 
+    gnucash_sheet_clear_cache (sheet);
+
     gnome_canvas_request_redraw (GNOME_CANVAS (sheet), 0, 0,
                                  sheet->width + 1, sheet->height + 1);
 
@@ -676,6 +758,8 @@ gnucash_sheet_redraw_block (GnucashSheet *sheet, VirtualCellLocation vcell_loc)
     if (!block || !block->style)
         return;
 
+    gnucash_sheet_block_clear_cache (block);
+
     x = block->origin_x;
     y = block->origin_y;
 
@@ -731,6 +815,18 @@ gnucash_sheet_realize (GtkWidget *widget)
 }
 
 
+static void
+gnucash_sheet_style_set (GtkWidget *widget, GtkStyle *previous_style)
+{
+    if (GTK_WIDGET_CLASS (sheet_parent_class)->style_set)
+        (*GTK_WIDGET_CLASS (sheet_parent_class)->style_set)(widget,
+                previous_style);
+
+    /* The cached layouts use the old font */
+    gnucash_sheet_clear_cache (GNUCASH_SHEET (widget));
+}
+
+
 static GnucashSheet *
 gnucash_sheet_create (Table *table)
 {
@@ -2344,6 +2440,8 @@ gnucash_sheet_block_set_from_table (GnucashSheet *sheet,
 
     vcell = gnc_table_get_virtual_cell (table, vcell_loc);
 
+    gnucash_sheet_block_clear_cache (block);
+
     if (block->style && (block->style != style))
     {
         gnucash_style_unref (block->style);
@@ -2459,6 +2557,8 @@ gnucash_sheet_block_destroy (gpointer _block, gpointer user_data)
     if (block == NULL)
         return;
 
+    gnucash_sheet_block_clear_cache (block);
+
     if (block->style)
     {
         gnucash_style_unref (block->style);
@@ -2473,6 +2573,8 @@ gnucash_sheet_block_construct (gpointer _block, gpointer user_data)
 
     block->style = NULL;
     block->visible = TRUE;
+    block->cell_cache = NULL;
+    block->cell_cache_size = 0;
 }
 
 static void
@@ -2752,6 +2854,7 @@ gnucash_sheet_class_init (GnucashSheetClass *klass)
     gobject_class->finalize = gnucash_sheet_finalize;
 
     widget_class->realize = gnucash_sheet_realize;
+    widget_class->style_set = gnucash_sheet_style_set;
 
     widget_class->size_request = gnucash_sheet_size_request;
     widget_class->size_allocate = gnucash_sheet_size_allocate;
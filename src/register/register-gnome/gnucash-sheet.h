@@ -56,6 +56,22 @@ typedef struct _GnucashRegister GnucashRegister;
 typedef struct _GnucashRegisterClass GnucashRegisterClass;
 
 
+/** What the grid needs to draw one cell, as read from the table.  It
+ *  is filled in when the cell is first drawn and dropped whenever the
+ *  block is redrawn from the table. */
+typedef struct
+{
+    gboolean valid;
+
+    PangoLayout *layout; /** layout of the entry, NULL if it is empty */
+    gint text_width;     /** logical pixel width of the layout */
+    CellAlignment align;
+
+    guint32 bg_color;    /** argb, or the gtkrc color type */
+    guint32 fg_color;    /** argb, or the gtkrc color type */
+    gboolean hatching;
+} SheetCellCache;
+
 typedef struct
 {
     /** The style for this block */
@@ -65,6 +81,11 @@ typedef struct
     gint origin_y; /** y origin of block */
 
     gboolean visible; /** is block visible */
+
+    /** Render cache for the cells of the block, indexed by
+     *  row * ncols + col, or NULL if nothing is cached */
+    SheetCellCache *cell_cache;
+    gint cell_cache_size;
 } SheetBlock;
 
 
@@ -83,6 +104,10 @@ GtkWidget *gnucash_register_new (Table *table);
 SheetBlock *gnucash_sheet_get_block (GnucashSheet *sheet,
                                      VirtualCellLocation vcell_loc);
 
+/** Return the virtual row of the block shown at pixel height y, or
+ *  the number of virtual rows if y lies below the last block. */
+gint gnucash_sheet_y_pixel_to_block (GnucashSheet *sheet, int y);
+
 gint gnucash_sheet_col_max_width (GnucashSheet *sheet,
                                   gint virt_col, gint cell_col);
 
@@ -92,6 +117,14 @@ void gnucash_sheet_redraw_help (GnucashSheet *sheet);
 void gnucash_sheet_redraw_block (GnucashSheet *sheet,
                                  VirtualCellLocation vcell_loc);
 
+/** Return the render cache entry of the given cell of a block,
+ *  allocating the block's cache if needed. */
+SheetCellCache *gnucash_sheet_block_get_cell_cache (SheetBlock *block,
+                                                    int row, int col);
+
+/** Drop the cached rendering of a block's cells. */
+void gnucash_sheet_block_clear_cache (SheetBlock *block);
+
 void gnucash_sheet_cursor_set (GnucashSheet *gsheet, VirtualLocation virt_loc);
 
 const char * gnucash_sheet_modify_current_cell(GnucashSheet *sheet,
@@ -547,9 +547,9 @@
 					      current-row-style
 					      cust-doc? credit-note?)))
 
-	    (if display-all-taxes
-		(let ((tax-list (gncEntryGetDocTaxValues current cust-doc? credit-note?)))
-		  (update-account-hash acct-hash tax-list))
+	    ;; With all taxes displayed, acct-hash already holds the
+	    ;; invoice's tax totals.
+	    (if (not display-all-taxes)
 		(tax-collector 'add
 			       (gnc:gnc-monetary-commodity (cdr entry-values))
 			       (gnc:gnc-monetary-amount (cdr entry-values))))
@@ -598,7 +598,11 @@
 			      (gnc:make-commodity-collector)
 			      (gnc:make-commodity-collector)
 			      totals
-			      (make-account-hash))
+			      (let ((acct-hash (make-account-hash)))
+			        (if display-all-taxes
+			            (update-account-hash
+			             acct-hash (gncInvoiceGetTotalTaxValues invoice)))
+			        acct-hash))
       table)))
 
 (define (string-expand string character replace-string)
@@ -2177,42 +2177,78 @@
 
     ;; for quarterly estimated tax payments, we need a different period
     ;; return the sometimes changed (from-est to-est full-year?) dates
+    (define (txf-special-period from-value to-value)
+      (let*
+          ((full-year?
+            (let ((bdto (localtime (car to-value)))
+                  (bdfrom (localtime (car from-value))))
+              (and (equal? (tm:year bdto) (tm:year bdfrom))
+                   (equal? (tm:mon bdfrom) 0)
+                   (equal? (tm:mday bdfrom) 1)
+                   (equal? (tm:mon bdto) 11)
+                   (equal? (tm:mday bdto) 31))))
+           ;; Adjust dates so we get the final Estimated Tax
+           ;; paymnent from the right year
+           (from-est (if full-year?
+                         (let ((bdtm (gnc:timepair->date
+                                      (timespecCanonicalDayTime
+                                       from-value))))
+                           (set-tm:mday bdtm 1) ; 01
+                           (set-tm:mon bdtm 2) ; Mar
+                           (set-tm:isdst bdtm -1)
+                           (cons (car (mktime bdtm)) 0))
+                         from-value))
+           (to-est (if full-year?
+                       (let* ((bdtm (gnc:timepair->date
+                                     (timespecCanonicalDayTime
+                                      from-value))))
+                         (set-tm:mday bdtm 28) ; 28
+                         (set-tm:mon bdtm 1) ; Feb
+                         (set-tm:year bdtm (+ (tm:year bdtm) 1))
+                         (set-tm:isdst bdtm -1)
+                         (cons (car (mktime bdtm)) 0))
+                       to-value)))
+        (list from-est to-est full-year?)))
+
     (define (txf-special-splits-period account from-value to-value)
       (if (and (xaccAccountGetTaxRelated account)
                (txf-special-date? (gnc:account-get-txf-code account)))
-          (let*
-              ((full-year?
-                (let ((bdto (localtime (car to-value)))
-                      (bdfrom (localtime (car from-value))))
-                  (and (equal? (tm:year bdto) (tm:year bdfrom))
-                       (equal? (tm:mon bdfrom) 0)
-                       (equal? (tm:mday bdfrom) 1)
-                       (equal? (tm:mon bdto) 11)
-                       (equal? (tm:mday bdto) 31))))
-              ;; Adjust dates so we get the final Estimated Tax
-              ;; paymnent from the right year
-               (from-est (if full-year?
-                             (let ((bdtm (gnc:timepair->date
-                                          (timespecCanonicalDayTime
-                                           from-value))))
-                               (set-tm:mday bdtm 1) ; 01
-                               (set-tm:mon bdtm 2) ; Mar
-                               (set-tm:isdst bdtm -1)
-                               (cons (car (mktime bdtm)) 0))
-                             from-value))
-               (to-est (if full-year?
-                           (let* ((bdtm (gnc:timepair->date
-                                         (timespecCanonicalDayTime
-                                          from-value))))
-                             (set-tm:mday bdtm 28) ; 28
-                             (set-tm:mon bdtm 1) ; Feb
-                             (set-tm:year bdtm (+ (tm:year bdtm) 1))
-                             (set-tm:isdst bdtm -1)
-                             (cons (car (mktime bdtm)) 0))
-                           to-value)))
-            (list from-est to-est full-year?))
+          (txf-special-period from-value to-value)
           #f))
 
+    ;; The splits of every tax related account in the report period and
+    ;; in the special period, looked up in one go by the engine the
+    ;; first time an account is handled.  A hash table from the
+    ;; account's guid to a list of the two split lists.
+    (define tax-split-table #f)
+
+    (define (make-tax-split-table)
+      (let* ((special-period (txf-special-period from-value to-value))
+             (periods (list (cons from-value
+                                  (gnc:timepair-end-day-time to-value))
+                            (cons (car special-period)
+                                  (gnc:timepair-end-day-time
+                                   (cadr special-period)))))
+             (totals (gnc-account-tax-totals-new-for-periods
+                      (gnc-get-current-root-account) periods))
+             (table (make-hash-table)))
+        (do ((n 0 (+ n 1)))
+            ((= n (gnc-account-tax-totals-get-n-accounts totals)))
+          (let ((account (gnc-account-tax-totals-get-nth-account totals n)))
+            (hash-set! table (gncAccountGetGUID account)
+                       (list (gnc-account-tax-totals-get-splits totals account 0)
+                             (gnc-account-tax-totals-get-splits totals account 1)))))
+        (gnc-account-tax-totals-free totals)
+        table))
+
+    (define (tax-split-list account special? split-filter-pred)
+      (if (not tax-split-table)
+          (set! tax-split-table (make-tax-split-table)))
+      (let ((splits (hash-ref tax-split-table (gncAccountGetGUID account))))
+        (if splits
+            (if special? (cadr splits) (car splits))
+            (make-split-list account split-filter-pred))))
+
     (define (handle-account account
                             table
                             need-form-line-acct-header?
@@ -2242,7 +2278,10 @@
                                  (if (and (not no-special-dates?) splits-period)
                                      to-special
                                      to-value)))
-              (split-list (make-split-list account split-filter-pred))
+              (split-list (tax-split-list account
+                                          (and (not no-special-dates?)
+                                               splits-period #t)
+                                          split-filter-pred))
               (account-USD-total (gnc-numeric-zero))
               (account-cap-gain-sales-USD-total (gnc-numeric-zero))
               (account-cap-gain-basis-USD-total (gnc-numeric-zero))
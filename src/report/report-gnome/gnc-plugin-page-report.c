@@ -1300,6 +1300,7 @@ gnc_plugin_page_report_reload_cb( GtkAction *action, GncPluginPageReport *report
     DEBUG( "reload-redraw" );
     dirty_report = scm_c_eval_string("gnc:report-set-dirty?!");
     scm_call_2(dirty_report, priv->cur_report, SCM_BOOL_T);
+    gnc_report_cache_forget(priv->cur_report);
 
     priv->need_reload = TRUE;
     /* now queue the fact that we need to reload this report */
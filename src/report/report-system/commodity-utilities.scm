@@ -124,84 +124,10 @@
 ;; 'time' is the timepair when the <gnc:numeric*> 'price' was valid.
 (define (gnc:get-commodity-totalavg-prices
 	 currency-accounts end-date-tp price-commodity report-currency)
-  (let ((total-foreign (gnc-numeric-zero))
-	(total-domestic (gnc-numeric-zero)))
-    (filter 
-     gnc:price-is-not-zero?
-     (map-in-order
-      (lambda (a)
-	(let* ((transaction-comm (xaccTransGetCurrency
-				  (xaccSplitGetParent a)))
-	       (account-comm (xaccAccountGetCommodity
-			      (xaccSplitGetAccount a)))
-	       (share-amount (gnc-numeric-abs
-			      (xaccSplitGetAmount a)))
-	       (value-amount (gnc-numeric-abs
-			      (xaccSplitGetValue a)))
-	       (transaction-date (gnc-transaction-get-date-posted
-				  (xaccSplitGetParent a)))
-	       (foreignlist
-		(if (gnc-commodity-equiv transaction-comm
-					  price-commodity)
-		    (list account-comm
-			  share-amount value-amount)
-		    (list transaction-comm
-			  value-amount share-amount))))
-	  
-	  ;;(warn "gnc:get-commodity-totalavg-prices: value " 
-	  ;;    (gnc-commodity-numeric->string
-	  ;;(first foreignlist) (second foreignlist))
-	  ;;      " bought shares "
-	  ;;    (gnc-commodity-numeric->string
-	  ;;price-commodity (third foreignlist)))
-
-	  ;; Try EURO exchange if necessary
-	  (if (not (gnc-commodity-equiv (first foreignlist)
-					 report-currency))
-	      (let ((exchanged (gnc:exchange-by-euro-numeric
-				(first foreignlist) (second foreignlist)
-				report-currency transaction-date)))
-		(if exchanged
-		    (set! foreignlist
-			  (list report-currency
-				(gnc:gnc-monetary-amount exchanged)
-				(third foreignlist))))))
-	  
-	  (list
-	   transaction-date
-	   (if (not (gnc-commodity-equiv (first foreignlist)
-					  report-currency))
-	       (begin
-		 (warn "gnc:get-commodity-totalavg-prices: " 
-		       "Sorry, currency exchange not yet implemented:"
-		       (gnc-commodity-numeric->string
-			(first foreignlist) (second foreignlist))
-		       " (buying "
-		       (gnc-commodity-numeric->string
-			price-commodity (third foreignlist))
-		       ") =? "
-		       (gnc-commodity-numeric->string
-			report-currency (gnc-numeric-zero)))
-		 (gnc-numeric-zero))
-	       (begin
-		 (set! total-foreign (gnc-numeric-add total-foreign
-                                                      (third foreignlist)
-                                                      GNC-DENOM-AUTO
-                                                      GNC-DENOM-LCD))
-		 (set! total-domestic (gnc-numeric-add total-domestic
-                                                       (second foreignlist)
-                                                       GNC-DENOM-AUTO
-                                                       GNC-DENOM-LCD))
-		 (gnc-numeric-div
-		  total-domestic
-		  total-foreign
-		  GNC-DENOM-AUTO 
-		  (logior (GNC-DENOM-SIGFIGS 8) GNC-RND-ROUND)))))))
-      ;; Get all the interesting splits, and sort them according to the
-      ;; date.
-      (gnc:get-match-commodity-splits-sorted
-       currency-accounts 
-       end-date-tp price-commodity)))))
+  ;; The splits are scanned in C, once for all commodities and
+  ;; reports until the book changes.
+  (gnc-exchange-totalavg-prices-to-scm
+   currency-accounts end-date-tp price-commodity report-currency))
 
 ;; Create a list of prices for all commodities in 'commodity-list',
 ;; i.e. the same thing as in get-commodity-totalavg-prices but
@@ -526,184 +452,54 @@
 ;; this functions to use some kind of recursiveness.
 
 
+;; Turns the totals from gnc-exchange-totals-to-scm into a sumlist:
+;; a multilevel alist. Each element has a commodity as key, and
+;; another alist as a value. The value-alist's elements consist of a
+;; commodity as a key, and a pair of two value-collectors as value,
+;; e.g. with only one (the report-) commodity DEM in the outer alist:
+;; ( {DEM ( [USD (400 .  1000)] [FRF (300 . 100)] ) } ) where
+;; DEM,USD,FRF are <gnc:commodity> and the numbers are a
+;; numeric-collector which in turn store a <gnc:numeric>. In the
+;; example, USD 400 were bought for an amount of DEM 1000, FRF 300
+;; were bought for DEM 100. The reason for the outer alist is that
+;; there might be commodity transactions which do not involve the
+;; report-commodity, but which can still be calculated after *all*
+;; transactions are processed.
+(define (gnc:exchange-totals->sumlist totals)
+  (map
+   (lambda (group)
+     (list (car group)
+	   (map
+	    (lambda (pair)
+	      (let ((amount-coll (gnc:make-numeric-collector))
+		    (group-coll (gnc:make-numeric-collector)))
+		(amount-coll 'add (cadr pair))
+		(group-coll 'add (caddr pair))
+		(list (car pair) (cons amount-coll group-coll))))
+	    (cadr group))))
+   totals))
+
 ;; Calculate the weighted average exchange rate between all
 ;; commodities and the 'report-commodity'. Uses all currency
 ;; transactions up until the 'end-date'. Returns an alist, see
-;; sumlist.
+;; sumlist. The absolute value and share amounts of the splits are
+;; added up in C, see gnc-exchange-totals.h.
 (define (gnc:get-exchange-totals report-commodity end-date)
-  (let ((curr-accounts 
-	 ;;(filter gnc:account-has-shares? ))
-	 ;; -- use all accounts, not only share accounts, since gnucash-1.7
-	 (gnc-account-get-descendants-sorted (gnc-get-current-root-account)))
-	;; sumlist: a multilevel alist. Each element has a commodity
-	;; as key, and another alist as a value. The value-alist's
-	;; elements consist of a commodity as a key, and a pair of two
-	;; value-collectors as value, e.g. with only one (the report-)
-	;; commodity DEM in the outer alist: ( {DEM ( [USD (400 .
-	;; 1000)] [FRF (300 . 100)] ) } ) where DEM,USD,FRF are
-	;; <gnc:commodity> and the numbers are a numeric-collector
-	;; which in turn store a <gnc:numeric>. In the example, USD
-	;; 400 were bought for an amount of DEM 1000, FRF 300 were
-	;; bought for DEM 100. The reason for the outer alist is that
-	;; there might be commodity transactions which do not involve
-	;; the report-commodity, but which can still be calculated
-	;; after *all* transactions are processed.
-	(sumlist (list (list report-commodity '()))))
-
-    (if (not (null? curr-accounts))
-	;; Go through all splits and add up all value-amounts
-	;; and share-amounts
-	(for-each 
-	 (lambda (a)
-	   (let* ((transaction-comm (xaccTransGetCurrency
-				     (xaccSplitGetParent a)))
-		  (account-comm (xaccAccountGetCommodity
-				 (xaccSplitGetAccount a)))
-		  ;; Always use the absolute value here.
-		  (share-amount (gnc-numeric-abs
-				 (xaccSplitGetAmount a)))
-		  (value-amount (gnc-numeric-abs
-				 (xaccSplitGetValue a)))
-		  (tmp (assoc transaction-comm sumlist))
-		  (comm-list (if (not tmp) 
-				 (assoc account-comm sumlist)
-				 tmp)))
-	       
-             (cond ((gnc-numeric-zero-p share-amount)
-                    ;; Without shares this is not a buy or sell; ignore it.
-                    #f)
-
-                   ((not comm-list)
-	            ;; entry doesn't exist in comm-list
-		    ;; create sub-alist from scratch
-		    (let ((pair (list transaction-comm
-				      (cons (gnc:make-numeric-collector)
-					    (gnc:make-numeric-collector)))))
-		      ((caadr pair) 'add value-amount)
-		      ((cdadr pair) 'add share-amount)
-		      (set! comm-list (list account-comm (list pair)))
-		      ;; and add the new sub-alist to sumlist.
-		      (set! sumlist (cons comm-list sumlist))))
-
-                   (else
-		    (let* 
-		          ;; Put the amounts in the right place.
-		          ((foreignlist 
-		            (if (gnc-commodity-equiv transaction-comm
-						      (car comm-list))
-			        (list account-comm 
-				      share-amount value-amount)
-			        (list transaction-comm 
-				      value-amount share-amount)))
-		           ;; second commodity already existing in comm-list?
-		           (pair (assoc (car foreignlist) (cadr comm-list))))
-		      ;; if not, create a new entry in comm-list.
-		      (if (not pair)
-		          (begin
-			    (set! 
-			     pair (list (car foreignlist)
-				        (cons (gnc:make-numeric-collector) 
-					      (gnc:make-numeric-collector))))
-			    (set! 
-			     comm-list (list (car comm-list) 
-					     (cons pair (cadr comm-list))))
-			    (set! 
-			     sumlist (cons comm-list 
-					   (alist-delete 
-					    (car comm-list) sumlist)))))
-		      ;; And add the balances to the comm-list entry.
-		      ((caadr pair) 'add (cadr foreignlist))
-		      ((cdadr pair) 'add (caddr foreignlist)))))))
-	 (gnc:get-all-commodity-splits curr-accounts end-date)))
-  
-    (gnc:resolve-unknown-comm sumlist report-commodity)))
+  (gnc:resolve-unknown-comm
+   (gnc:exchange-totals->sumlist
+    (gnc-exchange-totals-to-scm report-commodity end-date #f))
+   report-commodity))
 
 ;; Calculate the volume-weighted average cost of all commodities,
 ;; priced in the 'report-commodity'. Uses all transactions up until
-;; the 'end-date'. Returns an alist, see sumlist.
+;; the 'end-date'. Returns an alist, see sumlist. Splits in trading
+;; accounts are skipped as these counterbalance the actual value and
+;; share amounts back to zero.
 (define (gnc:get-exchange-cost-totals report-commodity end-date)
-  (let ((curr-accounts 
-	 ;;(filter gnc:account-has-shares? ))
-	 ;; -- use all accounts, not only share accounts, since gnucash-1.7
-	 (gnc-account-get-descendants-sorted (gnc-get-current-root-account)))
-	;; sumlist: a multilevel alist. Each element has a commodity
-	;; as key, and another alist as a value. The value-alist's
-	;; elements consist of a commodity as a key, and a pair of two
-	;; value-collectors as value, e.g. with only one (the report-)
-	;; commodity DEM in the outer alist: ( {DEM ( [USD (400 .
-	;; 1000)] [FRF (300 . 100)] ) } ) where DEM,USD,FRF are
-	;; <gnc:commodity> and the numbers are a numeric-collector
-	;; which in turn store a <gnc:numeric>. In the example, USD
-	;; 400 were bought for an amount of DEM 1000, FRF 300 were
-	;; bought for DEM 100. The reason for the outer alist is that
-	;; there might be commodity transactions which do not involve
-	;; the report-commodity, but which can still be calculated
-	;; after *all* transactions are processed.
-	(sumlist (list (list report-commodity '()))))
-
-    (if (not (null? curr-accounts))
-	;; Go through all splits and add up all value-amounts
-	;; and share-amounts
-	;; However skip splits in trading accounts as these counterbalance
-	;; the actual value and share amounts back to zero
-	(for-each 
-	 (lambda (a)
-	   (if (not (eq? (xaccAccountGetType (xaccSplitGetAccount a)) ACCT-TYPE-TRADING))
-	   (let* ((transaction-comm (xaccTransGetCurrency
-				     (xaccSplitGetParent a)))
-		  (account-comm (xaccAccountGetCommodity
-				 (xaccSplitGetAccount a)))
-		  (share-amount (xaccSplitGetAmount a))
-		  (value-amount (xaccSplitGetValue a))
-		  (tmp (assoc transaction-comm sumlist))
-		  (comm-list (if (not tmp) 
-				 (assoc account-comm sumlist)
-				 tmp)))
-	       
-	     ;; entry exists already in comm-list?
-	     (if (not comm-list)
-		 ;; no, create sub-alist from scratch
-		 (let ((pair (list transaction-comm
-				   (cons (gnc:make-numeric-collector)
-					 (gnc:make-numeric-collector)))))
-		   ((caadr pair) 'add value-amount)
-		   ((cdadr pair) 'add share-amount)
-		   (set! comm-list (list account-comm (list pair)))
-		   ;; and add the new sub-alist to sumlist.
-		   (set! sumlist (cons comm-list sumlist)))
-		 ;; yes, check for second commodity.
-		 (let* 
-		     ;; Put the amounts in the right place.
-		     ((foreignlist 
-		       (if (gnc-commodity-equiv transaction-comm
-						 (car comm-list))
-			   (list account-comm 
-				 share-amount value-amount)
-			   (list transaction-comm 
-				 (gnc-numeric-neg value-amount)
-                                 (gnc-numeric-neg share-amount))))
-		      ;; second commodity already existing in comm-list?
-		      (pair (assoc (car foreignlist) (cadr comm-list))))
-		   ;; if not, create a new entry in comm-list.
-		   (if (not pair)
-		       (begin
-			 (set! 
-			  pair (list (car foreignlist)
-				     (cons (gnc:make-numeric-collector) 
-					   (gnc:make-numeric-collector))))
-			 (set! 
-			  comm-list (list (car comm-list) 
-					  (cons pair (cadr comm-list))))
-			 (set! 
-			  sumlist (cons comm-list 
-					(alist-delete 
-					 (car comm-list) sumlist)))))
-		   ;; And add the balances to the comm-list entry.
-		   ((caadr pair) 'add (cadr foreignlist))
-		   ((cdadr pair) 'add (caddr foreignlist)))))))
-	 (gnc:get-all-commodity-splits curr-accounts end-date)))
-  
-    (gnc:resolve-unknown-comm sumlist report-commodity)))
+  (gnc:resolve-unknown-comm
+   (gnc:exchange-totals->sumlist
+    (gnc-exchange-totals-to-scm report-commodity end-date #t))
+   report-commodity))
 
 ;; Anybody feel free to reimplement any of these functions, either in
 ;; scheme or in C. -- cstim
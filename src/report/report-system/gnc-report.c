@@ -39,6 +39,10 @@
 #include "gnc-guile-utils.h"
 #include "gnc-report.h"
 #include "gnc-engine.h"
+#include "gnc-ui-util.h"
+#include "Account.h"
+#include "Transaction.h"
+#include "gnc-lot.h"
 
 static QofLogModule log_module = GNC_MOD_GUI;
 
@@ -142,6 +146,231 @@ gnc_reports_get_global(void)
     return reports;
 }
 
+/* The output of reports is cached under the report's type and options,
+ * so that showing a report again, or opening another one just like it,
+ * doesn't run it again as long as the book hasn't changed since.  A
+ * report can name the accounts it depends on (see cache-accounts in
+ * report.scm); its output then also survives changes to other
+ * accounts.  Output is never reused on another day, since reports
+ * often depend on today's date. */
+#define REPORT_CACHE_MAX 32
+
+typedef struct
+{
+    gchar      *html;
+    QofBook    *book;
+    guint64     generation;  /* of the book when the report was run */
+    time64      day;
+    GHashTable *accounts;    /* GncGUID set, or NULL for the whole book */
+    gboolean    stale;       /* one of the accounts has changed */
+    guint64     last_used;
+} ReportCacheEntry;
+
+static GHashTable *report_cache = NULL;
+static guint64 report_cache_clock = 0;
+static gint report_cache_handler_id = 0;
+
+static void
+report_cache_entry_free (gpointer data)
+{
+    ReportCacheEntry *entry = data;
+
+    g_free (entry->html);
+    if (entry->accounts)
+        g_hash_table_destroy (entry->accounts);
+    g_free (entry);
+}
+
+static void
+report_cache_mark_account (gpointer key, gpointer value, gpointer user_data)
+{
+    ReportCacheEntry *entry = value;
+
+    if (!entry->accounts || !user_data ||
+        g_hash_table_lookup_extended (entry->accounts,
+                                      qof_instance_get_guid (user_data),
+                                      NULL, NULL))
+        entry->stale = TRUE;
+}
+
+static void
+report_cache_event_handler (QofInstance *entity, QofEventId event_type,
+                            gpointer handler_data, gpointer event_data)
+{
+    GList *node;
+
+    if (g_hash_table_size (report_cache) == 0 || event_type == QOF_EVENT_CREATE)
+        return;
+
+    if (QOF_IS_BOOK (entity) && event_type == QOF_EVENT_DESTROY)
+    {
+        g_hash_table_remove_all (report_cache);
+        return;
+    }
+
+    if (GNC_IS_ACCOUNT (entity))
+        g_hash_table_foreach (report_cache, report_cache_mark_account, entity);
+    else if (GNC_IS_SPLIT (entity))
+        g_hash_table_foreach (report_cache, report_cache_mark_account,
+                              xaccSplitGetAccount (GNC_SPLIT (entity)));
+    else if (GNC_IS_TRANSACTION (entity))
+    {
+        for (node = xaccTransGetSplitList (GNC_TRANSACTION (entity));
+             node; node = node->next)
+            g_hash_table_foreach (report_cache, report_cache_mark_account,
+                                  xaccSplitGetAccount (node->data));
+    }
+    else if (GNC_IS_LOT (entity))
+        g_hash_table_foreach (report_cache, report_cache_mark_account,
+                              gnc_lot_get_account (GNC_LOT (entity)));
+    else
+        /* Prices, commodities and the rest may affect any report. */
+        g_hash_table_foreach (report_cache, report_cache_mark_account, NULL);
+}
+
+static gchar *
+report_cache_key (SCM report)
+{
+    SCM get_key = scm_c_eval_string ("gnc:report-cache-key");
+
+    if (report == SCM_BOOL_F)
+        return NULL;
+    return gnc_scm_call_1_to_string (get_key, report);
+}
+
+static GHashTable *
+report_cache_accounts (SCM report)
+{
+    SCM get_accounts = scm_c_eval_string ("gnc:report-cache-accounts");
+    SCM guids = scm_call_1 (get_accounts, report);
+    GHashTable *accounts;
+
+    if (!scm_is_true (scm_list_p (guids)))
+        return NULL;
+
+    accounts = g_hash_table_new_full (guid_hash_to_guint, guid_g_hash_table_equal,
+                                      guid_free, NULL);
+    for (; !scm_is_null (guids); guids = SCM_CDR (guids))
+    {
+        gchar *str = gnc_scm_to_utf8_string (SCM_CAR (guids));
+        GncGUID *guid = guid_malloc ();
+
+        if (string_to_guid (str, guid))
+            g_hash_table_insert (accounts, guid, NULL);
+        else
+            guid_free (guid);
+        g_free (str);
+    }
+    return accounts;
+}
+
+static gboolean
+report_cache_lookup (const gchar *key, QofBook *book, gchar **html)
+{
+    ReportCacheEntry *entry;
+
+    if (!report_cache)
+        return FALSE;
+
+    entry = g_hash_table_lookup (report_cache, key);
+    if (!entry)
+        return FALSE;
+
+    if (entry->book != book || entry->day != gnc_time64_get_today_start () ||
+        (entry->generation != qof_book_get_generation (book) &&
+         (!entry->accounts || entry->stale)))
+    {
+        g_hash_table_remove (report_cache, key);
+        return FALSE;
+    }
+
+    entry->last_used = ++report_cache_clock;
+    *html = g_strdup (entry->html);
+    return TRUE;
+}
+
+static void
+report_cache_evict_oldest (void)
+{
+    GHashTableIter iter;
+    gpointer key, value, oldest = NULL;
+    guint64 oldest_used = G_MAXUINT64;
+
+    g_hash_table_iter_init (&iter, report_cache);
+    while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+        ReportCacheEntry *entry = value;
+        if (entry->last_used < oldest_used)
+        {
+            oldest_used = entry->last_used;
+            oldest = key;
+        }
+    }
+    if (oldest)
+        g_hash_table_remove (report_cache, oldest);
+}
+
+/* Takes over key. */
+static void
+report_cache_store (gchar *key, SCM report, QofBook *book,
+                    guint64 generation, const gchar *html)
+{
+    ReportCacheEntry *entry;
+
+    if (!report_cache)
+    {
+        report_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                              report_cache_entry_free);
+        report_cache_handler_id =
+            qof_event_register_handler (report_cache_event_handler, NULL);
+    }
+
+    if (g_hash_table_size (report_cache) >= REPORT_CACHE_MAX)
+        report_cache_evict_oldest ();
+
+    entry = g_new0 (ReportCacheEntry, 1);
+    entry->html = g_strdup (html);
+    entry->book = book;
+    entry->generation = generation;
+    entry->day = gnc_time64_get_today_start ();
+    entry->accounts = report_cache_accounts (report);
+    entry->last_used = ++report_cache_clock;
+    g_hash_table_replace (report_cache, key, entry);
+}
+
+void
+gnc_report_cache_forget (SCM report)
+{
+    gchar *key;
+
+    if (!report_cache)
+        return;
+
+    key = report_cache_key (report);
+    if (key)
+        g_hash_table_remove (report_cache, key);
+    g_free (key);
+}
+
+void
+gnc_report_cache_flush (void)
+{
+    if (report_cache)
+        g_hash_table_remove_all (report_cache);
+}
+
+void
+gnc_report_book_read_lock (void)
+{
+    qof_book_read_lock (gnc_get_current_book ());
+}
+
+void
+gnc_report_book_read_unlock (void)
+{
+    qof_book_read_unlock (gnc_get_current_book ());
+}
+
 static void
 error_handler(const char *str)
 {
@@ -151,22 +380,48 @@ error_handler(const char *str)
 gboolean
 gnc_run_report (gint report_id, char ** data)
 {
-    gchar *free_data;
     SCM scm_text;
+    SCM report;
+    QofBook *book;
+    guint64 generation;
+    gchar *key;
     gchar *str;
+    gint64 trace;
 
     g_return_val_if_fail (data != NULL, FALSE);
     *data = NULL;
 
+    report = gnc_report_find (report_id);
+    book = gnc_get_current_book ();
+    key = report_cache_key (report);
+    if (key && report_cache_lookup (key, book, data))
+    {
+        DEBUG ("report %d from cache", report_id);
+        g_free (key);
+        return TRUE;
+    }
+    generation = qof_book_get_generation (book);
+
+    trace = qof_log_trace_begin ();
     str = g_strdup_printf("(gnc:report-run %d)", report_id);
     scm_text = gfec_eval_string(str, error_handler);
     g_free(str);
+    QOF_TRACE_END ("report", "render", trace);
 
     if (scm_text == SCM_UNDEFINED || !scm_is_string (scm_text))
+    {
+        g_free (key);
         return FALSE;
+    }
 
     *data = gnc_scm_to_utf8_string (scm_text);
 
+    /* Don't cache output that may have seen the book change under it. */
+    if (key && generation == qof_book_get_generation (book))
+        report_cache_store (key, report, book, generation, *data);
+    else
+        g_free (key);
+
     return TRUE;
 }
 
@@ -202,11 +457,16 @@ gnc_report_name( SCM report )
 gchar*
 gnc_get_default_report_font_family(void)
 {
+    static gchar*   last_font_family = NULL;
     GList*          top_list;
     GtkWidget*      top_widget;
     GtkStyle*       top_widget_style;
     const gchar*    default_font_family;
 
+    /* Reports computed in other threads must stay away from gtk. */
+    if (!g_main_context_is_owner (NULL))
+        return g_strdup (last_font_family ? last_font_family : "Arial");
+
     top_list = gtk_window_list_toplevels();
     g_return_val_if_fail (top_list != NULL, NULL);
     top_widget = GTK_WIDGET(top_list->data);
@@ -217,8 +477,10 @@ gnc_get_default_report_font_family(void)
 
     if (default_font_family == NULL)
         return g_strdup("Arial");
-    else
-        return g_strdup(default_font_family);
+
+    g_free (last_font_family);
+    last_font_family = g_strdup (default_font_family);
+    return g_strdup(default_font_family);
 }
 
 static gboolean
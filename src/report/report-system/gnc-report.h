@@ -31,9 +31,22 @@
 #define SAVED_REPORTS_FILE "saved-reports-2.4"
 #define SAVED_REPORTS_FILE_OLD_REV "saved-reports-2.0"
 
+/** Renders the report with the given id into a newly allocated HTML
+ *  string.  The output is cached, see gnc_report_cache_forget(). */
 gboolean gnc_run_report (gint report_id, char ** data);
 gboolean gnc_run_report_id_string (const char * id_string, char **data);
 
+/** Makes the next gnc_run_report() of this report run it again rather
+ *  than reuse its cached output. */
+void gnc_report_cache_forget (SCM report);
+/** Drops all cached report output. */
+void gnc_report_cache_flush (void);
+
+/** Reports computed away from the GUI thread hold a read lock on the
+ *  current book, see qof_book_read_lock(). */
+void gnc_report_book_read_lock (void);
+void gnc_report_book_read_unlock (void);
+
 /**
  * @param report The SCM version of the report.
  * @return a caller-owned copy of the name of the report, or NULL if report
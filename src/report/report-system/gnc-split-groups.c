@@ -0,0 +1,384 @@
+/********************************************************************
+ * gnc-split-groups.c -- grouping and subtotalling of report rows   *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ ********************************************************************/
+
+#include "config.h"
+
+#include <glib.h>
+#include <libguile.h>
+
+#include "gnc-split-groups.h"
+#include "swig-runtime.h"
+#include "engine-helpers-guile.h"
+
+#include "Account.h"
+#include "Transaction.h"
+#include "gnc-euro.h"
+#include "gnc-pricedb.h"
+#include "gnc-ui-util.h"
+
+static QofLogModule log_module = GNC_MOD_GUI;
+
+/* The amount shown for split, as add-split-row in transaction.scm
+ * works it out. */
+static gnc_monetary
+split_row_value (Split *split, guint32 reverse_types,
+                 gnc_commodity *report_currency)
+{
+    Transaction *trans = xaccSplitGetParent (split);
+    Account *account = xaccSplitGetAccount (split);
+    gnc_commodity *currency = account ? xaccAccountGetCommodity (account)
+                              : gnc_default_currency ();
+    gnc_numeric amount = xaccTransGetVoidStatus (trans)
+                         ? xaccSplitVoidFormerAmount (split)
+                         : xaccSplitGetAmount (split);
+
+    if (!report_currency)
+        report_currency = currency;
+    if (account && (reverse_types & (1 << xaccAccountGetType (account))))
+        amount = gnc_numeric_neg (amount);
+
+    /* The exchange of gnc:exchange-by-pricedb-nearest. */
+    if (gnc_is_euro_currency (report_currency) &&
+            gnc_is_euro_currency (currency))
+        amount = gnc_convert_from_euro (report_currency,
+                                        gnc_convert_to_euro (currency, amount));
+    else if (!gnc_commodity_equiv (currency, report_currency))
+        /* Midday matches a price on the same day. */
+        amount = gnc_pricedb_convert_balance_nearest_price
+                 (gnc_pricedb_get_db (qof_instance_get_book (split)),
+                  amount, currency, report_currency,
+                  timespecCanonicalDayTime (xaccTransRetDatePostedTS (trans)));
+
+    return gnc_monetary_create (report_currency, amount);
+}
+
+static gboolean
+is_filter_member (Split *split, GHashTable *accounts)
+{
+    Transaction *trans = xaccSplitGetParent (split);
+    gint count = xaccTransCountSplits (trans);
+    GList *node;
+
+    if (count == 2)
+    {
+        Split *other = xaccSplitGetOtherSplit (split);
+        return other && g_hash_table_lookup (accounts,
+                                             xaccSplitGetAccount (other));
+    }
+    if (count < 2)
+        return FALSE;
+
+    for (node = xaccTransGetSplitList (trans); node; node = node->next)
+        if (node->data != split &&
+                g_hash_table_lookup (accounts, xaccSplitGetAccount (node->data)))
+            return TRUE;
+    return FALSE;
+}
+
+/* The week as gnc:date-to-week counts them. */
+static gint64
+week_of (time64 t)
+{
+    return (gnc_time64_get_day_start (t) / 86400 - 3) / 7;
+}
+
+static gboolean
+same_group (Split *a, Split *b, GncSplitGroupBy by)
+{
+    time64 ta, tb;
+    struct tm tm_a, tm_b;
+
+    switch (by)
+    {
+    case GNC_SPLIT_GROUP_NONE:
+        return TRUE;
+    case GNC_SPLIT_GROUP_ACCOUNT_NAME:
+        return xaccSplitCompareAccountFullNames (a, b) == 0;
+    case GNC_SPLIT_GROUP_ACCOUNT_CODE:
+        return xaccSplitCompareAccountCodes (a, b) == 0;
+    case GNC_SPLIT_GROUP_CORR_ACCOUNT_NAME:
+        return xaccSplitCompareOtherAccountFullNames (a, b) == 0;
+    case GNC_SPLIT_GROUP_CORR_ACCOUNT_CODE:
+        return xaccSplitCompareOtherAccountCodes (a, b) == 0;
+    default:
+        break;
+    }
+
+    ta = xaccTransGetDate (xaccSplitGetParent (a));
+    tb = xaccTransGetDate (xaccSplitGetParent (b));
+    gnc_localtime_r (&ta, &tm_a);
+    gnc_localtime_r (&tb, &tm_b);
+    if (tm_a.tm_year != tm_b.tm_year)
+        return FALSE;
+
+    switch (by)
+    {
+    case GNC_SPLIT_GROUP_WEEK:
+        return week_of (ta) == week_of (tb);
+    case GNC_SPLIT_GROUP_MONTH:
+        return tm_a.tm_mon == tm_b.tm_mon;
+    case GNC_SPLIT_GROUP_QUARTER:
+        return tm_a.tm_mon / 3 == tm_b.tm_mon / 3;
+    default:
+        return TRUE;
+    }
+}
+
+GncSplitGroups *
+gnc_split_groups_new (QofQuery *query, GncSplitGroupBy primary,
+                      GncSplitGroupBy secondary, GList *filter_accounts,
+                      GncSplitFilter filter, guint32 reverse_types,
+                      gnc_commodity *report_currency)
+{
+    GncSplitGroups *groups;
+    GHashTable *account_set = NULL;
+    gnc_commodity_accumulator *primary_acc, *secondary_acc;
+    GPtrArray *splits;
+    GList *node;
+    guint i;
+
+    g_return_val_if_fail (query != NULL, NULL);
+
+    ENTER ("query %p, grouped by %d and %d", query, primary, secondary);
+    if (filter != GNC_SPLIT_FILTER_NONE)
+    {
+        account_set = g_hash_table_new (g_direct_hash, g_direct_equal);
+        for (node = filter_accounts; node; node = node->next)
+            if (node->data)
+                g_hash_table_insert (account_set, node->data, node->data);
+    }
+
+    splits = g_ptr_array_new ();
+    for (node = qof_query_run (query); node; node = node->next)
+    {
+        if (account_set &&
+                is_filter_member (node->data, account_set) !=
+                (filter == GNC_SPLIT_FILTER_INCLUDE))
+            continue;
+        g_ptr_array_add (splits, node->data);
+    }
+    if (account_set)
+        g_hash_table_destroy (account_set);
+
+    groups = g_new0 (GncSplitGroups, 1);
+    groups->rows = g_ptr_array_sized_new (splits->len);
+    groups->total = gnc_commodity_accumulator_new ();
+    primary_acc = gnc_commodity_accumulator_new ();
+    secondary_acc = gnc_commodity_accumulator_new ();
+
+    for (i = 0; i < splits->len; i++)
+    {
+        Split *split = g_ptr_array_index (splits, i);
+        Split *next = i + 1 < splits->len ? g_ptr_array_index (splits, i + 1)
+                      : NULL;
+        GncSplitRow *row = g_new0 (GncSplitRow, 1);
+        GncSplitRow *prev = i > 0 ? g_ptr_array_index (groups->rows, i - 1)
+                            : NULL;
+        gboolean primary_ends, secondary_ends;
+
+        row->split = split;
+        row->value = split_row_value (split, reverse_types, report_currency);
+        gnc_commodity_accumulator_add (primary_acc, row->value.commodity,
+                                       row->value.value);
+        gnc_commodity_accumulator_add (secondary_acc, row->value.commodity,
+                                       row->value.value);
+        gnc_commodity_accumulator_add (groups->total, row->value.commodity,
+                                       row->value.value);
+
+        row->primary_start = primary != GNC_SPLIT_GROUP_NONE &&
+                             (!prev || prev->primary_total);
+        row->secondary_start = secondary != GNC_SPLIT_GROUP_NONE &&
+                               (!prev || prev->secondary_total);
+
+        /* A secondary group ends with the primary one around it. */
+        primary_ends = primary != GNC_SPLIT_GROUP_NONE &&
+                       (!next || !same_group (split, next, primary));
+        secondary_ends = secondary != GNC_SPLIT_GROUP_NONE &&
+                         (primary_ends || !next ||
+                          !same_group (split, next, secondary));
+        if (secondary_ends)
+        {
+            row->secondary_total = secondary_acc;
+            secondary_acc = gnc_commodity_accumulator_new ();
+        }
+        if (primary_ends)
+        {
+            row->primary_total = primary_acc;
+            primary_acc = gnc_commodity_accumulator_new ();
+        }
+        g_ptr_array_add (groups->rows, row);
+    }
+
+    gnc_commodity_accumulator_free (primary_acc);
+    gnc_commodity_accumulator_free (secondary_acc);
+    g_ptr_array_free (splits, TRUE);
+    LEAVE ("%u rows", groups->rows->len);
+    return groups;
+}
+
+void
+gnc_split_groups_free (GncSplitGroups *groups)
+{
+    guint i;
+
+    if (!groups)
+        return;
+
+    for (i = 0; i < groups->rows->len; i++)
+    {
+        GncSplitRow *row = g_ptr_array_index (groups->rows, i);
+        if (row->primary_total)
+            gnc_commodity_accumulator_free (row->primary_total);
+        if (row->secondary_total)
+            gnc_commodity_accumulator_free (row->secondary_total);
+        g_free (row);
+    }
+    g_ptr_array_free (groups->rows, TRUE);
+    gnc_commodity_accumulator_free (groups->total);
+    g_free (groups);
+}
+
+/********************************************************************
+ * The Scheme side
+ ********************************************************************/
+
+static GncSplitGroupBy
+scm_to_group_by (SCM symbol)
+{
+    static const struct
+    {
+        const char *name;
+        GncSplitGroupBy by;
+    } names[] =
+    {
+        { "account-name", GNC_SPLIT_GROUP_ACCOUNT_NAME },
+        { "account-code", GNC_SPLIT_GROUP_ACCOUNT_CODE },
+        { "corresponding-acc-name", GNC_SPLIT_GROUP_CORR_ACCOUNT_NAME },
+        { "corresponding-acc-code", GNC_SPLIT_GROUP_CORR_ACCOUNT_CODE },
+        { "weekly", GNC_SPLIT_GROUP_WEEK },
+        { "monthly", GNC_SPLIT_GROUP_MONTH },
+        { "quarterly", GNC_SPLIT_GROUP_QUARTER },
+        { "yearly", GNC_SPLIT_GROUP_YEAR },
+    };
+    guint i;
+
+    if (!scm_is_symbol (symbol))
+        return GNC_SPLIT_GROUP_NONE;
+    for (i = 0; i < G_N_ELEMENTS (names); i++)
+        if (scm_is_eq (symbol, scm_from_locale_symbol (names[i].name)))
+            return names[i].by;
+    return GNC_SPLIT_GROUP_NONE;
+}
+
+static SCM
+monetary_to_scm (gnc_commodity *commodity, gnc_numeric amount)
+{
+    static swig_type_info *commodity_type = NULL;
+
+    if (!commodity_type)
+        commodity_type = SWIG_TypeQuery ("_p_gnc_commodity");
+    return scm_cons (SWIG_NewPointerObj (commodity, commodity_type, 0),
+                     gnc_numeric_to_scm (amount));
+}
+
+static SCM
+accumulator_to_scm (const gnc_commodity_accumulator *acc)
+{
+    SCM result = SCM_EOL;
+    guint n;
+
+    if (!acc)
+        return SCM_BOOL_F;
+    for (n = gnc_commodity_accumulator_count (acc); n > 0; n--)
+        result = scm_cons (monetary_to_scm
+                           (gnc_commodity_accumulator_nth_commodity (acc, n - 1),
+                            gnc_commodity_accumulator_nth_amount (acc, n - 1)),
+                           result);
+    return result;
+}
+
+SCM
+gnc_split_groups_scm (SCM query_scm, SCM primary, SCM secondary,
+                      SCM filter_accounts, SCM filter_scm,
+                      SCM reverse_types_scm, SCM report_currency_scm)
+{
+    static swig_type_info *split_type = NULL;
+    GncSplitFilter filter = GNC_SPLIT_FILTER_NONE;
+    gnc_commodity *report_currency = NULL;
+    GList *accounts = NULL;
+    guint32 reverse_types = 0;
+    GncSplitGroups *groups;
+    QofQuery *query;
+    SCM rows = SCM_EOL, result;
+    guint i;
+
+    if (!split_type)
+        split_type = SWIG_TypeQuery ("_p_Split");
+
+    query = SWIG_MustGetPtr (query_scm, SWIG_TypeQuery ("_p__QofQuery"), 1, 0);
+
+    if (scm_is_eq (filter_scm, scm_from_locale_symbol ("include")))
+        filter = GNC_SPLIT_FILTER_INCLUDE;
+    else if (scm_is_eq (filter_scm, scm_from_locale_symbol ("exclude")))
+        filter = GNC_SPLIT_FILTER_EXCLUDE;
+    for (; scm_is_pair (filter_accounts);
+            filter_accounts = SCM_CDR (filter_accounts))
+        if (scm_is_true (SCM_CAR (filter_accounts)))
+            accounts = g_list_prepend (accounts,
+                                       SWIG_MustGetPtr (SCM_CAR (filter_accounts),
+                                                        SWIG_TypeQuery ("_p_Account"),
+                                                        2, 0));
+
+    for (; scm_is_pair (reverse_types_scm);
+            reverse_types_scm = SCM_CDR (reverse_types_scm))
+        reverse_types |= 1 << scm_to_int (SCM_CAR (reverse_types_scm));
+
+    if (scm_is_true (report_currency_scm))
+        report_currency = SWIG_MustGetPtr (report_currency_scm,
+                                           SWIG_TypeQuery ("_p_gnc_commodity"),
+                                           7, 0);
+
+    groups = gnc_split_groups_new (query, scm_to_group_by (primary),
+                                   scm_to_group_by (secondary), accounts,
+                                   filter, reverse_types, report_currency);
+    g_list_free (accounts);
+    if (!groups)
+        return SCM_BOOL_F;
+
+    for (i = groups->rows->len; i > 0; i--)
+    {
+        GncSplitRow *row = g_ptr_array_index (groups->rows, i - 1);
+        SCM vec = scm_c_make_vector (6, SCM_BOOL_F);
+
+        scm_c_vector_set_x (vec, 0, SWIG_NewPointerObj (row->split,
+                                                        split_type, 0));
+        scm_c_vector_set_x (vec, 1, monetary_to_scm (row->value.commodity,
+                                                     row->value.value));
+        scm_c_vector_set_x (vec, 2, scm_from_bool (row->primary_start));
+        scm_c_vector_set_x (vec, 3, scm_from_bool (row->secondary_start));
+        scm_c_vector_set_x (vec, 4, accumulator_to_scm (row->primary_total));
+        scm_c_vector_set_x (vec, 5, accumulator_to_scm (row->secondary_total));
+        rows = scm_cons (vec, rows);
+    }
+    result = scm_cons (rows, accumulator_to_scm (groups->total));
+    gnc_split_groups_free (groups);
+    return result;
+}
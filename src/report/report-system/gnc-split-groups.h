@@ -0,0 +1,106 @@
+/********************************************************************
+ * gnc-split-groups.h -- grouping and subtotalling of report rows   *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ ********************************************************************/
+
+#ifndef GNC_SPLIT_GROUPS_H
+#define GNC_SPLIT_GROUPS_H
+
+#include <glib.h>
+#include <libguile.h>
+
+#include "qof.h"
+#include "gnc-commodity.h"
+#include "Split.h"
+
+/** What the rows of a transaction report are grouped and subtotalled
+ *  by; the primary and secondary sort keys of the report. */
+typedef enum
+{
+    GNC_SPLIT_GROUP_NONE,
+    GNC_SPLIT_GROUP_ACCOUNT_NAME,
+    GNC_SPLIT_GROUP_ACCOUNT_CODE,
+    GNC_SPLIT_GROUP_CORR_ACCOUNT_NAME,
+    GNC_SPLIT_GROUP_CORR_ACCOUNT_CODE,
+    GNC_SPLIT_GROUP_WEEK,
+    GNC_SPLIT_GROUP_MONTH,
+    GNC_SPLIT_GROUP_QUARTER,
+    GNC_SPLIT_GROUP_YEAR
+} GncSplitGroupBy;
+
+/** Which splits the filter accounts keep: those with another split in
+ *  one of them, or those without. */
+typedef enum
+{
+    GNC_SPLIT_FILTER_NONE,
+    GNC_SPLIT_FILTER_INCLUDE,
+    GNC_SPLIT_FILTER_EXCLUDE
+} GncSplitFilter;
+
+typedef struct
+{
+    Split *split;
+    /** The split's amount, its sign reversed for the reversed account
+     *  types and exchanged into the report currency. */
+    gnc_monetary value;
+    /** TRUE on the first row of a group, which gets a subheading. */
+    gboolean primary_start;
+    gboolean secondary_start;
+    /** On the last row of a group, the group's totals, which are
+     *  shown after it; otherwise NULL. */
+    gnc_commodity_accumulator *primary_total;
+    gnc_commodity_accumulator *secondary_total;
+} GncSplitRow;
+
+typedef struct
+{
+    GPtrArray *rows;            /**< GncSplitRow, in the query's order */
+    gnc_commodity_accumulator *total;
+} GncSplitGroups;
+
+/** Runs query for the rows of a transaction report and works out their
+ *  values, groups and subtotals.
+ *
+ *  @param reverse_types A bit (1 << type) for every GNCAccountType
+ *  whose amounts are shown with their sign reversed.
+ *
+ *  @param report_currency The currency to show all amounts in, using
+ *  the price nearest to each transaction, or NULL to show them in
+ *  their accounts' commodities. */
+GncSplitGroups *gnc_split_groups_new (QofQuery *query,
+                                      GncSplitGroupBy primary,
+                                      GncSplitGroupBy secondary,
+                                      GList *filter_accounts,
+                                      GncSplitFilter filter,
+                                      guint32 reverse_types,
+                                      gnc_commodity *report_currency);
+void gnc_split_groups_free (GncSplitGroups *groups);
+
+/** gnc_split_groups_new() for transaction.scm.  The groupings are the
+ *  symbols of the report's sorting options, or 'none, and the filter
+ *  'include, 'exclude or anything else.  Returns (rows . total), where
+ *  every row is a vector #(split value primary-start? secondary-start?
+ *  primary-total secondary-total), the value is (commodity . amount)
+ *  and the totals are #f or a list of (commodity . amount) in the
+ *  order the commodities were first added. */
+SCM gnc_split_groups_scm (SCM query, SCM primary, SCM secondary,
+                          SCM filter_accounts, SCM filter,
+                          SCM reverse_types, SCM report_currency);
+
+#endif
@@ -125,20 +125,44 @@
     (do-list tree)
     retval))
 
-;; first optional argument is "headers?"
-;; returns the html document as a string, I think.
+;; writes a tree as built by the renderers (every list in it holds
+;; its pieces last first) to port, in the order
+;; gnc:html-document-tree-collapse would put it.
+(define (gnc:html-document-tree-write tree port)
+  (for-each
+   (lambda (elt)
+     (if (list? elt)
+         (gnc:html-document-tree-write elt port)
+         (display elt port)))
+   (reverse tree)))
+
+;; The port an object rendered straight into a document may write its
+;; output to as it goes, rather than returning it; see
+;; gnc:html-table-render.  Objects nested in other objects must not
+;; see it, or their output would come out ahead of their parent's.
+(define gnc:*html-stream-port* (make-fluid))
+(fluid-set! gnc:*html-stream-port* #f)
+
+;; first optional argument is "headers?", the second an output port.
+;; returns the html document as a string, I think.  Given a port, the
+;; document is written there a top-level object at a time instead, so
+;; that large documents needn't be held in memory as a whole, and ""
+;; is returned.
 (define (gnc:html-document-render doc . rest) 
   (let ((stylesheet (gnc:html-document-style-sheet doc))
         (headers? (if (null? rest) #f (if (car rest) #t #f)))
+        (port (if (or (null? rest) (null? (cdr rest))) #f (cadr rest)))
 		(style-text (gnc:html-document-style-text doc))
 	   )
     (if stylesheet 
         ;; if there's a style sheet, let it do the rendering 
-        (gnc:html-style-sheet-render stylesheet doc headers?)
+        (gnc:html-style-sheet-render stylesheet doc headers? port)
         
         ;; otherwise, do the trivial render. 
         (let* ((retval '())
-               (push (lambda (l) (set! retval (cons l retval))))
+               (push (if port
+                         (lambda (l) (gnc:html-document-tree-write (list l) port))
+                         (lambda (l) (set! retval (cons l retval)))))
 	       (objs (gnc:html-document-objects doc))
 	       (work-to-do (length objs))
            (css? (gnc-html-engine-supports-css))
@@ -178,7 +202,10 @@
           (for-each 
            (lambda (child) 
 	     (begin
-	       (push (gnc:html-object-render child doc))
+	       (if port
+	           (with-fluids ((gnc:*html-stream-port* port))
+	             (push (gnc:html-object-render child doc)))
+	           (push (gnc:html-object-render child doc)))
 	       (set! work-done (+ 1 work-done))
 	       (gnc:report-percent-done (* 100 (/ work-done work-to-do)))))
            objs)
@@ -192,7 +219,9 @@
           (gnc:html-document-pop-style doc)
           (gnc:html-style-table-uncompile (gnc:html-document-style doc))
 
-          (string-concatenate (gnc:html-document-tree-collapse retval))))))
+          (if port
+              ""
+              (string-concatenate (gnc:html-document-tree-collapse retval)))))))
 
 
 (define (gnc:html-document-push-style doc style)
@@ -234,7 +234,8 @@
   (let ((newdoc ((gnc:html-style-sheet-renderer sheet) 
                  (gnc:html-style-sheet-options sheet)
                  doc))
-        (headers? (if (null? rest) #f (if (car rest) #t #f))))
+        (headers? (if (null? rest) #f (if (car rest) #t #f)))
+        (port (if (or (null? rest) (null? (cdr rest))) #f (cadr rest))))
 
     ;; Copy values over to stylesheet-produced document.  note that this is a
     ;; bug that should probably better be fixed by having the stylesheets
@@ -263,7 +264,7 @@
     ;; render the ssdocument (using the trivial stylesheet).  since
     ;; the objects from 'doc' are now in newdoc, this renders the whole
     ;; package.
-    (gnc:html-document-render newdoc headers?)))
+    (gnc:html-document-render newdoc headers? port)))
 
 (define (gnc:get-html-style-sheets)
   (let* ((ss '()))
@@ -627,9 +627,25 @@
      t1 (+ (gnc:html-table-num-rows t1)
            (gnc:html-table-num-rows t2)))))
 
+;; A table rendered straight into a document that streams to a port
+;; (see gnc:html-document-render) writes itself there row by row and
+;; returns nothing; the objects in its cells are rendered as usual.
 (define (gnc:html-table-render table doc)
-  (let* ((retval '())
-         (push (lambda (l) (set! retval (cons l retval)))))
+  (let ((port (fluid-ref gnc:*html-stream-port*)))
+    (if port
+        (with-fluids ((gnc:*html-stream-port* #f))
+          (gnc:html-table-render-internal
+           table doc
+           (lambda (l) (gnc:html-document-tree-write (list l) port)))
+          '())
+        (let ((retval '()))
+          (gnc:html-table-render-internal
+           table doc
+           (lambda (l) (set! retval (cons l retval))))
+          retval))))
+
+(define (gnc:html-table-render-internal table doc push)
+  (begin
     
     ;; compile the table style to make other compiles faster 
     (gnc:html-style-table-compile 
@@ -752,5 +768,4 @@
     
     ;; write the table end tag and pop the table style
     (push (gnc:html-document-markup-end doc "table"))
-    (gnc:html-document-pop-style doc)
-    retval))
+    (gnc:html-document-pop-style doc)))
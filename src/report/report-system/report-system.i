@@ -23,6 +23,7 @@
 /* Includes the header in the wrapper code */
 #include <config.h>
 #include <gnc-report.h>
+#include <gnc-split-groups.h>
 %}
 #if defined(SWIGGUILE)
 %{
@@ -40,5 +41,12 @@ gint gnc_report_add(SCM report);
 %newobject gnc_get_default_report_font_family;
 gchar* gnc_get_default_report_font_family();
 
+void gnc_report_book_read_lock (void);
+void gnc_report_book_read_unlock (void);
+
+SCM gnc_split_groups_scm (SCM query, SCM primary, SCM secondary,
+                          SCM filter_accounts, SCM filter,
+                          SCM reverse_types, SCM report_currency);
+
 void gnc_saved_reports_backup (void);
 gboolean gnc_saved_reports_write_to_file (const gchar* report_def, gboolean overwrite);
\ No newline at end of file
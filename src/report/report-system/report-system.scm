@@ -138,6 +138,9 @@
 (export gnc:define-report)
 (export <report>)
 (export gnc:report-template-new-options/report-guid)
+(export gnc:report-template-load!)
+(export gnc:define-lazy-report)
+(export gnc:report-registry-entries)
 (export gnc:report-template-menu-name/report-guid)
 (export gnc:report-template-renderer/report-guid)
 (export gnc:report-template-new-options)
@@ -155,6 +158,7 @@
 (export gnc:report-template-menu-tip)
 (export gnc:report-template-export-types)
 (export gnc:report-template-export-thunk)
+(export gnc:report-template-cache-accounts)
 (export gnc:report-template-has-unique-name?)
 (export gnc:report-type)
 (export gnc:report-set-type!)
@@ -176,6 +180,9 @@
 (export gnc:make-report-options)
 (export gnc:report-export-types)
 (export gnc:report-export-thunk)
+(export gnc:report-cache-key)
+(export gnc:report-cache-accounts)
+(export gnc:report-selected-accounts)
 (export gnc:report-menu-name)
 (export gnc:report-name)
 (export gnc:report-stylesheet)
@@ -189,6 +196,12 @@
 (export gnc:report-to-template-new)
 (export gnc:report-to-template-update)
 (export gnc:report-render-html)
+(export gnc:report-render-html-to-port)
+(export gnc:report-export-html-file)
+(export gnc:report-compute)
+(export gnc:report-finish-html)
+(export gnc:*report-threads*)
+(export gnc:report-render-html-list)
 (export gnc:report-run)
 (export gnc:report-templates-for-each)
 (export gnc:report-embedded-list)
@@ -278,6 +291,8 @@
 (export gnc:html-document-set-style!)
 (export gnc:html-document-tree-collapse)
 (export gnc:html-document-render)
+(export gnc:html-document-tree-write)
+(export gnc:*html-stream-port*)
 (export gnc:html-document-push-style)
 (export gnc:html-document-pop-style)
 (export gnc:html-document-add-object!)
@@ -678,6 +693,9 @@
 (export gnc-commodity-collector-commodity-count)
 (export gnc:account-get-balance-at-date)
 (export gnc:account-get-comm-balance-at-date)
+(export gnc:account-get-comm-balances-at-dates)
+(export gnc:make-account-balances)
+(export gnc:account-balances-get-comm-balance)
 (export gnc:account-get-comm-value-interval)
 (export gnc:account-get-comm-value-at-date)
 (export gnc:accounts-get-balance-helper)
@@ -694,6 +712,7 @@
 (export gnc:query-set-match-non-voids-only!)
 (export gnc:query-set-match-voids-only!)
 (export gnc:split-voided?)
+(export gnc:*report-progress*)
 (export gnc:report-starting)
 (export gnc:report-render-starting)
 (export gnc:report-percent-done)
@@ -322,92 +322,83 @@
 ;;       sign will be reversed.
 ;;   (internal) 'list #f #f: get the association list of 
 ;;       commodity->numeric-collector
+;;   (internal) 'accumulator #f #f: get the gnc_commodity_accumulator
+;;       holding the totals
+;;
+;; The totals live in a gnc_commodity_accumulator (see gnc-commodity.h)
+;; rather than in Scheme, which saves a lot of time and garbage in the
+;; reports that make a collector per account and row.  The accumulators
+;; of collectors that have gone away are freed whenever a new collector
+;; is made.
+
+(define commodity-accumulator-guardian (make-guardian))
+
+(define (free-dead-commodity-accumulators)
+  (let ((accumulator (commodity-accumulator-guardian)))
+    (if accumulator
+	(begin
+	  (gnc-commodity-accumulator-free accumulator)
+	  (free-dead-commodity-accumulators)))))
 
 (define (gnc:make-commodity-collector)
-  (let 
-      ;; the association list of (commodity -> value-collector) pairs.
-      ((commoditylist '()))
-    
-    ;; helper function to add a commodity->value pair to our list. 
-    ;; If no pair with this commodity exists, we will create one.
+  (let
+      ((accumulator (gnc-commodity-accumulator-new)))
+
+    ;; helper function to add a commodity->value pair.
     (define (add-commodity-value commodity value)
-      ;; lookup the corresponding pair
-      (let ((pair (assoc commodity commoditylist)))
-	(if (not pair)
-	    (begin
-	      ;; create a new pair, using the gnc:numeric-collector
-	      (set! pair (list commodity (gnc:make-numeric-collector)))
-	      ;; and add it to the alist
-	      (set! commoditylist (cons pair commoditylist))))
-	;; add the value
-	(gnc:numeric-collector-add (cadr pair) value)))
-    
-    ;; helper function to walk an association list, adding each
-    ;; (commodity -> collector) pair to our list at the appropriate 
-    ;; place
-    (define (add-commodity-clist clist)
-      (cond ((null? clist) '())
-	    (else (add-commodity-value 
-		   (caar clist) 
-		   (gnc:numeric-collector-total (cadar clist)))
-		  (add-commodity-clist (cdr clist)))))
-
-    (define (minus-commodity-clist clist)
-      (cond ((null? clist) '())
-	    (else (add-commodity-value 
-		   (caar clist) 
-		   (gnc-numeric-neg
-		    (gnc:numeric-collector-total (cadar clist))))
-		  (minus-commodity-clist (cdr clist)))))
-
-    ;; helper function walk the association list doing a callback on
-    ;; each key-value pair.
-    (define (process-commodity-list fn clist)
-      (map 
-       (lambda (pair) (fn (car pair) 
-			  (gnc:numeric-collector-total (cadr pair))))
-       clist))
-
-    ;; helper function which is given a commodity and returns, if
-    ;; existing, a list (gnc:commodity gnc:numeric). If the second
-    ;; argument was #t, the sign gets reversed.
-    (define (getpair c sign?)
-      (let ((pair (assoc c commoditylist)))
-	(cons c (cons 
-	      (if (not pair)
-		  (gnc-numeric-zero)
-		  (if sign?
-		      (gnc-numeric-neg
-		       (gnc:numeric-collector-total (cadr pair)))
-		      (gnc:numeric-collector-total (cadr pair))))
-	      '()))))
-
-    ;; helper function which is given a commodity and returns, if
-    ;; existing, a <gnc:monetary> value. If the second argument was
-    ;; #t, the sign gets reversed.
-    (define (getmonetary c sign?)
-      (let ((pair (assoc c commoditylist)))
-	(gnc:make-gnc-monetary
-	 c (if (not pair)
-	       (gnc-numeric-zero)
-	       (if sign?
-		   (gnc-numeric-neg
-		    (gnc:numeric-collector-total (cadr pair)))
-		   (gnc:numeric-collector-total (cadr pair)))))))
-    
+      (if (gnc:gnc-numeric? value)
+	  (gnc-commodity-accumulator-add accumulator commodity value)
+	  (begin
+	    (gnc-commodity-accumulator-add accumulator commodity
+					   (gnc-numeric-zero))
+	    (gnc:warn
+	     "gnc:numeric-collector called with wrong argument: "
+	     value))))
+
+    ;; helper function to walk the totals, latest commodity first,
+    ;; doing a callback on each commodity and amount.
+    (define (process-commodity-list fn)
+      (let loop ((n (gnc-commodity-accumulator-count accumulator))
+		 (result '()))
+	(if (= n 0)
+	    (reverse result)
+	    (loop (- n 1)
+		  (cons (fn (gnc-commodity-accumulator-nth-commodity
+			     accumulator (- n 1))
+			    (gnc-commodity-accumulator-nth-amount
+			     accumulator (- n 1)))
+			result)))))
+
+    ;; helper function which is given a commodity and returns its
+    ;; total. If the second argument was #t, the sign gets reversed.
+    (define (total c sign?)
+      (let ((amount (gnc-commodity-accumulator-get accumulator c)))
+	(if sign?
+	    (gnc-numeric-neg amount)
+	    amount)))
+
+    (free-dead-commodity-accumulators)
+    (commodity-accumulator-guardian accumulator)
+
     ;; Dispatch function
     (lambda (action commodity amount)
       (case action
 	((add) (add-commodity-value commodity amount))
-	((merge) (add-commodity-clist 
-		 (gnc-commodity-collector-list commodity)))
-	((minusmerge) (minus-commodity-clist
-		      (gnc-commodity-collector-list commodity)))
-	((format) (process-commodity-list commodity commoditylist))
-	((reset) (set! commoditylist '()))
-	((getpair) (getpair commodity amount))
-	((getmonetary) (getmonetary commodity amount))
-	((list) commoditylist) ; this one is only for internal use
+	((merge) (gnc-commodity-accumulator-merge
+		  accumulator (commodity 'accumulator #f #f) #f))
+	((minusmerge) (gnc-commodity-accumulator-merge
+		       accumulator (commodity 'accumulator #f #f) #t))
+	((format) (process-commodity-list commodity))
+	((reset) (gnc-commodity-accumulator-reset accumulator))
+	((getpair) (list commodity (total commodity amount)))
+	((getmonetary) (gnc:make-gnc-monetary
+			commodity (total commodity amount)))
+	((list) (process-commodity-list ; this one is only for internal use
+		 (lambda (c value)
+		   (let ((collector (gnc:make-numeric-collector)))
+		     (gnc:numeric-collector-add collector value)
+		     (list c collector)))))
+	((accumulator) accumulator) ; as is this one
 	(else (gnc:warn "bad commodity-collector action: " action))))))
 
 (define (gnc:commodity-collector-get-negated collector)
@@ -503,6 +494,49 @@
 				       (xaccSplitGetBalance (car splits))))
       balance-collector))
 
+;; Like gnc:account-get-comm-balance-at-date, but for each of a list of
+;; dates in increasing order, returning a list of commodity collectors.
+;; The splits of each account are walked only once, which is what makes
+;; charts over many dates affordable.
+(define (gnc:account-get-comm-balances-at-dates account dates include-children?)
+  (let ((collectors (map (lambda (date) (gnc:make-commodity-collector)) dates)))
+    (for-each
+     (lambda (acct)
+       (let ((commodity (xaccAccountGetCommodity acct)))
+         (for-each
+          (lambda (collector balance)
+            (if (not (gnc-numeric-zero-p balance))
+                (gnc-commodity-collector-add collector commodity balance)))
+          collectors
+          (gnc-account-get-balances-at-dates acct dates))))
+     (if include-children?
+         (cons account (gnc-account-get-descendants account))
+         (list account)))
+    collectors))
+
+;; A snapshot of the balances of all the book's accounts at two dates,
+;; taken in a single pass over the account tree.  Splits posted at a
+;; date count towards its balance, as in
+;; gnc:account-get-comm-balance-at-date.  Free it with
+;; gnc-account-balances-free.
+(define (gnc:make-account-balances start-date end-date)
+  (gnc-account-balances-new (gnc-get-current-root-account)
+                            (+ (gnc:timepair->secs start-date) 1)
+                            (+ (gnc:timepair->secs end-date) 1)
+                            '()))
+
+;; The account's own balance from the snapshot at its start or end date,
+;; as the commodity collector gnc:account-get-comm-balance-at-date would
+;; return.
+(define (gnc:account-balances-get-comm-balance balances account at-start?)
+  (let ((collector (gnc:make-commodity-collector))
+        (balance (gnc-account-balances-get-balance balances account at-start?)))
+    (if (not (gnc-numeric-zero-p balance))
+        (gnc-commodity-collector-add collector
+                                     (xaccAccountGetCommodity account)
+                                     balance))
+    collector))
+
 ;; Calculate the increase in the balance of the account in terms of
 ;; "value" (as opposed to "amount") between the specified dates.
 ;; If include-children? is true, the balances of all children (not
@@ -682,27 +716,39 @@
   (let ((trans (xaccSplitGetParent split)))
     (xaccTransGetVoidStatus trans)))
 
+;; Reports computed away from the GUI thread (see
+;; gnc:report-render-html-list) must not touch the window.  There this
+;; fluid holds a procedure taking a message, or #f, and a percentage,
+;; which the progress functions below call instead.
+(define gnc:*report-progress* (make-fluid))
+
+(define (report-show-progress message percent)
+  (let ((progress (fluid-ref gnc:*report-progress*)))
+    (if progress
+        (progress (if (string-null? message) #f message) percent)
+        (gnc-window-show-progress message percent))))
+
 (define (gnc:report-starting report-name)
-  (gnc-window-show-progress (sprintf #f
-				     (_ "Building '%s' report ...")
-				     (gnc:gettext report-name))
-			    0))
+  (report-show-progress (sprintf #f
+				 (_ "Building '%s' report ...")
+				 (gnc:gettext report-name))
+			0))
 
 (define (gnc:report-render-starting report-name)
-  (gnc-window-show-progress (sprintf #f
-				     (_ "Rendering '%s' report ...")
-				     (if (string-null? report-name)
-					 (gnc:gettext "Untitled")
-					 (gnc:gettext report-name)))
-			    0))
+  (report-show-progress (sprintf #f
+				 (_ "Rendering '%s' report ...")
+				 (if (string-null? report-name)
+				     (gnc:gettext "Untitled")
+				     (gnc:gettext report-name)))
+			0))
 
 (define (gnc:report-percent-done percent)
   (if (> percent 100)
       (gnc:warn "report more than 100% finished. " percent))
-  (gnc-window-show-progress "" percent))
+  (report-show-progress "" percent))
 
 (define (gnc:report-finished)
-  (gnc-window-show-progress "" -1))
+  (report-show-progress "" -1))
 
 ;; function to count the total number of splits to be iterated
 (define (gnc:accounts-count-splits accounts)
@@ -59,6 +59,14 @@
 ;; The key is the report guid and the
 ;; value is the report definition structure.
 (define *gnc:_report-templates_* (make-hash-table 23))
+;; The module that defined each template, by report guid, for the
+;; report registry.
+(define *gnc:_report-template-modules_* (make-hash-table 23))
+
+;; The templates that stand in for reports whose module hasn't been
+;; loaded yet, by report guid, with the name of the module.  They have
+;; only what the menus need; anything else loads the module first.
+(define *gnc:_lazy-report-templates_* (make-hash-table 23))
 
 ;; Define those strings here to make changes easier and avoid typos.
 (define gnc:menuname-reports "Reports/StandardReports")
@@ -87,7 +95,8 @@
                     '(version name report-guid parent-type options-generator
                               options-cleanup-cb options-changed-cb
                               renderer in-menu? menu-path menu-name
-                              menu-tip export-types export-thunk)))
+                              menu-tip export-types export-thunk
+                              cache-accounts)))
 
 ;; if args is supplied, it is a list of field names and values
 (define (gnc:define-report . args)
@@ -114,6 +123,7 @@
      #f                         ;; menu-tip
      #f                         ;; export-types
      #f                         ;; export-thunk
+     #f                         ;; cache-accounts
      ))
 
   (define (args-to-defn in-report-rec args)
@@ -135,10 +145,22 @@
 	(let* ((report-guid (gnc:report-template-report-guid report-rec))
 	       (name (gnc:report-template-name report-rec))
 	       (tmpl (hash-ref *gnc:_report-templates_* report-guid)))
-	  (if (not tmpl)
-	      (hash-set! *gnc:_report-templates_*
-			 report-guid report-rec)
-	      (begin
+	  (hash-set! *gnc:_report-template-modules_* report-guid
+		     (module-name (current-module)))
+	  (cond
+	   ((not tmpl)
+	    (hash-set! *gnc:_report-templates_*
+		       report-guid report-rec))
+	   ;; The registry put a stand-in here; fill it in, so that
+	   ;; whoever already holds it gets the real thing.
+	   ((hash-ref *gnc:_lazy-report-templates_* report-guid)
+	    (hash-remove! *gnc:_lazy-report-templates_* report-guid)
+	    (for-each
+	     (lambda (field)
+	       ((record-modifier <report-template> field)
+		tmpl ((record-accessor <report-template> field) report-rec)))
+	     (record-type-fields <report-template>)))
+	   (else
 		;; FIXME: We should pass the top-level window
 		;; instead of the '() to gnc-error-dialog, but I
 		;; have no idea where to get it from.
@@ -180,8 +202,58 @@
 	  (gnc:warn "gnc:define-report: old-style report. setting guid for " (gnc:report-template-name report-rec) " to " (gnc:report-template-report-guid report-rec)))
 	)))
 
+;; Loads the module of a stand-in template, which fills it in.
+(define (gnc:report-template-load! templ)
+  (let* ((guid (gnc:report-template-report-guid templ))
+         (module (hash-ref *gnc:_lazy-report-templates_* guid)))
+    (if module
+        (begin
+          (gnc:debug "loading " module " for report " guid)
+          (resolve-module module)
+          (if (hash-ref *gnc:_lazy-report-templates_* guid)
+              (begin
+                (hash-remove! *gnc:_lazy-report-templates_* guid)
+                (gnc:warn "report " guid " is no longer in " module)))))))
+
+(define (lazy-template-accessor field)
+  (let ((get (record-accessor <report-template> field)))
+    (lambda (templ)
+      (gnc:report-template-load! templ)
+      (get templ))))
+
+;; Adds a stand-in for a report of module that hasn't been loaded,
+;; from the report registry.
+(define (gnc:define-lazy-report module guid name parent-type in-menu?
+                                menu-path menu-name menu-tip)
+  (if (not (hash-ref *gnc:_report-templates_* guid))
+      (let ((templ ((record-constructor <report-template>)
+                    #f name guid parent-type #f #f #f #f in-menu?
+                    menu-path menu-name menu-tip #f #f #f)))
+        (hash-set! *gnc:_report-templates_* guid templ)
+        (hash-set! *gnc:_report-template-modules_* guid module)
+        (hash-set! *gnc:_lazy-report-templates_* guid module))))
+
+;; The registry entries of the templates defined by the modules for
+;; which module-wanted? is true, as lists of the arguments of
+;; gnc:define-lazy-report.
+(define (gnc:report-registry-entries module-wanted?)
+  (hash-fold
+   (lambda (guid templ entries)
+     (let ((module (hash-ref *gnc:_report-template-modules_* guid)))
+       (if (and module (module-wanted? module))
+           (cons (list module guid
+                       (gnc:report-template-name templ)
+                       (gnc:report-template-parent-type templ)
+                       (gnc:report-template-in-menu? templ)
+                       (gnc:report-template-menu-path templ)
+                       (gnc:report-template-menu-name templ)
+                       (gnc:report-template-menu-tip templ))
+                 entries)
+           entries)))
+   '() *gnc:_report-templates_*))
+
 (define gnc:report-template-version
-  (record-accessor <report-template> 'version))
+  (lazy-template-accessor 'version))
 (define gnc:report-template-report-guid
   (record-accessor <report-template> 'report-guid))
 (define gnc:report-template-set-report-guid!
@@ -195,13 +267,13 @@
 (define gnc:report-template-set-parent-type!
   (record-modifier <report-template> 'parent-type))
 (define gnc:report-template-options-generator
-  (record-accessor <report-template> 'options-generator))
+  (lazy-template-accessor 'options-generator))
 (define gnc:report-template-options-cleanup-cb
-  (record-accessor <report-template> 'options-cleanup-cb))
+  (lazy-template-accessor 'options-cleanup-cb))
 (define gnc:report-template-options-changed-cb
-  (record-accessor <report-template> 'options-changed-cb))
+  (lazy-template-accessor 'options-changed-cb))
 (define gnc:report-template-renderer
-  (record-accessor <report-template> 'renderer))
+  (lazy-template-accessor 'renderer))
 (define gnc:report-template-in-menu?
   (record-accessor <report-template> 'in-menu?))
 (define gnc:report-template-menu-path
@@ -211,9 +283,14 @@
 (define gnc:report-template-menu-tip
   (record-accessor <report-template> 'menu-tip))
 (define gnc:report-template-export-types
-  (record-accessor <report-template> 'export-types))
+  (lazy-template-accessor 'export-types))
 (define gnc:report-template-export-thunk
-  (record-accessor <report-template> 'export-thunk))
+  (lazy-template-accessor 'export-thunk))
+;; cache-accounts, if set, takes a report and returns the accounts its
+;; output depends on.  The cached output of the report then survives
+;; changes to the book that don't touch those accounts.
+(define gnc:report-template-cache-accounts
+  (lazy-template-accessor 'cache-accounts))
 
 (define (gnc:report-template-new-options/report-guid template-id template-name)
   (let ((templ (hash-ref *gnc:_report-templates_* template-id)))
@@ -417,6 +494,40 @@
         (gnc:report-template-export-thunk template)
         #f)))
 
+;; The key under which gnc-run-report caches the output of a report:
+;; its type and the options that differ from their defaults.
+(define (gnc:report-cache-key report)
+  (string-append (gnc:report-type report) "\n"
+                 (gnc:report-custom-template report) "\n"
+                 (gnc:generate-restore-forms (gnc:report-options report)
+                                             "options")))
+
+;; The guids of the accounts the cached output of a report depends on,
+;; or #f if any change to the book may affect it.
+(define (gnc:report-cache-accounts report)
+  (let* ((template (hash-ref *gnc:_report-templates_*
+                             (gnc:report-type report)))
+         (thunk (and template (gnc:report-template-cache-accounts template))))
+    (if thunk
+        (map gncAccountGetGUID (thunk report))
+        #f)))
+
+;; A cache-accounts procedure for reports that only look at the accounts
+;; selected in their options and the subaccounts of those.
+(define (gnc:report-selected-accounts report)
+  (let ((accounts '()))
+    (gnc:options-for-each
+     (lambda (option)
+       (let ((value (gnc:option-value option)))
+         (case (gnc:option-type option)
+           ((account-list)
+            (set! accounts (append value accounts)))
+           ((account-sel)
+            (if (not (null? value))
+                (set! accounts (cons value accounts)))))))
+     (gnc:report-options report))
+    (append accounts (gnc:acccounts-get-all-subaccounts accounts))))
+
 (define (gnc:report-menu-name report)
   (let ((template (hash-ref *gnc:_report-templates_* 
                             (gnc:report-type report))))
@@ -706,6 +817,32 @@
     save-ok?))
 
 
+;; runs the renderer from the report template and returns what it
+;; made: an html-doc, a string of finished HTML or #f if there's no
+;; template.  This is the part of running a report that may take long;
+;; it doesn't touch the GUI so it can run in a thread of its own.
+(define (gnc:report-compute report)
+  (let ((template (hash-ref *gnc:_report-templates_* 
+                            (gnc:report-type report))))
+    (if template
+        ((gnc:report-template-renderer template) report)
+        #f)))
+
+;; renders what gnc:report-compute returned with the report's
+;; stylesheet, caches the resulting string and returns it.
+(define (gnc:report-finish-html report doc headers?)
+  (if doc
+      (let ((html (if (string? doc)
+                      doc
+                      (begin
+                        (gnc:html-document-set-style-sheet!
+                         doc (gnc:report-stylesheet report))
+                        (gnc:html-document-render doc headers?)))))
+        (gnc:report-set-ctext! report html) ;; cache the html
+        (gnc:report-set-dirty?! report #f)  ;; mark it clean
+        html)
+      #f))
+
 ;; gets the renderer from the report template;
 ;; gets the stylesheet from the report;
 ;; renders the html doc and caches the resulting string;
@@ -716,29 +853,114 @@
   (if (and (not (gnc:report-dirty? report))
            (gnc:report-ctext report))
       ;; if there's clean cached text, return it 
-      ;;(begin
       (gnc:report-ctext report)
-      ;;  )
       
       ;; otherwise, rerun the report 
-      (let ((template (hash-ref *gnc:_report-templates_* 
-                                (gnc:report-type report)))
-	    (doc #f))
-        (set! doc (if template
-                      (let* ((renderer (gnc:report-template-renderer template))
-                             (stylesheet (gnc:report-stylesheet report))
-                             (doc (renderer report))
-                             (html #f))
-                        (if (string? doc)
-                          (set! html doc)
-                          (begin 
-                            (gnc:html-document-set-style-sheet! doc stylesheet)
-                            (set! html (gnc:html-document-render doc headers?))))
-                        (gnc:report-set-ctext! report html) ;; cache the html
-                        (gnc:report-set-dirty?! report #f)  ;; mark it clean
-                        html)
-                      #f))
-	doc))) ;; YUK! inner doc is html-doc object; outer doc is a string.
+      (gnc:report-finish-html report (gnc:report-compute report) headers?)))
+
+;; like gnc:report-render-html, but writes the html to port as it is
+;; rendered rather than building it as one string, so that a large
+;; report can go to a file in bounded memory.  The html is not cached
+;; as the report's ctext then.  Returns #t, or #f if the report failed.
+(define (gnc:report-render-html-to-port report headers? port)
+  (if (and (not (gnc:report-dirty? report))
+           (gnc:report-ctext report))
+      (begin
+        (display (gnc:report-ctext report) port)
+        #t)
+      (let ((doc (gnc:report-compute report)))
+        (cond
+         ((not doc) #f)
+         ((string? doc) (display doc port) #t)
+         (else
+          (gnc:html-document-set-style-sheet!
+           doc (gnc:report-stylesheet report))
+          (gnc:html-document-render doc headers? port)
+          #t)))))
+
+;; renders the report with its headers straight into the file
+;; filename.  Returns #t if the report could be written.
+(define (gnc:report-export-html-file report filename)
+  (let* ((port (open-output-file filename))
+         (ok (gnc:report-render-html-to-port report #t port)))
+    (close-port port)
+    ok))
+
+;; the most reports gnc:report-render-html-list computes at once.
+(define gnc:*report-threads* 4)
+
+;; like gnc:report-render-html for each of a list of reports; returns
+;; the list of html strings, with #f for the reports that failed.
+;; Reports without clean cached text are computed concurrently, each in
+;; a thread holding a read lock on the book, while this thread shows
+;; their combined progress and keeps the GUI going.  The html-docs are
+;; rendered back in this thread because stylesheets look at the GUI.
+(define (gnc:report-render-html-list reports headers?)
+  (let* ((n (length reports))
+         (report-vec (list->vector reports))
+         (docs (make-vector n #f))
+         (progress (make-vector n 0))
+         (todo (filter (lambda (i)
+                         (let ((report (vector-ref report-vec i)))
+                           (or (gnc:report-dirty? report)
+                               (not (gnc:report-ctext report)))))
+                       (iota n))))
+
+    (define (compute i)
+      (vector-set! docs i
+                   (gnc:backtrace-if-exception
+                    (lambda () (gnc:report-compute (vector-ref report-vec i)))))
+      (vector-set! progress i 100))
+
+    ;; Reports nested in one computed in a thread are computed in turn.
+    (if (and (provided? 'threads) (> (length todo) 1)
+             (not (fluid-ref gnc:*report-progress*)))
+        (let* ((queue todo)
+               (queue-lock (make-mutex))
+               (next (lambda ()
+                       (lock-mutex queue-lock)
+                       (let ((i (if (null? queue) #f (car queue))))
+                         (if i (set! queue (cdr queue)))
+                         (unlock-mutex queue-lock)
+                         i)))
+               (worker (lambda ()
+                         (dynamic-wind
+                             gnc-report-book-read-lock
+                             (lambda ()
+                               (let loop ((i (next)))
+                                 (if i
+                                     (begin
+                                       (with-fluids
+                                           ((gnc:*report-progress*
+                                             (lambda (message percent)
+                                               (if (<= 0 percent 100)
+                                                   (vector-set! progress i percent)))))
+                                         (compute i))
+                                       (loop (next))))))
+                             gnc-report-book-read-unlock)))
+               (threads (map (lambda (k) (call-with-new-thread worker))
+                             (iota (min gnc:*report-threads* (length todo))))))
+          (let wait ()
+            (gnc-window-show-progress
+             (_ "Building reports ...")
+             (/ (apply + (map (lambda (i) (vector-ref progress i)) todo))
+                (length todo)))
+            (if (any (lambda (thread) (not (thread-exited? thread))) threads)
+                (begin
+                  (usleep 100000)
+                  (wait))))
+          (for-each join-thread threads)
+          (gnc-window-show-progress "" -1))
+        (for-each compute todo))
+
+    (map (lambda (i)
+           (let ((report (vector-ref report-vec i)))
+             (if (memv i todo)
+                 (gnc:backtrace-if-exception
+                  (lambda ()
+                    (gnc:report-finish-html report (vector-ref docs i) headers?)))
+                 (gnc:report-ctext report))))
+         (iota n))))
 
 ;; looks up the report by id and renders it with gnc:report-render-html
 ;; marks the cursor busy during rendering; returns the html
@@ -422,8 +422,8 @@ balance at a given time"))
       (if do-intervals?
           (gnc:account-get-comm-balance-interval
            account from-date-tp to-date-tp subaccts?)
-          (gnc:account-get-comm-balance-at-date
-           account to-date-tp subaccts?)))
+          (car (gnc:account-get-comm-balances-at-dates
+                account (list to-date-tp) subaccts?))))
 
     ;; Define more helper variables.
     (let* ((exchange-fn (gnc:case-exchange-fn 
@@ -652,7 +652,8 @@ balance at a given time"))
                                        sort-comparator-security)
                                    (if depth-based?
                                        traverse-accounts
-                                       sum-securities)))))
+                                       sum-securities)))
+    'cache-accounts gnc:report-selected-accounts))
 
 (build-report!
   reportname-income
@@ -343,10 +343,11 @@
 	       (chart-table #f)                    ;; gnc:html-acct-table
 	       (hold-table (gnc:make-html-table))  ;; temporary gnc:html-table
 	       (build-table (gnc:make-html-table)) ;; gnc:html-table reported
+	       (balances (gnc:make-account-balances date-tp date-tp))
 	       (get-total-balance-fn
 		(lambda (account)
-		  (gnc:account-get-comm-balance-at-date 
-		   account date-tp #f)))
+		  (gnc:account-balances-get-comm-balance
+		   balances account #f)))
 	       (table-env                      ;; parameters for :make-
 		(list
 		 (list 'start-date #f)
@@ -497,6 +498,7 @@
                  (lambda (a)
 		   (gnc-account-get-descendants-sorted a))
                  accounts))))
+	  (gnc-account-balances-free balances)
 	  )
 	)
     
@@ -489,10 +489,11 @@
 	       (params #f)                         ;; and -add-account-
                (asset-table #f)                    ;; gnc:html-acct-table
                (equity-table #f)                   ;; gnc:html-acct-table
+	       (balances (gnc:make-account-balances date-tp date-tp))
 	       (get-total-balance-fn
 		(lambda (account)
-		  (gnc:account-get-comm-balance-at-date 
-		   account date-tp #f)))
+		  (gnc:account-balances-get-comm-balance
+		   balances account #f)))
                (get-total-value-fn
                 (lambda (account)
                   (gnc:account-get-comm-value-at-date account date-tp #f)))
@@ -730,6 +731,7 @@
                doc ;;(gnc:html-markup-p)
                (gnc:html-make-exchangerates 
                 report-commodity exchange-fn accounts)))
+	  (gnc-account-balances-free balances)
 	  (gnc:report-percent-done 100)
 	  
 	  ;; if sending the report to a file, do so now
@@ -179,6 +179,7 @@
         (act-sum 0)
         (date (gnc-budget-get-period-start-date budget period))
         (period-start-time (car date))
+        (actuals (gnc-budget-get-account-period-actual-vector budget acct))
         (bgt-vals '())
         (act-vals '())
         (date-iso-string-list '())
@@ -198,7 +199,7 @@
                 (gnc:get-account-period-rolledup-budget-value budget acct period))))
 	    (set! act-sum (+ act-sum
               (gnc-numeric-to-double
-                (gnc-budget-get-account-period-actual-value budget acct period))))
+                (vector-ref actuals period))))
           )
         )
         (if (<= report-start-time period-start-time)
@@ -211,7 +212,7 @@
                     (gnc:get-account-period-rolledup-budget-value budget acct period)))
 	        (set! act-sum
                   (gnc-numeric-to-double
-                    (gnc-budget-get-account-period-actual-value budget acct period)))
+                    (vector-ref actuals period)))
               )
             )
             (set! bgt-vals (append bgt-vals (list bgt-sum)))
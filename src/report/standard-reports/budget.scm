@@ -363,20 +363,19 @@
   ;; This is the sum of the actuals for each of the periods.
   ;;
   ;; Parameters:
-  ;;   budget - budget to use
-  ;;   acct - account
+  ;;   actuals - vector of the account's actual value for each budget period
   ;;   periodlist - list of budget periods to use
   ;;
   ;; Return value:
   ;;   Budget sum
-        (define (gnc:get-account-periodlist-actual-value budget acct periodlist)
+        (define (gnc:get-account-periodlist-actual-value actuals periodlist)
           (cond
            ((= (length periodlist) 1)
-            (gnc-budget-get-account-period-actual-value budget acct (car periodlist)))
+            (vector-ref actuals (car periodlist)))
            (else
             (gnc-numeric-add
-             (gnc-budget-get-account-period-actual-value budget acct (car periodlist))
-             (gnc:get-account-periodlist-actual-value budget acct (cdr periodlist))
+             (vector-ref actuals (car periodlist))
+             (gnc:get-account-periodlist-actual-value actuals (cdr periodlist))
              GNC-DENOM-AUTO GNC-RND-ROUND))
            )
           )
@@ -399,6 +398,7 @@
                  (bgt-total-unset? #t)
                  (act-total (gnc-numeric-zero))
                  (comm (xaccAccountGetCommodity acct))
+                 (actuals (gnc-budget-get-account-period-actual-vector budget acct))
                  (reverse-balance? (gnc-reverse-balance acct))
                  (income-acct? (eq? (xaccAccountGetType acct) ACCT-TYPE-INCOME))
                  )
@@ -469,7 +469,7 @@
                       (bgt-numeric-val (gnc:get-account-periodlist-budget-value budget acct period-list))
             
                       ;; actual amount
-                      (act-numeric-abs (gnc:get-account-periodlist-actual-value budget acct period-list))
+                      (act-numeric-abs (gnc:get-account-periodlist-actual-value actuals period-list))
                       (act-numeric-val
                         (if reverse-balance?
                           (gnc-numeric-neg act-numeric-abs)
@@ -333,14 +333,15 @@
 	       ;; Create the account table below where its
 	       ;; percentage time can be tracked.
 	       (build-table (gnc:make-html-table)) ;; gnc:html-table
+	       (balances (gnc:make-account-balances start-date-tp end-date-tp))
 	       (get-start-balance-fn
 		(lambda (account)
-		  (gnc:account-get-comm-balance-at-date 
-		   account start-date-tp #f)))
+		  (gnc:account-balances-get-comm-balance
+		   balances account #t)))
 	       (get-end-balance-fn
 		(lambda (account)
-		  (gnc:account-get-comm-balance-at-date 
-		   account end-date-tp #f)))
+		  (gnc:account-balances-get-comm-balance
+		   balances account #f)))
 	       (terse-period? #t)
 	       (period-for (if terse-period?
 			       (string-append " " (_ "for Period"))
@@ -664,6 +665,7 @@
 		 )
 	       )
 	  
+	  (gnc-account-balances-free balances)
 	  (gnc:report-percent-done 100)
 	  
 	  ;; if sending the report to a file, do so now
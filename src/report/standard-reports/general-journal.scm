@@ -82,14 +82,14 @@
        (set-option! "__reg" (car l) (cadr l)))
      ;; One list per option here with: option-name, default-value
      (list
-      (list "query" (gnc-query2scm query)) ;; think this wants an scm...
+      (list "query" query) ;; the option keeps its own copy
       (list "journal" #t)
       (list "double" #t)
       (list "debit-string" (_ "Debit"))
       (list "credit-string" (_ "Credit"))
       )
      )
-    ;; we'll leave query malloc'd in case this is required by the C side...
+    (qof-query-destroy query)
     
     ;; set options in the general tab...
     (set-option!
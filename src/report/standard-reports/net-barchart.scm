@@ -222,25 +222,36 @@
     ;; settings. Uses the collector->double conversion function
     ;; above. Returns a list of doubles.
     (define (process-datelist accounts dates income?)
-      (map
-       (lambda (date)
-         (collector->double
-          ((if inc-exp?
-               (if income?
-                   gnc:accounts-get-comm-total-income
-                   gnc:accounts-get-comm-total-expense)
-               gnc:accounts-get-comm-total-assets)
-           accounts
-           (lambda (account)
+      ;; Balances at dates are looked up once per account for the
+      ;; whole list of dates, as vectors of collectors.
+      (let ((balances
              (if inc-exp?
-                 ;; for inc-exp, 'date' is a pair of time values, else
-                 ;; it is a time value.
-                 (gnc:account-get-comm-balance-interval
-                  account (first date) (second date) #f)
-                 (gnc:account-get-comm-balance-at-date
-                  account date #f))))
-          (if inc-exp? (second date) date)))
-       dates))
+                 '()
+                 (map (lambda (account)
+                        (cons account
+                              (list->vector
+                               (gnc:account-get-comm-balances-at-dates
+                                account dates #f))))
+                      accounts))))
+        (map
+         (lambda (date index)
+           (collector->double
+            ((if inc-exp?
+                 (if income?
+                     gnc:accounts-get-comm-total-income
+                     gnc:accounts-get-comm-total-expense)
+                 gnc:accounts-get-comm-total-assets)
+             accounts
+             (lambda (account)
+               (if inc-exp?
+                   ;; for inc-exp, 'date' is a pair of time values, else
+                   ;; it is a time value.
+                   (gnc:account-get-comm-balance-interval
+                    account (first date) (second date) #f)
+                   (vector-ref (cdr (assoc account balances)) index))))
+            (if inc-exp? (second date) date)))
+         dates
+         (iota (length dates)))))
 
     (gnc:report-percent-done 1)
     (set! commodity-list (gnc:accounts-get-commodities
@@ -468,7 +479,8 @@
  'report-guid net-worth-barchart-uuid
  'menu-path (list gnc:menuname-asset-liability)
  'options-generator (lambda () (options-generator #f))
- 'renderer (lambda (report-obj) (net-renderer report-obj #f)))
+ 'renderer (lambda (report-obj) (net-renderer report-obj #f))
+ 'cache-accounts gnc:report-selected-accounts)
 
 (gnc:define-report
  'version 1
@@ -477,4 +489,5 @@
  'menu-name (N_ "Income & Expense Barchart")
  'menu-path (list gnc:menuname-income-expense)
  'options-generator (lambda () (options-generator #t))
- 'renderer (lambda (report-obj) (net-renderer report-obj #t)))
+ 'renderer (lambda (report-obj) (net-renderer report-obj #t))
+ 'cache-accounts gnc:report-selected-accounts)
@@ -837,7 +837,9 @@
     (if invoice?
         (set! title (_ "Invoice")))
 
-    (set! query (gnc-scm2query query-scm))
+    ;; Setting the book adds a term, so work on a copy of the option's
+    ;; query rather than on the query itself.
+    (set! query (qof-query-copy (gnc-handle2query query-scm)))
 
     (qof-query-set-book query (gnc-get-current-book))
 
@@ -28,6 +28,7 @@
 (use-modules (srfi srfi-13))
 (use-modules (gnucash main)) ;; FIXME: delete after we finish modularizing.
 (use-modules (gnucash core-utils))
+(use-modules (gnucash report report-system))
 
 (export gnc:register-report-create)
 (export gnc:register-report-hook)
@@ -146,12 +147,59 @@
 (gnc:debug "processed=" (process-file-list (directory-files (gnc-path-get-stdreportsdir))))
 (gnc:debug "report-list=" (get-report-list))
 
-(for-each
-    (lambda (x)
-	    (module-use!
-		    (current-module)
-			(resolve-interface (append '(gnucash report standard-reports) (list x)))))
-	(get-report-list))
+;; Loading every report takes a good part of startup, so what the menus
+;; need from them is kept in a registry in the user's directory.  While
+;; it matches this version, locale and the report files, the reports
+;; are only registered, and each module is loaded the first time one of
+;; its reports is run or has its options opened.
+(define registry-file (gnc-build-dotgnucash-path "standard-reports-registry"))
+
+(define (registry-stamp)
+  (let ((dir (gnc-path-get-stdreportsdir)))
+    (list gnc:version
+          (setlocale LC_ALL)
+          (map (lambda (f)
+                 (cons f (stat:mtime (stat (string-append dir "/" f)))))
+               (sort (directory-files dir) string<?)))))
+
+(define (read-registry stamp)
+  (and (access? registry-file R_OK)
+       (false-if-exception
+        (let ((registry (with-input-from-file registry-file read)))
+          (and (pair? registry)
+               (equal? (car registry) stamp)
+               (cdr registry))))))
+
+(define (write-registry stamp entries)
+  (if (not (false-if-exception
+            (with-output-to-file registry-file
+              (lambda ()
+                (write (cons stamp entries))
+                (newline)))))
+      (gnc:warn "Couldn't write " registry-file)))
+
+(define (standard-report-module? module)
+  (and (= (length module) 4)
+       (equal? (list-head module 3) '(gnucash report standard-reports))))
+
+;; gnc:register-report-create below calls into the register report.
+(module-use! (current-module)
+             (resolve-interface '(gnucash report standard-reports register)))
+
+(let* ((stamp (registry-stamp))
+       (entries (read-registry stamp)))
+  (if entries
+      (for-each (lambda (entry) (apply gnc:define-lazy-report entry))
+                entries)
+      (begin
+        (for-each
+         (lambda (x)
+           (module-use!
+            (current-module)
+            (resolve-interface (append '(gnucash report standard-reports) (list x)))))
+         (get-report-list))
+        (write-registry stamp (gnc:report-registry-entries
+                               standard-report-module?)))))
 
 (use-modules (gnucash gnc-module))
 (gnc:module-load "gnucash/engine" 0)
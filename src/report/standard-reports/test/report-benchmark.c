@@ -0,0 +1,269 @@
+/********************************************************************\
+ * report-benchmark.c -- time the standard reports on a synthetic   *
+ *                       book                                       *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+\********************************************************************/
+
+/* Builds a random book of the requested size with test-engine-stuff,
+ * then runs every standard report on it through gnc_run_report and
+ * writes one CSV line per report: the wall time, the Guile GC time,
+ * the bytes Guile allocated and the size of the HTML.  The same seed
+ * and sizes give the same book, so the numbers can be compared from
+ * one build to the next.  Run it with "make report-benchmark". */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <libguile.h>
+#include <glib.h>
+
+#include "gnc-module.h"
+#include "gnc-engine.h"
+#include "gnc-session.h"
+#include "gnc-pricedb.h"
+#include "gnc-report.h"
+#include "gnc-guile-utils.h"
+#include "test-engine-stuff.h"
+
+static gint seed = 42;
+static gint n_accounts = 100;
+static gint n_years = 5;
+static gint n_transactions = 2000;
+static gint n_price_rounds = 20;
+static gint n_runs = 3;
+static gchar *output = NULL;
+static gchar **only_reports = NULL;
+
+static GOptionEntry options[] =
+{
+    { "seed", 's', 0, G_OPTION_ARG_INT, &seed,
+      "Seed for the random book", "N" },
+    { "accounts", 'a', 0, G_OPTION_ARG_INT, &n_accounts,
+      "Maximum number of accounts", "N" },
+    { "years", 'y', 0, G_OPTION_ARG_INT, &n_years,
+      "Years of transactions, ending today", "N" },
+    { "transactions", 't', 0, G_OPTION_ARG_INT, &n_transactions,
+      "Number of transactions per year", "N" },
+    { "prices", 'p', 0, G_OPTION_ARG_INT, &n_price_rounds,
+      "Rounds of up to 40 random prices each", "N" },
+    { "runs", 'r', 0, G_OPTION_ARG_INT, &n_runs,
+      "Times to run each report; the fastest run is kept", "N" },
+    { "output", 'o', 0, G_OPTION_ARG_FILENAME, &output,
+      "CSV file to write, default stdout", "FILE" },
+    { "report", 0, 0, G_OPTION_ARG_STRING_ARRAY, &only_reports,
+      "Only run this report, by name; may be repeated", "NAME" },
+    { NULL }
+};
+
+/* The standard reports as (guid . name), and a way to make one with
+ * all its date options fixed to the book's time span. */
+static const char *benchmark_scm =
+    "(define (benchmark-templates)"
+    "  (let ((templates '()))"
+    "    (gnc:report-templates-for-each"
+    "     (lambda (guid template)"
+    "       (if (and (gnc:report-template-in-menu? template)"
+    "                (not (gnc:report-template-parent-type template)))"
+    "           (set! templates"
+    "                 (cons (cons guid (gnc:report-template-name template))"
+    "                       templates)))))"
+    "    (sort templates (lambda (a b) (string<? (cdr a) (cdr b))))))"
+    "(define (benchmark-make-report guid start end)"
+    "  (let* ((id (gnc:make-report guid))"
+    "         (options (gnc:report-options (gnc-report-find id))))"
+    "    (gnc:options-for-each"
+    "     (lambda (option)"
+    "       (if (eq? (gnc:option-type option) 'date)"
+    "           (gnc:option-set-value"
+    "            option"
+    "            (cons 'absolute"
+    "                  (cons (if (string=? (gnc:option-name option)"
+    "                                      \"Start Date\")"
+    "                            start end) 0)))))"
+    "     options)"
+    "    id))";
+
+static gboolean
+report_wanted (const char *name)
+{
+    gchar **report;
+
+    if (!only_reports || !*only_reports)
+        return TRUE;
+    for (report = only_reports; *report; report++)
+        if (g_strcmp0 (*report, name) == 0)
+            return TRUE;
+    return FALSE;
+}
+
+static SCM
+gc_stat (const char *key)
+{
+    SCM stats = scm_gc_stats ();
+    SCM value = scm_assq_ref (stats, scm_from_locale_symbol (key));
+
+    return scm_is_true (value) ? value : scm_from_int (0);
+}
+
+static void
+build_book (QofBook *book, time64 start, time64 end)
+{
+    gint i;
+
+    set_max_total_accounts (n_accounts);
+    set_max_account_tree_depth (4);
+    random_timespec_zero_nsec (TRUE);
+    random_timespec_range (start, end);
+
+    /* get_random_session already made an account tree and prices. */
+    for (i = 1; i < n_price_rounds; i++)
+        make_random_pricedb (book, gnc_pricedb_get_db (book));
+    add_random_transactions_to_book (book, n_transactions * n_years);
+}
+
+static gboolean
+run_report (const char *guid, time64 start, time64 end, FILE *out,
+            const char *name)
+{
+    SCM make_report = scm_c_eval_string ("benchmark-make-report");
+    SCM time_units = scm_c_eval_string ("internal-time-units-per-second");
+    gint64 best_usec = G_MAXINT64;
+    double best_gc = 0;
+    gint64 best_alloc = 0;
+    size_t html_len = 0;
+    gboolean ok = TRUE;
+    gint run;
+
+    for (run = 0; run < MAX (n_runs, 1) && ok; run++)
+    {
+        SCM id = scm_call_3 (make_report, scm_from_locale_string (guid),
+                             scm_from_int64 (start), scm_from_int64 (end));
+        gchar *id_string = g_strdup_printf ("id=%d", scm_to_int (id));
+        gchar *html = NULL;
+        gint64 gc_before, gc_after, alloc_before, alloc_after, usec;
+
+        gnc_report_cache_flush ();
+        scm_gc ();
+        gc_before = scm_to_int64 (gc_stat ("gc-time-taken"));
+        alloc_before = scm_to_int64 (gc_stat ("heap-total-allocated"));
+        usec = g_get_monotonic_time ();
+
+        ok = gnc_run_report_id_string (id_string, &html);
+
+        usec = g_get_monotonic_time () - usec;
+        gc_after = scm_to_int64 (gc_stat ("gc-time-taken"));
+        alloc_after = scm_to_int64 (gc_stat ("heap-total-allocated"));
+
+        if (usec < best_usec)
+        {
+            best_usec = usec;
+            best_gc = (double)(gc_after - gc_before) / scm_to_int64 (time_units);
+            best_alloc = alloc_after - alloc_before;
+            html_len = html ? strlen (html) : 0;
+        }
+        gnc_report_remove_by_id (scm_to_int (id));
+        g_free (html);
+        g_free (id_string);
+    }
+
+    fprintf (out, "\"%s\",%s,%s,%d,%d,%d,%d,%d,%.6f,%.6f,%" G_GINT64_FORMAT
+             ",%" G_GSIZE_FORMAT ",%s\n",
+             name, guid, PACKAGE_VERSION, seed, n_accounts, n_years,
+             n_transactions, n_price_rounds, best_usec / 1e6, best_gc,
+             best_alloc, html_len, ok ? "ok" : "failed");
+    fflush (out);
+    return ok;
+}
+
+static void
+guile_main (void *closure, int argc, char **argv)
+{
+    QofSession *session;
+    time64 start, end;
+    SCM templates;
+    FILE *out = stdout;
+    gboolean ok = TRUE;
+
+    gnc_module_system_init ();
+    if (!gnc_module_load ("gnucash/report/standard-reports", 0))
+    {
+        fprintf (stderr, "Could not load the standard reports\n");
+        exit (1);
+    }
+    scm_c_eval_string ("(use-modules (gnucash report report-system))");
+    scm_c_eval_string ("(use-modules (gnucash app-utils))");
+    scm_c_eval_string (benchmark_scm);
+
+    srand (seed);
+    end = gnc_time64_get_today_end ();
+    start = end - (time64)MAX (n_years, 1) * 365 * 24 * 3600;
+    session = get_random_session ();
+    gnc_set_current_session (session);
+    build_book (qof_session_get_book (session), start, end);
+
+    if (output && !(out = fopen (output, "w")))
+    {
+        perror (output);
+        exit (1);
+    }
+    fprintf (out, "report,guid,version,seed,accounts,years,transactions,"
+             "price_rounds,seconds,gc_seconds,bytes_allocated,html_bytes,"
+             "status\n");
+
+    for (templates = scm_call_0 (scm_c_eval_string ("benchmark-templates"));
+         !scm_is_null (templates); templates = SCM_CDR (templates))
+    {
+        gchar *guid = gnc_scm_to_utf8_string (SCM_CAAR (templates));
+        gchar *name = gnc_scm_to_utf8_string (SCM_CDAR (templates));
+
+        if (report_wanted (name))
+            ok = run_report (guid, start, end, out, name) && ok;
+        g_free (guid);
+        g_free (name);
+    }
+
+    if (out != stdout)
+        fclose (out);
+    gnc_clear_current_session ();
+    exit (ok ? 0 : 1);
+}
+
+int
+main (int argc, char **argv)
+{
+    GOptionContext *context;
+    GError *error = NULL;
+
+    context = g_option_context_new ("- time the standard reports");
+    g_option_context_add_main_entries (context, options, NULL);
+    if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+        fprintf (stderr, "%s\n", error->message);
+        g_error_free (error);
+        return 1;
+    }
+    g_option_context_free (context);
+
+    g_setenv ("GNC_UNINSTALLED", "1", TRUE);
+    scm_boot_guile (argc, argv, guile_main, NULL);
+    return 0;
+}
@@ -467,8 +467,11 @@
         (addto! heading-list (_ "Balance")))
     (reverse heading-list)))
 
+;; the optional last argument is the split's value, if gnc-split-groups-scm
+;; has already worked it out.
 (define (add-split-row table split column-vector options
-                       row-style account-types-to-reverse transaction-row?)
+                       row-style account-types-to-reverse transaction-row?
+                       . split-value-rest)
 
   (define (opt-val section name)
     (gnc:option-value 
@@ -489,17 +492,19 @@
 					 (xaccSplitVoidFormerAmount split)
 					 (xaccSplitGetAmount split)))
 	 (trans-date (gnc-transaction-get-date-posted parent))
-	 (split-value (gnc:exchange-by-pricedb-nearest
-		       (gnc:make-gnc-monetary 
-			currency
-			(if (member account-type account-types-to-reverse) 
-			    (gnc-numeric-neg damount)
-			    damount))
-		       report-currency
-		       ;; Use midday as the transaction time so it matches a price
-		       ;; on the same day.  Otherwise it uses midnight which will
-		       ;; likely match a price on the previous day
-		       (timespecCanonicalDayTime trans-date))))
+	 (split-value (if (pair? split-value-rest)
+                          (car split-value-rest)
+                          (gnc:exchange-by-pricedb-nearest
+		           (gnc:make-gnc-monetary 
+			    currency
+			    (if (member account-type account-types-to-reverse) 
+			        (gnc-numeric-neg damount)
+			        damount))
+		           report-currency
+		           ;; Use midday as the transaction time so it matches a price
+		           ;; on the same day.  Otherwise it uses midnight which will
+		           ;; likely match a price on the previous day
+		           (timespecCanonicalDayTime trans-date)))))
     
     (if (used-date column-vector)
         (addto! row-contents
@@ -1061,15 +1066,15 @@ Credit Card, and Income accounts.")))))
 
 ;; ;;;;;;;;;;;;;;;;;;;;
 ;; Here comes the big function that builds the whole table.
-(define (make-split-table splits options
-                          primary-subtotal-pred
-                          secondary-subtotal-pred
+;; groups is what gnc-split-groups-scm returned for the report: the
+;; rows with their values, and where the subheadings and subtotals go.
+(define (make-split-table groups options
                           primary-subheading-renderer
                           secondary-subheading-renderer
                           primary-subtotal-renderer
                           secondary-subtotal-renderer)
   
- (let ((work-to-do (length splits))
+ (let ((work-to-do (length (car groups)))
        (work-done 0)
        (used-columns (build-column-used options)))
   (define (get-account-types-to-reverse options)
@@ -1106,27 +1111,26 @@ Credit Card, and Income accounts.")))))
     (other-rows-driver split (xaccSplitGetParent split)
                        table used-columns 0))
 
-  (define (do-rows-with-subtotals splits 
+  ;; the subtotal renderers take a commodity collector.
+  (define (totals->collector totals)
+    (let ((collector (gnc:make-commodity-collector)))
+      (for-each (lambda (total)
+                  (collector 'add (car total) (cdr total)))
+                totals)
+      collector))
+
+  (define (do-rows-with-subtotals rows 
                                   table 
                                   used-columns
                                   width
                                   multi-rows?
                                   odd-row?
                                   export?
-                                  account-types-to-reverse
-                                  primary-subtotal-pred
-                                  secondary-subtotal-pred 
-                                  primary-subheading-renderer
-                                  secondary-subheading-renderer
-                                  primary-subtotal-renderer
-                                  secondary-subtotal-renderer
-                                  primary-subtotal-collector 
-                                  secondary-subtotal-collector 
-                                  total-collector)
+                                  account-types-to-reverse)
 
     (gnc:report-percent-done (* 100 (/ work-done work-to-do)))
     (set! work-done (+ 1 work-done))
-    (if (null? splits)
+    (if (null? rows)
         (begin
           (gnc:html-table-append-row/markup!
            table
@@ -1135,106 +1139,49 @@ Credit Card, and Income accounts.")))))
             (gnc:make-html-table-cell/size
              1 width (gnc:make-html-text (gnc:html-markup-hr)))))
 	  (if (gnc:option-value (gnc:lookup-option options "Display" "Totals"))
-	      (render-grand-total table width total-collector export?)))
+	      (render-grand-total table width (totals->collector (cdr groups))
+                                  export?)))
 	
-        (let* ((current (car splits))
+        (let* ((row (car rows))
+               (current (vector-ref row 0))
+               (value (vector-ref row 1))
+               (primary-total (vector-ref row 4))
+               (secondary-total (vector-ref row 5))
                (current-row-style (if multi-rows? def:normal-row-style
                                       (if odd-row? def:normal-row-style 
-                                          def:alternate-row-style)))
-               (rest (cdr splits))
-               (next (if (null? rest) #f
-                         (car rest)))
-               (split-value (add-split-row 
-                             table 
-                             current 
-                             used-columns
-			     options
-                             current-row-style
-                             account-types-to-reverse
-                             #t)))
+                                          def:alternate-row-style))))
+          (if (vector-ref row 2)
+              (primary-subheading-renderer
+               current table width def:primary-subtotal-style used-columns))
+          (if (vector-ref row 3)
+              (secondary-subheading-renderer
+               current table width def:secondary-subtotal-style used-columns))
+
+          (add-split-row table current used-columns options
+                         current-row-style account-types-to-reverse #t
+                         (gnc:make-gnc-monetary (car value) (cdr value)))
           (if multi-rows?
               (add-other-split-rows
                current table used-columns def:alternate-row-style
                account-types-to-reverse))
 
-          (primary-subtotal-collector 'add 
-                                      (gnc:gnc-monetary-commodity
-                                       split-value) 
-                                      (gnc:gnc-monetary-amount
-                                       split-value))
-          (secondary-subtotal-collector 'add
-                                        (gnc:gnc-monetary-commodity
-                                         split-value)
-                                        (gnc:gnc-monetary-amount
-                                         split-value))
-          (total-collector 'add
-                           (gnc:gnc-monetary-commodity split-value)
-                           (gnc:gnc-monetary-amount split-value))
-
-          (if (and primary-subtotal-pred
-                   (or (not next)
-                       (and next
-                            (not (primary-subtotal-pred current next)))))
-              (begin 
-                (if secondary-subtotal-pred
-
-                    (begin
-                      (secondary-subtotal-renderer
-                       table width current
-                       secondary-subtotal-collector
-                       def:secondary-subtotal-style used-columns export?)
-                      (secondary-subtotal-collector 'reset #f #f)))
-
-                (primary-subtotal-renderer table width current
-                                           primary-subtotal-collector
-                                           def:primary-subtotal-style used-columns
-                                           export?)
-
-                (primary-subtotal-collector 'reset #f #f)
-
-                (if next
-                    (begin 
-                      (primary-subheading-renderer
-                       next table width def:primary-subtotal-style used-columns)
-
-                      (if secondary-subtotal-pred
-                          (secondary-subheading-renderer
-                           next 
-                           table 
-                           width def:secondary-subtotal-style used-columns)))))
-
-              (if (and secondary-subtotal-pred
-                       (or (not next)
-                           (and next
-                                (not (secondary-subtotal-pred
-                                      current next)))))
-                  (begin (secondary-subtotal-renderer
-                          table width current
-                          secondary-subtotal-collector
-                          def:secondary-subtotal-style used-columns export?)
-                         (secondary-subtotal-collector 'reset #f #f)
-                         (if next
-                             (secondary-subheading-renderer
-                              next table width
-                              def:secondary-subtotal-style used-columns)))))
-
-          (do-rows-with-subtotals rest 
+          (if secondary-total
+              (secondary-subtotal-renderer
+               table width current (totals->collector secondary-total)
+               def:secondary-subtotal-style used-columns export?))
+          (if primary-total
+              (primary-subtotal-renderer
+               table width current (totals->collector primary-total)
+               def:primary-subtotal-style used-columns export?))
+
+          (do-rows-with-subtotals (cdr rows) 
                                   table 
                                   used-columns
                                   width 
                                   multi-rows?
                                   (not odd-row?)
                                   export?
-                                  account-types-to-reverse
-                                  primary-subtotal-pred 
-                                  secondary-subtotal-pred
-                                  primary-subheading-renderer 
-                                  secondary-subheading-renderer
-                                  primary-subtotal-renderer
-                                  secondary-subtotal-renderer
-                                  primary-subtotal-collector 
-                                  secondary-subtotal-collector 
-                                  total-collector))))
+                                  account-types-to-reverse))))
 
   (let* ((table (gnc:make-html-table))
          (width (num-columns-required used-columns))
@@ -1246,29 +1193,11 @@ Credit Card, and Income accounts.")))))
     (gnc:html-table-set-col-headers!
      table
      (make-heading-list used-columns options))
-    ;;     (gnc:warn "Splits:" splits)
-    (if (not (null? splits))
-        (begin
-          (if primary-subheading-renderer 
-              (primary-subheading-renderer
-               (car splits) table width def:primary-subtotal-style used-columns))
-          (if secondary-subheading-renderer
-              (secondary-subheading-renderer
-               (car splits) table width def:secondary-subtotal-style used-columns))
-
-          (do-rows-with-subtotals splits table used-columns width
-                                  multi-rows? #t
-                                  export?
-                                  account-types-to-reverse
-                                  primary-subtotal-pred
-                                  secondary-subtotal-pred
-                                  primary-subheading-renderer
-                                  secondary-subheading-renderer
-                                  primary-subtotal-renderer
-                                  secondary-subtotal-renderer
-                                  (gnc:make-commodity-collector)
-                                  (gnc:make-commodity-collector)
-                                  (gnc:make-commodity-collector))))
+    (if (not (null? (car groups)))
+        (do-rows-with-subtotals (car groups) table used-columns width
+                                multi-rows? #t
+                                export?
+                                account-types-to-reverse))
     
     table)))
 
@@ -1375,11 +1304,17 @@ Credit Card, and Income accounts.")))))
      (cdr (assq sort-option-value comp-funcs-assoc-list)) 
      0))
 
-  (define (get-subtotal-pred 
+  ;; What gnc-split-groups-scm groups the rows by for a sorting key,
+  ;; following the same choice as get-subtotalstuff-helper.
+  (define (get-group-by
            name-sortkey name-subtotal name-date-subtotal)
-    (get-subtotalstuff-helper 
-     name-sortkey name-subtotal name-date-subtotal
-     1 0))
+    (let ((sortkey (opt-val pagename-sorting name-sortkey)))
+      (if (member sortkey date-sorting-types)
+          (opt-val pagename-sorting name-date-subtotal)
+          (if (and (member sortkey subtotal-enabled)
+                   (opt-val pagename-sorting name-subtotal))
+              sortkey
+              'none))))
 
   (define (get-subheading-renderer
            name-sortkey name-subtotal name-date-subtotal)
@@ -1396,44 +1331,6 @@ Credit Card, and Income accounts.")))))
   ;;(define (get-other-account-names account-list)
   ;;  ( map (lambda (acct)  (gnc-account-get-full-name acct)) account-list))
 
-  (define (is-filter-member split account-list)
-    (let* ((txn (xaccSplitGetParent split))
-           (splitcount (xaccTransCountSplits txn)))
-
-      (cond
-        ;; A 2-split transaction - test separately so it can be optimized
-        ;; to significantly reduce the number of splits to traverse
-        ;; in guile code
-        ((= splitcount 2)
-         (let* ((other      (xaccSplitGetOtherSplit split))
-                (other-acct (xaccSplitGetAccount other)))
-               (member other-acct account-list)))
-
-        ;; A multi-split transaction - run over all splits
-        ((> splitcount 2)
-         (let ((splits (xaccTransGetSplitList txn)))
-
-                ;; Walk through the list of splits.
-                ;; if we reach the end, return #f
-                ;; if the 'this' != 'split' and the split->account is a member
-                ;; of the account-list, then return #t, else recurse
-                (define (is-member splits)
-                  (if (null? splits)
-                      #f
-                      (let* ((this (car splits))
-                             (rest (cdr splits))
-                             (acct (xaccSplitGetAccount this)))
-                        (if (and (not (eq? this split))
-                                 (member acct account-list))
-                            #t
-                            (is-member rest)))))
-
-                (is-member splits)))
-
-        ;; Single transaction splits
-        (else #f))))
-
-
   (gnc:report-starting reportname)
   (let ((document (gnc:make-html-document))
 	(c_account_1 (opt-val gnc:pagename-accounts "Accounts"))
@@ -1453,7 +1350,7 @@ Credit Card, and Income accounts.")))))
         (secondary-key (opt-val pagename-sorting optname-sec-sortkey))
         (secondary-order (opt-val pagename-sorting "Secondary Sort Order"))
 	(void-status (opt-val gnc:pagename-accounts optname-void-transactions))
-        (splits '())
+        (groups #f)
         (query (qof-query-create-for-splits)))
 
     ;;(gnc:warn "accts in trep-renderer:" c_account_1)
@@ -1485,43 +1382,27 @@ Credit Card, and Income accounts.")))))
 	    (gnc:query-set-match-voids-only! query (gnc-get-current-book)))
 	   (else #f))
 
-          (set! splits (qof-query-run query))
-
-          ;;(gnc:warn "Splits in trep-renderer:" splits)
-
-	  ;;(gnc:warn "Filter account names:" (get-other-account-names c_account_2))
-
-	  ;;This should probably a cond or a case to allow for different filter types.
-	  ;;(gnc:warn "Filter Mode: " filter-mode)
-	  (if (eq? filter-mode 'include)
-	      (begin
-		;;(gnc:warn "Including Filter Accounts")
-		(set! splits (filter (lambda (split) 
-				       (is-filter-member split c_account_2))
-				     splits))
-		)
-	      )
-
-	  (if (eq? filter-mode 'exclude)
-	      (begin
-		;;(gnc:warn "Excluding Filter Accounts")
-		(set! splits (filter (lambda (split) 
-				       (not (is-filter-member split c_account_2)))
-				     splits))
-		)
-	      )
-	
-          (if (not (null? splits))
+          ;; Run the query, filter, group and subtotal the splits.
+          (set! groups
+                (gnc-split-groups-scm
+                 query
+                 (get-group-by optname-prime-sortkey
+                               optname-prime-subtotal
+                               optname-prime-date-subtotal)
+                 (get-group-by optname-sec-sortkey
+                               optname-sec-subtotal
+                               optname-sec-date-subtotal)
+                 c_account_2 filter-mode
+                 (cdr (assq (opt-val gnc:pagename-display (N_ "Sign Reverses"))
+                            account-types-to-reverse-assoc-list))
+                 (and (opt-val gnc:pagename-general optname-common-currency)
+                      (opt-val gnc:pagename-general optname-currency))))
+
+          (if (not (null? (car groups)))
               (let ((table 
                      (make-split-table 
-                      splits 
+                      groups 
                       options
-                      (get-subtotal-pred optname-prime-sortkey 
-                                         optname-prime-subtotal
-                                         optname-prime-date-subtotal)
-                      (get-subtotal-pred optname-sec-sortkey 
-                                         optname-sec-subtotal
-                                         optname-sec-date-subtotal)
                       (get-subheading-renderer optname-prime-sortkey 
                                                optname-prime-subtotal
                                                optname-prime-date-subtotal)
@@ -520,6 +520,8 @@
                 ;; No need to calculate if doing valuation at cost.
                 (gnc:make-commodity-collector)
                 (let ((book-balance (gnc:make-commodity-collector))
+                      (balances (gnc:make-account-balances end-date-tp
+                                                           end-date-tp))
                       (unrealized-gain-collector (gnc:make-commodity-collector))
                       (cost-fn (gnc:case-exchange-fn 'average-cost
                                                      report-commodity
@@ -532,10 +534,11 @@
                   (map
                    (lambda (acct)
                      (book-balance 'merge
-                                   (gnc:account-get-comm-balance-at-date
-                                    acct end-date-tp #f)
+                                   (gnc:account-balances-get-comm-balance
+                                    balances acct #f)
                      #f))
                    all-accounts)
+                  (gnc-account-balances-free balances)
 
                  ;; Get the value of all holdings.
                  (set! value (gnc:gnc-monetary-amount
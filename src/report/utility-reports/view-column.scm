@@ -108,11 +108,21 @@
        reports)
       (gnc:option-set-value report-opt (reverse new-reports)))
     
+    ;; set the reports' style properly ... this way they will
+    ;; also get marked as dirty when the stylesheet is edited.
+    (for-each
+     (lambda (report-info)
+       (gnc:report-set-stylesheet!
+        (gnc-report-find (car report-info)) (gnc:report-stylesheet report)))
+     reports)
+
     ;; we really would rather do something smart here with the
     ;; report's cached text if possible.  For the moment, we'll have
     ;; to rerun every report, every time... FIXME
+    ;; The subreports don't depend on each other, so they're computed
+    ;; all at once.
     (for-each
-     (lambda (report-info)
+     (lambda (report-info html)
        ;; run the report renderer, pick out the document style table
        ;; and objects from the returned document, then make a new
        ;; HTML table cell with those objects as content and append
@@ -120,28 +130,17 @@
        ;; hash is an attempt to compute how many columnc are
        ;; actually used in a row; items with non-1 rowspans will take
        ;; up cells in the row without actually being in the row.
-       (let* ((subreport (gnc-report-find (car report-info)))
-	      (colspan (cadr report-info))
+       (let* ((colspan (cadr report-info))
 	      (rowspan (caddr report-info))
 	      (opt-callback (cadddr report-info))
 	      (toplevel-cell (gnc:make-html-table-cell/size rowspan colspan))
 	      (report-table (gnc:make-html-table))
 	      (contents-cell (gnc:make-html-table-cell)))
 
-	 ;; set the report's style properly ... this way it will
-	 ;; also get marked as dirty when the stylesheet is edited.
-	 (gnc:report-set-stylesheet! 
-	  subreport (gnc:report-stylesheet report))
-	 
-	 ;; render the report body ... hopefully this will DTRT
-	 ;; if there is an error, then dump a backtrace and print
-	 ;; an error message
-	 ;; and cache when it's ok to cache.
-	 (if (not (gnc:backtrace-if-exception
-		   (lambda ()
-		     (gnc:html-table-cell-append-objects! 
-		      contents-cell (gnc:report-render-html subreport #f))
-		     #t)))
+	 ;; put in the report body, or an error message if it
+	 ;; failed; the backtrace has been dumped already.
+	 (if html
+	     (gnc:html-table-cell-append-objects! contents-cell html)
 	     (gnc:html-table-cell-append-objects!
 	      contents-cell
 	      (gnc:make-html-text
@@ -201,7 +200,10 @@
 	       (set! current-width (hash-ref column-allocs current-row-num))
 	       (if (not current-width) (set! current-width 0))
 	       (set! current-row '())))))
-     reports)
+     reports
+     (gnc:report-render-html-list
+      (map (lambda (report-info) (gnc-report-find (car report-info))) reports)
+      #f))
     
     (if (not (null? current-row))
 	(gnc:html-table-append-row! column-tab current-row))
@@ -162,29 +162,45 @@
 
     (define (get-quotes)
       (if (not (null? quoter))
-          (let ((results #f))
+          (let ((results #f)
+                (sent #t))
             (set! to-child (fdes->outport (gnc-process-get-fd quoter 0)))
             (set! from-child (fdes->inport (gnc-process-get-fd quoter 1)))
+            ;; Send all the requests before reading any answer so that the
+            ;; helper can fetch them in parallel; the answers come back in
+            ;; the order of the requests.
+            (set! sent
+                  (catch
+                   #t
+                   (lambda ()
+                     (for-each
+                      (lambda (request)
+                        (gnc:debug "handling-request: " request)
+                        ;; we need to display the first element (the method,
+                        ;; so it won't be quoted) and then write the rest
+                        (display #\( to-child)
+                        (display (car request) to-child)
+                        (display " " to-child)
+                        (for-each (lambda (x) (write x to-child)) (cdr request))
+                        (display #\) to-child)
+                        (newline to-child))
+                      requests)
+                     (force-output to-child)
+                     #t)
+                   (lambda (key . args)
+                     key)))
             (map
              (lambda (request)
-               (catch
-                #t
-                (lambda ()
-                  (gnc:debug "handling-request: " request)
-                  ;; we need to display the first element (the method, so it
-                  ;; won't be quoted) and then write the rest
-                  (display #\( to-child)
-                  (display (car request) to-child)
-                  (display " " to-child)
-                  (for-each (lambda (x) (write x to-child)) (cdr request))
-                  (display #\) to-child)
-                  (newline to-child)
-                  (force-output to-child)
-                  (set! results (read from-child))
-                  (gnc:debug "results: " results)
-                  results)
-                (lambda (key . args)
-                  key)))
+               (if (not (eq? sent #t))
+                   sent
+                   (catch
+                    #t
+                    (lambda ()
+                      (set! results (read from-child))
+                      (gnc:debug "results: " results)
+                      results)
+                    (lambda (key . args)
+                      key))))
              requests))))
 
     (define (kill-quoter)
@@ -453,6 +469,7 @@
 
   (define (book-add-prices! book prices)
     (let ((pricedb (gnc-pricedb-get-db book)))
+      (gnc-pricedb-begin-batch pricedb)
       (for-each
        (lambda (price)
          (if price
@@ -460,7 +477,8 @@
                (gnc-pricedb-add-price pricedb price)
                (gnc-price-unref price)
                #f)))
-       prices)))
+       prices)
+      (gnc-pricedb-end-batch pricedb)))
 
   ;; FIXME: uses of gnc:warn in here need to be cleaned up.  Right
   ;; now, they'll result in funny formatting.
@@ -0,0 +1,162 @@
+/********************************************************************
+ * benchmark-support.c: timing loops for micro-benchmarks           *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+********************************************************************/
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "benchmark-support.h"
+
+#define BENCHMARK_REPEATS 5
+
+static gdouble scale = 1.0;
+static gdouble tolerance = 10.0;
+static gchar *baseline_file = NULL;
+static gchar *output_file = NULL;
+static GHashTable *baseline = NULL;
+static FILE *output = NULL;
+static gint regressions = 0;
+static volatile gint64 sink;
+
+static GOptionEntry options[] =
+{
+    { "scale", 0, 0, G_OPTION_ARG_DOUBLE, &scale,
+      "Multiply every iteration count by this", "FACTOR" },
+    { "baseline", 0, 0, G_OPTION_ARG_FILENAME, &baseline_file,
+      "Fail if slower than the results in this file", "FILE" },
+    { "tolerance", 0, 0, G_OPTION_ARG_DOUBLE, &tolerance,
+      "Percentage by which an operation may be slower, default 10",
+      "PERCENT" },
+    { "output", 'o', 0, G_OPTION_ARG_FILENAME, &output_file,
+      "File to write the results to, default stdout", "FILE" },
+    { NULL }
+};
+
+static void
+read_baseline (const gchar *filename)
+{
+    gchar *contents, **lines, **line;
+    GError *error = NULL;
+
+    if (!g_file_get_contents (filename, &contents, NULL, &error))
+    {
+        g_printerr ("%s\n", error->message);
+        g_error_free (error);
+        exit (2);
+    }
+
+    baseline = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                      g_free);
+    lines = g_strsplit (contents, "\n", -1);
+    for (line = lines; *line; line++)
+    {
+        gchar name[256];
+        gdouble value;
+
+        if (**line == '#' ||
+                sscanf (*line, "%255s %lf", name, &value) != 2)
+            continue;
+        g_hash_table_insert (baseline, g_strdup (name),
+                             g_memdup (&value, sizeof (value)));
+    }
+    g_strfreev (lines);
+    g_free (contents);
+}
+
+void
+gnc_benchmark_init (int *argc, char ***argv)
+{
+    GOptionContext *context;
+    GError *error = NULL;
+
+    context = g_option_context_new ("- run micro-benchmarks");
+    g_option_context_add_main_entries (context, options, NULL);
+    if (!g_option_context_parse (context, argc, argv, &error))
+    {
+        g_printerr ("%s\n", error->message);
+        g_error_free (error);
+        exit (2);
+    }
+    g_option_context_free (context);
+
+    if (baseline_file)
+        read_baseline (baseline_file);
+
+    output = stdout;
+    if (output_file && !(output = fopen (output_file, "w")))
+    {
+        perror (output_file);
+        exit (2);
+    }
+    fprintf (output, "# operation ns-per-iteration\n");
+}
+
+void
+gnc_benchmark_run (const char *name, GncBenchmarkFn fn, gpointer data,
+                   guint64 iterations)
+{
+    gdouble best = G_MAXDOUBLE;
+    gdouble *expected;
+    gint i;
+
+    iterations = MAX ((guint64)(iterations * scale), 1);
+
+    /* Once untimed to warm the caches. */
+    fn (data, MAX (iterations / 10, 1));
+    for (i = 0; i < BENCHMARK_REPEATS; i++)
+    {
+        gint64 start = g_get_monotonic_time ();
+        gdouble ns;
+
+        fn (data, iterations);
+        ns = (g_get_monotonic_time () - start) * 1000.0 / iterations;
+        best = MIN (best, ns);
+    }
+
+    fprintf (output, "%s %.3f", name, best);
+    expected = baseline ? g_hash_table_lookup (baseline, name) : NULL;
+    if (expected && best > *expected * (1 + tolerance / 100))
+    {
+        fprintf (output, " # REGRESSION, baseline %.3f", *expected);
+        regressions++;
+    }
+    fprintf (output, "\n");
+    fflush (output);
+}
+
+int
+gnc_benchmark_finish (void)
+{
+    if (output != stdout)
+        fclose (output);
+    if (baseline)
+        g_hash_table_destroy (baseline);
+    if (regressions)
+        g_printerr ("%d operations slower than the baseline\n", regressions);
+    return regressions ? 1 : 0;
+}
+
+void
+gnc_benchmark_consume (gint64 value)
+{
+    sink += value;
+}
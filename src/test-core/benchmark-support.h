@@ -0,0 +1,61 @@
+/********************************************************************
+ * benchmark-support.h: timing loops for micro-benchmarks           *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+********************************************************************/
+#ifndef BENCHMARK_SUPPORT_H
+#define BENCHMARK_SUPPORT_H
+
+#include <glib.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** @file benchmark-support.h
+ * @brief A small harness for micro-benchmarks.
+ *
+ * A benchmark program calls gnc_benchmark_init() with its arguments,
+ * gnc_benchmark_run() once per operation and returns the result of
+ * gnc_benchmark_finish().  Each operation is timed several times and
+ * the fastest run is reported, in nanoseconds per iteration, as a
+ * "name value" line.  The same file can be given back with
+ * --baseline, and then the program fails if any operation got slower
+ * than the baseline by more than --tolerance percent, which lets a CI
+ * job opt in to catching regressions.  --scale multiplies every
+ * iteration count, so that --scale 0.01 makes a quick smoke test.
+ */
+
+/** Runs the operation iterations times.  Anything computed should be
+ * handed to gnc_benchmark_consume() so it isn't optimized away. */
+typedef void (*GncBenchmarkFn) (gpointer data, guint64 iterations);
+
+void gnc_benchmark_init (int *argc, char ***argv);
+void gnc_benchmark_run (const char *name, GncBenchmarkFn fn, gpointer data,
+                        guint64 iterations);
+/** @return The exit status: non-zero if an operation regressed. */
+int gnc_benchmark_finish (void);
+
+void gnc_benchmark_consume (gint64 value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BENCHMARK_SUPPORT_H */